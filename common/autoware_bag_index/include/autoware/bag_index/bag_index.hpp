@@ -0,0 +1,221 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__BAG_INDEX__BAG_INDEX_HPP_
+#define AUTOWARE__BAG_INDEX__BAG_INDEX_HPP_
+
+#include <rmw/rmw.h>
+#include <rosbag2_storage/bag_metadata.hpp>
+#include <rosbag2_storage/serialized_bag_message.hpp>
+#include <rosidl_typesupport_cpp/message_type_support.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace autoware::bag_index
+{
+
+// time_stamp was renamed to recv_timestamp after Humble
+template <class M>
+auto getReceivedTime(const M & msg, int) -> decltype(msg.recv_timestamp)
+{
+  return msg.recv_timestamp;
+}
+
+template <class M>
+auto getReceivedTime(const M & msg, int64_t) -> decltype(msg.time_stamp)
+{
+  return msg.time_stamp;
+}
+
+struct IndexOptions
+{
+  // the topics to read, all the topics of the bag if empty
+  std::vector<std::string> topics{};
+
+  // [ns] the messages received from start_time to end_time are read, 0 for the start and the end
+  // of the bag. Both the topics and the start time are passed to the storage.
+  rcutils_time_point_value_t start_time{0};
+  rcutils_time_point_value_t end_time{0};
+
+  // [ns] only the first message of each period, from the epoch, of these topics is kept. The
+  // other topics keep all of their messages.
+  std::unordered_map<std::string, rcutils_time_point_value_t> periods{};
+
+  // The file the indexed messages are saved to, when the bag is read, and memory mapped from by
+  // the next indexes of the same bag and options. Empty not to use a cache.
+  std::string cache_path{};
+};
+
+/**
+ * The messages of a bag, read once and indexed by topic and received time. The topics are
+ * resolved to ids once, and the messages are kept serialized and deserialized on access, into
+ * the message of the caller or by parallel workers. The accesses are const and may be made from
+ * several threads.
+ */
+class BagIndex
+{
+public:
+  using TopicId = size_t;
+  static constexpr TopicId invalid_topic = std::numeric_limits<TopicId>::max();
+
+  // a message of the index, in the order of the bag
+  struct Entry
+  {
+    TopicId topic;
+    size_t index;
+  };
+
+  explicit BagIndex(const std::string & bag_path, const IndexOptions & options = IndexOptions());
+
+  // the cache file next to a bag, a directory or a file
+  static std::string getDefaultCachePath(const std::string & bag_path);
+
+  const rosbag2_storage::BagMetadata & getMetadata() const { return metadata_; }
+  bool isLoadedFromCache() const { return is_loaded_from_cache_; }
+
+  // @return : invalid_topic if the topic has no message in the index
+  TopicId getTopicId(const std::string & topic_name) const;
+  const std::string & getTopicName(const TopicId topic) const { return topics_.at(topic).name; }
+  size_t getTopicNum() const { return topics_.size(); }
+
+  // the number of messages of a topic, 0 for invalid_topic
+  size_t size(const TopicId topic) const
+  {
+    return topic < topics_.size() ? topics_[topic].times.size() : 0;
+  }
+  // [ns] the received time of a message
+  rcutils_time_point_value_t getTime(const TopicId topic, const size_t i) const
+  {
+    return topics_.at(topic).times.at(i);
+  }
+  // the serialized data of a message, which is not copied
+  const rcutils_uint8_array_t & getSerialized(const TopicId topic, const size_t i) const
+  {
+    return *topics_.at(topic).messages.at(i)->serialized_data;
+  }
+  const rosbag2_storage::SerializedBagMessageSharedPtr & getMessage(
+    const TopicId topic, const size_t i) const
+  {
+    return topics_.at(topic).messages.at(i);
+  }
+  const std::vector<Entry> & getEntries() const { return entries_; }
+
+  // @return : the first message received at @time or later, size() if none
+  size_t lowerBound(const TopicId topic, const rcutils_time_point_value_t time) const;
+  // @return : the last message received at @time or earlier, size() if none
+  size_t findLatest(const TopicId topic, const rcutils_time_point_value_t time) const;
+
+  // deserialize into @msg, so that the caller may reuse its memory
+  template <class T>
+  bool deserialize(const TopicId topic, const size_t i, T & msg) const
+  {
+    return rmw_deserialize(
+             &getSerialized(topic, i), rosidl_typesupport_cpp::get_message_type_support_handle<T>(),
+             &msg) == RMW_RET_OK;
+  }
+
+  // the same message as a seek in the bag, the first one received at @time or later
+  template <class T>
+  std::optional<T> seek(const TopicId topic, const rcutils_time_point_value_t time) const
+  {
+    return get<T>(topic, lowerBound(topic, time));
+  }
+
+  // the latest message received at @time or earlier
+  template <class T>
+  std::optional<T> getLatest(const TopicId topic, const rcutils_time_point_value_t time) const
+  {
+    return get<T>(topic, findLatest(topic, time));
+  }
+
+  // the last message of a topic
+  template <class T>
+  std::optional<T> getLast(const TopicId topic) const
+  {
+    return size(topic) == 0 ? std::nullopt : get<T>(topic, size(topic) - 1);
+  }
+
+  /**
+   * The messages @first to @last (excluded) of a topic deserialized by @thread_num workers, in
+   * their order. The messages which cannot be deserialized are left default constructed.
+   */
+  template <class T>
+  std::vector<T> deserializeAll(
+    const TopicId topic, const size_t thread_num, const size_t first = 0,
+    const size_t last = std::numeric_limits<size_t>::max()) const
+  {
+    const size_t end = std::min(last, size(topic));
+    const size_t begin = std::min(first, end);
+    std::vector<T> msgs(end - begin);
+    std::atomic<size_t> next_block(0);
+    constexpr size_t block_size = 64;
+
+    auto worker = [&]() {
+      for (size_t b = next_block++ * block_size; b < msgs.size(); b = next_block++ * block_size) {
+        for (size_t i = b; i < std::min(b + block_size, msgs.size()); i++) {
+          deserialize(topic, begin + i, msgs[i]);
+        }
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(thread_num, msgs.size() / block_size + 1); i++) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto & thread : threads) {
+      thread.join();
+    }
+    return msgs;
+  }
+
+private:
+  template <class T>
+  std::optional<T> get(const TopicId topic, const size_t i) const
+  {
+    T msg;
+    if (i >= size(topic) || !deserialize(topic, i, msg)) {
+      return std::nullopt;
+    }
+    return msg;
+  }
+
+  bool loadCache(const std::string & cache_path, const std::string & cache_key);
+  bool writeCache(const std::string & cache_path, const std::string & cache_key) const;
+
+  struct TopicIndex
+  {
+    std::string name;
+    // the received times, sorted, and the messages of the same positions
+    std::vector<rcutils_time_point_value_t> times;
+    std::vector<rosbag2_storage::SerializedBagMessageSharedPtr> messages;
+  };
+
+  rosbag2_storage::BagMetadata metadata_;
+  std::vector<TopicIndex> topics_;
+  std::unordered_map<std::string, TopicId> topic_ids_;
+  std::vector<Entry> entries_;
+  bool is_loaded_from_cache_{false};
+};
+
+}  // namespace autoware::bag_index
+
+#endif  // AUTOWARE__BAG_INDEX__BAG_INDEX_HPP_
@@ -0,0 +1,412 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/bag_index/bag_index.hpp"
+
+#include <rosbag2_cpp/reader.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoware::bag_index
+{
+
+namespace
+{
+constexpr char cache_magic[8] = {'B', 'A', 'G', 'I', 'D', 'X', '0', '1'};
+
+// the bag and the options the cache is built with, a cache of another key is rebuilt
+std::string makeCacheKey(
+  const rosbag2_storage::BagMetadata & metadata, const IndexOptions & options)
+{
+  std::ostringstream key;
+  key << metadata.starting_time.time_since_epoch().count() << ' ' << metadata.duration.count()
+      << ' ' << metadata.message_count << '\n';
+  auto topics = options.topics;
+  std::sort(topics.begin(), topics.end());
+  for (const auto & topic : topics) {
+    key << topic << '\n';
+  }
+  key << options.start_time << ' ' << options.end_time << '\n';
+  std::vector<std::pair<std::string, rcutils_time_point_value_t>> periods(
+    options.periods.begin(), options.periods.end());
+  std::sort(periods.begin(), periods.end());
+  for (const auto & [topic, period] : periods) {
+    key << topic << ' ' << period << '\n';
+  }
+  return key.str();
+}
+
+template <class M>
+auto setReceivedTime(M & msg, const rcutils_time_point_value_t time, int)
+  -> decltype(msg.recv_timestamp, void())
+{
+  msg.recv_timestamp = time;
+}
+
+template <class M>
+auto setReceivedTime(M & msg, const rcutils_time_point_value_t time, int64_t)
+  -> decltype(msg.time_stamp, void())
+{
+  msg.time_stamp = time;
+}
+
+template <class T>
+void writeValue(std::ofstream & ofs, const T & value)
+{
+  ofs.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void writeString(std::ofstream & ofs, const std::string & value)
+{
+  writeValue<uint64_t>(ofs, value.size());
+  ofs.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+// a read only memory mapped file, unmapped when the last message of it is released
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string & path)
+  {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      void * data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) {
+        data_ = static_cast<const uint8_t *>(data);
+        size_ = static_cast<size_t>(st.st_size);
+      }
+    }
+    ::close(fd);
+  }
+  ~MappedFile()
+  {
+    if (data_) {
+      ::munmap(const_cast<uint8_t *>(data_), size_);
+    }
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+  const uint8_t * data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const uint8_t * data_{nullptr};
+  size_t size_{0};
+};
+
+// reads the values of a mapped file in order, and fails past its end
+class CacheCursor
+{
+public:
+  explicit CacheCursor(const MappedFile & file) : file_(file) {}
+
+  bool read(void * value, const size_t size)
+  {
+    if (!ok_ || size > file_.size() - position_) {
+      ok_ = false;
+      return false;
+    }
+    if (size == 0) {
+      return true;
+    }
+    std::memcpy(value, file_.data() + position_, size);
+    position_ += size;
+    return true;
+  }
+  template <class T>
+  T read()
+  {
+    T value{};
+    read(&value, sizeof(T));
+    return value;
+  }
+  std::string readString()
+  {
+    const auto size = read<uint64_t>();
+    if (!ok_ || size > file_.size() - position_) {
+      ok_ = false;
+      return {};
+    }
+    std::string value(reinterpret_cast<const char *>(file_.data() + position_), size);
+    position_ += size;
+    return value;
+  }
+  // the next @size bytes, without a copy
+  const uint8_t * skip(const size_t size)
+  {
+    if (!ok_ || size > file_.size() - position_) {
+      ok_ = false;
+      return nullptr;
+    }
+    const auto data = file_.data() + position_;
+    position_ += size;
+    return data;
+  }
+  bool ok() const { return ok_; }
+
+private:
+  const MappedFile & file_;
+  size_t position_{0};
+  bool ok_{true};
+};
+}  // namespace
+
+BagIndex::BagIndex(const std::string & bag_path, const IndexOptions & options)
+{
+  rosbag2_cpp::Reader reader;
+  reader.open(bag_path);
+  metadata_ = reader.get_metadata();
+
+  std::string cache_key;
+  if (!options.cache_path.empty()) {
+    cache_key = makeCacheKey(metadata_, options);
+    if (loadCache(options.cache_path, cache_key)) {
+      is_loaded_from_cache_ = true;
+      return;
+    }
+  }
+
+  if (!options.topics.empty()) {
+    rosbag2_storage::StorageFilter filter;
+    filter.topics = options.topics;
+    reader.set_filter(filter);
+  }
+  if (options.start_time > 0) {
+    reader.seek(options.start_time);
+  }
+
+  // the periods of the topics, by the position of the topics in topics_
+  std::vector<rcutils_time_point_value_t> periods;
+
+  // the storage returns the messages in the order of their received time
+  while (reader.has_next()) {
+    auto message = reader.read_next();
+    const auto time = getReceivedTime(*message, 0);
+    if (options.end_time > 0 && time > options.end_time) {
+      break;
+    }
+
+    auto [itr, inserted] = topic_ids_.try_emplace(message->topic_name, topics_.size());
+    if (inserted) {
+      topics_.push_back(TopicIndex{message->topic_name, {}, {}});
+      const auto period = options.periods.find(message->topic_name);
+      periods.push_back(period == options.periods.end() ? 0 : period->second);
+    }
+    const TopicId topic = itr->second;
+    auto & index = topics_[topic];
+
+    if (
+      periods[topic] > 0 && !index.times.empty() &&
+      time / periods[topic] <= index.times.back() / periods[topic]) {
+      continue;
+    }
+    entries_.push_back(Entry{topic, index.times.size()});
+    index.times.push_back(time);
+    index.messages.push_back(std::move(message));
+  }
+
+  if (!options.cache_path.empty()) {
+    writeCache(options.cache_path, cache_key);
+  }
+}
+
+std::string BagIndex::getDefaultCachePath(const std::string & bag_path)
+{
+  auto path = std::filesystem::path(bag_path);
+  if (!path.has_filename()) {
+    path = path.parent_path();
+  }
+  return path.string() + ".bag_index";
+}
+
+/**
+ * The layout of the cache: the magic and the key, the topics with their names and message
+ * numbers, the topic of each entry, then the received times, the sizes and the serialized data
+ * of the messages, topic by topic. It is written to a temporary file, then renamed, so that a
+ * cache is complete if it exists.
+ */
+bool BagIndex::writeCache(const std::string & cache_path, const std::string & cache_key) const
+{
+  const auto temporary_path = cache_path + ".tmp";
+  {
+    std::ofstream ofs(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!ofs) {
+      return false;
+    }
+    ofs.write(cache_magic, sizeof(cache_magic));
+    writeString(ofs, cache_key);
+    writeValue<uint64_t>(ofs, topics_.size());
+    for (const auto & index : topics_) {
+      writeString(ofs, index.name);
+      writeValue<uint64_t>(ofs, index.times.size());
+    }
+    writeValue<uint64_t>(ofs, entries_.size());
+    for (const auto & entry : entries_) {
+      writeValue<uint32_t>(ofs, static_cast<uint32_t>(entry.topic));
+    }
+    for (const auto & index : topics_) {
+      ofs.write(
+        reinterpret_cast<const char *>(index.times.data()),
+        static_cast<std::streamsize>(index.times.size() * sizeof(rcutils_time_point_value_t)));
+    }
+    for (const auto & index : topics_) {
+      for (const auto & message : index.messages) {
+        writeValue<uint64_t>(ofs, message->serialized_data->buffer_length);
+      }
+    }
+    for (const auto & index : topics_) {
+      for (const auto & message : index.messages) {
+        ofs.write(
+          reinterpret_cast<const char *>(message->serialized_data->buffer),
+          static_cast<std::streamsize>(message->serialized_data->buffer_length));
+      }
+    }
+    if (!ofs) {
+      std::remove(temporary_path.c_str());
+      return false;
+    }
+  }
+  return std::rename(temporary_path.c_str(), cache_path.c_str()) == 0;
+}
+
+// The serialized data of the messages point into the mapped cache, which is not copied
+bool BagIndex::loadCache(const std::string & cache_path, const std::string & cache_key)
+{
+  const auto file = std::make_shared<const MappedFile>(cache_path);
+  if (!file->data()) {
+    return false;
+  }
+  CacheCursor cursor(*file);
+  char magic[sizeof(cache_magic)];
+  if (
+    !cursor.read(magic, sizeof(magic)) ||
+    std::memcmp(magic, cache_magic, sizeof(cache_magic)) != 0 || cursor.readString() != cache_key) {
+    return false;
+  }
+
+  const auto topic_num = cursor.read<uint64_t>();
+  if (!cursor.ok() || topic_num > file->size()) {
+    return false;
+  }
+  std::vector<TopicIndex> topics(topic_num);
+  for (auto & index : topics) {
+    index.name = cursor.readString();
+    const auto message_num = cursor.read<uint64_t>();
+    if (!cursor.ok() || message_num > file->size()) {
+      return false;
+    }
+    index.times.resize(message_num);
+    index.messages.resize(message_num);
+  }
+
+  std::vector<Entry> entries(cursor.read<uint64_t>());
+  if (!cursor.ok() || entries.size() > file->size()) {
+    return false;
+  }
+  std::vector<size_t> counts(topics.size(), 0);
+  for (auto & entry : entries) {
+    entry.topic = cursor.read<uint32_t>();
+    if (entry.topic >= topics.size() || counts[entry.topic] == topics[entry.topic].times.size()) {
+      return false;
+    }
+    entry.index = counts[entry.topic]++;
+  }
+
+  for (auto & index : topics) {
+    cursor.read(index.times.data(), index.times.size() * sizeof(rcutils_time_point_value_t));
+  }
+  std::vector<std::vector<uint64_t>> sizes(topics.size());
+  for (size_t t = 0; t < topics.size(); t++) {
+    sizes[t].resize(topics[t].times.size());
+    cursor.read(sizes[t].data(), sizes[t].size() * sizeof(uint64_t));
+  }
+  for (size_t t = 0; t < topics.size() && cursor.ok(); t++) {
+    auto & index = topics[t];
+    for (size_t i = 0; i < index.messages.size(); i++) {
+      const auto data = cursor.skip(sizes[t][i]);
+      if (!data) {
+        return false;
+      }
+      auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+      message->topic_name = index.name;
+      setReceivedTime(*message, index.times[i], 0);
+      auto * serialized_data = new rcutils_uint8_array_t{};
+      serialized_data->buffer = const_cast<uint8_t *>(data);
+      serialized_data->buffer_length = sizes[t][i];
+      serialized_data->buffer_capacity = sizes[t][i];
+      message->serialized_data = std::shared_ptr<rcutils_uint8_array_t>(
+        serialized_data, [file](rcutils_uint8_array_t * array) { delete array; });
+      index.messages[i] = std::move(message);
+    }
+  }
+  if (!cursor.ok()) {
+    return false;
+  }
+
+  topics_ = std::move(topics);
+  entries_ = std::move(entries);
+  topic_ids_.clear();
+  for (size_t t = 0; t < topics_.size(); t++) {
+    topic_ids_.emplace(topics_[t].name, t);
+  }
+  return true;
+}
+
+BagIndex::TopicId BagIndex::getTopicId(const std::string & topic_name) const
+{
+  const auto itr = topic_ids_.find(topic_name);
+  return itr == topic_ids_.end() ? invalid_topic : itr->second;
+}
+
+size_t BagIndex::lowerBound(const TopicId topic, const rcutils_time_point_value_t time) const
+{
+  if (topic >= topics_.size()) {
+    return 0;
+  }
+  const auto & times = topics_[topic].times;
+  return std::lower_bound(times.begin(), times.end(), time) - times.begin();
+}
+
+size_t BagIndex::findLatest(const TopicId topic, const rcutils_time_point_value_t time) const
+{
+  if (topic >= topics_.size()) {
+    return 0;
+  }
+  const auto & times = topics_[topic].times;
+  const size_t upper = std::upper_bound(times.begin(), times.end(), time) - times.begin();
+  return upper == 0 ? times.size() : upper - 1;
+}
+
+}  // namespace autoware::bag_index
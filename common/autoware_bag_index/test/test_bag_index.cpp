@@ -0,0 +1,157 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/bag_index/bag_index.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+#include <rosbag2_cpp/writer.hpp>
+
+#include <std_msgs/msg/int32.hpp>
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using autoware::bag_index::BagIndex;
+using autoware::bag_index::IndexOptions;
+using std_msgs::msg::Int32;
+
+namespace
+{
+constexpr rcutils_time_point_value_t ms = 1000000;
+
+// /a at every 100 ms from 1 s with the data of its position, /b at every 250 ms from 1 s
+class BagIndexTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    uri_ = (std::filesystem::temp_directory_path() / "test_bag_index").string();
+    std::filesystem::remove_all(uri_);
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = uri_;
+    storage_options.storage_id = "sqlite3";
+    rosbag2_cpp::Writer writer;
+    writer.open(storage_options, rosbag2_cpp::ConverterOptions{"cdr", "cdr"});
+    for (int i = 0; i < 40; i++) {
+      const rcutils_time_point_value_t t = 1000 * ms + i * 25 * ms;
+      if (i % 4 == 0) {
+        Int32 msg;
+        msg.data = i / 4;
+        writer.write(msg, "/a", rclcpp::Time(t));
+      }
+      if (i % 10 == 0) {
+        Int32 msg;
+        msg.data = -i / 10;
+        writer.write(msg, "/b", rclcpp::Time(t));
+      }
+    }
+  }
+
+  void TearDown() override
+  {
+    std::filesystem::remove_all(uri_);
+    std::filesystem::remove(BagIndex::getDefaultCachePath(uri_));
+  }
+
+  std::string uri_;
+};
+}  // namespace
+
+TEST_F(BagIndexTest, IndexByTopicAndTime)
+{
+  const BagIndex index(uri_);
+  const auto a = index.getTopicId("/a");
+  const auto b = index.getTopicId("/b");
+  ASSERT_NE(a, BagIndex::invalid_topic);
+  ASSERT_NE(b, BagIndex::invalid_topic);
+  EXPECT_EQ(index.getTopicId("/c"), BagIndex::invalid_topic);
+  EXPECT_EQ(index.size(a), 10u);
+  EXPECT_EQ(index.size(b), 4u);
+  EXPECT_EQ(index.getEntries().size(), 14u);
+
+  // the same message as a seek, and the latest one before
+  EXPECT_EQ(index.seek<Int32>(a, 1150 * ms)->data, 2);
+  EXPECT_EQ(index.getLatest<Int32>(a, 1150 * ms)->data, 1);
+  EXPECT_EQ(index.getLatest<Int32>(b, 1500 * ms)->data, -2);
+  EXPECT_FALSE(index.seek<Int32>(a, 2000 * ms).has_value());
+  EXPECT_FALSE(index.getLatest<Int32>(a, 999 * ms).has_value());
+  EXPECT_EQ(index.getLast<Int32>(b)->data, -3);
+
+  // the entries are in the order of the bag
+  rcutils_time_point_value_t previous = 0;
+  for (const auto & entry : index.getEntries()) {
+    EXPECT_GE(index.getTime(entry.topic, entry.index), previous);
+    previous = index.getTime(entry.topic, entry.index);
+  }
+
+  const auto msgs = index.deserializeAll<Int32>(a, 4);
+  ASSERT_EQ(msgs.size(), 10u);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(msgs[i].data, i);
+  }
+}
+
+TEST_F(BagIndexTest, FilterTopicsTimeAndPeriod)
+{
+  IndexOptions options;
+  options.topics = {"/a"};
+  options.start_time = 1200 * ms;
+  options.end_time = 1700 * ms;
+  options.periods["/a"] = 250 * ms;
+  const BagIndex index(uri_, options);
+  EXPECT_EQ(index.getTopicId("/b"), BagIndex::invalid_topic);
+
+  // the first ones of the periods from 1000, 1250 and 1500 ms, in the range
+  const auto a = index.getTopicId("/a");
+  const auto msgs = index.deserializeAll<Int32>(a, 1);
+  ASSERT_EQ(msgs.size(), 3u);
+  EXPECT_EQ(msgs[0].data, 2);
+  EXPECT_EQ(msgs[1].data, 3);
+  EXPECT_EQ(msgs[2].data, 5);
+}
+
+TEST_F(BagIndexTest, LoadFromCache)
+{
+  IndexOptions options;
+  options.periods["/a"] = 250 * ms;
+  options.cache_path = BagIndex::getDefaultCachePath(uri_);
+  const BagIndex cold(uri_, options);
+  EXPECT_FALSE(cold.isLoadedFromCache());
+  ASSERT_TRUE(std::filesystem::exists(options.cache_path));
+
+  const BagIndex warm(uri_, options);
+  EXPECT_TRUE(warm.isLoadedFromCache());
+  ASSERT_EQ(warm.getTopicNum(), cold.getTopicNum());
+  ASSERT_EQ(warm.getEntries().size(), cold.getEntries().size());
+  for (const auto & topic : {"/a", "/b"}) {
+    const auto id = warm.getTopicId(topic);
+    ASSERT_EQ(id, cold.getTopicId(topic));
+    const auto warm_msgs = warm.deserializeAll<Int32>(id, 1);
+    const auto cold_msgs = cold.deserializeAll<Int32>(id, 1);
+    ASSERT_EQ(warm_msgs.size(), cold_msgs.size());
+    for (size_t i = 0; i < warm_msgs.size(); i++) {
+      EXPECT_EQ(warm.getTime(id, i), cold.getTime(id, i));
+      EXPECT_EQ(warm_msgs[i].data, cold_msgs[i].data);
+    }
+  }
+
+  // other options are not served by the cache of the previous ones
+  options.periods.clear();
+  const BagIndex other(uri_, options);
+  EXPECT_FALSE(other.isLoadedFromCache());
+  EXPECT_EQ(other.size(other.getTopicId("/a")), 10u);
+}
@@ -0,0 +1,201 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__CSV_UTILS__CSV_READER_HPP_
+#define AUTOWARE__CSV_UTILS__CSV_READER_HPP_
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace autoware::csv_utils
+{
+
+/**
+ * The fields of a line, as views into the file. Numbers are parsed with std::from_chars, after
+ * the spaces around the field are trimmed.
+ */
+class CsvRow
+{
+public:
+  CsvRow(const std::string_view line, const char delimiter)
+  {
+    size_t begin = 0;
+    while (true) {
+      const size_t end = line.find(delimiter, begin);
+      fields_.push_back(trim(line.substr(begin, end - begin)));
+      if (end == std::string_view::npos) {
+        break;
+      }
+      begin = end + 1;
+    }
+  }
+
+  size_t size() const { return fields_.size(); }
+  std::string_view operator[](const size_t i) const { return fields_[i]; }
+
+  // nullopt if the field is missing or is not a number of the type as a whole
+  template <typename T>
+  std::optional<T> get(const size_t i) const
+  {
+    static_assert(std::is_arithmetic_v<T>, "get is for the numbers, use [] for the text");
+    if (i >= fields_.size()) {
+      return std::nullopt;
+    }
+    return parse<T>(fields_[i]);
+  }
+
+  template <typename T>
+  static std::optional<T> parse(const std::string_view field)
+  {
+    T value{};
+    const auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (ec != std::errc() || end != field.data() + field.size() || field.empty()) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+private:
+  static std::string_view trim(std::string_view field)
+  {
+    while (!field.empty() && (field.front() == ' ' || field.front() == '\t')) {
+      field.remove_prefix(1);
+    }
+    while (!field.empty() &&
+           (field.back() == ' ' || field.back() == '\t' || field.back() == '\r')) {
+      field.remove_suffix(1);
+    }
+    return field;
+  }
+
+  std::vector<std::string_view> fields_;
+};
+
+/**
+ * A CSV file memory mapped at once, whose lines are split and parsed in place instead of being
+ * copied into strings. The first line is the header unless told otherwise, and the empty lines
+ * are skipped. The rows can be parsed by several threads, each on a chunk of the file cut at the
+ * line ends, and the results are kept in the order of the file.
+ */
+class CsvReader
+{
+public:
+  explicit CsvReader(
+    const std::string & path, const char delimiter = ',', const bool has_header = true);
+  ~CsvReader();
+  CsvReader(const CsvReader &) = delete;
+  CsvReader & operator=(const CsvReader &) = delete;
+
+  bool isOpen() const { return is_open_; }
+  const std::vector<std::string> & header() const { return header_; }
+  std::optional<size_t> columnIndex(const std::string_view name) const;
+
+  // @parse returns std::optional<T> of a row, and the rows it returns nullopt for are skipped.
+  // 0 threads is one per core.
+  template <typename T, typename F>
+  std::vector<T> parseRows(F && parse, size_t thread_num = 1) const
+  {
+    const auto chunks = splitChunks(thread_num == 0 ? defaultThreadNum() : thread_num);
+    std::vector<std::vector<T>> results(chunks.size());
+    const auto parse_chunk = [&](const size_t c) {
+      forEachLine(chunks[c].first, chunks[c].second, [&](const std::string_view line) {
+        if (auto value = parse(CsvRow(line, delimiter_))) {
+          results[c].push_back(std::move(*value));
+        }
+      });
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t c = 1; c < chunks.size(); ++c) {
+      threads.emplace_back(parse_chunk, c);
+    }
+    if (!chunks.empty()) {
+      parse_chunk(0);
+    }
+    for (auto & thread : threads) {
+      thread.join();
+    }
+
+    if (results.size() == 1) {
+      return std::move(results.front());
+    }
+    std::vector<T> rows;
+    size_t row_num = 0;
+    for (const auto & result : results) {
+      row_num += result.size();
+    }
+    rows.reserve(row_num);
+    for (auto & result : results) {
+      std::move(result.begin(), result.end(), std::back_inserter(rows));
+    }
+    return rows;
+  }
+
+  // the values of a column, skipping the rows where it is not a number
+  template <typename T>
+  std::vector<T> column(const size_t index, const size_t thread_num = 1) const
+  {
+    return parseRows<T>([index](const CsvRow & row) { return row.get<T>(index); }, thread_num);
+  }
+
+  // calls @f with the CsvRow of each row in the calling thread
+  template <typename F>
+  void forEachRow(F && f) const
+  {
+    forEachLine(body_begin_, size_, [&](const std::string_view line) {
+      f(CsvRow(line, delimiter_));
+    });
+  }
+
+private:
+  template <typename F>
+  void forEachLine(size_t begin, const size_t end, F && f) const
+  {
+    while (begin < end) {
+      const char * const line_begin = data_ + begin;
+      const char * const line_end = std::find(line_begin, data_ + end, '\n');
+      std::string_view line(line_begin, static_cast<size_t>(line_end - line_begin));
+      if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+      }
+      if (!line.empty()) {
+        f(line);
+      }
+      begin = static_cast<size_t>(line_end - data_) + 1;
+    }
+  }
+
+  // [begin, end) of the body split into @chunk_num ranges of whole lines
+  std::vector<std::pair<size_t, size_t>> splitChunks(size_t chunk_num) const;
+  static size_t defaultThreadNum();
+
+  const char * data_{nullptr};
+  size_t size_{0};
+  size_t body_begin_{0};
+  char delimiter_;
+  bool is_open_{false};
+  std::vector<std::string> header_;
+};
+}  // namespace autoware::csv_utils
+
+#endif  // AUTOWARE__CSV_UTILS__CSV_READER_HPP_
@@ -0,0 +1,127 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__CSV_UTILS__CSV_WRITER_HPP_
+#define AUTOWARE__CSV_UTILS__CSV_WRITER_HPP_
+
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace autoware::csv_utils
+{
+
+/**
+ * A line of fields, formatted with std::to_chars. The floating point numbers are written in the
+ * shortest form which reads back to the same value, or as printf("%.<precision>g") if a
+ * precision is given, which is also the format of a default std::ostream for 6. The booleans are
+ * written as 1 and 0, and the text is written as it is.
+ */
+class CsvLine
+{
+public:
+  explicit CsvLine(const int precision = -1, const char delimiter = ',')
+  : precision_(precision), delimiter_(delimiter)
+  {
+  }
+
+  template <typename T>
+  CsvLine & add(const T & value)
+  {
+    if (!is_first_) {
+      text_ += delimiter_;
+    }
+    is_first_ = false;
+
+    if constexpr (std::is_same_v<T, bool>) {
+      text_ += value ? '1' : '0';
+    } else if constexpr (std::is_floating_point_v<T>) {
+      char buffer[64];
+      const auto result =
+        precision_ < 0 ? std::to_chars(buffer, buffer + sizeof(buffer), value)
+                       : std::to_chars(
+                           buffer, buffer + sizeof(buffer), value, std::chars_format::general,
+                           precision_);
+      text_.append(buffer, result.ptr);
+    } else if constexpr (std::is_arithmetic_v<T>) {
+      char buffer[32];
+      const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+      text_.append(buffer, result.ptr);
+    } else {
+      text_ += std::string_view(value);
+    }
+    return *this;
+  }
+
+  void clear()
+  {
+    text_.clear();
+    is_first_ = true;
+  }
+
+  const std::string & str() const { return text_; }
+
+private:
+  std::string text_;
+  int precision_;
+  char delimiter_;
+  bool is_first_{true};
+};
+
+/**
+ * Lines appended to a buffer, which is written to the file when it fills up, when flushed and
+ * when the writer is destroyed, instead of a write or a flush of a stream per line.
+ */
+class CsvWriter
+{
+public:
+  CsvWriter() = default;
+  explicit CsvWriter(const std::string & path, const size_t buffer_size = 1 << 20)
+  {
+    open(path, buffer_size);
+  }
+  ~CsvWriter();
+  CsvWriter(const CsvWriter &) = delete;
+  CsvWriter & operator=(const CsvWriter &) = delete;
+
+  // closes the current file first, and truncates the file
+  bool open(const std::string & path, const size_t buffer_size = 1 << 20);
+  bool close();
+  bool isOpen() const { return file_ != nullptr; }
+
+  void writeLine(const CsvLine & line) { writeLine(std::string_view(line.str())); }
+  void writeLine(const std::string_view line)
+  {
+    buffer_.append(line);
+    buffer_ += '\n';
+    if (buffer_.size() >= buffer_size_) {
+      flush();
+    }
+  }
+
+  // false if the file could not be written since it was opened
+  bool flush();
+
+private:
+  std::FILE * file_{nullptr};
+  std::string buffer_;
+  size_t buffer_size_{0};
+  bool is_good_{true};
+};
+}  // namespace autoware::csv_utils
+
+#endif  // AUTOWARE__CSV_UTILS__CSV_WRITER_HPP_
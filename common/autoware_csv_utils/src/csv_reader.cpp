@@ -0,0 +1,107 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/csv_utils/csv_reader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace autoware::csv_utils
+{
+CsvReader::CsvReader(const std::string & path, const char delimiter, const bool has_header)
+: delimiter_(delimiter)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return;
+  }
+  // an empty file can't be mapped, and has no rows
+  if (st.st_size > 0) {
+    void * data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      ::close(fd);
+      return;
+    }
+    ::madvise(data, st.st_size, MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(data);
+    size_ = static_cast<size_t>(st.st_size);
+  }
+  ::close(fd);
+  is_open_ = true;
+
+  if (has_header && size_ > 0) {
+    const char * const header_end = std::find(data_, data_ + size_, '\n');
+    const std::string_view header_line(data_, static_cast<size_t>(header_end - data_));
+    const CsvRow header(header_line, delimiter);
+    for (size_t i = 0; i < header.size(); ++i) {
+      header_.emplace_back(header[i]);
+    }
+    body_begin_ = std::min(static_cast<size_t>(header_end - data_) + 1, size_);
+  }
+}
+
+CsvReader::~CsvReader()
+{
+  if (data_) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+std::optional<size_t> CsvReader::columnIndex(const std::string_view name) const
+{
+  const auto it = std::find(header_.begin(), header_.end(), name);
+  if (it == header_.end()) {
+    return std::nullopt;
+  }
+  return static_cast<size_t>(it - header_.begin());
+}
+
+std::vector<std::pair<size_t, size_t>> CsvReader::splitChunks(size_t chunk_num) const
+{
+  // chunks smaller than this cost more to hand to a thread than to parse
+  constexpr size_t min_chunk_size = 1 << 20;
+  const size_t body_size = size_ - body_begin_;
+  chunk_num = std::max<size_t>(std::min(chunk_num, body_size / min_chunk_size), 1);
+
+  std::vector<std::pair<size_t, size_t>> chunks;
+  size_t begin = body_begin_;
+  for (size_t c = 1; c <= chunk_num && begin < size_; ++c) {
+    size_t end = c == chunk_num ? size_ : body_begin_ + body_size * c / chunk_num;
+    // each chunk ends after a line end, so that no line is split
+    end = std::max(end, begin);
+    end = std::min<size_t>(std::find(data_ + end, data_ + size_, '\n') - data_ + 1, size_);
+    chunks.emplace_back(begin, end);
+    begin = end;
+  }
+  return chunks;
+}
+
+size_t CsvReader::defaultThreadNum()
+{
+  return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+}  // namespace autoware::csv_utils
@@ -0,0 +1,67 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/csv_utils/csv_writer.hpp"
+
+#include <cstdio>
+#include <string>
+
+namespace autoware::csv_utils
+{
+CsvWriter::~CsvWriter()
+{
+  close();
+}
+
+bool CsvWriter::open(const std::string & path, const size_t buffer_size)
+{
+  close();
+  file_ = std::fopen(path.c_str(), "wb");
+  buffer_size_ = buffer_size;
+  buffer_.reserve(buffer_size);
+  is_good_ = file_ != nullptr;
+  return is_good_;
+}
+
+bool CsvWriter::close()
+{
+  if (!file_) {
+    return is_good_;
+  }
+  flush();
+  if (std::fclose(file_) != 0) {
+    is_good_ = false;
+  }
+  file_ = nullptr;
+  return is_good_;
+}
+
+bool CsvWriter::flush()
+{
+  if (!file_) {
+    buffer_.clear();
+    return false;
+  }
+  // the buffer is handed to the file as a whole, so the stdio buffer is bypassed
+  if (
+    !buffer_.empty() && std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+    is_good_ = false;
+  }
+  buffer_.clear();
+  if (std::fflush(file_) != 0) {
+    is_good_ = false;
+  }
+  return is_good_;
+}
+}  // namespace autoware::csv_utils
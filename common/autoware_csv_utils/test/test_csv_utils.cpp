@@ -0,0 +1,124 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/csv_utils/csv_reader.hpp"
+#include "autoware/csv_utils/csv_writer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using autoware::csv_utils::CsvLine;
+using autoware::csv_utils::CsvReader;
+using autoware::csv_utils::CsvRow;
+using autoware::csv_utils::CsvWriter;
+
+namespace
+{
+std::string temporaryPath(const std::string & name)
+{
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void writeFile(const std::string & path, const std::string & contents)
+{
+  std::ofstream ofs(path, std::ios::binary);
+  ofs << contents;
+}
+}  // namespace
+
+TEST(CsvReader, ReadsTypedColumns)
+{
+  const auto path = temporaryPath("test_csv_reader.csv");
+  writeFile(path, "x, y ,name\r\n1.5,2,a\n\n-3e2, 4 ,b\nbad,6,c");
+
+  const CsvReader reader(path);
+  ASSERT_TRUE(reader.isOpen());
+  EXPECT_EQ(reader.header(), (std::vector<std::string>{"x", "y", "name"}));
+  EXPECT_EQ(reader.columnIndex("y"), std::optional<size_t>(1));
+  EXPECT_FALSE(reader.columnIndex("z").has_value());
+  EXPECT_EQ(reader.column<double>(0), (std::vector<double>{1.5, -300.0}));
+  EXPECT_EQ(reader.column<int>(1), (std::vector<int>{2, 4, 6}));
+
+  std::vector<std::string> names;
+  reader.forEachRow([&names](const CsvRow & row) { names.emplace_back(row[2]); });
+  EXPECT_EQ(names, (std::vector<std::string>{"a", "b", "c"}));
+}
+
+TEST(CsvReader, ParsesChunksInOrder)
+{
+  const auto path = temporaryPath("test_csv_reader_chunks.csv");
+  std::string contents = "i,j\n";
+  constexpr int row_num = 300000;
+  for (int i = 0; i < row_num; ++i) {
+    contents += std::to_string(i) + "," + std::to_string(2 * i) + "\n";
+  }
+  writeFile(path, contents);
+
+  const CsvReader reader(path);
+  const auto rows = reader.parseRows<std::pair<int, int>>(
+    [](const CsvRow & row) -> std::optional<std::pair<int, int>> {
+      const auto i = row.get<int>(0);
+      const auto j = row.get<int>(1);
+      if (!i || !j) {
+        return std::nullopt;
+      }
+      return std::make_pair(*i, *j);
+    },
+    4);
+  ASSERT_EQ(rows.size(), static_cast<size_t>(row_num));
+  for (int i = 0; i < row_num; ++i) {
+    ASSERT_EQ(rows[i], std::make_pair(i, 2 * i));
+  }
+}
+
+TEST(CsvReader, MissingFile)
+{
+  const CsvReader reader(temporaryPath("test_csv_reader_missing.csv"));
+  EXPECT_FALSE(reader.isOpen());
+  EXPECT_TRUE(reader.column<double>(0).empty());
+}
+
+TEST(CsvWriter, WritesLinesReadBack)
+{
+  const auto path = temporaryPath("test_csv_writer.csv");
+  {
+    CsvWriter writer(path, 16);
+    ASSERT_TRUE(writer.isOpen());
+    writer.writeLine("a,b,c,d");
+    for (int i = 0; i < 100; ++i) {
+      writer.writeLine(CsvLine().add(i).add(0.1 * i).add(i % 2 == 0).add("text"));
+    }
+    EXPECT_TRUE(writer.close());
+  }
+
+  const CsvReader reader(path);
+  EXPECT_EQ(reader.column<int>(0).size(), 100u);
+  const auto values = reader.column<double>(1);
+  ASSERT_EQ(values.size(), 100u);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(values[i], 0.1 * i);
+  }
+}
+
+TEST(CsvLine, FormatsWithPrecision)
+{
+  EXPECT_EQ(CsvLine(6).add(1.0 / 3.0).add(true).add(-7).str(), "0.333333,1,-7");
+  EXPECT_EQ(CsvLine().add(0.1).add(std::string("x")).str(), "0.1,x");
+}
@@ -0,0 +1,158 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__RVIZ_SUBSCRIPTION_HUB__SUBSCRIPTION_HUB_HPP_
+#define AUTOWARE__RVIZ_SUBSCRIPTION_HUB__SUBSCRIPTION_HUB_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+#include <rosidl_runtime_cpp/traits.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace autoware::rviz_subscription_hub
+{
+
+// registration of a callback to the hub, which is unregistered when the last copy is destroyed
+using SubscriptionHandle = std::shared_ptr<void>;
+
+/**
+ * Process-wide subscriptions shared by the rviz plugins. The plugins subscribing to the same
+ * topic with the same type, reliability and durability share one subscription, whose message is
+ * deserialized once and passed to all their callbacks.
+ *
+ * - The subscription is created on the node and with the history depth of the first
+ *   registration, and destroyed with the last handle of the topic.
+ * - The last message of a transient local topic is kept, and passed to the callbacks registered
+ *   later when they are registered, as a subscription of their own would receive it.
+ * - The callbacks are called with the lock of the topic held, so that no callback is called
+ *   after its handle is destroyed. They must not register or unregister to the same topic.
+ */
+class SubscriptionHub
+{
+public:
+  template <typename MessageT>
+  using Callback = std::function<void(const typename MessageT::ConstSharedPtr &)>;
+
+  static SubscriptionHub & instance();
+
+  template <typename MessageT>
+  SubscriptionHandle subscribe(
+    const rclcpp::Node::SharedPtr & node, const std::string & topic_name, const rclcpp::QoS & qos,
+    Callback<MessageT> callback)
+  {
+    const std::string resolved_topic_name =
+      node->get_node_topics_interface()->resolve_topic_name(topic_name);
+    const std::string key = resolved_topic_name + " " +
+                            rosidl_generator_traits::name<MessageT>() + " " +
+                            std::to_string(static_cast<int>(qos.reliability())) + " " +
+                            std::to_string(static_cast<int>(qos.durability()));
+
+    std::shared_ptr<Channel<MessageT>> channel;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      channel = std::static_pointer_cast<Channel<MessageT>>(findChannel(key));
+      if (!channel) {
+        channel = std::make_shared<Channel<MessageT>>(
+          qos.durability() == rclcpp::DurabilityPolicy::TransientLocal);
+        channel->subscribe(node, resolved_topic_name, qos);
+        channels_[key] = channel;
+      }
+    }
+
+    const uint64_t id = channel->add(std::move(callback));
+    return SubscriptionHandle(nullptr, [channel, id](void *) { channel->remove(id); });
+  }
+
+private:
+  class ChannelBase
+  {
+  public:
+    virtual ~ChannelBase() = default;
+  };
+
+  template <typename MessageT>
+  class Channel : public ChannelBase, public std::enable_shared_from_this<Channel<MessageT>>
+  {
+  public:
+    explicit Channel(const bool keep_last_message) : keep_last_message_(keep_last_message) {}
+
+    void subscribe(
+      const rclcpp::Node::SharedPtr & node, const std::string & topic_name,
+      const rclcpp::QoS & qos)
+    {
+      // the executor may still run the callback while the last handle destroys the channel
+      std::weak_ptr<Channel> weak_channel = this->shared_from_this();
+      subscription_ = node->create_subscription<MessageT>(
+        topic_name, qos, [weak_channel](const typename MessageT::ConstSharedPtr msg) {
+          if (const auto channel = weak_channel.lock()) {
+            channel->dispatch(msg);
+          }
+        });
+    }
+
+    uint64_t add(Callback<MessageT> callback)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (last_message_) {
+        callback(last_message_);
+      }
+      callbacks_.emplace(next_id_, std::move(callback));
+      return next_id_++;
+    }
+
+    void remove(const uint64_t id)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      callbacks_.erase(id);
+    }
+
+  private:
+    void dispatch(const typename MessageT::ConstSharedPtr & msg)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (keep_last_message_) {
+        last_message_ = msg;
+      }
+      for (const auto & [id, callback] : callbacks_) {
+        callback(msg);
+      }
+    }
+
+    const bool keep_last_message_;
+    typename rclcpp::Subscription<MessageT>::SharedPtr subscription_;
+
+    std::mutex mutex_;
+    // in the order of the registrations
+    std::map<uint64_t, Callback<MessageT>> callbacks_;
+    uint64_t next_id_{0};
+    typename MessageT::ConstSharedPtr last_message_;
+  };
+
+  SubscriptionHub() = default;
+
+  // the channel of the key if it is still alive, and drops the expired channels
+  std::shared_ptr<ChannelBase> findChannel(const std::string & key);
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::weak_ptr<ChannelBase>> channels_;
+};
+}  // namespace autoware::rviz_subscription_hub
+
+#endif  // AUTOWARE__RVIZ_SUBSCRIPTION_HUB__SUBSCRIPTION_HUB_HPP_
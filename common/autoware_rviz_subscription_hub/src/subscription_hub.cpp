@@ -0,0 +1,42 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/rviz_subscription_hub/subscription_hub.hpp"
+
+#include <memory>
+#include <string>
+
+namespace autoware::rviz_subscription_hub
+{
+SubscriptionHub & SubscriptionHub::instance()
+{
+  // defined in the shared library, so that it is the same instance for all the plugins
+  static SubscriptionHub hub;
+  return hub;
+}
+
+std::shared_ptr<SubscriptionHub::ChannelBase> SubscriptionHub::findChannel(const std::string & key)
+{
+  for (auto itr = channels_.begin(); itr != channels_.end();) {
+    if (itr->second.expired()) {
+      itr = channels_.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+
+  const auto itr = channels_.find(key);
+  return itr == channels_.end() ? nullptr : itr->second.lock();
+}
+}  // namespace autoware::rviz_subscription_hub
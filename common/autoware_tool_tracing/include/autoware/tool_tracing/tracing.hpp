@@ -0,0 +1,75 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__TOOL_TRACING__TRACING_HPP_
+#define AUTOWARE__TOOL_TRACING__TRACING_HPP_
+
+#include "autoware/tool_tracing/config.hpp"
+
+// The stages of the tools, traced as a stage_begin and a stage_end event of the
+// autoware_tool_tracing LTTng provider. The events of a thread are paired by the vtid context,
+// and the stages may nest. The names must outlive the stage, e.g. be literals.
+// Without LTTng the functions are empty inline ones, and the stages are compiled out.
+// The namespaces are not nested, as the tools built as C++14 include this header.
+namespace autoware
+{
+namespace tool_tracing
+{
+
+#ifdef AUTOWARE_TOOL_TRACING_ENABLED
+void traceStageBegin(const char * tool, const char * stage);
+void traceStageEnd(const char * tool, const char * stage);
+#else
+inline void traceStageBegin(const char *, const char *)
+{
+}
+inline void traceStageEnd(const char *, const char *)
+{
+}
+#endif
+
+// a stage from its construction to its destruction
+class ScopedStage
+{
+public:
+  ScopedStage(const char * tool, const char * stage) : tool_(tool), stage_(stage)
+  {
+    traceStageBegin(tool_, stage_);
+  }
+  ~ScopedStage() { traceStageEnd(tool_, stage_); }
+
+  ScopedStage(const ScopedStage &) = delete;
+  ScopedStage & operator=(const ScopedStage &) = delete;
+
+private:
+  const char * tool_;
+  const char * stage_;
+};
+
+}  // namespace tool_tracing
+}  // namespace autoware
+
+#define AUTOWARE_TOOL_TRACING_CONCAT_(a, b) a##b
+#define AUTOWARE_TOOL_TRACING_CONCAT(a, b) AUTOWARE_TOOL_TRACING_CONCAT_(a, b)
+
+// trace the rest of the enclosing scope as a stage of a tool
+#ifdef AUTOWARE_TOOL_TRACING_ENABLED
+#define AUTOWARE_TOOL_TRACING_STAGE(tool, stage)                            \
+  const ::autoware::tool_tracing::ScopedStage AUTOWARE_TOOL_TRACING_CONCAT( \
+    autoware_tool_tracing_stage_, __LINE__)(tool, stage)
+#else
+#define AUTOWARE_TOOL_TRACING_STAGE(tool, stage) static_cast<void>(0)
+#endif
+
+#endif  // AUTOWARE__TOOL_TRACING__TRACING_HPP_
@@ -0,0 +1,38 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// The LTTng-UST provider of the tools, read several times by lttng/tracepoint-event.h
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER autoware_tool_tracing
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "tp.h"
+
+#if !defined(AUTOWARE_TOOL_TRACING__TP_H_) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define AUTOWARE_TOOL_TRACING__TP_H_
+
+#include <lttng/tracepoint.h>
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER, stage_begin, TP_ARGS(const char *, tool_arg, const char *, stage_arg),
+  TP_FIELDS(ctf_string(tool, tool_arg) ctf_string(stage, stage_arg)))
+
+TRACEPOINT_EVENT(
+  TRACEPOINT_PROVIDER, stage_end, TP_ARGS(const char *, tool_arg, const char *, stage_arg),
+  TP_FIELDS(ctf_string(tool, tool_arg) ctf_string(stage, stage_arg)))
+
+#endif  // AUTOWARE_TOOL_TRACING__TP_H_
+
+#include <lttng/tracepoint-event.h>
@@ -0,0 +1,40 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/tool_tracing/tracing.hpp"
+
+#ifdef AUTOWARE_TOOL_TRACING_ENABLED
+
+#include "tp.h"
+
+namespace autoware
+{
+namespace tool_tracing
+{
+
+// the tracepoints only test a flag while no session enables them
+void traceStageBegin(const char * tool, const char * stage)
+{
+  tracepoint(autoware_tool_tracing, stage_begin, tool, stage);
+}
+
+void traceStageEnd(const char * tool, const char * stage)
+{
+  tracepoint(autoware_tool_tracing, stage_end, tool, stage);
+}
+
+}  // namespace tool_tracing
+}  // namespace autoware
+
+#endif  // AUTOWARE_TOOL_TRACING_ENABLED
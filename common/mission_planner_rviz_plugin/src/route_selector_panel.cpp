@@ -77,14 +77,16 @@ void RouteSelectorPanel::onInitialize()
   sub_mrm_goal_ = node->create_subscription<PoseStamped>(
     "/rviz/route_selector/mrm/goal", rclcpp::QoS(1),
     std::bind(&RouteSelectorPanel::onMrmGoal, this, std::placeholders::_1));
-  sub_main_state_ = node->create_subscription<RouteState>(
-    "/planning/mission_planning/route_selector/main/state", durable_qos,
+  // the route states are shared with the other plugins subscribing to them
+  auto & hub = autoware::rviz_subscription_hub::SubscriptionHub::instance();
+  sub_main_state_ = hub.subscribe<RouteState>(
+    node, "/planning/mission_planning/route_selector/main/state", durable_qos,
     std::bind(&RouteSelectorPanel::onMainState, this, std::placeholders::_1));
-  sub_mrm_state_ = node->create_subscription<RouteState>(
-    "/planning/mission_planning/route_selector/mrm/state", durable_qos,
+  sub_mrm_state_ = hub.subscribe<RouteState>(
+    node, "/planning/mission_planning/route_selector/mrm/state", durable_qos,
     std::bind(&RouteSelectorPanel::onMrmState, this, std::placeholders::_1));
-  sub_planner_state_ = node->create_subscription<RouteState>(
-    "/planning/mission_planning/state", durable_qos,
+  sub_planner_state_ = hub.subscribe<RouteState>(
+    node, "/planning/mission_planning/state", durable_qos,
     std::bind(&RouteSelectorPanel::onPlannerState, this, std::placeholders::_1));
 
   cli_main_clear_ =
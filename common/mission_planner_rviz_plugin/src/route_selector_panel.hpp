@@ -17,6 +17,7 @@
 
 #include <QLabel>
 #include <QPushButton>
+#include <autoware/rviz_subscription_hub/subscription_hub.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <rviz_common/panel.hpp>
 
@@ -53,9 +54,9 @@ private:
   void onMainGoal(const PoseStamped::ConstSharedPtr msg);
   void onMrmGoal(const PoseStamped::ConstSharedPtr msg);
 
-  rclcpp::Subscription<RouteState>::SharedPtr sub_main_state_;
-  rclcpp::Subscription<RouteState>::SharedPtr sub_mrm_state_;
-  rclcpp::Subscription<RouteState>::SharedPtr sub_planner_state_;
+  autoware::rviz_subscription_hub::SubscriptionHandle sub_main_state_;
+  autoware::rviz_subscription_hub::SubscriptionHandle sub_mrm_state_;
+  autoware::rviz_subscription_hub::SubscriptionHandle sub_planner_state_;
   void onMainState(RouteState::ConstSharedPtr msg);
   void onMrmState(RouteState::ConstSharedPtr msg);
   void onPlannerState(RouteState::ConstSharedPtr msg);
@@ -19,13 +19,18 @@
 #include <QHBoxLayout>
 #include <QHeaderView>
 #include <QVBoxLayout>
+#include <autoware/tool_tracing/tracing.hpp>
 #include <rviz_common/display_context.hpp>
 
 #include <unique_identifier_msgs/msg/uuid.hpp>
 
 #include <algorithm>
+#include <iomanip>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace rviz_plugins
 {
@@ -243,13 +248,17 @@ RTCManagerPanel::RTCManagerPanel(QWidget * parent) : rviz_common::Panel(parent)
     vertical_header->hide();
     auto horizontal_header = new QHeaderView(Qt::Horizontal);
     horizontal_header->setSectionResizeMode(QHeaderView::Stretch);
-    rtc_table_ = new QTableWidget();
-    rtc_table_->setColumnCount(column_size_);
-    rtc_table_->setHorizontalHeaderLabels(
-      {"ID", "Module", "AW\nSafe", "Recv\nCmd", "Auto\nMode", "State", "Start\nDistance",
-       "Finish\nDistance"});
+    rtc_table_model_ = new RTCStatusTableModel(this);
+    rtc_table_ = new QTableView();
+    rtc_table_->setModel(rtc_table_model_);
     rtc_table_->setVerticalHeader(vertical_header);
     rtc_table_->setHorizontalHeader(horizontal_header);
+    // this is to stable rtc display, keeping the space of 5 rows
+    const size_t min_display_size{5};
+    rtc_table_->setMinimumHeight(
+      horizontal_header->sizeHint().height() +
+      static_cast<int>(min_display_size) * vertical_header->defaultSectionSize() +
+      2 * rtc_table_->frameWidth());
     rtc_table_layout->addWidget(rtc_table_);
     v_layout->addLayout(rtc_table_layout);
   }
@@ -270,8 +279,11 @@ void RTCManagerPanel::onInitialize()
       raw_node_->create_client<AutoMode>(enable_auto_mode_namespace_ + "/" + a->module_name);
   }
 
-  sub_rtc_status_ = raw_node_->create_subscription<CooperateStatusArray>(
-    "/api/external/get/rtc_status", 1, std::bind(&RTCManagerPanel::onRTCStatus, this, _1));
+  // shared with the other plugins subscribing to the statuses
+  sub_rtc_status_ =
+    autoware::rviz_subscription_hub::SubscriptionHub::instance().subscribe<CooperateStatusArray>(
+      raw_node_, "/api/external/get/rtc_status", rclcpp::QoS{1},
+      std::bind(&RTCManagerPanel::onRTCStatus, this, _1));
 }
 
 void RTCAutoMode::onChangeToAutoMode()
@@ -296,7 +308,7 @@ void RTCAutoMode::onChangeToManualMode()
   auto_module_button_ptr->setChecked(false);
 }
 
-CooperateCommand setRTCCommandFromStatus(CooperateStatus & status)
+CooperateCommand setRTCCommandFromStatus(const CooperateStatus & status)
 {
   CooperateCommand cooperate_command;
   cooperate_command.uuid = status.uuid;
@@ -312,7 +324,7 @@ void RTCManagerPanel::onClickChangeRequest(const bool is_path_change, const uint
   auto executable_cooperate_commands_request = std::make_shared<CooperateCommands::Request>();
   executable_cooperate_commands_request->stamp = cooperate_statuses_ptr_->stamp;
   // send coop request
-  for (auto status : cooperate_statuses_ptr_->statuses) {
+  for (const auto & status : cooperate_statuses_ptr_->statuses) {
     if (is_path_change ^ isPathChangeModule(status.module.type)) continue;
     CooperateCommand cooperate_command = setRTCCommandFromStatus(status);
     cooperate_command.command.type = command;
@@ -332,7 +344,7 @@ void RTCManagerPanel::onClickCommandRequest(const uint8_t command)
   auto executable_cooperate_commands_request = std::make_shared<CooperateCommands::Request>();
   executable_cooperate_commands_request->stamp = cooperate_statuses_ptr_->stamp;
   // send coop request
-  for (auto status : cooperate_statuses_ptr_->statuses) {
+  for (const auto & status : cooperate_statuses_ptr_->statuses) {
     CooperateCommand cooperate_command = setRTCCommandFromStatus(status);
     cooperate_command.command.type = command;
     executable_cooperate_commands_request->commands.emplace_back(cooperate_command);
@@ -367,86 +379,61 @@ void RTCManagerPanel::onClickWait()
 
 void RTCManagerPanel::onRTCStatus(const CooperateStatusArray::ConstSharedPtr msg)
 {
-  cooperate_statuses_ptr_ = std::make_shared<CooperateStatusArray>(*msg);
-  rtc_table_->clearContents();
+  AUTOWARE_TOOL_TRACING_STAGE("rtc_manager_panel", "on_rtc_status");
+
+  cooperate_statuses_ptr_ = msg;
   num_rtc_status_ptr_->setText(
     QString::fromStdString("The Number of RTC Statuses: " + std::to_string(msg->statuses.size())));
-  if (msg->statuses.empty()) {
-    rtc_table_->update();
-    return;
-  }
   // this is to stable rtc display not to occupy too much
-  size_t min_display_size{5};
   size_t max_display_size{10};
-  // rtc messages are already sorted by distance
-  rtc_table_->setRowCount(
-    std::max(min_display_size, std::min(msg->statuses.size(), max_display_size)));
-  int cnt = 0;
 
-  auto sorted_statuses = msg->statuses;
-  std::partition(sorted_statuses.begin(), sorted_statuses.end(), [](const auto & status) {
-    return !status.auto_mode && !uint2bool(status.command_status.type);
+  // rtc messages are already sorted by distance
+  std::vector<const CooperateStatus *> sorted_statuses;
+  sorted_statuses.reserve(msg->statuses.size());
+  for (const auto & status : msg->statuses) {
+    sorted_statuses.push_back(&status);
+  }
+  std::stable_partition(sorted_statuses.begin(), sorted_statuses.end(), [](const auto * status) {
+    return !status->auto_mode && !uint2bool(status->command_status.type);
   });
+  sorted_statuses.resize(std::min(sorted_statuses.size(), max_display_size));
+
+  std::vector<RTCStatusTableModel::Row> rows;
+  rows.reserve(sorted_statuses.size());
+  for (const auto * status : sorted_statuses) {
+    RTCStatusTableModel::Row row;
+    row.uuid = status->uuid.uuid;
 
-  for (auto status : sorted_statuses) {
-    if (static_cast<size_t>(cnt) >= max_display_size) {
-      rtc_table_->update();
-      return;
-    }
     // uuid
     {
       std::stringstream uuid;
-      uuid << std::setw(4) << std::setfill('0') << static_cast<int>(status.uuid.uuid.at(0));
-      auto label = new QLabel(QString::fromStdString(uuid.str()));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(uuid.str()));
-      rtc_table_->setCellWidget(cnt, 0, label);
+      uuid << std::setw(4) << std::setfill('0') << static_cast<int>(status->uuid.uuid.at(0));
+      row.cells.at(0) = QString::fromStdString(uuid.str());
     }
 
     // module name
-    {
-      std::string module_name = getModuleName(status.module.type);
-      auto label = new QLabel(QString::fromStdString(module_name));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(module_name));
-      rtc_table_->setCellWidget(cnt, 1, label);
-    }
+    row.cells.at(1) = QString::fromStdString(getModuleName(status->module.type));
 
     // is aw safe
-    bool is_aw_safe = status.safe;
-    {
-      std::string is_safe = Bool2String(is_aw_safe);
-      auto label = new QLabel(QString::fromStdString(is_safe));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(is_safe));
-      rtc_table_->setCellWidget(cnt, 2, label);
-    }
+    const bool is_aw_safe = status->safe;
+    row.cells.at(2) = QString::fromStdString(Bool2String(is_aw_safe));
 
     // is operator safe
-    const bool is_execute = uint2bool(status.command_status.type);
+    const bool is_execute = uint2bool(status->command_status.type);
     {
       std::string text = is_execute ? "EXECUTE" : "WAIT";
-      if (status.auto_mode) text = "NONE";
-      auto label = new QLabel(QString::fromStdString(text));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(text));
-      rtc_table_->setCellWidget(cnt, 3, label);
+      if (status->auto_mode) text = "NONE";
+      row.cells.at(3) = QString::fromStdString(text);
     }
 
     // is auto mode
-    const bool is_rtc_auto_mode = status.auto_mode;
-    {
-      std::string is_auto_mode = Bool2String(is_rtc_auto_mode);
-      auto label = new QLabel(QString::fromStdString(is_auto_mode));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(is_auto_mode));
-      rtc_table_->setCellWidget(cnt, 4, label);
-    }
+    const bool is_rtc_auto_mode = status->auto_mode;
+    row.cells.at(4) = QString::fromStdString(Bool2String(is_rtc_auto_mode));
 
     // State
     std::string module_state = "NONE";
     {
-      switch (status.state.type) {
+      switch (status->state.type) {
         case State::WAITING_FOR_EXECUTION:
           module_state = "Waiting";
           break;
@@ -465,41 +452,28 @@ void RTCManagerPanel::onRTCStatus(const CooperateStatusArray::ConstSharedPtr msg
         default:
           break;
       }
-      auto label = new QLabel(QString::fromStdString(module_state));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(module_state));
-      rtc_table_->setCellWidget(cnt, 5, label);
+      row.cells.at(5) = QString::fromStdString(module_state);
     }
 
     // start distance
-    {
-      std::string start_distance = std::to_string(status.start_distance);
-      auto label = new QLabel(QString::fromStdString(start_distance));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(start_distance));
-      rtc_table_->setCellWidget(cnt, 6, label);
-    }
+    row.cells.at(6) = QString::fromStdString(std::to_string(status->start_distance));
 
     // finish distance
-    {
-      std::string finish_distance = std::to_string(status.finish_distance);
-      auto label = new QLabel(QString::fromStdString(finish_distance));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(finish_distance));
-      rtc_table_->setCellWidget(cnt, 7, label);
-    }
+    row.cells.at(7) = QString::fromStdString(std::to_string(status->finish_distance));
 
     // add color for recognition
     if (is_rtc_auto_mode || (is_aw_safe && is_execute)) {
-      rtc_table_->cellWidget(cnt, 1)->setStyleSheet(BG_GREEN);
+      row.module_color = COLOR_GREEN;
     } else if (is_aw_safe || is_execute) {
-      rtc_table_->cellWidget(cnt, 1)->setStyleSheet(BG_YELLOW);
+      row.module_color = COLOR_YELLOW;
     } else {
-      rtc_table_->cellWidget(cnt, 1)->setStyleSheet(BG_RED);
+      row.module_color = COLOR_RED;
     }
-    cnt++;
+    rows.push_back(std::move(row));
   }
-  rtc_table_->update();
+
+  // only the changed cells are redrawn, without recreating the widgets
+  rtc_table_model_->update(std::move(rows));
 }
 }  // namespace rviz_plugins
 
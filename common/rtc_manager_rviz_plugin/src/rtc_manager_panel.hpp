@@ -17,10 +17,14 @@
 #ifndef RTC_MANAGER_PANEL_HPP_
 #define RTC_MANAGER_PANEL_HPP_
 
+#include "rtc_status_table_model.hpp"
+
+#include <QColor>
 #include <QLabel>
 #include <QPushButton>
 #include <QSpinBox>
 #include <QString>
+#include <QTableView>
 #include <QTableWidget>
 
 #ifndef Q_MOC_RUN
@@ -30,6 +34,7 @@
 #include <string>
 #include <vector>
 // ros
+#include <autoware/rviz_subscription_hub/subscription_hub.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <rviz_common/panel.hpp>
 
@@ -65,6 +70,9 @@ static const QString BG_PURPLE = "background-color: #9e3dff;";
 static const QString BG_ORANGE = "background-color: #ff7f00;";
 static const QString BG_GREEN = "background-color: #3dff3d;";
 static const QString BG_RED = "background-color: #ff3d3d;";
+static const QColor COLOR_GREEN("#3dff3d");
+static const QColor COLOR_YELLOW("#ffff3d");
+static const QColor COLOR_RED("#ff3d3d");
 
 struct RTCAutoMode : public QObject
 {
@@ -107,13 +115,14 @@ protected:
 
 private:
   rclcpp::Node::SharedPtr raw_node_;
-  rclcpp::Subscription<CooperateStatusArray>::SharedPtr sub_rtc_status_;
+  autoware::rviz_subscription_hub::SubscriptionHandle sub_rtc_status_;
   rclcpp::Client<CooperateCommands>::SharedPtr client_rtc_commands_;
   rclcpp::Client<AutoMode>::SharedPtr enable_auto_mode_cli_;
   std::vector<RTCAutoMode *> auto_modes_;
 
-  std::shared_ptr<CooperateStatusArray> cooperate_statuses_ptr_;
-  QTableWidget * rtc_table_;
+  CooperateStatusArray::ConstSharedPtr cooperate_statuses_ptr_;
+  QTableView * rtc_table_;
+  RTCStatusTableModel * rtc_table_model_;
   QTableWidget * auto_mode_table_;
   QPushButton * path_change_button_ptr_ = {nullptr};
   QPushButton * velocity_change_button_ptr_ = {nullptr};
@@ -125,7 +134,6 @@ private:
   QPushButton * wait_button_ptr_ = {nullptr};
   QLabel * num_rtc_status_ptr_ = {nullptr};
 
-  size_t column_size_ = {8};
   std::string enable_auto_mode_namespace_ = "/planning/enable_auto_mode";
 };
 
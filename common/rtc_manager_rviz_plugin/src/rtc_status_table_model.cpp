@@ -0,0 +1,135 @@
+//
+//  Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "rtc_status_table_model.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+RTCStatusTableModel::RTCStatusTableModel(QObject * parent) : QAbstractTableModel(parent)
+{
+}
+
+int RTCStatusTableModel::rowCount(const QModelIndex & parent) const
+{
+  return parent.isValid() ? 0 : static_cast<int>(rows_.size());
+}
+
+int RTCStatusTableModel::columnCount(const QModelIndex & parent) const
+{
+  return parent.isValid() ? 0 : column_size;
+}
+
+QVariant RTCStatusTableModel::data(const QModelIndex & index, int role) const
+{
+  if (!index.isValid() || index.row() >= rowCount() || index.column() >= column_size) {
+    return QVariant();
+  }
+
+  const auto & row = rows_.at(index.row());
+  switch (role) {
+    case Qt::DisplayRole:
+      return row.cells.at(index.column());
+    case Qt::TextAlignmentRole:
+      return static_cast<int>(Qt::AlignCenter);
+    case Qt::BackgroundRole:
+      return index.column() == 1 ? QVariant(row.module_color) : QVariant();
+    default:
+      return QVariant();
+  }
+}
+
+QVariant RTCStatusTableModel::headerData(
+  int section, Qt::Orientation orientation, int role) const
+{
+  static const std::array<QString, column_size> header{
+    "ID", "Module", "AW\nSafe", "Recv\nCmd", "Auto\nMode", "State", "Start\nDistance",
+    "Finish\nDistance"};
+
+  if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+    return QVariant();
+  }
+  if (section < 0 || section >= column_size) {
+    return QVariant();
+  }
+  return header.at(section);
+}
+
+void RTCStatusTableModel::update(std::vector<Row> && rows)
+{
+  const auto find_row = [](auto begin, auto end, const Row & row) {
+    return std::find_if(begin, end, [&](const Row & r) { return r.uuid == row.uuid; });
+  };
+
+  // remove the rows which are gone
+  for (int i = static_cast<int>(rows_.size()) - 1; i >= 0; --i) {
+    if (find_row(rows.begin(), rows.end(), rows_.at(i)) == rows.end()) {
+      beginRemoveRows(QModelIndex(), i, i);
+      rows_.erase(rows_.begin() + i);
+      endRemoveRows();
+    }
+  }
+
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const int row = static_cast<int>(i);
+    const auto itr = find_row(rows_.begin() + row, rows_.end(), rows.at(i));
+
+    // a new row
+    if (itr == rows_.end()) {
+      beginInsertRows(QModelIndex(), row, row);
+      rows_.insert(rows_.begin() + row, std::move(rows.at(i)));
+      endInsertRows();
+      continue;
+    }
+
+    // a row whose order changed
+    const int current_row = static_cast<int>(itr - rows_.begin());
+    if (current_row != row) {
+      beginMoveRows(QModelIndex(), current_row, current_row, QModelIndex(), row);
+      std::rotate(rows_.begin() + row, itr, itr + 1);
+      endMoveRows();
+    }
+
+    // the changed cells of the row
+    int first_column = column_size;
+    int last_column = -1;
+    for (int column = 0; column < column_size; ++column) {
+      const bool changed = rows_.at(i).cells.at(column) != rows.at(i).cells.at(column) ||
+                           (column == 1 && rows_.at(i).module_color != rows.at(i).module_color);
+      if (changed) {
+        first_column = std::min(first_column, column);
+        last_column = std::max(last_column, column);
+      }
+    }
+    if (last_column >= 0) {
+      rows_.at(i) = std::move(rows.at(i));
+      Q_EMIT dataChanged(index(row, first_column), index(row, last_column));
+    }
+  }
+
+  // rows left over from duplicated UUIDs
+  if (rows_.size() > rows.size()) {
+    beginRemoveRows(
+      QModelIndex(), static_cast<int>(rows.size()), static_cast<int>(rows_.size()) - 1);
+    rows_.resize(rows.size());
+    endRemoveRows();
+  }
+}
+
+}  // namespace rviz_plugins
@@ -0,0 +1,69 @@
+//
+//  Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef RTC_STATUS_TABLE_MODEL_HPP_
+#define RTC_STATUS_TABLE_MODEL_HPP_
+
+#include <QAbstractTableModel>
+#include <QColor>
+#include <QString>
+
+#ifndef Q_MOC_RUN
+// cpp
+#include <array>
+#include <vector>
+// ros
+#include <unique_identifier_msgs/msg/uuid.hpp>
+#endif
+
+namespace rviz_plugins
+{
+
+// Table of the RTC statuses, whose rows are kept by UUID so that only the changed cells are updated
+class RTCStatusTableModel : public QAbstractTableModel
+{
+  Q_OBJECT
+
+public:
+  static constexpr int column_size = 8;
+
+  struct Row
+  {
+    unique_identifier_msgs::msg::UUID::_uuid_type uuid;
+    std::array<QString, column_size> cells;
+    // background of the module cell
+    QColor module_color;
+  };
+
+  explicit RTCStatusTableModel(QObject * parent = nullptr);
+
+  int rowCount(const QModelIndex & parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex & parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const override;
+  QVariant headerData(
+    int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+  // removes, moves and inserts the rows by their UUID to match the new rows in this order,
+  // and notifies the views of the changed cells only
+  void update(std::vector<Row> && rows);
+
+private:
+  std::vector<Row> rows_;
+};
+
+}  // namespace rviz_plugins
+
+#endif  // RTC_STATUS_TABLE_MODEL_HPP_
@@ -18,6 +18,7 @@
 
 #include <autoware/universe_utils/ros/marker_helper.hpp>
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
@@ -27,8 +28,8 @@ AutowareAutomaticGoalPanel::AutowareAutomaticGoalPanel(QWidget * parent)
 : rviz_common::Panel(parent)
 {
   qt_timer_ = new QTimer(this);
-  connect(
-    qt_timer_, &QTimer::timeout, this, &AutowareAutomaticGoalPanel::updateAutoExecutionTimerTick);
+  // watchdog, the auto execution is stepped by the events
+  connect(qt_timer_, &QTimer::timeout, this, &AutowareAutomaticGoalPanel::runAutoExecution);
 
   auto * h_layout = new QHBoxLayout(this);
   auto * v_layout = new QVBoxLayout(this);
@@ -177,7 +178,7 @@ void AutowareAutomaticGoalPanel::onToggleAutoMode(bool checked)
   } else {
     if (checked) current_goal_ = goals_list_widget_ptr_->currentRow();
     is_automatic_mode_on_ = checked;
-    is_automatic_mode_on_ ? qt_timer_->start(1000) : qt_timer_->stop();
+    is_automatic_mode_on_ ? qt_timer_->start(2000) : qt_timer_->stop();
     onClickClearRoute();  // here will be set State::AUTO_NEXT or State::EDITING;
   }
 }
@@ -252,8 +253,7 @@ void AutowareAutomaticGoalPanel::onClickSaveListToFile()
 void AutowareAutomaticGoalPanel::onAppendGoal(const PoseStamped::ConstSharedPtr pose)
 {
   if (state_ == State::EDITING) {
-    goals_list_.emplace_back(pose);
-    updateGoalsList();
+    appendGoal(pose);
     updateGUI();
   }
 }
@@ -270,8 +270,9 @@ void AutowareAutomaticGoalPanel::onAppendCheckpoint(const PoseStamped::ConstShar
     return;
   }
 
-  goals_list_.at(current_goal_).checkpoint_pose_ptrs.push_back(pose);
-  publishMarkers();
+  auto & checkpoints = goals_list_.at(current_goal_).checkpoint_pose_ptrs;
+  checkpoints.push_back(pose);
+  publishMarkers(current_goal_, checkpoints.size() - 1);
 }
 
 // Override
@@ -279,17 +280,25 @@ void AutowareAutomaticGoalPanel::onCallResult()
 {
   updateGUI();
 }
+void AutowareAutomaticGoalPanel::onAutoExecutionEvent()
+{
+  // the events are called by the executor of the node, and the execution updates the widgets
+  QMetaObject::invokeMethod(this, [this]() { runAutoExecution(); }, Qt::QueuedConnection);
+}
 void AutowareAutomaticGoalPanel::onGoalListUpdated()
 {
   goals_list_widget_ptr_->clear();
   for (auto const & goal : goals_achieved_) {
-    auto * item =
-      new QListWidgetItem(QString::fromStdString(goal.second.first), goals_list_widget_ptr_);
-    goals_list_widget_ptr_->addItem(item);
-    updateGoalIcon(goals_list_widget_ptr_->count() - 1, QColor("lightGray"));
+    addGoalItem(goal.first);
   }
   publishMarkers();
 }
+void AutowareAutomaticGoalPanel::onGoalAppended(const unsigned goal_index)
+{
+  // the items and the markers of the other goals are kept as they are
+  addGoalItem(goal_index);
+  publishMarkers(goal_index, 0);
+}
 void AutowareAutomaticGoalPanel::onOperationModeUpdated(const OperationModeState::ConstSharedPtr)
 {
   updateGUI();
@@ -440,6 +449,14 @@ void AutowareAutomaticGoalPanel::updateGoalIcon(const unsigned goal_index, const
   goals_list_widget_ptr_->item(static_cast<int>(goal_index))->setIcon(icon);
 }
 
+void AutowareAutomaticGoalPanel::addGoalItem(const unsigned goal_index)
+{
+  auto * item = new QListWidgetItem(
+    QString::fromStdString(goals_achieved_[goal_index].first), goals_list_widget_ptr_);
+  goals_list_widget_ptr_->addItem(item);
+  updateGoalIcon(goals_list_widget_ptr_->count() - 1, QColor("lightGray"));
+}
+
 void AutowareAutomaticGoalPanel::publishMarkers()
 {
   using autoware::universe_utils::createDefaultMarker;
@@ -469,6 +486,33 @@ void AutowareAutomaticGoalPanel::publishMarkers()
   text_array.markers.clear();
   arrow_array.markers.clear();
 
+  // Publish current
+  for (size_t i = 0; i < goals_list_.size(); ++i) {
+    appendMarkers(i, 0, text_array, arrow_array);
+  }
+  pub_marker_->publish(text_array);
+  pub_marker_->publish(arrow_array);
+}
+
+void AutowareAutomaticGoalPanel::publishMarkers(
+  const size_t goal_index, const size_t first_checkpoint_index)
+{
+  // the markers of the ids already published are replaced, and the others are kept
+  MarkerArray text_array;
+  MarkerArray arrow_array;
+  appendMarkers(goal_index, first_checkpoint_index, text_array, arrow_array);
+  pub_marker_->publish(text_array);
+  pub_marker_->publish(arrow_array);
+}
+
+void AutowareAutomaticGoalPanel::appendMarkers(
+  const size_t goal_index, const size_t first_checkpoint_index, MarkerArray & text_array,
+  MarkerArray & arrow_array) const
+{
+  using autoware::universe_utils::createDefaultMarker;
+  using autoware::universe_utils::createMarkerColor;
+  using autoware::universe_utils::createMarkerScale;
+
   const auto push_arrow_marker = [&](const auto & pose, const auto & color, const size_t id) {
     auto marker = createDefaultMarker(
       "map", rclcpp::Clock{RCL_ROS_TIME}.now(), "poses", id, Marker::ARROW,
@@ -492,24 +536,24 @@ void AutowareAutomaticGoalPanel::publishMarkers()
     text_array.markers.push_back(marker);
   };
 
-  // Publish current
-  size_t id = 0;
-  for (size_t i = 0; i < goals_list_.size(); ++i) {
-    {
-      const auto pose = goals_list_.at(i).goal_pose_ptr->pose;
-      push_arrow_marker(pose, createMarkerColor(0.0, 1.0, 0.0, 0.999), id++);
-      push_text_marker(pose, "Goal:" + std::to_string(i), id++);
-    }
+  // the ids only depend on the goal and the checkpoint, so that a marker can be updated alone
+  constexpr size_t max_checkpoint_num = 0xFFFF;
+  const size_t goal_id = goal_index * (max_checkpoint_num + 1);
+  const auto & goal = goals_list_.at(goal_index);
+  if (first_checkpoint_index == 0) {
+    const auto pose = goal.goal_pose_ptr->pose;
+    push_arrow_marker(pose, createMarkerColor(0.0, 1.0, 0.0, 0.999), goal_id);
+    push_text_marker(pose, "Goal:" + std::to_string(goal_index), goal_id);
+  }
 
-    for (size_t j = 0; j < goals_list_.at(i).checkpoint_pose_ptrs.size(); ++j) {
-      const auto pose = goals_list_.at(i).checkpoint_pose_ptrs.at(j)->pose;
-      push_arrow_marker(pose, createMarkerColor(1.0, 1.0, 0.0, 0.999), id++);
-      push_text_marker(
-        pose, "Checkpoint:" + std::to_string(i) + "[Goal:" + std::to_string(j) + "]", id++);
-    }
+  const size_t checkpoint_num = std::min(goal.checkpoint_pose_ptrs.size(), max_checkpoint_num);
+  for (size_t j = first_checkpoint_index; j < checkpoint_num; ++j) {
+    const auto pose = goal.checkpoint_pose_ptrs.at(j)->pose;
+    push_arrow_marker(pose, createMarkerColor(1.0, 1.0, 0.0, 0.999), goal_id + j + 1);
+    push_text_marker(
+      pose, "Checkpoint:" + std::to_string(goal_index) + "[Goal:" + std::to_string(j) + "]",
+      goal_id + j + 1);
   }
-  pub_marker_->publish(text_array);
-  pub_marker_->publish(arrow_array);
 }
 
 // File
@@ -94,7 +94,9 @@ private:
   void onRouteUpdated(const RouteState::ConstSharedPtr msg) override;
   void onOperationModeUpdated(const OperationModeState::ConstSharedPtr msg) override;
   void onCallResult() override;
+  void onAutoExecutionEvent() override;
   void onGoalListUpdated() override;
+  void onGoalAppended(const unsigned goal_index) override;
 
   // Inputs
   void onAppendGoal(const PoseStamped::ConstSharedPtr pose);
@@ -103,7 +105,12 @@ private:
   // Visual updates
   void updateGUI();
   void updateGoalIcon(const unsigned goal_index, const QColor & color);
+  void addGoalItem(const unsigned goal_index);
   void publishMarkers();
+  void publishMarkers(const size_t goal_index, const size_t first_checkpoint_index);
+  void appendMarkers(
+    const size_t goal_index, const size_t first_checkpoint_index, MarkerArray & text_array,
+    MarkerArray & arrow_array) const;
   void showMessageBox(const QString & string);
   void disableAutomaticMode() { automatic_mode_btn_ptr_->setChecked(false); }
   static void activateButton(QAbstractButton * btn) { btn->setEnabled(true); }
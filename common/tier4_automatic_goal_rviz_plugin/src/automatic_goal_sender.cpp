@@ -13,7 +13,9 @@
 // limitations under the License.
 #include "automatic_goal_sender.hpp"
 
+#include <algorithm>
 #include <cstdio>
+#include <deque>
 #include <memory>
 #include <string>
 #include <utility>
@@ -29,9 +31,10 @@ void AutowareAutomaticGoalSender::init()
   loadParams(this);
   initCommunication(this);
   loadGoalsList(goals_list_file_path_);
+  // watchdog, the auto execution is stepped by the events
   timer_ = this->create_wall_timer(
-    std::chrono::milliseconds(500),
-    std::bind(&AutowareAutomaticGoalSender::updateAutoExecutionTimerTick, this));
+    std::chrono::milliseconds(2000),
+    std::bind(&AutowareAutomaticGoalSender::runAutoExecution, this));
 
   // Print info
   RCLCPP_INFO_STREAM(get_logger(), "GoalsList has been loaded from: " << goals_list_file_path_);
@@ -46,6 +49,7 @@ void AutowareAutomaticGoalSender::loadParams(rclcpp::Node * node)
   namespace fs = std::filesystem;
   node->declare_parameter("goals_list_file_path", "");
   node->declare_parameter("goals_achieved_dir_path", "");
+  node->declare_parameter("goals_achieved_max_lines", 10000);
   // goals_list
   goals_list_file_path_ = node->get_parameter("goals_list_file_path").as_string();
   if (!fs::exists(goals_list_file_path_) || !fs::is_regular_file(goals_list_file_path_))
@@ -57,6 +61,8 @@ void AutowareAutomaticGoalSender::loadParams(rclcpp::Node * node)
     throw std::invalid_argument(
       "goals_achieved_dir_path - directory path is invalid: " + goals_achieved_file_path_);
   goals_achieved_file_path_ += "goals_achieved.log";
+  max_achieved_goals_log_lines_ = static_cast<size_t>(
+    std::max<int64_t>(node->get_parameter("goals_achieved_max_lines").as_int(), 1));
 }
 
 void AutowareAutomaticGoalSender::initCommunication(rclcpp::Node * node)
@@ -92,6 +98,7 @@ void AutowareAutomaticGoalSender::onRoute(const RouteState::ConstSharedPtr msg)
   else if (msg->state == RouteState::ARRIVED && state_ == State::STARTED)
     state_ = State::ARRIVED;
   onRouteUpdated(msg);
+  onAutoExecutionEvent();
 }
 
 void AutowareAutomaticGoalSender::onOperationMode(const OperationModeState::ConstSharedPtr msg)
@@ -104,24 +111,48 @@ void AutowareAutomaticGoalSender::onOperationMode(const OperationModeState::Cons
     state_ = State::STARTED;
   is_autonomous_mode_available_ = msg->is_autonomous_mode_available;
   onOperationModeUpdated(msg);
+  onAutoExecutionEvent();
 }
 
 // Update
+std::string AutowareAutomaticGoalSender::getGoalName(const unsigned goal_index, const Route & goal)
+{
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(2);
+  tf2::Quaternion tf2_quat;
+  tf2::convert(goal.goal_pose_ptr->pose.orientation, tf2_quat);
+  ss << "G" << goal_index << " (" << goal.goal_pose_ptr->pose.position.x << ", ";
+  ss << goal.goal_pose_ptr->pose.position.y << ", " << tf2::getYaw(tf2_quat) << ")";
+  return ss.str();
+}
+
 void AutowareAutomaticGoalSender::updateGoalsList()
 {
-  unsigned i = 0;
-  for (const auto & goal : goals_list_) {
-    std::stringstream ss;
-    ss << std::fixed << std::setprecision(2);
-    tf2::Quaternion tf2_quat;
-    tf2::convert(goal.goal_pose_ptr->pose.orientation, tf2_quat);
-    ss << "G" << i << " (" << goal.goal_pose_ptr->pose.position.x << ", ";
-    ss << goal.goal_pose_ptr->pose.position.y << ", " << tf2::getYaw(tf2_quat) << ")";
-    goals_achieved_.insert({i++, std::make_pair(ss.str(), 0)});
+  for (unsigned i = 0; i < goals_list_.size(); ++i) {
+    goals_achieved_.insert({i, std::make_pair(getGoalName(i, goals_list_.at(i)), 0)});
   }
   onGoalListUpdated();
 }
 
+void AutowareAutomaticGoalSender::appendGoal(const PoseStamped::ConstSharedPtr & pose)
+{
+  goals_list_.emplace_back(pose);
+  const unsigned goal_index = goals_list_.size() - 1;
+  goals_achieved_.insert(
+    {goal_index, std::make_pair(getGoalName(goal_index, goals_list_.back()), 0)});
+  onGoalAppended(goal_index);
+}
+
+void AutowareAutomaticGoalSender::runAutoExecution()
+{
+  // a step which does not change the state waits for the next event or the watchdog
+  State previous_state{};
+  do {
+    previous_state = state_;
+    updateAutoExecutionTimerTick();
+  } while (state_ != previous_state && state_ != State::ERROR);
+}
+
 void AutowareAutomaticGoalSender::updateAutoExecutionTimerTick()
 {
   auto goal = goals_achieved_[current_goal_].first;
@@ -193,25 +224,92 @@ void AutowareAutomaticGoalSender::loadGoalsList(const std::string & file_path)
 
 void AutowareAutomaticGoalSender::updateAchievedGoalsFile(const unsigned goal_index)
 {
-  if (!goals_achieved_file_path_.empty()) {
-    std::ofstream out(goals_achieved_file_path_, std::fstream::app);
-    std::stringstream ss;
-    ss << "[" << getTimestamp() << "] Achieved: " << goals_achieved_[goal_index].first;
-    ss << ", Current number of achievements: " << goals_achieved_[goal_index].second << "\n";
-    out << ss.str();
-    out.close();
-  }
+  std::stringstream ss;
+  ss << "[" << getTimestamp() << "] Achieved: " << goals_achieved_[goal_index].first;
+  ss << ", Current number of achievements: " << goals_achieved_[goal_index].second;
+  appendAchievedGoalsLog(ss.str());
 }
 
 void AutowareAutomaticGoalSender::resetAchievedGoals()
 {
   goals_achieved_.clear();
-  if (!goals_achieved_file_path_.empty()) {
-    std::ofstream out(goals_achieved_file_path_, std::fstream::app);
-    out << "[" << getTimestamp()
-        << "] GoalsList was loaded from a file or a goal was removed - counters have been reset\n";
-    out.close();
+  appendAchievedGoalsLog(
+    "[" + getTimestamp() +
+    "] GoalsList was loaded from a file or a goal was removed - counters have been reset");
+}
+
+void AutowareAutomaticGoalSender::appendAchievedGoalsLog(const std::string & line)
+{
+  if (goals_achieved_file_path_.empty()) {
+    return;
+  }
+  // the path is changed by the panel
+  if (goals_achieved_file_path_ != achieved_goals_log_path_) {
+    openAchievedGoalsLog();
+  }
+
+  achieved_goals_log_stream_ << line << "\n";
+  achieved_goals_log_stream_.flush();
+  achieved_goals_log_lines_.push_back(line);
+  if (achieved_goals_log_lines_.size() > max_achieved_goals_log_lines_) {
+    achieved_goals_log_lines_.pop_front();
+  }
+  if (++achieved_goals_log_file_lines_ >= 2 * max_achieved_goals_log_lines_) {
+    compactAchievedGoalsLog();
+  }
+}
+
+void AutowareAutomaticGoalSender::openAchievedGoalsLog()
+{
+  achieved_goals_log_path_ = goals_achieved_file_path_;
+  achieved_goals_log_lines_.clear();
+  achieved_goals_log_file_lines_ = 0;
+
+  // the latest lines of the file of the previous runs, which are kept by the compaction
+  {
+    std::ifstream in(achieved_goals_log_path_);
+    std::string line;
+    while (std::getline(in, line)) {
+      achieved_goals_log_lines_.push_back(line);
+      if (achieved_goals_log_lines_.size() > max_achieved_goals_log_lines_) {
+        achieved_goals_log_lines_.pop_front();
+      }
+      ++achieved_goals_log_file_lines_;
+    }
+  }
+
+  if (achieved_goals_log_stream_.is_open()) {
+    achieved_goals_log_stream_.close();
+  }
+  achieved_goals_log_stream_.open(achieved_goals_log_path_, std::fstream::app);
+}
+
+void AutowareAutomaticGoalSender::compactAchievedGoalsLog()
+{
+  // retried after as many lines again if it fails
+  achieved_goals_log_file_lines_ = achieved_goals_log_lines_.size();
+
+  // written to a temporary file and renamed, so that the log is never left truncated
+  const std::string tmp_path = achieved_goals_log_path_ + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::fstream::trunc);
+    for (const auto & line : achieved_goals_log_lines_) {
+      out << line << "\n";
+    }
+    if (!out) {
+      RCLCPP_WARN_STREAM(get_logger(), "Failed to compact the achieved goals file: " << tmp_path);
+      return;
+    }
+  }
+
+  achieved_goals_log_stream_.close();
+  std::error_code error;
+  std::filesystem::rename(tmp_path, achieved_goals_log_path_, error);
+  if (error) {
+    RCLCPP_WARN_STREAM(
+      get_logger(), "Failed to compact the achieved goals file: " << error.message());
   }
+  achieved_goals_log_stream_.open(achieved_goals_log_path_, std::fstream::app);
 }
 }  // namespace automatic_goal
 
@@ -28,6 +28,7 @@
 #include <yaml-cpp/yaml.h>
 
 #include <chrono>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <map>
@@ -90,6 +91,7 @@ protected:
         if (result.get()->status.code != 0) state_ = State::ERROR;
         printCallResult<SetRoutePoints>(result);
         onCallResult();
+        onAutoExecutionEvent();
       });
     return true;
   }
@@ -106,6 +108,7 @@ protected:
       if (result.get()->status.code != 0) state_ = State::ERROR;
       printCallResult<T>(result);
       onCallResult();
+      onAutoExecutionEvent();
     });
     return true;
   }
@@ -132,12 +135,17 @@ protected:
 
   // Update
   void updateGoalsList();
+  void appendGoal(const PoseStamped::ConstSharedPtr & pose);
   virtual void updateAutoExecutionTimerTick();
+  // steps the auto execution until it waits for a response, a route or an operation mode
+  void runAutoExecution();
+  static std::string getGoalName(const unsigned goal_index, const Route & goal);
 
   // File
   void loadGoalsList(const std::string & file_path);
   void updateAchievedGoalsFile(const unsigned goal_index);
   void resetAchievedGoals();
+  void appendAchievedGoalsLog(const std::string & line);
   static std::string getTimestamp()
   {
     char buffer[128];
@@ -154,7 +162,12 @@ protected:
   virtual void onRouteUpdated(const RouteState::ConstSharedPtr) {}
   virtual void onOperationModeUpdated(const OperationModeState::ConstSharedPtr) {}
   virtual void onCallResult() {}
+  // The auto execution is stepped on the responses, the routes and the operation modes as soon
+  // as they change the state, and the timer is only a watchdog retrying the unavailable services.
+  virtual void onAutoExecutionEvent() { runAutoExecution(); }
   virtual void onGoalListUpdated() {}
+  // only the goal of the index has been appended to the end of the list
+  virtual void onGoalAppended(const unsigned) {}
 
   // Cli
   rclcpp::Client<ChangeOperationMode>::SharedPtr cli_change_to_autonomous_{nullptr};
@@ -177,9 +190,22 @@ private:
   rclcpp::Subscription<RouteState>::SharedPtr sub_route_{nullptr};
   rclcpp::Subscription<OperationModeState>::SharedPtr sub_operation_mode_{nullptr};
 
+  // File
+  void openAchievedGoalsLog();
+  void compactAchievedGoalsLog();
+
   // Containers
   std::string goals_list_file_path_{};
   rclcpp::TimerBase::SharedPtr timer_{nullptr};
+
+  // The achieved goals file is appended through a stream kept open, and rewritten with only its
+  // latest lines once it has grown to twice as many lines, so that both the file and the lines
+  // kept in memory are bounded in long runs.
+  size_t max_achieved_goals_log_lines_{10000};
+  std::string achieved_goals_log_path_{};
+  std::ofstream achieved_goals_log_stream_{};
+  std::deque<std::string> achieved_goals_log_lines_{};
+  size_t achieved_goals_log_file_lines_{0};
 };
 }  // namespace automatic_goal
 #endif  // AUTOMATIC_GOAL_SENDER_HPP_
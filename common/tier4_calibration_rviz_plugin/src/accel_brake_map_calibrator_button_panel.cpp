@@ -18,12 +18,16 @@
 
 #include "QFileDialog"
 #include "QHBoxLayout"
+#include "QImage"
 #include "QLineEdit"
 #include "QPainter"
+#include "QPixmap"
 #include "QPushButton"
+#include "autoware/tool_tracing/tracing.hpp"
 #include "pluginlib/class_list_macros.hpp"
 #include "rviz_common/display_context.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <thread>
@@ -31,8 +35,31 @@
 
 namespace tier4_calibration_rviz_plugin
 {
+namespace
+{
+// the outputs of the calibration adapter
+constexpr char accel_status_topic[] = "/calibration/vehicle/accel_status";
+constexpr char brake_status_topic[] = "/calibration/vehicle/brake_status";
+constexpr char acceleration_status_topic[] = "/calibration/vehicle/acceleration_status";
+constexpr char twist_status_topic[] = "/calibration/vehicle/twist_status";
+
+// cells of the map, by the brake pedal as negative and the accel pedal as positive
+constexpr double map_min_pedal = -1.0;
+constexpr double map_max_pedal = 1.0;
+constexpr size_t map_pedal_num = 20;
+constexpr double map_min_velocity = 0.0;
+constexpr double map_max_velocity = 20.0;
+constexpr size_t map_velocity_num = 20;
+// a cell is shown as converged with the samples
+constexpr size_t map_converged_sample_num = 50;
+constexpr int map_render_period_ms = 500;
+}  // namespace
+
 AccelBrakeMapCalibratorButtonPanel::AccelBrakeMapCalibratorButtonPanel(QWidget * parent)
-: rviz_common::Panel(parent)
+: rviz_common::Panel(parent),
+  map_accumulator_(
+    map_min_pedal, map_max_pedal, map_pedal_num, map_min_velocity, map_max_velocity,
+    map_velocity_num)
 {
   topic_label_ = new QLabel("topic: ");
   topic_label_->setAlignment(Qt::AlignCenter);
@@ -55,6 +82,22 @@ AccelBrakeMapCalibratorButtonPanel::AccelBrakeMapCalibratorButtonPanel(QWidget *
   status_label_->setAlignment(Qt::AlignCenter);
   status_label_->setStyleSheet("QLabel { background-color : darkgray;}");
 
+  // pedal on the horizontal axis and velocity on the vertical axis, from red to green by the
+  // number of the samples of each cell
+  map_label_ = new QLabel;
+  map_label_->setScaledContents(true);
+  map_label_->setMinimumSize(200, 200);
+  map_label_->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+
+  map_status_label_ = new QLabel("map: no sample");
+  map_status_label_->setAlignment(Qt::AlignCenter);
+
+  map_reset_button_ = new QPushButton("reset map");
+  connect(map_reset_button_, SIGNAL(clicked(bool)), SLOT(resetMap()));
+
+  map_timer_ = new QTimer(this);
+  connect(map_timer_, SIGNAL(timeout()), SLOT(updateMap()));
+
   QSizePolicy q_size_policy(QSizePolicy::Expanding, QSizePolicy::Expanding);
   calibration_button_->setSizePolicy(q_size_policy);
 
@@ -72,6 +115,12 @@ AccelBrakeMapCalibratorButtonPanel::AccelBrakeMapCalibratorButtonPanel(QWidget *
   v_layout->addWidget(calibration_button_);
   v_layout->addWidget(status_label_);
 
+  auto * map_layout = new QHBoxLayout;
+  map_layout->addWidget(map_status_label_);
+  map_layout->addWidget(map_reset_button_);
+  v_layout->addLayout(map_layout);
+  v_layout->addWidget(map_label_);
+
   setLayout(v_layout);
 }
 
@@ -87,6 +136,87 @@ void AccelBrakeMapCalibratorButtonPanel::onInitialize()
 
   client_ = raw_node->create_client<tier4_vehicle_msgs::srv::UpdateAccelBrakeMap>(
     service_edit_->text().toStdString());
+
+  accel_status_sub_ = raw_node->create_subscription<Float32Stamped>(
+    accel_status_topic, 10, [this](const Float32Stamped::ConstSharedPtr msg) {
+      std::lock_guard<std::mutex> lock(map_mutex_);
+      accel_pedal_ = msg->data;
+    });
+  brake_status_sub_ = raw_node->create_subscription<Float32Stamped>(
+    brake_status_topic, 10, [this](const Float32Stamped::ConstSharedPtr msg) {
+      std::lock_guard<std::mutex> lock(map_mutex_);
+      brake_pedal_ = msg->data;
+    });
+  twist_status_sub_ = raw_node->create_subscription<TwistStamped>(
+    twist_status_topic, 10, [this](const TwistStamped::ConstSharedPtr msg) {
+      std::lock_guard<std::mutex> lock(map_mutex_);
+      velocity_ = msg->twist.linear.x;
+    });
+  acceleration_status_sub_ = raw_node->create_subscription<Float32Stamped>(
+    acceleration_status_topic, 10,
+    std::bind(
+      &AccelBrakeMapCalibratorButtonPanel::callbackAcceleration, this, std::placeholders::_1));
+  map_timer_->start(map_render_period_ms);
+}
+
+void AccelBrakeMapCalibratorButtonPanel::callbackAcceleration(
+  const Float32Stamped::ConstSharedPtr msg)
+{
+  // the acceleration is accumulated at the latest pedals and velocity
+  std::lock_guard<std::mutex> lock(map_mutex_);
+  if (!accel_pedal_ || !brake_pedal_ || !velocity_) {
+    return;
+  }
+  map_accumulator_.add(*accel_pedal_ - *brake_pedal_, *velocity_, msg->data);
+}
+
+void AccelBrakeMapCalibratorButtonPanel::updateMap()
+{
+  AUTOWARE_TOOL_TRACING_STAGE("accel_brake_map_calibrator_button_panel", "update_map");
+
+  QImage image(
+    static_cast<int>(map_accumulator_.pedalNum()), static_cast<int>(map_accumulator_.velocityNum()),
+    QImage::Format_RGB32);
+  size_t sample_num = 0;
+  size_t converged_cell_num = 0;
+  {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    sample_num = map_accumulator_.sampleNum();
+    if (rendered_sample_num_ && *rendered_sample_num_ == sample_num) {
+      return;
+    }
+    for (size_t v = 0; v < map_accumulator_.velocityNum(); ++v) {
+      for (size_t p = 0; p < map_accumulator_.pedalNum(); ++p) {
+        const size_t count = map_accumulator_.at(p, v).count;
+        const double ratio =
+          std::min(static_cast<double>(count) / map_converged_sample_num, 1.0);
+        const QColor color =
+          count == 0 ? QColor(Qt::darkGray) : QColor::fromHsvF(ratio / 3.0, 1.0, 1.0);
+        // the higher velocity on the top
+        image.setPixel(
+          static_cast<int>(p), static_cast<int>(map_accumulator_.velocityNum() - 1 - v),
+          color.rgb());
+      }
+    }
+    converged_cell_num = map_accumulator_.countCells(map_converged_sample_num);
+  }
+  rendered_sample_num_ = sample_num;
+
+  map_label_->setPixmap(QPixmap::fromImage(image));
+  map_status_label_->setText(QString("map: %1 samples, %2/%3 cells converged")
+                               .arg(sample_num)
+                               .arg(converged_cell_num)
+                               .arg(map_accumulator_.pedalNum() * map_accumulator_.velocityNum()));
+}
+
+void AccelBrakeMapCalibratorButtonPanel::resetMap()
+{
+  {
+    std::lock_guard<std::mutex> lock(map_mutex_);
+    map_accumulator_.clear();
+  }
+  rendered_sample_num_.reset();
+  updateMap();
 }
 
 void AccelBrakeMapCalibratorButtonPanel::callbackUpdateSuggest(
@@ -21,16 +21,22 @@
 #include "QLineEdit"
 #include "QPushButton"
 #include "QSettings"
+#include "QTimer"
 
+#include <mutex>
+#include <optional>
 #include <string>
 #ifndef Q_MOC_RUN
 
+#include "calibration_map_accumulator.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rviz_common/panel.hpp"
 #include "rviz_common/properties/ros_topic_property.hpp"
 #endif
 
+#include "geometry_msgs/msg/twist_stamped.hpp"
 #include "std_msgs/msg/bool.hpp"
+#include "tier4_calibration_msgs/msg/float32_stamped.hpp"
 #include "tier4_vehicle_msgs/srv/update_accel_brake_map.hpp"
 
 namespace tier4_calibration_rviz_plugin
@@ -48,19 +54,44 @@ public Q_SLOTS:  // NOLINT for Qt
   void editTopic();
   void editService();
   void pushCalibrationButton();
+  void updateMap();
+  void resetMap();
 
 protected:
+  using Float32Stamped = tier4_calibration_msgs::msg::Float32Stamped;
+  using TwistStamped = geometry_msgs::msg::TwistStamped;
+
+  void callbackAcceleration(const Float32Stamped::ConstSharedPtr msg);
+
   rclcpp::Subscription<std_msgs::msg::Bool>::SharedPtr update_suggest_sub_;
   rclcpp::Client<tier4_vehicle_msgs::srv::UpdateAccelBrakeMap>::SharedPtr client_;
 
   bool after_calib_ = false;
 
+  // the map accumulated from the outputs of the calibration adapter, which is updated in the
+  // callbacks and rendered by the timer of the panel
+  rclcpp::Subscription<Float32Stamped>::SharedPtr accel_status_sub_;
+  rclcpp::Subscription<Float32Stamped>::SharedPtr brake_status_sub_;
+  rclcpp::Subscription<Float32Stamped>::SharedPtr acceleration_status_sub_;
+  rclcpp::Subscription<TwistStamped>::SharedPtr twist_status_sub_;
+  std::mutex map_mutex_;
+  CalibrationMapAccumulator map_accumulator_;
+  std::optional<double> accel_pedal_;
+  std::optional<double> brake_pedal_;
+  std::optional<double> velocity_;
+  // the map is rendered again only when the samples are added or cleared
+  std::optional<size_t> rendered_sample_num_;
+
   QLabel * topic_label_;
   QLineEdit * topic_edit_;
   QLabel * service_label_;
   QLineEdit * service_edit_;
   QPushButton * calibration_button_;
   QLabel * status_label_;
+  QLabel * map_label_;
+  QLabel * map_status_label_;
+  QPushButton * map_reset_button_;
+  QTimer * map_timer_;
 };
 
 }  // end namespace tier4_calibration_rviz_plugin
@@ -0,0 +1,82 @@
+//
+// Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "calibration_map_accumulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tier4_calibration_rviz_plugin
+{
+namespace
+{
+// index of the bin of the value in [min, max), or num if it is out of the range
+size_t toIndex(const double value, const double min, const double max, const size_t num)
+{
+  if (!std::isfinite(value) || value < min || value >= max) {
+    return num;
+  }
+  const auto index = static_cast<size_t>((value - min) / (max - min) * static_cast<double>(num));
+  return std::min(index, num - 1);
+}
+}  // namespace
+
+CalibrationMapAccumulator::CalibrationMapAccumulator(
+  const double min_pedal, const double max_pedal, const size_t pedal_num,
+  const double min_velocity, const double max_velocity, const size_t velocity_num)
+: min_pedal_(min_pedal),
+  max_pedal_(std::max(max_pedal, min_pedal)),
+  pedal_num_(std::max<size_t>(pedal_num, 1)),
+  min_velocity_(min_velocity),
+  max_velocity_(std::max(max_velocity, min_velocity)),
+  velocity_num_(std::max<size_t>(velocity_num, 1)),
+  cells_(pedal_num_ * velocity_num_)
+{
+}
+
+bool CalibrationMapAccumulator::add(
+  const double pedal, const double velocity, const double acceleration)
+{
+  const size_t pedal_index = toIndex(pedal, min_pedal_, max_pedal_, pedal_num_);
+  const size_t velocity_index = toIndex(velocity, min_velocity_, max_velocity_, velocity_num_);
+  if (
+    pedal_index == pedal_num_ || velocity_index == velocity_num_ ||
+    !std::isfinite(acceleration)) {
+    return false;
+  }
+
+  auto & cell = cells_.at(velocity_index * pedal_num_ + pedal_index);
+  cell.count++;
+  const double delta = acceleration - cell.mean;
+  cell.mean += delta / static_cast<double>(cell.count);
+  cell.m2 += delta * (acceleration - cell.mean);
+  sample_num_++;
+  return true;
+}
+
+void CalibrationMapAccumulator::clear()
+{
+  std::fill(cells_.begin(), cells_.end(), Cell{});
+  sample_num_ = 0;
+}
+
+size_t CalibrationMapAccumulator::countCells(const size_t min_sample_num) const
+{
+  return static_cast<size_t>(std::count_if(cells_.begin(), cells_.end(), [&](const Cell & cell) {
+    return cell.count >= std::max<size_t>(min_sample_num, 1);
+  }));
+}
+}  // namespace tier4_calibration_rviz_plugin
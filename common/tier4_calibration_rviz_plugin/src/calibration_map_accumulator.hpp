@@ -0,0 +1,77 @@
+//
+// Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef CALIBRATION_MAP_ACCUMULATOR_HPP_
+#define CALIBRATION_MAP_ACCUMULATOR_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace tier4_calibration_rviz_plugin
+{
+// Statistics of the acceleration in the cells of the pedal and the velocity, which are updated
+// online in constant time by the Welford's algorithm to show how the accel/brake map converges.
+// The pedal is positive for the accel and negative for the brake.
+class CalibrationMapAccumulator
+{
+public:
+  struct Cell
+  {
+    size_t count{0};
+    double mean{0.0};
+    // sum of the squared differences from the mean
+    double m2{0.0};
+
+    double variance() const { return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0; }
+  };
+
+  CalibrationMapAccumulator(
+    const double min_pedal, const double max_pedal, const size_t pedal_num,
+    const double min_velocity, const double max_velocity, const size_t velocity_num);
+
+  // returns false if the pedal or the velocity is out of the map
+  bool add(const double pedal, const double velocity, const double acceleration);
+  void clear();
+
+  const Cell & at(const size_t pedal_index, const size_t velocity_index) const
+  {
+    return cells_.at(velocity_index * pedal_num_ + pedal_index);
+  }
+  size_t pedalNum() const { return pedal_num_; }
+  size_t velocityNum() const { return velocity_num_; }
+  double minPedal() const { return min_pedal_; }
+  double maxPedal() const { return max_pedal_; }
+  double minVelocity() const { return min_velocity_; }
+  double maxVelocity() const { return max_velocity_; }
+  // number of the samples added to the cells
+  size_t sampleNum() const { return sample_num_; }
+  // number of the cells which have at least the samples
+  size_t countCells(const size_t min_sample_num) const;
+
+private:
+  const double min_pedal_;
+  const double max_pedal_;
+  const size_t pedal_num_;
+  const double min_velocity_;
+  const double max_velocity_;
+  const size_t velocity_num_;
+  // in the row major order of the velocity
+  std::vector<Cell> cells_;
+  size_t sample_num_{0};
+};
+}  // namespace tier4_calibration_rviz_plugin
+
+#endif  // CALIBRATION_MAP_ACCUMULATOR_HPP_
@@ -22,7 +22,9 @@
 #include <QVBoxLayout>
 #include <rviz_common/display_context.hpp>
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <string>
 
 using std::placeholders::_1;
@@ -88,21 +90,86 @@ ManualController::ManualController(QWidget * parent) : rviz_common::Panel(parent
   cruise_velocity_layout->addWidget(steering_angle_ptr_);
   cruise_velocity_layout->addWidget(new QLabel("  [deg]"));
 
+  // Command Period
+  command_period_label_ptr_ = new QLabel("Command Period: INIT");
+
   // Layout
   auto * v_layout = new QVBoxLayout;
   v_layout->addLayout(state_layout);
   v_layout->addLayout(cruise_velocity_layout);
+  v_layout->addWidget(command_period_label_ptr_);
   setLayout(v_layout);
 
+  // only for the statistics, as the commands are published by the command thread
   auto * timer = new QTimer(this);
   connect(timer, &QTimer::timeout, this, &ManualController::update);
-  timer->start(30);
+  timer->start(500);
+}
+
+ManualController::~ManualController()
+{
+  is_command_thread_running_ = false;
+  if (command_thread_.joinable()) {
+    command_thread_.join();
+  }
 }
 
 void ManualController::update()
 {
   if (!raw_node_) return;
 
+  const QString period_text = QString("Command Period: %1 [ms] (max: %2 [ms])")
+                                .arg(command_period_mean_.load() * 1e3, 0, 'f', 1)
+                                .arg(command_period_max_.load() * 1e3, 0, 'f', 1);
+  command_period_label_ptr_->setText(period_text);
+}
+
+void ManualController::runCommandLoop()
+{
+  using std::chrono::steady_clock;
+
+  // the next wake up is scheduled from the last one, so that the period does not drift
+  auto next_time = steady_clock::now();
+  std::optional<steady_clock::time_point> prev_publish_time;
+  steady_clock::time_point statistics_begin_time = next_time;
+  double period_sum = 0.0;
+  double period_max = 0.0;
+  size_t period_num = 0;
+
+  while (is_command_thread_running_) {
+    next_time += command_period_;
+    std::this_thread::sleep_until(next_time);
+    // skips the periods missed by a long stall, instead of publishing them in a burst
+    const auto now = steady_clock::now();
+    if (now - next_time > command_period_) {
+      next_time = now;
+    }
+
+    publishCommand();
+
+    if (prev_publish_time) {
+      const double period = std::chrono::duration<double>(now - *prev_publish_time).count();
+      period_sum += period;
+      period_max = std::max(period_max, period);
+      ++period_num;
+    }
+    prev_publish_time = now;
+    if (now - statistics_begin_time >= std::chrono::seconds(1) && period_num > 0) {
+      command_period_mean_ = period_sum / static_cast<double>(period_num);
+      command_period_max_ = period_max;
+      statistics_begin_time = now;
+      period_sum = 0.0;
+      period_max = 0.0;
+      period_num = 0;
+    }
+  }
+}
+
+void ManualController::publishCommand()
+{
+  const double cruise_velocity = cruise_velocity_;
+  const double steering_angle = steering_angle_;
+
   const auto velocity = sub_velocity_->takeData();
   const double current_velocity = velocity ? velocity->longitudinal_velocity : 0.0;
 
@@ -112,8 +179,8 @@ void ManualController::update()
   Control control_cmd;
   {
     control_cmd.stamp = raw_node_->get_clock()->now();
-    control_cmd.lateral.steering_tire_angle = steering_angle_;
-    control_cmd.longitudinal.velocity = cruise_velocity_;
+    control_cmd.lateral.steering_tire_angle = steering_angle;
+    control_cmd.longitudinal.velocity = cruise_velocity;
     /**
      * @brief Calculate desired acceleration by simple BackSteppingControl
      *  V = 0.5*(v-v_des)^2 >= 0
@@ -122,7 +189,7 @@ void ManualController::update()
      */
     const double k = -0.5;
     const double v = current_velocity;
-    const double v_des = cruise_velocity_;
+    const double v_des = cruise_velocity;
     const double a = current_acceleration;
     const double a_des = k * (v - v_des) + a;
     control_cmd.longitudinal.acceleration = std::clamp(a_des, -1.0, 1.0);
@@ -147,9 +214,11 @@ void ManualController::update()
 void ManualController::onManualSteering()
 {
   const double scale_factor = -0.25;
-  steering_angle_ = scale_factor * steering_slider_ptr_->sliderPosition() * M_PI / 180.0;
+  const double steering_angle =
+    scale_factor * steering_slider_ptr_->sliderPosition() * M_PI / 180.0;
+  steering_angle_ = steering_angle;
   const QString steering_string =
-    QString::fromStdString(std::to_string(steering_angle_ * 180.0 / M_PI));
+    QString::fromStdString(std::to_string(steering_angle * 180.0 / M_PI));
   steering_angle_ptr_->setText(steering_string);
 }
 
@@ -186,6 +255,9 @@ void ManualController::onInitialize()
     raw_node_->create_publisher<Control>("/external/selected/control_cmd", rclcpp::QoS(1));
 
   pub_gear_cmd_ = raw_node_->create_publisher<GearCommand>("/external/selected/gear_cmd", 1);
+
+  is_command_thread_running_ = true;
+  command_thread_ = std::thread(&ManualController::runCommandLoop, this);
 }
 
 void ManualController::onGateMode(const tier4_control_msgs::msg::GateMode::ConstSharedPtr msg)
@@ -35,7 +35,10 @@
 #include <tier4_control_msgs/msg/gate_mode.hpp>
 #include <tier4_external_api_msgs/srv/engage.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
 
 namespace rviz_plugins
 {
@@ -55,6 +58,7 @@ class ManualController : public rviz_common::Panel
 
 public:
   explicit ManualController(QWidget * parent = nullptr);
+  ~ManualController() override;
   void onInitialize() override;
 
 public Q_SLOTS:  // NOLINT for Qt
@@ -64,10 +68,12 @@ public Q_SLOTS:  // NOLINT for Qt
   void update();
 
 protected:
-  // Timer
-  rclcpp::TimerBase::SharedPtr timer_;
-  void onTimer();
-  void onPublishControlCommand();
+  // the commands are published by a thread of a steady period, not to jitter with the rendering
+  static constexpr std::chrono::milliseconds command_period_{30};
+  std::thread command_thread_;
+  std::atomic<bool> is_command_thread_running_{false};
+  void runCommandLoop();
+  void publishCommand();
   void onGateMode(const GateMode::ConstSharedPtr msg);
   void onEngageStatus(const Engage::ConstSharedPtr msg);
   void onGear(const GearReport::ConstSharedPtr msg);
@@ -83,8 +89,13 @@ protected:
   rclcpp::Client<EngageSrv>::SharedPtr client_engage_;
   rclcpp::Subscription<GearReport>::SharedPtr sub_gear_;
 
-  double cruise_velocity_{0.0};
-  double steering_angle_{0.0};
+  // targets set by the panel and read by the command thread
+  std::atomic<double> cruise_velocity_{0.0};
+  std::atomic<double> steering_angle_{0.0};
+
+  // periods of the commands in the last second, set by the command thread and shown by the panel
+  std::atomic<double> command_period_mean_{0.0};
+  std::atomic<double> command_period_max_{0.0};
 
   QLabel * gate_mode_label_ptr_;
   QLabel * gear_label_ptr_;
@@ -94,6 +105,7 @@ protected:
   QSpinBox * cruise_velocity_input_;
   QDial * steering_slider_ptr_;
   QLabel * steering_angle_ptr_;
+  QLabel * command_period_label_ptr_;
 
   bool current_engage_{false};
 };
@@ -116,6 +116,8 @@ public:
   virtual void hide();
   virtual void show();
   virtual bool isTextureReady();
+  // the texture is only reallocated when it grows beyond its capacity, otherwise the panel shows
+  // the top-left part of it with the given size
   virtual void updateTextureSize(unsigned int width, unsigned int height);
   virtual ScopedPixelBuffer getBuffer();
   virtual void setPosition(double left, double top);
@@ -131,6 +133,9 @@ protected:
   Ogre::PanelOverlayElement * panel_;
   Ogre::MaterialPtr panel_material_;
   Ogre::TexturePtr texture_;
+  // size of the used part of the texture
+  unsigned int width_{0};
+  unsigned int height_{0};
 
 private:
 };
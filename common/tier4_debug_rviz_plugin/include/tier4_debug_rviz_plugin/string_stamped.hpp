@@ -50,6 +50,7 @@
 
 #include <memory>
 #include <mutex>
+#include <string>
 
 #ifndef Q_MOC_RUN
 #include "tier4_debug_rviz_plugin/jsk_overlay_utils.hpp"
@@ -59,6 +60,7 @@
 #include <rviz_common/properties/int_property.hpp>
 #include <rviz_common/ros_topic_display.hpp>
 
+#include <QStaticText>
 #endif
 
 #include <autoware_internal_debug_msgs/msg/string_stamped.hpp>
@@ -94,6 +96,7 @@ protected:
   rviz_common::properties::FloatProperty * property_value_scale_;
   rviz_common::properties::IntProperty * property_font_size_;
   rviz_common::properties::IntProperty * property_max_letter_num_;
+  rviz_common::properties::FloatProperty * property_max_update_rate_;
   // QImage hud_;
 
 private:
@@ -102,6 +105,15 @@ private:
 
   std::mutex mutex_;
   autoware_internal_debug_msgs::msg::StringStamped::ConstSharedPtr last_msg_ptr_;
+
+  // the overlay is only repainted when the text or the properties change, at most at the max
+  // update rate, with the latest message
+  bool update_required_{false};
+  // [s]
+  float time_since_repaint_{0.0f};
+  std::string text_;
+  // the layout of the text is kept while the text does not change
+  QStaticText static_text_;
 };
 }  // namespace rviz_plugins
 
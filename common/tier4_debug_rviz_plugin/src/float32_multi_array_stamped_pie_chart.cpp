@@ -49,6 +49,7 @@
 #include <rviz_common/display_context.hpp>
 #include <rviz_common/uniform_string_stream.hpp>
 #include <tier4_debug_rviz_plugin/float32_multi_array_stamped_pie_chart.hpp>
+#include <tier4_debug_rviz_plugin/pie_chart.hpp>
 
 #include <algorithm>
 #include <string>
@@ -169,13 +170,21 @@ void Float32MultiArrayStampedPieChartDisplay::onInitialize()
 void Float32MultiArrayStampedPieChartDisplay::update(
   [[maybe_unused]] float wall_dt, [[maybe_unused]] float ros_dt)
 {
-  if (update_required_) {
+  // the value is set by the subscription, and the overlay is only repainted when it changes
+  float data = 0.0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!update_required_) {
+      return;
+    }
     update_required_ = false;
-    overlay_->updateTextureSize(texture_size_, texture_size_ + caption_offset_);
-    overlay_->setPosition(left_, top_);
-    overlay_->setDimensions(overlay_->getTextureWidth(), overlay_->getTextureHeight());
-    drawPlot(data_);
+    data = data_;
   }
+
+  overlay_->updateTextureSize(texture_size_, texture_size_ + caption_offset_);
+  overlay_->setPosition(left_, top_);
+  overlay_->setDimensions(overlay_->getTextureWidth(), overlay_->getTextureHeight());
+  drawPlot(data);
 }
 
 void Float32MultiArrayStampedPieChartDisplay::processMessage(
@@ -199,36 +208,23 @@ void Float32MultiArrayStampedPieChartDisplay::processMessage(
 
 void Float32MultiArrayStampedPieChartDisplay::drawPlot(double val)
 {
-  QColor fg_color(fg_color_);
-
-  if (auto_color_change_) {
-    double r = std::min(1.0, fabs((val - min_value_) / (max_value_ - min_value_)));
-    if (r > 0.6) {
-      double r2 = (r - 0.6) / 0.4;
-      fg_color.setRed((max_color_.red() - fg_color_.red()) * r2 + fg_color_.red());
-      fg_color.setGreen((max_color_.green() - fg_color_.green()) * r2 + fg_color_.green());
-      fg_color.setBlue((max_color_.blue() - fg_color_.blue()) * r2 + fg_color_.blue());
-    }
-    if (max_color_threshold_ != 0) {
-      if (r > max_color_threshold_) {
-        fg_color.setRed(max_color_.red());
-        fg_color.setGreen(max_color_.green());
-        fg_color.setBlue(max_color_.blue());
-      }
-    }
-    if (med_color_threshold_ != 0) {
-      if (max_color_threshold_ > r && r > med_color_threshold_) {
-        fg_color.setRed(med_color_.red());
-        fg_color.setGreen(med_color_.green());
-        fg_color.setBlue(med_color_.blue());
-      }
-    }
-  }
+  PieChartStyle style;
+  style.fg_color = fg_color_;
+  style.max_color = max_color_;
+  style.med_color = med_color_;
+  style.fg_alpha = fg_alpha_;
+  style.fg_alpha2 = fg_alpha2_;
+  style.max_value = max_value_;
+  style.min_value = min_value_;
+  style.max_color_threshold = max_color_threshold_;
+  style.med_color_threshold = med_color_threshold_;
+  style.auto_color_change = auto_color_change_;
+  style.clockwise_rotate = clockwise_rotate_;
+  style.text_size = text_size_;
+  style.show_caption = show_caption_;
+  style.caption_offset = caption_offset_;
 
-  QColor fg_color2(fg_color);
   QColor bg_color(bg_color_);
-  fg_color.setAlpha(fg_alpha_);
-  fg_color2.setAlpha(fg_alpha2_);
   bg_color.setAlpha(bg_alpha_);
   int width = overlay_->getTextureWidth();
   int height = overlay_->getTextureHeight();
@@ -237,51 +233,7 @@ void Float32MultiArrayStampedPieChartDisplay::drawPlot(double val)
     QImage Hud = buffer.getQImage(*overlay_, bg_color);
     QPainter painter(&Hud);
     painter.setRenderHint(QPainter::Antialiasing, true);
-
-    const int outer_line_width = 5;
-    const int value_line_width = 10;
-    const int value_indicator_line_width = 2;
-    const int value_padding = 5;
-
-    const int value_offset = outer_line_width + value_padding + value_line_width / 2;
-
-    painter.setPen(QPen(fg_color, outer_line_width, Qt::SolidLine));
-
-    painter.drawEllipse(
-      outer_line_width / 2, outer_line_width / 2, width - outer_line_width,
-      height - outer_line_width - caption_offset_);
-
-    painter.setPen(QPen(fg_color2, value_indicator_line_width, Qt::SolidLine));
-    painter.drawEllipse(
-      value_offset, value_offset, width - value_offset * 2,
-      height - value_offset * 2 - caption_offset_);
-
-    const double ratio = (val - min_value_) / (max_value_ - min_value_);
-    const double rotate_direction = clockwise_rotate_ ? -1.0 : 1.0;
-    const double ratio_angle = ratio * 360.0 * rotate_direction;
-    const double start_angle_offset = -90;
-    painter.setPen(QPen(fg_color, value_line_width, Qt::SolidLine));
-    painter.drawArc(
-      QRectF(
-        value_offset, value_offset, width - value_offset * 2,
-        height - value_offset * 2 - caption_offset_),
-      start_angle_offset * 16, ratio_angle * 16);
-    QFont font = painter.font();
-    font.setPointSize(text_size_);
-    font.setBold(true);
-    painter.setFont(font);
-    painter.setPen(QPen(fg_color, value_line_width, Qt::SolidLine));
-    std::ostringstream s;
-    s << std::fixed << std::setprecision(2) << val;
-    painter.drawText(
-      0, 0, width, height - caption_offset_, Qt::AlignCenter | Qt::AlignVCenter, s.str().c_str());
-
-    // caption
-    if (show_caption_) {
-      painter.drawText(
-        0, height - caption_offset_, width, caption_offset_, Qt::AlignCenter | Qt::AlignVCenter,
-        getName());
-    }
+    drawPieChart(painter, QRect(0, 0, width, height), val, getName(), style);
 
     // done
     painter.end();
@@ -0,0 +1,360 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Copyright (c) 2014, JSK Lab
+// All rights reserved.
+//
+// Software License Agreement (BSD License)
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of {copyright_holder} nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.S SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+
+#include <QFontMetrics>
+#include <QPainter>
+#include <rviz_common/display_context.hpp>
+#include <rviz_common/uniform_string_stream.hpp>
+#include <tier4_debug_rviz_plugin/float32_multi_array_stamped_pie_chart_grid.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace rviz_plugins
+{
+namespace
+{
+std::vector<std::string> splitByComma(const std::string & text)
+{
+  std::vector<std::string> tokens;
+  std::stringstream ss(text);
+  std::string token;
+  while (std::getline(ss, token, ',')) {
+    token.erase(0, token.find_first_not_of(' '));
+    token.erase(token.find_last_not_of(' ') + 1);
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+}  // namespace
+
+Float32MultiArrayStampedPieChartGridDisplay::Float32MultiArrayStampedPieChartGridDisplay()
+: rviz_common::Display()
+{
+  update_topic_property_ = new rviz_common::properties::StringProperty(
+    "Topic", "",
+    "autoware_internal_debug_msgs::msg::Float32MultiArrayStamped topic to subscribe to.", this,
+    SLOT(updateTopic()), this);
+  data_indices_property_ = new rviz_common::properties::StringProperty(
+    "data indices", "0", "comma separated data indices in message to visualize", this,
+    SLOT(updateDataIndices()));
+  captions_property_ = new rviz_common::properties::StringProperty(
+    "captions", "", "comma separated captions of the data indices, the index by default", this,
+    SLOT(updateCaptions()));
+  columns_property_ = new rviz_common::properties::IntProperty(
+    "columns", 4, "number of pie charts in a row", this, SLOT(updateLayout()));
+  columns_property_->setMin(1);
+  size_property_ = new rviz_common::properties::IntProperty(
+    "size", 128, "size of each pie chart", this, SLOT(updateLayout()));
+  size_property_->setMin(1);
+  left_property_ = new rviz_common::properties::IntProperty(
+    "left", 128, "left of the plotter window", this, SLOT(updateLayout()));
+  top_property_ = new rviz_common::properties::IntProperty(
+    "top", 128, "top of the plotter window", this, SLOT(updateLayout()));
+  max_rate_property_ = new rviz_common::properties::FloatProperty(
+    "max refresh rate", 10.0, "max rate to repaint the pie charts [Hz]", this,
+    SLOT(updateLayout()));
+  max_rate_property_->setMin(0.1);
+  fg_color_property_ = new rviz_common::properties::ColorProperty(
+    "foreground color", QColor(25, 255, 240), "color to draw line", this, SLOT(updateLayout()));
+  fg_alpha_property_ = new rviz_common::properties::FloatProperty(
+    "foreground alpha", 0.7, "alpha blending value for foreground", this, SLOT(updateLayout()));
+  fg_alpha2_property_ = new rviz_common::properties::FloatProperty(
+    "foreground alpha 2", 0.4, "alpha blending value for foreground for indicator", this,
+    SLOT(updateLayout()));
+  bg_color_property_ = new rviz_common::properties::ColorProperty(
+    "background color", QColor(0, 0, 0), "background color", this, SLOT(updateLayout()));
+  bg_alpha_property_ = new rviz_common::properties::FloatProperty(
+    "background alpha", 0.0, "alpha blending value for background", this, SLOT(updateLayout()));
+  text_size_property_ = new rviz_common::properties::IntProperty(
+    "text size", 14, "text size", this, SLOT(updateLayout()));
+  show_caption_property_ = new rviz_common::properties::BoolProperty(
+    "show caption", true, "show caption", this, SLOT(updateLayout()));
+  max_value_property_ = new rviz_common::properties::FloatProperty(
+    "max value", 1.0, "max value of pie chart", this, SLOT(updateLayout()));
+  min_value_property_ = new rviz_common::properties::FloatProperty(
+    "min value", 0.0, "min value of pie chart", this, SLOT(updateLayout()));
+  auto_color_change_property_ = new rviz_common::properties::BoolProperty(
+    "auto color change", false, "change the color automatically", this,
+    SLOT(updateAutoColorChange()));
+  max_color_property_ = new rviz_common::properties::ColorProperty(
+    "max color", QColor(255, 0, 0), "only used if auto color change is set to True.", this,
+    SLOT(updateLayout()));
+  med_color_property_ = new rviz_common::properties::ColorProperty(
+    "med color", QColor(255, 0, 0), "only used if auto color change is set to True.", this,
+    SLOT(updateLayout()));
+  max_color_threshold_property_ = new rviz_common::properties::FloatProperty(
+    "max color change threshold", 0, "change the max color at threshold", this,
+    SLOT(updateLayout()));
+  med_color_threshold_property_ = new rviz_common::properties::FloatProperty(
+    "med color change threshold", 0, "change the med color at threshold ", this,
+    SLOT(updateLayout()));
+  clockwise_rotate_property_ = new rviz_common::properties::BoolProperty(
+    "clockwise rotate direction", false, "change the rotate direction", this,
+    SLOT(updateLayout()));
+}
+
+Float32MultiArrayStampedPieChartGridDisplay::~Float32MultiArrayStampedPieChartGridDisplay()
+{
+  if (overlay_ && overlay_->isVisible()) {
+    overlay_->hide();
+  }
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::onInitialize()
+{
+  static int count = 0;
+  rviz_common::UniformStringStream ss;
+  ss << "Float32MultiArrayStampedPieChartGrid" << count++;
+  auto logger = context_->getRosNodeAbstraction().lock()->get_raw_node()->get_logger();
+  overlay_.reset(new jsk_rviz_plugins::OverlayObject(scene_manager_, logger, ss.str()));
+  updateDataIndices();
+  updateAutoColorChange();
+  onEnable();
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::update(
+  float wall_dt, [[maybe_unused]] float ros_dt)
+{
+  elapsed_time_ += wall_dt;
+  if (elapsed_time_ < 1.0 / max_rate_property_->getFloat()) {
+    return;
+  }
+
+  std::vector<float> values;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!update_required_) {
+      return;
+    }
+    update_required_ = false;
+    values = values_;
+  }
+  elapsed_time_ = 0.0;
+
+  drawPlots(values);
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::processMessage(
+  const autoware_internal_debug_msgs::msg::Float32MultiArrayStamped::ConstSharedPtr msg)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  bool changed = false;
+  for (size_t i = 0; i < data_indices_.size(); ++i) {
+    const int index = data_indices_.at(i);
+    const float value = 0 <= index && index < static_cast<int>(msg->data.size())
+                          ? msg->data.at(index)
+                          : std::numeric_limits<float>::quiet_NaN();
+    // NaN is not equal to itself, so compare the bits of the missing values too
+    if (value != values_.at(i) && !(std::isnan(value) && std::isnan(values_.at(i)))) {
+      values_.at(i) = value;
+      changed = true;
+    }
+  }
+  update_required_ = update_required_ || changed;
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::drawPlots(const std::vector<float> & values)
+{
+  PieChartStyle style;
+  style.fg_color = fg_color_property_->getColor();
+  style.max_color = max_color_property_->getColor();
+  style.med_color = med_color_property_->getColor();
+  style.fg_alpha = fg_alpha_property_->getFloat() * 255.0;
+  style.fg_alpha2 = fg_alpha2_property_->getFloat() * 255.0;
+  style.max_value = max_value_property_->getFloat();
+  style.min_value = min_value_property_->getFloat();
+  style.max_color_threshold = max_color_threshold_property_->getFloat();
+  style.med_color_threshold = med_color_threshold_property_->getFloat();
+  style.auto_color_change = auto_color_change_property_->getBool();
+  style.clockwise_rotate = clockwise_rotate_property_->getBool();
+  style.text_size = text_size_property_->getInt();
+  style.show_caption = show_caption_property_->getBool();
+  {
+    QFont font;
+    font.setPointSize(style.text_size);
+    style.caption_offset = style.show_caption ? QFontMetrics(font).height() : 0;
+  }
+
+  const int size = size_property_->getInt();
+  const int columns = columns_property_->getInt();
+  const int chart_num = std::max(static_cast<int>(values.size()), 1);
+  const int rows = (chart_num + columns - 1) / columns;
+  const int cell_height = size + style.caption_offset;
+  overlay_->updateTextureSize(std::min(chart_num, columns) * size, rows * cell_height);
+  overlay_->setPosition(left_property_->getInt(), top_property_->getInt());
+  overlay_->setDimensions(overlay_->getTextureWidth(), overlay_->getTextureHeight());
+
+  QColor bg_color(bg_color_property_->getColor());
+  bg_color.setAlpha(bg_alpha_property_->getFloat() * 255.0);
+  {
+    jsk_rviz_plugins::ScopedPixelBuffer buffer = overlay_->getBuffer();
+    QImage Hud = buffer.getQImage(*overlay_, bg_color);
+    QPainter painter(&Hud);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    // all the pie charts in one texture, so that there is a single overlay to composite
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (std::isnan(values.at(i))) {
+        continue;
+      }
+      const int row = static_cast<int>(i) / columns;
+      const int column = static_cast<int>(i) % columns;
+      const QRect rect(column * size, row * cell_height, size, cell_height);
+      drawPieChart(painter, rect, values.at(i), captions_.at(i), style);
+    }
+
+    painter.end();
+  }
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::subscribe()
+{
+  std::string topic_name = update_topic_property_->getStdString();
+
+  // NOTE: Remove all spaces since topic name filled with only spaces will crash
+  topic_name.erase(std::remove(topic_name.begin(), topic_name.end(), ' '), topic_name.end());
+
+  if (topic_name.length() > 0 && topic_name != "/") {
+    rclcpp::Node::SharedPtr raw_node = context_->getRosNodeAbstraction().lock()->get_raw_node();
+    sub_ =
+      raw_node->create_subscription<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>(
+        topic_name, 1,
+        std::bind(
+          &Float32MultiArrayStampedPieChartGridDisplay::processMessage, this,
+          std::placeholders::_1));
+  }
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::unsubscribe()
+{
+  sub_.reset();
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::onEnable()
+{
+  subscribe();
+  overlay_->show();
+  updateLayout();
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::onDisable()
+{
+  unsubscribe();
+  overlay_->hide();
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::updateTopic()
+{
+  unsubscribe();
+  subscribe();
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::updateDataIndices()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    data_indices_.clear();
+    for (const auto & token : splitByComma(data_indices_property_->getStdString())) {
+      try {
+        data_indices_.push_back(std::stoi(token));
+      } catch (const std::exception &) {
+        // skip the invalid index
+      }
+    }
+    values_.assign(data_indices_.size(), std::numeric_limits<float>::quiet_NaN());
+  }
+  updateCaptions();
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::updateCaptions()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto captions = splitByComma(captions_property_->getStdString());
+  captions_.clear();
+  for (size_t i = 0; i < data_indices_.size(); ++i) {
+    captions_.push_back(
+      i < captions.size() && !captions.at(i).empty()
+        ? QString::fromStdString(captions.at(i))
+        : QString("data[%1]").arg(data_indices_.at(i)));
+  }
+  update_required_ = true;
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::updateLayout()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  update_required_ = true;
+  // repaint at the next frame
+  elapsed_time_ = std::numeric_limits<float>::max();
+}
+
+void Float32MultiArrayStampedPieChartGridDisplay::updateAutoColorChange()
+{
+  if (auto_color_change_property_->getBool()) {
+    max_color_property_->show();
+    med_color_property_->show();
+    max_color_threshold_property_->show();
+    med_color_threshold_property_->show();
+  } else {
+    max_color_property_->hide();
+    med_color_property_->hide();
+    max_color_threshold_property_->hide();
+    med_color_threshold_property_->hide();
+  }
+  updateLayout();
+}
+}  // namespace rviz_plugins
+
+#include <pluginlib/class_list_macros.hpp>
+PLUGINLIB_EXPORT_CLASS(
+  rviz_plugins::Float32MultiArrayStampedPieChartGridDisplay, rviz_common::Display)
@@ -47,6 +47,7 @@
 
 #include <tier4_debug_rviz_plugin/jsk_overlay_utils.hpp>
 
+#include <algorithm>
 #include <string>
 
 namespace jsk_rviz_plugins
@@ -71,18 +72,18 @@ QImage ScopedPixelBuffer::getQImage(unsigned int width, unsigned int height)
 {
   const Ogre::PixelBox & pixelBox = pixel_buffer_->getCurrentLock();
   Ogre::uint8 * pDest = static_cast<Ogre::uint8 *>(pixelBox.data);
-  memset(pDest, 0, width * height);
-  return QImage(pDest, width, height, QImage::Format_ARGB32);
+  // the texture can be wider than the image when it is reused with a smaller size
+  const auto bytes_per_line =
+    static_cast<int>(pixelBox.rowPitch * Ogre::PixelUtil::getNumElemBytes(pixelBox.format));
+  QImage Hud(pDest, width, height, bytes_per_line, QImage::Format_ARGB32);
+  Hud.fill(Qt::transparent);
+  return Hud;
 }
 
 QImage ScopedPixelBuffer::getQImage(unsigned int width, unsigned int height, QColor & bg_color)
 {
   QImage Hud = getQImage(width, height);
-  for (unsigned int i = 0; i < width; i++) {
-    for (unsigned int j = 0; j < height; j++) {
-      Hud.setPixel(i, j, bg_color.rgba());
-    }
-  }
+  Hud.fill(bg_color);
   return Hud;
 }
 
@@ -160,24 +161,34 @@ void OverlayObject::updateTextureSize(unsigned int width, unsigned int height)
     RCLCPP_WARN(logger_, "height=0 is specified as texture size");
     height = 1;
   }
-  if (!isTextureReady() || ((width != texture_->getWidth()) || (height != texture_->getHeight()))) {
+  if (!isTextureReady() || ((width > texture_->getWidth()) || (height > texture_->getHeight()))) {
+    unsigned int capacity_width = width;
+    unsigned int capacity_height = height;
     if (isTextureReady()) {
+      capacity_width = std::max(width, static_cast<unsigned int>(texture_->getWidth()));
+      capacity_height = std::max(height, static_cast<unsigned int>(texture_->getHeight()));
       Ogre::TextureManager::getSingleton().remove(texture_name);
       panel_material_->getTechnique(0)->getPass(0)->removeAllTextureUnitStates();
     }
     texture_ = Ogre::TextureManager::getSingleton().createManual(
       texture_name,  // name
       Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
-      Ogre::TEX_TYPE_2D,  // type
-      width, height,      // width & height of the render window
-      0,                  // number of mipmaps
-      Ogre::PF_A8R8G8B8,  // pixel format chosen to match a format Qt can use
-      Ogre::TU_DEFAULT    // usage
+      Ogre::TEX_TYPE_2D,                // type
+      capacity_width, capacity_height,  // width & height of the render window
+      0,                                // number of mipmaps
+      Ogre::PF_A8R8G8B8,                // pixel format chosen to match a format Qt can use
+      Ogre::TU_DEFAULT                  // usage
     );
     panel_material_->getTechnique(0)->getPass(0)->createTextureUnitState(texture_name);
 
     panel_material_->getTechnique(0)->getPass(0)->setSceneBlending(Ogre::SBT_TRANSPARENT_ALPHA);
   }
+
+  width_ = width;
+  height_ = height;
+  panel_->setUV(
+    0.0, 0.0, static_cast<Ogre::Real>(width_) / texture_->getWidth(),
+    static_cast<Ogre::Real>(height_) / texture_->getHeight());
 }
 
 ScopedPixelBuffer OverlayObject::getBuffer()
@@ -207,7 +218,7 @@ bool OverlayObject::isVisible()
 unsigned int OverlayObject::getTextureWidth()
 {
   if (isTextureReady()) {
-    return texture_->getWidth();
+    return width_;
   } else {
     return 0;
   }
@@ -216,7 +227,7 @@ unsigned int OverlayObject::getTextureWidth()
 unsigned int OverlayObject::getTextureHeight()
 {
   if (isTextureReady()) {
-    return texture_->getHeight();
+    return height_;
   } else {
     return 0;
   }
@@ -0,0 +1,338 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Renders the overlays of the string and pie chart displays from a bag to PNG frames, without
+// rviz nor a display:
+//   overlay_bag_renderer <bag> <output_dir> [--fps 10] [--jobs N] [--width 1280] [--height 720]
+//                        [--string <topic>]... [--pie <topic>:<index>]...
+
+#include "tier4_debug_rviz_plugin/pie_chart.hpp"
+#include "tier4_debug_rviz_plugin/string_overlay.hpp"
+
+#include <QFontMetrics>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+#include <QStaticText>
+#include <rclcpp/serialization.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+
+#include <autoware_internal_debug_msgs/msg/float32_multi_array_stamped.hpp>
+#include <autoware_internal_debug_msgs/msg/string_stamped.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using autoware_internal_debug_msgs::msg::Float32MultiArrayStamped;
+using autoware_internal_debug_msgs::msg::StringStamped;
+
+struct Options
+{
+  std::string bag_uri;
+  std::string output_dir;
+  double fps{10.0};
+  size_t jobs{std::max(std::thread::hardware_concurrency(), 1u)};
+  int width{1280};
+  int height{720};
+  std::vector<std::string> string_topics;
+  std::vector<std::pair<std::string, int>> pie_topics;
+};
+
+// values of a topic in the order of their recorded time [ns]
+template <typename T>
+struct Track
+{
+  std::vector<int64_t> times;
+  std::vector<T> values;
+
+  // the latest value at the time, if any
+  const T * at(const int64_t time) const
+  {
+    const auto itr = std::upper_bound(times.begin(), times.end(), time);
+    return itr == times.begin() ? nullptr : &values.at(itr - times.begin() - 1);
+  }
+};
+
+void printUsage()
+{
+  std::fprintf(
+    stderr,
+    "usage: overlay_bag_renderer <bag> <output_dir> [--fps 10] [--jobs N] [--width 1280] "
+    "[--height 720] [--string <topic>]... [--pie <topic>:<index>]...\n");
+}
+
+bool parseOptions(const int argc, char ** argv, Options & options)
+{
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--fps" && has_value) {
+      options.fps = std::stod(argv[++i]);
+    } else if (arg == "--jobs" && has_value) {
+      options.jobs = std::max(std::stoul(argv[++i]), 1ul);
+    } else if (arg == "--width" && has_value) {
+      options.width = std::stoi(argv[++i]);
+    } else if (arg == "--height" && has_value) {
+      options.height = std::stoi(argv[++i]);
+    } else if (arg == "--string" && has_value) {
+      options.string_topics.push_back(argv[++i]);
+    } else if (arg == "--pie" && has_value) {
+      const std::string spec = argv[++i];
+      const auto colon = spec.rfind(':');
+      if (colon == std::string::npos) {
+        return false;
+      }
+      options.pie_topics.emplace_back(spec.substr(0, colon), std::stoi(spec.substr(colon + 1)));
+    } else if (arg.rfind("--", 0) == 0) {
+      return false;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+  if (positional.size() != 2 || options.fps <= 0.0 || options.width <= 0 || options.height <= 0) {
+    return false;
+  }
+  if (options.string_topics.empty() && options.pie_topics.empty()) {
+    return false;
+  }
+  options.bag_uri = positional.at(0);
+  options.output_dir = positional.at(1);
+  return true;
+}
+
+// the same style as the default properties of the displays
+rviz_plugins::PieChartStyle getPieChartStyle()
+{
+  rviz_plugins::PieChartStyle style;
+  style.fg_color = QColor(25, 255, 240);
+  style.max_color = QColor(255, 0, 0);
+  style.med_color = QColor(255, 0, 0);
+  style.fg_alpha = 0.7 * 255.0;
+  style.fg_alpha2 = 0.4 * 255.0;
+  style.max_value = 1.0;
+  style.min_value = 0.0;
+  style.max_color_threshold = 0.0;
+  style.med_color_threshold = 0.0;
+  style.auto_color_change = false;
+  style.clockwise_rotate = false;
+  style.text_size = 14;
+  style.show_caption = true;
+  QFont font;
+  font.setPointSize(style.text_size);
+  style.caption_offset = QFontMetrics(font).height();
+  return style;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  Options options;
+  try {
+    if (!parseOptions(argc, argv, options)) {
+      printUsage();
+      return 1;
+    }
+  } catch (const std::exception &) {
+    printUsage();
+    return 1;
+  }
+
+  // the fonts need a gui application, which does not need a display with the offscreen platform
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  QGuiApplication app(argc, argv);
+
+  // ---------------------------------------------------- //
+  // Read the values of the topics, sequentially from the bag
+  // ---------------------------------------------------- //
+  std::vector<Track<QString>> string_tracks(options.string_topics.size());
+  std::vector<Track<float>> pie_tracks(options.pie_topics.size());
+  {
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = options.bag_uri;
+    rosbag2_cpp::ConverterOptions converter_options;
+    converter_options.input_serialization_format = "cdr";
+    converter_options.output_serialization_format = "cdr";
+    rosbag2_cpp::readers::SequentialReader reader;
+    reader.open(storage_options, converter_options);
+
+    rosbag2_storage::StorageFilter filter;
+    filter.topics = options.string_topics;
+    for (const auto & [topic, index] : options.pie_topics) {
+      filter.topics.push_back(topic);
+    }
+    reader.set_filter(filter);
+
+    rclcpp::Serialization<StringStamped> serialization_string;
+    rclcpp::Serialization<Float32MultiArrayStamped> serialization_array;
+    while (reader.has_next()) {
+      const auto serialized_message = reader.read_next();
+      const rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+      const int64_t time = serialized_message->time_stamp;
+
+      // a message is deserialized once, even if it is drawn by several overlays
+      std::optional<Float32MultiArrayStamped> array;
+      for (size_t i = 0; i < options.pie_topics.size(); ++i) {
+        if (options.pie_topics.at(i).first != serialized_message->topic_name) {
+          continue;
+        }
+        if (!array) {
+          array.emplace();
+          serialization_array.deserialize_message(&msg, &*array);
+        }
+        const int index = options.pie_topics.at(i).second;
+        pie_tracks.at(i).times.push_back(time);
+        pie_tracks.at(i).values.push_back(
+          0 <= index && index < static_cast<int>(array->data.size())
+            ? array->data.at(index)
+            : std::numeric_limits<float>::quiet_NaN());
+      }
+      std::optional<QString> string;
+      for (size_t i = 0; i < options.string_topics.size(); ++i) {
+        if (options.string_topics.at(i) != serialized_message->topic_name) {
+          continue;
+        }
+        if (!string) {
+          StringStamped string_msg;
+          serialization_string.deserialize_message(&msg, &string_msg);
+          string = QString::fromStdString(string_msg.data);
+        }
+        string_tracks.at(i).times.push_back(time);
+        string_tracks.at(i).values.push_back(*string);
+      }
+    }
+  }
+
+  int64_t begin_time = std::numeric_limits<int64_t>::max();
+  int64_t end_time = std::numeric_limits<int64_t>::lowest();
+  const auto update_range = [&](const std::vector<int64_t> & times) {
+    if (!times.empty()) {
+      begin_time = std::min(begin_time, times.front());
+      end_time = std::max(end_time, times.back());
+    }
+  };
+  for (const auto & track : string_tracks) {
+    update_range(track.times);
+  }
+  for (const auto & track : pie_tracks) {
+    update_range(track.times);
+  }
+  if (begin_time > end_time) {
+    std::fprintf(stderr, "no message of the topics in %s\n", options.bag_uri.c_str());
+    return 1;
+  }
+
+  // ------------------------------------------------ //
+  // Render the frames in parallel, each to a PNG file
+  // ------------------------------------------------ //
+  std::filesystem::create_directories(options.output_dir);
+  const double period = 1e9 / options.fps;
+  const size_t frame_num = static_cast<size_t>((end_time - begin_time) / period) + 1;
+
+  // the pie charts in a row on the top, and the strings stacked in the rest of the frame
+  const rviz_plugins::PieChartStyle pie_style = getPieChartStyle();
+  const int pie_size = 128;
+  const int pie_columns = std::max(options.width / pie_size, 1);
+  const int pie_rows = (static_cast<int>(pie_tracks.size()) + pie_columns - 1) / pie_columns;
+  const int strings_top = pie_rows * (pie_size + pie_style.caption_offset);
+  const int string_height =
+    string_tracks.empty()
+      ? 0
+      : std::max(options.height - strings_top, 1) / static_cast<int>(string_tracks.size());
+  rviz_plugins::StringOverlayStyle string_style;
+  string_style.text_color = QColor(25, 255, 240);
+  string_style.font_size = 15;
+  string_style.value_height_offset = 0;
+
+  std::atomic<size_t> next_frame{0};
+  std::atomic<size_t> failed_frame_num{0};
+  const auto render = [&]() {
+    // the layouts of the texts are kept while they do not change, as the display does
+    std::vector<QStaticText> static_texts(string_tracks.size());
+    for (auto & static_text : static_texts) {
+      static_text.setTextFormat(Qt::PlainText);
+      static_text.setPerformanceHint(QStaticText::AggressiveCaching);
+    }
+
+    QImage image(options.width, options.height, QImage::Format_ARGB32);
+    for (size_t frame = next_frame++; frame < frame_num; frame = next_frame++) {
+      const int64_t time = begin_time + static_cast<int64_t>(std::round(frame * period));
+      image.fill(Qt::transparent);
+      QPainter painter(&image);
+      painter.setRenderHint(QPainter::Antialiasing, true);
+
+      for (size_t i = 0; i < pie_tracks.size(); ++i) {
+        const float * value = pie_tracks.at(i).at(time);
+        if (!value || std::isnan(*value)) {
+          continue;
+        }
+        const int row = static_cast<int>(i) / pie_columns;
+        const int column = static_cast<int>(i) % pie_columns;
+        const QRect rect(
+          column * pie_size, row * (pie_size + pie_style.caption_offset), pie_size,
+          pie_size + pie_style.caption_offset);
+        const auto & [topic, index] = options.pie_topics.at(i);
+        rviz_plugins::drawPieChart(
+          painter, rect, *value, QString("%1[%2]").arg(QString::fromStdString(topic)).arg(index),
+          pie_style);
+      }
+
+      for (size_t i = 0; i < string_tracks.size(); ++i) {
+        const QString * text = string_tracks.at(i).at(time);
+        if (!text) {
+          continue;
+        }
+        if (static_texts.at(i).text() != *text) {
+          static_texts.at(i).setText(*text);
+        }
+        const QRect rect(
+          0, strings_top + static_cast<int>(i) * string_height, options.width, string_height);
+        rviz_plugins::drawStringOverlay(painter, rect, static_texts.at(i), string_style);
+      }
+      painter.end();
+
+      char file_name[32];
+      std::snprintf(file_name, sizeof(file_name), "frame_%06zu.png", frame);
+      if (!image.save(QString::fromStdString(options.output_dir + "/" + file_name))) {
+        failed_frame_num++;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < std::min(options.jobs, frame_num); ++i) {
+    workers.emplace_back(render);
+  }
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  std::printf(
+    "rendered %zu frames at %.1f[fps] to %s\n", frame_num - failed_frame_num.load(), options.fps,
+    options.output_dir.c_str());
+  return failed_frame_num.load() == 0 ? 0 : 1;
+}
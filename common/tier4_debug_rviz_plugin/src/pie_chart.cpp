@@ -0,0 +1,144 @@
+// Copyright 2022 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Copyright (c) 2014, JSK Lab
+// All rights reserved.
+//
+// Software License Agreement (BSD License)
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of {copyright_holder} nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.S SOFTWARE, EVEN IF ADVISED OF THE
+//  POSSIBILITY OF SUCH DAMAGE.
+
+#include "tier4_debug_rviz_plugin/pie_chart.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace rviz_plugins
+{
+void drawPieChart(
+  QPainter & painter, const QRect & rect, const double value, const QString & caption,
+  const PieChartStyle & style)
+{
+  QColor fg_color(style.fg_color);
+
+  if (style.auto_color_change) {
+    const QColor & base_color = style.fg_color;
+    const QColor & max_color = style.max_color;
+    const QColor & med_color = style.med_color;
+    double r = std::min(1.0, fabs((value - style.min_value) / (style.max_value - style.min_value)));
+    if (r > 0.6) {
+      double r2 = (r - 0.6) / 0.4;
+      fg_color.setRed((max_color.red() - base_color.red()) * r2 + base_color.red());
+      fg_color.setGreen((max_color.green() - base_color.green()) * r2 + base_color.green());
+      fg_color.setBlue((max_color.blue() - base_color.blue()) * r2 + base_color.blue());
+    }
+    if (style.max_color_threshold != 0) {
+      if (r > style.max_color_threshold) {
+        fg_color.setRed(max_color.red());
+        fg_color.setGreen(max_color.green());
+        fg_color.setBlue(max_color.blue());
+      }
+    }
+    if (style.med_color_threshold != 0) {
+      if (style.max_color_threshold > r && r > style.med_color_threshold) {
+        fg_color.setRed(med_color.red());
+        fg_color.setGreen(med_color.green());
+        fg_color.setBlue(med_color.blue());
+      }
+    }
+  }
+
+  QColor fg_color2(fg_color);
+  fg_color.setAlpha(style.fg_alpha);
+  fg_color2.setAlpha(style.fg_alpha2);
+  const int left = rect.x();
+  const int top = rect.y();
+  const int width = rect.width();
+  const int height = rect.height();
+
+  const int outer_line_width = 5;
+  const int value_line_width = 10;
+  const int value_indicator_line_width = 2;
+  const int value_padding = 5;
+
+  const int value_offset = outer_line_width + value_padding + value_line_width / 2;
+
+  painter.setPen(QPen(fg_color, outer_line_width, Qt::SolidLine));
+
+  painter.drawEllipse(
+    left + outer_line_width / 2, top + outer_line_width / 2, width - outer_line_width,
+    height - outer_line_width - style.caption_offset);
+
+  painter.setPen(QPen(fg_color2, value_indicator_line_width, Qt::SolidLine));
+  painter.drawEllipse(
+    left + value_offset, top + value_offset, width - value_offset * 2,
+    height - value_offset * 2 - style.caption_offset);
+
+  const double ratio = (value - style.min_value) / (style.max_value - style.min_value);
+  const double rotate_direction = style.clockwise_rotate ? -1.0 : 1.0;
+  const double ratio_angle = ratio * 360.0 * rotate_direction;
+  const double start_angle_offset = -90;
+  painter.setPen(QPen(fg_color, value_line_width, Qt::SolidLine));
+  painter.drawArc(
+    QRectF(
+      left + value_offset, top + value_offset, width - value_offset * 2,
+      height - value_offset * 2 - style.caption_offset),
+    start_angle_offset * 16, ratio_angle * 16);
+  QFont font = painter.font();
+  font.setPointSize(style.text_size);
+  font.setBold(true);
+  painter.setFont(font);
+  painter.setPen(QPen(fg_color, value_line_width, Qt::SolidLine));
+  std::ostringstream s;
+  s << std::fixed << std::setprecision(2) << value;
+  painter.drawText(
+    left, top, width, height - style.caption_offset, Qt::AlignCenter | Qt::AlignVCenter,
+    s.str().c_str());
+
+  // caption
+  if (style.show_caption) {
+    painter.drawText(
+      left, top + height - style.caption_offset, width, style.caption_offset,
+      Qt::AlignCenter | Qt::AlignVCenter, caption);
+  }
+}
+}  // namespace rviz_plugins
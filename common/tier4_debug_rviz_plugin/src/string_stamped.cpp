@@ -48,6 +48,7 @@
 #include "tier4_debug_rviz_plugin/string_stamped.hpp"
 
 #include "tier4_debug_rviz_plugin/jsk_overlay_utils.hpp"
+#include "tier4_debug_rviz_plugin/string_overlay.hpp"
 
 #include <QPainter>
 #include <rviz_common/uniform_string_stream.hpp>
@@ -88,6 +89,12 @@ StringStampedOverlayDisplay::StringStampedOverlayDisplay()
   property_max_letter_num_ = new rviz_common::properties::IntProperty(
     "Max Letter Num", 100, "Max Letter Num", this, SLOT(updateVisualization()), this);
   property_max_letter_num_->setMin(10);
+  property_max_update_rate_ = new rviz_common::properties::FloatProperty(
+    "Max Update Rate", 10.0, "Max rate to repaint the text [Hz]", this);
+  property_max_update_rate_->setMin(0.1);
+
+  static_text_.setTextFormat(Qt::PlainText);
+  static_text_.setPerformanceHint(QStaticText::AggressiveCaching);
 }
 
 StringStampedOverlayDisplay::~StringStampedOverlayDisplay()
@@ -109,7 +116,8 @@ void StringStampedOverlayDisplay::onInitialize()
 
   overlay_->show();
 
-  const int texture_size = property_font_size_->getInt() * property_max_letter_num_->getInt();
+  const int texture_size =
+    getStringOverlaySize(property_font_size_->getInt(), property_max_letter_num_->getInt());
   overlay_->updateTextureSize(texture_size, texture_size);
   overlay_->setPosition(property_left_->getInt(), property_top_->getInt());
   overlay_->setDimensions(overlay_->getTextureWidth(), overlay_->getTextureHeight());
@@ -119,6 +127,8 @@ void StringStampedOverlayDisplay::onEnable()
 {
   subscribe();
   overlay_->show();
+  std::lock_guard<std::mutex> message_lock(mutex_);
+  update_required_ = true;
 }
 
 void StringStampedOverlayDisplay::onDisable()
@@ -130,20 +140,29 @@ void StringStampedOverlayDisplay::onDisable()
 
 void StringStampedOverlayDisplay::update(float wall_dt, float ros_dt)
 {
-  (void)wall_dt;
   (void)ros_dt;
 
+  time_since_repaint_ += wall_dt;
+
   std::lock_guard<std::mutex> message_lock(mutex_);
-  if (!last_msg_ptr_) {
+  if (!last_msg_ptr_ || !update_required_) {
     return;
   }
+  // the messages of a verbose topic are coalesced until the next repaint
+  if (time_since_repaint_ < 1.0f / property_max_update_rate_->getFloat()) {
+    return;
+  }
+  update_required_ = false;
+  time_since_repaint_ = 0.0f;
 
-  // Display
-  QColor background_color;
-  background_color.setAlpha(0);
+  if (last_msg_ptr_->data != text_) {
+    text_ = last_msg_ptr_->data;
+    static_text_.setText(QString::fromStdString(text_));
+  }
+
+  // Display, the image is cleared to transparent
   jsk_rviz_plugins::ScopedPixelBuffer buffer = overlay_->getBuffer();
   QImage hud = buffer.getQImage(*overlay_);
-  hud.fill(background_color);
 
   QPainter painter(&hud);
   painter.setRenderHint(QPainter::Antialiasing, true);
@@ -151,22 +170,12 @@ void StringStampedOverlayDisplay::update(float wall_dt, float ros_dt)
   const int w = overlay_->getTextureWidth() - line_width_;
   const int h = overlay_->getTextureHeight() - line_width_;
 
-  // text
-  QColor text_color(property_text_color_->getColor());
-  text_color.setAlpha(255);
-  painter.setPen(QPen(text_color, static_cast<int>(2), Qt::SolidLine));
-  QFont font = painter.font();
-  font.setPixelSize(property_font_size_->getInt());
-  font.setBold(true);
-  painter.setFont(font);
-
-  // same as above, but align on right side
-  painter.drawText(
-    0, std::min(property_value_height_offset_->getInt(), h - 1), w,
-    std::max(h - property_value_height_offset_->getInt(), 1), Qt::AlignLeft | Qt::AlignTop,
-    last_msg_ptr_->data.c_str());
+  StringOverlayStyle style;
+  style.text_color = property_text_color_->getColor();
+  style.font_size = property_font_size_->getInt();
+  style.value_height_offset = property_value_height_offset_->getInt();
+  drawStringOverlay(painter, QRect(0, 0, w, h), static_text_, style);
   painter.end();
-  updateVisualization();
 }
 
 void StringStampedOverlayDisplay::processMessage(
@@ -178,6 +187,9 @@ void StringStampedOverlayDisplay::processMessage(
 
   {
     std::lock_guard<std::mutex> message_lock(mutex_);
+    if (!last_msg_ptr_ || last_msg_ptr_->data != msg_ptr->data) {
+      update_required_ = true;
+    }
     last_msg_ptr_ = msg_ptr;
   }
 
@@ -186,7 +198,13 @@ void StringStampedOverlayDisplay::processMessage(
 
 void StringStampedOverlayDisplay::updateVisualization()
 {
-  const int texture_size = property_font_size_->getInt() * property_max_letter_num_->getInt();
+  {
+    std::lock_guard<std::mutex> message_lock(mutex_);
+    update_required_ = true;
+  }
+
+  const int texture_size =
+    getStringOverlaySize(property_font_size_->getInt(), property_max_letter_num_->getInt());
   overlay_->updateTextureSize(texture_size, texture_size);
   overlay_->setPosition(property_left_->getInt(), property_top_->getInt());
   overlay_->setDimensions(overlay_->getTextureWidth(), overlay_->getTextureHeight());
@@ -0,0 +1,75 @@
+// Copyright 2024 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TIER4_DEBUG_TOOLS__LATERAL_ERROR_HPP_
+#define TIER4_DEBUG_TOOLS__LATERAL_ERROR_HPP_
+
+#include <autoware_planning_msgs/msg/trajectory.hpp>
+#include <geometry_msgs/msg/pose.hpp>
+
+#include <cstddef>
+#include <optional>
+
+/**
+ * @brief lateral errors in the normal direction of the reference trajectory [m]
+ */
+struct LateralError
+{
+  double control;       //!< @brief from the closest trajectory point to the vehicle pose
+  double localization;  //!< @brief from the vehicle pose to the ground truth pose
+  double total;         //!< @brief control + localization
+};
+
+/**
+ * @brief calculator of the lateral errors against a reference trajectory, shared by the node and
+ * the offline evaluation of bags
+ */
+class LateralErrorCalculator
+{
+public:
+  LateralErrorCalculator(
+    const double yaw_threshold_to_search_closest, const size_t closest_search_window);
+
+  /**
+   * @brief set the reference trajectory, which resets the start of the closest search
+   */
+  void setTrajectory(const autoware_planning_msgs::msg::Trajectory::ConstSharedPtr & trajectory);
+  const autoware_planning_msgs::msg::Trajectory::ConstSharedPtr & getTrajectory() const
+  {
+    return trajectory_ptr_;
+  }
+
+  /**
+   * @brief search closest trajectory point around the previous one, or in the whole trajectory
+   */
+  std::optional<size_t> searchClosestIndex(const geometry_msgs::msg::Pose & pose);
+
+  /**
+   * @brief calculate the lateral errors, with a trajectory of two points at least
+   * @return lateral errors, or nullopt if the closest point is not found
+   */
+  std::optional<LateralError> calculate(
+    const geometry_msgs::msg::Pose & vehicle_pose,
+    const geometry_msgs::msg::Pose & ground_truth_pose);
+
+private:
+  double yaw_threshold_to_search_closest_;
+  size_t closest_search_window_;  //!< @brief points searched before and after the last closest
+
+  autoware_planning_msgs::msg::Trajectory::ConstSharedPtr trajectory_ptr_;
+  std::optional<size_t>
+    prev_closest_index_;  //!< @brief closest index in the current trajectory, to start the search
+};
+
+#endif  // TIER4_DEBUG_TOOLS__LATERAL_ERROR_HPP_
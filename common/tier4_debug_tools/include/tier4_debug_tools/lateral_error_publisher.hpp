@@ -15,33 +15,35 @@
 #ifndef TIER4_DEBUG_TOOLS__LATERAL_ERROR_PUBLISHER_HPP_
 #define TIER4_DEBUG_TOOLS__LATERAL_ERROR_PUBLISHER_HPP_
 
-#define EIGEN_MPL2_ONLY
+#include "tier4_debug_tools/lateral_error.hpp"
+#include "tier4_debug_tools/lateral_error_statistics.hpp"
 
-#include <Eigen/Core>
-#include <Eigen/Geometry>
-#include <autoware/motion_utils/trajectory/trajectory.hpp>
 #include <rclcpp/rclcpp.hpp>
 
+#include <autoware_internal_debug_msgs/msg/float32_multi_array_stamped.hpp>
 #include <autoware_internal_debug_msgs/msg/float32_stamped.hpp>
 #include <autoware_planning_msgs/msg/trajectory.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
 
+#include <array>
+#include <memory>
+#include <vector>
+
 class LateralErrorPublisher : public rclcpp::Node
 {
 public:
   explicit LateralErrorPublisher(const rclcpp::NodeOptions & node_options);
 
 private:
-  /* Parameters */
-  double yaw_threshold_to_search_closest_;
-
   /* States */
-  autoware_planning_msgs::msg::Trajectory::SharedPtr
-    current_trajectory_ptr_;  //!< @brief reference trajectory
+  std::unique_ptr<LateralErrorCalculator>
+    calculator_;  //!< @brief calculator with the reference trajectory
   geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr
     current_vehicle_pose_ptr_;  //!< @brief current EKF pose
   geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr
     current_ground_truth_pose_ptr_;  //!< @brief current GNSS pose
+  std::vector<LateralErrorStatistics>
+    statistics_;  //!< @brief statistics of control, localization and (control + localization)
 
   /* Publishers and Subscribers */
   rclcpp::Subscription<autoware_planning_msgs::msg::Trajectory>::SharedPtr
@@ -56,6 +58,10 @@ private:
     pub_localization_lateral_error_;  //!< @brief publisher for localization lateral error
   rclcpp::Publisher<autoware_internal_debug_msgs::msg::Float32Stamped>::SharedPtr
     pub_lateral_error_;  //!< @brief publisher for lateral error (control + localization)
+  std::array<
+    rclcpp::Publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>::SharedPtr, 3>
+    pub_statistics_;  //!< @brief publishers for statistics, in the order of statistics_
+  rclcpp::TimerBase::SharedPtr timer_statistics_;  //!< @brief timer for statistics
 
   /**
    * @brief set current_trajectory_ with received message
@@ -69,6 +75,10 @@ private:
    * @brief set current_ground_truth_pose_ and calculate lateral error
    */
   void onGroundTruthPose(const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg);
+  /**
+   * @brief publish statistics of lateral errors in the window
+   */
+  void onStatisticsTimer();
 };
 
 #endif  // TIER4_DEBUG_TOOLS__LATERAL_ERROR_PUBLISHER_HPP_
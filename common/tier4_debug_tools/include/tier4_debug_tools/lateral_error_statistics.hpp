@@ -0,0 +1,87 @@
+// Copyright 2024 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TIER4_DEBUG_TOOLS__LATERAL_ERROR_STATISTICS_HPP_
+#define TIER4_DEBUG_TOOLS__LATERAL_ERROR_STATISTICS_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief statistics of the lateral errors in a time window
+ */
+class LateralErrorStatistics
+{
+public:
+  /// values in the order of the published array
+  enum class TYPE { RMS = 0, MAX = 1, PERCENTILE = 2, SAMPLE_NUM = 3, SIZE };
+
+  LateralErrorStatistics(const double window, const double percentile)
+  : window_(window), percentile_(std::clamp(percentile, 0.0, 1.0))
+  {
+  }
+
+  /**
+   * @brief add the error at the time, and drop the errors out of the window before the time
+   */
+  void add(const double time, const double error)
+  {
+    while (!errors_.empty() && errors_.front().first < time - window_) {
+      errors_.pop_front();
+    }
+    errors_.emplace_back(time, error);
+  }
+
+  /**
+   * @brief get the RMS, the max of the absolute values, the percentile of the absolute values and
+   * the number of the errors in the window before the time
+   */
+  std::array<double, static_cast<int>(TYPE::SIZE)> calcValues(const double time)
+  {
+    abs_errors_.clear();
+    double sum_squared = 0.0;
+    for (const auto & [error_time, error] : errors_) {
+      if (time - window_ <= error_time) {
+        abs_errors_.push_back(std::abs(error));
+        sum_squared += error * error;
+      }
+    }
+    if (abs_errors_.empty()) {
+      return {0.0, 0.0, 0.0, 0.0};
+    }
+
+    const double num = static_cast<double>(abs_errors_.size());
+    const double max = *std::max_element(abs_errors_.begin(), abs_errors_.end());
+    // nearest rank
+    const size_t rank = static_cast<size_t>(std::ceil(percentile_ * num));
+    const auto nth = abs_errors_.begin() + (rank == 0 ? 0 : rank - 1);
+    std::nth_element(abs_errors_.begin(), nth, abs_errors_.end());
+    return {std::sqrt(sum_squared / num), max, *nth, num};
+  }
+
+private:
+  double window_;
+  double percentile_;
+  // pairs of the time [s] and the error [m], in the order of the time
+  std::deque<std::pair<double, double>> errors_;
+  // buffer for the selection of the percentile, which keeps its capacity
+  std::vector<double> abs_errors_;
+};
+
+#endif  // TIER4_DEBUG_TOOLS__LATERAL_ERROR_STATISTICS_HPP_
@@ -0,0 +1,155 @@
+// Copyright 2024 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tier4_debug_tools/lateral_error.hpp"
+
+#define EIGEN_MPL2_ONLY
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <autoware/motion_utils/trajectory/trajectory.hpp>
+#include <autoware/universe_utils/geometry/geometry.hpp>
+#include <autoware/universe_utils/math/normalization.hpp>
+
+#include <tf2/utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+/**
+ * @brief search closest trajectory point in the window around the hint, which fails if the closest
+ * point is on the edge of the window as the closest one may be beyond it
+ */
+std::optional<size_t> findNearestIndexAround(
+  const std::vector<autoware_planning_msgs::msg::TrajectoryPoint> & points,
+  const geometry_msgs::msg::Pose & pose, const size_t hint_index, const size_t window,
+  const double max_yaw)
+{
+  const size_t begin = hint_index > window ? hint_index - window : 0;
+  const size_t end = std::min(hint_index + window + 1, points.size());
+  const double yaw = tf2::getYaw(pose.orientation);
+
+  std::optional<size_t> nearest_index;
+  double min_squared_dist = std::numeric_limits<double>::max();
+  for (size_t i = begin; i < end; ++i) {
+    const auto & point_pose = points.at(i).pose;
+    const double yaw_deviation =
+      autoware::universe_utils::normalizeRadian(yaw - tf2::getYaw(point_pose.orientation));
+    if (std::abs(yaw_deviation) > max_yaw) {
+      continue;
+    }
+    const double squared_dist = autoware::universe_utils::calcSquaredDistance2d(point_pose, pose);
+    if (squared_dist < min_squared_dist) {
+      min_squared_dist = squared_dist;
+      nearest_index = i;
+    }
+  }
+
+  if (!nearest_index) {
+    return std::nullopt;
+  }
+  if (
+    (*nearest_index == begin && begin != 0) ||
+    (*nearest_index == end - 1 && end != points.size())) {
+    return std::nullopt;
+  }
+  return nearest_index;
+}
+}  // namespace
+
+LateralErrorCalculator::LateralErrorCalculator(
+  const double yaw_threshold_to_search_closest, const size_t closest_search_window)
+: yaw_threshold_to_search_closest_(yaw_threshold_to_search_closest),
+  closest_search_window_(std::max<size_t>(closest_search_window, 1))
+{
+}
+
+void LateralErrorCalculator::setTrajectory(
+  const autoware_planning_msgs::msg::Trajectory::ConstSharedPtr & trajectory)
+{
+  trajectory_ptr_ = trajectory;
+  prev_closest_index_ = std::nullopt;
+}
+
+std::optional<size_t> LateralErrorCalculator::searchClosestIndex(
+  const geometry_msgs::msg::Pose & pose)
+{
+  const auto & points = trajectory_ptr_->points;
+  if (prev_closest_index_ && *prev_closest_index_ < points.size()) {
+    const auto closest_index = findNearestIndexAround(
+      points, pose, *prev_closest_index_, closest_search_window_,
+      yaw_threshold_to_search_closest_);
+    if (closest_index) {
+      prev_closest_index_ = closest_index;
+      return closest_index;
+    }
+  }
+
+  prev_closest_index_ = autoware::motion_utils::findNearestIndex(
+    points, pose, std::numeric_limits<double>::max(), yaw_threshold_to_search_closest_);
+  return prev_closest_index_;
+}
+
+std::optional<LateralError> LateralErrorCalculator::calculate(
+  const geometry_msgs::msg::Pose & vehicle_pose,
+  const geometry_msgs::msg::Pose & ground_truth_pose)
+{
+  // Search closest trajectory point with vehicle pose
+  const auto closest_index = searchClosestIndex(vehicle_pose);
+  if (!closest_index) {
+    return std::nullopt;
+  }
+
+  // Calculate the normal vector in the reference trajectory direction
+  size_t base_index = 0;
+  size_t next_index = 0;
+  if (*closest_index == trajectory_ptr_->points.size() - 1) {
+    base_index = *closest_index - 1;
+    next_index = *closest_index;
+  } else {
+    base_index = *closest_index;
+    next_index = *closest_index + 1;
+  }
+
+  const auto & base_pose = trajectory_ptr_->points.at(base_index).pose;
+  const auto & next_pose = trajectory_ptr_->points.at(next_index).pose;
+  const double dx = next_pose.position.x - base_pose.position.x;
+  const double dy = next_pose.position.y - base_pose.position.y;
+  const Eigen::Vector2d trajectory_direction(dx, dy);
+
+  const auto rotation = Eigen::Rotation2Dd(M_PI_2);
+  const Eigen::Vector2d normal_direction = rotation * trajectory_direction;
+  const Eigen::Vector2d unit_normal_direction = normal_direction.normalized();
+
+  // Calculate control lateral error
+  const auto & closest_pose = trajectory_ptr_->points.at(*closest_index).pose;
+  const Eigen::Vector2d closest_to_vehicle(
+    vehicle_pose.position.x - closest_pose.position.x,
+    vehicle_pose.position.y - closest_pose.position.y);
+  const auto control_lateral_error = closest_to_vehicle.dot(unit_normal_direction);
+
+  // Calculate localization lateral error
+  const Eigen::Vector2d vehicle_to_ground_truth(
+    ground_truth_pose.position.x - vehicle_pose.position.x,
+    ground_truth_pose.position.y - vehicle_pose.position.y);
+  const auto localization_lateral_error = vehicle_to_ground_truth.dot(unit_normal_direction);
+
+  return LateralError{
+    control_lateral_error, localization_lateral_error,
+    control_lateral_error + localization_lateral_error};
+}
@@ -0,0 +1,359 @@
+// Copyright 2024 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Evaluates the lateral errors of bags as the lateral_error_publisher does, without playing them:
+//   lateral_error_batch_evaluator --ground-truth-topic <topic> [--trajectory-topic <topic>]
+//     [--vehicle-pose-topic <topic>] [--segment 10.0] [--percentile 0.95] [--max-gap 0.1]
+//     [--yaw-threshold 0.785398] [--closest-search-window 20] [--jobs N] <bag>...
+// The statistics of each segment of each bag are written to stdout as CSV.
+
+#include "tier4_debug_tools/lateral_error.hpp"
+#include "tier4_debug_tools/lateral_error_statistics.hpp"
+
+#include <autoware/universe_utils/geometry/geometry.hpp>
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/time.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+
+#include <autoware_planning_msgs/msg/trajectory.hpp>
+#include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using autoware_planning_msgs::msg::Trajectory;
+using geometry_msgs::msg::PoseWithCovarianceStamped;
+
+struct Options
+{
+  std::vector<std::string> bag_uris;
+  std::string trajectory_topic{"/planning/trajectory"};
+  std::string vehicle_pose_topic{"/localization/pose_with_covariance"};
+  std::string ground_truth_topic;
+  double segment{10.0};
+  double percentile{0.95};
+  double max_gap{0.1};
+  double yaw_threshold{M_PI / 4.0};
+  size_t closest_search_window{20};
+  size_t jobs{std::max(std::thread::hardware_concurrency(), 1u)};
+};
+
+// messages of a bag in the order of their stamps [s]
+struct BagMessages
+{
+  std::vector<std::pair<double, Trajectory::ConstSharedPtr>> trajectories;
+  std::vector<std::pair<double, PoseWithCovarianceStamped>> vehicle_poses;
+  std::vector<std::pair<double, PoseWithCovarianceStamped>> ground_truth_poses;
+};
+
+struct BagResult
+{
+  std::string rows;
+  double duration{0.0};
+  bool succeeded{false};
+};
+
+void printUsage()
+{
+  std::fprintf(
+    stderr,
+    "usage: lateral_error_batch_evaluator --ground-truth-topic <topic> [--trajectory-topic "
+    "<topic>] [--vehicle-pose-topic <topic>] [--segment 10.0] [--percentile 0.95] "
+    "[--max-gap 0.1] [--yaw-threshold 0.785398] [--closest-search-window 20] [--jobs N] "
+    "<bag>...\n");
+}
+
+bool parseOptions(const int argc, char ** argv, Options & options)
+{
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--trajectory-topic" && has_value) {
+      options.trajectory_topic = argv[++i];
+    } else if (arg == "--vehicle-pose-topic" && has_value) {
+      options.vehicle_pose_topic = argv[++i];
+    } else if (arg == "--ground-truth-topic" && has_value) {
+      options.ground_truth_topic = argv[++i];
+    } else if (arg == "--segment" && has_value) {
+      options.segment = std::stod(argv[++i]);
+    } else if (arg == "--percentile" && has_value) {
+      options.percentile = std::stod(argv[++i]);
+    } else if (arg == "--max-gap" && has_value) {
+      options.max_gap = std::stod(argv[++i]);
+    } else if (arg == "--yaw-threshold" && has_value) {
+      options.yaw_threshold = std::stod(argv[++i]);
+    } else if (arg == "--closest-search-window" && has_value) {
+      options.closest_search_window = std::stoul(argv[++i]);
+    } else if (arg == "--jobs" && has_value) {
+      options.jobs = std::max(std::stoul(argv[++i]), 1ul);
+    } else if (arg.rfind("--", 0) == 0) {
+      return false;
+    } else {
+      options.bag_uris.push_back(arg);
+    }
+  }
+  return !options.bag_uris.empty() && !options.ground_truth_topic.empty() &&
+         options.segment > 0.0 && options.max_gap > 0.0;
+}
+
+template <typename T>
+void sortByStamp(std::vector<std::pair<double, T>> & messages)
+{
+  std::stable_sort(messages.begin(), messages.end(), [](const auto & a, const auto & b) {
+    return a.first < b.first;
+  });
+}
+
+BagMessages readBag(const std::string & bag_uri, const Options & options)
+{
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = bag_uri;
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::readers::SequentialReader reader;
+  reader.open(storage_options, converter_options);
+
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {
+    options.trajectory_topic, options.vehicle_pose_topic, options.ground_truth_topic};
+  reader.set_filter(filter);
+
+  rclcpp::Serialization<Trajectory> serialization_trajectory;
+  rclcpp::Serialization<PoseWithCovarianceStamped> serialization_pose;
+  BagMessages messages;
+  while (reader.has_next()) {
+    const auto serialized_message = reader.read_next();
+    const rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+    const auto & topic_name = serialized_message->topic_name;
+    if (topic_name == options.trajectory_topic) {
+      auto trajectory = std::make_shared<Trajectory>();
+      serialization_trajectory.deserialize_message(&msg, trajectory.get());
+      messages.trajectories.emplace_back(
+        rclcpp::Time(trajectory->header.stamp).seconds(), trajectory);
+    }
+    // the vehicle pose and the ground truth pose may be the same topic
+    if (topic_name == options.vehicle_pose_topic || topic_name == options.ground_truth_topic) {
+      PoseWithCovarianceStamped pose;
+      serialization_pose.deserialize_message(&msg, &pose);
+      const double stamp = rclcpp::Time(pose.header.stamp).seconds();
+      if (topic_name == options.vehicle_pose_topic) {
+        messages.vehicle_poses.emplace_back(stamp, pose);
+      }
+      if (topic_name == options.ground_truth_topic) {
+        messages.ground_truth_poses.emplace_back(stamp, pose);
+      }
+    }
+  }
+
+  // the recorded order may differ from the order of the stamps
+  sortByStamp(messages.trajectories);
+  sortByStamp(messages.vehicle_poses);
+  sortByStamp(messages.ground_truth_poses);
+  return messages;
+}
+
+// the vehicle pose interpolated at the stamp, if the stamp is between two poses close enough
+std::optional<geometry_msgs::msg::Pose> interpolateVehiclePose(
+  const std::vector<std::pair<double, PoseWithCovarianceStamped>> & vehicle_poses,
+  const double stamp, const double max_gap)
+{
+  const auto next = std::lower_bound(
+    vehicle_poses.begin(), vehicle_poses.end(), stamp,
+    [](const auto & pose, const double t) { return pose.first < t; });
+  if (next == vehicle_poses.end()) {
+    return std::nullopt;
+  }
+  if (next->first == stamp) {
+    return next->second.pose.pose;
+  }
+  if (next == vehicle_poses.begin()) {
+    return std::nullopt;
+  }
+  const auto prev = std::prev(next);
+  if (next->first - prev->first > max_gap) {
+    return std::nullopt;
+  }
+  const double ratio = (stamp - prev->first) / (next->first - prev->first);
+  return autoware::universe_utils::calcInterpolatedPose(
+    prev->second.pose.pose, next->second.pose.pose, ratio);
+}
+
+void appendRow(
+  std::string & rows, const std::string & bag_uri, const size_t segment, const double begin,
+  const double end, std::vector<LateralErrorStatistics> & statistics)
+{
+  char buffer[128];
+  std::snprintf(buffer, sizeof(buffer), "%zu,%.3f,%.3f", segment, begin, end);
+  rows += bag_uri + "," + buffer;
+  const auto sample_num =
+    statistics.front().calcValues(end)[static_cast<int>(LateralErrorStatistics::TYPE::SAMPLE_NUM)];
+  std::snprintf(buffer, sizeof(buffer), ",%.0f", sample_num);
+  rows += buffer;
+  for (auto & s : statistics) {
+    const auto values = s.calcValues(end);
+    std::snprintf(
+      buffer, sizeof(buffer), ",%.6f,%.6f,%.6f",
+      values[static_cast<int>(LateralErrorStatistics::TYPE::RMS)],
+      values[static_cast<int>(LateralErrorStatistics::TYPE::MAX)],
+      values[static_cast<int>(LateralErrorStatistics::TYPE::PERCENTILE)]);
+    rows += buffer;
+  }
+  rows += "\n";
+}
+
+BagResult evaluateBag(const std::string & bag_uri, const Options & options)
+{
+  const auto messages = readBag(bag_uri, options);
+  BagResult result;
+  result.succeeded = true;
+  if (messages.ground_truth_poses.empty()) {
+    return result;
+  }
+
+  LateralErrorCalculator calculator(options.yaw_threshold, options.closest_search_window);
+  // statistics of control, localization and (control + localization) in the current segment
+  const auto create_statistics = [&]() {
+    return std::vector<LateralErrorStatistics>(
+      3, LateralErrorStatistics(options.segment, options.percentile));
+  };
+  auto statistics = create_statistics();
+
+  const double begin_time = messages.ground_truth_poses.front().first;
+  result.duration = messages.ground_truth_poses.back().first - begin_time;
+  size_t segment = 0;
+  double last_time = begin_time;
+  bool has_samples = false;
+  const auto flush_segment = [&]() {
+    if (has_samples) {
+      appendRow(
+        result.rows, bag_uri, segment, begin_time + segment * options.segment, last_time,
+        statistics);
+    }
+    statistics = create_statistics();
+    has_samples = false;
+  };
+
+  size_t next_trajectory = 0;
+  for (const auto & [stamp, ground_truth_pose] : messages.ground_truth_poses) {
+    // the latest trajectory stamped before the ground truth pose
+    bool is_trajectory_updated = false;
+    while (
+      next_trajectory < messages.trajectories.size() &&
+      messages.trajectories.at(next_trajectory).first <= stamp) {
+      ++next_trajectory;
+      is_trajectory_updated = true;
+    }
+    if (is_trajectory_updated) {
+      calculator.setTrajectory(messages.trajectories.at(next_trajectory - 1).second);
+    }
+    const auto & trajectory_ptr = calculator.getTrajectory();
+    if (!trajectory_ptr || trajectory_ptr->points.size() < 2) {
+      continue;
+    }
+
+    const auto vehicle_pose =
+      interpolateVehiclePose(messages.vehicle_poses, stamp, options.max_gap);
+    if (!vehicle_pose) {
+      continue;
+    }
+    const auto errors = calculator.calculate(*vehicle_pose, ground_truth_pose.pose.pose);
+    if (!errors) {
+      continue;
+    }
+
+    const size_t stamp_segment = static_cast<size_t>((stamp - begin_time) / options.segment);
+    if (stamp_segment != segment) {
+      flush_segment();
+      segment = stamp_segment;
+    }
+    statistics.at(0).add(stamp, errors->control);
+    statistics.at(1).add(stamp, errors->localization);
+    statistics.at(2).add(stamp, errors->total);
+    last_time = stamp;
+    has_samples = true;
+  }
+  flush_segment();
+  return result;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  Options options;
+  try {
+    if (!parseOptions(argc, argv, options)) {
+      printUsage();
+      return 1;
+    }
+  } catch (const std::exception &) {
+    printUsage();
+    return 1;
+  }
+
+  // ---------------------------------------- //
+  // Evaluate the bags in parallel, one bag per job
+  // ---------------------------------------- //
+  const auto wall_begin = std::chrono::steady_clock::now();
+  std::vector<BagResult> results(options.bag_uris.size());
+  std::atomic<size_t> next_bag{0};
+  const auto evaluate = [&]() {
+    for (size_t i = next_bag++; i < options.bag_uris.size(); i = next_bag++) {
+      try {
+        results.at(i) = evaluateBag(options.bag_uris.at(i), options);
+      } catch (const std::exception & e) {
+        std::fprintf(
+          stderr, "failed to evaluate %s: %s\n", options.bag_uris.at(i).c_str(), e.what());
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < std::min(options.jobs, options.bag_uris.size()); ++i) {
+    workers.emplace_back(evaluate);
+  }
+  for (auto & worker : workers) {
+    worker.join();
+  }
+  const double wall_time =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_begin).count();
+
+  // the rows in the order of the bags, regardless of the order of the jobs
+  std::printf(
+    "bag,segment,begin,end,samples,control_rms,control_max,control_percentile,localization_rms,"
+    "localization_max,localization_percentile,lateral_rms,lateral_max,lateral_percentile\n");
+  double duration = 0.0;
+  size_t failed_bag_num = 0;
+  for (const auto & result : results) {
+    std::fputs(result.rows.c_str(), stdout);
+    duration += result.duration;
+    failed_bag_num += result.succeeded ? 0 : 1;
+  }
+  std::fprintf(
+    stderr, "evaluated %zu bags of %.1f[s] in %.1f[s]\n", results.size() - failed_bag_num,
+    duration, wall_time);
+  return failed_bag_num == 0 ? 0 : 1;
+}
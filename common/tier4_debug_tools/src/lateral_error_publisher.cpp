@@ -14,7 +14,7 @@
 
 #include "tier4_debug_tools/lateral_error_publisher.hpp"
 
-#include <limits>
+#include <algorithm>
 
 LateralErrorPublisher::LateralErrorPublisher(const rclcpp::NodeOptions & node_options)
 : Node("lateral_error_publisher", node_options)
@@ -22,8 +22,15 @@ LateralErrorPublisher::LateralErrorPublisher(const rclcpp::NodeOptions & node_op
   using std::placeholders::_1;
 
   /* Parameters */
-  yaw_threshold_to_search_closest_ =
+  const double yaw_threshold_to_search_closest =
     declare_parameter("yaw_threshold_to_search_closest", M_PI / 4.0);
+  const int closest_search_window = declare_parameter("closest_search_window", 20);
+  calculator_ = std::make_unique<LateralErrorCalculator>(
+    yaw_threshold_to_search_closest, static_cast<size_t>(std::max(closest_search_window, 1)));
+  const double statistics_window = declare_parameter("statistics_window", 1.0);
+  const double statistics_percentile = declare_parameter("statistics_percentile", 0.95);
+  const double statistics_publish_rate = declare_parameter("statistics_publish_rate", 1.0);
+  statistics_.assign(3, LateralErrorStatistics(statistics_window, statistics_percentile));
 
   /* Publishers and Subscribers */
   sub_trajectory_ = create_subscription<autoware_planning_msgs::msg::Trajectory>(
@@ -42,12 +49,27 @@ LateralErrorPublisher::LateralErrorPublisher(const rclcpp::NodeOptions & node_op
       "~/localization_lateral_error", 1);
   pub_lateral_error_ =
     create_publisher<autoware_internal_debug_msgs::msg::Float32Stamped>("~/lateral_error", 1);
+  pub_statistics_.at(0) =
+    create_publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>(
+      "~/control_lateral_error_statistics", 1);
+  pub_statistics_.at(1) =
+    create_publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>(
+      "~/localization_lateral_error_statistics", 1);
+  pub_statistics_.at(2) =
+    create_publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>(
+      "~/lateral_error_statistics", 1);
+
+  /* Timer */
+  const auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::duration<double>(1.0 / statistics_publish_rate));
+  timer_statistics_ = rclcpp::create_timer(
+    this, get_clock(), period, std::bind(&LateralErrorPublisher::onStatisticsTimer, this));
 }
 
 void LateralErrorPublisher::onTrajectory(
   const autoware_planning_msgs::msg::Trajectory::SharedPtr msg)
 {
-  current_trajectory_ptr_ = msg;
+  calculator_->setTrajectory(msg);
 }
 
 void LateralErrorPublisher::onVehiclePose(
@@ -62,74 +84,32 @@ void LateralErrorPublisher::onGroundTruthPose(
   current_ground_truth_pose_ptr_ = msg;
 
   // Guard
-  if (current_trajectory_ptr_ == nullptr || current_vehicle_pose_ptr_ == nullptr) {
+  const auto & trajectory_ptr = calculator_->getTrajectory();
+  if (trajectory_ptr == nullptr || current_vehicle_pose_ptr_ == nullptr) {
     RCLCPP_WARN_THROTTLE(
       this->get_logger(), *this->get_clock(), 1000 /* ms */,
       "Reference trajectory or EKF pose is not received");
     return;
   }
-  if (current_trajectory_ptr_->points.size() < 2) {
+  if (trajectory_ptr->points.size() < 2) {
     RCLCPP_WARN_THROTTLE(
       this->get_logger(), *this->get_clock(), 1000 /* ms */, "Reference trajectory is too short");
     return;
   }
 
-  // Search closest trajectory point with vehicle pose
-  const auto closest_index = autoware::motion_utils::findNearestIndex(
-    current_trajectory_ptr_->points, current_vehicle_pose_ptr_->pose.pose,
-    std::numeric_limits<double>::max(), yaw_threshold_to_search_closest_);
-  if (!closest_index) {
+  const auto errors =
+    calculator_->calculate(current_vehicle_pose_ptr_->pose.pose, msg->pose.pose);
+  if (!errors) {
     RCLCPP_WARN_THROTTLE(
       this->get_logger(), *this->get_clock(), 1000 /* ms */, "Failed to search closest index");
     return;
   }
-
-  // Calculate the normal vector in the reference trajectory direction
-  size_t base_index = 0;
-  size_t next_index = 0;
-  if (*closest_index == current_trajectory_ptr_->points.size() - 1) {
-    base_index = *closest_index - 1;
-    next_index = *closest_index;
-  } else {
-    base_index = *closest_index;
-    next_index = *closest_index + 1;
-  }
-
-  const auto & base_pose = current_trajectory_ptr_->points.at(base_index).pose;
-  const auto & next_pose = current_trajectory_ptr_->points.at(next_index).pose;
-  const double dx = next_pose.position.x - base_pose.position.x;
-  const double dy = next_pose.position.y - base_pose.position.y;
-  const Eigen::Vector2d trajectory_direction(dx, dy);
-  RCLCPP_DEBUG(this->get_logger(), "trajectory direction: (%f, %f)", dx, dy);
-
-  const auto rotation = Eigen::Rotation2Dd(M_PI_2);
-  const Eigen::Vector2d normal_direction = rotation * trajectory_direction;
-  RCLCPP_DEBUG(
-    this->get_logger(), "normal direction: (%f, %f)", normal_direction(0), normal_direction(1));
-  const Eigen::Vector2d unit_normal_direction = normal_direction.normalized();
+  const double control_lateral_error = errors->control;
+  const double localization_lateral_error = errors->localization;
+  const double lateral_error = errors->total;
   RCLCPP_DEBUG(
-    this->get_logger(), "unit normal direction: (%f, %f)", unit_normal_direction(0),
-    unit_normal_direction(1));
-
-  // Calculate control lateral error
-  const auto & closest_pose = current_trajectory_ptr_->points.at(*closest_index).pose;
-  const auto & vehicle_pose = current_vehicle_pose_ptr_->pose.pose;
-  const Eigen::Vector2d closest_to_vehicle(
-    vehicle_pose.position.x - closest_pose.position.x,
-    vehicle_pose.position.y - closest_pose.position.y);
-  const auto control_lateral_error = closest_to_vehicle.dot(unit_normal_direction);
-  RCLCPP_DEBUG(this->get_logger(), "control_lateral_error: %f", control_lateral_error);
-
-  // Calculate localization lateral error
-  const auto ground_truth_pose = current_ground_truth_pose_ptr_->pose.pose;
-  const Eigen::Vector2d vehicle_to_ground_truth(
-    ground_truth_pose.position.x - vehicle_pose.position.x,
-    ground_truth_pose.position.y - vehicle_pose.position.y);
-  const auto localization_lateral_error = vehicle_to_ground_truth.dot(unit_normal_direction);
-  RCLCPP_DEBUG(this->get_logger(), "localization_lateral_error: %f", localization_lateral_error);
-
-  const auto lateral_error = control_lateral_error + localization_lateral_error;
-  RCLCPP_DEBUG(this->get_logger(), "localization_error: %f", lateral_error);
+    this->get_logger(), "control_lateral_error: %f, localization_lateral_error: %f",
+    control_lateral_error, localization_lateral_error);
 
   // Publish lateral errors
   autoware_internal_debug_msgs::msg::Float32Stamped control_msg;
@@ -146,6 +126,24 @@ void LateralErrorPublisher::onGroundTruthPose(
   sum_msg.stamp = this->now();
   sum_msg.data = static_cast<float>(lateral_error);
   pub_lateral_error_->publish(sum_msg);
+
+  const double time = this->now().seconds();
+  statistics_.at(0).add(time, control_lateral_error);
+  statistics_.at(1).add(time, localization_lateral_error);
+  statistics_.at(2).add(time, lateral_error);
+}
+
+void LateralErrorPublisher::onStatisticsTimer()
+{
+  const auto stamp = this->now();
+  for (size_t i = 0; i < statistics_.size(); ++i) {
+    autoware_internal_debug_msgs::msg::Float32MultiArrayStamped msg;
+    msg.stamp = stamp;
+    for (const auto value : statistics_.at(i).calcValues(stamp.seconds())) {
+      msg.data.push_back(static_cast<float>(value));
+    }
+    pub_statistics_.at(i)->publish(msg);
+  }
 }
 
 #include <rclcpp_components/register_node_macro.hpp>
@@ -27,6 +27,8 @@
 #include <rviz_common/panel.hpp>
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -49,6 +51,18 @@ struct LoggerNamespaceInfo
   QString ns;  // group namespace
   std::vector<ButtonInfo> button_info_vec;
 };
+// requests sent in parallel by a press of a button, whose responses are reported together
+struct RequestBatch
+{
+  QString button_name;
+  QString level;
+  size_t pending_num{0};
+  size_t succeeded_num{0};
+  size_t failed_num{0};
+  // loggers already at the level, or whose node has no service
+  size_t unchanged_num{0};
+  size_t unavailable_num{0};
+};
 class LoggingLevelConfigureRvizPlugin : public rviz_common::Panel
 {
 Q_OBJECT  // This macro is needed for Qt to handle slots and signals
@@ -71,6 +85,15 @@ private:
   // button_map_[button_name][logging_level] = Q_button_pointer
   std::unordered_map<QString, std::unordered_map<QString, QPushButton *>> button_map_;
 
+  // logger_levels_[{node_name, logger_name}] = level, set or being set, which is guarded by
+  // level_mutex_ as the responses are handled by the executor of the node
+  std::mutex level_mutex_;
+  std::map<std::pair<QString, QString>, QString> logger_levels_;
+  void onLoggerLevelResponse(
+    const std::shared_ptr<RequestBatch> & batch, const std::pair<QString, QString> & logger,
+    const bool success);
+  void reportRequestBatch(const RequestBatch & batch) const;
+
   QStringList getNodeList();
   int getMaxModuleNameWidth(QLabel * containerLabel);
   void setLoggerNodeMap();
@@ -23,10 +23,11 @@
 
 #include <algorithm>
 #include <cstdlib>
-#include <iostream>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace rviz_plugin
@@ -151,21 +152,47 @@ void LoggingLevelConfigureRvizPlugin::onButtonClick(
   QPushButton * button, const QString & target_module_name, const QString & level)
 {
   if (button) {
-    const auto callback =
-      [&](rclcpp::Client<logging_demo::srv::ConfigLogger>::SharedFuture future) {
-        std::cerr << "change logging level: "
-                  << std::string(future.get()->success ? "success!" : "failed...") << std::endl;
-      };
-
-    const auto node_logger_vec = getNodeLoggerNameFromButtonName(target_module_name);
-    for (const auto & data : node_logger_vec) {
-      const auto req = std::make_shared<logging_demo::srv::ConfigLogger::Request>();
-
-      req->logger_name = data.logger_name.toStdString();
-      req->level = level.toStdString();
-      std::cerr << "logger level of " << req->logger_name << " is set to " << req->level
-                << std::endl;
-      client_map_[data.node_name]->async_send_request(req, callback);
+    using Client = rclcpp::Client<logging_demo::srv::ConfigLogger>;
+    using Request = logging_demo::srv::ConfigLogger::Request;
+    const auto batch = std::make_shared<RequestBatch>();
+    batch->button_name = target_module_name;
+    batch->level = level;
+
+    // the loggers already at the level are skipped, and the others are sent all at once
+    std::vector<std::tuple<Client::SharedPtr, Request::SharedPtr, std::pair<QString, QString>>>
+      requests;
+    {
+      std::lock_guard<std::mutex> lock(level_mutex_);
+      for (const auto & data : getNodeLoggerNameFromButtonName(target_module_name)) {
+        const auto logger = std::make_pair(data.node_name, data.logger_name);
+        const auto level_itr = logger_levels_.find(logger);
+        if (level_itr != logger_levels_.end() && level_itr->second == level) {
+          batch->unchanged_num++;
+          continue;
+        }
+        const auto client_itr = client_map_.find(data.node_name);
+        if (client_itr == client_map_.end() || !client_itr->second->service_is_ready()) {
+          batch->unavailable_num++;
+          continue;
+        }
+        const auto req = std::make_shared<Request>();
+        req->logger_name = data.logger_name.toStdString();
+        req->level = level.toStdString();
+        // not to send it again while it is in flight, and removed if it fails
+        logger_levels_[logger] = level;
+        requests.emplace_back(client_itr->second, req, logger);
+      }
+      batch->pending_num = requests.size();
+    }
+
+    for (const auto & [client, req, logger] : requests) {
+      client->async_send_request(
+        req, [this, batch, logger = logger](Client::SharedFuture future) {
+          onLoggerLevelResponse(batch, logger, future.get()->success);
+        });
+    }
+    if (requests.empty()) {
+      reportRequestBatch(*batch);
     }
 
     updateButtonColors(
@@ -173,6 +200,35 @@ void LoggingLevelConfigureRvizPlugin::onButtonClick(
   }
 }
 
+void LoggingLevelConfigureRvizPlugin::onLoggerLevelResponse(
+  const std::shared_ptr<RequestBatch> & batch, const std::pair<QString, QString> & logger,
+  const bool success)
+{
+  std::lock_guard<std::mutex> lock(level_mutex_);
+  if (success) {
+    batch->succeeded_num++;
+  } else {
+    batch->failed_num++;
+    // the level is unknown, so that the next press sends it again
+    const auto level_itr = logger_levels_.find(logger);
+    if (level_itr != logger_levels_.end() && level_itr->second == batch->level) {
+      logger_levels_.erase(level_itr);
+    }
+  }
+  if (--batch->pending_num == 0) {
+    reportRequestBatch(*batch);
+  }
+}
+
+void LoggingLevelConfigureRvizPlugin::reportRequestBatch(const RequestBatch & batch) const
+{
+  RCLCPP_INFO(
+    raw_node_->get_logger(),
+    "logger level of %s is set to %s: %zu succeeded, %zu failed, %zu unchanged, %zu unavailable",
+    batch.button_name.toStdString().c_str(), batch.level.toStdString().c_str(),
+    batch.succeeded_num, batch.failed_num, batch.unchanged_num, batch.unavailable_num);
+}
+
 void LoggingLevelConfigureRvizPlugin::updateButtonColors(
   const QString & target_module_name, QPushButton * active_button, const QString & level)
 {
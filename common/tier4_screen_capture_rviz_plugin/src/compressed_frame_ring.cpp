@@ -0,0 +1,102 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "compressed_frame_ring.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+CompressedFrameRing::CompressedFrameRing(const int jpeg_quality)
+: jpeg_params_{cv::IMWRITE_JPEG_QUALITY, jpeg_quality}
+{
+}
+
+void CompressedFrameRing::set_capacity(const size_t capacity)
+{
+  if (capacity == slots_.size()) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<std::vector<uchar>>> slots(capacity);
+  const size_t size = std::min(size_, capacity);
+  for (size_t i = 0; i < size; ++i) {
+    slots[i] = std::move(slots_[(oldest_index() + size_ - size + i) % slots_.size()]);
+  }
+
+  slots_ = std::move(slots);
+  size_ = size;
+  head_ = capacity == 0 ? 0 : size % capacity;
+}
+
+void CompressedFrameRing::clear()
+{
+  slots_.assign(slots_.size(), nullptr);
+  head_ = 0;
+  size_ = 0;
+}
+
+void CompressedFrameRing::push(const cv::Mat & frame, const bool flip_vertically)
+{
+  if (slots_.empty()) {
+    return;
+  }
+
+  auto & slot = slots_[head_];
+  if (!slot || slot.use_count() > 1) {
+    slot = std::make_shared<std::vector<uchar>>();
+  }
+
+  if (frame.channels() == 4) {
+    cv::cvtColor(frame, bgr_frame_, cv::COLOR_BGRA2BGR);
+    if (flip_vertically) {
+      cv::flip(bgr_frame_, bgr_frame_, 0);
+    }
+    cv::imencode(".jpg", bgr_frame_, *slot, jpeg_params_);
+  } else if (flip_vertically) {
+    cv::flip(frame, bgr_frame_, 0);
+    cv::imencode(".jpg", bgr_frame_, *slot, jpeg_params_);
+  } else {
+    cv::imencode(".jpg", frame, *slot, jpeg_params_);
+  }
+
+  head_ = (head_ + 1) % slots_.size();
+  size_ = std::min(size_ + 1, slots_.size());
+}
+
+std::vector<CompressedFrameRing::EncodedFrame> CompressedFrameRing::snapshot() const
+{
+  std::vector<EncodedFrame> frames;
+  frames.reserve(size_);
+  for (size_t i = 0; i < size_; ++i) {
+    frames.push_back(slots_[(oldest_index() + i) % slots_.size()]);
+  }
+  return frames;
+}
+
+size_t CompressedFrameRing::memory_size() const
+{
+  size_t memory_size = 0;
+  for (const auto & slot : slots_) {
+    if (slot) {
+      memory_size += slot->capacity();
+    }
+  }
+  return memory_size;
+}
+
+}  // namespace rviz_plugins
@@ -0,0 +1,69 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMPRESSED_FRAME_RING_HPP_
+#define COMPRESSED_FRAME_RING_HPP_
+
+#include <opencv2/opencv.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+// Ring of the last frames compressed to JPEG. The buffer of a slot is reused when it is
+// overwritten, unless a snapshot still holds it.
+class CompressedFrameRing
+{
+public:
+  using EncodedFrame = std::shared_ptr<const std::vector<uchar>>;
+
+  explicit CompressedFrameRing(const int jpeg_quality = 90);
+
+  // keeps the newest frames which fit in the new capacity
+  void set_capacity(const size_t capacity);
+
+  // releases the frames, keeping the capacity
+  void clear();
+
+  // compresses the BGR or BGRA frame over the oldest one when the ring is full, flipping a
+  // bottom-up frame first
+  void push(const cv::Mat & frame, const bool flip_vertically = false);
+
+  // the frames from the oldest, which stay valid while the ring is updated
+  std::vector<EncodedFrame> snapshot() const;
+
+  bool empty() const { return size_ == 0; }
+
+  size_t size() const { return size_; }
+
+  // total size of the compressed frames [byte]
+  size_t memory_size() const;
+
+private:
+  size_t oldest_index() const { return (head_ + slots_.size() - size_) % slots_.size(); }
+
+  std::vector<std::shared_ptr<std::vector<uchar>>> slots_;
+  // next slot to write
+  size_t head_{0};
+  size_t size_{0};
+
+  std::vector<int> jpeg_params_;
+  cv::Mat bgr_frame_;
+};
+
+}  // namespace rviz_plugins
+
+#endif  // COMPRESSED_FRAME_RING_HPP_
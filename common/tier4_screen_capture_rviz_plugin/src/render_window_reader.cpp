@@ -0,0 +1,145 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "render_window_reader.hpp"
+
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <OgreRenderTarget.h>
+
+#include <utility>
+
+namespace rviz_plugins
+{
+
+RenderWindowReader::RenderWindowReader(
+  rviz_rendering::RenderWindow * render_window, Callback callback)
+: render_window_(render_window), callback_(std::move(callback))
+{
+  rviz_rendering::RenderWindowOgreAdapter::addListener(render_window_, this);
+}
+
+RenderWindowReader::~RenderWindowReader()
+{
+  // the buffers which are not released yet go with the GL context of the window
+  rviz_rendering::RenderWindowOgreAdapter::removeListener(render_window_, this);
+}
+
+void RenderWindowReader::release()
+{
+  requested_ = false;
+  release_requested_ = true;
+}
+
+void RenderWindowReader::postRenderTargetUpdate(const Ogre::RenderTargetEvent & event)
+{
+  // the window is not swapped yet and its GL context is current
+  if (!single_callbacks_.empty()) {
+    read_single(event);
+  }
+
+  if (release_requested_) {
+    free_buffers();
+    release_requested_ = false;
+    return;
+  }
+
+  if (!requested_) return;
+  requested_ = false;
+
+  const cv::Size size(
+    static_cast<int>(event.source->getWidth()), static_cast<int>(event.source->getHeight()));
+  if (size.area() == 0) return;
+  if (size != size_) {
+    resize(size);
+  }
+
+  GLint pack_alignment = 4;
+  glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+  // the read only queues a copy into the buffer, which is mapped at the next request
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers_[next_buffer_]);
+  glReadBuffer(GL_BACK);
+  glReadPixels(0, 0, size_.width, size_.height, GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+  queued_[next_buffer_] = true;
+
+  next_buffer_ = 1 - next_buffer_;
+  if (queued_[next_buffer_]) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffers_[next_buffer_]);
+    const auto * pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (pixels) {
+      const cv::Mat frame(size_, CV_8UC3, const_cast<void *>(pixels));
+      callback_(frame);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    queued_[next_buffer_] = false;
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+}
+
+void RenderWindowReader::read_single(const Ogre::RenderTargetEvent & event)
+{
+  const auto callbacks = std::move(single_callbacks_);
+  single_callbacks_.clear();
+
+  const int width = static_cast<int>(event.source->getWidth());
+  const int height = static_cast<int>(event.source->getHeight());
+  if (width * height == 0) return;
+  single_frame_.create(height, width, CV_8UC3);
+
+  GLint pack_alignment = 4;
+  glGetIntegerv(GL_PACK_ALIGNMENT, &pack_alignment);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  // into the memory of the frame, not a pixel buffer
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glReadBuffer(GL_BACK);
+  glReadPixels(0, 0, width, height, GL_BGR, GL_UNSIGNED_BYTE, single_frame_.data);
+  glPixelStorei(GL_PACK_ALIGNMENT, pack_alignment);
+
+  for (const auto & callback : callbacks) {
+    callback(single_frame_);
+  }
+}
+
+void RenderWindowReader::resize(const cv::Size & size)
+{
+  free_buffers();
+
+  glGenBuffers(static_cast<GLsizei>(buffers_.size()), buffers_.data());
+  for (const auto buffer : buffers_) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    glBufferData(
+      GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size.area()) * 3, nullptr, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  size_ = size;
+}
+
+void RenderWindowReader::free_buffers()
+{
+  if (size_.area() > 0) {
+    glDeleteBuffers(static_cast<GLsizei>(buffers_.size()), buffers_.data());
+  }
+  buffers_ = {};
+  queued_ = {};
+  next_buffer_ = 0;
+  size_ = cv::Size();
+}
+
+}  // namespace rviz_plugins
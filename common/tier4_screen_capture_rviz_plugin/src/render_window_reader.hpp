@@ -0,0 +1,82 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RENDER_WINDOW_READER_HPP_
+#define RENDER_WINDOW_READER_HPP_
+
+#include <OgreRenderTargetListener.h>
+#include <opencv2/opencv.hpp>
+#include <rviz_rendering/render_window.hpp>
+
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+// Reads the frames rendered to an rviz render window back from the GPU, as BGR without the window
+// decorations. A read is queued into one of two pixel buffers after a requested render and mapped
+// at the next one, so the GL pipeline is not stalled and a frame is delivered one request late.
+// The frames are bottom-up, as GL stores them, and only valid in the callback.
+class RenderWindowReader : public Ogre::RenderTargetListener
+{
+public:
+  using Callback = std::function<void(const cv::Mat & bottom_up_frame)>;
+
+  RenderWindowReader(rviz_rendering::RenderWindow * render_window, Callback callback);
+  ~RenderWindowReader() override;
+
+  RenderWindowReader(const RenderWindowReader &) = delete;
+  RenderWindowReader & operator=(const RenderWindowReader &) = delete;
+
+  // reads the next rendered frame
+  void request() { requested_ = true; }
+
+  // reads the next rendered frame at once into memory, waiting for the GPU, for the single
+  // frames that cannot be a request late, e.g. screenshots
+  void request_single(Callback callback) { single_callbacks_.push_back(std::move(callback)); }
+
+  // drops the queued frames and frees the pixel buffers at the next render, since the GL context
+  // of the window is only current while it renders
+  void release();
+
+  void postRenderTargetUpdate(const Ogre::RenderTargetEvent & event) override;
+
+private:
+  void read_single(const Ogre::RenderTargetEvent & event);
+
+  void resize(const cv::Size & size);
+
+  void free_buffers();
+
+  rviz_rendering::RenderWindow * render_window_;
+  Callback callback_;
+
+  std::vector<Callback> single_callbacks_;
+  cv::Mat single_frame_;
+
+  std::array<unsigned int, 2> buffers_{};
+  std::array<bool, 2> queued_{};
+  size_t next_buffer_{0};
+  cv::Size size_;
+
+  bool requested_{false};
+  bool release_requested_{false};
+};
+
+}  // namespace rviz_plugins
+
+#endif  // RENDER_WINDOW_READER_HPP_
@@ -16,11 +16,14 @@
 
 #include <rclcpp/rclcpp.hpp>
 
+#include <algorithm>
 #include <ctime>
 #include <deque>
 #include <filesystem>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <utility>
 
 namespace rviz_plugins
 {
@@ -28,6 +31,10 @@ namespace rviz_plugins
 using std::placeholders::_1;
 using std::placeholders::_2;
 
+// the screenshots of a test scenario may be requested faster than they are compressed
+constexpr size_t SCREEN_SHOT_THREAD_NUM = 2;
+constexpr size_t SCREEN_SHOT_QUEUE_SIZE = 8;
+
 void setFormatDate(QLabel * line, double time)
 {
   char buffer[128];
@@ -106,6 +113,15 @@ void AutowareScreenCapturePanel::onInitialize()
   srv_ = raw_node_->create_service<Capture>(
     "/debug/capture", std::bind(&AutowareScreenCapturePanel::callback, this, _1, _2));
 
+  screenshot_writer_ = std::make_unique<ScreenshotWriter>(
+    SCREEN_SHOT_THREAD_NUM, SCREEN_SHOT_QUEUE_SIZE, [this](const std::string & file_name) {
+      RCLCPP_ERROR_STREAM(raw_node_->get_logger(), "FAILED TO WRITE " << file_name);
+    });
+
+  reader_ = std::make_unique<RenderWindowReader>(
+    getDisplayContext()->getViewManager()->getRenderPanel()->getRenderWindow(),
+    [this](const cv::Mat & frame) { on_frame(frame); });
+
   create_timer();
 }
 
@@ -128,54 +144,84 @@ void AutowareScreenCapturePanel::on_buffer_size_change(const int buffer_size)
   update_buffer_size();
   RCLCPP_INFO_STREAM(
     raw_node_->get_logger(),
-    "BUFFER SIZE: " << buffer_size << " [sec] with " << buffer_size_frames_ << " frames)");
+    "BUFFER SIZE: " << buffer_size << " [sec] with " << buffer_size_frames_ << " frames ("
+                    << buffer_.memory_size() / 1e6 << " [MB] used)");
 }
 
 void AutowareScreenCapturePanel::update_buffer_size()
 {
   // Calculate buffer sizes in frames
   buffer_size_frames_ = buffer_size_->value() * rate_->value();
+  buffer_.set_capacity(buffer_size_frames_);
 }
 
 void AutowareScreenCapturePanel::on_timer()
 {
   setFormatDate(ros_time_label_, rclcpp::Clock().now().seconds());
 
-  if (!main_window_) return;
+  finishing_encoders_.erase(
+    std::remove_if(
+      finishing_encoders_.begin(), finishing_encoders_.end(),
+      [](const auto & encoder) { return encoder->is_finished(); }),
+    finishing_encoders_.end());
 
-  // this is deprecated but only way to capture nicely
-  QScreen * screen = QGuiApplication::primaryScreen();
-  QPixmap original_pixmap = screen->grabWindow(main_window_->winId());
-  const auto q_image =
-    original_pixmap.toImage().convertToFormat(QImage::Format_RGB888).rgbSwapped();
-  const int h = q_image.height();
-  const int w = q_image.width();
-  cv::Size size = cv::Size(w, h);
-  cv::Mat image(
-    size, CV_8UC3, const_cast<uchar *>(q_image.bits()),
-    static_cast<size_t>(q_image.bytesPerLine()));
+  // the frame is read after the next render and delivered to on_frame at the one after
+  if (reader_ && (is_buffering_ || is_recording_)) {
+    reader_->request();
+  }
+}
 
-  size_ = size;
+void AutowareScreenCapturePanel::on_frame(const cv::Mat & frame)
+{
+  size_ = frame.size();
 
   if (is_buffering_) {
-    buffer_.push_back(image.clone());
-    while (buffer_.size() > buffer_size_frames_) {
-      buffer_.pop_front();
-    }
+    buffer_.push(frame, true);
   }
 
   if (is_recording_) {
-    movie_.push_back(image.clone());
+    record(frame);
+  }
+}
+
+void AutowareScreenCapturePanel::release_reader()
+{
+  if (reader_ && !is_buffering_ && !is_recording_) {
+    reader_->release();
+  }
+}
+
+void AutowareScreenCapturePanel::record(const cv::Mat & frame)
+{
+  if (!movie_encoder_) {
+    // about 2 seconds of frames can wait for the encoder
+    movie_encoder_ = std::make_unique<VideoEncoder>(2 * rate_->value());
+    movie_file_name_ = "capture/recording" + ros_time_label_->text().toStdString() + ".mp4";
+    if (!movie_encoder_->open(movie_file_name_, rate_->value(), frame.size())) {
+      RCLCPP_ERROR_STREAM(raw_node_->get_logger(), "FAILED TO OPEN " << movie_file_name_);
+      movie_encoder_.reset();
+      capture_to_mp4_button_ptr_->setText("waiting for capture");
+      capture_to_mp4_button_ptr_->setStyleSheet("background-color: #00FF00;");
+      is_recording_ = false;
+      release_reader();
+      return;
+    }
   }
 
-  cv::waitKey(0);
+  if (!movie_encoder_->push(frame, true)) {
+    RCLCPP_WARN_THROTTLE(
+      raw_node_->get_logger(), *raw_node_->get_clock(), 5000,
+      "the encoder is behind the capture, dropping frames. set a lower frame rate.");
+  }
 }
 
 void AutowareScreenCapturePanel::callback(
   const Capture::Request::SharedPtr req, const Capture::Response::SharedPtr res)
 {
   if (req->action == Capture::Request::SCREEN_SHOT) {
-    res->success = save_screen_shot(req->file_name);
+    const auto file_path = save_screen_shot(req->file_name, req->fast_compression);
+    res->success = file_path.has_value();
+    res->file_path = file_path.value_or("");
     return;
   }
 
@@ -219,7 +265,7 @@ void AutowareScreenCapturePanel::callback(
 
 void AutowareScreenCapturePanel::on_click_screen_capture()
 {
-  save_screen_shot(file_prefix_->text().toStdString());
+  save_screen_shot(file_prefix_->text().toStdString(), false);
 }
 
 void AutowareScreenCapturePanel::on_click_video_capture()
@@ -231,30 +277,38 @@ void AutowareScreenCapturePanel::on_click_video_capture()
   }
 }
 
-bool AutowareScreenCapturePanel::save_screen_shot(const std::string & file_name)
+std::optional<std::string> AutowareScreenCapturePanel::save_screen_shot(
+  const std::string & file_name, const bool fast)
 {
-  const std::string time_text = "capture/" + file_name + ros_time_label_->text().toStdString();
-  getDisplayContext()->getViewManager()->getRenderPanel()->getRenderWindow()->captureScreenShot(
-    time_text + ".png");
+  if (!reader_ || !screenshot_writer_) return std::nullopt;
+
+  // the grabbed screenshots count against the queue before they reach the writer
+  if (grabbed_screen_shot_num_ + screenshot_writer_->size() >= screenshot_writer_->capacity()) {
+    RCLCPP_WARN_THROTTLE(
+      raw_node_->get_logger(), *raw_node_->get_clock(), 5000,
+      "too many screenshots are waiting to be written, dropping them.");
+    return std::nullopt;
+  }
 
-  return true;
+  const std::string file_path =
+    "capture/" + file_name + ros_time_label_->text().toStdString() + ".png";
+
+  ++grabbed_screen_shot_num_;
+  reader_->request_single([this, file_path, fast](const cv::Mat & frame) {
+    --grabbed_screen_shot_num_;
+    cv::Mat image;
+    cv::flip(frame, image, 0);
+    if (!screenshot_writer_->push(file_path, image, fast)) {
+      RCLCPP_ERROR_STREAM(raw_node_->get_logger(), "FAILED TO QUEUE " << file_path);
+    }
+  });
+
+  return file_path;
 }
 
 bool AutowareScreenCapturePanel::start_recording()
 {
-  try {
-    const QWidgetList top_level_widgets = QApplication::topLevelWidgets();
-    for (QWidget * widget : top_level_widgets) {
-      auto * main_window_candidate = qobject_cast<QMainWindow *>(widget);
-      if (main_window_candidate) {
-        main_window_ = main_window_candidate;
-      }
-    }
-  } catch (...) {
-    return false;
-  }
-
-  if (!main_window_) return false;
+  if (!reader_) return false;
 
   RCLCPP_INFO_STREAM(raw_node_->get_logger(), "START RECORDING.");
 
@@ -268,19 +322,7 @@ bool AutowareScreenCapturePanel::start_recording()
 
 bool AutowareScreenCapturePanel::start_buffering()
 {
-  try {
-    const QWidgetList top_level_widgets = QApplication::topLevelWidgets();
-    for (QWidget * widget : top_level_widgets) {
-      auto * main_window_candidate = qobject_cast<QMainWindow *>(widget);
-      if (main_window_candidate) {
-        main_window_ = main_window_candidate;
-      }
-    }
-  } catch (...) {
-    return false;
-  }
-
-  if (!main_window_) return false;
+  if (!reader_) return false;
 
   RCLCPP_INFO_STREAM(raw_node_->get_logger(), "START BUFFERING.");
 
@@ -296,6 +338,7 @@ bool AutowareScreenCapturePanel::stop_buffering()
 
   buffer_.clear();
   is_buffering_ = false;
+  release_reader();
 
   return true;
 }
@@ -306,16 +349,28 @@ bool AutowareScreenCapturePanel::save_movie(const std::string & file_name)
 
   RCLCPP_INFO_STREAM(raw_node_->get_logger(), "SAVE RECORDED MOVIE.");
 
-  save(movie_, file_name);
-
   capture_to_mp4_button_ptr_->setText("waiting for capture");
   capture_to_mp4_button_ptr_->setStyleSheet("background-color: #00FF00;");
 
   is_recording_ = false;
+  release_reader();
+
+  if (!movie_encoder_) return false;
+
+  // the file can be renamed while the encoder still writes to it
+  std::error_code error;
+  std::filesystem::rename(
+    movie_file_name_,
+    "capture/" + file_name + ros_time_label_->text().toStdString() + ".mp4", error);
+  if (error) {
+    RCLCPP_ERROR_STREAM(
+      raw_node_->get_logger(), "FAILED TO RENAME " << movie_file_name_ << ": " << error.message());
+  }
 
-  movie_.clear();
+  movie_encoder_->finish();
+  finishing_encoders_.push_back(std::move(movie_encoder_));
 
-  return true;
+  return !error;
 }
 
 bool AutowareScreenCapturePanel::save_buffer(const std::string & file_name)
@@ -326,29 +381,20 @@ bool AutowareScreenCapturePanel::save_buffer(const std::string & file_name)
 
   RCLCPP_INFO_STREAM(raw_node_->get_logger(), "SAVE BUFFERED MOVIE.");
 
-  save(buffer_, file_name + "_buffered");
-
-  return true;
-}
-
-void AutowareScreenCapturePanel::save(
-  const std::deque<cv::Mat> & images, const std::string & file_name)
-{
-  int fourcc = cv::VideoWriter::fourcc('h', '2', '6', '4');  // mp4
-
-  cv::VideoWriter writer;
-
-  writer.open(
-    "capture/" + file_name + ros_time_label_->text().toStdString() + ".mp4", fourcc, rate_->value(),
-    size_);
-
-  for (const auto & frame : images) {
-    cv::Mat resized_frame;
-    cv::resize(frame, resized_frame, size_);
-    writer.write(resized_frame);
+  // the compressed frames are shared with the encoder, which decodes them in the background
+  auto encoder = std::make_unique<VideoEncoder>(0);
+  if (!encoder->open(
+        "capture/" + file_name + "_buffered" + ros_time_label_->text().toStdString() + ".mp4",
+        rate_->value(), size_)) {
+    return false;
   }
+  for (const auto & frame : buffer_.snapshot()) {
+    encoder->push_encoded(frame);
+  }
+  encoder->finish();
+  finishing_encoders_.push_back(std::move(encoder));
 
-  writer.release();
+  return true;
 }
 
 void AutowareScreenCapturePanel::save(rviz_common::Config config) const
@@ -17,15 +17,12 @@
 
 // Qt
 #include <QApplication>
-#include <QDesktopWidget>
 #include <QDir>
 #include <QFileDialog>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QLineEdit>
-#include <QMainWindow>
 #include <QPushButton>
-#include <QScreen>
 #include <QSpinBox>
 #include <QTimer>
 
@@ -39,12 +36,18 @@
 #include <rviz_rendering/render_window.hpp>
 
 // ros
+#include "compressed_frame_ring.hpp"
+#include "render_window_reader.hpp"
+#include "screenshot_writer.hpp"
+#include "video_encoder.hpp"
+
 #include <tier4_screen_capture_rviz_plugin/srv/capture.hpp>
 
 #include <std_srvs/srv/trigger.hpp>
 
 #include <deque>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -84,7 +87,9 @@ private:
 
   void callback(const Capture::Request::SharedPtr req, const Capture::Response::SharedPtr res);
 
-  bool save_screen_shot(const std::string & file_name);
+  // grabs the next rendered frame and writes it in the background, returns the file path or
+  // nullopt when too many screenshots are waiting to be written
+  std::optional<std::string> save_screen_shot(const std::string & file_name, const bool fast);
 
   bool start_buffering();
 
@@ -98,7 +103,13 @@ private:
 
   void on_timer();
 
-  void save(const std::deque<cv::Mat> & images, const std::string & file_name);
+  // a bottom-up BGR frame read from the render window
+  void on_frame(const cv::Mat & frame);
+
+  void record(const cv::Mat & frame);
+
+  // frees the readback buffers once nothing is captured
+  void release_reader();
 
   void update_buffer_size();
 
@@ -108,13 +119,21 @@ private:
   QLineEdit * file_prefix_;
   QSpinBox * rate_;
   QSpinBox * buffer_size_;
-  QMainWindow * main_window_{nullptr};
+
+  // the frames are read from the render window of the 3D view, not grabbed from the screen
+  std::unique_ptr<RenderWindowReader> reader_;
 
   cv::Size size_;
 
-  std::deque<cv::Mat> movie_;
+  // the recording is encoded while capturing, to a temporary file renamed when it is saved
+  std::unique_ptr<VideoEncoder> movie_encoder_;
+  std::string movie_file_name_;
+
+  // encoders closing their files in the background after being saved
+  std::vector<std::unique_ptr<VideoEncoder>> finishing_encoders_;
 
-  std::deque<cv::Mat> buffer_;
+  // last frames for the retroactive capture, compressed to keep it on for a whole drive
+  CompressedFrameRing buffer_;
 
   // Size of the frame buffer (number of frames to keep in memory)
   // At 10 Hz capture rate, 100 frames correspond to approximately 10 seconds of video
@@ -126,6 +145,10 @@ private:
   rclcpp::Service<Capture>::SharedPtr srv_;
   rclcpp::Node::SharedPtr raw_node_;
   rclcpp::TimerBase::SharedPtr timer_;
+
+  // the screenshots are compressed and written by workers, after the grabbed ones are read
+  std::unique_ptr<ScreenshotWriter> screenshot_writer_;
+  size_t grabbed_screen_shot_num_{0};
 };
 
 }  // namespace rviz_plugins
@@ -0,0 +1,126 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "screenshot_writer.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+namespace
+{
+// zlib levels, the default one of libpng and the fastest one
+constexpr int PNG_COMPRESSION = 6;
+constexpr int FAST_PNG_COMPRESSION = 1;
+
+bool write_png(const std::string & file_name, const cv::Mat & image, const bool fast)
+{
+  std::vector<uchar> png;
+  const std::vector<int> params{
+    cv::IMWRITE_PNG_COMPRESSION, fast ? FAST_PNG_COMPRESSION : PNG_COMPRESSION};
+  if (!cv::imencode(".png", image, png, params)) {
+    return false;
+  }
+
+  const auto temporary_name = file_name + ".tmp";
+  {
+    std::ofstream ofs(temporary_name, std::ios::binary);
+    ofs.write(reinterpret_cast<const char *>(png.data()), static_cast<std::streamsize>(png.size()));
+    if (!ofs) {
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_name, file_name, error);
+  return !error;
+}
+}  // namespace
+
+ScreenshotWriter::ScreenshotWriter(
+  const size_t thread_num, const size_t queue_size, ErrorCallback on_error)
+: on_error_(std::move(on_error)), queue_size_(queue_size)
+{
+  for (size_t i = 0; i < std::max<size_t>(thread_num, 1); ++i) {
+    threads_.emplace_back([this]() { run(); });
+  }
+}
+
+ScreenshotWriter::~ScreenshotWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finishing_ = true;
+  }
+  condition_.notify_all();
+  for (auto & thread : threads_) {
+    thread.join();
+  }
+}
+
+size_t ScreenshotWriter::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size() + writing_num_;
+}
+
+bool ScreenshotWriter::push(const std::string & file_name, const cv::Mat & image, const bool fast)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finishing_ || queue_.size() + writing_num_ >= queue_size_) {
+      return false;
+    }
+    queue_.push_back({file_name, image, fast});
+  }
+  condition_.notify_one();
+  return true;
+}
+
+void ScreenshotWriter::run()
+{
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return !queue_.empty() || finishing_; });
+      // the queued screenshots are written before the workers stop
+      if (queue_.empty()) {
+        break;
+      }
+      job = std::move(queue_.front());
+      queue_.pop_front();
+      ++writing_num_;
+    }
+
+    const bool written = write_png(job.file_name, job.image, job.fast);
+    job.image.release();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --writing_num_;
+    }
+    if (!written && on_error_) {
+      on_error_(job.file_name);
+    }
+  }
+}
+
+}  // namespace rviz_plugins
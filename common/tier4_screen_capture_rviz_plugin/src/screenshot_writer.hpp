@@ -0,0 +1,75 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SCREENSHOT_WRITER_HPP_
+#define SCREENSHOT_WRITER_HPP_
+
+#include <opencv2/opencv.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+// Compresses the screenshots to PNG and writes them on worker threads, so that the caller is not
+// blocked. A file is written under a temporary name and renamed, so that it appears complete.
+class ScreenshotWriter
+{
+public:
+  using ErrorCallback = std::function<void(const std::string & file_name)>;
+
+  // queue_size is the maximum number of screenshots waiting for or being written, @on_error is
+  // called by the workers for the files which cannot be written
+  ScreenshotWriter(const size_t thread_num, const size_t queue_size, ErrorCallback on_error);
+  ~ScreenshotWriter();
+
+  // the number of screenshots waiting for or being written
+  size_t size() const;
+
+  size_t capacity() const { return queue_size_; }
+
+  // queues the BGR @image, which is shared and not modified, favoring the compression speed over
+  // the file size if @fast, returns false and drops it when the queue is full
+  bool push(const std::string & file_name, const cv::Mat & image, const bool fast);
+
+private:
+  void run();
+
+  struct Job
+  {
+    std::string file_name;
+    cv::Mat image;
+    bool fast;
+  };
+
+  std::vector<std::thread> threads_;
+  ErrorCallback on_error_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Job> queue_;
+  size_t queue_size_;
+  size_t writing_num_{0};
+  bool finishing_{false};
+};
+
+}  // namespace rviz_plugins
+
+#endif  // SCREENSHOT_WRITER_HPP_
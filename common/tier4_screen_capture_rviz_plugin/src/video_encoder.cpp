@@ -0,0 +1,159 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "video_encoder.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+VideoEncoder::VideoEncoder(const size_t pool_size) : pool_size_(pool_size)
+{
+}
+
+VideoEncoder::~VideoEncoder()
+{
+  finish();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool VideoEncoder::open(const std::string & file_name, const double fps, const cv::Size & size)
+{
+  const int fourcc = cv::VideoWriter::fourcc('h', '2', '6', '4');  // mp4
+
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR > 5) || \
+  (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 2)
+  // VAAPI, NVENC, etc. through FFmpeg or GStreamer, which falls back to software otherwise
+  writer_.open(
+    file_name, cv::CAP_ANY, fourcc, fps, size,
+    {cv::VIDEOWRITER_PROP_HW_ACCELERATION, cv::VIDEO_ACCELERATION_ANY});
+#endif
+  if (!writer_.isOpened()) {
+    writer_.open(file_name, fourcc, fps, size);
+  }
+  if (!writer_.isOpened()) {
+    return false;
+  }
+
+  size_ = size;
+  thread_ = std::thread([this]() { run(); });
+  return true;
+}
+
+bool VideoEncoder::push(const cv::Mat & frame, const bool flip_vertically)
+{
+  cv::Mat buffer;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finishing_) {
+      return false;
+    }
+    if (!free_buffers_.empty()) {
+      buffer = std::move(free_buffers_.back());
+      free_buffers_.pop_back();
+    } else if (buffer_num_ < pool_size_) {
+      ++buffer_num_;
+    } else {
+      return false;
+    }
+  }
+
+  // reuses the memory of the buffer when the frame size does not change
+  if (flip_vertically) {
+    cv::flip(frame, buffer, 0);
+  } else {
+    frame.copyTo(buffer);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back({std::move(buffer), nullptr, true});
+  }
+  condition_.notify_one();
+  return true;
+}
+
+void VideoEncoder::push_encoded(const std::shared_ptr<const std::vector<uchar>> & encoded_frame)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finishing_) {
+      return;
+    }
+    queue_.push_back({cv::Mat(), encoded_frame, false});
+  }
+  condition_.notify_one();
+}
+
+void VideoEncoder::finish()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finishing_ = true;
+  }
+  condition_.notify_one();
+}
+
+void VideoEncoder::run()
+{
+  cv::Mat bgr_frame;
+  cv::Mat resized_frame;
+  while (true) {
+    Frame item;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return !queue_.empty() || finishing_; });
+      if (queue_.empty()) {
+        break;
+      }
+      item = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    if (item.encoded_image) {
+      item.image = cv::imdecode(*item.encoded_image, cv::IMREAD_COLOR);
+      item.encoded_image.reset();
+    }
+    if (item.image.empty()) {
+      continue;
+    }
+
+    const cv::Mat * frame = &item.image;
+    if (frame->channels() == 4) {
+      cv::cvtColor(*frame, bgr_frame, cv::COLOR_BGRA2BGR);
+      frame = &bgr_frame;
+    }
+    // the window may have been resized since the file was opened
+    if (frame->size() != size_) {
+      cv::resize(*frame, resized_frame, size_);
+      frame = &resized_frame;
+    }
+    writer_.write(*frame);
+
+    if (item.pooled) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_buffers_.push_back(std::move(item.image));
+    }
+  }
+
+  writer_.release();
+  finished_ = true;
+}
+
+}  // namespace rviz_plugins
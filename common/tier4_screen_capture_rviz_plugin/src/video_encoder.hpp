@@ -0,0 +1,84 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VIDEO_ENCODER_HPP_
+#define VIDEO_ENCODER_HPP_
+
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+// Encodes frames to a movie file on a background thread, so that the caller is not blocked.
+class VideoEncoder
+{
+public:
+  // pool_size is the maximum number of copied frames waiting for the encoder
+  explicit VideoEncoder(const size_t pool_size);
+  ~VideoEncoder();
+
+  // opens the file, preferring a hardware encoder when the backend has one, and starts encoding
+  bool open(const std::string & file_name, const double fps, const cv::Size & size);
+
+  // copies the BGR or BGRA frame into a pooled buffer and queues it, flipping a bottom-up frame
+  // in the same copy, returns false and drops the frame when all the buffers are waiting for the
+  // encoder
+  bool push(const cv::Mat & frame, const bool flip_vertically = false);
+
+  // queues a compressed frame, which is decoded by the encoding thread
+  void push_encoded(const std::shared_ptr<const std::vector<uchar>> & encoded_frame);
+
+  // stops accepting frames, the file is closed once the queued frames are encoded
+  void finish();
+
+  bool is_finished() const { return finished_; }
+
+private:
+  void run();
+
+  cv::VideoWriter writer_;
+  cv::Size size_;
+  std::thread thread_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  struct Frame
+  {
+    cv::Mat image;
+    std::shared_ptr<const std::vector<uchar>> encoded_image;
+    // whether the image is a pooled buffer to return after encoding
+    bool pooled;
+  };
+
+  std::deque<Frame> queue_;
+  std::vector<cv::Mat> free_buffers_;
+  size_t pool_size_;
+  size_t buffer_num_{0};
+  bool finishing_{false};
+  std::atomic<bool> finished_{false};
+};
+
+}  // namespace rviz_plugins
+
+#endif  // VIDEO_ENCODER_HPP_
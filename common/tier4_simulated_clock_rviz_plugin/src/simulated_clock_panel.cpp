@@ -16,6 +16,7 @@
 
 #include "simulated_clock_panel.hpp"
 
+#include <qt5/QtCore/QTimer>
 #include <qt5/QtWidgets/QGridLayout>
 #include <qt5/QtWidgets/QHBoxLayout>
 #include <qt5/QtWidgets/QLabel>
@@ -23,8 +24,10 @@
 #include <rclcpp/duration.hpp>
 #include <rviz_common/display_context.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <string>
+#include <utility>
 
 namespace rviz_plugins
 {
@@ -53,6 +56,7 @@ SimulatedClockPanel::SimulatedClockPanel(QWidget * parent) : rviz_common::Panel(
   step_time_input_->setValue(1);
   step_unit_combo_ = new QComboBox();
   step_unit_combo_->addItems({"s", "ms", "µs", "ns"});
+  statistics_label_ = new QLabel("Period: INIT");
 
   auto * layout = new QGridLayout(this);
   auto * step_layout = new QHBoxLayout();
@@ -71,11 +75,29 @@ SimulatedClockPanel::SimulatedClockPanel(QWidget * parent) : rviz_common::Panel(
   step_layout->addWidget(step_unit_combo_);
   layout->addWidget(clock_box, 0, 1, 1, 2);
   layout->addWidget(step_box, 1, 1, 1, 2);
+  layout->addWidget(statistics_label_, 2, 0, 1, 3);
   layout->setContentsMargins(0, 0, 20, 0);
-  prev_published_time_ = std::chrono::system_clock::now();
+
+  publishing_rate_ = publishing_rate_input_->value();
+  clock_speed_ = clock_speed_input_->value();
 
   connect(publishing_rate_input_, SIGNAL(valueChanged(int)), this, SLOT(onRateChanged(int)));
+  connect(clock_speed_input_, SIGNAL(valueChanged(double)), this, SLOT(onSpeedChanged(double)));
+  connect(pause_button_, SIGNAL(toggled(bool)), this, SLOT(onPauseToggled(bool)));
   connect(step_button_, SIGNAL(clicked()), this, SLOT(onStepClicked()));
+
+  // only for the statistics, as the clock is published by the clock thread
+  auto * statistics_timer = new QTimer(this);
+  connect(statistics_timer, SIGNAL(timeout()), this, SLOT(onStatisticsTimer()));
+  statistics_timer->start(500);
+}
+
+SimulatedClockPanel::~SimulatedClockPanel()
+{
+  is_clock_thread_running_ = false;
+  if (clock_thread_.joinable()) {
+    clock_thread_.join();
+  }
 }
 
 void SimulatedClockPanel::onInitialize()
@@ -83,14 +105,24 @@ void SimulatedClockPanel::onInitialize()
   raw_node_ = this->getDisplayContext()->getRosNodeAbstraction().lock()->get_raw_node();
 
   clock_pub_ = raw_node_->create_publisher<rosgraph_msgs::msg::Clock>("/clock", rclcpp::QoS(1));
-  createWallTimer();
+
+  is_clock_thread_running_ = true;
+  clock_thread_ = std::thread(&SimulatedClockPanel::runClockLoop, this);
 }
 
 void SimulatedClockPanel::onRateChanged(int new_rate)
 {
-  (void)new_rate;
-  pub_timer_->cancel();
-  createWallTimer();
+  publishing_rate_ = new_rate;
+}
+
+void SimulatedClockPanel::onSpeedChanged(double new_speed)
+{
+  clock_speed_ = new_speed;
+}
+
+void SimulatedClockPanel::onPauseToggled(bool is_paused)
+{
+  is_paused_ = is_paused;
 }
 
 void SimulatedClockPanel::onStepClicked()
@@ -110,40 +142,94 @@ void SimulatedClockPanel::onStepClicked()
   } else if (unit == "ns") {
     step_duration_ns += duration_cast<nanoseconds>(nanoseconds(step_time));
   }
-  addTimeToClock(step_duration_ns);
+  pending_step_ns_ += step_duration_ns.count();
 }
 
-void SimulatedClockPanel::createWallTimer()
+void SimulatedClockPanel::onStatisticsTimer()
 {
-  // convert rate from Hz to milliseconds
-  const auto period =
-    std::chrono::milliseconds(static_cast<int64_t>(1e3 / publishing_rate_input_->value()));
-  pub_timer_ = raw_node_->create_wall_timer(period, [&]() { onTimer(); });
+  const QString text = QString("Period: %1 [ms] (max: %2 [ms]), Delay: max %3 [ms]")
+                         .arg(period_mean_.load() * 1e3, 0, 'f', 3)
+                         .arg(period_max_.load() * 1e3, 0, 'f', 3)
+                         .arg(wake_up_delay_max_.load() * 1e3, 0, 'f', 3);
+  statistics_label_->setText(text);
 }
 
-void SimulatedClockPanel::onTimer()
+void SimulatedClockPanel::runClockLoop()
 {
-  if (!pause_button_->isChecked()) {
-    const auto duration_since_prev_clock = std::chrono::system_clock::now() - prev_published_time_;
-    const auto speed_adjusted_duration = duration_since_prev_clock * clock_speed_input_->value();
-    addTimeToClock(std::chrono::duration_cast<std::chrono::nanoseconds>(speed_adjusted_duration));
+  using std::chrono::steady_clock;
+
+  // the clock advances by the elapsed time of the steady clock, so that it does not drift however
+  // late each wake up is, and the next wake up is scheduled from the last one
+  auto prev_time = steady_clock::now();
+  auto next_time = prev_time;
+  int prev_rate = 0;
+  int64_t sim_time_ns = 0;
+  // the fraction of a nanosecond scaled by the speed, not to be lost every period
+  double sim_time_fraction_ns = 0.0;
+  steady_clock::time_point statistics_begin_time = prev_time;
+  double period_sum = 0.0;
+  double period_max = 0.0;
+  double delay_max = 0.0;
+  size_t period_num = 0;
+
+  while (is_clock_thread_running_) {
+    const int rate = std::max(publishing_rate_.load(), 1);
+    const auto period = std::chrono::duration_cast<steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / rate));
+    if (rate != prev_rate) {
+      next_time = steady_clock::now();
+      prev_rate = rate;
+    }
+    next_time += period;
+    std::this_thread::sleep_until(next_time);
+    const auto now = steady_clock::now();
+    const double delay = std::chrono::duration<double>(now - next_time).count();
+    // skips the periods missed by a long stall, instead of publishing them in a burst
+    if (now - next_time > period) {
+      next_time = now;
+    }
+
+    const auto elapsed = now - prev_time;
+    prev_time = now;
+    if (!is_paused_) {
+      sim_time_fraction_ns +=
+        std::chrono::duration<double, std::nano>(elapsed).count() * clock_speed_.load();
+      const auto advance_ns = static_cast<int64_t>(sim_time_fraction_ns);
+      sim_time_ns += advance_ns;
+      sim_time_fraction_ns -= static_cast<double>(advance_ns);
+    }
+    sim_time_ns += pending_step_ns_.exchange(0);
+    clock_msg_.clock.sec = static_cast<int32_t>(sim_time_ns / 1000000000);
+    clock_msg_.clock.nanosec = static_cast<uint32_t>(sim_time_ns % 1000000000);
+    publishClock();
+
+    const double elapsed_sec = std::chrono::duration<double>(elapsed).count();
+    period_sum += elapsed_sec;
+    period_max = std::max(period_max, elapsed_sec);
+    delay_max = std::max(delay_max, delay);
+    ++period_num;
+    if (now - statistics_begin_time >= std::chrono::seconds(1)) {
+      period_mean_ = period_sum / static_cast<double>(period_num);
+      period_max_ = period_max;
+      wake_up_delay_max_ = delay_max;
+      statistics_begin_time = now;
+      period_sum = 0.0;
+      period_max = 0.0;
+      delay_max = 0.0;
+      period_num = 0;
+    }
   }
-  clock_pub_->publish(clock_msg_);
-  prev_published_time_ = std::chrono::system_clock::now();
 }
 
-void SimulatedClockPanel::addTimeToClock(std::chrono::nanoseconds time_to_add_ns)
+void SimulatedClockPanel::publishClock()
 {
-  constexpr auto one_sec = std::chrono::seconds(1);
-  constexpr auto one_sec_ns = std::chrono::nanoseconds(one_sec);
-  while (time_to_add_ns >= one_sec) {
-    time_to_add_ns -= one_sec;
-    clock_msg_.clock.sec += 1;
-  }
-  clock_msg_.clock.nanosec += time_to_add_ns.count();
-  if (clock_msg_.clock.nanosec >= one_sec_ns.count()) {
-    clock_msg_.clock.sec += 1;
-    clock_msg_.clock.nanosec = clock_msg_.clock.nanosec - one_sec_ns.count();
+  // the clock is a fixed size message, which is loaned without an allocation if possible
+  if (clock_pub_->can_loan_messages()) {
+    auto loaned_msg = clock_pub_->borrow_loaned_message();
+    loaned_msg.get() = clock_msg_;
+    clock_pub_->publish(std::move(loaned_msg));
+  } else {
+    clock_pub_->publish(clock_msg_);
   }
 }
 
@@ -19,6 +19,7 @@
 
 #include <qt5/QtWidgets/QComboBox>
 #include <qt5/QtWidgets/QDoubleSpinBox>
+#include <qt5/QtWidgets/QLabel>
 #include <qt5/QtWidgets/QPushButton>
 #include <qt5/QtWidgets/QSpinBox>
 #include <rclcpp/rclcpp.hpp>
@@ -27,7 +28,11 @@
 
 #include <rosgraph_msgs/msg/clock.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <thread>
 
 namespace rviz_plugins
 {
@@ -37,26 +42,43 @@ class SimulatedClockPanel : public rviz_common::Panel
 
 public:
   explicit SimulatedClockPanel(QWidget * parent = nullptr);
+  ~SimulatedClockPanel() override;
   void onInitialize() override;
 
 protected Q_SLOTS:
   /// @brief callback for when the publishing rate is changed
   void onRateChanged(int new_rate);
+  /// @brief callback for when the clock speed is changed
+  void onSpeedChanged(double new_speed);
+  /// @brief callback for when the pause button is toggled
+  void onPauseToggled(bool is_paused);
   /// @brief callback for when the step button is clicked
   void onStepClicked();
+  /// @brief shows the statistics of the clock thread
+  void onStatisticsTimer();
 
 protected:
-  /// @brief creates ROS wall timer to periodically call onTimer()
-  void createWallTimer();
-  void onTimer();
-  /// @brief add some time to the clock
-  /// @input ns time to add in nanoseconds
-  void addTimeToClock(std::chrono::nanoseconds ns);
+  /// @brief advances and publishes the clock on a steady schedule, until the panel is destroyed
+  void runClockLoop();
+  /// @brief publishes the clock by a loaned message if the middleware supports it
+  void publishClock();
 
   // ROS
   rclcpp::Node::SharedPtr raw_node_;
   rclcpp::Publisher<rosgraph_msgs::msg::Clock>::SharedPtr clock_pub_;
-  rclcpp::TimerBase::SharedPtr pub_timer_;
+
+  // the clock is published by a thread of its own, not to be delayed by the rendering of rviz
+  std::thread clock_thread_;
+  std::atomic<bool> is_clock_thread_running_{false};
+  // set by the panel and read by the clock thread
+  std::atomic<int> publishing_rate_{100};
+  std::atomic<double> clock_speed_{1.0};
+  std::atomic<bool> is_paused_{false};
+  std::atomic<int64_t> pending_step_ns_{0};
+  // statistics of the last second, set by the clock thread and shown by the panel
+  std::atomic<double> period_mean_{0.0};
+  std::atomic<double> period_max_{0.0};
+  std::atomic<double> wake_up_delay_max_{0.0};
 
   // GUI
   QPushButton * pause_button_;
@@ -65,9 +87,9 @@ protected:
   QDoubleSpinBox * clock_speed_input_;
   QSpinBox * step_time_input_;
   QComboBox * step_unit_combo_;
+  QLabel * statistics_label_;
 
-  // Clocks
-  std::chrono::time_point<std::chrono::system_clock> prev_published_time_;
+  // Clocks, only used by the clock thread
   rosgraph_msgs::msg::Clock clock_msg_;
 };
 
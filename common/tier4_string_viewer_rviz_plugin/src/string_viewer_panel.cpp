@@ -14,10 +14,15 @@
 
 #include "string_viewer_panel.hpp"
 
+#include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <rclcpp/rclcpp.hpp>
 
+#include <chrono>
 #include <ctime>
+#include <functional>
+#include <string>
+#include <utility>
 
 namespace tier4_string_viewer_rviz_plugin
 {
@@ -26,10 +31,24 @@ StringViewerPanel::StringViewerPanel(QWidget * parent) : rviz_common::Panel(pare
 {
   auto * layout = new QVBoxLayout(this);
 
-  topic_list_ = new QComboBox();
-  layout->addWidget(topic_list_);
+  auto * topic_layout = new QHBoxLayout;
+  {
+    topic_list_ = new QComboBox();
+    topic_layout->addWidget(topic_list_, 1);
+
+    // verbose debug strings may be published much faster than they can be read
+    max_rate_ = new QSpinBox();
+    max_rate_->setRange(1, 60);
+    max_rate_->setValue(10);
+    topic_layout->addWidget(max_rate_);
+    topic_layout->addWidget(new QLabel(" [Hz]"));
+  }
+  layout->addLayout(topic_layout);
 
+  // the plain text skips the rich text detection, and the layout is kept while it is unchanged
   contents_ = new QLabel;
+  contents_->setTextFormat(Qt::PlainText);
+  contents_->setWordWrap(true);
   layout->addWidget(contents_);
 
   setLayout(layout);
@@ -37,6 +56,7 @@ StringViewerPanel::StringViewerPanel(QWidget * parent) : rviz_common::Panel(pare
   connect(
     topic_list_, SIGNAL(currentIndexChanged(const QString &)), this,
     SLOT(on_topic_name(const QString &)));
+  connect(max_rate_, SIGNAL(valueChanged(const int)), this, SLOT(on_max_rate(const int)));
 }
 
 void StringViewerPanel::onInitialize()
@@ -45,6 +65,22 @@ void StringViewerPanel::onInitialize()
 
   using namespace std::literals::chrono_literals;
   timer_ = raw_node_->create_wall_timer(1000ms, [&]() { on_timer(); });
+
+  create_render_timer();
+}
+
+void StringViewerPanel::create_render_timer()
+{
+  const auto period = std::chrono::milliseconds(static_cast<int64_t>(1e3 / max_rate_->value()));
+  render_timer_ = raw_node_->create_wall_timer(period, [&]() { on_render(); });
+}
+
+void StringViewerPanel::on_max_rate([[maybe_unused]] const int rate)
+{
+  if (!raw_node_) return;
+
+  render_timer_->cancel();
+  create_render_timer();
 }
 
 void StringViewerPanel::on_topic_name(const QString & topic)
@@ -52,6 +88,8 @@ void StringViewerPanel::on_topic_name(const QString & topic)
   if (topic.isEmpty()) return;
 
   contents_->clear();
+  latest_msg_.reset();
+  shown_hash_.reset();
   sub_string_.reset();
   sub_string_ = raw_node_->create_subscription<StringStamped>(
     topic.toStdString(), rclcpp::QoS{1},
@@ -60,8 +98,19 @@ void StringViewerPanel::on_topic_name(const QString & topic)
 
 void StringViewerPanel::on_string(const StringStamped::ConstSharedPtr msg)
 {
-  contents_->setText(msg->data.c_str());
-  contents_->setWordWrap(true);
+  latest_msg_ = msg;
+}
+
+void StringViewerPanel::on_render()
+{
+  if (!latest_msg_) return;
+
+  const auto msg = std::exchange(latest_msg_, nullptr);
+  const auto hash = std::hash<std::string>{}(msg->data);
+  if (shown_hash_ == hash) return;
+
+  contents_->setText(QString::fromStdString(msg->data));
+  shown_hash_ = hash;
 }
 
 void StringViewerPanel::on_timer()
@@ -102,12 +151,18 @@ void StringViewerPanel::save(rviz_common::Config config) const
 {
   Panel::save(config);
   config.mapSetValue("topic", topic_list_->currentText());
+  config.mapSetValue("max_rate", max_rate_->value());
 }
 
 void StringViewerPanel::load(const rviz_common::Config & config)
 {
   Panel::load(config);
   config.mapGetString("topic", &default_topic_);
+
+  int max_rate = 0;
+  if (config.mapGetInt("max_rate", &max_rate)) {
+    max_rate_->setValue(max_rate);
+  }
 }
 }  // namespace tier4_string_viewer_rviz_plugin
 
@@ -17,6 +17,7 @@
 
 #include <QComboBox>
 #include <QLabel>
+#include <QSpinBox>
 #include <rviz_common/display_context.hpp>
 #include <rviz_common/panel.hpp>
 #include <rviz_common/ros_integration/ros_node_abstraction_iface.hpp>
@@ -24,6 +25,9 @@
 
 #include <autoware_internal_debug_msgs/msg/string_stamped.hpp>
 
+#include <cstddef>
+#include <optional>
+
 namespace tier4_string_viewer_rviz_plugin
 {
 
@@ -47,21 +51,38 @@ public:
 private Q_SLOTS:
   void on_topic_name(const QString & topic);
 
+  void on_max_rate(const int rate);
+
 private:
   void on_string(const StringStamped::ConstSharedPtr msg);
 
   void on_timer();
 
+  // show the latest string, at most at the max rate
+  void on_render();
+
+  void create_render_timer();
+
   QLabel * contents_;
 
   QComboBox * topic_list_;
 
+  QSpinBox * max_rate_;
+
   QString default_topic_;
 
   rclcpp::Node::SharedPtr raw_node_;
 
   rclcpp::TimerBase::SharedPtr timer_;
 
+  rclcpp::TimerBase::SharedPtr render_timer_;
+
+  // the strings received since the last render are coalesced into the latest one
+  StringStamped::ConstSharedPtr latest_msg_;
+
+  // hash of the shown string, so that an unchanged one is not laid out again
+  std::optional<size_t> shown_hash_;
+
   rclcpp::Subscription<StringStamped>::SharedPtr sub_string_;
 
   size_t topic_num_{0L};
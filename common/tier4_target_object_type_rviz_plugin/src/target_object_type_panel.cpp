@@ -19,14 +19,28 @@
 #include <pluginlib/class_list_macros.hpp>
 #include <rclcpp/parameter_client.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <rviz_common/display_context.hpp>
+#include <rviz_common/ros_integration/ros_node_abstraction_iface.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 
-TargetObjectTypePanel::TargetObjectTypePanel(QWidget * parent) : rviz_common::Panel(parent)
+namespace
 {
-  node_ = std::make_shared<rclcpp::Node>("matrix_display_node");
+// a node which is down does not block the others, and is requested again on reload
+constexpr auto PARAMETER_TIMEOUT = std::chrono::seconds(2);
+
+// green base
+const QColor color_in_use("#afff70");
+const QColor color_no_use("#44642b");
+const QColor color_undefined("#9e9e9e");
+}  // namespace
 
+TargetObjectTypePanel::TargetObjectTypePanel(QWidget * parent) : rviz_common::Panel(parent)
+{
   setParameters();
 
   matrix_widget_ = new QTableWidget(modules_.size(), targets_.size(), this);
@@ -39,8 +53,6 @@ TargetObjectTypePanel::TargetObjectTypePanel(QWidget * parent) : rviz_common::Pa
       j, new QTableWidgetItem(QString::fromStdString(targets_[j])));
   }
 
-  updateMatrix();
-
   reload_button_ = new QPushButton("Reload", this);
   connect(
     reload_button_, &QPushButton::clicked, this, &TargetObjectTypePanel::onReloadButtonClicked);
@@ -51,6 +63,22 @@ TargetObjectTypePanel::TargetObjectTypePanel(QWidget * parent) : rviz_common::Pa
   setLayout(layout);
 }
 
+void TargetObjectTypePanel::onInitialize()
+{
+  // the node of rviz is spun on the GUI thread, so the responses may fill the table directly
+  node_ = getDisplayContext()->getRosNodeAbstraction().lock()->get_raw_node();
+
+  setRequests();
+
+  parameter_event_sub_ = node_->create_subscription<rcl_interfaces::msg::ParameterEvent>(
+    "/parameter_events", rclcpp::ParameterEventsQoS(),
+    [this](const rcl_interfaces::msg::ParameterEvent::ConstSharedPtr msg) {
+      onParameterEvent(msg);
+    });
+
+  updateMatrix();
+}
+
 void TargetObjectTypePanel::onReloadButtonClicked()
 {
   RCLCPP_INFO(node_->get_logger(), "Reload button clicked. Update parameter data.");
@@ -245,25 +273,8 @@ void TargetObjectTypePanel::setParameters()
   }
 }
 
-void TargetObjectTypePanel::updateMatrix()
+void TargetObjectTypePanel::setRequests()
 {
-  // blue base
-  // const QColor color_in_use("#6eb6cc");
-  // const QColor color_no_use("#1d3e48");
-  // const QColor color_undefined("#9e9e9e");
-
-  // green base
-  const QColor color_in_use("#afff70");
-  const QColor color_no_use("#44642b");
-  const QColor color_undefined("#9e9e9e");
-
-  const auto set_undefined = [&](const auto i, const auto j) {
-    QTableWidgetItem * item = new QTableWidgetItem("N/A");
-    item->setForeground(QBrush(Qt::black));  // set the text color to black
-    item->setBackground(color_undefined);
-    matrix_widget_->setItem(i, j, item);
-  };
-
   for (size_t i = 0; i < modules_.size(); i++) {
     const auto & module = modules_[i];
 
@@ -274,16 +285,7 @@ void TargetObjectTypePanel::updateMatrix()
     }
 
     const auto & module_params = param_names_.at(module);
-    auto parameters_client =
-      std::make_shared<rclcpp::SyncParametersClient>(node_, module_params.node);
-    if (!parameters_client->wait_for_service(std::chrono::microseconds(500))) {
-      RCLCPP_WARN_STREAM(
-        node_->get_logger(), "Failed to find parameter service for node: " << module_params.node);
-      for (size_t j = 0; j < targets_.size(); j++) {
-        set_undefined(i, j);
-      }
-      continue;
-    }
+    auto & node_parameters = node_parameters_[module_params.node];
 
     for (size_t j = 0; j < targets_.size(); j++) {
       const auto & target = targets_[j];
@@ -295,25 +297,132 @@ void TargetObjectTypePanel::updateMatrix()
         continue;
       }
 
-      std::string param_name =
-        (module_params.ns.empty() ? "" : module_params.ns + ".") + module_params.name.at(target);
-      auto parameter_result = parameters_client->get_parameters({param_name});
-
-      if (!parameter_result.empty()) {
-        bool value = parameter_result[0].as_bool();
-        QTableWidgetItem * item = new QTableWidgetItem(value ? "O" : "X");
-        item->setForeground(QBrush(value ? Qt::black : Qt::black));  // set the text color to black
-        item->setBackground(QBrush(value ? color_in_use : color_no_use));
-        matrix_widget_->setItem(i, j, item);
-      } else {
-        RCLCPP_WARN_STREAM(
-          node_->get_logger(),
-          "Failed to get parameter " << module_params.node << " " << param_name);
+      node_parameters.cells.emplace_back(i, j);
+      node_parameters.names.push_back(
+        (module_params.ns.empty() ? "" : module_params.ns + ".") + module_params.name.at(target));
+    }
+  }
+}
+
+void TargetObjectTypePanel::updateMatrix()
+{
+  if (!node_) return;
+
+  size_t request_num = 0;
+  for (const auto & [node_name, node_parameters] : node_parameters_) {
+    if (node_parameters.up_to_date || node_parameters.pending) continue;
+    requestParameters(node_name);
+    request_num++;
+  }
+
+  if (request_num == 0) {
+    RCLCPP_INFO(node_->get_logger(), "No parameter changed since the last update.");
+  }
+}
+
+void TargetObjectTypePanel::requestParameters(const std::string & node_name)
+{
+  auto & node_parameters = node_parameters_.at(node_name);
+
+  // a client whose request timed out is replaced, so that its pending request is dropped
+  if (!node_parameters.client) {
+    node_parameters.client = std::make_shared<rclcpp::AsyncParametersClient>(node_, node_name);
+  }
+
+  for (const auto & [i, j] : node_parameters.cells) {
+    setCell(i, j, "...", color_undefined);
+  }
+
+  const auto request_id = ++node_parameters.request_id;
+  node_parameters.pending = true;
 
-        set_undefined(i, j);
+  node_parameters.client->get_parameters(
+    node_parameters.names,
+    [this, node_name, request_id](std::shared_future<std::vector<rclcpp::Parameter>> future) {
+      try {
+        onParameters(node_name, request_id, future.get());
+      } catch (const std::exception & e) {
+        RCLCPP_WARN_STREAM(
+          node_->get_logger(), "Failed to get parameters of " << node_name << ": " << e.what());
+        onParameters(node_name, request_id, {});
       }
+    });
+
+  node_parameters.timeout_timer = node_->create_wall_timer(
+    PARAMETER_TIMEOUT, [this, node_name, request_id]() { onTimeout(node_name, request_id); });
+}
+
+void TargetObjectTypePanel::onParameters(
+  const std::string & node_name, const size_t request_id,
+  const std::vector<rclcpp::Parameter> & parameters)
+{
+  auto & node_parameters = node_parameters_.at(node_name);
+  if (request_id != node_parameters.request_id || !node_parameters.pending) return;
+
+  node_parameters.timeout_timer->cancel();
+  node_parameters.pending = false;
+  // a failed request is sent again on reload
+  node_parameters.up_to_date = !parameters.empty();
+
+  for (size_t k = 0; k < node_parameters.cells.size(); k++) {
+    const auto [i, j] = node_parameters.cells.at(k);
+    if (k < parameters.size() && parameters.at(k).get_type() == rclcpp::PARAMETER_BOOL) {
+      const bool value = parameters.at(k).as_bool();
+      setCell(i, j, value ? "O" : "X", value ? color_in_use : color_no_use);
+    } else {
+      RCLCPP_WARN_STREAM(
+        node_->get_logger(),
+        "Failed to get parameter " << node_name << " " << node_parameters.names.at(k));
+      setCell(i, j, "N/A", color_undefined);
     }
   }
 }
 
+void TargetObjectTypePanel::onTimeout(const std::string & node_name, const size_t request_id)
+{
+  auto & node_parameters = node_parameters_.at(node_name);
+  if (request_id != node_parameters.request_id || !node_parameters.pending) return;
+
+  RCLCPP_WARN_STREAM(
+    node_->get_logger(), "Failed to find parameter service for node: " << node_name);
+
+  node_parameters.timeout_timer->cancel();
+  node_parameters.client.reset();
+  node_parameters.pending = false;
+
+  for (const auto & [i, j] : node_parameters.cells) {
+    setCell(i, j, "N/A", color_undefined);
+  }
+}
+
+void TargetObjectTypePanel::onParameterEvent(
+  const rcl_interfaces::msg::ParameterEvent::ConstSharedPtr msg)
+{
+  const auto itr = node_parameters_.find(msg->node);
+  if (itr == node_parameters_.end()) return;
+
+  auto & node_parameters = itr->second;
+  const auto is_shown = [&](const rcl_interfaces::msg::Parameter & parameter) {
+    return std::find(node_parameters.names.begin(), node_parameters.names.end(), parameter.name) !=
+           node_parameters.names.end();
+  };
+
+  // a restarted node declares its parameters again
+  if (
+    std::any_of(msg->new_parameters.begin(), msg->new_parameters.end(), is_shown) ||
+    std::any_of(msg->changed_parameters.begin(), msg->changed_parameters.end(), is_shown) ||
+    std::any_of(msg->deleted_parameters.begin(), msg->deleted_parameters.end(), is_shown)) {
+    node_parameters.up_to_date = false;
+  }
+}
+
+void TargetObjectTypePanel::setCell(
+  const int i, const int j, const std::string & text, const QColor & color)
+{
+  QTableWidgetItem * item = new QTableWidgetItem(QString::fromStdString(text));
+  item->setForeground(QBrush(Qt::black));  // set the text color to black
+  item->setBackground(QBrush(color));
+  matrix_widget_->setItem(i, j, item);
+}
+
 PLUGINLIB_EXPORT_CLASS(TargetObjectTypePanel, rviz_common::Panel)
@@ -15,15 +15,19 @@
 #ifndef TARGET_OBJECT_TYPE_PANEL_HPP_
 #define TARGET_OBJECT_TYPE_PANEL_HPP_
 
+#include <QColor>
 #include <QPushButton>
 #include <QTableWidget>
 #include <QTableWidgetItem>
 #include <rclcpp/rclcpp.hpp>
 #include <rviz_common/panel.hpp>
 
+#include <rcl_interfaces/msg/parameter_event.hpp>
+
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 class TargetObjectTypePanel : public rviz_common::Panel
@@ -33,6 +37,8 @@ class TargetObjectTypePanel : public rviz_common::Panel
 public:
   explicit TargetObjectTypePanel(QWidget * parent = 0);
 
+  void onInitialize() override;
+
 protected:
   QTableWidget * matrix_widget_;
   std::shared_ptr<rclcpp::Node> node_;
@@ -47,14 +53,42 @@ protected:
   };
   std::unordered_map<std::string, ParamNameEnableObject> param_names_;
 
+  // The parameters of the modules of a planning node, fetched in one request. The values are
+  // kept until a parameter event of the node changes one of them.
+  struct NodeParameters
+  {
+    rclcpp::AsyncParametersClient::SharedPtr client;
+    // the cells of the table and the names of their parameters, in the order of the request
+    std::vector<std::pair<int, int>> cells;
+    std::vector<std::string> names;
+    rclcpp::TimerBase::SharedPtr timeout_timer;
+    // the responses of the previous requests are ignored
+    size_t request_id{0};
+    bool pending{false};
+    bool up_to_date{false};
+  };
+  std::unordered_map<std::string, NodeParameters> node_parameters_;
+
 private slots:
   void onReloadButtonClicked();
 
 private:
   QPushButton * reload_button_;
 
+  rclcpp::Subscription<rcl_interfaces::msg::ParameterEvent>::SharedPtr parameter_event_sub_;
+
+  // request the parameters of the nodes which are not up to date, the cells are filled as the
+  // responses arrive
   void updateMatrix();
   void setParameters();
+  void setRequests();
+  void requestParameters(const std::string & node_name);
+  void onParameters(
+    const std::string & node_name, const size_t request_id,
+    const std::vector<rclcpp::Parameter> & parameters);
+  void onTimeout(const std::string & node_name, const size_t request_id);
+  void onParameterEvent(const rcl_interfaces::msg::ParameterEvent::ConstSharedPtr msg);
+  void setCell(const int i, const int j, const std::string & text, const QColor & color);
 };
 
 #endif  // TARGET_OBJECT_TYPE_PANEL_HPP_
@@ -0,0 +1,103 @@
+// Copyright 2024 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VEHICLE_CMD_ANALYZER__TIMING_STATISTICS_HPP_
+#define VEHICLE_CMD_ANALYZER__TIMING_STATISTICS_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/// Timing values published alongside the debug values [s]
+enum class TimingValueType {
+  PERIOD_P50 = 0,
+  PERIOD_P99 = 1,
+  PERIOD_MAX = 2,
+  LATENCY_P50 = 3,
+  LATENCY_P99 = 4,
+  LATENCY_MAX = 5,
+  SIZE  // this is the number of enum elements
+};
+
+/**
+ * @brief get the percentile of the samples by the nearest rank, which reorders the samples
+ * @param [in] samples samples
+ * @param [in] ratio ratio of the percentile in [0, 1]
+ * @return percentile, or NaN without samples
+ */
+inline double calcPercentile(std::vector<double> & samples, const double ratio)
+{
+  if (samples.empty()) {
+    return std::nan("");
+  }
+  const size_t rank = static_cast<size_t>(std::ceil(std::clamp(ratio, 0.0, 1.0) * samples.size()));
+  const auto nth = samples.begin() + (rank == 0 ? 0 : std::min(rank, samples.size()) - 1);
+  std::nth_element(samples.begin(), nth, samples.end());
+  return *nth;
+}
+
+/// Latest samples in a ring of a fixed size, allocated once, with their percentiles
+class TimingStatistics
+{
+public:
+  explicit TimingStatistics(const size_t size) : samples_(std::max<size_t>(size, 1))
+  {
+    sorted_.reserve(samples_.size());
+  }
+
+  void add(const double sample)
+  {
+    samples_.at(next_) = sample;
+    next_ = (next_ + 1) % samples_.size();
+    num_ = std::min(num_ + 1, samples_.size());
+  }
+
+  size_t size() const { return num_; }
+  size_t capacity() const { return samples_.size(); }
+
+  double getPercentile(const double ratio) const
+  {
+    sorted_.assign(samples_.begin(), samples_.begin() + num_);
+    return calcPercentile(sorted_, ratio);
+  }
+
+  double getMax() const
+  {
+    return num_ == 0 ? std::nan("") : *std::max_element(samples_.begin(), samples_.begin() + num_);
+  }
+
+private:
+  std::vector<double> samples_;
+  size_t next_{0};
+  size_t num_{0};
+  // buffer for the selection of the percentiles, which keeps its capacity
+  mutable std::vector<double> sorted_;
+};
+
+/**
+ * @brief get the timing values of the periods and the latencies
+ * @param [in] periods periods between the stamps of the commands
+ * @param [in] latencies delays from the stamps of the commands to their reception
+ * @return timing values in the order of TimingValueType
+ */
+inline std::array<double, static_cast<int>(TimingValueType::SIZE)> getTimingValues(
+  const TimingStatistics & periods, const TimingStatistics & latencies)
+{
+  return {periods.getPercentile(0.5),   periods.getPercentile(0.99),   periods.getMax(),
+          latencies.getPercentile(0.5), latencies.getPercentile(0.99), latencies.getMax()};
+}
+
+#endif  // VEHICLE_CMD_ANALYZER__TIMING_STATISTICS_HPP_
@@ -0,0 +1,59 @@
+// Copyright 2024 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VEHICLE_CMD_ANALYZER__VEHICLE_CMD_ANALYSIS_HPP_
+#define VEHICLE_CMD_ANALYZER__VEHICLE_CMD_ANALYSIS_HPP_
+
+#include "vehicle_cmd_analyzer/debug_values.hpp"
+
+#include "autoware_control_msgs/msg/control.hpp"
+
+#include <array>
+#include <optional>
+#include <utility>
+
+/// Derivatives of the commands, shared by the node and the offline analysis of bags
+class VehicleCmdAnalysis
+{
+public:
+  VehicleCmdAnalysis(const double wheelbase, const double control_rate);
+
+  /**
+   * @brief calculate the debug values of the command at the time
+   * @param [in] time time of the analysis [s], either the time of the timer or the command stamp
+   * @param [in] cmd command
+   * @return debug values
+   */
+  DebugValues update(const double time, const autoware_control_msgs::msg::Control & cmd);
+
+private:
+  double getDt(const double time);
+  std::pair<double, double> differentiateVelocity(
+    const autoware_control_msgs::msg::Control & cmd, const double dt);
+  double differentiateAcceleration(
+    const autoware_control_msgs::msg::Control & cmd, const double dt);
+  double calcLateralAcceleration(const autoware_control_msgs::msg::Control & cmd) const;
+
+  double wheelbase_;
+  double control_rate_;
+
+  // for calculating dt
+  std::optional<double> prev_control_time_;
+
+  std::optional<double> prev_target_vel_;
+  std::array<double, 3> prev_target_d_vel_ = {};
+  std::optional<double> prev_target_acc_;
+};
+
+#endif  // VEHICLE_CMD_ANALYZER__VEHICLE_CMD_ANALYSIS_HPP_
@@ -16,7 +16,10 @@
 #define VEHICLE_CMD_ANALYZER__VEHICLE_CMD_ANALYZER_HPP_
 
 #include "autoware_vehicle_info_utils/vehicle_info_utils.hpp"
+#include "estimator_utils/debug_array_publisher.hpp"
 #include "vehicle_cmd_analyzer/debug_values.hpp"
+#include "vehicle_cmd_analyzer/timing_statistics.hpp"
+#include "vehicle_cmd_analyzer/vehicle_cmd_analysis.hpp"
 
 #include <rclcpp/rclcpp.hpp>
 
@@ -25,6 +28,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <utility>
@@ -32,37 +36,33 @@
 class VehicleCmdAnalyzer : public rclcpp::Node
 {
 private:
+  using Float32MultiArrayStamped = autoware_internal_debug_msgs::msg::Float32MultiArrayStamped;
+
   rclcpp::Subscription<autoware_control_msgs::msg::Control>::SharedPtr sub_vehicle_cmd_;
-  rclcpp::Publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>::SharedPtr
-    pub_debug_;
+  std::unique_ptr<DebugArrayPublisher<Float32MultiArrayStamped>> pub_debug_;
+  std::unique_ptr<DebugArrayPublisher<Float32MultiArrayStamped>> pub_timing_;
   rclcpp::TimerBase::SharedPtr timer_control_;
 
-  std::shared_ptr<autoware_control_msgs::msg::Control> vehicle_cmd_ptr_{nullptr};
+  autoware_control_msgs::msg::Control::ConstSharedPtr vehicle_cmd_ptr_{nullptr};
 
   // timer callback
   double control_rate_;
-  double wheelbase_;
-
-  // for calculating dt
-  std::shared_ptr<rclcpp::Time> prev_control_time_{nullptr};
+  // analyze each command at its stamp instead of the latest command at the timer
+  bool is_message_mode_;
 
-  double prev_target_vel_;
-  std::array<double, 3> prev_target_d_vel_ = {};
-  double prev_target_acc_;
+  VehicleCmdAnalysis analysis_;
 
-  // debug values
-  DebugValues debug_values_;
+  // periods between the stamps of the commands, and delays from the stamps to their reception,
+  // which need no lock as the subscription and the timer are in the same exclusive callback group
+  std::optional<rclcpp::Time> prev_cmd_stamp_;
+  TimingStatistics periods_;
+  TimingStatistics latencies_;
 
-  void callbackVehicleCommand(const autoware_control_msgs::msg::Control::SharedPtr msg);
+  void callbackVehicleCommand(const autoware_control_msgs::msg::Control::ConstSharedPtr msg);
 
   void callbackTimerControl();
 
-  void publishDebugData();
-
-  double getDt();
-  std::pair<double, double> differentiateVelocity(const double dt);
-  double differentiateAcceleration(const double dt);
-  double calcLateralAcceleration() const;
+  void publishDebugData(const rclcpp::Time & time);
 
 public:
   explicit VehicleCmdAnalyzer(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
@@ -0,0 +1,91 @@
+// Copyright 2024 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vehicle_cmd_analyzer/vehicle_cmd_analysis.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+VehicleCmdAnalysis::VehicleCmdAnalysis(const double wheelbase, const double control_rate)
+: wheelbase_(wheelbase), control_rate_(control_rate)
+{
+}
+
+DebugValues VehicleCmdAnalysis::update(
+  const double time, const autoware_control_msgs::msg::Control & cmd)
+{
+  const double dt = getDt(time);
+  const double a_lat = calcLateralAcceleration(cmd);
+  const auto [d_vel, dd_vel] = differentiateVelocity(cmd, dt);
+
+  DebugValues debug_values;
+  debug_values.setValues(DebugValues::TYPE::DT, dt);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_VEL, cmd.longitudinal.velocity);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_D_VEL, d_vel);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_DD_VEL, dd_vel);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_ACC, cmd.longitudinal.acceleration);
+  debug_values.setValues(
+    DebugValues::TYPE::CURRENT_TARGET_D_ACC, differentiateAcceleration(cmd, dt));
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_LATERAL_ACC, a_lat);
+  return debug_values;
+}
+
+double VehicleCmdAnalysis::getDt(const double time)
+{
+  const double dt = prev_control_time_ ? time - *prev_control_time_ : 1.0 / control_rate_;
+  prev_control_time_ = time;
+  const double max_dt = 1.0 / control_rate_ * 2.0;
+  const double min_dt = 1.0 / control_rate_ * 0.5;
+  return std::max(std::min(dt, max_dt), min_dt);
+}
+
+std::pair<double, double> VehicleCmdAnalysis::differentiateVelocity(
+  const autoware_control_msgs::msg::Control & cmd, const double dt)
+{
+  if (!prev_target_vel_) {
+    prev_target_vel_ = cmd.longitudinal.velocity;
+    prev_target_d_vel_.at(2) = 0.0;
+    return {0.0, 0.0};
+  }
+  const double d_vel = (cmd.longitudinal.velocity - *prev_target_vel_) / dt;
+  const double dd_vel = (d_vel - prev_target_d_vel_.at(0)) / 2 / dt;
+  prev_target_vel_ = cmd.longitudinal.velocity;
+  for (int i = 0; i < 2; i++) {
+    prev_target_d_vel_.at(i) = prev_target_d_vel_.at(i + 1);
+  }
+  prev_target_d_vel_.at(2) = d_vel;
+  return {d_vel, dd_vel};
+}
+
+double VehicleCmdAnalysis::differentiateAcceleration(
+  const autoware_control_msgs::msg::Control & cmd, const double dt)
+{
+  if (!prev_target_acc_) {
+    prev_target_acc_ = cmd.longitudinal.acceleration;
+    return 0.0;
+  }
+  const double d_acc = (cmd.longitudinal.acceleration - *prev_target_acc_) / dt;
+  prev_target_acc_ = cmd.longitudinal.acceleration;
+  return d_acc;
+}
+
+double VehicleCmdAnalysis::calcLateralAcceleration(
+  const autoware_control_msgs::msg::Control & cmd) const
+{
+  const double delta = cmd.lateral.steering_tire_angle;
+  const double vel = cmd.longitudinal.velocity;
+  const double a_lat = vel * vel * std::sin(delta) / wheelbase_;
+  return a_lat;
+}
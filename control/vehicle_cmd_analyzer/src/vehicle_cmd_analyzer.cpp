@@ -23,21 +23,31 @@
 #include <utility>
 
 VehicleCmdAnalyzer::VehicleCmdAnalyzer(const rclcpp::NodeOptions & options)
-: Node("vehicle_cmd_analyzer", options)
+: Node("vehicle_cmd_analyzer", options),
+  control_rate_(declare_parameter("control_rate", 30.0)),
+  is_message_mode_(false),
+  analysis_(
+    autoware::vehicle_info_utils::VehicleInfoUtils(*this).getVehicleInfo().wheel_base_m,
+    control_rate_),
+  periods_(static_cast<size_t>(declare_parameter<int>("timing_history_size", 1000))),
+  latencies_(periods_.capacity())
 {
-  control_rate_ = declare_parameter("control_rate", 30.0);
-
-  const auto vehicle_info = autoware::vehicle_info_utils::VehicleInfoUtils(*this).getVehicleInfo();
-  wheelbase_ = vehicle_info.wheel_base_m;
+  const auto mode = declare_parameter<std::string>("mode", "timer");
+  if (mode != "timer" && mode != "message") {
+    RCLCPP_WARN(get_logger(), "unknown mode: %s, use timer", mode.c_str());
+  }
+  is_message_mode_ = mode == "message";
 
   sub_vehicle_cmd_ = this->create_subscription<autoware_control_msgs::msg::Control>(
     "/control/command/control_cmd", rclcpp::QoS(10),
     std::bind(&VehicleCmdAnalyzer::callbackVehicleCommand, this, std::placeholders::_1));
-  pub_debug_ = create_publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>(
-    "~/debug_values", rclcpp::QoS{1});
+  pub_debug_ = std::make_unique<DebugArrayPublisher<Float32MultiArrayStamped>>(
+    this, "~/debug_values", static_cast<size_t>(DebugValues::TYPE::SIZE));
+  pub_timing_ = std::make_unique<DebugArrayPublisher<Float32MultiArrayStamped>>(
+    this, "~/timing_values", static_cast<size_t>(TimingValueType::SIZE));
 
   // Timer
-  {
+  if (!is_message_mode_) {
     auto timer_callback = std::bind(&VehicleCmdAnalyzer::callbackTimerControl, this);
     auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
       std::chrono::duration<double>(1.0 / control_rate_));
@@ -49,9 +59,21 @@ VehicleCmdAnalyzer::VehicleCmdAnalyzer(const rclcpp::NodeOptions & options)
 }
 
 void VehicleCmdAnalyzer::callbackVehicleCommand(
-  const autoware_control_msgs::msg::Control::SharedPtr msg)
+  const autoware_control_msgs::msg::Control::ConstSharedPtr msg)
 {
-  vehicle_cmd_ptr_ = std::make_shared<autoware_control_msgs::msg::Control>(*msg);
+  vehicle_cmd_ptr_ = msg;
+
+  // timing of the control loop, by the stamps of the commands
+  const rclcpp::Time stamp(msg->stamp, this->get_clock()->get_clock_type());
+  if (prev_cmd_stamp_) {
+    periods_.add((stamp - *prev_cmd_stamp_).seconds());
+  }
+  prev_cmd_stamp_ = stamp;
+  latencies_.add((this->now() - stamp).seconds());
+
+  if (is_message_mode_) {
+    publishDebugData(stamp);
+  }
 }
 
 void VehicleCmdAnalyzer::callbackTimerControl()
@@ -62,84 +84,20 @@ void VehicleCmdAnalyzer::callbackTimerControl()
   }
 
   // publish debug data
-  publishDebugData();
+  publishDebugData(this->now());
 }
 
-void VehicleCmdAnalyzer::publishDebugData()
+void VehicleCmdAnalyzer::publishDebugData(const rclcpp::Time & time)
 {
-  const double dt = getDt();
-  const double a_lat = calcLateralAcceleration();
-  const auto [d_vel, dd_vel] = differentiateVelocity(dt);
+  const auto debug_values = analysis_.update(time.seconds(), *vehicle_cmd_ptr_);
 
-  // set debug values
-  debug_values_.setValues(DebugValues::TYPE::DT, dt);
-  debug_values_.setValues(
-    DebugValues::TYPE::CURRENT_TARGET_VEL, vehicle_cmd_ptr_->longitudinal.velocity);
-  debug_values_.setValues(DebugValues::TYPE::CURRENT_TARGET_D_VEL, d_vel);
-  debug_values_.setValues(DebugValues::TYPE::CURRENT_TARGET_DD_VEL, dd_vel);
-  debug_values_.setValues(
-    DebugValues::TYPE::CURRENT_TARGET_ACC, vehicle_cmd_ptr_->longitudinal.acceleration);
-  debug_values_.setValues(DebugValues::TYPE::CURRENT_TARGET_D_ACC, differentiateAcceleration(dt));
-  debug_values_.setValues(DebugValues::TYPE::CURRENT_TARGET_LATERAL_ACC, a_lat);
+  // publish debug values, into the messages allocated at the construction
+  pub_debug_->message().stamp = time;
+  pub_debug_->publish(debug_values.getValues());
 
-  // publish debug values
-  autoware_internal_debug_msgs::msg::Float32MultiArrayStamped debug_msg{};
-  debug_msg.stamp = this->now();
-  for (const auto & v : debug_values_.getValues()) {
-    debug_msg.data.push_back(v);
-  }
-  pub_debug_->publish(debug_msg);
-}
-
-double VehicleCmdAnalyzer::getDt()
-{
-  double dt;
-  if (!prev_control_time_) {
-    dt = 1.0 / control_rate_;
-    prev_control_time_ = std::make_shared<rclcpp::Time>(this->now());
-  } else {
-    dt = (this->now() - *prev_control_time_).seconds();
-    *prev_control_time_ = this->now();
-  }
-  const double max_dt = 1.0 / control_rate_ * 2.0;
-  const double min_dt = 1.0 / control_rate_ * 0.5;
-  return std::max(std::min(dt, max_dt), min_dt);
-}
-
-std::pair<double, double> VehicleCmdAnalyzer::differentiateVelocity(const double dt)
-{
-  if (!prev_target_vel_) {
-    prev_target_vel_ = vehicle_cmd_ptr_->longitudinal.velocity;
-    prev_target_d_vel_.at(2) = 0.0;
-    return {0.0, 0.0};
-  }
-  const double d_vel = (vehicle_cmd_ptr_->longitudinal.velocity - prev_target_vel_) / dt;
-  const double dd_vel = (d_vel - prev_target_d_vel_.at(0)) / 2 / dt;
-  prev_target_vel_ = vehicle_cmd_ptr_->longitudinal.velocity;
-  for (int i = 0; i < 2; i++) {
-    prev_target_d_vel_.at(i) = prev_target_d_vel_.at(i + 1);
-  }
-  prev_target_d_vel_.at(2) = d_vel;
-  return {d_vel, dd_vel};
-}
-
-double VehicleCmdAnalyzer::differentiateAcceleration(const double dt)
-{
-  if (!prev_target_acc_) {
-    prev_target_acc_ = vehicle_cmd_ptr_->longitudinal.acceleration;
-    return 0.0;
-  }
-  const double d_acc = (vehicle_cmd_ptr_->longitudinal.acceleration - prev_target_acc_) / dt;
-  prev_target_acc_ = vehicle_cmd_ptr_->longitudinal.acceleration;
-  return d_acc;
-}
-
-double VehicleCmdAnalyzer::calcLateralAcceleration() const
-{
-  const double delta = vehicle_cmd_ptr_->lateral.steering_tire_angle;
-  const double vel = vehicle_cmd_ptr_->longitudinal.velocity;
-  const double a_lat = vel * vel * std::sin(delta) / wheelbase_;
-  return a_lat;
+  // publish timing values
+  pub_timing_->message().stamp = time;
+  pub_timing_->publish(getTimingValues(periods_, latencies_));
 }
 
 #include "rclcpp_components/register_node_macro.hpp"
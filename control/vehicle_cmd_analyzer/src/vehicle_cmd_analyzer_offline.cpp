@@ -0,0 +1,175 @@
+// Copyright 2024 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Analyzes the commands in bags at their stamps, as the message mode of the node does:
+//   vehicle_cmd_analyzer_offline --wheelbase <m> [--control-rate 30]
+//                                [--topic /control/command/control_cmd] <bag>...
+// The debug values of each command are written to stdout as CSV, and the percentiles of the
+// periods and the latencies, by the recorded time, of each bag and of all the bags to stderr.
+
+#include "vehicle_cmd_analyzer/timing_statistics.hpp"
+#include "vehicle_cmd_analyzer/vehicle_cmd_analysis.hpp"
+
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/time.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+
+#include "autoware_control_msgs/msg/control.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Options
+{
+  std::vector<std::string> bag_uris;
+  std::string topic{"/control/command/control_cmd"};
+  double wheelbase{0.0};
+  double control_rate{30.0};
+};
+
+// all the samples, since the percentiles of a whole log need more than the history of the node
+struct Samples
+{
+  std::vector<double> periods;
+  std::vector<double> latencies;
+
+  void append(const Samples & other)
+  {
+    periods.insert(periods.end(), other.periods.begin(), other.periods.end());
+    latencies.insert(latencies.end(), other.latencies.begin(), other.latencies.end());
+  }
+};
+
+void printUsage()
+{
+  std::fprintf(
+    stderr,
+    "usage: vehicle_cmd_analyzer_offline --wheelbase <m> [--control-rate 30] "
+    "[--topic /control/command/control_cmd] <bag>...\n");
+}
+
+bool parseOptions(const int argc, char ** argv, Options & options)
+{
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--wheelbase" && has_value) {
+      options.wheelbase = std::stod(argv[++i]);
+    } else if (arg == "--control-rate" && has_value) {
+      options.control_rate = std::stod(argv[++i]);
+    } else if (arg == "--topic" && has_value) {
+      options.topic = argv[++i];
+    } else if (arg.rfind("--", 0) == 0) {
+      return false;
+    } else {
+      options.bag_uris.push_back(arg);
+    }
+  }
+  return !options.bag_uris.empty() && options.wheelbase > 0.0 && options.control_rate > 0.0;
+}
+
+void printSummary(const std::string & name, Samples samples)
+{
+  const auto print = [&](const char * type, std::vector<double> & values) {
+    std::fprintf(
+      stderr, "%s %s[s]: num %zu, p50 %.6f, p99 %.6f, max %.6f\n", name.c_str(), type,
+      values.size(), calcPercentile(values, 0.5), calcPercentile(values, 0.99),
+      calcPercentile(values, 1.0));
+  };
+  print("period", samples.periods);
+  print("latency", samples.latencies);
+}
+
+Samples analyzeBag(const std::string & bag_uri, const Options & options)
+{
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = bag_uri;
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::readers::SequentialReader reader;
+  reader.open(storage_options, converter_options);
+
+  rosbag2_storage::StorageFilter filter;
+  filter.topics.push_back(options.topic);
+  reader.set_filter(filter);
+
+  // the derivatives are continued within a bag only
+  VehicleCmdAnalysis analysis(options.wheelbase, options.control_rate);
+  rclcpp::Serialization<autoware_control_msgs::msg::Control> serialization;
+  autoware_control_msgs::msg::Control cmd;
+  std::optional<double> prev_stamp;
+  Samples samples;
+  while (reader.has_next()) {
+    const auto serialized_message = reader.read_next();
+    const rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+    serialization.deserialize_message(&msg, &cmd);
+
+    const double stamp = rclcpp::Time(cmd.stamp).seconds();
+    const double recorded_time = rclcpp::Time(serialized_message->time_stamp).seconds();
+    const double period = prev_stamp ? stamp - *prev_stamp : std::nan("");
+    const double latency = recorded_time - stamp;
+    if (prev_stamp) {
+      samples.periods.push_back(period);
+    }
+    samples.latencies.push_back(latency);
+    prev_stamp = stamp;
+
+    std::printf("%s,%.9f,%.9f,%.9f,%.9f", bag_uri.c_str(), stamp, recorded_time, period, latency);
+    for (const auto & v : analysis.update(stamp, cmd).getValues()) {
+      std::printf(",%.9f", v);
+    }
+    std::printf("\n");
+  }
+  return samples;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  Options options;
+  try {
+    if (!parseOptions(argc, argv, options)) {
+      printUsage();
+      return 1;
+    }
+  } catch (const std::exception &) {
+    printUsage();
+    return 1;
+  }
+
+  std::printf(
+    "bag,stamp,recorded_time,period,latency,dt,target_vel,target_d_vel,target_dd_vel,target_acc,"
+    "target_d_acc,target_lateral_acc\n");
+  Samples total;
+  for (const auto & bag_uri : options.bag_uris) {
+    try {
+      const auto samples = analyzeBag(bag_uri, options);
+      printSummary(bag_uri, samples);
+      total.append(samples);
+    } catch (const std::exception & e) {
+      std::fprintf(stderr, "failed to analyze %s: %s\n", bag_uri.c_str(), e.what());
+    }
+  }
+  if (options.bag_uris.size() > 1) {
+    printSummary("total", total);
+  }
+  return 0;
+}
@@ -112,6 +112,12 @@ def generate_launch_description():
                     name="data_collecting_data_counter",
                     parameters=[common_param_file_path],
                 ),
+                Node(
+                    package="control_data_collecting_tool",
+                    executable="data_collecting_coverage_counter",
+                    name="data_collecting_coverage_counter",
+                    parameters=[common_param_file_path],
+                ),
             ]
         )
 
@@ -155,6 +161,12 @@ def generate_launch_description():
                     name="data_collecting_data_counter",
                     parameters=[common_param_file_path],
                 ),
+                Node(
+                    package="control_data_collecting_tool",
+                    executable="data_collecting_coverage_counter",
+                    name="data_collecting_coverage_counter",
+                    parameters=[common_param_file_path],
+                ),
             ]
         )
 
@@ -27,6 +27,8 @@ import numpy as np
 from numpy import pi
 from rcl_interfaces.msg import ParameterDescriptor
 import rclpy
+from rclpy.qos import DurabilityPolicy
+from rclpy.qos import QoSProfile
 from scipy.spatial.transform import Rotation as R
 from std_msgs.msg import Bool
 from std_msgs.msg import Float32
@@ -183,7 +185,8 @@ class DataCollectingTrajectoryPublisher(DataCollectingBaseNode):
             PolygonStamped,
             "/data_collecting_area",
             self.onDataCollectingArea,
-            1,
+            # the area is latched by the selection tool
+            QoSProfile(depth=1, durability=DurabilityPolicy.TRANSIENT_LOCAL),
         )
         self.sub_data_collecting_area_
         self._data_collecting_area_polygon = None
@@ -300,6 +303,12 @@ class DataCollectingTrajectoryPublisher(DataCollectingBaseNode):
         )
 
     def onDataCollectingArea(self, msg):
+        # re-plan only when the area changes
+        if (
+            self._data_collecting_area_polygon is not None
+            and self._data_collecting_area_polygon.polygon.points == msg.polygon.points
+        ):
+            return
         self._data_collecting_area_polygon = msg
         self.updateNominalTargetTrajectory()
 
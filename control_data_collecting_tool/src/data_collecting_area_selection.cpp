@@ -61,12 +61,14 @@ void DataCollectingAreaSelectionTool::onInitialize()
   nh_ = context_->getRosNodeAbstraction().lock()->get_raw_node();
 
   polygon_pub_ = nh_->create_publisher<geometry_msgs::msg::PolygonStamped>(
-    "/data_collecting_area", rclcpp::QoS(10));
+    "/data_collecting_area", rclcpp::QoS(10).transient_local());
 
+  // shared with the goal pose tool, which subscribes to the same state
   sub_operation_mode_state_ =
-    nh_->create_subscription<autoware_adapi_v1_msgs::msg::OperationModeState>(
-      "/system/operation_mode/state", rclcpp::QoS{1},
-      std::bind(&DataCollectingAreaSelectionTool::onOperationModeState, this, _1));
+    autoware::rviz_subscription_hub::SubscriptionHub::instance()
+      .subscribe<autoware_adapi_v1_msgs::msg::OperationModeState>(
+        nh_, "/system/operation_mode/state", rclcpp::QoS{1},
+        std::bind(&DataCollectingAreaSelectionTool::onOperationModeState, this, _1));
 
   projection_finder_ = std::make_shared<rviz_rendering::ViewportProjectionFinder>();
 
@@ -156,8 +158,13 @@ int DataCollectingAreaSelectionTool::processMouseEvent(rviz_common::ViewportMous
       polygon_msg.polygon.points.push_back(generatePoint(
         tmp_point_projection_on_xy_plane2.second[0], tmp_point_projection_on_xy_plane2.second[1],
         tmp_point_projection_on_xy_plane2.second[2]));
-      if (!control_applying_) {
+      // a click without a drag selects no area
+      const bool is_area_selected = sel_start_x_ != sel_end_x_ && sel_start_y_ != sel_end_y_;
+      if (
+        !control_applying_ && is_area_selected &&
+        (!published_polygon_ || published_polygon_->points != polygon_msg.polygon.points)) {
         polygon_pub_->publish(polygon_msg);
+        published_polygon_ = polygon_msg.polygon;
       }
       selecting_ = false;
     }
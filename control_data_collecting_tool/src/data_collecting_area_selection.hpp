@@ -15,6 +15,7 @@
 #ifndef DATA_COLLECTING_AREA_SELECTION_HPP_
 #define DATA_COLLECTING_AREA_SELECTION_HPP_
 
+#include <autoware/rviz_subscription_hub/subscription_hub.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <rviz_common/interaction/selection_manager.hpp>
 #include <rviz_common/tool.hpp>
@@ -26,6 +27,7 @@
 #include <geometry_msgs/msg/polygon_stamped.hpp>
 
 #include <memory>
+#include <optional>
 
 namespace rviz_rendering
 {
@@ -60,13 +62,14 @@ public:
   std::shared_ptr<rviz_rendering::ViewportProjectionFinder> projection_finder_;
 
 private:
-  rclcpp::Subscription<autoware_adapi_v1_msgs::msg::OperationModeState>::SharedPtr
-    sub_operation_mode_state_;
+  autoware::rviz_subscription_hub::SubscriptionHandle sub_operation_mode_state_;
 
   void onOperationModeState(
     const autoware_adapi_v1_msgs::msg::OperationModeState::ConstSharedPtr msg);
 
   Ogre::Vector3 start_pos;
+  // the last published area, to publish only the changed ones
+  std::optional<geometry_msgs::msg::Polygon> published_polygon_;
 
   rviz_default_plugins::tools::MoveTool * move_tool_;
   bool selecting_;
@@ -0,0 +1,218 @@
+// Copyright 2024 Proxima Technology Inc, TIER IV Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "data_collecting_coverage_counter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace control_data_collecting_tool
+{
+
+namespace
+{
+// crossing number of the ray from the point to +x
+bool isInsidePolygon(const geometry_msgs::msg::Polygon & polygon, const double x, const double y)
+{
+  bool is_inside = false;
+  const auto & points = polygon.points;
+  for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+    const double xi = points.at(i).x;
+    const double yi = points.at(i).y;
+    const double xj = points.at(j).x;
+    const double yj = points.at(j).y;
+    if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi) {
+      is_inside = !is_inside;
+    }
+  }
+  return is_inside;
+}
+
+bool isSamePolygon(const geometry_msgs::msg::Polygon & a, const geometry_msgs::msg::Polygon & b)
+{
+  return a.points == b.points;
+}
+}  // namespace
+
+PolygonGridMask::PolygonGridMask(
+  const geometry_msgs::msg::Polygon & polygon, const double resolution)
+: resolution_(resolution)
+{
+  if (polygon.points.size() < 3) {
+    return;
+  }
+  double max_x = std::numeric_limits<double>::lowest();
+  double max_y = std::numeric_limits<double>::lowest();
+  min_x_ = std::numeric_limits<double>::max();
+  min_y_ = std::numeric_limits<double>::max();
+  for (const auto & point : polygon.points) {
+    min_x_ = std::min(min_x_, static_cast<double>(point.x));
+    min_y_ = std::min(min_y_, static_cast<double>(point.y));
+    max_x = std::max(max_x, static_cast<double>(point.x));
+    max_y = std::max(max_y, static_cast<double>(point.y));
+  }
+  width_ = static_cast<int>(std::ceil((max_x - min_x_) / resolution_)) + 1;
+  height_ = static_cast<int>(std::ceil((max_y - min_y_) / resolution_)) + 1;
+
+  cells_.resize(static_cast<size_t>(width_) * height_);
+  for (int j = 0; j < height_; ++j) {
+    const double y = min_y_ + (j + 0.5) * resolution_;
+    for (int i = 0; i < width_; ++i) {
+      const double x = min_x_ + (i + 0.5) * resolution_;
+      cells_.at(static_cast<size_t>(j) * width_ + i) = isInsidePolygon(polygon, x, y);
+    }
+  }
+}
+
+bool PolygonGridMask::contains(const double x, const double y) const
+{
+  const double i = std::floor((x - min_x_) / resolution_);
+  const double j = std::floor((y - min_y_) / resolution_);
+  if (i < 0.0 || j < 0.0 || i >= width_ || j >= height_) {
+    return false;
+  }
+  return cells_[static_cast<size_t>(j) * width_ + static_cast<size_t>(i)];
+}
+
+std::optional<int> Bins::index(const double value) const
+{
+  const double i = std::floor((value - min) / (max - min) * num);
+  if (!(0.0 <= i && i < num)) {
+    return std::nullopt;
+  }
+  return static_cast<int>(i);
+}
+
+DataCollectingCoverageCounter::DataCollectingCoverageCounter(
+  const rclcpp::NodeOptions & node_options)
+: Node("data_collecting_coverage_counter", node_options)
+{
+  using std::placeholders::_1;
+
+  // the same parameters as the python counter, in common_param.yaml
+  wheel_base_ = declare_parameter("wheel_base", 2.79);
+  grid_resolution_ = std::max(declare_parameter("COVERAGE_GRID_RESOLUTION", 0.5), 0.01);
+  v_bins_ = Bins{
+    declare_parameter("V_MIN", 0.0), declare_parameter("V_MAX", 11.5),
+    std::max(declare_parameter("NUM_BINS_V", 10), 1)};
+  a_bins_ = Bins{
+    declare_parameter("A_MIN", -1.0), declare_parameter("A_MAX", 1.0),
+    std::max(declare_parameter("NUM_BINS_A", 10), 1)};
+  steer_bins_ = Bins{
+    declare_parameter("STEER_MIN", -1.0), declare_parameter("STEER_MAX", 1.0),
+    std::max(declare_parameter("NUM_BINS_STEER", 10), 1)};
+  const double publish_rate = declare_parameter("COVERAGE_PUBLISH_RATE", 50.0);
+
+  counts_.assign(static_cast<size_t>(v_bins_.num) * a_bins_.num * steer_bins_.num, 0);
+  const auto add_dimension = [this](const char * label, const int size, const int stride) {
+    std_msgs::msg::MultiArrayDimension dimension;
+    dimension.label = label;
+    dimension.size = size;
+    dimension.stride = stride;
+    counts_msg_.layout.dim.push_back(dimension);
+  };
+  add_dimension("velocity", v_bins_.num, v_bins_.num * a_bins_.num * steer_bins_.num);
+  add_dimension("acceleration", a_bins_.num, a_bins_.num * steer_bins_.num);
+  add_dimension("steer", steer_bins_.num, steer_bins_.num);
+
+  // the area is published only when it is selected
+  sub_area_ = create_subscription<geometry_msgs::msg::PolygonStamped>(
+    "/data_collecting_area", rclcpp::QoS(1).transient_local(),
+    std::bind(&DataCollectingCoverageCounter::onArea, this, _1));
+  sub_odometry_ = create_subscription<nav_msgs::msg::Odometry>(
+    "/localization/kinematic_state", rclcpp::QoS(1),
+    std::bind(&DataCollectingCoverageCounter::onOdometry, this, _1));
+  sub_acceleration_ = create_subscription<geometry_msgs::msg::AccelWithCovarianceStamped>(
+    "/localization/acceleration", rclcpp::QoS(1),
+    [this](const geometry_msgs::msg::AccelWithCovarianceStamped::ConstSharedPtr msg) {
+      acceleration_ = msg;
+    });
+  sub_operation_mode_ = create_subscription<autoware_adapi_v1_msgs::msg::OperationModeState>(
+    "/system/operation_mode/state", rclcpp::QoS(1).transient_local(),
+    [this](const autoware_adapi_v1_msgs::msg::OperationModeState::ConstSharedPtr msg) {
+      operation_mode_ = msg->mode;
+    });
+  sub_control_mode_ = create_subscription<autoware_vehicle_msgs::msg::ControlModeReport>(
+    "/vehicle/status/control_mode", rclcpp::QoS(1),
+    [this](const autoware_vehicle_msgs::msg::ControlModeReport::ConstSharedPtr msg) {
+      control_mode_ = msg->mode;
+    });
+  pub_counts_ = create_publisher<std_msgs::msg::Int32MultiArray>(
+    "/control_data_collecting_tools/collected_data_counts_of_vel_acc_steer",
+    rclcpp::QoS(1).transient_local());
+
+  const auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::duration<double>(1.0 / publish_rate));
+  timer_ = rclcpp::create_timer(
+    this, get_clock(), period, std::bind(&DataCollectingCoverageCounter::onTimer, this));
+}
+
+void DataCollectingCoverageCounter::onArea(
+  const geometry_msgs::msg::PolygonStamped::ConstSharedPtr msg)
+{
+  if (area_mask_ && isSamePolygon(area_, msg->polygon)) {
+    return;
+  }
+  area_ = msg->polygon;
+  area_mask_.emplace(area_, grid_resolution_);
+}
+
+void DataCollectingCoverageCounter::onOdometry(const nav_msgs::msg::Odometry::ConstSharedPtr msg)
+{
+  // the same conditions as the python counter
+  if (!area_mask_ || !acceleration_ || !operation_mode_ || !control_mode_) {
+    return;
+  }
+  if (
+    *operation_mode_ != autoware_adapi_v1_msgs::msg::OperationModeState::LOCAL ||
+    *control_mode_ != autoware_vehicle_msgs::msg::ControlModeReport::AUTONOMOUS) {
+    return;
+  }
+  const auto & twist = msg->twist.twist;
+  if (twist.linear.x <= 1e-3) {
+    return;
+  }
+  const auto & position = msg->pose.pose.position;
+  if (!area_mask_->contains(position.x, position.y)) {
+    return;
+  }
+
+  const double steer = std::atan2(wheel_base_ * twist.angular.z, twist.linear.x);
+  const auto v_index = v_bins_.index(twist.linear.x);
+  const auto a_index = a_bins_.index(acceleration_->accel.accel.linear.x);
+  const auto steer_index = steer_bins_.index(steer);
+  if (!v_index || !a_index || !steer_index) {
+    return;
+  }
+  counts_.at((*v_index * a_bins_.num + *a_index) * steer_bins_.num + *steer_index) += 1;
+  is_counts_updated_ = true;
+}
+
+void DataCollectingCoverageCounter::onTimer()
+{
+  if (!is_counts_updated_) {
+    return;
+  }
+  counts_msg_.data = counts_;
+  pub_counts_->publish(counts_msg_);
+  is_counts_updated_ = false;
+}
+
+}  // namespace control_data_collecting_tool
+
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(control_data_collecting_tool::DataCollectingCoverageCounter)
@@ -0,0 +1,106 @@
+// Copyright 2024 Proxima Technology Inc, TIER IV Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DATA_COLLECTING_COVERAGE_COUNTER_HPP_
+#define DATA_COLLECTING_COVERAGE_COUNTER_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <autoware_adapi_v1_msgs/msg/operation_mode_state.hpp>
+#include <autoware_vehicle_msgs/msg/control_mode_report.hpp>
+#include <geometry_msgs/msg/accel_with_covariance_stamped.hpp>
+#include <geometry_msgs/msg/polygon.hpp>
+#include <geometry_msgs/msg/polygon_stamped.hpp>
+#include <nav_msgs/msg/odometry.hpp>
+#include <std_msgs/msg/int32_multi_array.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace control_data_collecting_tool
+{
+
+// Inside or outside of the polygon at the centers of the cells of a grid over its bounding box,
+// which is computed once per polygon so that a lookup is two divisions
+class PolygonGridMask
+{
+public:
+  PolygonGridMask(const geometry_msgs::msg::Polygon & polygon, const double resolution);
+
+  bool contains(const double x, const double y) const;
+
+private:
+  double min_x_{0.0};
+  double min_y_{0.0};
+  double resolution_;
+  int width_{0};
+  int height_{0};
+  std::vector<uint8_t> cells_;
+};
+
+// Equally spaced bins of [min, max), as np.linspace(min, max, num + 1) in the python counter
+struct Bins
+{
+  double min;
+  double max;
+  int num;
+
+  std::optional<int> index(const double value) const;
+};
+
+// Histogram of the velocity, the acceleration and the steer collected in the selected area,
+// which is published only when it is updated
+class DataCollectingCoverageCounter : public rclcpp::Node
+{
+public:
+  explicit DataCollectingCoverageCounter(const rclcpp::NodeOptions & node_options);
+
+private:
+  void onArea(const geometry_msgs::msg::PolygonStamped::ConstSharedPtr msg);
+  void onOdometry(const nav_msgs::msg::Odometry::ConstSharedPtr msg);
+  void onTimer();
+
+  rclcpp::Subscription<geometry_msgs::msg::PolygonStamped>::SharedPtr sub_area_;
+  rclcpp::Subscription<nav_msgs::msg::Odometry>::SharedPtr sub_odometry_;
+  rclcpp::Subscription<geometry_msgs::msg::AccelWithCovarianceStamped>::SharedPtr
+    sub_acceleration_;
+  rclcpp::Subscription<autoware_adapi_v1_msgs::msg::OperationModeState>::SharedPtr
+    sub_operation_mode_;
+  rclcpp::Subscription<autoware_vehicle_msgs::msg::ControlModeReport>::SharedPtr
+    sub_control_mode_;
+  rclcpp::Publisher<std_msgs::msg::Int32MultiArray>::SharedPtr pub_counts_;
+  rclcpp::TimerBase::SharedPtr timer_;
+
+  double wheel_base_;
+  double grid_resolution_;
+  Bins v_bins_;
+  Bins a_bins_;
+  Bins steer_bins_;
+
+  geometry_msgs::msg::Polygon area_;
+  std::optional<PolygonGridMask> area_mask_;
+  geometry_msgs::msg::AccelWithCovarianceStamped::ConstSharedPtr acceleration_;
+  std::optional<uint8_t> operation_mode_;
+  std::optional<uint8_t> control_mode_;
+
+  // counts of [velocity][acceleration][steer]
+  std::vector<int32_t> counts_;
+  std_msgs::msg::Int32MultiArray counts_msg_;
+  bool is_counts_updated_{true};
+};
+
+}  // namespace control_data_collecting_tool
+
+#endif  // DATA_COLLECTING_COVERAGE_COUNTER_HPP_
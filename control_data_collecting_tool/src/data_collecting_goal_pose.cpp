@@ -79,10 +79,12 @@ void DataCollectingGoalPose::onInitialize()
     "Pose publisher initialized on topic: /data_collecting_goal_pose");
 
   // Subscription to the operation mode state topic with a QoS of 1
+  // shared with the area selection tool, which subscribes to the same state
   sub_operation_mode_state_ =
-    raw_node_ptr->create_subscription<autoware_adapi_v1_msgs::msg::OperationModeState>(
-      "/system/operation_mode/state", rclcpp::QoS{1},
-      std::bind(&DataCollectingGoalPose::onOperationModeState, this, std::placeholders::_1));
+    autoware::rviz_subscription_hub::SubscriptionHub::instance()
+      .subscribe<autoware_adapi_v1_msgs::msg::OperationModeState>(
+        raw_node_ptr, "/system/operation_mode/state", rclcpp::QoS{1},
+        std::bind(&DataCollectingGoalPose::onOperationModeState, this, std::placeholders::_1));
   RCLCPP_INFO(
     rclcpp::get_logger("DataCollectingGoalPose"),
     "Subscribed to topic: /system/operation_mode/state");
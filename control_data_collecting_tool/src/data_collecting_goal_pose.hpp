@@ -18,6 +18,7 @@
 #include "rviz_common/properties/qos_profile_property.hpp"
 #include "rviz_common/properties/string_property.hpp"
 
+#include <autoware/rviz_subscription_hub/subscription_hub.hpp>
 #include <rviz_common/tool.hpp>
 #include <rviz_default_plugins/tools/goal_pose/goal_tool.hpp>
 
@@ -47,8 +48,7 @@ private:
   bool control_applying_ = false;
 
   // Subscription to listen for operation mode state messages
-  rclcpp::Subscription<autoware_adapi_v1_msgs::msg::OperationModeState>::SharedPtr
-    sub_operation_mode_state_;
+  autoware::rviz_subscription_hub::SubscriptionHandle sub_operation_mode_state_;
 
   // Callback function to handle received operation mode state messages
   void onOperationModeState(
@@ -16,13 +16,16 @@
 #define DRIVING_ENVIRONMENT_ANALYZER__ANALYZER_CORE_HPP_
 
 #include "driving_environment_analyzer/type_alias.hpp"
-#include "rosbag2_cpp/reader.hpp"
+#include "driving_environment_analyzer/utils.hpp"
 
+#include <autoware/bag_index/bag_index.hpp>
+#include <autoware/csv_utils/csv_writer.hpp>
 #include <autoware/route_handler/route_handler.hpp>
 #include <rclcpp/rclcpp.hpp>
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -47,26 +50,35 @@ public:
 
   bool isDataReadyForStaticODDAnalysis() const;
   bool isDataReadyForDynamicODDAnalysis() const { return odd_raw_data_.has_value(); }
+  bool isMapReady() const { return route_handler_.isMapMsgReady(); }
 
   void analyzeStaticODDFactor() const;
-  void analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const;
+  // Static ODD factors of the routes of all @bag_paths against the map of the analyzer. The
+  // routes are read by @thread_num threads, and a lanelet driven by several routes is looked up
+  // in the attribute table once.
+  void analyzeStaticODDFactorOfBags(
+    const std::vector<std::string> & bag_paths, const size_t thread_num) const;
+  void analyzeDynamicODDFactor(autoware::csv_utils::CsvWriter & csv_writer) const;
+  void analyzeDynamicODDFactorInSweep(
+    autoware::csv_utils::CsvWriter & csv_writer, const rcutils_time_point_value_t interval,
+    const size_t thread_num) const;
 
-  void addHeader(std::ofstream & ofs_csv_file) const;
+  void addHeader(autoware::csv_utils::CsvWriter & csv_writer) const;
 
-  void setBagFile(const std::string & file_name);
+  void setBagFile(const std::string & file_name, const bool use_cache = false);
 
   void setTimeStamp(const rcutils_time_point_value_t & timestamp)
   {
     odd_raw_data_ = getRawData(timestamp);
   }
 
-  void setMap(const LaneletMapBin & msg) { route_handler_.setMap(msg); }
+  void setMap(const LaneletMapBin & msg);
 
   void clearData() { odd_raw_data_ = std::nullopt; }
 
   std::pair<rcutils_time_point_value_t, rcutils_time_point_value_t> getBagStartEndTime()
   {
-    const auto metadata = reader_.get_metadata();
+    const auto metadata = bag_index_->getMetadata();
     const auto start_time =
       duration_cast<seconds>(metadata.starting_time.time_since_epoch()).count();
     const auto duration_time = duration_cast<seconds>(metadata.duration).count();
@@ -79,22 +91,36 @@ public:
   TFMessage getTFStatic() const { return odd_raw_data_.value().tf_static; }
 
 private:
-  Pose getEgoPose() const { return odd_raw_data_.value().odometry.pose.pose; }
+  void writeStaticODDFactor(
+    const std::vector<utils::LaneletAttribute> & attributes, std::ostream & ss) const;
 
-  double getEgoSpeed() const { return odd_raw_data_.value().odometry.twist.twist.linear.x; }
+  // the numbers of the CSV are written with the digits of a default std::ostream
+  static constexpr int csv_precision = 6;
+
+  // @tracker carries the closest lanelet from the previous sample of the same thread
+  bool analyzeDynamicODDFactor(
+    const ODDRawData & odd_raw_data, utils::ClosestLaneletTracker & tracker,
+    autoware::csv_utils::CsvLine & csv_row, std::ostream & ss) const;
+
+  // the samples of a sweep are claimed by the threads in runs of consecutive timestamps, so the
+  // closest lanelet of a sample is mostly found next to the one of the previous sample
+  static constexpr size_t sweep_block_size = 16;
 
-  template <class T>
-  std::optional<T> getLastTopic(const std::string & topic_name);
   template <class T>
   std::optional<T> seekTopic(
-    const std::string & topic_name, const rcutils_time_point_value_t & timestamp);
-  std::optional<ODDRawData> getRawData(const rcutils_time_point_value_t & timestamp);
+    const std::string & topic_name, const rcutils_time_point_value_t & timestamp) const;
+  std::optional<ODDRawData> getRawData(const rcutils_time_point_value_t & timestamp) const;
 
   std::optional<ODDRawData> odd_raw_data_{std::nullopt};
 
+  // The first message of each second of the topics, and the route and the map. The timestamps
+  // given to seekTopic are whole seconds, so a lookup returns the message a seek in the bag would.
+  std::unique_ptr<autoware::bag_index::BagIndex> bag_index_;
+
   autoware::route_handler::RouteHandler route_handler_;
 
-  rosbag2_cpp::Reader reader_;
+  // Built when the map is set, read by the static and dynamic analyses
+  utils::LaneletAttributeTable lanelet_attribute_table_;
 
   rclcpp::Logger logger_;
 };
@@ -36,6 +36,15 @@ private:
 
   std::shared_ptr<analyzer_core::AnalyzerCore> analyzer_;
 
+  std::string bag_path_;
+  int64_t sweep_interval_;
+  int64_t sweep_thread_num_;
+  int64_t bag_thread_num_;
+  bool use_bag_cache_;
+
+  // bags under @bag_path_ analyzed together, empty if @bag_path_ is a single bag
+  std::vector<std::string> batch_bag_paths_;
+
   rclcpp::Subscription<LaneletMapBin>::SharedPtr sub_map_;
   rclcpp::TimerBase::SharedPtr timer_;
   rosbag2_cpp::Reader reader_;
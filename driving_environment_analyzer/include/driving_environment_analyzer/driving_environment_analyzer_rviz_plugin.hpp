@@ -32,8 +32,12 @@
 #include <rviz_common/view_manager.hpp>
 #include <rviz_rendering/render_window.hpp>
 
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace driving_environment_analyzer
@@ -57,17 +61,52 @@ public Q_SLOTS:
   void onClickAnalyzeStaticODDFactor();
   void onClickAnalyzeDynamicODDFactor();
 
+Q_SIGNALS:
+  // emitted by the worker thread, and received by the GUI thread through queued connections
+  void bagOpened(const QString & bag_name, int start_time, int end_time);
+  void statusChanged(const QString & status);
+
+private Q_SLOTS:
+  void onBagOpened(const QString & bag_name, int start_time, int end_time);
+
 private:
+  // The bag seeks, the map queries and the CSV writes of AnalyzerCore run on a worker thread,
+  // which processes the requests of the panel in turn, so that RViz does not freeze.
+  struct Request
+  {
+    enum class Type { SET_MAP, OPEN_BAG, SET_TIME_STAMP, ANALYZE_STATIC_ODD, ANALYZE_DYNAMIC_ODD };
+
+    Type type{Type::SET_MAP};
+    LaneletMapBin::ConstSharedPtr map{};
+    std::string bag_name{};
+    std::string csv_file_name{};
+    rcutils_time_point_value_t timestamp{0};
+  };
+
   void onMap(const LaneletMapBin::ConstSharedPtr map_msg);
 
+  void post(const Request & request);
+
+  void work();
+
+  void process(const Request & request);
+
   std::shared_ptr<analyzer_core::AnalyzerCore> analyzer_;
 
-  std::ofstream ofs_csv_file_;
+  // written by the worker thread only
+  autoware::csv_utils::CsvWriter csv_writer_;
+
+  std::thread worker_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request> requests_;
+  bool stop_{false};
 
   QSpinBox * bag_time_selector_;
   QSlider * bag_time_slider_;
   QLabel * bag_name_label_;
   QLabel * bag_time_line_;
+  QLabel * status_label_;
   QPushButton * dir_button_ptr_;
   QPushButton * file_button_ptr_;
   QPushButton * analyze_static_odd_button_;
@@ -17,7 +17,11 @@
 
 #include "driving_environment_analyzer/type_alias.hpp"
 
+#include <array>
+#include <limits>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -77,6 +81,25 @@ bool isStraightLane(const lanelet::ConstLanelet & lane);
 
 size_t getObjectNumber(const PredictedObjects & objects, const std::uint8_t target_class);
 
+// Statistics of the surrounding objects, indexed by ObjectClassification label for the classes
+struct ObjectStatistics
+{
+  static constexpr size_t CLASS_NUM = ObjectClassification::PEDESTRIAN + 1;
+  // Upper edges of the bins but the last one, which is unbounded
+  static constexpr std::array<double, 3> DISTANCE_BIN_EDGES{10.0, 30.0, 60.0};  // [m]
+  static constexpr std::array<double, 3> SPEED_BIN_EDGES{1.0, 5.0, 10.0};       // [m/s]
+
+  std::array<size_t, CLASS_NUM> number{};
+  // Infinity when there is no object of the class
+  std::array<double, CLASS_NUM> nearest_distance{};
+  std::array<size_t, DISTANCE_BIN_EDGES.size() + 1> distance_bins{};
+  std::array<size_t, SPEED_BIN_EDGES.size() + 1> speed_bins{};
+};
+
+// All the statistics in one pass over the objects. @statistics is reset, so it can be reused.
+void getObjectStatistics(
+  const PredictedObjects & objects, const Pose & ego_pose, ObjectStatistics & statistics);
+
 std::string getLaneShape(const lanelet::ConstLanelet & lane);
 
 std::string getModuleStatus(const CooperateStatusArray & status_array, const uint8_t module_type);
@@ -84,6 +107,81 @@ std::string getModuleStatus(const CooperateStatusArray & status_array, const uin
 std::string getEgoBehavior(
   const lanelet::ConstLanelet & lane, const RouteHandler & route_handler, const Pose & pose);
 
+// ODD attributes of a single lanelet, which do not depend on the route
+struct LaneletAttribute
+{
+  double length;
+  double width;
+  double max_curvature;
+  double min_elevation;
+  double max_elevation;
+  double speed_limit;
+  int left_lanelet_num;
+  int right_lanelet_num;
+  bool exist_same_direction_lane;
+  bool exist_opposite_direction_lane;
+  bool exist_road_shoulder_lane;
+  bool exist_traffic_light;
+  bool exist_intersection;
+  bool exist_crosswalk;
+};
+
+using LaneletAttributeTable = std::unordered_map<lanelet::Id, LaneletAttribute>;
+
+LaneletAttribute calcLaneletAttribute(
+  const lanelet::ConstLanelet & lane, const RouteHandler & route_handler);
+
+// Attributes of all the road lanelets of the map, computed by @thread_num threads
+LaneletAttributeTable createLaneletAttributeTable(
+  const RouteHandler & route_handler, const size_t thread_num);
+
+// Rows of @lanes, computed on the fly for the lanelets missing in @table
+std::vector<LaneletAttribute> getLaneletAttributes(
+  const lanelet::ConstLanelets & lanes, const LaneletAttributeTable & table,
+  const RouteHandler & route_handler);
+
+// Closest lanelet of the route to the ego along a sequence of nearby poses, as in a sweep of a
+// bag. The lanelet of the previous pose, its neighbours, successors and predecessors are tried
+// first, and the whole route only when the ego is in none of them. The centerline and the shape
+// of the lanelets found are kept for the next poses.
+class ClosestLaneletTracker
+{
+public:
+  explicit ClosestLaneletTracker(const RouteHandler & route_handler)
+  : route_handler_{route_handler}
+  {
+  }
+
+  // Same as RouteHandler::getClosestLaneletWithinRoute, unless overlapping route lanelets other
+  // than the candidates contain the ego
+  bool getClosestLanelet(const Pose & pose, lanelet::ConstLanelet * closest_lanelet);
+
+  double calcElevationAngle(const lanelet::ConstLanelet & lane, const Pose & pose);
+
+  std::string getLaneShape(const lanelet::ConstLanelet & lane);
+
+  // Number of poses resolved from the previous lanelet, and by the search over the route
+  size_t getHitNum() const { return hit_num_; }
+  size_t getMissNum() const { return miss_num_; }
+
+private:
+  struct LaneletCache
+  {
+    std::vector<geometry_msgs::msg::Point> centerline;
+    std::string shape;
+    // the lanelet itself first, then the route lanelets next to it
+    lanelet::ConstLanelets candidates;
+  };
+
+  const LaneletCache & getCache(const lanelet::ConstLanelet & lane);
+
+  const RouteHandler & route_handler_;
+  std::optional<lanelet::ConstLanelet> last_lanelet_;
+  std::unordered_map<lanelet::Id, LaneletCache> caches_;
+  size_t hit_num_{0};
+  size_t miss_num_{0};
+};
+
 }  // namespace driving_environment_analyzer::utils
 
 #endif  // DRIVING_ENVIRONMENT_ANALYZER__UTILS_HPP_
@@ -16,10 +16,17 @@
 
 #include "driving_environment_analyzer/utils.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace driving_environment_analyzer::analyzer_core
@@ -44,189 +51,286 @@ bool AnalyzerCore::isDataReadyForStaticODDAnalysis() const
   return true;
 }
 
-void AnalyzerCore::setBagFile(const std::string & file_name)
+namespace
 {
-  reader_.open(file_name);
-
-  const auto opt_route = getLastTopic<LaneletRoute>("/planning/mission_planning/route");
-  if (opt_route.has_value()) {
-    route_handler_.setRoute(opt_route.value());
-  }
+const std::string route_topic = "/planning/mission_planning/route";
+const std::string map_topic = "/map/vector_map";
+const std::string odometry_topic = "/localization/kinematic_state";
+const std::string objects_topic = "/perception/object_recognition/objects";
+const std::string rtc_status_topic = "/api/external/get/rtc_status";
+const std::string tf_topic = "/tf";
+const std::string tf_static_topic = "/tf_static";
+}  // namespace
+
+void AnalyzerCore::setMap(const LaneletMapBin & msg)
+{
+  route_handler_.setMap(msg);
 
-  const auto opt_map = getLastTopic<LaneletMapBin>("/map/vector_map");
-  if (opt_map.has_value()) {
-    route_handler_.setMap(opt_map.value());
-  }
+  lanelet_attribute_table_ =
+    utils::createLaneletAttributeTable(route_handler_, std::thread::hardware_concurrency());
 }
 
-template <class T>
-std::optional<T> AnalyzerCore::getLastTopic(const std::string & topic_name)
+// Read the bag once. The route and the map are the last messages of their topic, and only the
+// first message of each second of the other topics is kept. With @use_cache, the index is saved
+// next to the bag and loaded from there by the next analyses of the same bag.
+void AnalyzerCore::setBagFile(const std::string & file_name, const bool use_cache)
 {
-  rosbag2_storage::StorageFilter filter;
-  filter.topics.emplace_back(topic_name);
-  reader_.set_filter(filter);
-
-  if (!reader_.has_next()) {
-    return std::nullopt;
+  using autoware::bag_index::BagIndex;
+
+  autoware::bag_index::IndexOptions options;
+  options.topics = {route_topic,      map_topic, odometry_topic, objects_topic,
+                    rtc_status_topic, tf_topic,  tf_static_topic};
+  for (const auto & topic : {odometry_topic, objects_topic, rtc_status_topic, tf_topic,
+                             tf_static_topic}) {
+    options.periods[topic] = 1000000000;
   }
+  if (use_cache) {
+    options.cache_path = BagIndex::getDefaultCachePath(file_name);
+  }
+  bag_index_ = std::make_unique<BagIndex>(file_name, options);
 
-  rclcpp::Serialization<T> serializer;
-
-  const auto deserialized_message = std::make_shared<T>();
-  while (reader_.has_next()) {
-    rclcpp::SerializedMessage serialized_msg(*reader_.read_next()->serialized_data);
-    serializer.deserialize_message(&serialized_msg, deserialized_message.get());
+  const auto route = bag_index_->getLast<LaneletRoute>(bag_index_->getTopicId(route_topic));
+  if (route) {
+    route_handler_.setRoute(route.value());
   }
 
-  return *deserialized_message;
+  const auto map = bag_index_->getLast<LaneletMapBin>(bag_index_->getTopicId(map_topic));
+  if (map) {
+    setMap(map.value());
+  }
 }
 
+// Same result as a seek in the bag, the first message at @timestamp [s] or later
 template <class T>
 std::optional<T> AnalyzerCore::seekTopic(
-  const std::string & topic_name, const rcutils_time_point_value_t & timestamp)
+  const std::string & topic_name, const rcutils_time_point_value_t & timestamp) const
+{
+  return bag_index_->seek<T>(bag_index_->getTopicId(topic_name), timestamp * 1000000000);
+}
+
+std::optional<ODDRawData> AnalyzerCore::getRawData(
+  const rcutils_time_point_value_t & timestamp) const
 {
-  rosbag2_storage::StorageFilter filter;
-  filter.topics.emplace_back(topic_name);
-  reader_.set_filter(filter);
+  ODDRawData odd_raw_data;
+
+  odd_raw_data.timestamp = timestamp;
 
-  rclcpp::Serialization<T> serializer;
-  reader_.seek(timestamp);
+  const auto metadata = bag_index_->getMetadata();
+  const auto start_time = duration_cast<seconds>(metadata.starting_time.time_since_epoch()).count();
+
+  // The lookups only read the cache, so they are resolved in parallel
+  std::optional<Odometry> opt_odometry;
+  std::optional<PredictedObjects> opt_objects;
+  std::optional<CooperateStatusArray> opt_rtc_status;
+  std::optional<TFMessage> opt_tf;
+  std::optional<TFMessage> opt_tf_static;
+
+  std::vector<std::thread> threads;
+  threads.emplace_back(
+    [&]() { opt_objects = seekTopic<PredictedObjects>(objects_topic, timestamp); });
+  threads.emplace_back(
+    [&]() { opt_rtc_status = seekTopic<CooperateStatusArray>(rtc_status_topic, timestamp); });
+  threads.emplace_back([&]() { opt_tf = seekTopic<TFMessage>(tf_topic, timestamp); });
+  threads.emplace_back(
+    [&]() { opt_tf_static = seekTopic<TFMessage>(tf_static_topic, start_time); });
+  opt_odometry = seekTopic<Odometry>(odometry_topic, timestamp);
+  for (auto & thread : threads) {
+    thread.join();
+  }
 
-  if (!reader_.has_next()) {
+  if (
+    !opt_odometry.has_value() || !opt_objects.has_value() || !opt_rtc_status.has_value() ||
+    !opt_tf.has_value() || !opt_tf_static.has_value()) {
     return std::nullopt;
   }
 
-  rclcpp::SerializedMessage serialized_msg(*reader_.read_next()->serialized_data);
-  const auto deserialized_message = std::make_shared<T>();
-  serializer.deserialize_message(&serialized_msg, deserialized_message.get());
+  odd_raw_data.odometry = std::move(opt_odometry.value());
+  odd_raw_data.objects = std::move(opt_objects.value());
+  odd_raw_data.rtc_status = std::move(opt_rtc_status.value());
+  odd_raw_data.tf = std::move(opt_tf.value());
+  odd_raw_data.tf_static = std::move(opt_tf_static.value());
 
-  return *deserialized_message;
+  return odd_raw_data;
 }
 
-std::optional<ODDRawData> AnalyzerCore::getRawData(const rcutils_time_point_value_t & timestamp)
+void AnalyzerCore::addHeader(autoware::csv_utils::CsvWriter & csv_writer) const
 {
-  ODDRawData odd_raw_data;
+  autoware::csv_utils::CsvLine header;
+  header.add("TIME");
+  header.add("EGO [SPEED]");
+  header.add("EGO [ELEVATION ANGLE]");
+  header.add("EGO BEHAVIOR [AVOIDANCE(R)]");
+  header.add("EGO BEHAVIOR [AVOIDANCE(L)]");
+  header.add("EGO BEHAVIOR [LANE_CHANGE(R)]");
+  header.add("EGO BEHAVIOR [LANE_CHANGE(L)]");
+  header.add("EGO BEHAVIOR [START_PLANNER]");
+  header.add("EGO BEHAVIOR [GOAL_PLANNER]");
+  header.add("EGO BEHAVIOR [CROSSWALK]");
+  header.add("EGO BEHAVIOR [INTERSECTION]");
+  header.add("LANE [ID]");
+  header.add("LANE [WIDTH]");
+  header.add("LANE [SHAPE]");
+  header.add("LANE [RIGHT LANE NUM]");
+  header.add("LANE [LEFT LANE NUM]");
+  header.add("LANE [TOTAL LANE NUM]");
+  header.add("LANE [SAME DIRECTION LANE]");
+  header.add("LANE [OPPOSITE DIRECTION LANE]");
+  header.add("LANE [ROAD SHOULDER]");
+  header.add("OBJECT [UNKNOWN]");
+  header.add("OBJECT [CAR]");
+  header.add("OBJECT [TRUCK]");
+  header.add("OBJECT [BUS]");
+  header.add("OBJECT [TRAILER]");
+  header.add("OBJECT [MOTORCYCLE]");
+  header.add("OBJECT [BICYCLE]");
+  header.add("OBJECT [PEDESTRIAN]");
+  header.add("OBJECT DISTANCE [0-10m]");
+  header.add("OBJECT DISTANCE [10-30m]");
+  header.add("OBJECT DISTANCE [30-60m]");
+  header.add("OBJECT DISTANCE [60m-]");
+  header.add("OBJECT SPEED [0-1m/s]");
+  header.add("OBJECT SPEED [1-5m/s]");
+  header.add("OBJECT SPEED [5-10m/s]");
+  header.add("OBJECT SPEED [10m/s-]");
+  csv_writer.writeLine(header);
+}
 
-  odd_raw_data.timestamp = timestamp;
+void AnalyzerCore::analyzeDynamicODDFactor(autoware::csv_utils::CsvWriter & csv_writer) const
+{
+  std::ostringstream ss;
+  autoware::csv_utils::CsvLine csv_row(csv_precision);
 
-  const auto opt_odometry = seekTopic<Odometry>("/localization/kinematic_state", timestamp * 1e9);
-  if (!opt_odometry.has_value()) {
-    return std::nullopt;
-  } else {
-    odd_raw_data.odometry = opt_odometry.value();
-  }
+  utils::ClosestLaneletTracker tracker(route_handler_);
 
-  const auto opt_objects =
-    seekTopic<PredictedObjects>("/perception/object_recognition/objects", timestamp * 1e9);
-  if (!opt_objects.has_value()) {
-    return std::nullopt;
-  } else {
-    odd_raw_data.objects = opt_objects.value();
+  // a row per request of the panel, which is flushed for the file to be read meanwhile
+  if (analyzeDynamicODDFactor(odd_raw_data_.value(), tracker, csv_row, ss)) {
+    csv_writer.writeLine(csv_row);
+    csv_writer.flush();
   }
 
-  const auto opt_rtc_status =
-    seekTopic<CooperateStatusArray>("/api/external/get/rtc_status", timestamp * 1e9);
-  if (!opt_rtc_status.has_value()) {
-    return std::nullopt;
-  } else {
-    odd_raw_data.rtc_status = opt_rtc_status.value();
+  RCLCPP_INFO_STREAM(logger_, ss.str());
+}
+
+// Sample the bag every @interval [s]. The samples are analyzed in parallel since the topic cache
+// and the route handler are only read, and the rows are written in time order at the end.
+void AnalyzerCore::analyzeDynamicODDFactorInSweep(
+  autoware::csv_utils::CsvWriter & csv_writer, const rcutils_time_point_value_t interval,
+  const size_t thread_num) const
+{
+  if (interval <= 0) {
+    RCLCPP_ERROR(logger_, "The sweep interval must be positive.");
+    return;
   }
 
-  const auto opt_tf = seekTopic<TFMessage>("/tf", timestamp * 1e9);
-  if (!opt_tf.has_value()) {
-    return std::nullopt;
-  } else {
-    odd_raw_data.tf = opt_tf.value();
+  const auto metadata = bag_index_->getMetadata();
+  const auto start_time = duration_cast<seconds>(metadata.starting_time.time_since_epoch()).count();
+  const auto end_time = start_time + duration_cast<seconds>(metadata.duration).count();
+
+  std::vector<rcutils_time_point_value_t> timestamps;
+  for (auto timestamp = start_time; timestamp <= end_time; timestamp += interval) {
+    timestamps.push_back(timestamp);
   }
 
-  const auto [start_time, end_time] = getBagStartEndTime();
-  const auto opt_tf_static = seekTopic<TFMessage>("/tf_static", start_time * 1e9);
-  if (!opt_tf_static.has_value()) {
-    return std::nullopt;
-  } else {
-    odd_raw_data.tf_static = opt_tf_static.value();
+  std::vector<std::optional<std::string>> csv_rows(timestamps.size());
+  std::atomic<size_t> next_block(0);
+  std::atomic<size_t> hit_num(0);
+  std::vector<std::thread> threads;
+
+  auto worker = [&]() {
+    utils::ClosestLaneletTracker tracker(route_handler_);
+    for (size_t begin = next_block++ * sweep_block_size; begin < timestamps.size();
+         begin = next_block++ * sweep_block_size) {
+      for (size_t i = begin; i < std::min(begin + sweep_block_size, timestamps.size()); i++) {
+        const auto odd_raw_data = getRawData(timestamps.at(i));
+        if (!odd_raw_data.has_value()) {
+          continue;
+        }
+
+        std::ostringstream ss;
+        autoware::csv_utils::CsvLine csv_row(csv_precision);
+        if (analyzeDynamicODDFactor(odd_raw_data.value(), tracker, csv_row, ss)) {
+          csv_rows.at(i) = csv_row.str();
+        }
+      }
+    }
+    hit_num += tracker.getHitNum();
+  };
+  const auto block_num = (timestamps.size() + sweep_block_size - 1) / sweep_block_size;
+  for (size_t t = 1; t < std::max<size_t>(std::min(thread_num, block_num), 1); t++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : threads) {
+    thread.join();
   }
 
-  return odd_raw_data;
-}
+  size_t analyzed_num = 0;
+  for (const auto & csv_row : csv_rows) {
+    if (csv_row.has_value()) {
+      csv_writer.writeLine(csv_row.value());
+      analyzed_num++;
+    }
+  }
+  csv_writer.flush();
 
-void AnalyzerCore::addHeader(std::ofstream & ofs_csv_file) const
-{
-  ofs_csv_file << "TIME" << ',';
-  ofs_csv_file << "EGO [SPEED]" << ',';
-  ofs_csv_file << "EGO [ELEVATION ANGLE]" << ',';
-  ofs_csv_file << "EGO BEHAVIOR [AVOIDANCE(R)]" << ',';
-  ofs_csv_file << "EGO BEHAVIOR [AVOIDANCE(L)]" << ',';
-  ofs_csv_file << "EGO BEHAVIOR [LANE_CHANGE(R)]" << ',';
-  ofs_csv_file << "EGO BEHAVIOR [LANE_CHANGE(L)]" << ',';
-  ofs_csv_file << "EGO BEHAVIOR [START_PLANNER]" << ',';
-  ofs_csv_file << "EGO BEHAVIOR [GOAL_PLANNER]" << ',';
-  ofs_csv_file << "EGO BEHAVIOR [CROSSWALK]" << ',';
-  ofs_csv_file << "EGO BEHAVIOR [INTERSECTION]" << ',';
-  ofs_csv_file << "LANE [ID]" << ',';
-  ofs_csv_file << "LANE [WIDTH]" << ',';
-  ofs_csv_file << "LANE [SHAPE]" << ',';
-  ofs_csv_file << "LANE [RIGHT LANE NUM]" << ',';
-  ofs_csv_file << "LANE [LEFT LANE NUM]" << ',';
-  ofs_csv_file << "LANE [TOTAL LANE NUM]" << ',';
-  ofs_csv_file << "LANE [SAME DIRECTION LANE]" << ',';
-  ofs_csv_file << "LANE [OPPOSITE DIRECTION LANE]" << ',';
-  ofs_csv_file << "LANE [ROAD SHOULDER]" << ',';
-  ofs_csv_file << "OBJECT [UNKNOWN]" << ',';
-  ofs_csv_file << "OBJECT [CAR]" << ',';
-  ofs_csv_file << "OBJECT [TRUCK]" << ',';
-  ofs_csv_file << "OBJECT [BUS]" << ',';
-  ofs_csv_file << "OBJECT [TRAILER]" << ',';
-  ofs_csv_file << "OBJECT [MOTORCYCLE]" << ',';
-  ofs_csv_file << "OBJECT [BICYCLE]" << ',';
-  ofs_csv_file << "OBJECT [PEDESTRIAN]" << ',';
-  ofs_csv_file << std::endl;
+  RCLCPP_INFO_STREAM(
+    logger_, "Analyzed " << analyzed_num << " of " << timestamps.size() << " samples between "
+                         << start_time << " and " << end_time << ", " << hit_num
+                         << " lanelets found next to the previous sample.");
 }
 
-void AnalyzerCore::analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const
+bool AnalyzerCore::analyzeDynamicODDFactor(
+  const ODDRawData & odd_raw_data, utils::ClosestLaneletTracker & tracker,
+  autoware::csv_utils::CsvLine & csv_row, std::ostream & ss) const
 {
-  std::ostringstream ss;
   ss << std::boolalpha << "\n";
   ss << "***********************************************************\n";
   ss << "                   ODD analysis result\n";
   ss << "***********************************************************\n";
   ss << "Type: TIME SPECIFIED\n";
 
-  const auto write = [&ofs_csv_file](const auto & data) {
-    ofs_csv_file << data << ',';
+  const auto write = [&csv_row](const auto & data) {
+    csv_row.add(data);
     return data;
   };
 
   char buffer[128];
-  auto seconds = static_cast<time_t>(odd_raw_data_.value().timestamp);
+  auto seconds = static_cast<time_t>(odd_raw_data.timestamp);
   strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
   ss << "Time: " << write(buffer) << "\n";
   ss << "\n";
   ss << "\n";
 
+  const auto & ego_pose = odd_raw_data.odometry.pose.pose;
+  const auto ego_speed = odd_raw_data.odometry.twist.twist.linear.x;
+
   lanelet::ConstLanelet closest_lanelet;
-  if (!route_handler_.getClosestLaneletWithinRoute(getEgoPose(), &closest_lanelet)) {
-    return;
+  if (!tracker.getClosestLanelet(ego_pose, &closest_lanelet)) {
+    return false;
   }
 
-  const auto number = [this](const auto & target_class) {
-    return utils::getObjectNumber(odd_raw_data_.value().objects, target_class);
-  };
+  const auto lane_attribute = utils::getLaneletAttributes(
+    {closest_lanelet}, lanelet_attribute_table_, route_handler_).front();
 
-  const auto status = [this](const auto & module_type) {
-    return utils::getModuleStatus(odd_raw_data_.value().rtc_status, module_type);
+  utils::ObjectStatistics object_statistics;
+  utils::getObjectStatistics(odd_raw_data.objects, ego_pose, object_statistics);
+
+  const auto number = [&object_statistics](const auto & target_class) {
+    return object_statistics.number.at(target_class);
   };
 
-  const auto exist_crosswalk = [this, &closest_lanelet]() {
-    return utils::existCrosswalk(closest_lanelet, route_handler_) ? "EXIST" : "NONE";
+  const auto status = [&odd_raw_data](const auto & module_type) {
+    return utils::getModuleStatus(odd_raw_data.rtc_status, module_type);
   };
 
   const auto to_string = [](const bool exist) { return exist ? "EXIST" : "NONE"; };
+  const auto total_lanelet_num =
+    lane_attribute.right_lanelet_num + lane_attribute.left_lanelet_num + 1;
 
   ss << "- EGO INFO\n";
-  ss << "  [SPEED]                       : " << write(getEgoSpeed()) << " [m/s]\n";
+  ss << "  [SPEED]                       : " << write(ego_speed) << " [m/s]\n";
   ss << "  [ELEVATION ANGLE]             : "
-     << write(utils::calcElevationAngle(closest_lanelet, getEgoPose())) << " [rad]\n";
+     << write(tracker.calcElevationAngle(closest_lanelet, ego_pose)) << " [rad]\n";
   ss << "\n";
 
   ss << "- EGO BEHAVIOR\n";
@@ -236,29 +340,28 @@ void AnalyzerCore::analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const
   ss << "  [LANE_CHANGE(L)]              : " << write(status(Module::LANE_CHANGE_LEFT)) << "\n";
   ss << "  [START_PLANNER]               : " << write(status(Module::START_PLANNER)) << "\n";
   ss << "  [GOAL_PLANNER]                : " << write(status(Module::GOAL_PLANNER)) << "\n";
-  ss << "  [CROSSWALK]                   : " << write(exist_crosswalk()) << "\n";
+  ss << "  [CROSSWALK]                   : " << write(to_string(lane_attribute.exist_crosswalk))
+     << "\n";
   ss << "  [INTERSECTION]                : "
-     << write(utils::getEgoBehavior(closest_lanelet, route_handler_, getEgoPose())) << "\n";
+     << write(utils::getEgoBehavior(closest_lanelet, route_handler_, ego_pose)) << "\n";
   ss << "\n";
 
   ss << "- LANE INFO\n";
   ss << "  [ID]                          : " << write(closest_lanelet.id()) << "\n";
-  ss << "  [WIDTH]                       : " << write(utils::getLaneWidth(closest_lanelet))
-     << " [m]\n";
-  ss << "  [SHAPE]                       : " << write(utils::getLaneShape(closest_lanelet)) << "\n";
+  ss << "  [WIDTH]                       : " << write(lane_attribute.width) << " [m]\n";
+  ss << "  [SHAPE]                       : " << write(tracker.getLaneShape(closest_lanelet))
+     << "\n";
   ss << "  [RIGHT LANE NUM]              : "
-     << write(utils::getRightLaneletNum(closest_lanelet, route_handler_)) << "\n";
+     << write(lane_attribute.right_lanelet_num) << "\n";
   ss << "  [LEFT LANE NUM]               : "
-     << write(utils::getLeftLaneletNum(closest_lanelet, route_handler_)) << "\n";
-  ss << "  [TOTAL LANE NUM]              : "
-     << write(utils::getTotalLaneletNum(closest_lanelet, route_handler_)) << "\n";
+     << write(lane_attribute.left_lanelet_num) << "\n";
+  ss << "  [TOTAL LANE NUM]              : " << write(total_lanelet_num) << "\n";
   ss << "  [SAME DIRECTION LANE]         : "
-     << write(to_string(utils::existSameDirectionLane(closest_lanelet, route_handler_))) << "\n";
+     << write(to_string(lane_attribute.exist_same_direction_lane)) << "\n";
   ss << "  [OPPOSITE DIRECTION LANE]     : "
-     << write(to_string(utils::existOppositeDirectionLane(closest_lanelet, route_handler_)))
-     << "\n";
+     << write(to_string(lane_attribute.exist_opposite_direction_lane)) << "\n";
   ss << "  [ROAD SHOULDER]               : "
-     << write(to_string(utils::existRoadShoulderLane(closest_lanelet, route_handler_))) << "\n";
+     << write(to_string(lane_attribute.exist_road_shoulder_lane)) << "\n";
   ss << "\n";
 
   ss << "- SURROUND OBJECT NUM\n";
@@ -275,12 +378,38 @@ void AnalyzerCore::analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const
      << "\n";
   ss << "  [PEDESTRIAN]                  : " << write(number(ObjectClassification::PEDESTRIAN))
      << "\n";
+  ss << "\n";
 
-  ss << "***********************************************************\n";
+  const auto & distance_bins = object_statistics.distance_bins;
+  ss << "- SURROUND OBJECT DISTANCE\n";
+  ss << "  [0-10m]                       : " << write(distance_bins.at(0)) << "\n";
+  ss << "  [10-30m]                      : " << write(distance_bins.at(1)) << "\n";
+  ss << "  [30-60m]                      : " << write(distance_bins.at(2)) << "\n";
+  ss << "  [60m-]                        : " << write(distance_bins.at(3)) << "\n";
+  ss << "\n";
 
-  ofs_csv_file << std::endl;
+  const auto & speed_bins = object_statistics.speed_bins;
+  ss << "- SURROUND OBJECT SPEED\n";
+  ss << "  [0-1m/s]                      : " << write(speed_bins.at(0)) << "\n";
+  ss << "  [1-5m/s]                      : " << write(speed_bins.at(1)) << "\n";
+  ss << "  [5-10m/s]                     : " << write(speed_bins.at(2)) << "\n";
+  ss << "  [10m/s-]                      : " << write(speed_bins.at(3)) << "\n";
+  ss << "\n";
 
-  RCLCPP_INFO_STREAM(logger_, ss.str());
+  const std::array<const char *, utils::ObjectStatistics::CLASS_NUM> class_names{
+    "[UNKNOWN]   ", "[CAR]       ", "[TRUCK]     ", "[BUS]       ",
+    "[TRAILER]   ", "[MOTORCYCLE]", "[BICYCLE]   ", "[PEDESTRIAN]"};
+  ss << "- NEAREST OBJECT DISTANCE\n";
+  for (size_t label = 0; label < class_names.size(); label++) {
+    if (object_statistics.number.at(label) > 0) {
+      ss << "  " << class_names.at(label) << "                  : "
+         << object_statistics.nearest_distance.at(label) << " [m]\n";
+    }
+  }
+
+  ss << "***********************************************************\n";
+
+  return true;
 }
 
 void AnalyzerCore::analyzeStaticODDFactor() const
@@ -294,53 +423,185 @@ void AnalyzerCore::analyzeStaticODDFactor() const
   ss << "\n";
   ss << "\n";
 
-  const auto preferred_lanes = route_handler_.getPreferredLanelets();
+  // The route is analyzed from the rows of the attribute table built with the map
+  writeStaticODDFactor(
+    utils::getLaneletAttributes(
+      route_handler_.getPreferredLanelets(), lanelet_attribute_table_, route_handler_),
+    ss);
+
+  RCLCPP_INFO_STREAM(logger_, ss.str());
+}
+
+void AnalyzerCore::analyzeStaticODDFactorOfBags(
+  const std::vector<std::string> & bag_paths, const size_t thread_num) const
+{
+  // preferred lanelets of the route of each bag, empty if the bag has no route
+  std::vector<lanelet::Ids> route_lanelet_ids(bag_paths.size());
+  std::atomic<size_t> next_bag(0);
+  std::vector<std::thread> threads;
+
+  auto worker = [&]() {
+    for (size_t i = next_bag++; i < bag_paths.size(); i = next_bag++) {
+      try {
+        autoware::bag_index::IndexOptions options;
+        options.topics = {route_topic};
+        const autoware::bag_index::BagIndex bag_index(bag_paths.at(i), options);
+        const auto route = bag_index.getLast<LaneletRoute>(bag_index.getTopicId(route_topic));
+        if (!route) {
+          continue;
+        }
+
+        for (const auto & segment : route->segments) {
+          route_lanelet_ids.at(i).push_back(segment.preferred_primitive.id);
+        }
+      } catch (const std::exception & e) {
+        RCLCPP_ERROR_STREAM(logger_, "Failed to read " << bag_paths.at(i) << ": " << e.what());
+      }
+    }
+  };
+  for (size_t t = 1; t < std::max<size_t>(std::min(thread_num, bag_paths.size()), 1); t++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  // the rows of the distinct lanelets, the ones missing in the map are skipped
+  std::unordered_map<lanelet::Id, utils::LaneletAttribute> distinct_attributes;
+  const auto & lanelet_layer = route_handler_.getLaneletMapPtr()->laneletLayer;
+  for (const auto & ids : route_lanelet_ids) {
+    for (const auto id : ids) {
+      if (distinct_attributes.count(id) > 0 || !lanelet_layer.exists(id)) {
+        continue;
+      }
+      distinct_attributes.emplace(
+        id, utils::getLaneletAttributes(
+              {route_handler_.getLaneletsFromId(id)}, lanelet_attribute_table_, route_handler_)
+              .front());
+    }
+  }
+
+  // lanelets as many times as they are driven
+  std::vector<utils::LaneletAttribute> attributes;
+  size_t route_num = 0;
+  for (const auto & ids : route_lanelet_ids) {
+    route_num += ids.empty() ? 0 : 1;
+    for (const auto id : ids) {
+      const auto itr = distinct_attributes.find(id);
+      if (itr != distinct_attributes.end()) {
+        attributes.push_back(itr->second);
+      }
+    }
+  }
+
+  double distinct_length = 0.0;
+  for (const auto & [id, attribute] : distinct_attributes) {
+    distinct_length += attribute.length;
+  }
+
+  std::ostringstream ss;
+  ss << std::boolalpha << "\n";
+  ss << "***********************************************************\n";
+  ss << "                   ODD analysis result\n";
+  ss << "***********************************************************\n";
+  ss << "Type: ROUTES OF BAGS\n";
+  ss << "\n";
+  ss << "\n";
+
+  ss << "- BAG INFO\n";
+  ss << "  bags                              : " << bag_paths.size() << "\n";
+  ss << "  bags with route                   : " << route_num << "\n";
+  ss << "  distinct lanelets                 : " << distinct_attributes.size() << "\n";
+  ss << "  distinct lanelet length           : " << distinct_length << " [m]\n";
+  ss << "\n";
+
+  // the lengths below are the driven lengths, summed over the routes
+  if (!attributes.empty()) {
+    writeStaticODDFactor(attributes, ss);
+  }
+
+  RCLCPP_INFO_STREAM(logger_, ss.str());
+}
+
+void AnalyzerCore::writeStaticODDFactor(
+  const std::vector<utils::LaneletAttribute> & attributes, std::ostream & ss) const
+{
+  const auto length = [&attributes](const auto & is_target) {
+    double value = 0.0;
+    for (const auto & attribute : attributes) {
+      value += is_target(attribute) ? attribute.length : 0.0;
+    }
+    return value;
+  };
+
+  const auto exist = [&attributes](const auto & flag) {
+    return std::any_of(attributes.begin(), attributes.end(), [&flag](const auto & attribute) {
+      return attribute.*flag;
+    });
+  };
+
+  const auto min_max = [&attributes](const auto & min_value_of, const auto & max_value_of) {
+    double min_value = std::numeric_limits<double>::max();
+    double max_value = 0.0;
+    for (const auto & attribute : attributes) {
+      min_value = std::min(min_value, attribute.*min_value_of);
+      max_value = std::max(max_value, attribute.*max_value_of);
+    }
+    return std::make_pair(min_value, max_value);
+  };
+
+  using utils::LaneletAttribute;
+
   ss << "- ROUTE INFO\n";
-  ss << "  total length                      : " << utils::getRouteLength(preferred_lanes)
-     << " [m]\n";
+  ss << "  total length                      : "
+     << length([](const auto &) { return true; }) << " [m]\n";
   ss << "  exist same direction lane section : "
-     << utils::getRouteLengthWithSameDirectionLane(preferred_lanes, route_handler_) << " [m]\n";
+     << length([](const auto & a) { return a.exist_same_direction_lane; }) << " [m]\n";
   ss << "  exist same opposite lane section  : "
-     << utils::getRouteLengthWithOppositeDirectionLane(preferred_lanes, route_handler_) << " [m]\n";
+     << length([](const auto & a) { return a.exist_opposite_direction_lane; }) << " [m]\n";
   ss << "  no adjacent lane section          : "
-     << utils::getRouteLengthWithNoAdjacentLane(preferred_lanes, route_handler_) << " [m]\n";
+     << length([](const auto & a) {
+          return !a.exist_same_direction_lane && !a.exist_opposite_direction_lane;
+        })
+     << " [m]\n";
 
-  ss << "  exist traffic light               : " << utils::existTrafficLight(preferred_lanes)
+  ss << "  exist traffic light               : "
+     << exist(&LaneletAttribute::exist_traffic_light) << "\n";
+  ss << "  exist intersection                : "
+     << exist(&LaneletAttribute::exist_intersection) << "\n";
+  ss << "  exist crosswalk                   : " << exist(&LaneletAttribute::exist_crosswalk)
      << "\n";
-  ss << "  exist intersection                : " << utils::existIntersection(preferred_lanes)
-     << "\n";
-  ss << "  exist crosswalk                   : "
-     << utils::existCrosswalk(preferred_lanes, route_handler_) << "\n";
   ss << "\n";
 
-  const auto [min_width, max_width] = utils::getLaneWidth(preferred_lanes);
+  const auto [min_width, max_width] = min_max(&LaneletAttribute::width, &LaneletAttribute::width);
   ss << "- LANE WIDTH\n";
   ss << "  max                               : " << max_width << " [m]\n";
   ss << "  min                               : " << min_width << " [m]\n";
   ss << "\n";
 
-  const auto max_curvature = utils::getMaxCurvature(preferred_lanes);
+  const auto max_curvature =
+    min_max(&LaneletAttribute::max_curvature, &LaneletAttribute::max_curvature).second;
   ss << "- LANE CURVATURE\n";
   ss << "  max                               : " << max_curvature << " [1/m]\n";
   ss << "  max                               : " << 1.0 / max_curvature << " [m]\n";
   ss << "\n";
 
-  const auto [min_elevation, max_elevation] = utils::getElevation(preferred_lanes);
+  const auto [min_elevation, max_elevation] =
+    min_max(&LaneletAttribute::min_elevation, &LaneletAttribute::max_elevation);
   ss << "- ELEVATION ANGLE\n";
   ss << "  max                               : " << max_elevation << " [rad]\n";
   ss << "  min                               : " << min_elevation << " [rad]\n";
   ss << "\n";
 
   const auto [min_speed_limit, max_speed_limit] =
-    utils::getSpeedLimit(preferred_lanes, route_handler_);
+    min_max(&LaneletAttribute::speed_limit, &LaneletAttribute::speed_limit);
   ss << "- SPEED LIMIT\n";
   ss << "  max                               : " << max_speed_limit << " [m/s]\n";
   ss << "  min                               : " << min_speed_limit << " [m/s]\n";
   ss << "\n";
 
   ss << "***********************************************************\n";
-
-  RCLCPP_INFO_STREAM(logger_, ss.str());
 }
 
 AnalyzerCore::~AnalyzerCore() = default;
@@ -16,6 +16,8 @@
 
 #include "driving_environment_analyzer/analyzer_core.hpp"
 
+#include <algorithm>
+#include <filesystem>
 #include <memory>
 #include <string>
 #include <vector>
@@ -39,7 +41,28 @@ DrivingEnvironmentAnalyzerNode::DrivingEnvironmentAnalyzerNode(
 
   analyzer_ = std::make_shared<analyzer_core::AnalyzerCore>(*this);
 
-  analyzer_->setBagFile(declare_parameter<std::string>("bag_path"));
+  bag_path_ = declare_parameter<std::string>("bag_path");
+  sweep_interval_ = declare_parameter<int64_t>("sweep_interval", 0);
+  sweep_thread_num_ = declare_parameter<int64_t>("sweep_thread_num", 4);
+  bag_thread_num_ = declare_parameter<int64_t>("bag_thread_num", 4);
+  use_bag_cache_ = declare_parameter<bool>("use_bag_cache", false);
+
+  // A directory without its own metadata is a directory of bags, whose routes are aggregated
+  namespace fs = std::filesystem;
+  if (fs::is_directory(bag_path_) && !fs::exists(fs::path(bag_path_) / "metadata.yaml")) {
+    for (const auto & entry : fs::directory_iterator(bag_path_)) {
+      if (entry.is_directory() && fs::exists(entry.path() / "metadata.yaml")) {
+        batch_bag_paths_.push_back(entry.path().string());
+      }
+    }
+    std::sort(batch_bag_paths_.begin(), batch_bag_paths_.end());
+    RCLCPP_INFO_STREAM(
+      get_logger(), "Analyze the routes of " << batch_bag_paths_.size() << " bags in "
+                                             << bag_path_);
+    return;
+  }
+
+  analyzer_->setBagFile(bag_path_, use_bag_cache_);
 }
 
 void DrivingEnvironmentAnalyzerNode::onMap(const LaneletMapBin::ConstSharedPtr msg)
@@ -49,11 +72,31 @@ void DrivingEnvironmentAnalyzerNode::onMap(const LaneletMapBin::ConstSharedPtr m
 
 void DrivingEnvironmentAnalyzerNode::analyze()
 {
+  // The bags share the map of the topic, so only the map is waited for
+  if (!batch_bag_paths_.empty()) {
+    if (!analyzer_->isMapReady()) {
+      return;
+    }
+    analyzer_->analyzeStaticODDFactorOfBags(
+      batch_bag_paths_, static_cast<size_t>(std::max<int64_t>(bag_thread_num_, 1)));
+    rclcpp::shutdown();
+    return;
+  }
+
   if (!analyzer_->isDataReadyForStaticODDAnalysis()) {
     return;
   }
 
   analyzer_->analyzeStaticODDFactor();
+
+  // Dynamic ODD factors of the whole bag, written next to the bag like the RViz panel does
+  if (sweep_interval_ > 0) {
+    autoware::csv_utils::CsvWriter csv_writer(bag_path_ + "_odd.csv");
+    analyzer_->addHeader(csv_writer);
+    analyzer_->analyzeDynamicODDFactorInSweep(
+      csv_writer, sweep_interval_, static_cast<size_t>(std::max<int64_t>(sweep_thread_num_, 1)));
+  }
+
   rclcpp::shutdown();
 }
 }  // namespace driving_environment_analyzer
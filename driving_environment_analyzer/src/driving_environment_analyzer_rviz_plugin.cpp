@@ -14,9 +14,12 @@
 
 #include "driving_environment_analyzer/driving_environment_analyzer_rviz_plugin.hpp"
 
+#include "autoware/tool_tracing/tracing.hpp"
 #include "driving_environment_analyzer/analyzer_core.hpp"
 
+#include <exception>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -103,6 +106,22 @@ DrivingEnvironmentAnalyzerPanel::DrivingEnvironmentAnalyzerPanel(QWidget * paren
     v_layout->addLayout(layout);
   }
 
+  {
+    status_label_ = new QLabel("Ready");
+    status_label_->setAlignment(Qt::AlignLeft);
+    auto * layout = new QHBoxLayout(this);
+    layout->addWidget(new QLabel("Status:"));
+    layout->addWidget(status_label_);
+    v_layout->addLayout(layout);
+  }
+
+  connect(
+    this, SIGNAL(bagOpened(QString, int, int)), SLOT(onBagOpened(QString, int, int)),
+    Qt::QueuedConnection);
+  connect(
+    this, SIGNAL(statusChanged(QString)), status_label_, SLOT(setText(QString)),
+    Qt::QueuedConnection);
+
   setLayout(v_layout);
 }
 
@@ -124,11 +143,16 @@ void DrivingEnvironmentAnalyzerPanel::onInitialize()
   pub_tf_static_ = raw_node_->create_publisher<TFMessage>("/tf_static", rclcpp::QoS(1));
 
   analyzer_ = std::make_shared<analyzer_core::AnalyzerCore>(*raw_node_);
+
+  worker_ = std::thread(&DrivingEnvironmentAnalyzerPanel::work, this);
 }
 
 void DrivingEnvironmentAnalyzerPanel::onMap(const LaneletMapBin::ConstSharedPtr msg)
 {
-  analyzer_->setMap(*msg);
+  Request request;
+  request.type = Request::Type::SET_MAP;
+  request.map = msg;
+  post(request);
 }
 
 void DrivingEnvironmentAnalyzerPanel::onBoxUpdate()
@@ -141,6 +165,11 @@ void DrivingEnvironmentAnalyzerPanel::onSliderUpdate()
 {
   set_format_time(bag_time_line_, bag_time_slider_->value());
   bag_time_selector_->setValue(bag_time_slider_->value());
+
+  // preview the data while the slider is dragged
+  if (bag_time_slider_->isSliderDown()) {
+    onClickSetTimeStamp();
+  }
 }
 
 void DrivingEnvironmentAnalyzerPanel::onSelectDirectory()
@@ -150,16 +179,12 @@ void DrivingEnvironmentAnalyzerPanel::onSelectDirectory()
     return;
   }
 
-  analyzer_->setBagFile(file_name.toStdString());
-
-  ofs_csv_file_ = std::ofstream(
-    file_name.toStdString() + "/" + file_name.split("/").back().toStdString() + "_odd.csv");
-  analyzer_->addHeader(ofs_csv_file_);
-
-  const auto [start_time, end_time] = analyzer_->getBagStartEndTime();
-  bag_time_selector_->setRange(start_time, end_time);
-  bag_time_slider_->setRange(start_time, end_time);
-  bag_name_label_->setText(file_name);
+  Request request;
+  request.type = Request::Type::OPEN_BAG;
+  request.bag_name = file_name.toStdString();
+  request.csv_file_name =
+    file_name.toStdString() + "/" + file_name.split("/").back().toStdString() + "_odd.csv";
+  post(request);
 }
 
 void DrivingEnvironmentAnalyzerPanel::onSelectBagFile()
@@ -171,51 +196,155 @@ void DrivingEnvironmentAnalyzerPanel::onSelectBagFile()
     return;
   }
 
-  analyzer_->setBagFile(file_name.toStdString());
-
-  ofs_csv_file_ = std::ofstream(file_name.toStdString() + "_odd.csv");
-  analyzer_->addHeader(ofs_csv_file_);
+  Request request;
+  request.type = Request::Type::OPEN_BAG;
+  request.bag_name = file_name.toStdString();
+  request.csv_file_name = file_name.toStdString() + "_odd.csv";
+  post(request);
+}
 
-  const auto [start_time, end_time] = analyzer_->getBagStartEndTime();
+void DrivingEnvironmentAnalyzerPanel::onBagOpened(
+  const QString & bag_name, int start_time, int end_time)
+{
   bag_time_selector_->setRange(start_time, end_time);
   bag_time_slider_->setRange(start_time, end_time);
-  bag_name_label_->setText(file_name);
+  bag_name_label_->setText(bag_name);
 }
 
 void DrivingEnvironmentAnalyzerPanel::onClickSetTimeStamp()
 {
-  analyzer_->clearData();
-  analyzer_->setTimeStamp(bag_time_selector_->value());
+  Request request;
+  request.type = Request::Type::SET_TIME_STAMP;
+  request.timestamp = bag_time_selector_->value();
+  post(request);
+}
 
-  if (!analyzer_->isDataReadyForDynamicODDAnalysis()) {
-    return;
-  }
+void DrivingEnvironmentAnalyzerPanel::onClickAnalyzeDynamicODDFactor()
+{
+  Request request;
+  request.type = Request::Type::ANALYZE_DYNAMIC_ODD;
+  post(request);
+}
 
-  pub_odometry_->publish(analyzer_->getOdometry());
-  pub_objects_->publish(analyzer_->getObjects());
-  pub_tf_->publish(analyzer_->getTF());
-  pub_tf_static_->publish(analyzer_->getTFStatic());
+void DrivingEnvironmentAnalyzerPanel::onClickAnalyzeStaticODDFactor()
+{
+  Request request;
+  request.type = Request::Type::ANALYZE_STATIC_ODD;
+  post(request);
 }
 
-void DrivingEnvironmentAnalyzerPanel::onClickAnalyzeDynamicODDFactor()
+void DrivingEnvironmentAnalyzerPanel::post(const Request & request)
 {
-  if (!analyzer_->isDataReadyForDynamicODDAnalysis()) {
-    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // a time stamp replaces the pending one right before it, so that only the latest position of
+    // the slider is analyzed
+    if (
+      request.type == Request::Type::SET_TIME_STAMP && !requests_.empty() &&
+      requests_.back().type == Request::Type::SET_TIME_STAMP) {
+      requests_.back() = request;
+    } else {
+      requests_.push_back(request);
+    }
   }
-
-  analyzer_->analyzeDynamicODDFactor(ofs_csv_file_);
+  cv_.notify_one();
 }
 
-void DrivingEnvironmentAnalyzerPanel::onClickAnalyzeStaticODDFactor()
+void DrivingEnvironmentAnalyzerPanel::work()
 {
-  if (!analyzer_->isDataReadyForStaticODDAnalysis()) {
-    return;
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !requests_.empty(); });
+      if (stop_) return;
+      request = requests_.front();
+      requests_.pop_front();
+    }
+
+    try {
+      process(request);
+    } catch (const std::exception & e) {
+      Q_EMIT statusChanged(QString("Error: ") + e.what());
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (requests_.empty()) {
+      Q_EMIT statusChanged("Ready");
+    }
   }
+}
 
-  analyzer_->analyzeStaticODDFactor();
+void DrivingEnvironmentAnalyzerPanel::process(const Request & request)
+{
+  AUTOWARE_TOOL_TRACING_STAGE("driving_environment_analyzer_panel", "process");
+
+  switch (request.type) {
+    case Request::Type::SET_MAP:
+      analyzer_->setMap(*request.map);
+      break;
+
+    case Request::Type::OPEN_BAG: {
+      Q_EMIT statusChanged(QString::fromStdString("Opening " + request.bag_name));
+      analyzer_->setBagFile(request.bag_name);
+
+      csv_writer_.open(request.csv_file_name);
+      analyzer_->addHeader(csv_writer_);
+
+      const auto [start_time, end_time] = analyzer_->getBagStartEndTime();
+      Q_EMIT bagOpened(
+        QString::fromStdString(request.bag_name), static_cast<int>(start_time),
+        static_cast<int>(end_time));
+      break;
+    }
+
+    case Request::Type::SET_TIME_STAMP:
+      Q_EMIT statusChanged("Seeking");
+      analyzer_->clearData();
+      analyzer_->setTimeStamp(request.timestamp);
+
+      if (!analyzer_->isDataReadyForDynamicODDAnalysis()) {
+        break;
+      }
+
+      pub_odometry_->publish(analyzer_->getOdometry());
+      pub_objects_->publish(analyzer_->getObjects());
+      pub_tf_->publish(analyzer_->getTF());
+      pub_tf_static_->publish(analyzer_->getTFStatic());
+      break;
+
+    case Request::Type::ANALYZE_DYNAMIC_ODD:
+      if (!analyzer_->isDataReadyForDynamicODDAnalysis()) {
+        break;
+      }
+
+      Q_EMIT statusChanged("Analyzing dynamic ODD factor");
+      analyzer_->analyzeDynamicODDFactor(csv_writer_);
+      break;
+
+    case Request::Type::ANALYZE_STATIC_ODD:
+      if (!analyzer_->isDataReadyForStaticODDAnalysis()) {
+        break;
+      }
+
+      Q_EMIT statusChanged("Analyzing static ODD factor");
+      analyzer_->analyzeStaticODDFactor();
+      break;
+  }
 }
 
-DrivingEnvironmentAnalyzerPanel::~DrivingEnvironmentAnalyzerPanel() = default;
+DrivingEnvironmentAnalyzerPanel::~DrivingEnvironmentAnalyzerPanel()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
 }  // namespace driving_environment_analyzer
 
 #include <pluginlib/class_list_macros.hpp>
@@ -16,18 +16,26 @@
 
 #include "autoware/motion_utils/trajectory/trajectory.hpp"
 #include "autoware/universe_utils/geometry/geometry.hpp"
+#include "autoware/universe_utils/math/normalization.hpp"
 
 #include <autoware_lanelet2_extension/regulatory_elements/Forward.hpp>
 #include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <autoware_lanelet2_extension/utility/query.hpp>
 #include <autoware_lanelet2_extension/utility/utilities.hpp>
 #include <magic_enum.hpp>
 
 #include <lanelet2_routing/RoutingGraphContainer.h>
+#include <tf2/utils.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -406,6 +414,37 @@ size_t getObjectNumber(const PredictedObjects & objects, const std::uint8_t targ
     });
 }
 
+void getObjectStatistics(
+  const PredictedObjects & objects, const Pose & ego_pose, ObjectStatistics & statistics)
+{
+  const auto to_bin = [](const auto & edges, const double value) {
+    return static_cast<size_t>(
+      std::distance(edges.begin(), std::upper_bound(edges.begin(), edges.end(), value)));
+  };
+
+  statistics.number.fill(0);
+  statistics.nearest_distance.fill(std::numeric_limits<double>::infinity());
+  statistics.distance_bins.fill(0);
+  statistics.speed_bins.fill(0);
+
+  for (const auto & object : objects.objects) {
+    const auto & kinematics = object.kinematics;
+    const auto label = getHighestProbLabel(object.classification);
+    const auto distance = autoware::universe_utils::calcDistance2d(
+      ego_pose, kinematics.initial_pose_with_covariance.pose);
+    const auto speed = std::abs(kinematics.initial_twist_with_covariance.twist.linear.x);
+
+    if (label < ObjectStatistics::CLASS_NUM) {
+      statistics.number.at(label)++;
+      statistics.nearest_distance.at(label) =
+        std::min(statistics.nearest_distance.at(label), distance);
+    }
+
+    statistics.distance_bins.at(to_bin(ObjectStatistics::DISTANCE_BIN_EDGES, distance))++;
+    statistics.speed_bins.at(to_bin(ObjectStatistics::SPEED_BIN_EDGES, speed))++;
+  }
+}
+
 std::string getLaneShape(const lanelet::ConstLanelet & lane)
 {
   if (isStraightLane(lane)) {
@@ -455,4 +494,171 @@ std::string getEgoBehavior(
 
   return "NONE";
 }
+
+LaneletAttribute calcLaneletAttribute(
+  const lanelet::ConstLanelet & lane, const RouteHandler & route_handler)
+{
+  LaneletAttribute attribute;
+
+  attribute.length = lanelet::utils::getLaneletLength3d(lane);
+  attribute.width = getLaneWidth(lane);
+  attribute.max_curvature = getMaxCurvature({lane});
+  std::tie(attribute.min_elevation, attribute.max_elevation) = getElevation({lane});
+  attribute.speed_limit = route_handler.getTrafficRulesPtr()->speedLimit(lane).speedLimit.value();
+  attribute.left_lanelet_num = getLeftLaneletNum(lane, route_handler);
+  attribute.right_lanelet_num = getRightLaneletNum(lane, route_handler);
+  attribute.exist_same_direction_lane = existSameDirectionLane(lane, route_handler);
+  attribute.exist_opposite_direction_lane = existOppositeDirectionLane(lane, route_handler);
+  attribute.exist_road_shoulder_lane = existRoadShoulderLane(lane, route_handler);
+  attribute.exist_traffic_light = existTrafficLight({lane});
+  attribute.exist_intersection = existIntersection({lane});
+  attribute.exist_crosswalk = existCrosswalk(lane, route_handler);
+
+  return attribute;
+}
+
+LaneletAttributeTable createLaneletAttributeTable(
+  const RouteHandler & route_handler, const size_t thread_num)
+{
+  const auto lanes =
+    lanelet::utils::query::roadLanelets(route_handler.getLaneletMapPtr()->laneletLayer);
+
+  // A missing centerline is computed and stored by the first call, so it is done here before
+  // the lanelets are read by several threads
+  for (const auto & lane : lanes) {
+    lane.centerline();
+  }
+
+  std::vector<LaneletAttribute> attributes(lanes.size());
+  std::atomic<size_t> next_lane(0);
+  std::vector<std::thread> threads;
+
+  auto worker = [&]() {
+    for (size_t i = next_lane++; i < lanes.size(); i = next_lane++) {
+      attributes.at(i) = calcLaneletAttribute(lanes.at(i), route_handler);
+    }
+  };
+  for (size_t t = 1; t < std::max<size_t>(std::min(thread_num, lanes.size()), 1); t++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  LaneletAttributeTable table;
+  table.reserve(lanes.size());
+  for (size_t i = 0; i < lanes.size(); i++) {
+    table.emplace(lanes.at(i).id(), attributes.at(i));
+  }
+
+  return table;
+}
+
+std::vector<LaneletAttribute> getLaneletAttributes(
+  const lanelet::ConstLanelets & lanes, const LaneletAttributeTable & table,
+  const RouteHandler & route_handler)
+{
+  std::vector<LaneletAttribute> attributes;
+  attributes.reserve(lanes.size());
+
+  for (const auto & lane : lanes) {
+    const auto itr = table.find(lane.id());
+    attributes.push_back(
+      itr != table.end() ? itr->second : calcLaneletAttribute(lane, route_handler));
+  }
+
+  return attributes;
+}
+const ClosestLaneletTracker::LaneletCache & ClosestLaneletTracker::getCache(
+  const lanelet::ConstLanelet & lane)
+{
+  const auto itr = caches_.find(lane.id());
+  if (itr != caches_.end()) {
+    return itr->second;
+  }
+
+  LaneletCache cache;
+  for (const auto & p : lane.centerline()) {
+    cache.centerline.push_back(lanelet::utils::conversion::toGeomMsgPt(p));
+  }
+  cache.shape = utils::getLaneShape(lane);
+
+  const auto add_candidate = [&](const lanelet::ConstLanelet & candidate) {
+    if (route_handler_.isRouteLanelet(candidate)) {
+      cache.candidates.push_back(candidate);
+    }
+  };
+  cache.candidates.push_back(lane);
+  for (const auto & next_lane : route_handler_.getNextLanelets(lane)) {
+    add_candidate(next_lane);
+  }
+  for (const auto & prev_lane : route_handler_.getPreviousLanelets(lane)) {
+    add_candidate(prev_lane);
+  }
+  for (const auto & side_lane :
+       {route_handler_.getRightLanelet(lane, true, false),
+        route_handler_.getLeftLanelet(lane, true, false)}) {
+    if (side_lane.has_value()) {
+      add_candidate(side_lane.value());
+    }
+  }
+
+  return caches_.emplace(lane.id(), std::move(cache)).first->second;
+}
+
+bool ClosestLaneletTracker::getClosestLanelet(
+  const Pose & pose, lanelet::ConstLanelet * closest_lanelet)
+{
+  // the lanelets containing the ego are told apart by their direction, as in the search over
+  // the route
+  if (last_lanelet_.has_value()) {
+    const auto ego_yaw = tf2::getYaw(pose.orientation);
+    double min_yaw_diff = std::numeric_limits<double>::max();
+    for (const auto & candidate : getCache(last_lanelet_.value()).candidates) {
+      if (!lanelet::utils::isInLanelet(pose, candidate)) {
+        continue;
+      }
+      const auto lane_yaw = lanelet::utils::getLaneletAngle(candidate, pose.position);
+      const auto yaw_diff =
+        std::abs(autoware::universe_utils::normalizeRadian(lane_yaw - ego_yaw));
+      if (yaw_diff < min_yaw_diff) {
+        min_yaw_diff = yaw_diff;
+        *closest_lanelet = candidate;
+      }
+    }
+    if (min_yaw_diff < std::numeric_limits<double>::max()) {
+      last_lanelet_ = *closest_lanelet;
+      hit_num_++;
+      return true;
+    }
+  }
+
+  miss_num_++;
+  if (!route_handler_.getClosestLaneletWithinRoute(pose, closest_lanelet)) {
+    last_lanelet_ = std::nullopt;
+    return false;
+  }
+  last_lanelet_ = *closest_lanelet;
+  return true;
+}
+
+double ClosestLaneletTracker::calcElevationAngle(
+  const lanelet::ConstLanelet & lane, const Pose & pose)
+{
+  const auto & points = getCache(lane).centerline;
+
+  if (points.size() < 2) {
+    return 0.0;
+  }
+
+  const size_t idx = autoware::motion_utils::findNearestSegmentIndex(points, pose.position);
+
+  return autoware::universe_utils::calcElevationAngle(points.at(idx), points.at(idx + 1));
+}
+
+std::string ClosestLaneletTracker::getLaneShape(const lanelet::ConstLanelet & lane)
+{
+  return getCache(lane).shape;
+}
 }  // namespace driving_environment_analyzer::utils
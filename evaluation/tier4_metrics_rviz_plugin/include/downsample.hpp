@@ -0,0 +1,87 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef DOWNSAMPLE_HPP_
+#define DOWNSAMPLE_HPP_
+
+#include <QPointF>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace rviz_plugins
+{
+
+/**
+ * Downsample the points sorted by x to the columns of a plot, split into bucket_num buckets of
+ * the same width in [x_begin, x_end). Each bucket keeps its first, min, max and last points,
+ * so that the line drawn through them covers the same pixels as the line through all the points.
+ * The points are copied as they are if they already fit.
+ */
+template <typename Container>
+QVector<QPointF> downsampleMinMax(
+  const Container & points, const double x_begin, const double x_end, const size_t bucket_num)
+{
+  const size_t n = points.size();
+  QVector<QPointF> sampled;
+  if (n <= 4 * bucket_num || bucket_num == 0 || !(x_end > x_begin)) {
+    sampled.reserve(static_cast<int>(n));
+    for (size_t i = 0; i < n; ++i) {
+      sampled.push_back(points[i]);
+    }
+    return sampled;
+  }
+
+  sampled.reserve(static_cast<int>(4 * bucket_num + 4));
+  const double bucket_width = (x_end - x_begin) / static_cast<double>(bucket_num);
+  const auto bucket_of = [&](const QPointF & point) {
+    return std::floor((point.x() - x_begin) / bucket_width);
+  };
+
+  size_t first = 0;
+  while (first < n) {
+    const double bucket = bucket_of(points[first]);
+    size_t last = first;
+    size_t min_index = first;
+    size_t max_index = first;
+    while (last + 1 < n && bucket_of(points[last + 1]) == bucket) {
+      ++last;
+      if (points[last].y() < points[min_index].y()) {
+        min_index = last;
+      }
+      if (points[last].y() > points[max_index].y()) {
+        max_index = last;
+      }
+    }
+
+    // in the order of x, without the duplicated points
+    const size_t indices[] = {
+      first, std::min(min_index, max_index), std::max(min_index, max_index), last};
+    size_t previous = n;
+    for (const size_t index : indices) {
+      if (index != previous) {
+        sampled.push_back(points[index]);
+        previous = index;
+      }
+    }
+    first = last + 1;
+  }
+  return sampled;
+}
+}  // namespace rviz_plugins
+
+#endif  // DOWNSAMPLE_HPP_
@@ -0,0 +1,146 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef METRIC_STATISTICS_HPP_
+#define METRIC_STATISTICS_HPP_
+
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+#include <diagnostic_msgs/msg/key_value.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace rviz_plugins
+{
+
+/**
+ * Statistics of the values of a key of a metric since the last reset, i.e. over one period of
+ * the summary. The last value is kept across the resets, so that a summary always has it.
+ */
+class ValueStatistics
+{
+public:
+  void add(const double value)
+  {
+    last_ = value;
+    if (!std::isfinite(value)) {
+      return;
+    }
+    ++count_;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  void reset()
+  {
+    count_ = 0;
+    sum_ = 0.0;
+    min_ = std::numeric_limits<double>::max();
+    max_ = std::numeric_limits<double>::lowest();
+  }
+
+  size_t count() const { return count_; }
+  double last() const { return last_; }
+  double mean() const { return count_ == 0 ? last_ : sum_ / static_cast<double>(count_); }
+  double min() const { return count_ == 0 ? last_ : min_; }
+  double max() const { return count_ == 0 ? last_ : max_; }
+
+private:
+  size_t count_{0};
+  double sum_{0.0};
+  double min_{std::numeric_limits<double>::max()};
+  double max_{std::numeric_limits<double>::lowest()};
+  double last_{std::numeric_limits<double>::quiet_NaN()};
+};
+
+/**
+ * Statistics of the values of a metric, reduced to a status with the last value of each key, as
+ * the raw status has, followed by its "<key>/min", "<key>/max" and "<key>/mean" over the period.
+ * The panel shows a summary like a raw metric, with the extra keys as the envelope of the value.
+ */
+class MetricStatistics
+{
+public:
+  using DiagnosticStatus = diagnostic_msgs::msg::DiagnosticStatus;
+  using KeyValue = diagnostic_msgs::msg::KeyValue;
+
+  void add(const DiagnosticStatus & status)
+  {
+    level_ = status.level;
+    message_ = status.message;
+    hardware_id_ = status.hardware_id;
+    for (const auto & [key, value] : status.values) {
+      double data{};
+      const auto result = std::from_chars(value.data(), value.data() + value.size(), data);
+      if (result.ec != std::errc()) {
+        continue;
+      }
+      values_[key].add(data);
+      updated_ = true;
+    }
+  }
+
+  bool updated() const { return updated_; }
+
+  // the summary of the period, after which the statistics restart
+  DiagnosticStatus summarize(const std::string & name)
+  {
+    DiagnosticStatus status;
+    status.level = level_;
+    status.name = name;
+    status.message = message_;
+    status.hardware_id = hardware_id_;
+    for (auto & [key, statistics] : values_) {
+      status.values.push_back(toKeyValue(key, statistics.last()));
+    }
+    for (auto & [key, statistics] : values_) {
+      status.values.push_back(toKeyValue(key + "/min", statistics.min()));
+      status.values.push_back(toKeyValue(key + "/max", statistics.max()));
+      status.values.push_back(toKeyValue(key + "/mean", statistics.mean()));
+      statistics.reset();
+    }
+    updated_ = false;
+    return status;
+  }
+
+private:
+  static KeyValue toKeyValue(const std::string & key, const double value)
+  {
+    KeyValue key_value;
+    key_value.key = key;
+    std::ostringstream ss;
+    ss << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+    key_value.value = ss.str();
+    return key_value;
+  }
+
+  // sorted by key, so that the order of the values is the same in every summary
+  std::map<std::string, ValueStatistics> values_;
+  DiagnosticStatus::_level_type level_{DiagnosticStatus::OK};
+  std::string message_;
+  std::string hardware_id_;
+  bool updated_{false};
+};
+}  // namespace rviz_plugins
+
+#endif  // METRIC_STATISTICS_HPP_
@@ -27,9 +27,14 @@
 #include <QPainter>
 #include <QPushButton>
 #include <QTableWidget>
+#include <QTimer>
 #include <QVBoxLayout>
 #endif
 
+#include "downsample.hpp"
+#include "spsc_queue.hpp"
+#include "time_series.hpp"
+
 #include <rclcpp/rclcpp.hpp>
 #include <rviz_common/panel.hpp>
 
@@ -37,6 +42,7 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <cmath>
 #include <iostream>
 #include <limits>
 #include <string>
@@ -54,10 +60,21 @@ using QtCharts::QChart;
 using QtCharts::QChartView;
 using QtCharts::QLineSeries;
 
+struct HistoryParameters
+{
+  // duration of the plotted history [s]
+  double duration{100.0};
+  // capacity of the ring of the points kept for each value
+  size_t max_points{10000};
+  // draw the series with OpenGL instead of the raster painter of the chart
+  bool use_opengl{true};
+};
+
 struct Metric
 {
 public:
-  explicit Metric(const DiagnosticStatus & status) : chart(new QChartView), table(new QTableWidget)
+  Metric(const DiagnosticStatus & status, const HistoryParameters & history_parameters)
+  : chart(new QChartView), table(new QTableWidget), history_parameters(history_parameters)
   {
     init(status);
   }
@@ -82,7 +99,9 @@ public:
 
       auto plot = new QLineSeries;
       plot->setName(QString::fromStdString(key));
+      plot->setUseOpenGL(history_parameters.use_opengl);
       plots.emplace(key, plot);
+      histories.emplace(key, TimeSeries(history_parameters.max_points));
       chart->chart()->addSeries(plot);
       chart->chart()->createDefaultAxes();
 
@@ -104,56 +123,104 @@ public:
       table->setRowCount(1);
       table->setSizeAdjustPolicy(QAbstractScrollArea::AdjustToContents);
     }
+
+    {
+      table->setCellWidget(0, 0, labels.at("metric_name"));
+    }
+
+    for (size_t i = 0; i < status.values.size(); ++i) {
+      table->setCellWidget(0, i + 1, labels.at(status.values.at(i).key));
+    }
   }
 
+  // only stores the data, the widgets are redrawn by updateGraph() and updateTable()
   void updateData(const double time, const DiagnosticStatus & status)
   {
     for (const auto & [key, value] : status.values) {
       try {
         const double data = std::stod(value);
-        labels.at(key)->setText(QString::fromStdString(toString(data)));
-        plots.at(key)->append(time, data);
-        updateMinMax(data);
+        latest_values[key] = data;
+        table_dirty = true;
+        if (!std::isfinite(data)) {
+          continue;
+        }
+        // the full ring drops the oldest point by itself
+        auto & history = histories.at(key);
+        history.push(QPointF(time, data));
+        history.popBefore(time - history_parameters.duration);
+        latest_time = time;
+        graph_dirty = true;
       } catch (const std::exception & e) {
         RCLCPP_DEBUG(
           rclcpp::get_logger(__func__), "%s invalid argument. KEY:%s VALUE:%s", e.what(),
           key.c_str(), value.c_str());
       }
     }
+  }
 
-    {
-      const auto area = chart->chart()->plotArea();
-      const auto rect = chart->chart()->legend()->rect();
-      chart->chart()->legend()->setGeometry(
-        QRectF(area.x(), area.y(), area.width(), rect.height()));
-      chart->chart()->axes(Qt::Horizontal).front()->setRange(time - 100.0, time);
-    }
-
-    {
-      table->setCellWidget(0, 0, labels.at("metric_name"));
+  void updateTable()
+  {
+    if (!table_dirty) {
+      return;
     }
 
-    for (size_t i = 0; i < status.values.size(); ++i) {
-      table->setCellWidget(0, i + 1, labels.at(status.values.at(i).key));
+    for (const auto & [key, data] : latest_values) {
+      labels.at(key)->setText(QString::fromStdString(toString(data)));
     }
+    table->update();
+    table_dirty = false;
   }
 
-  void updateMinMax(double data)
+  void updateGraph()
   {
-    if (data < y_range_min) {
-      y_range_min = data > 0.0 ? 0.9 * data : 1.1 * data;
-      chart->chart()->axes(Qt::Vertical).front()->setMin(y_range_min);
+    if (!graph_dirty) {
+      return;
     }
 
-    if (data > y_range_max) {
-      y_range_max = data > 0.0 ? 1.1 * data : 0.9 * data;
-      chart->chart()->axes(Qt::Vertical).front()->setMax(y_range_max);
+    const auto area = chart->chart()->plotArea();
+    const double x_begin = latest_time - history_parameters.duration;
+
+    // replace the whole series at once, which redraws it once instead of once per appended point,
+    // with the points decimated to a few per pixel column
+    double y_min = std::numeric_limits<double>::max();
+    double y_max = std::numeric_limits<double>::lowest();
+    const size_t bucket_num = static_cast<size_t>(std::max(area.width(), 1.0));
+    for (const auto & [key, plot] : plots) {
+      const auto & history = histories.at(key);
+      plot->replace(downsampleMinMax(history, x_begin, latest_time, bucket_num));
+      y_min = std::min(y_min, history.minY());
+      y_max = std::max(y_max, history.maxY());
     }
-  }
 
-  void updateTable() { table->update(); }
+    {
+      const auto rect = chart->chart()->legend()->rect();
+      chart->chart()->legend()->setGeometry(
+        QRectF(area.x(), area.y(), area.width(), rect.height()));
+    }
 
-  void updateGraph() { chart->update(); }
+    // the axes relayout the chart, so that they are only set when their ranges change
+    if (latest_time != x_range_max) {
+      x_range_max = latest_time;
+      chart->chart()->axes(Qt::Horizontal).front()->setRange(x_begin, latest_time);
+    }
+    if (y_min <= y_max) {
+      const double margin =
+        0.1 * std::max({y_max - y_min, std::abs(y_min), std::abs(y_max), 1e-3});
+      const double range_min = y_min - margin;
+      const double range_max = y_max + margin;
+      // keep the range while the values stay in it and fill most of it
+      const bool is_inside = y_range_min <= y_min && y_max <= y_range_max;
+      const bool is_loose = (range_max - range_min) < 0.5 * (y_range_max - y_range_min);
+      if (!is_inside || is_loose) {
+        y_range_min = range_min;
+        y_range_max = range_max;
+        chart->chart()->axes(Qt::Vertical).front()->setRange(y_range_min, y_range_max);
+      }
+    }
+
+    chart->update();
+    graph_dirty = false;
+  }
 
   QChartView * getChartView() const { return chart; }
 
@@ -188,6 +255,17 @@ private:
   std::unordered_map<std::string, QLabel *> labels;
   std::unordered_map<std::string, QLineSeries *> plots;
 
+  HistoryParameters history_parameters;
+  std::unordered_map<std::string, TimeSeries> histories;
+  std::unordered_map<std::string, double> latest_values;
+  double latest_time{0.0};
+
+  // set when the data are updated and cleared when the widgets are redrawn
+  bool graph_dirty{false};
+  bool table_dirty{false};
+
+  // ranges set to the axes
+  double x_range_max{std::numeric_limits<double>::lowest()};
   double y_range_min{std::numeric_limits<double>::max()};
   double y_range_max{std::numeric_limits<double>::lowest()};
 };
@@ -206,22 +284,24 @@ private Q_SLOTS:
   void onSpecificMetricChanged();
   void onClearButtonClicked();
   void onTabChanged();
+  void onTimer();
 
 private:
   // ROS 2 node and subscriptions for handling metrics data
   rclcpp::Node::SharedPtr raw_node_;
-  rclcpp::TimerBase::SharedPtr timer_;
+  QTimer * timer_;
   std::unordered_map<std::string, rclcpp::Subscription<DiagnosticArray>::SharedPtr> subscriptions_;
 
   // Topics from which metrics are collected
   std::vector<std::string> topics_ = {
     "/planning/planning_evaluator/metrics", "/perception/perception_online_evaluator/metrics"};
 
-  // Timer and metrics message callback
-  void onTimer();
+  // Metrics message callback, which only passes the message to the Qt thread
   void onMetrics(const DiagnosticArray::ConstSharedPtr & msg, const std::string & topic_name);
 
   // Functions to update UI based on selected metrics
+  void processMetrics(const DiagnosticArray::ConstSharedPtr & msg, const std::string & topic_name);
+  void redrawVisibleMetrics();
   void updateViews();
   void updateSelectedMetric(const std::string & metric_name);
 
@@ -246,14 +326,18 @@ private:
     std::string, std::unordered_map<std::string, std::pair<QTableWidget *, QChartView *>>>
     topic_widgets_map_;
 
-  // Synchronization
-  std::mutex mutex_;
+  // Messages from the ROS executor thread to the Qt thread. The subscription callbacks are run by
+  // the single executor of the node, so it has a single producer.
+  SpscQueue<std::pair<std::string, DiagnosticArray::ConstSharedPtr>> message_queue_{256};
 
   // Stored metrics data
   std::unordered_map<std::string, Metric> metrics_;
 
   // Metrics configuration
   YAML::Node config_;
+  HistoryParameters history_parameters_;
+  // subscribe to the "<topic>/summary" topics of metrics_aggregator instead of the raw topics
+  bool use_summary_topics_{false};
 
   // Utility functions for managing widget visibility based on topics
   void updateWidgetVisibility(const std::string & target_topic, const bool show);
@@ -0,0 +1,81 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef SPSC_QUEUE_HPP_
+#define SPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+/**
+ * Bounded lock-free queue for one producer thread and one consumer thread.
+ * push() must only be called from the producer and pop() only from the consumer.
+ *
+ * deviation_estimator/include/deviation_estimator/spsc_queue.hpp is a copy of this queue.
+ * Apply any fix to both copies.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+  // one slot is kept empty to distinguish a full queue from an empty one
+  explicit SpscQueue(const size_t capacity) : buffer_(capacity + 1) {}
+
+  // returns false without blocking when the queue is full
+  bool push(T && value)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t next = increment(tail);
+    if (next == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    buffer_[tail] = std::move(value);
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // returns false without blocking when the queue is empty
+  bool pop(T & value)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = std::move(buffer_[head]);
+    buffer_[head] = T{};
+    head_.store(increment(head), std::memory_order_release);
+    return true;
+  }
+
+private:
+  size_t increment(const size_t index) const
+  {
+    return index + 1 == buffer_.size() ? 0 : index + 1;
+  }
+
+  std::vector<T> buffer_;
+
+  // the indices are written by different threads, so keep them on separate cache lines
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+}  // namespace rviz_plugins
+
+#endif  // SPSC_QUEUE_HPP_
@@ -0,0 +1,116 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef TIME_SERIES_HPP_
+#define TIME_SERIES_HPP_
+
+#include <QPointF>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+/**
+ * Points sorted by time in a ring of a fixed capacity, where a push to the full ring drops the
+ * oldest point. The min and max of the values in the ring are kept by monotonic queues, so that
+ * they are updated in amortized constant time as the points are pushed and dropped.
+ */
+class TimeSeries
+{
+public:
+  explicit TimeSeries(const size_t capacity) : points_(std::max<size_t>(capacity, 1)) {}
+
+  void push(const QPointF & point)
+  {
+    if (size() == points_.size()) {
+      popFront();
+    }
+    points_[end_ % points_.size()] = point;
+
+    while (!min_indices_.empty() && pointAt(min_indices_.back()).y() >= point.y()) {
+      min_indices_.pop_back();
+    }
+    min_indices_.push_back(end_);
+    while (!max_indices_.empty() && pointAt(max_indices_.back()).y() <= point.y()) {
+      max_indices_.pop_back();
+    }
+    max_indices_.push_back(end_);
+
+    ++end_;
+  }
+
+  // drops the points older than the time
+  void popBefore(const double time)
+  {
+    while (!empty() && front().x() < time) {
+      popFront();
+    }
+  }
+
+  void clear()
+  {
+    begin_ = end_;
+    min_indices_.clear();
+    max_indices_.clear();
+  }
+
+  size_t size() const { return static_cast<size_t>(end_ - begin_); }
+  bool empty() const { return begin_ == end_; }
+
+  // i-th oldest point
+  const QPointF & operator[](const size_t i) const { return pointAt(begin_ + i); }
+  const QPointF & front() const { return pointAt(begin_); }
+  const QPointF & back() const { return pointAt(end_ - 1); }
+
+  double minY() const
+  {
+    return empty() ? std::numeric_limits<double>::max() : pointAt(min_indices_.front()).y();
+  }
+  double maxY() const
+  {
+    return empty() ? std::numeric_limits<double>::lowest() : pointAt(max_indices_.front()).y();
+  }
+
+private:
+  const QPointF & pointAt(const uint64_t index) const { return points_[index % points_.size()]; }
+
+  void popFront()
+  {
+    if (min_indices_.front() == begin_) {
+      min_indices_.pop_front();
+    }
+    if (max_indices_.front() == begin_) {
+      max_indices_.pop_front();
+    }
+    ++begin_;
+  }
+
+  std::vector<QPointF> points_;
+  // indices of the oldest and the next points, which only grow and are wrapped into the ring
+  uint64_t begin_{0};
+  uint64_t end_{0};
+  // indices of the candidates for the min and the max, whose values are increasing and decreasing
+  std::deque<uint64_t> min_indices_;
+  std::deque<uint64_t> max_indices_;
+};
+}  // namespace rviz_plugins
+
+#endif  // TIME_SERIES_HPP_
@@ -0,0 +1,118 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Reduces the metric topics to "<topic>/summary" topics published at a low rate, on the vehicle,
+// so that the panels of remote operators subscribe to the summaries instead of the raw metrics.
+
+#include "metric_statistics.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rviz_plugins
+{
+using diagnostic_msgs::msg::DiagnosticArray;
+
+class MetricsAggregatorNode : public rclcpp::Node
+{
+public:
+  explicit MetricsAggregatorNode(const rclcpp::NodeOptions & options)
+  : Node("metrics_aggregator", options)
+  {
+    const auto topics = declare_parameter<std::vector<std::string>>(
+      "topics", {"/planning/planning_evaluator/metrics",
+                 "/perception/perception_online_evaluator/metrics"});
+    const auto publish_rate = declare_parameter<double>("publish_rate", 1.0);
+
+    for (const auto & topic_name : topics) {
+      auto & topic = topics_[topic_name];
+      topic.publisher =
+        create_publisher<DiagnosticArray>(topic_name + "/summary", rclcpp::QoS{1});
+      topic.subscription = create_subscription<DiagnosticArray>(
+        topic_name, rclcpp::QoS{1},
+        [this, topic_name](const DiagnosticArray::ConstSharedPtr msg) {
+          onMetrics(msg, topic_name);
+        });
+    }
+
+    // the subscriptions and the timer are in the default callback group, so that they are not
+    // run concurrently and the statistics need no lock
+    const auto period = std::chrono::duration<double>(1.0 / std::max(publish_rate, 1e-3));
+    timer_ = rclcpp::create_timer(
+      this, get_clock(), std::chrono::duration_cast<std::chrono::nanoseconds>(period),
+      [this]() { onTimer(); });
+  }
+
+private:
+  struct Topic
+  {
+    rclcpp::Subscription<DiagnosticArray>::SharedPtr subscription;
+    rclcpp::Publisher<DiagnosticArray>::SharedPtr publisher;
+    std::unordered_map<std::string, MetricStatistics> metrics;
+    // in the order the metrics were received first, which the panel lays out the metrics in
+    std::vector<std::string> metric_names;
+    builtin_interfaces::msg::Time latest_stamp;
+  };
+
+  void onMetrics(const DiagnosticArray::ConstSharedPtr & msg, const std::string & topic_name)
+  {
+    auto & topic = topics_.at(topic_name);
+    for (const auto & status : msg->status) {
+      auto [it, inserted] = topic.metrics.try_emplace(status.name);
+      if (inserted) {
+        topic.metric_names.push_back(status.name);
+      }
+      it->second.add(status);
+    }
+    topic.latest_stamp = msg->header.stamp;
+  }
+
+  void onTimer()
+  {
+    for (auto & [topic_name, topic] : topics_) {
+      auto summary = std::make_unique<DiagnosticArray>();
+      summary->header.stamp = topic.latest_stamp;
+      for (const auto & name : topic.metric_names) {
+        auto & metric = topic.metrics.at(name);
+        if (metric.updated()) {
+          summary->status.push_back(metric.summarize(name));
+        }
+      }
+      if (!summary->status.empty()) {
+        topic.publisher->publish(std::move(summary));
+      }
+    }
+  }
+
+  std::unordered_map<std::string, Topic> topics_;
+  rclcpp::TimerBase::SharedPtr timer_;
+};
+}  // namespace rviz_plugins
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::spin(std::make_shared<rviz_plugins::MetricsAggregatorNode>(rclcpp::NodeOptions{}));
+  rclcpp::shutdown();
+  return 0;
+}
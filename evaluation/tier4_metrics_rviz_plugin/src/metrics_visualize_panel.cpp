@@ -16,6 +16,7 @@
 #include "metrics_visualize_panel.hpp"
 
 #include <ament_index_cpp/get_package_share_directory.hpp>
+#include <autoware/tool_tracing/tracing.hpp>
 #include <rviz_common/display_context.hpp>
 
 #include <X11/Xlib.h>
@@ -74,6 +75,7 @@ MetricsVisualizePanel::MetricsVisualizePanel(QWidget * parent)
 
   tab_widget_->addTab(
     specific_metrics_widget, "Specific Metrics");  // Add "Specific Metrics" tab to the tab widget
+  connect(tab_widget_, SIGNAL(currentChanged(int)), this, SLOT(onTabChanged()));
 
   // Set the main layout of the panel
   QVBoxLayout * main_layout = new QVBoxLayout();
@@ -87,22 +89,44 @@ void MetricsVisualizePanel::onInitialize()
 
   raw_node_ = this->getDisplayContext()->getRosNodeAbstraction().lock()->get_raw_node();
 
+  const std::string yaml_filepath =
+    ament_index_cpp::get_package_share_directory("tier4_metrics_rviz_plugin") +
+    "/config/metrics_visualize_panel.param.yaml";
+  config_ = YAML::LoadFile(yaml_filepath);
+
+  try {
+    if (config_["history_duration"]) {
+      history_parameters_.duration = config_["history_duration"].as<double>();
+    }
+    if (config_["max_history"]) {
+      history_parameters_.max_points = config_["max_history"].as<size_t>();
+    }
+    if (config_["use_opengl"]) {
+      history_parameters_.use_opengl = config_["use_opengl"].as<bool>();
+    }
+    if (config_["use_summary_topics"]) {
+      use_summary_topics_ = config_["use_summary_topics"].as<bool>();
+    }
+  } catch (const YAML::Exception & e) {
+    std::cerr << "YAML error: " << e.what() << std::endl;
+  }
+
+  // the summaries of metrics_aggregator are shown under the names of the raw topics
   for (const auto & topic_name : topics_) {
     const auto callback = [this, topic_name](const DiagnosticArray::ConstSharedPtr msg) {
       this->onMetrics(msg, topic_name);
     };
-    const auto subscription =
-      raw_node_->create_subscription<DiagnosticArray>(topic_name, rclcpp::QoS{1}, callback);
+    const auto subscribed_topic_name = use_summary_topics_ ? topic_name + "/summary" : topic_name;
+    const auto subscription = raw_node_->create_subscription<DiagnosticArray>(
+      subscribed_topic_name, rclcpp::QoS{1}, callback);
     subscriptions_[topic_name] = subscription;
   }
 
+  // the widgets are only touched by the Qt thread, which the Qt timer runs on
   const auto period = std::chrono::milliseconds(static_cast<int64_t>(1e3 / 10));
-  timer_ = raw_node_->create_wall_timer(period, [&]() { onTimer(); });
-
-  const std::string yaml_filepath =
-    ament_index_cpp::get_package_share_directory("tier4_metrics_rviz_plugin") +
-    "/config/metrics_visualize_panel.param.yaml";
-  config_ = YAML::LoadFile(yaml_filepath);
+  timer_ = new QTimer(this);
+  connect(timer_, SIGNAL(timeout()), this, SLOT(onTimer()));
+  timer_->start(static_cast<int>(period.count()));
 }
 
 void MetricsVisualizePanel::updateWidgetVisibility(
@@ -134,20 +158,23 @@ void MetricsVisualizePanel::hideInactiveTopicWidgets()
 
 void MetricsVisualizePanel::onTopicChanged()
 {
-  std::lock_guard<std::mutex> message_lock(mutex_);
   hideInactiveTopicWidgets();
   showCurrentTopicWidgets();
+  redrawVisibleMetrics();
 }
 
-void MetricsVisualizePanel::updateSelectedMetric(const std::string & metric_name)
+void MetricsVisualizePanel::onTabChanged()
 {
-  std::lock_guard<std::mutex> message_lock(mutex_);
+  redrawVisibleMetrics();
+}
 
+void MetricsVisualizePanel::updateSelectedMetric(const std::string & metric_name)
+{
   for (const auto & [topic, msg] : current_msg_map_) {
     const auto time = msg->header.stamp.sec + msg->header.stamp.nanosec * 1e-9;
     for (const auto & status : msg->status) {
       if (metric_name == status.name) {
-        selected_metrics_ = {metric_name, Metric(status)};
+        selected_metrics_ = {metric_name, Metric(status, history_parameters_)};
         selected_metrics_->second.updateData(time, status);
         return;
       }
@@ -171,6 +198,7 @@ void MetricsVisualizePanel::updateViews()
   sizePolicy.setHeightForWidth(specific_metric_table_->sizePolicy().hasHeightForWidth());
   specific_metric_table_->setSizePolicy(sizePolicy);
   specific_metrics_layout->insertWidget(1, specific_metric_table_);
+  redrawVisibleMetrics();
 }
 
 void MetricsVisualizePanel::onSpecificMetricChanged()
@@ -191,14 +219,33 @@ void MetricsVisualizePanel::onClearButtonClicked()
 
 void MetricsVisualizePanel::onTimer()
 {
-  std::lock_guard<std::mutex> message_lock(mutex_);
+  AUTOWARE_TOOL_TRACING_STAGE("metrics_visualize_panel", "on_timer");
+
+  std::pair<std::string, DiagnosticArray::ConstSharedPtr> message;
+  while (message_queue_.pop(message)) {
+    processMetrics(message.second, message.first);
+  }
+
+  redrawVisibleMetrics();
+}
 
-  for (auto & [name, metric] : metrics_) {
-    metric.updateGraph();
-    metric.updateTable();
+void MetricsVisualizePanel::redrawVisibleMetrics()
+{
+  // the hidden metrics stay dirty, and are redrawn once they are shown
+  if (tab_widget_->currentIndex() == 0) {
+    const std::string current_topic = topic_selector_->currentText().toStdString();
+    for (const auto & [name, widgets] : topic_widgets_map_[current_topic]) {
+      Metric & metric = metrics_.at(name);
+      if (widgets.first->isVisible()) {
+        metric.updateTable();
+      }
+      if (widgets.second->isVisible()) {
+        metric.updateGraph();
+      }
+    }
   }
 
-  if (selected_metrics_) {
+  if (tab_widget_->currentIndex() == 1 && selected_metrics_) {
     selected_metrics_->second.updateGraph();
     selected_metrics_->second.updateTable();
   }
@@ -207,15 +254,24 @@ void MetricsVisualizePanel::onTimer()
 void MetricsVisualizePanel::onMetrics(
   const DiagnosticArray::ConstSharedPtr & msg, const std::string & topic_name)
 {
-  std::lock_guard<std::mutex> message_lock(mutex_);
+  // drop the message rather than blocking the executor when the Qt thread falls behind
+  if (!message_queue_.push({topic_name, msg})) {
+    RCLCPP_WARN_THROTTLE(
+      raw_node_->get_logger(), *raw_node_->get_clock(), 5000,
+      "metrics queue is full, dropping a message of %s", topic_name.c_str());
+  }
+}
 
+void MetricsVisualizePanel::processMetrics(
+  const DiagnosticArray::ConstSharedPtr & msg, const std::string & topic_name)
+{
   const auto time = msg->header.stamp.sec + msg->header.stamp.nanosec * 1e-9;
   constexpr size_t GRAPH_COL_SIZE = 5;
 
   for (const auto & status : msg->status) {
     const size_t num_current_metrics = topic_widgets_map_[topic_name].size();
     if (metrics_.count(status.name) == 0) {
-      const auto metric = Metric(status);
+      const auto metric = Metric(status, history_parameters_);
       metrics_.emplace(status.name, metric);
 
       // Calculate grid position
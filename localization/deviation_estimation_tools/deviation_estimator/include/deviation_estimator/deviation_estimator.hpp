@@ -18,9 +18,11 @@
 #include "autoware/universe_utils/ros/transform_listener.hpp"
 #include "deviation_estimator/gyro_bias_module.hpp"
 #include "deviation_estimator/logger.hpp"
+#include "deviation_estimator/spsc_queue.hpp"
 #include "deviation_estimator/utils.hpp"
 #include "deviation_estimator/validation_module.hpp"
 #include "deviation_estimator/velocity_coef_module.hpp"
+#include "diagnostic_updater/diagnostic_updater.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "tf2/utils.h"
 
@@ -32,9 +34,14 @@
 #include "sensor_msgs/msg/imu.hpp"
 #include "std_msgs/msg/float64.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -51,12 +58,77 @@ geometry_msgs::msg::Vector3 estimate_stddev_angular_velocity(
 double estimate_stddev_velocity(
   const std::vector<TrajectoryData> & traj_data_list, const double coef_vx);
 
+// over the first num elements of traj_data_list
+geometry_msgs::msg::Vector3 estimate_stddev_angular_velocity(
+  const std::vector<TrajectoryData> & traj_data_list, const geometry_msgs::msg::Vector3 & gyro_bias,
+  const size_t num);
+
+double estimate_stddev_velocity(
+  const std::vector<TrajectoryData> & traj_data_list, const double coef_vx, const size_t num);
+
+// A finished estimation window, reduced to what the standard deviation estimation needs, so that
+// its trajectory can be released. The gyro error is kept before the bias correction, which is
+// linear in the bias, and the distance from twist with the coefficient of 1, which is linear in the
+// coefficient.
+struct GyroWindowSummary
+{
+  bool valid;  // false if the poses are not in time order
+  double dt_pose;
+  double dt_gyro;
+  size_t n_gyro;
+  geometry_msgs::msg::Vector3 error_rpy_without_bias;
+};
+
+struct VelocityWindowSummary
+{
+  bool valid;  // false if the poses are not in time order
+  double dt_pose;
+  size_t n_vx;
+  double distance;
+  double distance_from_twist_without_coef;
+};
+
+GyroWindowSummary summarize_gyro_window(const TrajectoryData & traj_data);
+
+GyroWindowSummary summarize_gyro_window(const TrajectoryArrays & arrays);
+
+VelocityWindowSummary summarize_velocity_window(const TrajectoryData & traj_data);
+
+VelocityWindowSummary summarize_velocity_window(const TrajectoryArrays & arrays);
+
+geometry_msgs::msg::Vector3 estimate_stddev_angular_velocity(
+  const std::deque<GyroWindowSummary> & window_list, const geometry_msgs::msg::Vector3 & gyro_bias);
+
+double estimate_stddev_velocity(
+  const std::deque<VelocityWindowSummary> & window_list, const double coef_vx);
+
+// over the first num elements of window_list
+geometry_msgs::msg::Vector3 estimate_stddev_angular_velocity(
+  const std::deque<GyroWindowSummary> & window_list, const geometry_msgs::msg::Vector3 & gyro_bias,
+  const size_t num);
+
+double estimate_stddev_velocity(
+  const std::deque<VelocityWindowSummary> & window_list, const double coef_vx, const size_t num);
+
 class DeviationEstimator : public rclcpp::Node
 {
 public:
   DeviationEstimator(const std::string & node_name, const rclcpp::NodeOptions & options);
+  // as a component
+  explicit DeviationEstimator(const rclcpp::NodeOptions & options)
+  : DeviationEstimator("deviation_estimator", options)
+  {
+  }
+  ~DeviationEstimator() override;
 
 private:
+  // the samples of a closed window, handed from the timer to the estimation thread
+  struct EstimationWindow
+  {
+    TrajectoryData traj_data;
+    std::string imu_frame;
+  };
+
   rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr sub_pose_with_cov_;
   rclcpp::Subscription<autoware_vehicle_msgs::msg::VelocityReport>::SharedPtr sub_wheel_odometry_;
   rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr sub_imu_;
@@ -65,17 +137,31 @@ private:
   rclcpp::Publisher<std_msgs::msg::Float64>::SharedPtr pub_stddev_vx_;
   rclcpp::Publisher<geometry_msgs::msg::Vector3>::SharedPtr pub_stddev_angvel_;
   rclcpp::TimerBase::SharedPtr timer_;
+  diagnostic_updater::Updater diagnostic_updater_;
 
   tf2_ros::Buffer tf_buffer_;
   tf2_ros::TransformListener tf_listener_;
 
   std::string imu_link_frame_;
 
-  std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> vx_all_;
-  std::vector<geometry_msgs::msg::Vector3Stamped> gyro_all_;
-  std::vector<geometry_msgs::msg::PoseStamped> pose_buf_;
-  std::vector<TrajectoryData> traj_data_list_for_gyro_;
-  std::vector<TrajectoryData> traj_data_list_for_velocity_;
+  // samples newer than the last estimation window, and at most buffer_duration_ old
+  std::deque<autoware_internal_debug_msgs::msg::Float64Stamped> vx_all_;
+  std::deque<geometry_msgs::msg::Vector3Stamped> gyro_all_;
+  std::deque<geometry_msgs::msg::PoseStamped> pose_buf_;
+  // the last max_window_num_ windows used for the estimation, owned by the estimation thread
+  std::deque<GyroWindowSummary> gyro_window_list_;
+  std::deque<VelocityWindowSummary> velocity_window_list_;
+  // their sizes, for the diagnostics on the executor thread
+  std::atomic<size_t> gyro_window_num_{0};
+  std::atomic<size_t> velocity_window_num_{0};
+
+  // The timer only cuts the closed window out of the buffers, and the estimation, validation and
+  // logging run on estimation_thread_, so the sensor callbacks are not delayed by them
+  SpscQueue<EstimationWindow> window_queue_{8};
+  std::mutex estimation_mutex_;
+  std::condition_variable estimation_condition_;
+  bool is_estimation_stopped_ = false;
+  std::thread estimation_thread_;
 
   double dt_design_;
   double dx_design_;
@@ -84,6 +170,8 @@ private:
   double accel_threshold_;
   double estimation_freq_;
   double time_window_;
+  double buffer_duration_;
+  size_t max_window_num_;
 
   bool gyro_only_use_straight_;
   bool gyro_only_use_moving_;
@@ -97,7 +185,7 @@ private:
   std::string imu_frame_;
   const std::string output_frame_;
   const std::string results_dir_;
-  const Logger results_logger_;
+  Logger results_logger_;
 
   std::unique_ptr<GyroBiasModule> gyro_bias_module_;
   std::unique_ptr<VelocityCoefModule> vel_coef_module_;
@@ -114,6 +202,12 @@ private:
 
   void timer_callback();
 
+  void estimation_loop();
+
+  void estimate_window(const EstimationWindow & window);
+
+  void check_buffer_memory(diagnostic_updater::DiagnosticStatusWrapper & stat);
+
   double add_bias_uncertainty_on_velocity(
     const double stddev_vx, const double stddev_coef_vx) const;
 
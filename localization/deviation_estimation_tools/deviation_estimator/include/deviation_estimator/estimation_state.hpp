@@ -0,0 +1,75 @@
+// Copyright 2018-2019 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVIATION_ESTIMATOR__ESTIMATION_STATE_HPP_
+#define DEVIATION_ESTIMATOR__ESTIMATION_STATE_HPP_
+
+#include "deviation_estimator/deviation_estimator.hpp"
+#include "deviation_estimator/gyro_bias_module.hpp"
+
+#include "geometry_msgs/msg/transform_stamped.hpp"
+
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+// a window used for the estimation, reduced to what it adds to the modules and to the standard
+// deviations, which are sums over the windows
+struct WindowState
+{
+  bool use_velocity = false;
+  bool use_gyro = false;
+  std::optional<double> velocity_coef;
+  GyroBiasObservation gyro_bias{};
+  VelocityWindowSummary velocity_window{};
+  GyroWindowSummary gyro_window{};
+};
+
+// the windows of a bag, and its transform from base_link to the IMU frame
+struct BagState
+{
+  std::string hash;
+  std::string imu_frame_id;
+  geometry_msgs::msg::TransformStamped base_to_imu;
+  std::vector<WindowState> windows;
+};
+
+/**
+ * The windows of the bags already estimated by the unit tool, saved in a text file, so that a
+ * growing collection of bags is estimated by reading only the new bags. The bags are kept in the
+ * order they were added, and the oldest ones are dropped beyond max_bag_num. The state is valid
+ * only for the parameters it was estimated with, which are identified by a signature.
+ */
+class EstimationState
+{
+public:
+  explicit EstimationState(const std::string & signature) : signature_(signature) {}
+
+  // false if there is no state, or it is broken or from other parameters, which leaves it empty
+  bool load(const std::string & path);
+  bool save(const std::string & path) const;
+
+  bool contains(const std::string & hash) const;
+  // 0 keeps all bags
+  void add(BagState && bag, const size_t max_bag_num);
+
+  const std::deque<BagState> & bags() const { return bags_; }
+
+private:
+  std::string signature_;
+  std::deque<BagState> bags_;
+};
+
+#endif  // DEVIATION_ESTIMATOR__ESTIMATION_STATE_HPP_
@@ -21,19 +21,33 @@
 #include "geometry_msgs/msg/vector3_stamped.hpp"
 
 #include <utility>
-#include <vector>
+
+// what a window adds to the bias estimation: the error of the integrated angular velocity over the
+// duration of the window
+struct GyroBiasObservation
+{
+  double dt;
+  geometry_msgs::msg::Vector3 error_rpy;
+};
+
+GyroBiasObservation observe_gyro_bias(const TrajectoryArrays & arrays);
 
 class GyroBiasModule
 {
 public:
   GyroBiasModule() = default;
   void update_bias(const TrajectoryData & traj_data);
+  void update_bias(const TrajectoryArrays & arrays);
+  void update_bias(const GyroBiasObservation & observation);
   geometry_msgs::msg::Vector3 get_bias_base_link() const;
   geometry_msgs::msg::Vector3 get_bias_std() const;
   bool empty() const;
 
 private:
-  std::vector<geometry_msgs::msg::Vector3> gyro_bias_list_;
+  // of the bias of each trajectory
+  RunningStatistics gyro_bias_x_stat_;
+  RunningStatistics gyro_bias_y_stat_;
+  RunningStatistics gyro_bias_z_stat_;
   std::pair<geometry_msgs::msg::Vector3, geometry_msgs::msg::Vector3> gyro_bias_pair_;
 };
 
@@ -22,22 +22,50 @@
 
 #include <fmt/core.h>
 
-#include <fstream>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
+/**
+ * The results are formatted by the caller and written by a background thread, so a slow storage
+ * does not block the estimation. Each file is replaced atomically by a temporary file, at most
+ * once per min_write_interval, with the latest results. The pending results are written at the
+ * destruction.
+ */
 class Logger
 {
 public:
-  explicit Logger(const std::string & output_dir);
+  explicit Logger(const std::string & output_dir, const double min_write_interval = 1.0);
+  ~Logger();
+  Logger(const Logger &) = delete;
+  Logger & operator=(const Logger &) = delete;
+
   void log_estimated_result_section(
     const double stddev_vx, const double coef_vx,
     const geometry_msgs::msg::Vector3 & angular_velocity_stddev,
-    const geometry_msgs::msg::Vector3 & angular_velocity_offset) const;
-  void log_validation_result_section(const ValidationModule & validation_module) const;
+    const geometry_msgs::msg::Vector3 & angular_velocity_offset);
+  void log_validation_result_section(const ValidationModule & validation_module);
 
 private:
-  const std::string output_log_path_;
-  const std::string output_imu_param_path_;
-  const std::string output_velocity_param_path_;
+  struct OutputFile
+  {
+    std::string path;
+    std::string contents;
+    bool is_pending = false;
+  };
+  enum OutputFileIndex { LOG = 0, IMU_PARAM, VELOCITY_PARAM, OUTPUT_FILE_NUM };
+
+  void update(const OutputFileIndex index, std::string && contents);
+  void write_loop();
+
+  const std::chrono::duration<double> min_write_interval_;
+  std::array<OutputFile, OUTPUT_FILE_NUM> files_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool is_stopped_ = false;
+  std::thread writer_;
 };
 #endif  // DEVIATION_ESTIMATOR__LOGGER_HPP_
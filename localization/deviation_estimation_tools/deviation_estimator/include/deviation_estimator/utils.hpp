@@ -43,6 +43,31 @@ struct TrajectoryData
   std::vector<geometry_msgs::msg::Vector3Stamped> gyro_list;
 };
 
+/**
+ * @brief the signals of a trajectory in arrays of doubles, converted once from the messages so
+ * that the integrations over it do not convert the stamps and quaternions per element. The times
+ * are in seconds from the first pose, which keeps their precision.
+ */
+struct TrajectoryArrays
+{
+  std::vector<double> vx_t;
+  std::vector<double> vx;
+  std::vector<double> gyro_t;
+  std::vector<double> wx;
+  std::vector<double> wy;
+  std::vector<double> wz;
+  // only the first and last poses are used
+  double pose_t_front = 0.0;
+  double pose_t_back = 0.0;
+  geometry_msgs::msg::Point position_front;
+  geometry_msgs::msg::Point position_back;
+  geometry_msgs::msg::Vector3 rpy_front;
+  geometry_msgs::msg::Vector3 rpy_back;
+  double yaw_front = 0.0;
+};
+
+TrajectoryArrays to_trajectory_arrays(const TrajectoryData & traj_data);
+
 double double_round(const double x, const int n);
 
 bool whether_to_use_data(
@@ -93,6 +118,37 @@ double calculate_std_mean_const(const std::vector<T> & v, const double mean)
   return std::sqrt(error / v.size());
 }
 
+/**
+ * @brief running mean and sum of the squared deviations of a sequence, by Welford's method
+ */
+struct RunningStatistics
+{
+  std::size_t count = 0;
+  double mean = 0.0;
+  double m2 = 0.0;
+
+  void add(const double x)
+  {
+    ++count;
+    const double delta = x - mean;
+    mean += delta / count;
+    m2 += delta * (x - mean);
+  }
+
+  // the same as calculate_std of the sequence
+  double std() const { return count == 0 ? 0.0 : std::sqrt(m2 / count); }
+
+  // the same as calculate_std_mean_const of the sequence
+  double std_mean_const(const double mean_const) const
+  {
+    if (count == 0) {
+      return 0.0;
+    }
+    const double d = mean - mean_const;
+    return std::sqrt(m2 / count + d * d);
+  }
+};
+
 struct CompareMsgTimestamp
 {
   bool operator()(
@@ -142,15 +198,35 @@ geometry_msgs::msg::Vector3 interpolate_vector3_stamped(
   const std::vector<geometry_msgs::msg::Vector3Stamped> & vec_list, const double time,
   const double tolerance_sec);
 
-template <typename T>
-std::vector<T> extract_sub_trajectory(
-  const std::vector<T> & msg_list, const rclcpp::Time & t0, const rclcpp::Time & t1)
+/**
+ * @brief interpolator on "vec_list" with its stamps converted once, for the queries in the order of
+ * the time, e.g. along another message list
+ */
+class Vector3StampedInterpolator
+{
+public:
+  explicit Vector3StampedInterpolator(
+    const std::vector<geometry_msgs::msg::Vector3Stamped> & vec_list,
+    const double tolerance_sec = 0.1);
+  geometry_msgs::msg::Vector3 interpolate(const double time);
+
+private:
+  const std::vector<geometry_msgs::msg::Vector3Stamped> & vec_list_;
+  std::vector<double> time_list_;
+  double tolerance_sec_;
+  // the upper bound of the last query time in time_list_
+  std::size_t next_idx_ = 0;
+};
+
+template <typename Container>
+std::vector<typename Container::value_type> extract_sub_trajectory(
+  const Container & msg_list, const rclcpp::Time & t0, const rclcpp::Time & t1)
 {
   const auto start_iter =
     std::lower_bound(msg_list.begin(), msg_list.end(), t0, CompareMsgTimestamp());
   const auto end_iter =
     std::lower_bound(msg_list.begin(), msg_list.end(), t1, CompareMsgTimestamp());
-  std::vector<T> msg_list_sub(start_iter, end_iter);
+  std::vector<typename Container::value_type> msg_list_sub(start_iter, end_iter);
   return msg_list_sub;
 }
 
@@ -169,20 +245,32 @@ geometry_msgs::msg::Point integrate_position(
   const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list, const double coef_vx,
   const double yaw_init);
 
+geometry_msgs::msg::Point integrate_position(
+  const TrajectoryArrays & arrays, const double coef_vx, const double yaw_init);
+
 geometry_msgs::msg::Vector3 calculate_error_rpy(
   const std::vector<geometry_msgs::msg::PoseStamped> & pose_list,
   const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list,
   const geometry_msgs::msg::Vector3 & gyro_bias);
 
+geometry_msgs::msg::Vector3 calculate_error_rpy(
+  const TrajectoryArrays & arrays, const geometry_msgs::msg::Vector3 & gyro_bias);
+
 geometry_msgs::msg::Vector3 integrate_orientation(
   const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list,
   const geometry_msgs::msg::Vector3 & gyro_bias);
 
+geometry_msgs::msg::Vector3 integrate_orientation(
+  const TrajectoryArrays & arrays, const geometry_msgs::msg::Vector3 & gyro_bias);
+
 double get_mean_abs_vx(
   const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list);
 double get_mean_abs_wz(const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list);
 double get_mean_accel(
   const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list);
+double get_mean_abs_vx(const TrajectoryArrays & arrays);
+double get_mean_abs_wz(const TrajectoryArrays & arrays);
+double get_mean_accel(const TrajectoryArrays & arrays);
 
 geometry_msgs::msg::Vector3 transform_vector3(
   const geometry_msgs::msg::Vector3 & vec, const geometry_msgs::msg::TransformStamped & transform);
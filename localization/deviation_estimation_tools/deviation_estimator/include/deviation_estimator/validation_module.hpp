@@ -21,15 +21,49 @@
 
 #include <fmt/core.h>
 
+#include <array>
+#include <deque>
 #include <limits>
-#include <map>
 #include <string>
 #include <utility>
-#include <vector>
+
+/**
+ * @brief min and max of the last window_size values, kept by monotonic deques so that both a push
+ * and a query take O(1) amortized time
+ */
+class SlidingMinMax
+{
+public:
+  explicit SlidingMinMax(const size_t window_size);
+  void push_back(const double value);
+  std::pair<double, double> get_min_max() const;
+  size_t size() const { return count_; }
+  double back() const { return last_value_; }
+
+private:
+  // (index, value) pairs, whose values increase (decrease) from the front
+  std::deque<std::pair<size_t, double>> min_candidates_;
+  std::deque<std::pair<size_t, double>> max_candidates_;
+  size_t window_size_;
+  size_t count_ = 0;
+  double last_value_ = 0.0;
+};
 
 class ValidationModule
 {
 public:
+  enum Item {
+    COEF_VX = 0,
+    STDDEV_VX,
+    ANGULAR_VELOCITY_OFFSET_X,
+    ANGULAR_VELOCITY_OFFSET_Y,
+    ANGULAR_VELOCITY_OFFSET_Z,
+    ANGULAR_VELOCITY_STDDEV_XX,
+    ANGULAR_VELOCITY_STDDEV_YY,
+    ANGULAR_VELOCITY_STDDEV_ZZ,
+    ITEM_NUM
+  };
+
   ValidationModule(
     const double threshold_coef_vx, const double threshold_stddev_vx,
     const double threshold_bias_gyro, const double threshold_stddev_gyro, const size_t num_history);
@@ -37,13 +71,18 @@ public:
   void set_gyro_data(
     const geometry_msgs::msg::Vector3 & bias_gyro, const geometry_msgs::msg::Vector3 & stddev_gyro);
 
+  std::pair<double, double> get_min_max(const Item item) const;
+  bool is_valid(const Item item) const;
   std::pair<double, double> get_min_max(const std::string key) const;
   bool is_valid(const std::string key) const;
 
+  static const char * get_name(const Item item);
+
 private:
-  std::map<std::string, std::vector<double>> data_list_dict_;
+  static Item to_item(const std::string & key);
 
-  std::map<std::string, double> threshold_dict_;
+  std::array<SlidingMinMax, ITEM_NUM> histories_;
+  std::array<double, ITEM_NUM> thresholds_;
   const size_t num_history_;
 };
 
@@ -21,20 +21,27 @@
 #include "geometry_msgs/msg/pose_stamped.hpp"
 #include "geometry_msgs/msg/vector3_stamped.hpp"
 
+#include <optional>
 #include <utility>
-#include <vector>
+
+// what a window adds to the coefficient estimation: the ratio of the distance from the poses to
+// the one from the velocities, none if the latter is zero
+std::optional<double> observe_velocity_coef(const TrajectoryArrays & arrays);
 
 class VelocityCoefModule
 {
 public:
   VelocityCoefModule() = default;
   void update_coef(const TrajectoryData & traj_data);
+  void update_coef(const TrajectoryArrays & arrays);
+  void update_coef(const double d_coef_vx);
   double get_coef() const;
   double get_coef_std() const;
   bool empty() const;
 
 private:
-  std::vector<double> coef_vx_list_;
+  // of the coefficient of each trajectory
+  RunningStatistics coef_vx_stat_;
   std::pair<double, double> coef_vx_;
 };
 
@@ -14,14 +14,17 @@
 
 #include "deviation_estimator/deviation_estimator.hpp"
 
+#include "autoware/tool_tracing/tracing.hpp"
 #include "autoware/universe_utils/geometry/geometry.hpp"
 #include "deviation_estimator/logger.hpp"
 #include "deviation_estimator/utils.hpp"
 #include "rclcpp/logging.hpp"
 
 #include <algorithm>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -31,41 +34,122 @@ using std::placeholders::_1;
 geometry_msgs::msg::Vector3 estimate_stddev_angular_velocity(
   const std::vector<TrajectoryData> & traj_data_list, const geometry_msgs::msg::Vector3 & gyro_bias)
 {
-  if (traj_data_list.size() == 0) return geometry_msgs::msg::Vector3{};
+  return estimate_stddev_angular_velocity(traj_data_list, gyro_bias, traj_data_list.size());
+}
+
+geometry_msgs::msg::Vector3 estimate_stddev_angular_velocity(
+  const std::vector<TrajectoryData> & traj_data_list, const geometry_msgs::msg::Vector3 & gyro_bias,
+  const size_t num)
+{
+  std::deque<GyroWindowSummary> window_list;
+  for (size_t i = 0; i < num; ++i) {
+    window_list.push_back(summarize_gyro_window(traj_data_list[i]));
+  }
+  return estimate_stddev_angular_velocity(window_list, gyro_bias);
+}
+
+double estimate_stddev_velocity(
+  const std::vector<TrajectoryData> & traj_data_list, const double coef_vx)
+{
+  return estimate_stddev_velocity(traj_data_list, coef_vx, traj_data_list.size());
+}
+
+double estimate_stddev_velocity(
+  const std::vector<TrajectoryData> & traj_data_list, const double coef_vx, const size_t num)
+{
+  std::deque<VelocityWindowSummary> window_list;
+  for (size_t i = 0; i < num; ++i) {
+    window_list.push_back(summarize_velocity_window(traj_data_list[i]));
+  }
+  return estimate_stddev_velocity(window_list, coef_vx);
+}
+
+GyroWindowSummary summarize_gyro_window(const TrajectoryData & traj_data)
+{
+  return summarize_gyro_window(to_trajectory_arrays(traj_data));
+}
+
+GyroWindowSummary summarize_gyro_window(const TrajectoryArrays & arrays)
+{
+  GyroWindowSummary window;
+  window.valid = arrays.pose_t_front <= arrays.pose_t_back;
+  window.dt_pose = arrays.pose_t_back - arrays.pose_t_front;
+  if (!window.valid) return window;
+
+  window.n_gyro = arrays.gyro_t.size();
+  window.dt_gyro = arrays.gyro_t.back() - arrays.gyro_t.front();
+  const geometry_msgs::msg::Vector3 & rpy_0 = arrays.rpy_front;
+  const geometry_msgs::msg::Vector3 & rpy_1 = arrays.rpy_back;
+  const geometry_msgs::msg::Vector3 d_rpy =
+    integrate_orientation(arrays, createVector3(0.0, 0.0, 0.0));
+  window.error_rpy_without_bias = createVector3(
+    -rpy_1.x + rpy_0.x + d_rpy.x, -rpy_1.y + rpy_0.y + d_rpy.y, -rpy_1.z + rpy_0.z + d_rpy.z);
+  return window;
+}
+
+VelocityWindowSummary summarize_velocity_window(const TrajectoryData & traj_data)
+{
+  return summarize_velocity_window(to_trajectory_arrays(traj_data));
+}
+
+VelocityWindowSummary summarize_velocity_window(const TrajectoryArrays & arrays)
+{
+  VelocityWindowSummary window;
+  window.valid = arrays.pose_t_front <= arrays.pose_t_back;
+  window.dt_pose = arrays.pose_t_back - arrays.pose_t_front;
+  if (!window.valid) return window;
+
+  window.n_vx = arrays.vx_t.size();
+  window.distance = norm_xy(arrays.position_front, arrays.position_back);
+  const auto d_pos = integrate_position(arrays, 1.0, arrays.yaw_front);
+  const double dt_velocity = arrays.vx_t.back() - arrays.vx_t.front();
+  window.distance_from_twist_without_coef =
+    std::sqrt(d_pos.x * d_pos.x + d_pos.y * d_pos.y) * window.dt_pose / dt_velocity;
+  return window;
+}
+
+geometry_msgs::msg::Vector3 estimate_stddev_angular_velocity(
+  const std::deque<GyroWindowSummary> & window_list, const geometry_msgs::msg::Vector3 & gyro_bias)
+{
+  return estimate_stddev_angular_velocity(window_list, gyro_bias, window_list.size());
+}
+
+double estimate_stddev_velocity(
+  const std::deque<VelocityWindowSummary> & window_list, const double coef_vx)
+{
+  return estimate_stddev_velocity(window_list, coef_vx, window_list.size());
+}
+
+geometry_msgs::msg::Vector3 estimate_stddev_angular_velocity(
+  const std::deque<GyroWindowSummary> & window_list, const geometry_msgs::msg::Vector3 & gyro_bias,
+  const size_t num)
+{
+  if (num == 0) return geometry_msgs::msg::Vector3{};
 
   double t_window = 0.0;
-  for (const TrajectoryData & traj_data : traj_data_list) {
-    const rclcpp::Time t0_rclcpp_time = rclcpp::Time(traj_data.pose_list.front().header.stamp);
-    const rclcpp::Time t1_rclcpp_time = rclcpp::Time(traj_data.pose_list.back().header.stamp);
-    t_window += t1_rclcpp_time.seconds() - t0_rclcpp_time.seconds();
+  for (size_t i = 0; i < num; ++i) {
+    t_window += window_list[i].dt_pose;
   }
-  t_window /= traj_data_list.size();
+  t_window /= num;
 
   std::vector<double> delta_wx_list;
   std::vector<double> delta_wy_list;
   std::vector<double> delta_wz_list;
 
-  for (const TrajectoryData & traj_data : traj_data_list) {
-    const auto t1_pose = rclcpp::Time(traj_data.pose_list.back().header.stamp);
-    const auto t0_pose = rclcpp::Time(traj_data.pose_list.front().header.stamp);
-    if (t0_pose > t1_pose) continue;
-
-    const size_t n_twist = traj_data.gyro_list.size();
-
-    auto error_rpy = calculate_error_rpy(traj_data.pose_list, traj_data.gyro_list, gyro_bias);
-    const double dt_pose = (rclcpp::Time(traj_data.pose_list.back().header.stamp) -
-                            rclcpp::Time(traj_data.pose_list.front().header.stamp))
-                             .seconds();
-    const double dt_gyro = (rclcpp::Time(traj_data.gyro_list.back().header.stamp) -
-                            rclcpp::Time(traj_data.gyro_list.front().header.stamp))
-                             .seconds();
-    error_rpy.x *= dt_pose / dt_gyro;
-    error_rpy.y *= dt_pose / dt_gyro;
-    error_rpy.z *= dt_pose / dt_gyro;
-
-    delta_wx_list.push_back(std::sqrt(n_twist / t_window) * error_rpy.x);
-    delta_wy_list.push_back(std::sqrt(n_twist / t_window) * error_rpy.y);
-    delta_wz_list.push_back(std::sqrt(n_twist / t_window) * error_rpy.z);
+  for (size_t i = 0; i < num; ++i) {
+    const GyroWindowSummary & window = window_list[i];
+    if (!window.valid) continue;
+
+    // the bias is integrated over the gyro duration
+    const geometry_msgs::msg::Vector3 & e = window.error_rpy_without_bias;
+    const double scale = window.dt_pose / window.dt_gyro;
+    const double error_x = clip_radian(e.x - gyro_bias.x * window.dt_gyro) * scale;
+    const double error_y = clip_radian(e.y - gyro_bias.y * window.dt_gyro) * scale;
+    const double error_z = clip_radian(e.z - gyro_bias.z * window.dt_gyro) * scale;
+
+    delta_wx_list.push_back(std::sqrt(window.n_gyro / t_window) * error_x);
+    delta_wy_list.push_back(std::sqrt(window.n_gyro / t_window) * error_y);
+    delta_wz_list.push_back(std::sqrt(window.n_gyro / t_window) * error_z);
   }
 
   geometry_msgs::msg::Vector3 stddev_angvel_base = createVector3(
@@ -76,51 +160,46 @@ geometry_msgs::msg::Vector3 estimate_stddev_angular_velocity(
 }
 
 double estimate_stddev_velocity(
-  const std::vector<TrajectoryData> & traj_data_list, const double coef_vx)
+  const std::deque<VelocityWindowSummary> & window_list, const double coef_vx, const size_t num)
 {
-  if (traj_data_list.size() == 0) return 0.0;
+  if (num == 0) return 0.0;
 
   double t_window = 0.0;
-  for (const TrajectoryData & traj_data : traj_data_list) {
-    const rclcpp::Time t0_rclcpp_time = rclcpp::Time(traj_data.pose_list.front().header.stamp);
-    const rclcpp::Time t1_rclcpp_time = rclcpp::Time(traj_data.pose_list.back().header.stamp);
-    t_window += t1_rclcpp_time.seconds() - t0_rclcpp_time.seconds();
+  for (size_t i = 0; i < num; ++i) {
+    t_window += window_list[i].dt_pose;
   }
-  t_window /= traj_data_list.size();
+  t_window /= num;
 
   std::vector<double> delta_x_list;
 
-  for (const TrajectoryData & traj_data : traj_data_list) {
-    const auto t1_pose = rclcpp::Time(traj_data.pose_list.back().header.stamp);
-    const auto t0_pose = rclcpp::Time(traj_data.pose_list.front().header.stamp);
-    if (t0_pose > t1_pose) continue;
-
-    const size_t n_twist = traj_data.vx_list.size();
-
-    const double distance =
-      norm_xy(traj_data.pose_list.front().pose.position, traj_data.pose_list.back().pose.position);
-    const auto d_pos = integrate_position(
-      traj_data.vx_list, traj_data.gyro_list, coef_vx,
-      tf2::getYaw(traj_data.pose_list.front().pose.orientation));
-
-    const double dt_pose = (rclcpp::Time(traj_data.pose_list.back().header.stamp) -
-                            rclcpp::Time(traj_data.pose_list.front().header.stamp))
-                             .seconds();
-    const double dt_velocity =
-      (rclcpp::Time(traj_data.vx_list.back().stamp) - rclcpp::Time(traj_data.vx_list.front().stamp))
-        .seconds();
-    const double distance_from_twist =
-      std::sqrt(d_pos.x * d_pos.x + d_pos.y * d_pos.y) * dt_pose / dt_velocity;
-
-    const double delta = std::sqrt(n_twist / t_window) * (distance - distance_from_twist);
+  for (size_t i = 0; i < num; ++i) {
+    const VelocityWindowSummary & window = window_list[i];
+    if (!window.valid) continue;
+
+    const double distance_from_twist = std::abs(coef_vx) * window.distance_from_twist_without_coef;
+    const double delta =
+      std::sqrt(window.n_vx / t_window) * (window.distance - distance_from_twist);
     delta_x_list.push_back(delta);
   }
   return calculate_std(delta_x_list) / std::sqrt(t_window);
 }
 
+namespace
+{
+// drop the messages older than t from the front of a buffer in time order
+template <typename Container>
+void remove_older_than(Container & msg_list, const rclcpp::Time & t)
+{
+  const auto end_iter =
+    std::lower_bound(msg_list.begin(), msg_list.end(), t, CompareMsgTimestamp());
+  msg_list.erase(msg_list.begin(), end_iter);
+}
+}  // namespace
+
 DeviationEstimator::DeviationEstimator(
   const std::string & node_name, const rclcpp::NodeOptions & node_options)
 : rclcpp::Node(node_name, node_options),
+  diagnostic_updater_(this),
   tf_buffer_(this->get_clock()),
   tf_listener_(tf_buffer_),
   output_frame_(declare_parameter<std::string>("output_frame")),
@@ -133,6 +212,8 @@ DeviationEstimator::DeviationEstimator(
   wz_threshold_ = declare_parameter<double>("wz_threshold");
   accel_threshold_ = declare_parameter<double>("accel_threshold");
   time_window_ = declare_parameter<double>("time_window");
+  buffer_duration_ = declare_parameter<double>("buffer_duration");
+  max_window_num_ = static_cast<size_t>(declare_parameter<int>("max_window_num"));
 
   // flags for deciding which trajectory to use
   gyro_only_use_straight_ = declare_parameter<bool>("gyro_estimation.only_use_straight");
@@ -180,9 +261,24 @@ DeviationEstimator::DeviationEstimator(
     5);
   transform_listener_ = std::make_shared<autoware::universe_utils::TransformListener>(this);
 
+  diagnostic_updater_.setHardwareID("deviation_estimator");
+  diagnostic_updater_.add("buffer_memory", this, &DeviationEstimator::check_buffer_memory);
+
+  estimation_thread_ = std::thread(&DeviationEstimator::estimation_loop, this);
+
   RCLCPP_INFO(this->get_logger(), "[Deviation Estimator] launch success");
 }
 
+DeviationEstimator::~DeviationEstimator()
+{
+  {
+    std::lock_guard<std::mutex> lock(estimation_mutex_);
+    is_estimation_stopped_ = true;
+  }
+  estimation_condition_.notify_one();
+  estimation_thread_.join();
+}
+
 /**
  * @brief receive ground-truth pose (e.g. NDT pose) data
  */
@@ -194,6 +290,8 @@ void DeviationEstimator::callback_pose_with_covariance(
   pose.header = msg->header;
   pose.pose = msg->pose.pose;
   pose_buf_.push_back(pose);
+  remove_older_than(
+    pose_buf_, rclcpp::Time(pose.header.stamp) - rclcpp::Duration::from_seconds(buffer_duration_));
 }
 
 /**
@@ -207,6 +305,8 @@ void DeviationEstimator::callback_wheel_odometry(
   vx.data = wheel_odometry_msg_ptr->longitudinal_velocity;
 
   vx_all_.push_back(vx);
+  remove_older_than(
+    vx_all_, rclcpp::Time(vx.stamp) - rclcpp::Duration::from_seconds(buffer_duration_));
 }
 
 /**
@@ -229,13 +329,19 @@ void DeviationEstimator::callback_imu(const sensor_msgs::msg::Imu::ConstSharedPt
   gyro.vector = transform_vector3(imu_msg_ptr->angular_velocity, *tf_imu2base_ptr);
 
   gyro_all_.push_back(gyro);
+  remove_older_than(
+    gyro_all_,
+    rclcpp::Time(gyro.header.stamp) - rclcpp::Duration::from_seconds(buffer_duration_));
 }
 
 /**
- * @brief process the stored IMU, velocity, and pose data to estimate bias and standard deviation
+ * @brief cut the stored IMU, velocity, and pose data of the closed window, and hand them to the
+ * estimation thread
  */
 void DeviationEstimator::timer_callback()
 {
+  AUTOWARE_TOOL_TRACING_STAGE("deviation_estimator", "timer_callback");
+
   if (gyro_all_.empty()) {
     RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "No IMU data");
     return;
@@ -249,13 +355,60 @@ void DeviationEstimator::timer_callback()
   rclcpp::Time t1_rclcpp_time = rclcpp::Time(pose_buf_.back().header.stamp);
   if (t1_rclcpp_time <= t0_rclcpp_time) return;
 
-  TrajectoryData traj_data;
-  traj_data.pose_list = pose_buf_;
-  traj_data.vx_list = extract_sub_trajectory(vx_all_, t0_rclcpp_time, t1_rclcpp_time);
-  traj_data.gyro_list = extract_sub_trajectory(gyro_all_, t0_rclcpp_time, t1_rclcpp_time);
-  bool is_straight = get_mean_abs_wz(traj_data.gyro_list) < wz_threshold_;
-  bool is_moving = get_mean_abs_vx(traj_data.vx_list) > vx_threshold_;
-  bool is_constant_velocity = std::abs(get_mean_accel(traj_data.vx_list)) < accel_threshold_;
+  EstimationWindow window;
+  window.traj_data.pose_list.assign(pose_buf_.begin(), pose_buf_.end());
+  window.traj_data.vx_list = extract_sub_trajectory(vx_all_, t0_rclcpp_time, t1_rclcpp_time);
+  window.traj_data.gyro_list = extract_sub_trajectory(gyro_all_, t0_rclcpp_time, t1_rclcpp_time);
+  window.imu_frame = imu_frame_;
+
+  // the samples of this window are not used again
+  pose_buf_.clear();
+  remove_older_than(vx_all_, t1_rclcpp_time);
+  remove_older_than(gyro_all_, t1_rclcpp_time);
+
+  if (!window_queue_.push(std::move(window))) {
+    RCLCPP_WARN_THROTTLE(
+      get_logger(), *get_clock(), 5000, "The estimation is behind, a window is dropped");
+    return;
+  }
+
+  // taking the lock once the window is queued makes sure the estimation thread sees it
+  {
+    std::lock_guard<std::mutex> lock(estimation_mutex_);
+  }
+  estimation_condition_.notify_one();
+}
+
+/**
+ * @brief estimate the windows queued by the timer until the node is destroyed
+ */
+void DeviationEstimator::estimation_loop()
+{
+  EstimationWindow window;
+  while (true) {
+    while (window_queue_.pop(window)) {
+      estimate_window(window);
+    }
+
+    std::unique_lock<std::mutex> lock(estimation_mutex_);
+    estimation_condition_.wait(
+      lock, [this] { return is_estimation_stopped_ || !window_queue_.empty(); });
+    if (is_estimation_stopped_) return;
+  }
+}
+
+/**
+ * @brief update the bias and the coefficient with a closed window, then estimate the standard
+ * deviations, validate, publish and log the results
+ */
+void DeviationEstimator::estimate_window(const EstimationWindow & window)
+{
+  AUTOWARE_TOOL_TRACING_STAGE("deviation_estimator", "estimate_window");
+
+  const TrajectoryArrays arrays = to_trajectory_arrays(window.traj_data);
+  bool is_straight = get_mean_abs_wz(arrays) < wz_threshold_;
+  bool is_moving = get_mean_abs_vx(arrays) > vx_threshold_;
+  bool is_constant_velocity = std::abs(get_mean_accel(arrays)) < accel_threshold_;
 
   const bool use_gyro = whether_to_use_data(
     is_straight, is_moving, is_constant_velocity, gyro_only_use_straight_, gyro_only_use_moving_,
@@ -264,24 +417,26 @@ void DeviationEstimator::timer_callback()
     is_straight, is_moving, is_constant_velocity, velocity_only_use_straight_,
     velocity_only_use_moving_, velocity_only_use_constant_velocity_);
   if (use_velocity) {
-    vel_coef_module_->update_coef(traj_data);
-    traj_data_list_for_velocity_.push_back(traj_data);
+    vel_coef_module_->update_coef(arrays);
+    velocity_window_list_.push_back(summarize_velocity_window(arrays));
+    if (velocity_window_list_.size() > max_window_num_) velocity_window_list_.pop_front();
+    velocity_window_num_ = velocity_window_list_.size();
   }
   if (use_gyro) {
-    gyro_bias_module_->update_bias(traj_data);
-    traj_data_list_for_gyro_.push_back(traj_data);
+    gyro_bias_module_->update_bias(arrays);
+    gyro_window_list_.push_back(summarize_gyro_window(arrays));
+    if (gyro_window_list_.size() > max_window_num_) gyro_window_list_.pop_front();
+    gyro_window_num_ = gyro_window_list_.size();
   }
 
-  pose_buf_.clear();
-
   double stddev_vx =
-    estimate_stddev_velocity(traj_data_list_for_velocity_, vel_coef_module_->get_coef());
+    estimate_stddev_velocity(velocity_window_list_, vel_coef_module_->get_coef());
   if (velocity_add_bias_uncertainty_) {
     stddev_vx = add_bias_uncertainty_on_velocity(stddev_vx, vel_coef_module_->get_coef_std());
   }
 
-  auto stddev_angvel_base = estimate_stddev_angular_velocity(
-    traj_data_list_for_gyro_, gyro_bias_module_->get_bias_base_link());
+  auto stddev_angvel_base =
+    estimate_stddev_angular_velocity(gyro_window_list_, gyro_bias_module_->get_bias_base_link());
   if (gyro_add_bias_uncertainty_) {
     stddev_angvel_base = add_bias_uncertainty_on_angular_velocity(
       stddev_angvel_base, gyro_bias_module_->get_bias_std());
@@ -293,10 +448,11 @@ void DeviationEstimator::timer_callback()
   pub_coef_vx_->publish(coef_vx_msg);
 
   geometry_msgs::msg::TransformStamped::ConstSharedPtr tf_base2imu_ptr =
-    transform_listener_->getLatestTransform(output_frame_, imu_frame_);
+    transform_listener_->getLatestTransform(output_frame_, window.imu_frame);
   if (!tf_base2imu_ptr) {
     RCLCPP_ERROR(
-      this->get_logger(), "Please publish TF %s to %s", imu_frame_.c_str(), output_frame_.c_str());
+      this->get_logger(), "Please publish TF %s to %s", window.imu_frame.c_str(),
+      output_frame_.c_str());
     return;
   }
   const geometry_msgs::msg::Vector3 bias_angvel_imu =
@@ -325,6 +481,27 @@ void DeviationEstimator::timer_callback()
   results_logger_.log_validation_result_section(*validation_module_);
 }
 
+/**
+ * @brief report the number of buffered samples and windows, and their approximate memory
+ */
+void DeviationEstimator::check_buffer_memory(diagnostic_updater::DiagnosticStatusWrapper & stat)
+{
+  const size_t memory_bytes =
+    vx_all_.size() * sizeof(autoware_internal_debug_msgs::msg::Float64Stamped) +
+    gyro_all_.size() * sizeof(geometry_msgs::msg::Vector3Stamped) +
+    pose_buf_.size() * sizeof(geometry_msgs::msg::PoseStamped) +
+    gyro_window_num_ * sizeof(GyroWindowSummary) +
+    velocity_window_num_ * sizeof(VelocityWindowSummary);
+
+  stat.add("vx_buffer_size", vx_all_.size());
+  stat.add("gyro_buffer_size", gyro_all_.size());
+  stat.add("pose_buffer_size", pose_buf_.size());
+  stat.add("gyro_window_num", gyro_window_num_.load());
+  stat.add("velocity_window_num", velocity_window_num_.load());
+  stat.add("memory_bytes", memory_bytes);
+  stat.summary(diagnostic_msgs::msg::DiagnosticStatus::OK, "OK");
+}
+
 /**
  * @brief add uncertainty due to the deviation of speed scale factor on velocity standard deviation
  */
@@ -13,25 +13,120 @@
 // limitations under the License.
 
 #include "deviation_estimator/deviation_estimator.hpp"
+#include "deviation_estimator/estimation_state.hpp"
 
 #include <ament_index_cpp/get_package_share_directory.hpp>
 #include <rclcpp/serialization.hpp>
 #include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+namespace
+{
+const std::string velocity_topic = "/vehicle/status/velocity_status";
+const std::string tf_static_topic = "/tf_static";
+const std::string imu_topic = "/sensing/imu/tamagawa/imu_raw";
+const std::string pose_topic = "/localization/pose_estimator/pose_with_covariance";
+
+// a message of the bag, deserialized by a worker thread
+struct DecodedMessage
+{
+  enum class Type { VELOCITY, TF_STATIC, IMU, POSE };
+  Type type;
+  autoware_vehicle_msgs::msg::VelocityReport velocity_status;
+  tf2_msgs::msg::TFMessage tf;
+  sensor_msgs::msg::Imu imu;
+  geometry_msgs::msg::PoseWithCovarianceStamped pose;
+};
+
+// runs func(i) for i in [0, num) on the thread_num threads, including the calling one
+template <class Func>
+void parallel_for(const size_t num, const size_t thread_num, const Func & func)
+{
+  std::atomic<size_t> next_index(0);
+  auto worker = [&]() {
+    for (size_t i = next_index++; i < num; i = next_index++) {
+      func(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(thread_num, num); ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & t : threads) {
+    t.join();
+  }
+}
+
+// the estimation of a window, as the modules are updated by the windows up to it
+struct WindowResult
+{
+  bool is_straight;
+  bool is_moving;
+  bool is_constant_velocity;
+  bool use_gyro;
+  bool use_velocity;
+  double coef_vx;
+  geometry_msgs::msg::Vector3 gyro_bias;
+  size_t num_for_velocity;
+  size_t num_for_gyro;
+  double stddev_vx;
+  geometry_msgs::msg::Vector3 stddev_angvel_base;
+};
+
+// identifies a bag by the names of its files, its time range and its message count, so that a
+// bag is recognized in the state even if it was moved. FNV-1a, so the hash is the same across
+// builds.
+std::string hash_bag(const rosbag2_storage::BagMetadata & metadata)
+{
+  std::ostringstream key;
+  for (const auto & path : metadata.relative_file_paths) {
+    key << std::filesystem::path(path).filename().string() << " ";
+  }
+  key << metadata.starting_time.time_since_epoch().count() << " " << metadata.duration.count()
+      << " " << metadata.message_count;
+
+  uint64_t hash = 14695981039346656037ull;
+  for (const char c : key.str()) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+  }
+  std::ostringstream hex;
+  hex << std::hex << hash;
+  return hex.str();
+}
+}  // namespace
+
 int main(int argc, char ** argv)
 {
-  if (argc != 2) {
-    std::cout << "Usage: " << argv[0] << " <rosbag_path>" << std::endl;
+  if (argc < 2 || argc > 5) {
+    std::cout << "Usage: " << argv[0] << " <rosbag_path> [thread_num] [state_path] [max_bag_num]"
+              << std::endl;
     return 1;
   }
   const std::string rosbag_path = argv[1];
+  const size_t thread_num =
+    argc >= 3 ? std::max(std::stoul(argv[2]), 1ul)
+              : std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t{1});
+  // the windows of the bags estimated before are loaded from the state, and this bag is added
+  const std::string state_path = argc >= 4 ? argv[3] : "";
+  const size_t max_bag_num = argc == 5 ? std::stoul(argv[4]) : 0;
 
   std::cout << "deviation_estimator_unit_tool" << std::endl;
 
@@ -54,7 +149,21 @@ int main(int argc, char ** argv)
     }
   }
 
-  // Prepare rosbag reader
+  // The state is valid only for the parameters selecting and splitting the windows
+  std::ostringstream signature;
+  for (const std::string name :
+       {"time_window", "wz_threshold", "vx_threshold", "accel_threshold",
+        "gyro_estimation.only_use_straight", "gyro_estimation.only_use_moving",
+        "gyro_estimation.only_use_constant_velocity", "velocity_estimation.only_use_straight",
+        "velocity_estimation.only_use_moving", "velocity_estimation.only_use_constant_velocity"}) {
+    signature << name << "=" << param_map.at(name).value_to_string() << ";";
+  }
+  EstimationState state(signature.str());
+  if (!state_path.empty() && state.load(state_path)) {
+    std::cout << "loaded " << state.bags().size() << " bags from " << state_path << std::endl;
+  }
+
+  // Prepare rosbag reader, only with the topics to use
   rosbag2_storage::StorageOptions storage_options;
   storage_options.uri = rosbag_path;
   storage_options.storage_id = "sqlite3";
@@ -63,6 +172,9 @@ int main(int argc, char ** argv)
   converter_options.output_serialization_format = "cdr";
   rosbag2_cpp::readers::SequentialReader reader;
   reader.open(storage_options, converter_options);
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {velocity_topic, tf_static_topic, imu_topic, pose_topic};
+  reader.set_filter(storage_filter);
 
   // Prepare serialization
   rclcpp::Serialization<autoware_vehicle_msgs::msg::VelocityReport> serialization_velocity_status;
@@ -73,6 +185,8 @@ int main(int argc, char ** argv)
   // Prepare tf_buffer
   rclcpp::Clock::SharedPtr clock = std::make_shared<rclcpp::Clock>(RCL_ROS_TIME);
   tf2_ros::Buffer tf_buffer(clock);
+  // the static transforms to base_link of the IMU frames, looked up once until a new /tf_static
+  std::map<std::string, geometry_msgs::msg::TransformStamped> imu_transforms;
 
   // Prepare variables
   std::vector<TrajectoryData> trajectory_data_list;
@@ -80,83 +194,131 @@ int main(int argc, char ** argv)
   const double time_window = param_map.at("time_window").as_double();
   std::string imu_frame_id;
 
+  // the windows and their messages are preallocated by the counts of the bag
+  const auto metadata = reader.get_metadata();
+  const std::string bag_hash = hash_bag(metadata);
+  const bool is_new_bag = !state.contains(bag_hash);
+  const double bag_duration = std::chrono::duration<double>(metadata.duration).count();
+  const size_t expected_window_num = static_cast<size_t>(bag_duration / time_window) + 1;
+  std::map<std::string, size_t> messages_per_window;
+  for (const auto & topic : metadata.topics_with_message_count) {
+    messages_per_window[topic.topic_metadata.name] =
+      topic.message_count / expected_window_num + 1;
+  }
+  trajectory_data_list.reserve(expected_window_num + 1);
+  auto get_window = [&](const rclcpp::Time & curr_stamp) -> TrajectoryData & {
+    first_stamp = std::min(first_stamp, curr_stamp);
+    const double diff_sec = (curr_stamp - first_stamp).seconds();
+    const int64_t index = static_cast<int64_t>(diff_sec / time_window);
+    while (index >= static_cast<int64_t>(trajectory_data_list.size())) {
+      TrajectoryData traj_data;
+      // not for the windows out of the bag duration, e.g. by a wrong stamp
+      if (trajectory_data_list.size() < expected_window_num) {
+        traj_data.vx_list.reserve(messages_per_window[velocity_topic]);
+        traj_data.gyro_list.reserve(messages_per_window[imu_topic]);
+        traj_data.pose_list.reserve(messages_per_window[pose_topic]);
+      }
+      trajectory_data_list.push_back(std::move(traj_data));
+    }
+    return trajectory_data_list[index];
+  };
+
   // ----------- //
   // Read rosbag //
   // ----------- //
-  while (reader.has_next()) {
-    const rosbag2_storage::SerializedBagMessageSharedPtr serialized_message = reader.read_next();
-    const std::string topic_name = serialized_message->topic_name;
-    const rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
-
-    if (topic_name == "/vehicle/status/velocity_status") {
-      autoware_vehicle_msgs::msg::VelocityReport::SharedPtr velocity_status_msg =
-        std::make_shared<autoware_vehicle_msgs::msg::VelocityReport>();
-      serialization_velocity_status.deserialize_message(&msg, velocity_status_msg.get());
-      const rclcpp::Time curr_stamp = velocity_status_msg->header.stamp;
-      first_stamp = std::min(first_stamp, curr_stamp);
-      const double diff_sec = (curr_stamp - first_stamp).seconds();
-      const int64_t index = static_cast<int64_t>(diff_sec / time_window);
-      if (index >= static_cast<int64_t>(trajectory_data_list.size())) {
-        trajectory_data_list.resize(index + 1);
-      }
-      autoware_internal_debug_msgs::msg::Float64Stamped vx;
-      vx.stamp = velocity_status_msg->header.stamp;
-      vx.data = velocity_status_msg->longitudinal_velocity;
-      trajectory_data_list[index].vx_list.push_back(vx);
-
-    } else if (topic_name == "/tf_static") {
-      tf2_msgs::msg::TFMessage::SharedPtr tf_msg = std::make_shared<tf2_msgs::msg::TFMessage>();
-      serialization_tf.deserialize_message(&msg, tf_msg.get());
-      for (const auto & transform : tf_msg->transforms) {
-        try {
-          tf_buffer.setTransform(transform, "default_authority", false);
-        } catch (const tf2::TransformException & ex) {
-          std::cerr << "Transform exception: " << ex.what() << std::endl;
-          std::exit(1);
-        }
-      }
+  // A block of the messages is deserialized by the workers while the next one is read, and the
+  // deserialized ones are handled in the order of the bag.
+  constexpr size_t block_size = 4096;
+  auto read_block = [&reader](std::vector<rosbag2_storage::SerializedBagMessageSharedPtr> & block) {
+    block.clear();
+    while (block.size() < block_size && reader.has_next()) {
+      block.push_back(reader.read_next());
+    }
+  };
+  std::vector<rosbag2_storage::SerializedBagMessageSharedPtr> current_block, next_block;
+  std::vector<DecodedMessage> decoded(block_size);
+  if (is_new_bag) {
+    read_block(current_block);
+  } else {
+    std::cout << "the bag " << bag_hash << " is in the state, and is not read again" << std::endl;
+  }
 
-    } else if (topic_name == "/sensing/imu/tamagawa/imu_raw") {
-      sensor_msgs::msg::Imu::SharedPtr imu_msg = std::make_shared<sensor_msgs::msg::Imu>();
-      serialization_imu.deserialize_message(&msg, imu_msg.get());
-      imu_frame_id = imu_msg->header.frame_id;
-      geometry_msgs::msg::Vector3Stamped vec_stamped_transformed;
-      try {
-        const geometry_msgs::msg::TransformStamped transform =
-          tf_buffer.lookupTransform("base_link", imu_msg->header.frame_id, tf2::TimePointZero);
-        vec_stamped_transformed.header = imu_msg->header;
-        tf2::doTransform(imu_msg->angular_velocity, vec_stamped_transformed.vector, transform);
-      } catch (const tf2::TransformException & ex) {
-        std::cerr << "Transform exception: " << ex.what() << std::endl;
-        continue;
-      }
-      const rclcpp::Time curr_stamp = imu_msg->header.stamp;
-      first_stamp = std::min(first_stamp, curr_stamp);
-      const double diff_sec = (curr_stamp - first_stamp).seconds();
-      const int64_t index = static_cast<int64_t>(diff_sec / time_window);
-      if (index >= static_cast<int64_t>(trajectory_data_list.size())) {
-        trajectory_data_list.resize(index + 1);
-      }
-      trajectory_data_list[index].gyro_list.push_back(vec_stamped_transformed);
-
-    } else if (topic_name == "/localization/pose_estimator/pose_with_covariance") {
-      geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr pose_msg =
-        std::make_shared<geometry_msgs::msg::PoseWithCovarianceStamped>();
-      serialization_pose.deserialize_message(&msg, pose_msg.get());
-      const rclcpp::Time curr_stamp = pose_msg->header.stamp;
-      first_stamp = std::min(first_stamp, curr_stamp);
-      const double diff_sec = (curr_stamp - first_stamp).seconds();
-      const int64_t index = static_cast<int64_t>(diff_sec / time_window);
-      if (index >= static_cast<int64_t>(trajectory_data_list.size())) {
-        trajectory_data_list.resize(index + 1);
+  while (!current_block.empty()) {
+    std::thread decoder([&]() {
+      parallel_for(current_block.size(), thread_num, [&](const size_t i) {
+        const auto & serialized_message = current_block[i];
+        const rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+        auto & message = decoded[i];
+        const std::string & topic_name = serialized_message->topic_name;
+        if (topic_name == velocity_topic) {
+          message.type = DecodedMessage::Type::VELOCITY;
+          serialization_velocity_status.deserialize_message(&msg, &message.velocity_status);
+        } else if (topic_name == tf_static_topic) {
+          message.type = DecodedMessage::Type::TF_STATIC;
+          serialization_tf.deserialize_message(&msg, &message.tf);
+        } else if (topic_name == imu_topic) {
+          message.type = DecodedMessage::Type::IMU;
+          serialization_imu.deserialize_message(&msg, &message.imu);
+        } else {
+          message.type = DecodedMessage::Type::POSE;
+          serialization_pose.deserialize_message(&msg, &message.pose);
+        }
+      });
+    });
+    read_block(next_block);
+    decoder.join();
+
+    for (size_t i = 0; i < current_block.size(); ++i) {
+      const DecodedMessage & message = decoded[i];
+      if (message.type == DecodedMessage::Type::VELOCITY) {
+        const auto & velocity_status_msg = message.velocity_status;
+        autoware_internal_debug_msgs::msg::Float64Stamped vx;
+        vx.stamp = velocity_status_msg.header.stamp;
+        vx.data = velocity_status_msg.longitudinal_velocity;
+        get_window(velocity_status_msg.header.stamp).vx_list.push_back(vx);
+
+      } else if (message.type == DecodedMessage::Type::TF_STATIC) {
+        for (const auto & transform : message.tf.transforms) {
+          try {
+            tf_buffer.setTransform(transform, "default_authority", false);
+          } catch (const tf2::TransformException & ex) {
+            std::cerr << "Transform exception: " << ex.what() << std::endl;
+            std::exit(1);
+          }
+        }
+        imu_transforms.clear();
+
+      } else if (message.type == DecodedMessage::Type::IMU) {
+        const auto & imu_msg = message.imu;
+        imu_frame_id = imu_msg.header.frame_id;
+        auto transform = imu_transforms.find(imu_frame_id);
+        if (transform == imu_transforms.end()) {
+          try {
+            transform = imu_transforms
+                          .emplace(
+                            imu_frame_id, tf_buffer.lookupTransform(
+                                            "base_link", imu_frame_id, tf2::TimePointZero))
+                          .first;
+          } catch (const tf2::TransformException & ex) {
+            std::cerr << "Transform exception: " << ex.what() << std::endl;
+            continue;
+          }
+        }
+        geometry_msgs::msg::Vector3Stamped vec_stamped_transformed;
+        vec_stamped_transformed.header = imu_msg.header;
+        tf2::doTransform(
+          imu_msg.angular_velocity, vec_stamped_transformed.vector, transform->second);
+        get_window(imu_msg.header.stamp).gyro_list.push_back(vec_stamped_transformed);
+
+      } else {
+        const auto & pose_msg = message.pose;
+        geometry_msgs::msg::PoseStamped pose_stamped;
+        pose_stamped.header = pose_msg.header;
+        pose_stamped.pose = pose_msg.pose.pose;
+        get_window(pose_msg.header.stamp).pose_list.push_back(pose_stamped);
       }
-      geometry_msgs::msg::PoseStamped pose_stamped;
-      pose_stamped.header = pose_msg->header;
-      pose_stamped.pose = pose_msg->pose.pose;
-      trajectory_data_list[index].pose_list.push_back(pose_stamped);
-
-    } else {
     }
+    std::swap(current_block, next_block);
   }
 
   // ------------------ //
@@ -181,8 +343,6 @@ int main(int argc, char ** argv)
     param_map.at("velocity_estimation.add_bias_uncertainty").as_bool();
   std::unique_ptr<GyroBiasModule> gyro_bias_module = std::make_unique<GyroBiasModule>();
   std::unique_ptr<VelocityCoefModule> vel_coef_module = std::make_unique<VelocityCoefModule>();
-  std::vector<TrajectoryData> traj_data_list_for_velocity;
-  std::vector<TrajectoryData> traj_data_list_for_gyro;
 
   if (gyro_add_bias_uncertainty) {
     std::cerr << "gyro_add_bias_uncertainty is not supported yet." << std::endl;
@@ -199,62 +359,116 @@ int main(int argc, char ** argv)
 
   Logger results_logger(".");
 
-  for (const TrajectoryData & traj_data : trajectory_data_list) {
-    std::cout << "traj_data.pose_list.size(): " << traj_data.pose_list.size() << std::endl;
-    std::cout << "traj_data.gyro_list.size(): " << traj_data.gyro_list.size() << std::endl;
-    std::cout << "traj_data.vx_list.size(): " << traj_data.vx_list.size() << std::endl;
+  // The windows are converted to arrays and reduced to their states in parallel, as they are
+  // independent of each other. Then the modules are updated by the windows of the saved bags and
+  // of this bag in order, and the standard deviations over the windows up to each one of this bag
+  // are estimated in parallel.
+  std::vector<std::optional<WindowResult>> window_results(trajectory_data_list.size());
+  std::vector<WindowState> window_states(trajectory_data_list.size());
+  parallel_for(trajectory_data_list.size(), thread_num, [&](const size_t i) {
+    const TrajectoryData & traj_data = trajectory_data_list[i];
 
     // Skip if there is too little data such as terminal data
     if (
       traj_data.pose_list.size() < 2 || traj_data.gyro_list.size() < 2 ||
       traj_data.vx_list.size() < 2) {
-      continue;
+      return;
     }
 
-    const bool is_straight = get_mean_abs_wz(traj_data.gyro_list) < wz_threshold;
-    const bool is_moving = get_mean_abs_vx(traj_data.vx_list) > vx_threshold;
-    const bool is_constant_velocity = std::abs(get_mean_accel(traj_data.vx_list)) < accel_threshold;
-
-    const bool use_gyro = whether_to_use_data(
-      is_straight, is_moving, is_constant_velocity, gyro_only_use_straight, gyro_only_use_moving,
-      gyro_only_use_constant_velocity);
-    const bool use_velocity = whether_to_use_data(
-      is_straight, is_moving, is_constant_velocity, velocity_only_use_straight,
-      velocity_only_use_moving, velocity_only_use_constant_velocity);
-    if (use_velocity) {
-      vel_coef_module->update_coef(traj_data);
-      traj_data_list_for_velocity.push_back(traj_data);
+    const TrajectoryArrays arrays = to_trajectory_arrays(traj_data);
+
+    WindowResult result;
+    result.is_straight = get_mean_abs_wz(arrays) < wz_threshold;
+    result.is_moving = get_mean_abs_vx(arrays) > vx_threshold;
+    result.is_constant_velocity = std::abs(get_mean_accel(arrays)) < accel_threshold;
+
+    result.use_gyro = whether_to_use_data(
+      result.is_straight, result.is_moving, result.is_constant_velocity, gyro_only_use_straight,
+      gyro_only_use_moving, gyro_only_use_constant_velocity);
+    result.use_velocity = whether_to_use_data(
+      result.is_straight, result.is_moving, result.is_constant_velocity,
+      velocity_only_use_straight, velocity_only_use_moving, velocity_only_use_constant_velocity);
+
+    WindowState & window = window_states[i];
+    window.use_velocity = result.use_velocity;
+    window.use_gyro = result.use_gyro;
+    if (result.use_velocity) {
+      window.velocity_coef = observe_velocity_coef(arrays);
+      window.velocity_window = summarize_velocity_window(arrays);
     }
-    if (use_gyro) {
-      gyro_bias_module->update_bias(traj_data);
-      traj_data_list_for_gyro.push_back(traj_data);
+    if (result.use_gyro) {
+      window.gyro_bias = observe_gyro_bias(arrays);
+      window.gyro_window = summarize_gyro_window(arrays);
     }
+    window_results[i] = result;
+  });
+
+  if (is_new_bag) {
+    BagState bag;
+    bag.hash = bag_hash;
+    bag.imu_frame_id = imu_frame_id;
+    for (size_t i = 0; i < window_states.size(); ++i) {
+      if (window_results[i]) {
+        bag.windows.push_back(window_states[i]);
+      }
+    }
+    if (!bag.windows.empty()) {
+      bag.base_to_imu = tf_buffer.lookupTransform(imu_frame_id, "base_link", tf2::TimePointZero);
+    }
+    state.add(std::move(bag), max_bag_num);
+  }
 
-    double stddev_vx =
-      estimate_stddev_velocity(traj_data_list_for_velocity, vel_coef_module->get_coef());
+  std::deque<VelocityWindowSummary> velocity_window_list;
+  std::deque<GyroWindowSummary> gyro_window_list;
+  auto add_window = [&](const WindowState & window) {
+    if (window.use_velocity) {
+      if (window.velocity_coef) {
+        vel_coef_module->update_coef(*window.velocity_coef);
+      }
+      velocity_window_list.push_back(window.velocity_window);
+    }
+    if (window.use_gyro) {
+      gyro_bias_module->update_bias(window.gyro_bias);
+      gyro_window_list.push_back(window.gyro_window);
+    }
+  };
 
-    auto stddev_angvel_base = estimate_stddev_angular_velocity(
-      traj_data_list_for_gyro, gyro_bias_module->get_bias_base_link());
+  // the saved bags, without this one, which is the last one of the state if it is new
+  const size_t saved_bag_num = state.bags().size() - (is_new_bag ? 1 : 0);
+  for (size_t b = 0; b < saved_bag_num; ++b) {
+    for (const WindowState & window : state.bags()[b].windows) {
+      add_window(window);
+    }
+  }
 
-    // print
-    const geometry_msgs::msg::Vector3 curr_gyro_bias = gyro_bias_module->get_bias_base_link();
-
-    std::cout << std::fixed                                                       //
-              << "is_straight=" << is_straight                                    //
-              << ", is_moving=" << is_moving                                      //
-              << ", is_constant_velocity=" << is_constant_velocity                //
-              << ", use_gyro=" << use_gyro                                        //
-              << ", use_velocity=" << use_velocity                                //
-              << ", vel_coef_module->get_coef()=" << vel_coef_module->get_coef()  //
-              << ", curr_gyro_bias.x=" << curr_gyro_bias.x                        //
-              << ", curr_gyro_bias.y=" << curr_gyro_bias.y                        //
-              << ", curr_gyro_bias.z=" << curr_gyro_bias.z                        //
-              << ", stddev_vx=" << stddev_vx                                      //
-              << ", stddev_angvel_base.x=" << stddev_angvel_base.x                //
-              << ", stddev_angvel_base.y=" << stddev_angvel_base.y                //
-              << ", stddev_angvel_base.z=" << stddev_angvel_base.z                //
-              << std::endl;
+  for (size_t i = 0; i < trajectory_data_list.size(); ++i) {
+    if (!window_results[i]) {
+      continue;
+    }
+    WindowResult & result = *window_results[i];
+    add_window(window_states[i]);
+    result.coef_vx = vel_coef_module->get_coef();
+    result.gyro_bias = gyro_bias_module->get_bias_base_link();
+    result.num_for_velocity = velocity_window_list.size();
+    result.num_for_gyro = gyro_window_list.size();
+  }
 
+  parallel_for(window_results.size(), thread_num, [&](const size_t i) {
+    if (!window_results[i]) {
+      return;
+    }
+    WindowResult & result = *window_results[i];
+    result.stddev_vx =
+      estimate_stddev_velocity(velocity_window_list, result.coef_vx, result.num_for_velocity);
+    result.stddev_angvel_base =
+      estimate_stddev_angular_velocity(gyro_window_list, result.gyro_bias, result.num_for_gyro);
+  });
+
+  auto log_result = [&](
+                      const double coef_vx, const geometry_msgs::msg::Vector3 & gyro_bias,
+                      const double stddev_vx,
+                      const geometry_msgs::msg::Vector3 & stddev_angvel_base,
+                      const geometry_msgs::msg::TransformStamped & base_to_imu_transform) {
     // For IMU link standard deviation, we use the yaw standard deviation in base_link.
     // This is because the standard deviation estimation of x and y in base_link may not be accurate
     // especially when the data contains a motion when the people are getting on/off the vehicle,
@@ -264,22 +478,82 @@ int main(int argc, char ** argv)
     geometry_msgs::msg::Vector3 stddev_angvel_imu_msg =
       createVector3(stddev_angvel_imu, stddev_angvel_imu, stddev_angvel_imu);
 
-    const geometry_msgs::msg::TransformStamped transform =
-      tf_buffer.lookupTransform(imu_frame_id, "base_link", tf2::TimePointZero);
     geometry_msgs::msg::Vector3 bias_angvel_imu;
-    tf2::doTransform(gyro_bias_module->get_bias_base_link(), bias_angvel_imu, transform);
+    tf2::doTransform(gyro_bias, bias_angvel_imu, base_to_imu_transform);
 
-    validation_module->set_velocity_data(vel_coef_module->get_coef(), stddev_vx);
+    validation_module->set_velocity_data(coef_vx, stddev_vx);
     validation_module->set_gyro_data(bias_angvel_imu, stddev_angvel_imu_msg);
 
     results_logger.log_estimated_result_section(
-      stddev_vx, vel_coef_module->get_coef(), stddev_angvel_imu_msg, bias_angvel_imu);
+      stddev_vx, coef_vx, stddev_angvel_imu_msg, bias_angvel_imu);
     results_logger.log_validation_result_section(*validation_module);
 
     std::cout << "saved to ./" << std::endl;
+  };
+
+  std::optional<geometry_msgs::msg::TransformStamped> base_to_imu_transform;
+  for (size_t i = 0; i < trajectory_data_list.size(); ++i) {
+    const TrajectoryData & traj_data = trajectory_data_list[i];
+    std::cout << "traj_data.pose_list.size(): " << traj_data.pose_list.size() << std::endl;
+    std::cout << "traj_data.gyro_list.size(): " << traj_data.gyro_list.size() << std::endl;
+    std::cout << "traj_data.vx_list.size(): " << traj_data.vx_list.size() << std::endl;
+    if (!window_results[i]) {
+      continue;
+    }
+    const WindowResult & result = *window_results[i];
+    const double stddev_vx = result.stddev_vx;
+    const auto & stddev_angvel_base = result.stddev_angvel_base;
+
+    // print
+    const geometry_msgs::msg::Vector3 & curr_gyro_bias = result.gyro_bias;
+
+    std::cout << std::fixed                                                //
+              << "is_straight=" << result.is_straight                      //
+              << ", is_moving=" << result.is_moving                        //
+              << ", is_constant_velocity=" << result.is_constant_velocity  //
+              << ", use_gyro=" << result.use_gyro                          //
+              << ", use_velocity=" << result.use_velocity                  //
+              << ", vel_coef_module->get_coef()=" << result.coef_vx        //
+              << ", curr_gyro_bias.x=" << curr_gyro_bias.x                 //
+              << ", curr_gyro_bias.y=" << curr_gyro_bias.y                 //
+              << ", curr_gyro_bias.z=" << curr_gyro_bias.z                 //
+              << ", stddev_vx=" << stddev_vx                               //
+              << ", stddev_angvel_base.x=" << stddev_angvel_base.x         //
+              << ", stddev_angvel_base.y=" << stddev_angvel_base.y         //
+              << ", stddev_angvel_base.z=" << stddev_angvel_base.z         //
+              << std::endl;
+
+    if (!base_to_imu_transform) {
+      base_to_imu_transform =
+        tf_buffer.lookupTransform(imu_frame_id, "base_link", tf2::TimePointZero);
+    }
+    log_result(
+      result.coef_vx, result.gyro_bias, stddev_vx, stddev_angvel_base, *base_to_imu_transform);
+  }
+
+  // The bag was estimated before, so only the estimation over the saved windows is logged
+  if (!is_new_bag && !velocity_window_list.empty() && !gyro_window_list.empty()) {
+    const double coef_vx = vel_coef_module->get_coef();
+    const geometry_msgs::msg::Vector3 gyro_bias = gyro_bias_module->get_bias_base_link();
+    const auto last_bag = std::find_if(
+      state.bags().rbegin(), state.bags().rend(),
+      [](const BagState & bag) { return !bag.windows.empty(); });
+    log_result(
+      coef_vx, gyro_bias,
+      estimate_stddev_velocity(velocity_window_list, coef_vx, velocity_window_list.size()),
+      estimate_stddev_angular_velocity(gyro_window_list, gyro_bias, gyro_window_list.size()),
+      last_bag->base_to_imu);
+  }
+
+  if (!state_path.empty() && is_new_bag) {
+    if (state.save(state_path)) {
+      std::cout << "saved " << state.bags().size() << " bags to " << state_path << std::endl;
+    } else {
+      std::cerr << "Failed to save the state: " << state_path << std::endl;
+    }
   }
 
-  std::cout << "count for velocity : " << traj_data_list_for_velocity.size() << std::endl;
-  std::cout << "count for gyro : " << traj_data_list_for_gyro.size() << std::endl;
+  std::cout << "count for velocity : " << velocity_window_list.size() << std::endl;
+  std::cout << "count for gyro : " << gyro_window_list.size() << std::endl;
   std::cout << "Finished." << std::endl;
 }
@@ -0,0 +1,144 @@
+// Copyright 2018-2019 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/estimation_state.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace
+{
+const char * const header = "deviation_estimator_state 1";
+
+void write_window(std::ostream & os, const WindowState & window)
+{
+  const auto & gyro_error = window.gyro_bias.error_rpy;
+  const auto & v = window.velocity_window;
+  const auto & g = window.gyro_window;
+  os << "w " << window.use_velocity << " " << window.use_gyro << " "
+     << window.velocity_coef.has_value() << " " << window.velocity_coef.value_or(0.0) << " "
+     << window.gyro_bias.dt << " " << gyro_error.x << " " << gyro_error.y << " " << gyro_error.z
+     << " " << v.valid << " " << v.dt_pose << " " << v.n_vx << " " << v.distance << " "
+     << v.distance_from_twist_without_coef << " " << g.valid << " " << g.dt_pose << " "
+     << g.dt_gyro << " " << g.n_gyro << " " << g.error_rpy_without_bias.x << " "
+     << g.error_rpy_without_bias.y << " " << g.error_rpy_without_bias.z << "\n";
+}
+
+bool read_window(std::istream & is, WindowState & window)
+{
+  std::string tag;
+  bool has_coef = false;
+  double coef = 0.0;
+  auto & gyro_error = window.gyro_bias.error_rpy;
+  auto & v = window.velocity_window;
+  auto & g = window.gyro_window;
+  is >> tag >> window.use_velocity >> window.use_gyro >> has_coef >> coef >> window.gyro_bias.dt >>
+    gyro_error.x >> gyro_error.y >> gyro_error.z >> v.valid >> v.dt_pose >> v.n_vx >> v.distance >>
+    v.distance_from_twist_without_coef >> g.valid >> g.dt_pose >> g.dt_gyro >> g.n_gyro >>
+    g.error_rpy_without_bias.x >> g.error_rpy_without_bias.y >> g.error_rpy_without_bias.z;
+  window.velocity_coef = has_coef ? std::optional<double>(coef) : std::nullopt;
+  return is && tag == "w";
+}
+}  // namespace
+
+bool EstimationState::load(const std::string & path)
+{
+  bags_.clear();
+  std::ifstream file(path);
+  std::string line, signature;
+  if (!std::getline(file, line) || line != header || !std::getline(file, signature)) {
+    return false;
+  }
+  if (signature != signature_) {
+    std::cerr << "The state " << path << " is from other parameters, and is ignored." << std::endl;
+    return false;
+  }
+
+  std::string tag;
+  while (file >> tag) {
+    BagState bag;
+    size_t window_num = 0;
+    auto & t = bag.base_to_imu.transform;
+    file >> bag.hash >> bag.imu_frame_id >> window_num >> t.translation.x >> t.translation.y >>
+      t.translation.z >> t.rotation.x >> t.rotation.y >> t.rotation.z >> t.rotation.w;
+    if (!file || tag != "bag") {
+      bags_.clear();
+      return false;
+    }
+    if (bag.imu_frame_id == "-") {
+      bag.imu_frame_id.clear();
+    }
+    bag.base_to_imu.header.frame_id = bag.imu_frame_id;
+    bag.base_to_imu.child_frame_id = "base_link";
+    bag.windows.resize(window_num);
+    for (auto & window : bag.windows) {
+      if (!read_window(file, window)) {
+        bags_.clear();
+        return false;
+      }
+    }
+    bags_.push_back(std::move(bag));
+  }
+  return true;
+}
+
+/**
+ * @brief write the state to a temporary file first, so an interrupted run keeps the previous one
+ */
+bool EstimationState::save(const std::string & path) const
+{
+  const std::string temporary_path = path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::trunc);
+    file << std::setprecision(std::numeric_limits<double>::max_digits10);
+    file << header << "\n" << signature_ << "\n";
+    for (const auto & bag : bags_) {
+      const auto & t = bag.base_to_imu.transform;
+      // "-" for a bag without IMU messages, which would break the whitespace separated fields
+      const std::string imu_frame_id = bag.imu_frame_id.empty() ? "-" : bag.imu_frame_id;
+      file << "bag " << bag.hash << " " << imu_frame_id << " " << bag.windows.size() << " "
+           << t.translation.x << " " << t.translation.y << " " << t.translation.z << " "
+           << t.rotation.x << " " << t.rotation.y << " " << t.rotation.z << " " << t.rotation.w
+           << "\n";
+      for (const auto & window : bag.windows) {
+        write_window(file, window);
+      }
+    }
+    if (!file) {
+      return false;
+    }
+  }
+  return std::rename(temporary_path.c_str(), path.c_str()) == 0;
+}
+
+bool EstimationState::contains(const std::string & hash) const
+{
+  return std::any_of(
+    bags_.begin(), bags_.end(), [&hash](const BagState & bag) { return bag.hash == hash; });
+}
+
+void EstimationState::add(BagState && bag, const size_t max_bag_num)
+{
+  bags_.push_back(std::move(bag));
+  while (max_bag_num > 0 && bags_.size() > max_bag_num) {
+    bags_.pop_front();
+  }
+}
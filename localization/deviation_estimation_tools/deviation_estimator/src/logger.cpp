@@ -15,25 +15,57 @@
 #include "deviation_estimator/logger.hpp"
 
 #include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+namespace
+{
+// the readers of the file see either its previous or its new contents
+void write_atomically(const std::string & path, const std::string & contents)
+{
+  const std::string temporary_path = path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::trunc);
+    file << contents;
+    if (!file) {
+      std::cerr << "Failed to write " << temporary_path << std::endl;
+      return;
+    }
+  }
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    std::cerr << "Failed to replace " << path << std::endl;
+  }
+}
+}  // namespace
+
 /**
  * @brief constructor for Logger class
  */
-Logger::Logger(const std::string & output_dir)
-: output_log_path_(output_dir + "/output.txt"),
-  output_imu_param_path_(output_dir + "/imu_corrector.param.yaml"),
-  output_velocity_param_path_(output_dir + "/vehicle_velocity_converter.param.yaml")
+Logger::Logger(const std::string & output_dir, const double min_write_interval)
+: min_write_interval_(min_write_interval),
+  files_{
+    {{output_dir + "/output.txt", "", false},
+     {output_dir + "/imu_corrector.param.yaml", "", false},
+     {output_dir + "/vehicle_velocity_converter.param.yaml", "", false}}}
 {
-  std::ofstream file_log(output_log_path_);
-  file_log.close();
-
-  std::ofstream file_imu_param(output_imu_param_path_);
-  file_imu_param.close();
+  for (const auto & file : files_) {
+    write_atomically(file.path, "");
+  }
+  writer_ = std::thread(&Logger::write_loop, this);
+}
 
-  std::ofstream file_velocity_param(output_velocity_param_path_);
-  file_velocity_param.close();
+Logger::~Logger()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopped_ = true;
+  }
+  condition_.notify_one();
+  writer_.join();
 }
 
 /**
@@ -42,68 +74,108 @@ Logger::Logger(const std::string & output_dir)
 void Logger::log_estimated_result_section(
   const double stddev_vx, const double coef_vx,
   const geometry_msgs::msg::Vector3 & angular_velocity_stddev,
-  const geometry_msgs::msg::Vector3 & angular_velocity_offset) const
+  const geometry_msgs::msg::Vector3 & angular_velocity_offset)
 {
-  std::ofstream file_velocity_param(output_velocity_param_path_);
-  file_velocity_param << "# Estimated by deviation_estimator\n";
-  file_velocity_param << "/**:\n";
-  file_velocity_param << "  ros__parameters:\n";
-  file_velocity_param << fmt::format("    speed_scale_factor: {:.5f}\n", coef_vx);
-  file_velocity_param << fmt::format("    velocity_stddev_xx: {:.5f}\n", stddev_vx);
-  file_velocity_param << "    angular_velocity_stddev_zz: 0.1 # Default value\n";
-  file_velocity_param << "    frame_id: base_link # Default value\n";
-  file_velocity_param.close();
+  std::string velocity_param;
+  velocity_param += "# Estimated by deviation_estimator\n";
+  velocity_param += "/**:\n";
+  velocity_param += "  ros__parameters:\n";
+  velocity_param += fmt::format("    speed_scale_factor: {:.5f}\n", coef_vx);
+  velocity_param += fmt::format("    velocity_stddev_xx: {:.5f}\n", stddev_vx);
+  velocity_param += "    angular_velocity_stddev_zz: 0.1 # Default value\n";
+  velocity_param += "    frame_id: base_link # Default value\n";
+  update(VELOCITY_PARAM, std::move(velocity_param));
 
-  std::ofstream file_imu_param(output_imu_param_path_);
-  file_imu_param << "# Estimated by deviation_estimator\n";
-  file_imu_param << "/**:\n";
-  file_imu_param << "  ros__parameters:\n";
-  file_imu_param << fmt::format(
-    "    angular_velocity_offset_x: {:.5f}\n", angular_velocity_offset.x);
-  file_imu_param << fmt::format(
-    "    angular_velocity_offset_y: {:.5f}\n", angular_velocity_offset.y);
-  file_imu_param << fmt::format(
-    "    angular_velocity_offset_z: {:.5f}\n", angular_velocity_offset.z);
-  file_imu_param << fmt::format(
-    "    angular_velocity_stddev_xx: {:.5f}\n", angular_velocity_stddev.x);
-  file_imu_param << fmt::format(
-    "    angular_velocity_stddev_yy: {:.5f}\n", angular_velocity_stddev.y);
-  file_imu_param << fmt::format(
-    "    angular_velocity_stddev_zz: {:.5f}\n", angular_velocity_stddev.z);
+  std::string imu_param;
+  imu_param += "# Estimated by deviation_estimator\n";
+  imu_param += "/**:\n";
+  imu_param += "  ros__parameters:\n";
+  imu_param += fmt::format("    angular_velocity_offset_x: {:.5f}\n", angular_velocity_offset.x);
+  imu_param += fmt::format("    angular_velocity_offset_y: {:.5f}\n", angular_velocity_offset.y);
+  imu_param += fmt::format("    angular_velocity_offset_z: {:.5f}\n", angular_velocity_offset.z);
+  imu_param += fmt::format("    angular_velocity_stddev_xx: {:.5f}\n", angular_velocity_stddev.x);
+  imu_param += fmt::format("    angular_velocity_stddev_yy: {:.5f}\n", angular_velocity_stddev.y);
+  imu_param += fmt::format("    angular_velocity_stddev_zz: {:.5f}\n", angular_velocity_stddev.z);
+  update(IMU_PARAM, std::move(imu_param));
 }
 
 /**
  * @brief log validation results
  */
-void Logger::log_validation_result_section(const ValidationModule & validation_module) const
+void Logger::log_validation_result_section(const ValidationModule & validation_module)
 {
-  std::ofstream file(output_log_path_);
-  file << "# Validation results\n";
-  file << "# value: [min, max]\n";
+  std::string log;
+  log += "# Validation results\n";
+  log += "# value: [min, max]\n";
 
-  std::vector<std::string> keys{
-    "coef_vx",
-    "stddev_vx",
-    "angular_velocity_offset_x",
-    "angular_velocity_offset_y",
-    "angular_velocity_offset_z",
-    "angular_velocity_stddev_xx",
-    "angular_velocity_stddev_yy",
-    "angular_velocity_stddev_zz"};
-
-  for (const std::string & key : keys) {
+  for (int i = 0; i < ValidationModule::ITEM_NUM; ++i) {
+    const auto item = static_cast<ValidationModule::Item>(i);
+    const char * key = ValidationModule::get_name(item);
     try {
-      const auto min_max = validation_module.get_min_max(key);
-      if (validation_module.is_valid(key)) {
-        file << "[OK] ";
+      const auto min_max = validation_module.get_min_max(item);
+      if (validation_module.is_valid(item)) {
+        log += "[OK] ";
       } else {
-        file << "[NG] ";
+        log += "[NG] ";
       }
-      file << fmt::format(
+      log += fmt::format(
         "{}: [{}, {}]\n", key, double_round(min_max.first, 5), double_round(min_max.second, 5));
     } catch (std::domain_error & e) {  // if the data is not enough
-      file << fmt::format("[NG] {}: Not enough data provided yet\n", key);
+      log += fmt::format("[NG] {}: Not enough data provided yet\n", key);
+    }
+  }
+  update(LOG, std::move(log));
+}
+
+/**
+ * @brief replace the pending contents of a file by the latest ones
+ */
+void Logger::update(const OutputFileIndex index, std::string && contents)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_[index].contents = std::move(contents);
+    files_[index].is_pending = true;
+  }
+  condition_.notify_one();
+}
+
+/**
+ * @brief write the pending files, and wait for min_write_interval after each write
+ */
+void Logger::write_loop()
+{
+  std::vector<std::pair<std::string, std::string>> pending_files;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    const auto has_pending = [this]() {
+      for (const auto & file : files_) {
+        if (file.is_pending) {
+          return true;
+        }
+      }
+      return false;
+    };
+    condition_.wait(lock, [&]() { return is_stopped_ || has_pending(); });
+    if (!has_pending()) {
+      return;
+    }
+    pending_files.clear();
+    for (auto & file : files_) {
+      if (file.is_pending) {
+        pending_files.emplace_back(file.path, std::move(file.contents));
+        file.is_pending = false;
+      }
+    }
+
+    // the storage is accessed without the lock, so the results are updated in the meantime
+    lock.unlock();
+    for (const auto & file : pending_files) {
+      write_atomically(file.first, file.second);
     }
+    lock.lock();
+
+    // the results updated until then are written at once, unless the logger is destroyed
+    condition_.wait_for(lock, min_write_interval_, [this]() { return is_stopped_; });
   }
-  file.close();
 }
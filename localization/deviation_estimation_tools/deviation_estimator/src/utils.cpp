@@ -20,7 +20,9 @@
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2/utils.h>
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 
 double double_round(const double x, const int n)
@@ -54,27 +56,29 @@ geometry_msgs::msg::Vector3 interpolate_vector3_stamped(
   const std::vector<geometry_msgs::msg::Vector3Stamped> & vec_list, const double time,
   const double tolerance_sec = 0.1)
 {
-  std::vector<double> time_list{};
-  for (const auto & vec : vec_list) {
-    time_list.push_back(rclcpp::Time(vec.header.stamp).seconds());
-  }
-
+  const auto stamp_seconds = [](const geometry_msgs::msg::Vector3Stamped & vec) {
+    return rclcpp::Time(vec.header.stamp).seconds();
+  };
   const int next_idx =
-    std::upper_bound(time_list.begin(), time_list.end(), time) - time_list.begin();
+    std::upper_bound(
+      vec_list.begin(), vec_list.end(), time,
+      [&stamp_seconds](const double t, const auto & vec) { return t < stamp_seconds(vec); }) -
+    vec_list.begin();
 
   if (next_idx == 0) {
-    if (time_list.front() - time > tolerance_sec) {
+    if (stamp_seconds(vec_list.front()) - time > tolerance_sec) {
       throw std::domain_error("interpolate_vector3_stamped failed! Query time is too small.");
     }
     return vec_list.front().vector;
-  } else if (next_idx == time_list.end() - time_list.begin()) {
-    if (time - time_list.back() > tolerance_sec) {
+  } else if (next_idx == vec_list.end() - vec_list.begin()) {
+    if (time - stamp_seconds(vec_list.back()) > tolerance_sec) {
       throw std::domain_error("interpolate_vector3_stamped failed! Query time is too large.");
     }
     return vec_list.back().vector;
   } else {
     const int prev_idx = next_idx - 1;
-    const double ratio = (time - time_list[prev_idx]) / (time_list[next_idx] - time_list[prev_idx]);
+    const double t_prev = stamp_seconds(vec_list[prev_idx]);
+    const double ratio = (time - t_prev) / (stamp_seconds(vec_list[next_idx]) - t_prev);
     geometry_msgs::msg::Point interpolated_vec =
       calcInterpolatedPoint(vec_list[prev_idx].vector, vec_list[next_idx].vector, ratio);
 
@@ -82,6 +86,50 @@ geometry_msgs::msg::Vector3 interpolate_vector3_stamped(
   }
 }
 
+Vector3StampedInterpolator::Vector3StampedInterpolator(
+  const std::vector<geometry_msgs::msg::Vector3Stamped> & vec_list, const double tolerance_sec)
+: vec_list_(vec_list), tolerance_sec_(tolerance_sec)
+{
+  time_list_.reserve(vec_list.size());
+  for (const auto & vec : vec_list) {
+    time_list_.push_back(rclcpp::Time(vec.header.stamp).seconds());
+  }
+}
+
+/**
+ * @brief the same as interpolate_vector3_stamped, with the upper bound searched forward from the
+ * last one so that the queries in the order of the time are linear in total
+ */
+geometry_msgs::msg::Vector3 Vector3StampedInterpolator::interpolate(const double time)
+{
+  if (next_idx_ > 0 && time < time_list_[next_idx_ - 1]) {
+    next_idx_ = std::upper_bound(time_list_.begin(), time_list_.end(), time) - time_list_.begin();
+  }
+  while (next_idx_ < time_list_.size() && time_list_[next_idx_] <= time) {
+    ++next_idx_;
+  }
+
+  if (next_idx_ == 0) {
+    if (time_list_.front() - time > tolerance_sec_) {
+      throw std::domain_error("interpolate_vector3_stamped failed! Query time is too small.");
+    }
+    return vec_list_.front().vector;
+  } else if (next_idx_ == time_list_.size()) {
+    if (time - time_list_.back() > tolerance_sec_) {
+      throw std::domain_error("interpolate_vector3_stamped failed! Query time is too large.");
+    }
+    return vec_list_.back().vector;
+  } else {
+    const std::size_t prev_idx = next_idx_ - 1;
+    const double ratio =
+      (time - time_list_[prev_idx]) / (time_list_[next_idx_] - time_list_[prev_idx]);
+    geometry_msgs::msg::Point interpolated_vec =
+      calcInterpolatedPoint(vec_list_[prev_idx].vector, vec_list_[next_idx_].vector, ratio);
+
+    return createVector3(interpolated_vec.x, interpolated_vec.y, interpolated_vec.z);
+  }
+}
+
 /**
  * @brief perform a simple dead reckoning and return a relative position of end point from start
  * point
@@ -94,10 +142,10 @@ geometry_msgs::msg::Point integrate_position(
   double t_prev = rclcpp::Time(vx_list.front().stamp).seconds();
   double yaw = yaw_init;
   geometry_msgs::msg::Point d_pos = autoware::universe_utils::createPoint(0.0, 0.0, 0.0);
+  Vector3StampedInterpolator gyro_interpolator(gyro_list);
   for (std::size_t i = 0; i < vx_list.size() - 1; ++i) {
     const double t_cur = rclcpp::Time(vx_list[i + 1].stamp).seconds();
-    const geometry_msgs::msg::Vector3 gyro_interpolated =
-      interpolate_vector3_stamped(gyro_list, rclcpp::Time(vx_list[i + 1].stamp).seconds());
+    const geometry_msgs::msg::Vector3 gyro_interpolated = gyro_interpolator.interpolate(t_cur);
     yaw += gyro_interpolated.z * (t_cur - t_prev);
 
     d_pos.x += (t_cur - t_prev) * vx_list[i].data * std::cos(yaw) * coef_vx;
@@ -108,6 +156,109 @@ geometry_msgs::msg::Point integrate_position(
   return d_pos;
 }
 
+TrajectoryArrays to_trajectory_arrays(const TrajectoryData & traj_data)
+{
+  TrajectoryArrays arrays;
+  rclcpp::Time origin;
+  if (!traj_data.pose_list.empty()) {
+    origin = rclcpp::Time(traj_data.pose_list.front().header.stamp);
+  } else if (!traj_data.vx_list.empty()) {
+    origin = rclcpp::Time(traj_data.vx_list.front().stamp);
+  } else if (!traj_data.gyro_list.empty()) {
+    origin = rclcpp::Time(traj_data.gyro_list.front().header.stamp);
+  } else {
+    return arrays;
+  }
+
+  arrays.vx_t.reserve(traj_data.vx_list.size());
+  arrays.vx.reserve(traj_data.vx_list.size());
+  for (const auto & msg : traj_data.vx_list) {
+    arrays.vx_t.push_back((rclcpp::Time(msg.stamp) - origin).seconds());
+    arrays.vx.push_back(msg.data);
+  }
+
+  arrays.gyro_t.reserve(traj_data.gyro_list.size());
+  arrays.wx.reserve(traj_data.gyro_list.size());
+  arrays.wy.reserve(traj_data.gyro_list.size());
+  arrays.wz.reserve(traj_data.gyro_list.size());
+  for (const auto & msg : traj_data.gyro_list) {
+    arrays.gyro_t.push_back((rclcpp::Time(msg.header.stamp) - origin).seconds());
+    arrays.wx.push_back(msg.vector.x);
+    arrays.wy.push_back(msg.vector.y);
+    arrays.wz.push_back(msg.vector.z);
+  }
+
+  if (!traj_data.pose_list.empty()) {
+    const auto & pose_front = traj_data.pose_list.front();
+    const auto & pose_back = traj_data.pose_list.back();
+    arrays.pose_t_front = 0.0;
+    arrays.pose_t_back = (rclcpp::Time(pose_back.header.stamp) - origin).seconds();
+    arrays.position_front = pose_front.pose.position;
+    arrays.position_back = pose_back.pose.position;
+    arrays.rpy_front = autoware::universe_utils::getRPY(pose_front.pose.orientation);
+    arrays.rpy_back = autoware::universe_utils::getRPY(pose_back.pose.orientation);
+    arrays.yaw_front = tf2::getYaw(pose_front.pose.orientation);
+  }
+  return arrays;
+}
+
+/**
+ * @brief the same as integrate_position of the messages, with the yaw integrated first and then
+ * the position increments, which are independent of each other given the yaw
+ */
+geometry_msgs::msg::Point integrate_position(
+  const TrajectoryArrays & arrays, const double coef_vx, const double yaw_init)
+{
+  const double tolerance_sec = 0.1;
+  const std::vector<double> & t = arrays.vx_t;
+  const std::vector<double> & gyro_t = arrays.gyro_t;
+  geometry_msgs::msg::Point d_pos = autoware::universe_utils::createPoint(0.0, 0.0, 0.0);
+  if (t.size() < 2) return d_pos;
+  if (gyro_t.empty()) {
+    throw std::domain_error("integrate_position failed! No gyro data.");
+  }
+
+  // yaw at the velocity stamps, with the yaw rate interpolated by a forward merge of the stamps
+  std::vector<double> yaw_list(t.size() - 1);
+  double yaw = yaw_init;
+  std::size_t next_idx = 0;
+  for (std::size_t i = 0; i + 1 < t.size(); ++i) {
+    const double t_cur = t[i + 1];
+    while (next_idx < gyro_t.size() && gyro_t[next_idx] <= t_cur) {
+      ++next_idx;
+    }
+    double wz;
+    if (next_idx == 0) {
+      if (gyro_t.front() - t_cur > tolerance_sec) {
+        throw std::domain_error("interpolate_vector3_stamped failed! Query time is too small.");
+      }
+      wz = arrays.wz.front();
+    } else if (next_idx == gyro_t.size()) {
+      if (t_cur - gyro_t.back() > tolerance_sec) {
+        throw std::domain_error("interpolate_vector3_stamped failed! Query time is too large.");
+      }
+      wz = arrays.wz.back();
+    } else {
+      const std::size_t prev_idx = next_idx - 1;
+      const double ratio = (t_cur - gyro_t[prev_idx]) / (gyro_t[next_idx] - gyro_t[prev_idx]);
+      wz = arrays.wz[prev_idx] + (arrays.wz[next_idx] - arrays.wz[prev_idx]) * ratio;
+    }
+    yaw += wz * (t_cur - t[i]);
+    yaw_list[i] = yaw;
+  }
+
+  double dx = 0.0;
+  double dy = 0.0;
+  for (std::size_t i = 0; i < yaw_list.size(); ++i) {
+    const double ds = (t[i + 1] - t[i]) * arrays.vx[i];
+    dx += ds * std::cos(yaw_list[i]) * coef_vx;
+    dy += ds * std::sin(yaw_list[i]) * coef_vx;
+  }
+  d_pos.x = dx;
+  d_pos.y = dy;
+  return d_pos;
+}
+
 /**
  * @brief calculate RPY error on dead-reckoning (calculated from "gyro_list") compared to the
  * ground-truth pose from "pose_list".
@@ -129,6 +280,19 @@ geometry_msgs::msg::Vector3 calculate_error_rpy(
   return error_rpy;
 }
 
+geometry_msgs::msg::Vector3 calculate_error_rpy(
+  const TrajectoryArrays & arrays, const geometry_msgs::msg::Vector3 & gyro_bias)
+{
+  const geometry_msgs::msg::Vector3 & rpy_0 = arrays.rpy_front;
+  const geometry_msgs::msg::Vector3 & rpy_1 = arrays.rpy_back;
+  const geometry_msgs::msg::Vector3 d_rpy = integrate_orientation(arrays, gyro_bias);
+
+  geometry_msgs::msg::Vector3 error_rpy = createVector3(
+    clip_radian(-rpy_1.x + rpy_0.x + d_rpy.x), clip_radian(-rpy_1.y + rpy_0.y + d_rpy.y),
+    clip_radian(-rpy_1.z + rpy_0.z + d_rpy.z));
+  return error_rpy;
+}
+
 /**
  * @brief perform dead reckoning based on "gyro_list" and return a relative pose (in RPY)
  */
@@ -150,6 +314,22 @@ geometry_msgs::msg::Vector3 integrate_orientation(
   return d_rpy;
 }
 
+geometry_msgs::msg::Vector3 integrate_orientation(
+  const TrajectoryArrays & arrays, const geometry_msgs::msg::Vector3 & gyro_bias)
+{
+  const std::vector<double> & t = arrays.gyro_t;
+  double d_roll = 0.0;
+  double d_pitch = 0.0;
+  double d_yaw = 0.0;
+  for (std::size_t i = 0; i + 1 < t.size(); ++i) {
+    const double dt = t[i + 1] - t[i];
+    d_roll += dt * (arrays.wx[i] - gyro_bias.x);
+    d_pitch += dt * (arrays.wy[i] - gyro_bias.y);
+    d_yaw += dt * (arrays.wz[i] - gyro_bias.z);
+  }
+  return createVector3(d_roll, d_pitch, d_yaw);
+}
+
 /**
  * @brief calculate mean of |vx|
  */
@@ -188,6 +368,32 @@ double get_mean_accel(
   return (vx_list.back().data - vx_list.front().data) / dt;
 }
 
+double get_mean_abs_vx(const TrajectoryArrays & arrays)
+{
+  double mean_abs_vx = 0;
+  for (const double vx : arrays.vx) {
+    mean_abs_vx += std::abs(vx);
+  }
+  mean_abs_vx /= arrays.vx.size();
+  return mean_abs_vx;
+}
+
+double get_mean_abs_wz(const TrajectoryArrays & arrays)
+{
+  double mean_abs_wz = 0;
+  for (const double wz : arrays.wz) {
+    mean_abs_wz += std::abs(wz);
+  }
+  mean_abs_wz /= arrays.wz.size();
+  return mean_abs_wz;
+}
+
+double get_mean_accel(const TrajectoryArrays & arrays)
+{
+  const double dt = arrays.vx_t.back() - arrays.vx_t.front();
+  return (arrays.vx.back() - arrays.vx.front()) / dt;
+}
+
 /**
  * @brief transform a vector by "transform"
  */
@@ -14,43 +14,85 @@
 
 #include "deviation_estimator/validation_module.hpp"
 
-#include <algorithm>
 #include <limits>
+#include <stdexcept>
 #include <string>
 #include <utility>
-#include <vector>
+
+namespace
+{
+constexpr std::array<const char *, ValidationModule::ITEM_NUM> item_names{
+  "coef_vx",
+  "stddev_vx",
+  "angular_velocity_offset_x",
+  "angular_velocity_offset_y",
+  "angular_velocity_offset_z",
+  "angular_velocity_stddev_xx",
+  "angular_velocity_stddev_yy",
+  "angular_velocity_stddev_zz"};
+}  // namespace
+
+SlidingMinMax::SlidingMinMax(const size_t window_size) : window_size_(window_size)
+{
+}
 
 /**
- * @brief ValidationModule validates if estimated parameters are properly converged, given a
- * predefined threshold in this constructor arguments
+ * @brief add a value, and drop the candidates which can no longer be the min or max of a window
  */
-ValidationModule::ValidationModule(
-  const double threshold_coef_vx, const double threshold_stddev_vx,
-  const double threshold_bias_gyro, const double threshold_stddev_gyro, const size_t num_history)
-: num_history_(num_history)
+void SlidingMinMax::push_back(const double value)
 {
-  threshold_dict_["coef_vx"] = threshold_coef_vx;
-  threshold_dict_["stddev_vx"] = threshold_stddev_vx;
-  threshold_dict_["angular_velocity_offset_x"] = threshold_bias_gyro;
-  threshold_dict_["angular_velocity_offset_y"] = threshold_bias_gyro;
-  threshold_dict_["angular_velocity_offset_z"] = threshold_bias_gyro;
-  threshold_dict_["angular_velocity_stddev_xx"] = threshold_stddev_gyro;
-  threshold_dict_["angular_velocity_stddev_yy"] = threshold_stddev_gyro;
-  threshold_dict_["angular_velocity_stddev_zz"] = threshold_stddev_gyro;
+  last_value_ = value;
+  const size_t index = count_++;
+  if (window_size_ == 0) {
+    return;
+  }
+
+  while (!min_candidates_.empty() && min_candidates_.back().second >= value) {
+    min_candidates_.pop_back();
+  }
+  min_candidates_.emplace_back(index, value);
+  while (!max_candidates_.empty() && max_candidates_.back().second <= value) {
+    max_candidates_.pop_back();
+  }
+  max_candidates_.emplace_back(index, value);
+
+  // the window holds the indices from index - window_size_ + 1 to index
+  while (min_candidates_.front().first + window_size_ <= index) {
+    min_candidates_.pop_front();
+  }
+  while (max_candidates_.front().first + window_size_ <= index) {
+    max_candidates_.pop_front();
+  }
 }
 
 /**
- * @brief get a min and max of a given vector
+ * @brief get a min and max of the last window_size values
  */
-std::pair<double, double> get_min_max_from_vector(const std::vector<double> & vec, const int num)
+std::pair<double, double> SlidingMinMax::get_min_max() const
 {
-  double min_val = std::numeric_limits<double>::max();
-  double max_val = -std::numeric_limits<double>::max();
-  for (int i = 0; i < num; ++i) {
-    min_val = std::min(min_val, vec[vec.size() - i - 1]);
-    max_val = std::max(max_val, vec[vec.size() - i - 1]);
+  if (min_candidates_.empty()) {
+    return std::pair<double, double>(
+      std::numeric_limits<double>::max(), -std::numeric_limits<double>::max());
   }
-  return std::pair<double, double>(min_val, max_val);
+  return std::pair<double, double>(min_candidates_.front().second, max_candidates_.front().second);
+}
+
+/**
+ * @brief ValidationModule validates if estimated parameters are properly converged, given a
+ * predefined threshold in this constructor arguments
+ */
+ValidationModule::ValidationModule(
+  const double threshold_coef_vx, const double threshold_stddev_vx,
+  const double threshold_bias_gyro, const double threshold_stddev_gyro, const size_t num_history)
+: histories_{
+    SlidingMinMax(num_history), SlidingMinMax(num_history), SlidingMinMax(num_history),
+    SlidingMinMax(num_history), SlidingMinMax(num_history), SlidingMinMax(num_history),
+    SlidingMinMax(num_history), SlidingMinMax(num_history)},
+  thresholds_{threshold_coef_vx,     threshold_stddev_vx,   threshold_bias_gyro,
+              threshold_bias_gyro,   threshold_bias_gyro,   threshold_stddev_gyro,
+              threshold_stddev_gyro, threshold_stddev_gyro},
+  num_history_(num_history)
+{
 }
 
 /**
@@ -58,14 +100,12 @@ std::pair<double, double> get_min_max_from_vector(const std::vector<double> & ve
  */
 void ValidationModule::set_velocity_data(const double coef_vx, const double stddev_vx)
 {
-  if (data_list_dict_.count("coef_vx")) {
-    if (coef_vx == data_list_dict_["coef_vx"].back()) {
-      return;
-    }
+  if (histories_[COEF_VX].size() > 0 && coef_vx == histories_[COEF_VX].back()) {
+    return;
   }
 
-  data_list_dict_["coef_vx"].push_back(coef_vx);
-  data_list_dict_["stddev_vx"].push_back(stddev_vx);
+  histories_[COEF_VX].push_back(coef_vx);
+  histories_[STDDEV_VX].push_back(stddev_vx);
 }
 
 /**
@@ -74,33 +114,46 @@ void ValidationModule::set_velocity_data(const double coef_vx, const double stdd
 void ValidationModule::set_gyro_data(
   const geometry_msgs::msg::Vector3 & bias_gyro, const geometry_msgs::msg::Vector3 & stddev_gyro)
 {
-  if (data_list_dict_.count("angular_velocity_offset_x")) {
-    if (bias_gyro.x == data_list_dict_["angular_velocity_offset_x"].back()) {
-      return;
-    }
+  if (
+    histories_[ANGULAR_VELOCITY_OFFSET_X].size() > 0 &&
+    bias_gyro.x == histories_[ANGULAR_VELOCITY_OFFSET_X].back()) {
+    return;
   }
 
-  data_list_dict_["angular_velocity_offset_x"].push_back(bias_gyro.x);
-  data_list_dict_["angular_velocity_offset_y"].push_back(bias_gyro.y);
-  data_list_dict_["angular_velocity_offset_z"].push_back(bias_gyro.z);
-  data_list_dict_["angular_velocity_stddev_xx"].push_back(stddev_gyro.x);
-  data_list_dict_["angular_velocity_stddev_yy"].push_back(stddev_gyro.y);
-  data_list_dict_["angular_velocity_stddev_zz"].push_back(stddev_gyro.z);
+  histories_[ANGULAR_VELOCITY_OFFSET_X].push_back(bias_gyro.x);
+  histories_[ANGULAR_VELOCITY_OFFSET_Y].push_back(bias_gyro.y);
+  histories_[ANGULAR_VELOCITY_OFFSET_Z].push_back(bias_gyro.z);
+  histories_[ANGULAR_VELOCITY_STDDEV_XX].push_back(stddev_gyro.x);
+  histories_[ANGULAR_VELOCITY_STDDEV_YY].push_back(stddev_gyro.y);
+  histories_[ANGULAR_VELOCITY_STDDEV_ZZ].push_back(stddev_gyro.z);
 }
 
 /**
- * @brief get a min and max of a certain vector (designated by a key)
+ * @brief get a min and max of the last num_history values of an item
  */
-std::pair<double, double> ValidationModule::get_min_max(const std::string key) const
+std::pair<double, double> ValidationModule::get_min_max(const Item item) const
 {
-  if (data_list_dict_.count(key)) {
-    if (data_list_dict_.at(key).size() < num_history_) {
-      throw std::domain_error("The data is not enough. Provide more data for valid results.");
-    }
-    return get_min_max_from_vector(data_list_dict_.at(key), num_history_);
-  } else {
-    throw std::runtime_error("Invalid key in ValidationModule::get_min_max");
+  if (histories_.at(item).size() < num_history_) {
+    throw std::domain_error("The data is not enough. Provide more data for valid results.");
   }
+  return histories_.at(item).get_min_max();
+}
+
+/**
+ * @brief check if the given item is valid
+ */
+bool ValidationModule::is_valid(const Item item) const
+{
+  const auto min_max = get_min_max(item);
+  return min_max.second - min_max.first < thresholds_.at(item);
+}
+
+/**
+ * @brief get a min and max of a certain item (designated by a key)
+ */
+std::pair<double, double> ValidationModule::get_min_max(const std::string key) const
+{
+  return get_min_max(to_item(key));
 }
 
 /**
@@ -108,6 +161,23 @@ std::pair<double, double> ValidationModule::get_min_max(const std::string key) c
  */
 bool ValidationModule::is_valid(const std::string key) const
 {
-  const auto min_max = this->get_min_max(key);
-  return min_max.second - min_max.first < threshold_dict_.at(key);
+  return is_valid(to_item(key));
+}
+
+/**
+ * @brief get the key of an item, which is also its name in the logs
+ */
+const char * ValidationModule::get_name(const Item item)
+{
+  return item_names.at(item);
+}
+
+ValidationModule::Item ValidationModule::to_item(const std::string & key)
+{
+  for (size_t i = 0; i < item_names.size(); ++i) {
+    if (key == item_names[i]) {
+      return static_cast<Item>(i);
+    }
+  }
+  throw std::runtime_error("Invalid key in ValidationModule::get_min_max");
 }
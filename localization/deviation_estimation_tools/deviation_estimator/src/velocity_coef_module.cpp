@@ -22,32 +22,39 @@
  */
 void VelocityCoefModule::update_coef(const TrajectoryData & traj_data)
 {
-  const rclcpp::Time t0_rclcpp_time = rclcpp::Time(traj_data.pose_list.front().header.stamp);
-  const rclcpp::Time t1_rclcpp_time = rclcpp::Time(traj_data.pose_list.back().header.stamp);
+  update_coef(to_trajectory_arrays(traj_data));
+}
 
-  auto d_pos = integrate_position(
-    traj_data.vx_list, traj_data.gyro_list, 1.0,
-    tf2::getYaw(traj_data.pose_list.front().pose.orientation));
-  const double dt_pose = (rclcpp::Time(traj_data.pose_list.back().header.stamp) -
-                          rclcpp::Time(traj_data.pose_list.front().header.stamp))
-                           .seconds();
-  const double dt_velocity =
-    (rclcpp::Time(traj_data.vx_list.back().stamp) - rclcpp::Time(traj_data.vx_list.front().stamp))
-      .seconds();
+void VelocityCoefModule::update_coef(const TrajectoryArrays & arrays)
+{
+  if (const auto d_coef_vx = observe_velocity_coef(arrays)) {
+    update_coef(*d_coef_vx);
+  }
+}
+
+std::optional<double> observe_velocity_coef(const TrajectoryArrays & arrays)
+{
+  auto d_pos = integrate_position(arrays, 1.0, arrays.yaw_front);
+  const double dt_pose = arrays.pose_t_back - arrays.pose_t_front;
+  const double dt_velocity = arrays.vx_t.back() - arrays.vx_t.front();
   d_pos.x *= dt_pose / dt_velocity;
   d_pos.y *= dt_pose / dt_velocity;
 
-  const double dx =
-    traj_data.pose_list.back().pose.position.x - traj_data.pose_list.front().pose.position.x;
-  const double dy =
-    traj_data.pose_list.back().pose.position.y - traj_data.pose_list.front().pose.position.y;
-  if (d_pos.x * d_pos.x + d_pos.y * d_pos.y == 0) return;
+  const double dx = arrays.position_back.x - arrays.position_front.x;
+  const double dy = arrays.position_back.y - arrays.position_front.y;
+  if (d_pos.x * d_pos.x + d_pos.y * d_pos.y == 0) return std::nullopt;
 
-  const double d_coef_vx = (d_pos.x * dx + d_pos.y * dy) / (d_pos.x * d_pos.x + d_pos.y * d_pos.y);
+  return (d_pos.x * dx + d_pos.y * dy) / (d_pos.x * d_pos.x + d_pos.y * d_pos.y);
+}
 
+/**
+ * @brief update the coefficient by the observation of a window, which may be from a saved state
+ */
+void VelocityCoefModule::update_coef(const double d_coef_vx)
+{
   coef_vx_.first += d_coef_vx;
   coef_vx_.second += 1;
-  coef_vx_list_.push_back(d_coef_vx);
+  coef_vx_stat_.add(d_coef_vx);
 }
 
 /**
@@ -64,7 +71,7 @@ double VelocityCoefModule::get_coef() const
  */
 double VelocityCoefModule::get_coef_std() const
 {
-  return calculate_std(coef_vx_list_);
+  return coef_vx_stat_.std();
 }
 
 bool VelocityCoefModule::empty() const
@@ -0,0 +1,273 @@
+// Copyright 2022 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the stages of the offline deviation estimation over a synthetic bag, with 200 Hz
+// IMU, 50 Hz velocity and 10 Hz pose. It is not run by ctest:
+//   deviation_estimator_benchmark [duration_sec=600]
+
+#include "autoware/universe_utils/geometry/geometry.hpp"
+#include "autoware/universe_utils/system/stop_watch.hpp"
+#include "deviation_estimator/deviation_estimator.hpp"
+
+#include <rclcpp/serialization.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_cpp/writer.hpp>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+const std::string velocity_topic = "/vehicle/status/velocity_status";
+const std::string imu_topic = "/sensing/imu/tamagawa/imu_raw";
+const std::string pose_topic = "/localization/pose_estimator/pose_with_covariance";
+
+const double imu_rate = 200.0;
+const double velocity_rate = 50.0;
+const double pose_rate = 10.0;
+const double time_window = 4.0;
+
+// peak resident set size of the process [MB]
+double peak_memory_mb()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+void report(const char * stage, const size_t num, const char * unit, double time_ms)
+{
+  time_ms = std::max(time_ms, 1e-3);
+  std::printf(
+    "%-16s %10lu %-9s in %10.1f[ms], %14.1f %s/s, peak memory %8.1f[MB]\n", stage, num, unit,
+    time_ms, static_cast<double>(num) / (time_ms * 1e-3), unit, peak_memory_mb());
+}
+
+// a vehicle driving a gentle slalom with a noisy, biased gyro and a scaled wheel speed
+void write_synthetic_bag(const std::string & uri, const double duration)
+{
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = uri;
+  storage_options.storage_id = "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::Writer writer;
+  writer.open(storage_options, converter_options);
+
+  std::mt19937 engine(0);
+  std::normal_distribution<> gyro_noise(0.0, 0.01);
+  std::normal_distribution<> velocity_noise(0.0, 0.05);
+  const double vx = 10.0;
+  const auto wz = [](const double t) { return 0.05 * std::sin(0.2 * t); };
+  const auto yaw = [](const double t) { return 0.25 * (1.0 - std::cos(0.2 * t)); };
+  const rclcpp::Time t_start(1000, 0);
+
+  // the pose is integrated in small steps, to be consistent with the twist
+  double x = 0.0;
+  double y = 0.0;
+  const double dt = 1.0 / imu_rate;
+  const int step_num = static_cast<int>(duration * imu_rate);
+  for (int i = 0; i < step_num; ++i) {
+    const double t = i * dt;
+    const rclcpp::Time stamp = t_start + rclcpp::Duration::from_seconds(t);
+
+    sensor_msgs::msg::Imu imu;
+    imu.header.stamp = stamp;
+    imu.header.frame_id = "base_link";
+    imu.angular_velocity.x = 0.001 + gyro_noise(engine);
+    imu.angular_velocity.y = -0.002 + gyro_noise(engine);
+    imu.angular_velocity.z = wz(t) + 0.003 + gyro_noise(engine);
+    writer.write(imu, imu_topic, stamp);
+
+    if (i % static_cast<int>(imu_rate / velocity_rate) == 0) {
+      autoware_vehicle_msgs::msg::VelocityReport velocity;
+      velocity.header.stamp = stamp;
+      velocity.longitudinal_velocity = vx / 1.02 + velocity_noise(engine);
+      writer.write(velocity, velocity_topic, stamp);
+    }
+    if (i % static_cast<int>(imu_rate / pose_rate) == 0) {
+      geometry_msgs::msg::PoseWithCovarianceStamped pose;
+      pose.header.stamp = stamp;
+      pose.header.frame_id = "map";
+      pose.pose.pose.position = autoware::universe_utils::createPoint(x, y, 0.0);
+      pose.pose.pose.orientation = autoware::universe_utils::createQuaternionFromYaw(yaw(t));
+      writer.write(pose, pose_topic, stamp);
+    }
+    x += vx * std::cos(yaw(t)) * dt;
+    y += vx * std::sin(yaw(t)) * dt;
+  }
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const double duration = argc > 1 ? std::stod(argv[1]) : 600.0;
+  const std::string uri = (std::filesystem::temp_directory_path() /
+                           ("deviation_estimator_benchmark_" + std::to_string(getpid())))
+                            .string();
+  std::filesystem::remove_all(uri);
+
+  autoware::universe_utils::StopWatch<std::chrono::milliseconds> stop_watch;
+  const size_t velocity_num = static_cast<size_t>(duration * velocity_rate);
+
+  stop_watch.tic("write");
+  write_synthetic_bag(uri, duration);
+  const double write_time = stop_watch.toc("write");
+
+  // ---------- //
+  // Bag decode //
+  // ---------- //
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = uri;
+  storage_options.storage_id = "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::readers::SequentialReader reader;
+  reader.open(storage_options, converter_options);
+  rclcpp::Serialization<autoware_vehicle_msgs::msg::VelocityReport> serialization_velocity;
+  rclcpp::Serialization<sensor_msgs::msg::Imu> serialization_imu;
+  rclcpp::Serialization<geometry_msgs::msg::PoseWithCovarianceStamped> serialization_pose;
+
+  std::vector<TrajectoryData> trajectory_data_list(
+    static_cast<size_t>(duration / time_window) + 1);
+  rclcpp::Time first_stamp;
+  bool has_first_stamp = false;
+  auto get_window = [&](const rclcpp::Time & stamp) -> TrajectoryData & {
+    if (!has_first_stamp) {
+      first_stamp = stamp;
+      has_first_stamp = true;
+    }
+    const size_t index = static_cast<size_t>((stamp - first_stamp).seconds() / time_window);
+    return trajectory_data_list[std::min(index, trajectory_data_list.size() - 1)];
+  };
+
+  size_t message_num = 0;
+  stop_watch.tic("decode");
+  while (reader.has_next()) {
+    const auto serialized_message = reader.read_next();
+    const rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+    if (serialized_message->topic_name == velocity_topic) {
+      autoware_vehicle_msgs::msg::VelocityReport velocity;
+      serialization_velocity.deserialize_message(&msg, &velocity);
+      autoware_internal_debug_msgs::msg::Float64Stamped vx;
+      vx.stamp = velocity.header.stamp;
+      vx.data = velocity.longitudinal_velocity;
+      get_window(vx.stamp).vx_list.push_back(vx);
+    } else if (serialized_message->topic_name == imu_topic) {
+      sensor_msgs::msg::Imu imu;
+      serialization_imu.deserialize_message(&msg, &imu);
+      geometry_msgs::msg::Vector3Stamped gyro;
+      gyro.header = imu.header;
+      gyro.vector = imu.angular_velocity;
+      get_window(gyro.header.stamp).gyro_list.push_back(gyro);
+    } else {
+      geometry_msgs::msg::PoseWithCovarianceStamped pose;
+      serialization_pose.deserialize_message(&msg, &pose);
+      geometry_msgs::msg::PoseStamped pose_stamped;
+      pose_stamped.header = pose.header;
+      pose_stamped.pose = pose.pose.pose;
+      get_window(pose.header.stamp).pose_list.push_back(pose_stamped);
+    }
+    message_num++;
+  }
+  const double decode_time = stop_watch.toc("decode");
+  std::filesystem::remove_all(uri);
+
+  // the windows with enough data, as the offline tool uses
+  std::vector<const TrajectoryData *> windows;
+  for (const auto & traj_data : trajectory_data_list) {
+    if (
+      traj_data.pose_list.size() >= 2 && traj_data.gyro_list.size() >= 2 &&
+      traj_data.vx_list.size() >= 2) {
+      windows.push_back(&traj_data);
+    }
+  }
+
+  // ------------------------------------ //
+  // Conversion, interpolation and update //
+  // ------------------------------------ //
+  stop_watch.tic("conversion");
+  std::vector<TrajectoryArrays> arrays_list;
+  arrays_list.reserve(windows.size());
+  for (const auto * traj_data : windows) {
+    arrays_list.push_back(to_trajectory_arrays(*traj_data));
+  }
+  const double conversion_time = stop_watch.toc("conversion");
+
+  double distance = 0.0;
+  stop_watch.tic("interpolation");
+  for (const auto & arrays : arrays_list) {
+    const auto d_pos = integrate_position(arrays, 1.0, arrays.yaw_front);
+    distance += std::hypot(d_pos.x, d_pos.y);
+  }
+  const double interpolation_time = stop_watch.toc("interpolation");
+
+  GyroBiasModule gyro_bias_module;
+  VelocityCoefModule vel_coef_module;
+  stop_watch.tic("update");
+  for (const auto & arrays : arrays_list) {
+    gyro_bias_module.update_bias(arrays);
+    vel_coef_module.update_coef(arrays);
+  }
+  const double update_time = stop_watch.toc("update");
+
+  // ---------------- //
+  // Full offline run //
+  // ---------------- //
+  // from the decoded windows to the standard deviations over every prefix of the windows
+  stop_watch.tic("offline");
+  GyroBiasModule offline_gyro_bias_module;
+  VelocityCoefModule offline_vel_coef_module;
+  std::deque<VelocityWindowSummary> velocity_window_list;
+  std::deque<GyroWindowSummary> gyro_window_list;
+  double stddev_vx = 0.0;
+  geometry_msgs::msg::Vector3 stddev_angvel;
+  for (const auto * traj_data : windows) {
+    const TrajectoryArrays arrays = to_trajectory_arrays(*traj_data);
+    offline_vel_coef_module.update_coef(arrays);
+    velocity_window_list.push_back(summarize_velocity_window(arrays));
+    offline_gyro_bias_module.update_bias(arrays);
+    gyro_window_list.push_back(summarize_gyro_window(arrays));
+    stddev_vx = estimate_stddev_velocity(velocity_window_list, offline_vel_coef_module.get_coef());
+    stddev_angvel = estimate_stddev_angular_velocity(
+      gyro_window_list, offline_gyro_bias_module.get_bias_base_link());
+  }
+  const double offline_time = stop_watch.toc("offline");
+
+  std::printf(
+    "benchmark of %.0f[s], %lu messages, %lu windows (coef_vx %.4f, bias_z %.5f, stddev_vx %.4f, "
+    "stddev_wz %.5f, distance %.1f)\n",
+    duration, message_num, windows.size(), vel_coef_module.get_coef(),
+    gyro_bias_module.get_bias_base_link().z, stddev_vx, stddev_angvel.z, distance);
+  report("write", message_num, "messages", write_time);
+  report("decode", message_num, "messages", decode_time);
+  report("conversion", message_num, "messages", conversion_time);
+  report("interpolation", velocity_num, "velocity", interpolation_time);
+  report("update", windows.size(), "windows", update_time);
+  report("offline", message_num, "messages", offline_time);
+  report("offline", windows.size(), "windows", offline_time);
+  return 0;
+}
@@ -0,0 +1,114 @@
+// Copyright 2022 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/estimation_state.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+namespace
+{
+BagState make_bag(const std::string & hash, const size_t window_num)
+{
+  BagState bag;
+  bag.hash = hash;
+  bag.imu_frame_id = "imu_link";
+  bag.base_to_imu.transform.translation.x = 0.5;
+  bag.base_to_imu.transform.rotation.z = 0.6;
+  bag.base_to_imu.transform.rotation.w = 0.8;
+  for (size_t i = 0; i < window_num; ++i) {
+    WindowState window;
+    window.use_velocity = true;
+    window.use_gyro = i % 2 == 0;
+    if (i > 0) {
+      window.velocity_coef = 1.0 + 0.1 / (i + 1);
+    }
+    window.gyro_bias.dt = 30.0;
+    window.gyro_bias.error_rpy.z = 1.0 / 3.0 + i;
+    window.velocity_window = {true, 30.0, 3000, 100.0 + i, 99.9};
+    window.gyro_window = {true, 30.0, 29.9, 6000, {}};
+    window.gyro_window.error_rpy_without_bias.x = -0.01 * i;
+    bag.windows.push_back(window);
+  }
+  return bag;
+}
+}  // namespace
+
+TEST(DeviationEstimatorEstimationState, SaveAndLoad)
+{
+  const std::string path = "test_estimation_state.txt";
+  EstimationState state("time_window=30.0;");
+  state.add(make_bag("a1", 3), 0);
+  state.add(make_bag("b2", 2), 0);
+  BagState empty_bag;
+  empty_bag.hash = "e5";
+  state.add(std::move(empty_bag), 0);
+  ASSERT_TRUE(state.save(path));
+
+  EstimationState loaded("time_window=30.0;");
+  ASSERT_TRUE(loaded.load(path));
+  std::remove(path.c_str());
+
+  ASSERT_EQ(loaded.bags().size(), 3u);
+  EXPECT_TRUE(loaded.bags().back().imu_frame_id.empty());
+  EXPECT_TRUE(loaded.contains("a1"));
+  EXPECT_TRUE(loaded.contains("b2"));
+  EXPECT_FALSE(loaded.contains("c3"));
+  for (size_t b = 0; b < 2; ++b) {
+    const BagState & expected = state.bags()[b];
+    const BagState & actual = loaded.bags()[b];
+    EXPECT_EQ(actual.imu_frame_id, expected.imu_frame_id);
+    EXPECT_EQ(actual.base_to_imu.transform.rotation.w, expected.base_to_imu.transform.rotation.w);
+    ASSERT_EQ(actual.windows.size(), expected.windows.size());
+    for (size_t i = 0; i < actual.windows.size(); ++i) {
+      const WindowState & e = expected.windows[i];
+      const WindowState & a = actual.windows[i];
+      EXPECT_EQ(a.use_gyro, e.use_gyro);
+      EXPECT_EQ(a.velocity_coef, e.velocity_coef);
+      EXPECT_EQ(a.gyro_bias.error_rpy.z, e.gyro_bias.error_rpy.z);
+      EXPECT_EQ(a.velocity_window.n_vx, e.velocity_window.n_vx);
+      EXPECT_EQ(a.velocity_window.distance, e.velocity_window.distance);
+      EXPECT_EQ(a.gyro_window.error_rpy_without_bias.x, e.gyro_window.error_rpy_without_bias.x);
+    }
+  }
+}
+
+TEST(DeviationEstimatorEstimationState, DropOldestBags)
+{
+  EstimationState state("");
+  state.add(make_bag("a1", 1), 2);
+  state.add(make_bag("b2", 1), 2);
+  state.add(make_bag("c3", 1), 2);
+  ASSERT_EQ(state.bags().size(), 2u);
+  EXPECT_FALSE(state.contains("a1"));
+  EXPECT_EQ(state.bags().front().hash, "b2");
+  EXPECT_EQ(state.bags().back().hash, "c3");
+}
+
+TEST(DeviationEstimatorEstimationState, IgnoreOtherParameters)
+{
+  const std::string path = "test_estimation_state_other.txt";
+  EstimationState state("time_window=30.0;");
+  state.add(make_bag("a1", 1), 0);
+  ASSERT_TRUE(state.save(path));
+
+  EstimationState loaded("time_window=10.0;");
+  EXPECT_FALSE(loaded.load(path));
+  std::remove(path.c_str());
+  EXPECT_TRUE(loaded.bags().empty());
+  EXPECT_FALSE(loaded.load("not_existing_state.txt"));
+}
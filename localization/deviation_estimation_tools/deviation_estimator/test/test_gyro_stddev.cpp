@@ -121,3 +121,40 @@ TEST(DeviationEstimatorGyroStddev, SmokeTestWithBias)
   EXPECT_NEAR(estimated_gyro_stddev.y, stddev_gyro, stddev_gyro * ERROR_RATE);
   EXPECT_NEAR(estimated_gyro_stddev.z, stddev_gyro, stddev_gyro * ERROR_RATE);
 }
+
+TEST(DeviationEstimatorGyroStddev, SummaryMatchesTrajectory)
+{
+  const rclcpp::Time t_start = rclcpp::Time(0, 0);
+  const int gyro_rate = 30;
+  const int ndt_rate = 10;
+  const double t_window = 5;
+  const geometry_msgs::msg::Vector3 gyro_bias = createVector3(0.005, 0.001, -0.01);
+
+  std::mt19937 engine;
+  engine.seed();
+  std::normal_distribution<> dist(0.0, 0.03);
+
+  TrajectoryData traj_data;
+  for (int i = 0; i <= gyro_rate * t_window; ++i) {
+    geometry_msgs::msg::Vector3Stamped gyro;
+    gyro.header.stamp = t_start + rclcpp::Duration::from_seconds(1.0 * i / gyro_rate);
+    gyro.vector = createVector3(dist(engine), dist(engine), 0.1 + dist(engine));
+    traj_data.gyro_list.push_back(gyro);
+  }
+  for (int i = 0; i <= ndt_rate * t_window; ++i) {
+    geometry_msgs::msg::PoseStamped pose;
+    pose.header.stamp = t_start + rclcpp::Duration::from_seconds(1.0 * i / ndt_rate);
+    pose.pose.orientation = autoware::universe_utils::createQuaternionFromRPY(0.0, 0.0, 0.1 * i);
+    traj_data.pose_list.push_back(pose);
+  }
+
+  // the bias correction of the summary is the one of the integration over the gyro samples
+  const GyroWindowSummary window = summarize_gyro_window(traj_data);
+  const geometry_msgs::msg::Vector3 error_rpy =
+    calculate_error_rpy(traj_data.pose_list, traj_data.gyro_list, gyro_bias);
+  const geometry_msgs::msg::Vector3 & e = window.error_rpy_without_bias;
+  ASSERT_TRUE(window.valid);
+  EXPECT_NEAR(clip_radian(e.x - gyro_bias.x * window.dt_gyro), error_rpy.x, 1e-9);
+  EXPECT_NEAR(clip_radian(e.y - gyro_bias.y * window.dt_gyro), error_rpy.y, 1e-9);
+  EXPECT_NEAR(clip_radian(e.z - gyro_bias.z * window.dt_gyro), error_rpy.z, 1e-9);
+}
@@ -12,10 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "autoware/universe_utils/geometry/geometry.hpp"
 #include "deviation_estimator/utils.hpp"
 
 #include <gtest/gtest.h>
 
+#include <stdexcept>
+#include <vector>
+
 TEST(DeviationEstimatorUtils, WhetherToUseData1)
 {
   const bool is_straight = false;
@@ -106,3 +110,84 @@ TEST(DeviationEstimatorUtils, WhetherToUseData7)
     is_straight, is_moving, is_constant_velocity, only_use_straight, only_use_moving,
     only_use_constant_velocity));
 }
+
+TEST(DeviationEstimatorUtils, Vector3StampedInterpolator)
+{
+  std::vector<geometry_msgs::msg::Vector3Stamped> vec_list;
+  for (int i = 0; i < 10; ++i) {
+    geometry_msgs::msg::Vector3Stamped vec;
+    vec.header.stamp = rclcpp::Time(static_cast<int64_t>(i) * 10000000);
+    vec.vector = createVector3(i, 2.0 * i, -i);
+    vec_list.push_back(vec);
+  }
+
+  // the same as interpolate_vector3_stamped, also for the queries back in time
+  Vector3StampedInterpolator interpolator(vec_list);
+  for (const double time : {-0.05, 0.0, 0.015, 0.02, 0.055, 0.09, 0.03, 0.12}) {
+    const auto expected = interpolate_vector3_stamped(vec_list, time, 0.1);
+    const auto interpolated = interpolator.interpolate(time);
+    EXPECT_DOUBLE_EQ(interpolated.x, expected.x);
+    EXPECT_DOUBLE_EQ(interpolated.y, expected.y);
+    EXPECT_DOUBLE_EQ(interpolated.z, expected.z);
+  }
+  EXPECT_THROW(interpolator.interpolate(0.3), std::domain_error);
+}
+
+TEST(DeviationEstimatorUtils, RunningStatistics)
+{
+  const std::vector<double> v = {0.3, -1.2, 2.5, 0.7, 0.0, 1.1};
+  RunningStatistics stat;
+  EXPECT_DOUBLE_EQ(stat.std(), 0.0);
+  for (const double x : v) {
+    stat.add(x);
+  }
+  EXPECT_EQ(stat.count, v.size());
+  EXPECT_NEAR(stat.mean, calculate_mean(v), 1e-12);
+  EXPECT_NEAR(stat.std(), calculate_std(v), 1e-12);
+  EXPECT_NEAR(stat.std_mean_const(0.4), calculate_std_mean_const(v, 0.4), 1e-12);
+}
+
+TEST(DeviationEstimatorUtils, TrajectoryArrays)
+{
+  TrajectoryData traj_data;
+  for (int i = 0; i <= 50; ++i) {
+    autoware_internal_debug_msgs::msg::Float64Stamped vx;
+    vx.stamp = rclcpp::Time(1000000000 + static_cast<int64_t>(i) * 20000000);
+    vx.data = 5.0 + 0.1 * i;
+    traj_data.vx_list.push_back(vx);
+  }
+  for (int i = 0; i <= 100; ++i) {
+    geometry_msgs::msg::Vector3Stamped gyro;
+    gyro.header.stamp = rclcpp::Time(1000000000 + static_cast<int64_t>(i) * 10000000 + 3000000);
+    gyro.vector = createVector3(0.01 * i, -0.02, 0.1 - 0.001 * i);
+    traj_data.gyro_list.push_back(gyro);
+  }
+  for (int i = 0; i <= 10; ++i) {
+    geometry_msgs::msg::PoseStamped pose;
+    pose.header.stamp = rclcpp::Time(1000000000 + static_cast<int64_t>(i) * 100000000);
+    pose.pose.position = autoware::universe_utils::createPoint(0.5 * i, 0.1 * i, 0.0);
+    pose.pose.orientation = autoware::universe_utils::createQuaternionFromRPY(0.01, 0.0, 0.05 * i);
+    traj_data.pose_list.push_back(pose);
+  }
+
+  // the kernels on the arrays are the same as the functions on the messages
+  const TrajectoryArrays arrays = to_trajectory_arrays(traj_data);
+  const double yaw_init = tf2::getYaw(traj_data.pose_list.front().pose.orientation);
+  const auto d_pos = integrate_position(arrays, 1.1, yaw_init);
+  const auto d_pos_expected =
+    integrate_position(traj_data.vx_list, traj_data.gyro_list, 1.1, yaw_init);
+  EXPECT_NEAR(d_pos.x, d_pos_expected.x, 1e-9);
+  EXPECT_NEAR(d_pos.y, d_pos_expected.y, 1e-9);
+
+  const auto gyro_bias = createVector3(0.001, 0.002, -0.003);
+  const auto error_rpy = calculate_error_rpy(arrays, gyro_bias);
+  const auto error_rpy_expected =
+    calculate_error_rpy(traj_data.pose_list, traj_data.gyro_list, gyro_bias);
+  EXPECT_NEAR(error_rpy.x, error_rpy_expected.x, 1e-9);
+  EXPECT_NEAR(error_rpy.y, error_rpy_expected.y, 1e-9);
+  EXPECT_NEAR(error_rpy.z, error_rpy_expected.z, 1e-9);
+
+  EXPECT_NEAR(get_mean_abs_vx(arrays), get_mean_abs_vx(traj_data.vx_list), 1e-12);
+  EXPECT_NEAR(get_mean_abs_wz(arrays), get_mean_abs_wz(traj_data.gyro_list), 1e-12);
+  EXPECT_NEAR(get_mean_accel(arrays), get_mean_accel(traj_data.vx_list), 1e-9);
+}
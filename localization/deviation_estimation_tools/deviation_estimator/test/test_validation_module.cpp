@@ -0,0 +1,65 @@
+// Copyright 2022 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/validation_module.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+TEST(DeviationEstimatorValidationModule, SlidingMinMaxOfRandomValues)
+{
+  const size_t window_size = 5;
+  SlidingMinMax sliding_min_max(window_size);
+  std::vector<double> values;
+  std::mt19937 engine(0);
+  std::uniform_int_distribution<> distribution(-10, 10);
+  for (int i = 0; i < 200; ++i) {
+    values.push_back(distribution(engine));
+    sliding_min_max.push_back(values.back());
+
+    const auto begin = values.end() - std::min(values.size(), window_size);
+    const auto min_max = sliding_min_max.get_min_max();
+    EXPECT_EQ(min_max.first, *std::min_element(begin, values.end()));
+    EXPECT_EQ(min_max.second, *std::max_element(begin, values.end()));
+  }
+}
+
+TEST(DeviationEstimatorValidationModule, ValidAfterConvergence)
+{
+  ValidationModule validation_module(0.1, 0.1, 0.1, 0.1, 3);
+  EXPECT_THROW(validation_module.get_min_max(ValidationModule::COEF_VX), std::domain_error);
+
+  validation_module.set_velocity_data(1.5, 0.2);
+  validation_module.set_velocity_data(1.02, 0.2);
+  validation_module.set_velocity_data(1.0, 0.2);
+  EXPECT_FALSE(validation_module.is_valid(ValidationModule::COEF_VX));
+  EXPECT_TRUE(validation_module.is_valid("stddev_vx"));
+
+  // the same coefficient is not added twice
+  validation_module.set_velocity_data(1.0, 0.2);
+  EXPECT_FALSE(validation_module.is_valid("coef_vx"));
+
+  validation_module.set_velocity_data(1.01, 0.2);
+  const auto min_max = validation_module.get_min_max("coef_vx");
+  EXPECT_DOUBLE_EQ(min_max.first, 1.0);
+  EXPECT_DOUBLE_EQ(min_max.second, 1.02);
+  EXPECT_TRUE(validation_module.is_valid(ValidationModule::COEF_VX));
+
+  EXPECT_THROW(validation_module.get_min_max("angular_velocity_offset_x"), std::domain_error);
+  EXPECT_THROW(validation_module.get_min_max("unknown"), std::runtime_error);
+}
@@ -0,0 +1,96 @@
+// Copyright 2018-2019 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVIATION_EVALUATOR__DEAD_RECKONING_HYPOTHESIS_HPP_
+#define DEVIATION_EVALUATOR__DEAD_RECKONING_HYPOTHESIS_HPP_
+
+#include <Eigen/Core>
+
+#include <string>
+#include <vector>
+
+/**
+ * A set of deviation parameters to evaluate, as given to vehicle_velocity_converter,
+ * imu_corrector and ekf_localizer in the online evaluation.
+ */
+struct HypothesisParameters
+{
+  std::string name;
+  double coef_vx;
+  double stddev_vx;
+  double stddev_wz;
+  // yaw rate bias in base_link [rad/s], i.e. the IMU-frame bias rotated to base_link
+  double bias_wz;
+};
+
+// errors of a hypothesis over the replay
+struct HypothesisResult
+{
+  size_t check_num = 0;
+  size_t segment_num = 0;
+  double max_long_radius = 0.0;
+  double max_lateral = 0.0;
+  double p95_long_radius = 0.0;
+  double p95_lateral = 0.0;
+  // ratio of the checks with an error out of its predicted bound
+  double long_radius_violation_rate = 0.0;
+  double lateral_violation_rate = 0.0;
+  // mean of the predicted bounds at the ends of the segments
+  double mean_long_radius_bound = 0.0;
+  double mean_lateral_bound = 0.0;
+};
+
+/**
+ * 2D dead reckoning (x, y, yaw) from a ground-truth pose with the covariance propagation of an
+ * EKF without measurement updates, to compare its error with the ground truth and the bounds
+ * predicted by the covariance.
+ */
+class DeadReckoningHypothesis
+{
+public:
+  struct Errors
+  {
+    double long_radius;
+    double lateral;
+    double long_radius_bound;
+    double lateral_bound;
+  };
+
+  DeadReckoningHypothesis(const HypothesisParameters & parameters, const double bound_sigma);
+
+  void reset(const double time, const double x, const double y, const double yaw);
+
+  // integrates the last twist up to the time, and sets the twist for the next step
+  void predict(const double time, const double vx, const double wz);
+
+  Errors evaluate(const double x_gt, const double y_gt) const;
+
+  bool isInitialized() const { return initialized_; }
+  double startTime() const { return start_time_; }
+  const HypothesisParameters & parameters() const { return parameters_; }
+
+private:
+  HypothesisParameters parameters_;
+  double bound_sigma_;
+
+  bool initialized_;
+  double start_time_;
+  double last_time_;
+  double last_vx_;
+  double last_wz_;
+  Eigen::Vector3d state_;
+  Eigen::Matrix3d covariance_;
+};
+
+#endif  // DEVIATION_EVALUATOR__DEAD_RECKONING_HYPOTHESIS_HPP_
@@ -17,6 +17,7 @@
 
 #include "autoware/universe_utils/ros/transform_listener.hpp"
 #include "deviation_evaluator/autoware_universe_utils.hpp"
+#include "deviation_evaluator/timed_ring_buffer.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "tf2/LinearMath/Quaternion.h"
 
@@ -31,7 +32,6 @@
 
 #include <tf2/utils.h>
 
-#include <deque>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -54,6 +54,11 @@ private:
 
 public:
   DeviationEvaluator(const std::string & node_name, const rclcpp::NodeOptions & options);
+  // as a component
+  explicit DeviationEvaluator(const rclcpp::NodeOptions & options)
+  : DeviationEvaluator("deviation_evaluator", options)
+  {
+  }
 
 private:
   rclcpp::Subscription<PoseWithCovarianceStamped>::SharedPtr sub_ndt_pose_with_cov_;
@@ -74,9 +79,13 @@ private:
   Errors errors_threshold_;
   Errors current_errors_;
 
-  std::deque<PoseStamped::SharedPtr> dr_pose_queue_;
-
-  PoseStamped::SharedPtr last_gt_pose_ptr_;
+  // the latest DR and GT poses by stamp, in buffers of fixed size for long drives
+  TimedRingBuffer<geometry_msgs::msg::Pose> dr_poses_;
+  TimedRingBuffer<geometry_msgs::msg::Pose> gt_poses_;
+  // the DR poses are interpolated at the GT stamps in increasing order
+  TimedRingCursor<geometry_msgs::msg::Pose> dr_cursor_;
+  // sequence number of the first GT pose not compared with DR yet
+  size_t next_gt_seq_ = 0;
 
   PoseStamped::SharedPtr current_ekf_gt_pose_ptr_;
   PoseStamped::SharedPtr current_ndt_pose_ptr_;
@@ -94,7 +103,8 @@ private:
 
   void callbackEKFGTOdom(const Odometry::SharedPtr msg);
 
-  geometry_msgs::msg::Pose interpolatePose(const double timestamp_seconds);
+  // compare the GT poses covered by the DR poses with the DR poses interpolated at their stamps
+  void alignPoses();
 };
 
 #endif  // DEVIATION_EVALUATOR__DEVIATION_EVALUATOR_HPP_
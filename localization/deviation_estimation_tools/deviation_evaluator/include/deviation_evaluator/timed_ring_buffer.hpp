@@ -0,0 +1,135 @@
+// Copyright 2018-2019 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVIATION_EVALUATOR__TIMED_RING_BUFFER_HPP_
+#define DEVIATION_EVALUATOR__TIMED_RING_BUFFER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Stamped values in time order, in a buffer of fixed capacity. When it is full, the oldest value
+ * is overwritten, so the memory does not grow with the length of the drive. The values are
+ * addressed by their sequence number, the number of values pushed before them, which stays valid
+ * until the value is overwritten.
+ */
+template <typename T>
+class TimedRingBuffer
+{
+public:
+  explicit TimedRingBuffer(const size_t capacity) : buffer_(std::max<size_t>(capacity, 2)) {}
+
+  // clears the buffer first and returns false if the stamp is older than the newest one
+  bool push(const double stamp, const T & value)
+  {
+    const bool is_in_order = empty() || stamp >= back_stamp();
+    if (!is_in_order) {
+      clear();
+    }
+    if (size() == buffer_.size()) {
+      ++begin_;
+    }
+    buffer_[end_ % buffer_.size()] = std::make_pair(stamp, value);
+    ++end_;
+    return is_in_order;
+  }
+
+  // drops all values, the sequence numbers keep increasing
+  void clear() { begin_ = end_; }
+
+  bool empty() const { return begin_ == end_; }
+  size_t size() const { return end_ - begin_; }
+  size_t capacity() const { return buffer_.size(); }
+
+  // sequence numbers of the oldest value and past the newest one
+  size_t begin_seq() const { return begin_; }
+  size_t end_seq() const { return end_; }
+
+  double stamp(const size_t seq) const { return buffer_[seq % buffer_.size()].first; }
+  const T & value(const size_t seq) const { return buffer_[seq % buffer_.size()].second; }
+  double front_stamp() const { return stamp(begin_); }
+  double back_stamp() const { return stamp(end_ - 1); }
+
+private:
+  std::vector<std::pair<double, T>> buffer_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+};
+
+/**
+ * Finds the values around a stamp in a TimedRingBuffer. The search starts from the result of the
+ * previous one, so a stream of increasing stamps is aligned in constant time per stamp. An older
+ * stamp, or a cursor overtaken by the overwritten values, falls back to a binary search.
+ */
+template <typename T>
+class TimedRingCursor
+{
+public:
+  explicit TimedRingCursor(const TimedRingBuffer<T> & buffer) : buffer_(buffer) {}
+
+  // sets seq to the newest value at or before the stamp, false if the stamp is out of the buffer
+  bool find(const double stamp, size_t & seq)
+  {
+    if (buffer_.empty() || stamp < buffer_.front_stamp() || stamp > buffer_.back_stamp()) {
+      return false;
+    }
+
+    if (seq_ < buffer_.begin_seq() || seq_ >= buffer_.end_seq() || buffer_.stamp(seq_) > stamp) {
+      size_t low = buffer_.begin_seq();
+      size_t high = buffer_.end_seq();
+      while (high - low > 1) {
+        const size_t middle = low + (high - low) / 2;
+        if (buffer_.stamp(middle) <= stamp) {
+          low = middle;
+        } else {
+          high = middle;
+        }
+      }
+      seq_ = low;
+    }
+
+    while (seq_ + 1 < buffer_.end_seq() && buffer_.stamp(seq_ + 1) <= stamp) {
+      ++seq_;
+    }
+    seq = seq_;
+    return true;
+  }
+
+  // interpolates the values around the stamp with interpolate(before, after, ratio)
+  template <typename Interpolate>
+  bool interpolate(const double stamp, Interpolate && interpolate, T & value)
+  {
+    size_t seq;
+    if (!find(stamp, seq)) {
+      return false;
+    }
+    if (seq + 1 == buffer_.end_seq()) {
+      value = buffer_.value(seq);
+      return true;
+    }
+    const double t0 = buffer_.stamp(seq);
+    const double t1 = buffer_.stamp(seq + 1);
+    const double ratio = t1 > t0 ? (stamp - t0) / (t1 - t0) : 0.0;
+    value = interpolate(buffer_.value(seq), buffer_.value(seq + 1), ratio);
+    return true;
+  }
+
+private:
+  const TimedRingBuffer<T> & buffer_;
+  size_t seq_ = 0;
+};
+
+#endif  // DEVIATION_EVALUATOR__TIMED_RING_BUFFER_HPP_
@@ -0,0 +1,103 @@
+// Copyright 2018-2019 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_evaluator/dead_reckoning_hypothesis.hpp"
+
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <cmath>
+
+DeadReckoningHypothesis::DeadReckoningHypothesis(
+  const HypothesisParameters & parameters, const double bound_sigma)
+: parameters_(parameters),
+  bound_sigma_(bound_sigma),
+  initialized_(false),
+  start_time_(0.0),
+  last_time_(0.0),
+  last_vx_(0.0),
+  last_wz_(0.0),
+  state_(Eigen::Vector3d::Zero()),
+  covariance_(Eigen::Matrix3d::Zero())
+{
+}
+
+void DeadReckoningHypothesis::reset(
+  const double time, const double x, const double y, const double yaw)
+{
+  // the same as the initial pose of the online evaluation
+  const double initial_position_stddev = 0.05;
+  const double initial_angle_stddev = 0.01;
+
+  initialized_ = true;
+  start_time_ = time;
+  last_time_ = time;
+  state_ << x, y, yaw;
+  covariance_ = Eigen::Vector3d(
+                  initial_position_stddev * initial_position_stddev,
+                  initial_position_stddev * initial_position_stddev,
+                  initial_angle_stddev * initial_angle_stddev)
+                  .asDiagonal();
+}
+
+void DeadReckoningHypothesis::predict(const double time, const double vx, const double wz)
+{
+  const double dt = time - last_time_;
+  if (initialized_ && dt > 0.0) {
+    const double v = parameters_.coef_vx * last_vx_;
+    const double w = last_wz_ - parameters_.bias_wz;
+    const double yaw = state_(2);
+    const double cos_yaw = std::cos(yaw);
+    const double sin_yaw = std::sin(yaw);
+
+    Eigen::Matrix3d F = Eigen::Matrix3d::Identity();
+    F(0, 2) = -v * dt * sin_yaw;
+    F(1, 2) = v * dt * cos_yaw;
+    Eigen::Matrix<double, 3, 2> G = Eigen::Matrix<double, 3, 2>::Zero();
+    G(0, 0) = dt * cos_yaw;
+    G(1, 0) = dt * sin_yaw;
+    G(2, 1) = dt;
+    const Eigen::Vector2d twist_variance(
+      parameters_.stddev_vx * parameters_.stddev_vx,
+      parameters_.stddev_wz * parameters_.stddev_wz);
+
+    state_(0) += v * dt * cos_yaw;
+    state_(1) += v * dt * sin_yaw;
+    state_(2) += w * dt;
+    covariance_ = F * covariance_ * F.transpose() + G * twist_variance.asDiagonal() * G.transpose();
+  }
+  last_time_ = std::max(last_time_, time);
+  last_vx_ = vx;
+  last_wz_ = wz;
+}
+
+DeadReckoningHypothesis::Errors DeadReckoningHypothesis::evaluate(
+  const double x_gt, const double y_gt) const
+{
+  const double dx = x_gt - state_(0);
+  const double dy = y_gt - state_(1);
+  const double sin_yaw = std::sin(state_(2));
+  const double cos_yaw = std::cos(state_(2));
+  const Eigen::Matrix2d position_covariance = covariance_.topLeftCorner<2, 2>();
+  const Eigen::Vector2d lateral_direction(sin_yaw, -cos_yaw);
+  const Eigen::SelfAdjointEigenSolver<Eigen::Matrix2d> solver(position_covariance);
+
+  Errors errors;
+  errors.long_radius = std::sqrt(dx * dx + dy * dy);
+  errors.lateral = std::abs(dx * sin_yaw - dy * cos_yaw);
+  errors.long_radius_bound = bound_sigma_ * std::sqrt(std::max(solver.eigenvalues()(1), 0.0));
+  errors.lateral_bound =
+    bound_sigma_ * std::sqrt(lateral_direction.dot(position_covariance * lateral_direction));
+  return errors;
+}
@@ -57,7 +57,10 @@ double norm_xy_lateral(
 
 DeviationEvaluator::DeviationEvaluator(
   const std::string & node_name, const rclcpp::NodeOptions & node_options)
-: rclcpp::Node(node_name, node_options)
+: rclcpp::Node(node_name, node_options),
+  dr_poses_(static_cast<size_t>(declare_parameter<int>("pose_buffer_size"))),
+  gt_poses_(dr_poses_.capacity()),
+  dr_cursor_(dr_poses_)
 {
   show_debug_info_ = declare_parameter<bool>("show_debug_info", false);
   save_dir_ = declare_parameter<std::string>("save_dir");
@@ -151,63 +154,39 @@ void DeviationEvaluator::callbackNDTPoseWithCovariance(
 
 void DeviationEvaluator::callbackEKFDROdom(const Odometry::SharedPtr msg)
 {
-  PoseStamped::SharedPtr pose_ptr(new PoseStamped);
-  pose_ptr->pose = msg->pose.pose;
-  pose_ptr->header = msg->header;
-  if (!dr_pose_queue_.empty()) {
-    if (
-      rclcpp::Time(dr_pose_queue_.back()->header.stamp).seconds() >
-      rclcpp::Time(pose_ptr->header.stamp).seconds()) {
-      dr_pose_queue_.clear();
-      RCLCPP_ERROR_STREAM(this->get_logger(), "Timestamp jump detected!");
-    }
+  if (!dr_poses_.push(rclcpp::Time(msg->header.stamp).seconds(), msg->pose.pose)) {
+    RCLCPP_ERROR_STREAM(this->get_logger(), "Timestamp jump detected!");
   }
-  dr_pose_queue_.push_back(pose_ptr);
+  alignPoses();
 }
 
 void DeviationEvaluator::callbackEKFGTOdom(const Odometry::SharedPtr msg)
 {
-  if (last_gt_pose_ptr_ == nullptr) {
-    last_gt_pose_ptr_.reset(new PoseStamped);
-    last_gt_pose_ptr_->header = msg->header;
-    last_gt_pose_ptr_->pose = msg->pose.pose;
-  }
-  if (dr_pose_queue_.size() < 2) return;
-
-  double start_time = rclcpp::Time(dr_pose_queue_.front()->header.stamp).seconds();
-  double target_time = rclcpp::Time(last_gt_pose_ptr_->header.stamp).seconds();
-  if (start_time > target_time) {
-    last_gt_pose_ptr_ = nullptr;
-    return;
-  }
-
-  geometry_msgs::msg::Pose target_pose;
-  try {
-    target_pose = interpolatePose(target_time);
-  } catch (const std::runtime_error & exception) {
-    return;
-  }
-  current_errors_.long_radius = norm_xy(target_pose.position, last_gt_pose_ptr_->pose.position);
-  current_errors_.lateral = norm_xy_lateral(
-    target_pose.position, last_gt_pose_ptr_->pose.position, tf2::getYaw(target_pose.orientation));
-  last_gt_pose_ptr_ = nullptr;
-  dr_pose_queue_.clear();
+  gt_poses_.push(rclcpp::Time(msg->header.stamp).seconds(), msg->pose.pose);
+  alignPoses();
 }
 
-geometry_msgs::msg::Pose DeviationEvaluator::interpolatePose(const double time)
+void DeviationEvaluator::alignPoses()
 {
-  const auto iter_next = std::upper_bound(
-    dr_pose_queue_.begin(), dr_pose_queue_.end(), time,
-    [](double const & t1, geometry_msgs::msg::PoseStamped::SharedPtr const & t2) -> bool {
-      return t1 < rclcpp::Time(t2->header.stamp).seconds();
-    });
-
-  if ((iter_next == dr_pose_queue_.begin()) | (iter_next == dr_pose_queue_.end())) {
-    throw std::runtime_error("Interpolation failed");
+  using geometry_msgs::msg::Pose;
+  const auto interpolate = [](const Pose & src_pose, const Pose & dst_pose, const double ratio) {
+    return calcInterpolatedPose(src_pose, dst_pose, ratio);
+  };
+
+  // the GT poses overwritten before being compared are skipped
+  next_gt_seq_ = std::max(next_gt_seq_, gt_poses_.begin_seq());
+  for (; next_gt_seq_ < gt_poses_.end_seq(); ++next_gt_seq_) {
+    const double target_time = gt_poses_.stamp(next_gt_seq_);
+    // wait for the DR poses after the GT pose
+    if (dr_poses_.size() < 2 || target_time > dr_poses_.back_stamp()) return;
+
+    // the GT poses before the DR poses are never compared
+    geometry_msgs::msg::Pose target_pose;
+    if (!dr_cursor_.interpolate(target_time, interpolate, target_pose)) continue;
+
+    const auto & gt_pose = gt_poses_.value(next_gt_seq_);
+    current_errors_.long_radius = norm_xy(target_pose.position, gt_pose.position);
+    current_errors_.lateral = norm_xy_lateral(
+      target_pose.position, gt_pose.position, tf2::getYaw(target_pose.orientation));
   }
-
-  const double time_start = rclcpp::Time((*(iter_next - 1))->header.stamp).seconds();
-  const double time_end = rclcpp::Time((*iter_next)->header.stamp).seconds();
-  const double ratio = (time - time_start) / (time_end - time_start);
-  return calcInterpolatedPose((*(iter_next - 1))->pose, (*iter_next)->pose, ratio);
 }
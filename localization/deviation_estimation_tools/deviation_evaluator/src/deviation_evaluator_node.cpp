@@ -14,15 +14,6 @@
 
 #include "deviation_evaluator/deviation_evaluator.hpp"
 
-#include <memory>
+#include <rclcpp_components/register_node_macro.hpp>
 
-int main(int argc, char ** argv)
-{
-  rclcpp::init(argc, argv);
-  rclcpp::NodeOptions node_options;
-  auto node = std::make_shared<DeviationEvaluator>("deviation_evaluator", node_options);
-
-  rclcpp::spin(node);
-
-  return 0;
-}
+RCLCPP_COMPONENTS_REGISTER_NODE(DeviationEvaluator)
@@ -0,0 +1,355 @@
+// Copyright 2018-2019 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_evaluator/dead_reckoning_hypothesis.hpp"
+#include "rclcpp/parameter_map.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "tf2/LinearMath/Matrix3x3.h"
+#include "tf2/LinearMath/Quaternion.h"
+#include "tf2/utils.h"
+#include "tf2_ros/buffer.h"
+
+#include "autoware_vehicle_msgs/msg/velocity_report.hpp"
+#include "geometry_msgs/msg/pose_with_covariance_stamped.hpp"
+#include "sensor_msgs/msg/imu.hpp"
+#include "tf2_msgs/msg/tf_message.hpp"
+
+#include <ament_index_cpp/get_package_share_directory.hpp>
+#include <rcl_yaml_param_parser/parser.h>
+#include <rclcpp/serialization.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const std::string velocity_topic = "/vehicle/status/velocity_status";
+const std::string tf_static_topic = "/tf_static";
+const std::string imu_topic = "/sensing/imu/tamagawa/imu_raw";
+const std::string pose_topic = "/localization/pose_estimator/pose_with_covariance";
+
+// the decoded stream shared by the hypotheses, in the order of the bag
+struct Event
+{
+  enum class Type { VELOCITY, IMU, POSE };
+  Type type;
+  double time;
+  // vx for VELOCITY, yaw rate in base_link for IMU
+  double value;
+  // ground truth for POSE
+  double x;
+  double y;
+  double yaw;
+};
+
+double percentile(std::vector<double> values, const double ratio)
+{
+  if (values.empty()) return 0.0;
+  const size_t index = std::min(
+    static_cast<size_t>(ratio * static_cast<double>(values.size())), values.size() - 1);
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+/**
+ * Dead reckoning from a ground-truth pose for dr_duration, as vehicle_velocity_converter,
+ * gyro_odometer and the dead-reckoning ekf_localizer do without pose updates, and then again from
+ * the next ground-truth pose. The errors are checked at every ground-truth pose in a segment.
+ */
+HypothesisResult replay(
+  const std::vector<Event> & events, const HypothesisParameters & parameters,
+  const double dr_duration, const double bound_sigma)
+{
+  DeadReckoningHypothesis hypothesis(parameters, bound_sigma);
+  HypothesisResult result;
+  std::vector<double> long_radius_list;
+  std::vector<double> lateral_list;
+  size_t long_radius_violation_num = 0;
+  size_t lateral_violation_num = 0;
+  double last_vx = 0.0;
+  double last_wz = 0.0;
+  bool has_last_errors = false;
+  DeadReckoningHypothesis::Errors last_errors{};
+
+  auto finish_segment = [&]() {
+    if (!has_last_errors) return;
+    result.mean_long_radius_bound += last_errors.long_radius_bound;
+    result.mean_lateral_bound += last_errors.lateral_bound;
+    result.segment_num++;
+    has_last_errors = false;
+  };
+
+  for (const Event & event : events) {
+    if (event.type == Event::Type::VELOCITY) {
+      last_vx = event.value;
+      hypothesis.predict(event.time, last_vx, last_wz);
+    } else if (event.type == Event::Type::IMU) {
+      last_wz = event.value;
+      hypothesis.predict(event.time, last_vx, last_wz);
+    } else {
+      if (!hypothesis.isInitialized() || event.time - hypothesis.startTime() >= dr_duration) {
+        finish_segment();
+        hypothesis.reset(event.time, event.x, event.y, event.yaw);
+        hypothesis.predict(event.time, last_vx, last_wz);
+        continue;
+      }
+      hypothesis.predict(event.time, last_vx, last_wz);
+      const auto errors = hypothesis.evaluate(event.x, event.y);
+      long_radius_list.push_back(errors.long_radius);
+      lateral_list.push_back(errors.lateral);
+      long_radius_violation_num += errors.long_radius > errors.long_radius_bound;
+      lateral_violation_num += errors.lateral > errors.lateral_bound;
+      result.max_long_radius = std::max(result.max_long_radius, errors.long_radius);
+      result.max_lateral = std::max(result.max_lateral, errors.lateral);
+      last_errors = errors;
+      has_last_errors = true;
+    }
+  }
+  finish_segment();
+
+  result.check_num = long_radius_list.size();
+  if (result.check_num > 0) {
+    result.p95_long_radius = percentile(long_radius_list, 0.95);
+    result.p95_lateral = percentile(lateral_list, 0.95);
+    result.long_radius_violation_rate =
+      static_cast<double>(long_radius_violation_num) / result.check_num;
+    result.lateral_violation_rate = static_cast<double>(lateral_violation_num) / result.check_num;
+  }
+  if (result.segment_num > 0) {
+    result.mean_long_radius_bound /= result.segment_num;
+    result.mean_lateral_bound /= result.segment_num;
+  }
+  return result;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc != 2 && argc != 3) {
+    std::cout << "Usage: " << argv[0] << " <rosbag_path> [param_path]" << std::endl;
+    return 1;
+  }
+  const std::string rosbag_path = argv[1];
+  const std::string yaml_path =
+    argc == 3 ? std::string(argv[2])
+              : ament_index_cpp::get_package_share_directory("deviation_evaluator") +
+                  "/config/deviation_evaluator_replay.param.yaml";
+
+  // Load parameters
+  std::map<std::string, rclcpp::Parameter> param_map;
+  {
+    rcl_params_t * params_st = rcl_yaml_node_struct_init(rcl_get_default_allocator());
+    if (!rcl_parse_yaml_file(yaml_path.c_str(), params_st)) {
+      std::cerr << "Failed to parse yaml file: " << yaml_path << std::endl;
+      std::exit(1);
+    }
+    const std::vector<rclcpp::Parameter> parameters =
+      rclcpp::parameter_map_from(params_st, "").at("");
+    rcl_yaml_node_struct_fini(params_st);
+    for (const rclcpp::Parameter & param : parameters) {
+      param_map[param.get_name()] = param;
+    }
+  }
+  const double dr_duration = param_map.at("dr_duration").as_double();
+  const double bound_sigma = param_map.at("bound_sigma").as_double();
+  const std::string output_path = param_map.at("output_path").as_string();
+  const auto names = param_map.at("hypotheses.names").as_string_array();
+  const auto coef_vx = param_map.at("hypotheses.coef_vx").as_double_array();
+  const auto stddev_vx = param_map.at("hypotheses.stddev_vx").as_double_array();
+  const auto stddev_wz = param_map.at("hypotheses.stddev_wz").as_double_array();
+  const auto bias_x = param_map.at("hypotheses.bias_x").as_double_array();
+  const auto bias_y = param_map.at("hypotheses.bias_y").as_double_array();
+  const auto bias_z = param_map.at("hypotheses.bias_z").as_double_array();
+  for (const size_t size :
+       {coef_vx.size(), stddev_vx.size(), stddev_wz.size(), bias_x.size(), bias_y.size(),
+        bias_z.size()}) {
+    if (size != names.size()) {
+      std::cerr << "All the hypotheses parameters must have " << names.size() << " elements"
+                << std::endl;
+      std::exit(1);
+    }
+  }
+
+  // Prepare rosbag reader, only with the topics to use
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = rosbag_path;
+  storage_options.storage_id = "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::readers::SequentialReader reader;
+  reader.open(storage_options, converter_options);
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {velocity_topic, tf_static_topic, imu_topic, pose_topic};
+  reader.set_filter(storage_filter);
+
+  rclcpp::Serialization<autoware_vehicle_msgs::msg::VelocityReport> serialization_velocity_status;
+  rclcpp::Serialization<tf2_msgs::msg::TFMessage> serialization_tf;
+  rclcpp::Serialization<sensor_msgs::msg::Imu> serialization_imu;
+  rclcpp::Serialization<geometry_msgs::msg::PoseWithCovarianceStamped> serialization_pose;
+
+  rclcpp::Clock::SharedPtr clock = std::make_shared<rclcpp::Clock>(RCL_ROS_TIME);
+  tf2_ros::Buffer tf_buffer(clock);
+  // rotation from the IMU frame to base_link, looked up once until a new /tf_static
+  std::map<std::string, tf2::Matrix3x3> imu_rotations;
+  std::string imu_frame_id;
+
+  // ----------- //
+  // Read rosbag //
+  // ----------- //
+  // The bias of each hypothesis is in the IMU frame, so the raw yaw rate in base_link is kept and
+  // the bias is rotated to base_link once per hypothesis.
+  std::vector<Event> events;
+  while (reader.has_next()) {
+    const auto serialized_message = reader.read_next();
+    const rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+    const std::string & topic_name = serialized_message->topic_name;
+    Event event{};
+    if (topic_name == velocity_topic) {
+      autoware_vehicle_msgs::msg::VelocityReport velocity_status;
+      serialization_velocity_status.deserialize_message(&msg, &velocity_status);
+      event.type = Event::Type::VELOCITY;
+      event.time = rclcpp::Time(velocity_status.header.stamp).seconds();
+      event.value = velocity_status.longitudinal_velocity;
+      events.push_back(event);
+
+    } else if (topic_name == tf_static_topic) {
+      tf2_msgs::msg::TFMessage tf;
+      serialization_tf.deserialize_message(&msg, &tf);
+      for (const auto & transform : tf.transforms) {
+        try {
+          tf_buffer.setTransform(transform, "default_authority", true);
+        } catch (const tf2::TransformException & ex) {
+          std::cerr << "Transform exception: " << ex.what() << std::endl;
+          std::exit(1);
+        }
+      }
+      imu_rotations.clear();
+
+    } else if (topic_name == imu_topic) {
+      sensor_msgs::msg::Imu imu;
+      serialization_imu.deserialize_message(&msg, &imu);
+      imu_frame_id = imu.header.frame_id;
+      auto rotation = imu_rotations.find(imu_frame_id);
+      if (rotation == imu_rotations.end()) {
+        try {
+          const auto q =
+            tf_buffer.lookupTransform("base_link", imu_frame_id, tf2::TimePointZero)
+              .transform.rotation;
+          rotation = imu_rotations
+                       .emplace(imu_frame_id, tf2::Matrix3x3(tf2::Quaternion(q.x, q.y, q.z, q.w)))
+                       .first;
+        } catch (const tf2::TransformException & ex) {
+          std::cerr << "Transform exception: " << ex.what() << std::endl;
+          continue;
+        }
+      }
+      const tf2::Vector3 angular_velocity(
+        imu.angular_velocity.x, imu.angular_velocity.y, imu.angular_velocity.z);
+      event.type = Event::Type::IMU;
+      event.time = rclcpp::Time(imu.header.stamp).seconds();
+      event.value = rotation->second.getRow(2).dot(angular_velocity);
+      events.push_back(event);
+
+    } else {
+      geometry_msgs::msg::PoseWithCovarianceStamped pose;
+      serialization_pose.deserialize_message(&msg, &pose);
+      event.type = Event::Type::POSE;
+      event.time = rclcpp::Time(pose.header.stamp).seconds();
+      event.x = pose.pose.pose.position.x;
+      event.y = pose.pose.pose.position.y;
+      const auto & q = pose.pose.pose.orientation;
+      event.yaw = tf2::getYaw(tf2::Quaternion(q.x, q.y, q.z, q.w));
+      events.push_back(event);
+    }
+  }
+  if (imu_rotations.find(imu_frame_id) == imu_rotations.end()) {
+    std::cerr << "No IMU data with a transform to base_link" << std::endl;
+    std::exit(1);
+  }
+  // by the stamps, as the topics are recorded with different delays
+  std::stable_sort(events.begin(), events.end(), [](const Event & e1, const Event & e2) {
+    return e1.time < e2.time;
+  });
+
+  // ------------------ //
+  // Replay in parallel //
+  // ------------------ //
+  const tf2::Matrix3x3 & imu_rotation = imu_rotations.at(imu_frame_id);
+  std::vector<HypothesisParameters> hypotheses(names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    hypotheses[i].name = names[i];
+    hypotheses[i].coef_vx = coef_vx[i];
+    hypotheses[i].stddev_vx = stddev_vx[i];
+    hypotheses[i].stddev_wz = stddev_wz[i];
+    hypotheses[i].bias_wz =
+      imu_rotation.getRow(2).dot(tf2::Vector3(bias_x[i], bias_y[i], bias_z[i]));
+  }
+
+  std::vector<HypothesisResult> results(hypotheses.size());
+  const size_t thread_num = std::min(
+    std::max(static_cast<size_t>(std::thread::hardware_concurrency()), size_t{1}),
+    hypotheses.size());
+  std::atomic<size_t> next_index(0);
+  auto worker = [&]() {
+    for (size_t i = next_index++; i < hypotheses.size(); i = next_index++) {
+      results[i] = replay(events, hypotheses[i], dr_duration, bound_sigma);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_num; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  // ------ //
+  // Report //
+  // ------ //
+  std::ofstream ofs(output_path);
+  ofs << "name,coef_vx,stddev_vx,stddev_wz,bias_wz,segment_num,check_num,max_long_radius,"
+         "p95_long_radius,mean_long_radius_bound,long_radius_violation_rate,max_lateral,"
+         "p95_lateral,mean_lateral_bound,lateral_violation_rate"
+      << std::endl;
+  for (size_t i = 0; i < hypotheses.size(); ++i) {
+    const HypothesisParameters & p = hypotheses[i];
+    const HypothesisResult & r = results[i];
+    std::cout << std::fixed << std::setprecision(4)                                //
+              << p.name << ": segment_num=" << r.segment_num                       //
+              << ", long_radius max/p95/bound=" << r.max_long_radius << "/"        //
+              << r.p95_long_radius << "/" << r.mean_long_radius_bound              //
+              << " (violation " << r.long_radius_violation_rate * 100.0 << "%)"    //
+              << ", lateral max/p95/bound=" << r.max_lateral << "/" << r.p95_lateral  //
+              << "/" << r.mean_lateral_bound                                       //
+              << " (violation " << r.lateral_violation_rate * 100.0 << "%)" << std::endl;
+    ofs << p.name << "," << p.coef_vx << "," << p.stddev_vx << "," << p.stddev_wz << ","
+        << p.bias_wz << "," << r.segment_num << "," << r.check_num << "," << r.max_long_radius
+        << "," << r.p95_long_radius << "," << r.mean_long_radius_bound << ","
+        << r.long_radius_violation_rate << "," << r.max_lateral << "," << r.p95_lateral << ","
+        << r.mean_lateral_bound << "," << r.lateral_violation_rate << std::endl;
+  }
+  std::cout << "saved to " << output_path << std::endl;
+}
@@ -0,0 +1,50 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__LANELET2_MAP_UTILS__LANELET2_MAP_CACHE_HPP_
+#define AUTOWARE__LANELET2_MAP_UTILS__LANELET2_MAP_CACHE_HPP_
+
+#include <lanelet2_core/LaneletMap.h>
+
+#include <string>
+
+namespace autoware::lanelet2_map_utils
+{
+
+// Binary serialization of a parsed lanelet2 map, stored next to the OSM file as
+// <osm>.cache. The cache is valid only for the same file contents and the same projector
+// configuration, so that a changed map or projector is parsed again.
+class Lanelet2MapCache
+{
+public:
+  // @projector_config identifies the projection of the points, e.g. its type and origin
+  Lanelet2MapCache(const std::string & osm_path, const std::string & projector_config);
+
+  // Return the cached map, or nullptr if the cache is missing or stale. @user_data receives
+  // the string stored with the map.
+  lanelet::LaneletMapPtr load(std::string & user_data) const;
+
+  // Return false if the cache couldn't be written, which only costs a later parse
+  bool store(const lanelet::LaneletMap & map, const std::string & user_data) const;
+
+  const std::string & path() const { return path_; }
+
+private:
+  std::string path_;
+  std::string key_;
+};
+
+}  // namespace autoware::lanelet2_map_utils
+
+#endif  // AUTOWARE__LANELET2_MAP_UTILS__LANELET2_MAP_CACHE_HPP_
@@ -0,0 +1,79 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__LANELET2_MAP_UTILS__LANELET2_MAP_DIFF_HPP_
+#define AUTOWARE__LANELET2_MAP_UTILS__LANELET2_MAP_DIFF_HPP_
+
+#include <lanelet2_core/LaneletMap.h>
+
+#include <string>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+
+enum class ChangeType { ADDED, REMOVED, MODIFIED };
+
+// Change of the element of an ID between two maps. A modified element lists what changed:
+// "position" of a point, "points" (IDs) and "geometry" of a line string or a polygon,
+// "bounds" (IDs), "geometry", "centerline", and "regulatory_elements" of a lanelet or an area,
+// "parameters" of a regulatory element, and "attributes" of any element.
+struct ElementChange
+{
+  // "point", "line_string", "polygon", "lanelet", "area" or "regulatory_element"
+  std::string layer;
+  lanelet::Id id;
+  ChangeType type;
+  std::vector<std::string> fields;
+  double distance = 0;  // [m] Largest move of a point of the element, if it moved
+};
+
+struct MapDiffOptions
+{
+  // [m] Points moved less than this are equal, as the rounding of the coordinates in the OSM
+  double position_tolerance = 0.001;
+  // Attributes which repeat the coordinates, compared through the positions instead
+  std::vector<std::string> ignored_attributes = {"ele", "local_x", "local_y"};
+  size_t thread_num = 0;  // 0: hardware concurrency
+};
+
+struct MapDiff
+{
+  // Sorted by layer, in the order above, and by ID
+  std::vector<ElementChange> changes;
+  size_t compared_num = 0;  // Elements in both maps
+
+  bool empty() const { return changes.empty(); }
+};
+
+// Compare the elements of the same IDs in @original and @modified, whose points must be in the
+// same projection. The elements of a layer are compared in parallel. A lanelet or an area is
+// also modified if the points of its bounds moved, so the changed lanelets tell the lanes to
+// process again without following the references.
+MapDiff diff_lanelet_maps(
+  const lanelet::LaneletMap & original, const lanelet::LaneletMap & modified,
+  const MapDiffOptions & options = {});
+
+const char * change_type_name(ChangeType type);
+
+// Write the changes and the number of changes per layer. Return false if the file can't be
+// written.
+bool write_map_diff_json(const MapDiff & diff, const std::string & output_path);
+
+// One line per layer with changes, e.g. "lanelet: 2 added, 0 removed, 5 modified"
+std::string summarize_map_diff(const MapDiff & diff);
+
+}  // namespace autoware::lanelet2_map_utils
+
+#endif  // AUTOWARE__LANELET2_MAP_UTILS__LANELET2_MAP_DIFF_HPP_
@@ -0,0 +1,55 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__LANELET2_MAP_UTILS__LANELET2_MAP_SESSION_HPP_
+#define AUTOWARE__LANELET2_MAP_UTILS__LANELET2_MAP_SESSION_HPP_
+
+#include "autoware/lanelet2_map_utils/point_grid_index.hpp"
+
+#include <autoware_lanelet2_extension/projection/mgrs_projector.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+
+#include <memory>
+#include <string>
+
+namespace autoware::lanelet2_map_utils
+{
+
+// A lanelet2 map loaded once and modified by several passes in memory. Spatial indices over
+// the map are built on demand and kept until a pass changes the geometry.
+class Lanelet2MapSession
+{
+public:
+  bool load(const std::string & llt_map_path);
+  void write(const std::string & output_path);
+
+  lanelet::LaneletMapPtr & map() { return map_; }
+  lanelet::projection::MGRSProjector & projector() { return projector_; }
+
+  // Grid over the point layer in the order of the layer
+  const PointGridIndex & pointIndex(double cell_size);
+
+  // Must be called after a pass moved, added or removed primitives
+  void invalidateIndices() { point_index_.reset(); }
+
+private:
+  lanelet::LaneletMapPtr map_{new lanelet::LaneletMap};
+  lanelet::projection::MGRSProjector projector_;
+  std::unique_ptr<PointGridIndex> point_index_;
+};
+
+}  // namespace autoware::lanelet2_map_utils
+
+#endif  // AUTOWARE__LANELET2_MAP_UTILS__LANELET2_MAP_SESSION_HPP_
@@ -0,0 +1,85 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__LANELET2_MAP_UTILS__MAP_PASSES_HPP_
+#define AUTOWARE__LANELET2_MAP_UTILS__MAP_PASSES_HPP_
+
+#include "autoware/lanelet2_map_utils/point_grid_index.hpp"
+
+#include <rclcpp/logger.hpp>
+#include <rclcpp/node.hpp>
+
+#include <Eigen/Geometry>
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_io/Projection.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// Passes of the map_utils tools, shared by their executables and by lanelet2_map_pipeline
+namespace autoware::lanelet2_map_utils
+{
+bool load_lanelet_map(
+  const std::string & llt_map_path, lanelet::LaneletMapPtr & lanelet_map_ptr,
+  lanelet::Projector & projector);
+
+lanelet::Points3d convert_points_layer_to_points(const lanelet::LaneletMapPtr & lanelet_map_ptr);
+
+lanelet::LineStrings3d convert_line_layer_to_line_strings(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr);
+
+// fix_lane_change_tags, only for the lanelets of @filter. The IDs take precedence over the
+// bounding box, and an empty filter selects all the lanelets.
+struct LaneletFilter
+{
+  std::vector<lanelet::Id> ids;
+  std::optional<lanelet::BoundingBox2d> bounding_box;
+};
+void fix_tags(lanelet::LaneletMapPtr & lanelet_map_ptr, const LaneletFilter & filter = {});
+// From the lanelet_ids and bounding_box [min_x, min_y, max_x, max_y] parameters
+LaneletFilter declare_lanelet_filter(rclcpp::Node & node);
+
+// merge_close_points, @index is a grid over the point layer with @threshold as cell size
+void merge_points(const lanelet::LaneletMapPtr & lanelet_map_ptr, const double threshold = 0.1);
+void merge_points(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const PointGridIndex & index,
+  const double threshold);
+
+// merge_close_lines
+void merge_lines(lanelet::LaneletMapPtr & lanelet_map_ptr);
+
+// remove_unreferenced_geometry
+void remove_unreferenced_geometry(lanelet::LaneletMapPtr & lanelet_map_ptr);
+
+// fix_z_value_by_pcd
+std::vector<std::string> list_pcd_files(const std::string & pcd_map_path);
+void adjust_height(
+  const std::vector<std::string> & pcd_files, const lanelet::LaneletMapPtr & lanelet_map_ptr,
+  const bool verbose);
+
+// transform_maps
+Eigen::Affine3d create_affine_matrix_from_xyzrpy(
+  const double x, const double y, const double z, const double roll, const double pitch,
+  const double yaw);
+void transform_lanelet_map(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const Eigen::Affine3d & affine);
+void transform_pcd_file(
+  const std::string & input_path, const std::string & output_path, const Eigen::Affine3d & affine);
+bool transform_pcd_tiles(
+  const rclcpp::Logger & logger, const std::string & pcd_map_dir, const std::string & output_dir,
+  const std::string & prefix, const Eigen::Affine3d & affine);
+}  // namespace autoware::lanelet2_map_utils
+
+#endif  // AUTOWARE__LANELET2_MAP_UTILS__MAP_PASSES_HPP_
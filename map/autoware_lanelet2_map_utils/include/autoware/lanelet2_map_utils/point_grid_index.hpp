@@ -0,0 +1,144 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__LANELET2_MAP_UTILS__POINT_GRID_INDEX_HPP_
+#define AUTOWARE__LANELET2_MAP_UTILS__POINT_GRID_INDEX_HPP_
+
+#include <lanelet2_core/primitives/Point.h>
+
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+
+// Uniform 3D grid over a set of points for fixed-radius neighbor searches. With a cell size
+// equal to the search radius, a query visits the 27 cells around the query point only.
+class PointGridIndex
+{
+public:
+  PointGridIndex(const std::vector<lanelet::BasicPoint3d> & points, double cell_size)
+  : points_(points), cell_size_(cell_size)
+  {
+    for (size_t i = 0; i < points_.size(); ++i) {
+      cells_[toCell(points_[i])].push_back(i);
+    }
+  }
+
+  // Call @f with the index of every point closer than @radius to @p
+  template <typename F>
+  void forEachNeighbor(const lanelet::BasicPoint3d & p, double radius, F && f) const
+  {
+    const auto center = toCell(p);
+    const int64_t reach = static_cast<int64_t>(std::ceil(radius / cell_size_));
+    const double sq_radius = radius * radius;
+
+    for (int64_t dx = -reach; dx <= reach; ++dx) {
+      for (int64_t dy = -reach; dy <= reach; ++dy) {
+        for (int64_t dz = -reach; dz <= reach; ++dz) {
+          auto it = cells_.find(Cell{center.x + dx, center.y + dy, center.z + dz});
+
+          if (it == cells_.end()) {
+            continue;
+          }
+
+          for (const auto i : it->second) {
+            if ((points_[i] - p).squaredNorm() < sq_radius) {
+              f(i);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  const std::vector<lanelet::BasicPoint3d> & points() const { return points_; }
+
+  double cellSize() const { return cell_size_; }
+
+private:
+  struct Cell
+  {
+    int64_t x, y, z;
+
+    bool operator==(const Cell & other) const
+    {
+      return x == other.x && y == other.y && z == other.z;
+    }
+  };
+
+  struct CellHash
+  {
+    size_t operator()(const Cell & c) const
+    {
+      return (static_cast<size_t>(c.x) * 73856093) ^ (static_cast<size_t>(c.y) * 19349663) ^
+             (static_cast<size_t>(c.z) * 83492791);
+    }
+  };
+
+  Cell toCell(const lanelet::BasicPoint3d & p) const
+  {
+    return Cell{
+      static_cast<int64_t>(std::floor(p.x() / cell_size_)),
+      static_cast<int64_t>(std::floor(p.y() / cell_size_)),
+      static_cast<int64_t>(std::floor(p.z() / cell_size_))};
+  }
+
+  std::vector<lanelet::BasicPoint3d> points_;
+  double cell_size_;
+  std::unordered_map<Cell, std::vector<size_t>, CellHash> cells_;
+};
+
+// Disjoint sets over indices. The representative of a set is its smallest index, so the
+// partition and its representatives do not depend on the order of the unions.
+class UnionFind
+{
+public:
+  explicit UnionFind(size_t size) : parents_(size)
+  {
+    std::iota(parents_.begin(), parents_.end(), 0);
+  }
+
+  size_t find(size_t i)
+  {
+    while (parents_[i] != i) {
+      parents_[i] = parents_[parents_[i]];
+      i = parents_[i];
+    }
+
+    return i;
+  }
+
+  void unite(size_t a, size_t b)
+  {
+    a = find(a);
+    b = find(b);
+
+    if (a < b) {
+      parents_[b] = a;
+    } else if (b < a) {
+      parents_[a] = b;
+    }
+  }
+
+private:
+  std::vector<size_t> parents_;
+};
+
+}  // namespace autoware::lanelet2_map_utils
+
+#endif  // AUTOWARE__LANELET2_MAP_UTILS__POINT_GRID_INDEX_HPP_
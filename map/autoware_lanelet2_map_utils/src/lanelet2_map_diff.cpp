@@ -0,0 +1,81 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/lanelet2_map_diff.hpp"
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/projection/mgrs_projector.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Compare two versions of a map by element ID, e.g. before and after saving a centerline
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+
+  auto node = rclcpp::Node::make_shared("lanelet2_map_diff");
+
+  const auto original_map_path = node->declare_parameter<std::string>("original_map_path");
+  const auto modified_map_path = node->declare_parameter<std::string>("modified_map_path");
+  const auto output_path = node->declare_parameter<std::string>("output_path", "");
+
+  autoware::lanelet2_map_utils::MapDiffOptions options;
+  options.position_tolerance =
+    node->declare_parameter<double>("position_tolerance", options.position_tolerance);
+
+  lanelet::LaneletMapPtr original_map(new lanelet::LaneletMap);
+  lanelet::LaneletMapPtr modified_map(new lanelet::LaneletMap);
+  lanelet::projection::MGRSProjector original_projector;
+  lanelet::projection::MGRSProjector modified_projector;
+
+  if (
+    !autoware::lanelet2_map_utils::load_lanelet_map(
+      original_map_path, original_map, original_projector) ||
+    !autoware::lanelet2_map_utils::load_lanelet_map(
+      modified_map_path, modified_map, modified_projector)) {
+    return EXIT_FAILURE;
+  }
+
+  // Positions in different grids can't be compared
+  if (original_projector.getProjectedMGRSGrid() != modified_projector.getProjectedMGRSGrid()) {
+    RCLCPP_ERROR_STREAM(
+      node->get_logger(), "The maps are in different MGRS grids: "
+                            << original_projector.getProjectedMGRSGrid() << " and "
+                            << modified_projector.getProjectedMGRSGrid());
+    return EXIT_FAILURE;
+  }
+
+  using autoware::lanelet2_map_utils::summarize_map_diff;
+  using autoware::lanelet2_map_utils::write_map_diff_json;
+
+  const auto diff =
+    autoware::lanelet2_map_utils::diff_lanelet_maps(*original_map, *modified_map, options);
+
+  std::cout << "Compared " << diff.compared_num << " elements" << std::endl;
+  std::cout << (diff.empty() ? "No difference\n" : summarize_map_diff(diff));
+
+  if (!output_path.empty() && !write_map_diff_json(diff, output_path)) {
+    RCLCPP_ERROR_STREAM(node->get_logger(), "Couldn't write " << output_path);
+    return EXIT_FAILURE;
+  }
+
+  rclcpp::shutdown();
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/lanelet2_map_session.hpp"
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Run the passes of the map_utils tools in sequence on a map that is loaded and written once
+int main(int argc, char * argv[])
+{
+  using autoware::lanelet2_map_utils::Lanelet2MapSession;
+
+  rclcpp::init(argc, argv);
+
+  auto node = rclcpp::Node::make_shared("lanelet2_map_pipeline");
+
+  const auto llt_map_path = node->declare_parameter<std::string>("llt_map_path");
+  const auto output_path = node->declare_parameter<std::string>("output_path");
+  const auto passes = node->declare_parameter<std::vector<std::string>>("passes");
+
+  // The parameters of a pass are declared only if the pass is used
+  const std::map<std::string, std::function<bool(Lanelet2MapSession &)>> pass_table = {
+    {"fix_lane_change_tags",
+     [&node](Lanelet2MapSession & session) {
+       autoware::lanelet2_map_utils::fix_tags(
+         session.map(), autoware::lanelet2_map_utils::declare_lanelet_filter(*node));
+       return true;
+     }},
+    {"merge_close_points",
+     [&node](Lanelet2MapSession & session) {
+       const auto threshold = node->declare_parameter<double>("merge_threshold", 0.1);
+       autoware::lanelet2_map_utils::merge_points(
+         session.map(), session.pointIndex(threshold), threshold);
+       session.invalidateIndices();
+       return true;
+     }},
+    {"merge_close_lines",
+     [](Lanelet2MapSession & session) {
+       autoware::lanelet2_map_utils::merge_lines(session.map());
+       session.invalidateIndices();
+       return true;
+     }},
+    {"remove_unreferenced_geometry",
+     [](Lanelet2MapSession & session) {
+       autoware::lanelet2_map_utils::remove_unreferenced_geometry(session.map());
+       session.invalidateIndices();
+       return true;
+     }},
+    {"fix_z_value_by_pcd",
+     [&node](Lanelet2MapSession & session) {
+       const auto pcd_map_path = node->declare_parameter<std::string>("pcd_map_path");
+       const auto verbose = node->declare_parameter<bool>("verbose", false);
+       const auto pcd_files = autoware::lanelet2_map_utils::list_pcd_files(pcd_map_path);
+       if (pcd_files.empty()) {
+         RCLCPP_ERROR_STREAM(node->get_logger(), "No PCD file in " << pcd_map_path);
+         return false;
+       }
+       autoware::lanelet2_map_utils::adjust_height(pcd_files, session.map(), verbose);
+       session.invalidateIndices();
+       return true;
+     }},
+    {"transform",
+     [&node](Lanelet2MapSession & session) {
+       const auto affine = autoware::lanelet2_map_utils::create_affine_matrix_from_xyzrpy(
+         node->declare_parameter<double>("x"), node->declare_parameter<double>("y"),
+         node->declare_parameter<double>("z"), node->declare_parameter<double>("roll"),
+         node->declare_parameter<double>("pitch"), node->declare_parameter<double>("yaw"));
+       autoware::lanelet2_map_utils::transform_lanelet_map(session.map(), affine);
+       session.invalidateIndices();
+       return true;
+     }},
+  };
+
+  for (const auto & pass : passes) {
+    if (pass_table.count(pass) == 0) {
+      RCLCPP_ERROR_STREAM(node->get_logger(), "Unknown pass: " << pass);
+      return EXIT_FAILURE;
+    }
+  }
+
+  Lanelet2MapSession session;
+
+  if (!session.load(llt_map_path)) {
+    return EXIT_FAILURE;
+  }
+
+  for (const auto & pass : passes) {
+    const auto start = std::chrono::steady_clock::now();
+
+    if (!pass_table.at(pass)(session)) {
+      return EXIT_FAILURE;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Finished " << pass << " in " << elapsed.count() << " s" << std::endl;
+  }
+
+  session.write(output_path);
+
+  rclcpp::shutdown();
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+#include <lanelet2_core/primitives/LaneletSequence.h>
+#include <lanelet2_routing/RoutingGraph.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+lanelet::Lanelets convert_to_vector(const lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  lanelet::Lanelets lanelets;
+  std::copy(
+    lanelet_map_ptr->laneletLayer.begin(), lanelet_map_ptr->laneletLayer.end(),
+    std::back_inserter(lanelets));
+  return lanelets;
+}
+
+lanelet::Lanelets select_lanelets(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const LaneletFilter & filter)
+{
+  if (!filter.ids.empty()) {
+    lanelet::Lanelets lanelets;
+    for (const auto id : filter.ids) {
+      if (lanelet_map_ptr->laneletLayer.exists(id)) {
+        lanelets.push_back(lanelet_map_ptr->laneletLayer.get(id));
+      } else {
+        std::cerr << "Lanelet " << id << " is not in the map" << std::endl;
+      }
+    }
+    return lanelets;
+  }
+
+  if (filter.bounding_box) {
+    return lanelet_map_ptr->laneletLayer.search(*filter.bounding_box);
+  }
+
+  return convert_to_vector(lanelet_map_ptr);
+}
+
+LaneletFilter declare_lanelet_filter(rclcpp::Node & node)
+{
+  LaneletFilter filter;
+  const auto ids =
+    node.declare_parameter<std::vector<int64_t>>("lanelet_ids", std::vector<int64_t>{});
+  const auto bounding_box =
+    node.declare_parameter<std::vector<double>>("bounding_box", std::vector<double>{});
+
+  filter.ids.assign(ids.begin(), ids.end());
+  if (bounding_box.size() == 4) {
+    filter.bounding_box = lanelet::BoundingBox2d(
+      lanelet::BasicPoint2d(bounding_box.at(0), bounding_box.at(1)),
+      lanelet::BasicPoint2d(bounding_box.at(2), bounding_box.at(3)));
+  } else if (!bounding_box.empty()) {
+    RCLCPP_WARN(node.get_logger(), "bounding_box needs 4 values, so it is ignored");
+  }
+  return filter;
+}
+
+// Tags are changed after all the lanelets are checked, since a bound may be shared by the
+// lanelets of two threads
+struct TagChange
+{
+  bool fix = false;
+  bool right = false;
+  bool left = false;
+};
+
+// The routing graph is built once over the whole map, so lanelets next to the filtered ones
+// are still found. The read-only adjacency checks are shared among threads.
+void fix_tags(lanelet::LaneletMapPtr & lanelet_map_ptr, const LaneletFilter & filter)
+{
+  auto lanelets = select_lanelets(lanelet_map_ptr, filter);
+  lanelet::traffic_rules::TrafficRulesPtr traffic_rules =
+    lanelet::traffic_rules::TrafficRulesFactory::create(
+      lanelet::Locations::Germany, lanelet::Participants::Vehicle);
+  lanelet::routing::RoutingGraphUPtr routing_graph =
+    lanelet::routing::RoutingGraph::build(*lanelet_map_ptr, *traffic_rules);
+
+  std::vector<TagChange> changes(lanelets.size());
+  const size_t thread_num =
+    std::max<size_t>(std::min<size_t>(std::thread::hardware_concurrency(), lanelets.size()), 1);
+  std::atomic<size_t> next_lanelet(0);
+  std::vector<std::thread> threads;
+
+  auto worker = [&]() {
+    for (size_t i = next_lanelet++; i < lanelets.size(); i = next_lanelet++) {
+      const auto & llt = lanelets.at(i);
+      if (!routing_graph->conflicting(llt).empty()) {
+        continue;
+      }
+      changes.at(i).fix = true;
+      changes.at(i).right = !!routing_graph->adjacentRight(llt);
+      changes.at(i).left = !!routing_graph->adjacentLeft(llt);
+    }
+  };
+  for (size_t t = 1; t < thread_num; ++t) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  size_t fixed_num = 0;
+  for (size_t i = 0; i < lanelets.size(); ++i) {
+    auto & llt = lanelets.at(i);
+    const auto & change = changes.at(i);
+    if (!change.fix) {
+      continue;
+    }
+    llt.attributes().erase("turn_direction");
+    if (change.right) {
+      llt.rightBound().attributes()["lane_change"] = "yes";
+    }
+    if (change.left) {
+      llt.leftBound().attributes()["lane_change"] = "yes";
+    }
+    ++fixed_num;
+  }
+  std::cout << "Fixed tags of " << fixed_num << " of " << lanelets.size() << " lanelets"
+            << std::endl;
+}
+}  // namespace autoware::lanelet2_map_utils
@@ -0,0 +1,199 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+// Return the PCD file, or the PCD files in the directory of a divided map
+std::vector<std::string> list_pcd_files(const std::string & pcd_map_path)
+{
+  std::vector<std::string> pcd_files;
+  if (!std::filesystem::is_directory(pcd_map_path)) {
+    pcd_files.push_back(pcd_map_path);
+    return pcd_files;
+  }
+  for (const auto & entry : std::filesystem::recursive_directory_iterator(pcd_map_path)) {
+    const auto extension = entry.path().extension().string();
+    if (entry.is_regular_file() && (extension == ".pcd" || extension == ".PCD")) {
+      pcd_files.push_back(entry.path().string());
+    }
+  }
+  std::sort(pcd_files.begin(), pcd_files.end());
+  return pcd_files;
+}
+
+// Minimum heights of the map points around a set of query points. Instead of searching the
+// map for every query point, the query points are hashed by 2D cells of the search radius,
+// and every map point updates the queries in the 3 x 3 cells around it. So the map is read
+// tile by tile and never has to reside in memory as a whole.
+class MinHeightGrid
+{
+public:
+  MinHeightGrid(
+    const std::vector<lanelet::BasicPoint3d> & queries, const double search_radius3d,
+    const double search_radius2d)
+  : queries_(queries), search_radius3d_(search_radius3d), search_radius2d_(search_radius2d)
+  {
+    for (size_t i = 0; i < queries_.size(); i++) {
+      cells_[to_cell(queries_[i].x(), queries_[i].y())].push_back(i);
+    }
+  }
+
+  // Fold the points of a cloud into @min_heights, which has one entry per query point
+  void update(const pcl::PointCloud<pcl::PointXYZ> & cloud, std::vector<double> & min_heights) const
+  {
+    const double sq_radius3d = search_radius3d_ * search_radius3d_;
+    for (const auto & pt : cloud) {
+      const auto [cx, cy] = to_cell(pt.x, pt.y);
+      for (int64_t dx = -1; dx <= 1; dx++) {
+        for (int64_t dy = -1; dy <= 1; dy++) {
+          const auto it = cells_.find({cx + dx, cy + dy});
+          if (it == cells_.end()) {
+            continue;
+          }
+          for (const auto i : it->second) {
+            const auto & q = queries_[i];
+            const double dist_x = pt.x - static_cast<float>(q.x());
+            const double dist_y = pt.y - static_cast<float>(q.y());
+            const double dist_z = pt.z - static_cast<float>(q.z());
+            if (
+              pt.z < min_heights[i] && std::hypot(dist_x, dist_y) < search_radius2d_ &&
+              dist_x * dist_x + dist_y * dist_y + dist_z * dist_z <= sq_radius3d) {
+              min_heights[i] = pt.z;
+            }
+          }
+        }
+      }
+    }
+  }
+
+private:
+  using Cell = std::pair<int64_t, int64_t>;
+
+  struct CellHash
+  {
+    size_t operator()(const Cell & c) const
+    {
+      return (static_cast<size_t>(c.first) * 73856093) ^ (static_cast<size_t>(c.second) * 19349663);
+    }
+  };
+
+  Cell to_cell(const double x, const double y) const
+  {
+    return {
+      static_cast<int64_t>(std::floor(x / search_radius2d_)),
+      static_cast<int64_t>(std::floor(y / search_radius2d_))};
+  }
+
+  std::vector<lanelet::BasicPoint3d> queries_;
+  double search_radius3d_, search_radius2d_;
+  std::unordered_map<Cell, std::vector<size_t>, CellHash> cells_;
+};
+
+void adjust_height(
+  const std::vector<std::string> & pcd_files, const lanelet::LaneletMapPtr & lanelet_map_ptr,
+  const bool verbose)
+{
+  std::unordered_set<lanelet::Id> done;
+  double search_radius2d = 0.5;
+  double search_radius3d = 10;
+
+  // Bound points in the order they are visited, each once
+  std::vector<lanelet::Point3d> points;
+  std::vector<lanelet::BasicPoint3d> queries;
+  for (lanelet::Lanelet & llt : lanelet_map_ptr->laneletLayer) {
+    for (auto bound : {llt.leftBound(), llt.rightBound()}) {
+      for (lanelet::Point3d & pt : bound) {
+        if (done.insert(pt.id()).second) {
+          points.push_back(pt);
+          queries.push_back(pt.basicPoint());
+        }
+      }
+    }
+  }
+
+  const MinHeightGrid grid(queries, search_radius3d, search_radius2d);
+  const size_t thread_num = std::max<size_t>(
+    std::min<size_t>(std::thread::hardware_concurrency(), pcd_files.size()), 1);
+  std::vector<std::vector<double>> min_heights(
+    thread_num, std::vector<double>(queries.size(), std::numeric_limits<double>::max()));
+  std::atomic<size_t> next_file(0), loaded_point_num(0);
+  std::vector<std::thread> threads;
+
+  // Every thread reads its own tiles into its own minima, which are reduced afterwards
+  auto worker = [&](const size_t t) {
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    for (size_t f = next_file++; f < pcd_files.size(); f = next_file++) {
+      if (pcl::io::loadPCDFile<pcl::PointXYZ>(pcd_files[f], cloud) == -1) {
+        RCLCPP_ERROR_STREAM(
+          rclcpp::get_logger("loadPCDMap"), "Couldn't read file: " << pcd_files[f]);
+        continue;
+      }
+      loaded_point_num += cloud.size();
+      grid.update(cloud, min_heights[t]);
+    }
+  };
+  for (size_t t = 1; t < thread_num; t++) {
+    threads.emplace_back(worker, t);
+  }
+  worker(0);
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  std::cout << "Loaded " << loaded_point_num << " data points from " << pcd_files.size()
+            << " files." << std::endl;
+
+  std::ostringstream log;
+  size_t not_found_num = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    double min_height = std::numeric_limits<double>::max();
+    for (const auto & heights : min_heights) {
+      min_height = std::min(min_height, heights[i]);
+    }
+    if (min_height == std::numeric_limits<double>::max()) {
+      not_found_num++;
+      continue;
+    }
+    if (verbose) {
+      log << "moving from " << points[i].z() << " to " << min_height << "\n";
+    }
+    points[i].z() = min_height;
+  }
+  std::cout << log.str() << "Adjusted " << points.size() - not_found_num << " of "
+            << points.size() << " points, " << not_found_num
+            << " points have no map point around them." << std::endl;
+}
+}  // namespace autoware::lanelet2_map_utils
@@ -0,0 +1,173 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/lanelet2_map_cache.hpp"
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+#include <lanelet2_core/utility/Utilities.h>
+#include <lanelet2_io/io_handlers/Serialize.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+namespace
+{
+// Bump the version whenever the layout of the cache changes
+constexpr char cache_magic[] = "LANELET2_MAP_CACHE 1";
+
+// FNV-1a over the file contents, which is much cheaper than parsing the XML
+bool hash_file(const std::string & path, uint64_t & hash, uint64_t & size)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  std::vector<char> buffer(1 << 20);
+
+  if (!ifs) {
+    return false;
+  }
+
+  hash = 14695981039346656037ULL;
+  size = 0;
+
+  while (ifs) {
+    ifs.read(buffer.data(), buffer.size());
+
+    const auto read_size = static_cast<size_t>(ifs.gcount());
+
+    for (size_t i = 0; i < read_size; ++i) {
+      hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ULL;
+    }
+
+    size += read_size;
+  }
+
+  return true;
+}
+
+template <typename Layer>
+lanelet::Id max_id(const Layer & layer)
+{
+  lanelet::Id id = 0;
+
+  for (const auto & primitive : layer) {
+    id = std::max(id, primitive.id());
+  }
+
+  return id;
+}
+
+lanelet::Id max_id(const lanelet::RegulatoryElementLayer & layer)
+{
+  lanelet::Id id = 0;
+
+  for (const auto & regulatory_element : layer) {
+    id = std::max(id, regulatory_element->id());
+  }
+
+  return id;
+}
+}  // namespace
+
+Lanelet2MapCache::Lanelet2MapCache(
+  const std::string & osm_path, const std::string & projector_config)
+: path_(osm_path + ".cache")
+{
+  uint64_t hash, size;
+
+  // An empty key never matches, so the map is parsed and no cache is written
+  if (!hash_file(osm_path, hash, size)) {
+    return;
+  }
+
+  std::ostringstream key;
+  key << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec << " " << size << " "
+      << projector_config;
+  key_ = key.str();
+  std::replace(key_.begin(), key_.end(), '\n', ' ');
+}
+
+lanelet::LaneletMapPtr Lanelet2MapCache::load(std::string & user_data) const
+{
+  std::ifstream ifs(path_, std::ios::binary);
+  std::string magic, key;
+
+  if (
+    key_.empty() || !std::getline(ifs, magic) || magic != cache_magic || !std::getline(ifs, key) ||
+    key != key_ || !std::getline(ifs, user_data)) {
+    return nullptr;
+  }
+
+  auto map = std::make_shared<lanelet::LaneletMap>();
+
+  try {
+    boost::archive::binary_iarchive archive(ifs);
+    archive >> *map;
+  } catch (const std::exception &) {
+    return nullptr;
+  }
+
+  // New primitives must not reuse the IDs of the deserialized ones
+  lanelet::utils::registerId(std::max(
+    {max_id(map->laneletLayer), max_id(map->areaLayer), max_id(map->regulatoryElementLayer),
+     max_id(map->lineStringLayer), max_id(map->polygonLayer), max_id(map->pointLayer)}));
+
+  return map;
+}
+
+bool Lanelet2MapCache::store(const lanelet::LaneletMap & map, const std::string & user_data) const
+{
+  if (key_.empty()) {
+    return false;
+  }
+
+  // Write to a temporary file first, so a concurrent reader never sees a partial cache
+  const std::string tmp_path = path_ + ".tmp";
+
+  try {
+    std::ofstream ofs(tmp_path, std::ios::binary);
+
+    ofs << cache_magic << "\n" << key_ << "\n" << user_data << "\n";
+
+    {
+      boost::archive::binary_oarchive archive(ofs);
+      archive << map;
+    }
+
+    if (!ofs) {
+      std::filesystem::remove(tmp_path);
+      return false;
+    }
+  } catch (const std::exception &) {
+    std::error_code ec;
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path_, ec);
+
+  return !ec;
+}
+}  // namespace autoware::lanelet2_map_utils
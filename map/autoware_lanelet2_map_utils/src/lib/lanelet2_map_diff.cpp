@@ -0,0 +1,475 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/lanelet2_map_diff.hpp"
+
+#include <boost/variant/apply_visitor.hpp>
+#include <boost/variant/static_visitor.hpp>
+
+#include <lanelet2_core/primitives/Area.h>
+#include <lanelet2_core/primitives/Lanelet.h>
+#include <lanelet2_core/primitives/RegulatoryElement.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+namespace
+{
+constexpr std::array<const char *, 6> layer_names = {
+  "point", "line_string", "polygon", "lanelet", "area", "regulatory_element"};
+
+struct FieldDiff
+{
+  std::vector<std::string> fields;
+  double distance = 0;
+
+  void add(const char * field)
+  {
+    if (std::find(fields.begin(), fields.end(), field) == fields.end()) {
+      fields.emplace_back(field);
+    }
+  }
+};
+
+bool is_ignored(const std::string & key, const MapDiffOptions & options)
+{
+  return std::find(options.ignored_attributes.begin(), options.ignored_attributes.end(), key) !=
+         options.ignored_attributes.end();
+}
+
+bool equal_attributes(
+  const lanelet::AttributeMap & original, const lanelet::AttributeMap & modified,
+  const MapDiffOptions & options)
+{
+  const auto contains_all = [&options](const auto & lhs, const auto & rhs) {
+    for (const auto & [key, value] : lhs) {
+      if (is_ignored(key, options)) {
+        continue;
+      }
+      const auto it = rhs.find(key);
+      if (it == rhs.end() || it->second.value() != value.value()) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  return contains_all(original, modified) && contains_all(modified, original);
+}
+
+// Compare the points of two line strings by ID and by position. The positions are compared
+// pairwise if the line strings have as many points, otherwise the geometry is changed anyway.
+void compare_line_string(
+  const lanelet::ConstLineString3d & original, const lanelet::ConstLineString3d & modified,
+  const MapDiffOptions & options, const char * ids_field, const char * geometry_field,
+  FieldDiff & diff)
+{
+  if (original.inverted() != modified.inverted() || original.id() != modified.id()) {
+    diff.add(ids_field);
+  }
+  if (original.size() != modified.size()) {
+    diff.add(ids_field);
+    diff.add(geometry_field);
+    return;
+  }
+
+  for (size_t i = 0; i < original.size(); ++i) {
+    if (original[i].id() != modified[i].id()) {
+      diff.add(ids_field);
+    }
+    const double distance = (original[i].basicPoint() - modified[i].basicPoint()).norm();
+    if (distance > options.position_tolerance) {
+      diff.add(geometry_field);
+      diff.distance = std::max(diff.distance, distance);
+    }
+  }
+}
+
+void compare_regulatory_element_ids(
+  const lanelet::RegulatoryElementConstPtrs & original,
+  const lanelet::RegulatoryElementConstPtrs & modified, FieldDiff & diff)
+{
+  const auto ids = [](const auto & regulatory_elements) {
+    std::vector<lanelet::Id> result;
+    for (const auto & regulatory_element : regulatory_elements) {
+      result.push_back(regulatory_element->id());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+
+  if (ids(original) != ids(modified)) {
+    diff.add("regulatory_elements");
+  }
+}
+
+struct RuleParameterId : public boost::static_visitor<lanelet::Id>
+{
+  template <typename T>
+  lanelet::Id operator()(const T & primitive) const
+  {
+    return primitive.id();
+  }
+  lanelet::Id operator()(const lanelet::WeakLanelet & lanelet) const
+  {
+    return lanelet.expired() ? lanelet::InvalId : lanelet.lock().id();
+  }
+  lanelet::Id operator()(const lanelet::WeakArea & area) const
+  {
+    return area.expired() ? lanelet::InvalId : area.lock().id();
+  }
+  lanelet::Id operator()(const lanelet::ConstWeakLanelet & lanelet) const
+  {
+    return lanelet.expired() ? lanelet::InvalId : lanelet.lock().id();
+  }
+  lanelet::Id operator()(const lanelet::ConstWeakArea & area) const
+  {
+    return area.expired() ? lanelet::InvalId : area.lock().id();
+  }
+};
+
+// The parameters by role, as IDs sorted by role so that the order of the map doesn't matter
+template <typename ParameterMap>
+std::vector<std::pair<std::string, std::vector<lanelet::Id>>> parameter_ids(
+  const ParameterMap & parameters)
+{
+  std::vector<std::pair<std::string, std::vector<lanelet::Id>>> result;
+  for (const auto & [role, primitives] : parameters) {
+    std::vector<lanelet::Id> ids;
+    for (const auto & primitive : primitives) {
+      ids.push_back(boost::apply_visitor(RuleParameterId(), primitive));
+    }
+    result.emplace_back(role, std::move(ids));
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+FieldDiff compare(
+  const lanelet::ConstPoint3d & original, const lanelet::ConstPoint3d & modified,
+  const MapDiffOptions & options)
+{
+  FieldDiff diff;
+  const double distance = (original.basicPoint() - modified.basicPoint()).norm();
+  if (distance > options.position_tolerance) {
+    diff.add("position");
+    diff.distance = distance;
+  }
+  return diff;
+}
+
+FieldDiff compare(
+  const lanelet::ConstLineString3d & original, const lanelet::ConstLineString3d & modified,
+  const MapDiffOptions & options)
+{
+  FieldDiff diff;
+  compare_line_string(original, modified, options, "points", "geometry", diff);
+  return diff;
+}
+
+FieldDiff compare(
+  const lanelet::ConstPolygon3d & original, const lanelet::ConstPolygon3d & modified,
+  const MapDiffOptions & options)
+{
+  FieldDiff diff;
+  compare_line_string(
+    lanelet::ConstLineString3d(original.constData(), original.inverted()),
+    lanelet::ConstLineString3d(modified.constData(), modified.inverted()), options, "points",
+    "geometry", diff);
+  return diff;
+}
+
+FieldDiff compare(
+  const lanelet::ConstLanelet & original, const lanelet::ConstLanelet & modified,
+  const MapDiffOptions & options)
+{
+  FieldDiff diff;
+  compare_line_string(
+    original.leftBound3d(), modified.leftBound3d(), options, "bounds", "geometry", diff);
+  compare_line_string(
+    original.rightBound3d(), modified.rightBound3d(), options, "bounds", "geometry", diff);
+
+  // The generated centerline follows the bounds, only a custom one is compared
+  if (original.hasCustomCenterline() != modified.hasCustomCenterline()) {
+    diff.add("centerline");
+  } else if (original.hasCustomCenterline()) {
+    FieldDiff centerline_diff;
+    compare_line_string(
+      original.centerline3d(), modified.centerline3d(), options, "centerline", "centerline",
+      centerline_diff);
+    if (!centerline_diff.fields.empty()) {
+      diff.add("centerline");
+      diff.distance = std::max(diff.distance, centerline_diff.distance);
+    }
+  }
+
+  compare_regulatory_element_ids(
+    original.regulatoryElements(), modified.regulatoryElements(), diff);
+  return diff;
+}
+
+FieldDiff compare(
+  const lanelet::ConstArea & original, const lanelet::ConstArea & modified,
+  const MapDiffOptions & options)
+{
+  FieldDiff diff;
+  const auto compare_bounds = [&](const auto & original_bounds, const auto & modified_bounds) {
+    if (original_bounds.size() != modified_bounds.size()) {
+      diff.add("bounds");
+      diff.add("geometry");
+      return;
+    }
+    for (size_t i = 0; i < original_bounds.size(); ++i) {
+      compare_line_string(
+        original_bounds[i], modified_bounds[i], options, "bounds", "geometry", diff);
+    }
+  };
+
+  compare_bounds(original.outerBound(), modified.outerBound());
+
+  const auto original_inner = original.innerBounds();
+  const auto modified_inner = modified.innerBounds();
+  if (original_inner.size() != modified_inner.size()) {
+    diff.add("bounds");
+    diff.add("geometry");
+  } else {
+    for (size_t i = 0; i < original_inner.size(); ++i) {
+      compare_bounds(original_inner[i], modified_inner[i]);
+    }
+  }
+
+  compare_regulatory_element_ids(
+    original.regulatoryElements(), modified.regulatoryElements(), diff);
+  return diff;
+}
+
+FieldDiff compare(
+  const lanelet::RegulatoryElementConstPtr & original,
+  const lanelet::RegulatoryElementConstPtr & modified, const MapDiffOptions &)
+{
+  FieldDiff diff;
+  if (parameter_ids(original->getParameters()) != parameter_ids(modified->getParameters())) {
+    diff.add("parameters");
+  }
+  return diff;
+}
+
+// Regulatory elements are held by pointer in their layer
+template <typename T>
+lanelet::Id id_of(const std::shared_ptr<T> & regulatory_element)
+{
+  return regulatory_element->id();
+}
+
+template <typename T>
+lanelet::Id id_of(const T & primitive)
+{
+  return primitive.id();
+}
+
+template <typename T>
+const lanelet::AttributeMap & attributes_of(const std::shared_ptr<T> & regulatory_element)
+{
+  return regulatory_element->attributes();
+}
+
+template <typename T>
+const lanelet::AttributeMap & attributes_of(const T & primitive)
+{
+  return primitive.attributes();
+}
+
+// Added and removed IDs are found serially from the hashed layers, the elements of the common
+// IDs are compared by several threads, each on an interleaved share of the IDs.
+template <typename Layer>
+void diff_layer(
+  const char * layer_name, const Layer & original, const Layer & modified,
+  const MapDiffOptions & options, MapDiff & diff)
+{
+  std::vector<ElementChange> changes;
+  std::vector<lanelet::Id> common_ids;
+
+  for (const auto & element : original) {
+    const lanelet::Id id = id_of(element);
+    if (modified.exists(id)) {
+      common_ids.push_back(id);
+    } else {
+      changes.push_back({layer_name, id, ChangeType::REMOVED, {}, 0});
+    }
+  }
+  for (const auto & element : modified) {
+    const lanelet::Id id = id_of(element);
+    if (!original.exists(id)) {
+      changes.push_back({layer_name, id, ChangeType::ADDED, {}, 0});
+    }
+  }
+
+  const size_t hardware_thread_num =
+    options.thread_num > 0 ? options.thread_num : std::thread::hardware_concurrency();
+  const size_t thread_num =
+    std::max<size_t>(std::min<size_t>(hardware_thread_num, common_ids.size()), 1);
+  std::vector<std::vector<ElementChange>> thread_changes(thread_num);
+  std::vector<std::thread> threads;
+
+  for (size_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = t; i < common_ids.size(); i += thread_num) {
+        const auto original_element = original.get(common_ids[i]);
+        const auto modified_element = modified.get(common_ids[i]);
+        FieldDiff field_diff = compare(original_element, modified_element, options);
+        if (!equal_attributes(
+              attributes_of(original_element), attributes_of(modified_element), options)) {
+          field_diff.add("attributes");
+        }
+        if (!field_diff.fields.empty()) {
+          thread_changes[t].push_back(
+            {layer_name, common_ids[i], ChangeType::MODIFIED, std::move(field_diff.fields),
+             field_diff.distance});
+        }
+      }
+    });
+  }
+
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  for (auto & local_changes : thread_changes) {
+    std::move(local_changes.begin(), local_changes.end(), std::back_inserter(changes));
+  }
+  std::sort(changes.begin(), changes.end(), [](const auto & lhs, const auto & rhs) {
+    return lhs.id < rhs.id;
+  });
+
+  diff.compared_num += common_ids.size();
+  std::move(changes.begin(), changes.end(), std::back_inserter(diff.changes));
+}
+
+size_t layer_order(const std::string & layer)
+{
+  return std::find(layer_names.begin(), layer_names.end(), layer) - layer_names.begin();
+}
+
+std::string escape_json(const std::string & text)
+{
+  std::string result;
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result;
+}
+}  // namespace
+
+MapDiff diff_lanelet_maps(
+  const lanelet::LaneletMap & original, const lanelet::LaneletMap & modified,
+  const MapDiffOptions & options)
+{
+  MapDiff diff;
+
+  // Each layer appends its changes sorted by ID
+  diff_layer(layer_names[0], original.pointLayer, modified.pointLayer, options, diff);
+  diff_layer(layer_names[1], original.lineStringLayer, modified.lineStringLayer, options, diff);
+  diff_layer(layer_names[2], original.polygonLayer, modified.polygonLayer, options, diff);
+  diff_layer(layer_names[3], original.laneletLayer, modified.laneletLayer, options, diff);
+  diff_layer(layer_names[4], original.areaLayer, modified.areaLayer, options, diff);
+  diff_layer(
+    layer_names[5], original.regulatoryElementLayer, modified.regulatoryElementLayer, options,
+    diff);
+
+  return diff;
+}
+
+const char * change_type_name(ChangeType type)
+{
+  switch (type) {
+    case ChangeType::ADDED:
+      return "added";
+    case ChangeType::REMOVED:
+      return "removed";
+    case ChangeType::MODIFIED:
+      return "modified";
+  }
+  return "";
+}
+
+bool write_map_diff_json(const MapDiff & diff, const std::string & output_path)
+{
+  std::ofstream ofs(output_path);
+  if (!ofs) {
+    return false;
+  }
+
+  std::array<std::array<size_t, 3>, layer_names.size()> counts{};
+  for (const auto & change : diff.changes) {
+    ++counts[layer_order(change.layer)][static_cast<size_t>(change.type)];
+  }
+
+  ofs << "{\n  \"compared\": " << diff.compared_num << ",\n  \"summary\": {";
+  for (size_t l = 0; l < layer_names.size(); ++l) {
+    ofs << (l == 0 ? "\n" : ",\n") << "    \"" << layer_names[l] << "\": {\"added\": "
+        << counts[l][0] << ", \"removed\": " << counts[l][1] << ", \"modified\": " << counts[l][2]
+        << "}";
+  }
+  ofs << "\n  },\n  \"changes\": [";
+
+  for (size_t i = 0; i < diff.changes.size(); ++i) {
+    const auto & change = diff.changes[i];
+    ofs << (i == 0 ? "\n" : ",\n") << "    {\"layer\": \"" << change.layer
+        << "\", \"id\": " << change.id << ", \"type\": \"" << change_type_name(change.type)
+        << "\"";
+    if (change.type == ChangeType::MODIFIED) {
+      ofs << ", \"fields\": [";
+      for (size_t f = 0; f < change.fields.size(); ++f) {
+        ofs << (f == 0 ? "\"" : ", \"") << escape_json(change.fields[f]) << "\"";
+      }
+      ofs << "], \"distance\": " << change.distance;
+    }
+    ofs << "}";
+  }
+  ofs << (diff.changes.empty() ? "]\n}\n" : "\n  ]\n}\n");
+
+  return static_cast<bool>(ofs);
+}
+
+std::string summarize_map_diff(const MapDiff & diff)
+{
+  std::array<std::array<size_t, 3>, layer_names.size()> counts{};
+  for (const auto & change : diff.changes) {
+    ++counts[layer_order(change.layer)][static_cast<size_t>(change.type)];
+  }
+
+  std::ostringstream summary;
+  for (size_t l = 0; l < layer_names.size(); ++l) {
+    if (counts[l][0] + counts[l][1] + counts[l][2] == 0) {
+      continue;
+    }
+    summary << layer_names[l] << ": " << counts[l][0] << " added, " << counts[l][1]
+            << " removed, " << counts[l][2] << " modified\n";
+  }
+  return summary.str();
+}
+}  // namespace autoware::lanelet2_map_utils
@@ -0,0 +1,121 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/lanelet2_map_session.hpp"
+
+#include "autoware/lanelet2_map_utils/lanelet2_map_cache.hpp"
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/io/autoware_osm_parser.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_io/Io.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+// Maps projected by MGRS are cached in binary, so that repeated runs of the tools on the same
+// map skip the XML parsing. The cache keeps the MGRS grid, which the projector needs to write.
+bool load_lanelet_map(
+  const std::string & llt_map_path, lanelet::LaneletMapPtr & lanelet_map_ptr,
+  lanelet::Projector & projector)
+{
+  auto * mgrs_projector = dynamic_cast<lanelet::projection::MGRSProjector *>(&projector);
+  std::unique_ptr<Lanelet2MapCache> cache;
+
+  // A preset MGRS code changes the projection, which the cache key can't tell
+  if (mgrs_projector && !mgrs_projector->isMGRSCodeSet()) {
+    cache = std::make_unique<Lanelet2MapCache>(llt_map_path, "MGRS");
+
+    std::string mgrs_grid;
+    if (auto cached_map = cache->load(mgrs_grid)) {
+      lanelet_map_ptr = cached_map;
+      if (!mgrs_grid.empty()) {
+        mgrs_projector->setMGRSCode(mgrs_grid);
+      }
+      std::cout << "Loaded Lanelet2 map from " << cache->path() << std::endl;
+      return true;
+    }
+  }
+
+  lanelet::ErrorMessages errors;
+  lanelet_map_ptr = lanelet::load(llt_map_path, "autoware_osm_handler", projector, &errors);
+
+  for (const auto & error : errors) {
+    RCLCPP_ERROR_STREAM(rclcpp::get_logger("loadLaneletMap"), error);
+  }
+  if (!errors.empty()) {
+    return false;
+  }
+  std::cout << "Loaded Lanelet2 map" << std::endl;
+
+  if (cache && !cache->store(*lanelet_map_ptr, mgrs_projector->getProjectedMGRSGrid())) {
+    RCLCPP_WARN_STREAM(
+      rclcpp::get_logger("loadLaneletMap"), "Couldn't write the map cache " << cache->path());
+  }
+  return true;
+}
+
+lanelet::Points3d convert_points_layer_to_points(const lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  lanelet::Points3d points;
+  std::copy(
+    lanelet_map_ptr->pointLayer.begin(), lanelet_map_ptr->pointLayer.end(),
+    std::back_inserter(points));
+  return points;
+}
+
+lanelet::LineStrings3d convert_line_layer_to_line_strings(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  lanelet::LineStrings3d lines;
+  std::copy(
+    lanelet_map_ptr->lineStringLayer.begin(), lanelet_map_ptr->lineStringLayer.end(),
+    std::back_inserter(lines));
+  return lines;
+}
+
+bool Lanelet2MapSession::load(const std::string & llt_map_path)
+{
+  invalidateIndices();
+  return load_lanelet_map(llt_map_path, map_, projector_);
+}
+
+void Lanelet2MapSession::write(const std::string & output_path)
+{
+  lanelet::write(output_path, *map_, projector_);
+}
+
+const PointGridIndex & Lanelet2MapSession::pointIndex(double cell_size)
+{
+  if (!point_index_ || point_index_->cellSize() != cell_size) {
+    std::vector<lanelet::BasicPoint3d> positions;
+
+    positions.reserve(map_->pointLayer.size());
+
+    for (const auto & point : map_->pointLayer) {
+      positions.push_back(point.basicPoint());
+    }
+
+    point_index_ = std::make_unique<PointGridIndex>(positions, cell_size);
+  }
+
+  return *point_index_;
+}
+}  // namespace autoware::lanelet2_map_utils
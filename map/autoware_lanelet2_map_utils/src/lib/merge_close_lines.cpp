@@ -0,0 +1,224 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+#include <lanelet2_core/primitives/LaneletSequence.h>
+
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point_xy.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+using Point2d = boost::geometry::model::d2::point_xy<double>;
+using Box = boost::geometry::model::box<Point2d>;
+using BoxEntry = std::pair<Box, size_t>;
+
+lanelet::ConstPoint3d get3d_point_from2d_arc_length(
+  const lanelet::ConstLineString3d & line, const double s)
+{
+  double accumulated_distance2d = 0;
+  if (line.size() < 2) {
+    return lanelet::Point3d();
+  }
+  auto prev_pt = line.front();
+  for (size_t i = 1; i < line.size(); i++) {
+    const auto & pt = line[i];
+    double distance2d =
+      lanelet::geometry::distance2d(lanelet::utils::to2D(prev_pt), lanelet::utils::to2D(pt));
+    if (accumulated_distance2d + distance2d >= s) {
+      double ratio = (s - accumulated_distance2d) / distance2d;
+      auto interpolated_pt = prev_pt.basicPoint() * (1 - ratio) + pt.basicPoint() * ratio;
+      std::cout << interpolated_pt << std::endl;
+      return lanelet::ConstPoint3d{
+        lanelet::utils::getId(), interpolated_pt.x(), interpolated_pt.y(), interpolated_pt.z()};
+    }
+    accumulated_distance2d += distance2d;
+    prev_pt = pt;
+  }
+  RCLCPP_ERROR(rclcpp::get_logger("merge_close_lines"), "interpolation failed");
+  return {};
+}
+
+bool are_lines_same(
+  const lanelet::ConstLineString3d & line1, const lanelet::ConstLineString3d & line2)
+{
+  bool same_ends = false;
+  if (line1.front() == line2.front() && line1.back() == line2.back()) {
+    same_ends = true;
+  }
+  if (line1.front() == line2.back() && line1.back() == line2.front()) {
+    same_ends = true;
+  }
+  if (!same_ends) {
+    return false;
+  }
+
+  double sum_distance =
+    std::accumulate(line1.begin(), line1.end(), 0.0, [&line2](double sum, const auto & pt) {
+      return sum + boost::geometry::distance(pt.basicPoint(), line2);
+    });
+  sum_distance +=
+    std::accumulate(line2.begin(), line2.end(), 0.0, [&line1](double sum, const auto & pt) {
+      return sum + boost::geometry::distance(pt.basicPoint(), line1);
+    });
+
+  double avg_distance = sum_distance / static_cast<double>(line1.size() + line2.size());
+  return avg_distance < 1.0;
+}
+
+lanelet::BasicPoint3d get_closest_point_on_line(
+  const lanelet::BasicPoint3d & search_point, const lanelet::ConstLineString3d & line)
+{
+  auto arc_coordinate = lanelet::geometry::toArcCoordinates(
+    lanelet::utils::to2D(line), lanelet::utils::to2D(search_point));
+  std::cout << arc_coordinate.length << " " << arc_coordinate.distance << std::endl;
+  return get3d_point_from2d_arc_length(line, arc_coordinate.length).basicPoint();
+}
+
+lanelet::LineString3d merge_two_lines(
+  const lanelet::LineString3d & line1, const lanelet::ConstLineString3d & line2)
+{
+  lanelet::Points3d new_points;
+  for (const auto & p1 : line1) {
+    const lanelet::BasicPoint3d & p1_basic_point = p1.basicPoint();
+    lanelet::BasicPoint3d p2_basic_point = get_closest_point_on_line(p1, line2);
+    lanelet::BasicPoint3d new_basic_point = (p1_basic_point + p2_basic_point) / 2;
+    lanelet::Point3d new_point(lanelet::utils::getId(), new_basic_point);
+    new_points.push_back(new_point);
+  }
+  return lanelet::LineString3d{lanelet::utils::getId(), new_points};
+}
+
+void copy_data(lanelet::LineString3d & dst, const lanelet::LineString3d & src)
+{
+  dst.clear();
+  for (const lanelet::ConstPoint3d & pt : src) {
+    dst.push_back(static_cast<lanelet::Point3d>(pt));
+  }
+}
+
+Box get_bounding_box(const lanelet::ConstLineString3d & line)
+{
+  Box box;
+  boost::geometry::assign_inverse(box);
+  for (const auto & pt : line) {
+    boost::geometry::expand(box, Point2d(pt.x(), pt.y()));
+  }
+  return box;
+}
+
+void merge_lines(lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  auto lines = convert_line_layer_to_line_strings(lanelet_map_ptr);
+  const size_t line_num = lines.size();
+
+  // Lines with the same ends have intersecting bounding boxes, so only the pairs found by
+  // the R-tree are compared
+  std::vector<BoxEntry> entries;
+  entries.reserve(line_num);
+  for (size_t i = 0; i < line_num; i++) {
+    if (!lines.at(i).empty()) {
+      entries.emplace_back(get_bounding_box(lines.at(i)), i);
+    }
+  }
+  const boost::geometry::index::rtree<BoxEntry, boost::geometry::index::quadratic<16>> rtree(
+    entries.begin(), entries.end());
+
+  // Earlier lines that are the same as each line, compared on the lines as loaded
+  std::vector<std::vector<size_t>> same_lines(line_num);
+  std::atomic<size_t> next_line(0), candidate_num(0), same_num(0);
+  std::vector<std::thread> threads;
+
+  auto worker = [&]() {
+    std::vector<BoxEntry> candidates;
+    for (size_t i = next_line++; i < line_num; i = next_line++) {
+      if (lines.at(i).empty()) {
+        continue;
+      }
+      candidates.clear();
+      rtree.query(
+        boost::geometry::index::intersects(get_bounding_box(lines.at(i))),
+        std::back_inserter(candidates));
+      for (const auto & [box, j] : candidates) {
+        if (j >= i) {
+          continue;
+        }
+        candidate_num++;
+        if (are_lines_same(lines.at(i), lines.at(j))) {
+          same_lines.at(i).push_back(j);
+        }
+      }
+      std::sort(same_lines.at(i).begin(), same_lines.at(i).end());
+      same_num += same_lines.at(i).size();
+    }
+  };
+
+  const size_t thread_num = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  for (size_t t = 1; t < thread_num; t++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  // Merge in the order of the layer. A merged line consists of new points, so it is not the
+  // same as any other line afterwards.
+  std::vector<bool> merged(line_num, false);
+  size_t merged_num = 0;
+
+  for (size_t i = 0; i < line_num; i++) {
+    auto line_i = lines.at(i);
+    for (const size_t j : same_lines.at(i)) {
+      if (merged.at(j)) {
+        continue;
+      }
+      auto line_j = lines.at(j);
+      auto merged_line = merge_two_lines(line_i, line_j);
+      copy_data(line_i, merged_line);
+      copy_data(line_j, merged_line);
+      line_i.setId(line_j.id());
+      std::cout << line_j << " " << line_i << std::endl;
+      // lanelet_map_ptr->add(merged_line);
+      for (lanelet::Point3d & pt : merged_line) {
+        lanelet_map_ptr->add(pt);
+      }
+      merged.at(i) = merged.at(j) = true;
+      merged_num++;
+      break;
+    }
+  }
+
+  const size_t all_pair_num = line_num < 2 ? 0 : line_num * (line_num - 1) / 2;
+  std::cout << "Lines: " << line_num << ", candidate pairs: " << candidate_num << " / "
+            << all_pair_num << ", same pairs: " << same_num << ", merged pairs: " << merged_num
+            << std::endl;
+}
+}  // namespace autoware::lanelet2_map_utils
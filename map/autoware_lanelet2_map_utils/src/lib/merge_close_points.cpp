@@ -0,0 +1,127 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+// lanelet::LineString3d mergeClosePoints(const lanelet::ConstLineString3d& line1, const
+// lanelet::ConstLineString3d& line2)
+// {
+//   lanelet::Points3d new_points;
+//   for (const auto& p1 : line1)
+//   {
+//     p1_basic_point = p1.basicPoint();
+//     lanelet::BasicPoint3d p2 = getClosestPointOnLine(line2, p1);
+//     lanelet::BasicPoint3d new_basic_point = (p1_basic_point + p2_basic_point)/2;
+//     lanelet::Point3d new_point(lanelet::utils::getId(), new_basic_point);
+//     new_points.push_back(new_point);
+//   }
+//   return lanelet::LineString3d(lanelet::utils::getId(), new_points);
+// }
+
+void merge_points(const lanelet::LaneletMapPtr & lanelet_map_ptr, const double threshold)
+{
+  std::vector<lanelet::BasicPoint3d> positions;
+
+  positions.reserve(lanelet_map_ptr->pointLayer.size());
+
+  for (const auto & point : lanelet_map_ptr->pointLayer) {
+    positions.push_back(point.basicPoint());
+  }
+
+  merge_points(lanelet_map_ptr, PointGridIndex(positions, threshold), threshold);
+}
+
+// Merge the points closer than @threshold to each other. Close pairs are found with a grid
+// index by several threads, then points connected by close pairs are merged into their
+// centroid and take the ID of the first point of the layer, regardless of the thread count.
+void merge_points(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const PointGridIndex & index,
+  const double threshold)
+{
+  auto points = convert_points_layer_to_points(lanelet_map_ptr);
+  const size_t point_num = points.size();
+  const auto & positions = index.points();
+  const size_t thread_num =
+    std::max<size_t>(std::min<size_t>(std::thread::hardware_concurrency(), point_num), 1);
+  std::vector<std::vector<std::pair<size_t, size_t>>> close_pairs(thread_num);
+  std::vector<std::thread> threads;
+
+  for (size_t t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t]() {
+      for (size_t i = t; i < point_num; i += thread_num) {
+        index.forEachNeighbor(positions[i], threshold, [&](size_t j) {
+          if (j < i) {
+            close_pairs[t].emplace_back(j, i);
+          }
+        });
+      }
+    });
+  }
+
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  UnionFind clusters(point_num);
+
+  for (const auto & pairs : close_pairs) {
+    for (const auto & [j, i] : pairs) {
+      clusters.unite(j, i);
+    }
+  }
+
+  std::vector<lanelet::BasicPoint3d> sums(point_num, lanelet::BasicPoint3d::Zero());
+  std::vector<size_t> counts(point_num, 0);
+
+  for (size_t i = 0; i < point_num; ++i) {
+    const size_t root = clusters.find(i);
+    sums[root] += positions[i];
+    ++counts[root];
+  }
+
+  for (size_t i = 0; i < point_num; ++i) {
+    const size_t root = clusters.find(i);
+
+    if (counts[root] < 2) {
+      continue;
+    }
+
+    const lanelet::BasicPoint3d new_point = sums[root] / static_cast<double>(counts[root]);
+    auto & point = points.at(i);
+    point.x() = new_point.x();
+    point.y() = new_point.y();
+    point.z() = new_point.z();
+
+    if (i != root) {
+      point.setId(points.at(root).id());
+    }
+  }
+}
+}  // namespace autoware::lanelet2_map_utils
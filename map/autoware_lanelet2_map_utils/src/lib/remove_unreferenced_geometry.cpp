@@ -0,0 +1,164 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/primitives/RegulatoryElement.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace autoware::lanelet2_map_utils
+{
+namespace
+{
+using ReferenceCounts = std::unordered_map<lanelet::Id, size_t>;
+
+// Reference counts of the primitives reachable from the lanelets and the areas. The
+// primitives of a line string or a polygon are counted when it is referenced the first time.
+struct ReferenceTables
+{
+  ReferenceCounts regulatory_elements, polygons, line_strings, points;
+
+  void add_line_string(const lanelet::ConstLineString3d & line)
+  {
+    if (line_strings[line.id()]++ > 0) {
+      return;
+    }
+    for (const auto & point : line) {
+      ++points[point.id()];
+    }
+  }
+
+  void add_polygon(const lanelet::ConstPolygon3d & polygon)
+  {
+    if (polygons[polygon.id()]++ > 0) {
+      return;
+    }
+    for (const auto & point : polygon) {
+      ++points[point.id()];
+    }
+  }
+
+  void add_regulatory_element(const lanelet::RegulatoryElementConstPtr & regulatory_element);
+};
+
+class ParameterCounter : public lanelet::RuleParameterVisitor
+{
+public:
+  explicit ParameterCounter(ReferenceTables & tables) : tables_(tables) {}
+
+  void operator()(const lanelet::ConstPoint3d & point) override { ++tables_.points[point.id()]; }
+  void operator()(const lanelet::ConstLineString3d & line) override
+  {
+    tables_.add_line_string(line);
+  }
+  void operator()(const lanelet::ConstPolygon3d & polygon) override
+  {
+    tables_.add_polygon(polygon);
+  }
+
+private:
+  ReferenceTables & tables_;
+};
+
+void ReferenceTables::add_regulatory_element(
+  const lanelet::RegulatoryElementConstPtr & regulatory_element)
+{
+  if (regulatory_elements[regulatory_element->id()]++ > 0) {
+    return;
+  }
+  ParameterCounter counter(*this);
+  regulatory_element->applyVisitor(counter);
+}
+
+lanelet::Id id_of(const lanelet::RegulatoryElementPtr & regulatory_element)
+{
+  return regulatory_element->id();
+}
+
+template <typename PrimitiveT>
+lanelet::Id id_of(const PrimitiveT & primitive)
+{
+  return primitive.id();
+}
+
+// Copy the primitives of @layer with a nonzero count, or all of them without counts
+template <typename LayerT>
+typename LayerT::Map keep_referenced(
+  LayerT & layer, const ReferenceCounts * counts, const std::string & name)
+{
+  typename LayerT::Map kept;
+
+  for (auto & primitive : layer) {
+    if (!counts || counts->count(id_of(primitive)) > 0) {
+      kept.emplace(id_of(primitive), primitive);
+    }
+  }
+
+  std::cout << "Removed " << layer.size() - kept.size() << " of " << layer.size() << " " << name
+            << std::endl;
+
+  return kept;
+}
+}  // namespace
+
+// The lanelets and the areas are kept with everything they reference, directly or through
+// their regulatory elements. The references are counted in one pass over the map, then the
+// map is rebuilt from the referenced primitives at once.
+void remove_unreferenced_geometry(lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  ReferenceTables tables;
+
+  for (const auto & llt : lanelet_map_ptr->laneletLayer) {
+    tables.add_line_string(llt.leftBound());
+    tables.add_line_string(llt.rightBound());
+    if (llt.hasCustomCenterline()) {
+      tables.add_line_string(llt.centerline3d());
+    }
+    for (const auto & regulatory_element : llt.regulatoryElements()) {
+      tables.add_regulatory_element(regulatory_element);
+    }
+  }
+
+  for (const auto & area : lanelet_map_ptr->areaLayer) {
+    for (const auto & line : area.outerBound()) {
+      tables.add_line_string(line);
+    }
+    for (const auto & inner_bound : area.innerBounds()) {
+      for (const auto & line : inner_bound) {
+        tables.add_line_string(line);
+      }
+    }
+    for (const auto & regulatory_element : area.regulatoryElements()) {
+      tables.add_regulatory_element(regulatory_element);
+    }
+  }
+
+  auto & map = *lanelet_map_ptr;
+  auto lanelets = keep_referenced(map.laneletLayer, nullptr, "lanelets");
+  auto areas = keep_referenced(map.areaLayer, nullptr, "areas");
+  auto regulatory_elements =
+    keep_referenced(map.regulatoryElementLayer, &tables.regulatory_elements, "regulatory elements");
+  auto polygons = keep_referenced(map.polygonLayer, &tables.polygons, "polygons");
+  auto line_strings = keep_referenced(map.lineStringLayer, &tables.line_strings, "line strings");
+  auto points = keep_referenced(map.pointLayer, &tables.points, "points");
+
+  lanelet_map_ptr = std::make_shared<lanelet::LaneletMap>(
+    lanelets, areas, regulatory_elements, polygons, line_strings, points);
+}
+}  // namespace autoware::lanelet2_map_utils
@@ -0,0 +1,162 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware/pointcloud_divider/pcd_divider.hpp>
+#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <pcl/point_types.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+// Number of points read, transformed and written at once
+constexpr size_t block_size = 1000000;
+
+void transform_lanelet_map(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const Eigen::Affine3d & affine)
+{
+  for (lanelet::Point3d & pt : lanelet_map_ptr->pointLayer) {
+    Eigen::Vector3d eigen_pt(pt.x(), pt.y(), pt.z());
+    auto transformed_pt = affine * eigen_pt;
+    pt.x() = transformed_pt.x();
+    pt.y() = transformed_pt.y();
+    pt.z() = transformed_pt.z();
+  }
+}
+
+// Transform a PCD block by block, so the cloud never resides in memory as a whole
+void transform_pcd_file(
+  const std::string & input_path, const std::string & output_path, const Eigen::Affine3d & affine)
+{
+  autoware::pointcloud_divider::CustomPCDReader<pcl::PointXYZ> reader;
+  autoware::pointcloud_divider::CustomPCDWriter<pcl::PointXYZ> writer;
+  const autoware::pointcloud_divider::AffineTransformStage<pcl::PointXYZ> transform(affine);
+  pcl::PointCloud<pcl::PointXYZ> block;
+  size_t read_num = 0;
+
+  reader.setInput(input_path);
+  reader.setBlockSize(block_size);
+
+  const size_t point_num = reader.point_num();
+
+  writer.setOutput(output_path);
+  writer.writeMetadata(point_num, true);
+
+  while (reader.good() && read_num < point_num) {
+    reader.readABlock(block);
+    read_num += block.size();
+    transform.process(block);
+    writer.write(block);
+  }
+}
+
+// Read the grid size from the metadata of a divided map, next to or above the tile directory
+bool load_grid_size(const std::string & pcd_map_dir, double & grid_size_x, double & grid_size_y)
+{
+  const std::filesystem::path dir(pcd_map_dir);
+
+  for (const auto & candidate : {dir, dir.parent_path()}) {
+    std::ifstream metadata(candidate / "pointcloud_map_metadata.yaml");
+    std::string line;
+    bool found_x = false, found_y = false;
+
+    while (std::getline(metadata, line)) {
+      std::istringstream iss(line);
+      std::string key;
+      iss >> key;
+      if (key == "x_resolution:") {
+        found_x = static_cast<bool>(iss >> grid_size_x);
+      } else if (key == "y_resolution:") {
+        found_y = static_cast<bool>(iss >> grid_size_y);
+      }
+    }
+
+    if (found_x && found_y) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Divide the tiles of a divided map again with the grid of the input, transforming the points
+// as they are read, since the transformed points no longer match their tiles. The tiles are
+// read once, by several threads, and no transformed copy of them is written.
+bool transform_pcd_tiles(
+  const rclcpp::Logger & logger, const std::string & pcd_map_dir, const std::string & output_dir,
+  const std::string & prefix, const Eigen::Affine3d & affine)
+{
+  double grid_size_x, grid_size_y;
+
+  if (!load_grid_size(pcd_map_dir, grid_size_x, grid_size_y)) {
+    RCLCPP_ERROR_STREAM(logger, "Couldn't find pointcloud_map_metadata.yaml for " << pcd_map_dir);
+    return false;
+  }
+
+  std::vector<std::string> input_files;
+  for (const auto & entry : std::filesystem::recursive_directory_iterator(pcd_map_dir)) {
+    const auto extension = entry.path().extension().string();
+    if (entry.is_regular_file() && (extension == ".pcd" || extension == ".PCD")) {
+      input_files.push_back(entry.path().string());
+    }
+  }
+  std::sort(input_files.begin(), input_files.end());
+
+  const size_t thread_num = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+  autoware::pointcloud_divider::PCDDivider<pcl::PointXYZ> divider(logger);
+  divider.setOutputDir(output_dir);
+  divider.setGridSize(grid_size_x, grid_size_y);
+  divider.setPrefix(prefix);
+  divider.setLeafSize(-1);
+  divider.setDebugMode(false);
+  divider.setThreadNum(thread_num, std::max<size_t>(thread_num / 2, 1));
+  divider.setStages(
+    {std::make_shared<autoware::pointcloud_divider::AffineTransformStage<pcl::PointXYZ>>(
+      affine)});
+  divider.run(input_files);
+
+  std::cout << "Transformed " << input_files.size() << " tiles" << std::endl;
+  return true;
+}
+
+Eigen::Affine3d create_affine_matrix_from_xyzrpy(
+  const double x, const double y, const double z, const double roll, const double pitch,
+  const double yaw)
+{
+  double roll_rad = roll * M_PI / 180.0;
+  double pitch_rad = pitch * M_PI / 180.0;
+  double yaw_rad = yaw * M_PI / 180.0;
+
+  Eigen::Translation<double, 3> trans(x, y, z);
+  Eigen::Matrix3d rot;
+  rot = Eigen::AngleAxisd(yaw_rad, Eigen::Vector3d::UnitZ()) *
+        Eigen::AngleAxisd(pitch_rad, Eigen::Vector3d::UnitY()) *
+        Eigen::AngleAxisd(roll_rad, Eigen::Vector3d::UnitX());
+  return trans * rot;
+}
+}  // namespace autoware::lanelet2_map_utils
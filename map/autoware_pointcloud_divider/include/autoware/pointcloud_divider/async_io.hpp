@@ -0,0 +1,851 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__ASYNC_IO_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__ASYNC_IO_HPP_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define AUTOWARE_POINTCLOUD_DIVIDER_HAS_IO_URING 1
+#else
+#define AUTOWARE_POINTCLOUD_DIVIDER_HAS_IO_URING 0
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Options of the io_uring backend of CustomPCDReader and CustomPCDWriter. The files are read
+// and written in chunks of registered buffers, @queue_depth of them in flight at once. The
+// backend is disabled with a depth of 0, and the readers and writers fall back to their streams
+// if the kernel does not support io_uring. A reader or writer keeps its ring and buffers from a
+// file to the next one opened with the same depth and chunk size.
+struct AsyncIOOptions
+{
+  size_t queue_depth = 0;
+  size_t chunk_size = 1 << 22;
+  // Read with O_DIRECT, bypassing the page cache. The filesystems not supporting it fall back
+  // to buffered reads.
+  bool direct = false;
+  // Drop the pages of the file from the page cache once they are consumed or written back, for a
+  // streaming pass that does not read them again. Not for the files read back soon after.
+  bool drop_cache = false;
+};
+
+// Minimal io_uring of fixed buffers over the raw system calls, so that no library is required
+class IOUring
+{
+public:
+  IOUring() = default;
+  IOUring(const IOUring &) = delete;
+  IOUring & operator=(const IOUring &) = delete;
+  ~IOUring() { close(); }
+
+  // Return false if io_uring is not available
+  bool init(unsigned entries)
+  {
+#if AUTOWARE_POINTCLOUD_DIVIDER_HAS_IO_URING
+    io_uring_params params;
+
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+    if (ring_fd_ < 0) {
+      return false;
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sq_ptr_ = map(sq_size_, IORING_OFF_SQ_RING);
+    cq_ptr_ = map(cq_size_, IORING_OFF_CQ_RING);
+    sqes_ = static_cast<io_uring_sqe *>(map(sqes_size_, IORING_OFF_SQES));
+
+    if (!sq_ptr_ || !cq_ptr_ || !sqes_) {
+      close();
+
+      return false;
+    }
+
+    auto sq = static_cast<char *>(sq_ptr_);
+    auto cq = static_cast<char *>(cq_ptr_);
+
+    sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    return true;
+#else
+    (void)entries;
+
+    return false;
+#endif
+  }
+
+  bool registerBuffers(const std::vector<iovec> & buffers)
+  {
+#if AUTOWARE_POINTCLOUD_DIVIDER_HAS_IO_URING
+    return syscall(
+             __NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, buffers.data(),
+             buffers.size()) == 0;
+#else
+    (void)buffers;
+
+    return false;
+#endif
+  }
+
+  // Queue a read (@write = false) or a write of the registered buffer @buf_index. The request is
+  // sent to the kernel by the next submit().
+  bool push(
+    bool write, int fd, char * addr, uint32_t len, uint64_t offset, uint16_t buf_index,
+    uint64_t user_data)
+  {
+#if AUTOWARE_POINTCLOUD_DIVIDER_HAS_IO_URING
+    const unsigned tail = *sq_tail_;
+
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+      return false;
+    }
+
+    io_uring_sqe & sqe = sqes_[tail & sq_mask_];
+
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+    sqe.fd = fd;
+    sqe.addr = reinterpret_cast<uint64_t>(addr);
+    sqe.len = len;
+    sqe.off = offset;
+    sqe.buf_index = buf_index;
+    sqe.user_data = user_data;
+    sq_array_[tail & sq_mask_] = tail & sq_mask_;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++to_submit_;
+
+    return true;
+#else
+    (void)write, (void)fd, (void)addr, (void)len, (void)offset, (void)buf_index, (void)user_data;
+
+    return false;
+#endif
+  }
+
+  // Send the queued requests, and wait until @wait_num completions are available
+  bool submit(unsigned wait_num = 0)
+  {
+#if AUTOWARE_POINTCLOUD_DIVIDER_HAS_IO_URING
+    while (true) {
+      const long ret = syscall(
+        __NR_io_uring_enter, ring_fd_, to_submit_, wait_num,
+        wait_num > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+
+      if (ret >= 0) {
+        to_submit_ -= std::min<unsigned>(to_submit_, static_cast<unsigned>(ret));
+
+        return true;
+      }
+
+      if (errno != EINTR) {
+        return false;
+      }
+    }
+#else
+    (void)wait_num;
+
+    return false;
+#endif
+  }
+
+  // Take a completion, if any. @res is the number of bytes transferred, or a negative errno.
+  bool pop(uint64_t & user_data, int32_t & res)
+  {
+#if AUTOWARE_POINTCLOUD_DIVIDER_HAS_IO_URING
+    const unsigned head = *cq_head_;
+
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+
+    const io_uring_cqe & cqe = cqes_[head & cq_mask_];
+
+    user_data = cqe.user_data;
+    res = cqe.res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+#else
+    (void)user_data, (void)res;
+
+    return false;
+#endif
+  }
+
+  bool is_open() const { return ring_fd_ >= 0; }
+
+  // Wait for a completion
+  bool wait(uint64_t & user_data, int32_t & res)
+  {
+    while (!pop(user_data, res)) {
+      if (!submit(1)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void close()
+  {
+    if (sq_ptr_) {
+      munmap(sq_ptr_, sq_size_);
+    }
+
+    if (cq_ptr_) {
+      munmap(cq_ptr_, cq_size_);
+    }
+
+    if (sqes_) {
+      munmap(sqes_, sqes_size_);
+    }
+
+    if (ring_fd_ >= 0) {
+      ::close(ring_fd_);
+    }
+
+    ring_fd_ = -1;
+    sq_ptr_ = cq_ptr_ = nullptr;
+    sqes_ = nullptr;
+    to_submit_ = 0;
+  }
+
+private:
+  void * map(size_t size, uint64_t offset)
+  {
+    void * addr =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+
+    return addr == MAP_FAILED ? nullptr : addr;
+  }
+
+  int ring_fd_ = -1;
+  void * sq_ptr_ = nullptr;
+  void * cq_ptr_ = nullptr;
+  size_t sq_size_ = 0, cq_size_ = 0, sqes_size_ = 0;
+#if AUTOWARE_POINTCLOUD_DIVIDER_HAS_IO_URING
+  io_uring_sqe * sqes_ = nullptr;
+  io_uring_cqe * cqes_ = nullptr;
+#else
+  void * sqes_ = nullptr;
+#endif
+  unsigned * sq_head_ = nullptr;
+  unsigned * sq_tail_ = nullptr;
+  unsigned * sq_array_ = nullptr;
+  unsigned * cq_head_ = nullptr;
+  unsigned * cq_tail_ = nullptr;
+  unsigned sq_mask_ = 0, sq_entries_ = 0, cq_mask_ = 0;
+  unsigned to_submit_ = 0;
+};
+
+// Pool of page aligned chunks registered to a ring, as O_DIRECT requires
+class IOBufferPool
+{
+public:
+  // Alignment of the buffers, and of the offsets and sizes of the O_DIRECT requests
+  static constexpr size_t alignment = 4096;
+
+  IOBufferPool() = default;
+  IOBufferPool(const IOBufferPool &) = delete;
+  IOBufferPool & operator=(const IOBufferPool &) = delete;
+  ~IOBufferPool() { clear(); }
+
+  bool init(IOUring & ring, size_t chunk_num, size_t chunk_size)
+  {
+    clear();
+    chunk_size_ = (std::max(chunk_size, alignment) + alignment - 1) / alignment * alignment;
+
+    for (size_t i = 0; i < chunk_num; ++i) {
+      void * data = std::aligned_alloc(alignment, chunk_size_);
+
+      if (!data) {
+        return false;
+      }
+
+      buffers_.push_back({data, chunk_size_});
+    }
+
+    return ring.registerBuffers(buffers_);
+  }
+
+  char * data(size_t i) const { return static_cast<char *>(buffers_[i].iov_base); }
+  size_t chunkSize() const { return chunk_size_; }
+  size_t size() const { return buffers_.size(); }
+
+  void clear()
+  {
+    for (auto & buffer : buffers_) {
+      std::free(buffer.iov_base);
+    }
+
+    buffers_.clear();
+  }
+
+private:
+  std::vector<iovec> buffers_;
+  size_t chunk_size_ = 0;
+};
+
+// Sequential reader of a file through io_uring, which keeps the next chunks of the file being
+// read while the caller decodes the current one
+class AsyncFileReader
+{
+public:
+  AsyncFileReader() = default;
+  AsyncFileReader(const AsyncFileReader &) = delete;
+  AsyncFileReader & operator=(const AsyncFileReader &) = delete;
+  ~AsyncFileReader() { release(); }
+
+  // Read @path from @offset. Return false if the file cannot be read through io_uring, and the
+  // caller should read it by other means.
+  bool open(const std::string & path, size_t offset, const AsyncIOOptions & options)
+  {
+    close();
+
+    if (options.queue_depth == 0) {
+      return false;
+    }
+
+    // The ring and the buffers of the previous file are reused if they have the same sizes
+    const bool reuse = ring_.is_open() && options.queue_depth == options_.queue_depth &&
+                       options.chunk_size == options_.chunk_size;
+
+    options_ = options;
+    fd_ = options.direct ? ::open(path.c_str(), O_RDONLY | O_DIRECT) : -1;
+    direct_ = fd_ >= 0;
+
+    if (fd_ < 0) {
+      fd_ = ::open(path.c_str(), O_RDONLY);
+    }
+
+    struct stat file_stat;
+
+    if (fd_ < 0 || fstat(fd_, &file_stat) != 0) {
+      close();
+
+      return false;
+    }
+
+    if (!reuse) {
+      ring_.close();
+      pool_.clear();
+
+      if (
+        !ring_.init(options.queue_depth) ||
+        !pool_.init(ring_, options.queue_depth, options.chunk_size)) {
+        release();
+
+        return false;
+      }
+    }
+
+    file_size_ = file_stat.st_size;
+    chunks_.assign(pool_.size(), Chunk());
+
+    if (!direct_) {
+      posix_fadvise(fd_, offset, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    return seek(offset);
+  }
+
+  // Continue reading from @offset, dropping the chunks read ahead
+  bool seek(size_t offset)
+  {
+    if (!drain()) {
+      return false;
+    }
+
+    // O_DIRECT requests start at an aligned offset, and the bytes before @offset are skipped
+    next_offset_ = direct_ ? offset / IOBufferPool::alignment * IOBufferPool::alignment : offset;
+    head_ = 0;
+    head_pos_ = offset - next_offset_;
+    error_ = false;
+    // The chunks are requested by the first read, so a reader seeking after opening the file
+    // does not read its beginning
+    started_ = false;
+
+    return true;
+  }
+
+  // Copy the next @size bytes of the file to @dst. Return the number of bytes copied, which is
+  // less than @size at the end of the file or on an error.
+  size_t read(char * dst, size_t size)
+  {
+    size_t copied = 0;
+
+    if (!started_ && fd_ >= 0) {
+      for (size_t i = 0; i < chunks_.size(); ++i) {
+        submit(i);
+      }
+
+      error_ = error_ || !ring_.submit();
+      started_ = true;
+    }
+
+    while (copied < size && fd_ >= 0) {
+      Chunk & chunk = chunks_[head_];
+
+      while (chunk.pending && !error_) {
+        complete();
+      }
+
+      if (chunk.filled <= head_pos_ || error_) {
+        break;
+      }
+
+      const size_t n = std::min(size - copied, chunk.filled - head_pos_);
+
+      memcpy(dst + copied, pool_.data(head_) + head_pos_, n);
+      copied += n;
+      head_pos_ += n;
+
+      if (head_pos_ == chunk.filled) {
+        if (options_.drop_cache && !direct_) {
+          posix_fadvise(fd_, chunk.offset, chunk.filled, POSIX_FADV_DONTNEED);
+        }
+
+        submit(head_);
+        head_ = (head_ + 1) % chunks_.size();
+        head_pos_ = 0;
+        error_ = error_ || !ring_.submit();
+      }
+    }
+
+    return copied;
+  }
+
+  // True if a read failed
+  bool failed() const { return error_; }
+  bool is_open() const { return fd_ >= 0; }
+
+  // Close the file, and keep the ring and the buffers for the next one
+  void close()
+  {
+    // The buffers of the chunks still in flight cannot be reused
+    if (!drain()) {
+      ring_.close();
+      pool_.clear();
+    }
+
+    chunks_.clear();
+
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+
+    fd_ = -1;
+  }
+
+  // Close the file, and release the ring and the buffers
+  void release()
+  {
+    close();
+    ring_.close();
+    pool_.clear();
+  }
+
+private:
+  struct Chunk
+  {
+    size_t offset = 0, requested = 0, filled = 0;
+    bool pending = false;
+  };
+
+  // Request the next chunk of the file in the buffer @i, or leave it empty past the end
+  void submit(size_t i)
+  {
+    Chunk & chunk = chunks_[i];
+
+    chunk.offset = next_offset_;
+    chunk.requested = next_offset_ < file_size_
+                        ? std::min<size_t>(pool_.chunkSize(), file_size_ - next_offset_)
+                        : 0;
+    chunk.filled = 0;
+    chunk.pending = chunk.requested > 0;
+    next_offset_ += chunk.requested;
+
+    if (chunk.pending) {
+      push(i);
+    }
+  }
+
+  void push(size_t i)
+  {
+    Chunk & chunk = chunks_[i];
+    // O_DIRECT reads whole blocks, including the end of the file
+    size_t len = chunk.requested - chunk.filled;
+
+    if (direct_) {
+      len = (len + IOBufferPool::alignment - 1) / IOBufferPool::alignment * IOBufferPool::alignment;
+    }
+
+    if (!ring_.push(
+          false, fd_, pool_.data(i) + chunk.filled, len, chunk.offset + chunk.filled, i, i)) {
+      error_ = true;
+      chunk.pending = false;
+    }
+  }
+
+  // Wait for a completion, and request the rest of a short read
+  void complete()
+  {
+    uint64_t i;
+    int32_t res;
+
+    if (!ring_.wait(i, res)) {
+      error_ = true;
+
+      return;
+    }
+
+    Chunk & chunk = chunks_[i];
+
+    if (res == -EINTR || res == -EAGAIN) {
+      push(i);
+    } else if (res <= 0) {
+      // The file was truncated or cannot be read
+      error_ = error_ || res < 0;
+      chunk.pending = false;
+    } else {
+      chunk.filled = std::min(chunk.filled + res, chunk.requested);
+      chunk.pending = chunk.filled < chunk.requested;
+
+      if (chunk.pending) {
+        push(i);
+      }
+    }
+
+    error_ = error_ || !ring_.submit();
+  }
+
+  // Wait for the chunks in flight, since their buffers must not be released before
+  bool drain()
+  {
+    bool ok = true;
+
+    for (auto & chunk : chunks_) {
+      while (chunk.pending) {
+        uint64_t i;
+        int32_t res;
+
+        if (!ring_.wait(i, res)) {
+          return false;
+        }
+
+        chunks_[i].pending = false;
+        ok = ok && res >= 0;
+      }
+    }
+
+    return ok;
+  }
+
+  AsyncIOOptions options_;
+  int fd_ = -1;
+  bool direct_ = false;
+  size_t file_size_ = 0;
+  IOUring ring_;
+  IOBufferPool pool_;
+  std::vector<Chunk> chunks_;
+  // Offset of the next chunk to request, the chunk being consumed and the position in it
+  size_t next_offset_ = 0, head_ = 0, head_pos_ = 0;
+  bool started_ = false;
+  bool error_ = false;
+};
+
+// Sequential writer of a file through io_uring. The writes are coalesced into chunks, and the
+// caller fills the next chunk while the previous ones are written.
+class AsyncFileWriter
+{
+public:
+  AsyncFileWriter() = default;
+  AsyncFileWriter(const AsyncFileWriter &) = delete;
+  AsyncFileWriter & operator=(const AsyncFileWriter &) = delete;
+  ~AsyncFileWriter() { release(); }
+
+  // Create or truncate @path. Return false if it cannot be written through io_uring, and the
+  // caller should write it by other means.
+  bool open(const std::string & path, const AsyncIOOptions & options)
+  {
+    close();
+
+    if (options.queue_depth == 0) {
+      return false;
+    }
+
+    // The ring and the buffers of the previous file are reused if they have the same sizes
+    const bool reuse = ring_.is_open() && options.queue_depth == options_.queue_depth &&
+                       options.chunk_size == options_.chunk_size;
+
+    options_ = options;
+    // The chunks are not aligned to the blocks after a flush, so the writes are buffered
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd_ < 0) {
+      return false;
+    }
+
+    if (!reuse) {
+      ring_.close();
+      pool_.clear();
+
+      if (
+        !ring_.init(options.queue_depth) ||
+        !pool_.init(ring_, options.queue_depth, options.chunk_size)) {
+        ring_.close();
+        pool_.clear();
+        ::close(fd_);
+        fd_ = -1;
+
+        return false;
+      }
+    }
+
+    chunks_.assign(pool_.size(), Chunk());
+
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      free_.push_back(i);
+    }
+
+    current_ = next();
+    position_ = dropped_ = 0;
+    error_ = false;
+
+    return true;
+  }
+
+  bool write(const char * src, size_t size)
+  {
+    while (size > 0 && !error_) {
+      Chunk & chunk = chunks_[current_];
+      const size_t n = std::min(size, pool_.chunkSize() - chunk.size);
+
+      memcpy(pool_.data(current_) + chunk.size, src, n);
+      chunk.size += n;
+      src += n;
+      size -= n;
+
+      if (chunk.size == pool_.chunkSize()) {
+        submitCurrent();
+      }
+    }
+
+    return !error_;
+  }
+
+  // Write the buffered bytes and wait until all of them are written
+  bool flush()
+  {
+    if (fd_ < 0) {
+      return false;
+    }
+
+    if (chunks_[current_].size > 0) {
+      submitCurrent();
+    }
+
+    while (free_.size() + 1 < chunks_.size() && !error_) {
+      complete();
+    }
+
+    return !error_;
+  }
+
+  // Number of bytes written so far, including the buffered ones
+  size_t position() const { return position_ + (fd_ >= 0 ? chunks_[current_].size : 0); }
+  bool good() const { return fd_ >= 0 && !error_; }
+  bool is_open() const { return fd_ >= 0; }
+
+  // Close the file, and keep the ring and the buffers for the next one
+  bool close()
+  {
+    if (fd_ < 0) {
+      return true;
+    }
+
+    bool ok = flush();
+
+    // Drop the rest of the file which is already written back
+    if (ok && options_.drop_cache) {
+      dropCache(position_);
+    }
+
+    // The buffers of the chunks still in flight after an error cannot be reused
+    if (!ok) {
+      ring_.close();
+      pool_.clear();
+    }
+
+    chunks_.clear();
+    free_.clear();
+    ok = ::close(fd_) == 0 && ok;
+    fd_ = -1;
+
+    return ok;
+  }
+
+  // Close the file, and release the ring and the buffers
+  bool release()
+  {
+    const bool ok = close();
+
+    ring_.close();
+    pool_.clear();
+
+    return ok;
+  }
+
+private:
+  struct Chunk
+  {
+    size_t offset = 0, size = 0, written = 0;
+  };
+
+  void submitCurrent()
+  {
+    Chunk & chunk = chunks_[current_];
+
+    chunk.offset = position_;
+    chunk.written = 0;
+    position_ += chunk.size;
+    push(current_);
+    error_ = error_ || !ring_.submit();
+    current_ = next();
+
+    // The chunks before the ones in flight are written, and their write back was started when
+    // they completed, so their pages are mostly clean by now
+    if (options_.drop_cache && position_ > chunks_.size() * pool_.chunkSize()) {
+      dropCache(position_ - chunks_.size() * pool_.chunkSize());
+    }
+  }
+
+  void push(size_t i)
+  {
+    Chunk & chunk = chunks_[i];
+
+    if (!ring_.push(
+          true, fd_, pool_.data(i) + chunk.written, chunk.size - chunk.written,
+          chunk.offset + chunk.written, i, i)) {
+      error_ = true;
+    }
+  }
+
+  // A free chunk, waiting for a write to complete if all of them are in flight
+  size_t next()
+  {
+    while (free_.empty() && !error_) {
+      complete();
+    }
+
+    if (free_.empty()) {
+      return current_;
+    }
+
+    size_t i = free_.back();
+
+    free_.pop_back();
+    chunks_[i].size = 0;
+
+    return i;
+  }
+
+  void complete()
+  {
+    uint64_t i;
+    int32_t res;
+
+    if (!ring_.wait(i, res)) {
+      error_ = true;
+
+      return;
+    }
+
+    Chunk & chunk = chunks_[i];
+
+    if (res == -EINTR || res == -EAGAIN) {
+      push(i);
+    } else if (res <= 0) {
+      error_ = true;
+      free_.push_back(i);
+    } else if ((chunk.written += res) < chunk.size) {
+      push(i);
+    } else {
+      // Start writing the chunk back, so it is clean when its pages are dropped
+      if (options_.drop_cache) {
+        sync_file_range(fd_, chunk.offset, chunk.size, SYNC_FILE_RANGE_WRITE);
+      }
+
+      free_.push_back(i);
+    }
+
+    error_ = error_ || !ring_.submit();
+  }
+
+  // Drop the pages until @end which are written back. This waits for the write back already in
+  // progress, but not for the one it starts, so the dirty pages left stay in the page cache.
+  void dropCache(size_t end)
+  {
+    if (end <= dropped_) {
+      return;
+    }
+
+    sync_file_range(
+      fd_, dropped_, end - dropped_, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE);
+    posix_fadvise(fd_, dropped_, end - dropped_, POSIX_FADV_DONTNEED);
+    dropped_ = end;
+  }
+
+  AsyncIOOptions options_;
+  int fd_ = -1;
+  IOUring ring_;
+  IOBufferPool pool_;
+  std::vector<Chunk> chunks_;
+  std::vector<size_t> free_;
+  // Chunk being filled, bytes submitted so far, and bytes dropped from the page cache
+  size_t current_ = 0, position_ = 0, dropped_ = 0;
+  bool error_ = false;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__ASYNC_IO_HPP_
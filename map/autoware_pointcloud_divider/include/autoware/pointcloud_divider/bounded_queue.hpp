@@ -0,0 +1,94 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__BOUNDED_QUEUE_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__BOUNDED_QUEUE_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace autoware::pointcloud_divider
+{
+
+// A blocking FIFO queue with a fixed capacity, used to connect the stages of the
+// pipelined divider. Producers block when the queue is full, consumers block when
+// it is empty. Once closed, push() is rejected and pop() drains the remaining items.
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+  // Return false if the queue was closed before the item could be inserted
+  bool push(T item)
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+
+    not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+
+    if (closed_) {
+      return false;
+    }
+
+    items_.push_back(std::move(item));
+    lock.unlock();
+    not_empty_.notify_one();
+
+    return true;
+  }
+
+  // Return false if the queue was closed and there is no item left
+  bool pop(T & item)
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+
+    not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+
+    if (items_.empty()) {
+      return false;
+    }
+
+    item = std::move(items_.front());
+    items_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+
+    return true;
+  }
+
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      closed_ = true;
+    }
+
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+private:
+  std::mutex mtx_;
+  std::condition_variable not_empty_, not_full_;
+  std::deque<T> items_;
+  size_t capacity_;
+  bool closed_ = false;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__BOUNDED_QUEUE_HPP_
@@ -15,6 +15,7 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__CENTROID_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__CENTROID_HPP_
 
+#include "point_field_traits.hpp"
 #include "utility.hpp"
 
 #include <pcl/point_types.h>
@@ -24,52 +25,37 @@
 namespace autoware::pointcloud_divider
 {
 
+// Accumulate the differences between the points and the first point of the voxel,
+// to reduce the loss of precision when the coordinates are large
 template <typename PointT>
-void accumulate(const PointT & p, const PointT & first_p, PointT & acc_diff);
-template <typename PointT>
-void compute_centroid(
-  const PointT & acc_diff, const PointT & first_p, size_t point_num, PointT & centroid);
-
-template <>
-void accumulate(const pcl::PointXYZ & p, const pcl::PointXYZ & first_p, pcl::PointXYZ & acc_diff)
+inline void accumulate(const PointT & p, const PointT & first_p, PointT & acc_diff)
 {
-  acc_diff.x += p.x - first_p.x;
-  acc_diff.y += p.y - first_p.y;
-  acc_diff.z += p.z - first_p.z;
-}
+  using Traits = PointFieldTraits<PointT>;
 
-template <>
-void accumulate(const pcl::PointXYZI & p, const pcl::PointXYZI & first_p, pcl::PointXYZI & acc_diff)
-{
-  acc_diff.x += p.x - first_p.x;
-  acc_diff.y += p.y - first_p.y;
-  acc_diff.z += p.z - first_p.z;
-  acc_diff.intensity += p.intensity - first_p.intensity;
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    if (!Traits::color[fid]) {
+      *fieldPtr(acc_diff, fid) += *fieldPtr(p, fid) - *fieldPtr(first_p, fid);
+    }
+  }
 }
 
-template <>
-void compute_centroid(
-  const pcl::PointXYZ & acc_diff, const pcl::PointXYZ & first_p, size_t point_num,
-  pcl::PointXYZ & centroid)
+template <typename PointT>
+inline void compute_centroid(
+  const PointT & acc_diff, const PointT & first_p, size_t point_num, PointT & centroid)
 {
-  double double_point_num = static_cast<double>(point_num);
-
-  centroid.x = acc_diff.x / double_point_num + first_p.x;
-  centroid.y = acc_diff.y / double_point_num + first_p.y;
-  centroid.z = acc_diff.z / double_point_num + first_p.z;
-}
+  using Traits = PointFieldTraits<PointT>;
 
-template <>
-void compute_centroid(
-  const pcl::PointXYZI & acc_diff, const pcl::PointXYZI & first_p, size_t point_num,
-  pcl::PointXYZI & centroid)
-{
   double double_point_num = static_cast<double>(point_num);
 
-  centroid.x = acc_diff.x / double_point_num + first_p.x;
-  centroid.y = acc_diff.y / double_point_num + first_p.y;
-  centroid.z = acc_diff.z / double_point_num + first_p.z;
-  centroid.intensity = acc_diff.intensity / double_point_num + first_p.intensity;
+  // Colors are not averaged, so the centroid keeps the color of the first point
+  centroid = first_p;
+
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    if (!Traits::color[fid]) {
+      *fieldPtr(centroid, fid) =
+        *fieldPtr(acc_diff, fid) / double_point_num + *fieldPtr(first_p, fid);
+    }
+  }
 }
 
 template <typename PointT>
@@ -15,6 +15,7 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__GRID_INFO_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__GRID_INFO_HPP_
 
+#include <cmath>
 #include <iostream>
 #include <string>
 #include <tuple>
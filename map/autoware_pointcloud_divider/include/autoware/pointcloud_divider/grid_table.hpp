@@ -0,0 +1,173 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__GRID_TABLE_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__GRID_TABLE_HPP_
+
+#include "grid_info.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Open-addressing hash table from the 2D grids to values, with linear probing over a flat array.
+// The grids are packed to 64-bit keys, so a lookup hashes and compares a single integer.
+// Entries are never erased one by one, only all together by clear().
+template <typename ValueT>
+class GridTable
+{
+public:
+  GridTable() { slots_.resize(min_capacity_); }
+
+  static uint64_t key(const GridInfo<2> & grid)
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(grid.ix)) << 32) |
+           static_cast<uint32_t>(grid.iy);
+  }
+
+  // Value of the key, nullptr if the key is not in the table
+  ValueT * find(uint64_t key)
+  {
+    const size_t mask = slots_.size() - 1;
+
+    for (size_t i = slotIndex(key, mask);; i = (i + 1) & mask) {
+      auto & slot = slots_[i];
+
+      if (!slot.used) {
+        return nullptr;
+      }
+
+      if (slot.key == key) {
+        return &slot.value;
+      }
+    }
+  }
+
+  // Insert a key that is not in the table yet. The pointers returned by find() and insert()
+  // before are invalidated.
+  ValueT & insert(uint64_t key, ValueT value)
+  {
+    // Keep the load factor below 1/2, so the probe sequences stay short
+    if ((size_ + 1) * 2 > slots_.size()) {
+      rehash(slots_.size() * 2);
+    }
+
+    ++size_;
+
+    return place(key, std::move(value));
+  }
+
+  void clear()
+  {
+    slots_.clear();
+    slots_.resize(min_capacity_);
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+
+private:
+  struct Slot
+  {
+    uint64_t key = 0;
+    bool used = false;
+    ValueT value{};
+  };
+
+  static constexpr size_t min_capacity_ = 64;
+
+  // Fibonacci hashing, so the neighboring grids spread over the table
+  static size_t slotIndex(uint64_t key, size_t mask)
+  {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+  }
+
+  ValueT & place(uint64_t key, ValueT value)
+  {
+    const size_t mask = slots_.size() - 1;
+    size_t i = slotIndex(key, mask);
+
+    while (slots_[i].used) {
+      i = (i + 1) & mask;
+    }
+
+    slots_[i].key = key;
+    slots_[i].used = true;
+    slots_[i].value = std::move(value);
+
+    return slots_[i].value;
+  }
+
+  void rehash(size_t capacity)
+  {
+    std::vector<Slot> old_slots(capacity);
+
+    old_slots.swap(slots_);
+
+    for (auto & slot : old_slots) {
+      if (slot.used) {
+        place(slot.key, std::move(slot.value));
+      }
+    }
+  }
+
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+};
+
+// pointToGrid2 with the divisions replaced by multiplications with the reciprocals of the grid
+// sizes. The product differs from the quotient by a few ulps, which changes the grid only if
+// the quotient is next to an integer, so such points fall back to the division. The grids are
+// always the same as pointToGrid2.
+class GridMapper
+{
+public:
+  GridMapper(float res_x, float res_y)
+  : res_x_(res_x), res_y_(res_y), inv_res_x_(1.0f / res_x), inv_res_y_(1.0f / res_y)
+  {
+  }
+
+  template <typename PointT>
+  GridInfo<2> operator()(const PointT & p) const
+  {
+    return GridInfo<2>(toIndex(p.x, res_x_, inv_res_x_), toIndex(p.y, res_y_, inv_res_y_));
+  }
+
+private:
+  static int toIndex(float v, float res, float inv_res)
+  {
+    const float q = v * inv_res;
+    float fq = std::floor(q);
+    const float frac = q - fq;
+    const float tolerance = 4 * FLT_EPSILON * std::abs(q) + FLT_MIN;
+
+    if (frac < tolerance || frac > 1.0f - tolerance) {
+      fq = std::floor(v / res);
+    }
+
+    return static_cast<int>(fq * res);
+  }
+
+  float res_x_, res_y_, inv_res_x_, inv_res_y_;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__GRID_TABLE_HPP_
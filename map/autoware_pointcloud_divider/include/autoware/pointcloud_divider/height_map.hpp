@@ -0,0 +1,315 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__HEIGHT_MAP_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__HEIGHT_MAP_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// 2.5D raster of the minimum and median z of the points of a segment, written next to the
+// segment PCD, so that the ground height at (x, y) is read in O(1) without loading the points.
+// Like tile_index.hpp, it has no dependency other than the standard library.
+//
+// Layout of the binary format (little endian):
+//   char[8]     magic "PCDHMAP1"
+//   double      origin_x, origin_y (lower-left corner of the segment), cell_size
+//   uint32      cols, rows
+//   float       min[rows * cols], then median[rows * cols], row 0 at origin_y, NaN if empty
+//
+// The GeoTIFF format is an uncompressed float32 raster with the minimum and the median as two
+// samples per pixel, georeferenced in the map frame, for GIS tools. It is written only.
+
+enum class HeightMapFormat {
+  BINARY,  // <segment>.height
+  GEOTIFF  // <segment>.tif
+};
+
+// Convert the format name in the config ("binary" or "geotiff") to the format
+inline bool toHeightMapFormat(const std::string & name, HeightMapFormat & format)
+{
+  if (name == "binary") {
+    format = HeightMapFormat::BINARY;
+  } else if (name == "geotiff") {
+    format = HeightMapFormat::GEOTIFF;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+inline const char * heightMapFormatName(HeightMapFormat format)
+{
+  return format == HeightMapFormat::GEOTIFF ? "geotiff" : "binary";
+}
+
+inline const char * heightMapExtension(HeightMapFormat format)
+{
+  return format == HeightMapFormat::GEOTIFF ? ".tif" : ".height";
+}
+
+class HeightMap
+{
+public:
+  HeightMap() : origin_x_(0), origin_y_(0), cell_size_(1), cols_(0), rows_(0) {}
+
+  // Empty raster covering [origin_x, origin_x + size_x) x [origin_y, origin_y + size_y)
+  HeightMap(double origin_x, double origin_y, double size_x, double size_y, double cell_size)
+  : origin_x_(origin_x), origin_y_(origin_y), cell_size_(cell_size), cols_(0), rows_(0)
+  {
+    if (cell_size_ > 0) {
+      cols_ = std::max<uint32_t>(static_cast<uint32_t>(std::ceil(size_x / cell_size_)), 1);
+      rows_ = std::max<uint32_t>(static_cast<uint32_t>(std::ceil(size_y / cell_size_)), 1);
+    }
+
+    min_.assign(size(), std::numeric_limits<float>::quiet_NaN());
+    median_.assign(size(), std::numeric_limits<float>::quiet_NaN());
+  }
+
+  // Fill the cells from the points of @cloud, which only need x, y, and z. The points are
+  // sorted by cell in linear time, then the median of each cell is selected in place. Points
+  // on the upper borders are counted in the last cells, and the others outside are ignored.
+  // Cells of an even number of points take the upper of the two middle values.
+  template <class CloudT>
+  void build(const CloudT & cloud)
+  {
+    std::vector<uint32_t> cells;
+    std::vector<uint32_t> offsets(size() + 1, 0);
+
+    cells.reserve(cloud.size());
+
+    for (const auto & p : cloud) {
+      const int64_t cell = cellOf(p.x, p.y, true);
+
+      cells.push_back(cell < 0 ? invalid_cell : static_cast<uint32_t>(cell));
+
+      if (cell >= 0 && std::isfinite(p.z)) {
+        ++offsets[cell + 1];
+      }
+    }
+
+    for (size_t i = 0; i < size(); ++i) {
+      offsets[i + 1] += offsets[i];
+    }
+
+    std::vector<float> z(offsets.back());
+    std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+    size_t i = 0;
+
+    for (const auto & p : cloud) {
+      const uint32_t cell = cells[i++];
+
+      if (cell != invalid_cell && std::isfinite(p.z)) {
+        z[next[cell]++] = p.z;
+      }
+    }
+
+    for (size_t cell = 0; cell < size(); ++cell) {
+      auto first = z.begin() + offsets[cell], last = z.begin() + offsets[cell + 1];
+
+      if (first == last) {
+        continue;
+      }
+
+      auto middle = first + (last - first) / 2;
+
+      std::nth_element(first, middle, last);
+      median_[cell] = *middle;
+      // nth_element leaves the smaller values before the median
+      min_[cell] = *std::min_element(first, middle + 1);
+    }
+  }
+
+  // Minimum and median z of the cell containing (x, y), NaN if the cell is empty or outside
+  float minHeight(double x, double y) const { return value(min_, x, y); }
+  float medianHeight(double x, double y) const { return value(median_, x, y); }
+
+  // Return false if the file is not a height map
+  bool load(const std::string & path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    char magic[8];
+
+    file.read(magic, sizeof(magic));
+
+    if (!file || memcmp(magic, "PCDHMAP1", sizeof(magic)) != 0) {
+      return false;
+    }
+
+    file.read(reinterpret_cast<char *>(&origin_x_), sizeof(origin_x_));
+    file.read(reinterpret_cast<char *>(&origin_y_), sizeof(origin_y_));
+    file.read(reinterpret_cast<char *>(&cell_size_), sizeof(cell_size_));
+    file.read(reinterpret_cast<char *>(&cols_), sizeof(cols_));
+    file.read(reinterpret_cast<char *>(&rows_), sizeof(rows_));
+
+    if (!file) {
+      return false;
+    }
+
+    min_.resize(size());
+    median_.resize(size());
+    file.read(reinterpret_cast<char *>(min_.data()), size() * sizeof(float));
+    file.read(reinterpret_cast<char *>(median_.data()), size() * sizeof(float));
+
+    return static_cast<bool>(file);
+  }
+
+  bool save(const std::string & path) const
+  {
+    std::ofstream file(path, std::ios::binary);
+
+    file.write("PCDHMAP1", 8);
+    file.write(reinterpret_cast<const char *>(&origin_x_), sizeof(origin_x_));
+    file.write(reinterpret_cast<const char *>(&origin_y_), sizeof(origin_y_));
+    file.write(reinterpret_cast<const char *>(&cell_size_), sizeof(cell_size_));
+    file.write(reinterpret_cast<const char *>(&cols_), sizeof(cols_));
+    file.write(reinterpret_cast<const char *>(&rows_), sizeof(rows_));
+    file.write(reinterpret_cast<const char *>(min_.data()), size() * sizeof(float));
+    file.write(reinterpret_cast<const char *>(median_.data()), size() * sizeof(float));
+
+    return static_cast<bool>(file);
+  }
+
+  // Little endian TIFF of a single strip, the rows from the top (max y) down, followed by the
+  // directory. The geokeys only define a user-defined projected model with pixels as areas,
+  // since the map frame has no EPSG code.
+  bool saveGeoTIFF(const std::string & path) const
+  {
+    const uint32_t image_bytes = size() * 2 * sizeof(float);
+    const uint32_t ifd_offset = 8 + image_bytes;
+    const uint16_t tag_num = 16;
+    // The values too large for the directory entries follow it
+    const uint32_t extra_offset = ifd_offset + 2 + tag_num * 12 + 4;
+    const double pixel_scale[3] = {cell_size_, cell_size_, 0};
+    const double tiepoint[6] = {0, 0, 0, origin_x_, origin_y_ + rows_ * cell_size_, 0};
+    // Header (version 1.1.0, 2 keys), GTModelTypeGeoKey user-defined, GTRasterTypeGeoKey area
+    const uint16_t geokeys[12] = {1, 1, 0, 2, 1024, 0, 1, 32767, 1025, 0, 1, 1};
+    std::ofstream file(path, std::ios::binary);
+    std::vector<float> row(cols_ * 2);
+
+    file.write("II*\0", 4);
+    write(file, ifd_offset);
+
+    for (uint32_t r = rows_; r-- > 0;) {
+      for (uint32_t c = 0; c < cols_; ++c) {
+        row[c * 2] = min_[r * cols_ + c];
+        row[c * 2 + 1] = median_[r * cols_ + c];
+      }
+
+      file.write(reinterpret_cast<const char *>(row.data()), row.size() * sizeof(float));
+    }
+
+    write(file, tag_num);
+    writeTag(file, 256, 4, 1, cols_);                 // ImageWidth
+    writeTag(file, 257, 4, 1, rows_);                 // ImageLength
+    writeTag(file, 258, 3, 2, 32 | (32 << 16));       // BitsPerSample
+    writeTag(file, 259, 3, 1, 1);                     // Compression: none
+    writeTag(file, 262, 3, 1, 1);                     // PhotometricInterpretation: BlackIsZero
+    writeTag(file, 273, 4, 1, 8);                     // StripOffsets
+    writeTag(file, 277, 3, 1, 2);                     // SamplesPerPixel
+    writeTag(file, 278, 4, 1, rows_);                 // RowsPerStrip
+    writeTag(file, 279, 4, 1, image_bytes);           // StripByteCounts
+    writeTag(file, 284, 3, 1, 1);                     // PlanarConfiguration: contiguous
+    writeTag(file, 338, 3, 1, 0);                     // ExtraSamples: unspecified
+    writeTag(file, 339, 3, 2, 3 | (3 << 16));         // SampleFormat: IEEE float
+    writeTag(file, 33550, 12, 3, extra_offset);       // ModelPixelScaleTag
+    writeTag(file, 33922, 12, 6, extra_offset + 24);  // ModelTiepointTag
+    writeTag(file, 34735, 3, 12, extra_offset + 72);  // GeoKeyDirectoryTag
+    writeTag(file, 42113, 2, 4, 0x006e616e);          // GDAL_NODATA: "nan"
+    write(file, uint32_t{0});  // No next directory
+    file.write(reinterpret_cast<const char *>(pixel_scale), sizeof(pixel_scale));
+    file.write(reinterpret_cast<const char *>(tiepoint), sizeof(tiepoint));
+    file.write(reinterpret_cast<const char *>(geokeys), sizeof(geokeys));
+
+    return static_cast<bool>(file);
+  }
+
+  double originX() const { return origin_x_; }
+  double originY() const { return origin_y_; }
+  double cellSize() const { return cell_size_; }
+  uint32_t cols() const { return cols_; }
+  uint32_t rows() const { return rows_; }
+  size_t size() const { return static_cast<size_t>(cols_) * rows_; }
+
+private:
+  static constexpr uint32_t invalid_cell = std::numeric_limits<uint32_t>::max();
+
+  // Index of the cell containing (x, y), -1 if outside. With @clamp, the points just beyond the
+  // upper borders, which belong to the segment by rounding, are kept in the last cells.
+  int64_t cellOf(double x, double y, bool clamp = false) const
+  {
+    const double fx = std::floor((x - origin_x_) / cell_size_);
+    const double fy = std::floor((y - origin_y_) / cell_size_);
+
+    if (!(fx >= 0 && fy >= 0) || size() == 0) {
+      return -1;
+    }
+
+    int64_t c = static_cast<int64_t>(fx), r = static_cast<int64_t>(fy);
+
+    if (clamp) {
+      c = (c == cols_) ? c - 1 : c;
+      r = (r == rows_) ? r - 1 : r;
+    }
+
+    return (c < cols_ && r < rows_) ? r * cols_ + c : -1;
+  }
+
+  float value(const std::vector<float> & cells, double x, double y) const
+  {
+    const int64_t cell = cellOf(x, y);
+
+    return cell < 0 ? std::numeric_limits<float>::quiet_NaN() : cells[cell];
+  }
+
+  template <class T>
+  static void write(std::ofstream & file, T value)
+  {
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  // A directory entry, whose value is inlined (left justified) or the offset of its data
+  static void writeTag(
+    std::ofstream & file, uint16_t tag, uint16_t type, uint32_t count, uint32_t value)
+  {
+    write(file, tag);
+    write(file, type);
+    write(file, count);
+
+    if (type == 3 && count == 1) {
+      write(file, static_cast<uint16_t>(value));
+      write(file, uint16_t{0});
+    } else {
+      write(file, value);
+    }
+  }
+
+  double origin_x_, origin_y_, cell_size_;
+  uint32_t cols_, rows_;
+  std::vector<float> min_, median_;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__HEIGHT_MAP_HPP_
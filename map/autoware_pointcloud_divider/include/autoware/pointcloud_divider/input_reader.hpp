@@ -0,0 +1,100 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__INPUT_READER_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__INPUT_READER_HPP_
+
+#include "las_io_reader.hpp"
+#include "pcd_io_reader.hpp"
+
+#include <pcl/point_cloud.h>
+
+#include <string>
+
+namespace autoware::pointcloud_divider
+{
+
+// Reader of the input files of the divider. Each file is read by CustomPCDReader or LASReader
+// depending on its extension, through their common interface.
+template <typename PointT>
+class InputReader
+{
+  typedef pcl::PointCloud<PointT> PclCloudType;
+
+public:
+  void setInput(const std::string & path)
+  {
+    las_ = isLASFile(path);
+
+    if (las_) {
+      las_reader_.setInput(path);
+    } else {
+      pcd_reader_.setInput(path);
+    }
+  }
+
+  void setRange(size_t begin, size_t end)
+  {
+    if (las_) {
+      las_reader_.setRange(begin, end);
+    } else {
+      pcd_reader_.setRange(begin, end);
+    }
+  }
+
+  size_t readABlock(PclCloudType & output)
+  {
+    return las_ ? las_reader_.readABlock(output) : pcd_reader_.readABlock(output);
+  }
+
+  void setLAZCommand(const std::string & laz_command) { las_reader_.setLAZCommand(laz_command); }
+
+  // io_uring backend of the PCD reader, the LAS and LAZ inputs are read as they are
+  void setAsyncIO(const AsyncIOOptions & options) { pcd_reader_.setAsyncIO(options); }
+
+  const std::string & get_path() const
+  {
+    return las_ ? las_reader_.get_path() : pcd_reader_.get_path();
+  }
+
+  bool supportsRange() const
+  {
+    return las_ ? las_reader_.supportsRange() : pcd_reader_.supportsRange();
+  }
+
+  size_t rangeLength() const
+  {
+    return las_ ? las_reader_.rangeLength() : pcd_reader_.rangeLength();
+  }
+
+  size_t rangeStep() const { return las_ ? las_reader_.rangeStep() : pcd_reader_.rangeStep(); }
+
+  size_t rangePosition() const
+  {
+    return las_ ? las_reader_.rangePosition() : pcd_reader_.rangePosition();
+  }
+
+  bool good() { return las_ ? las_reader_.good() : pcd_reader_.good(); }
+
+  size_t point_num() { return las_ ? las_reader_.point_num() : pcd_reader_.point_num(); }
+
+private:
+  CustomPCDReader<PointT> pcd_reader_;
+  LASReader<PointT> las_reader_;
+  bool las_ = false;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__INPUT_READER_HPP_
@@ -0,0 +1,462 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__LAS_IO_READER_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__LAS_IO_READER_HPP_
+
+#include "point_field_traits.hpp"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// True if @path has the extension of a LAS or LAZ file
+inline bool isLASFile(const std::string & path)
+{
+  auto dot_pos = path.rfind('.');
+
+  if (dot_pos == std::string::npos) {
+    return false;
+  }
+
+  auto extension = path.substr(dot_pos);
+
+  return extension == ".las" || extension == ".LAS" || extension == ".laz" || extension == ".LAZ";
+}
+
+// Reader of LAS 1.0 to 1.4 files with the point data record formats 0 to 10, with the same
+// interface as CustomPCDReader. The coordinates are scaled and offset as in the header, the
+// intensity is copied as it is, and the 16-bit colors are reduced to 8 bits. The other fields of
+// PointT are set to 0.
+//
+// Uncompressed files are mapped to memory and can be read by ranges of points. LAZ files are
+// streamed from the standard output of a decompressor, "laszip -i {file} -olas -stdout" by
+// default, so they are neither converted on the disk nor read by ranges.
+template <typename PointT>
+class LASReader
+{
+  typedef pcl::PointCloud<PointT> PclCloudType;
+
+public:
+  LASReader() = default;
+  LASReader(const LASReader &) = delete;
+  LASReader & operator=(const LASReader &) = delete;
+
+  ~LASReader() { clear(); }
+
+  // Set a file to reading
+  void setInput(const std::string & las_path);
+  // Limit the reading to the points [@begin, @end). Only valid if supportsRange() is true.
+  void setRange(size_t begin, size_t end)
+  {
+    end_point_num_ = std::min(end, point_num_);
+    loaded_point_num_ = std::min(begin, end_point_num_);
+    good_ = loaded_point_num_ < end_point_num_;
+  }
+
+  // Read a block of points from the input
+  size_t readABlock(PclCloudType & output);
+
+  // Command decompressing a LAZ file to a LAS stream on its standard output, where {file} is
+  // replaced by the quoted path of the file. An empty command keeps the default one.
+  void setLAZCommand(const std::string & laz_command)
+  {
+    if (!laz_command.empty()) {
+      laz_command_ = laz_command;
+    }
+  }
+
+  const std::string & get_path() const { return las_path_; }
+
+  void setBlockSize(size_t block_size) { block_size_ = block_size; }
+
+  size_t block_size() const { return block_size_; }
+
+  bool supportsRange() const { return mapped_data_ != nullptr; }
+
+  size_t rangeLength() const { return point_num_; }
+
+  size_t rangeStep() const { return block_size_; }
+
+  size_t rangePosition() const { return loaded_point_num_; }
+
+  bool good() const { return good_; }
+
+  size_t point_num() const { return point_num_; }
+
+private:
+  // Fields of the public header block used to decode the points
+  struct Header
+  {
+    size_t data_offset = 0;
+    uint8_t format = 0;
+    bool compressed = false;
+    size_t record_length = 0;
+    size_t point_num = 0;
+    std::array<double, 3> scale = {1, 1, 1};
+    std::array<double, 3> offset = {0, 0, 0};
+  };
+
+  // Sources of the fields of PointT in a point record
+  enum class FieldSource { X, Y, Z, INTENSITY, RGB, ZERO };
+
+  // Size of the header fields up to the offsets and scales, which every version has
+  static constexpr size_t min_header_size_ = 227;
+  // Number of records read from the decompressor at once
+  static constexpr size_t stream_chunk_size_ = 65536;
+
+  template <typename T>
+  static T readLE(const char * data)
+  {
+    T value;
+
+    memcpy(&value, data, sizeof(T));
+
+    return value;
+  }
+
+  // Return false with the reason in @error if @data is not the header of a supported file
+  static bool parseHeader(const char * data, size_t size, Header & header, std::string & error);
+  [[noreturn]] void fail(const std::string & error) const
+  {
+    fprintf(stderr, "Error: Cannot read %s: %s\n", las_path_.c_str(), error.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  // Start the decompressor, and skip the header of its output
+  void openStream();
+  void decode(const char * input, size_t point_num, PointT * output) const;
+
+  void clear()
+  {
+    if (mapped_data_) {
+      munmap(const_cast<char *>(mapped_data_), mapped_size_);
+      mapped_data_ = nullptr;
+    }
+
+    if (stream_) {
+      pclose(stream_);
+      stream_ = nullptr;
+    }
+
+    mapped_size_ = 0;
+    point_num_ = loaded_point_num_ = end_point_num_ = 0;
+    good_ = false;
+  }
+
+  std::string las_path_;
+  std::string laz_command_ = "laszip -i {file} -olas -stdout";
+  Header header_;
+  std::array<FieldSource, PointFieldTraits<PointT>::size> sources_{};
+  size_t rgb_offset_ = 0;
+  const char * mapped_data_ = nullptr;
+  size_t mapped_size_ = 0;
+  // Output of the decompressor of a LAZ file, opened at the first block
+  FILE * stream_ = nullptr;
+  std::vector<char> buffer_;
+  size_t point_num_ = 0, loaded_point_num_ = 0, end_point_num_ = 0;
+  size_t block_size_ = 30000000;  // Number of points to read in each readABlock
+  bool good_ = false;
+};
+
+template <typename PointT>
+bool LASReader<PointT>::parseHeader(
+  const char * data, size_t size, Header & header, std::string & error)
+{
+  // Minimum record length of each point data record format
+  static constexpr std::array<size_t, 11> record_lengths = {20, 28, 26, 34, 57, 63,
+                                                            30, 36, 38, 59, 67};
+
+  if (size < min_header_size_ || memcmp(data, "LASF", 4) != 0) {
+    error = "not a LAS file";
+    return false;
+  }
+
+  const uint8_t version_minor = readLE<uint8_t>(data + 25);
+  const uint8_t format_byte = readLE<uint8_t>(data + 104);
+
+  header.data_offset = readLE<uint32_t>(data + 96);
+  // LAZ files set the two high bits of the format
+  header.format = format_byte & 0x3F;
+  header.compressed = (format_byte & 0xC0) != 0;
+  header.record_length = readLE<uint16_t>(data + 105);
+  header.point_num = readLE<uint32_t>(data + 107);
+
+  // LAS 1.4 counts the points with 64 bits, and sets the legacy count to 0 beyond 32 bits
+  if (version_minor >= 4 && size >= 255) {
+    header.point_num = readLE<uint64_t>(data + 247);
+  }
+
+  for (size_t i = 0; i < 3; ++i) {
+    header.scale[i] = readLE<double>(data + 131 + i * 8);
+    header.offset[i] = readLE<double>(data + 155 + i * 8);
+  }
+
+  if (header.format >= record_lengths.size()) {
+    error = "unsupported point data record format " + std::to_string(header.format);
+    return false;
+  }
+
+  if (header.record_length < record_lengths[header.format]) {
+    error = "the point records are shorter than their format";
+    return false;
+  }
+
+  return true;
+}
+
+template <typename PointT>
+void LASReader<PointT>::setInput(const std::string & las_path)
+{
+  using Traits = PointFieldTraits<PointT>;
+
+  clear();
+  las_path_ = las_path;
+
+  int fd = open(las_path.c_str(), O_RDONLY);
+  struct stat file_stat;
+
+  if (fd < 0 || fstat(fd, &file_stat) != 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+
+    fail("cannot open the file");
+  }
+
+  // The header of a LAZ file is not compressed, so the points are counted without decompressing
+  std::vector<char> header_data(375);
+  auto header_size = pread(fd, header_data.data(), header_data.size(), 0);
+  std::string error;
+
+  if (header_size < 0 || !parseHeader(header_data.data(), header_size, header_, error)) {
+    close(fd);
+    fail(error);
+  }
+
+  const size_t file_size = file_stat.st_size;
+  const bool laz = header_.compressed || las_path.back() == 'z' || las_path.back() == 'Z';
+
+  point_num_ = header_.point_num;
+
+  if (!laz && header_.data_offset <= file_size) {
+    // Ignore the points beyond the end of a truncated file
+    point_num_ = std::min(point_num_, (file_size - header_.data_offset) / header_.record_length);
+
+    void * addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (addr != MAP_FAILED) {
+      madvise(addr, file_size, MADV_SEQUENTIAL);
+      mapped_data_ = static_cast<const char *>(addr);
+      mapped_size_ = file_size;
+    }
+  }
+
+  close(fd);
+
+  if (!laz && !mapped_data_) {
+    fail("cannot map the file");
+  }
+
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    const std::string name = Traits::names[fid];
+
+    sources_[fid] = name == "x"           ? FieldSource::X
+                    : name == "y"         ? FieldSource::Y
+                    : name == "z"         ? FieldSource::Z
+                    : name == "intensity" ? FieldSource::INTENSITY
+                    : name == "rgb"       ? FieldSource::RGB
+                                          : FieldSource::ZERO;
+  }
+
+  // Offset of the colors in the record, 0 for the formats without colors
+  static constexpr std::array<size_t, 11> rgb_offsets = {0, 0, 20, 28, 0, 28, 0, 30, 30, 0, 30};
+
+  rgb_offset_ = rgb_offsets[header_.format];
+  end_point_num_ = point_num_;
+  good_ = true;
+}
+
+template <typename PointT>
+void LASReader<PointT>::openStream()
+{
+  std::string command = laz_command_;
+  std::string quoted = "'";
+
+  for (char c : las_path_) {
+    quoted += (c == '\'') ? std::string("'\\''") : std::string(1, c);
+  }
+
+  quoted += "'";
+
+  for (size_t pos = command.find("{file}"); pos != std::string::npos;
+       pos = command.find("{file}", pos + quoted.size())) {
+    command.replace(pos, 6, quoted);
+  }
+
+  stream_ = popen(command.c_str(), "r");
+
+  if (!stream_) {
+    fail("cannot run " + command);
+  }
+
+  // The decompressed stream has its own header, without the VLR of the compression
+  std::vector<char> header_data(min_header_size_);
+  Header stream_header;
+  std::string error;
+
+  if (fread(header_data.data(), 1, min_header_size_, stream_) != min_header_size_) {
+    fail("no LAS output from " + command);
+  }
+
+  header_data.resize(std::max<size_t>(readLE<uint32_t>(header_data.data() + 96), min_header_size_));
+
+  const size_t rest_size = header_data.size() - min_header_size_;
+
+  if (
+    fread(header_data.data() + min_header_size_, 1, rest_size, stream_) != rest_size ||
+    !parseHeader(header_data.data(), header_data.size(), stream_header, error) ||
+    stream_header.format != header_.format ||
+    stream_header.record_length != header_.record_length) {
+    fail("unexpected LAS output from " + command + (error.empty() ? "" : ": " + error));
+  }
+
+  header_ = stream_header;
+}
+
+template <typename PointT>
+size_t LASReader<PointT>::readABlock(PclCloudType & output)
+{
+  output.clear();
+
+  if (!good_) {
+    return 0;
+  }
+
+  const size_t proc_num = std::min(block_size_, end_point_num_ - loaded_point_num_);
+  const size_t record_length = header_.record_length;
+
+  if (mapped_data_) {
+    output.resize(proc_num);
+    decode(
+      mapped_data_ + header_.data_offset + loaded_point_num_ * record_length, proc_num,
+      output.points.data());
+    loaded_point_num_ += proc_num;
+    good_ = loaded_point_num_ < end_point_num_;
+
+    return proc_num * record_length;
+  }
+
+  if (!stream_) {
+    openStream();
+  }
+
+  buffer_.resize(stream_chunk_size_ * record_length);
+  output.resize(proc_num);
+
+  size_t read_num = 0;
+
+  while (read_num < proc_num) {
+    const size_t chunk_num = std::min(stream_chunk_size_, proc_num - read_num);
+    const size_t got_num = fread(buffer_.data(), record_length, chunk_num, stream_);
+
+    decode(buffer_.data(), got_num, output.points.data() + read_num);
+    read_num += got_num;
+
+    if (got_num < chunk_num) {
+      fprintf(
+        stderr, "Warning: %s ended after %lu of its %lu points\n", las_path_.c_str(),
+        loaded_point_num_ + read_num, point_num_);
+      end_point_num_ = loaded_point_num_ + read_num;
+      output.resize(read_num);
+      break;
+    }
+  }
+
+  loaded_point_num_ += read_num;
+  good_ = loaded_point_num_ < end_point_num_;
+
+  if (!good_) {
+    pclose(stream_);
+    stream_ = nullptr;
+  }
+
+  return read_num * record_length;
+}
+
+template <typename PointT>
+void LASReader<PointT>::decode(const char * input, size_t point_num, PointT * output) const
+{
+  using Traits = PointFieldTraits<PointT>;
+
+  const size_t record_length = header_.record_length;
+
+  for (size_t i = 0; i < point_num; ++i) {
+    const char * record = input + i * record_length;
+    PointT & p = output[i];
+
+    for (size_t fid = 0; fid < Traits::size; ++fid) {
+      float * field = fieldPtr(p, fid);
+
+      switch (sources_[fid]) {
+        case FieldSource::X:
+        case FieldSource::Y:
+        case FieldSource::Z: {
+          const size_t axis = static_cast<size_t>(sources_[fid]);
+
+          *field = static_cast<float>(
+            readLE<int32_t>(record + axis * 4) * header_.scale[axis] + header_.offset[axis]);
+          break;
+        }
+        case FieldSource::INTENSITY:
+          *field = readLE<uint16_t>(record + 12);
+          break;
+        case FieldSource::RGB: {
+          uint32_t rgb = 0xFF000000u;
+
+          if (rgb_offset_ > 0) {
+            rgb |= static_cast<uint32_t>(readLE<uint16_t>(record + rgb_offset_) >> 8) << 16;
+            rgb |= static_cast<uint32_t>(readLE<uint16_t>(record + rgb_offset_ + 2) >> 8) << 8;
+            rgb |= static_cast<uint32_t>(readLE<uint16_t>(record + rgb_offset_ + 4) >> 8);
+          }
+
+          memcpy(field, &rgb, sizeof(rgb));
+          break;
+        }
+        default:
+          *field = 0;
+      }
+    }
+  }
+}
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__LAS_IO_READER_HPP_
@@ -0,0 +1,68 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__MAPPED_REGION_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__MAPPED_REGION_HPP_
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <utility>
+
+namespace autoware::pointcloud_divider
+{
+
+// A read-only mapping of a file, unmapped when it is reset or destroyed. It is moved, never
+// copied, so a mapping is unmapped once.
+class MappedRegion
+{
+public:
+  MappedRegion() = default;
+  MappedRegion(const MappedRegion &) = delete;
+  MappedRegion & operator=(const MappedRegion &) = delete;
+  MappedRegion(MappedRegion && other) noexcept
+  : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0))
+  {
+  }
+  MappedRegion & operator=(MappedRegion && other) noexcept
+  {
+    if (this != &other) {
+      reset(std::exchange(other.data_, nullptr), std::exchange(other.size_, 0));
+    }
+
+    return *this;
+  }
+  ~MappedRegion() { reset(); }
+
+  void reset(const char * data = nullptr, size_t size = 0)
+  {
+    if (data_) {
+      munmap(const_cast<char *>(data_), size_);
+    }
+
+    data_ = data;
+    size_ = size;
+  }
+
+  const char * data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const char * data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__MAPPED_REGION_HPP_
@@ -0,0 +1,127 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__MORTON_ORDER_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__MORTON_ORDER_HPP_
+
+#include <pcl/point_cloud.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Number of bits of each coordinate in a 3D Morton code
+constexpr int MORTON_BITS = 21;
+
+// Insert two zero bits between the low 21 bits of @v
+inline uint64_t spreadMortonBits(uint64_t v)
+{
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffffULL;
+  v = (v | v << 16) & 0x1f0000ff0000ffULL;
+  v = (v | v << 8) & 0x100f00f00f00f00fULL;
+  v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+  v = (v | v << 2) & 0x1249249249249249ULL;
+
+  return v;
+}
+
+// Interleave the bits of the cell coordinates, x being the lowest one
+inline uint64_t mortonCode(uint32_t x, uint32_t y, uint32_t z)
+{
+  return spreadMortonBits(x) | (spreadMortonBits(y) << 1) | (spreadMortonBits(z) << 2);
+}
+
+// Reorder the points of @cloud along the Z-order curve of their bounding box, so the points
+// close in space are close in the file. The box is divided into 2^21 cubic cells along its
+// longest side, which is finer than any useful leaf size, and the points of a cell keep their
+// order. Non-finite points are moved to the end.
+template <typename PointT>
+void sortByMortonCode(pcl::PointCloud<PointT> & cloud)
+{
+  if (cloud.size() < 2) {
+    return;
+  }
+
+  float min_p[3] = {
+    std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+    std::numeric_limits<float>::max()};
+  float max_p[3] = {
+    std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+    std::numeric_limits<float>::lowest()};
+
+  for (const auto & p : cloud) {
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+      continue;
+    }
+
+    const float xyz[3] = {p.x, p.y, p.z};
+
+    for (int i = 0; i < 3; ++i) {
+      min_p[i] = std::min(min_p[i], xyz[i]);
+      max_p[i] = std::max(max_p[i], xyz[i]);
+    }
+  }
+
+  double extent = 0;
+
+  for (int i = 0; i < 3; ++i) {
+    extent = std::max(extent, static_cast<double>(max_p[i]) - min_p[i]);
+  }
+
+  const double max_cell = static_cast<double>((1u << MORTON_BITS) - 1);
+  const double scale = extent > 0 ? max_cell / extent : 0;
+
+  // The code of a point and its index in the input
+  std::vector<std::pair<uint64_t, size_t>> keys(cloud.size());
+
+  for (size_t i = 0; i < cloud.size(); ++i) {
+    const auto & p = cloud[i];
+
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+      keys[i] = {std::numeric_limits<uint64_t>::max(), i};
+      continue;
+    }
+
+    auto cell = [&](float v, int axis) {
+      return static_cast<uint32_t>(
+        std::min(max_cell, (static_cast<double>(v) - min_p[axis]) * scale));
+    };
+
+    keys[i] = {mortonCode(cell(p.x, 0), cell(p.y, 1), cell(p.z, 2)), i};
+  }
+
+  std::sort(keys.begin(), keys.end());
+
+  typename pcl::PointCloud<PointT>::VectorType sorted;
+
+  sorted.reserve(cloud.size());
+
+  for (const auto & key : keys) {
+    sorted.push_back(cloud[key.second]);
+  }
+
+  cloud.points.swap(sorted);
+}
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__MORTON_ORDER_HPP_
@@ -0,0 +1,221 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__NDT_VOXELS_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__NDT_VOXELS_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Means and covariances of the points of a segment in the voxels of an NDT resolution, written
+// next to the segment PCD, so that a localizer paging in the segment does not have to compute
+// them from the points. Like tile_index.hpp, it has no dependency other than the standard
+// library. The voxels are aligned to the origin of the map, as in the voxel grid of NDT, so the
+// resolution should divide the grid size for every voxel to belong to a single segment.
+//
+// Layout (little endian):
+//   char[8]     magic "PCDNDTV1"
+//   double      resolution
+//   uint32      minimum number of points of the voxels written
+//   uint64      number of voxels, followed by the NDTVoxels, sorted by (iz, iy, ix)
+
+struct NDTVoxel
+{
+  int32_t ix, iy, iz;  // floor(p / resolution)
+  uint32_t point_num;
+  double mean[3];
+  float cov[6];  // Sample covariance xx, xy, xz, yy, yz, zz
+};
+
+static_assert(sizeof(NDTVoxel) == 64, "NDTVoxel must be packed for the binary voxels");
+
+class NDTVoxelGrid
+{
+public:
+  // The default minimum number of points is the one of the voxel grid of NDT
+  explicit NDTVoxelGrid(double resolution = 1.0, uint32_t min_point_num = 6)
+  : resolution_(resolution), min_point_num_(std::max<uint32_t>(min_point_num, 1))
+  {
+  }
+
+  // Fold the points of @cloud, which only need x, y, and z, into the moments of their voxels,
+  // so a segment may be added block by block. The moments are the sums of the differences to
+  // the first point of the voxel, to keep the precision of large coordinates.
+  template <class CloudT>
+  void add(const CloudT & cloud)
+  {
+    for (const auto & p : cloud) {
+      if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+        continue;
+      }
+
+      const std::array<int32_t, 3> index = {
+        static_cast<int32_t>(std::floor(p.x / resolution_)),
+        static_cast<int32_t>(std::floor(p.y / resolution_)),
+        static_cast<int32_t>(std::floor(p.z / resolution_))};
+      auto & m = moments_[key(index)];
+
+      if (m.point_num == 0) {
+        m.index = index;
+        m.first = {p.x, p.y, p.z};
+      }
+
+      const double d[3] = {p.x - m.first[0], p.y - m.first[1], p.z - m.first[2]};
+
+      for (int i = 0, k = 0; i < 3; ++i) {
+        m.sum[i] += d[i];
+
+        for (int j = i; j < 3; ++j) {
+          m.sum_sq[k++] += d[i] * d[j];
+        }
+      }
+
+      ++m.point_num;
+    }
+  }
+
+  // The voxels of at least the minimum number of points, sorted by (iz, iy, ix)
+  std::vector<NDTVoxel> voxels() const
+  {
+    std::vector<NDTVoxel> output;
+
+    for (const auto & it : moments_) {
+      const auto & m = it.second;
+
+      if (m.point_num < min_point_num_) {
+        continue;
+      }
+
+      NDTVoxel voxel{};
+      const double n = m.point_num;
+      double mean_diff[3];
+
+      voxel.ix = m.index[0];
+      voxel.iy = m.index[1];
+      voxel.iz = m.index[2];
+      voxel.point_num = m.point_num;
+
+      for (int i = 0; i < 3; ++i) {
+        mean_diff[i] = m.sum[i] / n;
+        voxel.mean[i] = m.first[i] + mean_diff[i];
+      }
+
+      // The localizer regularizes the degenerate covariances, as for the voxels it computes
+      for (int i = 0, k = 0; i < 3; ++i) {
+        for (int j = i; j < 3; ++j, ++k) {
+          voxel.cov[k] =
+            n > 1 ? (m.sum_sq[k] - n * mean_diff[i] * mean_diff[j]) / (n - 1) : 0;
+        }
+      }
+
+      output.push_back(voxel);
+    }
+
+    std::sort(output.begin(), output.end(), [](const NDTVoxel & a, const NDTVoxel & b) {
+      return std::tie(a.iz, a.iy, a.ix) < std::tie(b.iz, b.iy, b.ix);
+    });
+
+    return output;
+  }
+
+  bool save(const std::string & path) const
+  {
+    const auto output = voxels();
+    std::ofstream file(path, std::ios::binary);
+    uint64_t voxel_num = output.size();
+
+    file.write("PCDNDTV1", 8);
+    file.write(reinterpret_cast<const char *>(&resolution_), sizeof(resolution_));
+    file.write(reinterpret_cast<const char *>(&min_point_num_), sizeof(min_point_num_));
+    file.write(reinterpret_cast<const char *>(&voxel_num), sizeof(voxel_num));
+    file.write(reinterpret_cast<const char *>(output.data()), voxel_num * sizeof(NDTVoxel));
+
+    return static_cast<bool>(file);
+  }
+
+  // Read the voxels of a file written by save(). Return false if it is not an NDT voxel file.
+  static bool load(const std::string & path, double & resolution, std::vector<NDTVoxel> & voxels)
+  {
+    std::ifstream file(path, std::ios::binary);
+    char magic[8];
+    uint32_t min_point_num = 0;
+    uint64_t voxel_num = 0;
+
+    file.read(magic, sizeof(magic));
+
+    if (!file || memcmp(magic, "PCDNDTV1", sizeof(magic)) != 0) {
+      return false;
+    }
+
+    file.read(reinterpret_cast<char *>(&resolution), sizeof(resolution));
+    file.read(reinterpret_cast<char *>(&min_point_num), sizeof(min_point_num));
+    file.read(reinterpret_cast<char *>(&voxel_num), sizeof(voxel_num));
+
+    if (!file) {
+      return false;
+    }
+
+    voxels.resize(voxel_num);
+    file.read(reinterpret_cast<char *>(voxels.data()), voxel_num * sizeof(NDTVoxel));
+
+    return static_cast<bool>(file);
+  }
+
+  double resolution() const { return resolution_; }
+  uint32_t minPointNum() const { return min_point_num_; }
+  // Number of occupied voxels, including the ones of too few points to be written
+  size_t size() const { return moments_.size(); }
+  void clear() { moments_.clear(); }
+
+private:
+  struct Moments
+  {
+    std::array<int32_t, 3> index{};
+    std::array<double, 3> first{};
+    double sum[3] = {0, 0, 0};
+    double sum_sq[6] = {0, 0, 0, 0, 0, 0};
+    uint32_t point_num = 0;
+  };
+
+  // 21 bits per axis, which spans +-1M voxels around the origin of the map
+  static uint64_t key(const std::array<int32_t, 3> & index)
+  {
+    uint64_t k = 0;
+
+    for (auto i : index) {
+      k = (k << 21) | ((static_cast<uint32_t>(i) + (1U << 20)) & 0x1FFFFFU);
+    }
+
+    return k;
+  }
+
+  double resolution_;
+  uint32_t min_point_num_;
+  std::unordered_map<uint64_t, Moments> moments_;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__NDT_VOXELS_HPP_
@@ -0,0 +1,183 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__OUTPUT_SINK_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__OUTPUT_SINK_HPP_
+
+#include "bounded_queue.hpp"
+#include "run_report.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Destination of the map files. The files are written to the output directory first, and each
+// one is handed to the sink as soon as it is finished, so the sink can publish it while the rest
+// of the map is still being finalized.
+class OutputSink
+{
+public:
+  virtual ~OutputSink() = default;
+
+  // Publish the finished file at @local_path, whose path relative to the output directory is @key
+  virtual void publish(const std::string & local_path, const std::string & key) = 0;
+
+  // Wait until the files published so far are done. Return false if any of them failed.
+  virtual bool flush() = 0;
+
+  // Time the publication in the "upload" phase of @report
+  void setReport(RunReport * report) { report_ = report; }
+
+protected:
+  RunReport * report_ = nullptr;
+};
+
+// The files stay in the output directory, which is the default
+class LocalOutputSink : public OutputSink
+{
+public:
+  void publish(const std::string &, const std::string &) override {}
+
+  bool flush() override { return true; }
+};
+
+// Sink running a shell command for every file, e.g. "aws s3 cp {file} s3://bucket/map/{key}" to
+// upload the map to an object storage. {file} is replaced by the local path and {key} by the
+// relative path, both quoted. The commands run on a pool of threads, so several files are
+// uploaded at the same time, and a failed command is tried again up to @attempt_num times.
+class CommandOutputSink : public OutputSink
+{
+public:
+  CommandOutputSink(const std::string & command, size_t thread_num, size_t attempt_num = 3)
+  : command_(command), attempt_num_(std::max<size_t>(attempt_num, 1)), queue_(1024)
+  {
+    for (size_t i = 0; i < std::max<size_t>(thread_num, 1); ++i) {
+      uploaders_.emplace_back([this]() {
+        std::pair<std::string, std::string> file;
+
+        while (queue_.pop(file)) {
+          const bool ok = upload(file.first, file.second);
+
+          {
+            std::lock_guard<std::mutex> lock(mtx_);
+
+            failed_ = failed_ || !ok;
+            --pending_num_;
+          }
+
+          done_cv_.notify_all();
+        }
+      });
+    }
+  }
+
+  ~CommandOutputSink() override
+  {
+    queue_.close();
+
+    for (auto & uploader : uploaders_) {
+      uploader.join();
+    }
+  }
+
+  void publish(const std::string & local_path, const std::string & key) override
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      ++pending_num_;
+    }
+
+    queue_.push(std::make_pair(local_path, key));
+  }
+
+  bool flush() override
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+
+    done_cv_.wait(lock, [this]() { return pending_num_ == 0; });
+
+    return !failed_;
+  }
+
+private:
+  bool upload(const std::string & local_path, const std::string & key)
+  {
+    RunReport::PhaseTimer timer(report_, "upload");
+    std::string command = command_;
+
+    replaceAll(command, "{file}", quote(local_path));
+    replaceAll(command, "{key}", quote(key));
+
+    for (size_t attempt = 0; attempt < attempt_num_; ++attempt) {
+      if (std::system(command.c_str()) == 0) {
+        if (report_) {
+          report_->addBytes("upload", std::filesystem::file_size(local_path));
+        }
+
+        return true;
+      }
+    }
+
+    std::cerr << "Error: Failed to publish " << local_path << " with " << command << std::endl;
+
+    return false;
+  }
+
+  // Single-quote @s for the shell
+  static std::string quote(const std::string & s)
+  {
+    std::string quoted = "'";
+
+    for (char c : s) {
+      if (c == '\'') {
+        quoted += "'\\''";
+      } else {
+        quoted += c;
+      }
+    }
+
+    return quoted + "'";
+  }
+
+  static void replaceAll(std::string & s, const std::string & from, const std::string & to)
+  {
+    for (size_t pos = s.find(from); pos != std::string::npos; pos = s.find(from, pos + to.size())) {
+      s.replace(pos, from.size(), to);
+    }
+  }
+
+  std::string command_;
+  size_t attempt_num_;
+  // Files waiting for an uploader, as pairs of the local path and the key
+  BoundedQueue<std::pair<std::string, std::string>> queue_;
+  std::vector<std::thread> uploaders_;
+  std::mutex mtx_;
+  std::condition_variable done_cv_;
+  size_t pending_num_ = 0;
+  bool failed_ = false;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__OUTPUT_SINK_HPP_
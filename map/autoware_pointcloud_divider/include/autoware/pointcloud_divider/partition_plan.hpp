@@ -0,0 +1,393 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__PARTITION_PLAN_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__PARTITION_PLAN_HPP_
+
+#include "grid_info.hpp"
+#include "output_sink.hpp"
+#include "tile_index.hpp"
+
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Assignment of the large grids of a map to the machines of a distributed divide. The
+// coordinator scans the inputs once and writes the plan, then every worker divides the points
+// of its large grids into its own output directory, reading only the inputs that have points in
+// them. The large grids of the workers are disjoint, so their segments never overlap and the
+// outputs are merged by moving the files and concatenating the metadata.
+struct PartitionPlan
+{
+  // An input and the large grids it has points in
+  struct Input
+  {
+    std::string path;
+    std::vector<GridInfo<2>> cells;
+  };
+
+  // The large grids of a worker, and their number of points
+  struct Worker
+  {
+    std::vector<GridInfo<2>> cells;
+    size_t point_num = 0;
+  };
+
+  double g_grid_size_x = 0, g_grid_size_y = 0;
+  std::vector<Worker> workers;
+  std::vector<Input> inputs;
+
+  // Split the large grids into @worker_num runs of consecutive grids along the Morton curve,
+  // with about the same number of points each, so a worker gets a compact area of the map and
+  // reads few inputs
+  void assign(const std::unordered_map<GridInfo<2>, size_t> & cell_points, size_t worker_num)
+  {
+    std::vector<std::pair<uint64_t, GridInfo<2>>> cells;
+    size_t total_point_num = 0;
+
+    for (const auto & cell : cell_points) {
+      cells.emplace_back(mortonCode(cell.first.ix, cell.first.iy), cell.first);
+      total_point_num += cell.second;
+    }
+
+    std::sort(cells.begin(), cells.end(), [](const auto & a, const auto & b) {
+      return a.first < b.first;
+    });
+
+    workers.assign(std::max<size_t>(worker_num, 1), Worker());
+
+    size_t w = 0, point_num = 0;
+
+    for (const auto & cell : cells) {
+      // Move to the next worker once this one has its share of the points, leaving at least a
+      // grid to each remaining worker if possible
+      while (w + 1 < workers.size() && !workers[w].cells.empty() &&
+             point_num >= total_point_num * (w + 1) / workers.size()) {
+        ++w;
+      }
+
+      const size_t n = cell_points.at(cell.second);
+
+      workers[w].cells.push_back(cell.second);
+      workers[w].point_num += n;
+      point_num += n;
+    }
+  }
+
+  // Inputs having points in the large grids of the worker @worker_id, and with @adjacent, in
+  // the large grids next to them
+  std::vector<std::string> workerInputs(size_t worker_id, bool adjacent = false) const
+  {
+    std::vector<std::string> paths;
+
+    if (worker_id >= workers.size()) {
+      return paths;
+    }
+
+    auto owned = workerCells(worker_id);
+
+    if (adjacent) {
+      for (const auto & cell : workers[worker_id].cells) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          for (int dy = -1; dy <= 1; ++dy) {
+            owned.emplace(cell.ix + dx, cell.iy + dy);
+          }
+        }
+      }
+    }
+
+    for (const auto & input : inputs) {
+      auto owns = [&owned](const GridInfo<2> & cell) { return owned.count(cell) > 0; };
+
+      if (std::any_of(input.cells.begin(), input.cells.end(), owns)) {
+        paths.push_back(input.path);
+      }
+    }
+
+    return paths;
+  }
+
+  std::unordered_set<GridInfo<2>> workerCells(size_t worker_id) const
+  {
+    if (worker_id >= workers.size()) {
+      return {};
+    }
+
+    return std::unordered_set<GridInfo<2>>(
+      workers[worker_id].cells.begin(), workers[worker_id].cells.end());
+  }
+
+  bool save(const std::string & path) const
+  {
+    YAML::Emitter out;
+
+    out << YAML::BeginMap;
+    out << YAML::Key << "large_grid_size" << YAML::Value << YAML::Flow << YAML::BeginSeq
+        << g_grid_size_x << g_grid_size_y << YAML::EndSeq;
+    out << YAML::Key << "workers" << YAML::Value << YAML::BeginSeq;
+
+    for (const auto & worker : workers) {
+      out << YAML::BeginMap;
+      out << YAML::Key << "point_num" << YAML::Value << worker.point_num;
+      out << YAML::Key << "cells" << YAML::Value;
+      emitCells(out, worker.cells);
+      out << YAML::EndMap;
+    }
+
+    out << YAML::EndSeq;
+    out << YAML::Key << "inputs" << YAML::Value << YAML::BeginSeq;
+
+    for (const auto & input : inputs) {
+      out << YAML::BeginMap;
+      out << YAML::Key << "path" << YAML::Value << input.path;
+      out << YAML::Key << "cells" << YAML::Value;
+      emitCells(out, input.cells);
+      out << YAML::EndMap;
+    }
+
+    out << YAML::EndSeq << YAML::EndMap;
+
+    std::ofstream file(path);
+
+    file << out.c_str() << std::endl;
+
+    return static_cast<bool>(file);
+  }
+
+  // Return false if the file is not a partition plan
+  bool load(const std::string & path)
+  {
+    try {
+      YAML::Node plan = YAML::LoadFile(path);
+
+      g_grid_size_x = plan["large_grid_size"][0].as<double>();
+      g_grid_size_y = plan["large_grid_size"][1].as<double>();
+      workers.clear();
+      inputs.clear();
+
+      for (const auto & node : plan["workers"]) {
+        Worker worker;
+
+        worker.point_num = node["point_num"].as<size_t>();
+        worker.cells = loadCells(node["cells"]);
+        workers.push_back(std::move(worker));
+      }
+
+      for (const auto & node : plan["inputs"]) {
+        inputs.push_back({node["path"].as<std::string>(), loadCells(node["cells"])});
+      }
+    } catch (const YAML::Exception &) {
+      return false;
+    }
+
+    return true;
+  }
+
+private:
+  static void emitCells(YAML::Emitter & out, const std::vector<GridInfo<2>> & cells)
+  {
+    out << YAML::Flow << YAML::BeginSeq;
+
+    for (const auto & cell : cells) {
+      out << YAML::Flow << YAML::BeginSeq << cell.ix << cell.iy << YAML::EndSeq;
+    }
+
+    out << YAML::EndSeq;
+  }
+
+  static std::vector<GridInfo<2>> loadCells(const YAML::Node & node)
+  {
+    std::vector<GridInfo<2>> cells;
+
+    for (const auto & cell : node) {
+      cells.emplace_back(cell[0].as<int>(), cell[1].as<int>());
+    }
+
+    return cells;
+  }
+};
+
+// Merge the outputs of the workers of a distributed divide into @output_dir. The segments and
+// the other files of the map folders are moved, which is a rename when the outputs are on the
+// same file system, and published to @sink. The metadata YAML lists the segments of all workers
+// after the header of the first one, and the tile index is merged if every worker wrote one.
+// They are published after the segments. Return false with @error set if the outputs do not
+// belong to the same map: every worker must have run with the same parameters, as recorded in
+// its pointcloud_map_partition.yaml, and written the same metadata header.
+inline bool mergePartitions(
+  const std::vector<std::string> & worker_dirs, const std::string & output_dir,
+  OutputSink & sink, std::string & error)
+{
+  namespace fs = std::filesystem;
+
+  std::string header, signature;
+  std::ostringstream entries;
+  double grid_size_x = 0, grid_size_y = 0;
+  std::vector<TileRecord> tiles;
+  std::string prefix;
+  bool has_index = true;
+
+  fs::create_directories(output_dir);
+
+  auto publish = [&](const fs::path & path) {
+    sink.publish(path.string(), path.lexically_relative(output_dir).lexically_normal().string());
+  };
+
+  for (size_t w = 0; w < worker_dirs.size(); ++w) {
+    const fs::path worker_dir(worker_dirs[w]);
+    const auto metadata_path = worker_dir / "pointcloud_map_metadata.yaml";
+    const auto info_path = worker_dir / "pointcloud_map_partition.yaml";
+
+    if (!fs::exists(metadata_path) || !fs::exists(info_path)) {
+      error = "Cannot find " + (fs::exists(metadata_path) ? info_path : metadata_path).string();
+      return false;
+    }
+
+    try {
+      const YAML::Node info = YAML::LoadFile(info_path.string());
+      const auto worker_signature = info["signature"].as<std::string>();
+
+      if (w == 0) {
+        YAML::Node metadata = YAML::LoadFile(metadata_path.string());
+
+        grid_size_x = metadata["x_resolution"].as<double>();
+        grid_size_y = metadata["y_resolution"].as<double>();
+        signature = worker_signature;
+      } else if (worker_signature != signature) {
+        error = "The parameters of " + info_path.string() + " differ from the first worker";
+        return false;
+      }
+    } catch (const YAML::Exception & e) {
+      error = "Cannot parse the metadata of " + worker_dir.string() + ": " + e.what();
+      return false;
+    }
+
+    // The segment entries are the top level keys ending with .pcd, the other lines are the
+    // header written by saveGridInfoToYAML
+    std::ifstream metadata_file(metadata_path);
+    std::string line, worker_header;
+
+    while (std::getline(metadata_file, line)) {
+      const auto key = line.substr(0, line.find(':'));
+      const bool is_entry = !key.empty() && key[0] != ' ' && fs::path(key).extension() == ".pcd";
+
+      if (is_entry) {
+        entries << line << "\n";
+      } else {
+        worker_header += line + "\n";
+      }
+    }
+
+    if (w == 0) {
+      header = worker_header;
+    } else if (worker_header != header) {
+      error = "The metadata header of " + metadata_path.string() + " differs from the first worker";
+      return false;
+    }
+
+    TileIndex index;
+
+    if (has_index && index.load((worker_dir / "pointcloud_map_index.bin").string())) {
+      tiles.insert(tiles.end(), index.tiles().begin(), index.tiles().end());
+      prefix = index.prefix();
+    } else {
+      has_index = false;
+    }
+  }
+
+  // Move the map folders, the metadata of the large grids included, once all workers are known
+  // to belong to the same map
+  for (const auto & worker : worker_dirs) {
+    const fs::path worker_dir(worker);
+
+    for (const auto & entry : fs::directory_iterator(worker_dir)) {
+      const auto name = entry.path().filename().string();
+
+      if (!entry.is_directory() || name.rfind("pointcloud_map", 0) != 0) {
+        continue;
+      }
+
+      for (const auto & file : fs::recursive_directory_iterator(entry.path())) {
+        if (!file.is_regular_file()) {
+          continue;
+        }
+
+        const auto target = fs::path(output_dir) / file.path().lexically_relative(worker_dir);
+        std::error_code ec;
+
+        fs::create_directories(target.parent_path());
+        fs::rename(file.path(), target, ec);
+
+        if (ec) {
+          fs::copy_file(file.path(), target, fs::copy_options::overwrite_existing);
+          fs::remove(file.path());
+        }
+
+        publish(target);
+      }
+    }
+  }
+
+  // The metadata is published only after all segments, so the map is never listed incomplete
+  if (!sink.flush()) {
+    error = "Cannot publish the segments of " + output_dir;
+    return false;
+  }
+
+  const auto metadata_path = fs::path(output_dir) / "pointcloud_map_metadata.yaml";
+  std::ofstream metadata_file(metadata_path);
+
+  metadata_file << header << entries.str();
+  metadata_file.close();
+
+  if (!metadata_file) {
+    error = "Cannot write the metadata to " + output_dir;
+    return false;
+  }
+
+  publish(metadata_path);
+
+  const auto index_path = fs::path(output_dir) / "pointcloud_map_index.bin";
+
+  if (has_index) {
+    if (!TileIndex(grid_size_x, grid_size_y, prefix, std::move(tiles)).save(index_path.string())) {
+      error = "Cannot write the tile index to " + index_path.string();
+      return false;
+    }
+
+    publish(index_path);
+  }
+
+  if (!sink.flush()) {
+    error = "Cannot publish the metadata of " + output_dir;
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__PARTITION_PLAN_HPP_
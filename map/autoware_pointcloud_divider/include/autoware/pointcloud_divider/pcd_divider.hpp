@@ -46,9 +46,16 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -56,8 +63,21 @@
 #include <vector>
 
 #define PCL_NO_PRECOMPILE
+#include "bounded_queue.hpp"
 #include "grid_info.hpp"
+#include "grid_table.hpp"
+#include "height_map.hpp"
+#include "input_reader.hpp"
+#include "morton_order.hpp"
+#include "ndt_voxels.hpp"
+#include "output_sink.hpp"
+#include "partition_plan.hpp"
 #include "pcd_io.hpp"
+#include "run_report.hpp"
+#include "spill_chunk.hpp"
+#include "stream_stage.hpp"
+#include "tile_index.hpp"
+#include "voxel_grid_filter.hpp"
 
 #include <rclcpp/rclcpp.hpp>
 
@@ -69,12 +89,93 @@
 namespace autoware::pointcloud_divider
 {
 
+// Policies to select the segment written to the tmp directory when the memory budget is reached
+enum class SpillPolicy {
+  SIZE,         // The largest resident segment
+  BYTES_RECENCY // The segment with most bytes weighted by the time since its last update
+};
+
+// Convert the policy name in the config ("size" or "bytes_recency") to the policy
+inline bool toSpillPolicy(const std::string & name, SpillPolicy & policy)
+{
+  if (name == "size") {
+    policy = SpillPolicy::SIZE;
+  } else if (name == "bytes_recency") {
+    policy = SpillPolicy::BYTES_RECENCY;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+// Encodings of the temporary segments
+enum class SpillEncoding {
+  PCD,                  // Binary PCD
+  QUANTIZED,            // Spill chunk with uint16 coordinates, see spill_chunk.hpp
+  QUANTIZED_COMPRESSED  // LZF compressed spill chunk
+};
+
+// Convert the encoding name in the config ("pcd", "quantized", or "quantized_compressed")
+inline bool toSpillEncoding(const std::string & name, SpillEncoding & encoding)
+{
+  if (name == "pcd") {
+    encoding = SpillEncoding::PCD;
+  } else if (name == "quantized") {
+    encoding = SpillEncoding::QUANTIZED;
+  } else if (name == "quantized_compressed") {
+    encoding = SpillEncoding::QUANTIZED_COMPRESSED;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+// Encodings of the output segments
+enum class TileEncoding {
+  BINARY,             // Binary PCD
+  BINARY_COMPRESSED,  // LZF compressed binary PCD
+  QUANTIZED           // Binary PCD with int16 coordinates relative to the segment center
+};
+
+// Convert the encoding name in the config ("binary", "binary_compressed", or "quantized")
+inline bool toTileEncoding(const std::string & name, TileEncoding & encoding)
+{
+  if (name == "binary") {
+    encoding = TileEncoding::BINARY;
+  } else if (name == "binary_compressed") {
+    encoding = TileEncoding::BINARY_COMPRESSED;
+  } else if (name == "quantized") {
+    encoding = TileEncoding::QUANTIZED;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+inline const char * tileEncodingName(TileEncoding encoding)
+{
+  switch (encoding) {
+    case TileEncoding::BINARY_COMPRESSED:
+      return "binary_compressed";
+    case TileEncoding::QUANTIZED:
+      return "quantized";
+    default:
+      return "binary";
+  }
+}
+
 template <class PointT>
 class PCDDivider
 {
   typedef pcl::PointCloud<PointT> PclCloudType;
   typedef typename PclCloudType::Ptr PclCloudPtr;
-  typedef std::unordered_map<GridInfo<2>, std::tuple<PclCloudType, int, size_t>> GridMapType;
+  // Points of a grid, spill counter, size at the last seg_by_size_ update, and the
+  // number of points binned by the shard when the grid was updated last time
+  typedef std::unordered_map<GridInfo<2>, std::tuple<PclCloudType, int, size_t, size_t>>
+    GridMapType;
   typedef typename GridMapType::iterator GridMapItr;
   typedef std::multimap<size_t, GridMapItr> GridMapSizeType;
   typedef typename GridMapSizeType::iterator GridMapSizeItr;
@@ -83,8 +184,17 @@ public:
   explicit PCDDivider(const rclcpp::Logger & logger) : logger_(logger) {}
 
   // Functions to set input parameters
+  // The input is a PCD, LAS, or LAZ file, or a directory of them
   void setInput(const std::string & input_pcd_or_dir) { input_pcd_or_dir_ = input_pcd_or_dir; }
 
+  // Command decompressing a LAZ input to a LAS stream on its standard output, with {file}
+  // replaced by the path of the input. An empty command keeps the default of LASReader.
+  void setLAZCommand(const std::string & laz_command)
+  {
+    laz_command_ = laz_command;
+    reader_.setLAZCommand(laz_command);
+  }
+
   void setOutputDir(const std::string & output_dir)
   {
     output_dir_ = output_dir;
@@ -105,16 +215,181 @@ public:
   {
     grid_size_x_ = res_x;
     grid_size_y_ = res_y;
-    g_grid_size_x_ = grid_size_x_ * 10;
-    g_grid_size_y_ = grid_size_y_ * 10;
+    g_grid_size_x_ = grid_size_x_ * large_grid_factor_;
+    g_grid_size_y_ = grid_size_y_ * large_grid_factor_;
   }
 
   void setLargeGridMode(bool use_large_grid) { use_large_grid_ = use_large_grid; }
 
+  // Number of segments along each axis of a large grid
+  void setLargeGridFactor(size_t large_grid_factor)
+  {
+    large_grid_factor_ = std::max<size_t>(large_grid_factor, 1);
+    setGridSize(grid_size_x_, grid_size_y_);
+  }
+
   void setLeafSize(float leaf_size) { leaf_size_ = leaf_size; }
 
   void setDebugMode(bool mode) { debug_mode_ = mode; }
 
+  void setVoxelFilterEngine(VoxelFilterEngine engine) { voxel_filter_engine_ = engine; }
+
+  // Bound the voxel accumulators of a dense segment streamed back from the tmp directory to
+  // @max_voxel_num, see VoxelGridFilter::setMaxVoxelNum. Setting to 0 keeps every voxel.
+  void setMaxVoxelNum(size_t max_voxel_num) { max_voxel_num_ = max_voxel_num; }
+
+  // Downsample the points of a grid at @leaf_size_ while binning, before they are spilled, so
+  // the redundant points of overlapping inputs do not reach the tmp directory. Points are
+  // averaged in several steps, so they move slightly within their voxels.
+  void setPreVoxelization(bool pre_voxelize) { pre_voxelize_ = pre_voxelize; }
+
+  // Remove the statistical outliers of every segment after the downsampling, by the distances
+  // to their @mean_k nearest neighbors, beyond @stddev_mul standard deviations of the segment.
+  // The neighbors are searched in the segment and the points of the adjacent segments within
+  // @halo meters of it, so the segments are filtered in parallel as one map. The halos are
+  // read from the tmp directory, which disables the in-memory mode. Setting @mean_k to 0
+  // disables the outlier removal.
+  void setOutlierRemoval(int mean_k, double stddev_mul = 1.0, double halo = 1.0)
+  {
+    outlier_mean_k_ = std::max(mean_k, 0);
+    outlier_stddev_mul_ = stddev_mul;
+    outlier_halo_ = std::max(halo, 0.0);
+  }
+
+  // Limit the memory used by the resident points to @budget bytes. The maximum number
+  // of resident points, the size of spilled segments, and the step to update the segment
+  // ordering are derived from it. Setting to 0 uses the default limits (100M points).
+  void setMemoryBudget(size_t budget);
+
+  void setSpillPolicy(SpillPolicy policy) { spill_policy_ = policy; }
+
+  // Encoding of the temporary segments. The quantized chunks store the coordinates as uint16
+  // at a fraction of the leaf size, which keeps every point in its voxel.
+  void setSpillEncoding(SpillEncoding encoding) { spill_encoding_ = encoding; }
+
+  // Number of background threads writing spilled segments to the tmp directory
+  // Setting to 0 writes the spilled segments synchronously
+  void setSpillThreadNum(size_t spill_thread_num) { spill_thread_num_ = spill_thread_num; }
+
+  // Allow the divider to keep all points in memory and write the final segments directly,
+  // without temporary files, when the input fits in half of the resident point limit
+  void setInMemoryMode(bool in_memory_mode) { in_memory_mode_ = in_memory_mode; }
+
+  // Encoding of the output segments. Quantized segments store the coordinates as int16
+  // multiples of @quantization_step (meters) relative to the origin in their VIEWPOINT.
+  void setTileEncoding(TileEncoding encoding, double quantization_step = 0.001)
+  {
+    tile_encoding_ = encoding;
+
+    if (quantization_step > 0) {
+      quantization_step_ = quantization_step;
+    }
+  }
+
+  // Leaf sizes of the coarser levels of detail written to pointcloud_map_lod<k>.pcd/.
+  // Each level is downsampled from the previous one, so the leaf sizes are sorted.
+  void setLODLeafSizes(const std::vector<double> & lod_leaf_sizes)
+  {
+    lod_leaf_sizes_.clear();
+
+    for (auto leaf_size : lod_leaf_sizes) {
+      if (leaf_size > 0) {
+        lod_leaf_sizes_.push_back(leaf_size);
+      }
+    }
+
+    std::sort(lod_leaf_sizes_.begin(), lod_leaf_sizes_.end());
+  }
+
+  // Write a raster of the minimum and median z of every segment, at @cell_size meters, next to
+  // its PCD, and flag it in the tile index. Setting the cell size to 0 disables the height maps.
+  void setHeightMap(double cell_size, HeightMapFormat format = HeightMapFormat::BINARY)
+  {
+    height_map_cell_size_ = std::max(cell_size, 0.0);
+    height_map_format_ = format;
+  }
+
+  // Write the means and covariances of the points of every segment in the voxels of
+  // @resolution meters next to its PCD, so a localizer does not compute them when it loads the
+  // segment. The points are accumulated before the downsampling, while the segments are
+  // merged. Setting the resolution to 0 disables the NDT voxels.
+  void setNDTVoxels(double resolution) { ndt_resolution_ = std::max(resolution, 0.0); }
+
+  // Sort the points of every segment and level of detail along a Morton (Z-order) curve before
+  // saving it, so the points close in space are close in the file. Kd-trees, voxel grids, and
+  // GPU uploads built from the loaded segments get a better memory locality.
+  void setMortonOrder(bool morton_order) { morton_order_ = morton_order; }
+
+  // Keep a manifest of the inputs and the grids they touch next to the metadata YAML. If the
+  // manifest of a previous run with the same parameters exists in the output directory, only
+  // the segments touched by new, modified, or removed inputs are rebuilt.
+  void setIncrementalMode(bool incremental_mode) { incremental_mode_ = incremental_mode; }
+
+  // Read the binary input PCDs and the temporary segments, and write the temporary segments,
+  // through io_uring with @options. A queue depth of 0 keeps the memory mapped reads and the
+  // PCL writes. The inputs are read once, so their pages are dropped from the page cache, while
+  // the temporary segments stay cached for the finalize phase which reads them back.
+  void setAsyncIO(const AsyncIOOptions & options)
+  {
+    input_io_ = options;
+    input_io_.drop_cache = true;
+    async_io_ = options;
+    async_io_.drop_cache = false;
+    reader_.setAsyncIO(input_io_);
+  }
+
+  // Number of threads merging and downsampling the temporary segments at the end
+  void setFinalizeThreadNum(size_t finalize_thread_num)
+  {
+    finalize_thread_num_ = std::max<size_t>(finalize_thread_num, 1);
+  }
+
+  // Number of threads decoding the input PCDs and binning the points to grids
+  // Setting both to 1 processes the input sequentially
+  void setThreadNum(size_t reader_thread_num, size_t worker_thread_num)
+  {
+    reader_thread_num_ = std::max<size_t>(reader_thread_num, 1);
+    worker_thread_num_ = std::max<size_t>(worker_thread_num, 1);
+  }
+
+  // Write the run report as JSON to @report_path at the end of the run, and log the progress
+  // every @progress_period seconds. An empty path or a period of 0 disables them.
+  void setReport(const std::string & report_path, double progress_period = 0)
+  {
+    report_path_ = report_path;
+    progress_period_ = progress_period;
+  }
+
+  // Write a checkpoint to the tmp directory every @checkpoint_period seconds while dividing. A
+  // run with the same inputs and parameters resumes from the checkpoint of an interrupted run
+  // instead of starting over. Setting to 0 disables the checkpoints.
+  void setCheckpointPeriod(double checkpoint_period) { checkpoint_period_ = checkpoint_period; }
+
+  // Apply @stages in order to every block of points read from the inputs, before it is binned,
+  // so a transformed, reprojected, or filtered map is divided in a single read pass. The stages
+  // run in the reader threads, so several blocks are processed at the same time with
+  // reader_thread_num above 1.
+  void setStages(std::vector<StreamStagePtr<PointT>> stages) { stages_ = std::move(stages); }
+
+  // Divide only the large grids assigned to the worker @worker_id by the partition plan at
+  // @plan_path, and read only the inputs having points in them. An empty path divides the whole
+  // map.
+  void setPartition(const std::string & plan_path, size_t worker_id)
+  {
+    partition_plan_path_ = plan_path;
+    partition_worker_id_ = worker_id;
+  }
+
+  // Hand the finished segments and metadata files to @sink. The metadata files are published
+  // after all segments, so a map published to a remote storage is complete once they appear.
+  void setOutputSink(std::shared_ptr<OutputSink> sink)
+  {
+    sink_ = sink ? std::move(sink) : std::make_shared<LocalOutputSink>();
+    sink_->setReport(&report_);
+  }
+
+  const RunReport & getReport() const { return report_; }
+
   std::pair<double, double> getGridSize() const
   {
     return std::pair<double, double>(grid_size_x_, grid_size_y_);
@@ -123,54 +398,277 @@ public:
   void run();
   void run(const std::vector<std::string> & pcd_names);
 
+  // Scan the inputs and write the plan assigning their large grids to @worker_num workers,
+  // which run the divider with setPartition on their share of the map
+  void planPartitions(size_t worker_num, const std::string & plan_path);
+  void planPartitions(
+    const std::vector<std::string> & pcd_names, size_t worker_num, const std::string & plan_path);
+
 private:
   std::string input_pcd_or_dir_, output_dir_, file_prefix_, config_file_;
 
   std::unordered_set<GridInfo<2>> grid_set_;
+  // Statistics of the output segments, written to the tile index
+  std::unordered_map<GridInfo<2>, TileRecord> tile_records_;
+  // Large grid folders already created in this run
+  std::unordered_set<std::string> created_dirs_;
+  std::mutex grid_set_mtx_;
+
+  // Temporary PCDs of a segment and their total number of points, recorded when they are
+  // spilled, so the final phase does not have to scan the tmp directory
+  struct SegmentRecord
+  {
+    std::list<std::string> pcd_list;
+    size_t point_num = 0;
+    // Points of the border strips of the temporary segments, with the outlier removal
+    size_t halo_point_num = 0;
+  };
+
+  std::unordered_map<GridInfo<2>, SegmentRecord> manifest_;
+  std::mutex manifest_mtx_;
 
   // Params from yaml
   bool use_large_grid_ = false;
   double leaf_size_ = 0.1;
   double grid_size_x_ = 100;
   double grid_size_y_ = 100;
-  double g_grid_size_x_ = grid_size_x_ * 10;
-  double g_grid_size_y_ = grid_size_y_ * 10;
+  size_t large_grid_factor_ = 10;
+  double g_grid_size_x_ = grid_size_x_ * large_grid_factor_;
+  double g_grid_size_y_ = grid_size_y_ * large_grid_factor_;
+  size_t reader_thread_num_ = 1;
+  size_t worker_thread_num_ = 1;
+  VoxelFilterEngine voxel_filter_engine_ = VoxelFilterEngine::HASH;
+  size_t max_voxel_num_ = 0;
+  bool pre_voxelize_ = false;
+  int outlier_mean_k_ = 0;
+  double outlier_stddev_mul_ = 1.0;
+  double outlier_halo_ = 1.0;
+  size_t spill_thread_num_ = 1;
+  SpillPolicy spill_policy_ = SpillPolicy::SIZE;
+  SpillEncoding spill_encoding_ = SpillEncoding::PCD;
+  size_t finalize_thread_num_ = 1;
+  bool in_memory_mode_ = false;
+  // True if the current run keeps all points in memory
+  bool in_memory_ = false;
+  TileEncoding tile_encoding_ = TileEncoding::BINARY;
+  double quantization_step_ = 0.001;
+  std::vector<double> lod_leaf_sizes_;
+  double height_map_cell_size_ = 0;
+  HeightMapFormat height_map_format_ = HeightMapFormat::BINARY;
+  double ndt_resolution_ = 0;
+  bool morton_order_ = false;
+  AsyncIOOptions input_io_, async_io_;
+  bool incremental_mode_ = false;
+  // True if the current run rebuilds the segments in rebuild_grids_ only
+  bool incremental_ = false;
+  // True if the grids touched by every input are recorded while dividing
+  bool record_grids_ = false;
+  std::unordered_set<GridInfo<2>> rebuild_grids_;
+
+  // An input of the manifest, identified by its size and modification time
+  struct InputRecord
+  {
+    uintmax_t file_size = 0;
+    int64_t mtime = 0;
+    std::unordered_set<GridInfo<2>> grids;
+  };
+
+  std::unordered_map<std::string, InputRecord> input_records_;
+
+  std::vector<StreamStagePtr<PointT>> stages_;
+
+  std::string partition_plan_path_;
+  size_t partition_worker_id_ = 0;
+  // True if the current run divides the large grids of partition_cells_ only
+  bool partitioned_ = false;
+  std::unordered_set<GridInfo<2>> partition_cells_;
+
+  double checkpoint_period_ = 0;
+  std::chrono::steady_clock::time_point last_checkpoint_;
+  // True if the current run resumes from a checkpoint
+  bool resumed_ = false;
+  // Inputs fully divided before the checkpoint, and the position in the next one, in the unit
+  // of its reader's rangeLength()
+  size_t resume_input_ = 0, resume_position_ = 0;
+  // Number of tmp PCDs of the segments at the checkpoint, so the new ones do not overwrite them
+  std::unordered_map<GridInfo<2>, int> resumed_counters_;
+  // Binning workers that spilled their resident segments for a checkpoint
+  size_t flushed_shard_num_ = 0;
+  std::mutex checkpoint_mtx_;
+  std::condition_variable checkpoint_cv_;
 
   // Maximum number of points per PCD block
-  const size_t max_block_size_ = 500000;
-
-  // Map of points distributed to grids
-  GridMapType grid_to_cloud_;
-
-  // Segments but sorted by size
-  GridMapSizeType seg_by_size_;
-  // Map segments to size iterator
-  std::unordered_map<GridInfo<2>, GridMapSizeItr> seg_to_size_itr_map_;
-  // Only 100 million points are allowed to reside in the main memory at max
-  const size_t max_resident_point_num_ = 100000000;
-  size_t resident_point_num_ = 0;
+  size_t max_block_size_ = 500000;
+  // Minimum change of a segment size to update its position in seg_by_size_
+  size_t size_update_step_ = 10000;
+
+  // A grid seen by a shard, and its segment if the shard bins the points of the grid
+  struct GridCell
+  {
+    bool owned = false;
+    GridMapItr it;
+  };
+
+  // Points distributed to grids. The sequential mode uses a single shard, while in the
+  // pipelined mode each binning worker owns the shard of the grids hashed to it.
+  struct GridShard
+  {
+    // Map of points distributed to grids
+    GridMapType grid_to_cloud_;
+    // Flat index of the grids seen by the shard, to find the segment of a point quickly
+    GridTable<GridCell> cells_;
+    // Segments but sorted by size
+    GridMapSizeType seg_by_size_;
+    // Map segments to size iterator
+    std::unordered_map<GridInfo<2>, GridMapSizeItr> seg_to_size_itr_map_;
+    size_t resident_point_num_ = 0;
+    size_t max_resident_point_num_ = 0;
+    size_t binned_point_num_ = 0;  // Clock used to measure the recency of grids
+  };
+
+  std::vector<GridShard> shards_;
+
+  // A segment cloud waiting to be written to the tmp directory
+  struct SpillTask
+  {
+    GridInfo<2> grid;
+    std::string seg_path, file_path;
+    PclCloudType cloud;
+  };
+
+  // Spilled segments are handed to the background writers, if there is any
+  std::unique_ptr<BoundedQueue<SpillTask>> spill_queue_;
+  std::vector<std::thread> spill_writers_;
+
+  // Segment buffers already written by the spill writers. They are recycled by
+  // saveGridPCD, so binning continues without reallocating 500k-point buffers.
+  std::vector<PclCloudType> free_clouds_;
+  size_t max_free_cloud_num_ = 0;
+  std::mutex free_clouds_mtx_;
+
+  // Only 100 million points are allowed to reside in the main memory at max by default
+  size_t max_resident_point_num_ = 100000000;
+
+  // Bytes written to and read back from the tmp directory
+  std::atomic<size_t> spilled_bytes_{0}, read_back_bytes_{0};
+  std::atomic<size_t> spilled_file_num_{0};
+  // Points dropped by the pre-voxelization
+  std::atomic<size_t> pre_voxelized_point_num_{0};
+  std::atomic<size_t> outlier_point_num_{0};
+  std::atomic<size_t> evicted_voxel_num_{0};
+  // Per-phase timers and throughputs of the current run
+  RunReport report_{"pointcloud_divider"};
+  std::string report_path_;
+  double progress_period_ = 0;
+  std::shared_ptr<OutputSink> sink_ = std::make_shared<LocalOutputSink>();
+  // False once a file failed to be published in the current run
+  bool publishing_ = true;
   std::string tmp_dir_;
-  CustomPCDReader<PointT> reader_;
+  InputReader<PointT> reader_;
+  std::string laz_command_;
   bool debug_mode_ = true;  // Print debug messages or not
   rclcpp::Logger logger_;
 
-  // Find all PCD files from the input path
+  // Find all PCD, LAS, and LAZ files from the input path
   std::vector<std::string> discoverPCDs(const std::string & input);
 
   std::string makeFileName(const GridInfo<2> & grid) const;
+  // Large grid containing a segment
+  GridInfo<2> toLargeGrid(const GridInfo<2> & grid) const;
+  // Segment @dx and @dy segments away from @grid
+  GridInfo<2> adjacentGrid(const GridInfo<2> & grid, int dx, int dy) const;
+  // True if the current run outputs the segment of @grid, since the incremental and the
+  // partitioned runs output some of the segments only
+  bool isOutputGrid(const GridInfo<2> & grid) const;
+  // True if the current run bins the points of @grid: those of the output segments, and with
+  // the outlier removal, those of the segments adjacent to them, for their halos
+  bool isBinnedGrid(const GridInfo<2> & grid) const;
+  // Folder containing the output segments of the level of detail @lod (0 is the full level)
+  std::string makeMapDir(size_t lod = 0) const;
+  // Path to the border strip of the temporary file @file_path, which holds its points within
+  // outlier_halo_ of the border of its segment, for the halos of the adjacent segments
+  static std::string makeHaloPath(const std::string & file_path);
+  // Path to the output segment of a grid
+  std::string makeSegmentPath(const GridInfo<2> & grid, size_t lod = 0) const;
+  // Path to the height map of a grid, next to its full level segment
+  std::string makeHeightMapPath(const GridInfo<2> & grid) const;
+  // Path to the NDT voxels of a grid, next to its full level segment
+  std::string makeNDTVoxelsPath(const GridInfo<2> & grid) const;
 
   PclCloudPtr loadPCD(const std::string & pcd_name);
   void savePCD(const std::string & pcd_name, const pcl::PointCloud<PointT> & cloud);
-  void dividePointCloud(const PclCloudPtr & cloud_ptr);
+  void divideSequential(const std::vector<std::string> & pcd_names);
+  void dividePipelined(const std::vector<std::string> & pcd_names);
+  // Apply the stages to a block read from the inputs
+  void applyStages(PclCloudType & block);
+  // Load the partition plan and keep the inputs of this worker in @pcd_names
+  void preparePartition(std::vector<std::string> & pcd_names);
+  // Bin the points of @input that belong to the grids of the shard @shard_id
+  void dividePointCloud(
+    const PclCloudType & input, GridShard & shard, size_t shard_id, size_t shard_num);
   void paramInitialize();
+  // Select the resident segment to be written to the tmp directory
+  GridMapItr pickSpillVictim(GridShard & shard) const;
   void saveGridInfoToYAML(const std::string & yaml_file_path);
+  void saveLargeGridInfoToYAML();
+  void saveTileIndex(const std::string & index_path);
+  // Record the parameters of a partition worker, which are checked by mergePartitions
+  void savePartitionInfo(const std::string & info_path);
+  // Publish a finished file of the output directory to the sink
+  void publish(const std::string & path);
+  // Stop the progress log and write the run report, if a path is set
+  void saveReport();
   void checkOutputDirectoryValidity();
 
-  void saveGridPCD(GridMapItr & grid_it);
-  void saveTheRest();
+  // Compare the inputs with the manifest of the previous run, select the inputs to divide
+  // again and the grids to rebuild. Return false if the whole map must be divided again.
+  bool prepareIncrementalRun(
+    const std::vector<std::string> & pcd_names, std::vector<std::string> & divide_names);
+  void saveManifest(const std::string & manifest_path);
+  // Parameters that must not change between incremental runs. Without @with_worker, the ones
+  // shared by all workers of a partition plan.
+  std::string manifestSignature(bool with_worker = true) const;
+  InputRecord statInput(const std::string & pcd_name) const;
+
+  // True if the period has elapsed since the last checkpoint, and the run uses the tmp directory
+  bool checkpointDue() const;
+  // Record the state of the tmp directory after @consumed inputs and @position in the next one.
+  // The resident segments must be spilled and the spill writers stopped before calling.
+  void saveCheckpoint(const std::vector<std::string> & pcd_names, size_t consumed, size_t position);
+  // Restore the state of the checkpoint of an interrupted run over @pcd_names, and remove the
+  // tmp PCDs written after it. Return false if there is no usable checkpoint.
+  bool loadCheckpoint(const std::vector<std::string> & pcd_names);
+  std::string checkpointSignature() const;
+  void collectGrids(const PclCloudType & cloud, std::unordered_set<GridInfo<2>> & grids) const;
+
+  // Replace the points of a grid by the centroids of their voxels if the pre-voxelization is
+  // enabled. Return true if at least half of the points were dropped.
+  bool compactGrid(GridShard & shard, GridMapItr & grid_it);
+  // If @reuse is false, the grid does not receive points anymore and its buffer is released
+  void saveGridPCD(GridShard & shard, GridMapItr & grid_it, bool reuse = true);
+  void writeSpill(const SpillTask & task);
+  // Write @cloud to the temporary file @path in the spill encoding, and return its size
+  size_t writeSpillCloud(const std::string & path, const PclCloudType & cloud);
+  void startSpillWriters(size_t queue_capacity);
+  void stopSpillWriters();
+  // Replace @cloud with an empty buffer from the pool, or with a new one
+  void acquireCloud(PclCloudType & cloud);
+  void releaseCloud(PclCloudType & cloud);
+  void saveTheRest(GridShard & shard);
   void mergeAndDownsample();
-  void mergeAndDownsample(
-    const std::string & dir_path, std::list<std::string> & pcd_list, size_t total_point_num);
+  void mergeAndDownsample(const GridInfo<2> & grid, const SegmentRecord & record);
+  // Remove the outliers of @cloud, whose neighbors are also searched in @halo
+  void removeOutliers(PclCloudPtr & cloud, const PclCloudType & halo);
+  // Downsample the points of a grid kept in memory and save them as a final segment
+  void saveResidentGrid(const GridInfo<2> & grid, PclCloudType & cloud);
+  // Save a merged (filtered) segment and its levels of detail to the output directory. The
+  // points of @cloud are reordered if the Morton order is enabled.
+  void saveSegment(const GridInfo<2> & grid, PclCloudType & cloud);
+  void saveTile(const std::string & path, const GridInfo<2> & grid, const PclCloudType & cloud);
+  // Save the height map of a segment and return its TILE_HEIGHT_MAP_* flag
+  uint32_t saveHeightMap(const GridInfo<2> & grid, const PclCloudType & cloud);
+  // Save the NDT voxels of a segment saved by saveSegment, and flag them in its tile record
+  void saveNDTVoxels(const GridInfo<2> & grid, const NDTVoxelGrid & ndt_voxels);
 };
 
 }  // namespace autoware::pointcloud_divider
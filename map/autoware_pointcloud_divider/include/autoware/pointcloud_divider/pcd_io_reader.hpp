@@ -54,15 +54,29 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__PCD_IO_READER_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__PCD_IO_READER_HPP_
 
+#include "async_io.hpp"
+#include "mapped_region.hpp"
+#include "point_field_traits.hpp"
 #include "utility.hpp"
 
 #include <pcl/io/pcd_io.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace autoware::pointcloud_divider
@@ -72,20 +86,40 @@ namespace autoware::pointcloud_divider
 #define INVALID_LOC_ (0xFFFF)
 #endif
 
+// A run of bytes copied as is from a point of the file to PointT
+struct PointCopyRun
+{
+  size_t src, dst, size;
+};
+
+// Decoders of binary points
+enum class BinaryLayout {
+  RUNTIME,  // Field sizes and types are resolved at run time
+  FLOAT32,  // All fields of the point are float32
+  FLOAT64   // All fields of the point are float64, and converted to float32
+};
+
 template <typename PointT>
 class CustomPCDReader
 {
   typedef pcl::PointCloud<PointT> PclCloudType;
 
 public:
-  CustomPCDReader()
-  {
-    buffer_ = nullptr;
-    clear();
-  }
+  CustomPCDReader() : async_reader_(std::make_unique<AsyncFileReader>()) { clear(); }
+
+  // The reader owns its mapping, buffer and ring, so it is moved but not copied
+  CustomPCDReader(const CustomPCDReader &) = delete;
+  CustomPCDReader & operator=(const CustomPCDReader &) = delete;
+  CustomPCDReader(CustomPCDReader &&) = default;
+  CustomPCDReader & operator=(CustomPCDReader &&) = default;
 
   // Set a file to reading
   void setInput(const std::string & pcd_path);
+  // Limit the reading to the range [@begin, @end) of the opening file, in the unit of
+  // rangeLength(). The ranges are the points of an uncompressed binary PCD, and the bytes of the
+  // data of an ASCII PCD, where a range reads the lines beginning in it. Readers of the different
+  // ranges of a file decode them concurrently. Only valid if supportsRange() is true.
+  void setRange(size_t begin, size_t end);
   // Read a block of points from the input stream
   size_t readABlock(PclCloudType & output);
 
@@ -94,6 +128,29 @@ public:
 
   void setBlockSize(size_t block_size) { block_size_ = block_size; }
 
+  size_t block_size() const { return block_size_; }
+
+  // Read the uncompressed binary PCDs opened next through io_uring instead of mapping them, with
+  // the chunks after the current block read ahead. The other PCDs are not affected.
+  void setAsyncIO(const AsyncIOOptions & options) { async_options_ = options; }
+
+  // True if the opening file is an uncompressed binary PCD, whose points can be read by ranges,
+  // or a mapped ASCII PCD, whose lines can be read by ranges
+  bool supportsRange() const
+  {
+    return (binary_ ? uncompressed_ : mapping_.data() != nullptr) && point_size_ > 0;
+  }
+
+  // Number of points of a binary PCD, or number of bytes of the data of an ASCII PCD
+  size_t rangeLength() const { return binary_ ? point_num_ : mapping_.size() - data_offset_; }
+
+  // Length of a range holding about a block of points
+  size_t rangeStep() const { return binary_ ? block_size_ : ascii_range_size_; }
+
+  // Position of the next point to be read, in the unit of rangeLength(). Reading the range from
+  // this position continues exactly where the reader is. Only valid if supportsRange() is true.
+  size_t rangePosition() const { return binary_ ? loaded_point_num_ : ascii_pos_ - data_offset_; }
+
   bool good() { return file_.good(); }
 
   size_t point_num()
@@ -112,7 +169,22 @@ private:
   size_t readABlock(std::ifstream & input, PclCloudType & output);
 
   size_t readABlockBinary(std::ifstream & input, PclCloudType & output);
+  size_t readABlockMapped(std::ifstream & input, PclCloudType & output);
+  size_t readABlockAsync(std::ifstream & input, PclCloudType & output);
   size_t readABlockASCII(std::ifstream & input, PclCloudType & output);
+  size_t readABlockASCIIMapped(std::ifstream & input, PclCloudType & output);
+  // Parse a line of an ASCII PCD. Return false if the line is blank, and exit if it is invalid.
+  bool parseLine(const char * first, const char * last, PointT & output);
+
+  // Map the data of the opening file to memory. If mapping fails, the reader
+  // falls back to reading the file through the stream.
+  void mapFile();
+  // Build the runs of bytes copied from a point of the file to PointT. Return false if a field of
+  // PointT is not in the file with the same size and count, so the points must be decoded.
+  bool buildCopyRuns();
+  void parsePoints(const char * input, size_t point_num, PointT * output);
+  // Copy @point_num consecutive points from @input to @output by the runs of buildCopyRuns()
+  void copyPoints(const char * input, size_t point_num, PointT * output) const;
 
   void clear()
   {
@@ -125,8 +197,9 @@ private:
     origin_x_ = origin_y_ = origin_z_ = 0.0;
     orientation_w_ = orientation_x_ = orientation_y_ = orientation_z_ = 0.0;
     point_num_ = 0;
-    loaded_point_num_ = 0;
+    loaded_point_num_ = end_point_num_ = 0;
     binary_ = true;
+    uncompressed_ = false;
 
     if (file_.is_open()) {
       file_.close();
@@ -135,12 +208,20 @@ private:
     file_.clear();
 
     point_size_ = read_size_ = 0;
-    if (buffer_) {
-      delete[] buffer_;
+    buffer_.reset();
+    block_size_ = 30000000;
+    mapping_.reset();
+
+    // A moved-from reader has no ring
+    if (async_reader_) {
+      async_reader_->close();
     }
 
-    buffer_ = nullptr;
-    block_size_ = 30000000;
+    data_offset_ = 0;
+    ascii_pos_ = ascii_end_ = 0;
+    layout_matched_ = bulk_copy_ = false;
+    copy_runs_.clear();
+    layout_ = BinaryLayout::RUNTIME;
   }
 
   // Metadata
@@ -157,14 +238,33 @@ private:
   size_t point_num_;
   // Number of points loaded so far, reset every time setInput is called
   size_t loaded_point_num_;
+  // Number of points at the end of the range to read, the whole file by default
+  size_t end_point_num_;
   bool binary_;                   // Data: true: binary, false: ascii
+  bool uncompressed_;             // Data is binary, not binary_compressed
   std::ifstream file_;            // Input stream of the PCD file
   size_t block_size_ = 30000000;  // Number of points to read in each readABlock
   size_t point_size_, read_size_;
-  char * buffer_;
+  std::unique_ptr<char[]> buffer_;
   std::string pcd_path_;            // Path to the current opening PCD
   std::vector<size_t> read_loc_;    // Locations to read fields of a point
   std::vector<size_t> read_sizes_;  // Sizes of fields of a point
+  // Memory-mapped content of the PCD, empty if the file is read through file_
+  MappedRegion mapping_;
+  size_t data_offset_;  // Offset of the first point
+  // Offsets of the next line of a mapped ASCII PCD, and of the end of its range
+  size_t ascii_pos_, ascii_end_;
+  // Values of the line being parsed
+  std::vector<std::pair<const char *, const char *>> ascii_values_;
+  // Bytes of an ASCII range, about a block of 1M points of 4 fields
+  static constexpr size_t ascii_range_size_ = 1 << 26;
+  bool layout_matched_;  // True if points are copied to PointT by copy_runs_
+  bool bulk_copy_;       // True if the points of the file are laid out exactly as PointT
+  std::vector<PointCopyRun> copy_runs_;
+  BinaryLayout layout_;  // Decoder of binary points
+  AsyncIOOptions async_options_;
+  // Reader of the data of the opening binary PCD, if it is read through io_uring
+  std::unique_ptr<AsyncFileReader> async_reader_;
 };
 
 template <typename PointT>
@@ -183,6 +283,187 @@ void CustomPCDReader<PointT>::setInput(const std::string & pcd_path)
 
   pcd_path_ = pcd_path;
   readHeader(file_);
+  end_point_num_ = point_num_;
+
+  auto data_pos = file_.tellg();
+
+  data_offset_ = data_pos < 0 ? 0 : static_cast<size_t>(data_pos);
+
+  if (
+    binary_ && uncompressed_ && point_size_ > 0 && data_pos >= 0 &&
+    async_reader_->open(pcd_path, data_offset_, async_options_)) {
+    layout_matched_ = buildCopyRuns();
+
+    return;
+  }
+
+  mapFile();
+}
+
+template <typename PointT>
+void CustomPCDReader<PointT>::setRange(size_t begin, size_t end)
+{
+  // Reset the end of the previous range
+  file_.clear();
+
+  if (!binary_) {
+    // The lines are counted by the ranges, not by the header
+    end_point_num_ = std::numeric_limits<size_t>::max();
+    ascii_end_ = std::min(data_offset_ + end, mapping_.size());
+    ascii_pos_ = std::min(data_offset_ + begin, ascii_end_);
+
+    // Skip the line beginning in the previous range
+    if (begin > 0 && ascii_pos_ < ascii_end_) {
+      const char * line_end = static_cast<const char *>(
+        memchr(mapping_.data() + ascii_pos_ - 1, '\n', mapping_.size() - ascii_pos_ + 1));
+
+      ascii_pos_ = line_end ? line_end - mapping_.data() + 1 : mapping_.size();
+    }
+
+    return;
+  }
+
+  end_point_num_ = std::min(end, point_num_);
+  loaded_point_num_ = std::min(begin, end_point_num_);
+
+  if (mapping_.data()) {
+    return;
+  }
+
+  if (async_reader_->is_open()) {
+    async_reader_->seek(data_offset_ + loaded_point_num_ * point_size_);
+
+    return;
+  }
+
+  file_.seekg(data_offset_ + loaded_point_num_ * point_size_);
+}
+
+template <typename PointT>
+void CustomPCDReader<PointT>::mapFile()
+{
+  auto data_pos = file_.tellg();
+
+  if (data_pos < 0 || point_size_ == 0) {
+    return;
+  }
+
+  int fd = open(pcd_path_.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    return;
+  }
+
+  struct stat file_stat;
+
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > data_pos) {
+    void * addr = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (addr != MAP_FAILED) {
+      // Points are consumed from the beginning to the end of the file
+      madvise(addr, file_stat.st_size, MADV_SEQUENTIAL);
+
+      mapping_.reset(static_cast<const char *>(addr), file_stat.st_size);
+      data_offset_ = data_pos;
+      layout_matched_ = binary_ && buildCopyRuns();
+      ascii_pos_ = data_offset_;
+      ascii_end_ = mapping_.size();
+    }
+  }
+
+  close(fd);
+}
+
+// A field of PointT is copied from the file if it is there with the same size and count. The
+// fields contiguous both in the file and in PointT are merged, so a PointXYZ is copied as one
+// run of 12 bytes into its 16, and a PointXYZI as two runs around the padding after z. The
+// padding of PointT is not in the file, except for a file written with the layout of PointT.
+template <typename PointT>
+bool CustomPCDReader<PointT>::buildCopyRuns()
+{
+  copy_runs_.clear();
+  bulk_copy_ = false;
+
+  size_t file_offset = 0;
+  std::vector<size_t> file_offsets(field_names_.size());
+
+  for (size_t i = 0; i < field_names_.size(); ++i) {
+    file_offsets[i] = file_offset;
+    file_offset += field_sizes_[i] * field_counts_[i];
+  }
+
+  std::vector<PointCopyRun> runs;
+
+  for (const auto & field : pcl::getFields<PointT>()) {
+    if (field.name == "_") {
+      continue;
+    }
+
+    auto it = std::find(field_names_.begin(), field_names_.end(), field.name);
+
+    if (it == field_names_.end()) {
+      return false;
+    }
+
+    size_t fid = it - field_names_.begin();
+    const size_t size = static_cast<size_t>(pcl::getFieldSize(field.datatype));
+
+    if (field_sizes_[fid] != size || field_counts_[fid] != field.count) {
+      return false;
+    }
+
+    runs.push_back({file_offsets[fid], field.offset, size * field.count});
+  }
+
+  std::sort(runs.begin(), runs.end(), [](const PointCopyRun & a, const PointCopyRun & b) {
+    return a.dst < b.dst;
+  });
+
+  bulk_copy_ = point_size_ == sizeof(PointT);
+
+  for (const auto & run : runs) {
+    bulk_copy_ = bulk_copy_ && run.src == run.dst;
+
+    if (
+      !copy_runs_.empty() && copy_runs_.back().src + copy_runs_.back().size == run.src &&
+      copy_runs_.back().dst + copy_runs_.back().size == run.dst) {
+      copy_runs_.back().size += run.size;
+    } else {
+      copy_runs_.push_back(run);
+    }
+  }
+
+  return true;
+}
+
+template <typename PointT>
+void CustomPCDReader<PointT>::copyPoints(
+  const char * input, size_t point_num, PointT * output) const
+{
+  if (bulk_copy_) {
+    memcpy(static_cast<void *>(output), input, point_num * point_size_);
+
+    return;
+  }
+
+  // The padding of the points keeps the values of their constructor
+  if (copy_runs_.size() == 1) {
+    const PointCopyRun run = copy_runs_.front();
+
+    for (size_t i = 0; i < point_num; ++i, input += point_size_) {
+      memcpy(reinterpret_cast<char *>(output + i) + run.dst, input + run.src, run.size);
+    }
+
+    return;
+  }
+
+  for (size_t i = 0; i < point_num; ++i, input += point_size_) {
+    char * dst = reinterpret_cast<char *>(output + i);
+
+    for (const auto & run : copy_runs_) {
+      memcpy(dst + run.dst, input + run.src, run.size);
+    }
+  }
 }
 
 template <typename PointT>
@@ -203,6 +484,12 @@ template <typename PointT>
 inline void buildReadMetadataASCII(
   std::vector<std::string> & field_names, std::vector<size_t> & read_loc);
 
+// Select the decoder of binary points
+template <typename PointT>
+inline BinaryLayout detectBinaryLayout(
+  const std::vector<std::string> & field_names, const std::vector<size_t> & field_sizes,
+  const std::vector<std::string> & field_types, const std::vector<size_t> & field_counts);
+
 template <typename PointT>
 void CustomPCDReader<PointT>::readHeader(std::ifstream & input)
 {
@@ -335,6 +622,7 @@ void CustomPCDReader<PointT>::readHeader(std::ifstream & input)
 
       if (vals[0] == "DATA") {
         binary_ = vals[1].find("binary") != std::string::npos;
+        uncompressed_ = util::trim(vals[1]) == "binary";
 
         break;
       }
@@ -359,16 +647,13 @@ void CustomPCDReader<PointT>::readHeader(std::ifstream & input)
 
   read_size_ = point_size_ * block_size_;
 
-  if (buffer_) {
-    delete[] buffer_;
-  }
-
-  buffer_ = new char[read_size_];
+  buffer_.reset(new char[read_size_]);
 
   if (field_sizes_.size() > 0) {
     // Construct read loc and read size, used to read data from files to points
     if (binary_) {
       buildReadMetadata<PointT>(field_names_, field_sizes_, field_counts_, read_loc_, read_sizes_);
+      layout_ = detectBinaryLayout<PointT>(field_names_, field_sizes_, field_types_, field_counts_);
     } else {
       buildReadMetadataASCII<PointT>(field_names_, read_loc_);
     }
@@ -411,16 +696,18 @@ inline void setFieldReadMetadata(
   read_loc = INVALID_LOC_;
 }
 
-template <>
-inline void buildReadMetadata<pcl::PointXYZ>(
+template <typename PointT>
+inline void buildReadMetadata(
   std::vector<std::string> & field_names, std::vector<size_t> & field_sizes,
   std::vector<size_t> & field_counts, std::vector<size_t> & read_loc,
   std::vector<size_t> & read_sizes)
 {
+  using Traits = PointFieldTraits<PointT>;
+
   size_t field_num = field_names.size();
 
-  read_loc.resize(3);
-  read_sizes.resize(3);
+  read_loc.resize(Traits::size);
+  read_sizes.resize(Traits::size);
 
   std::vector<size_t> tmp_read_loc(field_num);
 
@@ -430,106 +717,149 @@ inline void buildReadMetadata<pcl::PointXYZ>(
     tmp_read_loc[i + 1] = field_sizes[i] * field_counts[i] + tmp_read_loc[i];
   }
 
-  // Find field x, y, z
-  setFieldReadMetadata("x", field_names, field_sizes, tmp_read_loc, read_loc[0], read_sizes[0]);
-  setFieldReadMetadata("y", field_names, field_sizes, tmp_read_loc, read_loc[1], read_sizes[1]);
-  setFieldReadMetadata("z", field_names, field_sizes, tmp_read_loc, read_loc[2], read_sizes[2]);
+  // Find the fields of the point type
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    setFieldReadMetadata(
+      Traits::names[fid], field_names, field_sizes, tmp_read_loc, read_loc[fid], read_sizes[fid]);
+  }
 }
 
-template <>
-inline void buildReadMetadata<pcl::PointXYZI>(
-  std::vector<std::string> & field_names, std::vector<size_t> & field_sizes,
-  std::vector<size_t> & field_counts, std::vector<size_t> & read_loc,
-  std::vector<size_t> & read_sizes)
+template <typename PointT>
+inline void buildReadMetadataASCII(
+  std::vector<std::string> & field_names, std::vector<size_t> & read_loc)
 {
-  size_t field_num = field_names.size();
+  using Traits = PointFieldTraits<PointT>;
 
-  read_loc.resize(4);
-  read_sizes.resize(4);
-
-  std::vector<size_t> tmp_read_loc(field_num);
-
-  tmp_read_loc[0] = 0;
+  read_loc.resize(Traits::size);
 
-  for (size_t i = 0; i < field_num - 1; ++i) {
-    tmp_read_loc[i + 1] = field_sizes[i] * field_counts[i] + tmp_read_loc[i];
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    setFieldReadMetadata(Traits::names[fid], field_names, read_loc[fid]);
   }
-
-  // Find field x, y, z, intensity
-  setFieldReadMetadata("x", field_names, field_sizes, tmp_read_loc, read_loc[0], read_sizes[0]);
-  setFieldReadMetadata("y", field_names, field_sizes, tmp_read_loc, read_loc[1], read_sizes[1]);
-  setFieldReadMetadata("z", field_names, field_sizes, tmp_read_loc, read_loc[2], read_sizes[2]);
-  setFieldReadMetadata(
-    "intensity", field_names, field_sizes, tmp_read_loc, read_loc[3], read_sizes[3]);
 }
 
-template <>
-inline void buildReadMetadataASCII<pcl::PointXYZ>(
-  std::vector<std::string> & field_names, std::vector<size_t> & read_loc)
+// Pick the binary decoder. The fixed layouts are used only when every field of PointT
+// found in the file has the same size and a floating point type (missing fields are 0).
+template <typename PointT>
+inline BinaryLayout detectBinaryLayout(
+  const std::vector<std::string> & field_names, const std::vector<size_t> & field_sizes,
+  const std::vector<std::string> & field_types, const std::vector<size_t> & field_counts)
 {
-  read_loc.resize(3);
+  using Traits = PointFieldTraits<PointT>;
 
-  setFieldReadMetadata("x", field_names, read_loc[0]);
-  setFieldReadMetadata("y", field_names, read_loc[1]);
-  setFieldReadMetadata("z", field_names, read_loc[2]);
-}
+  size_t common_size = 0;
 
-template <>
-inline void buildReadMetadataASCII<pcl::PointXYZI>(
-  std::vector<std::string> & field_names, std::vector<size_t> & read_loc)
-{
-  read_loc.resize(4);
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    auto it = std::find(field_names.begin(), field_names.end(), Traits::names[fid]);
+
+    if (it == field_names.end()) {
+      continue;
+    }
+
+    size_t i = it - field_names.begin();
+
+    if (i >= field_types.size() || field_types[i] != "F" || field_counts[i] != 1) {
+      // Packed colors are stored as float32 or as uint32, both are copied bit by bit
+      if (!Traits::color[fid] || field_sizes[i] != sizeof(float)) {
+        return BinaryLayout::RUNTIME;
+      }
+    }
+
+    if (common_size == 0) {
+      common_size = field_sizes[i];
+    } else if (common_size != field_sizes[i]) {
+      return BinaryLayout::RUNTIME;
+    }
+  }
 
-  setFieldReadMetadata("x", field_names, read_loc[0]);
-  setFieldReadMetadata("y", field_names, read_loc[1]);
-  setFieldReadMetadata("z", field_names, read_loc[2]);
-  setFieldReadMetadata("intensity", field_names, read_loc[3]);
+  if (common_size == sizeof(float)) {
+    return BinaryLayout::FLOAT32;
+  }
+
+  if (common_size == sizeof(double)) {
+    return BinaryLayout::FLOAT64;
+  }
+
+  return BinaryLayout::RUNTIME;
 }
 
+// Runtime-dispatch decoder, used for the layouts that do not have a fixed decoder
 template <typename PointT>
 inline void parsePoint(
-  const char * input, std::vector<size_t> & rsize, std::vector<size_t> & loc, PointT & output);
+  const char * input, const std::vector<size_t> & rsize, const std::vector<size_t> & loc,
+  PointT & output)
+{
+  for (size_t fid = 0; fid < PointFieldTraits<PointT>::size; ++fid) {
+    if (rsize[fid] == sizeof(double)) {
+      double value;
 
-template <>
+      memcpy(&value, input + loc[fid], sizeof(double));
+      *fieldPtr(output, fid) = static_cast<float>(value);
+    } else {
+      memcpy(fieldPtr(output, fid), input + loc[fid], rsize[fid]);
+    }
+  }
+}
+
+// Fixed decoder for the layouts whose fields are all of type ValueT. The number of
+// fields and their sizes are known at compile time, so the loop is fully unrolled.
+// Fields missing in the file (rsize is 0) are left untouched.
+template <typename ValueT, typename PointT>
 inline void parsePoint(
-  const char * input, std::vector<size_t> & rsize, std::vector<size_t> & loc,
-  pcl::PointXYZ & output)
+  const char * input, const size_t * rsize, const size_t * loc, PointT & output)
 {
-  memcpy(&(output.x), input + loc[0], rsize[0]);
-  memcpy(&(output.y), input + loc[1], rsize[1]);
-  memcpy(&(output.z), input + loc[2], rsize[2]);
+  for (size_t fid = 0; fid < PointFieldTraits<PointT>::size; ++fid) {
+    if (rsize[fid] > 0) {
+      ValueT value;
+
+      memcpy(&value, input + loc[fid], sizeof(ValueT));
+      *fieldPtr(output, fid) = static_cast<float>(value);
+    }
+  }
 }
 
-template <>
-inline void parsePoint(
-  const char * input, std::vector<size_t> & rsize, std::vector<size_t> & loc,
-  pcl::PointXYZI & output)
+// Decode @point_num consecutive points from @input to @output
+template <typename PointT>
+void CustomPCDReader<PointT>::parsePoints(const char * input, size_t point_num, PointT * output)
 {
-  memcpy(&(output.x), input + loc[0], rsize[0]);
-  memcpy(&(output.y), input + loc[1], rsize[1]);
-  memcpy(&(output.z), input + loc[2], rsize[2]);
-  memcpy(&(output.intensity), input + loc[3], rsize[3]);
+  const size_t * rsize = read_sizes_.data();
+  const size_t * loc = read_loc_.data();
+
+  switch (layout_) {
+    case BinaryLayout::FLOAT32:
+      for (size_t i = 0; i < point_num; ++i, input += point_size_) {
+        parsePoint<float>(input, rsize, loc, output[i]);
+      }
+      break;
+    case BinaryLayout::FLOAT64:
+      for (size_t i = 0; i < point_num; ++i, input += point_size_) {
+        parsePoint<double>(input, rsize, loc, output[i]);
+      }
+      break;
+    default:
+      for (size_t i = 0; i < point_num; ++i, input += point_size_) {
+        parsePoint(input, read_sizes_, read_loc_, output[i]);
+      }
+      break;
+  }
 }
 
 template <typename PointT>
 size_t CustomPCDReader<PointT>::readABlockBinary(std::ifstream & input, PclCloudType & output)
 {
   output.clear();
-  output.reserve(block_size_);
-
-  PointT p;
 
   if (input) {
-    input.read(buffer_, read_size_);
+    input.read(buffer_.get(), read_size_);
 
     // Parse the buffer and convert to point
-    for (int i = 0; i < input.gcount() && loaded_point_num_ < point_num_;
-         i += point_size_, ++loaded_point_num_) {
-      parsePoint(buffer_ + i, read_sizes_, read_loc_, p);
-      output.push_back(p);
-    }
+    size_t proc_num = std::min(
+      static_cast<size_t>(input.gcount()) / point_size_, end_point_num_ - loaded_point_num_);
 
-    if (loaded_point_num_ == point_num_) {
+    output.resize(proc_num);
+    parsePoints(buffer_.get(), proc_num, output.points.data());
+    loaded_point_num_ += proc_num;
+
+    if (loaded_point_num_ == end_point_num_) {
       input.setstate(std::ios_base::eofbit);
     }
 
@@ -539,32 +869,171 @@ size_t CustomPCDReader<PointT>::readABlockBinary(std::ifstream & input, PclCloud
   return 0;
 }
 
+// Read points directly from the mapped file pages. If every field of PointT is in the file with
+// the same size, the points are copied by runs of bytes into the stride of PointT; otherwise
+// they are decoded one by one in place.
 template <typename PointT>
-void parsePoint(const std::string & point_line, const std::vector<size_t> & loc, PointT & output);
+size_t CustomPCDReader<PointT>::readABlockMapped(std::ifstream & input, PclCloudType & output)
+{
+  // Ignore the trailing bytes of an incomplete point in a truncated file
+  size_t available_num = std::min(end_point_num_, (mapping_.size() - data_offset_) / point_size_);
+  size_t end_num = std::min(available_num, loaded_point_num_ + block_size_);
 
-template <>
-inline void parsePoint(
-  const std::string & point_line, const std::vector<size_t> & loc, pcl::PointXYZ & output)
+  if (end_num <= loaded_point_num_) {
+    input.setstate(std::ios_base::eofbit);
+    output.clear();
+
+    return 0;
+  }
+
+  size_t proc_num = end_num - loaded_point_num_;
+  const char * src = mapping_.data() + data_offset_ + loaded_point_num_ * point_size_;
+
+  output.resize(proc_num);
+
+  if (layout_matched_) {
+    copyPoints(src, proc_num, output.points.data());
+  } else {
+    parsePoints(src, proc_num, output.points.data());
+  }
+
+  loaded_point_num_ = end_num;
+
+  if (loaded_point_num_ == available_num) {
+    input.setstate(std::ios_base::eofbit);
+  }
+
+  return proc_num * point_size_;
+}
+
+// Read points from the chunks read ahead by io_uring. If the layout of points in the file is the
+// same as PointT, they are read to the output directly; otherwise they are copied or decoded from
+// buffer_.
+template <typename PointT>
+size_t CustomPCDReader<PointT>::readABlockAsync(std::ifstream & input, PclCloudType & output)
 {
-  std::vector<std::string> vals;
+  size_t proc_num = input ? std::min(block_size_, end_point_num_ - loaded_point_num_) : 0;
+  char * dst = buffer_.get();
+
+  output.resize(proc_num);
+
+  if (bulk_copy_) {
+    dst = reinterpret_cast<char *>(output.points.data());
+  }
+
+  const size_t read_byte_num = async_reader_->read(dst, proc_num * point_size_);
 
-  util::split(point_line, " ", vals);
-  output.x = (loc[0] != INVALID_LOC_) ? std::stof(vals[loc[0]]) : 0;
-  output.y = (loc[1] != INVALID_LOC_) ? std::stof(vals[loc[1]]) : 0;
-  output.z = (loc[2] != INVALID_LOC_) ? std::stof(vals[loc[2]]) : 0;
+  if (async_reader_->failed()) {
+    fprintf(
+      stderr, "[%s, %d] %s::Error: Failed to read a block of points from file. File %s\n",
+      __FILE__, __LINE__, __func__, pcd_path_.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  // Ignore the trailing bytes of an incomplete point in a truncated file
+  const size_t read_num = read_byte_num / point_size_;
+
+  output.resize(read_num);
+
+  if (layout_matched_ && !bulk_copy_) {
+    copyPoints(buffer_.get(), read_num, output.points.data());
+  } else if (!layout_matched_) {
+    parsePoints(buffer_.get(), read_num, output.points.data());
+  }
+
+  loaded_point_num_ += read_num;
+
+  if (loaded_point_num_ == end_point_num_ || read_num < proc_num) {
+    input.setstate(std::ios_base::eofbit);
+  }
+
+  return read_byte_num;
 }
 
-template <>
-inline void parsePoint(
-  const std::string & point_line, const std::vector<size_t> & loc, pcl::PointXYZI & output)
+// Split a line of an ASCII PCD to its values, separated by spaces or tabs
+inline void splitASCIIValues(
+  const char * first, const char * last,
+  std::vector<std::pair<const char *, const char *>> & values)
 {
-  std::vector<std::string> vals;
+  auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+
+  values.clear();
+
+  while (first != last) {
+    if (is_space(*first)) {
+      ++first;
+      continue;
+    }
 
-  util::split(point_line, " ", vals);
-  output.x = (loc[0] != INVALID_LOC_) ? std::stof(vals[loc[0]]) : 0;
-  output.y = (loc[1] != INVALID_LOC_) ? std::stof(vals[loc[1]]) : 0;
-  output.z = (loc[2] != INVALID_LOC_) ? std::stof(vals[loc[2]]) : 0;
-  output.intensity = (loc[3] != INVALID_LOC_) ? std::stof(vals[loc[3]]) : 0;
+    const char * value_end = std::find_if(first, last, is_space);
+
+    values.emplace_back(first, value_end);
+    first = value_end;
+  }
+}
+
+// Parse a number from [@first, @last). Return false if it is not a number.
+template <typename ValueT>
+inline bool parseASCIIValue(const char * first, const char * last, ValueT & value)
+{
+  // from_chars does not accept the plus sign
+  if (first != last && *first == '+') {
+    ++first;
+  }
+
+  auto result = std::from_chars(first, last, value);
+
+  return result.ec == std::errc() && result.ptr == last;
+}
+
+template <typename PointT>
+inline bool parsePoint(
+  const std::vector<std::pair<const char *, const char *>> & values,
+  const std::vector<size_t> & loc, PointT & output)
+{
+  using Traits = PointFieldTraits<PointT>;
+
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    float * field = fieldPtr(output, fid);
+
+    if (loc[fid] == INVALID_LOC_) {
+      *field = 0;
+    } else if (loc[fid] >= values.size()) {
+      return false;
+    } else if (Traits::color[fid]) {
+      // Packed colors are written as uint32 in ASCII PCDs
+      std::uint32_t value;
+
+      if (!parseASCIIValue(values[loc[fid]].first, values[loc[fid]].second, value)) {
+        return false;
+      }
+
+      memcpy(field, &value, sizeof(value));
+    } else if (!parseASCIIValue(values[loc[fid]].first, values[loc[fid]].second, *field)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+template <typename PointT>
+bool CustomPCDReader<PointT>::parseLine(const char * first, const char * last, PointT & output)
+{
+  splitASCIIValues(first, last, ascii_values_);
+
+  if (ascii_values_.empty()) {
+    return false;
+  }
+
+  if (!parsePoint(ascii_values_, read_loc_, output)) {
+    fprintf(
+      stderr, "[%s, %d] %s::Error: Invalid point %s in file %s\n", __FILE__, __LINE__, __func__,
+      std::string(first, last).c_str(), pcd_path_.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  return true;
 }
 
 template <typename PointT>
@@ -582,12 +1051,13 @@ size_t CustomPCDReader<PointT>::readABlockASCII(std::ifstream & input, PclCloudT
     std::getline(input, point_line);
 
     if (!input.fail()) {
-      // Parse the buffer and convert to point
-      parsePoint(point_line, read_loc_, p);
-      output.push_back(p);
-
       read_byte_num += input.gcount();
-      ++loaded_point_num_;
+
+      // Parse the buffer and convert to point
+      if (parseLine(point_line.data(), point_line.data() + point_line.size(), p)) {
+        output.push_back(p);
+        ++loaded_point_num_;
+      }
     } else {
       fprintf(
         stderr, "[%s, %d] %s::Error: Failed to read a block of points from file. File %s\n",
@@ -603,13 +1073,66 @@ size_t CustomPCDReader<PointT>::readABlockASCII(std::ifstream & input, PclCloudT
   return read_byte_num;
 }
 
+// Parse the lines directly from the mapped file pages, without copying them to strings
+template <typename PointT>
+size_t CustomPCDReader<PointT>::readABlockASCIIMapped(std::ifstream & input, PclCloudType & output)
+{
+  // A point takes 2 bytes per field at least, as in "0 0 0\n"
+  const size_t read_loc_num = std::max<size_t>(read_loc_.size(), 1);
+  const size_t begin_pos = ascii_pos_;
+
+  output.clear();
+
+  if (ascii_pos_ < ascii_end_) {
+    output.reserve(std::min(block_size_, (ascii_end_ - ascii_pos_) / (2 * read_loc_num) + 1));
+  }
+
+  PointT p;
+
+  while (ascii_pos_ < ascii_end_ && output.size() < block_size_ &&
+         loaded_point_num_ < end_point_num_) {
+    const char * line = mapping_.data() + ascii_pos_;
+    const char * line_end =
+      static_cast<const char *>(memchr(line, '\n', mapping_.size() - ascii_pos_));
+
+    if (!line_end) {
+      line_end = mapping_.data() + mapping_.size();
+    }
+
+    ascii_pos_ = std::min<size_t>(line_end - mapping_.data() + 1, mapping_.size());
+
+    if (parseLine(line, line_end, p)) {
+      output.push_back(p);
+      ++loaded_point_num_;
+    }
+  }
+
+  if (ascii_pos_ >= ascii_end_ || loaded_point_num_ >= end_point_num_) {
+    input.setstate(std::ios_base::eofbit);
+  }
+
+  return ascii_pos_ - begin_pos;
+}
+
 template <typename PointT>
 size_t CustomPCDReader<PointT>::readABlock(std::ifstream & input, PclCloudType & output)
 {
   if (binary_) {
+    if (mapping_.data()) {
+      return readABlockMapped(input, output);
+    }
+
+    if (async_reader_->is_open()) {
+      return readABlockAsync(input, output);
+    }
+
     return readABlockBinary(input, output);
   }
 
+  if (mapping_.data()) {
+    return readABlockASCIIMapped(input, output);
+  }
+
   return readABlockASCII(input, output);
 }
 
@@ -54,6 +54,8 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__PCD_IO_WRITER_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__PCD_IO_WRITER_HPP_
 
+#include "async_io.hpp"
+#include "point_field_traits.hpp"
 #include "utility.hpp"
 
 #include <pcl/PCLPointField.h>
@@ -61,14 +63,54 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace autoware::pointcloud_divider
 {
 
+// Maximum number of characters of a formatted ASCII value
+constexpr size_t max_ascii_value_size = 32;
+
+// Format a value to @dst as an std::ostream with the default flags does, and return the end.
+// Floating point values are written with 6 significant digits, nan as "nan".
+template <typename ValueT>
+inline char * formatASCIIValue(char * dst, ValueT value)
+{
+  if constexpr (std::is_floating_point_v<ValueT>) {
+    if (std::isnan(value)) {
+      memcpy(dst, "nan", 3);
+
+      return dst + 3;
+    }
+
+    return std::to_chars(dst, dst + max_ascii_value_size, value, std::chars_format::general, 6)
+      .ptr;
+  } else {
+    return std::to_chars(dst, dst + max_ascii_value_size, value).ptr;
+  }
+}
+
+// Format the FileT value at @src as a PrintT value
+template <typename FileT, typename PrintT = FileT>
+inline char * formatASCIIValue(char * dst, const char * src)
+{
+  FileT value;
+
+  memcpy(&value, src, sizeof(FileT));
+
+  return formatASCIIValue(dst, static_cast<PrintT>(value));
+}
+
 template <typename PointT>
 class CustomPCDWriter
 {
@@ -99,13 +141,46 @@ public:
 
   void setBlockSize(size_t block_size) { block_size_ = block_size; }
 
-  bool good() { return file_.good(); }
+  // Write the PCDs opened next through io_uring, coalescing the writes to chunks written in the
+  // background while the next points are encoded
+  void setAsyncIO(const AsyncIOOptions & options) { async_options_ = options; }
+
+  // With io_uring, wait for the chunks in flight, so that their errors are reported
+  bool good() { return async_writer_.is_open() ? async_writer_.flush() : file_.good(); }
+
+  // Functions to write the points of a binary PCD from several threads. After writeMetadata,
+  // the points are encoded by encodeBinary and written by the callers at
+  // dataOffset() + index * pointSize(), then reported by markWritten so they are not padded.
+  size_t dataOffset()
+  {
+    if (async_writer_.is_open()) {
+      async_writer_.flush();
+
+      return async_writer_.position();
+    }
+
+    file_.flush();
+
+    return static_cast<size_t>(file_.tellp());
+  }
+
+  size_t pointSize() const { return point_size_; }
+
+  void encodeBinary(const PclCloudType & input, char * output) const;
+
+  void markWritten(size_t point_num) { written_point_num_ += point_num; }
+
+  // Finish the current file, keeping the io_uring ring and buffers for the next one
+  void close() { clear(); }
 
   ~CustomPCDWriter() { clear(); }
 
 private:
   void writeABlockBinary(const PclCloudType & input, size_t loc, size_t proc_size);
   void writeABlockASCII(const PclCloudType & input, size_t loc, size_t proc_size);
+  // Writers used when the fields of PointT are described by PointFieldTraits
+  void writeABlockBinaryFixed(const PclCloudType & input, size_t loc, size_t proc_size);
+  void writeABlockASCIIFixed(const PclCloudType & input, size_t loc, size_t proc_size);
 
   // If the number of points written to file is less than the number of points
   // in the header, fill the remaining points with 0. This often indicates
@@ -113,9 +188,19 @@ private:
   // analyze the problem easier.
   void padding();
 
+  void writeBytes(const char * data, size_t size)
+  {
+    if (async_writer_.is_open()) {
+      async_writer_.write(data, size);
+    } else {
+      file_.write(data, size);
+    }
+  }
+
   void clear()
   {
     padding();
+    async_writer_.close();
 
     fields_.clear();
     field_sizes_.clear();
@@ -158,15 +243,39 @@ private:
     }
 
     fields_.resize(i);
+    fixed_fields_ = matchFieldTraits();
 
     // Reserve a buffer for writing
     write_size_ = point_size_ * block_size_;
     buffer_ = new char[write_size_];
   }
 
+  // Check if the header fields are exactly the float32 fields listed in PointFieldTraits
+  bool matchFieldTraits() const
+  {
+    using Traits = PointFieldTraits<PointT>;
+
+    if (fields_.size() != Traits::size) {
+      return false;
+    }
+
+    for (size_t fid = 0; fid < Traits::size; ++fid) {
+      const auto & field = fields_[fid];
+
+      if (
+        field.name != Traits::names[fid] || field.offset != Traits::offsets[fid] ||
+        field.datatype != pcl::PCLPointField::FLOAT32 || field.count != 1) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   // Metadata
   std::vector<pcl::PCLPointField> fields_;
   std::vector<size_t> field_sizes_;
+  bool fixed_fields_ = false;
 
   // Number of points in the PCD file
   size_t point_num_;
@@ -175,8 +284,14 @@ private:
   size_t block_size_ = 30000000;  // Maximum number of points to write in each writeABlock
   size_t point_size_, write_size_;
   char * buffer_;
+  // Formatted lines of an ASCII PCD, written to the file when they exceed ascii_flush_size_
+  std::vector<char> ascii_buffer_;
+  static constexpr size_t ascii_flush_size_ = 1 << 20;
   std::string pcd_path_;      // Path to the current opening PCD
   size_t written_point_num_;  // To track the number of points written to the file
+  AsyncIOOptions async_options_;
+  // Writer of the opening PCD, if it is written through io_uring
+  AsyncFileWriter async_writer_;
 };
 
 template <typename PointT>
@@ -185,9 +300,11 @@ void CustomPCDWriter<PointT>::setOutput(const std::string & pcd_path)
   clear();
   init();
 
-  file_.open(pcd_path);
+  if (!async_writer_.open(pcd_path, async_options_)) {
+    file_.open(pcd_path);
+  }
 
-  if (!file_.is_open()) {
+  if (!file_.is_open() && !async_writer_.is_open()) {
     fprintf(
       stderr, "[%s, %d] %s::Error: Failed to open a file at %s\n", __FILE__, __LINE__, __func__,
       pcd_path.c_str());
@@ -200,7 +317,7 @@ void CustomPCDWriter<PointT>::setOutput(const std::string & pcd_path)
 template <typename PointT>
 void CustomPCDWriter<PointT>::writeMetadata(size_t point_num, bool binary_mode)
 {
-  if (!file_.is_open()) {
+  if (!file_.is_open() && !async_writer_.is_open()) {
     fprintf(
       stderr, "[%s, %d] %s::Error: File is not opening at %s!\n", __FILE__, __LINE__, __func__,
       pcd_path_.c_str());
@@ -210,16 +327,11 @@ void CustomPCDWriter<PointT>::writeMetadata(size_t point_num, bool binary_mode)
   pcl::PCDWriter pcd_writer;
   std::string pcd_metadata = pcd_writer.generateHeader(PclCloudType(), point_num);
 
-  file_ << pcd_metadata;
-
   binary_ = binary_mode;
   point_num_ = point_num;
+  pcd_metadata += binary_ ? "DATA binary\n" : "DATA ascii\n";
 
-  if (binary_) {
-    file_ << "DATA binary" << std::endl;
-  } else {
-    file_ << "DATA ascii" << std::endl;
-  }
+  writeBytes(pcd_metadata.data(), pcd_metadata.size());
 }
 
 template <typename PointT>
@@ -230,9 +342,17 @@ void CustomPCDWriter<PointT>::write(const PclCloudType & input)
       (read_loc + block_size_ < input.size()) ? block_size_ : input.size() - read_loc;
 
     if (binary_) {
-      writeABlockBinary(input, read_loc, proc_size);
+      if (fixed_fields_) {
+        writeABlockBinaryFixed(input, read_loc, proc_size);
+      } else {
+        writeABlockBinary(input, read_loc, proc_size);
+      }
     } else {
-      writeABlockASCII(input, read_loc, proc_size);
+      if (fixed_fields_) {
+        writeABlockASCIIFixed(input, read_loc, proc_size);
+      } else {
+        writeABlockASCII(input, read_loc, proc_size);
+      }
     }
   }
 
@@ -244,7 +364,7 @@ void CustomPCDWriter<PointT>::writeABlockBinary(
   const PclCloudType & input, size_t loc, size_t proc_size)
 {
   // Read points to the write buffer
-  for (size_t i = loc, write_loc = 0; i < proc_size; ++i) {
+  for (size_t i = loc, write_loc = 0; i < loc + proc_size; ++i) {
     const char * p = reinterpret_cast<const char *>(&input[i]);
 
     for (size_t fid = 0; fid < fields_.size(); ++fid) {
@@ -254,187 +374,175 @@ void CustomPCDWriter<PointT>::writeABlockBinary(
   }
 
   // Write the buffer to the file
-  file_.write(buffer_, proc_size * point_size_);
+  writeBytes(buffer_, proc_size * point_size_);
 }
 
 template <typename PointT>
 void CustomPCDWriter<PointT>::writeABlockASCII(
   const PclCloudType & cloud, size_t loc, size_t proc_size)
 {
-  // To reduce I/O cost, write several points together
-  std::ostringstream stream;
-  // When the number of points in the stream reach this number, write the stream to file
-  const size_t max_point_num = 10;
-  size_t packed_point_num = 0;
-
-  for (size_t i = loc; i < proc_size; ++i) {
-    auto & point = cloud[i];
-
-    // Copied from the PCL library
-    for (size_t d = 0; d < fields_.size(); ++d) {
-      // Ignore invalid padded dimensions that are inherited from binary data
-      if (fields_[d].name == "_") continue;
-
-      int count = fields_[d].count;
-      if (count == 0)
-        count = 1;  // we simply cannot tolerate 0 counts (coming from older converter code)
-
-      for (int c = 0; c < count; ++c) {
-        switch (fields_[d].datatype) {
-          // TODO(anh.nguyen.2@tier4.jp): PCL 1.12 has not supported BOOL, INT64, and UINT64 yet
-          // case pcl::PCLPointField::BOOL:
-          // {
-          //   bool value;
-          //   memcpy (&value, reinterpret_cast<const char*>(&point) + fields_[d].offset + c *
-          //   sizeof(bool), sizeof(bool)); stream << boost::numeric_cast<std::int32_t>(value);
-          //   break;
-          // }
-          case pcl::PCLPointField::INT8: {
-            std::int8_t value;
-            memcpy(
-              &value,
-              reinterpret_cast<const char *>(&point) + fields_[d].offset + c * sizeof(std::int8_t),
-              sizeof(std::int8_t));
-            stream << boost::numeric_cast<std::int32_t>(value);
+  size_t value_num = 0;
+
+  for (const auto & field : fields_) {
+    // we simply cannot tolerate 0 counts (coming from older converter code)
+    value_num += std::max<size_t>(field.count, 1);
+  }
+
+  // The lines are formatted in a buffer, which is written to the file when it is full enough
+  ascii_buffer_.resize(ascii_flush_size_ + value_num * (max_ascii_value_size + 1) + 1);
+
+  char * const begin = ascii_buffer_.data();
+  char * dst = begin;
+
+  for (size_t i = loc; i < loc + proc_size; ++i) {
+    const char * point = reinterpret_cast<const char *>(&cloud[i]);
+    char * line = dst;
+
+    for (const auto & field : fields_) {
+      const size_t count = std::max<size_t>(field.count, 1);
+
+      for (size_t c = 0; c < count; ++c) {
+        const char * src = point + field.offset + c * pcl::getFieldSize(field.datatype);
+
+        // TODO(anh.nguyen.2@tier4.jp): PCL 1.12 has not supported BOOL, INT64, and UINT64 yet
+        switch (field.datatype) {
+          case pcl::PCLPointField::INT8:
+            dst = formatASCIIValue<std::int8_t, std::int32_t>(dst, src);
             break;
-          }
-          case pcl::PCLPointField::UINT8: {
-            std::uint8_t value;
-            memcpy(
-              &value,
-              reinterpret_cast<const char *>(&point) + fields_[d].offset + c * sizeof(std::uint8_t),
-              sizeof(std::uint8_t));
-            stream << boost::numeric_cast<std::uint32_t>(value);
+          case pcl::PCLPointField::UINT8:
+            dst = formatASCIIValue<std::uint8_t, std::uint32_t>(dst, src);
             break;
-          }
-          case pcl::PCLPointField::INT16: {
-            std::int16_t value;
-            memcpy(
-              &value,
-              reinterpret_cast<const char *>(&point) + fields_[d].offset + c * sizeof(std::int16_t),
-              sizeof(std::int16_t));
-            stream << boost::numeric_cast<std::int16_t>(value);
+          case pcl::PCLPointField::INT16:
+            dst = formatASCIIValue<std::int16_t>(dst, src);
             break;
-          }
-          case pcl::PCLPointField::UINT16: {
-            std::uint16_t value;
-            memcpy(
-              &value,
-              reinterpret_cast<const char *>(&point) + fields_[d].offset +
-                c * sizeof(std::uint16_t),
-              sizeof(std::uint16_t));
-            stream << boost::numeric_cast<std::uint16_t>(value);
+          case pcl::PCLPointField::UINT16:
+            dst = formatASCIIValue<std::uint16_t>(dst, src);
             break;
-          }
-          case pcl::PCLPointField::INT32: {
-            std::int32_t value;
-            memcpy(
-              &value,
-              reinterpret_cast<const char *>(&point) + fields_[d].offset + c * sizeof(std::int32_t),
-              sizeof(std::int32_t));
-            stream << boost::numeric_cast<std::int32_t>(value);
+          case pcl::PCLPointField::INT32:
+            dst = formatASCIIValue<std::int32_t>(dst, src);
             break;
-          }
-          case pcl::PCLPointField::UINT32: {
-            std::uint32_t value;
-            memcpy(
-              &value,
-              reinterpret_cast<const char *>(&point) + fields_[d].offset +
-                c * sizeof(std::uint32_t),
-              sizeof(std::uint32_t));
-            stream << boost::numeric_cast<std::uint32_t>(value);
+          case pcl::PCLPointField::UINT32:
+            dst = formatASCIIValue<std::uint32_t>(dst, src);
             break;
-          }
-          // case pcl::PCLPointField::INT64:
-          // {
-          //   std::int64_t value;
-          //   memcpy (&value, reinterpret_cast<const char*>(&point) + fields_[d].offset + c *
-          //   sizeof(std::int64_t), sizeof(std::int64_t)); stream <<
-          //   boost::numeric_cast<std::int64_t>(value); break;
-          // }
-          // case pcl::PCLPointField::UINT64:
-          // {
-          //   std::uint64_t value;
-          //   memcpy (&value, reinterpret_cast<const char*>(&point) + fields_[d].offset + c *
-          //   sizeof(std::uint64_t), sizeof(std::uint64_t)); stream <<
-          //   boost::numeric_cast<std::uint64_t>(value); break;
-          // }
-          case pcl::PCLPointField::FLOAT32: {
+          case pcl::PCLPointField::FLOAT32:
             /*
              * Despite the float type, store the rgb field as uint32
              * because several fully opaque color values are mapped to
              * nan.
              */
-            if ("rgb" == fields_[d].name) {
-              std::uint32_t value;
-              memcpy(
-                &value,
-                reinterpret_cast<const char *>(&point) + fields_[d].offset + c * sizeof(float),
-                sizeof(float));
-              stream << boost::numeric_cast<std::uint32_t>(value);
-              break;
+            if ("rgb" == field.name) {
+              dst = formatASCIIValue<std::uint32_t>(dst, src);
+            } else {
+              dst = formatASCIIValue<float>(dst, src);
             }
-            float value;
-            memcpy(
-              &value,
-              reinterpret_cast<const char *>(&point) + fields_[d].offset + c * sizeof(float),
-              sizeof(float));
-            if (std::isnan(value))
-              stream << "nan";
-            else
-              stream << boost::numeric_cast<float>(value);
             break;
-          }
-          case pcl::PCLPointField::FLOAT64: {
-            double value;
-            memcpy(
-              &value,
-              reinterpret_cast<const char *>(&point) + fields_[d].offset + c * sizeof(double),
-              sizeof(double));
-            if (std::isnan(value))
-              stream << "nan";
-            else
-              stream << boost::numeric_cast<double>(value);
+          case pcl::PCLPointField::FLOAT64:
+            dst = formatASCIIValue<double>(dst, src);
             break;
-          }
           default:
             fprintf(
               stderr, "[%s, %d] %s::Incorrect field data type specified (%d)!\n", __FILE__,
-              __LINE__, __func__, fields_[d].datatype);
+              __LINE__, __func__, field.datatype);
             break;
         }
 
-        if (d < fields_.size() - 1 || c < static_cast<int>(fields_[d].count - 1)) {
-          stream << " ";
-        }
+        *dst++ = ' ';
       }
     }
 
-    stream << "\n";
+    // Replace the last separator with the line break
+    if (dst > line) {
+      --dst;
+    }
 
-    ++packed_point_num;
+    *dst++ = '\n';
 
-    if (packed_point_num == max_point_num) {
-      // Copy the stream, trim it, and write it to disk
-      std::string result = stream.str();
-      boost::trim(result);
-      stream.str("");
-      file_ << result << "\n";
-      packed_point_num = 0;
+    if (static_cast<size_t>(dst - begin) >= ascii_flush_size_) {
+      writeBytes(begin, dst - begin);
+      dst = begin;
     }
   }
 
-  // Write the rest of stream to file
-  if (packed_point_num > 0) {
-    // Copy the stream, trim it, and write it to disk
-    std::string result = stream.str();
-    boost::trim(result);
-    stream.str("");
-    file_ << result << "\n";
-    packed_point_num = 0;
+  // Write the rest of the buffer to file
+  writeBytes(begin, dst - begin);
+}
+
+template <typename PointT>
+void CustomPCDWriter<PointT>::encodeBinary(const PclCloudType & input, char * output) const
+{
+  using Traits = PointFieldTraits<PointT>;
+
+  if (fixed_fields_) {
+    for (const auto & p : input) {
+      for (size_t fid = 0; fid < Traits::size; ++fid, output += sizeof(float)) {
+        memcpy(output, fieldPtr(p, fid), sizeof(float));
+      }
+    }
+
+    return;
+  }
+
+  for (const auto & point : input) {
+    const char * p = reinterpret_cast<const char *>(&point);
+
+    for (size_t fid = 0; fid < fields_.size(); ++fid) {
+      memcpy(output, p + fields_[fid].offset, field_sizes_[fid]);
+      output += field_sizes_[fid];
+    }
   }
 }
 
+template <typename PointT>
+void CustomPCDWriter<PointT>::writeABlockBinaryFixed(
+  const PclCloudType & input, size_t loc, size_t proc_size)
+{
+  using Traits = PointFieldTraits<PointT>;
+
+  char * dst = buffer_;
+
+  for (size_t i = loc; i < loc + proc_size; ++i) {
+    for (size_t fid = 0; fid < Traits::size; ++fid, dst += sizeof(float)) {
+      memcpy(dst, fieldPtr(input[i], fid), sizeof(float));
+    }
+  }
+
+  writeBytes(buffer_, proc_size * point_size_);
+}
+
+template <typename PointT>
+void CustomPCDWriter<PointT>::writeABlockASCIIFixed(
+  const PclCloudType & cloud, size_t loc, size_t proc_size)
+{
+  using Traits = PointFieldTraits<PointT>;
+
+  // Same formatting as writeABlockASCII, without the per-field type dispatch
+  ascii_buffer_.resize(ascii_flush_size_ + Traits::size * (max_ascii_value_size + 1));
+
+  char * const begin = ascii_buffer_.data();
+  char * dst = begin;
+
+  for (size_t i = loc; i < loc + proc_size; ++i) {
+    for (size_t fid = 0; fid < Traits::size; ++fid) {
+      const char * field = reinterpret_cast<const char *>(fieldPtr(cloud[i], fid));
+
+      if (Traits::color[fid]) {
+        dst = formatASCIIValue<std::uint32_t>(dst, field);
+      } else {
+        dst = formatASCIIValue<float>(dst, field);
+      }
+
+      *dst++ = (fid < Traits::size - 1) ? ' ' : '\n';
+    }
+
+    if (static_cast<size_t>(dst - begin) >= ascii_flush_size_) {
+      writeBytes(begin, dst - begin);
+      dst = begin;
+    }
+  }
+
+  writeBytes(begin, dst - begin);
+}
+
 template <typename PointT>
 void CustomPCDWriter<PointT>::padding()
 {
@@ -453,6 +561,90 @@ void CustomPCDWriter<PointT>::padding()
   }
 }
 
+// Save a PCD whose x, y, z are int16 offsets from @origin in units of @step, while the
+// other fields are kept as they are. The origin is written to the VIEWPOINT of the header,
+// so the coordinates are restored as origin + offset * step. Return false without writing
+// anything if the offset of a point does not fit in int16.
+template <typename PointT>
+bool saveQuantizedPCD(
+  const std::string & pcd_path, const pcl::PointCloud<PointT> & cloud,
+  const std::array<double, 3> & origin, double step)
+{
+  using Traits = PointFieldTraits<PointT>;
+
+  const double max_offset = 32767 * step;
+
+  for (const auto & p : cloud) {
+    for (size_t fid = 0; fid < 3; ++fid) {
+      if (std::abs(*fieldPtr(p, fid) - origin[fid]) > max_offset) {
+        return false;
+      }
+    }
+  }
+
+  std::ofstream file(pcd_path, std::ios::binary);
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file << "# .PCD v0.7 - Point Cloud Data file format" << std::endl;
+  file << "VERSION 0.7" << std::endl;
+  file << "FIELDS";
+
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    file << " " << Traits::names[fid];
+  }
+
+  file << std::endl << "SIZE";
+
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    file << ((fid < 3) ? " 2" : " 4");
+  }
+
+  file << std::endl << "TYPE";
+
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    file << ((fid < 3) ? " I" : (Traits::color[fid] ? " U" : " F"));
+  }
+
+  file << std::endl << "COUNT";
+
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    file << " 1";
+  }
+
+  file << std::endl;
+  file << "WIDTH " << cloud.size() << std::endl;
+  file << "HEIGHT 1" << std::endl;
+  file << std::setprecision(17) << "VIEWPOINT " << origin[0] << " " << origin[1] << " "
+       << origin[2] << " 1 0 0 0" << std::endl;
+  file << "POINTS " << cloud.size() << std::endl;
+  file << "DATA binary" << std::endl;
+
+  const size_t row_size = 3 * sizeof(int16_t) + (Traits::size - 3) * sizeof(float);
+  std::vector<char> buffer(row_size * cloud.size());
+  char * out = buffer.data();
+
+  for (const auto & p : cloud) {
+    for (size_t fid = 0; fid < 3; ++fid) {
+      auto q = static_cast<int16_t>(std::lround((*fieldPtr(p, fid) - origin[fid]) / step));
+
+      memcpy(out, &q, sizeof(int16_t));
+      out += sizeof(int16_t);
+    }
+
+    for (size_t fid = 3; fid < Traits::size; ++fid) {
+      memcpy(out, fieldPtr(p, fid), sizeof(float));
+      out += sizeof(float);
+    }
+  }
+
+  file.write(buffer.data(), buffer.size());
+
+  return file.good();
+}
+
 }  // namespace autoware::pointcloud_divider
 
 #endif  // AUTOWARE__POINTCLOUD_DIVIDER__PCD_IO_WRITER_HPP_
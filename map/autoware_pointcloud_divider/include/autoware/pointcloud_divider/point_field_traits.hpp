@@ -0,0 +1,99 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__POINT_FIELD_TRAITS_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__POINT_FIELD_TRAITS_HPP_
+
+#include <pcl/point_types.h>
+
+#include <array>
+#include <cstddef>
+
+namespace autoware::pointcloud_divider
+{
+
+// Compile-time description of the fields of a supported point type. All fields are
+// 4-byte members of the point, listed in the same order as pcl::getFields<PointT>().
+//   names:   field names in PCD files
+//   offsets: byte offsets of the fields in PointT
+//   color:   packed RGB fields, which are written as uint32 in ASCII PCDs and are not
+//            averaged when downsampling (the color of the first point of a voxel is kept)
+template <typename PointT>
+struct PointFieldTraits;
+
+template <>
+struct PointFieldTraits<pcl::PointXYZ>
+{
+  static constexpr size_t size = 3;
+  static constexpr std::array<const char *, size> names = {"x", "y", "z"};
+  static constexpr std::array<size_t, size> offsets = {
+    offsetof(pcl::PointXYZ, x), offsetof(pcl::PointXYZ, y), offsetof(pcl::PointXYZ, z)};
+  static constexpr std::array<bool, size> color = {false, false, false};
+};
+
+template <>
+struct PointFieldTraits<pcl::PointXYZI>
+{
+  static constexpr size_t size = 4;
+  static constexpr std::array<const char *, size> names = {"x", "y", "z", "intensity"};
+  static constexpr std::array<size_t, size> offsets = {
+    offsetof(pcl::PointXYZI, x), offsetof(pcl::PointXYZI, y), offsetof(pcl::PointXYZI, z),
+    offsetof(pcl::PointXYZI, intensity)};
+  static constexpr std::array<bool, size> color = {false, false, false, false};
+};
+
+template <>
+struct PointFieldTraits<pcl::PointXYZRGB>
+{
+  static constexpr size_t size = 4;
+  static constexpr std::array<const char *, size> names = {"x", "y", "z", "rgb"};
+  static constexpr std::array<size_t, size> offsets = {
+    offsetof(pcl::PointXYZRGB, x), offsetof(pcl::PointXYZRGB, y), offsetof(pcl::PointXYZRGB, z),
+    offsetof(pcl::PointXYZRGB, rgb)};
+  static constexpr std::array<bool, size> color = {false, false, false, true};
+};
+
+template <>
+struct PointFieldTraits<pcl::PointXYZINormal>
+{
+  static constexpr size_t size = 8;
+  static constexpr std::array<const char *, size> names = {
+    "x", "y", "z", "intensity", "normal_x", "normal_y", "normal_z", "curvature"};
+  static constexpr std::array<size_t, size> offsets = {
+    offsetof(pcl::PointXYZINormal, x),        offsetof(pcl::PointXYZINormal, y),
+    offsetof(pcl::PointXYZINormal, z),        offsetof(pcl::PointXYZINormal, intensity),
+    offsetof(pcl::PointXYZINormal, normal_x), offsetof(pcl::PointXYZINormal, normal_y),
+    offsetof(pcl::PointXYZINormal, normal_z), offsetof(pcl::PointXYZINormal, curvature)};
+  static constexpr std::array<bool, size> color = {
+    false, false, false, false, false, false, false, false};
+};
+
+// Accessors to the fields of a point by their index in PointFieldTraits
+template <typename PointT>
+inline float * fieldPtr(PointT & p, size_t fid)
+{
+  return reinterpret_cast<float *>(
+    reinterpret_cast<char *>(&p) + PointFieldTraits<PointT>::offsets[fid]);
+}
+
+template <typename PointT>
+inline const float * fieldPtr(const PointT & p, size_t fid)
+{
+  return reinterpret_cast<const float *>(
+    reinterpret_cast<const char *>(&p) + PointFieldTraits<PointT>::offsets[fid]);
+}
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__POINT_FIELD_TRAITS_HPP_
@@ -0,0 +1,135 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__RAW_PCD_DIVIDER_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__RAW_PCD_DIVIDER_HPP_
+
+#include "grid_info.hpp"
+#include "tile_index.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Layout of the records of a binary PCD, parsed from its header
+struct RawPCDHeader
+{
+  // VERSION, FIELDS, SIZE, TYPE, and COUNT lines as they are in the file
+  std::vector<std::string> schema_lines;
+  // FIELDS, SIZE, TYPE, and COUNT with single spaces, to compare the schemas of the files
+  std::string layout;
+  size_t point_num = 0;
+  size_t record_size = 0;
+  // Offset of the first record from the beginning of the file
+  size_t data_offset = 0;
+  // Offsets of the coordinates in a record, and their sizes (4 or 8, z is 0 if missing)
+  size_t x_offset = 0, y_offset = 0, z_offset = 0;
+  size_t x_size = 0, y_size = 0, z_size = 0;
+};
+
+// Parse the header of an uncompressed binary PCD. Return false with the reason in @error if the
+// file is not one, or if its x and y are not float32 or float64 scalars.
+bool readRawPCDHeader(const std::string & path, RawPCDHeader & header, std::string & error);
+
+// Divider that bins the records of binary PCDs as opaque bytes. Only the coordinates are decoded
+// to find the grid of a record, so every field of the input is kept as it is, whatever the point
+// type is. The segments are not downsampled, and all the inputs must have the same fields.
+class RawPCDDivider
+{
+public:
+  explicit RawPCDDivider(const rclcpp::Logger & logger) : logger_(logger) {}
+
+  void setInput(const std::string & input_pcd_or_dir) { input_pcd_or_dir_ = input_pcd_or_dir; }
+
+  void setOutputDir(const std::string & output_dir)
+  {
+    output_dir_ = output_dir;
+    tmp_dir_ = output_dir + "/tmp/";
+  }
+
+  void setPrefix(const std::string & prefix) { file_prefix_ = prefix; }
+
+  void setGridSize(float res_x, float res_y)
+  {
+    grid_size_x_ = res_x;
+    grid_size_y_ = res_y;
+  }
+
+  void setLargeGridMode(bool use_large_grid) { use_large_grid_ = use_large_grid; }
+
+  // Number of segments along each axis of a large grid
+  void setLargeGridFactor(size_t large_grid_factor)
+  {
+    large_grid_factor_ = std::max<size_t>(large_grid_factor, 1);
+  }
+
+  // Limit the records resident in memory to @budget bytes, beyond which the largest segments are
+  // appended to the tmp directory. Setting to 0 keeps 100M records at max.
+  void setMemoryBudget(size_t budget) { memory_budget_ = budget; }
+
+  void setDebugMode(bool mode) { debug_mode_ = mode; }
+
+  void run();
+  void run(const std::vector<std::string> & pcd_names);
+
+private:
+  // Records of a segment, the resident ones and the ones appended to its tmp file
+  struct Segment
+  {
+    std::vector<char> records;
+    size_t spilled_num = 0;
+    float z_min = std::numeric_limits<float>::max();
+    float z_max = std::numeric_limits<float>::lowest();
+  };
+
+  std::string input_pcd_or_dir_, output_dir_, tmp_dir_, file_prefix_;
+  double grid_size_x_ = 100;
+  double grid_size_y_ = 100;
+  bool use_large_grid_ = false;
+  size_t large_grid_factor_ = 10;
+  size_t memory_budget_ = 0;
+  bool debug_mode_ = true;
+  rclcpp::Logger logger_;
+
+  // Header of the first input, which the other inputs and the output segments share
+  RawPCDHeader schema_;
+  std::unordered_map<GridInfo<2>, Segment> segments_;
+  size_t resident_bytes_ = 0;
+  size_t max_resident_bytes_ = 0;
+  size_t spilled_bytes_ = 0;
+
+  void checkOutputDirectoryValidity();
+  void divide(const std::string & pcd_name);
+  // Append the largest resident segment to its tmp file
+  void spillLargestSegment();
+  void saveSegment(const GridInfo<2> & grid, Segment & segment, TileRecord & record);
+  GridInfo<2> toLargeGrid(const GridInfo<2> & grid) const;
+  std::string makeFileName(const GridInfo<2> & grid) const;
+  std::string makeSegmentPath(const GridInfo<2> & grid) const;
+  std::string makeTmpPath(const GridInfo<2> & grid) const;
+  void saveGridInfoToYAML(const std::vector<GridInfo<2>> & grids);
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__RAW_PCD_DIVIDER_HPP_
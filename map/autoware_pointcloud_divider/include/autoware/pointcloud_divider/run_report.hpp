@@ -0,0 +1,416 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__RUN_REPORT_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__RUN_REPORT_HPP_
+
+#include <autoware/tool_tracing/tracing.hpp>
+
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace autoware::pointcloud_divider
+{
+
+// Instrumentation of a run of the map tools. The tools time their phases (read, bin, spill,
+// finalize, voxel, write...) with time(), and count the bytes and points the phases process.
+// The report is written as JSON at the end of the run, and a summary line can be logged
+// periodically while the run is in progress.
+//
+// The wall and CPU times of a phase are summed over the threads running it, so their ratio tells
+// whether the phase spends its time computing or waiting for the storage. The phases may nest,
+// e.g. finalize includes the voxel and write of the segments it finalizes. The phases are also
+// traced as the stages of the tool, to get their timeline.
+class RunReport
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Add the wall and CPU times of the calling thread to a phase when it goes out of scope.
+  // If @process_cpu is true, the CPU time of the whole process is measured instead, for the
+  // phases parallelized by OpenMP. It then includes the other phases running at the same time.
+  class PhaseTimer
+  {
+  public:
+    PhaseTimer(RunReport * report, const char * phase, bool process_cpu = false)
+    : report_(report),
+      phase_(phase),
+      process_cpu_(process_cpu),
+      start_(Clock::now()),
+      cpu_start_(cpuTime())
+    {
+      if (report_) {
+        tool_tracing::traceStageBegin(report_->tool_.c_str(), phase_);
+      }
+    }
+
+    PhaseTimer(PhaseTimer && other) noexcept
+    : report_(other.report_),
+      phase_(other.phase_),
+      process_cpu_(other.process_cpu_),
+      start_(other.start_),
+      cpu_start_(other.cpu_start_)
+    {
+      other.report_ = nullptr;
+    }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer & operator=(const PhaseTimer &) = delete;
+    PhaseTimer & operator=(PhaseTimer &&) = delete;
+
+    ~PhaseTimer()
+    {
+      if (report_) {
+        report_->addTime(phase_, start_, Clock::now(), cpuTime() - cpu_start_);
+        tool_tracing::traceStageEnd(report_->tool_.c_str(), phase_);
+      }
+    }
+
+  private:
+    double cpuTime() const { return process_cpu_ ? processCPUTime() : threadCPUTime(); }
+
+    RunReport * report_;
+    const char * phase_;
+    bool process_cpu_;
+    Clock::time_point start_;
+    double cpu_start_;
+  };
+
+  explicit RunReport(const std::string & tool = "") : tool_(tool) { reset(); }
+
+  ~RunReport() { stopProgress(); }
+
+  RunReport(const RunReport &) = delete;
+  RunReport & operator=(const RunReport &) = delete;
+
+  void reset()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    phases_.clear();
+    counters_.clear();
+    start_ = Clock::now();
+    cpu_start_ = processCPUTime();
+  }
+
+  PhaseTimer time(const char * phase, bool process_cpu = false)
+  {
+    return PhaseTimer(this, phase, process_cpu);
+  }
+
+  void addBytes(const char * phase, uint64_t bytes)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    phases_[phase].bytes += bytes;
+  }
+
+  void addPoints(const char * phase, uint64_t points)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    phases_[phase].points += points;
+  }
+
+  void count(const char * counter, uint64_t value = 1)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    counters_[counter] += value;
+  }
+
+  // Log a summary line every @period seconds until stopProgress() is called
+  void startProgress(double period, std::function<void(const std::string &)> log)
+  {
+    stopProgress();
+
+    if (period <= 0) {
+      return;
+    }
+
+    stop_progress_ = false;
+    progress_thread_ = std::thread([this, period, log = std::move(log)]() {
+      const auto wait = std::chrono::duration<double>(period);
+      std::unique_lock<std::mutex> lock(progress_mtx_);
+
+      while (!progress_cv_.wait_for(lock, wait, [this]() { return stop_progress_; })) {
+        log(summary());
+      }
+    });
+  }
+
+  void stopProgress()
+  {
+    if (!progress_thread_.joinable()) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(progress_mtx_);
+      stop_progress_ = true;
+    }
+
+    progress_cv_.notify_all();
+    progress_thread_.join();
+  }
+
+  // One line with the elapsed time, the progress of each phase, and the memory usage
+  std::string summary() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::ostringstream out;
+    char buf[128];
+
+    std::snprintf(buf, sizeof(buf), "%s: %.1f s", tool_.c_str(), elapsed());
+    out << buf;
+
+    for (const auto & it : phases_) {
+      const auto & p = it.second;
+
+      std::snprintf(
+        buf, sizeof(buf), ", %s %.1f s (%.0f%% cpu)", it.first.c_str(), p.wall_time,
+        p.wall_time > 0 ? 100 * p.cpu_time / p.wall_time : 0.0);
+      out << buf;
+
+      if (p.points > 0) {
+        std::snprintf(buf, sizeof(buf), " %.2f Mpts", p.points * 1e-6);
+        out << buf;
+      }
+
+      if (p.bytes > 0) {
+        std::snprintf(buf, sizeof(buf), " %.1f MiB", p.bytes / 1048576.0);
+        out << buf;
+      }
+    }
+
+    std::snprintf(buf, sizeof(buf), ", peak rss %.1f MiB", peakRSS() / 1048576.0);
+    out << buf;
+
+    return out.str();
+  }
+
+  std::string toJSON() const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::ostringstream out;
+    const double elapsed_time = elapsed();
+    const double cpu_time = processCPUTime() - cpu_start_;
+    uint64_t storage_read = 0, storage_write = 0;
+    const bool has_io = storageIO(storage_read, storage_write);
+
+    out << "{\n";
+    out << "  \"tool\": \"" << tool_ << "\",\n";
+    out << "  \"wall_time\": " << number(elapsed_time) << ",\n";
+    out << "  \"cpu_time\": " << number(cpu_time) << ",\n";
+    // Average number of cores busy during the run
+    out << "  \"cpu_utilization\": " << number(ratio(cpu_time, elapsed_time)) << ",\n";
+    out << "  \"peak_rss_bytes\": " << peakRSS() << ",\n";
+
+    if (has_io) {
+      out << "  \"storage_read_bytes\": " << storage_read << ",\n";
+      out << "  \"storage_write_bytes\": " << storage_write << ",\n";
+    }
+
+    out << "  \"phases\": {";
+
+    const char * sep = "\n";
+
+    for (const auto & it : phases_) {
+      const auto & p = it.second;
+      // The throughputs are over the span of the phase, so they count the threads running it
+      const double span = p.span();
+      const double cpu_ratio = ratio(p.cpu_time, p.wall_time);
+
+      out << sep << "    \"" << it.first << "\": {\n";
+      out << "      \"calls\": " << p.calls << ",\n";
+      out << "      \"wall_time\": " << number(p.wall_time) << ",\n";
+      out << "      \"cpu_time\": " << number(p.cpu_time) << ",\n";
+      out << "      \"span\": " << number(span) << ",\n";
+      out << "      \"cpu_ratio\": " << number(cpu_ratio) << ",\n";
+      out << "      \"bound\": \"" << (p.wall_time > 0 ? bound(cpu_ratio) : "none") << "\",\n";
+      out << "      \"bytes\": " << p.bytes << ",\n";
+      out << "      \"bytes_per_sec\": " << number(ratio(p.bytes, span)) << ",\n";
+      out << "      \"points\": " << p.points << ",\n";
+      out << "      \"points_per_sec\": " << number(ratio(p.points, span)) << "\n";
+      out << "    }";
+      sep = ",\n";
+    }
+
+    out << (phases_.empty() ? "},\n" : "\n  },\n");
+    out << "  \"counters\": {";
+    sep = "\n";
+
+    for (const auto & it : counters_) {
+      out << sep << "    \"" << it.first << "\": " << it.second;
+      sep = ",\n";
+    }
+
+    out << (counters_.empty() ? "}\n" : "\n  }\n");
+    out << "}\n";
+
+    return out.str();
+  }
+
+  bool save(const std::string & path) const
+  {
+    std::ofstream file(path);
+
+    if (!file) {
+      return false;
+    }
+
+    file << toJSON();
+
+    return static_cast<bool>(file);
+  }
+
+  struct Phase
+  {
+    uint64_t calls = 0;
+    double wall_time = 0, cpu_time = 0;
+    Clock::time_point first_start = Clock::time_point::max(), last_end;
+    uint64_t bytes = 0, points = 0;
+
+    // Seconds from the first start to the last end of the phase
+    double span() const
+    {
+      return calls > 0 ? std::chrono::duration<double>(last_end - first_start).count() : 0;
+    }
+  };
+
+  // Totals of a phase so far, all zeros if it has not run
+  Phase phase(const std::string & name) const
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = phases_.find(name);
+
+    return it == phases_.end() ? Phase() : it->second;
+  }
+
+private:
+  void addTime(
+    const char * phase, Clock::time_point start, Clock::time_point end, double cpu_time)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto & p = phases_[phase];
+
+    ++p.calls;
+    p.wall_time += std::chrono::duration<double>(end - start).count();
+    p.cpu_time += cpu_time;
+    p.first_start = std::min(p.first_start, start);
+    p.last_end = std::max(p.last_end, end);
+  }
+
+  double elapsed() const { return std::chrono::duration<double>(Clock::now() - start_).count(); }
+
+  static double threadCPUTime()
+  {
+    timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+  }
+
+  // User and system time of all the threads of the process, including the ones of OpenMP
+  static double processCPUTime()
+  {
+    rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 + usage.ru_stime.tv_sec +
+           usage.ru_stime.tv_usec * 1e-6;
+  }
+
+  static uint64_t peakRSS()
+  {
+    rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    // ru_maxrss is in kilobytes on Linux
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+  }
+
+  // Bytes read from and written to the storage by the process, which the page cache does not
+  // serve. Not available if the kernel does not account the I/O of tasks.
+  static bool storageIO(uint64_t & read_bytes, uint64_t & write_bytes)
+  {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value;
+    int found = 0;
+
+    while (io >> key >> value) {
+      if (key == "read_bytes:") {
+        read_bytes = value;
+        ++found;
+      } else if (key == "write_bytes:") {
+        write_bytes = value;
+        ++found;
+      }
+    }
+
+    return found == 2;
+  }
+
+  static double ratio(double a, double b) { return b > 0 ? a / b : 0; }
+
+  // A phase computing most of its time is CPU bound, one waiting most of its time is I/O bound
+  static const char * bound(double cpu_ratio)
+  {
+    if (cpu_ratio >= 0.8) {
+      return "cpu";
+    }
+
+    return cpu_ratio <= 0.5 ? "io" : "mixed";
+  }
+
+  static std::string number(double v)
+  {
+    char buf[32];
+
+    std::snprintf(buf, sizeof(buf), "%.6g", v);
+
+    return buf;
+  }
+
+  std::string tool_;
+  Clock::time_point start_;
+  double cpu_start_ = 0;
+  mutable std::mutex mtx_;
+  std::map<std::string, Phase> phases_;
+  std::map<std::string, uint64_t> counters_;
+
+  std::thread progress_thread_;
+  std::mutex progress_mtx_;
+  std::condition_variable progress_cv_;
+  bool stop_progress_ = false;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__RUN_REPORT_HPP_
@@ -0,0 +1,323 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__SPILL_CHUNK_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__SPILL_CHUNK_HPP_
+
+#include "async_io.hpp"
+#include "point_field_traits.hpp"
+
+#include <pcl/io/lzf.h>
+#include <pcl/point_cloud.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Private format of the temporary segments of the divider. They are only read back by the run
+// that wrote them, or by a run resuming from its checkpoint, so the chunk has a fixed header
+// instead of the ASCII header of a PCD, and is decoded by a plain loop.
+//
+// The coordinates are stored as uint16 multiples of a step from the origin of the chunk. The
+// step is the leaf size of the downsampling divided by a power of two, at most 256, and the
+// origin is a multiple of the step, so the cells of the step do not straddle a voxel. A point
+// is restored to the center of its cell, or of a neighbor cell if the float rounding moves the
+// center to another voxel, so it stays in its voxel and moves by at most 1.5 steps. If the
+// leaf size is 0, or a chunk cannot be quantized that way, the coordinates are stored as float.
+//
+// Layout (little endian):
+//   char[8]     magic "PCDSPIL1"
+//   uint32      number of points, number of fields of the point type
+//   uint32      SPILL_CHUNK_* flags, and a reserved word aligning the doubles
+//   double[3]   origin of x, y, and z
+//   double[3]   step of x, y, and z
+//   uint64      size of the payload in the file, and once decompressed
+//   payload     the x, y, and z columns, followed by a float column per other field
+
+// The coordinates are uint16, otherwise float
+constexpr uint32_t SPILL_CHUNK_QUANTIZED = 1U << 0;
+// The payload is compressed by LZF
+constexpr uint32_t SPILL_CHUNK_LZF = 1U << 1;
+
+struct SpillChunkHeader
+{
+  char magic[8];
+  uint32_t point_num, field_num;
+  uint32_t flags, reserved;
+  double origin[3];
+  double step[3];
+  uint64_t payload_size, raw_size;
+};
+
+// Encode @cloud in @buffer. The coordinates are quantized to a fraction of @leaf_size if it is
+// positive, and the payload is compressed if @compress is true and it gets smaller.
+template <typename PointT>
+void encodeSpillChunk(
+  const pcl::PointCloud<PointT> & cloud, double leaf_size, bool compress,
+  std::vector<char> & buffer)
+{
+  typedef PointFieldTraits<PointT> Traits;
+
+  constexpr int max_shift = 8;
+  const size_t n = cloud.size();
+  SpillChunkHeader header{};
+
+  memcpy(header.magic, "PCDSPIL1", sizeof(header.magic));
+  header.point_num = n;
+  header.field_num = Traits::size;
+
+  // The finest step at which the extent of every axis fits in uint16
+  const float res = static_cast<float>(leaf_size);
+  std::vector<uint16_t> coords;
+
+  if (res > 0 && n > 0) {
+    header.flags |= SPILL_CHUNK_QUANTIZED;
+    coords.resize(3 * n);
+
+    for (int axis = 0; axis < 3 && (header.flags & SPILL_CHUNK_QUANTIZED); ++axis) {
+      const size_t offset = Traits::offsets[axis];
+      auto coord = [offset](const PointT & p) {
+        float v;
+
+        memcpy(&v, reinterpret_cast<const char *>(&p) + offset, sizeof(v));
+
+        return v;
+      };
+      double min = coord(cloud[0]), max = min;
+
+      for (const auto & p : cloud) {
+        min = std::min<double>(min, coord(p));
+        max = std::max<double>(max, coord(p));
+      }
+
+      int shift = max_shift;
+      double origin = 0, step = 0;
+
+      for (; shift >= 0; --shift) {
+        step = static_cast<double>(res) / (1 << shift);
+        origin = std::floor(min / step) * step;
+
+        if (std::floor((max - origin) / step) <= UINT16_MAX) {
+          break;
+        }
+      }
+
+      header.origin[axis] = origin;
+      header.step[axis] = step;
+
+      // The voxels are computed in float as pointToGrid3 does, so a point close to the border of
+      // a voxel may be restored across it. The neighbor cells are tried then, and the chunk keeps
+      // the float coordinates if none of them is in the voxel.
+      auto restore = [origin, step](int64_t q) {
+        return static_cast<float>(origin + (q + 0.5) * step);
+      };
+
+      for (size_t i = 0; i < n && shift >= 0; ++i) {
+        const float v = coord(cloud[i]);
+        const float voxel = std::floor(v / res);
+        const int64_t q = std::clamp<int64_t>(std::floor((v - origin) / step), 0, UINT16_MAX);
+        int64_t best = -1;
+
+        for (int64_t c : {q, q - 1, q + 1}) {
+          if (c >= 0 && c <= UINT16_MAX && std::floor(restore(c) / res) == voxel) {
+            best = c;
+            break;
+          }
+        }
+
+        if (best < 0) {
+          shift = -1;
+        } else {
+          coords[axis * n + i] = static_cast<uint16_t>(best);
+        }
+      }
+
+      if (shift < 0) {
+        header.flags &= ~SPILL_CHUNK_QUANTIZED;
+      }
+    }
+  }
+
+  const bool quantized = header.flags & SPILL_CHUNK_QUANTIZED;
+  const size_t coord_size = quantized ? sizeof(uint16_t) : sizeof(float);
+  std::vector<char> raw(n * (3 * coord_size + (Traits::size - 3) * sizeof(float)));
+  char * dst = raw.data();
+
+  for (size_t f = 0; f < Traits::size; ++f) {
+    if (f < 3 && quantized) {
+      memcpy(dst, coords.data() + f * n, n * sizeof(uint16_t));
+      dst += n * sizeof(uint16_t);
+    } else {
+      for (const auto & p : cloud) {
+        memcpy(dst, reinterpret_cast<const char *>(&p) + Traits::offsets[f], sizeof(float));
+        dst += sizeof(float);
+      }
+    }
+  }
+
+  header.raw_size = raw.size();
+  header.payload_size = raw.size();
+  buffer.resize(sizeof(header) + raw.size());
+
+  // LZF fails if the output does not fit, in which case the payload is stored as is
+  if (compress && raw.size() > 0 && raw.size() < UINT_MAX) {
+    const unsigned int compressed_size =
+      pcl::lzfCompress(raw.data(), raw.size(), buffer.data() + sizeof(header), raw.size() - 1);
+
+    if (compressed_size > 0) {
+      header.flags |= SPILL_CHUNK_LZF;
+      header.payload_size = compressed_size;
+      buffer.resize(sizeof(header) + compressed_size);
+    }
+  }
+
+  if (!(header.flags & SPILL_CHUNK_LZF) && !raw.empty()) {
+    memcpy(buffer.data() + sizeof(header), raw.data(), raw.size());
+  }
+
+  memcpy(buffer.data(), &header, sizeof(header));
+}
+
+// Decode a chunk written by encodeSpillChunk for the same point type to @cloud. Return false if
+// @buffer is not such a chunk.
+template <typename PointT>
+bool decodeSpillChunk(const std::vector<char> & buffer, pcl::PointCloud<PointT> & cloud)
+{
+  typedef PointFieldTraits<PointT> Traits;
+
+  SpillChunkHeader header;
+
+  if (buffer.size() < sizeof(header)) {
+    return false;
+  }
+
+  memcpy(&header, buffer.data(), sizeof(header));
+
+  const bool quantized = header.flags & SPILL_CHUNK_QUANTIZED;
+  const size_t n = header.point_num;
+  const size_t coord_size = quantized ? sizeof(uint16_t) : sizeof(float);
+
+  if (
+    memcmp(header.magic, "PCDSPIL1", sizeof(header.magic)) != 0 ||
+    header.field_num != Traits::size ||
+    header.raw_size != n * (3 * coord_size + (Traits::size - 3) * sizeof(float)) ||
+    buffer.size() != sizeof(header) + header.payload_size) {
+    return false;
+  }
+
+  const char * src = buffer.data() + sizeof(header);
+  std::vector<char> raw;
+
+  if (header.flags & SPILL_CHUNK_LZF) {
+    raw.resize(header.raw_size);
+
+    if (pcl::lzfDecompress(src, header.payload_size, raw.data(), raw.size()) != raw.size()) {
+      return false;
+    }
+
+    src = raw.data();
+  }
+
+  cloud.resize(n);
+
+  for (size_t f = 0; f < Traits::size; ++f) {
+    const size_t offset = Traits::offsets[f];
+
+    if (f < 3 && quantized) {
+      const double origin = header.origin[f], step = header.step[f];
+
+      for (auto & p : cloud) {
+        uint16_t u;
+
+        memcpy(&u, src, sizeof(u));
+        src += sizeof(u);
+
+        const float v = static_cast<float>(origin + (u + 0.5) * step);
+
+        memcpy(reinterpret_cast<char *>(&p) + offset, &v, sizeof(v));
+      }
+    } else {
+      for (auto & p : cloud) {
+        memcpy(reinterpret_cast<char *>(&p) + offset, src, sizeof(float));
+        src += sizeof(float);
+      }
+    }
+  }
+
+  cloud.width = n;
+  cloud.height = 1;
+
+  return true;
+}
+
+// Write @buffer to @path, through io_uring if @options enable it. Each thread keeps one ring and
+// one buffer pool for all of the spill files it writes.
+inline bool writeSpillFile(
+  const std::string & path, const std::vector<char> & buffer, const AsyncIOOptions & options)
+{
+  thread_local AsyncFileWriter writer;
+
+  if (writer.open(path, options)) {
+    writer.write(buffer.data(), buffer.size());
+
+    return writer.close();
+  }
+
+  std::ofstream file(path, std::ios::binary);
+
+  file.write(buffer.data(), buffer.size());
+
+  return static_cast<bool>(file);
+}
+
+// Read the whole file at @path to @buffer, through io_uring if @options enable it. Each thread
+// keeps one ring and one buffer pool for all of the spill files it reads.
+inline bool readSpillFile(
+  const std::string & path, std::vector<char> & buffer, const AsyncIOOptions & options)
+{
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+  if (!file) {
+    return false;
+  }
+
+  buffer.resize(file.tellg());
+
+  thread_local AsyncFileReader reader;
+
+  if (reader.open(path, 0, options)) {
+    const bool ok = reader.read(buffer.data(), buffer.size()) == buffer.size() && !reader.failed();
+
+    reader.close();
+
+    return ok;
+  }
+
+  file.seekg(0);
+  file.read(buffer.data(), buffer.size());
+
+  return static_cast<bool>(file);
+}
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__SPILL_CHUNK_HPP_
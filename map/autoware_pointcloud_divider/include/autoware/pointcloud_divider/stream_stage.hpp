@@ -0,0 +1,204 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__STREAM_STAGE_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__STREAM_STAGE_HPP_
+
+#include <Eigen/Geometry>
+
+#include <pcl/point_cloud.h>
+#include <pcl/type_traits.h>
+
+#include <algorithm>
+#include <array>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// A step applied to the blocks of points read from the inputs, before they reach the sink (the
+// binning of the divider). Stages are chained, so a tool transforms, reprojects, filters, and
+// divides a map in a single read pass instead of writing the full cloud after every step.
+//
+// A stage is called by the reader threads on different blocks at the same time, so process()
+// must not modify the stage.
+template <typename PointT>
+class StreamStage
+{
+public:
+  typedef pcl::PointCloud<PointT> PclCloudType;
+
+  virtual ~StreamStage() = default;
+
+  // Name of the phase of the run report measuring the stage
+  virtual const char * name() const = 0;
+
+  // Parameters of the stage. A checkpoint or an incremental manifest is only reused by a run
+  // with the same stages.
+  virtual std::string signature() const = 0;
+
+  // Process the points of a block in place. Points may be removed.
+  virtual void process(PclCloudType & block) const = 0;
+};
+
+template <typename PointT>
+using StreamStagePtr = std::shared_ptr<const StreamStage<PointT>>;
+
+// Apply an affine transformation to the coordinates, and rotate the normals if the points have
+// them. The points are made relative to the first point of the block, so the rotation runs on
+// small float values in SoA buffers, which the compiler vectorizes, and the transformed first
+// point is added back in double precision.
+template <typename PointT>
+class AffineTransformStage : public StreamStage<PointT>
+{
+  typedef pcl::PointCloud<PointT> PclCloudType;
+
+public:
+  explicit AffineTransformStage(const Eigen::Affine3d & affine) : affine_(affine) {}
+
+  const char * name() const override { return "transform"; }
+
+  std::string signature() const override
+  {
+    std::ostringstream signature;
+
+    signature << "transform" << std::setprecision(17);
+
+    for (int i = 0; i < 12; ++i) {
+      signature << " " << affine_.matrix()(i % 3, i / 3);
+    }
+
+    return signature.str();
+  }
+
+  void process(PclCloudType & block) const override
+  {
+    const size_t n = block.size();
+
+    if (n == 0) {
+      return;
+    }
+
+    const Eigen::Vector3d center(block[0].x, block[0].y, block[0].z);
+    const Eigen::Vector3d offset = affine_ * center;
+    const Eigen::Matrix3f rot = affine_.linear().cast<float>();
+    std::vector<float> xs(n), ys(n), zs(n);
+
+    for (size_t i = 0; i < n; ++i) {
+      const auto & p = block[i];
+
+      xs[i] = static_cast<float>(p.x - center.x());
+      ys[i] = static_cast<float>(p.y - center.y());
+      zs[i] = static_cast<float>(p.z - center.z());
+    }
+
+    rotate(rot, xs, ys, zs);
+
+    for (size_t i = 0; i < n; ++i) {
+      auto & p = block[i];
+
+      p.x = static_cast<float>(offset.x() + xs[i]);
+      p.y = static_cast<float>(offset.y() + ys[i]);
+      p.z = static_cast<float>(offset.z() + zs[i]);
+    }
+
+    if constexpr (pcl::traits::has_normal<PointT>::value) {
+      for (size_t i = 0; i < n; ++i) {
+        auto & p = block[i];
+
+        xs[i] = p.normal_x;
+        ys[i] = p.normal_y;
+        zs[i] = p.normal_z;
+      }
+
+      rotate(rot, xs, ys, zs);
+
+      for (size_t i = 0; i < n; ++i) {
+        auto & p = block[i];
+
+        p.normal_x = xs[i];
+        p.normal_y = ys[i];
+        p.normal_z = zs[i];
+      }
+    }
+  }
+
+private:
+  static void rotate(
+    const Eigen::Matrix3f & rot, std::vector<float> & xs, std::vector<float> & ys,
+    std::vector<float> & zs)
+  {
+    for (size_t i = 0; i < xs.size(); ++i) {
+      const float x = xs[i], y = ys[i], z = zs[i];
+
+      xs[i] = rot(0, 0) * x + rot(0, 1) * y + rot(0, 2) * z;
+      ys[i] = rot(1, 0) * x + rot(1, 1) * y + rot(1, 2) * z;
+      zs[i] = rot(2, 0) * x + rot(2, 1) * y + rot(2, 2) * z;
+    }
+  }
+
+  Eigen::Affine3d affine_;
+};
+
+// Keep the points in the box [min, max], bounds included
+template <typename PointT>
+class BoxFilterStage : public StreamStage<PointT>
+{
+  typedef pcl::PointCloud<PointT> PclCloudType;
+
+public:
+  BoxFilterStage(const std::array<double, 3> & min, const std::array<double, 3> & max)
+  : min_(min), max_(max)
+  {
+  }
+
+  const char * name() const override { return "filter"; }
+
+  std::string signature() const override
+  {
+    std::ostringstream signature;
+
+    signature << "box_filter" << std::setprecision(17);
+
+    for (int i = 0; i < 3; ++i) {
+      signature << " " << min_[i] << " " << max_[i];
+    }
+
+    return signature.str();
+  }
+
+  void process(PclCloudType & block) const override
+  {
+    auto outside = [this](const PointT & p) {
+      return p.x < min_[0] || p.x > max_[0] || p.y < min_[1] || p.y > max_[1] || p.z < min_[2] ||
+             p.z > max_[2];
+    };
+
+    block.points.erase(
+      std::remove_if(block.points.begin(), block.points.end(), outside), block.points.end());
+    block.width = block.points.size();
+    block.height = 1;
+  }
+
+private:
+  std::array<double, 3> min_, max_;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__STREAM_STAGE_HPP_
@@ -0,0 +1,546 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__TILE_CACHE_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__TILE_CACHE_HPP_
+
+#include "grid_info.hpp"
+#include "pcd_io_reader.hpp"
+#include "tile_index.hpp"
+
+#include <pcl/PCLPointCloud2.h>
+#include <pcl/common/io.h>
+#include <pcl/conversions.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_cloud.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+struct TileCacheStats
+{
+  size_t hit_num = 0;         // Tiles of the queries found in the cache, or being prefetched
+  size_t miss_num = 0;        // Tiles of the queries loaded by the querying thread
+  size_t prefetched_num = 0;  // Tiles loaded by the prefetch threads
+  size_t evicted_num = 0;
+  size_t cached_bytes = 0;
+};
+
+// Points of a divided map in a box, served from a least recently used cache of decoded tiles,
+// so that a tool working on a map larger than the memory holds at most a fixed number of bytes
+// of points. The tiles are listed by the metadata YAML of the divider, and the tiles around the
+// queried box are loaded by background threads while the caller works on the points.
+//
+// The queries may be made from several threads at the same time, but not during open().
+template <class PointT>
+class TileCache
+{
+  typedef pcl::PointCloud<PointT> PclCloudType;
+
+public:
+  typedef typename PclCloudType::ConstPtr TileConstPtr;
+
+  // Keep at most @max_bytes of decoded points, and prefetch the tiles with
+  // @prefetch_thread_num threads. No tile is prefetched with 0 threads.
+  explicit TileCache(size_t max_bytes = size_t(1) << 30, size_t prefetch_thread_num = 1)
+  : max_bytes_(max_bytes)
+  {
+    for (size_t i = 0; i < prefetch_thread_num; ++i) {
+      prefetchers_.emplace_back(&TileCache::prefetchLoop, this);
+    }
+  }
+
+  TileCache(const TileCache &) = delete;
+  TileCache & operator=(const TileCache &) = delete;
+
+  ~TileCache()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+
+      stopped_ = true;
+      pending_.clear();
+    }
+
+    prefetch_cond_.notify_all();
+
+    for (auto & prefetcher : prefetchers_) {
+      prefetcher.join();
+    }
+  }
+
+  // Read the map divided to @map_dir, with its metadata YAML and its tiles in the
+  // pointcloud_map.pcd folder. Return false if the metadata cannot be read.
+  bool open(const std::string & map_dir)
+  {
+    return open(map_dir + "/pointcloud_map_metadata.yaml", map_dir + "/pointcloud_map.pcd");
+  }
+
+  bool open(const std::string & metadata_path, const std::string & pcd_dir)
+  {
+    std::vector<TileRecord> records;
+    std::unordered_map<GridInfo<2>, std::string> paths;
+    double grid_size_x, grid_size_y, quantization_step = 0.001;
+
+    try {
+      const YAML::Node metadata = YAML::LoadFile(metadata_path);
+
+      if (!metadata["x_resolution"] || !metadata["y_resolution"]) {
+        return false;
+      }
+
+      grid_size_x = metadata["x_resolution"].as<double>();
+      grid_size_y = metadata["y_resolution"].as<double>();
+
+      if (metadata["quantization_step"]) {
+        quantization_step = metadata["quantization_step"].as<double>();
+      }
+
+      // The other entries of the metadata, as the levels of detail, are not tiles
+      for (const auto & it : metadata) {
+        const auto & value = it.second;
+
+        if (!value.IsSequence() || value.size() != 2 || !value[0].IsScalar()) {
+          continue;
+        }
+
+        TileRecord record{};
+
+        record.ix = value[0].as<int32_t>();
+        record.iy = value[1].as<int32_t>();
+        records.push_back(record);
+        paths[GridInfo<2>(record.ix, record.iy)] = pcd_dir + "/" + it.first.as<std::string>();
+      }
+    } catch (const YAML::Exception &) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    index_ = TileIndex(grid_size_x, grid_size_y, "", std::move(records));
+    paths_ = std::move(paths);
+    quantization_step_ = quantization_step;
+
+    // The loads of the previous map still in flight are not inserted
+    ++generation_;
+    tiles_.clear();
+    lru_.clear();
+    loading_.clear();
+    pending_.clear();
+    stats_.cached_bytes = 0;
+
+    return true;
+  }
+
+  // Number of tiles around the queried box prefetched in each direction
+  void setPrefetchMargin(size_t margin) { prefetch_margin_ = margin; }
+
+  // Points in the box [min_x, max_x] x [min_y, max_y] x [min_z, max_z]
+  PclCloudType query(
+    double min_x, double min_y, double max_x, double max_y,
+    double min_z = -std::numeric_limits<double>::infinity(),
+    double max_z = std::numeric_limits<double>::infinity())
+  {
+    PclCloudType output;
+
+    for (const auto & tile : tiles(min_x, min_y, max_x, max_y)) {
+      for (const auto & p : *tile) {
+        if (
+          p.x >= min_x && p.x <= max_x && p.y >= min_y && p.y <= max_y && p.z >= min_z &&
+          p.z <= max_z) {
+          output.push_back(p);
+        }
+      }
+    }
+
+    return output;
+  }
+
+  // Decoded tiles intersecting the box [min_x, max_x] x [min_y, max_y]. The tiles stay valid
+  // after they are evicted from the cache.
+  std::vector<TileConstPtr> tiles(double min_x, double min_y, double max_x, double max_y)
+  {
+    std::vector<TileConstPtr> output;
+    size_t query_id;
+
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+
+      query_id = ++query_num_;
+    }
+
+    for (const auto & record : index_.query(min_x, min_y, max_x, max_y)) {
+      auto tile = get(GridInfo<2>(record.ix, record.iy), query_id);
+
+      if (tile) {
+        output.push_back(tile);
+      }
+    }
+
+    if (!prefetchers_.empty()) {
+      prefetchAround(min_x, min_y, max_x, max_y);
+    }
+
+    return output;
+  }
+
+  TileCacheStats stats()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    return stats_;
+  }
+
+private:
+  struct Entry
+  {
+    TileConstPtr cloud;
+    size_t bytes;
+    size_t query_id;  // Latest query using the tile
+    std::list<GridInfo<2>>::iterator lru_it;
+  };
+
+  // Return the tile of @grid, loading it if it is not cached. A @query_id of 0 prefetches the
+  // tile, which is skipped if it is cached or being loaded, and returns nullptr.
+  TileConstPtr get(const GridInfo<2> & grid, size_t query_id)
+  {
+    const bool prefetch = query_id == 0;
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto it = tiles_.find(grid);
+
+    if (it != tiles_.end()) {
+      if (prefetch) {
+        return nullptr;
+      }
+
+      touch(it->second, query_id);
+      ++stats_.hit_num;
+
+      return it->second.cloud;
+    }
+
+    auto loading = loading_.find(grid);
+
+    if (loading != loading_.end()) {
+      if (prefetch) {
+        return nullptr;
+      }
+
+      auto future = loading->second;
+
+      ++stats_.hit_num;
+      lock.unlock();
+
+      auto cloud = future.get();
+
+      lock.lock();
+      it = tiles_.find(grid);
+
+      if (it != tiles_.end()) {
+        touch(it->second, query_id);
+      }
+
+      return cloud;
+    }
+
+    auto path = paths_.find(grid);
+
+    if (path == paths_.end()) {
+      return nullptr;
+    }
+
+    std::promise<TileConstPtr> promise;
+    const std::string tile_path = path->second;
+    const size_t generation = generation_;
+    const double step = quantization_step_;
+
+    loading_[grid] = promise.get_future().share();
+    ++(prefetch ? stats_.prefetched_num : stats_.miss_num);
+    lock.unlock();
+
+    auto cloud = load(tile_path, step);
+
+    lock.lock();
+
+    if (generation == generation_) {
+      loading_.erase(grid);
+
+      if (cloud) {
+        insert(grid, cloud, query_id);
+      }
+    }
+
+    lock.unlock();
+    promise.set_value(cloud);
+
+    return cloud;
+  }
+
+  void touch(Entry & entry, size_t query_id)
+  {
+    entry.query_id = query_id;
+    lru_.splice(lru_.begin(), lru_, entry.lru_it);
+  }
+
+  // A prefetched tile is inserted as the least recently used one, so it only takes the place of
+  // the tiles less likely to be used. It is dropped rather than evicting a tile of the latest
+  // query, so that the prefetching never evicts the tiles being worked on.
+  void insert(const GridInfo<2> & grid, TileConstPtr cloud, size_t query_id)
+  {
+    const bool prefetch = query_id == 0;
+    const size_t bytes = sizeof(PclCloudType) + cloud->size() * sizeof(PointT);
+
+    while (stats_.cached_bytes + bytes > max_bytes_ && !lru_.empty()) {
+      auto & victim = tiles_.at(lru_.back());
+
+      if (prefetch && victim.query_id == query_num_) {
+        return;
+      }
+
+      stats_.cached_bytes -= victim.bytes;
+      ++stats_.evicted_num;
+      tiles_.erase(lru_.back());
+      lru_.pop_back();
+    }
+
+    auto lru_it = lru_.insert(prefetch ? lru_.end() : lru_.begin(), grid);
+
+    tiles_[grid] = Entry{std::move(cloud), bytes, query_id, lru_it};
+    stats_.cached_bytes += bytes;
+  }
+
+  // Replace the pending prefetches by the tiles around the box, nearest first. The tiles around
+  // an older box are not needed any more.
+  void prefetchAround(double min_x, double min_y, double max_x, double max_y)
+  {
+    const double margin_x = index_.gridSizeX() * prefetch_margin_;
+    const double margin_y = index_.gridSizeY() * prefetch_margin_;
+    const double center_x = (min_x + max_x) * 0.5, center_y = (min_y + max_y) * 0.5;
+    auto around =
+      index_.query(min_x - margin_x, min_y - margin_y, max_x + margin_x, max_y + margin_y);
+    auto distance = [&](const TileRecord & tile) {
+      const double dx = tile.ix + index_.gridSizeX() * 0.5 - center_x;
+      const double dy = tile.iy + index_.gridSizeY() * 0.5 - center_y;
+
+      return dx * dx + dy * dy;
+    };
+
+    std::sort(around.begin(), around.end(), [&](const TileRecord & a, const TileRecord & b) {
+      return distance(a) < distance(b);
+    });
+
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+
+      pending_.clear();
+
+      for (const auto & tile : around) {
+        GridInfo<2> grid(tile.ix, tile.iy);
+
+        if (!tiles_.count(grid) && !loading_.count(grid)) {
+          pending_.push_back(grid);
+        }
+      }
+    }
+
+    prefetch_cond_.notify_all();
+  }
+
+  void prefetchLoop()
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+
+    while (true) {
+      prefetch_cond_.wait(lock, [this] { return stopped_ || !pending_.empty(); });
+
+      if (stopped_) {
+        return;
+      }
+
+      GridInfo<2> grid = pending_.front();
+
+      pending_.pop_front();
+      lock.unlock();
+      get(grid, 0);
+      lock.lock();
+    }
+  }
+
+  // Decode a tile in any encoding of the divider. The uncompressed tiles are read by
+  // CustomPCDReader, the compressed ones by PCL, and the quantized ones are restored to float
+  // coordinates. Return nullptr if the file cannot be read.
+  static TileConstPtr load(const std::string & path, double quantization_step)
+  {
+    pcl::PCDReader pcd_reader;
+    pcl::PCLPointCloud2 blob;
+    Eigen::Vector4f origin;
+    Eigen::Quaternionf orientation;
+    int version, data_type;
+    unsigned int data_idx;
+    typename PclCloudType::Ptr cloud(new PclCloudType);
+
+    if (pcd_reader.readHeader(path, blob, origin, orientation, version, data_type, data_idx)) {
+      return nullptr;
+    }
+
+    auto x_field = std::find_if(blob.fields.begin(), blob.fields.end(), [](const auto & field) {
+      return field.name == "x";
+    });
+
+    if (x_field != blob.fields.end() && x_field->datatype == pcl::PCLPointField::INT16) {
+      std::array<double, 3> viewpoint;
+
+      if (!readViewpoint(path, viewpoint) || pcd_reader.read(path, blob)) {
+        return nullptr;
+      }
+
+      pcl::fromPCLPointCloud2(dequantize(blob, viewpoint, quantization_step), *cloud);
+    } else if (data_type == 2) {
+      if (pcd_reader.read(path, *cloud)) {
+        return nullptr;
+      }
+    } else {
+      CustomPCDReader<PointT> reader;
+      PclCloudType block;
+
+      reader.setInput(path);
+      cloud->reserve(reader.point_num());
+
+      do {
+        reader.readABlock(block);
+        *cloud += block;
+      } while (reader.good());
+    }
+
+    return cloud;
+  }
+
+  // The origin of a quantized tile, parsed as double. PCL parses the viewpoint as float, which
+  // loses millimeters at the coordinates of a map.
+  static bool readViewpoint(const std::string & path, std::array<double, 3> & viewpoint)
+  {
+    std::ifstream file(path);
+    std::string line;
+
+    while (std::getline(file, line) && line.compare(0, 4, "DATA") != 0) {
+      if (line.compare(0, 9, "VIEWPOINT") == 0) {
+        std::istringstream values(line.substr(9));
+
+        return static_cast<bool>(values >> viewpoint[0] >> viewpoint[1] >> viewpoint[2]);
+      }
+    }
+
+    return false;
+  }
+
+  // Replace the int16 x, y, and z of a quantized tile by float32 viewpoint + value * step
+  static pcl::PCLPointCloud2 dequantize(
+    const pcl::PCLPointCloud2 & blob, const std::array<double, 3> & viewpoint, double step)
+  {
+    pcl::PCLPointCloud2 output;
+    std::vector<int> axes;
+    uint32_t offset = 0;
+
+    output.header = blob.header;
+    output.height = blob.height;
+    output.width = blob.width;
+    output.is_bigendian = blob.is_bigendian;
+    output.is_dense = blob.is_dense;
+
+    for (auto field : blob.fields) {
+      const int axis = field.name == "x" ? 0 : field.name == "y" ? 1 : field.name == "z" ? 2 : -1;
+      const bool quantized = axis >= 0 && field.datatype == pcl::PCLPointField::INT16;
+
+      axes.push_back(quantized ? axis : -1);
+
+      if (quantized) {
+        field.datatype = pcl::PCLPointField::FLOAT32;
+      }
+
+      field.offset = offset;
+      offset += pcl::getFieldSize(field.datatype) * field.count;
+      output.fields.push_back(field);
+    }
+
+    output.point_step = offset;
+    output.row_step = offset * output.width;
+    output.data.resize(static_cast<size_t>(output.row_step) * output.height);
+
+    const size_t point_num = static_cast<size_t>(blob.width) * blob.height;
+
+    for (size_t i = 0; i < point_num; ++i) {
+      const uint8_t * src = blob.data.data() + i * blob.point_step;
+      uint8_t * dst = output.data.data() + i * output.point_step;
+
+      for (size_t fid = 0; fid < blob.fields.size(); ++fid) {
+        const auto & in = blob.fields[fid];
+        const auto & out = output.fields[fid];
+
+        if (axes[fid] >= 0) {
+          int16_t q;
+
+          memcpy(&q, src + in.offset, sizeof(q));
+
+          const float v = static_cast<float>(viewpoint[axes[fid]] + q * step);
+
+          memcpy(dst + out.offset, &v, sizeof(v));
+        } else {
+          memcpy(dst + out.offset, src + in.offset, pcl::getFieldSize(in.datatype) * in.count);
+        }
+      }
+    }
+
+    return output;
+  }
+
+  const size_t max_bytes_;
+  size_t prefetch_margin_ = 1;
+  TileIndex index_;
+  std::unordered_map<GridInfo<2>, std::string> paths_;
+  double quantization_step_ = 0.001;
+
+  std::mutex mtx_;
+  std::unordered_map<GridInfo<2>, Entry> tiles_;
+  std::list<GridInfo<2>> lru_;  // Most recently used first
+  std::unordered_map<GridInfo<2>, std::shared_future<TileConstPtr>> loading_;
+  size_t generation_ = 0;  // Number of maps opened, to drop the loads of a previous one
+  size_t query_num_ = 0;
+  TileCacheStats stats_;
+
+  std::deque<GridInfo<2>> pending_;
+  std::condition_variable prefetch_cond_;
+  bool stopped_ = false;
+  std::vector<std::thread> prefetchers_;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__TILE_CACHE_HPP_
@@ -0,0 +1,317 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__TILE_INDEX_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__TILE_INDEX_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Binary index of the output segments, written next to the metadata YAML as
+// pointcloud_map_index.bin. It has no dependency other than the standard library, so map
+// consumers can include this header alone. Tiles are sorted by the Morton code of their grid
+// indices, so the tiles intersecting a box are found by binary searches instead of a scan.
+//
+// Layout (little endian):
+//   char[8]     magic "PCDTIDX1"
+//   double      grid_size_x, grid_size_y
+//   uint32      length of the file prefix, followed by the prefix
+//   uint64      number of tiles, followed by the TileRecords
+
+struct TileRecord
+{
+  uint64_t code;       // Morton code of the grid indices
+  int32_t ix, iy;      // Lower-left corner of the tile, as in the metadata YAML
+  uint64_t point_num;  // Number of points
+  float z_min, z_max;
+  uint64_t byte_size;  // Size of the PCD file
+  uint32_t checksum;   // CRC32 of the PCD file
+  uint32_t flags;      // TILE_* bits of the sidecar files of the tile
+};
+
+// The tile has a height map next to its PCD, in the binary or the GeoTIFF format of
+// height_map.hpp. Index files written before the height maps have no flag set.
+constexpr uint32_t TILE_HEIGHT_MAP_BINARY = 1U << 0;
+constexpr uint32_t TILE_HEIGHT_MAP_GEOTIFF = 1U << 1;
+// The tile has the NDT voxels of ndt_voxels.hpp next to its PCD
+constexpr uint32_t TILE_NDT_VOXELS = 1U << 2;
+
+static_assert(sizeof(TileRecord) == 48, "TileRecord must be packed for the binary index");
+
+// Interleave the bits of the grid indices, x to the even bits and y to the odd bits.
+// The indices are biased, so the order of codes follows the order of signed indices.
+inline uint64_t mortonCode(int32_t gx, int32_t gy)
+{
+  auto spread = [](uint32_t v) {
+    uint64_t x = v;
+
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+
+    return x;
+  };
+
+  return spread(static_cast<uint32_t>(gx) ^ 0x80000000U) |
+         (spread(static_cast<uint32_t>(gy) ^ 0x80000000U) << 1);
+}
+
+inline void mortonDecode(uint64_t code, int32_t & gx, int32_t & gy)
+{
+  auto compact = [](uint64_t x) {
+    x &= 0x5555555555555555ULL;
+    x = (x | (x >> 1)) & 0x3333333333333333ULL;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+
+    return static_cast<uint32_t>(x);
+  };
+
+  gx = static_cast<int32_t>(compact(code) ^ 0x80000000U);
+  gy = static_cast<int32_t>(compact(code >> 1) ^ 0x80000000U);
+}
+
+// Smallest Morton code greater than @code that lies in the box spanned by @zmin and @zmax
+// (Tropf and Herzog, "Multidimensional Range Search in Dynamically Balanced Trees")
+inline uint64_t mortonBigMin(uint64_t code, uint64_t zmin, uint64_t zmax)
+{
+  uint64_t bigmin = 0;
+
+  for (int bit = 63; bit >= 0; --bit) {
+    const uint64_t mask = 1ULL << bit;
+    // Lower bits of the same dimension as @bit
+    const uint64_t dim_mask = ((bit % 2 == 0) ? 0x5555555555555555ULL : 0xAAAAAAAAAAAAAAAAULL) &
+                              (mask - 1);
+    const bool v = code & mask, lo = zmin & mask, hi = zmax & mask;
+
+    if (!v && !lo && hi) {
+      bigmin = (zmin & ~dim_mask) | mask;
+      zmax = (zmax & ~mask) | dim_mask;
+    } else if (!v && lo && hi) {
+      return zmin;
+    } else if (v && !lo && !hi) {
+      return bigmin;
+    } else if (v && !lo && hi) {
+      zmin = (zmin & ~dim_mask) | mask;
+    }
+  }
+
+  return bigmin;
+}
+
+inline uint32_t crc32(const char * data, size_t size, uint32_t crc = 0)
+{
+  static const auto table = []() {
+    std::array<uint32_t, 256> t;
+
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? (0xEDB88320U ^ (c >> 1)) : (c >> 1);
+      }
+
+      t[i] = c;
+    }
+
+    return t;
+  }();
+
+  crc = ~crc;
+
+  for (size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
+
+// CRC32 of a whole file, 0 if the file cannot be opened
+inline uint32_t fileChecksum(const std::string & path)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::vector<char> buffer(1 << 20);
+  uint32_t crc = 0;
+
+  while (file) {
+    file.read(buffer.data(), buffer.size());
+    crc = crc32(buffer.data(), file.gcount(), crc);
+  }
+
+  return crc;
+}
+
+class TileIndex
+{
+public:
+  TileIndex() : grid_size_x_(0), grid_size_y_(0) {}
+
+  TileIndex(
+    double grid_size_x, double grid_size_y, const std::string & prefix,
+    std::vector<TileRecord> tiles)
+  : grid_size_x_(grid_size_x), grid_size_y_(grid_size_y), prefix_(prefix), tiles_(std::move(tiles))
+  {
+    for (auto & tile : tiles_) {
+      tile.code = mortonCode(gridIndex(tile.ix, grid_size_x_), gridIndex(tile.iy, grid_size_y_));
+    }
+
+    std::sort(tiles_.begin(), tiles_.end(), [](const TileRecord & a, const TileRecord & b) {
+      return a.code < b.code;
+    });
+  }
+
+  // Return false if the file is not a tile index
+  bool load(const std::string & path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    char magic[8];
+    uint32_t prefix_len = 0;
+    uint64_t tile_num = 0;
+
+    file.read(magic, sizeof(magic));
+
+    if (!file || memcmp(magic, "PCDTIDX1", sizeof(magic)) != 0) {
+      return false;
+    }
+
+    file.read(reinterpret_cast<char *>(&grid_size_x_), sizeof(grid_size_x_));
+    file.read(reinterpret_cast<char *>(&grid_size_y_), sizeof(grid_size_y_));
+    file.read(reinterpret_cast<char *>(&prefix_len), sizeof(prefix_len));
+    prefix_.resize(prefix_len);
+    file.read(&prefix_[0], prefix_len);
+    file.read(reinterpret_cast<char *>(&tile_num), sizeof(tile_num));
+
+    if (!file) {
+      return false;
+    }
+
+    tiles_.resize(tile_num);
+    file.read(reinterpret_cast<char *>(tiles_.data()), tile_num * sizeof(TileRecord));
+
+    return static_cast<bool>(file);
+  }
+
+  bool save(const std::string & path) const
+  {
+    std::ofstream file(path, std::ios::binary);
+    uint32_t prefix_len = prefix_.size();
+    uint64_t tile_num = tiles_.size();
+
+    file.write("PCDTIDX1", 8);
+    file.write(reinterpret_cast<const char *>(&grid_size_x_), sizeof(grid_size_x_));
+    file.write(reinterpret_cast<const char *>(&grid_size_y_), sizeof(grid_size_y_));
+    file.write(reinterpret_cast<const char *>(&prefix_len), sizeof(prefix_len));
+    file.write(prefix_.data(), prefix_len);
+    file.write(reinterpret_cast<const char *>(&tile_num), sizeof(tile_num));
+    file.write(reinterpret_cast<const char *>(tiles_.data()), tile_num * sizeof(TileRecord));
+
+    return static_cast<bool>(file);
+  }
+
+  // Tiles intersecting the box [min_x, max_x] x [min_y, max_y], in Morton order.
+  // Each run of tiles inside the box costs one binary search.
+  std::vector<TileRecord> query(double min_x, double min_y, double max_x, double max_y) const
+  {
+    std::vector<TileRecord> output;
+
+    if (tiles_.empty() || grid_size_x_ <= 0 || grid_size_y_ <= 0) {
+      return output;
+    }
+
+    const int32_t gx_min = static_cast<int32_t>(std::floor(min_x / grid_size_x_));
+    const int32_t gy_min = static_cast<int32_t>(std::floor(min_y / grid_size_y_));
+    const int32_t gx_max = static_cast<int32_t>(std::floor(max_x / grid_size_x_));
+    const int32_t gy_max = static_cast<int32_t>(std::floor(max_y / grid_size_y_));
+    const uint64_t zmin = mortonCode(gx_min, gy_min), zmax = mortonCode(gx_max, gy_max);
+    auto less_code = [](const TileRecord & tile, uint64_t code) { return tile.code < code; };
+    auto it = std::lower_bound(tiles_.begin(), tiles_.end(), zmin, less_code);
+
+    while (it != tiles_.end() && it->code <= zmax) {
+      int32_t gx, gy;
+
+      mortonDecode(it->code, gx, gy);
+
+      if (gx >= gx_min && gx <= gx_max && gy >= gy_min && gy <= gy_max) {
+        output.push_back(*it);
+        ++it;
+      } else {
+        it = std::lower_bound(it, tiles_.end(), mortonBigMin(it->code, zmin, zmax), less_code);
+      }
+    }
+
+    return output;
+  }
+
+  // Name of the PCD file of a tile, as the keys of the metadata YAML
+  std::string fileName(const TileRecord & tile) const
+  {
+    return prefix_ + "_" + std::to_string(tile.ix) + "_" + std::to_string(tile.iy) + ".pcd";
+  }
+
+  // Name of the height map of a tile, in the same folder as its PCD, or empty if it has none
+  std::string heightMapName(const TileRecord & tile) const
+  {
+    std::string name = prefix_ + "_" + std::to_string(tile.ix) + "_" + std::to_string(tile.iy);
+
+    if (tile.flags & TILE_HEIGHT_MAP_BINARY) {
+      return name + ".height";
+    } else if (tile.flags & TILE_HEIGHT_MAP_GEOTIFF) {
+      return name + ".tif";
+    }
+
+    return "";
+  }
+
+  // Name of the NDT voxels of a tile, in the same folder as its PCD, or empty if it has none
+  std::string ndtVoxelsName(const TileRecord & tile) const
+  {
+    if (!(tile.flags & TILE_NDT_VOXELS)) {
+      return "";
+    }
+
+    return prefix_ + "_" + std::to_string(tile.ix) + "_" + std::to_string(tile.iy) + ".ndt";
+  }
+
+  const std::vector<TileRecord> & tiles() const { return tiles_; }
+  const std::string & prefix() const { return prefix_; }
+  double gridSizeX() const { return grid_size_x_; }
+  double gridSizeY() const { return grid_size_y_; }
+
+private:
+  static int32_t gridIndex(int32_t corner, double grid_size)
+  {
+    return static_cast<int32_t>(std::lround(corner / grid_size));
+  }
+
+  double grid_size_x_, grid_size_y_;
+  std::string prefix_;
+  std::vector<TileRecord> tiles_;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__TILE_INDEX_HPP_
@@ -15,6 +15,8 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__UTILITY_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__UTILITY_HPP_
 
+#include "point_field_traits.hpp"
+
 #include <pcl/point_types.h>
 
 #include <cstdio>
@@ -97,18 +99,11 @@ inline int split(const std::string & line, const std::string & del, std::vector<
 }
 
 template <typename PointT>
-inline void zero_point(PointT & p);
-
-template <>
-inline void zero_point(pcl::PointXYZ & p)
-{
-  p.x = p.y = p.z = 0;
-}
-
-template <>
-inline void zero_point(pcl::PointXYZI & p)
+inline void zero_point(PointT & p)
 {
-  p.x = p.y = p.z = p.intensity = 0;
+  for (size_t fid = 0; fid < PointFieldTraits<PointT>::size; ++fid) {
+    *fieldPtr(p, fid) = 0;
+  }
 }
 
 // Remove trailing whitespace, newline, and carriage return characters from a string
@@ -15,14 +15,40 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__VOXEL_GRID_FILTER_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__VOXEL_GRID_FILTER_HPP_
 
+#include "centroid.hpp"
+#include "grid_info.hpp"
+
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
 #include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace autoware::pointcloud_divider
 {
 
+// Algorithms used to group points to voxels
+enum class VoxelFilterEngine {
+  HASH,  // Insert points to a hash map of voxels
+  SORT   // Sort points by their linear voxel codes, then reduce the sorted runs
+};
+
+// Convert the engine name in the config ("hash" or "sort") to the engine
+inline bool toVoxelFilterEngine(const std::string & name, VoxelFilterEngine & engine)
+{
+  if (name == "hash") {
+    engine = VoxelFilterEngine::HASH;
+  } else if (name == "sort") {
+    engine = VoxelFilterEngine::SORT;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
 template <typename PointT>
 class VoxelGridFilter
 {
@@ -30,7 +56,13 @@ class VoxelGridFilter
   typedef typename PclCloudType::Ptr PclCloudPtr;
 
 public:
-  VoxelGridFilter() { resolution_ = 0; }
+  VoxelGridFilter()
+  {
+    resolution_ = 0;
+    engine_ = VoxelFilterEngine::HASH;
+    max_voxel_num_ = 0;
+    evicted_voxel_num_ = 0;
+  }
 
   void setResolution(float res)
   {
@@ -39,14 +71,63 @@ public:
     }
   }
 
+  void setEngine(VoxelFilterEngine engine) { engine_ = engine; }
+
   void filter(const PclCloudType & input, PclCloudType & output);
 
+  // Streaming interface: fold a block of points into the voxel accumulators, so the
+  // input does not have to reside in memory as a whole. The memory usage grows with
+  // the number of occupied voxels only. Blocks are always grouped by hash.
+  void add(const PclCloudType & input);
+  // Output the centroids of the accumulated voxels and reset the accumulators
+  void flush(PclCloudType & output);
+
+  // Bound the streaming interface to @max_voxel_num accumulators, in a table allocated once.
+  // When the table is full, the half of the voxels first along the Morton curve of their x and
+  // y indices are evicted, and their centroids and numbers of points are kept. A voxel receiving
+  // points after its eviction is evicted again, and its parts are merged into one centroid
+  // weighted by their numbers of points, so the output has a centroid per voxel in any input
+  // order. Few voxels are revisited when the input is in spatial order, and the evicted parts
+  // are merged whenever they double, so they stay within twice the number of evicted voxels or
+  // of @max_voxel_num.
+  // Setting to 0 keeps every voxel until flush (default).
+  void setMaxVoxelNum(size_t max_voxel_num);
+
+  // Number of voxels evicted before flush since the filter was created
+  size_t evictedVoxelNum() const { return evicted_voxel_num_; }
+
 private:
+  void filterByHash(const PclCloudType & input, PclCloudType & output);
+  // Return false if the voxel codes of the input cannot be packed into 64 bits
+  bool filterBySort(const PclCloudType & input, PclCloudType & output);
+  // Move the first half of the accumulators along the sweep to evicted_
+  void evict();
+  // Merge the parts of evicted_ of the same voxel
+  void mergeEvicted();
+
   float resolution_;
+  VoxelFilterEngine engine_;
+  std::unordered_map<GridInfo<3>, Centroid<PointT>> acc_map_;
+  size_t max_voxel_num_;
+  size_t evicted_voxel_num_;
+
+  // Centroid of the points of a voxel evicted at once
+  struct EvictedVoxel
+  {
+    GridInfo<3> key;
+    PointT centroid;
+    size_t point_num;
+  };
+
+  // Evicted parts of the voxels, output by the next flush, and their number after the last merge
+  std::vector<EvictedVoxel> evicted_;
+  size_t merged_evicted_num_ = 0;
 };
 
 template class VoxelGridFilter<pcl::PointXYZ>;
 template class VoxelGridFilter<pcl::PointXYZI>;
+template class VoxelGridFilter<pcl::PointXYZRGB>;
+template class VoxelGridFilter<pcl::PointXYZINormal>;
 
 }  // namespace autoware::pointcloud_divider
 
@@ -16,8 +16,12 @@
 #define POINTCLOUD_DIVIDER_NODE_HPP_
 
 #include <string>
+#include <vector>
 
 #define PCL_NO_RECOMPILE
+#include <autoware/pointcloud_divider/pcd_divider.hpp>
+#include <autoware/pointcloud_divider/raw_pcd_divider.hpp>
+#include <autoware/pointcloud_divider/voxel_grid_filter.hpp>
 #include <rclcpp/rclcpp.hpp>
 
 namespace autoware::pointcloud_divider
@@ -27,6 +31,38 @@ class PointCloudDivider : public rclcpp::Node
 {
 public:
   explicit PointCloudDivider(const rclcpp::NodeOptions & node_options);
+
+private:
+  template <typename PointT>
+  void runDivider();
+  // Divide the records of the inputs as they are, keeping all of their fields
+  void runRawDivider();
+  // Merge the outputs of the workers of a distributed divide, found in input_pcd_or_dir
+  void runPartitionMerge();
+
+  bool use_large_grid_, in_memory_mode_, incremental_mode_, pre_voxelize_, async_io_direct_;
+  float leaf_size_, grid_size_x_, grid_size_y_;
+  std::string input_pcd_or_dir_, output_pcd_dir_, file_prefix_, report_path_;
+  std::string output_sink_command_, laz_command_;
+  double progress_period_, checkpoint_period_;
+  int large_grid_factor_;
+  int reader_thread_num_, worker_thread_num_, spill_thread_num_, finalize_thread_num_;
+  int upload_thread_num_, async_io_queue_depth_;
+  VoxelFilterEngine voxel_filter_engine_;
+  int64_t memory_budget_, max_voxel_num_;
+  int outlier_mean_k_;
+  double outlier_stddev_mul_, outlier_halo_;
+  SpillPolicy spill_policy_;
+  SpillEncoding spill_encoding_;
+  TileEncoding tile_encoding_;
+  double quantization_step_;
+  std::vector<double> lod_leaf_sizes_;
+  double height_map_cell_size_;
+  HeightMapFormat height_map_format_;
+  double ndt_resolution_;
+  bool morton_order_;
+  std::string partition_role_, partition_plan_;
+  int partition_worker_num_, partition_worker_id_;
 };
 
 }  // namespace autoware::pointcloud_divider
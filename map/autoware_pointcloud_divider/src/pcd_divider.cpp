@@ -46,12 +46,20 @@
 #include <autoware/pointcloud_divider/voxel_grid_filter.hpp>
 
 #include <pcl/common/transforms.h>
+#include <pcl/filters/statistical_outlier_removal.h>
 #include <pcl/filters/voxel_grid.h>
 
+#include <array>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <fstream>
+#include <limits>
 #include <list>
 #include <memory>
+#include <numeric>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -75,7 +83,7 @@ std::vector<std::string> PCDDivider<PointT>::discoverPCDs(const std::string & in
         auto file_name = entry.path().string();
         auto extension = entry.path().extension().string();
 
-        if (extension == ".pcd" || extension == ".PCD") {
+        if (extension == ".pcd" || extension == ".PCD" || isLASFile(file_name)) {
           pcd_list.push_back(file_name);
         }
       }
@@ -84,12 +92,13 @@ std::vector<std::string> PCDDivider<PointT>::discoverPCDs(const std::string & in
     auto file_name = input_path.string();
     auto extension = input_path.extension().string();
 
-    if (extension == ".pcd" || extension == ".PCD") {
+    if (extension == ".pcd" || extension == ".PCD" || isLASFile(file_name)) {
       RCLCPP_INFO(logger_, "Input PCD file: %s", input.c_str());
 
       pcd_list.push_back(file_name);
     } else {
-      RCLCPP_ERROR(logger_, "Error: The input file is not PCD format %s", input.c_str());
+      RCLCPP_ERROR(
+        logger_, "Error: The input file is not PCD, LAS, or LAZ format %s", input.c_str());
       exit(EXIT_FAILURE);
     }
   } else {
@@ -113,12 +122,363 @@ void PCDDivider<PointT>::run()
 template <class PointT>
 void PCDDivider<PointT>::run(const std::vector<std::string> & pcd_names)
 {
-  checkOutputDirectoryValidity();
+  std::vector<std::string> input_names = pcd_names;
+
+  preparePartition(input_names);
+
+  std::vector<std::string> divide_names = input_names;
+
+  tile_records_.clear();
+  incremental_ = incremental_mode_ && prepareIncrementalRun(input_names, divide_names);
+  record_grids_ = incremental_mode_ && !incremental_;
 
   grid_set_.clear();
+  created_dirs_.clear();
+  manifest_.clear();
+  resumed_counters_.clear();
+  spilled_bytes_ = read_back_bytes_ = spilled_file_num_ = pre_voxelized_point_num_ = 0;
+  evicted_voxel_num_ = outlier_point_num_ = 0;
+  in_memory_ = false;
+  resume_input_ = resume_position_ = 0;
+  resumed_ = checkpoint_period_ > 0 && loadCheckpoint(divide_names);
+
+  checkOutputDirectoryValidity();
+
+  publishing_ = true;
+  report_.reset();
+  report_.startProgress(progress_period_, [this](const std::string & line) {
+    RCLCPP_INFO(logger_, "%s", line.c_str());
+  });
+
+  // The outlier removal reads the halos of the segments from the tmp directory
+  if (in_memory_mode_ && !resumed_ && outlier_mean_k_ == 0) {
+    // Count the input points from the PCD headers. Grid clouds grow by doubling their
+    // capacity, so only half of the resident point limit is used for the input.
+    InputReader<PointT> reader;
+    size_t total_point_num = 0;
+
+    reader.setLAZCommand(laz_command_);
+
+    for (const auto & pcd_name : divide_names) {
+      reader.setInput(pcd_name);
+      total_point_num += reader.point_num();
+    }
+
+    in_memory_ = (total_point_num <= max_resident_point_num_ / 2);
+
+    if (in_memory_) {
+      RCLCPP_INFO(
+        logger_, "The input (%lu points) fits in memory, skip the tmp directory", total_point_num);
+    }
+  }
+
+  last_checkpoint_ = std::chrono::steady_clock::now();
+
+  if (reader_thread_num_ > 1 || worker_thread_num_ > 1) {
+    dividePipelined(divide_names);
+  } else {
+    divideSequential(divide_names);
+  }
+
+  if (!rclcpp::ok()) {
+    report_.stopProgress();
+    return;
+  }
+
+  // An interruption while finalizing resumes from here, without dividing again
+  if (checkpoint_period_ > 0 && !in_memory_) {
+    saveCheckpoint(divide_names, divide_names.size(), 0);
+  }
+
+  RCLCPP_INFO(logger_, "Merge and downsampling... ");
+
+  // Now merge and downsample
+  mergeAndDownsample();
+
+  if (debug_mode_) {
+    RCLCPP_INFO(
+      logger_, "Spilled %lu files (%lu bytes) to the tmp directory, read back %lu bytes",
+      spilled_file_num_.load(), spilled_bytes_.load(), read_back_bytes_.load());
+  }
+
+  if (incremental_mode_) {
+    // The segments that were not rebuilt are still listed in the metadata
+    if (incremental_) {
+      grid_set_.clear();
+
+      for (const auto & input : input_records_) {
+        grid_set_.insert(input.second.grids.begin(), input.second.grids.end());
+      }
+    }
+
+    for (const auto & pcd_name : input_names) {
+      auto stat = statInput(pcd_name);
+      auto & record = input_records_[pcd_name];
+
+      record.file_size = stat.file_size;
+      record.mtime = stat.mtime;
+    }
+
+    saveManifest(output_dir_ + "/pointcloud_map_manifest.yaml");
+  }
+
+  // The segments are published before the metadata that lists them. If a segment failed, the
+  // metadata is only saved locally, so the published map is never listed incomplete.
+  publishing_ = sink_->flush();
+
+  std::string yaml_file_path = output_dir_ + "/pointcloud_map_metadata.yaml";
+  saveGridInfoToYAML(yaml_file_path);
+  saveTileIndex(output_dir_ + "/pointcloud_map_index.bin");
+
+  if (partitioned_) {
+    savePartitionInfo(output_dir_ + "/pointcloud_map_partition.yaml");
+  }
+
+  saveReport();
+
+  if (!publishing_ || !sink_->flush()) {
+    RCLCPP_ERROR(logger_, "Error: Cannot publish the output of %s", output_dir_.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  RCLCPP_INFO(logger_, "Done!");
+}
+
+template <class PointT>
+void PCDDivider<PointT>::preparePartition(std::vector<std::string> & pcd_names)
+{
+  partitioned_ = !partition_plan_path_.empty();
+  partition_cells_.clear();
+
+  if (!partitioned_) {
+    return;
+  }
+
+  PartitionPlan plan;
+
+  if (!plan.load(partition_plan_path_)) {
+    RCLCPP_ERROR(logger_, "Error: Cannot load the partition plan %s", partition_plan_path_.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  // The grids of the plan are only valid for the large grid size it was made with
+  if (
+    plan.g_grid_size_x != g_grid_size_x_ || plan.g_grid_size_y != g_grid_size_y_ ||
+    partition_worker_id_ >= plan.workers.size()) {
+    RCLCPP_ERROR(
+      logger_, "Error: The partition plan %s does not match the grid size or has no worker %lu",
+      partition_plan_path_.c_str(), partition_worker_id_);
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  partition_cells_ = plan.workerCells(partition_worker_id_);
+
+  // With the outlier removal, the segments at the border of the partition need the points of
+  // the adjacent large grids for their halos
+  const auto worker_inputs = plan.workerInputs(partition_worker_id_, outlier_mean_k_ > 0);
+  const std::unordered_set<std::string> worker_input_set(
+    worker_inputs.begin(), worker_inputs.end());
+  const size_t input_num = pcd_names.size();
+
+  pcd_names.erase(
+    std::remove_if(
+      pcd_names.begin(), pcd_names.end(),
+      [&worker_input_set](const std::string & name) { return worker_input_set.count(name) == 0; }),
+    pcd_names.end());
+
+  RCLCPP_INFO(
+    logger_, "Worker %lu of %lu: %lu large grids, %lu of %lu inputs", partition_worker_id_,
+    plan.workers.size(), partition_cells_.size(), pcd_names.size(), input_num);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::planPartitions(size_t worker_num, const std::string & plan_path)
+{
+  planPartitions(discoverPCDs(input_pcd_or_dir_), worker_num, plan_path);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::planPartitions(
+  const std::vector<std::string> & pcd_names, size_t worker_num, const std::string & plan_path)
+{
+  // The inputs are split into ranges like the pipelined mode, so a single huge input is also
+  // scanned by all the readers
+  struct ScanJob
+  {
+    size_t fid;
+    bool ranged;
+    size_t begin, end;
+  };
+
+  std::vector<ScanJob> jobs;
+
+  {
+    InputReader<PointT> reader;
+
+    reader.setLAZCommand(laz_command_);
+
+    for (size_t fid = 0; fid < pcd_names.size(); ++fid) {
+      reader.setInput(pcd_names[fid]);
+
+      const size_t length = reader.rangeLength();
+      const size_t step = std::max<size_t>(reader.rangeStep(), 1);
+
+      if (reader_thread_num_ > 1 && reader.supportsRange() && length > step) {
+        for (size_t begin = 0; begin < length; begin += step) {
+          jobs.push_back({fid, true, begin, std::min(begin + step, length)});
+        }
+      } else {
+        jobs.push_back({fid, false, 0, 0});
+      }
+    }
+  }
+
+  report_.reset();
+  report_.startProgress(progress_period_, [this](const std::string & line) {
+    RCLCPP_INFO(logger_, "%s", line.c_str());
+  });
+
+  // Number of points of every large grid in each job
+  std::vector<std::unordered_map<GridInfo<2>, size_t>> job_cells(jobs.size());
+  std::atomic<size_t> next_job(0);
+  std::vector<std::thread> readers;
+
+  auto scan = [&]() {
+    InputReader<PointT> reader;
+    PclCloudType block;
+
+    reader.setLAZCommand(laz_command_);
+
+    for (size_t jid = next_job++; jid < jobs.size() && rclcpp::ok(); jid = next_job++) {
+      const auto & job = jobs[jid];
+
+      if (!job.ranged || reader.get_path() != pcd_names[job.fid]) {
+        reader.setInput(pcd_names[job.fid]);
+      }
+
+      if (job.ranged) {
+        reader.setRange(job.begin, job.end);
+      }
+
+      do {
+        {
+          auto timer = report_.time("scan");
+
+          reader.readABlock(block);
+          report_.addPoints("scan", block.size());
+        }
+
+        // The grids are the ones of the points as they are divided
+        applyStages(block);
+
+        for (const auto & p : block) {
+          ++job_cells[jid][toLargeGrid(pointToGrid2(p, grid_size_x_, grid_size_y_))];
+        }
+      } while (reader.good());
+    }
+  };
+
+  for (size_t rid = 1; rid < std::min(reader_thread_num_, jobs.size()); ++rid) {
+    readers.emplace_back(scan);
+  }
+
+  scan();
+
+  for (auto & reader : readers) {
+    reader.join();
+  }
+
+  PartitionPlan plan;
+  std::vector<std::unordered_map<GridInfo<2>, size_t>> input_cells(pcd_names.size());
+  std::unordered_map<GridInfo<2>, size_t> cell_points;
+
+  for (size_t jid = 0; jid < jobs.size(); ++jid) {
+    for (const auto & cell : job_cells[jid]) {
+      input_cells[jobs[jid].fid][cell.first] += cell.second;
+      cell_points[cell.first] += cell.second;
+    }
+  }
+
+  plan.g_grid_size_x = g_grid_size_x_;
+  plan.g_grid_size_y = g_grid_size_y_;
+  plan.assign(cell_points, worker_num);
+
+  for (size_t fid = 0; fid < pcd_names.size(); ++fid) {
+    PartitionPlan::Input input{pcd_names[fid], {}};
+
+    for (const auto & cell : input_cells[fid]) {
+      input.cells.push_back(cell.first);
+    }
+
+    plan.inputs.push_back(std::move(input));
+  }
+
+  report_.stopProgress();
+
+  if (!plan.save(plan_path)) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save the partition plan %s", plan_path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t w = 0; w < plan.workers.size(); ++w) {
+    RCLCPP_INFO(
+      logger_, "Worker %lu: %lu large grids, %lu points, %lu inputs", w,
+      plan.workers[w].cells.size(), plan.workers[w].point_num, plan.workerInputs(w).size());
+  }
+
+  RCLCPP_INFO(logger_, "Saved the partition plan to %s", plan_path.c_str());
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveReport()
+{
+  report_.stopProgress();
+  report_.count("spilled_files", spilled_file_num_);
+  report_.count("read_back_bytes", read_back_bytes_);
+  report_.count("pre_voxelized_points", pre_voxelized_point_num_);
+  report_.count("evicted_voxels", evicted_voxel_num_);
+  report_.count("outlier_points", outlier_point_num_);
+  report_.count("segments", grid_set_.size());
+
+  if (report_path_.empty()) {
+    return;
+  }
+
+  // The map is complete at this point, so a failure to save the report is not fatal
+  if (!report_.save(report_path_)) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save the run report at %s", report_path_.c_str());
+    return;
+  }
+
+  RCLCPP_INFO(logger_, "Saved the run report to %s", report_path_.c_str());
+}
+
+template <class PointT>
+void PCDDivider<PointT>::divideSequential(const std::vector<std::string> & pcd_names)
+{
+  shards_.clear();
+  shards_.resize(1);
+  shards_[0].max_resident_point_num_ = max_resident_point_num_;
+
+  startSpillWriters(4);
+
+  // Spill the resident segments, so the tmp directory holds every point binned so far
+  auto checkpoint = [this, &pcd_names](size_t consumed, size_t position) {
+    saveTheRest(shards_[0]);
+    stopSpillWriters();
+    saveCheckpoint(pcd_names, consumed, position);
+    startSpillWriters(4);
+  };
+
+  for (size_t fid = resume_input_; fid < pcd_names.size(); ++fid) {
+    const std::string & pcd_name = pcd_names[fid];
 
-  for (const std::string & pcd_name : pcd_names) {
     if (!rclcpp::ok()) {
+      stopSpillWriters();
       return;
     }
 
@@ -126,356 +486,2276 @@ void PCDDivider<PointT>::run(const std::vector<std::string> & pcd_names)
       RCLCPP_INFO(logger_, "Dividing file %s", pcd_name.c_str());
     }
 
-    do {
-      auto cloud_ptr = loadPCD(pcd_name);
+    // Skip the part of the input divided before the checkpoint
+    if (fid == resume_input_ && resume_position_ > 0) {
+      reader_.setInput(pcd_name);
+      reader_.setRange(resume_position_, reader_.rangeLength());
+    }
+
+    do {
+      auto cloud_ptr = loadPCD(pcd_name);
+
+      if (record_grids_) {
+        collectGrids(*cloud_ptr, input_records_[pcd_name].grids);
+      }
+
+      dividePointCloud(*cloud_ptr, shards_[0], 0, 1);
+
+      // Inputs that cannot be read by ranges are checkpointed at their end only
+      if (checkpointDue() && reader_.good() && reader_.supportsRange()) {
+        checkpoint(fid, reader_.rangePosition());
+      }
+    } while (reader_.good() && rclcpp::ok());
+
+    report_.addBytes("read", fs::file_size(pcd_name));
+
+    if (checkpointDue() && rclcpp::ok()) {
+      checkpoint(fid + 1, 0);
+    }
+  }
+
+  saveTheRest(shards_[0]);
+  stopSpillWriters();
+}
+
+template <class PointT>
+void PCDDivider<PointT>::dividePipelined(const std::vector<std::string> & pcd_names)
+{
+  const size_t file_num = pcd_names.size();
+  const size_t worker_num = worker_thread_num_;
+
+  // A range of an input decoded by a reader, the whole input if it is not ranged
+  struct ReadJob
+  {
+    size_t fid;
+    bool ranged;
+    size_t begin, end;
+  };
+
+  // With several readers, uncompressed binary and ASCII inputs are split into ranges of about
+  // one block, which are decoded concurrently by all the readers, so that a single huge input
+  // also scales
+  std::vector<ReadJob> jobs;
+
+  {
+    InputReader<PointT> reader;
+
+    reader.setLAZCommand(laz_command_);
+    reader.setAsyncIO(input_io_);
+
+    for (size_t fid = resume_input_; fid < file_num; ++fid) {
+      reader.setInput(pcd_names[fid]);
+
+      const size_t length = reader.rangeLength();
+      const size_t step = std::max<size_t>(reader.rangeStep(), 1);
+      // The part of the input divided before the checkpoint is skipped
+      const size_t first = (fid == resume_input_) ? resume_position_ : 0;
+
+      if (reader_thread_num_ > 1 && reader.supportsRange() && length > first + step) {
+        for (size_t begin = first; begin < length; begin += step) {
+          jobs.push_back({fid, true, begin, std::min(begin + step, length)});
+        }
+      } else if (first > 0) {
+        jobs.push_back({fid, true, first, length});
+      } else {
+        jobs.push_back({fid, false, 0, 0});
+      }
+    }
+  }
+
+  const size_t job_num = jobs.size();
+  const size_t reader_num = std::max<size_t>(std::min(reader_thread_num_, job_num), 1);
+
+  // The resident point budget is split evenly among the shards
+  shards_.clear();
+  shards_.resize(worker_num);
+
+  for (auto & shard : shards_) {
+    shard.max_resident_point_num_ = max_resident_point_num_ / worker_num;
+  }
+
+  // Each reader has its own queue, and ends the blocks of a job with a null block, so blocks are
+  // dispatched in the same order as the sequential mode regardless of which reader finishes
+  // first. The queues hold at most one block to bound the memory held by readers running ahead
+  // of the dispatcher.
+  std::vector<std::unique_ptr<BoundedQueue<PclCloudPtr>>> reader_queues;
+  std::vector<std::unique_ptr<BoundedQueue<PclCloudPtr>>> worker_queues;
+
+  for (size_t rid = 0; rid < reader_num; ++rid) {
+    reader_queues.emplace_back(std::make_unique<BoundedQueue<PclCloudPtr>>(1));
+  }
+
+  for (size_t wid = 0; wid < worker_num; ++wid) {
+    worker_queues.emplace_back(std::make_unique<BoundedQueue<PclCloudPtr>>(2));
+  }
+
+  startSpillWriters(worker_num * 4);
+
+  // Binning stage: every worker scans all blocks but only keeps the points of its own grids,
+  // so the points of a grid are appended in exactly the same order as the sequential mode
+  std::vector<std::thread> workers;
+
+  for (size_t wid = 0; wid < worker_num; ++wid) {
+    workers.emplace_back([this, wid, worker_num, &worker_queues]() {
+      PclCloudPtr block;
+
+      while (worker_queues[wid]->pop(block)) {
+        // A null block requests the resident segments to be spilled for a checkpoint
+        if (!block) {
+          saveTheRest(shards_[wid]);
+
+          {
+            std::lock_guard<std::mutex> lock(checkpoint_mtx_);
+            ++flushed_shard_num_;
+          }
+
+          checkpoint_cv_.notify_all();
+          continue;
+        }
+
+        dividePointCloud(*block, shards_[wid], wid, worker_num);
+      }
+
+      saveTheRest(shards_[wid]);
+    });
+  }
+
+  // Reading stage: reader rid decodes the jobs rid, rid + reader_num, ...
+  std::vector<std::thread> readers;
+  std::vector<std::unordered_set<GridInfo<2>>> job_grids(job_num);
+
+  for (size_t rid = 0; rid < reader_num; ++rid) {
+    readers.emplace_back([this, rid, reader_num, job_num, &pcd_names, &jobs, &reader_queues,
+                          &job_grids]() {
+      InputReader<PointT> reader;
+      auto & queue = *reader_queues[rid];
+
+      reader.setLAZCommand(laz_command_);
+      reader.setAsyncIO(input_io_);
+
+      for (size_t jid = rid; jid < job_num; jid += reader_num) {
+        const auto & job = jobs[jid];
+
+        // The ranges of an input read by the same reader share its header and mapping
+        if (!job.ranged || reader.get_path() != pcd_names[job.fid]) {
+          reader.setInput(pcd_names[job.fid]);
+        }
+
+        if (job.ranged) {
+          reader.setRange(job.begin, job.end);
+        }
+
+        do {
+          PclCloudPtr block(new PclCloudType);
+
+          {
+            auto timer = report_.time("read");
+
+            reader.readABlock(*block);
+            report_.addPoints("read", block->size());
+          }
+
+          applyStages(*block);
+
+          if (record_grids_) {
+            collectGrids(*block, job_grids[jid]);
+          }
+
+          if (!queue.push(block)) {
+            return;
+          }
+        } while (reader.good() && rclcpp::ok());
+
+        if (!queue.push(nullptr)) {
+          return;
+        }
+      }
+    });
+  }
+
+  // The grids of the jobs whose blocks are all dispatched are moved to the input records
+  size_t recorded_job_num = 0;
+
+  auto recordGrids = [&](size_t end_job) {
+    for (; record_grids_ && recorded_job_num < end_job; ++recorded_job_num) {
+      auto & grids = input_records_[pcd_names[jobs[recorded_job_num].fid]].grids;
+
+      grids.insert(job_grids[recorded_job_num].begin(), job_grids[recorded_job_num].end());
+      job_grids[recorded_job_num].clear();
+    }
+  };
+
+  for (size_t jid = 0; jid < job_num && rclcpp::ok(); ++jid) {
+    if (debug_mode_ && jobs[jid].begin == 0) {
+      RCLCPP_INFO(logger_, "Dividing file %s", pcd_names[jobs[jid].fid].c_str());
+    }
+
+    PclCloudPtr block;
+
+    while (reader_queues[jid % reader_num]->pop(block) && block && rclcpp::ok()) {
+      for (auto & queue : worker_queues) {
+        queue->push(block);
+      }
+    }
+
+    const bool file_end = (jid + 1 == job_num || jobs[jid + 1].fid != jobs[jid].fid);
+
+    // The bytes of an input are counted once all its ranges are dispatched
+    if (file_end) {
+      report_.addBytes("read", fs::file_size(pcd_names[jobs[jid].fid]));
+    }
+
+    if (checkpointDue() && rclcpp::ok()) {
+      // Wait until every worker binned the dispatched blocks and spilled its resident segments
+      {
+        std::lock_guard<std::mutex> lock(checkpoint_mtx_);
+        flushed_shard_num_ = 0;
+      }
+
+      for (auto & queue : worker_queues) {
+        queue->push(nullptr);
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(checkpoint_mtx_);
+        checkpoint_cv_.wait(lock, [&]() { return flushed_shard_num_ == worker_num; });
+      }
+
+      // The workers wait for the next blocks, so the spill writers can be restarted safely
+      stopSpillWriters();
+      recordGrids(jid + 1);
+
+      if (file_end) {
+        saveCheckpoint(pcd_names, jobs[jid].fid + 1, 0);
+      } else {
+        saveCheckpoint(pcd_names, jobs[jid].fid, jobs[jid].end);
+      }
+
+      startSpillWriters(worker_num * 4);
+    }
+  }
+
+  // Unblock the readers if the dispatching was interrupted
+  for (auto & queue : reader_queues) {
+    queue->close();
+  }
+
+  for (auto & reader : readers) {
+    reader.join();
+  }
+
+  recordGrids(job_num);
+
+  for (auto & queue : worker_queues) {
+    queue->close();
+  }
+
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  stopSpillWriters();
+}
+
+template <class PointT>
+void PCDDivider<PointT>::checkOutputDirectoryValidity()
+{
+  tmp_dir_ = output_dir_ + "/tmp/";
+
+  // A resumed run continues with the tmp directory of the interrupted run, and the output of
+  // the interrupted run is overwritten by the finalization
+  if (fs::exists(tmp_dir_) && !resumed_) {
+    fs::remove_all(tmp_dir_);
+  }
+
+  // Incremental runs update the segments of the previous run in place
+  if (fs::exists(output_dir_) && !incremental_ && !resumed_) {
+    fs::remove_all(output_dir_);
+  }
+
+  for (size_t lod = 0; lod <= lod_leaf_sizes_.size(); ++lod) {
+    util::make_dir(makeMapDir(lod));
+  }
+
+  util::make_dir(tmp_dir_);
+}
+
+template <class PointT>
+typename pcl::PointCloud<PointT>::Ptr PCDDivider<PointT>::loadPCD(const std::string & pcd_name)
+{
+  if (pcd_name != reader_.get_path()) {
+    reader_.setInput(pcd_name);
+  }
+
+  PclCloudPtr cloud_ptr(new PclCloudType);
+
+  {
+    auto timer = report_.time("read");
+
+    reader_.readABlock(*cloud_ptr);
+    report_.addPoints("read", cloud_ptr->size());
+  }
+
+  applyStages(*cloud_ptr);
+
+  return cloud_ptr;
+}
+
+template <class PointT>
+void PCDDivider<PointT>::applyStages(PclCloudType & block)
+{
+  for (const auto & stage : stages_) {
+    auto timer = report_.time(stage->name());
+
+    report_.addPoints(stage->name(), block.size());
+    stage->process(block);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::savePCD(const std::string & path, const pcl::PointCloud<PointT> & cloud)
+{
+  if (pcl::io::savePCDFileBinary(path, cloud) == -1) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save PCD: %s", path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::dividePointCloud(
+  const PclCloudType & input, GridShard & shard, size_t shard_id, size_t shard_num)
+{
+  if (input.size() <= 0) {
+    return;
+  }
+
+  if (!rclcpp::ok()) {
+    rclcpp::shutdown();
+    exit(EXIT_SUCCESS);
+  }
+
+  auto timer = report_.time("bin");
+
+  // Every shard scans all the points, so they are counted by the first shard only
+  if (shard_id == 0) {
+    report_.addPoints("bin", input.size());
+  }
+
+  auto & grid_to_cloud = shard.grid_to_cloud_;
+  auto & seg_by_size = shard.seg_by_size_;
+  auto & seg_to_size_itr_map = shard.seg_to_size_itr_map_;
+  auto & resident_point_num = shard.resident_point_num_;
+  auto & cells = shard.cells_;
+
+  // The grids are computed for a batch of points first, then the points are binned
+  const GridMapper to_grid(grid_size_x_, grid_size_y_);
+  std::array<GridInfo<2>, 1024> grids;
+
+  // Consecutive points mostly fall in the same grid, so its cell is looked up only when the
+  // grid changes
+  GridCell * cell = nullptr;
+  uint64_t cell_key = 0;
+
+  for (size_t batch_begin = 0; batch_begin < input.size(); batch_begin += grids.size()) {
+    const size_t batch_size = std::min(grids.size(), input.size() - batch_begin);
+
+    for (size_t i = 0; i < batch_size; ++i) {
+      grids[i] = to_grid(input[batch_begin + i]);
+    }
+
+    for (size_t i = 0; i < batch_size; ++i) {
+      const PointT & p = input[batch_begin + i];
+      const auto & tmp = grids[i];
+      const uint64_t key = GridTable<GridCell>::key(tmp);
+
+      if (!cell || key != cell_key) {
+        cell = cells.find(key);
+        cell_key = key;
+      }
+
+      // If the grid has not been seen by the shard yet, create a new one
+      if (!cell) {
+        GridCell new_cell;
+
+        // Skip the points of the grids owned by other shards, and of the segments that are
+        // neither output nor in the halos of the output ones
+        new_cell.owned =
+          (shard_num <= 1 || std::hash<GridInfo<2>>{}(tmp) % shard_num == shard_id) &&
+          isBinnedGrid(tmp);
+
+        if (new_cell.owned) {
+          new_cell.it = grid_to_cloud.emplace(tmp, typename GridMapType::mapped_type()).first;
+
+          auto & new_grid = new_cell.it->second;
+
+          // Clouds kept until the end grow on demand, since most grids never reach a block
+          if (!in_memory_) {
+            std::get<0>(new_grid).reserve(max_block_size_);
+          }
+
+          // Counter set to 0, or after the tmp PCDs of the grid before the checkpoint
+          auto counter_it = resumed_counters_.find(tmp);
+
+          std::get<0>(new_grid).push_back(p);  // Push the first point to the cloud
+          std::get<1>(new_grid) = counter_it != resumed_counters_.end() ? counter_it->second : 0;
+          std::get<2>(new_grid) = 0;           // Prev size is 0
+          std::get<3>(new_grid) = shard.binned_point_num_++;
+        }
+
+        cell = &cells.insert(key, new_cell);
+
+        continue;
+      }
+
+      if (!cell->owned) {
+        continue;
+      }
+
+      auto it = cell->it;
+      auto & cloud = std::get<0>(it->second);
+      auto & prev_size = std::get<2>(it->second);
+
+      cloud.push_back(p);
+      std::get<3>(it->second) = shard.binned_point_num_++;
+
+      ++resident_point_num;
+
+      // All points stay in memory until the end, so there is nothing to spill. The grid is
+      // compacted after every block of new points instead.
+      if (in_memory_) {
+        if (pre_voxelize_ && cloud.size() - prev_size >= max_block_size_) {
+          compactGrid(shard, it);
+        }
+
+        continue;
+      }
+
+      // If the number of points in the segment reach maximum, save the segment to file, unless
+      // most of them were redundant
+      if (cloud.size() == max_block_size_) {
+        if (!compactGrid(shard, it)) {
+          saveGridPCD(shard, it);
+        }
+      } else {
+        // Otherwise, update the seg_by_size if the change of size is significant
+        if (cloud.size() - prev_size >= size_update_step_) {
+          prev_size = cloud.size();
+          auto seg_to_size_it = seg_to_size_itr_map.find(tmp);
+
+          if (seg_to_size_it == seg_to_size_itr_map.end()) {
+            auto size_it = seg_by_size.insert(std::make_pair(prev_size, it));
+            seg_to_size_itr_map[tmp] = size_it;
+          } else {
+            seg_by_size.erase(seg_to_size_it->second);
+            auto new_size_it = seg_by_size.insert(std::make_pair(prev_size, it));
+            seg_to_size_it->second = new_size_it;
+          }
+        }
+      }
+
+      // If the number of resident points reach maximum, save a resident segment to SSD
+      if (resident_point_num >= shard.max_resident_point_num_ && !seg_by_size.empty()) {
+        auto victim = pickSpillVictim(shard);
+
+        // Dropping the redundant points of the victim may free enough memory already
+        if (!compactGrid(shard, victim) || resident_point_num >= shard.max_resident_point_num_) {
+          saveGridPCD(shard, victim);
+        }
+      }
+    }
+  }
+}
+
+template <class PointT>
+typename PCDDivider<PointT>::GridMapItr PCDDivider<PointT>::pickSpillVictim(
+  GridShard & shard) const
+{
+  if (spill_policy_ == SpillPolicy::SIZE) {
+    return shard.seg_by_size_.rbegin()->second;
+  }
+
+  // Among the largest segments, prefer the ones that have not received points for a long
+  // time, since a survey rarely comes back to an area it has just left. The age is measured
+  // in binned points and normalized by the size of a spilled segment.
+  const size_t candidate_num = 8;
+  GridMapItr victim = shard.seg_by_size_.rbegin()->second;
+  double max_score = 0;
+  size_t checked_num = 0;
+
+  for (auto it = shard.seg_by_size_.rbegin();
+       it != shard.seg_by_size_.rend() && checked_num < candidate_num; ++it, ++checked_num) {
+    auto & grid = it->second->second;
+    double bytes = static_cast<double>(std::get<0>(grid).size() * sizeof(PointT));
+    double age = static_cast<double>(shard.binned_point_num_ - std::get<3>(grid));
+    double score = bytes * (1.0 + age / static_cast<double>(max_block_size_));
+
+    if (score > max_score) {
+      max_score = score;
+      victim = it->second;
+    }
+  }
+
+  return victim;
+}
+
+template <class PointT>
+void PCDDivider<PointT>::setMemoryBudget(size_t budget)
+{
+  if (budget == 0) {
+    max_resident_point_num_ = 100000000;
+    max_block_size_ = 500000;
+    size_update_step_ = 10000;
+
+    return;
+  }
+
+  // Keep a quarter of the budget for the hash maps, the reader blocks and the
+  // buffers waiting for the spill writers
+  max_resident_point_num_ = std::max<size_t>(budget / 4 * 3 / sizeof(PointT), 1);
+  // Same ratios as the default limits: a spilled segment is 1/200 of the resident points,
+  // and the segment ordering is updated every 1/50 of a spilled segment
+  max_block_size_ = std::clamp<size_t>(max_resident_point_num_ / 200, 10000, 500000);
+  size_update_step_ = std::max<size_t>(max_block_size_ / 50, 1);
+}
+
+template <class PointT>
+bool PCDDivider<PointT>::compactGrid(GridShard & shard, GridMapItr & grid_it)
+{
+  auto & cloud = std::get<0>(grid_it->second);
+  auto & prev_size = std::get<2>(grid_it->second);
+
+  if (!pre_voxelize_ || leaf_size_ <= 0 || cloud.empty()) {
+    return false;
+  }
+
+  auto timer = report_.time("pre_voxel");
+  VoxelGridFilter<PointT> vgf;
+  PclCloudType filtered_cloud;
+
+  vgf.setResolution(leaf_size_);
+  vgf.setEngine(voxel_filter_engine_);
+  vgf.filter(cloud, filtered_cloud);
+  report_.addPoints("pre_voxel", cloud.size());
+
+  const size_t point_num = cloud.size();
+  const size_t dropped_num = point_num - filtered_cloud.size();
+
+  shard.resident_point_num_ -= dropped_num;
+  pre_voxelized_point_num_ += dropped_num;
+
+  // Copy the centroids back, so the grid keeps its reserved buffer
+  cloud.clear();
+
+  for (const auto & p : filtered_cloud) {
+    cloud.push_back(p);
+  }
+
+  auto it = shard.seg_to_size_itr_map_.find(grid_it->first);
+
+  if (it != shard.seg_to_size_itr_map_.end()) {
+    shard.seg_by_size_.erase(it->second);
+    shard.seg_to_size_itr_map_.erase(it);
+  }
+
+  // The grid is ordered again by the next update of its size. In memory, the size after the
+  // compaction is kept to compact the grid again after a block of new points.
+  prev_size = in_memory_ ? cloud.size() : 0;
+
+  return dropped_num * 2 >= point_num;
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveGridPCD(GridShard & shard, GridMapItr & grid_it, bool reuse)
+{
+  auto & cloud = std::get<0>(grid_it->second);
+  auto & counter = std::get<1>(grid_it->second);
+  auto & prev_size = std::get<2>(grid_it->second);
+
+  // Try to create a new directory to contain the cloud
+  std::ostringstream seg_path, file_path;
+
+  seg_path << tmp_dir_ << "/" << grid_it->first << "/";
+  file_path << seg_path.str() << counter << "_" << cloud.size()
+            << (spill_encoding_ == SpillEncoding::PCD ? ".pcd" : ".spill");
+
+  shard.resident_point_num_ -= cloud.size();
+
+  SpillTask task;
+
+  task.grid = grid_it->first;
+  task.seg_path = seg_path.str();
+  task.file_path = file_path.str();
+
+  {
+    std::lock_guard<std::mutex> lock(manifest_mtx_);
+    auto & record = manifest_[grid_it->first];
+
+    record.pcd_list.push_back(task.file_path);
+    record.point_num += cloud.size();
+  }
+
+  task.cloud.swap(cloud);
+
+  if (spill_queue_) {
+    // Hand the points over to the background writers, and continue binning to a recycled buffer
+    spill_queue_->push(std::move(task));
+
+    if (reuse) {
+      acquireCloud(cloud);
+    }
+  } else {
+    writeSpill(task);
+
+    // Clear the content of the segment cloud and reserve space for further points
+    if (reuse) {
+      task.cloud.swap(cloud);
+      cloud.clear();
+      cloud.reserve(max_block_size_);
+    }
+  }
+
+  ++counter;  // Increase the counter so the next segment save will not overwrite the previously
+              // saved one
+  prev_size = 0;
+
+  // Update the seg_by_size_ and seg_to_size_itr_map_
+  auto it = shard.seg_to_size_itr_map_.find(grid_it->first);
+
+  if (it != shard.seg_to_size_itr_map_.end()) {
+    shard.seg_by_size_.erase(it->second);
+    shard.seg_to_size_itr_map_.erase(it);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::writeSpill(const SpillTask & task)
+{
+  auto timer = report_.time("spill");
+
+  util::make_dir(task.seg_path);
+
+  size_t file_size = 0;
+
+  // With the outlier removal, the points near the border are also written to a strip, so the
+  // halos of the adjacent segments are read from the strips instead of the whole segment. The
+  // strip is written first, so it exists for every temporary file listed by a checkpoint.
+  if (outlier_mean_k_ > 0) {
+    const double min_x = task.grid.ix + outlier_halo_;
+    const double max_x = task.grid.ix + grid_size_x_ - outlier_halo_;
+    const double min_y = task.grid.iy + outlier_halo_;
+    const double max_y = task.grid.iy + grid_size_y_ - outlier_halo_;
+    PclCloudType strip;
+
+    for (const auto & p : task.cloud) {
+      if (p.x < min_x || p.x > max_x || p.y < min_y || p.y > max_y) {
+        strip.push_back(p);
+      }
+    }
+
+    if (!strip.empty()) {
+      file_size += writeSpillCloud(makeHaloPath(task.file_path), strip);
+
+      std::lock_guard<std::mutex> lock(manifest_mtx_);
+
+      manifest_[task.grid].halo_point_num += strip.size();
+    }
+  }
+
+  file_size += writeSpillCloud(task.file_path, task.cloud);
+  spilled_bytes_ += file_size;
+  ++spilled_file_num_;
+  report_.addBytes("spill", file_size);
+  report_.addPoints("spill", task.cloud.size());
+}
+
+template <class PointT>
+size_t PCDDivider<PointT>::writeSpillCloud(const std::string & path, const PclCloudType & cloud)
+{
+  // A spill chunk is encoded in memory and written at once. For PCDs, the writer coalesces the
+  // points to chunks written by io_uring, while the PCL writer maps the file.
+  if (spill_encoding_ != SpillEncoding::PCD) {
+    std::vector<char> buffer;
+
+    encodeSpillChunk(
+      cloud, leaf_size_, spill_encoding_ == SpillEncoding::QUANTIZED_COMPRESSED, buffer);
+
+    if (!writeSpillFile(path, buffer, async_io_)) {
+      RCLCPP_ERROR(logger_, "Error: Cannot save a spill chunk at %s", path.c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+  } else if (async_io_.queue_depth > 0) {
+    // One ring and one buffer pool per spill thread
+    static thread_local CustomPCDWriter<PointT> writer;
+
+    writer.setAsyncIO(async_io_);
+    writer.setOutput(path);
+    writer.writeMetadata(cloud.size(), true);
+    writer.write(cloud);
+
+    if (!writer.good()) {
+      RCLCPP_ERROR(logger_, "Error: Cannot save a PCD file at %s", path.c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    writer.close();
+  } else if (pcl::io::savePCDFileBinary(path, cloud)) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save a PCD file at %s", path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  return fs::file_size(path);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::startSpillWriters(size_t queue_capacity)
+{
+  if (spill_thread_num_ == 0) {
+    return;
+  }
+
+  spill_queue_ = std::make_unique<BoundedQueue<SpillTask>>(queue_capacity);
+  max_free_cloud_num_ = queue_capacity + spill_thread_num_;
+
+  for (size_t i = 0; i < spill_thread_num_; ++i) {
+    spill_writers_.emplace_back([this]() {
+      SpillTask task;
+
+      while (spill_queue_->pop(task)) {
+        writeSpill(task);
+        releaseCloud(task.cloud);
+      }
+    });
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::stopSpillWriters()
+{
+  if (!spill_queue_) {
+    return;
+  }
+
+  // Writers drain the remaining spills before exiting
+  spill_queue_->close();
+
+  for (auto & writer : spill_writers_) {
+    writer.join();
+  }
+
+  spill_writers_.clear();
+  spill_queue_.reset();
+
+  std::lock_guard<std::mutex> lock(free_clouds_mtx_);
+
+  free_clouds_.clear();
+}
+
+template <class PointT>
+void PCDDivider<PointT>::acquireCloud(PclCloudType & cloud)
+{
+  {
+    std::lock_guard<std::mutex> lock(free_clouds_mtx_);
+
+    if (!free_clouds_.empty()) {
+      cloud.swap(free_clouds_.back());
+      free_clouds_.pop_back();
+
+      return;
+    }
+  }
+
+  cloud = PclCloudType();
+  cloud.reserve(max_block_size_);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::releaseCloud(PclCloudType & cloud)
+{
+  cloud.clear();
+
+  std::lock_guard<std::mutex> lock(free_clouds_mtx_);
+
+  // Keep at most as many buffers as the spills that can be in flight
+  if (free_clouds_.size() < max_free_cloud_num_) {
+    free_clouds_.emplace_back();
+    free_clouds_.back().swap(cloud);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveTheRest(GridShard & shard)
+{
+  for (auto it = shard.grid_to_cloud_.begin(); it != shard.grid_to_cloud_.end(); ++it) {
+    auto & cloud = std::get<0>(it->second);
+
+    if (cloud.size() > 0) {
+      if (in_memory_) {
+        saveResidentGrid(it->first, cloud);
+      } else {
+        compactGrid(shard, it);
+        saveGridPCD(shard, it, false);
+      }
+    }
+  }
+
+  if (in_memory_) {
+    shard.grid_to_cloud_.clear();
+    shard.cells_.clear();
+    shard.resident_point_num_ = 0;
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveResidentGrid(const GridInfo<2> & grid, PclCloudType & cloud)
+{
+  NDTVoxelGrid ndt_voxels(ndt_resolution_);
+
+  if (ndt_resolution_ > 0) {
+    auto timer = report_.time("ndt");
+
+    ndt_voxels.add(cloud);
+    report_.addPoints("ndt", cloud.size());
+  }
+
+  if (leaf_size_ > 0) {
+    VoxelGridFilter<PointT> vgf;
+    PclCloudType filtered_cloud;
+
+    vgf.setResolution(leaf_size_);
+    vgf.setEngine(voxel_filter_engine_);
+
+    {
+      auto timer = report_.time("voxel");
+
+      vgf.filter(cloud, filtered_cloud);
+      report_.addPoints("voxel", cloud.size());
+    }
+
+    saveSegment(grid, filtered_cloud);
+  } else {
+    saveSegment(grid, cloud);
+  }
+
+  if (ndt_resolution_ > 0) {
+    saveNDTVoxels(grid, ndt_voxels);
+  }
+
+  // Release the points as soon as the segment is saved
+  PclCloudType().swap(cloud);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::mergeAndDownsample()
+{
+  // Segments are finalized in groups. In the large grid mode, a group holds all segments of a
+  // large grid, so every large grid folder is written by a single worker.
+  struct FinalizeGroup
+  {
+    std::vector<std::pair<GridInfo<2>, const SegmentRecord *>> segments;
+    size_t total_point_num = 0;
+    // Segments of a group are finalized one by one, so the group holds at most this many points
+    size_t peak_point_num = 0;
+  };
+
+  std::unordered_map<GridInfo<2>, FinalizeGroup> group_map;
+
+  for (auto & it : manifest_) {
+    // The segments binned for the halos of the output ones are not output
+    if (!isOutputGrid(it.first)) {
+      continue;
+    }
+
+    auto & group = group_map[use_large_grid_ ? toLargeGrid(it.first) : it.first];
+    size_t point_num = it.second.point_num;
+
+    // The halo is read with the segment, and is at most the border strips of its neighbors
+    for (int dx = -1; outlier_mean_k_ > 0 && dx <= 1; ++dx) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        auto neighbor = manifest_.find(adjacentGrid(it.first, dx, dy));
+
+        if ((dx != 0 || dy != 0) && neighbor != manifest_.end()) {
+          point_num += neighbor->second.halo_point_num;
+        }
+      }
+    }
+
+    group.segments.emplace_back(it.first, &it.second);
+    group.total_point_num += point_num;
+    group.peak_point_num = std::max(group.peak_point_num, point_num);
+  }
+
+  std::vector<FinalizeGroup> groups;
+
+  groups.reserve(group_map.size());
+
+  for (auto & it : group_map) {
+    groups.push_back(std::move(it.second));
+  }
+
+  // Finalize the largest groups first, so the long tasks do not end up running alone
+  std::sort(groups.begin(), groups.end(), [](const auto & a, const auto & b) {
+    return a.total_point_num > b.total_point_num;
+  });
+
+  // Admission control: the points of the segments being finalized concurrently must not
+  // exceed the resident point limit. A segment larger than the limit runs alone.
+  std::mutex admission_mtx;
+  std::condition_variable admission_cv;
+  size_t next_group = 0, running_point_num = 0;
+
+  auto finalize = [&]() {
+    while (rclcpp::ok()) {
+      std::unique_lock<std::mutex> lock(admission_mtx);
+
+      admission_cv.wait(lock, [&]() {
+        return next_group >= groups.size() || running_point_num == 0 ||
+               running_point_num + groups[next_group].peak_point_num <= max_resident_point_num_;
+      });
+
+      if (next_group >= groups.size()) {
+        break;
+      }
+
+      auto & group = groups[next_group++];
+      size_t point_num = group.peak_point_num;
+
+      running_point_num += point_num;
+      lock.unlock();
+
+      for (auto & seg : group.segments) {
+        if (debug_mode_) {
+          std::ostringstream seg_name;
+
+          seg_name << seg.first;
+          RCLCPP_INFO(logger_, "Saving segment %s", seg_name.str().c_str());
+        }
+
+        mergeAndDownsample(seg.first, *seg.second);
+      }
+
+      lock.lock();
+      running_point_num -= point_num;
+      lock.unlock();
+      admission_cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> finalizers;
+
+  for (size_t i = 1; i < std::min(finalize_thread_num_, groups.size()); ++i) {
+    finalizers.emplace_back(finalize);
+  }
+
+  finalize();
+
+  for (auto & t : finalizers) {
+    t.join();
+  }
+
+  manifest_.clear();
+
+  // Remove tmp dir
+  util::remove(tmp_dir_);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::mergeAndDownsample(
+  const GridInfo<2> & grid, const SegmentRecord & record)
+{
+  auto timer = report_.time("finalize");
+  const auto & pcd_list = record.pcd_list;
+  size_t total_point_num = record.point_num;
+  PclCloudPtr new_cloud(new PclCloudType);
+  CustomPCDReader<PointT> reader;
+  PclCloudType block;
+  VoxelGridFilter<PointT> vgf;
+  NDTVoxelGrid ndt_voxels(ndt_resolution_);
+
+  reader.setAsyncIO(async_io_);
+
+  // Pass the points of a temporary segment to @consume, block by block. A spill chunk is
+  // decoded at once, as it holds no more points than a temporary segment.
+  std::vector<char> buffer;
+  auto read_back = [&](const std::string & fname, auto && consume) {
+    read_back_bytes_ += fs::file_size(fname);
+
+    if (fs::path(fname).extension() == ".spill") {
+      if (!readSpillFile(fname, buffer, async_io_) || !decodeSpillChunk(buffer, block)) {
+        RCLCPP_ERROR(logger_, "Error: Cannot read the spill chunk %s", fname.c_str());
+        rclcpp::shutdown();
+        exit(EXIT_FAILURE);
+      }
+
+      consume(block);
+      return;
+    }
+
+    reader.setInput(fname);
+
+    do {
+      reader.readABlock(block);
+      consume(block);
+    } while (reader.good());
+  };
+
+  // The NDT voxels are accumulated from the raw points, block by block as they are read back
+  auto add_ndt_voxels = [&](const PclCloudType & points) {
+    if (ndt_resolution_ > 0) {
+      auto ndt_timer = report_.time("ndt");
+
+      ndt_voxels.add(points);
+      report_.addPoints("ndt", points.size());
+    }
+  };
+
+  vgf.setResolution(leaf_size_);
+  vgf.setEngine(voxel_filter_engine_);
+
+  if (leaf_size_ > 0 && total_point_num > max_block_size_) {
+    vgf.setMaxVoxelNum(max_voxel_num_);
+
+    // Stream the temporary PCDs of a dense segment block by block into the voxel
+    // accumulators, so its raw points never reside in memory at once
+    for (auto & fname : pcd_list) {
+      read_back(fname, [&](const PclCloudType & points) {
+        add_ndt_voxels(points);
+
+        auto voxel_timer = report_.time("voxel");
+
+        vgf.add(points);
+      });
+    }
+
+    auto voxel_timer = report_.time("voxel");
+
+    vgf.flush(*new_cloud);
+    report_.addPoints("voxel", total_point_num);
+    evicted_voxel_num_ += vgf.evictedVoxelNum();
+  } else {
+    new_cloud->reserve(total_point_num);
+
+    // Merge all PCDs that belong to the specified segment to a single segment point cloud
+    for (auto & fname : pcd_list) {
+      read_back(fname, [&](const PclCloudType & points) {
+        add_ndt_voxels(points);
+
+        for (auto & p : points) {
+          new_cloud->push_back(p);
+        }
+      });
+    }
+
+    // Downsample if needed
+    if (leaf_size_ > 0) {
+      PclCloudPtr filtered_cloud(new PclCloudType);
+      auto voxel_timer = report_.time("voxel");
+
+      vgf.filter(*new_cloud, *filtered_cloud);
+      report_.addPoints("voxel", new_cloud->size());
+      new_cloud = filtered_cloud;
+    }
+  }
+
+  if (outlier_mean_k_ > 0) {
+    // The halo is made of the points of the adjacent segments within outlier_halo_ of this
+    // one, downsampled as the adjacent segments are, so the points at the border have the
+    // neighbors they have in the whole map. They are read from the border strips of the
+    // temporary files, and a file without a strip has no point near the border.
+    const double min_x = grid.ix - outlier_halo_, max_x = grid.ix + grid_size_x_ + outlier_halo_;
+    const double min_y = grid.iy - outlier_halo_, max_y = grid.iy + grid_size_y_ + outlier_halo_;
+    PclCloudType halo, filtered_halo;
+
+    for (int dx = -1; dx <= 1; ++dx) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        auto it = manifest_.find(adjacentGrid(grid, dx, dy));
+
+        if ((dx == 0 && dy == 0) || it == manifest_.end()) {
+          continue;
+        }
+
+        for (auto & fname : it->second.pcd_list) {
+          const std::string halo_path = makeHaloPath(fname);
+
+          if (!fs::exists(halo_path)) {
+            continue;
+          }
+
+          read_back(halo_path, [&](const PclCloudType & points) {
+            for (auto & p : points) {
+              if (p.x >= min_x && p.x <= max_x && p.y >= min_y && p.y <= max_y) {
+                halo.push_back(p);
+              }
+            }
+          });
+        }
+      }
+    }
+
+    if (leaf_size_ > 0) {
+      VoxelGridFilter<PointT> halo_vgf;
+      auto voxel_timer = report_.time("voxel");
+
+      halo_vgf.setResolution(leaf_size_);
+      halo_vgf.setEngine(voxel_filter_engine_);
+      halo_vgf.filter(halo, filtered_halo);
+      report_.addPoints("voxel", halo.size());
+      halo.swap(filtered_halo);
+    }
+
+    removeOutliers(new_cloud, halo);
+  }
+
+  saveSegment(grid, *new_cloud);
+
+  if (ndt_resolution_ > 0) {
+    saveNDTVoxels(grid, ndt_voxels);
+  }
+
+  // The tmp PCDs are kept until the end with the checkpoints, since a run resuming while
+  // finalizing merges all segments again, and with the outlier removal, since they are the
+  // halos of the adjacent segments
+  if (checkpoint_period_ > 0 || outlier_mean_k_ > 0) {
+    return;
+  }
+
+  // Delete the folder containing the segments
+  std::ostringstream seg_path;
+
+  seg_path << tmp_dir_ << "/" << grid << "/";
+  util::remove(seg_path.str());
+}
+
+template <class PointT>
+void PCDDivider<PointT>::removeOutliers(PclCloudPtr & cloud, const PclCloudType & halo)
+{
+  auto timer = report_.time("outlier");
+  const size_t point_num = cloud->size();
+
+  if (point_num == 0) {
+    return;
+  }
+
+  // The neighbors are searched in the segment and its halo, and only the points of the
+  // segment are filtered and output
+  pcl::IndicesPtr indices(new std::vector<int>(point_num));
+  pcl::StatisticalOutlierRemoval<PointT> sor;
+  PclCloudPtr inliers(new PclCloudType);
+
+  std::iota(indices->begin(), indices->end(), 0);
+  *cloud += halo;
+
+  sor.setInputCloud(cloud);
+  sor.setIndices(indices);
+  sor.setMeanK(outlier_mean_k_);
+  sor.setStddevMulThresh(outlier_stddev_mul_);
+  sor.filter(*inliers);
+
+  outlier_point_num_ += point_num - inliers->size();
+  report_.addPoints("outlier", point_num);
+  cloud = inliers;
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveSegment(const GridInfo<2> & grid, PclCloudType & cloud)
+{
+  // Segment name only (format gx_gy)
+  std::ostringstream seg_name;
+
+  seg_name << grid;
+
+  {
+    std::lock_guard<std::mutex> lock(grid_set_mtx_);
+    grid_set_.insert(grid);
+  }
+
+  // Save the merged (filtered) cloud, then the coarser levels of detail. The levels are sorted
+  // one by one, since the voxel grid filter does not keep the order of its input.
+  PclCloudType * lod_cloud = &cloud;
+  PclCloudType lod_clouds[2];
+
+  for (size_t lod = 0; lod <= lod_leaf_sizes_.size(); ++lod) {
+    if (lod > 0) {
+      VoxelGridFilter<PointT> vgf;
+      auto & next_cloud = lod_clouds[lod % 2];
+
+      next_cloud.clear();
+      vgf.setResolution(lod_leaf_sizes_[lod - 1]);
+      vgf.setEngine(voxel_filter_engine_);
+
+      auto timer = report_.time("voxel");
+
+      vgf.filter(*lod_cloud, next_cloud);
+      report_.addPoints("voxel", lod_cloud->size());
+      lod_cloud = &next_cloud;
+    }
+
+    // Segments are saved by the finalize threads, so the segments are sorted in parallel
+    if (morton_order_) {
+      auto timer = report_.time("morton");
+
+      sortByMortonCode(*lod_cloud);
+      report_.addPoints("morton", lod_cloud->size());
+    }
+
+    std::string save_path = makeSegmentPath(grid, lod);
+
+    // If save large pcd was turned on, create a folder to contain segment pcds. Each folder
+    // is created only once, since directory operations are slow on network filesystems.
+    if (use_large_grid_) {
+      std::string large_folder = fs::path(save_path).parent_path().string();
+      bool new_folder;
+
+      {
+        std::lock_guard<std::mutex> lock(grid_set_mtx_);
+        new_folder = created_dirs_.insert(large_folder).second;
+      }
+
+      if (new_folder) {
+        util::make_dir(large_folder);
+      }
+    }
+
+    saveTile(save_path, grid, *lod_cloud);
+
+    const size_t file_size = fs::file_size(save_path);
+
+    report_.addBytes("write", file_size);
+    report_.addPoints("write", lod_cloud->size());
+    publish(save_path);
+
+    if (lod == 0) {
+      TileRecord record{};
+
+      record.ix = grid.ix;
+      record.iy = grid.iy;
+      record.point_num = cloud.size();
+      record.z_min = std::numeric_limits<float>::max();
+      record.z_max = std::numeric_limits<float>::lowest();
+
+      for (const auto & p : cloud) {
+        record.z_min = std::min(record.z_min, p.z);
+        record.z_max = std::max(record.z_max, p.z);
+      }
+
+      record.byte_size = file_size;
+      record.checksum = fileChecksum(save_path);
+
+      if (height_map_cell_size_ > 0) {
+        record.flags |= saveHeightMap(grid, cloud);
+      }
+
+      std::lock_guard<std::mutex> lock(grid_set_mtx_);
+      tile_records_[grid] = record;
+    }
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveTile(
+  const std::string & path, const GridInfo<2> & grid, const PclCloudType & cloud)
+{
+  auto timer = report_.time("write");
+  int ret = 0;
+
+  if (tile_encoding_ == TileEncoding::QUANTIZED) {
+    // Offsets are relative to the center of the segment
+    std::array<double, 3> origin = {
+      grid.ix + grid_size_x_ * 0.5, grid.iy + grid_size_y_ * 0.5, 0};
+    auto min_max_z = std::minmax_element(
+      cloud.begin(), cloud.end(), [](const PointT & a, const PointT & b) { return a.z < b.z; });
+
+    if (min_max_z.first != cloud.end()) {
+      origin[2] = (static_cast<double>(min_max_z.first->z) + min_max_z.second->z) * 0.5;
+    }
+
+    if (saveQuantizedPCD(path, cloud, origin, quantization_step_)) {
+      return;
+    }
+
+    // The segment is too large for int16 offsets, keep the float coordinates
+    ret = pcl::io::savePCDFileBinary(path, cloud);
+  } else if (tile_encoding_ == TileEncoding::BINARY_COMPRESSED) {
+    ret = pcl::io::savePCDFileBinaryCompressed(path, cloud);
+  } else {
+    ret = pcl::io::savePCDFileBinary(path, cloud);
+  }
+
+  if (ret) {
+    RCLCPP_ERROR(logger_, "Error: Failed to save a point cloud at %s", path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+}
+
+template <class PointT>
+uint32_t PCDDivider<PointT>::saveHeightMap(const GridInfo<2> & grid, const PclCloudType & cloud)
+{
+  auto timer = report_.time("height_map");
+  std::string path = makeHeightMapPath(grid);
+  HeightMap height_map(grid.ix, grid.iy, grid_size_x_, grid_size_y_, height_map_cell_size_);
+
+  height_map.build(cloud);
+
+  bool geotiff = height_map_format_ == HeightMapFormat::GEOTIFF;
+
+  if (!(geotiff ? height_map.saveGeoTIFF(path) : height_map.save(path))) {
+    RCLCPP_ERROR(logger_, "Error: Failed to save a height map at %s", path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  report_.addBytes("height_map", fs::file_size(path));
+  report_.addPoints("height_map", cloud.size());
+  publish(path);
+
+  return geotiff ? TILE_HEIGHT_MAP_GEOTIFF : TILE_HEIGHT_MAP_BINARY;
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveNDTVoxels(const GridInfo<2> & grid, const NDTVoxelGrid & ndt_voxels)
+{
+  auto timer = report_.time("ndt");
+  std::string path = makeNDTVoxelsPath(grid);
+
+  if (!ndt_voxels.save(path)) {
+    RCLCPP_ERROR(logger_, "Error: Failed to save the NDT voxels at %s", path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  report_.addBytes("ndt", fs::file_size(path));
+  publish(path);
+
+  std::lock_guard<std::mutex> lock(grid_set_mtx_);
+  tile_records_[grid].flags |= TILE_NDT_VOXELS;
+}
+
+template <class PointT>
+GridInfo<2> PCDDivider<PointT>::toLargeGrid(const GridInfo<2> & grid) const
+{
+  int large_gx = static_cast<int>(std::floor(static_cast<float>(grid.ix) / g_grid_size_x_));
+  int large_gy = static_cast<int>(std::floor(static_cast<float>(grid.iy) / g_grid_size_y_));
+
+  return GridInfo<2>(large_gx, large_gy);
+}
+
+template <class PointT>
+GridInfo<2> PCDDivider<PointT>::adjacentGrid(const GridInfo<2> & grid, int dx, int dy) const
+{
+  PointT center;
+
+  center.x = grid.ix + (dx + 0.5) * grid_size_x_;
+  center.y = grid.iy + (dy + 0.5) * grid_size_y_;
+
+  return pointToGrid2(center, grid_size_x_, grid_size_y_);
+}
+
+template <class PointT>
+bool PCDDivider<PointT>::isOutputGrid(const GridInfo<2> & grid) const
+{
+  return (!incremental_ || rebuild_grids_.count(grid) > 0) &&
+         (!partitioned_ || partition_cells_.count(toLargeGrid(grid)) > 0);
+}
+
+template <class PointT>
+bool PCDDivider<PointT>::isBinnedGrid(const GridInfo<2> & grid) const
+{
+  if (isOutputGrid(grid)) {
+    return true;
+  }
+
+  if (outlier_mean_k_ == 0) {
+    return false;
+  }
+
+  for (int dx = -1; dx <= 1; ++dx) {
+    for (int dy = -1; dy <= 1; ++dy) {
+      if ((dx != 0 || dy != 0) && isOutputGrid(adjacentGrid(grid, dx, dy))) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+template <class PointT>
+std::string PCDDivider<PointT>::makeMapDir(size_t lod) const
+{
+  if (lod == 0) {
+    return output_dir_ + "/pointcloud_map.pcd/";
+  }
+
+  return output_dir_ + "/pointcloud_map_lod" + std::to_string(lod) + ".pcd/";
+}
+
+template <class PointT>
+std::string PCDDivider<PointT>::makeHeightMapPath(const GridInfo<2> & grid) const
+{
+  return fs::path(makeSegmentPath(grid)).replace_extension(heightMapExtension(height_map_format_));
+}
+
+template <class PointT>
+std::string PCDDivider<PointT>::makeNDTVoxelsPath(const GridInfo<2> & grid) const
+{
+  return fs::path(makeSegmentPath(grid)).replace_extension(".ndt");
+}
+
+template <class PointT>
+std::string PCDDivider<PointT>::makeHaloPath(const std::string & file_path)
+{
+  const fs::path path(file_path);
+
+  return (path.parent_path() / (path.stem().string() + ".halo" + path.extension().string()))
+    .string();
+}
+
+template <class PointT>
+std::string PCDDivider<PointT>::makeSegmentPath(const GridInfo<2> & grid, size_t lod) const
+{
+  std::ostringstream seg_name;
+
+  seg_name << grid;
+
+  std::string seg_name_only = seg_name.str();
+
+  // If save large pcd was turned on, segment pcds are contained in the folder of large grids
+  if (use_large_grid_) {
+    std::ostringstream large_folder_name;
+
+    large_folder_name << toLargeGrid(grid);
+
+    std::string large_folder = makeMapDir(lod) + large_folder_name.str() + "/";
+
+    return large_folder + file_prefix_ + "_" + seg_name_only + ".pcd";
+  }
+
+  return makeMapDir(lod) + file_prefix_ + "_" + seg_name_only + ".pcd";
+}
+
+template <class PointT>
+std::string PCDDivider<PointT>::makeFileName(const GridInfo<2> & grid) const
+{
+  return file_prefix_ + "_" + std::to_string(grid.ix) + "_" + std::to_string(grid.iy) + ".pcd";
+}
+
+template <class PointT>
+void PCDDivider<PointT>::paramInitialize()
+{
+  try {
+    YAML::Node conf = YAML::LoadFile(config_file_);
+    auto params = conf["/**"]["ros__parameters"];
+    use_large_grid_ = params["use_large_grid"].as<bool>();
+
+    if (params["large_grid_factor"]) {
+      large_grid_factor_ = std::max(params["large_grid_factor"].as<int>(), 1);
+    }
+
+    leaf_size_ = params["leaf_size"].as<double>();
+    grid_size_x_ = params["grid_size_x"].as<double>();
+    grid_size_y_ = params["grid_size_y"].as<double>();
+
+    if (
+      params["voxel_filter_engine"] &&
+      !toVoxelFilterEngine(params["voxel_filter_engine"].as<std::string>(), voxel_filter_engine_)) {
+      RCLCPP_ERROR(
+        logger_, "Error: Unknown voxel_filter_engine %s",
+        params["voxel_filter_engine"].as<std::string>().c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    if (params["max_voxel_num"]) {
+      max_voxel_num_ = std::max<int64_t>(params["max_voxel_num"].as<int64_t>(), 0);
+    }
+
+    if (params["memory_budget"]) {
+      setMemoryBudget(params["memory_budget"].as<size_t>());
+    }
+
+    if (
+      params["spill_policy"] &&
+      !toSpillPolicy(params["spill_policy"].as<std::string>(), spill_policy_)) {
+      RCLCPP_ERROR(
+        logger_, "Error: Unknown spill_policy %s", params["spill_policy"].as<std::string>().c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    if (params["outlier_mean_k"]) {
+      setOutlierRemoval(
+        params["outlier_mean_k"].as<int>(),
+        params["outlier_stddev_mul"] ? params["outlier_stddev_mul"].as<double>() : 1.0,
+        params["outlier_halo"] ? params["outlier_halo"].as<double>() : 1.0);
+    }
+
+    if (
+      params["spill_encoding"] &&
+      !toSpillEncoding(params["spill_encoding"].as<std::string>(), spill_encoding_)) {
+      RCLCPP_ERROR(
+        logger_, "Error: Unknown spill_encoding %s",
+        params["spill_encoding"].as<std::string>().c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    if (params["tile_encoding"]) {
+      TileEncoding encoding;
+
+      if (!toTileEncoding(params["tile_encoding"].as<std::string>(), encoding)) {
+        RCLCPP_ERROR(
+          logger_, "Error: Unknown tile_encoding %s",
+          params["tile_encoding"].as<std::string>().c_str());
+        rclcpp::shutdown();
+        exit(EXIT_FAILURE);
+      }
+
+      double step = params["quantization_step"] ? params["quantization_step"].as<double>() : 0;
+
+      setTileEncoding(encoding, step);
+    }
+
+    if (params["lod_leaf_sizes"]) {
+      setLODLeafSizes(params["lod_leaf_sizes"].as<std::vector<double>>());
+    }
+
+    if (params["height_map_cell_size"]) {
+      HeightMapFormat format = HeightMapFormat::BINARY;
+
+      if (
+        params["height_map_format"] &&
+        !toHeightMapFormat(params["height_map_format"].as<std::string>(), format)) {
+        RCLCPP_ERROR(
+          logger_, "Error: Unknown height_map_format %s",
+          params["height_map_format"].as<std::string>().c_str());
+        rclcpp::shutdown();
+        exit(EXIT_FAILURE);
+      }
+
+      setHeightMap(params["height_map_cell_size"].as<double>(), format);
+    }
+
+    if (params["ndt_resolution"]) {
+      setNDTVoxels(params["ndt_resolution"].as<double>());
+    }
+
+    if (params["morton_order"]) {
+      setMortonOrder(params["morton_order"].as<bool>());
+    }
+
+    if (params["async_io_queue_depth"]) {
+      AsyncIOOptions async_io;
+
+      async_io.queue_depth = params["async_io_queue_depth"].as<size_t>();
+
+      if (params["async_io_direct"]) {
+        async_io.direct = params["async_io_direct"].as<bool>();
+      }
+
+      setAsyncIO(async_io);
+    }
+
+    if (params["incremental_mode"]) {
+      setIncrementalMode(params["incremental_mode"].as<bool>());
+    }
+
+    if (params["in_memory_mode"]) {
+      setInMemoryMode(params["in_memory_mode"].as<bool>());
+    }
+
+    if (params["finalize_thread_num"]) {
+      setFinalizeThreadNum(params["finalize_thread_num"].as<size_t>());
+    }
+
+    if (params["spill_thread_num"]) {
+      setSpillThreadNum(params["spill_thread_num"].as<size_t>());
+    }
+
+    if (params["reader_thread_num"] && params["worker_thread_num"]) {
+      setThreadNum(
+        params["reader_thread_num"].as<size_t>(), params["worker_thread_num"].as<size_t>());
+    }
+  } catch (YAML::Exception & e) {
+    RCLCPP_ERROR(logger_, "YAML Error: %s", e.what());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  setGridSize(grid_size_x_, grid_size_y_);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveGridInfoToYAML(const std::string & yaml_file_path)
+{
+  std::ofstream yaml_file(yaml_file_path);
+
+  if (!yaml_file.is_open()) {
+    RCLCPP_ERROR(logger_, "Error: Cannot open YAML file: %s", yaml_file_path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  yaml_file << "x_resolution: " << grid_size_x_ << std::endl;
+  yaml_file << "y_resolution: " << grid_size_y_ << std::endl;
+
+  // The encoding and the levels of detail are written only when they are not the default ones,
+  // so the metadata of the default output stays readable by the existing loaders
+  if (tile_encoding_ != TileEncoding::BINARY) {
+    yaml_file << "encoding: " << tileEncodingName(tile_encoding_) << std::endl;
+  }
+
+  if (tile_encoding_ == TileEncoding::QUANTIZED) {
+    yaml_file << "quantization_step: " << quantization_step_ << std::endl;
+  }
+
+  if (!lod_leaf_sizes_.empty()) {
+    yaml_file << "lod_levels:" << std::endl;
+
+    for (size_t lod = 1; lod <= lod_leaf_sizes_.size(); ++lod) {
+      yaml_file << "  - {dir: pointcloud_map_lod" << lod
+                << ".pcd, leaf_size: " << lod_leaf_sizes_[lod - 1] << "}" << std::endl;
+    }
+  }
+
+  if (ndt_resolution_ > 0) {
+    yaml_file << "ndt_voxels: {resolution: " << ndt_resolution_
+              << ", min_point_num: " << NDTVoxelGrid(ndt_resolution_).minPointNum() << "}"
+              << std::endl;
+  }
+
+  if (morton_order_) {
+    yaml_file << "point_order: morton" << std::endl;
+  }
+
+  if (height_map_cell_size_ > 0) {
+    yaml_file << "height_map: {cell_size: " << height_map_cell_size_
+              << ", format: " << heightMapFormatName(height_map_format_) << "}" << std::endl;
+  }
+
+  for (const auto & grid : grid_set_) {
+    std::string file_name = makeFileName(grid);
+    fs::path p(file_name);
+    yaml_file << p.filename().string() << ": [" << grid.ix << ", " << grid.iy << "]" << std::endl;
+  }
+
+  yaml_file.close();
+  publish(yaml_file_path);
 
-      dividePointCloud(cloud_ptr);
-    } while (reader_.good() && rclcpp::ok());
+  if (use_large_grid_) {
+    saveLargeGridInfoToYAML();
   }
+}
 
-  saveTheRest();
+template <class PointT>
+void PCDDivider<PointT>::saveLargeGridInfoToYAML()
+{
+  // Every large grid folder gets its own catalogue in the same format as the global one,
+  // so readers of a folder do not have to parse the metadata of the whole map
+  std::unordered_map<GridInfo<2>, std::vector<GridInfo<2>>> large_grids;
 
-  RCLCPP_INFO(logger_, "Merge and downsampling... ");
+  for (const auto & grid : grid_set_) {
+    large_grids[toLargeGrid(grid)].push_back(grid);
+  }
 
-  // Now merge and downsample
-  mergeAndDownsample();
+  for (const auto & large_grid : large_grids) {
+    std::ostringstream yaml_file_path;
 
-  std::string yaml_file_path = output_dir_ + "/pointcloud_map_metadata.yaml";
-  saveGridInfoToYAML(yaml_file_path);
+    yaml_file_path << makeMapDir() << large_grid.first << "/pointcloud_map_metadata.yaml";
 
-  RCLCPP_INFO(logger_, "Done!");
-}
+    std::ofstream yaml_file(yaml_file_path.str());
 
-template <class PointT>
-void PCDDivider<PointT>::checkOutputDirectoryValidity()
-{
-  tmp_dir_ = output_dir_ + "/tmp/";
+    if (!yaml_file.is_open()) {
+      RCLCPP_ERROR(logger_, "Error: Cannot open YAML file: %s", yaml_file_path.str().c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
 
-  if (fs::exists(tmp_dir_)) {
-    fs::remove_all(tmp_dir_);
-  }
+    yaml_file << "x_resolution: " << grid_size_x_ << std::endl;
+    yaml_file << "y_resolution: " << grid_size_y_ << std::endl;
 
-  if (fs::exists(output_dir_)) {
-    fs::remove_all(output_dir_);
-  }
+    for (const auto & grid : large_grid.second) {
+      yaml_file << makeFileName(grid) << ": [" << grid.ix << ", " << grid.iy << "]" << std::endl;
+    }
 
-  util::make_dir(output_dir_ + "/pointcloud_map.pcd/");
-  util::make_dir(tmp_dir_);
+    yaml_file.close();
+    publish(yaml_file_path.str());
+  }
 }
 
 template <class PointT>
-typename pcl::PointCloud<PointT>::Ptr PCDDivider<PointT>::loadPCD(const std::string & pcd_name)
+bool PCDDivider<PointT>::prepareIncrementalRun(
+  const std::vector<std::string> & pcd_names, std::vector<std::string> & divide_names)
 {
-  if (pcd_name != reader_.get_path()) {
-    reader_.setInput(pcd_name);
+  std::string manifest_path = output_dir_ + "/pointcloud_map_manifest.yaml";
+
+  input_records_.clear();
+
+  if (!fs::exists(manifest_path)) {
+    return false;
   }
 
-  PclCloudPtr cloud_ptr(new PclCloudType);
+  try {
+    YAML::Node manifest = YAML::LoadFile(manifest_path);
 
-  reader_.readABlock(*cloud_ptr);
+    if (manifest["signature"].as<std::string>() != manifestSignature()) {
+      RCLCPP_INFO(logger_, "Parameters changed since the last run, divide the whole map");
+      return false;
+    }
 
-  return cloud_ptr;
-}
+    for (const auto & input : manifest["inputs"]) {
+      auto & record = input_records_[input["path"].as<std::string>()];
 
-template <class PointT>
-void PCDDivider<PointT>::savePCD(const std::string & path, const pcl::PointCloud<PointT> & cloud)
-{
-  if (pcl::io::savePCDFileBinary(path, cloud) == -1) {
-    RCLCPP_ERROR(logger_, "Error: Cannot save PCD: %s", path.c_str());
-    rclcpp::shutdown();
-    exit(EXIT_FAILURE);
+      record.file_size = input["size"].as<uintmax_t>();
+      record.mtime = input["mtime"].as<int64_t>();
+
+      for (const auto & grid : input["grids"]) {
+        record.grids.insert(GridInfo<2>(grid[0].as<int>(), grid[1].as<int>()));
+      }
+    }
+  } catch (YAML::Exception & e) {
+    RCLCPP_WARN(
+      logger_, "Cannot parse the manifest %s: %s, divide the whole map", manifest_path.c_str(),
+      e.what());
+    input_records_.clear();
+    return false;
   }
-}
 
-template <class PointT>
-void PCDDivider<PointT>::dividePointCloud(const PclCloudPtr & cloud_ptr)
-{
-  if (!cloud_ptr || cloud_ptr->size() <= 0) {
-    return;
+  rebuild_grids_.clear();
+
+  // The segments of removed inputs are rebuilt without their points
+  std::unordered_set<std::string> current_names(pcd_names.begin(), pcd_names.end());
+
+  for (auto it = input_records_.begin(); it != input_records_.end();) {
+    if (current_names.count(it->first) == 0) {
+      rebuild_grids_.insert(it->second.grids.begin(), it->second.grids.end());
+      it = input_records_.erase(it);
+    } else {
+      ++it;
+    }
   }
 
-  for (const PointT p : *cloud_ptr) {
-    if (!rclcpp::ok()) {
-      rclcpp::shutdown();
-      exit(EXIT_SUCCESS);
+  // The segments touched by new or modified inputs, before and after the modification
+  std::unordered_set<std::string> changed_names;
+
+  for (const auto & pcd_name : pcd_names) {
+    auto stat = statInput(pcd_name);
+    auto it = input_records_.find(pcd_name);
+
+    if (
+      it != input_records_.end() && it->second.file_size == stat.file_size &&
+      it->second.mtime == stat.mtime) {
+      continue;
     }
 
-    auto tmp = pointToGrid2(p, grid_size_x_, grid_size_y_);
-    auto it = grid_to_cloud_.find(tmp);
+    if (it != input_records_.end()) {
+      rebuild_grids_.insert(it->second.grids.begin(), it->second.grids.end());
+    }
 
-    // If the grid has not existed yet, create a new one
-    if (it == grid_to_cloud_.end()) {
-      auto & new_grid = grid_to_cloud_[tmp];
+    InputReader<PointT> reader;
+    PclCloudType block;
 
-      std::get<0>(new_grid).reserve(max_block_size_);
+    reader.setLAZCommand(laz_command_);
+    reader.setInput(pcd_name);
 
-      std::get<0>(new_grid).push_back(p);  // Push the first point to the cloud
-      std::get<1>(new_grid) = 0;           // Counter set to 0
-      std::get<2>(new_grid) = 0;           // Prev size is 0
-    } else {
-      auto & cloud = std::get<0>(it->second);
-      auto & prev_size = std::get<2>(it->second);
+    do {
+      reader.readABlock(block);
+      collectGrids(block, stat.grids);
+    } while (reader.good());
 
-      cloud.push_back(p);
+    rebuild_grids_.insert(stat.grids.begin(), stat.grids.end());
+    input_records_[pcd_name] = std::move(stat);
+    changed_names.insert(pcd_name);
+  }
 
-      ++resident_point_num_;
+  // With the outlier removal, the points at the border of a segment are filtered against the
+  // adjacent segments, so those are rebuilt too, and the segments next to the rebuilt ones are
+  // binned again for their halos
+  std::unordered_set<GridInfo<2>> binned_grids;
 
-      // If the number of points in the segment reach maximum, save the segment to file
-      if (cloud.size() == max_block_size_) {
-        saveGridPCD(it);
-      } else {
-        // Otherwise, update the seg_by_size_ if the change of size is significant
-        if (cloud.size() - prev_size >= 10000) {
-          prev_size = cloud.size();
-          auto seg_to_size_it = seg_to_size_itr_map_.find(tmp);
+  if (outlier_mean_k_ > 0) {
+    const std::vector<GridInfo<2>> changed_grids(rebuild_grids_.begin(), rebuild_grids_.end());
 
-          if (seg_to_size_it == seg_to_size_itr_map_.end()) {
-            auto size_it = seg_by_size_.insert(std::make_pair(prev_size, it));
-            seg_to_size_itr_map_[tmp] = size_it;
-          } else {
-            seg_by_size_.erase(seg_to_size_it->second);
-            auto new_size_it = seg_by_size_.insert(std::make_pair(prev_size, it));
-            seg_to_size_it->second = new_size_it;
-          }
+    for (const auto & grid : changed_grids) {
+      for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
+          rebuild_grids_.insert(adjacentGrid(grid, dx, dy));
+        }
+      }
+    }
+
+    for (const auto & grid : rebuild_grids_) {
+      for (int dx = -1; dx <= 1; ++dx) {
+        for (int dy = -1; dy <= 1; ++dy) {
+          binned_grids.insert(adjacentGrid(grid, dx, dy));
         }
       }
+    }
+  } else {
+    binned_grids = rebuild_grids_;
+  }
+
+  // Divide the changed inputs, and the unchanged ones having points in the binned segments.
+  // The input order is kept, so the rebuilt segments are the same as those of a full run.
+  divide_names.clear();
+
+  for (const auto & pcd_name : pcd_names) {
+    bool touched = (changed_names.count(pcd_name) > 0);
+
+    for (auto it = input_records_[pcd_name].grids.begin();
+         !touched && it != input_records_[pcd_name].grids.end(); ++it) {
+      touched = (binned_grids.count(*it) > 0);
+    }
 
-      // If the number of resident points reach maximum, save the biggest resident segment to SSD
-      if (resident_point_num_ >= max_resident_point_num_) {
-        auto max_size_seg_it = seg_by_size_.rbegin();
+    if (touched) {
+      divide_names.push_back(pcd_name);
+    }
+  }
+
+  RCLCPP_INFO(
+    logger_, "Incremental run: %lu changed inputs, %lu inputs to divide, %lu segments to rebuild",
+    changed_names.size(), divide_names.size(), rebuild_grids_.size());
+
+  // Remove the old segments to be rebuilt, since some of them may not receive points anymore
+  // Keep the statistics of the segments that are not rebuilt
+  TileIndex old_index;
 
-        saveGridPCD(max_size_seg_it->second);
+  if (old_index.load(output_dir_ + "/pointcloud_map_index.bin")) {
+    for (const auto & tile : old_index.tiles()) {
+      GridInfo<2> grid(tile.ix, tile.iy);
+
+      if (rebuild_grids_.count(grid) == 0) {
+        tile_records_[grid] = tile;
       }
     }
   }
+
+  for (const auto & grid : rebuild_grids_) {
+    for (size_t lod = 0; lod <= lod_leaf_sizes_.size(); ++lod) {
+      fs::remove(makeSegmentPath(grid, lod));
+    }
+
+    if (height_map_cell_size_ > 0) {
+      fs::remove(makeHeightMapPath(grid));
+    }
+
+    if (ndt_resolution_ > 0) {
+      fs::remove(makeNDTVoxelsPath(grid));
+    }
+  }
+
+  return true;
 }
 
 template <class PointT>
-void PCDDivider<PointT>::saveGridPCD(GridMapItr & grid_it)
+void PCDDivider<PointT>::saveManifest(const std::string & manifest_path)
 {
-  auto & cloud = std::get<0>(grid_it->second);
-  auto & counter = std::get<1>(grid_it->second);
-  auto & prev_size = std::get<2>(grid_it->second);
+  YAML::Emitter out;
 
-  // Try to create a new directory to contain the cloud
-  std::ostringstream seg_path, file_path;
+  out << YAML::BeginMap;
+  out << YAML::Key << "signature" << YAML::Value << manifestSignature();
+  out << YAML::Key << "inputs" << YAML::Value << YAML::BeginSeq;
 
-  seg_path << tmp_dir_ << "/" << grid_it->first << "/";
-  file_path << seg_path.str() << counter << "_" << cloud.size() << ".pcd";
+  for (const auto & input : input_records_) {
+    out << YAML::BeginMap;
+    out << YAML::Key << "path" << YAML::Value << input.first;
+    out << YAML::Key << "size" << YAML::Value << input.second.file_size;
+    out << YAML::Key << "mtime" << YAML::Value << input.second.mtime;
+    out << YAML::Key << "grids" << YAML::Value << YAML::Flow << YAML::BeginSeq;
+
+    for (const auto & grid : input.second.grids) {
+      out << YAML::Flow << YAML::BeginSeq << grid.ix << grid.iy << YAML::EndSeq;
+    }
+
+    out << YAML::EndSeq << YAML::EndMap;
+  }
+
+  out << YAML::EndSeq << YAML::EndMap;
 
-  util::make_dir(seg_path.str());
+  std::ofstream manifest_file(manifest_path);
 
-  if (pcl::io::savePCDFileBinary(file_path.str(), cloud)) {
-    RCLCPP_ERROR(logger_, "Error: Cannot save a PCD file at %s", file_path.str().c_str());
+  if (!manifest_file.is_open()) {
+    RCLCPP_ERROR(logger_, "Error: Cannot open manifest file: %s", manifest_path.c_str());
     rclcpp::shutdown();
     exit(EXIT_FAILURE);
   }
 
-  resident_point_num_ -= cloud.size();
+  manifest_file << out.c_str() << std::endl;
+}
 
-  // Clear the content of the segment cloud and reserve space for further points
-  cloud.clear();
-  cloud.reserve(max_block_size_);
-  ++counter;  // Increase the counter so the next segment save will not overwrite the previously
-              // saved one
-  prev_size = 0;
+template <class PointT>
+std::string PCDDivider<PointT>::manifestSignature(bool with_worker) const
+{
+  using Traits = PointFieldTraits<PointT>;
 
-  // Update the seg_by_size_ and seg_to_size_itr_map_
-  auto it = seg_to_size_itr_map_.find(grid_it->first);
+  std::ostringstream signature;
+
+  signature << grid_size_x_ << " " << grid_size_y_ << " " << leaf_size_ << " " << use_large_grid_
+            << " " << large_grid_factor_ << " " << file_prefix_ << " " << tileEncodingName(tile_encoding_) << " "
+            << quantization_step_;
+
+  // Appended only when enabled, so the manifests written before the option stay valid
+  if (pre_voxelize_) {
+    signature << " pre_voxelize";
+  }
+
+  for (auto lod_leaf_size : lod_leaf_sizes_) {
+    signature << " " << lod_leaf_size;
+  }
+
+  if (height_map_cell_size_ > 0) {
+    signature << " height_map " << height_map_cell_size_ << " "
+              << heightMapFormatName(height_map_format_);
+  }
 
-  if (it != seg_to_size_itr_map_.end()) {
-    seg_by_size_.erase(it->second);
-    seg_to_size_itr_map_.erase(it);
+  if (ndt_resolution_ > 0) {
+    signature << " ndt_voxels " << ndt_resolution_;
   }
+
+  if (morton_order_) {
+    signature << " morton_order";
+  }
+
+  if (max_voxel_num_ > 0) {
+    signature << " max_voxel_num " << max_voxel_num_;
+  }
+
+  if (outlier_mean_k_ > 0) {
+    signature << " outliers " << outlier_mean_k_ << " " << outlier_stddev_mul_ << " "
+              << outlier_halo_;
+  }
+
+  for (const auto & stage : stages_) {
+    signature << " " << stage->signature();
+  }
+
+  if (partitioned_ && with_worker) {
+    signature << " partition " << partition_plan_path_ << " " << partition_worker_id_;
+  }
+
+  for (size_t fid = 0; fid < Traits::size; ++fid) {
+    signature << " " << Traits::names[fid];
+  }
+
+  return signature.str();
 }
 
 template <class PointT>
-void PCDDivider<PointT>::saveTheRest()
+typename PCDDivider<PointT>::InputRecord PCDDivider<PointT>::statInput(
+  const std::string & pcd_name) const
 {
-  for (auto it = grid_to_cloud_.begin(); it != grid_to_cloud_.end(); ++it) {
-    auto & cloud = std::get<0>(it->second);
+  InputRecord record;
 
-    if (cloud.size() > 0) {
-      saveGridPCD(it);
-    }
-  }
+  record.file_size = fs::file_size(pcd_name);
+  record.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   fs::last_write_time(pcd_name).time_since_epoch())
+                   .count();
+
+  return record;
 }
 
 template <class PointT>
-void PCDDivider<PointT>::mergeAndDownsample()
+bool PCDDivider<PointT>::checkpointDue() const
+{
+  return checkpoint_period_ > 0 && !in_memory_ &&
+         std::chrono::steady_clock::now() - last_checkpoint_ >=
+           std::chrono::duration<double>(checkpoint_period_);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveCheckpoint(
+  const std::vector<std::string> & pcd_names, size_t consumed, size_t position)
 {
-  // Scan the tmp directory and find the segment folders
-  fs::path tmp_path(tmp_dir_);
+  const std::string checkpoint_path = tmp_dir_ + "checkpoint.yaml";
+  YAML::Emitter out;
+
+  out << YAML::BeginMap;
+  out << YAML::Key << "signature" << YAML::Value << checkpointSignature();
+  out << YAML::Key << "inputs" << YAML::Value << YAML::BeginSeq;
 
-  // Count the number of sub folders, to estimate progress
-  int seg_num = 0;
+  for (size_t fid = 0; fid < pcd_names.size(); ++fid) {
+    auto stat = statInput(pcd_names[fid]);
 
-  for (auto & entry : fs::directory_iterator(tmp_path)) {
-    if (fs::is_directory(entry.symlink_status())) {
-      ++seg_num;
+    out << YAML::BeginMap;
+    out << YAML::Key << "path" << YAML::Value << pcd_names[fid];
+    out << YAML::Key << "size" << YAML::Value << stat.file_size;
+    out << YAML::Key << "mtime" << YAML::Value << stat.mtime;
+
+    // The grids of the inputs divided so far, including the part of the next one
+    auto it = input_records_.find(pcd_names[fid]);
+
+    if (record_grids_ && fid <= consumed && it != input_records_.end()) {
+      out << YAML::Key << "grids" << YAML::Value << YAML::Flow << YAML::BeginSeq;
+
+      for (const auto & grid : it->second.grids) {
+        out << YAML::Flow << YAML::BeginSeq << grid.ix << grid.iy << YAML::EndSeq;
+      }
+
+      out << YAML::EndSeq;
     }
+
+    out << YAML::EndMap;
   }
 
-  for (auto & tmp_dir_entry : fs::directory_iterator(tmp_path)) {
-    if (fs::is_directory(tmp_dir_entry.symlink_status())) {
-      if (debug_mode_) {
-        RCLCPP_INFO(logger_, "Saving segment %s", tmp_dir_entry.path().string().c_str());
+  out << YAML::EndSeq;
+  out << YAML::Key << "consumed_inputs" << YAML::Value << consumed;
+  out << YAML::Key << "position" << YAML::Value << position;
+  out << YAML::Key << "spilled_bytes" << YAML::Value << spilled_bytes_.load();
+  out << YAML::Key << "spilled_files" << YAML::Value << spilled_file_num_.load();
+  out << YAML::Key << "segments" << YAML::Value << YAML::BeginSeq;
+
+  {
+    std::lock_guard<std::mutex> lock(manifest_mtx_);
+
+    for (const auto & segment : manifest_) {
+      out << YAML::BeginMap;
+      out << YAML::Key << "grid" << YAML::Value << YAML::Flow << YAML::BeginSeq
+          << segment.first.ix << segment.first.iy << YAML::EndSeq;
+      out << YAML::Key << "points" << YAML::Value << segment.second.point_num;
+
+      if (outlier_mean_k_ > 0) {
+        out << YAML::Key << "halo_points" << YAML::Value << segment.second.halo_point_num;
       }
-      std::list<std::string> pcd_list;
-      size_t total_point_num = 0;
 
-      for (auto & seg_entry : fs::directory_iterator(tmp_dir_entry.path())) {
-        if (fs::is_regular_file(seg_entry.symlink_status())) {
-          auto fname = seg_entry.path().string();
-          auto ext = fname.substr(fname.size() - 4);
+      out << YAML::Key << "files" << YAML::Value << YAML::Flow << YAML::BeginSeq;
 
-          if (ext == ".pcd") {
-            pcd_list.push_back(fname);
-            total_point_num += util::point_num(fname);
-          }
-        }
+      for (const auto & pcd_path : segment.second.pcd_list) {
+        out << fs::path(pcd_path).filename().string();
       }
 
-      // Fuse all PCDs and downsample if necessary
-      mergeAndDownsample(tmp_dir_entry.path().string(), pcd_list, total_point_num);
+      out << YAML::EndSeq << YAML::EndMap;
     }
   }
 
-  // Remove tmp dir
-  util::remove(tmp_dir_);
+  out << YAML::EndSeq << YAML::EndMap;
+
+  // Replace the previous checkpoint at once, so an interruption while writing leaves it intact
+  {
+    std::ofstream checkpoint_file(checkpoint_path + ".tmp");
+
+    if (!checkpoint_file.is_open() || !(checkpoint_file << out.c_str() << std::endl)) {
+      RCLCPP_ERROR(logger_, "Error: Cannot save the checkpoint: %s", checkpoint_path.c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  fs::rename(checkpoint_path + ".tmp", checkpoint_path);
+  last_checkpoint_ = std::chrono::steady_clock::now();
+
+  if (debug_mode_) {
+    RCLCPP_INFO(
+      logger_, "Saved a checkpoint after %lu of %lu inputs", consumed, pcd_names.size());
+  }
 }
 
 template <class PointT>
-void PCDDivider<PointT>::mergeAndDownsample(
-  const std::string & dir_path, std::list<std::string> & pcd_list, size_t total_point_num)
+bool PCDDivider<PointT>::loadCheckpoint(const std::vector<std::string> & pcd_names)
 {
-  PclCloudPtr new_cloud(new PclCloudType);
+  const std::string checkpoint_path = tmp_dir_ + "checkpoint.yaml";
 
-  new_cloud->reserve(total_point_num);
+  if (!fs::exists(checkpoint_path)) {
+    return false;
+  }
 
-  // Merge all PCDs that belong to the specified segment to a single segment point cloud
-  for (auto & fname : pcd_list) {
-    PclCloudType seg_cloud;
+  std::unordered_map<GridInfo<2>, SegmentRecord> manifest;
+  std::unordered_map<std::string, std::unordered_set<GridInfo<2>>> input_grids;
+  size_t consumed = 0, position = 0, spilled_bytes = 0, spilled_file_num = 0;
 
-    if (pcl::io::loadPCDFile(fname, seg_cloud)) {
-      RCLCPP_ERROR(logger_, "Error: Failed to open a PCD file at %s", fname.c_str());
-      rclcpp::shutdown();
-      exit(EXIT_FAILURE);
+  try {
+    YAML::Node checkpoint = YAML::LoadFile(checkpoint_path);
+
+    if (checkpoint["signature"].as<std::string>() != checkpointSignature()) {
+      RCLCPP_INFO(logger_, "Parameters changed since the checkpoint, divide from the beginning");
+      return false;
     }
 
-    for (auto & p : seg_cloud) {
-      new_cloud->push_back(p);
+    const auto & inputs = checkpoint["inputs"];
+    bool same_inputs = (inputs.size() == pcd_names.size());
+
+    for (size_t fid = 0; same_inputs && fid < pcd_names.size(); ++fid) {
+      auto stat = statInput(pcd_names[fid]);
+
+      same_inputs = inputs[fid]["path"].as<std::string>() == pcd_names[fid] &&
+                    inputs[fid]["size"].as<uintmax_t>() == stat.file_size &&
+                    inputs[fid]["mtime"].as<int64_t>() == stat.mtime;
+
+      for (const auto & grid : inputs[fid]["grids"]) {
+        input_grids[pcd_names[fid]].insert(GridInfo<2>(grid[0].as<int>(), grid[1].as<int>()));
+      }
     }
-  }
 
-  // Downsample if needed
-  if (leaf_size_ > 0) {
-    VoxelGridFilter<PointT> vgf;
-    PclCloudPtr filtered_cloud(new PclCloudType);
+    if (!same_inputs) {
+      RCLCPP_INFO(logger_, "Inputs changed since the checkpoint, divide from the beginning");
+      return false;
+    }
 
-    vgf.setResolution(leaf_size_);
-    vgf.filter(*new_cloud, *filtered_cloud);
+    consumed = checkpoint["consumed_inputs"].as<size_t>();
+    position = checkpoint["position"].as<size_t>();
+    spilled_bytes = checkpoint["spilled_bytes"].as<size_t>();
+    spilled_file_num = checkpoint["spilled_files"].as<size_t>();
 
-    new_cloud = filtered_cloud;
-  }
+    for (const auto & segment : checkpoint["segments"]) {
+      GridInfo<2> grid(segment["grid"][0].as<int>(), segment["grid"][1].as<int>());
+      std::ostringstream seg_path;
+      auto & record = manifest[grid];
 
-  // Save the new_cloud
-  // Extract segment name only (format gx_gy)
-  int end_name, start_name;
+      seg_path << tmp_dir_ << "/" << grid << "/";
+      record.point_num = segment["points"].as<size_t>();
 
-  for (end_name = dir_path.size() - 1; end_name >= 0 && dir_path[end_name] == '/'; --end_name) {
-  }
-  for (start_name = end_name; start_name >= 0 && dir_path[start_name] != '/'; --start_name) {
+      if (segment["halo_points"]) {
+        record.halo_point_num = segment["halo_points"].as<size_t>();
+      }
+
+      for (const auto & file : segment["files"]) {
+        record.pcd_list.push_back(seg_path.str() + file.as<std::string>());
+
+        if (!fs::exists(record.pcd_list.back())) {
+          RCLCPP_WARN(
+            logger_, "%s of the checkpoint is missing, divide from the beginning",
+            record.pcd_list.back().c_str());
+          return false;
+        }
+      }
+    }
+  } catch (YAML::Exception & e) {
+    RCLCPP_WARN(
+      logger_, "Cannot parse the checkpoint %s: %s, divide from the beginning",
+      checkpoint_path.c_str(), e.what());
+    return false;
   }
 
-  std::string seg_name_only = dir_path.substr(start_name + 1, end_name - start_name);
+  if (consumed > pcd_names.size()) {
+    return false;
+  }
 
-  // Parse the @seg_path to get the indices of the segment
-  auto underbar_pos = seg_name_only.rfind("_");
-  int gx = std::stoi(seg_name_only.substr(0, underbar_pos));
-  int gy = std::stoi(seg_name_only.substr(underbar_pos + 1));
+  // Remove the tmp PCDs spilled after the checkpoint
+  std::unordered_set<std::string> kept_files = {
+    fs::path(checkpoint_path).lexically_normal().string()};
+  std::vector<fs::path> orphans;
 
-  grid_set_.insert(GridInfo<2>(gx, gy));
+  for (const auto & segment : manifest) {
+    resumed_counters_[segment.first] = segment.second.pcd_list.size();
 
-  // Construct the path to save the new_cloud
-  std::string save_path;
+    for (const auto & pcd_path : segment.second.pcd_list) {
+      kept_files.insert(fs::path(pcd_path).lexically_normal().string());
+      kept_files.insert(fs::path(makeHaloPath(pcd_path)).lexically_normal().string());
+    }
+  }
 
-  // If save large pcd was turned on, create a folder to contain segment pcds
-  if (use_large_grid_) {
-    int large_gx = static_cast<int>(std::floor(static_cast<float>(gx) / g_grid_size_x_));
-    int large_gy = static_cast<int>(std::floor(static_cast<float>(gy) / g_grid_size_y_));
-    std::string large_folder = output_dir_ + "/pointcloud_map.pcd/" + std::to_string(large_gx) +
-                               "_" + std::to_string(large_gy) + "/";
+  for (const auto & entry : fs::recursive_directory_iterator(tmp_dir_)) {
+    const std::string file_path = entry.path().lexically_normal().string();
 
-    // Create a new folder for the large grid
-    util::make_dir(large_folder);
+    if (entry.is_regular_file() && kept_files.count(file_path) == 0) {
+      orphans.push_back(entry.path());
+    }
+  }
 
-    save_path = large_folder + file_prefix_ + "_" + seg_name_only + ".pcd";
-  } else {
-    save_path = output_dir_ + "/pointcloud_map.pcd/" + file_prefix_ + "_" + seg_name_only + ".pcd";
+  for (const auto & orphan : orphans) {
+    fs::remove(orphan);
   }
 
-  // Save the merged (filtered) cloud
-  if (pcl::io::savePCDFileBinary(save_path, *new_cloud)) {
-    RCLCPP_ERROR(logger_, "Error: Failed to save a point cloud at %s", save_path.c_str());
-    rclcpp::shutdown();
-    exit(EXIT_FAILURE);
+  for (auto & input : input_grids) {
+    input_records_[input.first].grids.insert(input.second.begin(), input.second.end());
   }
 
-  // Delete the folder containing the segments
-  util::remove(dir_path);
+  manifest_.swap(manifest);
+  resume_input_ = consumed;
+  resume_position_ = position;
+  spilled_bytes_ = spilled_bytes;
+  spilled_file_num_ = spilled_file_num;
+
+  RCLCPP_INFO(
+    logger_, "Resume from the checkpoint: %lu of %lu inputs divided, %lu segments in %s",
+    consumed, pcd_names.size(), manifest_.size(), tmp_dir_.c_str());
+
+  return true;
 }
 
 template <class PointT>
-std::string PCDDivider<PointT>::makeFileName(const GridInfo<2> & grid) const
+std::string PCDDivider<PointT>::checkpointSignature() const
 {
-  return file_prefix_ + "_" + std::to_string(grid.ix) + "_" + std::to_string(grid.iy) + ".pcd";
+  // The inputs and the segments divided by an incremental run depend on the previous run
+  std::ostringstream signature;
+
+  signature << manifestSignature() << " " << incremental_ << " " << record_grids_;
+
+  return signature.str();
 }
 
 template <class PointT>
-void PCDDivider<PointT>::paramInitialize()
+void PCDDivider<PointT>::collectGrids(
+  const PclCloudType & cloud, std::unordered_set<GridInfo<2>> & grids) const
 {
-  try {
-    YAML::Node conf = YAML::LoadFile(config_file_);
-    auto params = conf["/**"]["ros__parameters"];
-    use_large_grid_ = params["use_large_grid"].as<bool>();
-    leaf_size_ = params["leaf_size"].as<double>();
-    grid_size_x_ = params["grid_size_x"].as<double>();
-    grid_size_y_ = params["grid_size_y"].as<double>();
-  } catch (YAML::Exception & e) {
-    RCLCPP_ERROR(logger_, "YAML Error: %s", e.what());
+  for (const auto & p : cloud) {
+    grids.insert(pointToGrid2(p, grid_size_x_, grid_size_y_));
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveTileIndex(const std::string & index_path)
+{
+  std::vector<TileRecord> tiles;
+
+  tiles.reserve(grid_set_.size());
+
+  for (const auto & grid : grid_set_) {
+    auto it = tile_records_.find(grid);
+
+    if (it != tile_records_.end()) {
+      tiles.push_back(it->second);
+    }
+  }
+
+  TileIndex index(grid_size_x_, grid_size_y_, file_prefix_, std::move(tiles));
+
+  if (!index.save(index_path)) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save the tile index: %s", index_path.c_str());
     rclcpp::shutdown();
     exit(EXIT_FAILURE);
   }
 
-  g_grid_size_x_ = grid_size_x_ * 10;
-  g_grid_size_y_ = grid_size_y_ * 10;
+  publish(index_path);
 }
 
 template <class PointT>
-void PCDDivider<PointT>::saveGridInfoToYAML(const std::string & yaml_file_path)
+void PCDDivider<PointT>::savePartitionInfo(const std::string & info_path)
 {
-  std::ofstream yaml_file(yaml_file_path);
+  YAML::Emitter out;
 
-  if (!yaml_file.is_open()) {
-    RCLCPP_ERROR(logger_, "Error: Cannot open YAML file: %s", yaml_file_path.c_str());
+  // The file stays in the output directory of the worker, and is not part of the map
+  out << YAML::BeginMap;
+  out << YAML::Key << "worker" << YAML::Value << partition_worker_id_;
+  out << YAML::Key << "signature" << YAML::Value << manifestSignature(false);
+  out << YAML::EndMap;
+
+  std::ofstream file(info_path);
+
+  file << out.c_str() << std::endl;
+
+  if (!file) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save the partition info: %s", info_path.c_str());
     rclcpp::shutdown();
     exit(EXIT_FAILURE);
   }
+}
 
-  yaml_file << "x_resolution: " << grid_size_x_ << std::endl;
-  yaml_file << "y_resolution: " << grid_size_y_ << std::endl;
+template <class PointT>
+void PCDDivider<PointT>::publish(const std::string & path)
+{
+  if (publishing_) {
+    auto key = fs::path(path).lexically_relative(output_dir_).lexically_normal();
 
-  for (const auto & grid : grid_set_) {
-    std::string file_name = makeFileName(grid);
-    fs::path p(file_name);
-    yaml_file << p.filename().string() << ": [" << grid.ix << ", " << grid.iy << "]" << std::endl;
+    sink_->publish(path, key.string());
   }
-
-  yaml_file.close();
 }
 
 template class PCDDivider<pcl::PointXYZ>;
 template class PCDDivider<pcl::PointXYZI>;
+template class PCDDivider<pcl::PointXYZRGB>;
+template class PCDDivider<pcl::PointXYZINormal>;
 
 }  // namespace autoware::pointcloud_divider
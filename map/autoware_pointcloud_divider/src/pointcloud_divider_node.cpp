@@ -18,23 +18,214 @@
 
 #include <pcl/point_types.h>
 
+#include <algorithm>
+#include <filesystem>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace autoware::pointcloud_divider
 {
 
+template <typename PointT>
+void PointCloudDivider::runDivider()
+{
+  autoware::pointcloud_divider::PCDDivider<PointT> pcd_divider_exe(get_logger());
+
+  pcd_divider_exe.setLargeGridMode(use_large_grid_);
+  pcd_divider_exe.setLargeGridFactor(std::max(large_grid_factor_, 1));
+  pcd_divider_exe.setLeafSize(leaf_size_);
+  pcd_divider_exe.setGridSize(grid_size_x_, grid_size_y_);
+  pcd_divider_exe.setInput(input_pcd_or_dir_);
+  pcd_divider_exe.setOutputDir(output_pcd_dir_);
+  pcd_divider_exe.setPrefix(file_prefix_);
+  pcd_divider_exe.setThreadNum(reader_thread_num_, worker_thread_num_);
+  pcd_divider_exe.setSpillThreadNum(std::max(spill_thread_num_, 0));
+  pcd_divider_exe.setFinalizeThreadNum(std::max(finalize_thread_num_, 1));
+  pcd_divider_exe.setInMemoryMode(in_memory_mode_);
+  pcd_divider_exe.setIncrementalMode(incremental_mode_);
+  pcd_divider_exe.setTileEncoding(tile_encoding_, quantization_step_);
+  pcd_divider_exe.setLODLeafSizes(lod_leaf_sizes_);
+  pcd_divider_exe.setHeightMap(height_map_cell_size_, height_map_format_);
+  pcd_divider_exe.setNDTVoxels(ndt_resolution_);
+  pcd_divider_exe.setMortonOrder(morton_order_);
+  pcd_divider_exe.setVoxelFilterEngine(voxel_filter_engine_);
+  pcd_divider_exe.setPreVoxelization(pre_voxelize_);
+  pcd_divider_exe.setOutlierRemoval(outlier_mean_k_, outlier_stddev_mul_, outlier_halo_);
+  pcd_divider_exe.setMaxVoxelNum(std::max<int64_t>(max_voxel_num_, 0));
+  pcd_divider_exe.setMemoryBudget(std::max<int64_t>(memory_budget_, 0));
+  pcd_divider_exe.setSpillPolicy(spill_policy_);
+  pcd_divider_exe.setSpillEncoding(spill_encoding_);
+  pcd_divider_exe.setReport(report_path_, progress_period_);
+  pcd_divider_exe.setCheckpointPeriod(checkpoint_period_);
+  pcd_divider_exe.setLAZCommand(laz_command_);
+
+  if (async_io_queue_depth_ > 0) {
+    AsyncIOOptions async_io;
+
+    async_io.queue_depth = async_io_queue_depth_;
+    async_io.direct = async_io_direct_;
+    pcd_divider_exe.setAsyncIO(async_io);
+  }
+
+  if (!output_sink_command_.empty()) {
+    pcd_divider_exe.setOutputSink(
+      std::make_shared<CommandOutputSink>(output_sink_command_, std::max(upload_thread_num_, 1)));
+  }
+
+  if (partition_role_ == "plan") {
+    pcd_divider_exe.planPartitions(std::max(partition_worker_num_, 1), partition_plan_);
+    return;
+  }
+
+  if (partition_role_ == "worker") {
+    pcd_divider_exe.setPartition(partition_plan_, std::max(partition_worker_id_, 0));
+  }
+
+  pcd_divider_exe.run();
+}
+
+void PointCloudDivider::runRawDivider()
+{
+  autoware::pointcloud_divider::RawPCDDivider raw_divider_exe(get_logger());
+
+  // The records are copied as they are, so the downsampling and the encodings do not apply
+  if (leaf_size_ > 0) {
+    RCLCPP_WARN(get_logger(), "leaf_size is ignored, since the raw segments are not downsampled");
+  }
+
+  raw_divider_exe.setLargeGridMode(use_large_grid_);
+  raw_divider_exe.setLargeGridFactor(std::max(large_grid_factor_, 1));
+  raw_divider_exe.setGridSize(grid_size_x_, grid_size_y_);
+  raw_divider_exe.setInput(input_pcd_or_dir_);
+  raw_divider_exe.setOutputDir(output_pcd_dir_);
+  raw_divider_exe.setPrefix(file_prefix_);
+  raw_divider_exe.setMemoryBudget(std::max<int64_t>(memory_budget_, 0));
+
+  raw_divider_exe.run();
+}
+
+void PointCloudDivider::runPartitionMerge()
+{
+  std::vector<std::string> worker_dirs;
+
+  for (const auto & entry : std::filesystem::directory_iterator(input_pcd_or_dir_)) {
+    if (
+      entry.is_directory() &&
+      std::filesystem::exists(entry.path() / "pointcloud_map_metadata.yaml")) {
+      worker_dirs.push_back(entry.path().string());
+    }
+  }
+
+  std::sort(worker_dirs.begin(), worker_dirs.end());
+
+  std::shared_ptr<OutputSink> sink = std::make_shared<LocalOutputSink>();
+
+  if (!output_sink_command_.empty()) {
+    sink =
+      std::make_shared<CommandOutputSink>(output_sink_command_, std::max(upload_thread_num_, 1));
+  }
+
+  std::string error;
+
+  if (worker_dirs.empty() || !mergePartitions(worker_dirs, output_pcd_dir_, *sink, error)) {
+    RCLCPP_ERROR(
+      get_logger(), "Error: Cannot merge the outputs in %s: %s", input_pcd_or_dir_.c_str(),
+      worker_dirs.empty() ? "no output found" : error.c_str());
+    return;
+  }
+
+  RCLCPP_INFO(get_logger(), "Merged the outputs of %lu workers", worker_dirs.size());
+}
+
 PointCloudDivider::PointCloudDivider(const rclcpp::NodeOptions & node_options)
 : Node("pointcloud_divider", node_options)
 {
   // Load command parameters
-  bool use_large_grid = declare_parameter<bool>("use_large_grid", false);
-  float leaf_size = declare_parameter<float>("leaf_size");
-  float grid_size_x = declare_parameter<float>("grid_size_x");
-  float grid_size_y = declare_parameter<float>("grid_size_y");
-  std::string input_pcd_or_dir = declare_parameter<std::string>("input_pcd_or_dir");
-  std::string output_pcd_dir = declare_parameter<std::string>("output_pcd_dir");
-  std::string file_prefix = declare_parameter<std::string>("prefix");
+  use_large_grid_ = declare_parameter<bool>("use_large_grid", false);
+  large_grid_factor_ = declare_parameter<int>("large_grid_factor", 10);
+  leaf_size_ = declare_parameter<float>("leaf_size");
+  grid_size_x_ = declare_parameter<float>("grid_size_x");
+  grid_size_y_ = declare_parameter<float>("grid_size_y");
+  input_pcd_or_dir_ = declare_parameter<std::string>("input_pcd_or_dir");
+  output_pcd_dir_ = declare_parameter<std::string>("output_pcd_dir");
+  file_prefix_ = declare_parameter<std::string>("prefix");
   std::string point_type = declare_parameter<std::string>("point_type");
+  reader_thread_num_ = declare_parameter<int>("reader_thread_num", 1);
+  worker_thread_num_ = declare_parameter<int>("worker_thread_num", 1);
+  spill_thread_num_ = declare_parameter<int>("spill_thread_num", 1);
+  finalize_thread_num_ = declare_parameter<int>("finalize_thread_num", 1);
+  in_memory_mode_ = declare_parameter<bool>("in_memory_mode", false);
+  incremental_mode_ = declare_parameter<bool>("incremental_mode", false);
+  pre_voxelize_ = declare_parameter<bool>("pre_voxelize", false);
+  outlier_mean_k_ = declare_parameter<int>("outlier_mean_k", 0);
+  outlier_stddev_mul_ = declare_parameter<double>("outlier_stddev_mul", 1.0);
+  outlier_halo_ = declare_parameter<double>("outlier_halo", 1.0);
+  std::string tile_encoding = declare_parameter<std::string>("tile_encoding", "binary");
+  quantization_step_ = declare_parameter<double>("quantization_step", 0.001);
+  lod_leaf_sizes_ =
+    declare_parameter<std::vector<double>>("lod_leaf_sizes", std::vector<double>());
+
+  if (!toTileEncoding(tile_encoding, tile_encoding_)) {
+    RCLCPP_ERROR(
+      get_logger(), "Error: Unknown tile_encoding %s. Use binary instead.", tile_encoding.c_str());
+    tile_encoding_ = TileEncoding::BINARY;
+  }
+  height_map_cell_size_ = declare_parameter<double>("height_map_cell_size", 0.0);
+  ndt_resolution_ = declare_parameter<double>("ndt_resolution", 0.0);
+  morton_order_ = declare_parameter<bool>("morton_order", false);
+  std::string height_map_format = declare_parameter<std::string>("height_map_format", "binary");
+
+  if (!toHeightMapFormat(height_map_format, height_map_format_)) {
+    RCLCPP_ERROR(
+      get_logger(), "Error: Unknown height_map_format %s. Use binary instead.",
+      height_map_format.c_str());
+    height_map_format_ = HeightMapFormat::BINARY;
+  }
+
+  std::string voxel_filter_engine =
+    declare_parameter<std::string>("voxel_filter_engine", "hash");
+
+  if (!toVoxelFilterEngine(voxel_filter_engine, voxel_filter_engine_)) {
+    RCLCPP_ERROR(
+      get_logger(), "Error: Unknown voxel_filter_engine %s. Use hash instead.",
+      voxel_filter_engine.c_str());
+    voxel_filter_engine_ = VoxelFilterEngine::HASH;
+  }
+
+  max_voxel_num_ = declare_parameter<int64_t>("max_voxel_num", 0);
+  memory_budget_ = declare_parameter<int64_t>("memory_budget", 0);
+  std::string spill_policy = declare_parameter<std::string>("spill_policy", "size");
+  std::string spill_encoding = declare_parameter<std::string>("spill_encoding", "pcd");
+  report_path_ = declare_parameter<std::string>("report_path", "");
+  progress_period_ = declare_parameter<double>("progress_period", 0.0);
+  checkpoint_period_ = declare_parameter<double>("checkpoint_period", 0.0);
+  output_sink_command_ = declare_parameter<std::string>("output_sink_command", "");
+  upload_thread_num_ = declare_parameter<int>("upload_thread_num", 4);
+  laz_command_ = declare_parameter<std::string>("laz_command", "");
+  async_io_queue_depth_ = declare_parameter<int>("async_io_queue_depth", 0);
+  async_io_direct_ = declare_parameter<bool>("async_io_direct", false);
+  partition_role_ = declare_parameter<std::string>("partition_role", "none");
+  partition_plan_ = declare_parameter<std::string>("partition_plan", "");
+  partition_worker_num_ = declare_parameter<int>("partition_worker_num", 1);
+  partition_worker_id_ = declare_parameter<int>("partition_worker_id", 0);
+
+  if (report_path_.empty()) {
+    report_path_ = output_pcd_dir_ + "/pointcloud_divider_report.json";
+  }
+
+  if (!toSpillPolicy(spill_policy, spill_policy_)) {
+    RCLCPP_ERROR(
+      get_logger(), "Error: Unknown spill_policy %s. Use size instead.", spill_policy.c_str());
+    spill_policy_ = SpillPolicy::SIZE;
+  }
+
+  if (!toSpillEncoding(spill_encoding, spill_encoding_)) {
+    RCLCPP_ERROR(
+      get_logger(), "Error: Unknown spill_encoding %s. Use pcd instead.", spill_encoding.c_str());
+    spill_encoding_ = SpillEncoding::PCD;
+  }
+
   // Enter a new line and clear it
   // This is to get rid of the prefix of RCLCPP_INFO
   std::string line_breaker(102, ' ');
@@ -47,44 +238,112 @@ PointCloudDivider::PointCloudDivider(const rclcpp::NodeOptions & node_options)
   param_display << line_breaker << line_breaker << "########## Input Parameters ##########"
                 << line_breaker;
 
-  if (use_large_grid) {
-    param_display << "\tuse_large_grid: True" << line_breaker;
+  if (use_large_grid_) {
+    param_display << "\tuse_large_grid: True (" << large_grid_factor_ << " x "
+                  << large_grid_factor_ << " segments)" << line_breaker;
   } else {
     param_display << "\tuse_large_grid: False" << line_breaker;
   }
 
-  param_display << "\tleaf_size: " << leaf_size << line_breaker;
-  param_display << "\tgrid_size: " << grid_size_x << ", " << grid_size_y << line_breaker;
-  param_display << "\tinput_pcd_or_dir: " << input_pcd_or_dir << line_breaker;
-  param_display << "\toutput_pcd_dir: " << output_pcd_dir << line_breaker;
-  param_display << "\tfile_prefix: " << file_prefix << line_breaker;
+  param_display << "\tleaf_size: " << leaf_size_ << line_breaker;
+  param_display << "\tgrid_size: " << grid_size_x_ << ", " << grid_size_y_ << line_breaker;
+  param_display << "\tinput_pcd_or_dir: " << input_pcd_or_dir_ << line_breaker;
+  param_display << "\toutput_pcd_dir: " << output_pcd_dir_ << line_breaker;
+  param_display << "\tfile_prefix: " << file_prefix_ << line_breaker;
   param_display << "\tpoint_type: " << point_type << line_breaker;
-  param_display << "######################################" << line_breaker;
+  param_display << "\tthread_num: " << reader_thread_num_ << " readers, " << worker_thread_num_
+                << " workers, " << spill_thread_num_ << " spill writers, " << finalize_thread_num_
+                << " finalizers" << line_breaker;
+  param_display << "\tvoxel_filter_engine: " << voxel_filter_engine << line_breaker;
+  param_display << "\tpre_voxelize: " << (pre_voxelize_ ? "True" : "False") << line_breaker;
 
-  RCLCPP_INFO(get_logger(), "%s", param_display.str().c_str());
+  if (outlier_mean_k_ > 0) {
+    param_display << "\toutlier_mean_k: " << outlier_mean_k_
+                  << ", outlier_stddev_mul: " << outlier_stddev_mul_
+                  << ", outlier_halo: " << outlier_halo_ << " m" << line_breaker;
+  }
+  param_display << "\ttile_encoding: " << tile_encoding << line_breaker;
 
-  if (point_type == "point_xyz") {
-    autoware::pointcloud_divider::PCDDivider<pcl::PointXYZ> pcd_divider_exe(get_logger());
+  if (!lod_leaf_sizes_.empty()) {
+    param_display << "\tlod_leaf_sizes:";
 
-    pcd_divider_exe.setLargeGridMode(use_large_grid);
-    pcd_divider_exe.setLeafSize(leaf_size);
-    pcd_divider_exe.setGridSize(grid_size_x, grid_size_y);
-    pcd_divider_exe.setInput(input_pcd_or_dir);
-    pcd_divider_exe.setOutputDir(output_pcd_dir);
-    pcd_divider_exe.setPrefix(file_prefix);
+    for (auto lod_leaf_size : lod_leaf_sizes_) {
+      param_display << " " << lod_leaf_size;
+    }
 
-    pcd_divider_exe.run();
-  } else if (point_type == "point_xyzi") {
-    autoware::pointcloud_divider::PCDDivider<pcl::PointXYZI> pcd_divider_exe(get_logger());
+    param_display << line_breaker;
+  }
 
-    pcd_divider_exe.setLargeGridMode(use_large_grid);
-    pcd_divider_exe.setLeafSize(leaf_size);
-    pcd_divider_exe.setGridSize(grid_size_x, grid_size_y);
-    pcd_divider_exe.setInput(input_pcd_or_dir);
-    pcd_divider_exe.setOutputDir(output_pcd_dir);
-    pcd_divider_exe.setPrefix(file_prefix);
+  if (height_map_cell_size_ > 0) {
+    param_display << "\theight_map: " << height_map_cell_size_ << " m cells, "
+                  << height_map_format << line_breaker;
+  }
+
+  if (ndt_resolution_ > 0) {
+    param_display << "\tndt_resolution: " << ndt_resolution_ << line_breaker;
+  }
 
-    pcd_divider_exe.run();
+  param_display << "\tmorton_order: " << (morton_order_ ? "True" : "False") << line_breaker;
+
+  param_display << "\tincremental_mode: " << (incremental_mode_ ? "True" : "False")
+                << line_breaker;
+  param_display << "\tin_memory_mode: " << (in_memory_mode_ ? "True" : "False") << line_breaker;
+  if (max_voxel_num_ > 0) {
+    param_display << "\tmax_voxel_num: " << max_voxel_num_ << line_breaker;
+  }
+
+  param_display << "\tmemory_budget: " << memory_budget_ << " bytes, spill_policy: "
+                << spill_policy << ", spill_encoding: " << spill_encoding << line_breaker;
+  param_display << "\treport_path: " << report_path_ << line_breaker;
+
+  if (checkpoint_period_ > 0) {
+    param_display << "\tcheckpoint_period: " << checkpoint_period_ << " s" << line_breaker;
+  }
+
+  if (!output_sink_command_.empty()) {
+    param_display << "\toutput_sink_command: " << output_sink_command_ << " ("
+                  << upload_thread_num_ << " threads)" << line_breaker;
+  }
+
+  if (!laz_command_.empty()) {
+    param_display << "\tlaz_command: " << laz_command_ << line_breaker;
+  }
+
+  if (async_io_queue_depth_ > 0) {
+    param_display << "\tasync_io: " << async_io_queue_depth_ << " chunks in flight"
+                  << (async_io_direct_ ? ", direct reads" : "") << line_breaker;
+  }
+
+  if (partition_role_ != "none") {
+    param_display << "\tpartition_role: " << partition_role_ << " (plan: " << partition_plan_
+                  << ", " << partition_worker_num_ << " workers, worker id "
+                  << partition_worker_id_ << ")" << line_breaker;
+  }
+
+  param_display << "######################################" << line_breaker;
+
+  RCLCPP_INFO(get_logger(), "%s", param_display.str().c_str());
+
+  if (
+    partition_role_ != "none" && partition_role_ != "plan" && partition_role_ != "worker" &&
+    partition_role_ != "merge") {
+    RCLCPP_ERROR(get_logger(), "Error: Unknown partition_role %s", partition_role_.c_str());
+  } else if (partition_role_ == "merge") {
+    runPartitionMerge();
+  } else if (partition_role_ != "none" && point_type == "raw") {
+    RCLCPP_ERROR(get_logger(), "Error: The raw point type cannot be divided by partitions");
+  } else if (point_type == "point_xyz") {
+    runDivider<pcl::PointXYZ>();
+  } else if (point_type == "point_xyzi") {
+    runDivider<pcl::PointXYZI>();
+  } else if (point_type == "point_xyzrgb") {
+    runDivider<pcl::PointXYZRGB>();
+  } else if (point_type == "point_xyzinormal") {
+    runDivider<pcl::PointXYZINormal>();
+  } else if (point_type == "raw") {
+    runRawDivider();
+  } else {
+    RCLCPP_ERROR(get_logger(), "Error: Unsupported point type %s", point_type.c_str());
   }
 
   rclcpp::shutdown();
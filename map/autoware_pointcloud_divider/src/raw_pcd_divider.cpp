@@ -0,0 +1,573 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <autoware/pointcloud_divider/raw_pcd_divider.hpp>
+#include <autoware/pointcloud_divider/utility.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace autoware::pointcloud_divider
+{
+
+namespace
+{
+
+// Coordinates of a record, to find its grid with pointToGrid2 as the point dividers do
+struct RawPoint
+{
+  float x, y;
+};
+
+// Read a float32 or float64 coordinate, converted to float32 as the point dividers do
+inline float readCoordinate(const char * src, size_t size)
+{
+  if (size == sizeof(double)) {
+    double value;
+
+    memcpy(&value, src, sizeof(double));
+
+    return static_cast<float>(value);
+  }
+
+  float value;
+
+  memcpy(&value, src, sizeof(float));
+
+  return value;
+}
+
+// Find the offset and the size of a scalar float field. Return false if it is not one.
+bool findCoordinate(
+  const std::vector<std::string> & names, const std::vector<size_t> & sizes,
+  const std::vector<std::string> & types, const std::vector<size_t> & counts,
+  const std::string & name, size_t & offset, size_t & size)
+{
+  offset = 0;
+
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (names[i] == name) {
+      if (types[i] != "F" || counts[i] != 1 || (sizes[i] != 4 && sizes[i] != 8)) {
+        return false;
+      }
+
+      size = sizes[i];
+
+      return true;
+    }
+
+    offset += sizes[i] * counts[i];
+  }
+
+  return false;
+}
+
+}  // namespace
+
+bool readRawPCDHeader(const std::string & path, RawPCDHeader & header, std::string & error)
+{
+  std::ifstream file(path, std::ios::binary);
+
+  if (!file.is_open()) {
+    error = "cannot open the file";
+    return false;
+  }
+
+  header = RawPCDHeader();
+
+  std::vector<std::string> names, types;
+  std::vector<size_t> sizes, counts;
+  std::string line, data;
+  std::ostringstream layout;
+
+  try {
+    while (std::getline(file, line)) {
+      std::istringstream tokens(line);
+      std::string key, value;
+      std::vector<std::string> values;
+
+      tokens >> key;
+
+      while (tokens >> value) {
+        values.push_back(value);
+      }
+
+      if (key.empty()) {
+        continue;
+      }
+
+      if (key[0] == '#' || key == "VERSION") {
+        header.schema_lines.push_back(line);
+        continue;
+      }
+
+      if (key == "FIELDS" || key == "SIZE" || key == "TYPE" || key == "COUNT") {
+        header.schema_lines.push_back(line);
+        layout << key;
+
+        for (const auto & v : values) {
+          layout << " " << v;
+        }
+
+        layout << "\n";
+
+        if (key == "FIELDS") {
+          names = values;
+        } else if (key == "TYPE") {
+          types = values;
+        } else {
+          auto & target = (key == "SIZE") ? sizes : counts;
+
+          for (const auto & v : values) {
+            target.push_back(std::stoul(v));
+          }
+        }
+
+        continue;
+      }
+
+      if (key == "POINTS" && !values.empty()) {
+        header.point_num = std::stoul(values[0]);
+        continue;
+      }
+
+      if (key == "DATA") {
+        data = values.empty() ? "" : values[0];
+        break;
+      }
+
+      // WIDTH, HEIGHT, and VIEWPOINT are written again for each segment
+    }
+  } catch (const std::exception &) {
+    error = "invalid header";
+    return false;
+  }
+
+  if (data != "binary") {
+    error = "only the uncompressed binary PCDs are supported, but DATA is " + data;
+    return false;
+  }
+
+  auto data_pos = file.tellg();
+
+  if (data_pos < 0) {
+    error = "no data";
+    return false;
+  }
+
+  // COUNT is optional, and 1 by default
+  if (counts.empty()) {
+    counts.assign(names.size(), 1);
+  }
+
+  if (sizes.size() != names.size() || types.size() != names.size() ||
+      counts.size() != names.size()) {
+    error = "the numbers of the fields, sizes, types, and counts are different";
+    return false;
+  }
+
+  header.layout = layout.str();
+  header.data_offset = static_cast<size_t>(data_pos);
+
+  for (size_t i = 0; i < names.size(); ++i) {
+    header.record_size += sizes[i] * counts[i];
+  }
+
+  if (
+    !findCoordinate(names, sizes, types, counts, "x", header.x_offset, header.x_size) ||
+    !findCoordinate(names, sizes, types, counts, "y", header.y_offset, header.y_size)) {
+    error = "x and y must be float32 or float64 scalars";
+    return false;
+  }
+
+  if (!findCoordinate(names, sizes, types, counts, "z", header.z_offset, header.z_size)) {
+    header.z_size = 0;
+  }
+
+  return true;
+}
+
+void RawPCDDivider::run()
+{
+  std::vector<std::string> pcd_list;
+  fs::path input_path(input_pcd_or_dir_);
+
+  if (fs::is_directory(input_path)) {
+    RCLCPP_INFO(logger_, "Input PCD directory: %s", input_pcd_or_dir_.c_str());
+
+    for (auto & entry : fs::directory_iterator(input_path)) {
+      auto extension = entry.path().extension().string();
+
+      if (
+        fs::is_regular_file(entry.symlink_status()) &&
+        (extension == ".pcd" || extension == ".PCD")) {
+        pcd_list.push_back(entry.path().string());
+      }
+    }
+  } else if (fs::is_regular_file(input_path)) {
+    RCLCPP_INFO(logger_, "Input PCD file: %s", input_pcd_or_dir_.c_str());
+    pcd_list.push_back(input_path.string());
+  } else {
+    RCLCPP_ERROR(logger_, "Error: Invalid input %s", input_pcd_or_dir_.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  run(pcd_list);
+}
+
+void RawPCDDivider::run(const std::vector<std::string> & pcd_names)
+{
+  segments_.clear();
+  resident_bytes_ = spilled_bytes_ = 0;
+  checkOutputDirectoryValidity();
+
+  for (size_t i = 0; i < pcd_names.size(); ++i) {
+    std::string error;
+    RawPCDHeader header;
+
+    if (!readRawPCDHeader(pcd_names[i], header, error)) {
+      RCLCPP_ERROR(logger_, "Error: %s: %s", pcd_names[i].c_str(), error.c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    // The records of all the inputs are written to the same segments, so they share the fields
+    if (i == 0) {
+      schema_ = header;
+    } else if (header.layout != schema_.layout) {
+      RCLCPP_ERROR(
+        logger_, "Error: The fields of %s are different from the ones of %s",
+        pcd_names[i].c_str(), pcd_names[0].c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // The resident records are limited by the bytes of 100M records by default
+  max_resident_bytes_ =
+    memory_budget_ > 0 ? memory_budget_ : schema_.record_size * static_cast<size_t>(100000000);
+
+  for (const auto & pcd_name : pcd_names) {
+    if (!rclcpp::ok()) {
+      return;
+    }
+
+    if (debug_mode_) {
+      RCLCPP_INFO(logger_, "Dividing file %s", pcd_name.c_str());
+    }
+
+    divide(pcd_name);
+  }
+
+  RCLCPP_INFO(logger_, "Saving segments... ");
+
+  std::vector<GridInfo<2>> grids;
+  std::vector<TileRecord> tiles;
+
+  grids.reserve(segments_.size());
+  tiles.reserve(segments_.size());
+
+  for (auto & segment : segments_) {
+    tiles.emplace_back();
+    saveSegment(segment.first, segment.second, tiles.back());
+    grids.push_back(segment.first);
+  }
+
+  if (debug_mode_) {
+    RCLCPP_INFO(logger_, "Spilled %lu bytes to the tmp directory", spilled_bytes_);
+  }
+
+  fs::remove_all(tmp_dir_);
+  saveGridInfoToYAML(grids);
+
+  TileIndex index(grid_size_x_, grid_size_y_, file_prefix_, std::move(tiles));
+  std::string index_path = output_dir_ + "/pointcloud_map_index.bin";
+
+  if (!index.save(index_path)) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save the tile index: %s", index_path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  RCLCPP_INFO(logger_, "Done!");
+}
+
+void RawPCDDivider::checkOutputDirectoryValidity()
+{
+  if (fs::exists(output_dir_)) {
+    fs::remove_all(output_dir_);
+  }
+
+  util::make_dir(output_dir_ + "/pointcloud_map.pcd/");
+  util::make_dir(tmp_dir_);
+}
+
+void RawPCDDivider::divide(const std::string & pcd_name)
+{
+  RawPCDHeader header;
+  std::string error;
+
+  readRawPCDHeader(pcd_name, header, error);
+
+  int fd = open(pcd_name.c_str(), O_RDONLY);
+  struct stat file_stat;
+
+  if (fd < 0 || fstat(fd, &file_stat) != 0) {
+    RCLCPP_ERROR(logger_, "Error: Failed to open a file at %s", pcd_name.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  const size_t file_size = static_cast<size_t>(file_stat.st_size);
+
+  if (file_size <= header.data_offset || header.record_size == 0) {
+    close(fd);
+    return;
+  }
+
+  void * addr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close(fd);
+
+  if (addr == MAP_FAILED) {
+    RCLCPP_ERROR(logger_, "Error: Failed to map a file at %s", pcd_name.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  madvise(addr, file_size, MADV_SEQUENTIAL);
+
+  // Ignore the trailing bytes of an incomplete record in a truncated file
+  const size_t record_size = header.record_size;
+  const size_t record_num =
+    std::min(header.point_num, (file_size - header.data_offset) / record_size);
+  const char * record = static_cast<const char *>(addr) + header.data_offset;
+
+  // Consecutive records mostly fall in the same grid, so its segment is looked up only when the
+  // grid changes
+  GridInfo<2> last_grid;
+  Segment * segment = nullptr;
+
+  for (size_t i = 0; i < record_num; ++i, record += record_size) {
+    RawPoint p{
+      readCoordinate(record + header.x_offset, header.x_size),
+      readCoordinate(record + header.y_offset, header.y_size)};
+    auto grid = pointToGrid2(p, grid_size_x_, grid_size_y_);
+
+    if (!segment || grid != last_grid) {
+      segment = &segments_[grid];
+      last_grid = grid;
+    }
+
+    segment->records.insert(segment->records.end(), record, record + record_size);
+
+    if (header.z_size > 0) {
+      float z = readCoordinate(record + header.z_offset, header.z_size);
+
+      segment->z_min = std::min(segment->z_min, z);
+      segment->z_max = std::max(segment->z_max, z);
+    }
+
+    resident_bytes_ += record_size;
+
+    if (resident_bytes_ > max_resident_bytes_) {
+      spillLargestSegment();
+    }
+  }
+
+  munmap(addr, file_size);
+}
+
+void RawPCDDivider::spillLargestSegment()
+{
+  auto largest = std::max_element(
+    segments_.begin(), segments_.end(), [](const auto & a, const auto & b) {
+      return a.second.records.size() < b.second.records.size();
+    });
+
+  if (largest == segments_.end() || largest->second.records.empty()) {
+    return;
+  }
+
+  auto & segment = largest->second;
+  std::string tmp_path = makeTmpPath(largest->first);
+  std::ofstream tmp_file(tmp_path, std::ios::binary | std::ios::app);
+
+  tmp_file.write(segment.records.data(), segment.records.size());
+
+  if (!tmp_file) {
+    RCLCPP_ERROR(logger_, "Error: Failed to write records to %s", tmp_path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  segment.spilled_num += segment.records.size() / schema_.record_size;
+  resident_bytes_ -= segment.records.size();
+  spilled_bytes_ += segment.records.size();
+
+  // Release the buffer, since the segment may not receive records anymore
+  std::vector<char>().swap(segment.records);
+}
+
+void RawPCDDivider::saveSegment(const GridInfo<2> & grid, Segment & segment, TileRecord & record)
+{
+  const size_t point_num = segment.spilled_num + segment.records.size() / schema_.record_size;
+  std::string save_path = makeSegmentPath(grid);
+
+  if (use_large_grid_) {
+    util::make_dir(fs::path(save_path).parent_path().string());
+  }
+
+  // The schema of the inputs, followed by the size of the segment
+  std::ostringstream header;
+
+  for (const auto & line : schema_.schema_lines) {
+    header << line << "\n";
+  }
+
+  header << "WIDTH " << point_num << "\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS " << point_num
+         << "\nDATA binary\n";
+
+  std::ofstream file(save_path, std::ios::binary);
+  std::string header_str = header.str();
+  uint32_t crc = crc32(header_str.data(), header_str.size());
+
+  file.write(header_str.data(), header_str.size());
+
+  // The spilled records come first, as they were binned first
+  if (segment.spilled_num > 0) {
+    std::string tmp_path = makeTmpPath(grid);
+    std::ifstream tmp_file(tmp_path, std::ios::binary);
+    std::vector<char> buffer(1 << 20);
+
+    while (tmp_file) {
+      tmp_file.read(buffer.data(), buffer.size());
+      file.write(buffer.data(), tmp_file.gcount());
+      crc = crc32(buffer.data(), tmp_file.gcount(), crc);
+    }
+
+    fs::remove(tmp_path);
+  }
+
+  file.write(segment.records.data(), segment.records.size());
+  crc = crc32(segment.records.data(), segment.records.size(), crc);
+
+  if (!file) {
+    RCLCPP_ERROR(logger_, "Error: Failed to save a point cloud at %s", save_path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  record = TileRecord{};
+  record.ix = grid.ix;
+  record.iy = grid.iy;
+  record.point_num = point_num;
+  record.z_min = schema_.z_size > 0 ? segment.z_min : 0;
+  record.z_max = schema_.z_size > 0 ? segment.z_max : 0;
+  record.byte_size = static_cast<uint64_t>(file.tellp());
+  record.checksum = crc;
+
+  resident_bytes_ -= segment.records.size();
+  std::vector<char>().swap(segment.records);
+}
+
+GridInfo<2> RawPCDDivider::toLargeGrid(const GridInfo<2> & grid) const
+{
+  const double g_grid_size_x = grid_size_x_ * large_grid_factor_;
+  const double g_grid_size_y = grid_size_y_ * large_grid_factor_;
+  int large_gx = static_cast<int>(std::floor(static_cast<float>(grid.ix) / g_grid_size_x));
+  int large_gy = static_cast<int>(std::floor(static_cast<float>(grid.iy) / g_grid_size_y));
+
+  return GridInfo<2>(large_gx, large_gy);
+}
+
+std::string RawPCDDivider::makeFileName(const GridInfo<2> & grid) const
+{
+  return file_prefix_ + "_" + std::to_string(grid.ix) + "_" + std::to_string(grid.iy) + ".pcd";
+}
+
+std::string RawPCDDivider::makeSegmentPath(const GridInfo<2> & grid) const
+{
+  std::string map_dir = output_dir_ + "/pointcloud_map.pcd/";
+
+  // Segments are contained in the folders of their large grids, as the point dividers do
+  if (use_large_grid_) {
+    std::ostringstream large_folder_name;
+
+    large_folder_name << toLargeGrid(grid);
+    map_dir += large_folder_name.str() + "/";
+  }
+
+  return map_dir + makeFileName(grid);
+}
+
+std::string RawPCDDivider::makeTmpPath(const GridInfo<2> & grid) const
+{
+  std::ostringstream tmp_path;
+
+  tmp_path << tmp_dir_ << grid << ".bin";
+
+  return tmp_path.str();
+}
+
+void RawPCDDivider::saveGridInfoToYAML(const std::vector<GridInfo<2>> & grids)
+{
+  // The same catalogues as the point dividers, the global one and one per large grid folder
+  std::unordered_map<std::string, std::vector<GridInfo<2>>> catalogues;
+
+  catalogues[output_dir_ + "/pointcloud_map_metadata.yaml"] = grids;
+
+  if (use_large_grid_) {
+    for (const auto & grid : grids) {
+      std::ostringstream yaml_path;
+
+      yaml_path << output_dir_ << "/pointcloud_map.pcd/" << toLargeGrid(grid)
+                << "/pointcloud_map_metadata.yaml";
+      catalogues[yaml_path.str()].push_back(grid);
+    }
+  }
+
+  for (const auto & catalogue : catalogues) {
+    std::ofstream yaml_file(catalogue.first);
+
+    if (!yaml_file.is_open()) {
+      RCLCPP_ERROR(logger_, "Error: Cannot open YAML file: %s", catalogue.first.c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    yaml_file << "x_resolution: " << grid_size_x_ << std::endl;
+    yaml_file << "y_resolution: " << grid_size_y_ << std::endl;
+
+    for (const auto & grid : catalogue.second) {
+      yaml_file << makeFileName(grid) << ": [" << grid.ix << ", " << grid.iy << "]" << std::endl;
+    }
+  }
+}
+
+}  // namespace autoware::pointcloud_divider
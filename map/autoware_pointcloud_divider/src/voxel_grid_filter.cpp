@@ -14,9 +14,18 @@
 
 #include <autoware/pointcloud_divider/centroid.hpp>
 #include <autoware/pointcloud_divider/grid_info.hpp>
+#include <autoware/pointcloud_divider/tile_index.hpp>
 #include <autoware/pointcloud_divider/voxel_grid_filter.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace autoware::pointcloud_divider
 {
@@ -28,6 +37,16 @@ void VoxelGridFilter<PointT>::filter(const PclCloudType & input, PclCloudType &
     return;
   }
 
+  if (engine_ == VoxelFilterEngine::SORT && filterBySort(input, output)) {
+    return;
+  }
+
+  filterByHash(input, output);
+}
+
+template <typename PointT>
+void VoxelGridFilter<PointT>::filterByHash(const PclCloudType & input, PclCloudType & output)
+{
   std::unordered_map<GridInfo<3>, Centroid<PointT>> grid_map;
 
   for (auto & p : input) {
@@ -44,4 +63,252 @@ void VoxelGridFilter<PointT>::filter(const PclCloudType & input, PclCloudType &
   }
 }
 
+template <typename PointT>
+void VoxelGridFilter<PointT>::add(const PclCloudType & input)
+{
+  if (resolution_ <= 0) {
+    return;
+  }
+
+  for (auto & p : input) {
+    acc_map_[pointToGrid3(p, resolution_, resolution_, resolution_)].add(p);
+
+    if (max_voxel_num_ > 0 && acc_map_.size() > max_voxel_num_) {
+      evict();
+    }
+  }
+}
+
+template <typename PointT>
+void VoxelGridFilter<PointT>::flush(PclCloudType & output)
+{
+  // The voxels still accumulated may have been evicted before, so they are merged with them
+  if (!evicted_.empty()) {
+    for (auto & it : acc_map_) {
+      evicted_.push_back({it.first, it.second.get(), it.second.point_num_});
+    }
+
+    acc_map_.clear();
+    mergeEvicted();
+  }
+
+  output.reserve(output.size() + evicted_.size() + acc_map_.size());
+
+  for (auto & voxel : evicted_) {
+    output.push_back(voxel.centroid);
+  }
+
+  for (auto & it : acc_map_) {
+    output.push_back(it.second.get());
+  }
+
+  acc_map_.clear();
+  std::vector<EvictedVoxel>().swap(evicted_);
+  merged_evicted_num_ = 0;
+}
+
+template <typename PointT>
+void VoxelGridFilter<PointT>::setMaxVoxelNum(size_t max_voxel_num)
+{
+  max_voxel_num_ = max_voxel_num;
+
+  // The table never grows past the limit, so it is never rehashed
+  if (max_voxel_num_ > 0) {
+    acc_map_.reserve(max_voxel_num_ + 1);
+  }
+}
+
+template <typename PointT>
+void VoxelGridFilter<PointT>::evict()
+{
+  std::vector<std::pair<uint64_t, GridInfo<3>>> keys;
+
+  keys.reserve(acc_map_.size());
+
+  for (auto & it : acc_map_) {
+    keys.emplace_back(mortonCode(it.first.ix, it.first.iy), it.first);
+  }
+
+  auto middle = keys.begin() + keys.size() / 2;
+
+  std::nth_element(keys.begin(), middle, keys.end(), [](const auto & a, const auto & b) {
+    return a.first < b.first;
+  });
+
+  for (auto it = keys.begin(); it != middle; ++it) {
+    auto acc_it = acc_map_.find(it->second);
+
+    evicted_.push_back({acc_it->first, acc_it->second.get(), acc_it->second.point_num_});
+    acc_map_.erase(acc_it);
+  }
+
+  evicted_voxel_num_ += middle - keys.begin();
+
+  // Revisited voxels add parts without adding voxels, so the parts are merged once they double
+  if (evicted_.size() >= 2 * std::max(merged_evicted_num_, max_voxel_num_)) {
+    mergeEvicted();
+  }
+}
+
+template <typename PointT>
+void VoxelGridFilter<PointT>::mergeEvicted()
+{
+  using Traits = PointFieldTraits<PointT>;
+
+  // The parts of a voxel keep their eviction order, so the color is the one of its first point
+  std::stable_sort(evicted_.begin(), evicted_.end(), [](const auto & a, const auto & b) {
+    return std::tie(a.key.ix, a.key.iy, a.key.iz) < std::tie(b.key.ix, b.key.iy, b.key.iz);
+  });
+
+  size_t merged_num = 0;
+
+  for (size_t i = 0; i < evicted_.size(); ++i) {
+    if (merged_num == 0 || evicted_[i].key != evicted_[merged_num - 1].key) {
+      evicted_[merged_num++] = evicted_[i];
+      continue;
+    }
+
+    auto & merged = evicted_[merged_num - 1];
+    const auto & part = evicted_[i];
+    const double point_num = merged.point_num + part.point_num;
+
+    for (size_t fid = 0; fid < Traits::size; ++fid) {
+      if (!Traits::color[fid]) {
+        double sum = static_cast<double>(*fieldPtr(merged.centroid, fid)) * merged.point_num +
+                     static_cast<double>(*fieldPtr(part.centroid, fid)) * part.point_num;
+
+        *fieldPtr(merged.centroid, fid) = sum / point_num;
+      }
+    }
+
+    merged.point_num += part.point_num;
+  }
+
+  evicted_.resize(merged_num);
+  merged_evicted_num_ = evicted_.size();
+}
+
+template <typename PointT>
+bool VoxelGridFilter<PointT>::filterBySort(const PclCloudType & input, PclCloudType & output)
+{
+  const size_t point_num = input.size();
+
+  if (point_num == 0) {
+    return true;
+  }
+
+  if (point_num > std::numeric_limits<std::uint32_t>::max()) {
+    return false;
+  }
+
+  // Compute the voxel indices in batches over flat arrays, so the loops are
+  // vectorized by the compiler. The formula is the same as pointToGrid3.
+  std::vector<std::int32_t> ids(point_num * 3);
+  std::array<std::int32_t, 3> min_id, max_id;
+
+  for (size_t d = 0; d < 3; ++d) {
+    std::int32_t * dim_ids = ids.data() + d * point_num;
+
+    for (size_t i = 0; i < point_num; ++i) {
+      dim_ids[i] = static_cast<std::int32_t>(std::floor(input[i].data[d] / resolution_));
+    }
+
+    auto min_max = std::minmax_element(dim_ids, dim_ids + point_num);
+
+    min_id[d] = *min_max.first;
+    max_id[d] = *min_max.second;
+  }
+
+  // Linear codes: ((ix - min_x) * ny + (iy - min_y)) * nz + (iz - min_z)
+  std::array<std::uint64_t, 3> extent;
+  std::uint64_t max_code = 1;
+
+  for (size_t d = 0; d < 3; ++d) {
+    extent[d] = static_cast<std::uint64_t>(
+                  static_cast<std::int64_t>(max_id[d]) - static_cast<std::int64_t>(min_id[d])) +
+                1;
+
+    if (max_code > std::numeric_limits<std::uint64_t>::max() / extent[d]) {
+      return false;
+    }
+
+    max_code *= extent[d];
+  }
+
+  std::vector<std::uint64_t> codes(point_num);
+  const std::int32_t * ix = ids.data();
+  const std::int32_t * iy = ix + point_num;
+  const std::int32_t * iz = iy + point_num;
+
+  for (size_t i = 0; i < point_num; ++i) {
+    codes[i] = (static_cast<std::uint64_t>(ix[i] - min_id[0]) * extent[1] +
+                static_cast<std::uint64_t>(iy[i] - min_id[1])) *
+                 extent[2] +
+               static_cast<std::uint64_t>(iz[i] - min_id[2]);
+  }
+
+  ids = std::vector<std::int32_t>();
+
+  // LSD radix sort of the point indices by code. It is stable, so the points of a
+  // voxel keep their input order and are accumulated in the same order as filterByHash.
+  const size_t radix_bits = 11;
+  const size_t bucket_num = size_t(1) << radix_bits;
+  size_t code_bits = 0;
+
+  for (std::uint64_t c = max_code - 1; c > 0; c >>= 1) {
+    ++code_bits;
+  }
+
+  // The codes are moved together with the indices, so every pass reads them sequentially
+  std::vector<std::uint32_t> order(point_num), tmp_order(point_num);
+  std::vector<std::uint64_t> tmp_codes(point_num);
+  std::vector<size_t> bucket_start(bucket_num);
+
+  for (size_t i = 0; i < point_num; ++i) {
+    order[i] = i;
+  }
+
+  for (size_t shift = 0; shift < code_bits; shift += radix_bits) {
+    std::fill(bucket_start.begin(), bucket_start.end(), 0);
+
+    for (size_t i = 0; i < point_num; ++i) {
+      ++bucket_start[(codes[i] >> shift) & (bucket_num - 1)];
+    }
+
+    size_t sum = 0;
+
+    for (auto & start : bucket_start) {
+      size_t count = start;
+
+      start = sum;
+      sum += count;
+    }
+
+    for (size_t i = 0; i < point_num; ++i) {
+      size_t dst = bucket_start[(codes[i] >> shift) & (bucket_num - 1)]++;
+
+      tmp_codes[dst] = codes[i];
+      tmp_order[dst] = order[i];
+    }
+
+    codes.swap(tmp_codes);
+    order.swap(tmp_order);
+  }
+
+  // Reduce each run of equal codes to its centroid
+  for (size_t run_start = 0; run_start < point_num;) {
+    Centroid<PointT> centroid;
+    size_t i = run_start;
+
+    for (; i < point_num && codes[i] == codes[run_start]; ++i) {
+      centroid.add(input[order[i]]);
+    }
+
+    output.push_back(centroid.get());
+    run_start = i;
+  }
+
+  return true;
+}
+
 }  // namespace autoware::pointcloud_divider
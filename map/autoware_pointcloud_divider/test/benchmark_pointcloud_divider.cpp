@@ -0,0 +1,485 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the components of the divider over a synthetic cloud, and comparison of two
+// divided maps. It is not run by ctest:
+//   pointcloud_divider_benchmark [uniform|corridor|urban] [point_num=5000000] [density=100]
+//                                [work_dir=/tmp/pointcloud_divider_benchmark]
+//   pointcloud_divider_benchmark compare <map_dir_a> <map_dir_b> [tolerance=0]
+// The density is in points per square meter. The compare mode exits with 1 if the maps differ,
+// so the output of an optimized build can be checked against the one of a reference build.
+
+#include <autoware/pointcloud_divider/grid_info.hpp>
+#include <autoware/pointcloud_divider/pcd_divider.hpp>
+#include <autoware/pointcloud_divider/pcd_io.hpp>
+#include <autoware/pointcloud_divider/voxel_grid_filter.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <sys/resource.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+using autoware::pointcloud_divider::CustomPCDReader;
+using autoware::pointcloud_divider::CustomPCDWriter;
+using autoware::pointcloud_divider::GridInfo;
+using autoware::pointcloud_divider::PCDDivider;
+using autoware::pointcloud_divider::VoxelFilterEngine;
+using autoware::pointcloud_divider::VoxelGridFilter;
+
+typedef pcl::PointXYZI PointT;
+typedef pcl::PointCloud<PointT> CloudT;
+
+using Clock = std::chrono::steady_clock;
+
+// Size of the segments of the benchmarked divider [m]
+const float grid_size = 20.0f;
+
+// Peak resident set size of the process [MB]
+double peakMemoryMB()
+{
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+double elapsedMs(const Clock::time_point & start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void report(const std::string & stage, size_t point_num, size_t byte_num, double time_ms)
+{
+  time_ms = std::max(time_ms, 1e-3);
+
+  std::printf(
+    "%-36s %10lu points in %10.1f[ms], %8.2f Mpoints/s, %8.1f MB/s, peak memory %8.1f[MB]\n",
+    stage.c_str(), point_num, time_ms, point_num / (time_ms * 1e3),
+    byte_num / (time_ms * 1e3), peakMemoryMB());
+}
+
+// Synthetic clouds, in the order a survey would record them:
+//  - uniform: flat ground of the density over a square, in a random order
+//  - corridor: a winding road 30 m wide with walls on both sides, along the road
+//  - urban: 80 m blocks of ground around 30 m high facades, block by block
+CloudT makeCloud(const std::string & distribution, size_t point_num, double density)
+{
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::normal_distribution<float> ground_noise(0.0f, 0.05f);
+  CloudT cloud;
+
+  cloud.reserve(point_num);
+
+  auto push = [&](float x, float y, float z) {
+    PointT p;
+
+    p.x = x;
+    p.y = y;
+    p.z = z;
+    p.intensity = std::floor(unit(engine) * 256.0f);
+    cloud.push_back(p);
+  };
+
+  if (distribution == "corridor") {
+    const double width = 30.0;
+    const double length = point_num / (density * width);
+
+    for (size_t i = 0; i < point_num; ++i) {
+      const double s = length * (i + unit(engine)) / point_num;
+      const double heading = std::atan(0.4 * std::cos(s / 500.0));
+      const double cx = s, cy = 200.0 * std::sin(s / 500.0);
+      const bool wall = unit(engine) < 0.2f;
+      const double u = wall ? (unit(engine) < 0.5f ? -0.5 : 0.5) * width
+                            : (unit(engine) - 0.5) * width;
+      const float z = wall ? unit(engine) * 8.0f : ground_noise(engine);
+
+      push(cx - u * std::sin(heading), cy + u * std::cos(heading), z);
+    }
+  } else if (distribution == "urban") {
+    const double block = 80.0, building = 60.0;
+    const double side = std::sqrt(point_num / density);
+    const size_t blocks_per_side = std::max<size_t>(std::ceil(side / block), 1);
+    const size_t block_num = blocks_per_side * blocks_per_side;
+
+    for (size_t b = 0; b < block_num; ++b) {
+      const double bx = (b % blocks_per_side) * block, by = (b / blocks_per_side) * block;
+      const size_t end = point_num * (b + 1) / block_num;
+
+      while (cloud.size() < end) {
+        if (unit(engine) < 0.5f) {
+          push(bx + unit(engine) * block, by + unit(engine) * block, ground_noise(engine));
+          continue;
+        }
+
+        // A point on the facades of the building in the middle of the block
+        const double margin = (block - building) / 2;
+        const double t = unit(engine) * 4 * building;
+        const int side_id = static_cast<int>(t / building);
+        const double d = t - side_id * building;
+        const double fx = side_id == 0 ? d : (side_id == 1 ? building : (side_id == 2 ? d : 0));
+        const double fy = side_id == 0 ? 0 : (side_id == 1 ? d : (side_id == 2 ? building : d));
+
+        push(bx + margin + fx, by + margin + fy, unit(engine) * 30.0f);
+      }
+    }
+  } else {
+    const double side = std::sqrt(point_num / density);
+
+    for (size_t i = 0; i < point_num; ++i) {
+      push(unit(engine) * side, unit(engine) * side, ground_noise(engine));
+    }
+  }
+
+  return cloud;
+}
+
+void benchmarkWriter(const CloudT & cloud, const std::string & path, bool binary)
+{
+  const auto start = Clock::now();
+
+  // The file is closed when the writer is destroyed
+  {
+    CustomPCDWriter<PointT> writer;
+
+    writer.setOutput(path);
+    writer.writeMetadata(cloud.size(), binary);
+    writer.write(cloud);
+  }
+
+  report(
+    std::string("write ") + (binary ? "binary" : "ascii"), cloud.size(), fs::file_size(path),
+    elapsedMs(start));
+}
+
+void benchmarkReader(const std::string & path, bool binary)
+{
+  CustomPCDReader<PointT> reader;
+  CloudT block;
+  size_t point_num = 0;
+  const auto start = Clock::now();
+
+  reader.setInput(path);
+
+  do {
+    reader.readABlock(block);
+    point_num += block.size();
+  } while (reader.good());
+
+  report(
+    std::string("read ") + (binary ? "binary" : "ascii"), point_num, fs::file_size(path),
+    elapsedMs(start));
+}
+
+// The divider downsamples segment by segment, so the filter is measured on the segments
+void benchmarkVoxelFilter(const CloudT & cloud)
+{
+  std::unordered_map<GridInfo<2>, CloudT> segments;
+
+  for (const auto & p : cloud) {
+    segments[pointToGrid2(p, grid_size, grid_size)].push_back(p);
+  }
+
+  for (auto engine : {VoxelFilterEngine::HASH, VoxelFilterEngine::SORT}) {
+    for (float leaf_size : {0.1f, 0.2f, 0.5f, 1.0f}) {
+      VoxelGridFilter<PointT> vgf;
+      CloudT output;
+      size_t output_num = 0;
+      const auto start = Clock::now();
+
+      vgf.setResolution(leaf_size);
+      vgf.setEngine(engine);
+
+      for (const auto & segment : segments) {
+        output.clear();
+        vgf.filter(segment.second, output);
+        output_num += output.size();
+      }
+
+      char stage[64];
+
+      std::snprintf(
+        stage, sizeof(stage), "voxel %s %.1f[m] (%.1f%% kept)",
+        engine == VoxelFilterEngine::HASH ? "hash" : "sort", leaf_size,
+        100.0 * output_num / std::max<size_t>(cloud.size(), 1));
+      report(stage, cloud.size(), cloud.size() * sizeof(PointT), elapsedMs(start));
+    }
+  }
+}
+
+// Divide the input to @output_dir, and return the elapsed time [ms]. The binning rate is taken
+// from the bin phase of the run report.
+double divide(
+  const std::string & input, const std::string & output_dir, float leaf_size, size_t thread_num,
+  bool in_memory_mode, const std::string & stage)
+{
+  PCDDivider<PointT> divider(rclcpp::get_logger("pointcloud_divider_benchmark"));
+
+  divider.setOutputDir(output_dir);
+  divider.setPrefix("benchmark");
+  divider.setGridSize(grid_size, grid_size);
+  divider.setLeafSize(leaf_size);
+  divider.setDebugMode(false);
+  divider.setThreadNum(thread_num, thread_num);
+  divider.setFinalizeThreadNum(thread_num);
+  divider.setInMemoryMode(in_memory_mode);
+
+  const auto start = Clock::now();
+
+  divider.run({input});
+
+  const double time_ms = elapsedMs(start);
+  const auto bin = divider.getReport().phase("bin");
+
+  report(stage + " bin", bin.points, bin.points * sizeof(PointT), bin.span() * 1e3);
+  report(stage + " total", bin.points, fs::file_size(input), time_ms);
+
+  return time_ms;
+}
+
+// Relative paths of the PCDs of a divided map, without the tmp directory
+std::set<std::string> listTiles(const fs::path & map_dir)
+{
+  std::set<std::string> tiles;
+
+  for (auto it = fs::recursive_directory_iterator(map_dir);
+       it != fs::recursive_directory_iterator(); ++it) {
+    if (it->is_directory() && it->path().filename() == "tmp") {
+      it.disable_recursion_pending();
+    } else if (it->is_regular_file() && it->path().extension() == ".pcd") {
+      tiles.insert(fs::relative(it->path(), map_dir).string());
+    }
+  }
+
+  return tiles;
+}
+
+CloudT readTile(const std::string & path)
+{
+  CustomPCDReader<PointT> reader;
+  CloudT cloud, block;
+
+  reader.setInput(path);
+
+  do {
+    reader.readABlock(block);
+
+    for (const auto & p : block) {
+      cloud.push_back(p);
+    }
+  } while (reader.good());
+
+  return cloud;
+}
+
+// Largest difference of the fields of the points of two clouds of the same size
+double maxDifference(const CloudT & a, const CloudT & b)
+{
+  double max_diff = 0;
+
+  for (size_t i = 0; i < a.size(); ++i) {
+    max_diff = std::max<double>(
+      {max_diff, std::abs(a[i].x - b[i].x), std::abs(a[i].y - b[i].y),
+       std::abs(a[i].z - b[i].z), std::abs(a[i].intensity - b[i].intensity)});
+  }
+
+  return max_diff;
+}
+
+void sortPoints(CloudT & cloud)
+{
+  std::sort(cloud.begin(), cloud.end(), [](const PointT & a, const PointT & b) {
+    return std::tie(a.x, a.y, a.z, a.intensity) < std::tie(b.x, b.y, b.z, b.intensity);
+  });
+}
+
+// Entries of a metadata YAML with their values as text, empty if the file does not exist
+std::map<std::string, std::string> loadMetadata(const fs::path & yaml_path)
+{
+  std::map<std::string, std::string> entries;
+
+  if (!fs::exists(yaml_path)) {
+    return entries;
+  }
+
+  for (const auto & it : YAML::LoadFile(yaml_path.string())) {
+    YAML::Emitter value;
+
+    value << it.second;
+    entries[it.first.as<std::string>()] = value.c_str();
+  }
+
+  return entries;
+}
+
+// Compare the tiles and the metadata of two divided maps. The points of a tile may be in another
+// order, as long as every field matches within @tolerance.
+bool compareMaps(const fs::path & map_a, const fs::path & map_b, double tolerance)
+{
+  const auto tiles_a = listTiles(map_a), tiles_b = listTiles(map_b);
+  size_t diff_num = 0, reordered_num = 0, point_num = 0;
+  double max_diff = 0;
+
+  for (const auto & tile : tiles_a) {
+    if (tiles_b.count(tile) == 0) {
+      std::printf("only in %s: %s\n", map_a.c_str(), tile.c_str());
+      ++diff_num;
+    }
+  }
+
+  for (const auto & tile : tiles_b) {
+    if (tiles_a.count(tile) == 0) {
+      std::printf("only in %s: %s\n", map_b.c_str(), tile.c_str());
+      ++diff_num;
+      continue;
+    }
+
+    auto cloud_a = readTile((map_a / tile).string()), cloud_b = readTile((map_b / tile).string());
+
+    point_num += cloud_a.size();
+
+    if (cloud_a.size() != cloud_b.size()) {
+      std::printf("%s: %lu vs %lu points\n", tile.c_str(), cloud_a.size(), cloud_b.size());
+      ++diff_num;
+      continue;
+    }
+
+    double diff = maxDifference(cloud_a, cloud_b);
+
+    if (diff > tolerance) {
+      sortPoints(cloud_a);
+      sortPoints(cloud_b);
+      diff = maxDifference(cloud_a, cloud_b);
+      ++reordered_num;
+    }
+
+    max_diff = std::max(max_diff, diff);
+
+    if (diff > tolerance) {
+      std::printf("%s: points differ by %g\n", tile.c_str(), diff);
+      ++diff_num;
+    }
+  }
+
+  // The segments listed in the metadata, with their grids
+  const std::string metadata = "pointcloud_map_metadata.yaml";
+
+  if (loadMetadata(map_a / metadata) != loadMetadata(map_b / metadata)) {
+    std::printf("%s differs\n", metadata.c_str());
+    ++diff_num;
+  }
+
+  std::printf(
+    "compared %lu tiles (%lu points), %lu with the points in another order, max difference %g, "
+    "%lu differences\n",
+    tiles_b.size(), point_num, reordered_num, max_diff, diff_num);
+
+  return diff_num == 0;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc > 1 && std::string(argv[1]) == "compare") {
+    if (argc < 4) {
+      std::fprintf(
+        stderr,
+        "usage: pointcloud_divider_benchmark compare <map_dir_a> <map_dir_b> [tolerance]\n");
+      return EXIT_FAILURE;
+    }
+
+    for (int i = 2; i < 4; ++i) {
+      if (!fs::is_directory(argv[i])) {
+        std::fprintf(stderr, "%s is not a directory\n", argv[i]);
+        return EXIT_FAILURE;
+      }
+    }
+
+    const double tolerance = argc > 4 ? std::atof(argv[4]) : 0.0;
+
+    return compareMaps(argv[2], argv[3], tolerance) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  const std::string distribution = argc > 1 ? argv[1] : "corridor";
+  const size_t point_num = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5000000;
+  const double density = argc > 3 ? std::atof(argv[3]) : 100.0;
+  const fs::path work_dir = argc > 4 ? argv[4] : "/tmp/pointcloud_divider_benchmark";
+  const size_t thread_num = std::max(std::thread::hardware_concurrency(), 2u);
+
+  if (
+    (distribution != "uniform" && distribution != "corridor" && distribution != "urban") ||
+    point_num == 0 || density <= 0) {
+    std::fprintf(
+      stderr,
+      "usage: pointcloud_divider_benchmark [uniform|corridor|urban] [point_num] [density] "
+      "[work_dir]\n");
+    return EXIT_FAILURE;
+  }
+
+  // The divider stops when rclcpp is not ok
+  rclcpp::init(argc, argv);
+
+  fs::remove_all(work_dir);
+  fs::create_directories(work_dir);
+
+  std::printf(
+    "%s cloud, %lu points, %.1f points/m2, %lu threads for the parallel runs\n",
+    distribution.c_str(), point_num, density, thread_num);
+
+  const auto cloud = makeCloud(distribution, point_num, density);
+  const std::string binary_pcd = (work_dir / "input_binary.pcd").string();
+  const std::string ascii_pcd = (work_dir / "input_ascii.pcd").string();
+
+  benchmarkWriter(cloud, binary_pcd, true);
+  benchmarkWriter(cloud, ascii_pcd, false);
+  benchmarkReader(binary_pcd, true);
+  benchmarkReader(ascii_pcd, false);
+  benchmarkVoxelFilter(cloud);
+
+  // Binning alone: the points stay in memory and are not downsampled
+  divide(binary_pcd, (work_dir / "bin").string(), -1, 1, true, "divide in memory, sequential");
+
+  // End to end, with the tmp directory. The parallel run must give the same map.
+  const auto seq_dir = work_dir / "sequential", par_dir = work_dir / "parallel";
+
+  divide(binary_pcd, seq_dir.string(), 0.2f, 1, false, "divide 0.2[m], sequential");
+  divide(binary_pcd, par_dir.string(), 0.2f, thread_num, false, "divide 0.2[m], parallel");
+
+  const bool same = compareMaps(seq_dir, par_dir, 0.0);
+
+  rclcpp::shutdown();
+
+  return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
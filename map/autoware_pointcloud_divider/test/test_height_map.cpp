@@ -0,0 +1,204 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/pointcloud_divider/height_map.hpp"
+#include "test_utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using autoware::pointcloud_divider::HeightMap;
+using autoware::pointcloud_divider::HeightMapFormat;
+using autoware::pointcloud_divider::toHeightMapFormat;
+using autoware::pointcloud_divider::test_utils::addFarPoints;
+using autoware::pointcloud_divider::test_utils::expectRejected;
+using autoware::pointcloud_divider::test_utils::far_x;
+using autoware::pointcloud_divider::test_utils::far_y;
+using autoware::pointcloud_divider::test_utils::Point;
+using autoware::pointcloud_divider::test_utils::TempPath;
+
+namespace
+{
+constexpr double origin_x = far_x, origin_y = far_y, segment_size = 20.0, cell_size = 2.0;
+
+// Points of a segment with a few empty cells, some points on the upper borders, outside of the
+// segment, or without z
+std::vector<Point> makeCloud()
+{
+  std::mt19937 rng(13);
+  std::vector<Point> cloud;
+
+  addFarPoints(cloud, 5000, segment_size, -2.0f, 8.0f, rng);
+
+  // Keep the cells of the first column empty
+  cloud.erase(
+    std::remove_if(
+      cloud.begin(), cloud.end(), [](const Point & p) { return p.x < origin_x + cell_size; }),
+    cloud.end());
+
+  cloud.push_back({static_cast<float>(origin_x + segment_size), static_cast<float>(origin_y), 1});
+  cloud.push_back({static_cast<float>(origin_x - 5), static_cast<float>(origin_y + 1), -100});
+  cloud.push_back(
+    {static_cast<float>(origin_x + 3), static_cast<float>(origin_y + 3),
+     std::numeric_limits<float>::quiet_NaN()});
+
+  return cloud;
+}
+
+// The z of the points of each cell, sorted, with the points on the upper borders in the last
+// cells as HeightMap::build counts them
+std::map<std::pair<int, int>, std::vector<float>> bruteForce(const std::vector<Point> & cloud)
+{
+  const int cells = static_cast<int>(segment_size / cell_size);
+  std::map<std::pair<int, int>, std::vector<float>> output;
+
+  for (const auto & p : cloud) {
+    int c = static_cast<int>(std::floor((p.x - origin_x) / cell_size));
+    int r = static_cast<int>(std::floor((p.y - origin_y) / cell_size));
+
+    c = (c == cells) ? c - 1 : c;
+    r = (r == cells) ? r - 1 : r;
+
+    if (c >= 0 && r >= 0 && c < cells && r < cells && std::isfinite(p.z)) {
+      output[{c, r}].push_back(p.z);
+    }
+  }
+
+  for (auto & cell : output) {
+    std::sort(cell.second.begin(), cell.second.end());
+  }
+
+  return output;
+}
+
+// Center of a cell
+std::pair<double, double> center(int c, int r)
+{
+  return {origin_x + (c + 0.5) * cell_size, origin_y + (r + 0.5) * cell_size};
+}
+}  // namespace
+
+TEST(HeightMap, BuildMatchesBruteForce)
+{
+  const auto cloud = makeCloud();
+  const auto expected = bruteForce(cloud);
+  HeightMap map(origin_x, origin_y, segment_size, segment_size, cell_size);
+
+  map.build(cloud);
+  ASSERT_EQ(map.cols(), 10U);
+  ASSERT_EQ(map.rows(), 10U);
+
+  for (int c = 0; c < 10; ++c) {
+    for (int r = 0; r < 10; ++r) {
+      const auto [x, y] = center(c, r);
+      const auto it = expected.find({c, r});
+
+      if (it == expected.end()) {
+        EXPECT_TRUE(std::isnan(map.minHeight(x, y))) << c << " " << r;
+        EXPECT_TRUE(std::isnan(map.medianHeight(x, y))) << c << " " << r;
+        continue;
+      }
+
+      const auto & z = it->second;
+
+      EXPECT_EQ(map.minHeight(x, y), z.front()) << c << " " << r;
+      EXPECT_EQ(map.medianHeight(x, y), z[z.size() / 2]) << c << " " << r;
+    }
+  }
+
+  // Only the cells of the first column are empty
+  EXPECT_EQ(expected.size(), 90U);
+  EXPECT_TRUE(std::isnan(map.minHeight(origin_x - 1, origin_y + 1)));
+  EXPECT_TRUE(std::isnan(map.minHeight(origin_x + 1, origin_y + segment_size + 1)));
+}
+
+TEST(HeightMap, SaveLoadRoundTrip)
+{
+  const TempPath file(".height");
+  HeightMap map(origin_x, origin_y, segment_size, segment_size, cell_size);
+  HeightMap loaded;
+
+  map.build(makeCloud());
+  ASSERT_TRUE(map.save(file.string()));
+  ASSERT_TRUE(loaded.load(file.string()));
+  EXPECT_EQ(loaded.originX(), origin_x);
+  EXPECT_EQ(loaded.originY(), origin_y);
+  EXPECT_EQ(loaded.cellSize(), cell_size);
+  ASSERT_EQ(loaded.size(), map.size());
+
+  for (int c = 0; c < 10; ++c) {
+    for (int r = 0; r < 10; ++r) {
+      const auto [x, y] = center(c, r);
+      const float a = map.medianHeight(x, y), b = loaded.medianHeight(x, y);
+
+      EXPECT_TRUE(a == b || (std::isnan(a) && std::isnan(b)));
+      EXPECT_EQ(std::isnan(loaded.minHeight(x, y)), std::isnan(map.minHeight(x, y)));
+    }
+  }
+
+  expectRejected(file, "PCDHMAP0", [&](const std::string & path) { return loaded.load(path); });
+}
+
+TEST(HeightMap, GeoTIFFLayout)
+{
+  const TempPath file(".tif");
+  HeightMap map(origin_x, origin_y, 6.0, 4.0, cell_size);
+
+  const Point p{static_cast<float>(origin_x + 5), static_cast<float>(origin_y + 3), 4};
+
+  map.build(std::vector<Point>{p});
+  ASSERT_EQ(map.cols(), 3U);
+  ASSERT_EQ(map.rows(), 2U);
+  ASSERT_TRUE(map.saveGeoTIFF(file.string()));
+
+  std::ifstream stream(file.path(), std::ios::binary);
+  const std::vector<char> tiff{std::istreambuf_iterator<char>(stream), {}};
+  uint32_t ifd_offset;
+  float pixel[2];
+
+  ASSERT_GT(tiff.size(), 8U);
+  EXPECT_EQ(std::string(tiff.data(), 4), std::string("II*\0", 4));
+  std::memcpy(&ifd_offset, tiff.data() + 4, sizeof(ifd_offset));
+  EXPECT_EQ(ifd_offset, 8 + map.size() * 2 * sizeof(float));
+
+  // The rows are written from the top, so the upper right cell is the third pixel
+  std::memcpy(pixel, tiff.data() + 8 + 2 * 2 * sizeof(float), sizeof(pixel));
+  EXPECT_EQ(pixel[0], 4.0f);
+  EXPECT_EQ(pixel[1], 4.0f);
+  std::memcpy(pixel, tiff.data() + 8, sizeof(pixel));
+  EXPECT_TRUE(std::isnan(pixel[0]));
+}
+
+TEST(HeightMap, FormatNames)
+{
+  HeightMapFormat format;
+
+  EXPECT_TRUE(toHeightMapFormat("geotiff", format));
+  EXPECT_EQ(format, HeightMapFormat::GEOTIFF);
+  EXPECT_TRUE(toHeightMapFormat("binary", format));
+  EXPECT_EQ(format, HeightMapFormat::BINARY);
+  EXPECT_FALSE(toHeightMapFormat("png", format));
+}
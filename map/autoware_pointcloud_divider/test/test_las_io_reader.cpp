@@ -0,0 +1,226 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/pointcloud_divider/las_io_reader.hpp"
+#include "test_utils.hpp"
+
+#include <gtest/gtest.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using autoware::pointcloud_divider::isLASFile;
+using autoware::pointcloud_divider::LASReader;
+using autoware::pointcloud_divider::test_utils::TempPath;
+
+namespace
+{
+constexpr double scale = 0.001;
+constexpr double offset_x = 89000.0, offset_y = -45000.0, offset_z = 0.0;
+
+// Integer coordinates and attributes of the @i-th point written by writeLAS
+int32_t rawX(size_t i) { return static_cast<int32_t>(340123 + i * 7); }
+int32_t rawY(size_t i) { return static_cast<int32_t>(-678456 - i * 3); }
+int32_t rawZ(size_t i) { return static_cast<int32_t>(i * 11) - 2000; }
+uint16_t rawIntensity(size_t i) { return static_cast<uint16_t>(i * 37); }
+
+template <typename T>
+void put(std::vector<char> & data, size_t pos, T value)
+{
+  memcpy(data.data() + pos, &value, sizeof(value));
+}
+
+// Write to @file a LAS file of @point_num points of the record format 2 (with colors), or 1.4
+// with the 64-bit count, whose records have @extra_bytes after the fields of the format
+void writeLAS(
+  const TempPath & file, size_t point_num, uint8_t version_minor = 2, size_t extra_bytes = 0)
+{
+  const size_t header_size = version_minor >= 4 ? 375 : 227;
+  const size_t record_length = 26 + extra_bytes;
+  std::vector<char> data(header_size + point_num * record_length, 0);
+
+  memcpy(data.data(), "LASF", 4);
+  put<uint8_t>(data, 24, 1);
+  put<uint8_t>(data, 25, version_minor);
+  put<uint16_t>(data, 94, header_size);
+  put<uint32_t>(data, 96, header_size);
+  put<uint8_t>(data, 104, 2);
+  put<uint16_t>(data, 105, record_length);
+  put<uint32_t>(data, 107, version_minor >= 4 ? 0 : point_num);
+
+  for (size_t axis = 0; axis < 3; ++axis) {
+    put<double>(data, 131 + axis * 8, scale);
+  }
+
+  put<double>(data, 155, offset_x);
+  put<double>(data, 163, offset_y);
+  put<double>(data, 171, offset_z);
+
+  if (version_minor >= 4) {
+    put<uint64_t>(data, 247, point_num);
+  }
+
+  for (size_t i = 0; i < point_num; ++i) {
+    const size_t record = header_size + i * record_length;
+
+    put<int32_t>(data, record, rawX(i));
+    put<int32_t>(data, record + 4, rawY(i));
+    put<int32_t>(data, record + 8, rawZ(i));
+    put<uint16_t>(data, record + 12, rawIntensity(i));
+    put<uint16_t>(data, record + 20, static_cast<uint16_t>(0xAB00 + i));
+    put<uint16_t>(data, record + 22, 0x1234);
+    put<uint16_t>(data, record + 24, 0xFFFF);
+  }
+
+  std::ofstream(file.path(), std::ios::binary).write(data.data(), data.size());
+}
+
+template <typename PointT>
+void expectPoint(const PointT & p, size_t i)
+{
+  EXPECT_FLOAT_EQ(p.x, static_cast<float>(rawX(i) * scale + offset_x)) << "point " << i;
+  EXPECT_FLOAT_EQ(p.y, static_cast<float>(rawY(i) * scale + offset_y)) << "point " << i;
+  EXPECT_FLOAT_EQ(p.z, static_cast<float>(rawZ(i) * scale + offset_z)) << "point " << i;
+}
+}  // namespace
+
+TEST(LASReader, ReadsBlocks)
+{
+  const TempPath file(".las");
+  LASReader<pcl::PointXYZI> reader;
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  size_t read_num = 0;
+
+  writeLAS(file, 1000);
+  reader.setInput(file.string());
+  reader.setBlockSize(300);
+  ASSERT_TRUE(reader.supportsRange());
+  ASSERT_EQ(reader.point_num(), 1000U);
+
+  while (reader.good()) {
+    const size_t read_size = reader.readABlock(cloud);
+
+    EXPECT_EQ(read_size, cloud.size() * 26);
+
+    for (size_t i = 0; i < cloud.size(); ++i) {
+      expectPoint(cloud[i], read_num + i);
+      EXPECT_EQ(cloud[i].intensity, rawIntensity(read_num + i));
+    }
+
+    read_num += cloud.size();
+  }
+
+  EXPECT_EQ(read_num, 1000U);
+}
+
+TEST(LASReader, ReadsRangesAndColors)
+{
+  const TempPath file(".las");
+  LASReader<pcl::PointXYZRGB> reader;
+  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+
+  writeLAS(file, 500);
+  reader.setInput(file.string());
+  reader.setRange(120, 130);
+  ASSERT_TRUE(reader.good());
+  reader.readABlock(cloud);
+  ASSERT_EQ(cloud.size(), 10U);
+  EXPECT_FALSE(reader.good());
+
+  for (size_t i = 0; i < cloud.size(); ++i) {
+    uint32_t rgb;
+
+    memcpy(&rgb, &cloud[i].rgb, sizeof(rgb));
+    expectPoint(cloud[i], 120 + i);
+    // The 16-bit colors are reduced to their upper bytes
+    EXPECT_EQ(rgb, 0xFFAB12FFU) << "point " << i;
+  }
+
+  // An empty range
+  reader.setRange(600, 700);
+  EXPECT_FALSE(reader.good());
+}
+
+TEST(LASReader, ReadsVersion14AndExtraBytes)
+{
+  const TempPath file(".las");
+  LASReader<pcl::PointXYZ> reader;
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+
+  writeLAS(file, 50, 4, 6);
+  reader.setInput(file.string());
+  ASSERT_EQ(reader.point_num(), 50U);
+  reader.readABlock(cloud);
+  ASSERT_EQ(cloud.size(), 50U);
+  expectPoint(cloud[0], 0);
+  expectPoint(cloud[49], 49);
+}
+
+TEST(LASReader, IgnoresTruncatedPoints)
+{
+  const TempPath file(".las");
+
+  writeLAS(file, 100);
+  std::filesystem::resize_file(file.path(), 227 + 40 * 26 + 10);
+
+  LASReader<pcl::PointXYZI> reader;
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+
+  reader.setInput(file.string());
+  EXPECT_EQ(reader.point_num(), 40U);
+  reader.readABlock(cloud);
+  ASSERT_EQ(cloud.size(), 40U);
+  expectPoint(cloud[39], 39);
+}
+
+TEST(LASReader, StreamsLAZThroughTheCommand)
+{
+  // A LAS file named as a LAZ file, "decompressed" by cat, with a quote in its name
+  const TempPath file("'s.laz");
+  LASReader<pcl::PointXYZI> reader;
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  size_t read_num = 0;
+
+  writeLAS(file, 700);
+  reader.setInput(file.string());
+  reader.setLAZCommand("cat {file}");
+  reader.setBlockSize(256);
+  EXPECT_FALSE(reader.supportsRange());
+  ASSERT_EQ(reader.point_num(), 700U);
+
+  while (reader.good()) {
+    reader.readABlock(cloud);
+
+    for (size_t i = 0; i < cloud.size(); ++i) {
+      expectPoint(cloud[i], read_num + i);
+    }
+
+    read_num += cloud.size();
+  }
+
+  EXPECT_EQ(read_num, 700U);
+}
+
+TEST(LASReader, Extensions)
+{
+  EXPECT_TRUE(isLASFile("map.las"));
+  EXPECT_TRUE(isLASFile("dir.d/map.LAZ"));
+  EXPECT_FALSE(isLASFile("map.pcd"));
+  EXPECT_FALSE(isLASFile("las"));
+}
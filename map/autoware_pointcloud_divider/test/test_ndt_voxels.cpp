@@ -0,0 +1,180 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/pointcloud_divider/ndt_voxels.hpp"
+#include "test_utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using autoware::pointcloud_divider::NDTVoxel;
+using autoware::pointcloud_divider::NDTVoxelGrid;
+using autoware::pointcloud_divider::test_utils::addFarPoints;
+using autoware::pointcloud_divider::test_utils::expectRejected;
+using autoware::pointcloud_divider::test_utils::Point;
+using autoware::pointcloud_divider::test_utils::TempPath;
+
+namespace
+{
+using VoxelIndex = std::tuple<int32_t, int32_t, int32_t>;
+
+// Points far from the origin, so the moments lose precision if they are not centered
+std::vector<Point> makeCloud(size_t point_num)
+{
+  std::mt19937 rng(17);
+  std::vector<Point> cloud;
+
+  addFarPoints(cloud, point_num, 8.0f, -2.0f, 6.0f, rng);
+  cloud.push_back({std::numeric_limits<float>::quiet_NaN(), 0.0f, 0.0f});
+
+  return cloud;
+}
+
+// Two pass mean and sample covariance of the points of each voxel
+std::map<VoxelIndex, std::vector<Point>> bruteForce(
+  const std::vector<Point> & cloud, double resolution)
+{
+  std::map<VoxelIndex, std::vector<Point>> output;
+
+  for (const auto & p : cloud) {
+    if (!std::isfinite(p.x)) {
+      continue;
+    }
+
+    const VoxelIndex index{
+      static_cast<int32_t>(std::floor(p.x / resolution)),
+      static_cast<int32_t>(std::floor(p.y / resolution)),
+      static_cast<int32_t>(std::floor(p.z / resolution))};
+
+    output[index].push_back(p);
+  }
+
+  return output;
+}
+
+void expectMoments(const NDTVoxel & voxel, const std::vector<Point> & points)
+{
+  const double n = points.size();
+  std::array<double, 3> mean{0, 0, 0};
+
+  for (const auto & p : points) {
+    mean[0] += p.x / n;
+    mean[1] += p.y / n;
+    mean[2] += p.z / n;
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(voxel.mean[i], mean[i], 1e-6);
+  }
+
+  for (int i = 0, k = 0; i < 3; ++i) {
+    for (int j = i; j < 3; ++j, ++k) {
+      double cov = 0;
+
+      for (const auto & p : points) {
+        const double d[3] = {p.x - mean[0], p.y - mean[1], p.z - mean[2]};
+
+        cov += d[i] * d[j] / (n - 1);
+      }
+
+      EXPECT_NEAR(voxel.cov[k], cov, 1e-5);
+    }
+  }
+}
+}  // namespace
+
+TEST(NDTVoxels, MomentsMatchBruteForce)
+{
+  const double resolution = 2.0;
+  const auto cloud = makeCloud(20000);
+  const auto expected = bruteForce(cloud, resolution);
+  NDTVoxelGrid grid(resolution, 6);
+
+  // The segment is added in two blocks
+  grid.add(std::vector<Point>(cloud.begin(), cloud.begin() + cloud.size() / 2));
+  grid.add(std::vector<Point>(cloud.begin() + cloud.size() / 2, cloud.end()));
+  EXPECT_EQ(grid.size(), expected.size());
+
+  const auto voxels = grid.voxels();
+  size_t dense_num = 0;
+
+  for (const auto & it : expected) {
+    dense_num += it.second.size() >= 6;
+  }
+
+  ASSERT_EQ(voxels.size(), dense_num);
+
+  for (size_t i = 0; i < voxels.size(); ++i) {
+    const auto & voxel = voxels[i];
+    const auto it = expected.find({voxel.ix, voxel.iy, voxel.iz});
+
+    ASSERT_NE(it, expected.end());
+    EXPECT_EQ(voxel.point_num, it->second.size());
+    expectMoments(voxel, it->second);
+
+    if (i > 0) {
+      const auto & prev = voxels[i - 1];
+
+      EXPECT_LT(std::tie(prev.iz, prev.iy, prev.ix), std::tie(voxel.iz, voxel.iy, voxel.ix));
+    }
+  }
+}
+
+TEST(NDTVoxels, SparseVoxelsAreSkipped)
+{
+  NDTVoxelGrid grid(1.0, 3);
+
+  grid.add(std::vector<Point>{{0.5f, 0.5f, 0.5f}, {0.6f, 0.5f, 0.5f}, {-0.5f, 0.5f, 0.5f}});
+  EXPECT_EQ(grid.size(), 2U);
+  EXPECT_TRUE(grid.voxels().empty());
+
+  grid.add(std::vector<Point>{{0.7f, 0.5f, 0.5f}});
+  ASSERT_EQ(grid.voxels().size(), 1U);
+  EXPECT_EQ(grid.voxels()[0].ix, 0);
+  EXPECT_EQ(grid.voxels()[0].point_num, 3U);
+
+  grid.clear();
+  EXPECT_EQ(grid.size(), 0U);
+}
+
+TEST(NDTVoxels, SaveLoadRoundTrip)
+{
+  const TempPath file(".ndt");
+  NDTVoxelGrid grid(2.0, 6);
+  std::vector<NDTVoxel> loaded;
+  double resolution = 0;
+
+  grid.add(makeCloud(5000));
+  ASSERT_TRUE(grid.save(file.string()));
+  ASSERT_TRUE(NDTVoxelGrid::load(file.string(), resolution, loaded));
+  EXPECT_EQ(resolution, 2.0);
+
+  const auto voxels = grid.voxels();
+
+  ASSERT_EQ(loaded.size(), voxels.size());
+  EXPECT_EQ(memcmp(loaded.data(), voxels.data(), voxels.size() * sizeof(NDTVoxel)), 0);
+
+  expectRejected(file, "PCDNDTV0", [&](const std::string & path) {
+    return NDTVoxelGrid::load(path, resolution, loaded);
+  });
+}
@@ -0,0 +1,258 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/pointcloud_divider/partition_plan.hpp"
+#include "test_utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using autoware::pointcloud_divider::GridInfo;
+using autoware::pointcloud_divider::mergePartitions;
+using autoware::pointcloud_divider::mortonCode;
+using autoware::pointcloud_divider::OutputSink;
+using autoware::pointcloud_divider::PartitionPlan;
+using autoware::pointcloud_divider::TileIndex;
+using autoware::pointcloud_divider::TileRecord;
+using autoware::pointcloud_divider::test_utils::expectRejected;
+using autoware::pointcloud_divider::test_utils::TempPath;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// Sink recording the keys published, and where the flushes happened
+class RecordingSink : public OutputSink
+{
+public:
+  void publish(const std::string &, const std::string & key) override { keys.push_back(key); }
+
+  bool flush() override
+  {
+    keys.push_back("<flush>");
+    return true;
+  }
+
+  std::vector<std::string> keys;
+};
+
+std::unordered_map<GridInfo<2>, size_t> makeCells()
+{
+  std::mt19937 rng(19);
+  std::unordered_map<GridInfo<2>, size_t> cell_points;
+
+  for (int x = -6; x < 6; ++x) {
+    for (int y = -4; y < 4; ++y) {
+      cell_points[GridInfo<2>(x, y)] = 1000 + rng() % 5000;
+    }
+  }
+
+  return cell_points;
+}
+
+// Output of a worker with the segment @segment and a tile index, run with @signature
+void writeWorker(
+  const fs::path & dir, const std::string & segment, int32_t ix, const std::string & signature,
+  const std::string & header = "x_resolution: 20\ny_resolution: 20\n")
+{
+  fs::create_directories(dir / "pointcloud_map.pcd");
+  std::ofstream(dir / "pointcloud_map.pcd" / segment) << segment;
+  std::ofstream(dir / "pointcloud_map_metadata.yaml") << header << segment << ": [" << ix
+                                                      << ", 0]\n";
+  std::ofstream(dir / "pointcloud_map_partition.yaml") << "worker: 0\nsignature: " << signature
+                                                       << "\n";
+
+  TileRecord tile{};
+
+  tile.ix = ix;
+  TileIndex(20, 20, "pointcloud_map", {tile}).save((dir / "pointcloud_map_index.bin").string());
+}
+}  // namespace
+
+TEST(PartitionPlan, AssignBalancesRunsOfTheMortonCurve)
+{
+  const auto cell_points = makeCells();
+  PartitionPlan plan;
+  size_t total_point_num = 0;
+
+  for (const auto & cell : cell_points) {
+    total_point_num += cell.second;
+  }
+
+  plan.assign(cell_points, 4);
+  ASSERT_EQ(plan.workers.size(), 4U);
+
+  std::unordered_set<GridInfo<2>> assigned;
+  uint64_t last_code = 0;
+
+  for (size_t w = 0; w < plan.workers.size(); ++w) {
+    const auto & worker = plan.workers[w];
+    size_t point_num = 0;
+
+    ASSERT_FALSE(worker.cells.empty());
+
+    for (const auto & cell : worker.cells) {
+      const uint64_t code = mortonCode(cell.ix, cell.iy);
+
+      // The workers take consecutive runs of the curve
+      EXPECT_TRUE(assigned.empty() || code > last_code);
+      EXPECT_TRUE(assigned.insert(cell).second);
+      last_code = code;
+      point_num += cell_points.at(cell);
+    }
+
+    EXPECT_EQ(worker.point_num, point_num);
+    // Each worker stops at the first grid past its share
+    EXPECT_LT(point_num, total_point_num / 4 + 6000);
+  }
+
+  EXPECT_EQ(assigned.size(), cell_points.size());
+}
+
+TEST(PartitionPlan, AssignLeavesAGridToEachWorker)
+{
+  std::unordered_map<GridInfo<2>, size_t> cell_points;
+
+  cell_points[GridInfo<2>(0, 0)] = 1000000;
+  cell_points[GridInfo<2>(1, 0)] = 1;
+  cell_points[GridInfo<2>(0, 1)] = 1;
+
+  PartitionPlan plan;
+
+  plan.assign(cell_points, 3);
+
+  for (const auto & worker : plan.workers) {
+    EXPECT_EQ(worker.cells.size(), 1U);
+  }
+
+  // More workers than grids
+  plan.assign(cell_points, 5);
+  EXPECT_EQ(plan.workers.size(), 5U);
+  EXPECT_TRUE(plan.workers[4].cells.empty());
+}
+
+TEST(PartitionPlan, WorkerInputsAndSaveLoad)
+{
+  const TempPath file(".yaml");
+  PartitionPlan plan, loaded;
+
+  plan.g_grid_size_x = plan.g_grid_size_y = 100.0;
+  plan.workers.resize(2);
+  plan.workers[0].cells = {GridInfo<2>(0, 0), GridInfo<2>(1, 0)};
+  plan.workers[0].point_num = 10;
+  plan.workers[1].cells = {GridInfo<2>(5, 5)};
+  plan.inputs = {
+    {"a.pcd", {GridInfo<2>(0, 0)}},
+    {"b.pcd", {GridInfo<2>(2, 1)}},
+    {"c.pcd", {GridInfo<2>(5, 5), GridInfo<2>(1, 0)}},
+    {"d.pcd", {GridInfo<2>(9, 9)}}};
+
+  EXPECT_EQ(plan.workerInputs(0), (std::vector<std::string>{"a.pcd", "c.pcd"}));
+  // The inputs of the halo of the grids are read for the outlier removal
+  EXPECT_EQ(plan.workerInputs(0, true), (std::vector<std::string>{"a.pcd", "b.pcd", "c.pcd"}));
+  EXPECT_EQ(plan.workerInputs(1), (std::vector<std::string>{"c.pcd"}));
+  EXPECT_TRUE(plan.workerInputs(2).empty());
+
+  ASSERT_TRUE(plan.save(file.string()));
+  ASSERT_TRUE(loaded.load(file.string()));
+  EXPECT_EQ(loaded.g_grid_size_x, 100.0);
+  ASSERT_EQ(loaded.workers.size(), 2U);
+  EXPECT_EQ(loaded.workers[0].cells, plan.workers[0].cells);
+  EXPECT_EQ(loaded.workers[0].point_num, 10U);
+  ASSERT_EQ(loaded.inputs.size(), 4U);
+  EXPECT_EQ(loaded.inputs[2].path, "c.pcd");
+  EXPECT_EQ(loaded.inputs[2].cells, plan.inputs[2].cells);
+
+  expectRejected(file, "workers: 3\n", [&](const std::string & path) { return loaded.load(path); });
+}
+
+TEST(PartitionPlan, MergePublishesTheSegmentsFirst)
+{
+  const TempPath root_dir;
+  const auto & root = root_dir.path();
+  RecordingSink sink;
+  std::string error;
+
+  writeWorker(root / "w0", "pointcloud_map_0_0.pcd", 0, "same");
+  writeWorker(root / "w1", "pointcloud_map_20_0.pcd", 20, "same");
+
+  ASSERT_TRUE(mergePartitions(
+    {(root / "w0").string(), (root / "w1").string()}, (root / "out").string(), sink, error))
+    << error;
+
+  EXPECT_TRUE(fs::exists(root / "out/pointcloud_map.pcd/pointcloud_map_0_0.pcd"));
+  EXPECT_TRUE(fs::exists(root / "out/pointcloud_map.pcd/pointcloud_map_20_0.pcd"));
+  EXPECT_FALSE(fs::exists(root / "w0/pointcloud_map.pcd/pointcloud_map_0_0.pcd"));
+
+  const std::vector<std::string> expected_keys = {
+    "pointcloud_map.pcd/pointcloud_map_0_0.pcd", "pointcloud_map.pcd/pointcloud_map_20_0.pcd",
+    "<flush>", "pointcloud_map_metadata.yaml", "pointcloud_map_index.bin", "<flush>"};
+
+  EXPECT_EQ(sink.keys, expected_keys);
+
+  std::ifstream metadata(root / "out/pointcloud_map_metadata.yaml");
+  const std::string text{std::istreambuf_iterator<char>(metadata), {}};
+
+  EXPECT_EQ(
+    text,
+    "x_resolution: 20\ny_resolution: 20\npointcloud_map_0_0.pcd: [0, 0]\n"
+    "pointcloud_map_20_0.pcd: [20, 0]\n");
+
+  TileIndex index;
+
+  ASSERT_TRUE(index.load((root / "out/pointcloud_map_index.bin").string()));
+  EXPECT_EQ(index.tiles().size(), 2U);
+  EXPECT_EQ(index.query(0, 0, 39, 19).size(), 2U);
+}
+
+TEST(PartitionPlan, MergeRejectsOtherMaps)
+{
+  const TempPath root_dir;
+  const auto & root = root_dir.path();
+  const std::vector<std::string> workers = {(root / "w0").string(), (root / "w1").string()};
+  RecordingSink sink;
+  std::string error;
+
+  // Workers run with other parameters
+  writeWorker(root / "w0", "pointcloud_map_0_0.pcd", 0, "same");
+  writeWorker(root / "w1", "pointcloud_map_20_0.pcd", 20, "other");
+  EXPECT_FALSE(mergePartitions(workers, (root / "out").string(), sink, error));
+  EXPECT_NE(error.find("parameters"), std::string::npos);
+  // Nothing is moved before the workers are checked
+  EXPECT_TRUE(fs::exists(root / "w0/pointcloud_map.pcd/pointcloud_map_0_0.pcd"));
+  EXPECT_TRUE(sink.keys.empty());
+
+  // Workers writing other metadata headers
+  fs::remove_all(root);
+  writeWorker(root / "w0", "pointcloud_map_0_0.pcd", 0, "same");
+  writeWorker(
+    root / "w1", "pointcloud_map_20_0.pcd", 20, "same", "x_resolution: 10\ny_resolution: 20\n");
+  EXPECT_FALSE(mergePartitions(workers, (root / "out").string(), sink, error));
+  EXPECT_NE(error.find("header"), std::string::npos);
+
+  // A worker without its partition info
+  fs::remove(root / "w1/pointcloud_map_partition.yaml");
+  EXPECT_FALSE(mergePartitions(workers, (root / "out").string(), sink, error));
+  EXPECT_NE(error.find("Cannot find"), std::string::npos);
+  EXPECT_TRUE(sink.keys.empty());
+}
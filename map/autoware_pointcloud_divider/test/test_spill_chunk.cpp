@@ -0,0 +1,224 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/pointcloud_divider/grid_info.hpp"
+#include "autoware/pointcloud_divider/spill_chunk.hpp"
+#include "test_utils.hpp"
+
+#include <gtest/gtest.h>
+#include <pcl/point_types.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using autoware::pointcloud_divider::AsyncIOOptions;
+using autoware::pointcloud_divider::decodeSpillChunk;
+using autoware::pointcloud_divider::encodeSpillChunk;
+using autoware::pointcloud_divider::readSpillFile;
+using autoware::pointcloud_divider::SPILL_CHUNK_LZF;
+using autoware::pointcloud_divider::SPILL_CHUNK_QUANTIZED;
+using autoware::pointcloud_divider::SpillChunkHeader;
+using autoware::pointcloud_divider::writeSpillFile;
+using autoware::pointcloud_divider::test_utils::addFarPoints;
+using autoware::pointcloud_divider::test_utils::TempPath;
+
+namespace
+{
+using Cloud = pcl::PointCloud<pcl::PointXYZI>;
+
+// Points in a segment far from the origin, a quarter of them exactly on the borders of the
+// voxels of @leaf_size or next to them, where the quantization may move a point across
+Cloud makeCloud(size_t point_num, float extent, float leaf_size)
+{
+  std::mt19937 rng(7);
+  Cloud cloud;
+
+  addFarPoints(cloud, point_num, extent, -5.0f, 30.0f, rng);
+
+  for (size_t i = 0; i < cloud.size(); ++i) {
+    auto & p = cloud[i];
+
+    if (i % 4 == 0) {
+      p.x = std::floor(p.x / leaf_size) * leaf_size;
+      p.y = std::nextafter(std::floor(p.y / leaf_size) * leaf_size, 0.0f);
+      p.z = std::nextafter(std::floor(p.z / leaf_size) * leaf_size, 100.0f);
+    }
+
+    p.intensity = static_cast<float>(i % 256);
+  }
+
+  return cloud;
+}
+
+SpillChunkHeader header(const std::vector<char> & buffer)
+{
+  SpillChunkHeader h;
+  std::memcpy(&h, buffer.data(), sizeof(h));
+  return h;
+}
+
+void expectSame(const Cloud & expected, const Cloud & actual)
+{
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(actual[i].x, expected[i].x);
+    EXPECT_EQ(actual[i].y, expected[i].y);
+    EXPECT_EQ(actual[i].z, expected[i].z);
+    EXPECT_EQ(actual[i].intensity, expected[i].intensity);
+  }
+}
+}  // namespace
+
+TEST(SpillChunk, FloatRoundTrip)
+{
+  const Cloud cloud = makeCloud(1000, 20.0f, 0.1f);
+
+  for (bool compress : {false, true}) {
+    std::vector<char> buffer;
+    Cloud decoded;
+
+    encodeSpillChunk(cloud, 0.0, compress, buffer);
+    EXPECT_FALSE(header(buffer).flags & SPILL_CHUNK_QUANTIZED);
+    ASSERT_TRUE(decodeSpillChunk(buffer, decoded));
+    expectSame(cloud, decoded);
+  }
+}
+
+TEST(SpillChunk, QuantizedKeepsVoxels)
+{
+  const float leaf_size = 0.1f;
+  const Cloud cloud = makeCloud(20000, 20.0f, leaf_size);
+  std::vector<char> plain, compressed;
+  Cloud decoded, decompressed;
+
+  encodeSpillChunk(cloud, leaf_size, false, plain);
+  encodeSpillChunk(cloud, leaf_size, true, compressed);
+
+  const auto h = header(plain);
+  ASSERT_TRUE(h.flags & SPILL_CHUNK_QUANTIZED);
+  EXPECT_FALSE(h.flags & SPILL_CHUNK_LZF);
+  EXPECT_LE(compressed.size(), plain.size());
+  EXPECT_LT(plain.size(), cloud.size() * 4 * sizeof(float));
+
+  ASSERT_TRUE(decodeSpillChunk(plain, decoded));
+  ASSERT_TRUE(decodeSpillChunk(compressed, decompressed));
+  expectSame(decoded, decompressed);
+  ASSERT_EQ(decoded.size(), cloud.size());
+
+  for (size_t i = 0; i < cloud.size(); ++i) {
+    const auto & p = cloud[i];
+    const auto & q = decoded[i];
+
+    EXPECT_EQ(
+      pointToGrid3(p, leaf_size, leaf_size, leaf_size),
+      pointToGrid3(q, leaf_size, leaf_size, leaf_size))
+      << "point " << i;
+    EXPECT_LE(std::abs(q.x - p.x), 1.5 * h.step[0] + 1e-3);
+    EXPECT_LE(std::abs(q.y - p.y), 1.5 * h.step[1] + 1e-3);
+    EXPECT_LE(std::abs(q.z - p.z), 1.5 * h.step[2] + 1e-6);
+    EXPECT_EQ(q.intensity, p.intensity);
+  }
+}
+
+TEST(SpillChunk, CompressedRoundTrip)
+{
+  // Points at the origin, whose columns are zeros and compress well
+  Cloud cloud;
+  pcl::PointXYZI p;
+
+  p.x = p.y = p.z = p.intensity = 0.0f;
+
+  for (size_t i = 0; i < 4096; ++i) {
+    cloud.push_back(p);
+  }
+
+  for (double leaf_size : {0.0, 0.1}) {
+    std::vector<char> buffer;
+    Cloud decoded;
+
+    encodeSpillChunk(cloud, leaf_size, true, buffer);
+    EXPECT_TRUE(header(buffer).flags & SPILL_CHUNK_LZF);
+    EXPECT_LT(buffer.size(), cloud.size() * sizeof(float));
+    ASSERT_TRUE(decodeSpillChunk(buffer, decoded));
+    ASSERT_EQ(decoded.size(), cloud.size());
+
+    if (leaf_size == 0.0) {
+      expectSame(cloud, decoded);
+    }
+
+    EXPECT_EQ(decoded[4095].intensity, p.intensity);
+    EXPECT_NEAR(decoded[4095].x, p.x, leaf_size);
+  }
+}
+
+TEST(SpillChunk, WideChunkKeepsFloats)
+{
+  // 10 km spans more than 65536 leaf sizes of 0.1 m, so the coordinates cannot be uint16
+  const Cloud cloud = makeCloud(1000, 10000.0f, 0.1f);
+  std::vector<char> buffer;
+  Cloud decoded;
+
+  encodeSpillChunk(cloud, 0.1, true, buffer);
+  EXPECT_FALSE(header(buffer).flags & SPILL_CHUNK_QUANTIZED);
+  ASSERT_TRUE(decodeSpillChunk(buffer, decoded));
+  expectSame(cloud, decoded);
+}
+
+TEST(SpillChunk, EmptyAndInvalidChunks)
+{
+  std::vector<char> buffer;
+  Cloud decoded = makeCloud(10, 1.0f, 0.1f);
+
+  encodeSpillChunk(Cloud(), 0.1, true, buffer);
+  ASSERT_TRUE(decodeSpillChunk(buffer, decoded));
+  EXPECT_TRUE(decoded.empty());
+
+  encodeSpillChunk(makeCloud(100, 1.0f, 0.1f), 0.1, false, buffer);
+  std::vector<char> truncated(buffer.begin(), buffer.end() - 1);
+  EXPECT_FALSE(decodeSpillChunk(truncated, decoded));
+  std::vector<char> corrupted = buffer;
+  corrupted[0] = 'X';
+  EXPECT_FALSE(decodeSpillChunk(corrupted, decoded));
+  // The chunk of another point type has a different number of fields
+  pcl::PointCloud<pcl::PointXYZ> xyz;
+  EXPECT_FALSE(decodeSpillChunk(buffer, xyz));
+}
+
+TEST(SpillChunk, FileRoundTrip)
+{
+  const TempPath file(".spill");
+  const Cloud cloud = makeCloud(5000, 20.0f, 0.1f);
+  std::vector<char> buffer;
+
+  encodeSpillChunk(cloud, 0.1, true, buffer);
+
+  // A queue depth of 0 uses the streams, otherwise io_uring if the kernel supports it. The
+  // files are written and read twice, so the rings of the thread are reused.
+  for (size_t queue_depth : {0, 4, 4}) {
+    AsyncIOOptions options;
+    std::vector<char> read;
+    Cloud decoded;
+
+    options.queue_depth = queue_depth;
+    options.chunk_size = 1 << 12;
+    ASSERT_TRUE(writeSpillFile(file.string(), buffer, options));
+    ASSERT_TRUE(readSpillFile(file.string(), read, options));
+    EXPECT_EQ(read, buffer);
+    ASSERT_TRUE(decodeSpillChunk(read, decoded));
+    EXPECT_EQ(decoded.size(), cloud.size());
+  }
+}
@@ -0,0 +1,231 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/pointcloud_divider/tile_index.hpp"
+#include "test_utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using autoware::pointcloud_divider::crc32;
+using autoware::pointcloud_divider::mortonBigMin;
+using autoware::pointcloud_divider::mortonCode;
+using autoware::pointcloud_divider::mortonDecode;
+using autoware::pointcloud_divider::TILE_NDT_VOXELS;
+using autoware::pointcloud_divider::TileIndex;
+using autoware::pointcloud_divider::TileRecord;
+using autoware::pointcloud_divider::test_utils::expectRejected;
+using autoware::pointcloud_divider::test_utils::TempPath;
+
+namespace
+{
+constexpr double grid_size = 50.0;
+
+// Tiles on half of the grids of [-range, range)^2, with their corners in meters as in the
+// metadata YAML
+std::vector<TileRecord> makeTiles(int32_t range)
+{
+  std::mt19937 rng(11);
+  std::vector<TileRecord> tiles;
+
+  for (int32_t gx = -range; gx < range; ++gx) {
+    for (int32_t gy = -range; gy < range; ++gy) {
+      if (rng() % 2 == 0) {
+        continue;
+      }
+
+      TileRecord tile{};
+
+      tile.ix = static_cast<int32_t>(gx * grid_size);
+      tile.iy = static_cast<int32_t>(gy * grid_size);
+      tile.point_num = rng() % 100000;
+      tile.z_min = -1.0f;
+      tile.z_max = static_cast<float>(rng() % 50);
+      tile.byte_size = tile.point_num * 16;
+      tile.checksum = rng();
+      tile.flags = (rng() % 2) ? TILE_NDT_VOXELS : 0;
+      tiles.push_back(tile);
+    }
+  }
+
+  return tiles;
+}
+
+std::set<std::pair<int32_t, int32_t>> corners(const std::vector<TileRecord> & tiles)
+{
+  std::set<std::pair<int32_t, int32_t>> output;
+
+  for (const auto & tile : tiles) {
+    output.emplace(tile.ix, tile.iy);
+  }
+
+  return output;
+}
+}  // namespace
+
+TEST(TileIndex, MortonCodeRoundTrip)
+{
+  for (int32_t gx : {-2147483647 - 1, -70000, -1, 0, 1, 12345, 2147483647}) {
+    for (int32_t gy : {-2147483647 - 1, -3, 0, 7, 65536, 2147483647}) {
+      int32_t x, y;
+
+      mortonDecode(mortonCode(gx, gy), x, y);
+      EXPECT_EQ(x, gx);
+      EXPECT_EQ(y, gy);
+    }
+  }
+
+  // The order of the codes follows the order of the signed indices on each axis
+  EXPECT_LT(mortonCode(-1, 0), mortonCode(0, 0));
+  EXPECT_LT(mortonCode(0, -1), mortonCode(0, 0));
+  EXPECT_LT(mortonCode(-5, -5), mortonCode(4, 4));
+}
+
+TEST(TileIndex, BigMinMatchesBruteForce)
+{
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int32_t> index(-20, 20);
+
+  for (int trial = 0; trial < 200; ++trial) {
+    int32_t x0 = index(rng), x1 = index(rng), y0 = index(rng), y1 = index(rng);
+
+    if (x0 > x1) {
+      std::swap(x0, x1);
+    }
+    if (y0 > y1) {
+      std::swap(y0, y1);
+    }
+
+    const uint64_t zmin = mortonCode(x0, y0), zmax = mortonCode(x1, y1);
+    std::set<uint64_t> box;
+
+    for (int32_t gx = x0; gx <= x1; ++gx) {
+      for (int32_t gy = y0; gy <= y1; ++gy) {
+        box.insert(mortonCode(gx, gy));
+      }
+    }
+
+    // Every code outside the box between the corners jumps to the next code in the box
+    for (int32_t gx = -21; gx <= 21; ++gx) {
+      for (int32_t gy = -21; gy <= 21; ++gy) {
+        const uint64_t code = mortonCode(gx, gy);
+
+        if (code < zmin || code > zmax || box.count(code)) {
+          continue;
+        }
+
+        const auto next = box.upper_bound(code);
+
+        ASSERT_NE(next, box.end());
+        EXPECT_EQ(mortonBigMin(code, zmin, zmax), *next) << gx << " " << gy;
+      }
+    }
+  }
+}
+
+TEST(TileIndex, SaveLoadRoundTrip)
+{
+  const TempPath file(".bin");
+  const TileIndex index(grid_size, grid_size, "map", makeTiles(8));
+  TileIndex loaded;
+
+  ASSERT_TRUE(index.save(file.string()));
+  ASSERT_TRUE(loaded.load(file.string()));
+  EXPECT_EQ(loaded.gridSizeX(), grid_size);
+  EXPECT_EQ(loaded.gridSizeY(), grid_size);
+  EXPECT_EQ(loaded.prefix(), "map");
+  ASSERT_EQ(loaded.tiles().size(), index.tiles().size());
+
+  for (size_t i = 0; i < index.tiles().size(); ++i) {
+    const auto & a = index.tiles()[i];
+    const auto & b = loaded.tiles()[i];
+
+    EXPECT_EQ(memcmp(&a, &b, sizeof(TileRecord)), 0);
+    EXPECT_EQ(
+      loaded.fileName(b), "map_" + std::to_string(a.ix) + "_" + std::to_string(a.iy) + ".pcd");
+    EXPECT_EQ(loaded.ndtVoxelsName(b).empty(), !(a.flags & TILE_NDT_VOXELS));
+    EXPECT_TRUE(loaded.heightMapName(b).empty());
+
+    if (i > 0) {
+      EXPECT_LT(index.tiles()[i - 1].code, a.code);
+    }
+  }
+
+  // Not an index
+  expectRejected(file, "PCDTIDX0", [&](const std::string & path) { return loaded.load(path); });
+  EXPECT_FALSE(loaded.load(file.string() + ".missing"));
+}
+
+TEST(TileIndex, QueryMatchesBruteForce)
+{
+  const auto tiles = makeTiles(12);
+  const TileIndex index(grid_size, grid_size, "map", tiles);
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> coord(-700.0, 700.0);
+
+  for (int trial = 0; trial < 500; ++trial) {
+    double min_x = coord(rng), max_x = coord(rng), min_y = coord(rng), max_y = coord(rng);
+
+    if (min_x > max_x) {
+      std::swap(min_x, max_x);
+    }
+    if (min_y > max_y) {
+      std::swap(min_y, max_y);
+    }
+
+    // Boxes on the borders of the grids too
+    if (trial % 5 == 0) {
+      min_x = std::floor(min_x / grid_size) * grid_size;
+      max_y = std::floor(max_y / grid_size) * grid_size;
+    }
+
+    std::vector<TileRecord> expected;
+
+    for (const auto & tile : tiles) {
+      if (
+        tile.ix + grid_size > min_x && tile.ix <= max_x && tile.iy + grid_size > min_y &&
+        tile.iy <= max_y) {
+        expected.push_back(tile);
+      }
+    }
+
+    const auto output = index.query(min_x, min_y, max_x, max_y);
+
+    EXPECT_EQ(output.size(), expected.size());
+    EXPECT_EQ(corners(output), corners(expected));
+
+    for (size_t i = 1; i < output.size(); ++i) {
+      EXPECT_LT(output[i - 1].code, output[i].code);
+    }
+  }
+
+  EXPECT_TRUE(TileIndex().query(0, 0, 100, 100).empty());
+}
+
+TEST(TileIndex, Crc32)
+{
+  const std::string text = "123456789";
+
+  EXPECT_EQ(crc32(text.data(), text.size()), 0xCBF43926U);
+  // The checksum of the parts chains to the checksum of the whole
+  EXPECT_EQ(crc32(text.data() + 4, 5, crc32(text.data(), 4)), 0xCBF43926U);
+}
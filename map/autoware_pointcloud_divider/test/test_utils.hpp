@@ -0,0 +1,93 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TEST_UTILS_HPP_
+#define TEST_UTILS_HPP_
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace autoware::pointcloud_divider::test_utils
+{
+struct Point
+{
+  float x, y, z;
+};
+
+// Corner of the test clouds, far from the origin as in a projected map, where a float keeps
+// less than a centimeter
+constexpr float far_x = 89340.0f, far_y = -45678.0f;
+
+// Add @point_num points of @rng to @cloud, in the square of @extent from (far_x, far_y) and
+// between @z_min and @z_max. @cloud is a std::vector or a pcl::PointCloud.
+template <typename CloudT>
+void addFarPoints(
+  CloudT & cloud, size_t point_num, float extent, float z_min, float z_max, std::mt19937 & rng)
+{
+  std::uniform_real_distribution<float> offset(0.0f, extent), height(z_min, z_max);
+
+  for (size_t i = 0; i < point_num; ++i) {
+    typename CloudT::value_type p{};
+
+    p.x = far_x + offset(rng);
+    p.y = far_y + offset(rng);
+    p.z = height(rng);
+    cloud.push_back(p);
+  }
+}
+
+// A file or a directory in the temporary directory, named after the running test and the
+// process so that the tests run concurrently never share it, and removed with the object
+class TempPath
+{
+public:
+  explicit TempPath(const std::string & extension = "")
+  {
+    const auto * info = ::testing::UnitTest::GetInstance()->current_test_info();
+
+    path_ = std::filesystem::temp_directory_path() /
+            ("pointcloud_divider_" + std::string(info->test_suite_name()) + "_" + info->name() +
+             "_" + std::to_string(getpid()) + extension);
+    std::filesystem::remove_all(path_);
+  }
+
+  ~TempPath() { std::filesystem::remove_all(path_); }
+
+  TempPath(const TempPath &) = delete;
+  TempPath & operator=(const TempPath &) = delete;
+
+  const std::filesystem::path & path() const { return path_; }
+
+  std::string string() const { return path_.string(); }
+
+private:
+  std::filesystem::path path_;
+};
+
+// Overwrite the file of a round trip with @content, e.g. the magic of another format, and check
+// that @load rejects it
+template <typename LoadT>
+void expectRejected(const TempPath & file, const std::string & content, LoadT load)
+{
+  std::ofstream(file.path(), std::ios::binary | std::ios::trunc) << content;
+  EXPECT_FALSE(load(file.string())) << "content: " << content;
+}
+}  // namespace autoware::pointcloud_divider::test_utils
+
+#endif  // TEST_UTILS_HPP_
@@ -46,11 +46,19 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+#include <fstream>
+#include <functional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #define PCL_NO_PRECOMPILE
 #include <autoware/pointcloud_divider/pcd_io.hpp>
+#include <autoware/pointcloud_divider/run_report.hpp>
+#include <autoware/pointcloud_divider/tile_index.hpp>
+#include <autoware/pointcloud_divider/voxel_grid_filter.hpp>
+#include <autoware/pointcloud_merger/region_of_interest.hpp>
 #include <rclcpp/rclcpp.hpp>
 
 #include <pcl/point_cloud.h>
@@ -81,6 +89,35 @@ public:
 
   void setLeafSize(double leaf_size) { leaf_size_ = leaf_size; }
 
+  void setVoxelFilterEngine(autoware::pointcloud_divider::VoxelFilterEngine engine)
+  {
+    voxel_filter_engine_ = engine;
+  }
+
+  // Number of threads reading the inputs and writing them to the output concurrently
+  void setThreadNum(size_t thread_num) { thread_num_ = std::max<size_t>(thread_num, 1); }
+
+  // Write the run report as JSON to @report_path at the end of the run, and log the progress
+  // every @progress_period seconds. An empty path or a period of 0 disables them.
+  void setReport(const std::string & report_path, double progress_period = 0)
+  {
+    report_path_ = report_path;
+    progress_period_ = progress_period;
+  }
+
+  // Extract the region @roi from a divided map instead of merging all PCDs of the input. The
+  // tiles are selected by the tile index or the metadata YAML of the divider, found in the input
+  // directory or its parent, and only the tiles crossed by the boundary of the region are read
+  // and cropped. With @divided_output, the tiles are written to the output directory as a
+  // divided map with its own metadata, instead of being merged to a single PCD.
+  void setROI(const RegionOfInterest & roi, bool divided_output = false)
+  {
+    roi_ = roi;
+    roi_divided_output_ = divided_output;
+  }
+
+  const autoware::pointcloud_divider::RunReport & getReport() const { return report_; }
+
   void run();
   void run(const std::vector<std::string> & pcd_names);
 
@@ -89,18 +126,77 @@ private:
 
   // Params from yaml
   double leaf_size_ = 0.1;
+  autoware::pointcloud_divider::VoxelFilterEngine voxel_filter_engine_ =
+    autoware::pointcloud_divider::VoxelFilterEngine::HASH;
+
+  size_t thread_num_ = 1;
+  RegionOfInterest roi_;
+  bool roi_divided_output_ = false;
 
   // Maximum number of points per PCD block
   const size_t max_block_size_ = 500000;
+  // Raw points buffered per partition before they are folded into its voxel accumulators
+  const size_t partition_buffer_size_ = 50000;
+
+  // A coarse cell of the downsampled output. Raw points are kept while they are few, so a
+  // small partition is filtered by the configured engine, and folded into the accumulators
+  // of the filter once the buffer is full.
+  struct Partition
+  {
+    PclCloudType points;
+    autoware::pointcloud_divider::VoxelGridFilter<PointT> vgf;
+    bool folded = false;
+  };
+
+  // Per-phase timers and throughputs of the current run
+  autoware::pointcloud_divider::RunReport report_{"pointcloud_merger"};
+  std::string report_path_;
+  double progress_period_ = 0;
 
   std::string tmp_dir_;
   autoware::pointcloud_divider::CustomPCDWriter<PointT> writer_;
   rclcpp::Logger logger_;
 
+  // A tile of a divided map selected by the region of interest
+  struct ROITile
+  {
+    std::string name, path;
+    autoware::pointcloud_divider::TileRecord record;
+    bool boundary;
+  };
+
+  // Tiles of the divided input map in the region of interest
+  struct ROIMap
+  {
+    double grid_size_x = 0, grid_size_y = 0;
+    // File prefix of the tile index, if the tiles were selected by it
+    std::string prefix;
+    bool indexed = false;
+    std::vector<ROITile> tiles;
+  };
+
   std::vector<std::string> discoverPCDs(const std::string & input);
+  ROIMap selectROITiles();
+  void runROI();
+  void merge(const std::vector<std::string> & pcd_names);
+  // Write the points of @input_pcd in the region of interest to @output_pcd, and update the
+  // number of points and the z range of @record. Return false if no point is in the region.
+  bool cropTile(
+    const std::string & input_pcd, const std::string & output_pcd,
+    autoware::pointcloud_divider::TileRecord & record);
   void paramInitialize();
+  // Stop the progress log and write the run report, if a path is set
+  void saveReport();
   void mergeWithoutDownsample(const std::vector<std::string> & input_pcds);
   void mergeWithDownsample(const std::vector<std::string> & input_pcds);
+  // Run @task on every index in [0, @num) by thread_num_ threads
+  void parallelFor(size_t num, const std::function<void(size_t)> & task);
+  // Compute the centroids of a partition and append them to @body
+  size_t flushPartition(Partition & partition, std::ofstream & body);
+  void writeAll(int fd, const char * data, size_t size, size_t offset);
+  // Write the points of an input to the output descriptor @fd from the byte @offset
+  void copyPoints(
+    const std::string & pcd_name, size_t point_num, int fd, size_t offset, size_t point_size);
 };
 
 }  // namespace autoware::pointcloud_merger
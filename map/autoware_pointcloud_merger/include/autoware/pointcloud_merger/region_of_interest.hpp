@@ -0,0 +1,182 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_MERGER__REGION_OF_INTEREST_HPP_
+#define AUTOWARE__POINTCLOUD_MERGER__REGION_OF_INTEREST_HPP_
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace autoware::pointcloud_merger
+{
+
+// Relation between a tile and the region of interest
+enum class TileOverlap {
+  OUTSIDE,   // No point of the tile is in the region
+  INSIDE,    // All points of the tile are in the region
+  BOUNDARY   // The tile is crossed by the boundary of the region
+};
+
+// A simple polygon on the xy plane. Points on the boundary are in the region.
+class RegionOfInterest
+{
+public:
+  RegionOfInterest() = default;
+
+  // Parse a flat list of the config, either a box [min_x, min_y, max_x, max_y] or the vertices
+  // of a polygon [x0, y0, x1, y1, ...] with at least 3 vertices. An empty list is no region.
+  static bool fromList(const std::vector<double> & values, RegionOfInterest & roi)
+  {
+    roi.vertices_.clear();
+
+    if (values.empty()) {
+      return true;
+    }
+
+    if (values.size() == 4) {
+      if (values[0] >= values[2] || values[1] >= values[3]) {
+        return false;
+      }
+
+      roi.vertices_ = {
+        {values[0], values[1]}, {values[2], values[1]}, {values[2], values[3]},
+        {values[0], values[3]}};
+    } else if (values.size() >= 6 && values.size() % 2 == 0) {
+      for (size_t i = 0; i < values.size(); i += 2) {
+        roi.vertices_.push_back({values[i], values[i + 1]});
+      }
+    } else {
+      return false;
+    }
+
+    roi.updateBounds();
+
+    return true;
+  }
+
+  bool empty() const { return vertices_.empty(); }
+
+  // Bounding box of the region, as [min_x, min_y, max_x, max_y]
+  const std::array<double, 4> & bounds() const { return bounds_; }
+
+  bool contains(double x, double y) const
+  {
+    if (x < bounds_[0] || x > bounds_[2] || y < bounds_[1] || y > bounds_[3]) {
+      return false;
+    }
+
+    bool inside = false;
+
+    for (size_t i = 0, j = vertices_.size() - 1; i < vertices_.size(); j = i++) {
+      const auto & a = vertices_[i];
+      const auto & b = vertices_[j];
+
+      if (onSegment(x, y, a, b)) {
+        return true;
+      }
+
+      // Crossings of the ray toward +x
+      if ((a[1] > y) != (b[1] > y) && x < (b[0] - a[0]) * (y - a[1]) / (b[1] - a[1]) + a[0]) {
+        inside = !inside;
+      }
+    }
+
+    return inside;
+  }
+
+  // A tile is crossed by the boundary if an edge of the region passes through its interior.
+  // Otherwise, it is either fully in or fully out of the region, which its center tells. The
+  // tiles sharing an edge with a box aligned to the grid are not on the boundary.
+  TileOverlap overlap(double min_x, double min_y, double max_x, double max_y) const
+  {
+    if (max_x < bounds_[0] || min_x > bounds_[2] || max_y < bounds_[1] || min_y > bounds_[3]) {
+      return TileOverlap::OUTSIDE;
+    }
+
+    for (size_t i = 0, j = vertices_.size() - 1; i < vertices_.size(); j = i++) {
+      if (clipSegment(vertices_[j], vertices_[i], min_x, min_y, max_x, max_y)) {
+        return TileOverlap::BOUNDARY;
+      }
+    }
+
+    return contains((min_x + max_x) * 0.5, (min_y + max_y) * 0.5) ? TileOverlap::INSIDE
+                                                                  : TileOverlap::OUTSIDE;
+  }
+
+private:
+  typedef std::array<double, 2> Vertex;
+
+  void updateBounds()
+  {
+    bounds_ = {
+      std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+      std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+
+    for (const auto & v : vertices_) {
+      bounds_[0] = std::min(bounds_[0], v[0]);
+      bounds_[1] = std::min(bounds_[1], v[1]);
+      bounds_[2] = std::max(bounds_[2], v[0]);
+      bounds_[3] = std::max(bounds_[3], v[1]);
+    }
+  }
+
+  static bool onSegment(double x, double y, const Vertex & a, const Vertex & b)
+  {
+    const double cross = (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+
+    return cross == 0 && x >= std::min(a[0], b[0]) && x <= std::max(a[0], b[0]) &&
+           y >= std::min(a[1], b[1]) && y <= std::max(a[1], b[1]);
+  }
+
+  // True if the segment [a, b] passes through the interior of the box (Liang-Barsky)
+  static bool clipSegment(
+    const Vertex & a, const Vertex & b, double min_x, double min_y, double max_x, double max_y)
+  {
+    const double dx = b[0] - a[0], dy = b[1] - a[1];
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {a[0] - min_x, max_x - a[0], a[1] - min_y, max_y - a[1]};
+    double t0 = 0, t1 = 1;
+
+    for (int k = 0; k < 4; ++k) {
+      if (p[k] == 0) {
+        if (q[k] <= 0) {
+          return false;
+        }
+      } else {
+        const double t = q[k] / p[k];
+
+        if (p[k] < 0) {
+          t0 = std::max(t0, t);
+        } else {
+          t1 = std::min(t1, t);
+        }
+
+        if (t0 >= t1) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  std::vector<Vertex> vertices_;
+  std::array<double, 4> bounds_{};
+};
+
+}  // namespace autoware::pointcloud_merger
+
+#endif  // AUTOWARE__POINTCLOUD_MERGER__REGION_OF_INTEREST_HPP_
@@ -18,6 +18,8 @@
 #include <string>
 
 #define PCL_NO_RECOMPILE
+#include <autoware/pointcloud_divider/voxel_grid_filter.hpp>
+#include <autoware/pointcloud_merger/region_of_interest.hpp>
 #include <rclcpp/rclcpp.hpp>
 
 namespace autoware::pointcloud_merger
@@ -27,6 +29,18 @@ class PointCloudMerger : public rclcpp::Node
 {
 public:
   explicit PointCloudMerger(const rclcpp::NodeOptions & node_options);
+
+private:
+  template <typename PointT>
+  void runMerger();
+
+  float leaf_size_;
+  int thread_num_;
+  std::string input_pcd_dir_, output_pcd_, report_path_;
+  double progress_period_;
+  autoware::pointcloud_divider::VoxelFilterEngine voxel_filter_engine_;
+  RegionOfInterest roi_;
+  bool roi_divided_output_;
 };
 
 }  // namespace autoware::pointcloud_merger
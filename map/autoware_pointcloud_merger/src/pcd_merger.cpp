@@ -43,18 +43,27 @@
 
 #include "include/pointcloud_merger_node.hpp"
 
-#include <autoware/pointcloud_divider/pcd_divider.hpp>
 #include <autoware/pointcloud_divider/utility.hpp>
 #include <autoware/pointcloud_merger/pcd_merger.hpp>
 
+#include <fcntl.h>
 #include <pcl/console/print.h>
+#include <unistd.h>
 
+#include <atomic>
 #include <filesystem>
+#include <functional>
+#include <limits>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace fs = std::filesystem;
 
+using autoware::pointcloud_divider::GridInfo;
+
 namespace autoware::pointcloud_merger
 {
 
@@ -89,6 +98,11 @@ std::vector<std::string> PCDMerger<PointT>::discoverPCDs(const std::string & inp
 template <class PointT>
 void PCDMerger<PointT>::run()
 {
+  if (!roi_.empty()) {
+    runROI();
+    return;
+  }
+
   auto pcd_list = discoverPCDs(input_dir_);
 
   run(pcd_list);
@@ -96,6 +110,18 @@ void PCDMerger<PointT>::run()
 
 template <class PointT>
 void PCDMerger<PointT>::run(const std::vector<std::string> & pcd_names)
+{
+  report_.reset();
+  report_.startProgress(progress_period_, [this](const std::string & line) {
+    RCLCPP_INFO(logger_, "%s", line.c_str());
+  });
+
+  merge(pcd_names);
+  saveReport();
+}
+
+template <class PointT>
+void PCDMerger<PointT>::merge(const std::vector<std::string> & pcd_names)
 {
   // Just in case the downsampling option is on
   if (leaf_size_ > 0) {
@@ -120,37 +146,518 @@ void PCDMerger<PointT>::run(const std::vector<std::string> & pcd_names)
   }
 }
 
+template <class PointT>
+typename PCDMerger<PointT>::ROIMap PCDMerger<PointT>::selectROITiles()
+{
+  using autoware::pointcloud_divider::TileIndex;
+  using autoware::pointcloud_divider::TileRecord;
+
+  ROIMap map;
+  std::vector<TileRecord> records;
+  std::vector<std::string> names;
+  fs::path input_path = fs::path(input_dir_).lexically_normal();
+
+  if (!input_path.has_filename()) {
+    input_path = input_path.parent_path();
+  }
+
+  // The input is either the output directory of the divider or its pointcloud_map.pcd folder
+  for (const auto & dir : {input_path, input_path.parent_path()}) {
+    TileIndex index;
+
+    if (index.load((dir / "pointcloud_map_index.bin").string())) {
+      const auto & bounds = roi_.bounds();
+
+      map.grid_size_x = index.gridSizeX();
+      map.grid_size_y = index.gridSizeY();
+      map.prefix = index.prefix();
+      map.indexed = true;
+
+      for (const auto & record : index.query(bounds[0], bounds[1], bounds[2], bounds[3])) {
+        records.push_back(record);
+        names.push_back(index.fileName(record));
+      }
+
+      break;
+    }
+
+    const fs::path yaml_path = dir / "pointcloud_map_metadata.yaml";
+
+    if (!fs::exists(yaml_path)) {
+      continue;
+    }
+
+    try {
+      const YAML::Node metadata = YAML::LoadFile(yaml_path.string());
+
+      map.grid_size_x = metadata["x_resolution"].as<double>();
+      map.grid_size_y = metadata["y_resolution"].as<double>();
+
+      // The other entries of the metadata, as the levels of detail, are not tiles
+      for (const auto & it : metadata) {
+        const auto & value = it.second;
+
+        if (!value.IsSequence() || value.size() != 2 || !value[0].IsScalar()) {
+          continue;
+        }
+
+        TileRecord record{};
+
+        record.ix = value[0].as<int32_t>();
+        record.iy = value[1].as<int32_t>();
+        records.push_back(record);
+        names.push_back(it.first.as<std::string>());
+      }
+    } catch (YAML::Exception & e) {
+      RCLCPP_ERROR(logger_, "YAML Error: %s", e.what());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    break;
+  }
+
+  if (map.grid_size_x <= 0 || map.grid_size_y <= 0) {
+    RCLCPP_ERROR(
+      logger_, "Error: No tile index or metadata YAML of a divided map in or next to %s",
+      input_dir_.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  // Tiles are found directly in the input directory, or in the folders of the large grids
+  std::unordered_map<std::string, std::string> large_grid_paths;
+  bool scanned = false;
+
+  for (size_t i = 0; i < records.size(); ++i) {
+    const auto & record = records[i];
+    auto overlap = roi_.overlap(
+      record.ix, record.iy, record.ix + map.grid_size_x, record.iy + map.grid_size_y);
+
+    if (overlap == TileOverlap::OUTSIDE) {
+      continue;
+    }
+
+    std::string path = (input_path / names[i]).string();
+
+    if (!fs::exists(path)) {
+      if (!scanned) {
+        for (auto & entry : fs::recursive_directory_iterator(input_path)) {
+          if (entry.is_regular_file()) {
+            large_grid_paths[entry.path().filename().string()] = entry.path().string();
+          }
+        }
+
+        scanned = true;
+      }
+
+      auto it = large_grid_paths.find(names[i]);
+
+      if (it == large_grid_paths.end()) {
+        RCLCPP_WARN(logger_, "Tile %s is not found in %s", names[i].c_str(), input_dir_.c_str());
+        continue;
+      }
+
+      path = it->second;
+    }
+
+    map.tiles.push_back({names[i], path, record, overlap == TileOverlap::BOUNDARY});
+  }
+
+  return map;
+}
+
+template <class PointT>
+void PCDMerger<PointT>::runROI()
+{
+  report_.reset();
+  report_.startProgress(progress_period_, [this](const std::string & line) {
+    RCLCPP_INFO(logger_, "%s", line.c_str());
+  });
+
+  auto map = selectROITiles();
+  auto & tiles = map.tiles;
+  const size_t boundary_num = std::count_if(
+    tiles.begin(), tiles.end(), [](const ROITile & tile) { return tile.boundary; });
+
+  RCLCPP_INFO(
+    logger_, "Selected %lu tiles in the region of interest, %lu of them on its boundary",
+    tiles.size(), boundary_num);
+
+  // The tiles inside the region are used as they are, and only the boundary ones are cropped
+  const std::string output_dir = roi_divided_output_ ? output_pcd_ + "/pointcloud_map.pcd/"
+                                                     : std::string("./pointcloud_merger_roi_tmp/");
+  std::vector<char> kept(tiles.size(), 0);
+
+  if (!roi_divided_output_ && fs::exists(output_dir)) {
+    fs::remove_all(output_dir);
+  }
+
+  fs::create_directories(output_dir);
+
+  parallelFor(tiles.size(), [&](size_t i) {
+    auto & tile = tiles[i];
+    const std::string output_path = output_dir + tile.name;
+
+    if (tile.boundary) {
+      kept[i] = cropTile(tile.path, output_path, tile.record);
+    } else if (roi_divided_output_) {
+      auto timer = report_.time("copy");
+
+      fs::copy_file(tile.path, output_path, fs::copy_options::overwrite_existing);
+      report_.addBytes("copy", fs::file_size(output_path));
+      kept[i] = 1;
+    } else {
+      kept[i] = 1;
+    }
+
+    // The sidecar files of the tiles are not copied, so their flags are cleared
+    if (kept[i] && roi_divided_output_ && map.indexed) {
+      tile.record.byte_size = fs::file_size(output_path);
+      tile.record.checksum = autoware::pointcloud_divider::fileChecksum(output_path);
+      tile.record.flags = 0;
+    }
+  });
+
+  if (!roi_divided_output_) {
+    std::vector<std::string> pcd_list;
+
+    for (size_t i = 0; i < tiles.size(); ++i) {
+      if (kept[i]) {
+        pcd_list.push_back(tiles[i].boundary ? output_dir + tiles[i].name : tiles[i].path);
+      }
+    }
+
+    merge(pcd_list);
+    autoware::pointcloud_divider::util::remove(output_dir);
+    saveReport();
+
+    return;
+  }
+
+  // The metadata and the index of the extracted map list the tiles with points in the region
+  std::ofstream yaml_file(output_pcd_ + "/pointcloud_map_metadata.yaml");
+  std::vector<autoware::pointcloud_divider::TileRecord> records;
+
+  yaml_file << "x_resolution: " << map.grid_size_x << std::endl;
+  yaml_file << "y_resolution: " << map.grid_size_y << std::endl;
+
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    if (kept[i]) {
+      yaml_file << tiles[i].name << ": [" << tiles[i].record.ix << ", " << tiles[i].record.iy
+                << "]" << std::endl;
+      records.push_back(tiles[i].record);
+    }
+  }
+
+  if (!yaml_file) {
+    RCLCPP_ERROR(logger_, "Error: Failed to write the metadata YAML to %s", output_pcd_.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  if (map.indexed) {
+    autoware::pointcloud_divider::TileIndex index(
+      map.grid_size_x, map.grid_size_y, map.prefix, std::move(records));
+
+    if (!index.save(output_pcd_ + "/pointcloud_map_index.bin")) {
+      RCLCPP_ERROR(logger_, "Error: Failed to write the tile index to %s", output_pcd_.c_str());
+    }
+  }
+
+  saveReport();
+}
+
+template <class PointT>
+bool PCDMerger<PointT>::cropTile(
+  const std::string & input_pcd, const std::string & output_pcd,
+  autoware::pointcloud_divider::TileRecord & record)
+{
+  autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
+  PclCloudType block, cropped;
+
+  reader.setInput(input_pcd);
+  reader.setBlockSize(max_block_size_);
+
+  {
+    auto timer = report_.time("crop");
+
+    do {
+      reader.readABlock(block);
+
+      for (const auto & p : block) {
+        if (roi_.contains(p.x, p.y)) {
+          cropped.push_back(p);
+        }
+      }
+
+      report_.addPoints("crop", block.size());
+    } while (reader.good() && rclcpp::ok());
+
+    report_.addBytes("crop", fs::file_size(input_pcd));
+  }
+
+  if (cropped.empty()) {
+    return false;
+  }
+
+  record.point_num = cropped.size();
+  record.z_min = std::numeric_limits<float>::max();
+  record.z_max = std::numeric_limits<float>::lowest();
+
+  for (const auto & p : cropped) {
+    record.z_min = std::min(record.z_min, p.z);
+    record.z_max = std::max(record.z_max, p.z);
+  }
+
+  auto timer = report_.time("write");
+  autoware::pointcloud_divider::CustomPCDWriter<PointT> writer;
+
+  writer.setOutput(output_pcd);
+  writer.writeMetadata(cropped.size(), true);
+  writer.write(cropped);
+
+  if (!writer.good()) {
+    RCLCPP_ERROR(logger_, "Error: Failed to write points to %s", output_pcd.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  report_.addPoints("write", cropped.size());
+
+  return true;
+}
+
+template <class PointT>
+void PCDMerger<PointT>::saveReport()
+{
+  report_.stopProgress();
+
+  if (report_path_.empty()) {
+    return;
+  }
+
+  // The output is complete at this point, so a failure to save the report is not fatal
+  if (!report_.save(report_path_)) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save the run report at %s", report_path_.c_str());
+    return;
+  }
+
+  RCLCPP_INFO(logger_, "Saved the run report to %s", report_path_.c_str());
+}
+
 template <class PointT>
 void PCDMerger<PointT>::mergeWithDownsample(const std::vector<std::string> & input_pcds)
 {
-  RCLCPP_INFO(logger_, "Downsampling by PointCloudDivider");
-  // Divide the input clouds to smaller segments
-  autoware::pointcloud_divider::PCDDivider<PointT> pcd_divider(logger_);
+  if (input_pcds.size() == 0) {
+    RCLCPP_INFO(logger_, "No input PCDs. Return!");
 
-  pcd_divider.setOutputDir(tmp_dir_);
-  pcd_divider.setGridSize(leaf_size_ * 100, leaf_size_ * 100);
-  pcd_divider.setPrefix("tmp_segment");
-  pcd_divider.setLeafSize(leaf_size_);
-  pcd_divider.setDebugMode(false);
-  pcd_divider.run(input_pcds);
+    return;
+  }
 
-  // Now go get path of the segmentation pcd
-  std::vector<std::string> seg_names;
-  fs::path tmp_path(tmp_dir_);
+  RCLCPP_INFO(logger_, "Downsampling and merging");
 
-  for (auto & entry : fs::recursive_directory_iterator(tmp_path)) {
-    if (fs::is_regular_file(entry.symlink_status())) {
-      auto fname = entry.path().string();
-      auto ext = fname.substr(fname.size() - 4);
+  // Points are partitioned by coarse cells, so a cell can be flushed once no remaining
+  // input has points in it
+  const float part_res = leaf_size_ * 100;
+  const size_t file_num = input_pcds.size();
+  std::vector<std::unordered_set<GridInfo<2>>> file_parts(file_num);
+
+  parallelFor(file_num, [&](size_t fid) {
+    autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
+    PclCloudType new_cloud;
+
+    reader.setInput(input_pcds[fid]);
+    reader.setBlockSize(max_block_size_);
+
+    do {
+      auto timer = report_.time("scan");
+
+      reader.readABlock(new_cloud);
+
+      for (auto & p : new_cloud) {
+        file_parts[fid].insert(pointToGrid2(p, part_res, part_res));
+      }
+
+      report_.addPoints("scan", new_cloud.size());
+    } while (reader.good() && rclcpp::ok());
+
+    report_.addBytes("scan", fs::file_size(input_pcds[fid]));
+  });
+
+  std::unordered_map<GridInfo<2>, size_t> last_file;
+
+  for (size_t fid = 0; fid < file_num; ++fid) {
+    for (auto & grid : file_parts[fid]) {
+      last_file[grid] = fid;
+    }
+  }
+
+  // The number of output points is known only at the end, so the centroids are staged in a
+  // raw body file and copied behind the header afterwards
+  const std::string body_path = tmp_dir_ + "merged_points.bin";
+  std::ofstream body(body_path, std::ios::binary);
+  std::unordered_map<GridInfo<2>, Partition> parts;
+  autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
+  PclCloudType new_cloud;
+  size_t output_point_num = 0;
 
-      if (ext == ".pcd") {
-        seg_names.push_back(fname);
+  for (size_t fid = 0; fid < file_num && rclcpp::ok(); ++fid) {
+    RCLCPP_INFO(logger_, "Processing file [%lu/%lu] %s", fid, file_num, input_pcds[fid].c_str());
+
+    reader.setInput(input_pcds[fid]);
+    reader.setBlockSize(max_block_size_);
+
+    do {
+      {
+        auto timer = report_.time("read");
+
+        reader.readABlock(new_cloud);
+        report_.addPoints("read", new_cloud.size());
       }
+
+      auto timer = report_.time("bin");
+
+      report_.addPoints("bin", new_cloud.size());
+
+      for (auto & p : new_cloud) {
+        auto grid = pointToGrid2(p, part_res, part_res);
+        auto it = parts.find(grid);
+
+        if (it == parts.end()) {
+          it = parts.emplace(grid, Partition()).first;
+          it->second.vgf.setResolution(leaf_size_);
+          it->second.vgf.setEngine(voxel_filter_engine_);
+        }
+
+        auto & part = it->second;
+
+        part.points.push_back(p);
+
+        if (part.points.size() >= partition_buffer_size_) {
+          auto voxel_timer = report_.time("voxel");
+
+          report_.addPoints("voxel", part.points.size());
+          part.vgf.add(part.points);
+          part.points.clear();
+          part.folded = true;
+        }
+      }
+    } while (reader.good() && rclcpp::ok());
+
+    report_.addBytes("read", fs::file_size(input_pcds[fid]));
+
+    // Flush the partitions that the remaining inputs do not touch
+    for (auto & grid : file_parts[fid]) {
+      if (last_file[grid] == fid) {
+        output_point_num += flushPartition(parts[grid], body);
+        parts.erase(grid);
+      }
+    }
+
+    file_parts[fid].clear();
+  }
+
+  body.close();
+
+  writer_.setOutput(output_pcd_);
+  writer_.writeMetadata(output_point_num, true);
+
+  const size_t data_offset = writer_.dataOffset();
+  int fd = open(output_pcd_.c_str(), O_WRONLY);
+
+  if (fd < 0) {
+    RCLCPP_ERROR(logger_, "Error: Failed to open the output PCD %s", output_pcd_.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  std::ifstream body_in(body_path, std::ios::binary);
+  std::vector<char> buffer(max_block_size_ * writer_.pointSize());
+  size_t copied_size = 0;
+  auto timer = report_.time("write");
+
+  while (body_in) {
+    body_in.read(buffer.data(), buffer.size());
+    writeAll(fd, buffer.data(), body_in.gcount(), data_offset + copied_size);
+    copied_size += body_in.gcount();
+  }
+
+  close(fd);
+  writer_.markWritten(output_point_num);
+  fs::remove(body_path);
+  report_.addBytes("write", copied_size);
+  report_.addPoints("write", output_point_num);
+}
+
+template <class PointT>
+size_t PCDMerger<PointT>::flushPartition(Partition & partition, std::ofstream & body)
+{
+  PclCloudType centroids;
+
+  {
+    auto timer = report_.time("voxel");
+
+    report_.addPoints("voxel", partition.points.size());
+
+    if (partition.folded) {
+      partition.vgf.add(partition.points);
+      partition.vgf.flush(centroids);
+    } else {
+      partition.vgf.filter(partition.points, centroids);
     }
   }
 
-  // Now merge the downsampled segments
-  mergeWithoutDownsample(seg_names);
+  // The centroids are staged in the tmp directory, which is also written to the storage
+  auto timer = report_.time("stage");
+  std::vector<char> buffer(centroids.size() * writer_.pointSize());
+
+  writer_.encodeBinary(centroids, buffer.data());
+  body.write(buffer.data(), buffer.size());
+  report_.addBytes("stage", buffer.size());
+  report_.addPoints("stage", centroids.size());
+
+  return centroids.size();
+}
+
+template <class PointT>
+void PCDMerger<PointT>::parallelFor(size_t num, const std::function<void(size_t)> & task)
+{
+  const size_t thread_num = std::min(thread_num_, num);
+  std::atomic<size_t> next_id(0);
+  std::vector<std::thread> threads;
+
+  auto worker = [&]() {
+    for (size_t id = next_id++; id < num && rclcpp::ok(); id = next_id++) {
+      task(id);
+    }
+  };
+
+  for (size_t i = 1; i < thread_num; ++i) {
+    threads.emplace_back(worker);
+  }
+
+  worker();
+
+  for (auto & t : threads) {
+    t.join();
+  }
+}
+
+template <class PointT>
+void PCDMerger<PointT>::writeAll(int fd, const char * data, size_t size, size_t offset)
+{
+  for (size_t written = 0; written < size;) {
+    ssize_t ret = pwrite(fd, data + written, size - written, offset + written);
+
+    if (ret <= 0) {
+      RCLCPP_ERROR(logger_, "Error: Failed to write points to %s", output_pcd_.c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    written += ret;
+  }
 }
 
 template <class PointT>
@@ -162,39 +669,99 @@ void PCDMerger<PointT>::mergeWithoutDownsample(const std::vector<std::string> &
     return;
   }
 
-  // Check the number of points of the merger
-  size_t total_point_num = 0;
-  autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
+  const size_t file_num = input_pcds.size();
+  // Check the number of points of the inputs
+  std::vector<size_t> point_nums(file_num);
+
+  parallelFor(file_num, [&](size_t fid) {
+    autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
 
-  for (const auto & pcd_name : input_pcds) {
-    reader.setInput(pcd_name);
+    reader.setInput(input_pcds[fid]);
+    point_nums[fid] = reader.point_num();
+  });
 
-    total_point_num += reader.point_num();
+  size_t total_point_num = 0;
+
+  for (auto point_num : point_nums) {
+    total_point_num += point_num;
   }
 
   writer_.setOutput(output_pcd_);
   writer_.writeMetadata(total_point_num, true);
 
-  size_t file_counter = 0;
+  // Binary points have a fixed size, so every input is written at its own offset
+  const size_t point_size = writer_.pointSize();
+  std::vector<size_t> offsets(file_num);
 
-  for (const auto & pcd_name : input_pcds) {
-    if (!rclcpp::ok()) {
-      return;
-    }
+  offsets[0] = writer_.dataOffset();
+
+  for (size_t fid = 1; fid < file_num; ++fid) {
+    offsets[fid] = offsets[fid - 1] + point_nums[fid - 1] * point_size;
+  }
+
+  int fd = open(output_pcd_.c_str(), O_WRONLY);
 
+  if (fd < 0) {
+    RCLCPP_ERROR(logger_, "Error: Failed to open the output PCD %s", output_pcd_.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  std::atomic<size_t> file_counter(0);
+
+  parallelFor(file_num, [&](size_t fid) {
     RCLCPP_INFO(
-      logger_, "Processing file [%lu/%lu] %s", file_counter, input_pcds.size(), pcd_name.c_str());
-    ++file_counter;
+      logger_, "Processing file [%lu/%lu] %s", file_counter++, file_num, input_pcds[fid].c_str());
 
-    reader.setInput(pcd_name);
+    copyPoints(input_pcds[fid], point_nums[fid], fd, offsets[fid], point_size);
+  });
 
-    do {
-      PclCloudType new_cloud;
+  close(fd);
+  writer_.markWritten(total_point_num);
+}
+
+template <class PointT>
+void PCDMerger<PointT>::copyPoints(
+  const std::string & pcd_name, size_t point_num, int fd, size_t offset, size_t point_size)
+{
+  autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
+  PclCloudType new_cloud;
+  std::vector<char> buffer;
+  size_t copied_num = 0;
+
+  reader.setInput(pcd_name);
+  reader.setBlockSize(max_block_size_);
+  report_.addBytes("read", fs::file_size(pcd_name));
+
+  do {
+    {
+      auto timer = report_.time("read");
 
       reader.readABlock(new_cloud);
-      writer_.write(new_cloud);
-    } while (reader.good() && rclcpp::ok());
-  }
+      report_.addPoints("read", new_cloud.size());
+    }
+
+    auto timer = report_.time("write");
+
+    // Points beyond the header of the input would overwrite the next input
+    if (copied_num + new_cloud.size() > point_num) {
+      new_cloud.resize(point_num - copied_num);
+    }
+
+    buffer.resize(new_cloud.size() * point_size);
+    writer_.encodeBinary(new_cloud, buffer.data());
+
+    // Missing points are filled by 0, as the single-threaded writer did
+    if (!reader.good() && copied_num + new_cloud.size() < point_num) {
+      buffer.resize((point_num - copied_num) * point_size, 0);
+    }
+
+    writeAll(fd, buffer.data(), buffer.size(), offset + copied_num * point_size);
+    report_.addBytes("write", buffer.size());
+    report_.addPoints("write", buffer.size() / point_size);
+
+    copied_num += buffer.size() / point_size;
+  } while (reader.good() && copied_num < point_num && rclcpp::ok());
 }
 
 template <class PointT>
@@ -205,6 +772,33 @@ void PCDMerger<PointT>::paramInitialize()
     auto params = conf["/**"]["ros__parameters"];
 
     leaf_size_ = params["leaf_size"].as<double>();
+
+    if (params["thread_num"]) {
+      setThreadNum(params["thread_num"].as<size_t>());
+    }
+
+    if (params["roi"]) {
+      RegionOfInterest roi;
+
+      if (!RegionOfInterest::fromList(params["roi"].as<std::vector<double>>(), roi)) {
+        RCLCPP_ERROR(logger_, "Error: Invalid roi");
+        rclcpp::shutdown();
+        exit(EXIT_FAILURE);
+      }
+
+      setROI(roi, params["roi_divided_output"] && params["roi_divided_output"].as<bool>());
+    }
+
+    if (
+      params["voxel_filter_engine"] &&
+      !autoware::pointcloud_divider::toVoxelFilterEngine(
+        params["voxel_filter_engine"].as<std::string>(), voxel_filter_engine_)) {
+      RCLCPP_ERROR(
+        logger_, "Error: Unknown voxel_filter_engine %s",
+        params["voxel_filter_engine"].as<std::string>().c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
   } catch (YAML::Exception & e) {
     RCLCPP_ERROR(logger_, "YAML Error: %s", e.what());
     rclcpp::shutdown();
@@ -214,8 +808,8 @@ void PCDMerger<PointT>::paramInitialize()
 
 template class PCDMerger<pcl::PointXYZ>;
 template class PCDMerger<pcl::PointXYZI>;
-// template class PCDMerger<pcl::PointXYZINormal>;
-// template class PCDMerger<pcl::PointXYZRGB>;
+template class PCDMerger<pcl::PointXYZINormal>;
+template class PCDMerger<pcl::PointXYZRGB>;
 // template class PCDMerger<pcl::PointNormal>;
 
 }  // namespace autoware::pointcloud_merger
@@ -18,19 +18,63 @@
 
 #include <pcl/point_types.h>
 
+#include <algorithm>
 #include <string>
 
 namespace autoware::pointcloud_merger
 {
 
+template <typename PointT>
+void PointCloudMerger::runMerger()
+{
+  autoware::pointcloud_merger::PCDMerger<PointT> pcd_merger_exe(get_logger());
+
+  pcd_merger_exe.setLeafSize(leaf_size_);
+  pcd_merger_exe.setVoxelFilterEngine(voxel_filter_engine_);
+  pcd_merger_exe.setThreadNum(std::max(thread_num_, 1));
+  pcd_merger_exe.setInput(input_pcd_dir_);
+  pcd_merger_exe.setOutput(output_pcd_);
+  pcd_merger_exe.setReport(report_path_, progress_period_);
+  pcd_merger_exe.setROI(roi_, roi_divided_output_);
+
+  pcd_merger_exe.run();
+}
+
 PointCloudMerger::PointCloudMerger(const rclcpp::NodeOptions & node_options)
 : Node("pointcloud_merger", node_options)
 {
   // Load command parameters
-  float leaf_size = declare_parameter<float>("leaf_size");
-  std::string input_pcd_dir = declare_parameter<std::string>("input_pcd_dir");
-  std::string output_pcd = declare_parameter<std::string>("output_pcd");
+  leaf_size_ = declare_parameter<float>("leaf_size");
+  input_pcd_dir_ = declare_parameter<std::string>("input_pcd_dir");
+  output_pcd_ = declare_parameter<std::string>("output_pcd");
   std::string point_type = declare_parameter<std::string>("point_type");
+  std::string voxel_filter_engine =
+    declare_parameter<std::string>("voxel_filter_engine", "hash");
+  thread_num_ = declare_parameter<int>("thread_num", 1);
+  report_path_ = declare_parameter<std::string>("report_path", "");
+  progress_period_ = declare_parameter<double>("progress_period", 0.0);
+  const auto roi = declare_parameter<std::vector<double>>("roi", std::vector<double>());
+  roi_divided_output_ = declare_parameter<bool>("roi_divided_output", false);
+
+  if (report_path_.empty()) {
+    report_path_ = output_pcd_ + ".report.json";
+  }
+
+  if (!autoware::pointcloud_divider::toVoxelFilterEngine(
+        voxel_filter_engine, voxel_filter_engine_)) {
+    RCLCPP_ERROR(
+      get_logger(), "Error: Unknown voxel_filter_engine %s. Use hash instead.",
+      voxel_filter_engine.c_str());
+    voxel_filter_engine_ = autoware::pointcloud_divider::VoxelFilterEngine::HASH;
+  }
+
+  if (!RegionOfInterest::fromList(roi, roi_)) {
+    RCLCPP_ERROR(
+      get_logger(),
+      "Error: roi must be [min_x, min_y, max_x, max_y] or [x0, y0, x1, y1, x2, y2, ...]. "
+      "Merge the whole input instead.");
+    roi_ = RegionOfInterest();
+  }
 
   // Enter a new line and clear it
   // This is to get rid of the prefix of RCLCPP_INFO
@@ -44,30 +88,39 @@ PointCloudMerger::PointCloudMerger(const rclcpp::NodeOptions & node_options)
   param_display << line_breaker << line_breaker << "########## Input Parameters ##########"
                 << line_breaker;
 
-  param_display << "\tleaf_size: " << leaf_size << line_breaker;
-  param_display << "\tinput_pcd_dir: " << input_pcd_dir << line_breaker;
-  param_display << "\toutput_pcd: " << output_pcd << line_breaker;
+  param_display << "\tleaf_size: " << leaf_size_ << line_breaker;
+  param_display << "\tinput_pcd_dir: " << input_pcd_dir_ << line_breaker;
+  param_display << "\toutput_pcd: " << output_pcd_ << line_breaker;
   param_display << "\tpoint_type: " << point_type << line_breaker;
-  param_display << "######################################" << line_breaker;
+  param_display << "\tvoxel_filter_engine: " << voxel_filter_engine << line_breaker;
+  param_display << "\tthread_num: " << thread_num_ << line_breaker;
+  param_display << "\treport_path: " << report_path_ << line_breaker;
 
-  RCLCPP_INFO(get_logger(), "%s", param_display.str().c_str());
+  if (!roi_.empty()) {
+    param_display << "\troi:";
 
-  if (point_type == "point_xyz") {
-    autoware::pointcloud_merger::PCDMerger<pcl::PointXYZ> pcd_merger_exe(get_logger());
+    for (auto value : roi) {
+      param_display << " " << value;
+    }
 
-    pcd_merger_exe.setLeafSize(leaf_size);
-    pcd_merger_exe.setInput(input_pcd_dir);
-    pcd_merger_exe.setOutput(output_pcd);
+    param_display << (roi_divided_output_ ? ", divided output" : ", merged output")
+                  << line_breaker;
+  }
 
-    pcd_merger_exe.run();
-  } else if (point_type == "point_xyzi") {
-    autoware::pointcloud_merger::PCDMerger<pcl::PointXYZI> pcd_merger_exe(get_logger());
+  param_display << "######################################" << line_breaker;
 
-    pcd_merger_exe.setLeafSize(leaf_size);
-    pcd_merger_exe.setInput(input_pcd_dir);
-    pcd_merger_exe.setOutput(output_pcd);
+  RCLCPP_INFO(get_logger(), "%s", param_display.str().c_str());
 
-    pcd_merger_exe.run();
+  if (point_type == "point_xyz") {
+    runMerger<pcl::PointXYZ>();
+  } else if (point_type == "point_xyzi") {
+    runMerger<pcl::PointXYZI>();
+  } else if (point_type == "point_xyzrgb") {
+    runMerger<pcl::PointXYZRGB>();
+  } else if (point_type == "point_xyzinormal") {
+    runMerger<pcl::PointXYZINormal>();
+  } else {
+    RCLCPP_ERROR(get_logger(), "Error: Unsupported point type %s", point_type.c_str());
   }
 
   rclcpp::shutdown();
@@ -26,15 +26,14 @@ namespace autoware::pointcloud_projection_converter
 ConverterFromLLH::ConverterFromLLH(const YAML::Node & config)
 {
   projector_type_ = config["projector_type"].as<std::string>();
+  proj_ = &GeographicLib::TransverseMercatorExact::UTM();
 
   if (projector_type_ == "TransverseMercator") {
     central_meridian_ = config["map_origin"]["longitude"].as<double>();
 
     // Calculate origin in Transverse Mercator coordinate
-    const GeographicLib::TransverseMercatorExact & proj =
-      GeographicLib::TransverseMercatorExact::UTM();
     double x, y;
-    proj.Forward(
+    proj_->Forward(
       central_meridian_, config["map_origin"]["latitude"].as<double>(),
       config["map_origin"]["longitude"].as<double>(), x, y);
     origin_xy_ = std::pair<double, double>(x, y);
@@ -43,27 +42,58 @@ ConverterFromLLH::ConverterFromLLH(const YAML::Node & config)
 
 pcl::PointXYZI ConverterFromLLH::convert(const LatLonAlt & llh)
 {
+  checkProjectorType();
+
   pcl::PointXYZI xyz;
-  if (projector_type_ == "TransverseMercator") {
-    const GeographicLib::TransverseMercatorExact & proj =
-      GeographicLib::TransverseMercatorExact::UTM();
 
-    // Variables to hold the results
-    double x, y;
+  // Variables to hold the results
+  double x, y;
+
+  // Convert to transverse mercator coordinates
+  proj_->Forward(central_meridian_, llh.lat, llh.lon, x, y);
+  xyz.x = x - origin_xy_.first;
+  xyz.y = y - origin_xy_.second;
+  xyz.z = llh.alt;
+
+  return xyz;
+}
 
-    // Convert to transverse mercator coordinates
-    proj.Forward(central_meridian_, llh.lat, llh.lon, x, y);
-    xyz.x = x - origin_xy_.first;
-    xyz.y = y - origin_xy_.second;
-    xyz.z = llh.alt;
+void ConverterFromLLH::convert(
+  size_t n, const double * lat, const double * lon, const double * alt, double * x, double * y,
+  double * z) const
+{
+  checkProjectorType();
 
-  } else {
+  for (size_t i = 0; i < n; ++i) {
+    proj_->Forward(central_meridian_, lat[i], lon[i], x[i], y[i]);
+    x[i] -= origin_xy_.first;
+    y[i] -= origin_xy_.second;
+    z[i] = alt[i];
+  }
+}
+
+bool ConverterFromLLH::transverseMercatorFrame(
+  double & central_meridian, double & origin_x, double & origin_y) const
+{
+  if (projector_type_ != "TransverseMercator") {
+    return false;
+  }
+
+  central_meridian = central_meridian_;
+  origin_x = origin_xy_.first;
+  origin_y = origin_xy_.second;
+
+  return true;
+}
+
+void ConverterFromLLH::checkProjectorType() const
+{
+  if (projector_type_ != "TransverseMercator") {
     std::cerr << "Only conversion to "
                  "TransverseMercator is supported currently.\n";
     std::cerr << "Not supported projector type: " << projector_type_ << std::endl;
     throw std::runtime_error("");
   }
-  return xyz;
 }
 
 }  // namespace autoware::pointcloud_projection_converter
@@ -28,6 +28,16 @@ ConverterToLLH::ConverterToLLH(const YAML::Node & config)
   projector_type_ = config["projector_type"].as<std::string>();
   if (projector_type_ == "MGRS") {
     mgrs_grid_ = config["mgrs_grid"].as<std::string>();
+
+    try {
+      int prec = 8;
+      constexpr bool longpath = false;
+      GeographicLib::MGRS::Reverse(
+        mgrs_grid_, zone_, northp_, mgrs_base_x_, mgrs_base_y_, prec, longpath);
+      mgrs_valid_ = true;
+    } catch (const std::exception & e) {
+      std::cerr << "Error: Could not convert from MGRS to UTM: " << e.what() << std::endl;
+    }
   }
 }
 
@@ -35,18 +45,14 @@ LatLonAlt ConverterToLLH::convert(const pcl::PointXYZI & xyz)
 {
   LatLonAlt llh;
   if (projector_type_ == "MGRS") {
-    try {
-      int zone;
-      bool northern_hemisphere;
-      double mgrs_base_x, mgrs_base_y;
-      int prec = 8;
-      constexpr bool longpath = false;
-      GeographicLib::MGRS::Reverse(
-        mgrs_grid_, zone, northern_hemisphere, mgrs_base_x, mgrs_base_y, prec, longpath);
+    if (!mgrs_valid_) {
+      return LatLonAlt();
+    }
 
+    try {
       // Convert UTM to LLH
       GeographicLib::UTMUPS::Reverse(
-        zone, northern_hemisphere, xyz.x + mgrs_base_x, xyz.y + mgrs_base_y, llh.lat, llh.lon);
+        zone_, northp_, xyz.x + mgrs_base_x_, xyz.y + mgrs_base_y_, llh.lat, llh.lon);
 
       llh.alt = xyz.z;
     } catch (const std::exception & e) {
@@ -57,4 +63,45 @@ LatLonAlt ConverterToLLH::convert(const pcl::PointXYZI & xyz)
   return llh;
 }
 
+void ConverterToLLH::convert(
+  size_t n, const double * x, const double * y, const double * z, double * lat, double * lon,
+  double * alt) const
+{
+  if (projector_type_ != "MGRS") {
+    return;
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    lat[i] = lon[i] = alt[i] = 0;
+
+    if (!mgrs_valid_) {
+      continue;
+    }
+
+    try {
+      GeographicLib::UTMUPS::Reverse(
+        zone_, northp_, x[i] + mgrs_base_x_, y[i] + mgrs_base_y_, lat[i], lon[i]);
+      alt[i] = z[i];
+    } catch (const std::exception & e) {
+      std::cerr << "Error: Could not convert from MGRS to UTM: " << e.what() << std::endl;
+      lat[i] = lon[i] = 0;
+    }
+  }
+}
+
+bool ConverterToLLH::utmFrame(int & zone, bool & northp, double & base_x, double & base_y) const
+{
+  // Zone 0 is the polar stereographic projection
+  if (projector_type_ != "MGRS" || !mgrs_valid_ || zone_ == 0) {
+    return false;
+  }
+
+  zone = zone_;
+  northp = northp_;
+  base_x = mgrs_base_x_;
+  base_y = mgrs_base_y_;
+
+  return true;
+}
+
 }  // namespace autoware::pointcloud_projection_converter
@@ -25,6 +25,7 @@
 #include <pcl/point_types.h>
 #include <yaml-cpp/yaml.h>
 
+#include <cstddef>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -37,11 +38,23 @@ class ConverterFromLLH
 public:
   explicit ConverterFromLLH(const YAML::Node & config);
   pcl::PointXYZI convert(const LatLonAlt & xyz);
+  // Convert @n points given as arrays of coordinates
+  void convert(
+    size_t n, const double * lat, const double * lon, const double * alt, double * x, double * y,
+    double * z) const;
+
+  // Return true if the output is a transverse Mercator plane, with its central meridian and
+  // the projected coordinates of its origin
+  bool transverseMercatorFrame(
+    double & central_meridian, double & origin_x, double & origin_y) const;
 
 private:
+  void checkProjectorType() const;
+
   std::string projector_type_;
   std::pair<double, double> origin_xy_;
   double central_meridian_;
+  const GeographicLib::TransverseMercatorExact * proj_;
 };
 
 }  // namespace autoware::pointcloud_projection_converter
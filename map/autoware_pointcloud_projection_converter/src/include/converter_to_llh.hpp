@@ -24,6 +24,7 @@
 #include <pcl/point_types.h>
 #include <yaml-cpp/yaml.h>
 
+#include <cstddef>
 #include <iostream>
 #include <string>
 
@@ -35,11 +36,24 @@ class ConverterToLLH
 public:
   explicit ConverterToLLH(const YAML::Node & config);
   LatLonAlt convert(const pcl::PointXYZI & llh);
+  // Convert @n points given as arrays of coordinates
+  void convert(
+    size_t n, const double * x, const double * y, const double * z, double * lat, double * lon,
+    double * alt) const;
+
+  // Return true if the input is a UTM plane, with the UTM coordinates of its origin
+  bool utmFrame(int & zone, bool & northp, double & base_x, double & base_y) const;
 
 private:
   std::string projector_type_;
   std::string mgrs_grid_;
   double lat_, lon_;
+
+  // UTM zone and origin of the MGRS grid, decoded once in the constructor
+  bool mgrs_valid_ = false;
+  int zone_ = 0;
+  bool northp_ = true;
+  double mgrs_base_x_ = 0, mgrs_base_y_ = 0;
 };
 
 }  // namespace autoware::pointcloud_projection_converter
@@ -0,0 +1,53 @@
+// Copyright 2025 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POINT_CONVERTER_HPP_
+#define POINT_CONVERTER_HPP_
+
+#include "converter_from_llh.hpp"
+#include "converter_to_llh.hpp"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <yaml-cpp/yaml.h>
+
+namespace autoware::pointcloud_projection_converter
+{
+
+// Convert point clouds from the input projection to the output projection. Points are
+// converted in batches through latitude/longitude. If both projections are the same
+// transverse Mercator plane up to an offset (an MGRS grid whose UTM zone has the central
+// meridian of the output), the conversion is a translation and skips the geodesic step.
+class PointConverter
+{
+public:
+  PointConverter(const YAML::Node & input_config, const YAML::Node & output_config);
+
+  // Convert the coordinates of the points in place, other fields are kept.
+  // Batches are converted by OpenMP threads if @parallel is true.
+  void convert(pcl::PointCloud<pcl::PointXYZI> & cloud, bool parallel) const;
+
+  bool isDirect() const { return direct_; }
+
+private:
+  ConverterToLLH to_llh_;
+  ConverterFromLLH from_llh_;
+
+  bool direct_ = false;
+  double offset_x_ = 0, offset_y_ = 0;
+};
+
+}  // namespace autoware::pointcloud_projection_converter
+
+#endif  // POINT_CONVERTER_HPP_
@@ -0,0 +1,67 @@
+// Copyright 2025 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PROJECTION_STAGE_HPP_
+#define PROJECTION_STAGE_HPP_
+
+#include "point_converter.hpp"
+
+#include <autoware/pointcloud_divider/stream_stage.hpp>
+#include <yaml-cpp/yaml.h>
+
+#include <string>
+
+namespace autoware::pointcloud_projection_converter
+{
+
+// Convert the blocks read by the divider from the input projection to the output projection.
+// The reader threads convert different blocks at the same time, so the points of a block are
+// converted by the calling thread only.
+class ProjectionStage : public autoware::pointcloud_divider::StreamStage<pcl::PointXYZI>
+{
+public:
+  ProjectionStage(const YAML::Node & input_config, const YAML::Node & output_config)
+  : converter_(input_config, output_config),
+    signature_("projection " + flow(input_config) + " " + flow(output_config))
+  {
+  }
+
+  const char * name() const override { return "convert"; }
+
+  std::string signature() const override { return signature_; }
+
+  void process(pcl::PointCloud<pcl::PointXYZI> & block) const override
+  {
+    converter_.convert(block, false);
+  }
+
+  bool isDirect() const { return converter_.isDirect(); }
+
+private:
+  static std::string flow(const YAML::Node & config)
+  {
+    YAML::Emitter out;
+
+    out << YAML::Flow << config;
+
+    return out.c_str();
+  }
+
+  PointConverter converter_;
+  std::string signature_;
+};
+
+}  // namespace autoware::pointcloud_projection_converter
+
+#endif  // PROJECTION_STAGE_HPP_
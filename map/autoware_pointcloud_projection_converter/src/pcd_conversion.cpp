@@ -14,58 +14,226 @@
 
 // The original code was written by Koji Minoda
 
-#include "converter_from_llh.hpp"
-#include "converter_to_llh.hpp"
-#include "lat_lon_alt.hpp"
+#include "point_converter.hpp"
 
-#include <GeographicLib/MGRS.hpp>
+#define PCL_NO_PRECOMPILE
+#include <autoware/pointcloud_divider/bounded_queue.hpp>
+#include <autoware/pointcloud_divider/pcd_io.hpp>
+#include <autoware/pointcloud_divider/run_report.hpp>
 
-#include <pcl/io/pcd_io.h>
 #include <pcl/point_types.h>
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <filesystem>
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+using autoware::pointcloud_divider::BoundedQueue;
+using autoware::pointcloud_divider::RunReport;
+using autoware::pointcloud_projection_converter::PointConverter;
+
+typedef pcl::PointCloud<pcl::PointXYZI> PclCloudType;
+
+// Number of points read, converted and written at once
+constexpr size_t block_size = 1000000;
+// Number of blocks buffered between two stages
+constexpr size_t queue_capacity = 2;
+
+// Convert a PCD block by block, so the memory usage is bounded by a few blocks instead of
+// the whole cloud. Reading, converting and writing run in their own threads. The points of
+// a block are converted by OpenMP threads if @parallel_points is true.
+void convertFile(
+  const std::string & input_pcd, const std::string & output_pcd, const PointConverter & converter,
+  bool parallel_points, RunReport & report)
+{
+  autoware::pointcloud_divider::CustomPCDReader<pcl::PointXYZI> reader;
+  autoware::pointcloud_divider::CustomPCDWriter<pcl::PointXYZI> writer;
+
+  reader.setInput(input_pcd);
+  reader.setBlockSize(block_size);
+
+  const size_t point_num = reader.point_num();
+
+  writer.setOutput(output_pcd);
+  writer.writeMetadata(point_num, true);
+
+  BoundedQueue<PclCloudType> read_queue(queue_capacity), write_queue(queue_capacity);
+
+  std::thread read_thread([&]() {
+    size_t read_num = 0;
+
+    while (reader.good() && read_num < point_num) {
+      PclCloudType block;
+
+      {
+        auto timer = report.time("read");
+
+        reader.readABlock(block);
+        report.addPoints("read", block.size());
+      }
+
+      read_num += block.size();
+
+      if (!block.empty() && !read_queue.push(std::move(block))) {
+        break;
+      }
+    }
+
+    read_queue.close();
+    report.addBytes("read", fs::file_size(input_pcd));
+  });
+
+  std::thread write_thread([&]() {
+    PclCloudType block;
+
+    while (write_queue.pop(block)) {
+      auto timer = report.time("write");
+
+      writer.write(block);
+      report.addPoints("write", block.size());
+    }
+  });
+
+  PclCloudType block;
+
+  while (read_queue.pop(block)) {
+    {
+      // The OpenMP threads converting the points are measured by the CPU time of the process
+      auto timer = report.time("convert", parallel_points);
+
+      converter.convert(block, parallel_points);
+      report.addPoints("convert", block.size());
+    }
+
+    write_queue.push(std::move(block));
+  }
+
+  write_queue.close();
+  read_thread.join();
+  write_thread.join();
+  report.addBytes("write", fs::file_size(output_pcd));
+}
+
+// Write the report if a path is given
+void saveReport(RunReport & report, const char * report_path)
+{
+  report.stopProgress();
+
+  if (report_path == nullptr) {
+    return;
+  }
+
+  if (report.save(report_path)) {
+    std::cout << "Saved the run report to " << report_path << std::endl;
+  } else {
+    std::cerr << "Error: Cannot save the run report at " << report_path << std::endl;
+  }
+}
+
+std::vector<std::string> discoverPCDs(const std::string & input_dir)
+{
+  std::vector<std::string> pcd_list;
+
+  for (auto & entry : fs::directory_iterator(input_dir)) {
+    auto extension = entry.path().extension().string();
+
+    if (
+      fs::is_regular_file(entry.symlink_status()) &&
+      (extension == ".pcd" || extension == ".PCD")) {
+      pcd_list.push_back(entry.path().string());
+    }
+  }
+
+  std::sort(pcd_list.begin(), pcd_list.end());
+
+  return pcd_list;
+}
+
+}  // namespace
 
 int main(int argc, char ** argv)
 {
   if (argc < 5) {
     std::cerr << "Usage: ros2 run autoware_pointcloud_projection_converter "
-                 "pointcloud_projection_converter input_pcd output_pcd "
-                 "input_yaml output_yaml"
+                 "pointcloud_projection_converter input_pcd_or_dir output_pcd_or_dir "
+                 "input_yaml output_yaml [report_json [progress_period]]"
               << std::endl;
     std::exit(EXIT_FAILURE);
   }
 
-  // Load point cloud data from file
-  pcl::PointCloud<pcl::PointXYZI>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZI>);
-  if (pcl::io::loadPCDFile<pcl::PointXYZI>(argv[1], *cloud) == -1) {
-    std::cerr << "Couldn't read file " << argv[1] << std::endl;
-    std::exit(EXIT_FAILURE);
-  }
-
   // Parse YAML configuration files
   YAML::Node input_config = YAML::LoadFile(argv[3]);
   YAML::Node output_config = YAML::LoadFile(argv[4]);
 
-  // Define converters
-  autoware::pointcloud_projection_converter::ConverterToLLH to_llh(input_config);
-  autoware::pointcloud_projection_converter::ConverterFromLLH from_llh(output_config);
+  // Define converter
+  PointConverter converter(input_config, output_config);
+
+  if (converter.isDirect()) {
+    std::cout << "Both projections share the same plane, points are translated" << std::endl;
+  }
+
+  // The run report and the period of the progress lines [s] are optional
+  const char * report_path = argc > 5 ? argv[5] : nullptr;
+  RunReport report("pointcloud_projection_converter");
+
+  report.startProgress(argc > 6 ? std::atof(argv[6]) : 0, [](const std::string & line) {
+    std::cout << line << std::endl;
+  });
+
+  if (!fs::is_directory(argv[1])) {
+    convertFile(argv[1], argv[2], converter, true, report);
+    saveReport(report, report_path);
+
+    std::cout << "Point cloud projection conversion completed successfully" << std::endl;
+
+    return 0;
+  }
+
+  // A directory of tiles is converted to a directory of tiles with the same names, one tile
+  // per thread
+  const auto input_pcds = discoverPCDs(argv[1]);
+  const fs::path output_dir(argv[2]);
+
+  fs::create_directories(output_dir);
+
+  const size_t thread_num = std::max<size_t>(
+    std::min<size_t>(std::thread::hardware_concurrency(), input_pcds.size()), 1);
+  std::atomic<size_t> next_file(0);
+  std::vector<std::thread> threads;
+
+  auto worker = [&]() {
+    for (size_t fid = next_file++; fid < input_pcds.size(); fid = next_file++) {
+      const fs::path input_path(input_pcds[fid]);
+      const auto output_path = output_dir / input_path.filename();
+
+      std::cout << "Converting [" << fid + 1 << "/" << input_pcds.size() << "] "
+                << input_path.string() << std::endl;
+      convertFile(input_path.string(), output_path.string(), converter, thread_num == 1, report);
+    }
+  };
+
+  for (size_t i = 1; i < thread_num; ++i) {
+    threads.emplace_back(worker);
+  }
 
-  // Convert points
-  const size_t n_points = cloud->points.size();
+  worker();
 
-#pragma omp parallel for
-  for (size_t i = 0; i < n_points; ++i) {
-    auto & point = cloud->points[i];
-    autoware::pointcloud_projection_converter::LatLonAlt llh = to_llh.convert(point);
-    point = from_llh.convert(llh);
+  for (auto & t : threads) {
+    t.join();
   }
 
-  // Save converted point cloud to file
-  pcl::io::savePCDFileBinary(argv[2], *cloud);
+  saveReport(report, report_path);
 
   std::cout << "Point cloud projection conversion completed successfully" << std::endl;
 
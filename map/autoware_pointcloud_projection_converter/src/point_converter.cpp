@@ -0,0 +1,88 @@
+// Copyright 2025 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "point_converter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace autoware::pointcloud_projection_converter
+{
+
+// Number of points converted per batch
+constexpr size_t batch_size = 4096;
+
+PointConverter::PointConverter(const YAML::Node & input_config, const YAML::Node & output_config)
+: to_llh_(input_config), from_llh_(output_config)
+{
+  int zone;
+  bool northp;
+  double base_x, base_y, central_meridian, origin_x, origin_y;
+
+  if (
+    to_llh_.utmFrame(zone, northp, base_x, base_y) &&
+    from_llh_.transverseMercatorFrame(central_meridian, origin_x, origin_y) &&
+    std::abs(central_meridian - (6 * zone - 183)) < 1e-9) {
+    // UTM coordinates carry a false easting of 500 km, and a false northing of 10000 km in
+    // the southern hemisphere
+    direct_ = true;
+    offset_x_ = base_x - 500000 - origin_x;
+    offset_y_ = base_y - (northp ? 0 : 10000000) - origin_y;
+  }
+}
+
+void PointConverter::convert(pcl::PointCloud<pcl::PointXYZI> & cloud, bool parallel) const
+{
+  const size_t n_points = cloud.size();
+
+  if (direct_) {
+#pragma omp parallel for if (parallel)
+    for (size_t i = 0; i < n_points; ++i) {
+      auto & point = cloud.points[i];
+      point.x = point.x + offset_x_;
+      point.y = point.y + offset_y_;
+    }
+
+    return;
+  }
+
+  const size_t batch_num = (n_points + batch_size - 1) / batch_size;
+
+#pragma omp parallel for if (parallel)
+  for (size_t b = 0; b < batch_num; ++b) {
+    const size_t begin = b * batch_size;
+    const size_t n = std::min(batch_size, n_points - begin);
+    std::vector<double> x(n), y(n), z(n), lat(n), lon(n), alt(n);
+
+    for (size_t i = 0; i < n; ++i) {
+      const auto & point = cloud.points[begin + i];
+      x[i] = point.x;
+      y[i] = point.y;
+      z[i] = point.z;
+    }
+
+    to_llh_.convert(n, x.data(), y.data(), z.data(), lat.data(), lon.data(), alt.data());
+    from_llh_.convert(n, lat.data(), lon.data(), alt.data(), x.data(), y.data(), z.data());
+
+    for (size_t i = 0; i < n; ++i) {
+      auto & point = cloud.points[begin + i];
+      point.x = x[i];
+      point.y = y[i];
+      point.z = z[i];
+    }
+  }
+}
+
+}  // namespace autoware::pointcloud_projection_converter
@@ -0,0 +1,141 @@
+// Copyright 2025 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Transform, reproject, crop, and divide a point cloud map in a single read pass. The stages
+// are applied by the reader threads of the divider to every block before it is binned, so no
+// intermediate cloud is written.
+
+#include "projection_stage.hpp"
+
+#define PCL_NO_PRECOMPILE
+#include <autoware/pointcloud_divider/pcd_divider.hpp>
+#include <autoware/pointcloud_divider/stream_stage.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <pcl/point_types.h>
+#include <yaml-cpp/yaml.h>
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using autoware::pointcloud_divider::AffineTransformStage;
+using autoware::pointcloud_divider::BoxFilterStage;
+using autoware::pointcloud_divider::StreamStagePtr;
+using autoware::pointcloud_projection_converter::ProjectionStage;
+
+// Translation in meters, then rotation in degrees applied as yaw * pitch * roll, the convention
+// of autoware_lanelet2_map_utils
+Eigen::Affine3d loadTransform(const YAML::Node & node)
+{
+  auto value = [&node](const char * key) { return node[key] ? node[key].as<double>() : 0.0; };
+  const double to_rad = M_PI / 180.0;
+
+  Eigen::Matrix3d rot;
+
+  rot = Eigen::AngleAxisd(value("yaw") * to_rad, Eigen::Vector3d::UnitZ()) *
+        Eigen::AngleAxisd(value("pitch") * to_rad, Eigen::Vector3d::UnitY()) *
+        Eigen::AngleAxisd(value("roll") * to_rad, Eigen::Vector3d::UnitX());
+
+  return Eigen::Translation3d(value("x"), value("y"), value("z")) * rot;
+}
+
+std::array<double, 3> loadPoint(const YAML::Node & node)
+{
+  const auto values = node.as<std::vector<double>>();
+
+  if (values.size() != 3) {
+    throw YAML::Exception(node.Mark(), "crop_box bounds must be [x, y, z]");
+  }
+
+  return {values[0], values[1], values[2]};
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc < 4) {
+    std::cerr << "Usage: ros2 run autoware_pointcloud_projection_converter "
+                 "pointcloud_map_pipeline input_pcd_or_dir output_dir pipeline_yaml"
+              << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  rclcpp::init(argc, argv);
+
+  const auto logger = rclcpp::get_logger("pointcloud_map_pipeline");
+  std::vector<StreamStagePtr<pcl::PointXYZI>> stages;
+  YAML::Node pipeline;
+
+  try {
+    pipeline = YAML::LoadFile(argv[3]);
+
+    if (pipeline["transform"]) {
+      stages.push_back(std::make_shared<AffineTransformStage<pcl::PointXYZI>>(
+        loadTransform(pipeline["transform"])));
+    }
+
+    if (pipeline["projection"]) {
+      auto projection = std::make_shared<ProjectionStage>(
+        YAML::LoadFile(pipeline["projection"]["input"].as<std::string>()),
+        YAML::LoadFile(pipeline["projection"]["output"].as<std::string>()));
+
+      if (projection->isDirect()) {
+        std::cout << "Both projections share the same plane, points are translated" << std::endl;
+      }
+
+      stages.push_back(projection);
+    }
+
+    if (pipeline["crop_box"]) {
+      stages.push_back(std::make_shared<BoxFilterStage<pcl::PointXYZI>>(
+        loadPoint(pipeline["crop_box"]["min"]), loadPoint(pipeline["crop_box"]["max"])));
+    }
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR(logger, "Error: Cannot load the pipeline %s: %s", argv[3], e.what());
+    rclcpp::shutdown();
+    std::exit(EXIT_FAILURE);
+  }
+
+  autoware::pointcloud_divider::PCDDivider<pcl::PointXYZI> divider(logger);
+
+  divider.setInput(argv[1]);
+  divider.setOutputDir(argv[2]);
+  divider.setPrefix(pipeline["prefix"] ? pipeline["prefix"].as<std::string>() : "");
+  divider.setConfig(pipeline["divider_config"].as<std::string>());
+  divider.setThreadNum(
+    pipeline["reader_thread_num"] ? pipeline["reader_thread_num"].as<size_t>() : 1,
+    pipeline["worker_thread_num"] ? pipeline["worker_thread_num"].as<size_t>() : 1);
+
+  if (pipeline["report_path"]) {
+    divider.setReport(pipeline["report_path"].as<std::string>());
+  }
+
+  divider.setStages(stages);
+  divider.run();
+
+  rclcpp::shutdown();
+
+  std::cout << "Point cloud map pipeline completed successfully" << std::endl;
+
+  return 0;
+}
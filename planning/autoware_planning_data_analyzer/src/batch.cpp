@@ -0,0 +1,647 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "columns.hpp"
+#include "node.hpp"
+
+#include "autoware/universe_utils/system/stop_watch.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+namespace
+{
+namespace fs = std::filesystem;
+
+// A shard reads the 20 s buffer window of its first step again, so it should be much longer
+constexpr double MIN_SHARD_TIME = 60.0;
+
+// consecutive steps of a bag, analyzed by one worker
+struct Shard
+{
+  size_t bag;
+  size_t begin;
+  size_t end;
+};
+
+struct BagInfo
+{
+  fs::path path;
+  int64_t starting_time;
+  size_t step_num;
+};
+
+// settings shared by all the bags of a run
+struct Context
+{
+  vehicle_info_utils::VehicleInfo vehicle_info;
+  std::shared_ptr<Parameters> parameters;
+  fs::path output_dir;
+  double dt;
+  size_t thread_num;
+  rclcpp::Logger logger;
+};
+
+// Run @task(i) for every i in [0, @num) on up to @thread_num threads
+void parallel_for(
+  const size_t num, const size_t thread_num, const std::function<void(size_t)> & task)
+{
+  std::atomic<size_t> next_id(0);
+
+  auto worker = [&]() {
+    for (size_t id = next_id++; id < num && rclcpp::ok(); id = next_id++) {
+      task(id);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(thread_num, num); i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & t : threads) {
+    t.join();
+  }
+}
+
+// Step through @shard as on_timer does, starting from a fresh BagData whose buffers are filled
+// from the first step of the shard, and call @on_step with the data set of every step
+void step_shard(
+  const BagInfo & bag, const Shard & shard, const Context & context,
+  const std::function<void(int64_t, const DataSet &)> & on_step)
+{
+  const auto dt = static_cast<int64_t>(context.dt * 1e9);
+
+  rosbag2_cpp::Reader reader;
+  reader.open(bag.path.string());
+  set_topic_filter(reader);
+
+  const auto start = bag.starting_time + static_cast<int64_t>(shard.begin) * dt;
+  reader.seek(start);
+
+  const auto bag_data = std::make_shared<BagData>(start);
+
+  // the data set of a step is rebuilt in place for the next step
+  std::optional<DataSet> data_set;
+
+  for (size_t step = shard.begin; step < shard.end && rclcpp::ok(); step++) {
+    bag_data->update(dt);
+
+    fill_buffers(reader, *bag_data, context.logger);
+
+    if (!bag_data->ready()) break;
+
+    if (data_set) {
+      data_set->update(bag_data);
+    } else {
+      data_set.emplace(bag_data, context.vehicle_info, context.parameters);
+    }
+    on_step(bag_data->timestamp, data_set.value());
+  }
+}
+
+// Split the bags of @bag_indices into shards. The bags are processed in parallel, and a bag is
+// split only if there are fewer bags than threads.
+std::vector<Shard> make_shards(
+  const std::vector<BagInfo> & bags, const std::vector<size_t> & bag_indices,
+  const Context & context)
+{
+  std::vector<Shard> shards;
+  if (bag_indices.empty()) {
+    return shards;
+  }
+
+  const size_t shards_per_bag = (context.thread_num + bag_indices.size() - 1) / bag_indices.size();
+  const auto min_shard_steps =
+    std::max<size_t>(static_cast<size_t>(MIN_SHARD_TIME / context.dt), 1);
+
+  for (const auto b : bag_indices) {
+    const auto step_num = bags.at(b).step_num;
+    const auto max_shard_num = std::max<size_t>(step_num / min_shard_steps, 1);
+    const auto shard_num = std::min(shards_per_bag, max_shard_num);
+
+    for (size_t s = 0; s < shard_num; s++) {
+      shards.push_back(Shard{b, step_num * s / shard_num, step_num * (s + 1) / shard_num});
+    }
+  }
+
+  return shards;
+}
+
+// A bag is a directory with a metadata.yaml or a single storage file. Otherwise @bag_path is a
+// directory of bags.
+std::vector<fs::path> discover_bags(fs::path bag_path)
+{
+  if (!bag_path.has_filename()) {
+    bag_path = bag_path.parent_path();
+  }
+
+  if (fs::is_regular_file(bag_path) || fs::exists(bag_path / "metadata.yaml")) {
+    return {bag_path};
+  }
+
+  std::vector<fs::path> bags;
+  for (const auto & entry : fs::directory_iterator(bag_path)) {
+    if (entry.is_directory() && fs::exists(entry.path() / "metadata.yaml")) {
+      bags.push_back(entry.path());
+    }
+  }
+  std::sort(bags.begin(), bags.end());
+
+  return bags;
+}
+
+// Write the metrics and scores of every step of every bag to <output_dir>/<bag>.columns
+bool analyze(const std::vector<BagInfo> & bags, const Context & context)
+{
+  std::vector<size_t> bag_indices(bags.size());
+  std::iota(bag_indices.begin(), bag_indices.end(), 0);
+  const auto shards = make_shards(bags, bag_indices, context);
+
+  std::vector<Columns> results(shards.size());
+  std::vector<char> failed(shards.size(), false);
+
+  parallel_for(shards.size(), context.thread_num, [&](const size_t s) {
+    const auto & bag = bags.at(shards.at(s).bag);
+    try {
+      step_shard(bag, shards.at(s), context, [&](const int64_t timestamp, const auto & data_set) {
+        append_row(results.at(s), timestamp, data_set, *context.parameters);
+      });
+    } catch (const std::exception & e) {
+      RCLCPP_ERROR(context.logger, "failed to analyze %s: %s", bag.path.c_str(), e.what());
+      failed.at(s) = true;
+    }
+  });
+
+  // the shards of a bag are consecutive and in order
+  bool success = true;
+  for (size_t s = 0, b = 0; b < bags.size(); b++) {
+    Columns columns;
+    bool bag_failed = false;
+    for (; s < shards.size() && shards.at(s).bag == b; s++) {
+      bag_failed |= static_cast<bool>(failed.at(s));
+      columns.append(std::move(results.at(s)));
+    }
+
+    const auto output_path = context.output_dir / (bags.at(b).path.stem().string() + ".columns");
+    if (bag_failed || !write_columns(output_path, columns)) {
+      RCLCPP_ERROR(context.logger, "failed to write %s", output_path.c_str());
+      success = false;
+      continue;
+    }
+
+    RCLCPP_INFO(context.logger, "wrote %lu steps to %s", columns.rows, output_path.c_str());
+  }
+
+  RCLCPP_INFO(context.logger, "analyzed %lu bags in %lu shards", bags.size(), shards.size());
+
+  return success;
+}
+
+// Everything that changes the data sets of @bag, so that a stale loss cache is not loaded
+std::string cache_key(const BagInfo & bag, const Context & context)
+{
+  const auto & p = *context.parameters;
+
+  std::ostringstream ss;
+  ss << std::setprecision(17) << "start " << bag.starting_time << " steps " << bag.step_num
+     << " dt " << context.dt << " resample_num " << p.resample_num << " time_resolution "
+     << p.time_resolution << " wheel_base " << context.vehicle_info.wheel_base_m;
+
+  const auto add = [&ss](const std::string & name, const std::vector<double> & values) {
+    ss << " " << name;
+    for (const auto value : values) ss << " " << value;
+  };
+  add("lat_positions", p.target_state.lat_positions);
+  add("lat_velocities", p.target_state.lat_velocities);
+  add("lat_accelerations", p.target_state.lat_accelerations);
+  add("lon_positions", p.target_state.lon_positions);
+  add("lon_velocities", p.target_state.lon_velocities);
+  add("lon_accelerations", p.target_state.lon_accelerations);
+  add(
+    "feasibility",
+    {p.feasibility.max_lateral_acceleration, p.feasibility.max_lateral_jerk,
+     p.feasibility.max_curvature});
+
+  return ss.str();
+}
+
+template <class T>
+void write_vector(std::ofstream & ofs, const std::vector<T> & values)
+{
+  const uint64_t size = values.size();
+  ofs.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  ofs.write(
+    reinterpret_cast<const char *>(values.data()),
+    static_cast<std::streamsize>(size * sizeof(T)));
+}
+
+template <class T>
+bool read_vector(std::ifstream & ifs, std::vector<T> & values)
+{
+  uint64_t size = 0;
+  if (!ifs.read(reinterpret_cast<char *>(&size), sizeof(size))) {
+    return false;
+  }
+
+  values.resize(size);
+  return static_cast<bool>(ifs.read(
+    reinterpret_cast<char *>(values.data()), static_cast<std::streamsize>(size * sizeof(T))));
+}
+
+constexpr const char * LOSS_CACHE_MAGIC = "PLANNING_DATA_ANALYZER_LOSS_CACHE 1";
+
+// The loss cache of a bag is a text header of the magic and the key, followed by the data sets
+bool write_loss_cache(
+  const fs::path & path, const std::string & key, const std::vector<CompactDataSet> & data_sets)
+{
+  const auto tmp_path = path.string() + ".tmp";
+  {
+    std::ofstream ofs(tmp_path, std::ios::binary);
+    if (!ofs) {
+      return false;
+    }
+
+    ofs << LOSS_CACHE_MAGIC << "\n" << key << "\n";
+
+    const uint64_t size = data_sets.size();
+    ofs.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    for (const auto & data_set : data_sets) {
+      ofs.write(reinterpret_cast<const char *>(&data_set.origin_x), sizeof(double));
+      ofs.write(reinterpret_cast<const char *>(&data_set.origin_y), sizeof(double));
+      write_vector(ofs, data_set.score_matrix);
+      write_vector(ofs, data_set.offsets);
+      write_vector(ofs, data_set.x);
+      write_vector(ofs, data_set.y);
+      write_vector(ofs, data_set.manual_x);
+      write_vector(ofs, data_set.manual_y);
+    }
+
+    if (!ofs) {
+      return false;
+    }
+  }
+
+  fs::rename(tmp_path, path);
+  return true;
+}
+
+bool read_loss_cache(
+  const fs::path & path, const std::string & key, std::vector<CompactDataSet> & data_sets)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  std::string magic, cached_key;
+  if (!std::getline(ifs, magic) || !std::getline(ifs, cached_key)) {
+    return false;
+  }
+
+  if (magic != LOSS_CACHE_MAGIC || cached_key != key) {
+    return false;
+  }
+
+  uint64_t size = 0;
+  if (!ifs.read(reinterpret_cast<char *>(&size), sizeof(size))) {
+    return false;
+  }
+
+  data_sets.resize(size);
+  for (auto & data_set : data_sets) {
+    ifs.read(reinterpret_cast<char *>(&data_set.origin_x), sizeof(double));
+    ifs.read(reinterpret_cast<char *>(&data_set.origin_y), sizeof(double));
+    if (
+      !ifs || !read_vector(ifs, data_set.score_matrix) || !read_vector(ifs, data_set.offsets) ||
+      !read_vector(ifs, data_set.x) || !read_vector(ifs, data_set.y) ||
+      !read_vector(ifs, data_set.manual_x) || !read_vector(ifs, data_set.manual_y)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+std::vector<Result> make_weight_grid(const GridSearchParameters & p)
+{
+  std::vector<Result> weight_grid;
+  for (double w0 = p.min; w0 < p.max + 0.1 * p.resolution; w0 += p.resolution) {
+    for (double w1 = p.min; w1 < p.max + 0.1 * p.resolution; w1 += p.resolution) {
+      for (double w2 = p.min; w2 < p.max + 0.1 * p.resolution; w2 += p.resolution) {
+        for (double w3 = p.min; w3 < p.max + 0.1 * p.resolution; w3 += p.resolution) {
+          weight_grid.emplace_back(w0, w1, w2, w3);
+        }
+      }
+    }
+  }
+
+  return weight_grid;
+}
+
+// Search the weight grid against the steps of all the bags. The compact data sets of a bag are
+// computed once and cached in <output_dir>/<bag>.loss_cache, so later searches, e.g. with another
+// grid, read the caches only. The losses of every weight go to <output_dir>/weight_grid.columns.
+bool weight_search(const std::vector<BagInfo> & bags, const Context & context)
+{
+  std::vector<std::vector<CompactDataSet>> data_sets(bags.size());
+  std::vector<std::string> keys(bags.size());
+  std::vector<size_t> uncached;
+
+  for (size_t b = 0; b < bags.size(); b++) {
+    const auto cache_path = context.output_dir / (bags.at(b).path.stem().string() + ".loss_cache");
+    keys.at(b) = cache_key(bags.at(b), context);
+    if (!read_loss_cache(cache_path, keys.at(b), data_sets.at(b))) {
+      data_sets.at(b).clear();
+      uncached.push_back(b);
+    }
+  }
+
+  RCLCPP_INFO(
+    context.logger, "%lu of %lu bags are cached", bags.size() - uncached.size(), bags.size());
+
+  const auto shards = make_shards(bags, uncached, context);
+  std::vector<std::vector<CompactDataSet>> results(shards.size());
+  std::vector<char> failed(shards.size(), false);
+
+  parallel_for(shards.size(), context.thread_num, [&](const size_t s) {
+    const auto & bag = bags.at(shards.at(s).bag);
+    try {
+      step_shard(bag, shards.at(s), context, [&](const int64_t, const auto & data_set) {
+        results.at(s).emplace_back(data_set);
+      });
+    } catch (const std::exception & e) {
+      RCLCPP_ERROR(context.logger, "failed to analyze %s: %s", bag.path.c_str(), e.what());
+      failed.at(s) = true;
+    }
+  });
+
+  for (size_t s = 0; s < shards.size(); s++) {
+    if (failed.at(s)) {
+      return false;
+    }
+
+    auto & bag_data_sets = data_sets.at(shards.at(s).bag);
+    bag_data_sets.insert(
+      bag_data_sets.end(), std::make_move_iterator(results.at(s).begin()),
+      std::make_move_iterator(results.at(s).end()));
+  }
+
+  for (const auto b : uncached) {
+    const auto cache_path = context.output_dir / (bags.at(b).path.stem().string() + ".loss_cache");
+    if (!write_loss_cache(cache_path, keys.at(b), data_sets.at(b))) {
+      RCLCPP_WARN(context.logger, "failed to write %s", cache_path.c_str());
+    }
+  }
+
+  LossTable table;
+  for (const auto & bag_data_sets : data_sets) {
+    for (const auto & data_set : bag_data_sets) {
+      table.add(data_set);
+    }
+  }
+
+  if (table.step_num() == 0) {
+    RCLCPP_ERROR(context.logger, "no data set for the weight search.");
+    return false;
+  }
+
+  auto weight_grid = make_weight_grid(context.parameters->grid_search);
+
+  // the cpu backend runs on the threads of the batch
+  auto grid_search = context.parameters->grid_search;
+  grid_search.thread_num = context.thread_num;
+
+  try {
+    evaluate_weight_grid(table, weight_grid, grid_search, context.logger);
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR(context.logger, "failed to evaluate a weight: %s", e.what());
+    return false;
+  }
+
+  Columns columns;
+  columns.names = {"w0", "w1", "w2", "w3", "loss"};
+  columns.values.resize(columns.names.size());
+  for (const auto & w : weight_grid) {
+    columns.values.at(0).push_back(w.w0);
+    columns.values.at(1).push_back(w.w1);
+    columns.values.at(2).push_back(w.w2);
+    columns.values.at(3).push_back(w.w3);
+    columns.values.at(4).push_back(w.loss);
+  }
+  columns.rows = weight_grid.size();
+
+  const auto output_path = context.output_dir / "weight_grid.columns";
+  if (!write_columns(output_path, columns)) {
+    RCLCPP_ERROR(context.logger, "failed to write %s", output_path.c_str());
+    return false;
+  }
+
+  const auto best = *std::min_element(
+    weight_grid.begin(), weight_grid.end(),
+    [](const auto & a, const auto & b) { return a.loss < b.loss; });
+
+  RCLCPP_INFO(
+    context.logger, "best of %lu weights over %lu steps of %lu bags: [w0]:%.4f [w1]:%.4f "
+    "[w2]:%.4f [w3]:%.4f [loss]:%.4f",
+    weight_grid.size(), table.step_num(), bags.size(), best.w0, best.w1, best.w2, best.w3,
+    best.loss);
+
+  return true;
+}
+
+// Time the stages of the analysis on one thread over the first @step_num steps of the first bag,
+// and report the rate of each stage, so that a change of one stage shows up on its own:
+// reading and deserializing the messages of a step, sampling and scoring the trajectories of a
+// step, selecting the best trajectory for every weight of the grid, and the losses of the grid
+// search.
+bool benchmark(const std::vector<BagInfo> & bags, const Context & context, const size_t step_num)
+{
+  const auto & bag = bags.front();
+  const auto dt = static_cast<int64_t>(context.dt * 1e9);
+  const auto weight_grid = make_weight_grid(context.parameters->grid_search);
+
+  rosbag2_cpp::Reader reader;
+  reader.open(bag.path.string());
+  set_topic_filter(reader);
+  reader.seek(bag.starting_time);
+
+  const auto bag_data = std::make_shared<BagData>(bag.starting_time);
+
+  autoware::universe_utils::StopWatch<std::chrono::microseconds> stop_watch;
+  double read_time = 0.0;
+  double data_set_time = 0.0;
+  double selection_time = 0.0;
+  size_t trajectory_num = 0;
+  size_t pruned_num = 0;
+  std::vector<CompactDataSet> steps;
+  std::optional<DataSet> data_set;
+
+  for (size_t step = 0; step < std::min(step_num, bag.step_num) && rclcpp::ok(); step++) {
+    bag_data->update(dt);
+
+    stop_watch.tic("read");
+    fill_buffers(reader, *bag_data, context.logger);
+    read_time += stop_watch.toc("read");
+
+    // the first steps only fill the buffer window
+    if (!bag_data->ready()) continue;
+
+    stop_watch.tic("data_set");
+    if (data_set) {
+      data_set->update(bag_data);
+    } else {
+      data_set.emplace(bag_data, context.vehicle_info, context.parameters);
+    }
+    data_set_time += stop_watch.toc("data_set");
+    trajectory_num += data_set->sampling.data.size();
+    pruned_num += data_set->sampling.pruned_num;
+
+    size_t found_num = 0;
+    stop_watch.tic("selection");
+    for (const auto & w : weight_grid) {
+      found_num += data_set->sampling.best_index(w.w0, w.w1, w.w2, w.w3).has_value();
+    }
+    selection_time += stop_watch.toc("selection");
+
+    if (found_num == weight_grid.size()) {
+      steps.emplace_back(data_set.value());
+    }
+  }
+
+  if (steps.empty()) {
+    RCLCPP_ERROR(context.logger, "no data set for the benchmark.");
+    return false;
+  }
+
+  stop_watch.tic("loss");
+  double loss = 0.0;
+  for (const auto & w : weight_grid) {
+    for (const auto & step : steps) {
+      loss += step.loss(w.w0, w.w1, w.w2, w.w3);
+    }
+  }
+  const auto loss_time = stop_watch.toc("loss");
+
+  const auto report = [&](const char * stage, const size_t num, const char * unit, double time) {
+    time = std::max(time, 1.0);
+    RCLCPP_INFO(
+      context.logger, "%-14s %10lu %-12s in %10.1f[ms], %12.1f %s/s", stage, num, unit,
+      time * 1e-3, static_cast<double>(num) / (time * 1e-6), unit);
+  };
+
+  RCLCPP_INFO(
+    context.logger,
+    "benchmark of %s, %lu steps, %lu trajectories (%lu pruned), %lu weights (loss %.4g)",
+    bag.path.c_str(), steps.size(), trajectory_num, pruned_num, weight_grid.size(), loss);
+  report("read", std::min(step_num, bag.step_num), "steps", read_time);
+  report("data set", steps.size(), "steps", data_set_time);
+  report("data set", trajectory_num, "trajectories", data_set_time);
+  report("selection", steps.size() * weight_grid.size(), "selections", selection_time);
+  report("loss", steps.size() * weight_grid.size(), "losses", loss_time);
+  report("grid search", weight_grid.size(), "weights", loss_time);
+
+  return true;
+}
+
+bool run(rclcpp::Node & node)
+{
+  const auto bag_path = node.declare_parameter<std::string>("bag_path");
+  const auto mode = node.declare_parameter<std::string>("batch.mode");
+  const Context context{
+    vehicle_info_utils::VehicleInfoUtils(node).getVehicleInfo(),
+    declare_parameters(node),
+    fs::path(node.declare_parameter<std::string>("output_dir")),
+    node.declare_parameter<double>("batch.dt"),
+    static_cast<size_t>(std::max<int64_t>(node.declare_parameter<int>("batch.thread_num"), 1)),
+    node.get_logger()};
+  const auto & logger = context.logger;
+
+  if (context.dt <= 0.0) {
+    RCLCPP_ERROR(logger, "batch.dt must be positive.");
+    return false;
+  }
+
+  std::vector<BagInfo> bags;
+  for (const auto & path : discover_bags(bag_path)) {
+    rosbag2_cpp::Reader reader;
+    reader.open(path.string());
+
+    const auto & metadata = reader.get_metadata();
+    const auto starting_time =
+      duration_cast<nanoseconds>(metadata.starting_time.time_since_epoch()).count();
+    const auto step_num = static_cast<size_t>(metadata.duration.count() / (context.dt * 1e9));
+    bags.push_back(BagInfo{path, starting_time, step_num});
+  }
+
+  if (bags.empty()) {
+    RCLCPP_ERROR(logger, "no bag is found in %s", bag_path.c_str());
+    return false;
+  }
+
+  fs::create_directories(context.output_dir);
+
+  autoware::universe_utils::StopWatch<std::chrono::milliseconds> stop_watch;
+  stop_watch.tic("total_time");
+
+  bool success = false;
+  if (mode == "analyze") {
+    success = analyze(bags, context);
+  } else if (mode == "weight_search") {
+    success = weight_search(bags, context);
+  } else if (mode == "benchmark") {
+    const auto step_num = node.declare_parameter<int>("batch.benchmark_step_num");
+    try {
+      success = benchmark(bags, context, static_cast<size_t>(std::max<int64_t>(step_num, 1)));
+    } catch (const std::exception & e) {
+      RCLCPP_ERROR(logger, "failed to benchmark %s: %s", bags.front().path.c_str(), e.what());
+    }
+  } else {
+    RCLCPP_ERROR(logger, "unknown batch.mode %s", mode.c_str());
+  }
+
+  RCLCPP_INFO(logger, "process time: %.0f[ms]", stop_watch.toc("total_time"));
+
+  return success;
+}
+}  // namespace
+}  // namespace autoware::behavior_analyzer
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+
+  auto node = std::make_shared<rclcpp::Node>("behavior_analyzer_batch");
+  const auto success = autoware::behavior_analyzer::run(*node);
+
+  rclcpp::shutdown();
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,183 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "columns.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+const std::vector<std::pair<METRIC, std::string>> METRIC_COLUMNS{
+  {METRIC::LATERAL_ACCEL, "lateral_accel"},
+  {METRIC::LONGITUDINAL_JERK, "longitudinal_jerk"},
+  {METRIC::TRAVEL_DISTANCE, "travel_distance"},
+  {METRIC::MINIMUM_TTC, "minimum_ttc"}};
+
+const std::vector<std::pair<SCORE, std::string>> SCORE_COLUMNS{
+  {SCORE::LATERAL_COMFORTABILITY, "lateral_comfortability"},
+  {SCORE::LONGITUDINAL_COMFORTABILITY, "longitudinal_comfortability"},
+  {SCORE::EFFICIENCY, "efficiency"},
+  {SCORE::SAFETY, "safety"}};
+
+void append_row(
+  Columns & columns, const int64_t timestamp, const DataSet & data_set, const Parameters & p)
+{
+  constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+
+  size_t column = 0;
+  const auto push = [&](const std::string & name, const double value) {
+    if (columns.rows == 0) {
+      columns.names.push_back(name);
+      columns.values.emplace_back();
+    }
+    columns.values.at(column++).push_back(value);
+  };
+
+  const auto push_metric = [&](const std::string & name, const CommonData * data, const size_t id) {
+    const auto * values = data ? &data->value(id) : nullptr;
+    for (size_t i = 0; i < p.resample_num; i++) {
+      push(
+        name + "." + std::to_string(i), values && i < values->size() ? values->at(i) : nan);
+    }
+  };
+
+  const auto push_data = [&](const std::string & prefix, const CommonData * data) {
+    for (const auto & [metric, name] : METRIC_COLUMNS) {
+      push_metric(prefix + "." + name, data, static_cast<size_t>(metric));
+    }
+
+    // the metrics added to the registry
+    const auto & entries = MetricRegistry::entries();
+    for (size_t id = static_cast<size_t>(METRIC::SIZE); id < entries.size(); id++) {
+      push_metric(prefix + "." + entries.at(id).name, data, id);
+    }
+
+    for (const auto & [score, name] : SCORE_COLUMNS) {
+      push(prefix + "." + name, data ? data->score(score) : nan);
+    }
+
+    push(prefix + ".total", data ? data->total(p.w0, p.w1, p.w2, p.w3) : nan);
+  };
+
+  push("timestamp", static_cast<double>(timestamp) * 1e-9);
+
+  push_data("manual", &data_set.manual);
+
+  push_data("system", data_set.sampling.autoware());
+
+  const auto * best = data_set.sampling.best(p.w0, p.w1, p.w2, p.w3);
+  push_data("best", best);
+
+  // the selected trajectory itself
+  for (size_t i = 0; i < p.resample_num; i++) {
+    const auto * point = best && i < best->points.size() ? &best->points.at(i) : nullptr;
+    push("best.x." + std::to_string(i), point ? point->pose.position.x : nan);
+    push("best.y." + std::to_string(i), point ? point->pose.position.y : nan);
+  }
+
+  columns.rows++;
+}
+
+bool write_columns(std::ostream & ofs, const Columns & columns)
+{
+  ofs << "PLANNING_DATA_ANALYZER_COLUMNS 1\n";
+  ofs << columns.rows << " " << columns.names.size() << "\n";
+  for (const auto & name : columns.names) {
+    ofs << name << "\n";
+  }
+
+  for (const auto & values : columns.values) {
+    ofs.write(
+      reinterpret_cast<const char *>(values.data()),
+      static_cast<std::streamsize>(values.size() * sizeof(double)));
+  }
+
+  return static_cast<bool>(ofs);
+}
+
+bool write_columns(const std::filesystem::path & path, const Columns & columns)
+{
+  std::ofstream ofs(path, std::ios::binary);
+  if (!ofs) {
+    return false;
+  }
+
+  return write_columns(ofs, columns);
+}
+
+ColumnsWriter::ColumnsWriter(const std::filesystem::path & path, const size_t batch_rows)
+: ofs_(path, std::ios::binary), batch_rows_{std::max<size_t>(batch_rows, 1)}
+{
+  thread_ = std::thread(&ColumnsWriter::work, this);
+}
+
+ColumnsWriter::~ColumnsWriter()
+{
+  flush();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+}
+
+void ColumnsWriter::append_row(
+  const int64_t timestamp, const DataSet & data_set, const Parameters & p)
+{
+  behavior_analyzer::append_row(rows_, timestamp, data_set, p);
+
+  if (rows_.rows >= batch_rows_) {
+    flush();
+  }
+}
+
+void ColumnsWriter::flush()
+{
+  if (rows_.rows == 0) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks_.push_back(std::exchange(rows_, Columns{}));
+  }
+  cv_.notify_one();
+}
+
+void ColumnsWriter::work()
+{
+  while (true) {
+    Columns block;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !blocks_.empty(); });
+      if (blocks_.empty()) {
+        return;
+      }
+      block = std::move(blocks_.front());
+      blocks_.pop_front();
+    }
+
+    write_columns(ofs_, block);
+    ofs_.flush();
+  }
+}
+}  // namespace autoware::behavior_analyzer
@@ -0,0 +1,121 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COLUMNS_HPP_
+#define COLUMNS_HPP_
+
+#include "data_structs.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+extern const std::vector<std::pair<METRIC, std::string>> METRIC_COLUMNS;
+
+extern const std::vector<std::pair<SCORE, std::string>> SCORE_COLUMNS;
+
+// metrics and scores of the analyzed steps of a bag, one vector per column
+struct Columns
+{
+  std::vector<std::string> names;
+
+  std::vector<std::vector<double>> values;
+
+  size_t rows{0};
+
+  void append(Columns && other)
+  {
+    if (other.rows == 0) {
+      return;
+    }
+
+    if (rows == 0) {
+      *this = std::move(other);
+      return;
+    }
+
+    for (size_t i = 0; i < values.size(); i++) {
+      values.at(i).insert(values.at(i).end(), other.values.at(i).begin(), other.values.at(i).end());
+    }
+    rows += other.rows;
+  }
+};
+
+// Add the metrics and scores of @data_set as a row. The columns are named by the first row, and
+// the values that are not available, e.g. the system trajectory that was not published, are NaN.
+void append_row(
+  Columns & columns, const int64_t timestamp, const DataSet & data_set, const Parameters & p);
+
+// Write the columns one after another behind a text header:
+//   PLANNING_DATA_ANALYZER_COLUMNS 1
+//   <rows> <columns>
+//   <one column name per line>
+// followed by <rows> native doubles per column.
+bool write_columns(std::ostream & os, const Columns & columns);
+
+bool write_columns(const std::filesystem::path & path, const Columns & columns);
+
+// Stream the rows of the analyzed steps to a file. The rows are buffered, and every @batch_rows
+// rows are written as one block of write_columns by a background thread, so the file is a
+// sequence of blocks. The remaining rows are written by the destructor.
+class ColumnsWriter
+{
+public:
+  ColumnsWriter(const std::filesystem::path & path, const size_t batch_rows);
+
+  ~ColumnsWriter();
+
+  ColumnsWriter(const ColumnsWriter &) = delete;
+
+  ColumnsWriter & operator=(const ColumnsWriter &) = delete;
+
+  bool good() const { return static_cast<bool>(ofs_); }
+
+  void append_row(const int64_t timestamp, const DataSet & data_set, const Parameters & p);
+
+  // hand the buffered rows to the background thread
+  void flush();
+
+private:
+  void work();
+
+  std::ofstream ofs_;
+
+  size_t batch_rows_;
+
+  Columns rows_;
+
+  std::mutex mutex_;
+
+  std::condition_variable cv_;
+
+  std::deque<Columns> blocks_;
+
+  bool stop_{false};
+
+  std::thread thread_;
+};
+}  // namespace autoware::behavior_analyzer
+
+#endif  // COLUMNS_HPP_
@@ -14,9 +14,16 @@
 
 #include "data_structs.hpp"
 
+#include "thread_pool.hpp"
 #include "utils.hpp"
 
+#include <tf2/LinearMath/Quaternion.h>
+
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <string>
@@ -26,6 +33,151 @@
 
 namespace autoware::behavior_analyzer
 {
+namespace
+{
+// positions and velocities of objects in world coordinates, in columns
+struct ObjectStates
+{
+  // overwrite the columns with @objects, keeping their memory
+  void assign(const PredictedObjects & objects)
+  {
+    x.clear();
+    y.clear();
+    z.clear();
+    vx.clear();
+    vy.clear();
+    vz.clear();
+    speed.clear();
+
+    for (const auto & object : objects.objects) {
+      const auto & p = object.kinematics.initial_pose_with_covariance.pose.position;
+      const auto v = utils::get_velocity_in_world_coordinate(object.kinematics);
+      x.push_back(p.x);
+      y.push_back(p.y);
+      z.push_back(p.z);
+      vx.push_back(v.x());
+      vy.push_back(v.y());
+      vz.push_back(v.z());
+      speed.push_back(v.length());
+    }
+  }
+
+  std::vector<double> x, y, z;
+  std::vector<double> vx, vy, vz;
+  std::vector<double> speed;
+};
+
+// The smallest time to collision above 1 ms, as utils::time_to_collision. The closing speed to
+// an object is at most the sum of the speeds, which bounds its time to collision from below, so
+// the objects that can't beat the current minimum are dropped before the exact computation.
+double minimum_time_to_collision(
+  const ObjectStates & objects, const double x, const double y, const double z, const double vx,
+  const double vy, const double vz)
+{
+  const auto ego_speed = std::sqrt(vx * vx + vy * vy + vz * vz);
+
+  double minimum = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < objects.x.size(); i++) {
+    const auto dx = objects.x[i] - x;
+    const auto dy = objects.y[i] - y;
+    const auto dz = objects.z[i] - z;
+    const auto squared_distance = dx * dx + dy * dy + dz * dz;
+    const auto max_closing_speed = ego_speed + objects.speed[i];
+
+    if (squared_distance < std::numeric_limits<double>::epsilon()) {
+      continue;
+    }
+
+    const auto lower_bound = minimum * max_closing_speed;
+    if (lower_bound * lower_bound <= squared_distance) {
+      continue;
+    }
+
+    const auto distance = std::sqrt(squared_distance);
+    const auto closing_speed =
+      (dx * (vx - objects.vx[i]) + dy * (vy - objects.vy[i]) + dz * (vz - objects.vz[i])) /
+      distance;
+    const auto time_to_collision = distance / closing_speed;
+
+    if (time_to_collision < 1e-3) {
+      continue;
+    }
+
+    minimum = std::min(minimum, time_to_collision);
+  }
+
+  return minimum;
+}
+
+void lateral_accel(const CommonData & data, const EgoStates & ego, std::vector<double> & values)
+{
+  values.resize(ego.speed.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    const auto curvature = std::tan(ego.tire_angle.at(i)) / data.vehicle_info.wheel_base_m;
+    values.at(i) = ego.speed.at(i) * ego.speed.at(i) * curvature;
+  }
+}
+
+void longitudinal_accel(const CommonData &, const EgoStates & ego, std::vector<double> & values)
+{
+  values.assign(ego.acceleration.begin(), ego.acceleration.end());
+}
+
+void longitudinal_jerk(const CommonData &, const EgoStates & ego, std::vector<double> & values)
+{
+  values.assign(ego.acceleration.size(), 0.0);
+  for (size_t i = 0; i + 1 < values.size(); i++) {
+    values.at(i) = (ego.acceleration.at(i + 1) - ego.acceleration.at(i)) /
+                   (ego.time.at(i + 1) - ego.time.at(i));
+  }
+}
+
+void travel_distance(const CommonData &, const EgoStates & ego, std::vector<double> & values)
+{
+  values.resize(ego.x.size());
+  double distance = 0.0;
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i > 0) {
+      const auto dx = ego.x.at(i) - ego.x.at(i - 1);
+      const auto dy = ego.y.at(i) - ego.y.at(i - 1);
+      const auto dz = ego.planar_distance ? 0.0 : ego.z.at(i) - ego.z.at(i - 1);
+      distance += std::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+    values.at(i) = distance;
+  }
+}
+
+void minimum_ttc(const CommonData & data, const EgoStates & ego, std::vector<double> & values)
+{
+  // the columns are reused by all the trajectories evaluated on this thread
+  thread_local ObjectStates objects;
+
+  values.resize(ego.x.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    objects.assign(*data.objects_history.at(i));
+    values.at(i) = minimum_time_to_collision(
+      objects, ego.x.at(i), ego.y.at(i), ego.z.at(i), ego.vx.at(i), ego.vy.at(i), ego.vz.at(i));
+  }
+}
+}  // namespace
+
+std::vector<MetricRegistry::Entry> & MetricRegistry::instance()
+{
+  // in the order of METRIC
+  static std::vector<Entry> entries{
+    {"lateral_accel", lateral_accel},
+    {"longitudinal_accel", longitudinal_accel},
+    {"longitudinal_jerk", longitudinal_jerk},
+    {"travel_distance", travel_distance},
+    {"minimum_ttc", minimum_ttc}};
+  return entries;
+}
+
+size_t MetricRegistry::add(const std::string & name, const MetricFunction & function)
+{
+  instance().push_back(Entry{name, function});
+  return instance().size() - 1;
+}
 
 std::string TOPIC::TF = "/tf";                                          // NOLINT
 std::string TOPIC::ODOMETRY = "/localization/kinematic_state";          // NOLINT
@@ -35,97 +187,121 @@ std::string TOPIC::TRAJECTORY = "/planning/trajectory";                 // NOLIN
 std::string TOPIC::STEERING = "/vehicle/status/steering_status";        // NOLINT
                                                                         //
 template <>
-bool Buffer<SteeringReport>::ready() const
+auto Buffer<SteeringReport>::stamp_of(const SteeringReport & msg) -> std::optional<int64_t>
 {
-  if (msgs.empty()) {
-    return false;
-  }
-
-  return rclcpp::Time(msgs.back().stamp).nanoseconds() -
-           rclcpp::Time(msgs.front().stamp).nanoseconds() >
-         BUFFER_TIME;
+  return rclcpp::Time(msg.stamp).nanoseconds();
 }
 
+// a TF message without transforms can't be placed in time, so it isn't buffered
 template <>
-bool Buffer<TFMessage>::ready() const
+auto Buffer<TFMessage>::stamp_of(const TFMessage & msg) -> std::optional<int64_t>
 {
-  if (msgs.empty()) {
-    return false;
+  if (msg.transforms.empty()) {
+    return std::nullopt;
   }
 
-  if (msgs.front().transforms.empty()) {
+  return rclcpp::Time(msg.transforms.front().header.stamp).nanoseconds();
+}
+
+bool TFBuffer::append(const rcutils_uint8_array_t & serialized_msg)
+{
+  if (!Buffer<TFMessage>::append(serialized_msg)) {
     return false;
   }
 
-  if (msgs.back().transforms.empty()) {
-    return false;
+  for (const auto & transform : at(last).transforms) {
+    auto & samples = transforms[{transform.header.frame_id, transform.child_frame_id}];
+    const auto stamp = rclcpp::Time(transform.header.stamp).nanoseconds();
+    const auto itr = std::upper_bound(
+      samples.begin(), samples.end(), stamp,
+      [](const int64_t value, const auto & sample) { return value < sample.first; });
+    samples.emplace(itr, stamp, transform);
   }
 
-  return rclcpp::Time(msgs.back().transforms.front().header.stamp).nanoseconds() -
-           rclcpp::Time(msgs.front().transforms.front().header.stamp).nanoseconds() >
-         BUFFER_TIME;
+  return true;
 }
 
-template <>
-void Buffer<SteeringReport>::remove_old_data(const rcutils_time_point_value_t now)
+void TFBuffer::remove_old_data(const rcutils_time_point_value_t now)
 {
-  if (msgs.empty()) {
-    return;
-  }
+  Buffer<TFMessage>::remove_old_data(now);
 
-  const auto itr = std::remove_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-    return rclcpp::Time(msg.stamp).nanoseconds() < now;
-  });
-  msgs.erase(itr, msgs.end());
+  for (auto & [frames, samples] : transforms) {
+    while (samples.size() > 1 && samples.at(1).first < now) {
+      samples.pop_front();
+    }
+  }
 }
 
-template <>
-void Buffer<TFMessage>::remove_old_data(const rcutils_time_point_value_t now)
+auto TFBuffer::lookup(const rcutils_time_point_value_t now) const -> std::optional<TFMessage>
 {
-  if (msgs.empty()) {
-    return;
-  }
+  TFMessage msg;
 
-  const auto itr = std::remove_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-    return rclcpp::Time(msg.transforms.front().header.stamp).nanoseconds() < now;
-  });
-  msgs.erase(itr, msgs.end());
-}
+  for (const auto & [frames, samples] : transforms) {
+    const auto next = std::upper_bound(
+      samples.begin(), samples.end(), now,
+      [](const int64_t value, const auto & sample) { return value < sample.first; });
 
-template <>
-auto Buffer<SteeringReport>::get(const rcutils_time_point_value_t now) const
-  -> SteeringReport::SharedPtr
-{
-  const auto itr = std::find_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-    return rclcpp::Time(msg.stamp).nanoseconds() > now;
-  });
+    if (next == samples.begin()) {
+      msg.transforms.push_back(next->second);
+      continue;
+    }
 
-  if (itr == msgs.end()) {
-    return nullptr;
-  }
+    const auto & [prev_stamp, prev] = *std::prev(next);
+    if (next == samples.end()) {
+      msg.transforms.push_back(prev);
+      continue;
+    }
 
-  return std::make_shared<SteeringReport>(*itr);
-}
+    const auto ratio =
+      static_cast<double>(now - prev_stamp) / static_cast<double>(next->first - prev_stamp);
+    const auto & a = prev.transform;
+    const auto & b = next->second.transform;
 
-template <>
-auto Buffer<TFMessage>::get(const rcutils_time_point_value_t now) const -> TFMessage::SharedPtr
-{
-  const auto itr = std::find_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-    return rclcpp::Time(msg.transforms.front().header.stamp).nanoseconds() > now;
-  });
+    const auto lerp = [ratio](const double x, const double y) { return x + ratio * (y - x); };
+
+    auto transform = prev;
+    transform.header.stamp = rclcpp::Time(now);
+    transform.transform.translation.x = lerp(a.translation.x, b.translation.x);
+    transform.transform.translation.y = lerp(a.translation.y, b.translation.y);
+    transform.transform.translation.z = lerp(a.translation.z, b.translation.z);
+
+    const auto rotation =
+      tf2::Quaternion(a.rotation.x, a.rotation.y, a.rotation.z, a.rotation.w)
+        .slerp(tf2::Quaternion(b.rotation.x, b.rotation.y, b.rotation.z, b.rotation.w), ratio);
+    transform.transform.rotation.x = rotation.x();
+    transform.transform.rotation.y = rotation.y();
+    transform.transform.rotation.z = rotation.z();
+    transform.transform.rotation.w = rotation.w();
 
-  if (itr == msgs.end()) {
-    return nullptr;
+    msg.transforms.push_back(transform);
   }
 
-  return std::make_shared<TFMessage>(*itr);
+  if (msg.transforms.empty()) {
+    return std::nullopt;
+  }
+
+  return msg;
 }
 
 CommonData::CommonData(
-  const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
+  const std::vector<PredictedObjects::ConstSharedPtr> & objects_history,
+  const vehicle_info_utils::VehicleInfo & vehicle_info,
   const std::shared_ptr<Parameters> & parameters, const std::string & tag)
-: vehicle_info{vehicle_info}, parameters{parameters}, tag{tag}
+: objects_history{objects_history},
+  ego{parameters->resample_num},
+  vehicle_info{vehicle_info},
+  parameters{parameters},
+  tag{tag}
+{
+  values.resize(MetricRegistry::entries().size());
+  scores.resize(static_cast<size_t>(SCORE::SIZE), std::numeric_limits<double>::quiet_NaN());
+}
+
+void CommonData::objects_history_of(
+  const std::shared_ptr<BagData> & bag_data, const std::shared_ptr<Parameters> & parameters,
+  std::vector<PredictedObjects::ConstSharedPtr> & objects_history)
 {
+  objects_history.clear();
   objects_history.reserve(parameters->resample_num);
 
   const auto objects_buffer_ptr = std::dynamic_pointer_cast<Buffer<PredictedObjects>>(
@@ -138,42 +314,56 @@ CommonData::CommonData(
     }
     objects_history.push_back(opt_objects);
   }
+}
 
-  values.resize(static_cast<size_t>(METRIC::SIZE));
-  scores.resize(static_cast<size_t>(SCORE::SIZE));
+void CommonData::reset()
+{
+  for (auto & metric : values) {
+    metric.clear();
+  }
+  std::fill(scores.begin(), scores.end(), std::numeric_limits<double>::quiet_NaN());
 }
 
 void CommonData::calculate()
 {
-  std::vector<double> lateral_accel_values;
-  std::vector<double> minimum_ttc_values;
-  std::vector<double> longitudinal_jerk_values;
-  std::vector<double> travel_distance_values;
+  ego_states(ego);
+}
 
-  for (size_t i = 0; i < parameters->resample_num - 1; i++) {
-    lateral_accel_values.push_back(lateral_accel(i));
-    longitudinal_jerk_values.push_back(longitudinal_jerk(i));
-    minimum_ttc_values.push_back(minimum_ttc(i));
-    travel_distance_values.push_back(travel_distance(i));
+const std::vector<double> & CommonData::value(const size_t id) const
+{
+  auto & metric = values.at(id);
+  if (metric.empty()) {
+    MetricRegistry::entries().at(id).function(*this, ego, metric);
   }
 
-  {
-    lateral_accel_values.push_back(lateral_accel(parameters->resample_num - 1));
-    longitudinal_jerk_values.push_back(0.0);
-    minimum_ttc_values.push_back(minimum_ttc(parameters->resample_num - 1));
-    travel_distance_values.push_back(travel_distance(parameters->resample_num - 1));
+  return metric;
+}
+
+double CommonData::score(const SCORE score) const
+{
+  auto & value = scores.at(static_cast<size_t>(score));
+  if (!std::isnan(value)) {
+    return value;
   }
 
-  values.at(static_cast<size_t>(METRIC::LATERAL_ACCEL)) = lateral_accel_values;
-  values.at(static_cast<size_t>(METRIC::LONGITUDINAL_JERK)) = longitudinal_jerk_values;
-  values.at(static_cast<size_t>(METRIC::MINIMUM_TTC)) = minimum_ttc_values;
-  values.at(static_cast<size_t>(METRIC::TRAVEL_DISTANCE)) = travel_distance_values;
+  switch (score) {
+    case SCORE::LATERAL_COMFORTABILITY:
+      value = lateral_comfortability();
+      break;
+    case SCORE::LONGITUDINAL_COMFORTABILITY:
+      value = longitudinal_comfortability();
+      break;
+    case SCORE::EFFICIENCY:
+      value = efficiency();
+      break;
+    case SCORE::SAFETY:
+      value = safety();
+      break;
+    default:
+      throw std::logic_error("unknown score.");
+  }
 
-  scores.at(static_cast<size_t>(SCORE::LATERAL_COMFORTABILITY)) = lateral_comfortability();
-  scores.at(static_cast<size_t>(SCORE::LONGITUDINAL_COMFORTABILITY)) =
-    longitudinal_comfortability();
-  scores.at(static_cast<size_t>(SCORE::EFFICIENCY)) = efficiency();
-  scores.at(static_cast<size_t>(SCORE::SAFETY)) = safety();
+  return value;
 }
 
 double CommonData::longitudinal_comfortability() const
@@ -191,7 +381,7 @@ double CommonData::longitudinal_comfortability() const
   for (size_t i = 0; i < parameters->resample_num; i++) {
     score += normalize(
       std::pow(TIME_FACTOR, i) *
-      std::abs(values.at(static_cast<size_t>(METRIC::LONGITUDINAL_JERK)).at(i)));
+      std::abs(value(METRIC::LONGITUDINAL_JERK).at(i)));
   }
 
   return score / parameters->resample_num;
@@ -212,7 +402,7 @@ double CommonData::lateral_comfortability() const
   for (size_t i = 0; i < parameters->resample_num; i++) {
     score += normalize(
       std::pow(TIME_FACTOR, i) *
-      std::abs(values.at(static_cast<size_t>(METRIC::LATERAL_ACCEL)).at(i)));
+      std::abs(value(METRIC::LATERAL_ACCEL).at(i)));
   }
 
   return score / parameters->resample_num;
@@ -232,8 +422,7 @@ double CommonData::efficiency() const
 
   for (size_t i = 0; i < parameters->resample_num; i++) {
     score += normalize(
-      std::pow(TIME_FACTOR, i) * values.at(static_cast<size_t>(METRIC::TRAVEL_DISTANCE)).at(i) /
-      0.5);
+      std::pow(TIME_FACTOR, i) * value(METRIC::TRAVEL_DISTANCE).at(i) / 0.5);
   }
 
   return score / parameters->resample_num;
@@ -253,7 +442,7 @@ double CommonData::safety() const
 
   for (size_t i = 0; i < parameters->resample_num; i++) {
     score += normalize(
-      std::pow(TIME_FACTOR, i) * values.at(static_cast<size_t>(METRIC::MINIMUM_TTC)).at(i));
+      std::pow(TIME_FACTOR, i) * value(METRIC::MINIMUM_TTC).at(i));
   }
 
   return score / parameters->resample_num;
@@ -261,17 +450,30 @@ double CommonData::safety() const
 
 double CommonData::total(const double w0, const double w1, const double w2, const double w3) const
 {
-  return w0 * scores.at(static_cast<size_t>(SCORE::LATERAL_COMFORTABILITY)) +
-         w1 * scores.at(static_cast<size_t>(SCORE::LONGITUDINAL_COMFORTABILITY)) +
-         w2 * scores.at(static_cast<size_t>(SCORE::EFFICIENCY)) +
-         w3 * scores.at(static_cast<size_t>(SCORE::SAFETY));
+  double total = 0.0;
+  if (w0 != 0.0) total += w0 * score(SCORE::LATERAL_COMFORTABILITY);
+  if (w1 != 0.0) total += w1 * score(SCORE::LONGITUDINAL_COMFORTABILITY);
+  if (w2 != 0.0) total += w2 * score(SCORE::EFFICIENCY);
+  if (w3 != 0.0) total += w3 * score(SCORE::SAFETY);
+  return total;
 }
 
 ManualDrivingData::ManualDrivingData(
   const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
   const std::shared_ptr<Parameters> & parameters)
-: CommonData(bag_data, vehicle_info, parameters, "manual")
+: CommonData({}, vehicle_info, parameters, "manual")
 {
+  update(bag_data);
+}
+
+void ManualDrivingData::update(const std::shared_ptr<BagData> & bag_data)
+{
+  objects_history_of(bag_data, parameters, objects_history);
+  reset();
+
+  odometry_history.clear();
+  accel_history.clear();
+  steer_history.clear();
   odometry_history.reserve(parameters->resample_num);
   accel_history.reserve(parameters->resample_num);
   steer_history.reserve(parameters->resample_num);
@@ -310,41 +512,25 @@ ManualDrivingData::ManualDrivingData(
   calculate();
 }
 
-double ManualDrivingData::lateral_accel(const size_t idx) const
-{
-  const auto radius =
-    vehicle_info.wheel_base_m / std::tan(steer_history.at(idx)->steering_tire_angle);
-  const auto speed = odometry_history.at(idx)->twist.twist.linear.x;
-  return speed * speed / radius;
-}
-
-double ManualDrivingData::longitudinal_jerk(const size_t idx) const
-{
-  const double dt = rclcpp::Time(accel_history.at(idx + 1)->header.stamp).nanoseconds() -
-                    rclcpp::Time(accel_history.at(idx)->header.stamp).nanoseconds();
-
-  return 1e9 *
-         (accel_history.at(idx + 1)->accel.accel.linear.x -
-          accel_history.at(idx)->accel.accel.linear.x) /
-         dt;
-}
-
-double ManualDrivingData::minimum_ttc(const size_t idx) const
-{
-  const auto p_ego = odometry_history.at(idx)->pose.pose;
-  const auto v_ego = utils::get_velocity_in_world_coordinate(*odometry_history.at(idx));
-
-  return utils::time_to_collision(*objects_history.at(idx), p_ego, v_ego);
-}
-
-double ManualDrivingData::travel_distance(const size_t idx) const
+void ManualDrivingData::ego_states(EgoStates & states) const
 {
-  double distance = 0.0;
-  for (size_t i = 0L; i < idx; i++) {
-    distance += autoware::universe_utils::calcDistance3d(
-      odometry_history.at(i + 1)->pose.pose, odometry_history.at(i)->pose.pose);
+  const auto & t0 = accel_history.at(0)->header.stamp;
+  for (size_t i = 0; i < parameters->resample_num; i++) {
+    const auto & odometry = *odometry_history.at(i);
+    const auto v_world = utils::get_velocity_in_world_coordinate(odometry);
+    states.x.at(i) = odometry.pose.pose.position.x;
+    states.y.at(i) = odometry.pose.pose.position.y;
+    states.z.at(i) = odometry.pose.pose.position.z;
+    states.vx.at(i) = v_world.x();
+    states.vy.at(i) = v_world.y();
+    states.vz.at(i) = v_world.z();
+    states.speed.at(i) = odometry.twist.twist.linear.x;
+    states.tire_angle.at(i) = steer_history.at(i)->steering_tire_angle;
+    states.acceleration.at(i) = accel_history.at(i)->accel.accel.linear.x;
+    states.time.at(i) =
+      (rclcpp::Time(accel_history.at(i)->header.stamp) - rclcpp::Time(t0)).seconds();
   }
-  return distance;
+  states.planar_distance = false;
 }
 
 bool ManualDrivingData::ready() const
@@ -369,41 +555,66 @@ bool ManualDrivingData::ready() const
 }
 
 TrajectoryData::TrajectoryData(
-  const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
+  const std::vector<PredictedObjects::ConstSharedPtr> & objects_history,
+  const vehicle_info_utils::VehicleInfo & vehicle_info,
   const std::shared_ptr<Parameters> & parameters, const std::string & tag,
-  const std::vector<TrajectoryPoint> & points)
-: CommonData(bag_data, vehicle_info, parameters, tag), points{points}
+  std::vector<TrajectoryPoint> points)
+: CommonData(objects_history, vehicle_info, parameters, tag), points{std::move(points)}
 {
   calculate();
 }
 
-double TrajectoryData::lateral_accel(const size_t idx) const
+TrajectoryData::TrajectoryData(
+  const vehicle_info_utils::VehicleInfo & vehicle_info,
+  const std::shared_ptr<Parameters> & parameters)
+: CommonData({}, vehicle_info, parameters, "")
 {
-  const auto radius = vehicle_info.wheel_base_m / std::tan(points.at(idx).front_wheel_angle_rad);
-  const auto speed = points.at(idx).longitudinal_velocity_mps;
-  return speed * speed / radius;
 }
 
-double TrajectoryData::longitudinal_jerk(const size_t idx) const
+void TrajectoryData::update(
+  const std::vector<PredictedObjects::ConstSharedPtr> & objects_history, const std::string & tag)
 {
-  return (points.at(idx + 1).acceleration_mps2 - points.at(idx).acceleration_mps2) / 0.5;
+  this->objects_history = objects_history;
+  this->tag = tag;
+  pruned = false;
+  reset();
+  calculate();
 }
 
-double TrajectoryData::minimum_ttc(const size_t idx) const
+void TrajectoryData::prune(const std::string & tag)
 {
-  const auto p_ego = points.at(idx).pose;
-  const auto v_ego = utils::get_velocity_in_world_coordinate(points.at(idx));
-
-  return utils::time_to_collision(*objects_history.at(idx), p_ego, v_ego);
+  objects_history.clear();
+  points.clear();
+  this->tag = tag;
+  pruned = true;
+  reset();
 }
 
-double TrajectoryData::travel_distance(const size_t idx) const
+void TrajectoryData::ego_states(EgoStates & states) const
 {
-  return autoware::motion_utils::calcSignedArcLength(points, 0L, idx);
+  for (size_t i = 0; i < parameters->resample_num; i++) {
+    const auto & point = points.at(i);
+    const auto v_world = utils::get_velocity_in_world_coordinate(point);
+    states.x.at(i) = point.pose.position.x;
+    states.y.at(i) = point.pose.position.y;
+    states.z.at(i) = point.pose.position.z;
+    states.vx.at(i) = v_world.x();
+    states.vy.at(i) = v_world.y();
+    states.vz.at(i) = v_world.z();
+    states.speed.at(i) = point.longitudinal_velocity_mps;
+    states.tire_angle.at(i) = point.front_wheel_angle_rad;
+    states.acceleration.at(i) = point.acceleration_mps2;
+    states.time.at(i) = 0.5 * i;
+  }
+  states.planar_distance = true;
 }
 
 bool TrajectoryData::feasible() const
 {
+  if (pruned) {
+    return false;
+  }
+
   const auto condition = [](const auto & p) { return p.longitudinal_velocity_mps > -1e-3; };
   return std::all_of(points.begin(), points.end(), condition);
 }
@@ -424,6 +635,13 @@ bool TrajectoryData::ready() const
 SamplingTrajectoryData::SamplingTrajectoryData(
   const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
   const std::shared_ptr<Parameters> & parameters)
+{
+  update(bag_data, vehicle_info, parameters);
+}
+
+void SamplingTrajectoryData::update(
+  const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
+  const std::shared_ptr<Parameters> & parameters)
 {
   const auto opt_odometry = std::dynamic_pointer_cast<Buffer<Odometry>>(
                               bag_data->buffers.at("/localization/kinematic_state"))
@@ -445,22 +663,150 @@ SamplingTrajectoryData::SamplingTrajectoryData(
   if (!opt_trajectory) {
     throw std::logic_error("data is not enough.");
   }
-  data.emplace_back(
-    bag_data, vehicle_info, parameters, "autoware",
-    utils::resampling(
-      *opt_trajectory, opt_odometry->pose.pose, parameters->resample_num,
-      parameters->time_resolution));
+  auto & reference = utils::reference_path(*opt_trajectory, bag_data->reference_path);
+  CommonData::objects_history_of(bag_data, parameters, objects_history);
+  const auto problem = utils::sampling_problem(
+    reference, opt_odometry->pose.pose, opt_odometry->twist.twist.linear.x,
+    opt_accel->accel.accel.linear.x, parameters);
+  const auto sample_num = problem.sampling_parameters.parameters.size();
+
+  // the autoware trajectory, the sampled trajectories and the stop trajectory, in the slots of
+  // the last tick
+  const auto size = sample_num + 2;
+  if (data.size() > size) {
+    data.erase(std::next(data.begin(), static_cast<std::ptrdiff_t>(size)), data.end());
+  }
+  data.reserve(size);
+  while (data.size() < size) {
+    data.emplace_back(vehicle_info, parameters);
+  }
+
+  auto & autoware = data.front();
+  utils::resampling(
+    *opt_trajectory, reference, opt_odometry->pose.pose, parameters->resample_num,
+    parameters->time_resolution, autoware.points);
+  autoware.update(objects_history, "autoware");
+
+  // The sampled trajectories are independent. Each thread builds a contiguous range of them in
+  // their own slots, so the data does not depend on the number of threads.
+  const auto & pool = parameters->thread_pool;
+  const size_t thread_num = pool ? pool->size() : 1;
+  const auto build = [&](const size_t t) {
+    const auto begin = sample_num * t / thread_num;
+    const auto end = sample_num * (t + 1) / thread_num;
+    for (size_t i = begin; i < end; i++) {
+      auto & trajectory = data.at(i + 1);
+      if (!utils::within_limits(reference, problem, i, parameters)) {
+        trajectory.prune("frenet");
+        continue;
+      }
+      utils::sampling(reference, problem, i, vehicle_info, parameters, trajectory.points);
+      trajectory.update(objects_history, "frenet");
+    }
+  };
 
-  for (const auto & sample : utils::sampling(
-         *opt_trajectory, opt_odometry->pose.pose, opt_odometry->twist.twist.linear.x,
-         opt_accel->accel.accel.linear.x, vehicle_info, parameters)) {
-    data.emplace_back(bag_data, vehicle_info, parameters, "frenet", sample);
+  if (pool) {
+    pool->run(build);
+  } else {
+    build(0);
   }
 
-  std::vector<TrajectoryPoint> stop_points(parameters->resample_num);
-  for (auto & stop_point : stop_points) {
+  auto & stop = data.back();
+  stop.points.assign(parameters->resample_num, TrajectoryPoint{});
+  for (auto & stop_point : stop.points) {
     stop_point.pose = opt_odometry->pose.pose;
   }
-  data.emplace_back(bag_data, vehicle_info, parameters, "stop", stop_points);
+  stop.update(objects_history, "stop");
+
+  feasible_indices.clear();
+  pruned_num = 0;
+  for (size_t i = 0; i < data.size(); i++) {
+    pruned_num += data.at(i).pruned ? 1 : 0;
+    if (data.at(i).feasible()) {
+      feasible_indices.push_back(i);
+    }
+  }
+
+  score_matrix.assign(
+    feasible_indices.size() * static_cast<size_t>(SCORE::SIZE),
+    std::numeric_limits<double>::quiet_NaN());
+  score_columns.fill(false);
+}
+
+auto SamplingTrajectoryData::scores(
+  const double w0, const double w1, const double w2, const double w3) const
+  -> const std::vector<double> &
+{
+  const std::array<double, static_cast<size_t>(SCORE::SIZE)> weights{w0, w1, w2, w3};
+  const auto n = feasible_indices.size();
+
+  for (size_t j = 0; j < weights.size(); j++) {
+    if (weights.at(j) == 0.0 || score_columns.at(j)) {
+      continue;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+      score_matrix.at(j * n + i) = data.at(feasible_indices.at(i)).score(static_cast<SCORE>(j));
+    }
+    score_columns.at(j) = true;
+  }
+
+  return score_matrix;
+}
+
+CompactDataSet::CompactDataSet(const DataSet & data_set)
+: score_matrix{data_set.sampling.scores(1.0, 1.0, 1.0, 1.0)}
+{
+  const auto & odometry_history = data_set.manual.odometry_history;
+  if (!odometry_history.empty()) {
+    origin_x = odometry_history.front()->pose.pose.position.x;
+    origin_y = odometry_history.front()->pose.pose.position.y;
+  }
+
+  for (const auto & odometry : odometry_history) {
+    manual_x.push_back(static_cast<float>(odometry->pose.pose.position.x - origin_x));
+    manual_y.push_back(static_cast<float>(odometry->pose.pose.position.y - origin_y));
+  }
+
+  offsets.push_back(0);
+  for (const auto i : data_set.sampling.feasible_indices) {
+    for (const auto & point : data_set.sampling.data.at(i).points) {
+      x.push_back(static_cast<float>(point.pose.position.x - origin_x));
+      y.push_back(static_cast<float>(point.pose.position.y - origin_y));
+    }
+    offsets.push_back(x.size());
+  }
+}
+
+auto CompactDataSet::loss(const double w0, const double w1, const double w2, const double w3) const
+  -> double
+{
+  const auto best = best_column(score_matrix, w0, w1, w2, w3);
+  if (!best.has_value()) {
+    throw std::logic_error("no found best trajectory.");
+  }
+
+  const auto mse = candidate_loss(best.value());
+  if (!std::isfinite(mse)) {
+    throw std::logic_error("loss value is invalid.");
+  }
+
+  return mse;
+}
+
+auto CompactDataSet::candidate_loss(const size_t column) const -> double
+{
+  const auto begin = offsets.at(column);
+  const auto size = offsets.at(column + 1) - begin;
+  const auto min_size = std::min<size_t>(manual_x.size(), size);
+
+  double mse = 0.0;
+  for (size_t i = 0; i < min_size; i++) {
+    const double dx = manual_x.at(i) - x.at(begin + i);
+    const double dy = manual_y.at(i) - y.at(begin + i);
+    mse = (mse * i + dx * dx + dy * dy) / (i + 1);
+  }
+
+  return mse;
 }
 }  // namespace autoware::behavior_analyzer
@@ -18,11 +18,18 @@
 #include "type_alias.hpp"
 
 #include <autoware/universe_utils/geometry/geometry.hpp>
+#include <rmw/rmw.h>
+#include <rosidl_typesupport_cpp/message_type_support.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -74,6 +81,14 @@ struct TargetStateParameters
   std::vector<double> lon_accelerations{};
 };
 
+struct CoarseToFineParameters
+{
+  size_t num{5};
+  double shrink{0.5};
+  double tolerance{1e-6};
+  size_t max_iteration{20};
+};
+
 struct GridSearchParameters
 {
   double min{0.0};
@@ -81,8 +96,23 @@ struct GridSearchParameters
   double resolution{0.01};
   double dt{1.0};
   size_t thread_num{4};
+  std::string mode{"exhaustive"};
+  // cpu, or cuda if built with BEHAVIOR_ANALYZER_USE_CUDA
+  std::string backend{"cpu"};
+  CoarseToFineParameters coarse_to_fine{};
 };
 
+// Limits on the frenet polynomials of a sampled trajectory, checked before it is generated. A
+// candidate out of them is infeasible and is neither generated, resampled nor measured.
+struct FeasibilityParameters
+{
+  double max_lateral_acceleration{std::numeric_limits<double>::infinity()};  // [m/s^2]
+  double max_lateral_jerk{std::numeric_limits<double>::infinity()};          // [m/s^3]
+  double max_curvature{std::numeric_limits<double>::infinity()};             // [1/m]
+};
+
+class ThreadPool;
+
 struct Parameters
 {
   size_t resample_num{20};
@@ -93,6 +123,9 @@ struct Parameters
   double w3{1.0};
   GridSearchParameters grid_search{};
   TargetStateParameters target_state{};
+  FeasibilityParameters feasibility{};
+  // generates the sampled trajectories of a data set in parallel, null to generate them in turn
+  std::shared_ptr<ThreadPool> thread_pool{};
 };
 
 struct Result
@@ -112,74 +145,173 @@ struct BufferBase
 {
   virtual bool ready() const = 0;
   virtual void remove_old_data(const rcutils_time_point_value_t now) = 0;
+  virtual bool append(const rcutils_uint8_array_t & serialized_msg) = 0;
 };
 
 template <typename T>
 struct Buffer : BufferBase
 {
-  std::vector<T> msgs;
+  // The messages are kept sorted by stamp in a ring of slots. Old messages are dropped from
+  // the front in constant time, and a new message is deserialized into a recycled slot so that
+  // the memory of the message is reused.
+  std::vector<T> slots;
+
+  std::vector<int64_t> stamps;
+
+  // Copies of the slots handed out by get(). A message is copied once when it first enters the
+  // window, then shared by every history of the following ticks until it leaves the ring.
+  mutable std::vector<typename T::ConstSharedPtr> shared;
+
+  size_t head{0};
+
+  size_t count{0};
+
+  // position of the message of the last successful append
+  size_t last{0};
+
+  const rosidl_message_type_support_t * type_support{
+    rosidl_typesupport_cpp::get_message_type_support_handle<T>()};
 
   const double BUFFER_TIME = 20.0 * 1e9;
 
+  static std::optional<int64_t> stamp_of(const T & msg)
+  {
+    return rclcpp::Time(msg.header.stamp).nanoseconds();
+  }
+
+  size_t index(const size_t i) const { return (head + i) % slots.size(); }
+
+  const T & at(const size_t i) const { return slots.at(index(i)); }
+
   bool ready() const override
   {
-    if (msgs.empty()) {
+    if (count == 0) {
       return false;
     }
 
-    return rclcpp::Time(msgs.back().header.stamp).nanoseconds() -
-             rclcpp::Time(msgs.front().header.stamp).nanoseconds() >
-           BUFFER_TIME;
+    return stamps.at(index(count - 1)) - stamps.at(index(0)) > BUFFER_TIME;
   }
 
   void remove_old_data(const rcutils_time_point_value_t now) override
   {
-    const auto itr = std::remove_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-      return rclcpp::Time(msg.header.stamp).nanoseconds() < now;
-    });
-    msgs.erase(itr, msgs.end());
+    while (count > 0 && stamps.at(head) < now) {
+      shared.at(head).reset();
+      head = (head + 1) % slots.size();
+      count--;
+    }
   }
 
-  void append(const T & msg) { msgs.push_back(msg); }
+  bool append(const rcutils_uint8_array_t & serialized_msg) override
+  {
+    if (count == slots.size()) {
+      grow();
+    }
+
+    auto & slot = slots.at(index(count));
+    shared.at(index(count)).reset();
+    if (rmw_deserialize(&serialized_msg, type_support, &slot) != RMW_RET_OK) {
+      return false;
+    }
+
+    const auto stamp = stamp_of(slot);
+    if (!stamp) {
+      return false;
+    }
+
+    stamps.at(index(count)) = stamp.value();
+    count++;
+
+    // keep the order even if a message is recorded later than a newer one
+    last = count - 1;
+    for (; last > 0 && stamps.at(index(last - 1)) > stamps.at(index(last)); last--) {
+      std::swap(slots.at(index(last - 1)), slots.at(index(last)));
+      std::swap(stamps.at(index(last - 1)), stamps.at(index(last)));
+      std::swap(shared.at(index(last - 1)), shared.at(index(last)));
+    }
+
+    return true;
+  }
 
-  auto get(const rcutils_time_point_value_t now) const -> typename T::SharedPtr
+  // the first message newer than @now
+  auto get(const rcutils_time_point_value_t now) const -> typename T::ConstSharedPtr
   {
-    const auto itr = std::find_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-      return rclcpp::Time(msg.header.stamp).nanoseconds() > now;
-    });
+    size_t lower = 0;
+    size_t upper = count;
+    while (lower < upper) {
+      const auto mid = (lower + upper) / 2;
+      if (stamps.at(index(mid)) > now) {
+        upper = mid;
+      } else {
+        lower = mid + 1;
+      }
+    }
 
-    if (itr == msgs.end()) {
+    if (lower == count) {
       return nullptr;
     }
 
-    return std::make_shared<T>(*itr);
+    auto & message = shared.at(index(lower));
+    if (!message) {
+      message = std::make_shared<const T>(at(lower));
+    }
+
+    return message;
+  }
+
+private:
+  void grow()
+  {
+    const size_t capacity = std::max<size_t>(16, 2 * slots.size());
+    std::vector<T> new_slots(capacity);
+    std::vector<int64_t> new_stamps(capacity);
+    std::vector<typename T::ConstSharedPtr> new_shared(capacity);
+
+    for (size_t i = 0; i < count; i++) {
+      new_slots.at(i) = std::move(slots.at(index(i)));
+      new_stamps.at(i) = stamps.at(index(i));
+      new_shared.at(i) = std::move(shared.at(index(i)));
+    }
+
+    slots = std::move(new_slots);
+    stamps = std::move(new_stamps);
+    shared = std::move(new_shared);
+    head = 0;
   }
 };
 
 template <>
-bool Buffer<SteeringReport>::ready() const;
+auto Buffer<SteeringReport>::stamp_of(const SteeringReport & msg) -> std::optional<int64_t>;
 
 template <>
-bool Buffer<TFMessage>::ready() const;
+auto Buffer<TFMessage>::stamp_of(const TFMessage & msg) -> std::optional<int64_t>;
 
-template <>
-void Buffer<SteeringReport>::remove_old_data(const rcutils_time_point_value_t now);
+// The TF messages of a bag mix the frame pairs of several publishers at different rates, so the
+// transforms are also indexed by frame pair, sorted by their own stamps. A pair is looked up by a
+// binary search and interpolated, whichever message it came in.
+struct TFBuffer : Buffer<TFMessage>
+{
+  bool append(const rcutils_uint8_array_t & serialized_msg) override;
 
-template <>
-void Buffer<TFMessage>::remove_old_data(const rcutils_time_point_value_t now);
+  // the last transform of a pair before @now is kept to interpolate at @now
+  void remove_old_data(const rcutils_time_point_value_t now) override;
 
-template <>
-auto Buffer<SteeringReport>::get(const rcutils_time_point_value_t now) const
-  -> SteeringReport::SharedPtr;
+  // the transform of every frame pair at @now, interpolated between the transforms of the pair
+  // around @now, or the nearest transform of the pair if @now is out of its range
+  auto lookup(const rcutils_time_point_value_t now) const -> std::optional<TFMessage>;
 
-template <>
-auto Buffer<TFMessage>::get(const rcutils_time_point_value_t now) const -> TFMessage::SharedPtr;
+  // (frame_id, child_frame_id) -> (stamp, transform)
+  std::map<
+    std::pair<std::string, std::string>, std::deque<std::pair<int64_t, TransformStamped>>>
+    transforms;
+};
+
+struct ReferencePath;
 
 struct BagData
 {
   explicit BagData(const rcutils_time_point_value_t timestamp) : timestamp{timestamp}
   {
-    buffers.emplace(TOPIC::TF, std::make_shared<Buffer<TFMessage>>());
+    buffers.emplace(TOPIC::TF, std::make_shared<TFBuffer>());
     buffers.emplace(TOPIC::ODOMETRY, std::make_shared<Buffer<Odometry>>());
     buffers.emplace(TOPIC::ACCELERATION, std::make_shared<Buffer<AccelWithCovarianceStamped>>());
     buffers.emplace(TOPIC::TRAJECTORY, std::make_shared<Buffer<Trajectory>>());
@@ -191,6 +323,9 @@ struct BagData
 
   rcutils_time_point_value_t timestamp;
 
+  // reference path of the trajectory message sampled by the last tick, see utils::reference_path
+  std::shared_ptr<ReferencePath> reference_path{};
+
   void update(const rcutils_time_point_value_t dt)
   {
     timestamp += dt;
@@ -211,14 +346,85 @@ struct BagData
   }
 };
 
+// states of the ego vehicle at the resampled times in columns, from which the metrics are derived
+struct EgoStates
+{
+  explicit EgoStates(const size_t size)
+  : x(size), y(size), z(size), vx(size), vy(size), vz(size), speed(size), tire_angle(size),
+    acceleration(size), time(size)
+  {
+  }
+
+  std::vector<double> x, y, z;
+  std::vector<double> vx, vy, vz;  // velocity in world coordinates
+  std::vector<double> speed;       // longitudinal
+  std::vector<double> tire_angle;
+  std::vector<double> acceleration;
+  std::vector<double> time;
+  bool planar_distance{true};
+};
+
+struct CommonData;
+
+// A metric writes one value per resampled time to @values. The values are empty when the metric is
+// called, and keep the memory of the trajectory that was computed in the same slot last tick.
+using MetricFunction = std::function<void(
+  const CommonData & data, const EgoStates & ego, std::vector<double> & values)>;
+
+// The metrics by id. The ids of the built-in metrics are their METRIC, and add() gives the next
+// id, so that a metric is added without editing this file. The metrics must be added before the
+// first data set is created, since the registry is not locked.
+class MetricRegistry
+{
+public:
+  struct Entry
+  {
+    std::string name;
+    MetricFunction function;
+  };
+
+  static size_t add(const std::string & name, const MetricFunction & function);
+
+  static const std::vector<Entry> & entries() { return instance(); }
+
+private:
+  static std::vector<Entry> & instance();
+};
+
+// The metrics and the scores are computed on first use and memoized, so that a score with a zero
+// weight and the metric it depends on are never computed for the sampled trajectories. A score
+// declares its metrics by reading them with value().
+//
+// The data of a tick is rebuilt in place for the next tick by the update() of the derived classes,
+// so that the histories, the ego states and the metrics keep their memory from tick to tick.
 struct CommonData
 {
   CommonData(
-    const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
+    const std::vector<PredictedObjects::ConstSharedPtr> & objects_history,
+    const vehicle_info_utils::VehicleInfo & vehicle_info,
     const std::shared_ptr<Parameters> & parameters, const std::string & tag);
 
+  // objects at the resampled times, written to @objects_history. Reading a buffer is not thread
+  // safe, so the data sets built concurrently share the history read beforehand.
+  static void objects_history_of(
+    const std::shared_ptr<BagData> & bag_data, const std::shared_ptr<Parameters> & parameters,
+    std::vector<PredictedObjects::ConstSharedPtr> & objects_history);
+
+  // forget the memoized values of the last data, keeping their memory
+  void reset();
+
+  // fill the ego states, called by the constructors of the derived classes
   void calculate();
 
+  const std::vector<double> & value(const size_t id) const;
+
+  const std::vector<double> & value(const METRIC metric) const
+  {
+    return value(static_cast<size_t>(metric));
+  }
+
+  double score(const SCORE score) const;
+
   double longitudinal_comfortability() const;
 
   double lateral_comfortability() const;
@@ -227,29 +433,24 @@ struct CommonData
 
   double safety() const;
 
+  // the scores of the zero weights are not computed
   double total(const double w0, const double w1, const double w2, const double w3) const;
 
-  virtual double lateral_accel(const size_t idx) const = 0;
-
-  virtual double longitudinal_jerk(const size_t idx) const = 0;
-
-  virtual double minimum_ttc(const size_t idx) const = 0;
-
-  virtual double travel_distance(const size_t idx) const = 0;
+  virtual void ego_states(EgoStates & states) const = 0;
 
   virtual bool feasible() const = 0;
 
   virtual bool ready() const = 0;
 
-  std::vector<PredictedObjects::SharedPtr> objects_history;
+  std::vector<PredictedObjects::ConstSharedPtr> objects_history;
 
-  std::vector<std::vector<double>> values;
+  EgoStates ego;
 
-  std::vector<double> scores;
+  // empty until computed
+  mutable std::vector<std::vector<double>> values;
 
-  // std::unordered_map<METRIC, std::vector<double>> values;
-
-  // std::unordered_map<SCORE, double> scores;
+  // NaN until computed
+  mutable std::vector<double> scores;
 
   vehicle_info_utils::VehicleInfo vehicle_info;
 
@@ -264,82 +465,141 @@ struct ManualDrivingData : CommonData
     const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
     const std::shared_ptr<Parameters> & parameters);
 
-  double lateral_accel(const size_t idx) const override;
-
-  double longitudinal_jerk(const size_t idx) const override;
+  // rebuild the data at the timestamp of @bag_data
+  void update(const std::shared_ptr<BagData> & bag_data);
 
-  double minimum_ttc(const size_t idx) const override;
-
-  double travel_distance(const size_t idx) const override;
+  void ego_states(EgoStates & states) const override;
 
   bool feasible() const override { return true; }
 
   bool ready() const override;
 
-  std::vector<Odometry::SharedPtr> odometry_history;
-  std::vector<AccelWithCovarianceStamped::SharedPtr> accel_history;
-  std::vector<SteeringReport::SharedPtr> steer_history;
+  std::vector<Odometry::ConstSharedPtr> odometry_history;
+  std::vector<AccelWithCovarianceStamped::ConstSharedPtr> accel_history;
+  std::vector<SteeringReport::ConstSharedPtr> steer_history;
 };
 
 struct TrajectoryData : CommonData
 {
   TrajectoryData(
-    const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
+    const std::vector<PredictedObjects::ConstSharedPtr> & objects_history,
+    const vehicle_info_utils::VehicleInfo & vehicle_info,
     const std::shared_ptr<Parameters> & parameters, const std::string & tag,
-    const std::vector<TrajectoryPoint> & points);
+    std::vector<TrajectoryPoint> points);
 
-  double lateral_accel(const size_t idx) const override;
+  // an empty slot, which is filled by update()
+  TrajectoryData(
+    const vehicle_info_utils::VehicleInfo & vehicle_info,
+    const std::shared_ptr<Parameters> & parameters);
 
-  double longitudinal_jerk(const size_t idx) const override;
+  // rebuild the data from the points written to @points
+  void update(
+    const std::vector<PredictedObjects::ConstSharedPtr> & objects_history, const std::string & tag);
 
-  double minimum_ttc(const size_t idx) const override;
+  // leave the slot without points, as a candidate rejected before it was generated
+  void prune(const std::string & tag);
 
-  double travel_distance(const size_t idx) const override;
+  void ego_states(EgoStates & states) const override;
 
   bool feasible() const override;
 
   bool ready() const override;
 
   std::vector<TrajectoryPoint> points;
+
+  bool pruned{false};
 };
 
+// column of the highest total score in @score_matrix, which holds one column of values per SCORE.
+// The columns of the zero weights are skipped, so they may be missing, i.e. NaN.
+inline auto best_column(
+  const std::vector<double> & score_matrix, const double w0, const double w1, const double w2,
+  const double w3) -> std::optional<size_t>
+{
+  const auto n = score_matrix.size() / static_cast<size_t>(SCORE::SIZE);
+  if (n == 0) return std::nullopt;
+
+  const auto * lat = score_matrix.data() + n * static_cast<size_t>(SCORE::LATERAL_COMFORTABILITY);
+  const auto * lon =
+    score_matrix.data() + n * static_cast<size_t>(SCORE::LONGITUDINAL_COMFORTABILITY);
+  const auto * efficiency = score_matrix.data() + n * static_cast<size_t>(SCORE::EFFICIENCY);
+  const auto * safety = score_matrix.data() + n * static_cast<size_t>(SCORE::SAFETY);
+
+  size_t best = 0;
+  double best_total = std::numeric_limits<double>::lowest();
+  for (size_t i = 0; i < n; i++) {
+    double total = 0.0;
+    if (w0 != 0.0) total += w0 * lat[i];
+    if (w1 != 0.0) total += w1 * lon[i];
+    if (w2 != 0.0) total += w2 * efficiency[i];
+    if (w3 != 0.0) total += w3 * safety[i];
+    if (total > best_total) {
+      best_total = total;
+      best = i;
+    }
+  }
+
+  return best;
+}
+
 struct SamplingTrajectoryData
 {
   SamplingTrajectoryData(
     const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
     const std::shared_ptr<Parameters> & parameters);
 
-  auto best(const double w0, const double w1, const double w2, const double w3) const
-    -> std::optional<TrajectoryData>
-  {
-    auto sort_by_score = data;
-
-    std::sort(
-      sort_by_score.begin(), sort_by_score.end(),
-      [&w0, &w1, &w2, &w3](const auto & a, const auto & b) {
-        return a.total(w0, w1, w2, w3) > b.total(w0, w1, w2, w3);
-      });
-
-    const auto itr = std::remove_if(
-      sort_by_score.begin(), sort_by_score.end(), [](const auto & d) { return !d.feasible(); });
-
-    sort_by_score.erase(itr, sort_by_score.end());
+  // Rebuild the trajectories at the timestamp of @bag_data. The trajectories of the last tick are
+  // recycled, so a new one is only allocated when there are more trajectories than ever before.
+  void update(
+    const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
+    const std::shared_ptr<Parameters> & parameters);
 
-    if (sort_by_score.empty()) return std::nullopt;
+  // index of the feasible trajectory with the highest total score
+  auto best_index(const double w0, const double w1, const double w2, const double w3) const
+    -> std::optional<size_t>
+  {
+    const auto best = best_column(scores(w0, w1, w2, w3), w0, w1, w2, w3);
+    if (!best.has_value()) return std::nullopt;
+    return feasible_indices.at(best.value());
+  }
 
-    return sort_by_score.front();
+  // the trajectories are not copied, so the pointers are valid until the next update()
+  auto best(const double w0, const double w1, const double w2, const double w3) const
+    -> const TrajectoryData *
+  {
+    const auto index = best_index(w0, w1, w2, w3);
+    if (!index.has_value()) return nullptr;
+    return &data.at(index.value());
   }
 
-  auto autoware() const -> std::optional<TrajectoryData>
+  auto autoware() const -> const TrajectoryData *
   {
     const auto itr = std::find_if(data.begin(), data.end(), [](const auto & trajectory) {
       return trajectory.tag == "autoware";
     });
-    if (itr == data.end()) return std::nullopt;
-    return *itr;
+    if (itr == data.end()) return nullptr;
+    return &*itr;
   }
 
+  // score_matrix with the columns of the nonzero weights, which are computed on first use
+  auto scores(const double w0, const double w1, const double w2, const double w3) const
+    -> const std::vector<double> &;
+
   std::vector<TrajectoryData> data;
+
+  // objects at the resampled times, shared by all the trajectories
+  std::vector<PredictedObjects::ConstSharedPtr> objects_history;
+
+  // scores of the feasible trajectories, one column of feasible_indices.size() values per SCORE,
+  // so that the totals of all the trajectories are a single matrix-vector product
+  mutable std::vector<double> score_matrix;
+
+  mutable std::array<bool, static_cast<size_t>(SCORE::SIZE)> score_columns{};
+
+  std::vector<size_t> feasible_indices;
+
+  // number of the sampled trajectories rejected by the feasibility limits before generation
+  size_t pruned_num{0};
 };
 
 struct DataSet
@@ -353,26 +613,42 @@ struct DataSet
   {
   }
 
+  // Rebuild the data set at the timestamp of @bag_data in place, reusing the memory of the last
+  // tick. If it throws, the data set is left half updated and must be updated again before use.
+  void update(const std::shared_ptr<BagData> & bag_data)
+  {
+    manual.update(bag_data);
+    sampling.update(bag_data, manual.vehicle_info, parameters);
+  }
+
   auto loss(const double w0, const double w1, const double w2, const double w3) const -> double
   {
-    const auto best = sampling.best(w0, w1, w2, w3);
+    const auto best = best_column(sampling.scores(w0, w1, w2, w3), w0, w1, w2, w3);
     if (!best.has_value()) {
       throw std::logic_error("no found best trajectory.");
     }
 
-    const auto min_size = std::min(manual.odometry_history.size(), best.value().points.size());
+    const auto mse = candidate_loss(best.value());
+    if (!std::isfinite(mse)) {
+      throw std::logic_error("loss value is invalid.");
+    }
+
+    return mse;
+  }
+
+  // the loss of the @column-th feasible trajectory, whatever the weights that select it
+  auto candidate_loss(const size_t column) const -> double
+  {
+    const auto & candidate = sampling.data.at(sampling.feasible_indices.at(column));
+    const auto min_size = std::min(manual.odometry_history.size(), candidate.points.size());
 
     double mse = 0.0;
     for (size_t i = 0; i < min_size; i++) {
       const auto & p1 = manual.odometry_history.at(i)->pose.pose;
-      const auto & p2 = best.value().points.at(i);
+      const auto & p2 = candidate.points.at(i);
       mse = (mse * i + autoware::universe_utils::calcSquaredDistance2d(p1, p2)) / (i + 1);
     }
 
-    if (!std::isfinite(mse)) {
-      throw std::logic_error("loss value is invalid.");
-    }
-
     return mse;
   }
 
@@ -382,6 +658,36 @@ struct DataSet
   std::shared_ptr<Parameters> parameters;
 };
 
+// The part of a DataSet that its loss reads: the score matrix, the points of the feasible
+// trajectories and the manual odometry. It is small enough to keep the data sets of many bags in
+// memory and on disk, so the points are single precision, relative to the first manual position.
+struct CompactDataSet
+{
+  CompactDataSet() = default;
+
+  explicit CompactDataSet(const DataSet & data_set);
+
+  // same as DataSet::loss
+  auto loss(const double w0, const double w1, const double w2, const double w3) const -> double;
+
+  // same as DataSet::candidate_loss
+  auto candidate_loss(const size_t column) const -> double;
+
+  double origin_x{0.0};
+  double origin_y{0.0};
+
+  // as SamplingTrajectoryData::score_matrix
+  std::vector<double> score_matrix;
+
+  // the points of the i-th feasible trajectory are [offsets[i], offsets[i + 1])
+  std::vector<uint64_t> offsets;
+  std::vector<float> x;
+  std::vector<float> y;
+
+  std::vector<float> manual_x;
+  std::vector<float> manual_y;
+};
+
 }  // namespace autoware::behavior_analyzer
 
 #endif  // DATA_STRUCTS_HPP_
@@ -0,0 +1,139 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "device_loss_table.hpp"
+#include "loss_kernel.hpp"
+
+#include <cuda_runtime.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+namespace
+{
+constexpr int BLOCK_SIZE = 256;
+
+void check(const cudaError_t error, const char * what)
+{
+  if (error != cudaSuccess) {
+    throw std::runtime_error(std::string(what) + ": " + cudaGetErrorString(error));
+  }
+}
+
+template <class T>
+auto upload(const std::vector<T> & host) -> T *
+{
+  T * device = nullptr;
+  check(cudaMalloc(&device, std::max<size_t>(host.size(), 1) * sizeof(T)), "cudaMalloc");
+  check(
+    cudaMemcpy(device, host.data(), host.size() * sizeof(T), cudaMemcpyHostToDevice),
+    "cudaMemcpy");
+  return device;
+}
+
+// one thread per weight, against all the steps
+__global__ void evaluate_kernel(
+  const uint64_t * offsets, const size_t step_num, const double * scores, const double * losses,
+  const double * weights, const size_t weight_num, double * weight_losses, int * statuses)
+{
+  const size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (i >= weight_num) return;
+
+  double w[loss_kernel::SCORE_NUM];
+  for (size_t j = 0; j < loss_kernel::SCORE_NUM; j++) {
+    w[j] = weights[loss_kernel::SCORE_NUM * i + j];
+  }
+
+  double loss = 0.0;
+  statuses[i] = loss_kernel::evaluate(offsets, step_num, scores, losses, w, loss);
+  weight_losses[i] = loss;
+}
+}  // namespace
+
+DeviceLossTable::DeviceLossTable(
+  const std::vector<uint64_t> & offsets, const std::vector<double> & scores,
+  const std::vector<double> & losses)
+: step_num_{offsets.size() - 1}
+{
+  try {
+    offsets_ = upload(offsets);
+    scores_ = upload(scores);
+    losses_ = upload(losses);
+  } catch (...) {
+    cudaFree(offsets_);
+    cudaFree(scores_);
+    cudaFree(losses_);
+    throw;
+  }
+}
+
+DeviceLossTable::~DeviceLossTable()
+{
+  cudaFree(offsets_);
+  cudaFree(scores_);
+  cudaFree(losses_);
+}
+
+void DeviceLossTable::evaluate(
+  const std::vector<double> & weights, std::vector<double> & weight_losses,
+  std::vector<int> & statuses) const
+{
+  const size_t weight_num = weights.size() / loss_kernel::SCORE_NUM;
+  weight_losses.resize(weight_num);
+  statuses.resize(weight_num);
+  if (weight_num == 0) return;
+
+  // the grid is small next to the table, so it is copied every time
+  double * device_weights = upload(weights);
+  double * device_losses = nullptr;
+  int * device_statuses = nullptr;
+  try {
+    check(cudaMalloc(&device_losses, weight_num * sizeof(double)), "cudaMalloc");
+    check(cudaMalloc(&device_statuses, weight_num * sizeof(int)), "cudaMalloc");
+
+    const auto block_num = static_cast<unsigned int>((weight_num + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    evaluate_kernel<<<block_num, BLOCK_SIZE>>>(
+      offsets_, step_num_, scores_, losses_, device_weights, weight_num, device_losses,
+      device_statuses);
+    check(cudaGetLastError(), "evaluate_kernel");
+
+    check(
+      cudaMemcpy(
+        weight_losses.data(), device_losses, weight_num * sizeof(double), cudaMemcpyDeviceToHost),
+      "cudaMemcpy");
+    check(
+      cudaMemcpy(
+        statuses.data(), device_statuses, weight_num * sizeof(int), cudaMemcpyDeviceToHost),
+      "cudaMemcpy");
+  } catch (...) {
+    cudaFree(device_weights);
+    cudaFree(device_losses);
+    cudaFree(device_statuses);
+    throw;
+  }
+  cudaFree(device_weights);
+  cudaFree(device_losses);
+  cudaFree(device_statuses);
+}
+
+auto DeviceLossTable::available() -> bool
+{
+  int device_num = 0;
+  return cudaGetDeviceCount(&device_num) == cudaSuccess && device_num > 0;
+}
+}  // namespace autoware::behavior_analyzer
@@ -0,0 +1,55 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVICE_LOSS_TABLE_HPP_
+#define DEVICE_LOSS_TABLE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+// The arrays of a LossTable on the CUDA device, built with BEHAVIOR_ANALYZER_USE_CUDA only. The
+// errors of CUDA are thrown as std::runtime_error.
+class DeviceLossTable
+{
+public:
+  DeviceLossTable(
+    const std::vector<uint64_t> & offsets, const std::vector<double> & scores,
+    const std::vector<double> & losses);
+
+  ~DeviceLossTable();
+
+  DeviceLossTable(const DeviceLossTable &) = delete;
+
+  DeviceLossTable & operator=(const DeviceLossTable &) = delete;
+
+  // @weights holds loss_kernel::SCORE_NUM weights per weight, and a loss and a
+  // loss_kernel::Status are written per weight
+  void evaluate(
+    const std::vector<double> & weights, std::vector<double> & weight_losses,
+    std::vector<int> & statuses) const;
+
+  static auto available() -> bool;
+
+private:
+  size_t step_num_{0};
+  uint64_t * offsets_{nullptr};
+  double * scores_{nullptr};
+  double * losses_{nullptr};
+};
+}  // namespace autoware::behavior_analyzer
+
+#endif  // DEVICE_LOSS_TABLE_HPP_
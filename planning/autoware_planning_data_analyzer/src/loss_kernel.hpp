@@ -0,0 +1,71 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LOSS_KERNEL_HPP_
+#define LOSS_KERNEL_HPP_
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// compiled by the host compiler and by nvcc, so that both evaluate a weight the same way
+#ifdef __CUDACC__
+#define LOSS_KERNEL_FUNCTION __host__ __device__ inline
+#else
+#define LOSS_KERNEL_FUNCTION inline
+#endif
+
+namespace autoware::behavior_analyzer::loss_kernel
+{
+enum Status : int { OK = 0, NO_TRAJECTORY = 1, INVALID_LOSS = 2 };
+
+// the columns of a score matrix, in the order of the weights
+constexpr size_t SCORE_NUM = 4;
+
+// The loss of the weights @w summed over the @step_num steps of a LossTable, the selection being
+// the same as best_column(). The loss is only valid if OK is returned.
+LOSS_KERNEL_FUNCTION int evaluate(
+  const uint64_t * offsets, const size_t step_num, const double * scores, const double * losses,
+  const double * w, double & loss)
+{
+  loss = 0.0;
+  for (size_t s = 0; s < step_num; s++) {
+    const auto begin = offsets[s];
+    const auto n = static_cast<size_t>(offsets[s + 1] - begin);
+    if (n == 0) return NO_TRAJECTORY;
+
+    const double * matrix = scores + SCORE_NUM * begin;
+    size_t best = 0;
+    double best_total = -DBL_MAX;
+    for (size_t i = 0; i < n; i++) {
+      double total = 0.0;
+      for (size_t j = 0; j < SCORE_NUM; j++) {
+        if (w[j] != 0.0) total += w[j] * matrix[j * n + i];
+      }
+      if (total > best_total) {
+        best_total = total;
+        best = i;
+      }
+    }
+
+    const double step_loss = losses[begin + best];
+    if (!std::isfinite(step_loss)) return INVALID_LOSS;
+    loss += step_loss;
+  }
+  return OK;
+}
+}  // namespace autoware::behavior_analyzer::loss_kernel
+
+#endif  // LOSS_KERNEL_HPP_
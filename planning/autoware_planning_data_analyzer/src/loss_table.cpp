@@ -0,0 +1,181 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "loss_table.hpp"
+
+#include "loss_kernel.hpp"
+
+#ifdef BEHAVIOR_ANALYZER_USE_CUDA
+#include "device_loss_table.hpp"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+#ifndef BEHAVIOR_ANALYZER_USE_CUDA
+// only destroyed through the unique_ptr, which is always empty without CUDA
+class DeviceLossTable
+{
+};
+#endif
+
+namespace
+{
+static_assert(
+  loss_kernel::SCORE_NUM == static_cast<size_t>(SCORE::SIZE),
+  "the kernel reads one column per weight");
+
+void throw_status(const int status)
+{
+  if (status == loss_kernel::NO_TRAJECTORY) {
+    throw std::logic_error("no found best trajectory.");
+  }
+  if (status == loss_kernel::INVALID_LOSS) {
+    throw std::logic_error("loss value is invalid.");
+  }
+}
+}  // namespace
+
+LossTable::LossTable() : offsets_{0}
+{
+}
+
+LossTable::~LossTable() = default;
+
+LossTable::LossTable(LossTable &&) noexcept = default;
+
+LossTable & LossTable::operator=(LossTable &&) noexcept = default;
+
+void LossTable::add(const DataSet & data_set)
+{
+  const auto & score_matrix = data_set.sampling.scores(1.0, 1.0, 1.0, 1.0);
+
+  std::vector<double> losses(data_set.sampling.feasible_indices.size());
+  for (size_t i = 0; i < losses.size(); i++) {
+    losses.at(i) = data_set.candidate_loss(i);
+  }
+
+  add(score_matrix, losses);
+}
+
+void LossTable::add(const CompactDataSet & data_set)
+{
+  std::vector<double> losses(data_set.offsets.empty() ? 0 : data_set.offsets.size() - 1);
+  for (size_t i = 0; i < losses.size(); i++) {
+    losses.at(i) = data_set.candidate_loss(i);
+  }
+
+  add(data_set.score_matrix, losses);
+}
+
+void LossTable::add(const std::vector<double> & score_matrix, const std::vector<double> & losses)
+{
+  // a matrix and its losses disagreeing on the trajectories is a bug of the caller
+  if (score_matrix.size() != loss_kernel::SCORE_NUM * losses.size()) {
+    throw std::logic_error("the score matrix does not match the trajectories.");
+  }
+
+  scores_.insert(scores_.end(), score_matrix.begin(), score_matrix.end());
+  losses_.insert(losses_.end(), losses.begin(), losses.end());
+  offsets_.push_back(losses_.size());
+
+  // the copy on the device is stale
+  device_.reset();
+}
+
+void LossTable::evaluate(std::vector<Result> & weight_grid, const size_t thread_num) const
+{
+  constexpr size_t CHUNK_SIZE = 64;
+
+  std::vector<int> statuses(weight_grid.size(), loss_kernel::OK);
+  std::atomic<size_t> next_chunk(0);
+
+  // every weight is evaluated against all the steps by one thread, so the losses need no lock
+  auto worker = [&]() {
+    for (size_t begin = next_chunk++ * CHUNK_SIZE; begin < weight_grid.size();
+         begin = next_chunk++ * CHUNK_SIZE) {
+      const auto end = std::min(begin + CHUNK_SIZE, weight_grid.size());
+      for (size_t i = begin; i < end; i++) {
+        auto & result = weight_grid.at(i);
+        const double w[loss_kernel::SCORE_NUM] = {result.w0, result.w1, result.w2, result.w3};
+        double loss = 0.0;
+        statuses.at(i) = loss_kernel::evaluate(
+          offsets_.data(), step_num(), scores_.data(), losses_.data(), w, loss);
+        result.loss += loss;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(thread_num, weight_grid.size() / CHUNK_SIZE + 1); i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  for (const auto status : statuses) {
+    throw_status(status);
+  }
+}
+
+#ifdef BEHAVIOR_ANALYZER_USE_CUDA
+void LossTable::evaluate_on_device(std::vector<Result> & weight_grid) const
+{
+  if (!device_) {
+    device_ = std::make_unique<DeviceLossTable>(offsets_, scores_, losses_);
+  }
+
+  std::vector<double> weights;
+  weights.reserve(loss_kernel::SCORE_NUM * weight_grid.size());
+  for (const auto & result : weight_grid) {
+    weights.insert(weights.end(), {result.w0, result.w1, result.w2, result.w3});
+  }
+
+  std::vector<double> weight_losses;
+  std::vector<int> statuses;
+  device_->evaluate(weights, weight_losses, statuses);
+
+  for (size_t i = 0; i < weight_grid.size(); i++) {
+    weight_grid.at(i).loss += weight_losses.at(i);
+  }
+
+  for (const auto status : statuses) {
+    throw_status(status);
+  }
+}
+
+auto LossTable::device_available() -> bool
+{
+  return DeviceLossTable::available();
+}
+#else
+void LossTable::evaluate_on_device(std::vector<Result> &) const
+{
+  throw std::runtime_error("built without BEHAVIOR_ANALYZER_USE_CUDA.");
+}
+
+auto LossTable::device_available() -> bool
+{
+  return false;
+}
+#endif
+}  // namespace autoware::behavior_analyzer
@@ -0,0 +1,83 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LOSS_TABLE_HPP_
+#define LOSS_TABLE_HPP_
+
+#include "data_structs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+class DeviceLossTable;
+
+// The steps of the weight grid search in flat arrays. A weight only changes the loss of a step
+// through the feasible trajectory it selects, so the loss of every feasible trajectory is
+// computed once when the step is added, and a weight is evaluated by a weighted sum of the score
+// matrix and an argmax per step. The losses are the same as DataSet::loss and
+// CompactDataSet::loss, summed over the steps in the order they were added.
+//
+// Built with BEHAVIOR_ANALYZER_USE_CUDA, the table may also be evaluated on a CUDA device, to
+// which it is copied on the first evaluation and kept for the next ones.
+class LossTable
+{
+public:
+  LossTable();
+
+  ~LossTable();
+
+  LossTable(LossTable &&) noexcept;
+
+  LossTable & operator=(LossTable &&) noexcept;
+
+  // the score matrix of @data_set is computed for all the weights first
+  void add(const DataSet & data_set);
+
+  void add(const CompactDataSet & data_set);
+
+  auto step_num() const -> size_t { return offsets_.size() - 1; }
+
+  // Add the losses of every weight of @weight_grid, on @thread_num threads. Throws
+  // std::logic_error as DataSet::loss if a step has no trajectory or a selected loss is invalid.
+  void evaluate(std::vector<Result> & weight_grid, const size_t thread_num) const;
+
+  // same as evaluate() on the CUDA device, throws std::runtime_error if there is none
+  void evaluate_on_device(std::vector<Result> & weight_grid) const;
+
+  // whether the package is built with CUDA and a device is found
+  static auto device_available() -> bool;
+
+private:
+  void add(const std::vector<double> & score_matrix, const std::vector<double> & losses);
+
+  // the trajectories of the s-th step are [offsets_[s], offsets_[s + 1])
+  std::vector<uint64_t> offsets_;
+
+  // the score matrix of the s-th step, with offsets_[s + 1] - offsets_[s] rows, from
+  // SCORE::SIZE * offsets_[s]
+  std::vector<double> scores_;
+
+  std::vector<double> losses_;
+
+  // the copy on the device, made by the first evaluate_on_device()
+  mutable std::unique_ptr<DeviceLossTable> device_;
+};
+}  // namespace autoware::behavior_analyzer
+
+#endif  // LOSS_TABLE_HPP_
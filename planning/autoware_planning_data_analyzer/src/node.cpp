@@ -15,13 +15,26 @@
 #include "node.hpp"
 
 #include "autoware/universe_utils/system/stop_watch.hpp"
+#include "thread_pool.hpp"
 
+#include <autoware/tool_tracing/tracing.hpp>
 #include <autoware/universe_utils/ros/marker_helper.hpp>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <numeric>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace autoware::behavior_analyzer
@@ -32,6 +45,231 @@ using autoware::universe_utils::createMarkerScale;
 using autoware::universe_utils::Point2d;
 using autoware::universe_utils::Polygon2d;
 
+namespace
+{
+// Persistent workers for the weight grid search. The weights of a data set are taken in chunks
+// by the workers, and each weight is evaluated by one worker only, so the losses of a step are
+// written without locks and added to the grid once the step is done.
+class GridSearchPool
+{
+public:
+  GridSearchPool(std::vector<Result> & weight_grid, const size_t thread_num)
+  : weight_grid_{weight_grid}, step_loss_(weight_grid.size(), 0.0)
+  {
+    for (size_t i = 0; i < std::max<size_t>(thread_num, 1); i++) {
+      threads_.emplace_back(&GridSearchPool::work, this);
+    }
+  }
+
+  ~GridSearchPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_start_.notify_all();
+    for (auto & t : threads_) t.join();
+  }
+
+  // start evaluating @data_set in the background
+  void start(const std::shared_ptr<DataSet> & data_set)
+  {
+    // the scores are computed on first use, so all of them are computed here and the workers
+    // only read them
+    data_set->sampling.scores(1.0, 1.0, 1.0, 1.0);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      data_set_ = data_set;
+      next_chunk_ = 0;
+      busy_ = threads_.size();
+      generation_++;
+    }
+    cv_start_.notify_all();
+  }
+
+  // wait for the evaluation of the current data set and add its losses to the grid
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_done_.wait(lock, [this]() { return busy_ == 0; });
+    data_set_.reset();
+
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+
+    for (size_t i = 0; i < weight_grid_.size(); i++) {
+      weight_grid_.at(i).loss += step_loss_.at(i);
+    }
+  }
+
+private:
+  static constexpr size_t CHUNK_SIZE = 64;
+
+  void work()
+  {
+    size_t generation = 0;
+
+    while (true) {
+      std::shared_ptr<DataSet> data_set;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_start_.wait(lock, [&]() { return stop_ || generation_ != generation; });
+        if (stop_) return;
+        generation = generation_;
+        data_set = data_set_;
+      }
+
+      try {
+        for (size_t begin = next_chunk_++ * CHUNK_SIZE; begin < weight_grid_.size();
+             begin = next_chunk_++ * CHUNK_SIZE) {
+          const auto end = std::min(begin + CHUNK_SIZE, weight_grid_.size());
+          for (size_t i = begin; i < end; i++) {
+            const auto & w = weight_grid_.at(i);
+            step_loss_.at(i) = data_set->loss(w.w0, w.w1, w.w2, w.w3);
+          }
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+        next_chunk_ = weight_grid_.size();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        busy_--;
+      }
+      cv_done_.notify_one();
+    }
+  }
+
+  std::vector<Result> & weight_grid_;
+  std::vector<double> step_loss_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_start_;
+  std::condition_variable cv_done_;
+  std::shared_ptr<DataSet> data_set_;
+  std::exception_ptr error_;
+  std::atomic<size_t> next_chunk_{0};
+  size_t generation_{0};
+  size_t busy_{0};
+  bool stop_{false};
+};
+void show_best_result(const std::vector<Result> & weight_grid)
+{
+  auto sort_by_loss = weight_grid;
+  std::sort(sort_by_loss.begin(), sort_by_loss.end(), [](const auto & a, const auto & b) {
+    return a.loss < b.loss;
+  });
+
+  const auto best = sort_by_loss.front();
+
+  std::cout << std::fixed;
+  std::cout << std::setprecision(4);
+  std::cout << " [w0]:" << best.w0 << " [w1]:" << best.w1 << " [w2]:" << best.w2
+            << " [w3]:" << best.w3 << " [loss]:" << best.loss << std::endl;
+}
+}  // namespace
+
+auto declare_parameters(rclcpp::Node & node) -> std::shared_ptr<Parameters>
+{
+  const auto p = std::make_shared<Parameters>();
+  p->resample_num = node.declare_parameter<int>("resample_num");
+  p->time_resolution = node.declare_parameter<double>("time_resolution");
+  p->w0 = node.declare_parameter<double>("weight.lat_comfortability");
+  p->w1 = node.declare_parameter<double>("weight.lon_comfortability");
+  p->w2 = node.declare_parameter<double>("weight.efficiency");
+  p->w3 = node.declare_parameter<double>("weight.safety");
+  p->grid_search.dt = node.declare_parameter<double>("grid_search.dt");
+  p->grid_search.min = node.declare_parameter<double>("grid_search.min");
+  p->grid_search.max = node.declare_parameter<double>("grid_search.max");
+  p->grid_search.resolution = node.declare_parameter<double>("grid_search.resolution");
+  p->grid_search.thread_num = node.declare_parameter<int>("grid_search.thread_num");
+  p->grid_search.mode = node.declare_parameter<std::string>("grid_search.mode");
+  p->grid_search.backend = node.declare_parameter<std::string>("grid_search.backend");
+  p->grid_search.coarse_to_fine.num = node.declare_parameter<int>("grid_search.coarse_to_fine.num");
+  p->grid_search.coarse_to_fine.shrink =
+    node.declare_parameter<double>("grid_search.coarse_to_fine.shrink");
+  p->grid_search.coarse_to_fine.tolerance =
+    node.declare_parameter<double>("grid_search.coarse_to_fine.tolerance");
+  p->grid_search.coarse_to_fine.max_iteration =
+    node.declare_parameter<int>("grid_search.coarse_to_fine.max_iteration");
+  p->target_state.lat_positions =
+    node.declare_parameter<std::vector<double>>("target_state.lateral_positions");
+  p->target_state.lat_velocities =
+    node.declare_parameter<std::vector<double>>("target_state.lateral_velocities");
+  p->target_state.lat_accelerations =
+    node.declare_parameter<std::vector<double>>("target_state.lateral_accelerations");
+  p->target_state.lon_positions =
+    node.declare_parameter<std::vector<double>>("target_state.longitudinal_positions");
+  p->target_state.lon_velocities =
+    node.declare_parameter<std::vector<double>>("target_state.longitudinal_velocities");
+  p->target_state.lon_accelerations =
+    node.declare_parameter<std::vector<double>>("target_state.longitudinal_accelerations");
+
+  p->feasibility.max_lateral_acceleration =
+    node.declare_parameter<double>("feasibility.max_lateral_acceleration");
+  p->feasibility.max_lateral_jerk = node.declare_parameter<double>("feasibility.max_lateral_jerk");
+  p->feasibility.max_curvature = node.declare_parameter<double>("feasibility.max_curvature");
+
+  const auto sampling_thread_num = node.declare_parameter<int>("sampling.thread_num");
+  if (sampling_thread_num > 1) {
+    p->thread_pool = std::make_shared<ThreadPool>(static_cast<size_t>(sampling_thread_num));
+  }
+
+  return p;
+}
+
+void set_topic_filter(rosbag2_cpp::Reader & reader)
+{
+  rosbag2_storage::StorageFilter filter;
+  filter.topics.emplace_back(TOPIC::TF);
+  filter.topics.emplace_back(TOPIC::ODOMETRY);
+  filter.topics.emplace_back(TOPIC::ACCELERATION);
+  filter.topics.emplace_back(TOPIC::OBJECTS);
+  filter.topics.emplace_back(TOPIC::STEERING);
+  filter.topics.emplace_back(TOPIC::TRAJECTORY);
+  reader.set_filter(filter);
+}
+
+void fill_buffers(rosbag2_cpp::Reader & reader, BagData & bag_data, const rclcpp::Logger & logger)
+{
+  while (!bag_data.ready() && reader.has_next()) {
+    const auto next_data = reader.read_next();
+
+    // each buffer deserializes the messages of its topic into its own slots
+    const auto buffer = bag_data.buffers.find(next_data->topic_name);
+    if (buffer == bag_data.buffers.end()) {
+      continue;
+    }
+
+    if (!buffer->second->append(*next_data->serialized_data)) {
+      RCLCPP_WARN(logger, "failed to buffer a message of %s", next_data->topic_name.c_str());
+    }
+  }
+}
+
+void evaluate_weight_grid(
+  const LossTable & table, std::vector<Result> & weight_grid,
+  const GridSearchParameters & parameters, const rclcpp::Logger & logger)
+{
+  if (parameters.backend == "cuda") {
+    if (LossTable::device_available()) {
+      table.evaluate_on_device(weight_grid);
+      return;
+    }
+    RCLCPP_WARN_ONCE(logger, "no CUDA device for the weight grid search, the cpu is used.");
+  } else if (parameters.backend != "cpu") {
+    RCLCPP_WARN_ONCE(
+      logger, "unknown grid_search.backend %s, the cpu is used.", parameters.backend.c_str());
+  }
+
+  table.evaluate(weight_grid, parameters.thread_num);
+}
+
 BehaviorAnalyzerNode::BehaviorAnalyzerNode(const rclcpp::NodeOptions & node_options)
 : Node("path_selector_node", node_options)
 {
@@ -76,102 +314,42 @@ BehaviorAnalyzerNode::BehaviorAnalyzerNode(const rclcpp::NodeOptions & node_opti
   bag_data_ = std::make_shared<BagData>(
     duration_cast<nanoseconds>(reader_.get_metadata().starting_time.time_since_epoch()).count());
 
-  parameters_ = std::make_shared<Parameters>();
-  parameters_->resample_num = declare_parameter<int>("resample_num");
-  parameters_->time_resolution = declare_parameter<double>("time_resolution");
-  parameters_->w0 = declare_parameter<double>("weight.lat_comfortability");
-  parameters_->w1 = declare_parameter<double>("weight.lon_comfortability");
-  parameters_->w2 = declare_parameter<double>("weight.efficiency");
-  parameters_->w3 = declare_parameter<double>("weight.safety");
-  parameters_->grid_search.dt = declare_parameter<double>("grid_search.dt");
-  parameters_->grid_search.min = declare_parameter<double>("grid_search.min");
-  parameters_->grid_search.max = declare_parameter<double>("grid_search.max");
-  parameters_->grid_search.resolution = declare_parameter<double>("grid_search.resolution");
-  parameters_->grid_search.thread_num = declare_parameter<int>("grid_search.thread_num");
-  parameters_->target_state.lat_positions =
-    declare_parameter<std::vector<double>>("target_state.lateral_positions");
-  parameters_->target_state.lat_velocities =
-    declare_parameter<std::vector<double>>("target_state.lateral_velocities");
-  parameters_->target_state.lat_accelerations =
-    declare_parameter<std::vector<double>>("target_state.lateral_accelerations");
-  parameters_->target_state.lon_positions =
-    declare_parameter<std::vector<double>>("target_state.longitudinal_positions");
-  parameters_->target_state.lon_velocities =
-    declare_parameter<std::vector<double>>("target_state.longitudinal_velocities");
-  parameters_->target_state.lon_accelerations =
-    declare_parameter<std::vector<double>>("target_state.longitudinal_accelerations");
-}
+  parameters_ = declare_parameters(*this);
 
-void BehaviorAnalyzerNode::update(const std::shared_ptr<BagData> & bag_data, const double dt) const
-{
-  rosbag2_storage::StorageFilter filter;
-  filter.topics.emplace_back(TOPIC::TF);
-  filter.topics.emplace_back(TOPIC::ODOMETRY);
-  filter.topics.emplace_back(TOPIC::ACCELERATION);
-  filter.topics.emplace_back(TOPIC::OBJECTS);
-  filter.topics.emplace_back(TOPIC::STEERING);
-  filter.topics.emplace_back(TOPIC::TRAJECTORY);
-  reader_.set_filter(filter);
+  output_dir_ = declare_parameter<std::string>("output.dir");
+  output_batch_rows_ = declare_parameter<int>("output.batch_rows");
 
-  bag_data->update(dt * 1e9);
+  visualization_top_k_ = declare_parameter<int>("visualization.top_k");
+  visualization_period_ = declare_parameter<double>("visualization.period");
 
-  while (reader_.has_next()) {
-    const auto next_data = reader_.read_next();
-    rclcpp::SerializedMessage serialized_msg(*next_data->serialized_data);
+  open_columns_writer();
+}
 
-    if (bag_data->ready()) {
-      break;
-    }
+void BehaviorAnalyzerNode::open_columns_writer()
+{
+  columns_writer_.reset();
 
-    if (next_data->topic_name == TOPIC::TF) {
-      rclcpp::Serialization<TFMessage> serializer;
-      const auto deserialized_message = std::make_shared<TFMessage>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<TFMessage>>(bag_data->buffers.at(TOPIC::TF))
-        ->append(*deserialized_message);
-    }
+  if (output_dir_.empty()) return;
 
-    if (next_data->topic_name == TOPIC::ODOMETRY) {
-      rclcpp::Serialization<Odometry> serializer;
-      const auto deserialized_message = std::make_shared<Odometry>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<Odometry>>(bag_data->buffers.at(TOPIC::ODOMETRY))
-        ->append(*deserialized_message);
-    }
+  std::filesystem::create_directories(output_dir_);
 
-    if (next_data->topic_name == TOPIC::ACCELERATION) {
-      rclcpp::Serialization<AccelWithCovarianceStamped> serializer;
-      const auto deserialized_message = std::make_shared<AccelWithCovarianceStamped>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<AccelWithCovarianceStamped>>(
-        bag_data->buffers.at(TOPIC::ACCELERATION))
-        ->append(*deserialized_message);
-    }
+  const auto path = std::filesystem::path(output_dir_) / "steps.columns";
+  columns_writer_ = std::make_unique<ColumnsWriter>(path, output_batch_rows_);
+  if (!columns_writer_->good()) {
+    RCLCPP_ERROR_STREAM(get_logger(), "failed to open " << path.string());
+    columns_writer_.reset();
+  }
+}
 
-    if (next_data->topic_name == TOPIC::OBJECTS) {
-      rclcpp::Serialization<PredictedObjects> serializer;
-      const auto deserialized_message = std::make_shared<PredictedObjects>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<PredictedObjects>>(bag_data->buffers.at(TOPIC::OBJECTS))
-        ->append(*deserialized_message);
-    }
+void BehaviorAnalyzerNode::update(const std::shared_ptr<BagData> & bag_data, const double dt) const
+{
+  AUTOWARE_TOOL_TRACING_STAGE("behavior_analyzer", "update");
 
-    if (next_data->topic_name == TOPIC::STEERING) {
-      rclcpp::Serialization<SteeringReport> serializer;
-      const auto deserialized_message = std::make_shared<SteeringReport>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<SteeringReport>>(bag_data->buffers.at(TOPIC::STEERING))
-        ->append(*deserialized_message);
-    }
+  set_topic_filter(reader_);
 
-    if (next_data->topic_name == TOPIC::TRAJECTORY) {
-      rclcpp::Serialization<Trajectory> serializer;
-      const auto deserialized_message = std::make_shared<Trajectory>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<Trajectory>>(bag_data->buffers.at(TOPIC::TRAJECTORY))
-        ->append(*deserialized_message);
-    }
-  }
+  bag_data->update(dt * 1e9);
+
+  fill_buffers(reader_, *bag_data, get_logger());
 }
 
 void BehaviorAnalyzerNode::play(
@@ -198,6 +376,9 @@ void BehaviorAnalyzerNode::rewind(
   bag_data_ = std::make_shared<BagData>(
     duration_cast<nanoseconds>(reader_.get_metadata().starting_time.time_since_epoch()).count());
 
+  // the steps are analyzed again from the beginning of the bag
+  open_columns_writer();
+
   res->success = true;
 }
 
@@ -213,87 +394,84 @@ void BehaviorAnalyzerNode::weight(
   const auto bag_data = std::make_shared<BagData>(
     duration_cast<nanoseconds>(reader_.get_metadata().starting_time.time_since_epoch()).count());
 
-  std::vector<Result> weight_grid;
+  // the data set of the next step, rebuilt in @recycled unless it is nullptr
+  const auto next_data_set =
+    [&](const std::shared_ptr<DataSet> & recycled) -> std::shared_ptr<DataSet> {
+    if (!reader_.has_next() || !rclcpp::ok()) return nullptr;
 
-  double resolution = p->grid_search.resolution;
-  double min = p->grid_search.min;
-  double max = p->grid_search.max;
-  for (double w0 = min; w0 < max + 0.1 * resolution; w0 += resolution) {
-    for (double w1 = min; w1 < max + 0.1 * resolution; w1 += resolution) {
-      for (double w2 = min; w2 < max + 0.1 * resolution; w2 += resolution) {
-        for (double w3 = min; w3 < max + 0.1 * resolution; w3 += resolution) {
-          weight_grid.emplace_back(w0, w1, w2, w3);
-        }
-      }
-    }
-  }
+    update(bag_data, p->grid_search.dt);
 
-  const auto show_best_result = [&weight_grid]() {
-    auto sort_by_loss = weight_grid;
-    std::sort(sort_by_loss.begin(), sort_by_loss.end(), [](const auto & a, const auto & b) {
-      return a.loss < b.loss;
-    });
+    if (!bag_data->ready()) return nullptr;
 
-    const auto best = sort_by_loss.front();
+    if (recycled) {
+      recycled->update(bag_data);
+      return recycled;
+    }
 
-    std::cout << std::fixed;
-    std::cout << std::setprecision(4);
-    std::cout << " [w0]:" << best.w0 << " [w1]:" << best.w1 << " [w2]:" << best.w2
-              << " [w3]:" << best.w3 << " [loss]:" << best.loss << std::endl;
+    return std::make_shared<DataSet>(bag_data, vehicle_info_, p);
   };
 
   autoware::universe_utils::StopWatch<std::chrono::milliseconds> stop_watch;
 
   stop_watch.tic("total_time");
-  while (reader_.has_next() && rclcpp::ok()) {
-    update(bag_data, p->grid_search.dt);
 
-    if (!bag_data->ready()) break;
+  if (p->grid_search.mode == "coarse_to_fine") {
+    std::vector<std::shared_ptr<DataSet>> data_sets;
+    for (auto data_set = next_data_set(nullptr); data_set; data_set = next_data_set(nullptr)) {
+      data_sets.push_back(data_set);
+    }
 
-    const auto data_set = std::make_shared<DataSet>(bag_data, vehicle_info_, p);
+    coarse_to_fine(data_sets);
+  } else {
+    std::vector<Result> weight_grid;
+
+    double resolution = p->grid_search.resolution;
+    double min = p->grid_search.min;
+    double max = p->grid_search.max;
+    for (double w0 = min; w0 < max + 0.1 * resolution; w0 += resolution) {
+      for (double w1 = min; w1 < max + 0.1 * resolution; w1 += resolution) {
+        for (double w2 = min; w2 < max + 0.1 * resolution; w2 += resolution) {
+          for (double w3 = min; w3 < max + 0.1 * resolution; w3 += resolution) {
+            weight_grid.emplace_back(w0, w1, w2, w3);
+          }
+        }
+      }
+    }
 
-    std::mutex grid_mutex;
+    if (p->grid_search.backend == "cuda") {
+      // The steps are collected into a table while the bag is read and the grid is evaluated once
+      // on the device, since a launch per step would spend its time on the copies.
+      LossTable table;
+      for (auto data_set = next_data_set(nullptr); data_set; data_set = next_data_set(data_set)) {
+        table.add(*data_set);
+      }
 
-    const auto update = [&weight_grid, &grid_mutex](const auto & data_set, const auto idx) {
-      double w0 = 0.0;
-      double w1 = 0.0;
-      double w2 = 0.0;
-      double w3 = 0.0;
+      evaluate_weight_grid(table, weight_grid, p->grid_search, get_logger());
 
-      {
-        std::lock_guard<std::mutex> lock(grid_mutex);
-        if (idx + 1 > weight_grid.size()) return;
-        w0 = weight_grid.at(idx).w0;
-        w1 = weight_grid.at(idx).w1;
-        w2 = weight_grid.at(idx).w2;
-        w3 = weight_grid.at(idx).w3;
-      }
+      show_best_result(weight_grid);
 
-      const auto loss = data_set->loss(w0, w1, w2, w3);
+      write_weight_grid(weight_grid);
+    } else {
+      GridSearchPool pool(weight_grid, p->grid_search.thread_num);
 
-      {
-        std::lock_guard<std::mutex> lock(grid_mutex);
-        if (idx < weight_grid.size()) {
-          weight_grid.at(idx).loss += loss;
-        }
-      }
-    };
+      // The next bag step is read while the workers evaluate the current one, so two data sets
+      // are rebuilt in turn.
+      auto data_set = next_data_set(nullptr);
+      std::shared_ptr<DataSet> spare;
+      while (data_set) {
+        pool.start(data_set);
 
-    size_t i = 0;
-    while (rclcpp::ok()) {
-      std::vector<std::thread> threads;
-      for (size_t thread_id = 0; thread_id < p->grid_search.thread_num; thread_id++) {
-        threads.emplace_back(update, data_set, i + thread_id);
-      }
+        auto next = next_data_set(spare);
 
-      for (auto & t : threads) t.join();
+        pool.wait();
 
-      if (i + 1 > weight_grid.size()) break;
+        show_best_result(weight_grid);
 
-      i += p->grid_search.thread_num;
-    }
+        spare = std::exchange(data_set, next);
+      }
 
-    show_best_result();
+      write_weight_grid(weight_grid);
+    }
   }
   std::cout << "process time: " << stop_watch.toc("total_time") << "[ms]" << std::endl;
 
@@ -302,16 +480,130 @@ void BehaviorAnalyzerNode::weight(
   res->success = true;
 }
 
+void BehaviorAnalyzerNode::write_weight_grid(const std::vector<Result> & weight_grid) const
+{
+  if (output_dir_.empty()) return;
+
+  Columns columns;
+  columns.names = {"w0", "w1", "w2", "w3", "loss"};
+  columns.values.resize(columns.names.size());
+  for (const auto & result : weight_grid) {
+    columns.values.at(0).push_back(result.w0);
+    columns.values.at(1).push_back(result.w1);
+    columns.values.at(2).push_back(result.w2);
+    columns.values.at(3).push_back(result.w3);
+    columns.values.at(4).push_back(result.loss);
+  }
+  columns.rows = weight_grid.size();
+
+  const auto path = std::filesystem::path(output_dir_) / "weight_grid.columns";
+  if (!write_columns(path, columns)) {
+    RCLCPP_ERROR_STREAM(get_logger(), "failed to write " << path.string());
+  }
+}
+
+void BehaviorAnalyzerNode::coarse_to_fine(
+  const std::vector<std::shared_ptr<DataSet>> & data_sets) const
+{
+  const auto & p = parameters_->grid_search;
+
+  if (data_sets.empty()) {
+    RCLCPP_WARN(get_logger(), "no data set for the weight search.");
+    return;
+  }
+
+  LossTable table;
+  for (const auto & data_set : data_sets) {
+    table.add(*data_set);
+  }
+
+  const auto num = std::max<size_t>(p.coarse_to_fine.num, 2);
+
+  // each iteration searches a grid of num^4 weights around the best weight so far, then shrinks
+  // the grid by the shrink factor until its spacing falls below the resolution
+  std::array<double, 4> center;
+  center.fill(0.5 * (p.min + p.max));
+  double half_width = 0.5 * (p.max - p.min);
+  double best_loss = std::numeric_limits<double>::max();
+
+  for (size_t iteration = 0; iteration < p.coarse_to_fine.max_iteration && rclcpp::ok();
+       iteration++) {
+    std::array<std::vector<double>, 4> axes;
+    for (size_t d = 0; d < axes.size(); d++) {
+      for (size_t k = 0; k < num; k++) {
+        const auto w = center.at(d) + half_width * (2.0 * k / (num - 1) - 1.0);
+        axes.at(d).push_back(std::clamp(w, p.min, p.max));
+      }
+    }
+
+    std::vector<Result> weight_grid;
+    for (const auto w0 : axes.at(0)) {
+      for (const auto w1 : axes.at(1)) {
+        for (const auto w2 : axes.at(2)) {
+          for (const auto w3 : axes.at(3)) {
+            weight_grid.emplace_back(w0, w1, w2, w3);
+          }
+        }
+      }
+    }
+
+    // the data sets are kept in memory, so every iteration evaluates the same table
+    evaluate_weight_grid(table, weight_grid, p, get_logger());
+
+    const auto best = *std::min_element(
+      weight_grid.begin(), weight_grid.end(),
+      [](const auto & a, const auto & b) { return a.loss < b.loss; });
+
+    std::cout << "[iteration]:" << iteration << " [spacing]:" << 2.0 * half_width / (num - 1);
+    show_best_result(weight_grid);
+
+    write_weight_grid(weight_grid);
+
+    const auto improvement = best_loss - best.loss;
+    const auto converged = best_loss < std::numeric_limits<double>::max() &&
+                           improvement <= p.coarse_to_fine.tolerance * std::abs(best_loss);
+
+    if (best.loss < best_loss) {
+      best_loss = best.loss;
+      center = {best.w0, best.w1, best.w2, best.w3};
+    }
+
+    half_width *= p.coarse_to_fine.shrink;
+
+    if (converged) {
+      RCLCPP_INFO(
+        get_logger(), "converged after %lu iterations, the loss improved by %f.", iteration + 1,
+        improvement);
+      return;
+    }
+
+    if (2.0 * half_width / (num - 1) < p.resolution) {
+      RCLCPP_INFO(
+        get_logger(), "converged after %lu iterations, the spacing reached the resolution.",
+        iteration + 1);
+      return;
+    }
+  }
+
+  RCLCPP_WARN(get_logger(), "not converged within %lu iterations.", p.coarse_to_fine.max_iteration);
+}
+
 void BehaviorAnalyzerNode::analyze(const std::shared_ptr<BagData> & bag_data) const
 {
   if (!bag_data->ready()) return;
 
-  const auto data_set = std::make_shared<DataSet>(bag_data, vehicle_info_, parameters_);
+  // the data set of the last tick is rebuilt in place
+  if (data_set_) {
+    data_set_->update(bag_data);
+  } else {
+    data_set_ = std::make_shared<DataSet>(bag_data, vehicle_info_, parameters_);
+  }
+  const auto & data_set = data_set_;
 
-  const auto opt_tf = std::dynamic_pointer_cast<Buffer<TFMessage>>(bag_data->buffers.at(TOPIC::TF))
-                        ->get(bag_data->timestamp);
+  const auto opt_tf = std::dynamic_pointer_cast<TFBuffer>(bag_data->buffers.at(TOPIC::TF))
+                        ->lookup(bag_data->timestamp);
   if (opt_tf) {
-    pub_tf_->publish(*opt_tf);
+    pub_tf_->publish(opt_tf.value());
   }
 
   const auto opt_objects =
@@ -335,10 +627,16 @@ void BehaviorAnalyzerNode::analyze(const std::shared_ptr<BagData> & bag_data) co
   visualize(data_set);
 
   print(data_set);
+
+  if (columns_writer_) {
+    columns_writer_->append_row(bag_data->timestamp, *data_set, *parameters_);
+  }
 }
 
 void BehaviorAnalyzerNode::metrics(const std::shared_ptr<DataSet> & data_set) const
 {
+  AUTOWARE_TOOL_TRACING_STAGE("behavior_analyzer", "metrics");
+
   {
     Float32MultiArrayStamped msg{};
 
@@ -347,7 +645,7 @@ void BehaviorAnalyzerNode::metrics(const std::shared_ptr<DataSet> & data_set) co
 
     const auto set_metrics = [&msg, this](const auto & data, const auto metric_type) {
       const auto offset = static_cast<size_t>(metric_type) * parameters_->resample_num;
-      const auto metric = data.values.at(static_cast<size_t>(metric_type));
+      const auto & metric = data.value(metric_type);
       std::copy(metric.begin(), metric.end(), msg.data.begin() + offset);
     };
 
@@ -359,8 +657,8 @@ void BehaviorAnalyzerNode::metrics(const std::shared_ptr<DataSet> & data_set) co
     pub_manual_metrics_->publish(msg);
   }
 
-  const auto autoware_trajectory = data_set->sampling.autoware();
-  if (autoware_trajectory.has_value()) {
+  const auto * autoware_trajectory = data_set->sampling.autoware();
+  if (autoware_trajectory) {
     Float32MultiArrayStamped msg{};
 
     msg.stamp = now();
@@ -368,14 +666,14 @@ void BehaviorAnalyzerNode::metrics(const std::shared_ptr<DataSet> & data_set) co
 
     const auto set_metrics = [&msg, this](const auto & data, const auto metric_type) {
       const auto offset = static_cast<size_t>(metric_type) * parameters_->resample_num;
-      const auto metric = data.values.at(static_cast<size_t>(metric_type));
+      const auto & metric = data.value(metric_type);
       std::copy(metric.begin(), metric.end(), msg.data.begin() + offset);
     };
 
-    set_metrics(autoware_trajectory.value(), METRIC::LATERAL_ACCEL);
-    set_metrics(autoware_trajectory.value(), METRIC::LONGITUDINAL_JERK);
-    set_metrics(autoware_trajectory.value(), METRIC::TRAVEL_DISTANCE);
-    set_metrics(autoware_trajectory.value(), METRIC::MINIMUM_TTC);
+    set_metrics(*autoware_trajectory, METRIC::LATERAL_ACCEL);
+    set_metrics(*autoware_trajectory, METRIC::LONGITUDINAL_JERK);
+    set_metrics(*autoware_trajectory, METRIC::TRAVEL_DISTANCE);
+    set_metrics(*autoware_trajectory, METRIC::MINIMUM_TTC);
 
     pub_system_metrics_->publish(msg);
   }
@@ -383,6 +681,8 @@ void BehaviorAnalyzerNode::metrics(const std::shared_ptr<DataSet> & data_set) co
 
 void BehaviorAnalyzerNode::score(const std::shared_ptr<DataSet> & data_set) const
 {
+  AUTOWARE_TOOL_TRACING_STAGE("behavior_analyzer", "score");
+
   {
     Float32MultiArrayStamped msg{};
 
@@ -391,7 +691,7 @@ void BehaviorAnalyzerNode::score(const std::shared_ptr<DataSet> & data_set) cons
 
     const auto set_reward = [&msg](const auto & data, const auto score_type) {
       msg.data.at(static_cast<size_t>(static_cast<size_t>(score_type))) =
-        static_cast<float>(data.scores.at(static_cast<size_t>(score_type)));
+        static_cast<float>(data.score(score_type));
     };
 
     set_reward(data_set->manual, SCORE::LONGITUDINAL_COMFORTABILITY);
@@ -402,8 +702,8 @@ void BehaviorAnalyzerNode::score(const std::shared_ptr<DataSet> & data_set) cons
     pub_manual_score_->publish(msg);
   }
 
-  const auto autoware_trajectory = data_set->sampling.autoware();
-  if (autoware_trajectory.has_value()) {
+  const auto * autoware_trajectory = data_set->sampling.autoware();
+  if (autoware_trajectory) {
     Float32MultiArrayStamped msg{};
 
     msg.stamp = now();
@@ -411,13 +711,13 @@ void BehaviorAnalyzerNode::score(const std::shared_ptr<DataSet> & data_set) cons
 
     const auto set_reward = [&msg](const auto & data, const auto score_type) {
       msg.data.at(static_cast<size_t>(static_cast<size_t>(score_type))) =
-        static_cast<float>(data.scores.at(static_cast<size_t>(score_type)));
+        static_cast<float>(data.score(score_type));
     };
 
-    set_reward(autoware_trajectory.value(), SCORE::LONGITUDINAL_COMFORTABILITY);
-    set_reward(autoware_trajectory.value(), SCORE::LATERAL_COMFORTABILITY);
-    set_reward(autoware_trajectory.value(), SCORE::EFFICIENCY);
-    set_reward(autoware_trajectory.value(), SCORE::SAFETY);
+    set_reward(*autoware_trajectory, SCORE::LONGITUDINAL_COMFORTABILITY);
+    set_reward(*autoware_trajectory, SCORE::LATERAL_COMFORTABILITY);
+    set_reward(*autoware_trajectory, SCORE::EFFICIENCY);
+    set_reward(*autoware_trajectory, SCORE::SAFETY);
 
     pub_system_score_->publish(msg);
   }
@@ -425,81 +725,130 @@ void BehaviorAnalyzerNode::score(const std::shared_ptr<DataSet> & data_set) cons
 
 void BehaviorAnalyzerNode::visualize(const std::shared_ptr<DataSet> & data_set) const
 {
+  const auto now = get_clock()->now();
+  if (
+    last_visualization_time_.has_value() &&
+    (now - last_visualization_time_.value()).seconds() < visualization_period_) {
+    return;
+  }
+  last_visualization_time_ = now;
+
+  const auto & p = parameters_;
+  const auto & sampling = data_set->sampling;
+
   MarkerArray msg;
 
-  size_t i = 0;
+  // The markers of a namespace keep their ids from tick to tick, so that they are modified in
+  // place, and only the markers of the last tick beyond the current number are deleted.
+  std::unordered_map<std::string, size_t> marker_nums;
+  const auto add = [&](Marker marker) {
+    marker.id = static_cast<int32_t>(marker_nums[marker.ns]++);
+    marker.action = Marker::MODIFY;
+    msg.markers.push_back(std::move(marker));
+  };
+
   for (const auto & point : data_set->manual.odometry_history) {
     Marker marker = createDefaultMarker(
-      "map", rclcpp::Clock{RCL_ROS_TIME}.now(), "manual", i++, Marker::ARROW,
-      createMarkerScale(0.7, 0.3, 0.3), createMarkerColor(1.0, 0.0, 0.0, 0.999));
+      "map", now, "manual", 0, Marker::ARROW, createMarkerScale(0.7, 0.3, 0.3),
+      createMarkerColor(1.0, 0.0, 0.0, 0.999));
     marker.pose = point->pose.pose;
-    msg.markers.push_back(marker);
+    add(marker);
   }
 
-  for (const auto & trajectory : data_set->sampling.data) {
-    Marker marker = createDefaultMarker(
-      "map", rclcpp::Clock{RCL_ROS_TIME}.now(), "candidates", i++, Marker::LINE_STRIP,
-      createMarkerScale(0.05, 0.0, 0.0), createMarkerColor(0.0, 0.0, 1.0, 0.999));
-    if (!trajectory.feasible()) {
-      for (const auto & point : trajectory.points) {
-        marker.points.push_back(point.pose.position);
-        marker.colors.push_back(createMarkerColor(0.1, 0.1, 0.1, 0.5));
-      }
-    } else {
-      for (const auto & point : trajectory.points) {
-        marker.points.push_back(point.pose.position);
-        marker.colors.push_back(createMarkerColor(0.0, 0.0, 1.0, 0.999));
-      }
+  // the top_k feasible candidates by total score, or all the candidates if top_k is negative
+  std::vector<size_t> candidates;
+  if (visualization_top_k_ < 0) {
+    candidates.resize(sampling.data.size());
+    std::iota(candidates.begin(), candidates.end(), 0);
+  } else {
+    candidates = sampling.feasible_indices;
+    const auto k = std::min(static_cast<size_t>(visualization_top_k_), candidates.size());
+    std::partial_sort(
+      candidates.begin(), candidates.begin() + k, candidates.end(),
+      [&](const size_t a, const size_t b) {
+        return sampling.data.at(a).total(p->w0, p->w1, p->w2, p->w3) >
+               sampling.data.at(b).total(p->w0, p->w1, p->w2, p->w3);
+      });
+    candidates.resize(k);
+  }
+
+  // all the candidates are packed in one line list
+  Marker candidate_marker = createDefaultMarker(
+    "map", now, "candidates", 0, Marker::LINE_LIST, createMarkerScale(0.05, 0.0, 0.0),
+    createMarkerColor(0.0, 0.0, 1.0, 0.999));
+  for (const auto i : candidates) {
+    const auto & trajectory = sampling.data.at(i);
+    const auto color = trajectory.feasible() ? createMarkerColor(0.0, 0.0, 1.0, 0.999)
+                                             : createMarkerColor(0.1, 0.1, 0.1, 0.5);
+    for (size_t j = 1; j < trajectory.points.size(); j++) {
+      candidate_marker.points.push_back(trajectory.points.at(j - 1).pose.position);
+      candidate_marker.points.push_back(trajectory.points.at(j).pose.position);
+      candidate_marker.colors.push_back(color);
+      candidate_marker.colors.push_back(color);
     }
-    msg.markers.push_back(marker);
+  }
+  if (!candidate_marker.points.empty()) {
+    add(candidate_marker);
   }
 
-  const auto best_trajectory =
-    data_set->sampling.best(parameters_->w0, parameters_->w1, parameters_->w2, parameters_->w3);
-  if (best_trajectory.has_value()) {
+  const auto best_index = sampling.best_index(p->w0, p->w1, p->w2, p->w3);
+  if (best_index.has_value()) {
     Marker marker = createDefaultMarker(
-      "map", rclcpp::Clock{RCL_ROS_TIME}.now(), "best", i++, Marker::LINE_STRIP,
-      createMarkerScale(0.2, 0.0, 0.0), createMarkerColor(1.0, 1.0, 1.0, 0.999));
-    for (const auto & point : best_trajectory.value().points) {
+      "map", now, "best", 0, Marker::LINE_STRIP, createMarkerScale(0.2, 0.0, 0.0),
+      createMarkerColor(1.0, 1.0, 1.0, 0.999));
+    for (const auto & point : sampling.data.at(best_index.value()).points) {
       marker.points.push_back(point.pose.position);
     }
-    msg.markers.push_back(marker);
+    add(marker);
   }
 
-  const auto autoware_trajectory = data_set->sampling.autoware();
-  if (autoware_trajectory.has_value()) {
-    for (const auto & point : autoware_trajectory.value().points) {
+  const auto * autoware_trajectory = sampling.autoware();
+  if (autoware_trajectory) {
+    for (const auto & point : autoware_trajectory->points) {
       Marker marker = createDefaultMarker(
-        "map", rclcpp::Clock{RCL_ROS_TIME}.now(), "system", i++, Marker::ARROW,
-        createMarkerScale(0.7, 0.3, 0.3), createMarkerColor(1.0, 1.0, 0.0, 0.999));
+        "map", now, "system", 0, Marker::ARROW, createMarkerScale(0.7, 0.3, 0.3),
+        createMarkerColor(1.0, 1.0, 0.0, 0.999));
       marker.pose = point.pose;
+      add(marker);
+    }
+  }
+
+  for (const auto & [ns, last_num] : visualization_marker_nums_) {
+    for (size_t id = marker_nums[ns]; id < last_num; id++) {
+      Marker marker;
+      marker.header.frame_id = "map";
+      marker.header.stamp = now;
+      marker.ns = ns;
+      marker.id = static_cast<int32_t>(id);
+      marker.action = Marker::DELETE;
       msg.markers.push_back(marker);
     }
   }
+  visualization_marker_nums_ = marker_nums;
 
   pub_marker_->publish(msg);
 }
 
 void BehaviorAnalyzerNode::print(const std::shared_ptr<DataSet> & data_set) const
 {
-  const auto autoware_trajectory = data_set->sampling.autoware();
-  if (!autoware_trajectory.has_value()) {
+  const auto * autoware_trajectory = data_set->sampling.autoware();
+  if (!autoware_trajectory) {
     return;
   }
 
   const auto & p = parameters_;
 
-  const auto best_trajectory = data_set->sampling.best(p->w0, p->w1, p->w2, p->w3);
-  if (!best_trajectory.has_value()) {
+  const auto * best_trajectory = data_set->sampling.best(p->w0, p->w1, p->w2, p->w3);
+  if (!best_trajectory) {
     return;
   }
 
   std::cout << "---result---" << std::endl;
   std::cout << "[HUMAN] SCORE:" << data_set->manual.total(p->w0, p->w1, p->w2, p->w3) << std::endl;
-  std::cout << "[AUTOWARE] SCORE:" << autoware_trajectory.value().total(p->w0, p->w1, p->w2, p->w3)
+  std::cout << "[AUTOWARE] SCORE:" << autoware_trajectory->total(p->w0, p->w1, p->w2, p->w3)
             << std::endl;
-  std::cout << "[SAMPLING] BEST SCORE:" << best_trajectory.value().total(p->w0, p->w1, p->w2, p->w3)
-            << "(" << best_trajectory.value().tag << ")" << std::endl;
+  std::cout << "[SAMPLING] BEST SCORE:" << best_trajectory->total(p->w0, p->w1, p->w2, p->w3)
+            << "(" << best_trajectory->tag << ")" << std::endl;
 }
 
 void BehaviorAnalyzerNode::on_timer()
@@ -15,7 +15,9 @@
 #ifndef NODE_HPP_
 #define NODE_HPP_
 
+#include "columns.hpp"
 #include "data_structs.hpp"
+#include "loss_table.hpp"
 #include "rosbag2_cpp/reader.hpp"
 #include "type_alias.hpp"
 
@@ -25,9 +27,11 @@
 #include <rclcpp/rclcpp.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -35,6 +39,21 @@
 
 namespace autoware::behavior_analyzer
 {
+// parameters of the analysis, shared by the node and the batch tool
+auto declare_parameters(rclcpp::Node & node) -> std::shared_ptr<Parameters>;
+
+// read only the topics that are buffered by BagData
+void set_topic_filter(rosbag2_cpp::Reader & reader);
+
+// read @reader forward until all the buffers of @bag_data are ready or the bag ends
+void fill_buffers(rosbag2_cpp::Reader & reader, BagData & bag_data, const rclcpp::Logger & logger);
+
+// Add the losses of @table to every weight of @weight_grid, on the backend of @parameters. The
+// cuda backend falls back to the threads of the cpu one if no device is found.
+void evaluate_weight_grid(
+  const LossTable & table, std::vector<Result> & weight_grid,
+  const GridSearchParameters & parameters, const rclcpp::Logger & logger);
+
 class BehaviorAnalyzerNode : public rclcpp::Node
 {
 public:
@@ -49,6 +68,14 @@ private:
 
   void weight(const Trigger::Request::SharedPtr req, Trigger::Response::SharedPtr res);
 
+  void coarse_to_fine(const std::vector<std::shared_ptr<DataSet>> & data_sets) const;
+
+  // (re)start the rows of the analyzed steps in output.dir
+  void open_columns_writer();
+
+  // write the loss of every weight to output.dir
+  void write_weight_grid(const std::vector<Result> & weight_grid) const;
+
   void update(const std::shared_ptr<BagData> & bag_data, const double dt) const;
 
   void analyze(const std::shared_ptr<BagData> & bag_data) const;
@@ -79,8 +106,30 @@ private:
 
   std::shared_ptr<BagData> bag_data_;
 
+  // the data set of the last tick, whose memory is reused by the next tick
+  mutable std::shared_ptr<DataSet> data_set_;
+
   std::shared_ptr<Parameters> parameters_;
 
+  // the rows of the analyzed steps, nullptr if output.dir is empty
+  std::unique_ptr<ColumnsWriter> columns_writer_;
+
+  std::string output_dir_;
+
+  size_t output_batch_rows_;
+
+  // number of the sampled trajectories drawn besides the best and the autoware ones, all of them
+  // if negative
+  int64_t visualization_top_k_;
+
+  // [s] minimum period of the markers
+  double visualization_period_;
+
+  mutable std::optional<rclcpp::Time> last_visualization_time_;
+
+  // number of the markers of each namespace published last
+  mutable std::unordered_map<std::string, size_t> visualization_marker_nums_;
+
   mutable std::mutex mutex_;
 
   mutable rosbag2_cpp::Reader reader_;
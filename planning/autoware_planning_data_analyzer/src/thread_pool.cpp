@@ -0,0 +1,108 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace autoware::behavior_analyzer
+{
+ThreadPool::ThreadPool(const size_t thread_num)
+{
+  for (size_t t = 1; t < std::max<size_t>(thread_num, 1); t++) {
+    threads_.emplace_back(&ThreadPool::work, this, t);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_start_.notify_all();
+  for (auto & t : threads_) t.join();
+}
+
+void ThreadPool::run(const std::function<void(size_t)> & task)
+{
+  std::unique_lock<std::mutex> task_lock(task_mutex_, std::try_to_lock);
+  if (!task_lock.owns_lock()) {
+    for (size_t t = 0; t < size(); t++) {
+      task(t);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    busy_ = threads_.size();
+    generation_++;
+  }
+  cv_start_.notify_all();
+
+  std::exception_ptr error;
+  try {
+    task(0);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_done_.wait(lock, [this]() { return busy_ == 0; });
+    task_ = nullptr;
+    if (!error) {
+      error = error_;
+    }
+    error_ = nullptr;
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void ThreadPool::work(const size_t t)
+{
+  size_t generation = 0;
+
+  while (true) {
+    const std::function<void(size_t)> * task = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_start_.wait(lock, [&]() { return stop_ || generation_ != generation; });
+      if (stop_) return;
+      generation = generation_;
+      task = task_;
+    }
+
+    try {
+      (*task)(t);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy_--;
+    }
+    cv_done_.notify_one();
+  }
+}
+}  // namespace autoware::behavior_analyzer
@@ -0,0 +1,67 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THREAD_POOL_HPP_
+#define THREAD_POOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+// Persistent workers shared by the data sets of all the ticks, so that no thread is started per
+// tick. One task runs at a time: a caller that finds the workers busy, e.g. another shard of the
+// batch mode, runs its task alone instead of waiting for them.
+class ThreadPool
+{
+public:
+  explicit ThreadPool(const size_t thread_num);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  // number of threads of a task, including the calling thread
+  size_t size() const { return threads_.size() + 1; }
+
+  // run @task(t) for every t in [0, size()) and wait for them, task(0) on the calling thread. The
+  // first exception of the task is rethrown.
+  void run(const std::function<void(size_t)> & task);
+
+private:
+  void work(const size_t t);
+
+  std::vector<std::thread> threads_;
+
+  std::mutex task_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_start_;
+  std::condition_variable cv_done_;
+  const std::function<void(size_t)> * task_{nullptr};
+  std::exception_ptr error_;
+  size_t generation_{0};
+  size_t busy_{0};
+  bool stop_{false};
+};
+}  // namespace autoware::behavior_analyzer
+
+#endif  // THREAD_POOL_HPP_
@@ -17,6 +17,7 @@
 
 #include "autoware/motion_utils/trajectory/interpolation.hpp"
 #include "autoware/motion_utils/trajectory/trajectory.hpp"
+#include "autoware/universe_utils/math/normalization.hpp"
 #include "autoware_frenet_planner/frenet_planner.hpp"
 #include "autoware_path_sampler/prepare_inputs.hpp"
 #include "autoware_path_sampler/utils/trajectory_utils.hpp"
@@ -24,13 +25,43 @@
 #include "type_alias.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+namespace autoware::behavior_analyzer
+{
+// The spline and the arc lengths of a trajectory message, shared by the ticks that sample from
+// the same message, with the nearest segment of the last tick to start the next search from
+struct ReferencePath
+{
+  explicit ReferencePath(const Trajectory & trajectory)
+  : stamp{rclcpp::Time(trajectory.header.stamp).nanoseconds()},
+    spline{autoware::path_sampler::preparePathSpline(trajectory.points, true)},
+    arc_lengths(trajectory.points.size(), 0.0)
+  {
+    for (size_t i = 1; i < trajectory.points.size(); i++) {
+      const auto & p0 = trajectory.points.at(i - 1);
+      const auto & p1 = trajectory.points.at(i);
+      arc_lengths.at(i) = arc_lengths.at(i - 1) + autoware::universe_utils::calcDistance2d(p0, p1);
+    }
+  }
+
+  int64_t stamp;
+
+  autoware::sampler_common::transform::Spline2D spline;
+
+  std::vector<double> arc_lengths;
+
+  std::optional<size_t> ego_seg_idx{};
+};
+}  // namespace autoware::behavior_analyzer
+
 namespace autoware::behavior_analyzer::utils
 {
 Point vector2point(const geometry_msgs::msg::Vector3 & v)
@@ -102,11 +133,12 @@ double time_to_collision(
   return time_to_collisions.front();
 }
 
-auto convertToTrajectoryPoints(
+// the points of @trajectory, written to @traj_points
+void convertToTrajectoryPoints(
   const autoware::sampler_common::Trajectory & trajectory,
-  const vehicle_info_utils::VehicleInfo & vehicle_info) -> std::vector<TrajectoryPoint>
+  const vehicle_info_utils::VehicleInfo & vehicle_info, std::vector<TrajectoryPoint> & traj_points)
 {
-  std::vector<TrajectoryPoint> traj_points;
+  traj_points.clear();
   for (auto i = 0UL; i < trajectory.points.size(); ++i) {
     TrajectoryPoint p;
     p.pose.position.x = trajectory.points[i].x();
@@ -122,25 +154,87 @@ auto convertToTrajectoryPoints(
     p.front_wheel_angle_rad = vehicle_info.wheel_base_m * trajectory.curvatures.at(i);
     traj_points.push_back(p);
   }
-  return traj_points;
 }
 
 template <class T>
-auto convertToFrenetPoint(const T & points, const Point & search_point_geom, const size_t seg_idx)
-  -> FrenetPoint
+auto convertToFrenetPoint(
+  const T & points, const std::vector<double> & arc_lengths, const Point & search_point_geom,
+  const size_t seg_idx) -> FrenetPoint
 {
   FrenetPoint frenet_point;
 
   const double longitudinal_length =
     autoware::motion_utils::calcLongitudinalOffsetToSegment(points, seg_idx, search_point_geom);
-  frenet_point.length =
-    autoware::motion_utils::calcSignedArcLength(points, 0, seg_idx) + longitudinal_length;
+  frenet_point.length = arc_lengths.at(seg_idx) + longitudinal_length;
   frenet_point.distance =
     autoware::motion_utils::calcLateralOffset(points, search_point_geom, seg_idx);
 
   return frenet_point;
 }
 
+// reference path of @trajectory, from @cache if it was built for the same message
+auto reference_path(const Trajectory & trajectory, std::shared_ptr<ReferencePath> & cache)
+  -> ReferencePath &
+{
+  if (!cache || cache->stamp != rclcpp::Time(trajectory.header.stamp).nanoseconds()) {
+    cache = std::make_shared<ReferencePath>(trajectory);
+  }
+
+  return *cache;
+}
+
+// findFirstNearestSegmentIndexWithSoftConstraints, starting from the nearest segment of the last
+// tick. The ego moves forward along the trajectory, so the first local minimum of the distance
+// after the hint is the nearest point, unless the distance already grows at the hint.
+auto find_nearest_segment_index(
+  const std::vector<TrajectoryPoint> & points, const Pose & p_ego,
+  const std::optional<size_t> & hint, const double dist_threshold, const double yaw_threshold)
+  -> size_t
+{
+  const auto full_search = [&]() {
+    return autoware::motion_utils::findFirstNearestSegmentIndexWithSoftConstraints(
+      points, p_ego, dist_threshold, yaw_threshold);
+  };
+
+  if (!hint.has_value() || hint.value() + 1 >= points.size()) {
+    return full_search();
+  }
+
+  const auto squared_distance = [&](const size_t i) {
+    return autoware::universe_utils::calcSquaredDistance2d(points.at(i), p_ego);
+  };
+  const auto within_thresholds = [&](const size_t i) {
+    const auto yaw = autoware::universe_utils::normalizeRadian(
+      tf2::getYaw(points.at(i).pose.orientation) - tf2::getYaw(p_ego.orientation));
+    return squared_distance(i) < dist_threshold * dist_threshold &&
+           std::abs(yaw) < yaw_threshold;
+  };
+
+  const auto start = hint.value();
+  const auto moved_back = start > 0 && squared_distance(start - 1) < squared_distance(start);
+  if (!within_thresholds(start) || moved_back) {
+    return full_search();
+  }
+
+  size_t nearest = start;
+  while (nearest + 1 < points.size() && within_thresholds(nearest + 1) &&
+         squared_distance(nearest + 1) < squared_distance(nearest)) {
+    nearest++;
+  }
+
+  if (nearest == 0) {
+    return 0;
+  }
+
+  if (nearest + 1 == points.size()) {
+    return nearest - 1;
+  }
+
+  const auto signed_length =
+    autoware::motion_utils::calcLongitudinalOffsetToSegment(points, nearest, p_ego.position);
+  return signed_length <= 0.0 ? nearest - 1 : nearest;
+}
+
 auto prepareSamplingParameters(
   const autoware::sampler_common::Configuration & initial_state, const double base_length,
   const autoware::sampler_common::transform::Spline2D & path_spline,
@@ -159,7 +253,7 @@ auto prepareSamplingParameters(
     p.target_state.longitudinal_velocity =
       initial_state.velocity + lon_acceleration * p.target_duration;
     p.target_state.position.s = std::min(
-      max_s, path_spline.frenet(initial_state.pose).s +
+      max_s, initial_state.frenet.s +
                std::max(
                  0.0, initial_state.velocity * p.target_duration +
                         0.5 * lon_acceleration * std::pow(p.target_duration, 2.0) - base_length));
@@ -178,16 +272,18 @@ auto prepareSamplingParameters(
   return sampling_parameters;
 }
 
-auto resampling(
-  const Trajectory & trajectory, const Pose & p_ego, const size_t resample_num,
-  const double time_resolution) -> std::vector<TrajectoryPoint>
+// @trajectory resampled at the times of the metrics, written to @output
+void resampling(
+  const Trajectory & trajectory, ReferencePath & reference, const Pose & p_ego,
+  const size_t resample_num, const double time_resolution, std::vector<TrajectoryPoint> & output)
 {
-  const auto ego_seg_idx = autoware::motion_utils::findFirstNearestSegmentIndexWithSoftConstraints(
-    trajectory.points, p_ego, 10.0, M_PI_2);
+  const auto ego_seg_idx =
+    find_nearest_segment_index(trajectory.points, p_ego, reference.ego_seg_idx, 10.0, M_PI_2);
+  reference.ego_seg_idx = ego_seg_idx;
 
-  std::vector<TrajectoryPoint> output;
+  output.clear();
   const auto vehicle_pose_frenet =
-    convertToFrenetPoint(trajectory.points, p_ego.position, ego_seg_idx);
+    convertToFrenetPoint(trajectory.points, reference.arc_lengths, p_ego.position, ego_seg_idx);
 
   double length = 0.0;
   for (size_t i = 0; i < resample_num; i++) {
@@ -202,17 +298,20 @@ auto resampling(
     length +=
       pred_velocity * time_resolution + 0.5 * pred_accel * time_resolution * time_resolution;
   }
-
-  return output;
 }
 
-auto sampling(
-  const Trajectory & trajectory, const Pose & p_ego, const double v_ego, const double a_ego,
-  const vehicle_info_utils::VehicleInfo & vehicle_info,
-  const std::shared_ptr<Parameters> & parameters) -> std::vector<std::vector<TrajectoryPoint>>
+// the initial frenet state of the ego vehicle and the target states of the sampled trajectories
+struct SamplingProblem
 {
-  const auto reference_trajectory =
-    autoware::path_sampler::preparePathSpline(trajectory.points, true);
+  autoware::frenet_planner::FrenetState initial_state;
+  autoware::frenet_planner::SamplingParameters sampling_parameters;
+};
+
+auto sampling_problem(
+  const ReferencePath & reference, const Pose & p_ego, const double v_ego, const double a_ego,
+  const std::shared_ptr<Parameters> & parameters) -> SamplingProblem
+{
+  const auto & reference_trajectory = reference.spline;
 
   autoware::sampler_common::Configuration current_state;
   current_state.pose = {p_ego.position.x, p_ego.position.y};
@@ -224,12 +323,12 @@ auto sampling(
   current_state.heading = reference_trajectory.yaw(current_state.frenet.s);
   current_state.curvature = reference_trajectory.curvature(current_state.frenet.s);
 
-  const auto trajectory_length = autoware::motion_utils::calcArcLength(trajectory.points);
+  const auto trajectory_length = reference.arc_lengths.empty() ? 0.0 : reference.arc_lengths.back();
   const auto sampling_parameters = prepareSamplingParameters(
     current_state, 0.0, reference_trajectory, trajectory_length, parameters->target_state);
 
   autoware::frenet_planner::FrenetState initial_frenet_state;
-  initial_frenet_state.position = reference_trajectory.frenet(current_state.pose);
+  initial_frenet_state.position = current_state.frenet;
   initial_frenet_state.longitudinal_velocity = v_ego;
   initial_frenet_state.longitudinal_acceleration = a_ego;
   const auto s = initial_frenet_state.position.s;
@@ -254,18 +353,113 @@ auto sampling(
         (current_state.curvature * ((1 - path_curvature * d) / cos_yaw) - path_curvature);
   }
 
-  const auto sampling_frenet_trajectories = autoware::frenet_planner::generateTrajectories(
-    reference_trajectory, initial_frenet_state, sampling_parameters);
+  return SamplingProblem{initial_frenet_state, sampling_parameters};
+}
 
-  std::vector<std::vector<TrajectoryPoint>> output;
-  output.reserve(sampling_frenet_trajectories.size());
+// The quintic polynomial from (x0, v0, a0) at 0 to (xT, vT, aT) at @duration, the form the frenet
+// planner gives to the lateral and longitudinal motions of a candidate
+struct QuinticPolynomial
+{
+  QuinticPolynomial(
+    const double x0, const double v0, const double a0, const double xT, const double vT,
+    const double aT, const double duration)
+  : c0{x0}, c1{v0}, c2{0.5 * a0}
+  {
+    const auto T = duration;
+    const auto h = xT - x0 - v0 * T - 0.5 * a0 * T * T;
+    const auto hv = vT - v0 - a0 * T;
+    const auto ha = aT - a0;
+    c3 = (10.0 * h - 4.0 * hv * T + 0.5 * ha * T * T) / std::pow(T, 3);
+    c4 = (-15.0 * h + 7.0 * hv * T - ha * T * T) / std::pow(T, 4);
+    c5 = (6.0 * h - 3.0 * hv * T + 0.5 * ha * T * T) / std::pow(T, 5);
+  }
 
-  for (const auto & trajectory : sampling_frenet_trajectories) {
-    output.push_back(convertToTrajectoryPoints(
-      trajectory.resampleTimeFromZero(parameters->time_resolution), vehicle_info));
+  double position(const double t) const
+  {
+    return c0 + t * (c1 + t * (c2 + t * (c3 + t * (c4 + t * c5))));
+  }
+  double velocity(const double t) const
+  {
+    return c1 + t * (2.0 * c2 + t * (3.0 * c3 + t * (4.0 * c4 + t * 5.0 * c5)));
+  }
+  double acceleration(const double t) const
+  {
+    return 2.0 * c2 + t * (6.0 * c3 + t * (12.0 * c4 + t * 20.0 * c5));
   }
+  double jerk(const double t) const { return 6.0 * c3 + t * (24.0 * c4 + t * 60.0 * c5); }
+
+  double c0, c1, c2, c3{0.0}, c4{0.0}, c5{0.0};
+};
+
+// Whether the @i-th candidate of @problem is within the feasibility limits, from its polynomials
+// at the resampled times, without generating it. The lateral acceleration and the curvature add
+// the motion along the curvature of the reference path. The curvature is only checked above
+// 1 m/s, where dividing by the squared velocity is meaningful.
+bool within_limits(
+  const ReferencePath & reference, const SamplingProblem & problem, const size_t i,
+  const std::shared_ptr<Parameters> & parameters)
+{
+  const auto & limits = parameters->feasibility;
+  const auto & initial = problem.initial_state;
+  const auto & parameter = problem.sampling_parameters.parameters.at(i);
+  const auto & target = parameter.target_state;
+  const auto duration = parameter.target_duration;
+  if (duration <= 0.0) {
+    return true;
+  }
+
+  const QuinticPolynomial lateral(
+    initial.position.d, initial.lateral_velocity, initial.lateral_acceleration, target.position.d,
+    target.lateral_velocity, target.lateral_acceleration, duration);
+  const QuinticPolynomial longitudinal(
+    initial.position.s, initial.longitudinal_velocity, initial.longitudinal_acceleration,
+    target.position.s, target.longitudinal_velocity, target.longitudinal_acceleration, duration);
+
+  constexpr double min_velocity = 1.0;
+  const auto max_s = reference.spline.lastS();
+  for (size_t k = 0; k < parameters->resample_num; k++) {
+    const auto t = std::min(k * parameters->time_resolution, duration);
+    const auto s = std::clamp(longitudinal.position(t), 0.0, max_s);
+    const auto v = longitudinal.velocity(t);
+    const auto path_curvature = reference.spline.curvature(s);
+    const auto lat_acc = lateral.acceleration(t);
+
+    if (std::abs(lat_acc + path_curvature * v * v) > limits.max_lateral_acceleration) {
+      return false;
+    }
+    if (std::abs(lateral.jerk(t)) > limits.max_lateral_jerk) {
+      return false;
+    }
+    if (v > min_velocity) {
+      // second derivative of the lateral offset by the arc length of the reference path
+      const auto d_ss =
+        (lat_acc - lateral.velocity(t) * longitudinal.acceleration(t) / v) / (v * v);
+      if (std::abs(path_curvature + d_ss) > limits.max_curvature) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// The @i-th sampled trajectory of @problem, written to @points. It only reads @reference and
+// @problem, so the trajectories of a problem are generated concurrently.
+void sampling(
+  const ReferencePath & reference, const SamplingProblem & problem, const size_t i,
+  const vehicle_info_utils::VehicleInfo & vehicle_info,
+  const std::shared_ptr<Parameters> & parameters, std::vector<TrajectoryPoint> & points)
+{
+  autoware::frenet_planner::SamplingParameters sampling_parameters;
+  sampling_parameters.resolution = problem.sampling_parameters.resolution;
+  sampling_parameters.parameters.push_back(problem.sampling_parameters.parameters.at(i));
+
+  const auto sampling_frenet_trajectories = autoware::frenet_planner::generateTrajectories(
+    reference.spline, problem.initial_state, sampling_parameters);
 
-  return output;
+  convertToTrajectoryPoints(
+    sampling_frenet_trajectories.front().resampleTimeFromZero(parameters->time_resolution),
+    vehicle_info, points);
 }
 }  // namespace autoware::behavior_analyzer::utils
 
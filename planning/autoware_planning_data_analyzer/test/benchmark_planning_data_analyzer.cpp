@@ -0,0 +1,333 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the stages of the analysis over synthetic messages at 10 Hz, with the ego vehicle
+// following a curved trajectory among objects driving on the same road, so that no bag is needed.
+// It is not run by ctest:
+//   autoware_planning_data_analyzer_benchmark [duration_sec=60] [object_num=20] [thread_num=1]
+// thread_num is the number of threads generating the sampled trajectories, as sampling.thread_num.
+
+#include "data_structs.hpp"
+#include "thread_pool.hpp"
+
+#include <autoware/universe_utils/geometry/geometry.hpp>
+#include <autoware/universe_utils/system/stop_watch.hpp>
+#include <rclcpp/serialization.hpp>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+using autoware::behavior_analyzer::AccelWithCovarianceStamped;
+using autoware::behavior_analyzer::BagData;
+using autoware::behavior_analyzer::CompactDataSet;
+using autoware::behavior_analyzer::DataSet;
+using autoware::behavior_analyzer::Odometry;
+using autoware::behavior_analyzer::Parameters;
+using autoware::behavior_analyzer::Pose;
+using autoware::behavior_analyzer::PredictedObjects;
+using autoware::behavior_analyzer::Result;
+using autoware::behavior_analyzer::SCORE;
+using autoware::behavior_analyzer::SteeringReport;
+using autoware::behavior_analyzer::TFMessage;
+using autoware::behavior_analyzer::ThreadPool;
+using autoware::behavior_analyzer::TOPIC;
+using autoware::behavior_analyzer::Trajectory;
+using autoware::behavior_analyzer::TrajectoryPoint;
+using autoware::universe_utils::createPoint;
+using autoware::universe_utils::createQuaternionFromYaw;
+
+const double rate = 10.0;
+const double speed = 10.0;
+const double wheel_base = 2.79;
+const int64_t t_start = 1000000000000;  // [ns]
+
+// peak resident set size of the process [MB]
+double peak_memory_mb()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+void report(const char * stage, const size_t num, const char * unit, double time_ms)
+{
+  time_ms = std::max(time_ms, 1e-3);
+  std::printf(
+    "%-16s %10lu %-12s in %10.1f[ms], %14.1f %s/s, peak memory %8.1f[MB]\n", stage, num, unit,
+    time_ms, static_cast<double>(num) / (time_ms * 1e-3), unit, peak_memory_mb());
+}
+
+// the road, a gentle S curve parametrized by x, whose y and yaw are given at @x
+double road_y(const double x)
+{
+  return 10.0 * std::sin(x / 150.0);
+}
+
+double road_yaw(const double x)
+{
+  return std::atan(10.0 / 150.0 * std::cos(x / 150.0));
+}
+
+double road_curvature(const double x)
+{
+  const auto dy = 10.0 / 150.0 * std::cos(x / 150.0);
+  const auto ddy = -10.0 / 150.0 / 150.0 * std::sin(x / 150.0);
+  return ddy / std::pow(1.0 + dy * dy, 1.5);
+}
+
+Pose road_pose(const double x)
+{
+  Pose pose;
+  pose.position = createPoint(x, road_y(x), 0.0);
+  pose.orientation = createQuaternionFromYaw(road_yaw(x));
+  return pose;
+}
+
+struct Message
+{
+  std::string topic;
+  rclcpp::SerializedMessage serialized;
+};
+
+template <typename T>
+void push(std::vector<Message> & messages, const std::string & topic, const T & msg)
+{
+  static rclcpp::Serialization<T> serialization;
+  messages.push_back(Message{topic, rclcpp::SerializedMessage{}});
+  serialization.serialize_message(&msg, &messages.back().serialized);
+}
+
+// The serialized messages of every topic of BagData over @duration, in the order of their stamps,
+// as a bag would give them. The ego vehicle drives the road at a constant speed, the trajectory
+// follows the road for 200 m ahead of it, and the objects drive the road ahead at other speeds.
+std::vector<Message> make_messages(const double duration, const size_t object_num)
+{
+  std::vector<Message> messages;
+  const auto step_num = static_cast<size_t>(duration * rate);
+
+  for (size_t i = 0; i < step_num; i++) {
+    const auto t = static_cast<double>(i) / rate;
+    const rclcpp::Time time(t_start + static_cast<int64_t>(t * 1e9));
+    const auto x = speed * t;
+
+    TFMessage tf;
+    tf.transforms.emplace_back();
+    tf.transforms.back().header.stamp = time;
+    tf.transforms.back().header.frame_id = "map";
+    tf.transforms.back().child_frame_id = "base_link";
+    tf.transforms.back().transform.translation.x = x;
+    tf.transforms.back().transform.translation.y = road_y(x);
+    tf.transforms.back().transform.rotation = createQuaternionFromYaw(road_yaw(x));
+    push(messages, TOPIC::TF, tf);
+
+    Odometry odometry;
+    odometry.header.stamp = time;
+    odometry.header.frame_id = "map";
+    odometry.child_frame_id = "base_link";
+    odometry.pose.pose = road_pose(x);
+    odometry.twist.twist.linear.x = speed;
+    push(messages, TOPIC::ODOMETRY, odometry);
+
+    AccelWithCovarianceStamped accel;
+    accel.header.stamp = time;
+    accel.header.frame_id = "base_link";
+    accel.accel.accel.linear.y = speed * speed * road_curvature(x);
+    push(messages, TOPIC::ACCELERATION, accel);
+
+    SteeringReport steering;
+    steering.stamp = time;
+    steering.steering_tire_angle = static_cast<float>(std::atan(wheel_base * road_curvature(x)));
+    push(messages, TOPIC::STEERING, steering);
+
+    Trajectory trajectory;
+    trajectory.header.stamp = time;
+    trajectory.header.frame_id = "map";
+    for (size_t j = 0; j < 200; j++) {
+      const auto x_j = x + static_cast<double>(j);
+      TrajectoryPoint point;
+      point.pose = road_pose(x_j);
+      point.longitudinal_velocity_mps = static_cast<float>(speed);
+      point.front_wheel_angle_rad = static_cast<float>(std::atan(wheel_base * road_curvature(x_j)));
+      point.time_from_start = rclcpp::Duration::from_seconds(static_cast<double>(j) / speed);
+      trajectory.points.push_back(point);
+    }
+    push(messages, TOPIC::TRAJECTORY, trajectory);
+
+    PredictedObjects objects;
+    objects.header.stamp = time;
+    objects.header.frame_id = "map";
+    for (size_t k = 0; k < object_num; k++) {
+      const auto object_speed = speed + 2.0 * std::sin(static_cast<double>(k));
+      const auto x_k = 30.0 + 15.0 * static_cast<double>(k) + object_speed * t;
+      objects.objects.emplace_back();
+      auto & kinematics = objects.objects.back().kinematics;
+      kinematics.initial_pose_with_covariance.pose = road_pose(x_k);
+      kinematics.initial_twist_with_covariance.twist.linear.x = object_speed;
+      objects.objects.back().shape.dimensions.x = 4.5;
+      objects.objects.back().shape.dimensions.y = 1.8;
+      objects.objects.back().shape.dimensions.z = 1.5;
+    }
+    push(messages, TOPIC::OBJECTS, objects);
+  }
+
+  return messages;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const double duration = argc > 1 ? std::stod(argv[1]) : 60.0;
+  const size_t object_num = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+  const size_t thread_num = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1;
+
+  // the sampling of the default parameters
+  const auto parameters = std::make_shared<Parameters>();
+  parameters->target_state.lat_positions = {-4.5, -2.5, 0.0, 2.5, 4.0};
+  parameters->target_state.lat_velocities = {0.0};
+  parameters->target_state.lat_accelerations = {0.0};
+  parameters->target_state.lon_positions = {0.0};
+  parameters->target_state.lon_velocities = {0.0};
+  parameters->target_state.lon_accelerations = {-0.2, -0.1, 0.0, 0.1, 0.2};
+  if (thread_num > 1) {
+    parameters->thread_pool = std::make_shared<ThreadPool>(thread_num);
+  }
+
+  autoware::vehicle_info_utils::VehicleInfo vehicle_info;
+  vehicle_info.wheel_base_m = wheel_base;
+
+  // the weight grid of the default parameters, [0.1, 1.0] by 0.2
+  std::vector<Result> weight_grid;
+  for (double w0 = 0.1; w0 < 1.02; w0 += 0.2) {
+    for (double w1 = 0.1; w1 < 1.02; w1 += 0.2) {
+      for (double w2 = 0.1; w2 < 1.02; w2 += 0.2) {
+        for (double w3 = 0.1; w3 < 1.02; w3 += 0.2) {
+          weight_grid.emplace_back(w0, w1, w2, w3);
+        }
+      }
+    }
+  }
+
+  autoware::universe_utils::StopWatch<std::chrono::milliseconds> stop_watch;
+
+  stop_watch.tic("serialize");
+  const auto messages = make_messages(duration, object_num);
+  const double serialize_time = stop_watch.toc("serialize");
+
+  // ------------------------ //
+  // Steps, as the batch mode //
+  // ------------------------ //
+  const auto dt = static_cast<int64_t>(1e9 / rate);
+  const auto bag_data = std::make_shared<BagData>(t_start);
+  std::optional<DataSet> data_set;
+  std::vector<CompactDataSet> steps;
+  size_t next = 0;
+  size_t step_num = 0;
+  size_t trajectory_num = 0;
+  size_t feasible_num = 0;
+  size_t pruned_num = 0;
+  double append_time = 0.0;
+  double manual_time = 0.0;
+  double sampling_time = 0.0;
+  double score_time = 0.0;
+  double selection_time = 0.0;
+
+  while (true) {
+    bag_data->update(dt);
+
+    stop_watch.tic("append");
+    while (!bag_data->ready() && next < messages.size()) {
+      const auto & message = messages.at(next++);
+      bag_data->buffers.at(message.topic)->append(message.serialized.get_rcl_serialized_message());
+    }
+    append_time += stop_watch.toc("append");
+
+    // the end of the messages
+    if (!bag_data->ready()) break;
+
+    // the first data set allocates the trajectories, which the next steps recycle
+    if (!data_set) {
+      data_set.emplace(bag_data, vehicle_info, parameters);
+      continue;
+    }
+
+    stop_watch.tic("manual");
+    data_set->manual.update(bag_data);
+    manual_time += stop_watch.toc("manual");
+
+    stop_watch.tic("sampling");
+    data_set->sampling.update(bag_data, vehicle_info, parameters);
+    sampling_time += stop_watch.toc("sampling");
+
+    // the metrics and the scores of every feasible trajectory, computed on first use
+    stop_watch.tic("score");
+    const auto & score_matrix = data_set->sampling.scores(1.0, 1.0, 1.0, 1.0);
+    score_time += stop_watch.toc("score");
+
+    size_t found_num = 0;
+    stop_watch.tic("selection");
+    for (const auto & w : weight_grid) {
+      found_num += data_set->sampling.best_index(w.w0, w.w1, w.w2, w.w3).has_value();
+    }
+    selection_time += stop_watch.toc("selection");
+
+    step_num++;
+    trajectory_num += data_set->sampling.data.size();
+    feasible_num += score_matrix.size() / static_cast<size_t>(SCORE::SIZE);
+    pruned_num += data_set->sampling.pruned_num;
+    if (found_num == weight_grid.size()) {
+      steps.emplace_back(data_set.value());
+    }
+  }
+
+  if (steps.empty()) {
+    std::printf("no step for the benchmark, the duration must be longer than 21[s].\n");
+    return 1;
+  }
+
+  stop_watch.tic("loss");
+  double loss = 0.0;
+  for (const auto & w : weight_grid) {
+    for (const auto & step : steps) {
+      loss += step.loss(w.w0, w.w1, w.w2, w.w3);
+    }
+  }
+  const double loss_time = stop_watch.toc("loss");
+
+  std::printf(
+    "benchmark of %.0f[s], %lu objects, %lu threads, %lu steps, %lu trajectories (%lu pruned), "
+    "%lu weights (loss %.4g)\n",
+    duration, object_num, std::max<size_t>(thread_num, 1), step_num, trajectory_num, pruned_num,
+    weight_grid.size(), loss);
+  report("serialize", messages.size(), "messages", serialize_time);
+  report("append", next, "messages", append_time);
+  report("manual", step_num, "steps", manual_time);
+  report("sampling", step_num, "steps", sampling_time);
+  report("sampling", trajectory_num, "trajectories", sampling_time);
+  report("score", feasible_num, "trajectories", score_time);
+  report("selection", step_num * weight_grid.size(), "selections", selection_time);
+  report("loss", steps.size() * weight_grid.size(), "losses", loss_time);
+  return 0;
+}
@@ -25,9 +25,11 @@
 #include "tier4_rtc_msgs/srv/cooperate_commands.hpp"
 #include <unique_identifier_msgs/msg/uuid.hpp>
 
-#include <map>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace autoware::rtc_replayer
@@ -41,6 +43,18 @@ using tier4_rtc_msgs::msg::CooperateStatusArray;
 using tier4_rtc_msgs::msg::Module;
 using tier4_rtc_msgs::srv::CooperateCommands;
 using unique_identifier_msgs::msg::UUID;
+
+struct UUIDHash
+{
+  size_t operator()(const UUID::_uuid_type & uuid) const
+  {
+    uint64_t upper, lower;
+    std::memcpy(&upper, uuid.data(), sizeof(upper));
+    std::memcpy(&lower, uuid.data() + sizeof(upper), sizeof(lower));
+    return std::hash<uint64_t>{}(upper ^ (lower * 0x9e3779b97f4a7c15ULL));
+  }
+};
+
 class RTCReplayerNode : public rclcpp::Node
 {
 public:
@@ -51,7 +65,7 @@ private:
 
   rclcpp::Subscription<CooperateStatusArray>::SharedPtr sub_statuses_;
   rclcpp::Client<CooperateCommands>::SharedPtr client_rtc_commands_;
-  std::map<std::string, uint8_t> prev_cmd_status_;
+  std::unordered_map<UUID::_uuid_type, uint8_t, UUIDHash> prev_cmd_status_;
 };
 
 }  // namespace autoware::rtc_replayer
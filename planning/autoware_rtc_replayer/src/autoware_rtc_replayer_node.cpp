@@ -93,8 +93,12 @@ std::string to_string(const unique_identifier_msgs::msg::UUID & uuid)
 RTCReplayerNode::RTCReplayerNode(const rclcpp::NodeOptions & node_options)
 : Node("rtc_replayer_node", node_options)
 {
+  // A bag replayed faster than real time delivers statuses in bursts, every status is needed to
+  // find the command changes
+  const auto queue_size = declare_parameter<int>("queue_size", 100);
   sub_statuses_ = create_subscription<CooperateStatusArray>(
-    "/debug/rtc_status", 1, std::bind(&RTCReplayerNode::onCooperateStatus, this, _1));
+    "/debug/rtc_status", rclcpp::QoS{static_cast<size_t>(std::max(queue_size, 1))},
+    std::bind(&RTCReplayerNode::onCooperateStatus, this, _1));
   client_rtc_commands_ = create_client<CooperateCommands>("/api/external/set/rtc_commands");
 }
 
@@ -102,25 +106,26 @@ void RTCReplayerNode::onCooperateStatus(const CooperateStatusArray::ConstSharedP
 {
   if (msg->statuses.empty()) return;
   CooperateCommands::Request::SharedPtr request = std::make_shared<CooperateCommands::Request>();
-  for (auto status : msg->statuses) {
+  for (const auto & status : msg->statuses) {
     const auto cmd_status = status.command_status.type;
-    const auto uuid_string = to_string(status.uuid);
+    const auto [prev_cmd_status, is_new] =
+      prev_cmd_status_.try_emplace(status.uuid.uuid, cmd_status);
     // add command which has change from previous status and command is already registered
-    if (
-      prev_cmd_status_.find(uuid_string) != prev_cmd_status_.end() &&
-      cmd_status != prev_cmd_status_[uuid_string]) {
-      CooperateCommand cc;
-      // send previous command status
-      cc.command.type = cmd_status;
-      cc.uuid = status.uuid;
-      cc.module = status.module;
-      request->stamp = status.stamp;
-      request->commands.emplace_back(cc);
-      std::cerr << "uuid: " << uuid_string << " module: " << getModuleName(cc.module.type)
-                << " status: " << getModuleStatus(cmd_status) << std::endl;
+    if (is_new || prev_cmd_status->second == cmd_status) {
+      continue;
     }
     // post process
-    prev_cmd_status_[uuid_string] = cmd_status;
+    prev_cmd_status->second = cmd_status;
+
+    CooperateCommand cc;
+    // send previous command status
+    cc.command.type = cmd_status;
+    cc.uuid = status.uuid;
+    cc.module = status.module;
+    request->stamp = status.stamp;
+    request->commands.emplace_back(cc);
+    std::cerr << "uuid: " << to_string(status.uuid) << " module: " << getModuleName(cc.module.type)
+              << " status: " << getModuleStatus(cmd_status) << std::endl;
   }
   if (!request->commands.empty()) {
     client_rtc_commands_->async_send_request(request);
@@ -17,18 +17,24 @@
 import json
 import uuid
 
+from autoware_static_centerline_generator.srv import GetPlanPathProgress
 from autoware_static_centerline_generator.srv import LoadMap
 from autoware_static_centerline_generator.srv import PlanPath
 from autoware_static_centerline_generator.srv import PlanRoute
+from autoware_static_centerline_generator.srv import StartPlanPath
 from flask import Flask
 from flask import jsonify
 from flask import request
 from flask_cors import CORS
 import rclpy
 from rclpy.node import Node
+from std_msgs.msg import Empty
 
 rclpy.init()
 node = Node("static_centerline_generator_http_server")
+cancel_plan_path_publisher = node.create_publisher(
+    Empty, "/static_centerline_generator/cancel_plan_path", 1
+)
 
 app = Flask(__name__)
 CORS(app)
@@ -42,6 +48,54 @@ def create_client(service_type, server_name):
     return cli
 
 
+def call_service(service_type, server_name, req):
+    cli = create_client(service_type, server_name)
+    future = cli.call_async(req)
+    rclpy.spin_until_future_complete(node, future)
+    return future.result()
+
+
+def create_plan_path_error(res):
+    # error handling of the PlanPath and StartPlanPath responses, None if no error occurred
+    if res.message == "MapNotFound":
+        return jsonify(code=res.message, message="Map is missing."), 404
+    elif res.message == "LaneletsNotConnected":
+        return (
+            jsonify(
+                code=res.message,
+                message="Lanelets are not connected.",
+                object_ids=tuple(res.unconnected_lane_ids),
+            ),
+            400,
+        )
+    elif res.message != "":
+        return (
+            jsonify(
+                code="InternalServerError",
+                message="Error occurred on the server. Please check the terminal.",
+            ),
+            500,
+        )
+    return None
+
+
+def create_path_json(points_with_lane_ids):
+    result_json = []
+    for points_with_lane_id in points_with_lane_ids:
+        current_lane_points = []
+        for geom_point in points_with_lane_id.points:
+            point = {"x": geom_point.x, "y": geom_point.y, "z": geom_point.z}
+            current_lane_points.append(point)
+
+        current_result_json = {}
+        current_result_json["lane_id"] = int(points_with_lane_id.lane_id)
+        current_result_json["points"] = current_lane_points
+
+        result_json.append(current_result_json)
+
+    return tuple(result_json)
+
+
 @app.route("/map", methods=["POST"])
 def get_map():
     data = request.get_json()
@@ -122,54 +176,71 @@ def post_planned_path():
         # TODO(murooka) error handling for map_id mismatch
         print("map_id is not correct.")
 
-    # create client
-    cli = create_client(PlanPath, "/planning/static_centerline_generator/plan_path")
-
     # request path planning
     route_lane_ids = [eval(i) for i in request.args.getlist("route[]")]
-    req = PlanPath.Request(route=route_lane_ids)
-    future = cli.call_async(req)
+    res = call_service(
+        PlanPath,
+        "/planning/static_centerline_generator/plan_path",
+        PlanPath.Request(route=route_lane_ids),
+    )
 
-    # get result
-    rclpy.spin_until_future_complete(node, future)
-    res = future.result()
+    error = create_plan_path_error(res)
+    if error is not None:
+        return error
 
-    # error handling
-    if res.message == "MapNotFound":
-        return jsonify(code=res.message, message="Map is missing."), 404
-    elif res.message == "LaneletsNotConnected":
-        return (
-            jsonify(
-                code=res.message,
-                message="Lanelets are not connected.",
-                object_ids=tuple(res.unconnected_lane_ids),
-            ),
-            400,
-        )
-    elif res.message != "":
-        return (
-            jsonify(
-                code="InternalServerError",
-                message="Error occurred on the server. Please check the terminal.",
-            ),
-            500,
-        )
+    return json.dumps(create_path_json(res.points_with_lane_ids))
 
-    # create output json
-    result_json = []
-    for points_with_lane_id in res.points_with_lane_ids:
-        current_lane_points = []
-        for geom_point in points_with_lane_id.points:
-            point = {"x": geom_point.x, "y": geom_point.y, "z": geom_point.z}
-            current_lane_points.append(point)
 
-        current_result_json = {}
-        current_result_json["lane_id"] = int(points_with_lane_id.lane_id)
-        current_result_json["points"] = current_lane_points
+@app.route("/planned_path/start", methods=["GET"])
+def start_planned_path():
+    args = request.args.to_dict()
+    global map_id
+    if map_id != args.get("map_id"):
+        # TODO(murooka) error handling for map_id mismatch
+        print("map_id is not correct.")
+
+    # start path planning, which cancels the previous one
+    route_lane_ids = [eval(i) for i in request.args.getlist("route[]")]
+    res = call_service(
+        StartPlanPath,
+        "/planning/static_centerline_generator/start_plan_path",
+        StartPlanPath.Request(route=route_lane_ids),
+    )
+
+    error = create_plan_path_error(res)
+    if error is not None:
+        return error
+
+    return json.dumps({"job_id": res.job_id})
+
+
+@app.route("/planned_path/progress", methods=["GET"])
+def get_planned_path_progress():
+    args = request.args.to_dict()
+    res = call_service(
+        GetPlanPathProgress,
+        "/planning/static_centerline_generator/get_plan_path_progress",
+        GetPlanPathProgress.Request(job_id=int(args.get("job_id"))),
+    )
+
+    if res.message == "JobNotFound":
+        return jsonify(code=res.message, message="Path planning is not found."), 404
+
+    # the partial path while running, and the whole path once succeeded
+    return json.dumps(
+        {
+            "state": res.state,
+            "progress": res.progress,
+            "message": res.message,
+            "path": create_path_json(res.points_with_lane_ids),
+        }
+    )
 
-        result_json.append(current_result_json)
 
-    return json.dumps(tuple(result_json))
+@app.route("/planned_path/cancel", methods=["POST"])
+def cancel_planned_path():
+    cancel_plan_path_publisher.publish(Empty())
+    return ""
 
 
 if __name__ == "__main__":
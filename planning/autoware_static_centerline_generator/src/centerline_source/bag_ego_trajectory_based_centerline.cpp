@@ -20,6 +20,8 @@
 
 #include <nav_msgs/msg/odometry.hpp>
 
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -29,58 +31,68 @@ namespace autoware::static_centerline_generator
 std::vector<TrajectoryPoint> generate_centerline_with_bag(rclcpp::Node & node)
 {
   const auto bag_filename = node.declare_parameter<std::string>("bag_filename");
+  const double start_offset = node.declare_parameter<double>("bag_ego_trajectory.start_offset");
+  const double duration = node.declare_parameter<double>("bag_ego_trajectory.duration");
+  const double point_interval = node.declare_parameter<double>("bag_ego_trajectory.point_interval");
 
-  // open rosbag
+  // open rosbag, which reads the odometry topic only from the start of the time range
   rosbag2_cpp::Reader bag_reader;
   bag_reader.open(bag_filename);
 
-  // extract 2D position of ego's trajectory from rosbag
+  rosbag2_storage::StorageFilter filter;
+  filter.topics.emplace_back("/localization/kinematic_state");
+  bag_reader.set_filter(filter);
+
+  const int64_t start_time =
+    bag_reader.get_metadata().starting_time.time_since_epoch().count() +
+    static_cast<int64_t>(std::max(start_offset, 0.0) * 1e9);
+  const int64_t end_time = 0.0 < duration ? start_time + static_cast<int64_t>(duration * 1e9)
+                                          : std::numeric_limits<int64_t>::max();
+  bag_reader.seek(start_time);
+
+  // extract 2D position of ego's trajectory from rosbag, thinned out while reading
   rclcpp::Serialization<nav_msgs::msg::Odometry> bag_serialization;
+  nav_msgs::msg::Odometry ros_msg;
   std::vector<TrajectoryPoint> centerline_traj_points;
   while (bag_reader.has_next()) {
     const rosbag2_storage::SerializedBagMessageSharedPtr msg = bag_reader.read_next();
 
-    if (msg->topic_name != "/localization/kinematic_state") {
-      continue;
-    }
-
     rclcpp::SerializedMessage serialized_msg(*msg->serialized_data);
-    const auto ros_msg = std::make_shared<nav_msgs::msg::Odometry>();
+    bag_serialization.deserialize_message(&serialized_msg, &ros_msg);
 
-    bag_serialization.deserialize_message(&serialized_msg, ros_msg.get());
+    if (end_time < rclcpp::Time(ros_msg.header.stamp).nanoseconds()) {
+      break;
+    }
 
+    if (
+      !centerline_traj_points.empty() &&
+      autoware::universe_utils::calcDistance2d(
+        centerline_traj_points.back().pose.position, ros_msg.pose.pose.position) <
+        point_interval) {
+      continue;
+    }
+
+    // calculate rough orientation of the previous point towards the new one
     if (!centerline_traj_points.empty()) {
-      constexpr double epsilon = 1e-1;
-      if (
-        std::abs(centerline_traj_points.back().pose.position.x - ros_msg->pose.pose.position.x) <
-          epsilon &&
-        std::abs(centerline_traj_points.back().pose.position.y - ros_msg->pose.pose.position.y) <
-          epsilon) {
-        continue;
-      }
+      const double yaw_angle = autoware::universe_utils::calcAzimuthAngle(
+        centerline_traj_points.back().pose.position, ros_msg.pose.pose.position);
+      centerline_traj_points.back().pose.orientation =
+        autoware::universe_utils::createQuaternionFromYaw(yaw_angle);
     }
+
     TrajectoryPoint centerline_traj_point;
-    centerline_traj_point.pose.position = ros_msg->pose.pose.position;
+    centerline_traj_point.pose.position = ros_msg.pose.pose.position;
     centerline_traj_points.push_back(centerline_traj_point);
   }
 
-  RCLCPP_INFO(node.get_logger(), "Extracted centerline from the bag.");
-
-  // calculate rough orientation of centerline trajectory points
-  for (size_t i = 0; i < centerline_traj_points.size(); ++i) {
-    if (i == centerline_traj_points.size() - 1) {
-      if (i != 0) {
-        centerline_traj_points.at(i).pose.orientation =
-          centerline_traj_points.at(i - 1).pose.orientation;
-      }
-    } else {
-      const double yaw_angle = autoware::universe_utils::calcAzimuthAngle(
-        centerline_traj_points.at(i).pose.position, centerline_traj_points.at(i + 1).pose.position);
-      centerline_traj_points.at(i).pose.orientation =
-        autoware::universe_utils::createQuaternionFromYaw(yaw_angle);
-    }
+  // the last point keeps the orientation of the previous one
+  if (1 < centerline_traj_points.size()) {
+    centerline_traj_points.back().pose.orientation =
+      centerline_traj_points.at(centerline_traj_points.size() - 2).pose.orientation;
   }
 
+  RCLCPP_INFO(node.get_logger(), "Extracted centerline from the bag.");
+
   return centerline_traj_points;
 }
 }  // namespace autoware::static_centerline_generator
@@ -19,6 +19,7 @@
 #include "autoware/behavior_path_planner_common/data_manager.hpp"
 #include "autoware/motion_utils/resample/resample.hpp"
 #include "autoware/motion_utils/trajectory/conversion.hpp"
+#include "autoware/motion_utils/trajectory/trajectory.hpp"
 #include "autoware/path_optimizer/node.hpp"
 #include "autoware/path_smoother/elastic_band_smoother.hpp"
 #include "autoware/universe_utils/ros/parameter.hpp"
@@ -27,7 +28,10 @@
 #include "utils.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <exception>
 #include <memory>
 #include <string>
 #include <thread>
@@ -79,6 +83,59 @@ std_msgs::msg::Header create_header(const rclcpp::Time & now)
   header.stamp = now;
   return header;
 }
+
+// Number of points to shift the virtual ego pose from @idx by, which decreases linearly from
+// @max_stride on a straight path to @min_stride where the curvature reaches @curvature_threshold
+// within the points it skips
+std::vector<int> calc_strides(
+  const PathWithLaneId & path_with_lane_id, const int min_stride, const int max_stride,
+  const double curvature_threshold)
+{
+  const auto & points = path_with_lane_id.points;
+  std::vector<int> strides(points.size(), min_stride);
+  if (points.size() < 3 || max_stride <= min_stride || curvature_threshold <= 0.0) {
+    return strides;
+  }
+
+  const auto curvatures = autoware::motion_utils::calcCurvature(points);
+  for (size_t i = 0; i < points.size(); ++i) {
+    double max_curvature = 0.0;
+    for (size_t j = i; j < std::min(i + static_cast<size_t>(max_stride) + 1, points.size()); ++j) {
+      max_curvature = std::max(max_curvature, std::abs(curvatures.at(j)));
+    }
+    const double ratio = std::min(max_curvature / curvature_threshold, 1.0);
+    strides.at(i) = static_cast<int>(std::round(max_stride - (max_stride - min_stride) * ratio));
+  }
+
+  return strides;
+}
+
+// Nearest segment of @points to @pose, searched forward from the segment @hint. The spliced
+// trajectory moves forward monotonically, so the search visits a few points only.
+size_t find_nearest_segment_index_from(
+  const std::vector<TrajectoryPoint> & points, const Pose & pose, const size_t hint)
+{
+  size_t nearest_idx = std::min(hint, points.size() - 1);
+  double min_dist = autoware::universe_utils::calcSquaredDistance2d(points.at(nearest_idx), pose);
+  for (size_t i = nearest_idx + 1; i < points.size(); ++i) {
+    const double dist = autoware::universe_utils::calcSquaredDistance2d(points.at(i), pose);
+    if (min_dist < dist) {
+      break;
+    }
+    min_dist = dist;
+    nearest_idx = i;
+  }
+
+  // the nearest point ends the segment if the pose is behind it
+  if (
+    0 < nearest_idx &&
+    (nearest_idx + 1 == points.size() ||
+     autoware::motion_utils::calcLongitudinalOffsetToSegment(points, nearest_idx, pose.position) <
+       0.0)) {
+    return nearest_idx - 1;
+  }
+  return nearest_idx;
+}
 }  // namespace
 
 OptimizationTrajectoryBasedCenterline::OptimizationTrajectoryBasedCenterline(rclcpp::Node & node)
@@ -149,38 +206,97 @@ std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_tra
   rclcpp::Node & node, const PathWithLaneId & raw_path_with_lane_id,
   std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
   const LaneletRoute & route) const
+{
+  const bool publish_debug =
+    autoware::universe_utils::getOrDeclareParameter<bool>(node, "debug.publish_iterative_output");
+  const bool parallel_optimization =
+    autoware::universe_utils::getOrDeclareParameter<bool>(node, "parallel_optimization.enable");
+
+  std::vector<TrajectoryPoint> whole_optimized_traj_points;
+  if (parallel_optimization) {
+    whole_optimized_traj_points = optimize_windows_in_parallel(
+      node, raw_path_with_lane_id, route_handler_ptr, map_bin_ptr, route);
+  } else {
+    prepare_optimizers(1);
+    whole_optimized_traj_points = optimize_window(
+      node, raw_path_with_lane_id, route.goal_pose, true, *optimizer_pool_.eb_path_smoothers.at(0),
+      *optimizer_pool_.mpt_optimizers.at(0), route_handler_ptr, map_bin_ptr, route, publish_debug,
+      true);
+  }
+
+  if (!publish_debug) {
+    return whole_optimized_traj_points;
+  }
+
+  // remove the visualization of iterative trajectories
+  Trajectory empty_traj;
+  empty_traj.header = create_header(node.get_clock()->now());
+  pub_iterative_smoothed_traj_->publish(empty_traj);
+  pub_iterative_optimized_traj_->publish(empty_traj);
+
+  Path empty_path;
+  empty_path.header = create_header(node.get_clock()->now());
+  pub_iterative_path_->publish(empty_path);
+
+  return whole_optimized_traj_points;
+}
+
+std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_window(
+  rclcpp::Node & node, const PathWithLaneId & path_with_lane_id, const Pose & goal_pose,
+  const bool connect_goal, autoware::path_smoother::EBPathSmoother & eb_path_smoother,
+  autoware::path_optimizer::MPTOptimizer & mpt_optimizer,
+  std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
+  const LaneletRoute & route, const bool publish_debug, const bool report_iterations) const
 {
   const int wait_time_during_planning_iteration =
-    autoware::universe_utils::getOrDeclareParameter<int>(
-      node, "debug.wait_time_during_planning_iteration");
+    publish_debug ? autoware::universe_utils::getOrDeclareParameter<int>(
+                      node, "debug.wait_time_during_planning_iteration")
+                  : 0;
 
-  // create an instance of elastic band and model predictive trajectory.
-  const auto eb_path_smoother_ptr =
-    autoware::path_smoother::ElasticBandSmoother(create_node_options()).getElasticBandSmoother();
-  const auto mpt_optimizer_ptr =
-    autoware::path_optimizer::PathOptimizer(create_node_options()).getMPTOptimizer();
+  // the optimizers may be reused for another window, so their warm start is reset
+  eb_path_smoother.resetPreviousData();
+  mpt_optimizer.resetPreviousData();
 
-  // NOTE: The optimization is executed every following number of points.
-  constexpr int virtual_ego_pose_lon_shift_points_num = 1;
+  // NOTE: The optimization is executed every stride of points, which is shorter in curves.
+  const int min_stride = std::max(
+    autoware::universe_utils::getOrDeclareParameter<int>(
+      node, "optimization.stride.min_points_num"),
+    1);
+  const int max_stride = std::max(
+    autoware::universe_utils::getOrDeclareParameter<int>(
+      node, "optimization.stride.max_points_num"),
+    min_stride);
+  const auto strides = calc_strides(
+    path_with_lane_id, min_stride, max_stride,
+    autoware::universe_utils::getOrDeclareParameter<double>(
+      node, "optimization.stride.curvature_threshold"));
 
   // NOTE: num_initial_optimization exists to make the both optimizations stable since they may use
-  // warm start.
-  constexpr int num_initial_optimization = -2;
+  // warm start. The warm start is then propagated from an iteration to the next one.
+  const int num_initial_optimization = -std::max(
+    autoware::universe_utils::getOrDeclareParameter<int>(
+      node, "optimization.num_initial_optimization"),
+    0);
 
   // move the virtual_ego_pose forward following the raw_path_with_lane_id every cycle
   // and plan an optimized trajectory
   std::vector<TrajectoryPoint> whole_optimized_traj_points;
+  size_t splice_segment_idx = 0;
   for (int virtual_ego_pose_idx = num_initial_optimization;
-       virtual_ego_pose_idx < static_cast<int>(raw_path_with_lane_id.points.size());
-       virtual_ego_pose_idx += virtual_ego_pose_lon_shift_points_num) {
+       virtual_ego_pose_idx < static_cast<int>(path_with_lane_id.points.size());
+       virtual_ego_pose_idx +=
+       virtual_ego_pose_idx < 0 ? 1 : strides.at(static_cast<size_t>(virtual_ego_pose_idx))) {
     // calculate virtual ego pose for the optimization
     const auto virtual_ego_pose =
-      raw_path_with_lane_id.points.at(static_cast<size_t>(std::max(virtual_ego_pose_idx, 0)))
+      path_with_lane_id.points.at(static_cast<size_t>(std::max(virtual_ego_pose_idx, 0)))
         .point.pose;
 
     // create path_with_lane_id by goal_method
-    const auto path_with_lane_id_with_goal_connection = modify_goal_connection(
-      node, raw_path_with_lane_id, route_handler_ptr, map_bin_ptr, route, virtual_ego_pose);
+    const auto path_with_lane_id_with_goal_connection =
+      connect_goal ? modify_goal_connection(
+                       node, path_with_lane_id, route_handler_ptr, map_bin_ptr, route,
+                       virtual_ego_pose)
+                   : path_with_lane_id;
     if (path_with_lane_id_with_goal_connection.points.empty()) {
       continue;
     }
@@ -188,32 +304,38 @@ std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_tra
     // NOTE: path_with_lane_id is not used for the visualization since the
     // tier4_planning_rviz_plugin
     //       has an issue to die.
-    auto path = convert_to_path(path_with_lane_id_with_goal_connection);
-    path.header = create_header(node.get_clock()->now());
-    pub_iterative_path_->publish(path);
+    if (publish_debug) {
+      auto path = convert_to_path(path_with_lane_id_with_goal_connection);
+      path.header = create_header(node.get_clock()->now());
+      pub_iterative_path_->publish(path);
+    }
 
     // convert trajectory
     const auto traj_points = convert_to_trajectory_points(path_with_lane_id_with_goal_connection);
 
     // smooth trajectory by elastic band in the autoware_path_smoother package
     const auto smoothed_traj_points =
-      eb_path_smoother_ptr->smoothTrajectory(traj_points, virtual_ego_pose);
-    pub_iterative_smoothed_traj_->publish(
-      autoware::motion_utils::convertToTrajectory(
-        smoothed_traj_points, create_header(node.get_clock()->now())));
+      eb_path_smoother.smoothTrajectory(traj_points, virtual_ego_pose);
+    if (publish_debug) {
+      pub_iterative_smoothed_traj_->publish(
+        autoware::motion_utils::convertToTrajectory(
+          smoothed_traj_points, create_header(node.get_clock()->now())));
+    }
 
     // road collision avoidance by model predictive trajectory in the autoware_path_optimizer
     // package
     const autoware::path_optimizer::PlannerData planner_data{
-      raw_path_with_lane_id.header, smoothed_traj_points, raw_path_with_lane_id.left_bound,
-      raw_path_with_lane_id.right_bound, virtual_ego_pose};
-    const auto optimized_traj_points = mpt_optimizer_ptr->optimizeTrajectory(planner_data);
+      path_with_lane_id.header, smoothed_traj_points, path_with_lane_id.left_bound,
+      path_with_lane_id.right_bound, virtual_ego_pose};
+    const auto optimized_traj_points = mpt_optimizer.optimizeTrajectory(planner_data);
     if (!optimized_traj_points) {
       return whole_optimized_traj_points;
     }
-    pub_iterative_optimized_traj_->publish(
-      autoware::motion_utils::convertToTrajectory(
-        *optimized_traj_points, create_header(node.get_clock()->now())));
+    if (publish_debug) {
+      pub_iterative_optimized_traj_->publish(
+        autoware::motion_utils::convertToTrajectory(
+          *optimized_traj_points, create_header(node.get_clock()->now())));
+    }
 
     // connect the previously and currently optimized trajectory points
     // 1. generate valid_optimized_traj_points
@@ -235,45 +357,162 @@ std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_tra
     }
 
     // 3. the whole_optimized_traj_points close to the valid_optimized_traj_points is removed, and
-    // will be updated.
-    if (!valid_optimized_traj_points.empty()) {
-      const size_t nearest_segment_idx =
-        autoware::motion_utils::findFirstNearestSegmentIndexWithSoftConstraints(
-          whole_optimized_traj_points, valid_optimized_traj_points.front().pose, 1.0, 0.35);
-
-      const std::vector<TrajectoryPoint> extracted_whole_optimized_traj_points{
-        whole_optimized_traj_points.begin(),
-        whole_optimized_traj_points.begin() + nearest_segment_idx};
-      whole_optimized_traj_points = extracted_whole_optimized_traj_points;
+    // will be updated. The splice point is searched from the previous one.
+    if (!valid_optimized_traj_points.empty() && 1 < whole_optimized_traj_points.size()) {
+      splice_segment_idx = find_nearest_segment_index_from(
+        whole_optimized_traj_points, valid_optimized_traj_points.front().pose, splice_segment_idx);
+      whole_optimized_traj_points.resize(splice_segment_idx);
+    } else if (!valid_optimized_traj_points.empty()) {
+      whole_optimized_traj_points.clear();
     }
 
     // 4. register valid_optimized_traj_points
-    for (const auto & valid_optimized_traj_point : valid_optimized_traj_points) {
-      whole_optimized_traj_points.push_back(valid_optimized_traj_point);
+    whole_optimized_traj_points.insert(
+      whole_optimized_traj_points.end(), valid_optimized_traj_points.begin(),
+      valid_optimized_traj_points.end());
+
+    if (report_iterations) {
+      const double ratio = static_cast<double>(std::max(virtual_ego_pose_idx, 0)) /
+                           static_cast<double>(path_with_lane_id.points.size());
+      report_progress(whole_optimized_traj_points, ratio);
     }
 
     // 5. finish if the valid_optimized_traj_point contains the goal.
     const double dist_to_goal =
-      autoware::universe_utils::calcDistance2d(valid_optimized_traj_points.back(), route.goal_pose);
+      autoware::universe_utils::calcDistance2d(valid_optimized_traj_points.back(), goal_pose);
     if (dist_to_goal < 0.1) {
       break;
     }
 
     // wait for debugging purpose to visualize the iteration.
-    if (1e-5 < static_cast<double>(wait_time_during_planning_iteration)) {
+    if (publish_debug && 1e-5 < static_cast<double>(wait_time_during_planning_iteration)) {
       std::this_thread::sleep_for(std::chrono::milliseconds(wait_time_during_planning_iteration));
     }
   }
 
-  // remove the visualization of iterative trajectories
-  Trajectory empty_traj;
-  empty_traj.header = create_header(node.get_clock()->now());
-  pub_iterative_smoothed_traj_->publish(empty_traj);
-  pub_iterative_optimized_traj_->publish(empty_traj);
+  return whole_optimized_traj_points;
+}
 
-  Path empty_path;
-  empty_path.header = create_header(node.get_clock()->now());
-  pub_iterative_path_->publish(empty_path);
+std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_windows_in_parallel(
+  rclcpp::Node & node, const PathWithLaneId & raw_path_with_lane_id,
+  std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
+  const LaneletRoute & route) const
+{
+  // NOTE: the windows overlap by at least two points, so they can be stitched inside the overlap
+  const auto window_points_num = static_cast<size_t>(std::max(
+    autoware::universe_utils::getOrDeclareParameter<int>(
+      node, "parallel_optimization.window_points_num"),
+    3));
+  const auto overlap_points_num = std::min(
+    static_cast<size_t>(std::max(
+      autoware::universe_utils::getOrDeclareParameter<int>(
+        node, "parallel_optimization.overlap_points_num"),
+      2)),
+    window_points_num - 1);
+  const auto thread_num = static_cast<size_t>(std::max(
+    autoware::universe_utils::getOrDeclareParameter<int>(node, "parallel_optimization.thread_num"),
+    1));
+
+  const auto & points = raw_path_with_lane_id.points;
+  if (points.size() < 2) {
+    return {};
+  }
+
+  // windows [begin, end) of the raw path, where only the last one is connected to the goal
+  std::vector<std::pair<size_t, size_t>> windows;
+  for (size_t begin = 0;; begin += window_points_num - overlap_points_num) {
+    const auto end = std::min(begin + window_points_num, points.size());
+    windows.emplace_back(begin, end);
+    if (end == points.size()) {
+      break;
+    }
+  }
+
+  // the optimizers are built before the workers start, and each worker reuses its own pair
+  const auto worker_num = std::min(thread_num, windows.size());
+  prepare_optimizers(worker_num);
+  const auto & eb_path_smoothers = optimizer_pool_.eb_path_smoothers;
+  const auto & mpt_optimizers = optimizer_pool_.mpt_optimizers;
+
+  RCLCPP_INFO(
+    node.get_logger(), "Optimizing %lu windows of %lu points with %lu threads.", windows.size(),
+    window_points_num, worker_num);
+
+  std::vector<std::vector<TrajectoryPoint>> window_traj_points(windows.size());
+  std::vector<std::exception_ptr> errors(worker_num);
+  std::atomic<size_t> next_window(0);
+  std::atomic<size_t> done_window_num(0);
+
+  const auto worker = [&](const size_t worker_id) {
+    try {
+      for (size_t w = next_window++; w < windows.size(); w = next_window++) {
+        const auto [begin, end] = windows.at(w);
+        const bool is_last = w + 1 == windows.size();
+
+        PathWithLaneId window_path;
+        window_path.header = raw_path_with_lane_id.header;
+        window_path.left_bound = raw_path_with_lane_id.left_bound;
+        window_path.right_bound = raw_path_with_lane_id.right_bound;
+        window_path.points.assign(points.begin() + begin, points.begin() + end);
+
+        const auto goal_pose = is_last ? route.goal_pose : window_path.points.back().point.pose;
+        window_traj_points.at(w) = optimize_window(
+          node, window_path, goal_pose, is_last, *eb_path_smoothers.at(worker_id),
+          *mpt_optimizers.at(worker_id), route_handler_ptr, map_bin_ptr, route, false, false);
+        report_progress(
+          {}, static_cast<double>(++done_window_num) / static_cast<double>(windows.size()));
+      }
+    } catch (...) {
+      errors.at(worker_id) = std::current_exception();
+      next_window = windows.size();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < worker_num; ++i) {
+    threads.emplace_back(worker, i);
+  }
+  worker(0);
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  for (const auto & error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // stitch the windows at the middle of their overlaps, where both of them are far from the
+  // ends of their paths
+  auto whole_optimized_traj_points = window_traj_points.front();
+  for (size_t w = 1; w < windows.size(); ++w) {
+    const auto & next_traj_points = window_traj_points.at(w);
+    if (whole_optimized_traj_points.size() < 2 || next_traj_points.size() < 2) {
+      RCLCPP_WARN(node.get_logger(), "Failed to optimize the window %lu.", w);
+      break;
+    }
+
+    const auto & stitch_pose =
+      points.at((windows.at(w).first + windows.at(w - 1).second - 1) / 2).point.pose;
+    const size_t whole_segment_idx =
+      autoware::motion_utils::findFirstNearestSegmentIndexWithSoftConstraints(
+        whole_optimized_traj_points, stitch_pose, 1.0, 0.35);
+    const size_t next_segment_idx =
+      autoware::motion_utils::findFirstNearestSegmentIndexWithSoftConstraints(
+        next_traj_points, stitch_pose, 1.0, 0.35);
+
+    // the previous window was not optimized to its end
+    if (whole_segment_idx + 2 == whole_optimized_traj_points.size()) {
+      RCLCPP_WARN(node.get_logger(), "Failed to optimize the window %lu to its end.", w - 1);
+      break;
+    }
+
+    whole_optimized_traj_points.resize(whole_segment_idx + 1);
+    whole_optimized_traj_points.insert(
+      whole_optimized_traj_points.end(), next_traj_points.begin() + next_segment_idx + 1,
+      next_traj_points.end());
+  }
 
   return whole_optimized_traj_points;
 }
@@ -308,6 +547,26 @@ OptimizationTrajectoryBasedCenterline::create_route(
   return route_ptr;
 }
 
+void OptimizationTrajectoryBasedCenterline::report_progress(
+  const std::vector<TrajectoryPoint> & optimized_traj_points, const double ratio) const
+{
+  if (progress_callback_ && !progress_callback_(optimized_traj_points, std::min(ratio, 1.0))) {
+    throw CenterlineGenerationCanceled();
+  }
+}
+
+void OptimizationTrajectoryBasedCenterline::prepare_optimizers(const size_t optimizer_num) const
+{
+  // NOTE: the optimizers are extracted from temporary nodes, which declare their parameters and
+  //       set up the solvers once. Their previous data is reset by every window.
+  while (optimizer_pool_.eb_path_smoothers.size() < optimizer_num) {
+    optimizer_pool_.eb_path_smoothers.push_back(
+      autoware::path_smoother::ElasticBandSmoother(create_node_options()).getElasticBandSmoother());
+    optimizer_pool_.mpt_optimizers.push_back(
+      autoware::path_optimizer::PathOptimizer(create_node_options()).getMPTOptimizer());
+  }
+}
+
 void OptimizationTrajectoryBasedCenterline::init_path_generator_node(
   const geometry_msgs::msg::Pose current_pose, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
   const LaneletRoute & route) const
@@ -315,13 +574,18 @@ void OptimizationTrajectoryBasedCenterline::init_path_generator_node(
   autoware::path_generator::PathGenerator::InputData path_generator_input;
 
   if (!path_generator_node_) {
-    // initialize node, lanelet map and route
+    // initialize node and lanelet map
     path_generator_node_ =
       std::make_shared<autoware::path_generator::PathGenerator>(create_node_options());
 
     // NOTE: no need to register every time
     path_generator_input.lanelet_map_bin_ptr = map_bin_ptr;
-    path_generator_input.route_ptr = std::make_shared<LaneletRoute>(route);
+  }
+
+  // NOTE: the node is reused for the later routes, so the route is registered when it changes
+  if (!path_generator_route_ptr_ || *path_generator_route_ptr_ != route) {
+    path_generator_route_ptr_ = std::make_shared<LaneletRoute>(route);
+    path_generator_input.route_ptr = path_generator_route_ptr_;
   }
 
   path_generator_input.odometry_ptr = utils::convert_to_odometry(current_pose);
@@ -23,28 +23,105 @@
 #include "rclcpp/rclcpp.hpp"
 #include "type_alias.hpp"
 
+#include <functional>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+namespace autoware::path_smoother
+{
+class EBPathSmoother;
+}  // namespace autoware::path_smoother
+
+namespace autoware::path_optimizer
+{
+class MPTOptimizer;
+}  // namespace autoware::path_optimizer
+
 namespace autoware::static_centerline_generator
 {
+// thrown by the centerline generation when its progress callback cancels it
+class CenterlineGenerationCanceled : public std::runtime_error
+{
+public:
+  CenterlineGenerationCanceled() : std::runtime_error("The centerline generation was canceled.")
+  {
+  }
+};
+
 class OptimizationTrajectoryBasedCenterline
 {
 public:
+  // called with the trajectory optimized so far and the ratio of the raw path it covers, which
+  // is empty in the parallel optimization. Returning false cancels the generation.
+  // NOTE: the workers of the parallel optimization call it concurrently.
+  using ProgressCallback =
+    std::function<bool(const std::vector<TrajectoryPoint> & optimized_traj_points, double ratio)>;
+
   OptimizationTrajectoryBasedCenterline() = default;
   explicit OptimizationTrajectoryBasedCenterline(rclcpp::Node & node);
   std::vector<TrajectoryPoint> generate_centerline_with_optimization(
     rclcpp::Node & node, std::shared_ptr<RouteHandler> & route_handler_ptr,
     LaneletMapBin::ConstSharedPtr & map_bin_ptr, const LaneletRoute & route);
 
+  void set_progress_callback(const ProgressCallback & progress_callback)
+  {
+    progress_callback_ = progress_callback;
+  }
+
 private:
+  // call the progress callback, and throw CenterlineGenerationCanceled if it cancels
+  void report_progress(
+    const std::vector<TrajectoryPoint> & optimized_traj_points, const double ratio) const;
+
   std::vector<TrajectoryPoint> optimize_trajectory(
     rclcpp::Node & node, const PathWithLaneId & raw_path_with_lane_id,
     std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
     const LaneletRoute & route) const;
 
+  // move the virtual ego pose along @path_with_lane_id until the optimized trajectory reaches
+  // @goal_pose, and connect the optimized trajectories. The progress is reported every iteration
+  // if @report_iterations is true.
+  std::vector<TrajectoryPoint> optimize_window(
+    rclcpp::Node & node, const PathWithLaneId & path_with_lane_id, const Pose & goal_pose,
+    const bool connect_goal, autoware::path_smoother::EBPathSmoother & eb_path_smoother,
+    autoware::path_optimizer::MPTOptimizer & mpt_optimizer,
+    std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
+    const LaneletRoute & route, const bool publish_debug, const bool report_iterations) const;
+
+  // optimize overlapping windows of @raw_path_with_lane_id in parallel and stitch them at the
+  // middle of their overlaps
+  std::vector<TrajectoryPoint> optimize_windows_in_parallel(
+    rclcpp::Node & node, const PathWithLaneId & raw_path_with_lane_id,
+    std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
+    const LaneletRoute & route) const;
+
+  // elastic band smoothers and MPT optimizers built by the first calls and reused by the later
+  // ones, since building them declares their parameters and sets up their solvers. A copy of
+  // the centerline generator builds its own, so that the copies can run concurrently.
+  struct OptimizerPool
+  {
+    OptimizerPool() = default;
+    OptimizerPool(const OptimizerPool &) {}
+    OptimizerPool & operator=(const OptimizerPool &)
+    {
+      eb_path_smoothers.clear();
+      mpt_optimizers.clear();
+      return *this;
+    }
+
+    std::vector<std::shared_ptr<autoware::path_smoother::EBPathSmoother>> eb_path_smoothers;
+    std::vector<std::shared_ptr<autoware::path_optimizer::MPTOptimizer>> mpt_optimizers;
+  };
+
+  // build the optimizers until the pool holds @optimizer_num of them
+  void prepare_optimizers(const size_t optimizer_num) const;
+
+  mutable OptimizerPool optimizer_pool_;
+  ProgressCallback progress_callback_{nullptr};
+
   // publisher
   rclcpp::Publisher<PathWithLaneId>::SharedPtr pub_raw_path_with_lane_id_{nullptr};
   rclcpp::Publisher<Path>::SharedPtr pub_raw_path_{nullptr};
@@ -73,6 +150,7 @@ private:
     const LaneletRoute & route, const Pose & current_pose) const;
 
   mutable std::shared_ptr<autoware::path_generator::PathGenerator> path_generator_node_;
+  mutable std::shared_ptr<LaneletRoute> path_generator_route_ptr_;
 };
 }  // namespace autoware::static_centerline_generator
 // clang-format off
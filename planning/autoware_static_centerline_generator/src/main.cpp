@@ -38,6 +38,8 @@ int main(int argc, char * argv[])
       node->connect_centerline_to_lanelet();
       node->validate_centerline();
       node->save_map();
+    } else if (mode == "BATCH") {
+      node->generate_centerlines_in_batch();
     } else if (mode == "GUI") {
       node->generate_centerline();
     } else if (mode == "VMB") {
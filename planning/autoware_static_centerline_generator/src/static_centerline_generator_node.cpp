@@ -32,32 +32,46 @@
 #include "utils.hpp"
 
 #include <autoware/geography_utils/lanelet2_projector.hpp>
+#include <autoware/lanelet2_map_utils/lanelet2_map_cache.hpp>
 #include <autoware/mission_planner_universe/mission_planner_plugin.hpp>
 #include <autoware/universe_utils/ros/marker_helper.hpp>
 #include <pluginlib/class_loader.hpp>
+#include <rclcpp/serialization.hpp>
 
 #include "std_msgs/msg/empty.hpp"
 #include "std_msgs/msg/float32.hpp"
 #include "std_msgs/msg/int32.hpp"
 
 #include <boost/geometry/algorithms/correct.hpp>
+#include <boost/geometry/algorithms/covered_by.hpp>
 #include <boost/geometry/algorithms/distance.hpp>
+#include <boost/geometry/algorithms/envelope.hpp>
+#include <boost/geometry/algorithms/within.hpp>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/index/rtree.hpp>
 
 #include <glog/logging.h>
 #include <lanelet2_core/LaneletMap.h>
 #include <lanelet2_core/geometry/Lanelet.h>
+#include <lanelet2_core/geometry/Polygon.h>
 #include <lanelet2_io/Io.h>
 #include <lanelet2_projection/UTM.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #define RESET_TEXT "\x1B[0m"
@@ -107,6 +121,157 @@ LinearRing2d create_vehicle_footprint(
   return footprint;
 }
 
+// Segments of a bound in an R-tree, so that the distance from a footprint is computed against
+// the segments around the footprint only
+class BoundSegmentIndex
+{
+public:
+  explicit BoundSegmentIndex(const LineString2d & bound)
+  {
+    if (bound.size() == 1) {
+      segments_.push_back(LineString2d{bound.front(), bound.front()});
+    }
+    for (size_t i = 0; i + 1 < bound.size(); ++i) {
+      segments_.push_back(LineString2d{bound.at(i), bound.at(i + 1)});
+    }
+
+    std::vector<BoxEntry> entries;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+      entries.emplace_back(boost::geometry::return_envelope<Box>(segments_.at(i)), i);
+    }
+    rtree_ = Rtree(entries.begin(), entries.end());
+  }
+
+  double distance(const LinearRing2d & footprint_poly) const
+  {
+    if (segments_.empty()) {
+      return std::numeric_limits<double>::max();
+    }
+
+    // the nearest segment by the bounding boxes bounds the distance, and the segments closer
+    // than that intersect the footprint's box expanded by it
+    const auto footprint_box = boost::geometry::return_envelope<Box>(footprint_poly);
+    std::vector<BoxEntry> candidates;
+    rtree_.query(boost::geometry::index::nearest(footprint_box, 1), std::back_inserter(candidates));
+    double min_dist =
+      boost::geometry::distance(footprint_poly, segments_.at(candidates.front().second));
+
+    auto search_box = footprint_box;
+    search_box.min_corner().x() -= min_dist;
+    search_box.min_corner().y() -= min_dist;
+    search_box.max_corner().x() += min_dist;
+    search_box.max_corner().y() += min_dist;
+
+    candidates.clear();
+    rtree_.query(boost::geometry::index::intersects(search_box), std::back_inserter(candidates));
+    for (const auto & [box, i] : candidates) {
+      min_dist = std::min(min_dist, boost::geometry::distance(footprint_poly, segments_.at(i)));
+    }
+    return min_dist;
+  }
+
+private:
+  using Box = boost::geometry::model::box<Point2d>;
+  using BoxEntry = std::pair<Box, size_t>;
+  using Rtree = boost::geometry::index::rtree<BoxEntry, boost::geometry::index::quadratic<16>>;
+
+  std::vector<LineString2d> segments_;
+  Rtree rtree_;
+};
+
+// Polygons of the route lanelets, built once, with their bounding boxes in an R-tree. A point
+// is tested against the polygon of a lanelet only if the box of the lanelet contains it.
+class RouteLaneletIndex
+{
+public:
+  explicit RouteLaneletIndex(const lanelet::ConstLanelets & route_lanelets)
+  {
+    std::vector<BoxEntry> entries;
+    for (size_t i = 0; i < route_lanelets.size(); ++i) {
+      polygons_.push_back(route_lanelets.at(i).polygon2d().basicPolygon());
+      boxes_.push_back(boost::geometry::return_envelope<Box>(polygons_.back()));
+      entries.emplace_back(boxes_.back(), i);
+    }
+    rtree_ = Rtree(entries.begin(), entries.end());
+  }
+
+  // same as lanelet::geometry::inside on the lanelet at @lanelet_idx of the route
+  bool is_inside(const size_t lanelet_idx, const lanelet::BasicPoint2d & point) const
+  {
+    return boost::geometry::covered_by(point, boxes_.at(lanelet_idx)) &&
+           boost::geometry::within(point, polygons_.at(lanelet_idx));
+  }
+
+  // the first lanelet of the route containing @point
+  std::optional<size_t> find_first(const lanelet::BasicPoint2d & point) const
+  {
+    std::vector<BoxEntry> candidates;
+    rtree_.query(boost::geometry::index::covers(point), std::back_inserter(candidates));
+
+    std::optional<size_t> first_idx;
+    for (const auto & [box, i] : candidates) {
+      if ((!first_idx || i < *first_idx) && boost::geometry::within(point, polygons_.at(i))) {
+        first_idx = i;
+      }
+    }
+    return first_idx;
+  }
+
+private:
+  using Box = boost::geometry::model::box<lanelet::BasicPoint2d>;
+  using BoxEntry = std::pair<Box, size_t>;
+  using Rtree = boost::geometry::index::rtree<BoxEntry, boost::geometry::index::quadratic<16>>;
+
+  std::vector<lanelet::BasicPolygon2d> polygons_;
+  std::vector<Box> boxes_;
+  Rtree rtree_;
+};
+
+// split @traj_points into the runs of points inside each of @route_lanelets
+std::vector<PointsWithLaneId> split_points_by_lanelet(
+  const lanelet::ConstLanelets & route_lanelets, const std::vector<TrajectoryPoint> & traj_points)
+{
+  std::vector<PointsWithLaneId> points_with_lane_ids;
+  if (traj_points.empty()) {
+    return points_with_lane_ids;
+  }
+
+  const RouteLaneletIndex route_lanelet_index(route_lanelets);
+  auto target_traj_point = traj_points.cbegin();
+  bool is_end_lanelet = false;
+  for (size_t lanelet_idx = 0; lanelet_idx < route_lanelets.size(); ++lanelet_idx) {
+    const auto & lanelet = route_lanelets.at(lanelet_idx);
+    std::vector<geometry_msgs::msg::Point> current_lanelet_points;
+
+    // check if target point is inside the lanelet
+    while (route_lanelet_index.is_inside(
+      lanelet_idx, convert_to_lanelet_point(target_traj_point->pose.position))) {
+      // memorize points inside the lanelet
+      current_lanelet_points.push_back(target_traj_point->pose.position);
+      target_traj_point++;
+
+      if (target_traj_point == traj_points.cend()) {
+        is_end_lanelet = true;
+        break;
+      }
+    }
+
+    if (!current_lanelet_points.empty()) {
+      // register points with lane_id
+      PointsWithLaneId points_with_lane_id;
+      points_with_lane_id.lane_id = lanelet.id();
+      points_with_lane_id.points = current_lanelet_points;
+      points_with_lane_ids.push_back(points_with_lane_id);
+    }
+
+    if (is_end_lanelet) {
+      break;
+    }
+  }
+
+  return points_with_lane_ids;
+}
+
 geometry_msgs::msg::Pose get_text_pose(
   const geometry_msgs::msg::Pose & pose,
   const autoware::vehicle_info_utils::VehicleInfo & vehicle_info, const double x_offset = 0.0)
@@ -153,6 +318,44 @@ std::vector<lanelet::Id> check_lanelet_connection(
   return unconnected_lane_ids;
 }
 
+// The projector info is stored in the map cache as its CDR serialization in hex
+std::string serialize_projector_info(const MapProjectorInfo & info)
+{
+  rclcpp::Serialization<MapProjectorInfo> serializer;
+  rclcpp::SerializedMessage serialized_msg;
+  serializer.serialize_message(&info, &serialized_msg);
+
+  const auto & rcl_msg = serialized_msg.get_rcl_serialized_message();
+  std::ostringstream oss;
+  oss << std::hex << std::setfill('0');
+  for (size_t i = 0; i < rcl_msg.buffer_length; ++i) {
+    oss << std::setw(2) << static_cast<unsigned int>(rcl_msg.buffer[i]);
+  }
+  return oss.str();
+}
+
+bool deserialize_projector_info(const std::string & str, MapProjectorInfo & info)
+{
+  if (str.empty() || str.size() % 2 != 0) {
+    return false;
+  }
+
+  rclcpp::SerializedMessage serialized_msg(str.size() / 2);
+  auto & rcl_msg = serialized_msg.get_rcl_serialized_message();
+  try {
+    for (size_t i = 0; i < str.size() / 2; ++i) {
+      rcl_msg.buffer[i] = static_cast<uint8_t>(std::stoul(str.substr(2 * i, 2), nullptr, 16));
+    }
+    rcl_msg.buffer_length = str.size() / 2;
+
+    rclcpp::Serialization<MapProjectorInfo> serializer;
+    serializer.deserialize_message(&serialized_msg, &info);
+  } catch (const std::exception &) {
+    return false;
+  }
+  return true;
+}
+
 std_msgs::msg::Header create_header(const rclcpp::Time & now)
 {
   std_msgs::msg::Header header;
@@ -248,6 +451,8 @@ StaticCenterlineGeneratorNode::StaticCenterlineGeneratorNode(
   sub_traj_start_index_ = create_subscription<std_msgs::msg::Int32>(
     "/static_centerline_generator/traj_start_index", rclcpp::QoS{1},
     [this](const std_msgs::msg::Int32 & msg) {
+      // the user is editing the current centerline, so the one being planned is discarded
+      cancel_plan_path_job(false);
       if (centerline_handler_.update_start_index(msg.data)) {
         visualize_selected_centerline();
       }
@@ -255,6 +460,7 @@ StaticCenterlineGeneratorNode::StaticCenterlineGeneratorNode(
   sub_traj_end_index_ = create_subscription<std_msgs::msg::Int32>(
     "/static_centerline_generator/traj_end_index", rclcpp::QoS{1},
     [this](const std_msgs::msg::Int32 & msg) {
+      cancel_plan_path_job(false);
       if (centerline_handler_.update_end_index(msg.data)) {
         visualize_selected_centerline();
       }
@@ -273,6 +479,9 @@ StaticCenterlineGeneratorNode::StaticCenterlineGeneratorNode(
       connect_centerline_to_lanelet();
       validate_centerline();
     });
+  sub_cancel_plan_path_ = create_subscription<std_msgs::msg::Empty>(
+    "/static_centerline_generator/cancel_plan_path", rclcpp::QoS{1},
+    [this]([[maybe_unused]] const std_msgs::msg::Empty & msg) { cancel_plan_path_job(false); });
 
   // services
   callback_group_ = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
@@ -294,6 +503,26 @@ StaticCenterlineGeneratorNode::StaticCenterlineGeneratorNode(
       &StaticCenterlineGeneratorNode::on_plan_path, this, std::placeholders::_1,
       std::placeholders::_2),
     rmw_qos_profile_services_default, callback_group_);
+  srv_plan_centerlines_ = create_service<PlanCenterlines>(
+    "/planning/static_centerline_generator/plan_centerlines",
+    std::bind(
+      &StaticCenterlineGeneratorNode::on_plan_centerlines, this, std::placeholders::_1,
+      std::placeholders::_2),
+    rmw_qos_profile_services_default, callback_group_);
+  srv_start_plan_path_ = create_service<StartPlanPath>(
+    "/planning/static_centerline_generator/start_plan_path",
+    std::bind(
+      &StaticCenterlineGeneratorNode::on_start_plan_path, this, std::placeholders::_1,
+      std::placeholders::_2),
+    rmw_qos_profile_services_default, callback_group_);
+  srv_get_plan_path_progress_ = create_service<GetPlanPathProgress>(
+    "/planning/static_centerline_generator/get_plan_path_progress",
+    std::bind(
+      &StaticCenterlineGeneratorNode::on_get_plan_path_progress, this, std::placeholders::_1,
+      std::placeholders::_2),
+    rmw_qos_profile_services_default, callback_group_);
+  timer_plan_path_job_ = create_wall_timer(
+    std::chrono::milliseconds(100), [this]() { apply_plan_path_job(); }, callback_group_);
 
   // vehicle info
   vehicle_info_ = autoware::vehicle_info_utils::VehicleInfoUtils(*this).getVehicleInfo();
@@ -311,6 +540,11 @@ StaticCenterlineGeneratorNode::StaticCenterlineGeneratorNode(
   }();
 }
 
+StaticCenterlineGeneratorNode::~StaticCenterlineGeneratorNode()
+{
+  cancel_plan_path_job();
+}
+
 void StaticCenterlineGeneratorNode::visualize_selected_centerline()
 {
   // publish selected centerline
@@ -343,6 +577,169 @@ void StaticCenterlineGeneratorNode::generate_centerline()
   visualize_selected_centerline();
 }
 
+void StaticCenterlineGeneratorNode::generate_centerlines_in_batch()
+{
+  // declare planning setting parameters
+  const auto lanelet2_input_file_path = declare_parameter<std::string>("lanelet2_input_file_path");
+  if (lanelet2_input_file_path == "") {
+    throw std::invalid_argument("The `lanelet2_input_file_path` is empty.");
+  }
+  const auto start_lanelet_ids = declare_parameter<std::vector<int64_t>>("start_lanelet_ids");
+  const auto end_lanelet_ids = declare_parameter<std::vector<int64_t>>("end_lanelet_ids");
+  if (start_lanelet_ids.size() != end_lanelet_ids.size()) {
+    throw std::invalid_argument(
+      "The sizes of `start_lanelet_ids` and `end_lanelet_ids` are not the same.");
+  }
+
+  // process
+  load_map(lanelet2_input_file_path);
+  const auto failed_route_indices = generate_and_save_centerlines(
+    std::vector<lanelet::Id>(start_lanelet_ids.begin(), start_lanelet_ids.end()),
+    std::vector<lanelet::Id>(end_lanelet_ids.begin(), end_lanelet_ids.end()));
+
+  for (const auto route_idx : failed_route_indices) {
+    RCLCPP_ERROR(
+      get_logger(), "Failed to generate the centerline from lanelet %ld to %ld.",
+      start_lanelet_ids.at(route_idx), end_lanelet_ids.at(route_idx));
+  }
+
+  visualize_selected_centerline();
+}
+
+std::vector<size_t> StaticCenterlineGeneratorNode::generate_and_save_centerlines(
+  const std::vector<lanelet::Id> & start_lanelet_ids,
+  const std::vector<lanelet::Id> & end_lanelet_ids)
+{
+  const size_t route_num = std::min(start_lanelet_ids.size(), end_lanelet_ids.size());
+  std::vector<size_t> failed_route_indices;
+
+  if (!route_handler_ptr_ || centerline_source_ != CenterlineSource::OptimizationTrajectoryBase) {
+    RCLCPP_ERROR(
+      get_logger(), "Route handler is not ready or the centerline source is not optimization.");
+    for (size_t i = 0; i < route_num; ++i) {
+      failed_route_indices.push_back(i);
+    }
+    return failed_route_indices;
+  }
+
+  // plan routes sequentially since the mission planner is created as a node every time
+  std::vector<LaneletRoute> routes(route_num);
+  for (size_t i = 0; i < route_num; ++i) {
+    try {
+      routes.at(i) = plan_route(
+        utils::get_center_pose(*route_handler_ptr_, start_lanelet_ids.at(i)),
+        utils::get_center_pose(*route_handler_ptr_, end_lanelet_ids.at(i)));
+    } catch (const std::exception & e) {
+      RCLCPP_ERROR(get_logger(), "Route planning failed: %s", e.what());
+    }
+  }
+
+  // NOTE: Every worker optimizes its routes with its own copy of a centerline generator, which
+  //       keeps its optimizers between the routes, and every route with its own copy of the route
+  //       handler. They share the publishers and the map. The first route is optimized before
+  //       the other ones so that the parameters are declared before they are read concurrently.
+  const OptimizationTrajectoryBasedCenterline prototype_centerline(*this);
+  std::vector<std::vector<TrajectoryPoint>> centerlines(route_num);
+  const auto optimize = [&](OptimizationTrajectoryBasedCenterline & centerline, const size_t i) {
+    if (routes.at(i).segments.empty()) {
+      return;
+    }
+    auto route_handler_ptr = std::make_shared<RouteHandler>(*route_handler_ptr_);
+    auto map_bin_ptr = map_bin_ptr_;
+    try {
+      centerlines.at(i) = centerline.generate_centerline_with_optimization(
+        *this, route_handler_ptr, map_bin_ptr, routes.at(i));
+    } catch (const std::exception & e) {
+      RCLCPP_ERROR(get_logger(), "Path planning failed: %s", e.what());
+    }
+  };
+
+  auto main_centerline = prototype_centerline;
+  if (0 < route_num) {
+    optimize(main_centerline, 0);
+  }
+
+  const size_t rest_route_num = 1 < route_num ? route_num - 1 : 0;
+  const size_t thread_num = std::max<size_t>(
+    std::min<size_t>(getRosParameter<int>("batch.thread_num"), rest_route_num), 1);
+  std::atomic<size_t> next_route(1);
+  std::vector<std::thread> threads;
+
+  auto worker = [&](OptimizationTrajectoryBasedCenterline & centerline) {
+    for (size_t i = next_route++; i < route_num; i = next_route++) {
+      optimize(centerline, i);
+    }
+  };
+  for (size_t t = 1; t < thread_num; t++) {
+    threads.emplace_back([&]() {
+      auto centerline = prototype_centerline;
+      worker(centerline);
+    });
+  }
+  worker(main_centerline);
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  // embed all the centerlines in the map, where a later route overwrites the lanelets it shares
+  // with an earlier one
+  const double output_trajectory_interval = getRosParameter<double>("output_trajectory_interval");
+  for (size_t i = 0; i < route_num; ++i) {
+    if (centerlines.at(i).empty()) {
+      failed_route_indices.push_back(i);
+      continue;
+    }
+
+    centerline_handler_ = CenterlineHandler(CenterlineWithRoute{
+      resample_trajectory_points(centerlines.at(i), output_trajectory_interval), routes.at(i)});
+    connect_centerline_to_lanelet();
+    utils::update_centerline(
+      original_map_ptr_, centerline_handler_.get_selected_centerline(),
+      centerline_handler_.get_centerline_lane_ids(), embedded_centerlines_);
+  }
+  RCLCPP_INFO(
+    get_logger(), "Updated the centerlines of %lu routes in map.",
+    route_num - failed_route_indices.size());
+
+  if (failed_route_indices.size() < route_num) {
+    write_map();
+  }
+
+  return failed_route_indices;
+}
+
+void StaticCenterlineGeneratorNode::on_plan_centerlines(
+  const PlanCenterlines::Request::SharedPtr request,
+  const PlanCenterlines::Response::SharedPtr response)
+{
+  if (!route_handler_ptr_) {
+    response->message = "MapNotFound";
+    RCLCPP_ERROR(get_logger(), "Route handler is not ready.");
+    return;
+  }
+
+  if (request->start_lane_ids.size() != request->end_lane_ids.size()) {
+    response->message = "InvalidRoutes";
+    RCLCPP_ERROR(get_logger(), "The sizes of the start and end lane ids are not the same.");
+    return;
+  }
+
+  const auto failed_route_indices = generate_and_save_centerlines(
+    std::vector<lanelet::Id>(request->start_lane_ids.begin(), request->start_lane_ids.end()),
+    std::vector<lanelet::Id>(request->end_lane_ids.begin(), request->end_lane_ids.end()));
+  visualize_selected_centerline();
+
+  response->failed_route_indices =
+    std::vector<int64_t>(failed_route_indices.begin(), failed_route_indices.end());
+  if (failed_route_indices.size() == request->start_lane_ids.size()) {
+    response->message = "PathNotFound";
+    return;
+  }
+
+  // empty string if error did not occur for any route
+  response->message = "";
+}
+
 CenterlineWithRoute StaticCenterlineGeneratorNode::generate_whole_centerline_with_route()
 {
   if (!route_handler_ptr_) {
@@ -392,19 +789,40 @@ void StaticCenterlineGeneratorNode::load_map(const std::string & lanelet2_input_
 
   // load map by the map_loader package
   map_bin_ptr_ = [&]() -> LaneletMapBin::ConstSharedPtr {
-    // load map
-    map_projector_info_ = std::make_unique<MapProjectorInfo>(
-      autoware::map_projection_loader::load_info_from_lanelet2_map(lanelet2_input_file_path));
-    const auto map_ptr = autoware::map_loader::Lanelet2MapLoaderNode::load_map(
-      lanelet2_input_file_path, *map_projector_info_);
-    if (!map_ptr) {
-      return nullptr;
-    }
+    // NOTE: The projector info is derived from the map file itself, so the cache of the map
+    //       keeps the projector info too and a cache hit skips parsing the XML altogether.
+    const autoware::lanelet2_map_utils::Lanelet2MapCache map_cache(
+      lanelet2_input_file_path, "map_projection_loader");
+    std::string cached_projector_info;
+    auto map_ptr = map_cache.load(cached_projector_info);
+    MapProjectorInfo projector_info;
+
+    if (map_ptr && deserialize_projector_info(cached_projector_info, projector_info)) {
+      RCLCPP_INFO(get_logger(), "Loaded map from %s", map_cache.path().c_str());
+      map_projector_info_ = std::make_unique<MapProjectorInfo>(projector_info);
+
+      // NOTE: The original map is stored here since the centerline will be added to all the
+      //       lanelet when lanelet::utils::overwriteLaneletCenterline is called.
+      original_map_ptr_ = map_cache.load(cached_projector_info);
+    } else {
+      // load map
+      map_projector_info_ = std::make_unique<MapProjectorInfo>(
+        autoware::map_projection_loader::load_info_from_lanelet2_map(lanelet2_input_file_path));
+      map_ptr = autoware::map_loader::Lanelet2MapLoaderNode::load_map(
+        lanelet2_input_file_path, *map_projector_info_);
+      if (!map_ptr) {
+        return nullptr;
+      }
+
+      // NOTE: The original map is stored here since the centerline will be added to all the
+      //       lanelet when lanelet::utils::overwriteLaneletCenterline is called.
+      original_map_ptr_ = autoware::map_loader::Lanelet2MapLoaderNode::load_map(
+        lanelet2_input_file_path, *map_projector_info_);
 
-    // NOTE: The original map is stored here since the centerline will be added to all the
-    //       lanelet when lanelet::utils::overwriteLaneletCenterline is called.
-    original_map_ptr_ = autoware::map_loader::Lanelet2MapLoaderNode::load_map(
-      lanelet2_input_file_path, *map_projector_info_);
+      if (!map_cache.store(*original_map_ptr_, serialize_projector_info(*map_projector_info_))) {
+        RCLCPP_WARN(get_logger(), "Failed to write the map cache %s", map_cache.path().c_str());
+      }
+    }
 
     // overwrite more dense centerline
     // NOTE: overwriteLaneletsCenterlineWithWaypoints is used only in real time calculation.
@@ -417,6 +835,10 @@ void StaticCenterlineGeneratorNode::load_map(const std::string & lanelet2_input_
     return std::make_shared<LaneletMapBin>(map_bin_msg);
   }();
 
+  // the centerlines embedded in the previous map are dropped with it
+  embedded_centerlines_.clear();
+  is_map_written_ = false;
+
   // check if map_bin_ptr_ is not null pointer
   if (!map_bin_ptr_) {
     RCLCPP_ERROR(get_logger(), "Loading map failed");
@@ -436,6 +858,9 @@ void StaticCenterlineGeneratorNode::load_map(const std::string & lanelet2_input_
 void StaticCenterlineGeneratorNode::on_load_map(
   const LoadMap::Request::SharedPtr request, const LoadMap::Response::SharedPtr response)
 {
+  // the running job plans on the previous map
+  cancel_plan_path_job();
+
   const std::string tmp_lanelet2_input_file_path = "/tmp/input_lanelet2_map.osm";
 
   // save map file temporarily since load map's input must be a file
@@ -555,24 +980,23 @@ void StaticCenterlineGeneratorNode::on_plan_route(
   response->lane_ids = lane_ids;
 }
 
-void StaticCenterlineGeneratorNode::on_plan_path(
-  const PlanPath::Request::SharedPtr request, const PlanPath::Response::SharedPtr response)
+std::optional<LaneletRoute> StaticCenterlineGeneratorNode::create_route_from_lane_ids(
+  const std::vector<int64_t> & route_lane_ids, std::string & message,
+  std::vector<int64_t> & unconnected_lane_ids)
 {
   if (!route_handler_ptr_) {
-    response->message = "MapNotFound";
+    message = "MapNotFound";
     RCLCPP_ERROR(get_logger(), "Route handler is not ready.");
-    return;
+    return std::nullopt;
   }
 
   // get lanelets from route lane ids
-  const auto route_lane_ids = request->route;
   const auto route_lanelets = utils::get_lanelets_from_ids(*route_handler_ptr_, route_lane_ids);
 
   // create route
   LaneletRoute route;
   route.start_pose = utils::get_center_pose(*route_handler_ptr_, route_lane_ids.front());
   route.goal_pose = utils::get_center_pose(*route_handler_ptr_, route_lane_ids.back());
-  std::vector<lanelet::Id> lane_ids;
   for (const auto route_lane_id : route_lane_ids) {
     LaneletSegment segment;
     segment.preferred_primitive.id = route_lane_id;
@@ -580,18 +1004,34 @@ void StaticCenterlineGeneratorNode::on_plan_path(
   }
 
   // check if input route lanelets are connected to each other.
-  const auto unconnected_lane_ids = check_lanelet_connection(*route_handler_ptr_, route_lanelets);
-  if (!unconnected_lane_ids.empty()) {
-    response->message = "LaneletsNotConnected";
-    response->unconnected_lane_ids = unconnected_lane_ids;
+  const auto check_result = check_lanelet_connection(*route_handler_ptr_, route_lanelets);
+  if (!check_result.empty()) {
+    message = "LaneletsNotConnected";
+    unconnected_lane_ids.assign(check_result.begin(), check_result.end());
     RCLCPP_ERROR(get_logger(), "Lanelets are not connected.");
+    return std::nullopt;
+  }
+
+  return route;
+}
+
+void StaticCenterlineGeneratorNode::on_plan_path(
+  const PlanPath::Request::SharedPtr request, const PlanPath::Response::SharedPtr response)
+{
+  // the asynchronous job uses the same optimizers, so it is canceled first
+  cancel_plan_path_job();
+
+  const auto route = create_route_from_lane_ids(
+    request->route, response->message, response->unconnected_lane_ids);
+  if (!route) {
     return;
   }
+  const auto route_lanelets = utils::get_lanelets_from_ids(*route_handler_ptr_, request->route);
 
   // plan path
   const auto optimized_traj_points =
     optimization_trajectory_based_centerline_.generate_centerline_with_optimization(
-      *this, route_handler_ptr_, map_bin_ptr_, route);
+      *this, route_handler_ptr_, map_bin_ptr_, *route);
 
   // check calculation result
   if (optimized_traj_points.empty()) {
@@ -600,46 +1040,148 @@ void StaticCenterlineGeneratorNode::on_plan_path(
     return;
   }
 
-  centerline_handler_ = CenterlineHandler(CenterlineWithRoute{optimized_traj_points, route});
+  centerline_handler_ = CenterlineHandler(CenterlineWithRoute{optimized_traj_points, *route});
 
   // publish unsafe_footprints
   connect_centerline_to_lanelet();
   validate_centerline();
 
   // create output data
-  auto target_traj_point = optimized_traj_points.cbegin();
-  bool is_end_lanelet = false;
-  for (const auto & lanelet : route_lanelets) {
-    std::vector<geometry_msgs::msg::Point> current_lanelet_points;
+  response->points_with_lane_ids = split_points_by_lanelet(route_lanelets, optimized_traj_points);
 
-    // check if target point is inside the lanelet
-    while (lanelet::geometry::inside(
-      lanelet, convert_to_lanelet_point(target_traj_point->pose.position))) {
-      // memorize points inside the lanelet
-      current_lanelet_points.push_back(target_traj_point->pose.position);
-      target_traj_point++;
+  // empty string if error did not occur
+  response->message = "";
+}
 
-      if (target_traj_point == optimized_traj_points.cend()) {
-        is_end_lanelet = true;
-        break;
+void StaticCenterlineGeneratorNode::on_start_plan_path(
+  const StartPlanPath::Request::SharedPtr request,
+  const StartPlanPath::Response::SharedPtr response)
+{
+  // NOTE: only one job runs at a time, since the jobs reuse the same optimizers
+  cancel_plan_path_job();
+
+  const auto route = create_route_from_lane_ids(
+    request->route, response->message, response->unconnected_lane_ids);
+  if (!route) {
+    return;
+  }
+
+  auto job = std::make_shared<PlanPathJob>();
+  job->id = ++plan_path_job_num_;
+  job->route = *route;
+  job->route_lanelets = utils::get_lanelets_from_ids(*route_handler_ptr_, request->route);
+
+  // the worker plans on its own copy of the route handler, since the route is set to it
+  auto route_handler_ptr = std::make_shared<RouteHandler>(*route_handler_ptr_);
+  auto map_bin_ptr = map_bin_ptr_;
+  optimization_trajectory_based_centerline_.set_progress_callback(
+    [job](const std::vector<TrajectoryPoint> & optimized_traj_points, const double ratio) {
+      std::lock_guard<std::mutex> lock(job->mutex);
+      job->progress = ratio;
+      if (!optimized_traj_points.empty()) {
+        job->optimized_traj_points = optimized_traj_points;
       }
+      return !job->is_canceled;
+    });
+  job->worker = std::thread([this, job, route_handler_ptr, map_bin_ptr]() mutable {
+    std::string state = "Failed";
+    std::string message;
+    std::vector<TrajectoryPoint> optimized_traj_points;
+    try {
+      optimized_traj_points =
+        optimization_trajectory_based_centerline_.generate_centerline_with_optimization(
+          *this, route_handler_ptr, map_bin_ptr, job->route);
+      if (optimized_traj_points.empty()) {
+        message = "PathNotFound";
+        RCLCPP_ERROR(get_logger(), "Path planning failed.");
+      } else {
+        state = "Succeeded";
+      }
+    } catch (const CenterlineGenerationCanceled &) {
+      state = "Canceled";
+      RCLCPP_INFO(get_logger(), "Path planning %u was canceled.", job->id);
+    } catch (const std::exception & e) {
+      message = "InternalServerError";
+      RCLCPP_ERROR(get_logger(), "Path planning failed: %s", e.what());
     }
 
-    if (!current_lanelet_points.empty()) {
-      // register points with lane_id
-      autoware_static_centerline_generator::msg::PointsWithLaneId points_with_lane_id;
-      points_with_lane_id.lane_id = lanelet.id();
-      points_with_lane_id.points = current_lanelet_points;
-      response->points_with_lane_ids.push_back(points_with_lane_id);
+    std::lock_guard<std::mutex> lock(job->mutex);
+    job->state = state;
+    job->message = message;
+    if (state == "Succeeded") {
+      job->progress = 1.0;
+      job->optimized_traj_points = optimized_traj_points;
     }
+  });
+  plan_path_job_ = job;
 
-    if (is_end_lanelet) {
-      break;
+  response->job_id = job->id;
+  response->message = "";
+}
+
+void StaticCenterlineGeneratorNode::on_get_plan_path_progress(
+  const GetPlanPathProgress::Request::SharedPtr request,
+  const GetPlanPathProgress::Response::SharedPtr response)
+{
+  if (!plan_path_job_ || plan_path_job_->id != request->job_id) {
+    response->message = "JobNotFound";
+    return;
+  }
+
+  std::vector<TrajectoryPoint> optimized_traj_points;
+  {
+    std::lock_guard<std::mutex> lock(plan_path_job_->mutex);
+    response->state = plan_path_job_->state;
+    response->progress = plan_path_job_->progress;
+    response->message = plan_path_job_->message;
+    optimized_traj_points = plan_path_job_->optimized_traj_points;
+  }
+
+  // the job may be canceled after it succeeded, before its centerline is selected
+  if (response->state == "Succeeded" && !plan_path_job_->is_applied) {
+    response->state = plan_path_job_->is_canceled ? "Canceled" : "Running";
+  }
+
+  // the partial centerline while running, and the whole one once succeeded
+  response->points_with_lane_ids =
+    split_points_by_lanelet(plan_path_job_->route_lanelets, optimized_traj_points);
+}
+
+void StaticCenterlineGeneratorNode::cancel_plan_path_job(const bool wait)
+{
+  if (!plan_path_job_) {
+    return;
+  }
+
+  plan_path_job_->is_canceled = true;
+  if (wait && plan_path_job_->worker.joinable()) {
+    plan_path_job_->worker.join();
+  }
+  optimization_trajectory_based_centerline_.set_progress_callback(nullptr);
+}
+
+void StaticCenterlineGeneratorNode::apply_plan_path_job()
+{
+  if (!plan_path_job_ || plan_path_job_->is_applied || plan_path_job_->is_canceled) {
+    return;
+  }
+
+  std::vector<TrajectoryPoint> optimized_traj_points;
+  {
+    std::lock_guard<std::mutex> lock(plan_path_job_->mutex);
+    if (plan_path_job_->state != "Succeeded") {
+      return;
     }
+    optimized_traj_points = plan_path_job_->optimized_traj_points;
   }
+  plan_path_job_->is_applied = true;
 
-  // empty string if error did not occur
-  response->message = "";
+  centerline_handler_ =
+    CenterlineHandler(CenterlineWithRoute{optimized_traj_points, plan_path_job_->route});
+
+  // publish unsafe_footprints
+  connect_centerline_to_lanelet();
+  validate_centerline();
 }
 
 void StaticCenterlineGeneratorNode::connect_centerline_to_lanelet()
@@ -653,17 +1195,11 @@ void StaticCenterlineGeneratorNode::connect_centerline_to_lanelet()
   const auto route = centerline_handler_.get_route();
   const auto route_lanelets = utils::get_lanelets_from_route(*route_handler_ptr_, route);
 
+  const RouteLaneletIndex route_lanelet_index(route_lanelets);
+
   // 1. calculate the lanelet of the centerline's front.
-  std::optional<size_t> centerline_front_lanelet_idx{std::nullopt};
-  for (size_t i = 0; i < route_lanelets.size(); ++i) {
-    const auto & lanelet = route_lanelets.at(i);
-    const bool is_inside =
-      lanelet::geometry::inside(lanelet, convert_to_lanelet_point(centerline.at(0).pose.position));
-    if (is_inside) {
-      centerline_front_lanelet_idx = i;
-      break;
-    }
-  }
+  const std::optional<size_t> centerline_front_lanelet_idx =
+    route_lanelet_index.find_first(convert_to_lanelet_point(centerline.at(0).pose.position));
 
   // 2. update centerline_lane_ids in centerline_handler_
   size_t centerline_idx = 0;
@@ -675,8 +1211,8 @@ void StaticCenterlineGeneratorNode::connect_centerline_to_lanelet()
 
     while (true) {
       // check if target point is inside the lanelet
-      const bool is_inside = lanelet::geometry::inside(
-        lanelet, convert_to_lanelet_point(centerline.at(centerline_idx).pose.position));
+      const bool is_inside = route_lanelet_index.is_inside(
+        lanelet_idx, convert_to_lanelet_point(centerline.at(centerline_idx).pose.position));
       if (is_inside) {
         was_once_inside_lanelet = true;
       }
@@ -742,6 +1278,8 @@ void StaticCenterlineGeneratorNode::validate_centerline()
   // create right/left bound for each lanelet
   std::unordered_map<lanelet::Id, LineString2d> lanelet_right_bound_map;
   std::unordered_map<lanelet::Id, LineString2d> lanelet_left_bound_map;
+  std::unordered_map<lanelet::Id, BoundSegmentIndex> lanelet_right_bound_index_map;
+  std::unordered_map<lanelet::Id, BoundSegmentIndex> lanelet_left_bound_index_map;
   std::vector<lanelet::Id> centerline_lane_id_map_order;
   for (size_t centerline_idx = 0; centerline_idx < centerline_lane_ids.size(); ++centerline_idx) {
     const lanelet::Id centerline_lane_id = centerline_lane_ids.at(centerline_idx);
@@ -762,27 +1300,59 @@ void StaticCenterlineGeneratorNode::validate_centerline()
       boost::geometry::append(
         lanelet_left_bound_map.at(centerline_lane_id), Point2d(point.x(), point.y()));
     }
+    lanelet_right_bound_index_map.emplace(
+      centerline_lane_id, BoundSegmentIndex(lanelet_right_bound_map.at(centerline_lane_id)));
+    lanelet_left_bound_index_map.emplace(
+      centerline_lane_id, BoundSegmentIndex(lanelet_left_bound_map.at(centerline_lane_id)));
   }
 
   // calculate curvature
   const auto curvature_vec = autoware::motion_utils::calcCurvature(centerline);
   const double steer_angle_threshold = vehicle_info_.max_steer_angle_rad - max_steer_angle_margin;
 
-  // calculate the distance between footprint and right/left bounds
+  // calculate the distance between footprint and right/left bounds in parallel
+  std::vector<LinearRing2d> footprint_polys(centerline.size());
+  std::vector<double> min_dist_to_bounds(centerline.size());
+  {
+    const size_t thread_num = std::max<size_t>(
+      std::min<size_t>(std::thread::hardware_concurrency(), centerline.size()), 1);
+    std::atomic<size_t> next_point(0);
+    std::vector<std::thread> threads;
+
+    auto worker = [&]() {
+      for (size_t i = next_point++; i < centerline.size(); i = next_point++) {
+        const lanelet::Id centerline_lane_id = centerline_lane_ids.at(i);
+
+        footprint_polys.at(i) = create_vehicle_footprint(centerline.at(i).pose, vehicle_info_);
+
+        const double dist_to_right =
+          lanelet_right_bound_index_map.at(centerline_lane_id).distance(footprint_polys.at(i));
+        const double dist_to_left =
+          lanelet_left_bound_index_map.at(centerline_lane_id).distance(footprint_polys.at(i));
+        min_dist_to_bounds.at(i) = std::min(dist_to_right, dist_to_left);
+      }
+    };
+    for (size_t t = 1; t < thread_num; t++) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto & thread : threads) {
+      thread.join();
+    }
+  }
+
+  // create markers of the footprints close to the bounds and of the curvature, which is shown
+  // every curvature_marker_interval points or where the steer angle is too high
+  const size_t curvature_marker_interval =
+    std::max(getRosParameter<int>("validation.curvature_marker_interval"), 1);
+  const auto stamp = now();
   MarkerArray marker_array;
   double min_dist = std::numeric_limits<double>::max();
   double max_curvature = std::numeric_limits<double>::min();
   for (size_t i = 0; i < centerline.size(); ++i) {
     const auto & traj_point = centerline.at(i);
-    const lanelet::Id centerline_lane_id = centerline_lane_ids.at(i);
-
-    const auto footprint_poly = create_vehicle_footprint(traj_point.pose, vehicle_info_);
-
-    const double dist_to_right =
-      boost::geometry::distance(footprint_poly, lanelet_right_bound_map.at(centerline_lane_id));
-    const double dist_to_left =
-      boost::geometry::distance(footprint_poly, lanelet_left_bound_map.at(centerline_lane_id));
-    const double min_dist_to_bound = std::min(dist_to_right, dist_to_left);
+    const auto & footprint_poly = footprint_polys.at(i);
+    const double min_dist_to_bound = min_dist_to_bounds.at(i);
 
     if (min_dist_to_bound < min_dist) {
       min_dist = min_dist_to_bound;
@@ -790,28 +1360,32 @@ void StaticCenterlineGeneratorNode::validate_centerline()
 
     // create marker
     const auto marker_color_opt = get_marker_color(min_dist_to_bound);
-    const auto text_pose = get_text_pose(traj_point.pose, vehicle_info_);
     if (marker_color_opt) {
       const auto & marker_color = marker_color_opt.get();
+      const auto text_pose = get_text_pose(traj_point.pose, vehicle_info_);
 
       // add footprint marker
       const auto footprint_marker = utils::create_footprint_marker(
         "unsafe_footprints", footprint_poly, 0.05, marker_color.at(0), marker_color.at(1),
-        marker_color.at(2), 0.7, now(), i);
+        marker_color.at(2), 0.7, stamp, i);
       marker_array.markers.push_back(footprint_marker);
 
       // add text of distance to bounds marker
       const auto text_marker = utils::create_text_marker(
         "unsafe_footprints_distance", text_pose, min_dist_to_bound, marker_color.at(0),
-        marker_color.at(1), marker_color.at(2), 0.999, now(), i);
+        marker_color.at(1), marker_color.at(2), 0.999, stamp, i);
       marker_array.markers.push_back(text_marker);
     }
 
     const double curvature = curvature_vec.at(i);
-    const auto curvature_text_pose = get_text_pose(traj_point.pose, vehicle_info_, -0.4);
-    const auto text_marker = utils::create_text_marker(
-      "curvature", curvature_text_pose, curvature, 1.0, 1.0, 1.0, 0.8, now(), i);
-    marker_array.markers.push_back(text_marker);
+    if (
+      i % curvature_marker_interval == 0 ||
+      steer_angle_threshold <= vehicle_info_.calcSteerAngleFromCurvature(std::abs(curvature))) {
+      const auto curvature_text_pose = get_text_pose(traj_point.pose, vehicle_info_, -0.4);
+      const auto text_marker = utils::create_text_marker(
+        "curvature", curvature_text_pose, curvature, 1.0, 1.0, 1.0, 0.8, stamp, i);
+      marker_array.markers.push_back(text_marker);
+    }
 
     if (max_curvature < std::abs(curvature)) {
       max_curvature = std::abs(curvature);
@@ -910,11 +1484,25 @@ void StaticCenterlineGeneratorNode::save_map()
   const auto centerline = centerline_handler_.get_selected_centerline();
   const auto centerline_lane_ids = centerline_handler_.get_centerline_lane_ids();
 
-  const auto lanelet2_output_file_path = getRosParameter<std::string>("lanelet2_output_file_path");
-
   // update centerline in map
-  utils::update_centerline(original_map_ptr_, centerline, centerline_lane_ids);
-  RCLCPP_INFO(get_logger(), "Updated centerline in map.");
+  const auto updated_lane_ids = utils::update_centerline(
+    original_map_ptr_, centerline, centerline_lane_ids, embedded_centerlines_);
+  RCLCPP_INFO(get_logger(), "Updated centerline of %lu lanelets in map.", updated_lane_ids.size());
+
+  // NOTE: The whole map is written since lanelet2_io has no partial writer, but only when some
+  //       centerline changed since the last save.
+  if (updated_lane_ids.empty() && is_map_written_) {
+    RCLCPP_INFO(get_logger(), "Skipped saving map since no centerline changed.");
+    pub_map_saved_->publish(std_msgs::msg::Empty{});
+    return;
+  }
+
+  write_map();
+}
+
+void StaticCenterlineGeneratorNode::write_map()
+{
+  const auto lanelet2_output_file_path = getRosParameter<std::string>("lanelet2_output_file_path");
 
   // save map with modified center line
   std::filesystem::create_directory("/tmp/autoware_static_centerline_generator");
@@ -931,6 +1519,8 @@ void StaticCenterlineGeneratorNode::save_map()
     lanelet2_output_file_path, debug_output_file_dir + "lanelet2_map.osm",
     std::filesystem::copy_options::overwrite_existing);
 
+  is_map_written_ = true;
+
   std_msgs::msg::Empty empty_msg;
   pub_map_saved_->publish(empty_msg);
 }
@@ -16,30 +16,43 @@
 #define STATIC_CENTERLINE_GENERATOR_NODE_HPP_
 
 #include "autoware/universe_utils/ros/parameter.hpp"
+#include "autoware_static_centerline_generator/msg/points_with_lane_id.hpp"
+#include "autoware_static_centerline_generator/srv/get_plan_path_progress.hpp"
 #include "autoware_static_centerline_generator/srv/load_map.hpp"
+#include "autoware_static_centerline_generator/srv/plan_centerlines.hpp"
 #include "autoware_static_centerline_generator/srv/plan_path.hpp"
 #include "autoware_static_centerline_generator/srv/plan_route.hpp"
+#include "autoware_static_centerline_generator/srv/start_plan_path.hpp"
 #include "autoware_vehicle_info_utils/vehicle_info_utils.hpp"
 #include "centerline_source/optimization_trajectory_based_centerline.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "type_alias.hpp"
+#include "utils.hpp"
 
 #include "autoware_map_msgs/msg/map_projector_info.hpp"
 #include "std_msgs/msg/empty.hpp"
 #include "std_msgs/msg/float32.hpp"
 #include "std_msgs/msg/int32.hpp"
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 namespace autoware::static_centerline_generator
 {
 using autoware_map_msgs::msg::MapProjectorInfo;
+using autoware_static_centerline_generator::msg::PointsWithLaneId;
+using autoware_static_centerline_generator::srv::GetPlanPathProgress;
 using autoware_static_centerline_generator::srv::LoadMap;
+using autoware_static_centerline_generator::srv::PlanCenterlines;
 using autoware_static_centerline_generator::srv::PlanPath;
 using autoware_static_centerline_generator::srv::PlanRoute;
+using autoware_static_centerline_generator::srv::StartPlanPath;
 
 struct CenterlineWithRoute
 {
@@ -98,6 +111,26 @@ struct CenterlineHandler
   std::vector<lanelet::Id> centerline_lane_ids;
 };
 
+// centerline generation started by the StartPlanPath service, which runs on a worker thread
+struct PlanPathJob
+{
+  uint32_t id{};
+  LaneletRoute route{};
+  lanelet::ConstLanelets route_lanelets{};
+  std::atomic<bool> is_canceled{false};
+  std::thread worker;
+
+  // written by the worker and read by the services
+  std::mutex mutex;
+  std::string state{"Running"};
+  double progress{0.0};
+  std::vector<TrajectoryPoint> optimized_traj_points{};
+  std::string message{};
+
+  // true once the centerline of the succeeded job is selected
+  bool is_applied{false};
+};
+
 struct RoadBounds
 {
   std::vector<geometry_msgs::msg::Point> left_bound;
@@ -108,7 +141,9 @@ class StaticCenterlineGeneratorNode : public rclcpp::Node
 {
 public:
   explicit StaticCenterlineGeneratorNode(const rclcpp::NodeOptions & node_options);
+  ~StaticCenterlineGeneratorNode() override;
   void generate_centerline();
+  void generate_centerlines_in_batch();
   void connect_centerline_to_lanelet();
   void validate_centerline();
   void save_map();
@@ -133,10 +168,36 @@ private:
   CenterlineWithRoute generate_whole_centerline_with_route();
   std::vector<lanelet::Id> get_route_lane_ids_from_points(
     const std::vector<TrajectoryPoint> & points);
+  // route along the lane ids of a PlanPath or StartPlanPath request, or nullopt with @message
+  // and @unconnected_lane_ids set if the lanelets cannot be planned
+  std::optional<LaneletRoute> create_route_from_lane_ids(
+    const std::vector<int64_t> & route_lane_ids, std::string & message,
+    std::vector<int64_t> & unconnected_lane_ids);
   void on_plan_path(
     const PlanPath::Request::SharedPtr request, const PlanPath::Response::SharedPtr response);
 
+  // plan centerline asynchronously, so that the services stay responsive while optimizing
+  void on_start_plan_path(
+    const StartPlanPath::Request::SharedPtr request,
+    const StartPlanPath::Response::SharedPtr response);
+  void on_get_plan_path_progress(
+    const GetPlanPathProgress::Request::SharedPtr request,
+    const GetPlanPathProgress::Response::SharedPtr response);
+  // cancel the running job, if any, and wait for its worker if @wait is true
+  void cancel_plan_path_job(const bool wait = true);
+  // select the centerline of the job once it succeeded
+  void apply_plan_path_job();
+
+  // plan the centerlines of many routes over the loaded map in parallel, and save them in one map
+  std::vector<size_t> generate_and_save_centerlines(
+    const std::vector<lanelet::Id> & start_lanelet_ids,
+    const std::vector<lanelet::Id> & end_lanelet_ids);
+  void on_plan_centerlines(
+    const PlanCenterlines::Request::SharedPtr request,
+    const PlanCenterlines::Response::SharedPtr response);
+
   void visualize_selected_centerline();
+  void write_map();
 
   // parameter
   template <typename T>
@@ -146,12 +207,17 @@ private:
   }
 
   lanelet::LaneletMapPtr original_map_ptr_{nullptr};
+  utils::EmbeddedCenterlines embedded_centerlines_;
+  bool is_map_written_{false};
   LaneletMapBin::ConstSharedPtr map_bin_ptr_{nullptr};
   std::shared_ptr<RouteHandler> route_handler_ptr_{nullptr};
   std::unique_ptr<MapProjectorInfo> map_projector_info_{nullptr};
 
   CenterlineHandler centerline_handler_;
 
+  std::shared_ptr<PlanPathJob> plan_path_job_{nullptr};
+  uint32_t plan_path_job_num_{0};
+
   float footprint_margin_for_road_bound_{0.0};
 
   enum class CenterlineSource {
@@ -176,11 +242,18 @@ private:
   rclcpp::Subscription<std_msgs::msg::Empty>::SharedPtr sub_save_map_;
   rclcpp::Subscription<std_msgs::msg::Empty>::SharedPtr sub_validate_;
   rclcpp::Subscription<std_msgs::msg::Float32>::SharedPtr sub_footprint_margin_for_road_bound_;
+  rclcpp::Subscription<std_msgs::msg::Empty>::SharedPtr sub_cancel_plan_path_;
 
   // service
   rclcpp::Service<LoadMap>::SharedPtr srv_load_map_;
   rclcpp::Service<PlanRoute>::SharedPtr srv_plan_route_;
   rclcpp::Service<PlanPath>::SharedPtr srv_plan_path_;
+  rclcpp::Service<PlanCenterlines>::SharedPtr srv_plan_centerlines_;
+  rclcpp::Service<StartPlanPath>::SharedPtr srv_start_plan_path_;
+  rclcpp::Service<GetPlanPathProgress>::SharedPtr srv_get_plan_path_progress_;
+
+  // timer selecting the centerline of the finished job
+  rclcpp::TimerBase::SharedPtr timer_plan_path_job_;
 
   // callback group for service
   rclcpp::CallbackGroup::SharedPtr callback_group_;
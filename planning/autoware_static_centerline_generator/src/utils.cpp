@@ -163,56 +163,84 @@ PathWithLaneId get_path_with_lane_id(
   return path_with_lane_id;
 }
 
-void update_centerline(
+std::vector<lanelet::Id> update_centerline(
   lanelet::LaneletMapPtr lanelet_map_ptr, const std::vector<TrajectoryPoint> & new_centerline,
-  const std::vector<lanelet::Id> & centerline_lane_ids)
+  const std::vector<lanelet::Id> & centerline_lane_ids,
+  EmbeddedCenterlines & embedded_centerlines)
 {
-  // get lanelet as reference to update centerline
-  std::unordered_map<lanelet::Id, lanelet::Lanelet> lanelet_ref_map;
-  for (const lanelet::Id centerline_lane_id : centerline_lane_ids) {
-    if (!lanelet_ref_map.count(centerline_lane_id) == 0) {
-      continue;
-    }
-    for (auto & lanelet_ref : lanelet_map_ptr->laneletLayer) {
-      if (lanelet_ref.id() == static_cast<int>(centerline_lane_id)) {
-        lanelet_ref_map.emplace(centerline_lane_id, lanelet_ref);
-        break;
-      }
-    }
-  }
-
-  // create new centerline
-  std::unordered_map<lanelet::Id, lanelet::LineString3d> centerline_map;
+  // collect the centerline points for each lanelet
+  std::vector<lanelet::Id> lane_ids_in_order;
+  std::unordered_map<lanelet::Id, std::vector<lanelet::BasicPoint3d>> positions_map;
   for (size_t traj_idx = 0; traj_idx < new_centerline.size(); ++traj_idx) {
     const auto & traj_pos = new_centerline.at(traj_idx).pose.position;
-    const lanelet::BasicPoint2d point(traj_pos.x, traj_pos.y);
     const lanelet::Id centerline_lane_id = centerline_lane_ids.at(traj_idx);
-    auto & lanelet_ref = lanelet_ref_map.at(centerline_lane_id);
+    const auto lanelet_ref = lanelet_map_ptr->laneletLayer.get(centerline_lane_id);
 
-    if (centerline_map.count(centerline_lane_id) == 0) {
-      centerline_map.emplace(centerline_lane_id, lanelet::LineString3d{lanelet::utils::getId()});
+    if (positions_map.count(centerline_lane_id) == 0) {
+      positions_map.emplace(centerline_lane_id, std::vector<lanelet::BasicPoint3d>{});
+      lane_ids_in_order.push_back(centerline_lane_id);
     }
 
     // already checked by connect_centerline_to_lanelet, but double check.
-    const bool is_inside = lanelet::geometry::inside(lanelet_ref, point);
+    const bool is_inside =
+      lanelet::geometry::inside(lanelet_ref, lanelet::BasicPoint2d(traj_pos.x, traj_pos.y));
     if (is_inside) {
-      const auto center_point = createPoint3d(traj_pos.x, traj_pos.y, traj_pos.z);
+      positions_map.at(centerline_lane_id).emplace_back(traj_pos.x, traj_pos.y, traj_pos.z);
+    }
+  }
 
-      // set center point
-      centerline_map.at(centerline_lane_id).push_back(center_point);
-      lanelet_map_ptr->add(center_point);
+  // update the centerline of the lanelets whose points changed only
+  std::vector<lanelet::Id> updated_lane_ids;
+  for (const lanelet::Id centerline_lane_id : lane_ids_in_order) {
+    const auto & positions = positions_map.at(centerline_lane_id);
+    if (positions.size() <= 1) {
+      continue;
     }
 
+    auto embedded_centerline = embedded_centerlines.find(centerline_lane_id);
     if (
-      traj_idx == new_centerline.size() - 1 ||
-      centerline_lane_id != centerline_lane_ids.at(traj_idx + 1)) {
-      const auto & centerline = centerline_map.at(centerline_lane_id);
-      if (centerline.size() > 1) {
-        lanelet_map_ptr->add(centerline);
-        lanelet_ref.setCenterline(centerline);
+      embedded_centerline != embedded_centerlines.end() &&
+      embedded_centerline->second.positions == positions) {
+      continue;
+    }
+
+    // NOTE: The points of an embedded centerline are moved in place, so that the map does not
+    //       accumulate the points of the previous centerlines.
+    if (embedded_centerline == embedded_centerlines.end()) {
+      embedded_centerline =
+        embedded_centerlines
+          .emplace(
+            centerline_lane_id,
+            EmbeddedCenterline{{}, lanelet::LineString3d{lanelet::utils::getId()}})
+          .first;
+      lanelet_map_ptr->add(embedded_centerline->second.line_string);
+    }
+    auto & line_string = embedded_centerline->second.line_string;
+    while (positions.size() < line_string.size()) {
+      line_string.pop_back();
+    }
+    for (size_t i = 0; i < positions.size(); ++i) {
+      const auto & position = positions.at(i);
+      if (i < line_string.size()) {
+        auto center_point = line_string[i];
+        center_point.x() = position.x();
+        center_point.y() = position.y();
+        center_point.z() = position.z();
+        center_point.setAttribute("local_x", position.x());
+        center_point.setAttribute("local_y", position.y());
+      } else {
+        const auto center_point = createPoint3d(position.x(), position.y(), position.z());
+        line_string.push_back(center_point);
+        lanelet_map_ptr->add(center_point);
       }
     }
+    embedded_centerline->second.positions = positions;
+
+    lanelet_map_ptr->laneletLayer.get(centerline_lane_id).setCenterline(line_string);
+    updated_lane_ids.push_back(centerline_lane_id);
   }
+
+  return updated_lane_ids;
 }
 
 Marker create_footprint_marker(
@@ -23,6 +23,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -52,9 +53,21 @@ PathWithLaneId get_path_with_lane_id(
   const geometry_msgs::msg::Pose & start_pose, const double ego_nearest_dist_threshold,
   const double ego_nearest_yaw_threshold);
 
-void update_centerline(
+// Centerline embedded in a lanelet by update_centerline, whose elements are patched in place
+// when the centerline of the lanelet changes
+struct EmbeddedCenterline
+{
+  std::vector<lanelet::BasicPoint3d> positions;
+  lanelet::LineString3d line_string;
+};
+using EmbeddedCenterlines = std::unordered_map<lanelet::Id, EmbeddedCenterline>;
+
+// Update the centerline of the lanelets whose points changed since they were embedded in
+// @embedded_centerlines, and return their IDs
+std::vector<lanelet::Id> update_centerline(
   lanelet::LaneletMapPtr lanelet_map_ptr, const std::vector<TrajectoryPoint> & new_centerline,
-  const std::vector<lanelet::Id> & centerline_lane_ids);
+  const std::vector<lanelet::Id> & centerline_lane_ids,
+  EmbeddedCenterlines & embedded_centerlines);
 
 Marker create_footprint_marker(
   const std::string & ns, const LinearRing2d & footprint_poly, const double width, const double r,
@@ -16,8 +16,12 @@
 #define PLANNING_DEBUG_TOOLS__TRAJECTORY_ANALYZER_HPP_
 
 #include "autoware/motion_utils/trajectory/trajectory.hpp"
+#include "autoware/tool_tracing/tracing.hpp"
 #include "autoware/universe_utils/geometry/geometry.hpp"
+#include "autoware/universe_utils/math/normalization.hpp"
+#include "autoware/universe_utils/system/stop_watch.hpp"
 #include "planning_debug_tools/msg/trajectory_debug_info.hpp"
+#include "planning_debug_tools/msg/trajectory_diff_info.hpp"
 #include "planning_debug_tools/util.hpp"
 #include "rclcpp/rclcpp.hpp"
 
@@ -27,10 +31,15 @@
 #include "autoware_planning_msgs/msg/trajectory.hpp"
 #include "nav_msgs/msg/odometry.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace planning_debug_tools
@@ -40,26 +49,54 @@ using autoware_planning_msgs::msg::Path;
 using autoware_planning_msgs::msg::Trajectory;
 using nav_msgs::msg::Odometry;
 using planning_debug_tools::msg::TrajectoryDebugInfo;
+using planning_debug_tools::msg::TrajectoryDiffInfo;
 
 template <typename T>
 class TrajectoryAnalyzer
 {
   using SubscriberType = typename rclcpp::Subscription<T>::SharedPtr;
   using PublisherType = rclcpp::Publisher<TrajectoryDebugInfo>::SharedPtr;
+  using DiffPublisherType = rclcpp::Publisher<TrajectoryDiffInfo>::SharedPtr;
   using T_ConstSharedPtr = typename T::ConstSharedPtr;
 
 public:
-  TrajectoryAnalyzer(rclcpp::Node * node, const std::string & sub_name)
-  : node_(node), name_(sub_name)
+  TrajectoryAnalyzer(rclcpp::Node * node, const std::string & sub_name, const int decimation = 1)
+  : node_(node),
+    name_(sub_name),
+    decimation_(std::max(decimation, 1)),
+    use_intra_process_(node->get_node_options().use_intra_process_comms())
   {
     const auto pub_name = sub_name + "/debug_info";
     pub_ = node->create_publisher<TrajectoryDebugInfo>(pub_name, 1);
+    diff_pub_ = node->create_publisher<TrajectoryDiffInfo>(sub_name + "/debug_diff", 1);
+
+    // each analyzer has its own callback group, so that a slow topic does not delay the others
+    // under a multi-threaded executor
+    callback_group_ = node->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    rclcpp::SubscriptionOptions options;
+    options.callback_group = callback_group_;
     sub_ = node->create_subscription<T>(
-      sub_name, 1, [this](const T_ConstSharedPtr msg) { run(msg->points); });
+      sub_name, 1,
+      [this](const T_ConstSharedPtr msg) {
+        // analyze every decimation_ messages, and only while the result is subscribed
+        if (++message_count_ % decimation_ != 0) return;
+        if (getSubscriberNum(pub_) + getSubscriberNum(diff_pub_) == 0) {
+          // the next analyzed message is compared with nothing rather than an old message
+          prev_msg_ = nullptr;
+          return;
+        }
+        run(msg);
+      },
+      options);
   }
   ~TrajectoryAnalyzer() = default;
 
-  void setKinematics(const Odometry::ConstSharedPtr input) { ego_kinematics_ = input; }
+  // NOTE: The kinematics are set from the callback group of the node while the analyzer reads
+  //       them from its own, so the pointer is accessed atomically.
+  void setKinematics(const Odometry::ConstSharedPtr input)
+  {
+    std::atomic_store(&ego_kinematics_, input);
+  }
 
   // Note: the lambda used in the subscriber captures "this", so any operations that change the
   // address of "this" are prohibited.
@@ -72,35 +109,175 @@ public:
   std::shared_ptr<rclcpp::Node> node_;
   std::string name_;
   PublisherType pub_;
+  DiffPublisherType diff_pub_;
   SubscriberType sub_;
+  rclcpp::CallbackGroup::SharedPtr callback_group_;
   Odometry::ConstSharedPtr ego_kinematics_;
+  int decimation_;
+  int message_count_{0};
+  bool use_intra_process_;
+
+  // NOTE: The arrays of the published message are reused between the calls of run.
+  TrajectoryDebugInfo data_;
+
+  // The last analyzed message, and its arrays with the arc length from its first point. The
+  // planners publish almost the same trajectory every cycle, so only the values depending on the
+  // points after the first differing one are computed again.
+  T_ConstSharedPtr prev_msg_;
+  TrajectoryDebugInfo cache_;
+
+  template <typename PublisherT>
+  static size_t getSubscriberNum(const PublisherT & pub)
+  {
+    return pub->get_subscription_count() + pub->get_intra_process_subscription_count();
+  }
 
-  template <typename P>
-  void run(const P & points)
+  void run(const T_ConstSharedPtr & msg)
   {
-    if (!ego_kinematics_) return;
+    AUTOWARE_TOOL_TRACING_STAGE("trajectory_analyzer", "run");
+    autoware::universe_utils::StopWatch<std::chrono::milliseconds> stop_watch;
+
+    const auto ego_kinematics = std::atomic_load(&ego_kinematics_);
+    if (!ego_kinematics) return;
+    const auto & points = msg->points;
     if (points.size() < 3) return;
 
-    const auto & ego_p = ego_kinematics_->pose.pose.position;
-
-    TrajectoryDebugInfo data;
-    data.stamp = node_->now();
-    data.size = points.size();
-    data.curvature = autoware::motion_utils::calcCurvature(points);
-    const auto arclength_offset = autoware::motion_utils::calcSignedArcLength(points, 0, ego_p);
-    data.arclength = calcPathArcLengthArray(points, -arclength_offset);
-    data.velocity = getVelocityArray(points);
-    data.acceleration = getAccelerationArray(points);
-    data.yaw = getYawArray(points);
-
-    if (
-      data.size != data.arclength.size() || data.size != data.velocity.size() ||
-      data.size != data.yaw.size()) {
-      RCLCPP_ERROR(node_->get_logger(), "computation failed.");
+    const auto & ego_p = ego_kinematics->pose.pose.position;
+    const size_t n = points.size();
+    const size_t prev_n = prev_msg_ ? prev_msg_->points.size() : 0;
+
+    // first point differing from the previous message
+    size_t diff_idx = 0;
+    while (diff_idx < std::min(n, prev_n) &&
+           points.at(diff_idx) == prev_msg_->points.at(diff_idx)) {
+      ++diff_idx;
+    }
+
+    TrajectoryDiffInfo diff;
+    diff.stamp = node_->now();
+    diff.size = n;
+    diff.previous_size = prev_n;
+    diff.first_diff_index = diff_idx;
+    for (size_t i = diff_idx; i < std::min(n, prev_n); ++i) {
+      diff.max_position_diff =
+        std::max(diff.max_position_diff, calcDistance2d(points.at(i), prev_msg_->points.at(i)));
+    }
+
+    // the curvature and the acceleration of a point depend on the next point, so the values are
+    // computed again from the point before the first differing one, and from the last segment at
+    // least since the acceleration there depends on the size
+    const size_t start_idx = std::min(std::max<size_t>(diff_idx, 1) - 1, n - 2);
+    diff.recomputed_size = n - start_idx;
+
+    cache_.arclength.resize(n);
+    cache_.curvature.resize(n);
+    cache_.velocity.resize(n);
+    cache_.acceleration.resize(n);
+    cache_.yaw.resize(n);
+
+    // records the difference with the value of the previous message at the same index
+    const auto update = [&](auto & values, const size_t i, const double value, double & max_diff) {
+      if (i < prev_n) {
+        max_diff = std::max(max_diff, std::abs(value - values.at(i)));
+      }
+      values.at(i) = value;
+    };
+
+    // fill all the arrays in one pass, where the segment to the next point is shared by the arc
+    // length and the acceleration
+    double arclength = start_idx == 0 ? 0.0 : cache_.arclength.at(start_idx);
+    double prev_segment_acc = 0.0;
+    if (0 < start_idx) {
+      const auto & prev_p = points.at(start_idx - 1);
+      const auto & p = points.at(start_idx);
+      const double delta_s = calcDistance2d(prev_p, p);
+      const double prev_vel = getVelocity(prev_p);
+      const double vel = getVelocity(p);
+      prev_segment_acc =
+        delta_s == 0.0 ? 0.0 : (vel * vel - prev_vel * prev_vel) / 2.0 / delta_s;
+    }
+    for (size_t i = start_idx; i < n; ++i) {
+      const auto & p = points.at(i);
+      const double vel = getVelocity(p);
+
+      cache_.arclength.at(i) = arclength;
+      update(cache_.velocity, i, vel, diff.max_velocity_diff);
+      const double yaw = getYaw(p);
+      if (i < prev_n) {
+        diff.max_yaw_diff = std::max(
+          diff.max_yaw_diff,
+          std::abs(autoware::universe_utils::normalizeRadian(yaw - cache_.yaw.at(i))));
+      }
+      cache_.yaw.at(i) = yaw;
+
+      if (i + 1 == n) {
+        break;
+      }
+
+      if (0 < i) {
+        update(
+          cache_.curvature, i,
+          autoware::universe_utils::calcCurvature(
+            getPoint(points.at(i - 1)), getPoint(p), getPoint(points.at(i + 1))),
+          diff.max_curvature_diff);
+      }
+
+      const auto & next_p = points.at(i + 1);
+      const double delta_s = calcDistance2d(p, next_p);
+      const double next_vel = getVelocity(next_p);
+      const double segment_acc =
+        delta_s == 0.0 ? 0.0 : (next_vel * next_vel - vel * vel) / 2.0 / delta_s;
+      arclength += delta_s;
+
+      // NOTE: The last two acceleration values are ignored since the path end velocity is always
+      //       0 by motion_velocity_smoother, which makes them negative infinity.
+      double acc = 0.0;
+      if (i == 0) {
+        acc = segment_acc;
+      } else if (i + 2 != n) {
+        acc = (prev_segment_acc + segment_acc) / 2.0;
+      }
+      update(cache_.acceleration, i, acc, diff.max_acceleration_diff);
+      prev_segment_acc = segment_acc;
+    }
+    cache_.acceleration.at(n - 1) = 0.0;
+    cache_.curvature.at(0) = cache_.curvature.at(1);
+    cache_.curvature.at(n - 1) = cache_.curvature.at(n - 2);
+    prev_msg_ = msg;
+
+    if (getSubscriberNum(diff_pub_) > 0) {
+      diff_pub_->publish(diff);
+    }
+    if (getSubscriberNum(pub_) == 0) {
       return;
     }
 
-    pub_->publish(data);
+    data_.stamp = diff.stamp;
+    data_.size = n;
+    data_.curvature = cache_.curvature;
+    data_.velocity = cache_.velocity;
+    data_.acceleration = cache_.acceleration;
+    data_.yaw = cache_.yaw;
+
+    // make the arc length relative to the ego, with the arc length to the ego's nearest segment
+    const size_t ego_seg_idx = autoware::motion_utils::findNearestSegmentIndex(points, ego_p);
+    const double arclength_offset =
+      cache_.arclength.at(ego_seg_idx) +
+      autoware::motion_utils::calcLongitudinalOffsetToSegment(points, ego_seg_idx, ego_p);
+    data_.arclength.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      data_.arclength.at(i) = cache_.arclength.at(i) - arclength_offset;
+    }
+
+    data_.processing_time_ms = stop_watch.toc();
+
+    // NOTE: The message is moved to the intra-process subscribers instead of being copied, at the
+    //       cost of its arrays being allocated again by the next call.
+    if (use_intra_process_) {
+      pub_->publish(std::make_unique<TrajectoryDebugInfo>(std::move(data_)));
+    } else {
+      pub_->publish(data_);
+    }
   }
 };
 
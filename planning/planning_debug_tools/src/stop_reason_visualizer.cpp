@@ -21,10 +21,14 @@
 #include <visualization_msgs/msg/marker.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 
 namespace planning_debug_tools
 {
@@ -34,11 +38,43 @@ using tier4_planning_msgs::msg::StopReasonArray;
 using visualization_msgs::msg::Marker;
 using visualization_msgs::msg::MarkerArray;
 
+namespace
+{
+template <typename T>
+void hashCombine(std::size_t & seed, const T & value)
+{
+  seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// hash of the fields that the markers are made of, so the header is not part of it
+std::size_t hashStopReasons(const StopReasonArray & msg)
+{
+  std::size_t seed = 0;
+  for (const auto & stop_reason : msg.stop_reasons) {
+    if (stop_reason.reason.empty()) continue;
+    hashCombine(seed, stop_reason.reason);
+    for (const auto & stop_factor : stop_reason.stop_factors) {
+      if (stop_factor.stop_factor_points.empty()) continue;
+      const auto & point = stop_factor.stop_factor_points.front();
+      const auto & pose = stop_factor.stop_pose;
+      for (const double value :
+           {point.x, point.y, point.z, pose.position.x, pose.position.y, pose.position.z,
+            pose.orientation.x, pose.orientation.y, pose.orientation.z, pose.orientation.w}) {
+        hashCombine(seed, value);
+      }
+    }
+  }
+  return seed;
+}
+}  // namespace
+
 class StopReasonVisualizerNode : public rclcpp::Node
 {
 public:
   explicit StopReasonVisualizerNode(const rclcpp::NodeOptions & options)
-  : Node("stop_reason_visualizer", options)
+  : Node("stop_reason_visualizer", options),
+    decimation_(std::max(declare_parameter<int>("decimation", 1), 1)),
+    marker_lifetime_(std::max(declare_parameter<double>("marker_lifetime", 1.0), 0.0))
   {
     pub_stop_reasons_marker_ = create_publisher<MarkerArray>("~/debug/markers", 1);
     sub_stop_reasons_ = create_subscription<StopReasonArray>(
@@ -49,76 +85,109 @@ public:
 private:
   void onStopReasonArray(const StopReasonArray::ConstSharedPtr msg)
   {
-    using autoware::universe_utils::appendMarkerArray;
     using autoware::universe_utils::createDefaultMarker;
     using autoware::universe_utils::createMarkerColor;
     using autoware::universe_utils::createMarkerScale;
 
-    MarkerArray all_marker_array;
-    const auto header = msg->header;
+    // visualize every decimation_ messages, and only while the markers are subscribed
+    if (++message_count_ % decimation_ != 0) return;
+    if (
+      pub_stop_reasons_marker_->get_subscription_count() +
+        pub_stop_reasons_marker_->get_intra_process_subscription_count() ==
+      0) {
+      // a new subscriber gets the markers even if the stop reasons do not change
+      last_hash_.reset();
+      return;
+    }
+
+    // The stop reasons rarely change, so the same markers are published again only before their
+    // lifetime ends. Without a lifetime, they are published on change only, after a DELETEALL.
+    const auto current_time = this->now();
+    const auto hash = hashStopReasons(*msg);
+    if (
+      last_hash_ == hash &&
+      (marker_lifetime_ == 0.0 ||
+       (current_time - last_publish_time_).seconds() < 0.5 * marker_lifetime_)) {
+      return;
+    }
+    last_hash_ = hash;
+    last_publish_time_ = current_time;
+
+    auto all_marker_array = std::make_unique<MarkerArray>();
+    auto & markers = all_marker_array->markers;
+    const auto lifetime = rclcpp::Duration::from_seconds(marker_lifetime_);
     const double offset_z = 1.0;
-    for (auto stop_reason : msg->stop_reasons) {
-      std::string reason = stop_reason.reason;
+
+    if (marker_lifetime_ == 0.0) {
+      Marker delete_all_marker;
+      delete_all_marker.action = Marker::DELETEALL;
+      markers.push_back(delete_all_marker);
+    }
+
+    // build the markers in place
+    const auto add = [&](
+                       const std::string & ns, const int id, const int32_t type,
+                       const geometry_msgs::msg::Vector3 & scale,
+                       const std_msgs::msg::ColorRGBA & color) -> Marker & {
+      markers.push_back(createDefaultMarker("map", current_time, ns, id, type, scale, color));
+      markers.back().lifetime = lifetime;
+      return markers.back();
+    };
+
+    for (const auto & stop_reason : msg->stop_reasons) {
+      const auto & reason = stop_reason.reason;
       if (reason.empty()) continue;
-      const auto current_time = this->now();
       int id = 0;
-      MarkerArray marker_array;
-      for (auto stop_factor : stop_reason.stop_factors) {
+      for (const auto & stop_factor : stop_reason.stop_factors) {
         if (stop_factor.stop_factor_points.empty()) continue;
-        std::string prefix = reason + "[" + std::to_string(id) + "]";
-        const auto stop_factor_point = stop_factor.stop_factor_points.front();
+        const std::string prefix = reason + "[" + std::to_string(id) + "]";
+        const auto & stop_factor_point = stop_factor.stop_factor_points.front();
         // base stop pose marker
-        {
-          auto stop_point_marker = createDefaultMarker(
-            "map", current_time, prefix + ":stop_factor_point", id, Marker::SPHERE,
-            createMarkerScale(0.25, 0.25, 0.25), createMarkerColor(1.0, 0.0, 0.0, 0.999));
-          stop_point_marker.pose.position = stop_factor_point;
-          marker_array.markers.emplace_back(stop_point_marker);
-        }
+        add(
+          prefix + ":stop_factor_point", id, Marker::SPHERE, createMarkerScale(0.25, 0.25, 0.25),
+          createMarkerColor(1.0, 0.0, 0.0, 0.999))
+          .pose.position = stop_factor_point;
         // attention ! marker
         {
-          auto attention_text_marker = createDefaultMarker(
-            "map", current_time, prefix + ":attention text", id,
-            visualization_msgs::msg::Marker::TEXT_VIEW_FACING, createMarkerScale(0.0, 0.0, 1.0),
-            createMarkerColor(1.0, 1.0, 1.0, 0.999));
+          auto & attention_text_marker = add(
+            prefix + ":attention text", id, Marker::TEXT_VIEW_FACING,
+            createMarkerScale(0.0, 0.0, 1.0), createMarkerColor(1.0, 1.0, 1.0, 0.999));
           attention_text_marker.pose.position = stop_factor_point;
           attention_text_marker.pose.position.z += offset_z;
           attention_text_marker.text = "!";
-          marker_array.markers.emplace_back(attention_text_marker);
         }
         // point to pose
         {
-          auto stop_to_pose_marker = createDefaultMarker(
-            "map", current_time, prefix + ":stop_to_pose", id, Marker::LINE_STRIP,
-            createMarkerScale(0.02, 0.0, 0.0), createMarkerColor(0.0, 1.0, 1.0, 0.999));
-          stop_to_pose_marker.points.emplace_back(stop_factor.stop_factor_points.front());
-          stop_to_pose_marker.points.emplace_back(stop_factor.stop_pose.position);
-          marker_array.markers.emplace_back(stop_to_pose_marker);
+          auto & stop_to_pose_marker = add(
+            prefix + ":stop_to_pose", id, Marker::LINE_STRIP, createMarkerScale(0.02, 0.0, 0.0),
+            createMarkerColor(0.0, 1.0, 1.0, 0.999));
+          stop_to_pose_marker.points.push_back(stop_factor_point);
+          stop_to_pose_marker.points.push_back(stop_factor.stop_pose.position);
         }
         // point to pose
-        {
-          auto stop_pose_marker = createDefaultMarker(
-            "map", current_time, prefix + ":stop_pose", id, Marker::ARROW,
-            createMarkerScale(0.4, 0.2, 0.2), createMarkerColor(1.0, 0.0, 0.0, 0.999));
-          stop_pose_marker.pose = stop_factor.stop_pose;
-          marker_array.markers.emplace_back(stop_pose_marker);
-        }
+        add(
+          prefix + ":stop_pose", id, Marker::ARROW, createMarkerScale(0.4, 0.2, 0.2),
+          createMarkerColor(1.0, 0.0, 0.0, 0.999))
+          .pose = stop_factor.stop_pose;
         // add view distance text
         {
-          auto reason_text_marker = createDefaultMarker(
-            "map", current_time, prefix + ":reason", id, Marker::TEXT_VIEW_FACING,
-            createMarkerScale(0.0, 0.0, 0.2), createMarkerColor(1.0, 1.0, 1.0, 0.999));
+          auto & reason_text_marker = add(
+            prefix + ":reason", id, Marker::TEXT_VIEW_FACING, createMarkerScale(0.0, 0.0, 0.2),
+            createMarkerColor(1.0, 1.0, 1.0, 0.999));
           reason_text_marker.pose = stop_factor.stop_pose;
           reason_text_marker.text = prefix;
-          marker_array.markers.emplace_back(reason_text_marker);
         }
         id++;
       }
-      if (!marker_array.markers.empty())
-        appendMarkerArray(marker_array, &all_marker_array, current_time);
     }
-    pub_stop_reasons_marker_->publish(all_marker_array);
+    // NOTE: The markers are moved to the intra-process subscribers instead of being copied.
+    pub_stop_reasons_marker_->publish(std::move(all_marker_array));
   }
+  int decimation_;
+  double marker_lifetime_;
+  int message_count_{0};
+  std::optional<std::size_t> last_hash_;
+  rclcpp::Time last_publish_time_;
   rclcpp::Publisher<MarkerArray>::SharedPtr pub_stop_reasons_marker_;
   rclcpp::Subscription<StopReasonArray>::SharedPtr sub_stop_reasons_;
 };
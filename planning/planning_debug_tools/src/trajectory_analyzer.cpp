@@ -27,19 +27,21 @@ TrajectoryAnalyzerNode::TrajectoryAnalyzerNode(const rclcpp::NodeOptions & optio
   const auto path_topics = declare_parameter<TopicNames>("path_topics");
   const auto path_with_lane_id_topics = declare_parameter<TopicNames>("path_with_lane_id_topics");
   const auto trajectory_topics = declare_parameter<TopicNames>("trajectory_topics");
+  const auto decimation = declare_parameter<int>("decimation", 1);
 
   for (const auto & s : path_topics) {
-    path_analyzers_.push_back(std::make_shared<TrajectoryAnalyzer<Path>>(this, s));
+    path_analyzers_.push_back(std::make_shared<TrajectoryAnalyzer<Path>>(this, s, decimation));
     RCLCPP_INFO(get_logger(), "path_topics: %s", s.c_str());
   }
   for (const auto & s : path_with_lane_id_topics) {
     path_with_lane_id_analyzers_.push_back(
-      std::make_shared<TrajectoryAnalyzer<PathWithLaneId>>(this, s));
+      std::make_shared<TrajectoryAnalyzer<PathWithLaneId>>(this, s, decimation));
     RCLCPP_INFO(get_logger(), "path_with_lane_id_topics: %s", s.c_str());
   }
 
   for (const auto & s : trajectory_topics) {
-    trajectory_analyzers_.push_back(std::make_shared<TrajectoryAnalyzer<Trajectory>>(this, s));
+    trajectory_analyzers_.push_back(
+      std::make_shared<TrajectoryAnalyzer<Trajectory>>(this, s, decimation));
     RCLCPP_INFO(get_logger(), "trajectory_topics: %s", s.c_str());
   }
 
@@ -19,6 +19,7 @@
 
 #include "calibration_adapter/calibration_adapter_node_base.hpp"
 #include "estimator_utils/math_utils.hpp"
+#include "estimator_utils/time_series_buffer.hpp"
 #include "rclcpp/rclcpp.hpp"
 
 #include "autoware_control_msgs/msg/control.hpp"
@@ -26,7 +27,7 @@
 #include "geometry_msgs/msg/twist_stamped.hpp"
 #include "tier4_calibration_msgs/msg/float32_stamped.hpp"
 
-#include <vector>
+#include <cstddef>
 
 class CalibrationAdapterNode : public CalibrationAdapterNodeBase
 {
@@ -35,27 +36,32 @@ class CalibrationAdapterNode : public CalibrationAdapterNodeBase
   using TwistStamped = geometry_msgs::msg::TwistStamped;
 
 public:
-  CalibrationAdapterNode();
+  explicit CalibrationAdapterNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
 private:
   double acceleration_ = 0.0;
   const double dif_twist_time_ = 0.2;  // 200ms
   const std::size_t twist_vec_max_size_ = 100;
   double lowpass_cutoff_value_;
-  std::vector<TwistStamped> twist_vec_;
+  // the slope of the velocity fitted over the last dif_twist_time_ instead of the difference from
+  // the twist of dif_twist_time_ before
+  bool use_regression_derivative_;
+  TimeSeriesBuffer<TwistStamped> twist_buffer_{twist_vec_max_size_};
+  // the time from time_origin_ and the velocity of the last window_size_ twists of twist_buffer_
+  math_utils::StreamingStatistics window_statistics_;
+  std::size_t window_size_ = 0;
+  std::size_t window_update_count_ = 0;
+  double time_origin_ = 0.0;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_acceleration_status_;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_acceleration_cmd_;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_steering_angle_cmd_;
   rclcpp::Publisher<TwistStamped>::SharedPtr pub_vehicle_twist_;
   rclcpp::Subscription<ControlCommandStamped>::SharedPtr sub_control_cmd_;
   rclcpp::Subscription<Velocity>::SharedPtr sub_twist_;
-  template <class T>
-  T getNearestTimeDataFromVec(
-    const T base_data, const double back_time, const std::vector<T> & vec);
   double getAccel(
     const TwistStamped & prev_twist, const TwistStamped & current_twist, const double dt);
-  template <class T>
-  void pushDataToVec(const T data, const std::size_t max_size, std::vector<T> * vec);
+  void pushTwist(const TwistStamped & twist);
+  void rebuildWindowStatistics();
   void callbackControlCmd(const ControlCommandStamped::ConstSharedPtr msg);
   void callbackTwistStatus(const Velocity::ConstSharedPtr msg);
 };
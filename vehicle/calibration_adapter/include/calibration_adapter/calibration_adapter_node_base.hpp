@@ -17,6 +17,7 @@
 #ifndef CALIBRATION_ADAPTER__CALIBRATION_ADAPTER_NODE_BASE_HPP_
 #define CALIBRATION_ADAPTER__CALIBRATION_ADAPTER_NODE_BASE_HPP_
 
+#include "calibration_adapter/latency_histogram.hpp"
 #include "rclcpp/rclcpp.hpp"
 
 #include "autoware_vehicle_msgs/msg/engage.hpp"
@@ -35,9 +36,16 @@ public:
   using BoolStamped = tier4_calibration_msgs::msg::BoolStamped;
   using EngageStatus = autoware_vehicle_msgs::msg::Engage;
   using SteeringAngleStatus = autoware_vehicle_msgs::msg::SteeringReport;
-  CalibrationAdapterNodeBase();
+  explicit CalibrationAdapterNodeBase(const rclcpp::NodeOptions & options);
+
+protected:
+  // the output topics are latched, unless the intra-process communication requires volatile ones
+  rclcpp::QoS getOutputQoS(const std::size_t depth) const;
+  // time from the start of each callback to the publish of its output
+  LatencyHistogram latency_histogram_;
 
 private:
+  rclcpp::TimerBase::SharedPtr latency_report_timer_;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_accel_status_;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_brake_status_;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_steer_status_;
@@ -55,6 +63,7 @@ private:
   void onActuationCmd(const ActuationCommandStamped::ConstSharedPtr msg);
   void onActuationStatus(const ActuationStatusStamped::ConstSharedPtr msg);
   void onEngageStatus(const EngageStatus::SharedPtr msg);
+  void reportLatency();
 };
 
 #endif  // CALIBRATION_ADAPTER__CALIBRATION_ADAPTER_NODE_BASE_HPP_
@@ -0,0 +1,97 @@
+//
+// Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef CALIBRATION_ADAPTER__LATENCY_HISTOGRAM_HPP_
+#define CALIBRATION_ADAPTER__LATENCY_HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+/**
+ * Histogram of latencies in buckets of the powers of two in microseconds, the last bucket is
+ * for all the ones over about half a second.
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr std::size_t BUCKET_NUM = 21;
+
+  void add(const std::chrono::nanoseconds latency)
+  {
+    const auto us = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0) / 1000);
+    std::size_t bucket = 0;
+    while (bucket < BUCKET_NUM - 1 && (uint64_t{1} << bucket) <= us) {
+      bucket++;
+    }
+    buckets_[bucket]++;
+    count_++;
+    max_ = std::max(max_, latency);
+  }
+
+  void clear() { *this = LatencyHistogram(); }
+  std::size_t count() const { return count_; }
+
+  // @return : upper bound in microseconds of the bucket of the ratio of the latencies
+  uint64_t percentile(const double ratio) const
+  {
+    const auto target = static_cast<std::size_t>(std::ceil(ratio * static_cast<double>(count_)));
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < BUCKET_NUM; i++) {
+      sum += buckets_[i];
+      if (sum >= std::max<std::size_t>(target, 1)) {
+        return uint64_t{1} << i;
+      }
+    }
+    return uint64_t{1} << (BUCKET_NUM - 1);
+  }
+
+  std::string toString() const
+  {
+    std::stringstream ss;
+    ss << "n: " << count_ << ", p50 < " << percentile(0.5) << " us, p99 < " << percentile(0.99)
+       << " us, max: " << std::chrono::duration_cast<std::chrono::microseconds>(max_).count()
+       << " us";
+    return ss.str();
+  }
+
+private:
+  std::array<std::size_t, BUCKET_NUM> buckets_{};
+  std::size_t count_ = 0;
+  std::chrono::nanoseconds max_{0};
+};
+
+// adds the time from its construction to its destruction to a histogram
+class ScopedLatency
+{
+public:
+  explicit ScopedLatency(LatencyHistogram * histogram)
+  : histogram_(histogram), start_(std::chrono::steady_clock::now())
+  {
+  }
+  ~ScopedLatency() { histogram_->add(std::chrono::steady_clock::now() - start_); }
+
+private:
+  LatencyHistogram * histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+#endif  // CALIBRATION_ADAPTER__LATENCY_HISTOGRAM_HPP_
@@ -18,19 +18,19 @@
 
 #include <tf2/utils.h>
 
-#include <limits>
 #include <memory>
-#include <vector>
+#include <utility>
 
-CalibrationAdapterNode::CalibrationAdapterNode()
+CalibrationAdapterNode::CalibrationAdapterNode(const rclcpp::NodeOptions & options)
+: CalibrationAdapterNodeBase(options)
 {
   using std::placeholders::_1;
 
   // QoS setup
   static constexpr std::size_t queue_size = 1;
-  rclcpp::QoS durable_qos(queue_size);
-  durable_qos.transient_local();  // option for latching
+  const auto durable_qos = getOutputQoS(queue_size);
   lowpass_cutoff_value_ = this->declare_parameter<double>("lowpass_cutoff_value", 0.033);
+  use_regression_derivative_ = this->declare_parameter<bool>("use_regression_derivative", false);
 
   pub_steering_angle_cmd_ =
     create_publisher<Float32Stamped>("~/output/steering_angle_cmd", durable_qos);
@@ -48,24 +48,6 @@ CalibrationAdapterNode::CalibrationAdapterNode()
     std::bind(&CalibrationAdapterNode::callbackTwistStatus, this, _1));
 }
 
-template <class T>
-T CalibrationAdapterNode::getNearestTimeDataFromVec(
-  const T base_data, const double back_time, const std::vector<T> & vec)
-{
-  double nearest_time = std::numeric_limits<double>::max();
-  const double target_time = rclcpp::Time(base_data.header.stamp).seconds() - back_time;
-  T nearest_time_data;
-  for (const auto & data : vec) {
-    const double data_time = rclcpp::Time(data.header.stamp).seconds();
-    const auto delta_time = std::abs(target_time - data_time);
-    if (nearest_time > delta_time) {
-      nearest_time_data = data;
-      nearest_time = delta_time;
-    }
-  }
-  return nearest_time_data;
-}
-
 double CalibrationAdapterNode::getAccel(
   const TwistStamped & prev_twist, const TwistStamped & current_twist, const double dt)
 {
@@ -77,59 +59,112 @@ double CalibrationAdapterNode::getAccel(
   return dv / dt;
 }
 
-template <class T>
-void CalibrationAdapterNode::pushDataToVec(
-  const T data, const std::size_t max_size, std::vector<T> * vec)
+void CalibrationAdapterNode::pushTwist(const TwistStamped & twist)
 {
-  vec->emplace_back(data);
-  while (vec->size() > max_size) {
-    vec->erase(vec->begin());
+  const double time = rclcpp::Time(twist.header.stamp).seconds();
+  if (!use_regression_derivative_) {
+    twist_buffer_.push(time, twist);
+    return;
+  }
+
+  // the oldest twist of the window is dropped from the buffer
+  if (twist_buffer_.full() && window_size_ == twist_buffer_.size()) {
+    window_statistics_.remove(
+      twist_buffer_.timeAt(0) - time_origin_, twist_buffer_.at(0).twist.linear.x);
+    window_size_--;
+  }
+  if (!twist_buffer_.push(time, twist)) {
+    // the time went back, e.g. by replaying a rosbag again
+    window_statistics_.clear();
+    window_size_ = 0;
+  }
+  if (twist_buffer_.size() == 1) {
+    time_origin_ = time;
+  }
+  window_statistics_.add(time - time_origin_, twist.twist.linear.x);
+  window_size_++;
+
+  // the twists older than dif_twist_time_ leave the window
+  while (window_size_ > 1) {
+    const std::size_t front = twist_buffer_.size() - window_size_;
+    if (twist_buffer_.timeAt(front) >= time - dif_twist_time_) {
+      break;
+    }
+    window_statistics_.remove(
+      twist_buffer_.timeAt(front) - time_origin_, twist_buffer_.at(front).twist.linear.x);
+    window_size_--;
   }
+
+  // the removals accumulate rounding errors, so the statistics are rebuilt once in a while
+  if (++window_update_count_ >= twist_buffer_.capacity()) {
+    rebuildWindowStatistics();
+  }
+}
+
+void CalibrationAdapterNode::rebuildWindowStatistics()
+{
+  window_statistics_.clear();
+  for (std::size_t i = twist_buffer_.size() - window_size_; i < twist_buffer_.size(); i++) {
+    window_statistics_.add(
+      twist_buffer_.timeAt(i) - time_origin_, twist_buffer_.at(i).twist.linear.x);
+  }
+  window_update_count_ = 0;
 }
 
 void CalibrationAdapterNode::callbackControlCmd(const ControlCommandStamped::ConstSharedPtr msg)
 {
-  Float32Stamped steer_angle_msg;
-  steer_angle_msg.header.stamp = msg->stamp;
-  steer_angle_msg.header.frame_id = "base_link";
-  steer_angle_msg.data = msg->lateral.steering_tire_angle;
-  pub_steering_angle_cmd_->publish(steer_angle_msg);
-
-  Float32Stamped accel_msg;
-  accel_msg.header.stamp = msg->stamp;
-  accel_msg.header.frame_id = "base_link";
-  accel_msg.data = msg->longitudinal.acceleration;
-  pub_acceleration_cmd_->publish(accel_msg);
+  ScopedLatency latency(&latency_histogram_);
+  auto steer_angle_msg = std::make_unique<Float32Stamped>();
+  steer_angle_msg->header.stamp = msg->stamp;
+  steer_angle_msg->header.frame_id = "base_link";
+  steer_angle_msg->data = msg->lateral.steering_tire_angle;
+  pub_steering_angle_cmd_->publish(std::move(steer_angle_msg));
+
+  auto accel_msg = std::make_unique<Float32Stamped>();
+  accel_msg->header.stamp = msg->stamp;
+  accel_msg->header.frame_id = "base_link";
+  accel_msg->data = msg->longitudinal.acceleration;
+  pub_acceleration_cmd_->publish(std::move(accel_msg));
 }
 
 void CalibrationAdapterNode::callbackTwistStatus(const Velocity::ConstSharedPtr msg)
 {
+  ScopedLatency latency(&latency_histogram_);
   TwistStamped twist;
   twist.header = msg->header;
   twist.twist.linear.x = msg->longitudinal_velocity;
   twist.twist.linear.y = msg->lateral_velocity;
   twist.twist.angular.z = msg->heading_rate;
-  pub_vehicle_twist_->publish(twist);
-  if (!twist_vec_.empty()) {
-    const auto past_msg = getNearestTimeDataFromVec(twist, dif_twist_time_, twist_vec_);
+  pub_vehicle_twist_->publish(std::make_unique<TwistStamped>(twist));
+  if (use_regression_derivative_) {
+    pushTwist(twist);
+    // the span of the window
     const double dt =
-      (rclcpp::Time(msg->header.stamp) - rclcpp::Time(past_msg.header.stamp)).seconds();
-    const double raw_acceleration = getAccel(past_msg, twist, dt);
-    acceleration_ =
-      math_utils::lowpassFilter(acceleration_, raw_acceleration, lowpass_cutoff_value_, dt);
+      twist_buffer_.backTime() - twist_buffer_.timeAt(twist_buffer_.size() - window_size_);
+    if (window_size_ > 2 && dt >= 1e-03 && window_statistics_.varianceX() > 0.0) {
+      const double raw_acceleration =
+        window_statistics_.covariance() / window_statistics_.varianceX();
+      acceleration_ =
+        math_utils::lowpassFilter(acceleration_, raw_acceleration, lowpass_cutoff_value_, dt);
+    }
+  } else {
+    if (!twist_buffer_.empty()) {
+      const double time = rclcpp::Time(msg->header.stamp).seconds();
+      const auto & past_msg = twist_buffer_.at(twist_buffer_.nearestIndex(time - dif_twist_time_));
+      const double dt =
+        (rclcpp::Time(msg->header.stamp) - rclcpp::Time(past_msg.header.stamp)).seconds();
+      const double raw_acceleration = getAccel(past_msg, twist, dt);
+      acceleration_ =
+        math_utils::lowpassFilter(acceleration_, raw_acceleration, lowpass_cutoff_value_, dt);
+    }
+    pushTwist(twist);
   }
-  pushDataToVec(twist, twist_vec_max_size_, &twist_vec_);
 
-  Float32Stamped accel_status_msg;
-  accel_status_msg.header.stamp = msg->header.stamp;
-  accel_status_msg.data = acceleration_;
-  pub_acceleration_status_->publish(accel_status_msg);
+  auto accel_status_msg = std::make_unique<Float32Stamped>();
+  accel_status_msg->header.stamp = msg->header.stamp;
+  accel_status_msg->data = acceleration_;
+  pub_acceleration_status_->publish(std::move(accel_status_msg));
 }
 
-int main(int argc, char ** argv)
-{
-  rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<CalibrationAdapterNode>());
-  rclcpp::shutdown();
-  return 0;
-}
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(CalibrationAdapterNode)
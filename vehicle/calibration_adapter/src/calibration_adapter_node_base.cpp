@@ -18,16 +18,18 @@
 
 #include <tf2/utils.h>
 
+#include <chrono>
 #include <memory>
+#include <utility>
 
-CalibrationAdapterNodeBase::CalibrationAdapterNodeBase() : Node("calibration_adapter")
+CalibrationAdapterNodeBase::CalibrationAdapterNodeBase(const rclcpp::NodeOptions & options)
+: Node("calibration_adapter", options)
 {
   using std::placeholders::_1;
 
   // QoS setup
   static constexpr std::size_t queue_size = 1;
-  rclcpp::QoS durable_qos(queue_size);
-  durable_qos.transient_local();  // option for latching
+  const auto durable_qos = getOutputQoS(queue_size);
 
   pub_accel_status_ = create_publisher<tier4_calibration_msgs::msg::Float32Stamped>(
     "~/output/accel_status", durable_qos);
@@ -61,56 +63,83 @@ CalibrationAdapterNodeBase::CalibrationAdapterNodeBase() : Node("calibration_ada
   sub_actuation_command_ = create_subscription<ActuationCommandStamped>(
     "~/input/actuation_command", queue_size,
     std::bind(&CalibrationAdapterNodeBase::onActuationCmd, this, _1));
+
+  // 0 for no report
+  const double latency_report_period = declare_parameter<double>("latency_report_period", 0.0);
+  if (latency_report_period > 0.0) {
+    latency_report_timer_ = rclcpp::create_timer(
+      this, get_clock(), rclcpp::Duration::from_seconds(latency_report_period),
+      std::bind(&CalibrationAdapterNodeBase::reportLatency, this));
+  }
+}
+
+rclcpp::QoS CalibrationAdapterNodeBase::getOutputQoS(const std::size_t depth) const
+{
+  rclcpp::QoS qos(depth);
+  if (!get_node_options().use_intra_process_comms()) {
+    qos.transient_local();  // option for latching
+  }
+  return qos;
+}
+
+void CalibrationAdapterNodeBase::reportLatency()
+{
+  RCLCPP_INFO_STREAM(get_logger(), "callback latency " << latency_histogram_.toString());
+  latency_histogram_.clear();
 }
 
 void CalibrationAdapterNodeBase::callbackSteeringAngleStatus(
   const SteeringAngleStatus::ConstSharedPtr msg)
 {
-  Float32Stamped steer_status_msg;
-  steer_status_msg.header.stamp = msg->stamp;
-  steer_status_msg.data = msg->steering_tire_angle;
-  pub_steering_angle_status_->publish(steer_status_msg);
+  ScopedLatency latency(&latency_histogram_);
+  auto steer_status_msg = std::make_unique<Float32Stamped>();
+  steer_status_msg->header.stamp = msg->stamp;
+  steer_status_msg->data = msg->steering_tire_angle;
+  pub_steering_angle_status_->publish(std::move(steer_status_msg));
 }
 
 void CalibrationAdapterNodeBase::onActuationCmd(const ActuationCommandStamped::ConstSharedPtr msg)
 {
-  Float32Stamped brake_msgs;
-  brake_msgs.header = msg->header;
-  brake_msgs.data = msg->actuation.brake_cmd;
-  pub_brake_cmd_->publish(brake_msgs);
-
-  Float32Stamped accel_msgs;
-  accel_msgs.header = msg->header;
-  accel_msgs.data = msg->actuation.accel_cmd;
-  pub_accel_cmd_->publish(accel_msgs);
-
-  Float32Stamped steer_msgs;
-  steer_msgs.header = msg->header;
-  steer_msgs.data = msg->actuation.steer_cmd;
-  pub_steer_cmd_->publish(steer_msgs);
+  ScopedLatency latency(&latency_histogram_);
+  auto brake_msgs = std::make_unique<Float32Stamped>();
+  brake_msgs->header = msg->header;
+  brake_msgs->data = msg->actuation.brake_cmd;
+  pub_brake_cmd_->publish(std::move(brake_msgs));
+
+  auto accel_msgs = std::make_unique<Float32Stamped>();
+  accel_msgs->header = msg->header;
+  accel_msgs->data = msg->actuation.accel_cmd;
+  pub_accel_cmd_->publish(std::move(accel_msgs));
+
+  auto steer_msgs = std::make_unique<Float32Stamped>();
+  steer_msgs->header = msg->header;
+  steer_msgs->data = msg->actuation.steer_cmd;
+  pub_steer_cmd_->publish(std::move(steer_msgs));
 }
 
 void CalibrationAdapterNodeBase::onActuationStatus(const ActuationStatusStamped::ConstSharedPtr msg)
 {
-  Float32Stamped accel_msgs;
-  accel_msgs.header = msg->header;
-  accel_msgs.data = msg->status.accel_status;
-  pub_accel_status_->publish(accel_msgs);
-
-  Float32Stamped brake_msgs;
-  brake_msgs.header = msg->header;
-  brake_msgs.data = msg->status.brake_status;
-  pub_brake_status_->publish(brake_msgs);
-
-  Float32Stamped steer_msgs;
-  steer_msgs.header = msg->header;
-  steer_msgs.data = msg->status.steer_status;
-  pub_steer_status_->publish(steer_msgs);
+  ScopedLatency latency(&latency_histogram_);
+  auto accel_msgs = std::make_unique<Float32Stamped>();
+  accel_msgs->header = msg->header;
+  accel_msgs->data = msg->status.accel_status;
+  pub_accel_status_->publish(std::move(accel_msgs));
+
+  auto brake_msgs = std::make_unique<Float32Stamped>();
+  brake_msgs->header = msg->header;
+  brake_msgs->data = msg->status.brake_status;
+  pub_brake_status_->publish(std::move(brake_msgs));
+
+  auto steer_msgs = std::make_unique<Float32Stamped>();
+  steer_msgs->header = msg->header;
+  steer_msgs->data = msg->status.steer_status;
+  pub_steer_status_->publish(std::move(steer_msgs));
 }
 
 void CalibrationAdapterNodeBase::onEngageStatus(const EngageStatus::SharedPtr msg)
 {
-  BoolStamped engage_msgs;
-  engage_msgs.data = msg->engage;
-  pub_is_engage_->publish(engage_msgs);
+  ScopedLatency latency(&latency_histogram_);
+  auto engage_msgs = std::make_unique<BoolStamped>();
+  engage_msgs->data = msg->engage;
+  pub_is_engage_->publish(std::move(engage_msgs));
 }
@@ -19,15 +19,16 @@
 #include <tf2/utils.h>
 
 #include <memory>
+#include <utility>
 
-PacmodCalibrationAdapterNode::PacmodCalibrationAdapterNode()
+PacmodCalibrationAdapterNode::PacmodCalibrationAdapterNode(const rclcpp::NodeOptions & options)
+: CalibrationAdapterNodeBase(options)
 {
   using std::placeholders::_1;
 
   // QoS setup
   static constexpr std::size_t queue_size = 1;
-  rclcpp::QoS durable_qos(queue_size);
-  durable_qos.transient_local();  // option for latching
+  const auto durable_qos = getOutputQoS(queue_size);
 
   pub_handle_status_ = create_publisher<Float32Stamped>("~/output/handle_status", durable_qos);
   sub_handle_status_ = create_subscription<SteeringWheelStatusStamped>(
@@ -38,17 +39,13 @@ PacmodCalibrationAdapterNode::PacmodCalibrationAdapterNode()
 void PacmodCalibrationAdapterNode::callbackSteeringWheelStatus(
   const SteeringWheelStatusStamped::ConstSharedPtr msg)
 {
-  tier4_calibration_msgs::msg::Float32Stamped steer_msgs;
-  steer_msgs.header.stamp = msg->stamp;
-  steer_msgs.header.frame_id = "base_link";
-  steer_msgs.data = msg->data;
-  pub_handle_status_->publish(steer_msgs);
+  ScopedLatency latency(&latency_histogram_);
+  auto steer_msgs = std::make_unique<tier4_calibration_msgs::msg::Float32Stamped>();
+  steer_msgs->header.stamp = msg->stamp;
+  steer_msgs->header.frame_id = "base_link";
+  steer_msgs->data = msg->data;
+  pub_handle_status_->publish(std::move(steer_msgs));
 }
 
-int main(int argc, char ** argv)
-{
-  rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<PacmodCalibrationAdapterNode>());
-  rclcpp::shutdown();
-  return 0;
-}
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(PacmodCalibrationAdapterNode)
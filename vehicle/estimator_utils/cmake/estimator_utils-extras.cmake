@@ -0,0 +1,6 @@
+# Link the counters of estimator_utils/allocation_counter.hpp into a test executable. They replace
+# the allocation functions of the executable, so they are not exported to the nodes.
+function(estimator_utils_link_allocation_counter target)
+  target_link_libraries(${target}
+    "${estimator_utils_DIR}/../../../lib/${CMAKE_STATIC_LIBRARY_PREFIX}estimator_utils_allocation_counter${CMAKE_STATIC_LIBRARY_SUFFIX}")
+endfunction()
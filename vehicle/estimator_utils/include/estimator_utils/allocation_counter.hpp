@@ -0,0 +1,87 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef ESTIMATOR_UTILS__ALLOCATION_COUNTER_HPP_
+#define ESTIMATOR_UTILS__ALLOCATION_COUNTER_HPP_
+
+#include <cstddef>
+#include <ostream>
+
+/**
+ * Heap allocation counters of each thread, for the tests checking that the callbacks of the
+ * real-time nodes do not allocate once they are warmed up. They are only defined in the test
+ * executables linking estimator_utils_allocation_counter, which replaces operator new and delete,
+ * and also malloc, calloc, realloc and free on glibc. It must not be linked into the nodes.
+ */
+namespace allocation_counter
+{
+struct Counts
+{
+  size_t allocations = 0;
+  size_t deallocations = 0;
+  size_t bytes = 0;
+};
+
+inline Counts operator-(const Counts & a, const Counts & b)
+{
+  Counts c;
+  c.allocations = a.allocations - b.allocations;
+  c.deallocations = a.deallocations - b.deallocations;
+  c.bytes = a.bytes - b.bytes;
+  return c;
+}
+
+inline std::ostream & operator<<(std::ostream & os, const Counts & c)
+{
+  return os << c.allocations << " allocations (" << c.bytes << " bytes), " << c.deallocations
+            << " deallocations";
+}
+
+// false if the allocations are not counted, as in the builds with a sanitizer replacing them
+bool isEnabled();
+
+// the counts of the calling thread since it started
+Counts getThreadCounts();
+
+// the allocations of the calling thread while @f runs
+template <class F>
+Counts count(F && f)
+{
+  const Counts start = getThreadCounts();
+  f();
+  return getThreadCounts() - start;
+}
+
+/**
+ * The allocations of @n calls of @callback after @warm_up calls, which may allocate the buffers
+ * kept by the callback, as in the steady state of a node. The callback gets the number of the
+ * call, so that it may feed synthetic messages.
+ */
+template <class F>
+Counts countSteadyState(F && callback, const size_t warm_up, const size_t n)
+{
+  for (size_t i = 0; i < warm_up; i++) {
+    callback(i);
+  }
+  return count([&]() {
+    for (size_t i = warm_up; i < warm_up + n; i++) {
+      callback(i);
+    }
+  });
+}
+}  // namespace allocation_counter
+
+#endif  // ESTIMATOR_UTILS__ALLOCATION_COUNTER_HPP_
@@ -0,0 +1,95 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef ESTIMATOR_UTILS__DEBUG_ARRAY_PUBLISHER_HPP_
+#define ESTIMATOR_UTILS__DEBUG_ARRAY_PUBLISHER_HPP_
+
+#include "rclcpp/rclcpp.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+
+/**
+ * Array message reused for every publication, whose data is reserved with the capacity once so
+ * that filling it again does not allocate while the size is within the capacity.
+ * MessageT is a message of an array field named data, e.g. std_msgs::msg::Float32MultiArray.
+ */
+template <class MessageT>
+class PreallocatedArray
+{
+public:
+  explicit PreallocatedArray(const size_t capacity) { message_.data.reserve(capacity); }
+
+  /**
+   * @return : message whose data is emptied, keeping its allocation
+   **/
+  MessageT & clear()
+  {
+    message_.data.clear();
+    return message_;
+  }
+
+  /**
+   * @return : message whose data is the values, converted to the type of the data
+   **/
+  template <class Container>
+  MessageT & assign(const Container & values)
+  {
+    message_.data.assign(std::begin(values), std::end(values));
+    return message_;
+  }
+
+  MessageT & message() { return message_; }
+  const MessageT & message() const { return message_; }
+  size_t capacity() const { return message_.data.capacity(); }
+
+private:
+  MessageT message_;
+};
+
+/**
+ * Publisher of a debug array message, which publishes the preallocated message of its own
+ */
+template <class MessageT>
+class DebugArrayPublisher
+{
+public:
+  DebugArrayPublisher(
+    rclcpp::Node * node, const std::string & topic, const size_t capacity,
+    const rclcpp::QoS & qos = rclcpp::QoS(1))
+  : publisher_(node->create_publisher<MessageT>(topic, qos)), array_(capacity)
+  {
+  }
+
+  MessageT & clear() { return array_.clear(); }
+  MessageT & message() { return array_.message(); }
+
+  void publish() const { publisher_->publish(array_.message()); }
+  template <class Container>
+  void publish(const Container & values)
+  {
+    array_.assign(values);
+    publish();
+  }
+
+private:
+  typename rclcpp::Publisher<MessageT>::SharedPtr publisher_;
+  PreallocatedArray<MessageT> array_;
+};
+
+#endif  // ESTIMATOR_UTILS__DEBUG_ARRAY_PUBLISHER_HPP_
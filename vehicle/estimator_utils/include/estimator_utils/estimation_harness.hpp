@@ -0,0 +1,110 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef ESTIMATOR_UTILS__ESTIMATION_HARNESS_HPP_
+#define ESTIMATOR_UTILS__ESTIMATION_HARNESS_HPP_
+
+#include "estimator_utils/estimator_base.hpp"
+
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Offline runner of estimators over one stream of samples, e.g. decoded from a rosbag.
+ *
+ * The samples are decoded once, a block at a time, and every estimator runs over a block in its
+ * own thread while the next block is decoded. The estimators do not publish, their results are
+ * left in their statistics and result_msgs_.
+ */
+template <class Sample>
+class EstimationHarness
+{
+public:
+  // gives a sample to an estimator, e.g. by its setData
+  using Feed = std::function<void(const Sample &)>;
+  // sets the next sample of the stream, and returns false at the end of the stream
+  using Decode = std::function<bool(Sample &)>;
+
+  explicit EstimationHarness(const size_t block_size = 4096) : block_size_(block_size) {}
+
+  void addEstimator(EstimatorBase * estimator, Feed feed)
+  {
+    channels_.push_back({estimator, std::move(feed)});
+  }
+
+  /**
+   * @param decode : source of the samples
+   * @return : number of samples
+   **/
+  size_t run(const Decode & decode)
+  {
+    std::vector<Sample> current, next;
+    current.reserve(block_size_);
+    next.reserve(block_size_);
+    bool has_next = decodeBlock(decode, current);
+    size_t num_sample = 0;
+
+    while (!current.empty()) {
+      std::vector<std::thread> threads;
+      for (auto & channel : channels_) {
+        threads.emplace_back([&channel, &current]() {
+          for (const auto & sample : current) {
+            channel.feed(sample);
+            channel.estimator->processData();
+            channel.estimator->Run(false);
+          }
+        });
+      }
+      next.clear();
+      if (has_next) {
+        has_next = decodeBlock(decode, next);
+      }
+      for (auto & t : threads) {
+        t.join();
+      }
+      num_sample += current.size();
+      std::swap(current, next);
+    }
+    return num_sample;
+  }
+
+private:
+  struct Channel
+  {
+    EstimatorBase * estimator;
+    Feed feed;
+  };
+
+  // @return : false if the stream ended
+  bool decodeBlock(const Decode & decode, std::vector<Sample> & block) const
+  {
+    Sample sample;
+    while (block.size() < block_size_) {
+      if (!decode(sample)) {
+        return false;
+      }
+      block.push_back(sample);
+    }
+    return true;
+  }
+
+  size_t block_size_;
+  std::vector<Channel> channels_;
+};
+
+#endif  // ESTIMATOR_UTILS__ESTIMATION_HARNESS_HPP_
@@ -60,7 +60,7 @@ public:
     math_utils::calcSequentialStddev(result_statistics_);
     math_utils::calcSequentialStddev(error_statistics_);
   }
-  void publishResult()
+  void updateResult()
   {
     result_msgs_.result = result_statistics_.value;
     result_msgs_.result_mean = result_statistics_.mean;
@@ -68,6 +68,10 @@ public:
     result_msgs_.absolute_error = error_statistics_.value;
     result_msgs_.mean_absolute_error = error_statistics_.mean;
     result_msgs_.stddev_absolute_error = error_statistics_.stddev;
+  }
+  void publishResult()
+  {
+    updateResult();
     pub_estimated_->publish(result_msgs_);
   }
   rclcpp::Publisher<outputType>::SharedPtr pub_estimated_;
@@ -85,9 +89,9 @@ public:
    *  1. preprocess data
    *  2. estimate parameter
    *  3. post process output
-   *  publish output
+   *  publish output, unless @publish is false
    **/
-  void Run()
+  void Run(const bool publish = true)
   {
     try {
       if (is_valid_data_) {
@@ -100,8 +104,12 @@ public:
           seq_++;
         }
       }
-      publishData();
-      publishResult();
+      if (publish) {
+        publishData();
+        publishResult();
+      } else {
+        updateResult();
+      }
     } catch (std::runtime_error & e) {  // Handle runtime errors
       std::cerr << "[parameter_estimator] runtime_error: " << e.what() << std::endl;
     } catch (std::logic_error & e) {
@@ -0,0 +1,54 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef ESTIMATOR_UTILS__LATEST_VALUE_HPP_
+#define ESTIMATOR_UTILS__LATEST_VALUE_HPP_
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/**
+ * Slot of the latest message received by a subscription, read by a timer. The message is shared,
+ * not copied, and the pointer is swapped atomically, so the callbacks and the timers may run in
+ * different threads of a multi-threaded executor. A reader keeps the message it loaded alive
+ * while the slot is updated, so it should load the slot once and use the loaded pointer.
+ */
+template <class T>
+class LatestValue
+{
+public:
+  using ConstSharedPtr = std::shared_ptr<const T>;
+
+  void store(ConstSharedPtr value)
+  {
+    std::atomic_store_explicit(&value_, std::move(value), std::memory_order_release);
+  }
+  ConstSharedPtr load() const
+  {
+    return std::atomic_load_explicit(&value_, std::memory_order_acquire);
+  }
+  void reset() { store(nullptr); }
+  bool empty() const { return load() == nullptr; }
+
+  // lock free when the standard library supports it for shared_ptr, else a short spin lock
+  bool is_lock_free() const { return std::atomic_is_lock_free(&value_); }
+
+private:
+  ConstSharedPtr value_;
+};
+
+#endif  // ESTIMATOR_UTILS__LATEST_VALUE_HPP_
@@ -19,6 +19,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <complex>
+#include <cstddef>
 #include <deque>
 #include <numeric>
 #include <utility>
@@ -40,19 +42,71 @@ inline double normalize(const double val, const double min, const double max)
   return (val - min) / (max - min);
 }
 
-inline std::vector<double> getLinearInterpolation(const std::vector<double> & arr, int num_interp)
+/**
+ * Non-owning view of contiguous samples, as std::span of C++20. The helpers taking spans read and
+ * write the buffers of the caller, so that they do not allocate. A span is made from a pointer and
+ * a size, or from any container with data() and size(), and it is itself a vector like container
+ * for the template helpers, e.g. calcMAE.
+ */
+template <class T>
+class Span
+{
+public:
+  Span() = default;
+  Span(T * data, const size_t size) : data_(data), size_(size) {}
+  template <class C>
+  Span(C & container)  // NOLINT
+  : Span(container.data(), container.size())
+  {
+  }
+
+  T * data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  T & operator[](const size_t i) const { return data_[i]; }
+  T & back() const { return data_[size_ - 1]; }
+  T * begin() const { return data_; }
+  T * end() const { return data_ + size_; }
+  Span subspan(const size_t offset, const size_t count) const { return {data_ + offset, count}; }
+
+private:
+  T * data_ = nullptr;
+  size_t size_ = 0;
+};
+
+using ConstSpan = Span<const double>;
+
+/**
+ * @param arr : samples to interpolate
+ * @param num_interp : interpolated points per sample
+ * @param interp : (arr.size() - 1) * num_interp + 1 values, written by the function
+ * @return : number of the written values
+ */
+inline size_t getLinearInterpolation(const ConstSpan arr, int num_interp, const Span<double> interp)
 {
-  std::vector<double> interp;
+  if (arr.empty()) {
+    return 0;
+  }
+  size_t n = 0;
   for (size_t i = 1; i < arr.size(); i++) {
     double a = arr[i - 1];
     double b = arr[i];
     for (int j = 0; j < num_interp; j++) {
       double weight = j / static_cast<double>(num_interp);
-      double val = interpolate(a, b, weight);
-      interp.emplace_back(val);
+      interp[n++] = interpolate(a, b, weight);
     }
   }
-  interp.emplace_back(arr.back());
+  interp[n++] = arr.back();
+  return n;
+}
+
+inline std::vector<double> getLinearInterpolation(const std::vector<double> & arr, int num_interp)
+{
+  if (arr.empty()) {
+    return {};
+  }
+  std::vector<double> interp((arr.size() - 1) * std::max(num_interp, 0) + 1);
+  interp.resize(getLinearInterpolation(arr, num_interp, interp));
   return interp;
 }
 
@@ -62,6 +116,115 @@ int getMaximumIndexFromVector(const T & x)
   const auto iter = std::max_element(x.begin(), x.end());
   return std::distance(x.begin(), iter);
 }
+
+/**
+ * @brief sub-sample position of a peak, at the vertex of the parabola through the peak and its
+ * neighbors
+ * @param x : vector like array
+ * @param peak_index : index of the maximum of x
+ * @return : peak_index moved by at most half a sample, or peak_index at the ends of x
+ */
+template <class T>
+double getParabolicPeakIndex(const T & x, const int peak_index)
+{
+  if (peak_index <= 0 || peak_index + 1 >= static_cast<int>(x.size())) {
+    return peak_index;
+  }
+  const double y0 = x[peak_index - 1];
+  const double y1 = x[peak_index];
+  const double y2 = x[peak_index + 1];
+  const double curvature = y0 - 2.0 * y1 + y2;
+  // flat around the peak
+  if (curvature >= 0.0) {
+    return peak_index;
+  }
+  return peak_index + saturation(0.5 * (y0 - y2) / curvature, -0.5, 0.5);
+}
+/**
+ * Weighted mean, variance and covariance of the samples (x, y), updated in O(1) per sample by
+ * Welford's method. A sample is removed by the inverse update, e.g. when it leaves a sliding
+ * window, and two accumulators are merged by Chan's method. The variances are those of the
+ * population, as getStddevFromVector.
+ */
+class StreamingStatistics
+{
+public:
+  void add(const double x, const double y = 0.0, const double w = 1.0)
+  {
+    count_++;
+    update(x, y, w);
+  }
+
+  // @x, @y and @w must be those of a sample added before
+  void remove(const double x, const double y = 0.0, const double w = 1.0)
+  {
+    if (count_ <= 1) {
+      clear();
+      return;
+    }
+    count_--;
+    update(x, y, -w);
+  }
+
+  void merge(const StreamingStatistics & other)
+  {
+    if (other.count_ == 0) {
+      return;
+    }
+    if (count_ == 0) {
+      *this = other;
+      return;
+    }
+    const double sum_w = sum_w_ + other.sum_w_;
+    const double dx = other.mean_x_ - mean_x_;
+    const double dy = other.mean_y_ - mean_y_;
+    const double ratio = sum_w_ * other.sum_w_ / sum_w;
+    mean_x_ += dx * other.sum_w_ / sum_w;
+    mean_y_ += dy * other.sum_w_ / sum_w;
+    m2_x_ += other.m2_x_ + dx * dx * ratio;
+    m2_y_ += other.m2_y_ + dy * dy * ratio;
+    c_xy_ += other.c_xy_ + dx * dy * ratio;
+    sum_w_ = sum_w;
+    count_ += other.count_;
+  }
+
+  void clear() { *this = StreamingStatistics(); }
+
+  size_t count() const { return count_; }
+  double weight() const { return sum_w_; }
+  double meanX() const { return mean_x_; }
+  double meanY() const { return mean_y_; }
+  double varianceX() const { return sum_w_ > 0.0 ? std::max(m2_x_ / sum_w_, 0.0) : 0.0; }
+  double varianceY() const { return sum_w_ > 0.0 ? std::max(m2_y_ / sum_w_, 0.0) : 0.0; }
+  double stddevX() const { return std::sqrt(varianceX()); }
+  double stddevY() const { return std::sqrt(varianceY()); }
+  double covariance() const { return sum_w_ > 0.0 ? c_xy_ / sum_w_ : 0.0; }
+  double correlation() const { return covariance() / (stddevX() * stddevY()); }
+
+private:
+  // a negative @w removes the sample
+  void update(const double x, const double y, const double w)
+  {
+    sum_w_ += w;
+    const double dx = x - mean_x_;
+    const double dy = y - mean_y_;
+    mean_x_ += dx * w / sum_w_;
+    mean_y_ += dy * w / sum_w_;
+    m2_x_ += w * dx * (x - mean_x_);
+    m2_y_ += w * dy * (y - mean_y_);
+    c_xy_ += w * dx * (y - mean_y_);
+  }
+
+  size_t count_ = 0;
+  double sum_w_ = 0;
+  double mean_x_ = 0;
+  double mean_y_ = 0;
+  // the weighted sums of the squared deviations and of the products of the deviations
+  double m2_x_ = 0;
+  double m2_y_ = 0;
+  double c_xy_ = 0;
+};
+
 template <class T>
 double getAverageFromVector(const T & arr)
 {
@@ -77,12 +240,11 @@ double getStddevFromVector(const T & arr)
   if (arr.empty()) {
     return 0;
   }
-  double average = getAverageFromVector(arr);
-  double diff = 0;
+  StreamingStatistics stat;
   for (const auto & v : arr) {
-    diff += std::pow(v - average, 2);
+    stat.add(v);
   }
-  return std::sqrt(diff / static_cast<double>(arr.size()));
+  return stat.stddevX();
 }
 
 template <class T>
@@ -91,20 +253,14 @@ double getCorrelationCoefficientFromVector(const T & x, const T & y)
   if (x.empty()) {
     return 0;
   }
-  int sz = x.size();
-  double coeff = 0;
-  double x_avg = getAverageFromVector(x);
-  double y_avg = getAverageFromVector(y);
-  double x_stddev = getStddevFromVector(x);
-  double y_stddev = getStddevFromVector(y);
-  if (x_stddev < 0.0001 || y_stddev < 0.0001) {
-    return 0;
+  StreamingStatistics stat;
+  for (size_t i = 0; i < x.size(); i++) {
+    stat.add(x[i], y[i]);
   }
-  for (int i = 0; i < x.size(); i++) {
-    coeff += (x[i] - x_avg) * (y[i] - y_avg);
+  if (stat.stddevX() < 0.0001 || stat.stddevY() < 0.0001) {
+    return 0;
   }
-  coeff /= (x_stddev * y_stddev * sz);
-  return coeff;
+  return stat.correlation();
 }
 
 template <class T>
@@ -128,15 +284,11 @@ double getCovarianceFromVector(const T & x, const T & y, const T & w)
   if (x.empty()) {
     return 0;
   }
-  double cov = 0;
-  double sum_w = 0;
-  double avg_x = getAverageFromVector(x, w);
-  double avg_y = getAverageFromVector(y, w);
+  StreamingStatistics stat;
   for (size_t i = 0; i < x.size(); i++) {
-    cov += w[i] * (x[i] - avg_x) * (y[i] - avg_y);
-    sum_w += w[i];
+    stat.add(x[i], y[i], w[i]);
   }
-  return cov / sum_w;
+  return stat.covariance();
 }
 template <class T>
 double getStddevFromVector(const T & arr, const T & w)
@@ -144,14 +296,11 @@ double getStddevFromVector(const T & arr, const T & w)
   if (arr.empty()) {
     return 0;
   }
-  double average = getAverageFromVector(arr, w);
-  double var = 0;
-  double w_sum = 0;
+  StreamingStatistics stat;
   for (size_t i = 0; i < arr.size(); i++) {
-    var += w[i] * std::pow((arr[i] - average), 2);
-    w_sum += w[i];
+    stat.add(arr[i], 0.0, w[i]);
   }
-  return std::sqrt(var / w_sum);
+  return stat.stddevX();
 }
 
 template <class T>
@@ -160,10 +309,11 @@ double getCorrelationCoefficientFromVector(const T & x, const T & y, const T & w
   if (x.empty()) {
     return 0;
   }
-  double x_stddev = getStddevFromVector(x, w);
-  double y_stddev = getStddevFromVector(y, w);
-  double xy_cov = getCovarianceFromVector(x, y, w);
-  return xy_cov / (x_stddev * y_stddev);
+  StreamingStatistics stat;
+  for (size_t i = 0; i < x.size(); i++) {
+    stat.add(x[i], y[i], w[i]);
+  }
+  return stat.correlation();
 }
 
 inline double lowpassFilter(
@@ -174,6 +324,21 @@ inline double lowpassFilter(
   return prev_value * a + (1 - a) * current_value;
 }
 
+/**
+ * @param : arr samples
+ * @param : avg_arr arr minus its average, of arr.size() values, which may be arr itself
+ */
+inline void getAveragedVector(const ConstSpan arr, const Span<double> avg_arr)
+{
+  if (arr.empty()) {
+    return;
+  }
+  double avg = std::accumulate(arr.begin(), arr.end(), 0.0) / static_cast<double>(arr.size());
+  for (size_t i = 0; i < arr.size(); i++) {
+    avg_arr[i] = arr[i] - avg;
+  }
+}
+
 /**
  * @param : arr vector like container
  * @return : avg_arr processed arr vector
@@ -181,17 +346,21 @@ inline double lowpassFilter(
 template <class T>
 std::vector<double> getAveragedVector(const T & arr)
 {
-  if (arr.empty()) {
-    return arr;
-  }
   std::vector<double> avg_arr = {arr.begin(), arr.end()};
-  double avg = std::accumulate((arr).begin(), (arr).end(), 0.0) / static_cast<double>(arr.size());
-  for (auto & v : avg_arr) {
-    v -= avg;
-  }
+  getAveragedVector(avg_arr, avg_arr);
   return avg_arr;
 }
 
+/**
+ * @param : arr vector like container
+ * @param : vec copy of arr, which keeps its memory
+ */
+template <class T>
+void arrToVector(const T & arr, std::vector<double> & vec)
+{
+  vec.assign(arr.begin(), arr.end());
+}
+
 /**
  * @param : arr vector like container
  * @return : avg_arr processed arr vector
@@ -199,10 +368,44 @@ std::vector<double> getAveragedVector(const T & arr)
 template <class T>
 std::vector<double> arrToVector(const T & arr)
 {
-  std::vector<double> vec = {arr.begin(), arr.end()};
+  std::vector<double> vec;
+  arrToVector(arr, vec);
   return vec;
 }
 
+/**
+ * @param : arr samples
+ * @param : slide move vector placement 0 or 1
+ * @return : the last size samples of arr before the num_slide newest ones, without copying them
+ */
+inline ConstSpan fitToTheSizeOfVector(const ConstSpan arr, const int size, const int num_slide)
+{
+  if (static_cast<int>(arr.size()) < (size + num_slide)) {
+    return arr;
+  }
+  return arr.subspan(arr.size() - size - num_slide, size);
+}
+
+/**
+ * @brief averages of blocks of factor samples, from the newest ones. The oldest samples which do
+ * not fill a block are dropped.
+ * @param : arr vector like container, assuming (old,....,new)
+ * @param : decimated arr.size() / factor averages, (old,....,new)
+ */
+template <class T>
+void decimate(const T & arr, const int factor, std::vector<double> & decimated)
+{
+  const size_t block = static_cast<size_t>(std::max(factor, 1));
+  const size_t offset = arr.size() % block;
+  decimated.assign(arr.size() / block, 0.0);
+  for (size_t j = 0; j < decimated.size(); j++) {
+    for (size_t k = 0; k < block; k++) {
+      decimated[j] += arr[offset + j * block + k];
+    }
+    decimated[j] /= static_cast<double>(block);
+  }
+}
+
 /**
  * @param : arr vector like container
  * @param : slide move vector placement 0 or 1
@@ -247,38 +450,309 @@ void fitToTheSizeOfVector(
   } else if (d10 < d00 && d10 < d01) {
     input_slide = num_slide;
   }
-  input = fitToTheSizeOfVector(input, size, input_slide);
-  response = fitToTheSizeOfVector(response, size, response_slide);
+  // the samples are kept in place
+  const auto fit = [size](std::vector<double> & arr, const int slide) {
+    if (static_cast<int>(arr.size()) < (size + slide)) {
+      return;
+    }
+    arr.erase(arr.end() - slide, arr.end());
+    arr.erase(arr.begin(), arr.end() - size);
+  };
+  fit(input, input_slide);
+  fit(response, response_slide);
 }
+/**
+ * Workspace of calcCrossCorrelationCoefficient. The sums of every delay are computed at once by
+ * FFT in O(N log N), and the buffers are kept for the next signals of the same size.
+ *
+ * For a delay tau, the input reversed and shifted by tau and the response reversed are compared
+ * over N samples, with zeros behind the shifted part, as the correlation of the two vectors.
+ */
+class CrossCorrelation
+{
+public:
+  template <class T>
+  std::vector<double> calc(
+    const T & input, const T & response, const double valid_delay_index_ratio)
+  {
+    std::vector<double> CorrCoeff;
+    calc(input, response, valid_delay_index_ratio, CorrCoeff);
+    return CorrCoeff;
+  }
+
+  template <class T, class W>
+  std::vector<double> calc(
+    const T & input, const T & response, const W & weight, const double valid_delay_index_ratio)
+  {
+    std::vector<double> CorrCoeff;
+    calc(input, response, weight, valid_delay_index_ratio, CorrCoeff);
+    return CorrCoeff;
+  }
+
+  // the coefficients are written to CorrCoeff, which keeps its memory
+  template <class T>
+  void calc(
+    const T & input, const T & response, const double valid_delay_index_ratio,
+    std::vector<double> & CorrCoeff)
+  {
+    const size_t n = input.size();
+    const int T_interval = static_cast<int>(n * valid_delay_index_ratio);
+    CorrCoeff.assign(T_interval + 1, 0.0);
+    const size_t delay_num = std::min<size_t>(std::max(T_interval, 0), n);
+    if (delay_num == 0) {
+      return;
+    }
+
+    resize(n);
+
+    // x + iy, x: reversed input, y: reversed response
+    for (size_t k = 0; k < n; k++) {
+      a_[k] = {input[n - 1 - k], response[n - 1 - k]};
+    }
+    transform(a_, false);
+
+    // sum_k x[k + tau] * y[k]
+    for (size_t k = 0; k < a_.size(); k++) {
+      const auto spectra = separate(a_, k);
+      c_[k] = spectra.first * std::conj(spectra.second);
+    }
+    transform(c_, true);
+
+    double sum_x = 0, sum_x2 = 0, sum_y = 0, sum_y2 = 0;
+    for (size_t k = 0; k < n; k++) {
+      sum_x += reversed(input, n, k);
+      sum_x2 += std::pow(reversed(input, n, k), 2);
+      sum_y += reversed(response, n, k);
+      sum_y2 += std::pow(reversed(response, n, k), 2);
+    }
+
+    /**
+     * Correlation Coefficient Method
+     * CorrCoeff = Cov(x1x2)/Stddev(x1)*Stddev(x2)
+     */
+    const double sz = static_cast<double>(n);
+    for (size_t tau = 0; tau < delay_num; tau++) {
+      if (tau > 0) {
+        // x[tau - 1] and y[n - tau] leave the window
+        sum_x -= reversed(input, n, tau - 1);
+        sum_x2 -= std::pow(reversed(input, n, tau - 1), 2);
+        sum_y -= reversed(response, n, n - tau);
+        sum_y2 -= std::pow(reversed(response, n, n - tau), 2);
+      }
+      const double x_avg = sum_x / sz;
+      const double y_avg = sum_y / sz;
+      const double x_stddev = std::sqrt(std::max(sum_x2 / sz - x_avg * x_avg, 0.0));
+      const double y_stddev = std::sqrt(std::max(sum_y2 / sz - y_avg * y_avg, 0.0));
+      if (x_stddev < 0.0001 || y_stddev < 0.0001) {
+        continue;
+      }
+      CorrCoeff[tau] = (c_[tau].real() / sz - x_avg * y_avg) / (x_stddev * y_stddev);
+    }
+  }
+
+  template <class T, class W>
+  void calc(
+    const T & input, const T & response, const W & weight, const double valid_delay_index_ratio,
+    std::vector<double> & CorrCoeff)
+  {
+    const size_t n = input.size();
+    const int T_interval = static_cast<int>(n * valid_delay_index_ratio);
+    CorrCoeff.assign(std::max(T_interval, 0), 0.0);
+    const size_t delay_num = std::min<size_t>(std::max(T_interval - 1, 0), n);
+    if (delay_num == 0) {
+      return;
+    }
+
+    resize(n);
+
+    // the weights are not shifted, and the missing weights are zero
+    const auto w = [&](const size_t k) { return k < weight.size() ? weight[k] : 0.0; };
+
+    // x + ix^2 and w + iwy, x: reversed input, y: reversed response
+    double sum_w = 0, sum_wy = 0, sum_wy2 = 0;
+    for (size_t k = 0; k < n; k++) {
+      const double x = reversed(input, n, k);
+      const double y = reversed(response, n, k);
+      a_[k] = {x, x * x};
+      b_[k] = {w(k), w(k) * y};
+      sum_w += w(k);
+      sum_wy += w(k) * y;
+      sum_wy2 += w(k) * y * y;
+    }
+    transform(a_, false);
+    transform(b_, false);
+
+    // sum_k w[k] * x[k + tau] + i sum_k w[k] * x[k + tau]^2, and sum_k w[k] * y[k] * x[k + tau]
+    for (size_t k = 0; k < a_.size(); k++) {
+      const auto x_spectra = separate(a_, k);
+      const auto w_spectra = separate(b_, k);
+      c_[k] = a_[k] * std::conj(w_spectra.first);
+      d_[k] = x_spectra.first * std::conj(w_spectra.second);
+    }
+    transform(c_, true);
+    transform(d_, true);
+
+    /**
+     * Correlation Coefficient Method
+     * CorrCoeff = Cov(x1x2)/Stddev(x1)*Stddev(x2)
+     */
+    for (size_t tau = 0; tau < delay_num; tau++) {
+      if (tau > 0) {
+        // y[n - tau] leaves the window
+        const double y = reversed(response, n, n - tau);
+        sum_wy -= w(n - tau) * y;
+        sum_wy2 -= w(n - tau) * y * y;
+      }
+      const double avg_x = c_[tau].real() / sum_w;
+      const double avg_y = sum_wy / sum_w;
+      const double x_stddev = std::sqrt(std::max(c_[tau].imag() / sum_w - avg_x * avg_x, 0.0));
+      const double y_stddev = std::sqrt(std::max(sum_wy2 / sum_w - avg_y * avg_y, 0.0));
+      const double xy_cov = d_[tau].real() / sum_w - avg_x * avg_y;
+      CorrCoeff[tau] = xy_cov / (x_stddev * y_stddev);
+    }
+  }
+
+  /**
+   * @brief the weighted coefficients of calc at the delays in [lower_delay, upper_delay] only. Each
+   * delay is summed directly in O(n), which is cheaper than the FFTs for a few delays. The other
+   * delays are -1, the least coefficient.
+   */
+  template <class T, class W>
+  void calcInWindow(
+    const T & input, const T & response, const W & weight, const double valid_delay_index_ratio,
+    const int lower_delay, const int upper_delay, std::vector<double> & CorrCoeff) const
+  {
+    const size_t n = input.size();
+    const int T_interval = static_cast<int>(n * valid_delay_index_ratio);
+    CorrCoeff.assign(std::max(T_interval, 0), -1.0);
+    const int delay_num = static_cast<int>(std::min<size_t>(std::max(T_interval - 1, 0), n));
+
+    const auto w = [&](const size_t k) { return k < weight.size() ? weight[k] : 0.0; };
+    double sum_w = 0;
+    for (size_t k = 0; k < n; k++) {
+      sum_w += w(k);
+    }
+
+    for (int tau = std::max(lower_delay, 0); tau <= std::min(upper_delay, delay_num - 1); tau++) {
+      // x[k + tau] and y[k] of the reversed signals, as in calc
+      double sum_wx = 0, sum_wx2 = 0, sum_wy = 0, sum_wy2 = 0, sum_wxy = 0;
+      for (size_t k = 0; k + tau < n; k++) {
+        const double x = reversed(input, n, k + tau);
+        const double y = reversed(response, n, k);
+        sum_wx += w(k) * x;
+        sum_wx2 += w(k) * x * x;
+        sum_wy += w(k) * y;
+        sum_wy2 += w(k) * y * y;
+        sum_wxy += w(k) * x * y;
+      }
+      const double avg_x = sum_wx / sum_w;
+      const double avg_y = sum_wy / sum_w;
+      const double x_stddev = std::sqrt(std::max(sum_wx2 / sum_w - avg_x * avg_x, 0.0));
+      const double y_stddev = std::sqrt(std::max(sum_wy2 / sum_w - avg_y * avg_y, 0.0));
+      const double xy_cov = sum_wxy / sum_w - avg_x * avg_y;
+      CorrCoeff[tau] = xy_cov / (x_stddev * y_stddev);
+    }
+  }
+
+private:
+  using Complex = std::complex<double>;
+
+  // k-th sample of the reversed signal
+  template <class T>
+  static double reversed(const T & arr, const size_t n, const size_t k)
+  {
+    return arr[n - 1 - k];
+  }
+
+  // zero padded to a power of two of at least 2n, so the correlation does not wrap around
+  void resize(const size_t n)
+  {
+    size_t m = 1;
+    while (m < 2 * n) {
+      m <<= 1;
+    }
+    if (m != a_.size()) {
+      a_.resize(m);
+      b_.resize(m);
+      c_.resize(m);
+      d_.resize(m);
+      twiddles_.resize(m / 2);
+      for (size_t k = 0; k < m / 2; k++) {
+        twiddles_[k] = std::polar(1.0, -2.0 * M_PI * static_cast<double>(k) / m);
+      }
+      bit_reverse_.assign(m, 0);
+      for (size_t i = 1; i < m; i++) {
+        bit_reverse_[i] = (bit_reverse_[i >> 1] >> 1) | ((i & 1) ? m >> 1 : 0);
+      }
+    }
+    std::fill(a_.begin(), a_.end(), Complex{});
+    std::fill(b_.begin(), b_.end(), Complex{});
+  }
+
+  // in-place radix-2 FFT, the inverse is scaled by 1/m
+  void transform(std::vector<Complex> & a, const bool inverse) const
+  {
+    const size_t m = a.size();
+    for (size_t i = 0; i < m; i++) {
+      if (i < bit_reverse_[i]) {
+        std::swap(a[i], a[bit_reverse_[i]]);
+      }
+    }
+    for (size_t len = 2; len <= m; len <<= 1) {
+      const size_t step = m / len;
+      for (size_t i = 0; i < m; i += len) {
+        for (size_t j = 0; j < len / 2; j++) {
+          const auto w = inverse ? std::conj(twiddles_[j * step]) : twiddles_[j * step];
+          const auto u = a[i + j];
+          const auto v = a[i + j + len / 2] * w;
+          a[i + j] = u + v;
+          a[i + j + len / 2] = u - v;
+        }
+      }
+    }
+    if (inverse) {
+      for (auto & v : a) {
+        v /= static_cast<double>(m);
+      }
+    }
+  }
+
+  // the k-th bins of the spectra of the real and the imaginary parts of a transformed signal
+  static std::pair<Complex, Complex> separate(const std::vector<Complex> & spectrum, size_t k)
+  {
+    const auto z = spectrum[k];
+    const auto z_conj = std::conj(spectrum[(spectrum.size() - k) & (spectrum.size() - 1)]);
+    return {0.5 * (z + z_conj), Complex{0.0, -0.5} * (z - z_conj)};
+  }
+
+  std::vector<Complex> a_, b_, c_, d_;
+  std::vector<Complex> twiddles_;
+  std::vector<size_t> bit_reverse_;
+};
+
 /**
  *
  * @param input : input signal
  * @param response : output signal
  * @param valid_delay_index_ratio : number of shift to compare rate
+ * @param workspace : buffers reused between the calls
  * @return corr : size of (input+num_shift) , type T correlation value
  */
+template <class T>
+std::vector<double> calcCrossCorrelationCoefficient(
+  const T & input, const T & response, const double valid_delay_index_ratio,
+  CrossCorrelation & workspace)
+{
+  return workspace.calc(input, response, valid_delay_index_ratio);
+}
+
 template <class T>
 T calcCrossCorrelationCoefficient(
   const T & input, const T & response, const double valid_delay_index_ratio)
 {
-  T r_input = input;
-  T r_response = response;
-  std::reverse(r_input.begin(), r_input.end());
-  std::reverse(r_response.begin(), r_response.end());
-  int T_interval = static_cast<int>(input.size() * valid_delay_index_ratio);
-  T CorrCoeff(T_interval + 1, 0.0);
-  /**
-   * Correlation Coefficient Method
-   * CorrCoeff = Cov(x1x2)/Stddev(x1)*Stddev(x2)
-   */
-  for (int tau = 0; tau < T_interval; tau++) {
-    T cmp_input(input.size());
-    T cmp_response(response.size());
-    copy(r_input.begin() + tau, r_input.end(), cmp_input.begin());
-    copy(r_response.begin(), r_response.end() - tau, cmp_response.begin());
-    CorrCoeff.at(tau) = getCorrelationCoefficientFromVector(cmp_input, cmp_response);
-  }
-  return CorrCoeff;
+  CrossCorrelation workspace;
+  const auto CorrCoeff = workspace.calc(input, response, valid_delay_index_ratio);
+  return T(CorrCoeff.begin(), CorrCoeff.end());
 }
 
 /**
@@ -287,47 +761,55 @@ T calcCrossCorrelationCoefficient(
  * @param response : output signal
  * @param weight : weight for correlation
  * @param valid_delay_index_ratio : number of shift to compare rate
+ * @param workspace : buffers reused between the calls
  * @return corr : size of (input+num_shift) , type T correlation value
  */
+template <class T, class W>
+std::vector<double> calcCrossCorrelationCoefficient(
+  const T & input, const T & response, const W & weight, const double valid_delay_index_ratio,
+  CrossCorrelation & workspace)
+{
+  return workspace.calc(input, response, weight, valid_delay_index_ratio);
+}
+
+/**
+ * @brief calcCrossCorrelationCoefficient written to corr, which keeps its memory
+ */
+template <class T>
+void calcCrossCorrelationCoefficient(
+  const T & input, const T & response, const double valid_delay_index_ratio,
+  CrossCorrelation & workspace, std::vector<double> & corr)
+{
+  workspace.calc(input, response, valid_delay_index_ratio, corr);
+}
+
+template <class T, class W>
+void calcCrossCorrelationCoefficient(
+  const T & input, const T & response, const W & weight, const double valid_delay_index_ratio,
+  CrossCorrelation & workspace, std::vector<double> & corr)
+{
+  workspace.calc(input, response, weight, valid_delay_index_ratio, corr);
+}
+
 template <class T>
 T calcCrossCorrelationCoefficient(
   const T & input, const T & response, const T & weight, const double valid_delay_index_ratio)
 {
-  T r_input = input;
-  T r_response = response;
-  std::reverse(r_input.begin(), r_input.end());
-  std::reverse(r_response.begin(), r_response.end());
-  int T_interval = static_cast<int>(input.size() * valid_delay_index_ratio);
-  T CorrCoeff(T_interval, 0.0);
-  /**
-   * Correlation Coefficient Method
-   * CorrCoeff = Cov(x1x2)/Stddev(x1)*Stddev(x2)
-   */
-  for (int tau = 0; tau < T_interval - 1; tau++) {
-    T cmp_input(input.size());
-    T cmp_response(response.size());
-    copy(r_input.begin() + tau, r_input.end(), cmp_input.begin());
-    copy(r_response.begin(), r_response.end() - tau, cmp_response.begin());
-    CorrCoeff.at(tau) = getCorrelationCoefficientFromVector(cmp_input, cmp_response, weight);
-  }
-  return CorrCoeff;
+  CrossCorrelation workspace;
+  const auto CorrCoeff = workspace.calc(input, response, weight, valid_delay_index_ratio);
+  return T(CorrCoeff.begin(), CorrCoeff.end());
 }
 
 template <class T>
 double calcMAE(const T & input, const T & response, const int delay_index)
 {
   size_t sz = input.size() / 2;
-  T r_input = input;
-  T r_response = response;
-  std::reverse(r_input.begin(), r_input.end());
-  std::reverse(r_response.begin(), r_response.end());
-  std::vector<double> errors;  // input - response
-  for (size_t i = 0; i < sz; i++) {
-    errors.emplace_back(r_input[i + delay_index] - r_response[i]);
-  }
+  // input - response, from the newest samples
+  const size_t input_last = input.size() - 1;
+  const size_t response_last = response.size() - 1;
   double abs_sum = 0;
   for (size_t i = 0; i < sz; i++) {
-    abs_sum += std::abs(errors[i]);
+    abs_sum += std::abs(input[input_last - (i + delay_index)] - response[response_last - i]);
   }
   double mae = abs_sum / static_cast<double>(sz);
   return mae;
@@ -359,10 +841,10 @@ inline void calcSequentialStddev(Statistics & stat)
     auto & variance = stat.variance[i];
     auto & val = stat.value[i];
     auto & stddev = stat.stddev[i];
-    const auto old_avg = stat.mean[i];
-    mean = (seq * mean + val) / (seq + 1.0);
-    variance = (seq * (variance + std::pow(old_avg, 2)) + std::pow(val, 2)) / (seq + 1.0) -
-               std::pow(mean, 2);
+    // Welford's method, without the cancellation of E[x^2] - E[x]^2
+    const double delta = val - mean;
+    mean += delta / (seq + 1.0);
+    variance = (seq * variance + delta * (val - mean)) / (seq + 1.0);
     stddev = std::sqrt(variance);
   }
   cnt++;
@@ -379,11 +861,10 @@ struct Statistic
   // O(1) speed stddev & mean
   double calcSequentialStddev(const double val)
   {
-    double old_avg = mean;
     double seq = static_cast<double>(cnt);
-    mean = (seq * mean + val) / (seq + 1.0);
-    variance = (seq * (variance + std::pow(old_avg, 2)) + std::pow(val, 2)) / (seq + 1.0) -
-               std::pow(mean, 2);
+    const double delta = val - mean;
+    mean += delta / (seq + 1.0);
+    variance = (seq * variance + delta * (val - mean)) / (seq + 1.0);
     cnt++;
     return std::sqrt(variance);
   }
@@ -22,6 +22,8 @@
 #include <eigen3/Eigen/Geometry>
 #include <eigen3/Eigen/LU>
 
+#include <array>
+#include <cmath>
 #include <vector>
 
 namespace optimization_utils
@@ -52,6 +54,27 @@ inline void estimateByRLS(
   est = est + coef * error(0, 0);
 }
 
+/**
+ * @brief RLS of a model of N coefficients, without heap allocations
+ *
+ * The covariance is updated in the Joseph form, which keeps it symmetric and positive
+ * semi-definite against rounding errors:
+ * cov_n=[(I-coef_n*zn^T_n)*cov_n-1*(I-coef_n*zn^T_n)^T+rho_n*coef_n*coef_n^T]/rho_n
+ */
+template <int N>
+inline void estimateByRLS(
+  Eigen::Ref<Eigen::Matrix<double, N, 1>> est, Eigen::Ref<Eigen::Matrix<double, N, N>> cov,
+  const Eigen::Matrix<double, N, 1> & zn, const double ff, const double y)
+{
+  const Eigen::Matrix<double, N, 1> cov_zn = cov * zn;
+  const Eigen::Matrix<double, N, 1> coef = cov_zn / (ff + zn.dot(cov_zn));
+  const Eigen::Matrix<double, N, N> i_kz =
+    Eigen::Matrix<double, N, N>::Identity() - coef * zn.transpose();
+  const double error = y - zn.dot(est);
+  cov = (i_kz * cov * i_kz.transpose() + ff * coef * coef.transpose()) / ff;
+  est += coef * error;
+}
+
 /**
  * @param x_t latter value
  * @param t_x previous value
@@ -163,6 +186,126 @@ inline double getLeastSquaredError(
   return getErrorNorm(X, Y, w);
 }
 
+/**
+ * @brief least squared (LS) fits of the delayed targets against the same regressors
+ *
+ * X is made of the regressors and Y of the target delayed by one of the searched delays. X does
+ * not depend on the delay, so Xt * X is factorized once, and each delay only computes Xt * Y,
+ * the solution and the error norm, in one pass over the samples without building matrices.
+ */
+template <int Dim>
+class DelayedLeastSquared
+{
+public:
+  using Regressors = std::array<const double *, Dim>;
+
+  /**
+   * @param x : the columns of X, of num_sample values each
+   * @param num_sample : number of rows of X
+   */
+  DelayedLeastSquared(const Regressors & x, const size_t num_sample)
+  : x_(x), num_sample_(num_sample)
+  {
+    Eigen::Matrix<double, Dim, Dim> XtX = Eigen::Matrix<double, Dim, Dim>::Zero();
+    for (size_t i = 0; i < num_sample_; i++) {
+      for (int r = 0; r < Dim; r++) {
+        for (int c = 0; c < Dim; c++) {
+          XtX(r, c) += x_[r][i] * x_[c][i];
+        }
+      }
+    }
+    lu_.compute(XtX);
+  }
+
+  /**
+   * @param y : the num_sample values of Y
+   * @param w : solved by LS
+   * @return : normalized error, as getErrorNorm
+   */
+  double getLeastSquaredError(const double * y, Eigen::VectorXd & w) const
+  {
+    return solve([y](const size_t i) { return y[i]; }, w);
+  }
+
+  /**
+   * @brief fit of Y at a fractional delay, linearly interpolated between two integer delays
+   * @param y : the num_sample values of Y at the integer delay
+   * @param y_next : the num_sample values of Y delayed by one more sample
+   * @param ratio : position between y and y_next, in [0, 1]
+   * @param w : solved by LS
+   * @return : normalized error, as getErrorNorm
+   */
+  double getLeastSquaredError(
+    const double * y, const double * y_next, const double ratio, Eigen::VectorXd & w) const
+  {
+    return solve([&](const size_t i) { return y[i] + ratio * (y_next[i] - y[i]); }, w);
+  }
+
+private:
+  template <class Target>
+  double solve(const Target & y, Eigen::VectorXd & w) const
+  {
+    Eigen::Matrix<double, Dim, 1> b = Eigen::Matrix<double, Dim, 1>::Zero();
+    for (size_t i = 0; i < num_sample_; i++) {
+      const double y_i = y(i);
+      for (int r = 0; r < Dim; r++) {
+        b(r) += x_[r][i] * y_i;
+      }
+    }
+    const Eigen::Matrix<double, Dim, 1> solution = lu_.solve(b);
+
+    double error = 0;
+    for (size_t i = 0; i < num_sample_; i++) {
+      double e = -y(i);
+      for (int r = 0; r < Dim; r++) {
+        e += x_[r][i] * solution(r);
+      }
+      error += std::abs(e);
+    }
+    w = solution;
+    return error / static_cast<double>(num_sample_);
+  }
+
+  Regressors x_;
+  size_t num_sample_;
+  Eigen::FullPivLU<Eigen::Matrix<double, Dim, Dim>> lu_;
+};
+
+/**
+ * @brief minimum of a unimodal function by golden-section search
+ * @param f : function of one double
+ * @param lower : lower end of the search interval
+ * @param upper : upper end of the search interval
+ * @param tolerance : width of the interval at the end of the search
+ * @return : center of the last interval
+ */
+template <class F>
+double goldenSectionSearch(const F & f, double lower, double upper, const double tolerance)
+{
+  const double inv_phi = 0.5 * (std::sqrt(5.0) - 1.0);
+  double c = upper - inv_phi * (upper - lower);
+  double d = lower + inv_phi * (upper - lower);
+  double fc = f(c);
+  double fd = f(d);
+  // each step shrinks the interval by inv_phi and reuses one of the inner points
+  while (upper - lower > tolerance) {
+    if (fc < fd) {
+      upper = d;
+      d = c;
+      fd = fc;
+      c = upper - inv_phi * (upper - lower);
+      fc = f(c);
+    } else {
+      lower = c;
+      c = d;
+      fc = fd;
+      d = lower + inv_phi * (upper - lower);
+      fd = f(d);
+    }
+  }
+  return 0.5 * (lower + upper);
+}
+
 template <class T>
 bool change_abs_min(T & a, const T & b)
 {
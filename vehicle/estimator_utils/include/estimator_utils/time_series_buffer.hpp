@@ -0,0 +1,119 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef ESTIMATOR_UTILS__TIME_SERIES_BUFFER_HPP_
+#define ESTIMATOR_UTILS__TIME_SERIES_BUFFER_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Fixed capacity ring buffer of timestamped data, the oldest data is dropped when it is full.
+ * The times are kept in the increasing order, so the data of a time is found by binary search.
+ * The indices are from the oldest data.
+ */
+template <class T>
+class TimeSeriesBuffer
+{
+public:
+  explicit TimeSeriesBuffer(const size_t capacity)
+  : times_(capacity > 0 ? capacity : 1), data_(times_.size())
+  {
+  }
+
+  /**
+   * @return : false if the time is older than the newest data, then the buffer is cleared first
+   **/
+  bool push(const double time, const T & data)
+  {
+    const bool in_order = empty() || time >= backTime();
+    if (!in_order) {
+      clear();
+    }
+    const size_t i = (head_ + size_) % capacity();
+    times_[i] = time;
+    data_[i] = data;
+    if (size_ < capacity()) {
+      size_++;
+    } else {
+      head_ = (head_ + 1) % capacity();
+    }
+    return in_order;
+  }
+
+  void clear()
+  {
+    head_ = 0;
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return times_.size(); }
+  bool empty() const { return size_ == 0; }
+  bool full() const { return size_ == capacity(); }
+
+  const T & at(const size_t i) const { return data_[physical(i)]; }
+  double timeAt(const size_t i) const { return times_[physical(i)]; }
+  const T & back() const { return at(size_ - 1); }
+  double backTime() const { return timeAt(size_ - 1); }
+
+  /**
+   * @return : index of the first data not older than the time, size() if none
+   **/
+  size_t lowerBound(const double time) const
+  {
+    size_t first = 0;
+    size_t count = size_;
+    while (count > 0) {
+      const size_t step = count / 2;
+      if (timeAt(first + step) < time) {
+        first += step + 1;
+        count -= step + 1;
+      } else {
+        count = step;
+      }
+    }
+    return first;
+  }
+
+  /**
+   * @return : index of the data nearest to the time, the older one of equally near ones
+   **/
+  size_t nearestIndex(const double time) const
+  {
+    const size_t upper = lowerBound(time);
+    if (upper == 0) {
+      return 0;
+    }
+    if (upper == size_) {
+      return size_ - 1;
+    }
+    // the first one of the same times, as the older data is preferred
+    const size_t lower = lowerBound(timeAt(upper - 1));
+    return std::abs(time - timeAt(lower)) <= std::abs(timeAt(upper) - time) ? lower : upper;
+  }
+
+private:
+  size_t physical(const size_t i) const { return (head_ + i) % capacity(); }
+
+  std::vector<double> times_;
+  std::vector<T> data_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+#endif  // ESTIMATOR_UTILS__TIME_SERIES_BUFFER_HPP_
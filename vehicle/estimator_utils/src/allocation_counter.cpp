@@ -0,0 +1,201 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/allocation_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// the sanitizers replace the allocation functions themselves
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || \
+  __has_feature(memory_sanitizer)
+#define ESTIMATOR_UTILS_ALLOCATION_COUNTER_DISABLED
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define ESTIMATOR_UTILS_ALLOCATION_COUNTER_DISABLED
+#endif
+
+namespace
+{
+// constant initialized and trivially destructible, so that it is usable from any allocation
+thread_local allocation_counter::Counts thread_counts;
+
+#ifndef ESTIMATOR_UTILS_ALLOCATION_COUNTER_DISABLED
+void countAllocation(const bool allocated, const size_t size)
+{
+  if (allocated) {
+    thread_counts.allocations++;
+    thread_counts.bytes += size;
+  }
+}
+
+void countDeallocation(const void * ptr)
+{
+  if (ptr) {
+    thread_counts.deallocations++;
+  }
+}
+#endif
+}  // namespace
+
+namespace allocation_counter
+{
+bool isEnabled()
+{
+#ifdef ESTIMATOR_UTILS_ALLOCATION_COUNTER_DISABLED
+  return false;
+#else
+  return true;
+#endif
+}
+
+Counts getThreadCounts()
+{
+  return thread_counts;
+}
+}  // namespace allocation_counter
+
+#ifndef ESTIMATOR_UTILS_ALLOCATION_COUNTER_DISABLED
+
+#ifdef __GLIBC__
+// The C allocation functions of glibc are replaced by the ones of the executable, which count
+// and call the implementations of glibc. operator new of libstdc++ calls them, so the
+// allocations of the C++ and the C libraries are all counted once.
+extern "C" {
+void * __libc_malloc(size_t size) noexcept;
+void * __libc_calloc(size_t num, size_t size) noexcept;
+void * __libc_realloc(void * ptr, size_t size) noexcept;
+void * __libc_memalign(size_t alignment, size_t size) noexcept;
+void __libc_free(void * ptr) noexcept;
+
+void * malloc(size_t size) noexcept
+{
+  void * ptr = __libc_malloc(size);
+  countAllocation(ptr != nullptr, size);
+  return ptr;
+}
+
+void * calloc(size_t num, size_t size) noexcept
+{
+  void * ptr = __libc_calloc(num, size);
+  countAllocation(ptr != nullptr, num * size);
+  return ptr;
+}
+
+// a reallocation is counted as an allocation and a deallocation, even if it grows in place
+void * realloc(void * ptr, size_t size) noexcept
+{
+  void * new_ptr = __libc_realloc(ptr, size);
+  countDeallocation(ptr);
+  countAllocation(new_ptr != nullptr, size);
+  return new_ptr;
+}
+
+void * memalign(size_t alignment, size_t size) noexcept
+{
+  void * ptr = __libc_memalign(alignment, size);
+  countAllocation(ptr != nullptr, size);
+  return ptr;
+}
+
+void * aligned_alloc(size_t alignment, size_t size) noexcept
+{
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void ** ptr, size_t alignment, size_t size) noexcept
+{
+  if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+    return 22;  // EINVAL
+  }
+  *ptr = memalign(alignment, size);
+  return *ptr || size == 0 ? 0 : 12;  // ENOMEM
+}
+
+void free(void * ptr) noexcept
+{
+  countDeallocation(ptr);
+  __libc_free(ptr);
+}
+}  // extern "C"
+
+#else
+// Elsewhere only the allocations of operator new are counted
+
+void * operator new(size_t size)
+{
+  void * ptr = std::malloc(size == 0 ? 1 : size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  countAllocation(true, size);
+  return ptr;
+}
+
+void * operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept
+{
+  try {
+    return operator new(size);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+  return operator new(size, std::nothrow);
+}
+
+void operator delete(void * ptr) noexcept
+{
+  countDeallocation(ptr);
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+  operator delete(ptr);
+}
+
+void operator delete(void * ptr, size_t) noexcept
+{
+  operator delete(ptr);
+}
+
+void operator delete[](void * ptr, size_t) noexcept
+{
+  operator delete(ptr);
+}
+
+void operator delete(void * ptr, const std::nothrow_t &) noexcept
+{
+  operator delete(ptr);
+}
+
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept
+{
+  operator delete(ptr);
+}
+#endif  // __GLIBC__
+
+#endif  // ESTIMATOR_UTILS_ALLOCATION_COUNTER_DISABLED
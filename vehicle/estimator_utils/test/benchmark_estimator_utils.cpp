@@ -0,0 +1,193 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Benchmark of the kernels of the estimators over synthetic signals of 1k, 10k and 100k samples,
+// as a baseline to compare their optimizations against. It is not run by ctest:
+//   estimator_utils_benchmark [min_time_sec=0.2] [max_sample_num=100000]
+// Each kernel is repeated for at least min_time_sec, and its time per call and throughput in
+// samples per second are printed.
+
+#include "estimator_utils/math_utils.hpp"
+#include "estimator_utils/optimization_utils.hpp"
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace
+{
+// results of the kernels, so that they are not optimized out
+volatile double sink = 0;
+
+// a command and its response delayed by 12 samples, with noise
+struct Signals
+{
+  explicit Signals(const size_t n)
+  {
+    std::mt19937 engine(0);
+    std::normal_distribution<> noise(0.0, 0.02);
+    const size_t delay = 12;
+    std::vector<double> source(n + delay);
+    for (size_t i = 0; i < source.size(); i++) {
+      const double t = static_cast<double>(i) / 30.0;
+      source[i] = std::sin(0.7 * t) + 0.3 * std::sin(2.3 * t) + noise(engine);
+    }
+    for (size_t i = 0; i < n; i++) {
+      input.push_back(source[i + delay]);
+      response.push_back(source[i] + noise(engine));
+      response_dot.push_back(i == 0 ? 0.0 : (response[i] - response[i - 1]) * 30.0);
+      weights.push_back(static_cast<double>(n - i));
+    }
+  }
+  std::vector<double> input;
+  std::vector<double> response;
+  std::vector<double> response_dot;
+  std::vector<double> weights;
+};
+
+void run(
+  const char * kernel, const size_t n, const double min_time, const std::function<void()> & f)
+{
+  using Clock = std::chrono::steady_clock;
+  size_t calls = 0;
+  const auto start = Clock::now();
+  double elapsed = 0;
+  while (elapsed < min_time) {
+    f();
+    calls++;
+    elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  }
+  const double time_per_call = elapsed / static_cast<double>(calls);
+  std::printf(
+    "%-24s %8lu samples %10lu calls %14.2f[us/call] %10.2f[Msamples/s]\n", kernel, n, calls,
+    time_per_call * 1e6, static_cast<double>(n) / time_per_call * 1e-6);
+}
+
+void benchmark(const size_t n, const double min_time)
+{
+  const Signals s(n);
+  const double valid_delay_index_ratio = 0.1;
+
+  math_utils::CrossCorrelation workspace;
+  std::vector<double> corr;
+  run("cross_correlation", n, min_time, [&]() {
+    math_utils::calcCrossCorrelationCoefficient(
+      s.input, s.response, valid_delay_index_ratio, workspace, corr);
+    sink = corr.front();
+  });
+  run("weighted_cross_corr", n, min_time, [&]() {
+    math_utils::calcCrossCorrelationCoefficient(
+      s.input, s.response, s.weights, valid_delay_index_ratio, workspace, corr);
+    sink = corr.front();
+  });
+  run("cross_corr_window", n, min_time, [&]() {
+    workspace.calcInWindow(s.input, s.response, s.weights, valid_delay_index_ratio, 9, 15, corr);
+    sink = corr[12];
+  });
+
+  run("calc_mae", n, min_time, [&]() { sink = math_utils::calcMAE(s.input, s.response, 12); });
+
+  // the fits of one delay, by the matrices and by the shared Gram matrix of the delays
+  Eigen::VectorXd w;
+  run("least_squared_error", n, min_time, [&]() {
+    sink = optimization_utils::getLeastSquaredError(s.response_dot, s.response, s.input, w);
+  });
+  const optimization_utils::DelayedLeastSquared<2> least_squared(
+    {s.response_dot.data(), s.response.data()}, n);
+  run("delayed_least_squared", n, min_time, [&]() {
+    sink = least_squared.getLeastSquaredError(s.input.data(), w);
+  });
+
+  // one update per sample, by the scalar, the dynamic and the fixed size RLS
+  run("rls_scalar", n, min_time, [&]() {
+    double est = 0, cov = 1.0;
+    for (size_t i = 0; i < n; i++) {
+      optimization_utils::estimateByRLS(est, cov, s.response[i], 0.99, s.input[i]);
+    }
+    sink = est;
+  });
+  run("rls_dynamic", n, min_time, [&]() {
+    Eigen::MatrixXd est = Eigen::MatrixXd::Zero(2, 1);
+    Eigen::MatrixXd cov = Eigen::MatrixXd::Identity(2, 2);
+    Eigen::MatrixXd zn(2, 1);
+    Eigen::MatrixXd ff = Eigen::MatrixXd::Constant(1, 1, 0.99);
+    Eigen::MatrixXd y(1, 1);
+    for (size_t i = 0; i < n; i++) {
+      zn << s.response_dot[i], s.response[i];
+      y(0, 0) = s.input[i];
+      optimization_utils::estimateByRLS(est, cov, zn, ff, y);
+    }
+    sink = est(0, 0);
+  });
+  run("rls_fixed", n, min_time, [&]() {
+    Eigen::Matrix<double, 2, 1> est = Eigen::Matrix<double, 2, 1>::Zero();
+    Eigen::Matrix<double, 2, 2> cov = Eigen::Matrix<double, 2, 2>::Identity();
+    for (size_t i = 0; i < n; i++) {
+      const Eigen::Matrix<double, 2, 1> zn(s.response_dot[i], s.response[i]);
+      optimization_utils::estimateByRLS<2>(est, cov, zn, 0.99, s.input[i]);
+    }
+    sink = est(0);
+  });
+  // the three parameters of the gear ratio estimator: 1, v^2 and -|handle|
+  run("rls_fixed_gear_ratio", n, min_time, [&]() {
+    Eigen::Vector3d est = Eigen::Vector3d::Zero();
+    Eigen::Matrix3d cov = Eigen::Matrix3d::Identity() * 100;
+    for (size_t i = 0; i < n; i++) {
+      const Eigen::Vector3d zn(1.0, s.response[i] * s.response[i], -std::fabs(s.response_dot[i]));
+      optimization_utils::estimateByRLS<3>(est, cov, zn, 0.99, s.input[i]);
+    }
+    sink = est(0);
+  });
+
+  // the statistics of all the samples, and of a sliding window of a tenth of them
+  run("statistics", n, min_time, [&]() {
+    math_utils::Statistics stat(1);
+    for (size_t i = 0; i < n; i++) {
+      stat.value[0] = s.input[i];
+      math_utils::calcSequentialStddev(stat);
+    }
+    sink = stat.stddev[0];
+  });
+  run("streaming_statistics", n, min_time, [&]() {
+    math_utils::StreamingStatistics stat;
+    const size_t window = std::max<size_t>(n / 10, 1);
+    for (size_t i = 0; i < n; i++) {
+      stat.add(s.input[i], s.response[i]);
+      if (i >= window) {
+        stat.remove(s.input[i - window], s.response[i - window]);
+      }
+    }
+    sink = stat.correlation();
+  });
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const double min_time = argc > 1 ? std::atof(argv[1]) : 0.2;
+  const size_t max_sample_num = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+  for (size_t n = 1000; n <= max_sample_num; n *= 10) {
+    benchmark(n, min_time);
+  }
+  return 0;
+}
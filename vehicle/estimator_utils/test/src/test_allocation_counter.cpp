@@ -0,0 +1,120 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/allocation_counter.hpp"
+#include "estimator_utils/latest_value.hpp"
+#include "estimator_utils/math_utils.hpp"
+#include "estimator_utils/optimization_utils.hpp"
+#include "estimator_utils/time_series_buffer.hpp"
+
+#include <Eigen/Core>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr size_t warm_up = 10;
+constexpr size_t callback_num = 1000;
+}  // namespace
+
+TEST(allocation_counter, count)
+{
+  if (!allocation_counter::isEnabled()) {
+    GTEST_SKIP() << "the allocations are not counted in this build";
+  }
+
+  std::vector<double> kept;
+  const auto counts = allocation_counter::count([&kept]() { kept.resize(100); });
+  EXPECT_EQ(counts.allocations, 1u) << counts;
+  EXPECT_GE(counts.bytes, 100 * sizeof(double));
+
+  // the allocations of the other threads are not counted
+  std::thread thread([]() {
+    std::vector<double> other(100);
+    other[0] = 1.0;
+  });
+  const auto join_counts = allocation_counter::count([&thread]() { thread.join(); });
+  EXPECT_EQ(join_counts.allocations, 0u) << join_counts;
+}
+
+// The kernels called by the callbacks of the nodes do not allocate once their buffers are sized
+TEST(allocation_counter, steady_state)
+{
+  if (!allocation_counter::isEnabled()) {
+    GTEST_SKIP() << "the allocations are not counted in this build";
+  }
+
+  const size_t n = 300;
+  std::vector<double> input(n), response(n), weights(n);
+  for (size_t i = 0; i < n; i++) {
+    input[i] = std::sin(0.1 * static_cast<double>(i));
+    response[i] = std::sin(0.1 * static_cast<double>(i) - 0.5);
+    weights[i] = static_cast<double>(n - i);
+  }
+
+  math_utils::CrossCorrelation workspace;
+  std::vector<double> corr;
+  auto counts = allocation_counter::countSteadyState(
+    [&](const size_t) {
+      math_utils::calcCrossCorrelationCoefficient(input, response, weights, 0.1, workspace, corr);
+    },
+    warm_up, callback_num / 10);
+  EXPECT_EQ(counts.allocations, 0u) << "cross correlation: " << counts;
+
+  TimeSeriesBuffer<double> buffer(100);
+  counts = allocation_counter::countSteadyState(
+    [&buffer](const size_t i) { buffer.push(0.01 * static_cast<double>(i), 1.0); }, warm_up,
+    callback_num);
+  EXPECT_EQ(counts.allocations, 0u) << "time series buffer: " << counts;
+
+  math_utils::StreamingStatistics statistics;
+  counts = allocation_counter::countSteadyState(
+    [&](const size_t i) {
+      statistics.add(input[i % n], response[i % n]);
+      if (i >= 100) {
+        statistics.remove(input[(i - 100) % n], response[(i - 100) % n]);
+      }
+    },
+    warm_up, callback_num);
+  EXPECT_EQ(counts.allocations, 0u) << "streaming statistics: " << counts;
+
+  Eigen::Matrix<double, 2, 1> est = Eigen::Matrix<double, 2, 1>::Zero();
+  Eigen::Matrix<double, 2, 2> cov = Eigen::Matrix<double, 2, 2>::Identity();
+  counts = allocation_counter::countSteadyState(
+    [&](const size_t i) {
+      const Eigen::Matrix<double, 2, 1> zn(input[i % n], response[i % n]);
+      optimization_utils::estimateByRLS<2>(est, cov, zn, 0.99, weights[i % n]);
+    },
+    warm_up, callback_num);
+  EXPECT_EQ(counts.allocations, 0u) << "fixed size RLS: " << counts;
+
+  // the messages are allocated by the subscriptions, the slot only shares them
+  LatestValue<double> slot;
+  const auto msg = std::make_shared<const double>(1.0);
+  double sum = 0.0;
+  counts = allocation_counter::countSteadyState(
+    [&](const size_t) {
+      slot.store(msg);
+      sum += *slot.load();
+    },
+    warm_up, callback_num);
+  EXPECT_EQ(counts.allocations, 0u) << "latest value: " << counts;
+  EXPECT_DOUBLE_EQ(sum, static_cast<double>(warm_up + callback_num));
+}
@@ -0,0 +1,51 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/debug_array_publisher.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+namespace
+{
+struct ArrayMessage
+{
+  std::vector<float> data;
+};
+}  // namespace
+
+TEST(debug_array_publisher, reuse)
+{
+  PreallocatedArray<ArrayMessage> array(8);
+  ASSERT_GE(array.capacity(), 8u);
+  const float * allocation = array.message().data.data();
+
+  const std::array<double, 3> values{0.5, 1.5, 2.5};
+  const auto & message = array.assign(values);
+  ASSERT_EQ(message.data.size(), 3u);
+  EXPECT_FLOAT_EQ(message.data.at(2), 2.5f);
+
+  auto & cleared = array.clear();
+  EXPECT_TRUE(cleared.data.empty());
+  for (int i = 0; i < 8; i++) {
+    cleared.data.emplace_back(static_cast<float>(i));
+  }
+  // filled within the capacity without a reallocation
+  EXPECT_EQ(array.message().data.data(), allocation);
+  EXPECT_EQ(array.message().data.size(), 8u);
+}
@@ -0,0 +1,83 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/estimation_harness.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+// mean of the positive samples, without publishers
+class MeanEstimator : public EstimatorBase
+{
+public:
+  MeanEstimator()
+  {
+    result_statistics_ = math_utils::Statistics(1);
+    error_statistics_ = math_utils::Statistics(1);
+  }
+  void setData(const double v) { data_ = v; }
+  int published = 0;
+  std::vector<double> seen;
+
+private:
+  double data_ = 0;
+  bool estimate() { return true; }
+  void preprocessData() {}
+  bool checkIsValidData() { return data_ > 0.0; }
+  void postprocessOutput()
+  {
+    seen.push_back(data_);
+    result_statistics_.value = {data_};
+    error_statistics_.value = {0.0};
+  }
+  void publishData() { published++; }
+};
+}  // namespace
+
+TEST(estimation_harness, run)
+{
+  MeanEstimator all, odd;
+  EstimationHarness<double> harness(7);
+  harness.addEstimator(&all, [&all](const double v) { all.setData(v); });
+  harness.addEstimator(&odd, [&odd](const double v) {
+    odd.setData(static_cast<int>(v) % 2 == 1 ? v : 0.0);
+  });
+
+  int i = 0;
+  const size_t num_sample = harness.run([&i](double & v) {
+    if (i == 100) {
+      return false;
+    }
+    v = static_cast<double>(++i);
+    return true;
+  });
+
+  EXPECT_EQ(num_sample, 100u);
+  // every sample once, in order, and nothing is published
+  ASSERT_EQ(all.seen.size(), 100u);
+  for (size_t k = 0; k < all.seen.size(); k++) {
+    EXPECT_DOUBLE_EQ(all.seen[k], static_cast<double>(k + 1));
+  }
+  EXPECT_EQ(odd.seen.size(), 50u);
+  EXPECT_DOUBLE_EQ(all.result_msgs_.result.at(0), 100.0);
+  EXPECT_DOUBLE_EQ(odd.result_msgs_.result.at(0), 99.0);
+  // the statistics skip the first 51 estimations
+  EXPECT_DOUBLE_EQ(all.result_msgs_.result_mean.at(0), 76.0);
+  EXPECT_EQ(all.published, 0);
+}
@@ -0,0 +1,63 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/latest_value.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+TEST(latest_value, store_and_load)
+{
+  LatestValue<int> slot;
+  EXPECT_TRUE(slot.empty());
+
+  // the stored message is shared, not copied
+  const auto msg = std::make_shared<const int>(3);
+  slot.store(msg);
+  EXPECT_EQ(slot.load(), msg);
+
+  // a loaded message stays valid after the slot is updated
+  const auto loaded = slot.load();
+  slot.store(std::make_shared<const int>(4));
+  EXPECT_EQ(*loaded, 3);
+  EXPECT_EQ(*slot.load(), 4);
+
+  slot.reset();
+  EXPECT_TRUE(slot.empty());
+}
+
+TEST(latest_value, concurrent_store_and_load)
+{
+  LatestValue<int> slot;
+  slot.store(std::make_shared<const int>(0));
+  const int n = 10000;
+  std::thread writer([&slot]() {
+    for (int i = 1; i <= n; i++) {
+      slot.store(std::make_shared<const int>(i));
+    }
+  });
+
+  // the values are read in the order they are written
+  int previous = 0;
+  while (previous < n) {
+    const int value = *slot.load();
+    ASSERT_GE(value, previous);
+    previous = value;
+  }
+  writer.join();
+}
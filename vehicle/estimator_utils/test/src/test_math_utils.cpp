@@ -58,6 +58,32 @@ TEST(math_utils, getLinearInterpolation)
   ASSERT_THAT(output, ElementsAre(0, 1, 2, 3));
 }
 
+TEST(math_utils, getLinearInterpolationOfSpan)
+{
+  using math_utils::getLinearInterpolation;
+  using testing::ElementsAre;
+  const double input[] = {0, 3, 0};
+  double output[5] = {};
+  EXPECT_EQ(getLinearInterpolation({input, 3}, 2, {output, 5}), 5u);
+  ASSERT_THAT(output, ElementsAre(0, 1.5, 3, 1.5, 0));
+  EXPECT_EQ(getLinearInterpolation({input, 0}, 2, {output, 5}), 0u);
+}
+
+TEST(math_utils, getParabolicPeakIndex)
+{
+  using math_utils::getParabolicPeakIndex;
+  // samples of 1 - (i - 2.3)^2, whose peak is between the samples
+  std::vector<double> x;
+  for (int i = 0; i < 5; i++) {
+    x.push_back(1.0 - (i - 2.3) * (i - 2.3));
+  }
+  EXPECT_NEAR(getParabolicPeakIndex(x, 2), 2.3, 1e-12);
+  // the ends and the flat peaks are not moved
+  EXPECT_DOUBLE_EQ(getParabolicPeakIndex(x, 0), 0.0);
+  EXPECT_DOUBLE_EQ(getParabolicPeakIndex(x, 4), 4.0);
+  EXPECT_DOUBLE_EQ(getParabolicPeakIndex(std::vector<double>{1, 1, 1}, 1), 1.0);
+}
+
 TEST(math_utils, calcCrossCorrelationCoefficient)
 {
   using math_utils::calcCrossCorrelationCoefficient;
@@ -69,6 +95,74 @@ TEST(math_utils, calcCrossCorrelationCoefficient)
   EXPECT_EQ(delay_index, 1);
 }
 
+TEST(math_utils, calcCrossCorrelationCoefficientWithoutWeight)
+{
+  using math_utils::calcCrossCorrelationCoefficient;
+  std::vector<double> input = {1, 2, 3, 2, 1, 0, 1, 2};
+  std::vector<double> response = {0, 1, 2, 3, 2, 1, 0, 1};
+  math_utils::CrossCorrelation workspace;
+  std::vector<double> output = calcCrossCorrelationCoefficient(input, response, 0.5, workspace);
+  ASSERT_EQ(output.size(), 5u);
+  int delay_index = math_utils::getMaximumIndexFromVector(output);
+  EXPECT_EQ(delay_index, 1);
+  EXPECT_DOUBLE_EQ(output.back(), 0.0);
+
+  // the workspace is reused for the next signals
+  std::vector<double> reused = calcCrossCorrelationCoefficient(input, response, 0.5, workspace);
+  for (size_t i = 0; i < output.size(); i++) {
+    EXPECT_NEAR(output[i], reused[i], 1e-12);
+  }
+
+  // the coefficients are written to the buffer of the caller
+  std::vector<double> buffer(10, 1.0);
+  calcCrossCorrelationCoefficient(input, response, 0.5, workspace, buffer);
+  ASSERT_EQ(buffer.size(), output.size());
+  for (size_t i = 0; i < output.size(); i++) {
+    EXPECT_NEAR(output[i], buffer[i], 1e-12);
+  }
+  std::vector<double> weights = {1, 1, 1, 1, 1, 1, 1, 1};
+  std::vector<double> weighted = calcCrossCorrelationCoefficient(input, response, weights, 0.5);
+  calcCrossCorrelationCoefficient(input, response, weights, 0.5, workspace, buffer);
+  ASSERT_EQ(buffer.size(), weighted.size());
+  for (size_t i = 0; i < weighted.size(); i++) {
+    EXPECT_DOUBLE_EQ(weighted[i], buffer[i]);
+  }
+}
+
+TEST(math_utils, calcInWindow)
+{
+  std::vector<double> input, response, weights;
+  for (int i = 0; i < 60; i++) {
+    input.push_back(std::sin(0.2 * i) + 0.1 * std::cos(1.3 * i));
+    response.push_back(std::sin(0.2 * (i - 4)));
+    weights.push_back(60 - i);
+  }
+  math_utils::CrossCorrelation workspace;
+  const std::vector<double> full = workspace.calc(input, response, weights, 0.2);
+  std::vector<double> window;
+  workspace.calcInWindow(input, response, weights, 0.2, 2, 6, window);
+  ASSERT_EQ(window.size(), full.size());
+  for (size_t i = 0; i < full.size(); i++) {
+    if (2 <= i && i <= 6) {
+      EXPECT_NEAR(window[i], full[i], 1e-9);
+    } else {
+      EXPECT_DOUBLE_EQ(window[i], -1.0);
+    }
+  }
+  EXPECT_EQ(math_utils::getMaximumIndexFromVector(window), 4);
+}
+
+TEST(math_utils, decimate)
+{
+  using ::testing::ElementsAre;
+  std::vector<double> decimated;
+  // the oldest sample does not fill a block
+  math_utils::decimate(std::vector<double>{9, 1, 3, 5, 7}, 2, decimated);
+  ASSERT_THAT(decimated, ElementsAre(2, 6));
+  math_utils::decimate(std::vector<double>{1, 2}, 1, decimated);
+  ASSERT_THAT(decimated, ElementsAre(1, 2));
+}
+
 TEST(math_utils, Statistics)
 {
   using ::testing::ElementsAre;
@@ -82,6 +176,53 @@ TEST(math_utils, Statistics)
   }
 }
 
+TEST(math_utils, StreamingStatistics)
+{
+  std::vector<double> x, y, w;
+  for (int i = 0; i < 50; i++) {
+    x.push_back(std::sin(0.3 * i) + 100.0);
+    y.push_back(0.5 * x.back() + std::cos(0.7 * i));
+    w.push_back(1.0 + 0.1 * i);
+  }
+
+  // a sliding window of 20 samples
+  math_utils::StreamingStatistics window;
+  for (size_t i = 0; i < x.size(); i++) {
+    window.add(x[i], y[i]);
+    if (i >= 20) {
+      window.remove(x[i - 20], y[i - 20]);
+    }
+  }
+  const std::vector<double> last_x = {x.end() - 20, x.end()};
+  const std::vector<double> last_y = {y.end() - 20, y.end()};
+  EXPECT_EQ(window.count(), 20u);
+  EXPECT_NEAR(window.meanX(), math_utils::getAverageFromVector(last_x), 1e-9);
+  double squared_sum = 0;
+  for (const auto v : last_x) {
+    squared_sum += std::pow(v - math_utils::getAverageFromVector(last_x), 2);
+  }
+  EXPECT_NEAR(window.stddevX(), std::sqrt(squared_sum / 20.0), 1e-9);
+  EXPECT_NEAR(
+    window.correlation(), math_utils::getCorrelationCoefficientFromVector(last_x, last_y), 1e-9);
+
+  // merged halves, weighted
+  math_utils::StreamingStatistics all, first, second;
+  for (size_t i = 0; i < x.size(); i++) {
+    all.add(x[i], y[i], w[i]);
+    (i < 17 ? first : second).add(x[i], y[i], w[i]);
+  }
+  first.merge(second);
+  EXPECT_NEAR(first.meanX(), all.meanX(), 1e-9);
+  EXPECT_NEAR(first.varianceY(), all.varianceY(), 1e-9);
+  EXPECT_NEAR(first.covariance(), all.covariance(), 1e-9);
+  EXPECT_NEAR(first.meanX(), math_utils::getAverageFromVector(x, w), 1e-9);
+
+  window.remove(x.back(), y.back());
+  window.clear();
+  EXPECT_EQ(window.count(), 0u);
+  EXPECT_DOUBLE_EQ(window.stddevX(), 0.0);
+}
+
 TEST(math_utils, getAveragedVector)
 {
   using ::testing::ElementsAre;
@@ -100,6 +241,15 @@ TEST(math_utils, getAveragedVector2)
   ASSERT_THAT(result, avg);
 }
 
+TEST(math_utils, getAveragedVectorOfSpan)
+{
+  using ::testing::ElementsAre;
+  // the samples are averaged in place
+  std::vector<double> x = {1, 2, 3};
+  math_utils::getAveragedVector(x, x);
+  ASSERT_THAT(x, ElementsAre(-1, 0, 1));
+}
+
 TEST(math_utils, fitToTheSizeOfVector)
 {
   std::vector<double> input_stamp = {1, 2, 3, 4, 5, 5, 6, 10};
@@ -109,3 +259,19 @@ TEST(math_utils, fitToTheSizeOfVector)
   math_utils::fitToTheSizeOfVector(input_stamp, response_stamp, input, response, 5, 1);
   ASSERT_THAT(input, testing::ElementsAre(3, 4, 5, 5, 6));
 }
+
+TEST(math_utils, fitToTheSizeOfVectorOfSpan)
+{
+  const std::vector<double> input = {1, 2, 3, 4, 5, 5, 6, 7};
+  const math_utils::ConstSpan fit =
+    math_utils::fitToTheSizeOfVector(math_utils::ConstSpan(input), 5, 1);
+  EXPECT_EQ(fit.data(), input.data() + 2);
+  ASSERT_THAT(std::vector<double>(fit.begin(), fit.end()), testing::ElementsAre(3, 4, 5, 5, 6));
+  EXPECT_EQ(math_utils::fitToTheSizeOfVector(fit, 10, 0).size(), 5u);
+
+  // the template helpers read spans as vector like containers
+  const std::vector<double> response = {0, 1, 2, 3, 4, 5, 6, 7};
+  EXPECT_DOUBLE_EQ(
+    math_utils::calcMAE(math_utils::ConstSpan(input), math_utils::ConstSpan(response), 1),
+    math_utils::calcMAE(input, response, 1));
+}
@@ -24,7 +24,6 @@
 #include <gtest/gtest.h>
 
 #include <cassert>
-#include <chrono>
 #include <cmath>
 #include <deque>
 #include <numeric>
@@ -101,3 +100,110 @@ TEST(optimization_utils, getSecondaryCentralDifference)
   EXPECT_DOUBLE_EQ(xd, 2);
   EXPECT_DOUBLE_EQ(xdd, 0);
 }
+
+TEST(optimization_utils, DelayedLeastSquared)
+{
+  std::vector<double> x2dot, x_dot, x, u;
+  for (int i = 0; i < 40; i++) {
+    x2dot.push_back(std::cos(0.3 * i));
+    x_dot.push_back(std::sin(0.2 * i));
+    x.push_back(0.1 * i);
+    u.push_back(std::sin(0.1 * i) + 0.01 * i * i);
+  }
+  const size_t num_sample = 30;
+  const optimization_utils::DelayedLeastSquared<2> least_squared(
+    {x_dot.data() + x_dot.size() - num_sample, x.data() + x.size() - num_sample}, num_sample);
+  const optimization_utils::DelayedLeastSquared<3> least_squared2(
+    {x2dot.data() + x2dot.size() - num_sample, x_dot.data() + x_dot.size() - num_sample,
+     x.data() + x.size() - num_sample},
+    num_sample);
+  const std::vector<double> y2dot = {x2dot.end() - num_sample, x2dot.end()};
+  const std::vector<double> y_dot = {x_dot.end() - num_sample, x_dot.end()};
+  const std::vector<double> y = {x.end() - num_sample, x.end()};
+
+  // the same errors as the fits of the delayed copies
+  for (size_t d = 0; d < 10; d++) {
+    const std::vector<double> delayed = {u.end() - num_sample - d, u.end() - d};
+    Eigen::VectorXd w, expected_w;
+
+    double error = least_squared.getLeastSquaredError(delayed.data(), w);
+    double expected = optimization_utils::getLeastSquaredError(y_dot, y, delayed, expected_w);
+    EXPECT_NEAR(error, expected, 1e-9);
+    EXPECT_NEAR((w - expected_w).norm(), 0.0, 1e-9);
+
+    error = least_squared2.getLeastSquaredError(delayed.data(), w);
+    expected = optimization_utils::getLeastSquaredError(y2dot, y_dot, y, delayed, expected_w);
+    EXPECT_NEAR(error, expected, 1e-9);
+    EXPECT_NEAR((w - expected_w).norm(), 0.0, 1e-9);
+  }
+}
+
+TEST(optimization_utils, DelayedLeastSquaredFractionalDelay)
+{
+  std::vector<double> x_dot, x, u;
+  for (int i = 0; i < 40; i++) {
+    x_dot.push_back(std::sin(0.2 * i));
+    x.push_back(0.1 * i);
+    u.push_back(std::sin(0.1 * i) + 0.01 * i * i);
+  }
+  const size_t num_sample = 30;
+  const optimization_utils::DelayedLeastSquared<2> least_squared(
+    {x_dot.data() + x_dot.size() - num_sample, x.data() + x.size() - num_sample}, num_sample);
+
+  const double * y = u.data() + u.size() - num_sample - 3;
+  const double * y_next = y - 1;
+  Eigen::VectorXd w, expected_w;
+
+  // the ends of the interval are the integer delays
+  double error = least_squared.getLeastSquaredError(y, y_next, 0.0, w);
+  double expected = least_squared.getLeastSquaredError(y, expected_w);
+  EXPECT_NEAR(error, expected, 1e-12);
+  error = least_squared.getLeastSquaredError(y, y_next, 1.0, w);
+  expected = least_squared.getLeastSquaredError(y_next, expected_w);
+  EXPECT_NEAR(error, expected, 1e-12);
+
+  // the same as the fit of the interpolated copy
+  std::vector<double> interpolated;
+  for (size_t i = 0; i < num_sample; i++) {
+    interpolated.push_back(y[i] + 0.25 * (y_next[i] - y[i]));
+  }
+  error = least_squared.getLeastSquaredError(y, y_next, 0.25, w);
+  expected = least_squared.getLeastSquaredError(interpolated.data(), expected_w);
+  EXPECT_NEAR(error, expected, 1e-12);
+  EXPECT_NEAR((w - expected_w).norm(), 0.0, 1e-12);
+}
+
+TEST(optimization_utils, goldenSectionSearch)
+{
+  using optimization_utils::goldenSectionSearch;
+  const auto f = [](const double t) { return std::abs(t - 0.37) + 2.0; };
+  EXPECT_NEAR(goldenSectionSearch(f, -1.0, 1.0, 1e-6), 0.37, 1e-6);
+  // the minimum at an end of the interval
+  EXPECT_NEAR(goldenSectionSearch(f, 0.5, 1.0, 1e-6), 0.5, 1e-6);
+}
+
+TEST(optimization_utils, estimateByRLSFixedSize)
+{
+  const double ff = 0.99;
+  const Eigen::Matrix3d cov0 = (Eigen::Matrix3d::Identity() + 0.1 * Eigen::Matrix3d::Ones()) * 100;
+  Eigen::MatrixXd est = Eigen::MatrixXd::Zero(3, 1);
+  Eigen::MatrixXd cov = cov0;
+  const Eigen::MatrixXd ff_matrix = Eigen::MatrixXd::Identity(1, 1) * ff;
+  Eigen::Vector3d fixed_est = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d fixed_cov = cov0;
+
+  // y = 15.7 + 0.053 * v^2 - 0.042 * abs(handle)
+  for (int i = 0; i < 1000; i++) {
+    const double v = 0.01 * i;
+    const Eigen::Vector3d zn(1.0, v * v, -std::fabs(std::sin(0.05 * i)));
+    const double y = zn.dot(Eigen::Vector3d(15.7, 0.053, 0.042));
+    optimization_utils::estimateByRLS(est, cov, zn, ff_matrix, Eigen::MatrixXd::Constant(1, 1, y));
+    optimization_utils::estimateByRLS<3>(fixed_est, fixed_cov, zn, ff, y);
+    // the same as the dynamic size version
+    EXPECT_NEAR((fixed_est - est).norm(), 0.0, 1e-9);
+    EXPECT_NEAR((fixed_cov - fixed_cov.transpose()).norm(), 0.0, 1e-12);
+  }
+  EXPECT_NEAR(fixed_est(0), 15.7, 1e-3);
+  EXPECT_NEAR(fixed_est(1), 0.053, 1e-3);
+  EXPECT_NEAR(fixed_est(2), 0.042, 1e-3);
+}
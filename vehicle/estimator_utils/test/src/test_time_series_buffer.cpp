@@ -0,0 +1,71 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/time_series_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+TEST(time_series_buffer, push)
+{
+  TimeSeriesBuffer<int> buffer(3);
+  EXPECT_TRUE(buffer.empty());
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(buffer.push(0.1 * i, i));
+  }
+  ASSERT_EQ(buffer.size(), 3u);
+  EXPECT_TRUE(buffer.full());
+  // the oldest ones are dropped
+  EXPECT_EQ(buffer.at(0), 2);
+  EXPECT_EQ(buffer.back(), 4);
+  EXPECT_DOUBLE_EQ(buffer.timeAt(0), 0.2);
+
+  // an older time clears the buffer
+  EXPECT_FALSE(buffer.push(0.0, 5));
+  ASSERT_EQ(buffer.size(), 1u);
+  EXPECT_EQ(buffer.back(), 5);
+}
+
+TEST(time_series_buffer, nearestIndex)
+{
+  // the same as the linear search, which prefers the older one of equally near data
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> dt(0.0, 0.02);
+  std::uniform_int_distribution<int> same(0, 4);
+  TimeSeriesBuffer<double> buffer(64);
+  double time = 0.0;
+  for (int i = 0; i < 200; i++) {
+    time += same(gen) == 0 ? 0.0 : dt(gen);
+    buffer.push(time, time);
+
+    const double target = time - 0.2 * dt(gen) / 0.02;
+    size_t expected = 0;
+    double nearest = std::abs(target - buffer.timeAt(0));
+    for (size_t j = 1; j < buffer.size(); j++) {
+      if (std::abs(target - buffer.timeAt(j)) < nearest) {
+        nearest = std::abs(target - buffer.timeAt(j));
+        expected = j;
+      }
+    }
+    EXPECT_EQ(buffer.nearestIndex(target), expected);
+  }
+  EXPECT_EQ(buffer.lowerBound(time + 1.0), buffer.size());
+  EXPECT_EQ(buffer.nearestIndex(-1.0), 0u);
+}
@@ -48,9 +48,12 @@ private:
   std::unique_ptr<Debugger> debugger_;
   Eigen::MatrixXd estimated_;
   Eigen::MatrixXd covariance_;
-  Eigen::MatrixXd forgetting_factor_;
+  double forgetting_factor_;
   double error_;
   bool estimate();
+  // RLS with the regressors @zn of the model of N coefficients
+  template <int N>
+  bool updateEstimation(const Eigen::Matrix<double, N, 1> & zn, const double yn);
   bool checkIsValidData();
   void preprocessData() {}
   void postprocessOutput();
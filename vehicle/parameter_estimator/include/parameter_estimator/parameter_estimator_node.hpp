@@ -19,6 +19,7 @@
 
 #include "autoware_vehicle_info_utils/vehicle_info_utils.hpp"
 #include "estimator_utils/estimator_base.hpp"
+#include "estimator_utils/latest_value.hpp"
 #include "parameter_estimator/gear_ratio_estimator.hpp"
 #include "parameter_estimator/parameters.hpp"
 #include "parameter_estimator/steer_offset_estimator.hpp"
@@ -30,6 +31,7 @@
 #include "sensor_msgs/msg/imu.hpp"
 #include "tier4_calibration_msgs/msg/float32_stamped.hpp"
 
+#include <atomic>
 #include <memory>
 
 class ParameterEstimatorNode : public rclcpp::Node
@@ -41,16 +43,17 @@ private:
   rclcpp::Subscription<autoware_vehicle_msgs::msg::ControlModeReport>::SharedPtr
     sub_control_mode_report_;
   rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr sub_imu_;
+  rclcpp::CallbackGroup::SharedPtr callback_group_subscriptions_;
 
   // Timer
   rclcpp::TimerBase::SharedPtr timer_;
   void initTimer(double period_s);
 
-  geometry_msgs::msg::TwistStamped::ConstSharedPtr vehicle_twist_ptr_;
-  sensor_msgs::msg::Imu::ConstSharedPtr imu_ptr_;
-  tier4_calibration_msgs::msg::Float32Stamped::ConstSharedPtr steer_ptr_;
-  tier4_calibration_msgs::msg::Float32Stamped::ConstSharedPtr steer_wheel_ptr_;
-  autoware_vehicle_msgs::msg::ControlModeReport::ConstSharedPtr control_mode_ptr_;
+  // the latest messages, which the timer may read while the callbacks update them
+  LatestValue<geometry_msgs::msg::TwistStamped> vehicle_twist_ptr_;
+  LatestValue<sensor_msgs::msg::Imu> imu_ptr_;
+  LatestValue<tier4_calibration_msgs::msg::Float32Stamped> steer_ptr_;
+  LatestValue<tier4_calibration_msgs::msg::Float32Stamped> steer_wheel_ptr_;
 
   /**
    * ros parameters
@@ -66,7 +69,8 @@ private:
   bool select_wheel_base_estimator;
   bool invert_imu_z;
 
-  double auto_mode_duration_ = 0;
+  // written by the control mode callback, read by the timer
+  std::atomic<double> auto_mode_duration_{0};
   double last_manual_time_ = 0;
 
   std::unique_ptr<SteerOffsetEstimator> steer_offset_estimator_;
@@ -31,7 +31,7 @@ GearRatioEstimator::GearRatioEstimator(
   }
   covariance_ =
     (Eigen::MatrixXd::Identity(dim_x_, dim_x_) + 0.1 * Eigen::MatrixXd::Ones(dim_x_, dim_x_)) * cov;
-  forgetting_factor_ = Eigen::MatrixXd::Identity(1, 1) * ff;
+  forgetting_factor_ = ff;
   params_ = p;
   debugger_ = std::make_unique<Debugger>("gear_ratio", node);
   // in estimator_base.h
@@ -46,36 +46,33 @@ bool GearRatioEstimator::estimate()
   const auto & wheel_base = data_.wheel_base;
   const auto & wz = data_.angular_velocity;
   const auto & handle = data_.handle;
-  const auto & ff = forgetting_factor_;
-  auto & est = estimated_;
-  auto & cov = covariance_;
   // steering = handle / gear_ratio
   // gear_ratio=(a+b*v^2-c*abs(handle))
-  Eigen::MatrixXd zn = Eigen::MatrixXd::Zero(dim_x_, 1);
-  Eigen::MatrixXd yn = Eigen::MatrixXd::Zero(1, 1);
-  Eigen::MatrixXd th = Eigen::MatrixXd::Zero(dim_x_, 1);
-
+  const double yn = handle / std::atan2(wz * wheel_base, vel);
   if (dim_x_ == 3) {
-    yn(0, 0) = handle / std::atan2(wz * wheel_base, vel);
-    zn(0, 0) = 1.0;
-    zn(1, 0) = vel * vel;
-    zn(2, 0) = -std::fabs(handle);
+    return updateEstimation(Eigen::Vector3d(1.0, vel * vel, -std::fabs(handle)), yn);
   } else if (dim_x_ == 4) {
-    yn(0, 0) = handle / std::atan2(wz * wheel_base, vel);
-    zn(0, 0) = 1.0;
-    zn(1, 0) = vel;
-    zn(2, 0) = vel * vel;
-    zn(3, 0) = -std::fabs(handle);
+    return updateEstimation(Eigen::Vector4d(1.0, vel, vel * vel, -std::fabs(handle)), yn);
   }
-  optimization_utils::estimateByRLS(est, cov, zn, ff, yn);
-  error_ = (yn - zn.transpose() * est)(0, 0);
+  return false;
+}
+
+template <int N>
+bool GearRatioEstimator::updateEstimation(const Eigen::Matrix<double, N, 1> & zn, const double yn)
+{
+  // the fixed size views of the coefficients and the covariance
+  Eigen::Map<Eigen::Matrix<double, N, 1>> est(estimated_.data());
+  Eigen::Map<Eigen::Matrix<double, N, N>> cov(covariance_.data());
+  optimization_utils::estimateByRLS<N>(est, cov, zn, forgetting_factor_, yn);
+  const double gear = zn.dot(est);
+  error_ = yn - gear;
   auto & de = debugger_->debug_values_;
   {
-    th << 15.713, 0.053, 0.042;
-    double gear = (zn.transpose() * est)(0, 0);
+    const auto & vel = data_.velocity;
+    const auto & handle = data_.handle;
     de.data[0] = gear;
-    de.data[1] = yn(0, 0);
-    de.data[2] = (zn.transpose() * th)(0, 0);
+    de.data[1] = yn;
+    de.data[2] = 15.713 + 0.053 * vel * vel - 0.042 * std::fabs(handle);
   }
   // if (error > 1.0) return false;
   return true;
@@ -0,0 +1,333 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "autoware_vehicle_info_utils/vehicle_info_utils.hpp"
+#include "estimator_utils/estimation_harness.hpp"
+#include "parameter_estimator/gear_ratio_estimator.hpp"
+#include "parameter_estimator/parameters.hpp"
+#include "parameter_estimator/steer_offset_estimator.hpp"
+#include "parameter_estimator/wheel_base_estimator.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+
+#include "autoware_vehicle_msgs/msg/control_mode_report.hpp"
+#include "geometry_msgs/msg/twist_stamped.hpp"
+#include "sensor_msgs/msg/imu.hpp"
+#include "tier4_calibration_msgs/msg/float32_stamped.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+using ControlModeReport = autoware_vehicle_msgs::msg::ControlModeReport;
+using Float32Stamped = tier4_calibration_msgs::msg::Float32Stamped;
+
+// the parameters of ParameterEstimatorNode that select and gate the samples
+struct Context
+{
+  double update_hz;
+  bool use_auto_mode;
+  bool invert_imu_z;
+  bool select_gear_ratio_estimator;
+  bool select_steer_offset_estimator;
+  bool select_wheel_base_estimator;
+  double wheel_base;
+  std::string imu_topic;
+  std::string vehicle_twist_topic;
+  std::string steer_topic;
+  std::string handle_status_topic;
+  std::string control_mode_topic;
+};
+
+template <typename T>
+T deserialize(const rosbag2_storage::SerializedBagMessage & message)
+{
+  static const rclcpp::Serialization<T> serialization;
+  const rclcpp::SerializedMessage serialized(*message.serialized_data);
+  T msg;
+  serialization.deserialize_message(&serialized, &msg);
+  return msg;
+}
+
+/**
+ * The samples of timerCallback of ParameterEstimatorNode over bags, at the bag time. The bags
+ * are read one after another, and the latest messages are forgotten between two bags.
+ */
+class BagSampler
+{
+public:
+  BagSampler(const Context & context, const std::vector<std::string> & bag_paths)
+  : context_(context), bag_paths_(bag_paths)
+  {
+  }
+
+  // @return : false at the end of the last bag
+  bool next(VehicleData & v)
+  {
+    while (rclcpp::ok()) {
+      if (!pending_) {
+        if (!reader_ || !reader_->has_next()) {
+          if (!openNextBag()) {
+            return false;
+          }
+          continue;
+        }
+        pending_ = reader_->read_next();
+      }
+      // the timer fires before the pending message
+      const double t = static_cast<double>(pending_->time_stamp) * 1e-9;
+      const double tick = start_time_ + static_cast<double>(tick_num_) / context_.update_hz;
+      if (t < tick) {
+        handle(*pending_, t);
+        pending_.reset();
+        continue;
+      }
+      tick_num_++;
+      if (sample(v)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  bool openNextBag()
+  {
+    if (next_bag_ == bag_paths_.size()) {
+      return false;
+    }
+    const auto & path = bag_paths_[next_bag_++];
+    RCLCPP_INFO(rclcpp::get_logger("parameter_estimator"), "reading %s", path.c_str());
+    reader_ = std::make_unique<rosbag2_cpp::Reader>();
+    reader_->open(path);
+
+    rosbag2_storage::StorageFilter filter;
+    filter.topics = {
+      context_.imu_topic, context_.vehicle_twist_topic, context_.steer_topic,
+      context_.handle_status_topic, context_.control_mode_topic};
+    reader_->set_filter(filter);
+
+    start_time_ =
+      std::chrono::duration<double>(reader_->get_metadata().starting_time.time_since_epoch())
+        .count();
+    tick_num_ = 1;
+    has_twist_ = has_imu_ = has_steer_ = has_handle_ = false;
+    auto_mode_duration_ = 0;
+    last_manual_time_ = start_time_;
+    return true;
+  }
+
+  void handle(const rosbag2_storage::SerializedBagMessage & message, const double t)
+  {
+    const auto & topic = message.topic_name;
+    if (topic == context_.vehicle_twist_topic) {
+      velocity_ = deserialize<geometry_msgs::msg::TwistStamped>(message).twist.linear.x;
+      has_twist_ = true;
+    } else if (topic == context_.imu_topic) {
+      angular_velocity_ = deserialize<sensor_msgs::msg::Imu>(message).angular_velocity.z;
+      has_imu_ = true;
+    } else if (topic == context_.steer_topic) {
+      steer_ = deserialize<Float32Stamped>(message).data;
+      has_steer_ = true;
+    } else if (topic == context_.handle_status_topic) {
+      handle_ = deserialize<Float32Stamped>(message).data;
+      has_handle_ = true;
+    } else if (topic == context_.control_mode_topic) {
+      if (deserialize<ControlModeReport>(message).mode == ControlModeReport::AUTONOMOUS) {
+        auto_mode_duration_ = t - last_manual_time_;
+      } else {
+        auto_mode_duration_ = 0;
+        last_manual_time_ = t;
+      }
+    }
+  }
+
+  // the same conditions and data as timerCallback
+  bool sample(VehicleData & v) const
+  {
+    const bool use_steer =
+      context_.select_steer_offset_estimator || context_.select_wheel_base_estimator;
+    if (
+      !has_twist_ || (!has_steer_ && use_steer) ||
+      (!has_handle_ && context_.select_gear_ratio_estimator) || !has_imu_ ||
+      (auto_mode_duration_ < 0.5 && context_.use_auto_mode)) {
+      return false;
+    }
+    v = {};
+    v.velocity = velocity_;
+    v.angular_velocity = angular_velocity_ * (context_.invert_imu_z ? -1 : 1);
+    if (use_steer) {
+      v.steer = steer_;
+    }
+    if (context_.select_gear_ratio_estimator) {
+      v.handle = handle_;
+    }
+    v.wheel_base = context_.wheel_base;
+    return true;
+  }
+
+  const Context & context_;
+  const std::vector<std::string> & bag_paths_;
+  size_t next_bag_ = 0;
+  std::unique_ptr<rosbag2_cpp::Reader> reader_;
+  std::shared_ptr<rosbag2_storage::SerializedBagMessage> pending_;
+  double start_time_ = 0;
+  int64_t tick_num_ = 1;
+
+  // the latest messages
+  bool has_twist_ = false;
+  bool has_imu_ = false;
+  bool has_steer_ = false;
+  bool has_handle_ = false;
+  double velocity_ = 0;
+  double angular_velocity_ = 0;
+  double steer_ = 0;
+  double handle_ = 0;
+  double auto_mode_duration_ = 0;
+  double last_manual_time_ = 0;
+};
+
+void writeResult(std::ostream & os, const std::string & name, const EstimatorBase & estimator)
+{
+  const auto & r = estimator.result_msgs_;
+  for (size_t i = 0; i < r.result.size(); i++) {
+    os << name << "," << i << "," << r.result[i] << "," << r.result_mean[i] << ","
+       << r.result_stddev[i] << "," << r.mean_absolute_error.at(0) << "\n";
+  }
+}
+
+bool run(rclcpp::Node & node)
+{
+  const auto bag_paths =
+    node.declare_parameter<std::vector<std::string>>("bag_paths", std::vector<std::string>{});
+  const auto output_path =
+    node.declare_parameter<std::string>("batch/output_path", "parameter_estimation.csv");
+
+  Context context;
+  context.wheel_base =
+    autoware::vehicle_info_utils::VehicleInfoUtils(node).getVehicleInfo().wheel_base_m;
+  context.use_auto_mode = node.declare_parameter<bool>("use_auto_mode", true);
+  context.update_hz = node.declare_parameter<double>("update_hz", 10.0);
+  const double covariance = node.declare_parameter<double>("initial_covariance", 1.0);
+  const double forgetting_factor = node.declare_parameter<double>("forgetting_factor", 0.999);
+  context.select_gear_ratio_estimator =
+    node.declare_parameter<bool>("select_gear_ratio_estimator", true);
+  context.select_steer_offset_estimator =
+    node.declare_parameter<bool>("select_steer_offset_estimator", true);
+  context.select_wheel_base_estimator =
+    node.declare_parameter<bool>("select_wheel_base_estimator", true);
+  context.invert_imu_z = node.declare_parameter<bool>("invert_imu_z", true);
+  context.imu_topic = node.declare_parameter<std::string>("imu_topic", "/sensing/imu/imu_data");
+  context.vehicle_twist_topic = node.declare_parameter<std::string>(
+    "vehicle_twist_topic", "/calibration/vehicle/twist_status");
+  context.steer_topic = node.declare_parameter<std::string>(
+    "steer_topic", "/calibration/vehicle/steering_angle_status");
+  context.handle_status_topic = node.declare_parameter<std::string>(
+    "handle_status_topic", "/calibration/vehicle/handle_status");
+  context.control_mode_topic =
+    node.declare_parameter<std::string>("control_mode_topic", "/vehicle/status/control_mode");
+
+  Params params;
+  params.valid_max_steer_rad = node.declare_parameter<double>("valid_max_steer_rad", 0.05);
+  params.valid_min_velocity = node.declare_parameter<double>("valid_min_velocity", 0.5);
+  params.valid_min_angular_velocity =
+    node.declare_parameter<double>("valid_min_angular_velocity", 0.1);
+  params.is_showing_debug_info = false;
+  const auto estimated_gear_ratio =
+    node.declare_parameter<std::vector<double>>("gear_ratio", {15.7, 0.053, 0.047});
+
+  if (bag_paths.empty()) {
+    RCLCPP_ERROR(node.get_logger(), "bag_paths is empty.");
+    return false;
+  }
+  if (context.update_hz <= 0.0) {
+    RCLCPP_ERROR(node.get_logger(), "update_hz must be positive.");
+    return false;
+  }
+
+  SteerOffsetEstimator steer_offset_estimator(&node, params, covariance, forgetting_factor, 0);
+  WheelBaseEstimator wheel_base_estimator(
+    &node, params, covariance, forgetting_factor, context.wheel_base);
+  GearRatioEstimator gear_ratio_estimator(
+    &node, params, covariance, forgetting_factor, estimated_gear_ratio);
+
+  // the samples are decoded once for all the selected estimators
+  EstimationHarness<VehicleData> harness;
+  if (context.select_steer_offset_estimator) {
+    harness.addEstimator(&steer_offset_estimator, [&](const VehicleData & v) {
+      steer_offset_estimator.setData(v);
+    });
+  }
+  if (context.select_wheel_base_estimator) {
+    harness.addEstimator(
+      &wheel_base_estimator, [&](const VehicleData & v) { wheel_base_estimator.setData(v); });
+  }
+  if (context.select_gear_ratio_estimator) {
+    harness.addEstimator(
+      &gear_ratio_estimator, [&](const VehicleData & v) { gear_ratio_estimator.setData(v); });
+  }
+
+  BagSampler sampler(context, bag_paths);
+  size_t num_sample = 0;
+  try {
+    num_sample = harness.run([&sampler](VehicleData & v) { return sampler.next(v); });
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR(node.get_logger(), "failed to read the bags: %s", e.what());
+    return false;
+  }
+  RCLCPP_INFO(node.get_logger(), "estimated from %zu samples", num_sample);
+
+  std::ofstream ofs(output_path);
+  if (!ofs) {
+    RCLCPP_ERROR(node.get_logger(), "failed to open %s", output_path.c_str());
+    return false;
+  }
+  ofs << "estimator,index,result,result_mean,result_stddev,mean_absolute_error\n";
+  if (context.select_steer_offset_estimator) {
+    writeResult(ofs, "steer_offset", steer_offset_estimator);
+  }
+  if (context.select_wheel_base_estimator) {
+    writeResult(ofs, "wheel_base", wheel_base_estimator);
+  }
+  if (context.select_gear_ratio_estimator) {
+    writeResult(ofs, "gear_ratio", gear_ratio_estimator);
+  }
+  RCLCPP_INFO(node.get_logger(), "wrote %s", output_path.c_str());
+  return true;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+
+  // named like the live node, so that its parameter file applies as it is
+  auto node = std::make_shared<rclcpp::Node>("parameter_estimator");
+  const bool success = run(*node);
+
+  rclcpp::shutdown();
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -57,26 +57,33 @@ ParameterEstimatorNode::ParameterEstimatorNode(const rclcpp::NodeOptions & node_
   gear_ratio_estimator_ = std::make_unique<GearRatioEstimator>(
     this, params_, covariance_, forgetting_factor_, estimated_gear_ratio);
 
-  // subscriber
+  // subscriber, which only stores the latest messages and may run apart from the timer
+  callback_group_subscriptions_ =
+    create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+  rclcpp::SubscriptionOptions subscription_options;
+  subscription_options.callback_group = callback_group_subscriptions_;
   sub_imu_ = create_subscription<sensor_msgs::msg::Imu>(
-    "input/imu_twist", queue_size, std::bind(&ParameterEstimatorNode::callbackImu, this, _1));
+    "input/imu_twist", queue_size, std::bind(&ParameterEstimatorNode::callbackImu, this, _1),
+    subscription_options);
   sub_vehicle_twist_ = create_subscription<geometry_msgs::msg::TwistStamped>(
     "input/vehicle_twist", queue_size,
-    std::bind(&ParameterEstimatorNode::callbackVehicleTwist, this, _1));
+    std::bind(&ParameterEstimatorNode::callbackVehicleTwist, this, _1), subscription_options);
 
   if (select_gear_ratio_estimator) {
     sub_steer_wheel_ = create_subscription<tier4_calibration_msgs::msg::Float32Stamped>(
       "input/handle_status", queue_size,
-      std::bind(&ParameterEstimatorNode::callbackSteerWheel, this, _1));
+      std::bind(&ParameterEstimatorNode::callbackSteerWheel, this, _1), subscription_options);
   }
 
   if (select_steer_offset_estimator || select_wheel_base_estimator) {
     sub_steer_ = create_subscription<tier4_calibration_msgs::msg::Float32Stamped>(
-      "input/steer", queue_size, std::bind(&ParameterEstimatorNode::callbackSteer, this, _1));
+      "input/steer", queue_size, std::bind(&ParameterEstimatorNode::callbackSteer, this, _1),
+      subscription_options);
   }
   sub_control_mode_report_ = create_subscription<autoware_vehicle_msgs::msg::ControlModeReport>(
     "input/control_mode", queue_size,
-    std::bind(&ParameterEstimatorNode::callbackControlModeReport, this, _1));
+    std::bind(&ParameterEstimatorNode::callbackControlModeReport, this, _1),
+    subscription_options);
 
   initTimer(1.0 / update_hz_);
 }
@@ -96,19 +103,23 @@ void ParameterEstimatorNode::timerCallback()
 {
   auto & clk = *this->get_clock();
   const auto & is_debug = params_.is_showing_debug_info;
-  if (!vehicle_twist_ptr_) {
+  const auto vehicle_twist = vehicle_twist_ptr_.load();
+  const auto imu = imu_ptr_.load();
+  const auto steer = steer_ptr_.load();
+  const auto steer_wheel = steer_wheel_ptr_.load();
+  if (!vehicle_twist) {
     RCLCPP_INFO_EXPRESSION(
       rclcpp::get_logger("parameter_estimator"), is_debug, "vehicle_twist_ptr_ is null");
     return;
-  } else if (!steer_ptr_ && (select_steer_offset_estimator || select_wheel_base_estimator)) {
+  } else if (!steer && (select_steer_offset_estimator || select_wheel_base_estimator)) {
     RCLCPP_INFO_EXPRESSION(
       rclcpp::get_logger("parameter_estimator"), is_debug, "steer_ptr_ is null");
     return;
-  } else if (!steer_wheel_ptr_ && select_gear_ratio_estimator) {
+  } else if (!steer_wheel && select_gear_ratio_estimator) {
     RCLCPP_INFO_EXPRESSION(
       rclcpp::get_logger("parameter_estimator"), is_debug, "steer_wheel_ptr_ is null");
     return;
-  } else if (!imu_ptr_) {
+  } else if (!imu) {
     RCLCPP_INFO_EXPRESSION(rclcpp::get_logger("parameter_estimator"), is_debug, "imu_ptr_ is null");
     return;
   } else if (auto_mode_duration_ < 0.5 && use_auto_mode_) {
@@ -122,13 +133,13 @@ void ParameterEstimatorNode::timerCallback()
 
   {
     VehicleData v = {};
-    v.velocity = vehicle_twist_ptr_->twist.linear.x;
-    v.angular_velocity = imu_ptr_->angular_velocity.z * (invert_imu_z ? -1 : 1);
+    v.velocity = vehicle_twist->twist.linear.x;
+    v.angular_velocity = imu->angular_velocity.z * (invert_imu_z ? -1 : 1);
     if (select_steer_offset_estimator || select_wheel_base_estimator) {
-      v.steer = steer_ptr_->data;
+      v.steer = steer->data;
     }
     if (select_gear_ratio_estimator) {
-      v.handle = steer_wheel_ptr_->data;
+      v.handle = steer_wheel->data;
     }
     v.wheel_base = wheel_base_;
     if (select_steer_offset_estimator) {
@@ -152,36 +163,35 @@ void ParameterEstimatorNode::timerCallback()
 void ParameterEstimatorNode::callbackVehicleTwist(
   const geometry_msgs::msg::TwistStamped::ConstSharedPtr msg)
 {
-  vehicle_twist_ptr_ = msg;
+  vehicle_twist_ptr_.store(msg);
 }
 
 void ParameterEstimatorNode::callbackImu(const sensor_msgs::msg::Imu::ConstSharedPtr msg)
 {
-  imu_ptr_ = msg;
+  imu_ptr_.store(msg);
 }
 
 void ParameterEstimatorNode::callbackSteer(
   const tier4_calibration_msgs::msg::Float32Stamped::ConstSharedPtr msg)
 {
-  steer_ptr_ = msg;
+  steer_ptr_.store(msg);
 }
 
 void ParameterEstimatorNode::callbackSteerWheel(
   const tier4_calibration_msgs::msg::Float32Stamped::ConstSharedPtr msg)
 {
-  steer_wheel_ptr_ = msg;
+  steer_wheel_ptr_.store(msg);
 }
 
 void ParameterEstimatorNode::callbackControlModeReport(
   const autoware_vehicle_msgs::msg::ControlModeReport::ConstSharedPtr msg)
 {
   auto & clk = *this->get_clock();
-  control_mode_ptr_ = msg;
-  if (control_mode_ptr_->mode == autoware_vehicle_msgs::msg::ControlModeReport::AUTONOMOUS) {
+  if (msg->mode == autoware_vehicle_msgs::msg::ControlModeReport::AUTONOMOUS) {
     auto_mode_duration_ = (this->now().seconds() - last_manual_time_);
     RCLCPP_DEBUG_STREAM_THROTTLE(
       rclcpp::get_logger("parameter_estimator"), clk, 5000,
-      "[parameter_estimator] control mode duration: " << auto_mode_duration_);
+      "[parameter_estimator] control mode duration: " << auto_mode_duration_.load());
   } else {
     auto_mode_duration_ = 0;
     last_manual_time_ = this->now().seconds();
@@ -190,3 +200,7 @@ void ParameterEstimatorNode::callbackControlModeReport(
       "[parameter_estimator] control mode : manual");
   }
 }
+
+#include <rclcpp_components/register_node_macro.hpp>
+
+RCLCPP_COMPONENTS_REGISTER_NODE(ParameterEstimatorNode)
@@ -17,6 +17,7 @@
 #ifndef PITCH_CHECKER__PITCH_CHECKER_HPP_
 #define PITCH_CHECKER__PITCH_CHECKER_HPP_
 
+#include "pitch_checker/pitch_map.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "tf2/utils.h"
 
@@ -24,12 +25,8 @@
 #include "std_msgs/msg/bool.hpp"
 #include "std_srvs/srv/trigger.hpp"
 
-#include <fstream>
-#include <map>
 #include <memory>
 #include <string>
-#include <utility>
-#include <vector>
 #ifdef ROS_DISTRO_GALACTIC
 #include "tf2_geometry_msgs/tf2_geometry_msgs.h"
 #else
@@ -37,15 +34,6 @@
 #endif
 #include "autoware/universe_utils/ros/transform_listener.hpp"
 
-struct TfInfo
-{
-  double x;
-  double y;
-  double z;
-  double yaw;
-  double pitch;
-};
-
 class PitchChecker : public rclcpp::Node
 {
 public:
@@ -61,13 +49,10 @@ private:
   // Service
   rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr save_flag_server_;
 
-  std::vector<TfInfo> tf_info_vec_;
-  std::map<std::pair<int, int>, std::vector<TfInfo>> tf_map_;
-  std::map<std::pair<int, int>, std::vector<TfInfo>> tf_map_unified_;
+  // the pitch of the poses, accumulated online on a grid
+  PitchMap pitch_map_;
   std::string output_file_;
   double update_hz_;
-  int get_tf_count_ = 0;
-  static constexpr int MAX_TF_COUNT_ = 1e08;
 
   void timerCallback();
   bool onSaveService(
@@ -75,9 +60,7 @@ private:
     const std::shared_ptr<std_srvs::srv::Trigger::Request> req,
     const std::shared_ptr<std_srvs::srv::Trigger::Response> res);
   bool getTf();
-  void pitchInfoToMap();
   bool writeMap();
-  TfInfo getMedianPitchTfInfo(const std::vector<TfInfo> & tf_info_vec);
 };
 
 #endif  // PITCH_CHECKER__PITCH_CHECKER_HPP_
@@ -0,0 +1,100 @@
+//
+// Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PITCH_CHECKER__PITCH_MAP_HPP_
+#define PITCH_CHECKER__PITCH_MAP_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Pitch statistics on a 2D grid of the map frame, binned by the heading in each cell.
+ *
+ * The samples are accumulated online, so the memory grows with the driven area and not with the
+ * driving time, and is bounded by max_cell_num. Maps of the same resolution and yaw_bin_num can be
+ * merged, e.g. the maps of many vehicles into a fleet map.
+ */
+class PitchMap
+{
+public:
+  struct Bin
+  {
+    size_t count = 0;
+    double pitch_mean = 0.0;
+    // sum of the squared deviations of the pitch
+    double pitch_m2 = 0.0;
+    double z_mean = 0.0;
+    // sum of the heading vectors, for the circular mean of the yaw
+    double yaw_cos = 0.0;
+    double yaw_sin = 0.0;
+
+    void add(const double z, const double yaw, const double pitch);
+    void merge(const Bin & other);
+    double yaw() const;
+    double pitchStddev() const;
+  };
+
+  explicit PitchMap(
+    const double resolution = 1.0, const int yaw_bin_num = 4, const size_t max_cell_num = 1000000);
+
+  // @return : false if the sample is dropped, as its cell is new and the map is full
+  bool add(const double x, const double y, const double z, const double yaw, const double pitch);
+  // @return : false if some cells of other are dropped, as the map is full
+  bool merge(const PitchMap & other);
+  void clear();
+  size_t size() const { return cells_.size(); }
+  bool isFull() const { return cells_.size() >= max_cell_num_; }
+
+  // one line per bin with samples: x, y, z, yaw, pitch, pitch_stddev, count
+  bool writeCSV(const std::string & csv_path) const;
+  // merges the bins of a file written by writeCSV, the ones of new cells are dropped if the map
+  // is full
+  bool readCSV(const std::string & csv_path);
+
+private:
+  struct Cell
+  {
+    int64_t x, y;
+    bool operator==(const Cell & other) const { return x == other.x && y == other.y; }
+    bool operator<(const Cell & other) const
+    {
+      return x < other.x || (x == other.x && y < other.y);
+    }
+  };
+  struct CellHash
+  {
+    size_t operator()(const Cell & c) const
+    {
+      return (static_cast<size_t>(c.x) * 73856093) ^ (static_cast<size_t>(c.y) * 19349663);
+    }
+  };
+
+  double resolution_;
+  int yaw_bin_num_;
+  size_t max_cell_num_;
+  // yaw_bin_num_ bins per cell
+  std::unordered_map<Cell, std::vector<Bin>, CellHash> cells_;
+
+  Cell toCell(const double x, const double y) const;
+  int toYawBin(const double yaw) const;
+  // @return : nullptr if the cell is new and the map is full
+  std::vector<Bin> * findOrAddCell(const Cell & cell);
+};
+
+#endif  // PITCH_CHECKER__PITCH_MAP_HPP_
@@ -18,12 +18,14 @@
 #define PITCH_CHECKER__PITCH_READER_HPP_
 
 #include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 struct TfInfo
@@ -35,19 +37,58 @@ struct TfInfo
   double pitch;
 };
 
+// the pitch of the poses of a file against the reference, as the reference minus the file
+struct PitchComparison
+{
+  bool is_read = false;
+  size_t pose_num = 0;
+  // the poses found in the reference
+  size_t matched_num = 0;
+  // the median and the standard deviation of the differences
+  double bias = 0.0;
+  double stddev = 0.0;
+  // the differences further than outlier_thresh from the bias
+  size_t outlier_num = 0;
+};
+
 class PitchReader
 {
 public:
   explicit PitchReader(const std::string input_file);
   bool getPitch(
     double * pitch, const double x, const double y, const double yaw,
-    const double dist_thresh = 10.0, const double yaw_thresh = M_PI_4);
-  std::vector<double> comparePitch(const std::string comp_input_file);
+    const double dist_thresh = 10.0, const double yaw_thresh = M_PI_4) const;
+  std::vector<double> comparePitch(const std::string comp_input_file) const;
+  // the file is compared in the calling thread, so that many files are compared in parallel
+  PitchComparison summarizePitch(
+    const std::string comp_input_file, const double outlier_thresh) const;
+  bool isRead() const { return read_csv_; }
 
 private:
+  // cells of a 2D grid over tf_infos_, of the default dist_thresh in size
+  struct Cell
+  {
+    int64_t x, y;
+    bool operator==(const Cell & other) const { return x == other.x && y == other.y; }
+  };
+  struct CellHash
+  {
+    size_t operator()(const Cell & c) const
+    {
+      return (static_cast<size_t>(c.x) * 73856093) ^ (static_cast<size_t>(c.y) * 19349663);
+    }
+  };
+  static constexpr double cell_size_ = 10.0;
+
   std::vector<TfInfo> tf_infos_;
-  bool readCSV(const std::string csv_path, std::vector<TfInfo> * tf_infos);
-  std::vector<std::string> split(const std::string & s, char delim);
+  // the indices of tf_infos_ in each cell, in the order of the yaw
+  std::unordered_map<Cell, std::vector<size_t>, CellHash> grid_;
+  void buildGrid();
+  Cell toCell(const double x, const double y) const;
+  std::vector<double> findDifferences(
+    const std::vector<TfInfo> & comp_tf_infos, const size_t thread_num) const;
+  static bool readCSV(
+    const std::string csv_path, std::vector<TfInfo> * tf_infos, const size_t thread_num);
   bool read_csv_ = false;
 };
 
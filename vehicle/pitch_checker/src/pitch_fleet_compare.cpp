@@ -0,0 +1,105 @@
+//
+// Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "pitch_checker/pitch_reader.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compares the pitch logs of many vehicles against a reference pitch map, e.g. the merged map of
+// the fleet, and writes the bias and the outliers of each vehicle.
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  auto node = std::make_shared<rclcpp::Node>("pitch_fleet_compare");
+  const auto logger = node->get_logger();
+
+  const auto reference_file = node->declare_parameter<std::string>("reference_file", "pitch.csv");
+  const auto input_files =
+    node->declare_parameter<std::vector<std::string>>("input_files", std::vector<std::string>{});
+  const auto output_file =
+    node->declare_parameter<std::string>("output_file", "pitch_comparison.csv");
+  // [rad] the differences further than this from the bias of the vehicle are outliers
+  const double outlier_threshold = node->declare_parameter<double>("outlier_threshold", 0.01);
+  const int thread_num = node->declare_parameter<int>("thread_num", 0);
+
+  if (input_files.empty()) {
+    RCLCPP_ERROR(logger, "input_files is empty.");
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  // the reference is indexed once, and shared by the threads comparing a file each
+  const PitchReader reference(reference_file);
+  if (!reference.isRead()) {
+    RCLCPP_ERROR_STREAM(logger, "cannot open the file: " << reference_file);
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  const size_t num_thread = std::min<size_t>(
+    thread_num > 0 ? static_cast<size_t>(thread_num)
+                   : std::max(std::thread::hardware_concurrency(), 1u),
+    input_files.size());
+  std::vector<PitchComparison> comparisons(input_files.size());
+  std::atomic<size_t> next_file(0);
+
+  auto worker = [&]() {
+    for (size_t i = next_file++; i < input_files.size(); i = next_file++) {
+      comparisons[i] = reference.summarizePitch(input_files[i], outlier_threshold);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_thread; i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  std::ofstream ofs(output_file);
+  if (!ofs.is_open()) {
+    RCLCPP_ERROR_STREAM(logger, "cannot open the file: " << output_file);
+    rclcpp::shutdown();
+    return 1;
+  }
+  ofs << "file,pose_num,matched_num,bias,stddev,outlier_num" << std::endl;
+  for (size_t i = 0; i < input_files.size(); i++) {
+    const auto & c = comparisons[i];
+    if (!c.is_read) {
+      RCLCPP_WARN_STREAM(logger, "cannot open the file: " << input_files[i]);
+      continue;
+    }
+    if (c.matched_num == 0) {
+      RCLCPP_WARN_STREAM(logger, "no pose of " << input_files[i] << " is in the reference");
+    }
+    ofs << input_files[i] << "," << c.pose_num << "," << c.matched_num << "," << c.bias << ","
+        << c.stddev << "," << c.outlier_num << std::endl;
+  }
+
+  RCLCPP_INFO_STREAM(
+    logger, "Compared " << input_files.size() << " files with " << reference_file << " on "
+                        << output_file);
+  rclcpp::shutdown();
+  return 0;
+}
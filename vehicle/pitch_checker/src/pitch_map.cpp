@@ -0,0 +1,203 @@
+//
+// Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "pitch_checker/pitch_map.hpp"
+
+#include <autoware/csv_utils/csv_reader.hpp>
+#include <autoware/csv_utils/csv_writer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+void PitchMap::Bin::add(const double z, const double yaw, const double pitch)
+{
+  // Welford's update
+  count++;
+  const double delta = pitch - pitch_mean;
+  pitch_mean += delta / static_cast<double>(count);
+  pitch_m2 += delta * (pitch - pitch_mean);
+  z_mean += (z - z_mean) / static_cast<double>(count);
+  yaw_cos += std::cos(yaw);
+  yaw_sin += std::sin(yaw);
+}
+
+void PitchMap::Bin::merge(const Bin & other)
+{
+  if (other.count == 0) {
+    return;
+  }
+  if (count == 0) {
+    *this = other;
+    return;
+  }
+  // Chan's parallel update
+  const double n_a = static_cast<double>(count);
+  const double n_b = static_cast<double>(other.count);
+  const double n = n_a + n_b;
+  const double delta = other.pitch_mean - pitch_mean;
+  pitch_mean += delta * n_b / n;
+  pitch_m2 += other.pitch_m2 + delta * delta * n_a * n_b / n;
+  z_mean += (other.z_mean - z_mean) * n_b / n;
+  yaw_cos += other.yaw_cos;
+  yaw_sin += other.yaw_sin;
+  count += other.count;
+}
+
+double PitchMap::Bin::yaw() const { return std::atan2(yaw_sin, yaw_cos); }
+
+double PitchMap::Bin::pitchStddev() const
+{
+  return count == 0 ? 0.0 : std::sqrt(pitch_m2 / static_cast<double>(count));
+}
+
+PitchMap::PitchMap(const double resolution, const int yaw_bin_num, const size_t max_cell_num)
+: resolution_(resolution), yaw_bin_num_(std::max(yaw_bin_num, 1)), max_cell_num_(max_cell_num)
+{
+}
+
+PitchMap::Cell PitchMap::toCell(const double x, const double y) const
+{
+  return Cell{
+    static_cast<int64_t>(std::nearbyint(x / resolution_)),
+    static_cast<int64_t>(std::nearbyint(y / resolution_))};
+}
+
+int PitchMap::toYawBin(const double yaw) const
+{
+  const double normalized = std::atan2(std::sin(yaw), std::cos(yaw)) + M_PI;
+  const int bin = static_cast<int>(normalized / (2.0 * M_PI) * yaw_bin_num_);
+  return std::min(std::max(bin, 0), yaw_bin_num_ - 1);
+}
+
+std::vector<PitchMap::Bin> * PitchMap::findOrAddCell(const Cell & cell)
+{
+  const auto it = cells_.find(cell);
+  if (it != cells_.end()) {
+    return &it->second;
+  }
+  if (isFull()) {
+    return nullptr;
+  }
+  return &cells_.emplace(cell, std::vector<Bin>(yaw_bin_num_)).first->second;
+}
+
+bool PitchMap::add(
+  const double x, const double y, const double z, const double yaw, const double pitch)
+{
+  auto * bins = findOrAddCell(toCell(x, y));
+  if (!bins) {
+    return false;
+  }
+  bins->at(toYawBin(yaw)).add(z, yaw, pitch);
+  return true;
+}
+
+bool PitchMap::merge(const PitchMap & other)
+{
+  bool merged_all = true;
+  for (const auto & cell : other.cells_) {
+    auto * bins = findOrAddCell(cell.first);
+    if (!bins) {
+      merged_all = false;
+      continue;
+    }
+    for (int i = 0; i < yaw_bin_num_ && i < static_cast<int>(cell.second.size()); i++) {
+      bins->at(i).merge(cell.second.at(i));
+    }
+  }
+  return merged_all;
+}
+
+void PitchMap::clear() { cells_.clear(); }
+
+bool PitchMap::writeCSV(const std::string & csv_path) const
+{
+  autoware::csv_utils::CsvWriter writer(csv_path);
+  if (!writer.isOpen()) {
+    return false;
+  }
+
+  // in the order of the cells, as the map is written the same regardless of the hashing
+  std::vector<const std::pair<const Cell, std::vector<Bin>> *> sorted_cells;
+  sorted_cells.reserve(cells_.size());
+  for (const auto & cell : cells_) {
+    sorted_cells.push_back(&cell);
+  }
+  std::sort(sorted_cells.begin(), sorted_cells.end(), [](const auto * a, const auto * b) {
+    return a->first < b->first;
+  });
+
+  // enough digits for the cells of the map coordinates to be read back
+  writer.writeLine("x,y,z,yaw,pitch,pitch_stddev,count");
+  autoware::csv_utils::CsvLine line(12);
+  for (const auto * cell : sorted_cells) {
+    const double x = static_cast<double>(cell->first.x) * resolution_;
+    const double y = static_cast<double>(cell->first.y) * resolution_;
+    for (const auto & bin : cell->second) {
+      if (bin.count == 0) {
+        continue;
+      }
+      line.clear();
+      line.add(x).add(y).add(bin.z_mean).add(bin.yaw()).add(bin.pitch_mean);
+      line.add(bin.pitchStddev()).add(bin.count);
+      writer.writeLine(line);
+    }
+  }
+  return writer.close();
+}
+
+bool PitchMap::readCSV(const std::string & csv_path)
+{
+  const autoware::csv_utils::CsvReader reader(csv_path);
+  if (!reader.isOpen()) {
+    return false;
+  }
+
+  // the rows are merged in the order of the file, as the bins are sums
+  reader.forEachRow([this](const autoware::csv_utils::CsvRow & row) {
+    double values[7];
+    for (size_t i = 0; i < 7; i++) {
+      const auto value = row.get<double>(i);
+      if (!value) {
+        return;
+      }
+      values[i] = *value;
+    }
+    if (values[6] < 1.0) {
+      return;
+    }
+
+    const double x = values[0];
+    const double y = values[1];
+    const double yaw = values[3];
+    const double stddev = values[5];
+    Bin bin;
+    bin.count = static_cast<size_t>(values[6]);
+    bin.pitch_mean = values[4];
+    bin.pitch_m2 = stddev * stddev * static_cast<double>(bin.count);
+    bin.z_mean = values[2];
+    bin.yaw_cos = std::cos(yaw) * static_cast<double>(bin.count);
+    bin.yaw_sin = std::sin(yaw) * static_cast<double>(bin.count);
+
+    auto * bins = findOrAddCell(toCell(x, y));
+    if (bins) {
+      bins->at(toYawBin(yaw)).merge(bin);
+    }
+  });
+  return true;
+}
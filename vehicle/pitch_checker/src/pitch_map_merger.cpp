@@ -0,0 +1,99 @@
+//
+// Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "pitch_checker/pitch_map.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Merges the pitch maps saved by pitch_checker, e.g. of many vehicles, into one map.
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  auto node = std::make_shared<rclcpp::Node>("pitch_map_merger");
+  const auto logger = node->get_logger();
+
+  const auto input_files =
+    node->declare_parameter<std::vector<std::string>>("input_files", std::vector<std::string>{});
+  const auto output_file = node->declare_parameter<std::string>("output_file", "pitch.csv");
+  // the same as the ones the input maps are saved with
+  const double resolution = node->declare_parameter<double>("map_resolution", 1.0);
+  const int yaw_bin_num = node->declare_parameter<int>("yaw_bin_num", 4);
+  const size_t max_cell_num =
+    static_cast<size_t>(node->declare_parameter<int>("max_cell_num", 1000000));
+  const int thread_num = node->declare_parameter<int>("thread_num", 0);
+
+  if (input_files.empty()) {
+    RCLCPP_ERROR(logger, "input_files is empty.");
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  // each thread reads the files into its own map, and the maps are merged at the end
+  const size_t num_thread = std::min<size_t>(
+    thread_num > 0 ? static_cast<size_t>(thread_num)
+                   : std::max(std::thread::hardware_concurrency(), 1u),
+    input_files.size());
+  std::vector<PitchMap> partial_maps(
+    num_thread, PitchMap(resolution, yaw_bin_num, max_cell_num));
+  std::vector<char> success(input_files.size(), false);
+  std::atomic<size_t> next_file(0);
+
+  auto worker = [&](const size_t thread_index) {
+    for (size_t i = next_file++; i < input_files.size(); i = next_file++) {
+      success[i] = partial_maps[thread_index].readCSV(input_files[i]);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_thread; i++) {
+    threads.emplace_back(worker, i);
+  }
+  worker(0);
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  for (size_t i = 0; i < input_files.size(); i++) {
+    if (!success[i]) {
+      RCLCPP_WARN_STREAM(logger, "cannot open the file: " << input_files[i]);
+    }
+  }
+
+  auto & pitch_map = partial_maps.front();
+  for (size_t i = 1; i < partial_maps.size(); i++) {
+    pitch_map.merge(partial_maps[i]);
+  }
+  if (pitch_map.isFull()) {
+    RCLCPP_WARN(logger, "the merged map is full, some cells may be dropped.");
+  }
+
+  int ret = 0;
+  if (pitch_map.writeCSV(output_file)) {
+    RCLCPP_INFO_STREAM(
+      logger, "Merged " << input_files.size() << " maps into " << pitch_map.size()
+                        << " cells on " << output_file);
+  } else {
+    RCLCPP_ERROR_STREAM(logger, "cannot open the file: " << output_file);
+    ret = 1;
+  }
+  rclcpp::shutdown();
+  return ret;
+}
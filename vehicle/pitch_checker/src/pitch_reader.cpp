@@ -14,93 +14,211 @@
 // limitations under the License.
 //
 
-// cSpell:ignore strvec
-
 #include "pitch_checker/pitch_reader.hpp"
 
+#include <autoware/csv_utils/csv_reader.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <limits>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 PitchReader::PitchReader(const std::string input_file)
 {
-  read_csv_ = (readCSV(input_file, &tf_infos_));
+  read_csv_ = (readCSV(input_file, &tf_infos_, 0));
+  buildGrid();
+}
+
+void PitchReader::buildGrid()
+{
+  for (size_t i = 0; i < tf_infos_.size(); i++) {
+    grid_[toCell(tf_infos_[i].x, tf_infos_[i].y)].push_back(i);
+  }
+  for (auto & cell : grid_) {
+    auto & indices = cell.second;
+    std::stable_sort(indices.begin(), indices.end(), [this](const size_t a, const size_t b) {
+      return tf_infos_[a].yaw < tf_infos_[b].yaw;
+    });
+  }
+}
+
+PitchReader::Cell PitchReader::toCell(const double x, const double y) const
+{
+  return Cell{
+    static_cast<int64_t>(std::floor(x / cell_size_)),
+    static_cast<int64_t>(std::floor(y / cell_size_))};
 }
 
 bool PitchReader::getPitch(
   double * pitch, const double x, const double y, const double yaw, const double dist_thresh,
-  const double yaw_thresh)
+  const double yaw_thresh) const
 {
   if (!read_csv_) {
     return false;
   }
 
+  // the nearest pose within dist_thresh and yaw_thresh, the first one in tf_infos_ of the
+  // nearest ones as the linear search
   double min_dist = std::numeric_limits<double>::max();
-  bool success_search = false;
-  for (const auto & tf_info : tf_infos_) {
-    const double dist = std::hypot(x - tf_info.x, y - tf_info.y);
-    if (dist < dist_thresh && dist < min_dist && std::fabs(yaw - tf_info.yaw) < yaw_thresh) {
-      min_dist = dist;
-      *pitch = tf_info.pitch;
-      success_search = true;
+  size_t min_index = std::numeric_limits<size_t>::max();
+  const auto center = toCell(x, y);
+  constexpr double yaw_margin = 1e-9;
+  const auto reach = static_cast<int64_t>(std::ceil(dist_thresh / cell_size_));
+  for (int64_t dx = -reach; dx <= reach; dx++) {
+    for (int64_t dy = -reach; dy <= reach; dy++) {
+      const auto it = grid_.find(Cell{center.x + dx, center.y + dy});
+      if (it == grid_.end()) {
+        continue;
+      }
+      const auto & indices = it->second;
+      // the poses of the cell within the yaw window, with a margin against the rounding
+      auto begin = std::lower_bound(
+        indices.begin(), indices.end(), yaw - yaw_thresh - yaw_margin,
+        [this](const size_t i, const double v) { return tf_infos_[i].yaw < v; });
+      for (auto i = begin;
+           i != indices.end() && tf_infos_[*i].yaw <= yaw + yaw_thresh + yaw_margin; i++) {
+        const auto & tf_info = tf_infos_[*i];
+        const double dist = std::hypot(x - tf_info.x, y - tf_info.y);
+        if (
+          dist < dist_thresh && (dist < min_dist || (dist == min_dist && *i < min_index)) &&
+          std::fabs(yaw - tf_info.yaw) < yaw_thresh) {
+          min_dist = dist;
+          min_index = *i;
+        }
+      }
     }
   }
-  return success_search;
+  if (min_index == std::numeric_limits<size_t>::max()) {
+    return false;
+  }
+  *pitch = tf_infos_[min_index].pitch;
+  return true;
 }
 
-std::vector<double> PitchReader::comparePitch(const std::string comp_input_file)
+std::vector<double> PitchReader::comparePitch(const std::string comp_input_file) const
 {
-  std::vector<double> pitches;
   std::vector<TfInfo> comp_tf_infos;
-  if (!readCSV(comp_input_file, &comp_tf_infos)) {
-    return pitches;
+  if (!readCSV(comp_input_file, &comp_tf_infos, 0)) {
+    return {};
+  }
+  const size_t thread_num = std::max<size_t>(
+    std::min<size_t>(std::thread::hardware_concurrency(), comp_tf_infos.size() / 1000), 1);
+  return findDifferences(comp_tf_infos, thread_num);
+}
+
+PitchComparison PitchReader::summarizePitch(
+  const std::string comp_input_file, const double outlier_thresh) const
+{
+  PitchComparison comparison;
+  std::vector<TfInfo> comp_tf_infos;
+  comparison.is_read = readCSV(comp_input_file, &comp_tf_infos, 1);
+  comparison.pose_num = comp_tf_infos.size();
+  auto differences = findDifferences(comp_tf_infos, 1);
+  comparison.matched_num = differences.size();
+  if (differences.empty()) {
+    return comparison;
+  }
+
+  // the median is the bias, so that the outliers do not shift it
+  const auto middle = differences.begin() + differences.size() / 2;
+  std::nth_element(differences.begin(), middle, differences.end());
+  comparison.bias = *middle;
+  if (differences.size() % 2 == 0) {
+    comparison.bias = (comparison.bias + *std::max_element(differences.begin(), middle)) / 2.0;
   }
 
-  for (const auto & tf_info : comp_tf_infos) {
-    double pitch;
-    if (getPitch(&pitch, tf_info.x, tf_info.y, tf_info.yaw)) {
-      pitches.emplace_back(pitch - tf_info.pitch);
+  double sum = 0.0;
+  double squared_sum = 0.0;
+  for (const double difference : differences) {
+    sum += difference;
+    squared_sum += difference * difference;
+    if (std::fabs(difference - comparison.bias) > outlier_thresh) {
+      comparison.outlier_num++;
     }
   }
-  return pitches;
+  const double n = static_cast<double>(differences.size());
+  const double mean = sum / n;
+  comparison.stddev = std::sqrt(std::max(squared_sum / n - mean * mean, 0.0));
+  return comparison;
 }
 
-bool PitchReader::readCSV(const std::string csv_path, std::vector<TfInfo> * tf_infos)
+std::vector<double> PitchReader::findDifferences(
+  const std::vector<TfInfo> & comp_tf_infos, const size_t thread_num) const
 {
-  std::vector<std::vector<std::string>> result;
-  std::ifstream ifs(csv_path);
-  if (!ifs.is_open()) {
-    return false;
-  }
+  // the entries are looked up in parallel, and the differences are kept in their order
+  std::vector<double> differences(comp_tf_infos.size());
+  std::vector<char> found(comp_tf_infos.size(), false);
+  std::atomic<size_t> next_block(0);
+  constexpr size_t block_size = 256;
 
-  std::string line;
-  while (std::getline(ifs, line)) {
-    std::vector<std::string> strvec = split(line, ',');
-    result.emplace_back(strvec);
+  auto worker = [&]() {
+    for (size_t b = next_block++ * block_size; b < comp_tf_infos.size();
+         b = next_block++ * block_size) {
+      for (size_t i = b; i < std::min(b + block_size, comp_tf_infos.size()); i++) {
+        const auto & tf_info = comp_tf_infos[i];
+        double pitch;
+        if (getPitch(&pitch, tf_info.x, tf_info.y, tf_info.yaw)) {
+          differences[i] = pitch - tf_info.pitch;
+          found[i] = true;
+        }
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_num; i++) {
+    threads.emplace_back(worker);
   }
-
-  for (size_t i = 1; i < result.size(); i++) {
-    TfInfo tf_info;
-    tf_info.x = std::stod(result.at(i).at(0));
-    tf_info.y = std::stod(result.at(i).at(1));
-    tf_info.z = std::stod(result.at(i).at(2));
-    tf_info.yaw = std::stod(result.at(i).at(3));
-    tf_info.pitch = std::stod(result.at(i).at(4));
-    tf_infos->emplace_back(tf_info);
+  worker();
+  for (auto & t : threads) {
+    t.join();
   }
 
-  return true;
+  std::vector<double> pitches;
+  for (size_t i = 0; i < comp_tf_infos.size(); i++) {
+    if (found[i]) {
+      pitches.emplace_back(differences[i]);
+    }
+  }
+  return pitches;
 }
 
-std::vector<std::string> PitchReader::split(const std::string & original, char delim)
+// The header line is skipped, and the first five values of the other lines are x, y, z, yaw and
+// pitch. The file is memory mapped and its values are parsed in place by @thread_num threads, 0
+// for one per core.
+bool PitchReader::readCSV(
+  const std::string csv_path, std::vector<TfInfo> * tf_infos, const size_t thread_num)
 {
-  std::vector<std::string> elems;
-  std::stringstream sstr(original);
-  std::string elem;
-  while (getline(sstr, elem, delim)) {
-    if (!elem.empty()) {
-      elems.push_back(elem);
-    }
+  const autoware::csv_utils::CsvReader reader(csv_path);
+  if (!reader.isOpen()) {
+    return false;
   }
-  return elems;
+
+  const auto rows = reader.parseRows<TfInfo>(
+    [](const autoware::csv_utils::CsvRow & row) -> std::optional<TfInfo> {
+      double values[5];
+      size_t num_value = 0;
+      // empty fields are skipped, as they were by the split of the lines
+      for (size_t i = 0; i < row.size() && num_value < 5; i++) {
+        if (row[i].empty()) {
+          continue;
+        }
+        const auto value = row.get<double>(i);
+        if (!value) {
+          return std::nullopt;
+        }
+        values[num_value++] = *value;
+      }
+      if (num_value < 5) {
+        return std::nullopt;
+      }
+      return TfInfo{values[0], values[1], values[2], values[3], values[4]};
+    },
+    thread_num);
+  tf_infos->insert(tf_infos->end(), rows.begin(), rows.end());
+
+  return true;
 }
@@ -21,6 +21,7 @@
 #include "estimator_utils/optimization_utils.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "time_delay_estimator/parameters.hpp"
+#include "time_delay_estimator/ring_buffer.hpp"
 
 #include "std_msgs/msg/float32_multi_array.hpp"
 #include "std_msgs/msg/float64_multi_array.hpp"
@@ -35,14 +36,31 @@
 struct Data
 {
   Data() : value{0.0}, p_value{0.0} {}
+  /**
+   * @param capacity : number of samples of stamps, raw and filtered
+   * @param validation_capacity : number of samples of validation
+   * @param num_interpolation : interpolated points per sample of processed
+   **/
+  Data(const size_t capacity, const size_t validation_capacity, const int num_interpolation)
+  : value{0.0},
+    p_value{0.0},
+    stamps(capacity),
+    validation(validation_capacity),
+    raw(capacity),
+    filtered(capacity),
+    processed(capacity, num_interpolation)
+  {
+  }
   double value;
   double p_value = 0;
   double stamp = 0;
-  std::deque<double> stamps = {};
-  std::deque<double> validation = {};
-  std::deque<double> raw = {};
-  std::deque<double> filtered = {};
-  std::vector<double> processed;
+  RingBuffer stamps;
+  RingBuffer validation;
+  // of the samples of validation
+  math_utils::StreamingStatistics validation_statistics;
+  RingBuffer raw;
+  RingBuffer filtered;
+  InterpolatedRingBuffer processed;
 
   void setValue(const double val, const double time)
   {
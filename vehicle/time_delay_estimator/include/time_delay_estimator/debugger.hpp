@@ -18,11 +18,13 @@
 #define TIME_DELAY_ESTIMATOR__DEBUGGER_HPP_
 
 // ros depend
+#include "estimator_utils/debug_array_publisher.hpp"
 #include "rclcpp/rclcpp.hpp"
 
 #include "std_msgs/msg/float32_multi_array.hpp"
 #include "std_msgs/msg/float64_multi_array.hpp"
 
+#include <memory>
 #include <string>
 // ros pkg depend
 #include "time_delay_estimator/parameters.hpp"
@@ -30,7 +32,8 @@
 class Debugger
 {
 public:
-  Debugger(rclcpp::Node * node, const std::string & name)
+  // capacity : size of the arrays of the input, response, estimated and correlation
+  Debugger(rclcpp::Node * node, const std::string & name, const size_t capacity)
   {
     // QoS setup
     static constexpr std::size_t queue_size = 1;
@@ -39,23 +42,25 @@ public:
 
     pub_debug_ = node->create_publisher<std_msgs::msg::Float32MultiArray>(
       "~/debug_values/" + name, durable_qos);
-    pub_debug_input_ = node->create_publisher<std_msgs::msg::Float32MultiArray>(
-      "~/debug_values/" + name + "_input", durable_qos);
-    pub_debug_response_ = node->create_publisher<std_msgs::msg::Float32MultiArray>(
-      "~/debug_values/" + name + "_response", durable_qos);
-    pub_debug_estimated_ = node->create_publisher<std_msgs::msg::Float32MultiArray>(
-      "~/debug_values/" + name + "_estimated", durable_qos);
-    pub_debug_corr_ = node->create_publisher<std_msgs::msg::Float64MultiArray>(
-      "~/debug_values/" + name + "_correlation", durable_qos);
+    // the arrays are allocated once here and reused for every publication
+    pub_debug_input_ = std::make_unique<DebugArrayPublisher<std_msgs::msg::Float32MultiArray>>(
+      node, "~/debug_values/" + name + "_input", capacity, durable_qos);
+    pub_debug_response_ = std::make_unique<DebugArrayPublisher<std_msgs::msg::Float32MultiArray>>(
+      node, "~/debug_values/" + name + "_response", capacity, durable_qos);
+    pub_debug_estimated_ =
+      std::make_unique<DebugArrayPublisher<std_msgs::msg::Float32MultiArray>>(
+        node, "~/debug_values/" + name + "_estimated", capacity, durable_qos);
+    pub_debug_corr_ = std::make_unique<DebugArrayPublisher<std_msgs::msg::Float64MultiArray>>(
+      node, "~/debug_values/" + name + "_correlation", capacity, durable_qos);
     debug_values_.data.resize(num_debug_values_, 0.0);
   }
 
   /* Debug */
   rclcpp::Publisher<std_msgs::msg::Float32MultiArray>::SharedPtr pub_debug_;
-  rclcpp::Publisher<std_msgs::msg::Float32MultiArray>::SharedPtr pub_debug_input_;
-  rclcpp::Publisher<std_msgs::msg::Float32MultiArray>::SharedPtr pub_debug_response_;
-  rclcpp::Publisher<std_msgs::msg::Float32MultiArray>::SharedPtr pub_debug_estimated_;
-  rclcpp::Publisher<std_msgs::msg::Float64MultiArray>::SharedPtr pub_debug_corr_;
+  std::unique_ptr<DebugArrayPublisher<std_msgs::msg::Float32MultiArray>> pub_debug_input_;
+  std::unique_ptr<DebugArrayPublisher<std_msgs::msg::Float32MultiArray>> pub_debug_response_;
+  std::unique_ptr<DebugArrayPublisher<std_msgs::msg::Float32MultiArray>> pub_debug_estimated_;
+  std::unique_ptr<DebugArrayPublisher<std_msgs::msg::Float64MultiArray>> pub_debug_corr_;
 
   /**
    * @brief : for rqt_multiplot
@@ -20,6 +20,7 @@
 #include "estimator_utils/math_utils.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "time_delay_estimator/data_processor.hpp"
+#include "time_delay_estimator/parallel_estimation.hpp"
 #include "time_delay_estimator/parameters.hpp"
 #include "time_delay_estimator/time_delay_estimator.hpp"
 
@@ -36,12 +37,13 @@
 #include <cmath>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
 
-class TimeDelayEstimatorNode : public rclcpp::Node
+class GeneralTimeDelayEstimatorNode : public rclcpp::Node
 {
   using Float32Stamped = tier4_calibration_msgs::msg::Float32Stamped;
   using ControlModeReport = autoware_vehicle_msgs::msg::ControlModeReport;
@@ -50,30 +52,42 @@ class TimeDelayEstimatorNode : public rclcpp::Node
   using TimeDelay = tier4_calibration_msgs::msg::TimeDelay;
 
 private:
-  // output delay
-  rclcpp::Publisher<TimeDelay>::SharedPtr pub_time_delay_;
+  // command and status signals whose delay is estimated
+  struct Channel
+  {
+    std::string name;
+    // saturation
+    MinMax valid_input;
+    double input_offset;
+    // output delay
+    rclcpp::Publisher<TimeDelay>::SharedPtr pub_time_delay;
+    // response subscription
+    rclcpp::Subscription<Float32Stamped>::SharedPtr sub_input_cmd;
+    rclcpp::Subscription<Float32Stamped>::SharedPtr sub_input_status;
+    Float32Stamped::ConstSharedPtr input_cmd_ptr;
+    Float32Stamped::ConstSharedPtr input_status_ptr;
+    // samples of the subscriptions, resampled on the grid of sampling_hz by the collector
+    StampedRingBuffer cmd_samples;
+    StampedRingBuffer status_samples;
+    bool has_grid = false;
+    double grid_stamp = 0;
+    std::unique_ptr<TimeDelayEstimator> collected_data;
+  };
 
   // input subscription
   rclcpp::Subscription<autoware_vehicle_msgs::msg::ControlModeReport>::SharedPtr
     sub_control_mode_report_;
-
-  // response subscription
-  rclcpp::Subscription<Float32Stamped>::SharedPtr sub_input_cmd_;
-  rclcpp::Subscription<Float32Stamped>::SharedPtr sub_input_status_;
   rclcpp::Subscription<BoolStamped>::SharedPtr sub_is_engaged_;
 
   // Timer
   rclcpp::TimerBase::SharedPtr timer_estimation_;
   rclcpp::TimerBase::SharedPtr timer_data_processing_;
 
-  Float32Stamped::ConstSharedPtr input_cmd_ptr_;
-  Float32Stamped::ConstSharedPtr input_status_ptr_;
   ControlModeReport::ConstSharedPtr control_mode_ptr_;
   std::string estimator_type_;
-  std::string data_name_;
 
-  void callbackInputCmd(const Float32Stamped::ConstSharedPtr msg);
-  void callbackInputStatus(const Float32Stamped::ConstSharedPtr msg);
+  void callbackInputCmd(Channel & channel, const Float32Stamped::ConstSharedPtr msg);
+  void callbackInputStatus(Channel & channel, const Float32Stamped::ConstSharedPtr msg);
   void callbackControlModeReport(const ControlModeReport::ConstSharedPtr msg);
   void callbackVehicleEngage(const ControlModeReport::ConstSharedPtr msg);
   void callbackEngage(const IsEngaged::ConstSharedPtr msg);
@@ -85,21 +99,34 @@ private:
   double engage_duration_;
   bool detect_manual_engage_;
   bool engage_mode_ = false;
-  // saturation
-  MinMax valid_input_;
-  double input_offset_;
 
-  std::unique_ptr<TimeDelayEstimator> collected_data_;
+  std::vector<std::unique_ptr<Channel>> channels_;
+  // the workers of the channels, nullptr unless parallel_estimation
+  std::unique_ptr<ParallelEstimation> parallel_estimation_;
   // for ros parameters
   Params params_;
 
+  /**
+   * @brief : add a channel
+   * @param name : name of the data
+   * @param prefix : prefix of the parameters and the topics of the channel
+   * @param use_weight_for_cross_correlation : weight decay
+   **/
+  void addChannel(
+    const std::string & name, const std::string & prefix,
+    const bool use_weight_for_cross_correlation);
+
+  // lock the data of a channel against its worker, if any
+  std::unique_lock<std::mutex> lockData(const size_t channel);
+
   void timerCallback();
+  // resample the samples of the channels up to the newest stamp of both of their signals
   void timerDataCollector();
   bool estimateTimeDelay();
 
 public:
-  explicit TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_options);
-  ~TimeDelayEstimatorNode() {}
+  explicit GeneralTimeDelayEstimatorNode(const rclcpp::NodeOptions & node_options);
+  ~GeneralTimeDelayEstimatorNode() {}
 };
 
 #endif  // TIME_DELAY_ESTIMATOR__GENERAL_TIME_DELAY_ESTIMATOR_NODE_HPP_
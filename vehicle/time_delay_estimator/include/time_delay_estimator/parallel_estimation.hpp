@@ -0,0 +1,95 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef TIME_DELAY_ESTIMATOR__PARALLEL_ESTIMATION_HPP_
+#define TIME_DELAY_ESTIMATOR__PARALLEL_ESTIMATION_HPP_
+
+#include "rclcpp/rclcpp.hpp"
+#include "time_delay_estimator/time_delay_estimator.hpp"
+
+#include "tier4_calibration_msgs/msg/time_delay.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief : estimate the time delays of several channels in parallel, one worker per channel
+ *
+ * The result of a channel is published by its worker as soon as it is estimated, unless the
+ * deadline of the estimation has passed. A channel that is still running at the next estimation
+ * is skipped. The data of a channel must be locked with dataMutex() while they are collected.
+ **/
+class ParallelEstimation
+{
+  using TimeDelay = tier4_calibration_msgs::msg::TimeDelay;
+
+public:
+  /**
+   * @param estimator_type : "cc", "ls" or "ls2"
+   * @param deadline : time to wait for the channels from the start of an estimation [s]
+   **/
+  ParallelEstimation(
+    rclcpp::Node * node, const std::string & estimator_type, const double deadline);
+  ~ParallelEstimation();
+
+  /**
+   * @brief : add a channel, before the first estimation
+   * @return : index of the channel
+   **/
+  size_t addChannel(
+    const std::string & name, TimeDelayEstimator * estimator,
+    const rclcpp::Publisher<TimeDelay>::SharedPtr & publisher);
+
+  std::mutex & dataMutex(const size_t channel) { return channels_.at(channel)->data_mutex; }
+
+  /**
+   * @brief : start the channels that are ready and wait until they finish or the deadline passes
+   * @param ready : whether each channel has its data
+   **/
+  void estimate(const std::vector<bool> & ready);
+
+private:
+  struct Channel
+  {
+    std::string name;
+    TimeDelayEstimator * estimator;
+    rclcpp::Publisher<TimeDelay>::SharedPtr publisher;
+    std::mutex data_mutex;
+    std::thread thread;
+    bool requested = false;
+    bool busy = false;
+  };
+
+  void work(Channel & channel);
+
+  rclcpp::Node * node_;
+  std::string estimator_type_;
+  std::chrono::steady_clock::duration deadline_duration_;
+  std::vector<std::unique_ptr<Channel>> channels_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_start_;
+  std::condition_variable cv_done_;
+  std::chrono::steady_clock::time_point deadline_;
+  bool stop_ = false;
+};
+
+#endif  // TIME_DELAY_ESTIMATOR__PARALLEL_ESTIMATION_HPP_
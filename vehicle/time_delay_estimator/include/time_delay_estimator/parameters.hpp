@@ -36,6 +36,9 @@ struct Params
   bool is_showing_debug_info;
   bool use_interpolation;
   int num_interpolation;
+  int cross_correlation_search_width;
+  int cross_correlation_full_scan_period;
+  int cross_correlation_decimation;
   int estimation_method;
   bool is_test_mode;
 };
@@ -0,0 +1,201 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef TIME_DELAY_ESTIMATOR__RING_BUFFER_HPP_
+#define TIME_DELAY_ESTIMATOR__RING_BUFFER_HPP_
+
+#include "estimator_utils/math_utils.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief : fixed capacity FIFO of samples, linear from the oldest to the newest sample
+ *
+ * Every sample is stored at its slot and at its slot + capacity, so the samples are always a
+ * contiguous range of the storage and are handed to the estimators without copies. A push to a
+ * full buffer drops the oldest sample.
+ **/
+class RingBuffer
+{
+public:
+  explicit RingBuffer(const size_t capacity = 0) : storage_(2 * capacity), capacity_(capacity) {}
+
+  void push_back(const double value)
+  {
+    if (capacity_ == 0) {
+      throw std::length_error("push_back to a ring buffer without capacity");
+    }
+    if (size_ == capacity_) {
+      pop_front();
+    }
+    const size_t slot = (head_ + size_) % capacity_;
+    storage_[slot] = value;
+    storage_[slot + capacity_] = value;
+    size_++;
+  }
+
+  void pop_front()
+  {
+    if (size_ == 0) {
+      throw std::out_of_range("pop_front from an empty ring buffer");
+    }
+    head_ = (head_ + 1) % capacity_;
+    size_--;
+    popped_++;
+  }
+
+  void clear()
+  {
+    popped_ += size_;
+    head_ = 0;
+    size_ = 0;
+  }
+
+  const double * data() const { return storage_.data() + head_; }
+  const double * begin() const { return data(); }
+  const double * end() const { return data() + size_; }
+  double operator[](const size_t i) const { return data()[i]; }
+  double front() const { return data()[0]; }
+  double back() const { return data()[size_ - 1]; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return capacity_; }
+  // number of samples popped so far, i.e. the index of the front sample among all the pushed ones
+  size_t frontIndex() const { return popped_; }
+
+private:
+  std::vector<double> storage_;
+  size_t capacity_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  size_t popped_ = 0;
+};
+
+/**
+ * @brief : math_utils::getLinearInterpolation of the samples of a source buffer
+ *
+ * update() interpolates the samples pushed to the source and drops the samples popped from it
+ * since the last update, instead of interpolating all the samples again.
+ **/
+class InterpolatedRingBuffer : public RingBuffer
+{
+public:
+  /**
+   * @param source_capacity : capacity of the source buffer
+   * @param max_num_interpolation : largest num_interpolation of update
+   **/
+  explicit InterpolatedRingBuffer(
+    const size_t source_capacity = 0, const int max_num_interpolation = 1)
+  : RingBuffer(
+      source_capacity == 0
+        ? 0
+        : (source_capacity - 1) * static_cast<size_t>(std::max(max_num_interpolation, 1)) + 1)
+  {
+  }
+
+  void update(const RingBuffer & source, const int num_interpolation)
+  {
+    const size_t num_interp = static_cast<size_t>(std::max(num_interpolation, 1));
+    const size_t begin = source.frontIndex();
+    const size_t end = begin + source.size();
+    if (num_interp != num_interp_ || begin < begin_ || end_ < begin) {
+      clear();
+      num_interp_ = num_interp;
+      begin_ = begin;
+      end_ = begin;
+    }
+
+    // the first sample of m samples has num_interp points, unless it is the last one
+    for (; begin_ < begin; begin_++) {
+      const size_t num_points = end_ - begin_ == 1 ? 1 : num_interp;
+      for (size_t j = 0; j < num_points; j++) {
+        pop_front();
+      }
+    }
+
+    for (; end_ < end; end_++) {
+      const double b = source[end_ - begin];
+      if (!empty()) {
+        const double a = back();
+        for (size_t j = 1; j < num_interp; j++) {
+          push_back(math_utils::interpolate(a, b, j / static_cast<double>(num_interp)));
+        }
+      }
+      push_back(b);
+    }
+  }
+
+private:
+  // the interpolated samples of the source are [begin_, end_)
+  size_t begin_ = 0;
+  size_t end_ = 0;
+  size_t num_interp_ = 1;
+};
+
+/**
+ * @brief : timestamped samples of a signal, for resampling at increasing stamps
+ *
+ * interpolate() drops the samples before the two around its stamp, so resampling a signal on a
+ * grid of increasing stamps visits each sample once.
+ **/
+class StampedRingBuffer
+{
+public:
+  explicit StampedRingBuffer(const size_t capacity = 0) : stamps(capacity), values(capacity) {}
+
+  // a sample older than the newest one is dropped
+  void push_back(const double stamp, const double value)
+  {
+    if (!stamps.empty() && stamp < stamps.back()) {
+      return;
+    }
+    stamps.push_back(stamp);
+    values.push_back(value);
+  }
+
+  void clear()
+  {
+    stamps.clear();
+    values.clear();
+  }
+
+  bool empty() const { return stamps.empty(); }
+
+  // linear interpolation at stamp, the nearest sample outside of the stamps of the samples
+  double interpolate(const double stamp)
+  {
+    if (empty()) {
+      throw std::out_of_range("interpolate an empty stamped ring buffer");
+    }
+    while (stamps.size() > 1 && stamps[1] <= stamp) {
+      stamps.pop_front();
+      values.pop_front();
+    }
+    if (stamps.size() == 1 || stamp <= stamps[0]) {
+      return values[0];
+    }
+    const double ratio = (stamp - stamps[0]) / (stamps[1] - stamps[0]);
+    return math_utils::interpolate(values[0], values[1], ratio);
+  }
+
+  RingBuffer stamps;
+  RingBuffer values;
+};
+
+#endif  // TIME_DELAY_ESTIMATOR__RING_BUFFER_HPP_
@@ -23,6 +23,7 @@
 #include "time_delay_estimator/data_processor.hpp"
 #include "time_delay_estimator/debugger.hpp"
 #include "time_delay_estimator/parameters.hpp"
+#include "time_delay_estimator/ring_buffer.hpp"
 
 #include "std_msgs/msg/float32_multi_array.hpp"
 #include "std_msgs/msg/float64_multi_array.hpp"
@@ -52,7 +53,19 @@ private:
   Estimator cc_estimator_;
   Estimator ls_estimator_;
   Estimator ls2_estimator_;
+  // extra samples of the buffers over data_size, for fitting
+  static constexpr int data_buffer_ = 2;
   std::vector<double> weights_for_data_;
+  math_utils::CrossCorrelation cross_correlation_workspace_;
+  // the correlation is searched around the previous peak between the full scans
+  bool has_cross_correlation_peak_ = false;
+  int cross_correlation_scan_count_ = 0;
+  // decimated signals of the coarse full scan, with their own FFT size
+  math_utils::CrossCorrelation coarse_cross_correlation_workspace_;
+  std::vector<double> decimated_input_;
+  std::vector<double> decimated_response_;
+  std::vector<double> decimated_weights_;
+  std::vector<double> coarse_cross_correlation_;
   std::string name_;
   bool is_valid_data_ = false;
   double max_current_stddev_ = 0;
@@ -75,15 +88,23 @@ private:
    * @return Correlation type value
    **/
   enum DetectionResult estimateDelayByCrossCorrelation(
-    rclcpp::Node * node, const std::vector<double> & input, const std::vector<double> & response,
-    Estimator & corr, std::string name, const Params & params);
+    rclcpp::Node * node, const RingBuffer & input, const RingBuffer & response, Estimator & corr,
+    std::string name, const Params & params);
+
+  /**
+   * @brief : correlation of all the delays, found on the decimated signals and computed at full
+   * resolution around their peak, or by the FFTs if the decimation is off
+   * @param cross_corr : correlation of the delays, -1 outside of the computed ones
+   **/
+  void scanCrossCorrelation(
+    const RingBuffer & input, const RingBuffer & response, const Params & params,
+    std::vector<double> & cross_corr);
 
   enum DetectionResult estimateDelayByLeastSquared(
-    const std::vector<double> & x2dot, const std::vector<double> & x_dot,
-    const std::vector<double> & x, const std::vector<double> & u, const Params & params);
+    const RingBuffer & x2dot, const RingBuffer & x_dot, const RingBuffer & x,
+    const RingBuffer & u, const Params & params);
   enum DetectionResult estimateDelayByLeastSquared(
-    const std::vector<double> & x_dot, const std::vector<double> & x, const std::vector<double> & u,
-    const Params & params);
+    const RingBuffer & x_dot, const RingBuffer & x, const RingBuffer & u, const Params & params);
 
 public:
   Data input_;
@@ -91,10 +112,16 @@ public:
   Data response_dot_;
   Data response_2dot_;
   bool checkIsValidData();
+  // the output of estimateTimeDelay is updated from the current data
+  bool hasEnoughData() const
+  {
+    return is_valid_data_ && has_enough_input_ && has_enough_response_;
+  }
   void estimate();
   void preprocessData(rclcpp::Node * node);
   void processDebugData(rclcpp::Node * node);
   void resetEstimator();
+  void resetData();
   Params params_;
   /**
    * @brief : initialize module
@@ -20,6 +20,7 @@
 #include "estimator_utils/math_utils.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "time_delay_estimator/data_processor.hpp"
+#include "time_delay_estimator/parallel_estimation.hpp"
 #include "time_delay_estimator/parameters.hpp"
 #include "time_delay_estimator/time_delay_estimator.hpp"
 
@@ -36,6 +37,7 @@
 #include <cmath>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <utility>
@@ -109,9 +111,16 @@ private:
   std::unique_ptr<TimeDelayEstimator> accel_data_;
   std::unique_ptr<TimeDelayEstimator> brake_data_;
   std::unique_ptr<TimeDelayEstimator> steer_data_;
+  // the workers of the channels, nullptr unless parallel_estimation
+  std::unique_ptr<ParallelEstimation> parallel_estimation_;
   // for ros parameters
   Params params_;
 
+  enum ChannelIndex : size_t { ACCEL = 0, BRAKE = 1, STEER = 2 };
+
+  // lock the data of a channel against its worker, if any
+  std::unique_lock<std::mutex> lockData(const ChannelIndex channel);
+
   void timerCallback();
   void timerDataCollector();
   bool estimateTimeDelay();
@@ -26,33 +26,37 @@ bool checkIsValidData(
 {
   bool is_valid_data = false;
   if (input.validation.empty()) {
-    input.validation.emplace_back(input.value);
-    response.validation.emplace_back(response.value);
+    input.validation.push_back(input.value);
+    response.validation.push_back(response.value);
   } else {
     const double filtered_input = math_utils::lowpassFilter(
       input.value, input.validation.back(), params.cutoff_hz_input, params.sampling_delta_time);
-    input.validation.emplace_back(filtered_input);
+    input.validation.push_back(filtered_input);
     const double filtered_response = math_utils::lowpassFilter(
       response.value, response.validation.back(), params.cutoff_hz_input,
       params.sampling_delta_time);
-    response.validation.emplace_back(filtered_response);
+    response.validation.push_back(filtered_response);
   }
+  input.validation_statistics.add(input.validation.back());
+  response.validation_statistics.add(response.validation.back());
 
   const auto input_val_size = static_cast<int>(input.validation.size());
   const auto response_val_size = static_cast<int>(response.validation.size());
   if (input_val_size > params.validation_size && response_val_size > params.validation_size) {
     // Ignore None featured data or Too much deviation data
-    double input_stddev = math_utils::getStddevFromVector(input.validation);
-    double response_stddev = math_utils::getStddevFromVector(response.validation);
+    double input_stddev = input.validation_statistics.stddevX();
+    double response_stddev = response.validation_statistics.stddevX();
     max_stddev = std::max(input_stddev, response_stddev);
     if (ignore_thresh < max_stddev) {
       is_valid_data = true;
     }
   }
   if (input_val_size > params.validation_size) {
+    input.validation_statistics.remove(input.validation.front());
     input.validation.pop_front();
   }
   if (response_val_size > params.validation_size) {
+    response.validation_statistics.remove(response.validation.front());
     response.validation.pop_front();
   }
   return is_valid_data;
@@ -60,20 +64,17 @@ bool checkIsValidData(
 bool processInputData(Data & input, const Params & params, const int buffer)
 {
   bool has_enough_input = true;
-  input.raw.emplace_back(input.value);
-  input.stamps.emplace_back(input.stamp);
+  input.raw.push_back(input.value);
+  input.stamps.push_back(input.stamp);
   if (input.filtered.size() == 0) {
-    input.filtered.emplace_back(input.value);
+    input.filtered.push_back(input.value);
   } else {
     const double filt = math_utils::lowpassFilter(
       input.raw.back(), input.filtered.back(), params.cutoff_hz_input, params.sampling_delta_time);
     // Filtered
-    input.filtered.emplace_back(filt);
-    input.processed = math_utils::arrToVector(input.filtered);
-    if (params.num_interpolation > 1 && input.processed.size() > 5) {
-      input.processed =
-        math_utils::getLinearInterpolation(input.processed, params.num_interpolation);
-    }
+    input.filtered.push_back(filt);
+    input.processed.update(
+      input.filtered, input.filtered.size() > 5 ? params.num_interpolation : 1);
   }
 
   const auto input_raw_size = static_cast<int>(input.raw.size());
@@ -101,23 +102,20 @@ bool processResponseData(
   const int buffer)
 {
   bool has_enough_data = true;
-  data.raw.emplace_back(data.value);
-  data.stamps.emplace_back(data.stamp);
+  data.raw.push_back(data.value);
+  data.stamps.push_back(data.stamp);
   if (data.filtered.size() == 0) {
-    data.filtered.emplace_back(data.value);
+    data.filtered.push_back(data.value);
   } else {
     const double filt = math_utils::lowpassFilter(
       data.raw.back(), data.filtered.back(), params.cutoff_hz_input, params.sampling_delta_time);
     // Filtered
-    data.filtered.emplace_back(filt);
-    data.processed = math_utils::arrToVector(data.filtered);
-    if (params.num_interpolation > 1 && data.processed.size() > 5) {
-      data.processed = math_utils::getLinearInterpolation(data.processed, params.num_interpolation);
-    }
+    data.filtered.push_back(filt);
+    data.processed.update(data.filtered, data.filtered.size() > 5 ? params.num_interpolation : 1);
   }
   if (data.filtered.size() < 3) {
-    data_dot.filtered.emplace_back(0);
-    data_2dot.filtered.emplace_back(0);
+    data_dot.filtered.push_back(0);
+    data_2dot.filtered.push_back(0);
     return false;
   } else {
     const double x0 = *(data.filtered.end() - 3);
@@ -132,15 +130,11 @@ bool processResponseData(
     RCLCPP_DEBUG_STREAM_THROTTLE(
       rclcpp::get_logger("time_delay_estimator"), clk, 3000,
       "[time delay estimator] diff : " << diff << " diff2 : " << diff2);
-    data_dot.filtered.emplace_back(diff);
-    data_2dot.filtered.emplace_back(diff2);
+    data_dot.filtered.push_back(diff);
+    data_2dot.filtered.push_back(diff2);
     // Filtered
-    data_dot.processed = math_utils::arrToVector(data_dot.filtered);
-    data_2dot.processed = math_utils::arrToVector(data_2dot.filtered);
-    data_dot.processed =
-      math_utils::getLinearInterpolation(data_dot.processed, params.num_interpolation);
-    data_2dot.processed =
-      math_utils::getLinearInterpolation(data_2dot.processed, params.num_interpolation);
+    data_dot.processed.update(data_dot.filtered, params.num_interpolation);
+    data_2dot.processed.update(data_2dot.filtered, params.num_interpolation);
   }
 
   const auto data_raw_size = static_cast<int>(data.raw.size());
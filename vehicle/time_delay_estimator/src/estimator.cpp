@@ -15,38 +15,79 @@
 //
 
 #include "estimator_utils/math_utils.hpp"
+#include "estimator_utils/optimization_utils.hpp"
 #include "time_delay_estimator/time_delay_estimator.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <string>
 #include <vector>
 
+namespace
+{
+// Sub-sample delay of the least squared fit, refined around the integer delay @index of the
+// smallest error. The target is interpolated between the neighboring delays, whose errors are
+// searched by golden section down to a hundredth of a sample. @error and @w are updated if the
+// refined delay fits better.
+template <int Dim>
+double refineDelayByLeastSquared(
+  const optimization_utils::DelayedLeastSquared<Dim> & least_squared, const RingBuffer & u,
+  const int num_sample, const int maximum_delay, const int index, double & error,
+  Eigen::VectorXd & w)
+{
+  if (maximum_delay < 2) {
+    return index;
+  }
+  // the target delayed by @delay samples, assuming std::vector(old,....,new)
+  const auto target = [&](const int delay) { return u.data() + u.size() - num_sample - delay; };
+  const auto fractional_error = [&](const double delay, Eigen::VectorXd & coefficients) {
+    const int lower = std::min(static_cast<int>(std::floor(delay)), maximum_delay - 2);
+    return least_squared.getLeastSquaredError(
+      target(lower), target(lower + 1), delay - lower, coefficients);
+  };
+  Eigen::VectorXd coefficients;
+  const double delay = optimization_utils::goldenSectionSearch(
+    [&](const double d) { return fractional_error(d, coefficients); }, std::max(index - 1, 0),
+    std::min(index + 1, maximum_delay - 1), 0.01);
+  const double refined_error = fractional_error(delay, coefficients);
+  if (refined_error >= error) {
+    return index;
+  }
+  error = refined_error;
+  w = coefficients;
+  return delay;
+}
+}  // namespace
+
 TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByLeastSquared(
-  const std::vector<double> & x_dot, const std::vector<double> & x, const std::vector<double> & u,
-  const Params & params)
+  const RingBuffer & x_dot, const RingBuffer & x, const RingBuffer & u, const Params & params)
 {
   int num_sample = static_cast<int>(u.size() * (1.0 - params.valid_delay_index_ratio));
   int maximum_delay = static_cast<int>(u.size() * params.valid_delay_index_ratio);
-  std::vector<double> resample_y = {x.end() - num_sample, x.end()};
-  std::vector<double> resample_y_dot = {x_dot.end() - num_sample, x_dot.end()};
-  std::vector<double> resample_x;
+  // the response is not delayed, so its Gram matrix is shared by all the delays
+  const optimization_utils::DelayedLeastSquared<2> least_squared(
+    {x_dot.data() + x_dot.size() - num_sample, x.data() + x.size() - num_sample}, num_sample);
   double min_error = std::numeric_limits<double>::max();
 
   int min_error_index = 0;
   for (int d = 0; d < maximum_delay; d++) {
     // assume std::vector(old,....,new)
-    resample_x = {u.end() - num_sample - d, u.end() - d};
-    double error_norm = optimization_utils::getLeastSquaredError(
-      resample_y_dot, resample_y, resample_x, ls_estimator_.w);
+    const double * resample_x = u.data() + u.size() - num_sample - d;
+    double error_norm = least_squared.getLeastSquaredError(resample_x, ls_estimator_.w);
     if (optimization_utils::change_abs_min(min_error, error_norm)) {
       min_error = error_norm;
       min_error_index = d;
     }
   }
+  least_squared.getLeastSquaredError(
+    u.data() + u.size() - num_sample - min_error_index, ls_estimator_.w);
+  const double delay = refineDelayByLeastSquared(
+    least_squared, u, num_sample, maximum_delay, min_error_index, min_error, ls_estimator_.w);
   ls_estimator_.mae = min_error;
   ls_estimator_.estimated_delay_index = min_error_index;
-  ls_estimator_.time_delay = static_cast<double>(min_error_index) * params.sampling_delta_time /
-                             static_cast<double>(params.num_interpolation);
+  ls_estimator_.time_delay =
+    delay * params.sampling_delta_time / static_cast<double>(params.num_interpolation);
   const double valid_mae_threshold = 0.1;
   if (ls_estimator_.mae < valid_mae_threshold) {
     return DetectionResult::BELOW_THRESH;
@@ -55,32 +96,35 @@ TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByLeastSqua
 }
 
 TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByLeastSquared(
-  const std::vector<double> & x2dot, const std::vector<double> & x_dot,
-  const std::vector<double> & x, const std::vector<double> & u, const Params & params)
+  const RingBuffer & x2dot, const RingBuffer & x_dot, const RingBuffer & x, const RingBuffer & u,
+  const Params & params)
 {
   int num_sample = static_cast<int>(u.size() * (1.0 - params.valid_delay_index_ratio));
   int maximum_delay = static_cast<int>(u.size() * params.valid_delay_index_ratio);
-  std::vector<double> resample_y = {x.end() - num_sample, x.end()};
-  std::vector<double> resample_y_dot = {x_dot.end() - num_sample, x_dot.end()};
-  std::vector<double> resample_y2dot = {x2dot.end() - num_sample, x2dot.end()};
-  std::vector<double> resample_x;
+  // the response is not delayed, so its Gram matrix is shared by all the delays
+  const optimization_utils::DelayedLeastSquared<3> least_squared(
+    {x2dot.data() + x2dot.size() - num_sample, x_dot.data() + x_dot.size() - num_sample,
+     x.data() + x.size() - num_sample},
+    num_sample);
   double min_error = std::numeric_limits<double>::max();
   int min_error_index = 0;
-  min_error = std::numeric_limits<double>::max();
   for (int d = 0; d < maximum_delay; d++) {
     //  assume std::vector(old,....,new)
-    resample_x = {u.end() - num_sample - d, u.end() - d};
-    double error_norm = optimization_utils::getLeastSquaredError(
-      resample_y2dot, resample_y_dot, resample_y, resample_x, ls2_estimator_.w);
+    const double * resample_x = u.data() + u.size() - num_sample - d;
+    double error_norm = least_squared.getLeastSquaredError(resample_x, ls2_estimator_.w);
     if (optimization_utils::change_abs_min(min_error, error_norm)) {
       min_error = error_norm;
       min_error_index = d;
     }
   }
+  least_squared.getLeastSquaredError(
+    u.data() + u.size() - num_sample - min_error_index, ls2_estimator_.w);
+  const double delay = refineDelayByLeastSquared(
+    least_squared, u, num_sample, maximum_delay, min_error_index, min_error, ls2_estimator_.w);
   ls2_estimator_.mae = min_error;
   ls2_estimator_.estimated_delay_index = min_error_index;
-  ls2_estimator_.time_delay = static_cast<double>(min_error_index) * params.sampling_delta_time /
-                              static_cast<double>(params.num_interpolation);
+  ls2_estimator_.time_delay =
+    delay * params.sampling_delta_time / static_cast<double>(params.num_interpolation);
   const double valid_mae_threshold = 0.1;
   if (ls2_estimator_.mae < valid_mae_threshold) {
     return DetectionResult::DETECTED;
@@ -89,17 +133,39 @@ TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByLeastSqua
 }
 
 TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByCrossCorrelation(
-  rclcpp::Node * node, const std::vector<double> & input, const std::vector<double> & response,
+  rclcpp::Node * node, const RingBuffer & input, const RingBuffer & response,
   Estimator & cc_estimator, std::string name, const Params & params)
 {
   auto & cross_corr = cc_estimator.cross_correlation;
-  cross_corr = math_utils::calcCrossCorrelationCoefficient(
-    input, response, weights_for_data_, params.valid_delay_index_ratio);
   auto & peak_index = cc_estimator.estimated_delay_index;
-  peak_index = math_utils::getMaximumIndexFromVector(cross_corr);
+  const int width = params.cross_correlation_search_width;
+  bool is_full_scan = !has_cross_correlation_peak_ || width <= 0 ||
+                      cross_correlation_scan_count_ >= params.cross_correlation_full_scan_period;
+  if (!is_full_scan) {
+    // warm start around the previous peak, whose delay is not smoothed by the output filter
+    const int center = peak_index;
+    cross_correlation_workspace_.calcInWindow(
+      input, response, weights_for_data_, params.valid_delay_index_ratio, center - width,
+      center + width, cross_corr);
+    peak_index = math_utils::getMaximumIndexFromVector(cross_corr);
+    // the peak on an edge of the window may be outside of it, the last delay is not computed
+    const int last_delay = static_cast<int>(cross_corr.size()) - 2;
+    const bool is_on_edge = (peak_index == center - width && peak_index > 0) ||
+                            (peak_index == center + width && peak_index < last_delay);
+    is_full_scan =
+      is_on_edge || cross_corr[peak_index] < params.valid_peak_cross_correlation_threshold;
+  }
+  if (is_full_scan) {
+    scanCrossCorrelation(input, response, params, cross_corr);
+    peak_index = math_utils::getMaximumIndexFromVector(cross_corr);
+    cross_correlation_scan_count_ = 0;
+  } else {
+    cross_correlation_scan_count_++;
+  }
   auto & peak_corr = cc_estimator.peak_correlation;
   peak_corr = cross_corr[peak_index];
-  if (peak_corr < params.valid_peak_cross_correlation_threshold) {
+  has_cross_correlation_peak_ = peak_corr >= params.valid_peak_cross_correlation_threshold;
+  if (!has_cross_correlation_peak_) {
     auto & clk = *node->get_clock();
     RCLCPP_DEBUG_STREAM_THROTTLE(
       rclcpp::get_logger("time_delay_estimator"), clk, 5000,
@@ -107,7 +173,44 @@ TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByCrossCorr
     return DetectionResult::BELOW_THRESH;
   }
   cc_estimator.mae = math_utils::calcMAE(input, response, cc_estimator.estimated_delay_index);
-  cc_estimator.time_delay = static_cast<double>(peak_index) * params.sampling_delta_time /
+  // the correlation peak is refined below a sample
+  cc_estimator.time_delay = math_utils::getParabolicPeakIndex(cross_corr, peak_index) *
+                            params.sampling_delta_time /
                             static_cast<double>(params.num_interpolation);
   return DetectionResult::DETECTED;
 }
+
+void TimeDelayEstimator::scanCrossCorrelation(
+  const RingBuffer & input, const RingBuffer & response, const Params & params,
+  std::vector<double> & cross_corr)
+{
+  const int decimation = std::max(params.cross_correlation_decimation, 1);
+  const size_t coarse_size = input.size() / decimation;
+  // the decimated signals are too short for the coarse delays
+  const size_t min_coarse_size = 8;
+  if (decimation == 1 || coarse_size < min_coarse_size) {
+    math_utils::calcCrossCorrelationCoefficient(
+      input, response, weights_for_data_, params.valid_delay_index_ratio,
+      cross_correlation_workspace_, cross_corr);
+    return;
+  }
+  math_utils::decimate(input, decimation, decimated_input_);
+  math_utils::decimate(response, decimation, decimated_response_);
+  // the weights are from the newest samples, and their scale does not matter
+  decimated_weights_.assign(coarse_size, 0.0);
+  for (size_t j = 0; j < coarse_size; j++) {
+    for (int k = 0; k < decimation; k++) {
+      const size_t i = j * decimation + k;
+      decimated_weights_[j] += i < weights_for_data_.size() ? weights_for_data_[i] : 0.0;
+    }
+  }
+  // two more coarse delays, so that the coarse delays cover all of the delays
+  const double coarse_ratio = params.valid_delay_index_ratio + 2.0 / coarse_size;
+  math_utils::calcCrossCorrelationCoefficient(
+    decimated_input_, decimated_response_, decimated_weights_, coarse_ratio,
+    coarse_cross_correlation_workspace_, coarse_cross_correlation_);
+  const int coarse_peak = math_utils::getMaximumIndexFromVector(coarse_cross_correlation_);
+  cross_correlation_workspace_.calcInWindow(
+    input, response, weights_for_data_, params.valid_delay_index_ratio,
+    (coarse_peak - 1) * decimation, (coarse_peak + 1) * decimation, cross_corr);
+}
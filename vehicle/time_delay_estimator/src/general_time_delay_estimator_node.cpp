@@ -17,9 +17,11 @@
 #include "time_delay_estimator/general_time_delay_estimator_node.hpp"
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 double validateRange(
   rclcpp::Node * node, const double min, const double max, const double val, std::string name)
@@ -41,15 +43,20 @@ double addOffset(const double val, const double offset)
   return val + offset;
 }
 
-TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_options)
+// the stamp of the message, or the current time if it is not stamped
+double getStamp(rclcpp::Node * node, const std_msgs::msg::Header & header)
+{
+  const rclcpp::Time stamp(header.stamp);
+  return stamp.nanoseconds() == 0 ? node->now().seconds() : stamp.seconds();
+}
+
+GeneralTimeDelayEstimatorNode::GeneralTimeDelayEstimatorNode(
+  const rclcpp::NodeOptions & node_options)
 : Node("time_delay_estimator", node_options)
 {
   using std::placeholders::_1;
 
-  // QoS setup
   static constexpr std::size_t queue_size = 1;
-  rclcpp::QoS durable_qos(queue_size);
-  durable_qos.transient_local();  // option for latching
 
   // get parameter
   detect_manual_engage_ = this->declare_parameter<bool>("detect_manual_engage", true);
@@ -65,7 +72,13 @@ TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_
   params_.cutoff_hz_output = this->declare_parameter<double>("filter/cutoff_hz_output", 0.1);
   params_.is_showing_debug_info = this->declare_parameter<bool>("is_showing_debug_info", true);
   // params_.is_test_mode = this->declare_parameter<bool>("test/is_test_mode", false);
-  params_.num_interpolation = this->declare_parameter<int>("data/num_interpolation", 3);
+  params_.num_interpolation = this->declare_parameter<int>("data/num_interpolation", 1);
+  params_.cross_correlation_search_width =
+    this->declare_parameter<int>("data/cross_correlation_search_width", 3);
+  params_.cross_correlation_full_scan_period =
+    this->declare_parameter<int>("data/cross_correlation_full_scan_period", 10);
+  params_.cross_correlation_decimation =
+    this->declare_parameter<int>("data/cross_correlation_decimation", 4);
   params_.reset_at_disengage = this->declare_parameter<bool>("reset_at_disengage", false);
   bool use_weight_for_cross_correlation =
     this->declare_parameter<bool>("use_weight_for_cross_correlation", false);
@@ -73,39 +86,49 @@ TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_
   params_.estimation_delta_time = 1.0 / params_.estimation_hz;
   params_.data_size = static_cast<int>(params_.sampling_hz * params_.sampling_duration);
   params_.validation_size = static_cast<int>(params_.sampling_hz * params_.validation_duration);
-  valid_input_.min = this->declare_parameter<double>("min_valid_value", 0.05);
-  valid_input_.max = this->declare_parameter<double>("max_valid_value", 1.00);
-  input_offset_ = this->declare_parameter<double>("offset_value", 0.0);
-  data_name_ = this->declare_parameter<std::string>("data_name", "test");
 
   last_manual_time_ = this->now().seconds();
   // input
   sub_control_mode_report_ = create_subscription<autoware_vehicle_msgs::msg::ControlModeReport>(
     "~/input/control_mode", queue_size,
-    std::bind(&TimeDelayEstimatorNode::callbackControlModeReport, this, _1));
-
-  // response
-  sub_input_cmd_ = create_subscription<Float32Stamped>(
-    "~/input/input_cmd", queue_size,
-    std::bind(&TimeDelayEstimatorNode::callbackInputCmd, this, _1));
-  sub_input_status_ = create_subscription<Float32Stamped>(
-    "~/input/input_status", queue_size,
-    std::bind(&TimeDelayEstimatorNode::callbackInputStatus, this, _1));
+    std::bind(&GeneralTimeDelayEstimatorNode::callbackControlModeReport, this, _1));
   sub_is_engaged_ = create_subscription<BoolStamped>(
-    "~/input/is_engage", queue_size, std::bind(&TimeDelayEstimatorNode::callbackEngage, this, _1));
+    "~/input/is_engage", queue_size,
+    std::bind(&GeneralTimeDelayEstimatorNode::callbackEngage, this, _1));
 
   params_.total_data_size =
     static_cast<int>(params_.sampling_duration * params_.sampling_hz * params_.num_interpolation) +
     1;
-  collected_data_ = std::make_unique<TimeDelayEstimator>(
-    this, params_, data_name_, params_.total_data_size, use_weight_for_cross_correlation);
 
-  pub_time_delay_ = create_publisher<TimeDelay>("~/output/time_delay", durable_qos);
+  // one channel of data_name with the parameters and the topics at the top, or one channel per
+  // name of data_names with its parameters and topics under its name
+  const auto data_names =
+    this->declare_parameter<std::vector<std::string>>("data_names", std::vector<std::string>{});
+  if (data_names.empty()) {
+    addChannel(
+      this->declare_parameter<std::string>("data_name", "test"), "",
+      use_weight_for_cross_correlation);
+  }
+  for (const auto & name : data_names) {
+    addChannel(name, name + "/", use_weight_for_cross_correlation);
+  }
+
+  const bool parallel_estimation = this->declare_parameter<bool>("parallel_estimation", false);
+  const double estimation_deadline =
+    this->declare_parameter<double>("estimation_deadline", params_.sampling_delta_time);
+  if (parallel_estimation) {
+    parallel_estimation_ = std::make_unique<ParallelEstimation>(this, "cc", estimation_deadline);
+    for (const auto & channel : channels_) {
+      parallel_estimation_->addChannel(
+        channel->name, channel->collected_data.get(), channel->pub_time_delay);
+    }
+  }
 
   const auto period_s = params_.sampling_delta_time;
   // data processing callback
   {
-    auto data_processing_callback = std::bind(&TimeDelayEstimatorNode::timerDataCollector, this);
+    auto data_processing_callback =
+      std::bind(&GeneralTimeDelayEstimatorNode::timerDataCollector, this);
     const auto period_ns =
       std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(period_s));
     timer_data_processing_ =
@@ -116,7 +139,7 @@ TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_
   }
   // estimation callback
   {
-    auto estimation_callback = std::bind(&TimeDelayEstimatorNode::estimateTimeDelay, this);
+    auto estimation_callback = std::bind(&GeneralTimeDelayEstimatorNode::estimateTimeDelay, this);
     const auto period_ns =
       std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(period_s));
     timer_estimation_ = std::make_shared<rclcpp::GenericTimer<decltype(estimation_callback)>>(
@@ -126,19 +149,95 @@ TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_
   }
 }
 
-void TimeDelayEstimatorNode::timerDataCollector()
+void GeneralTimeDelayEstimatorNode::addChannel(
+  const std::string & name, const std::string & prefix,
+  const bool use_weight_for_cross_correlation)
+{
+  using std::placeholders::_1;
+
+  // QoS setup
+  static constexpr std::size_t queue_size = 1;
+  rclcpp::QoS durable_qos(queue_size);
+  durable_qos.transient_local();  // option for latching
+
+  auto channel = std::make_unique<Channel>();
+  channel->name = name;
+  channel->valid_input.min = this->declare_parameter<double>(prefix + "min_valid_value", 0.05);
+  channel->valid_input.max = this->declare_parameter<double>(prefix + "max_valid_value", 1.00);
+  channel->input_offset = this->declare_parameter<double>(prefix + "offset_value", 0.0);
+
+  // a second of samples of a kHz signal
+  static constexpr std::size_t sample_capacity = 1000;
+  channel->cmd_samples = StampedRingBuffer(sample_capacity);
+  channel->status_samples = StampedRingBuffer(sample_capacity);
+
+  // response
+  channel->sub_input_cmd = create_subscription<Float32Stamped>(
+    "~/input/" + prefix + "input_cmd", queue_size,
+    std::bind(&GeneralTimeDelayEstimatorNode::callbackInputCmd, this, std::ref(*channel), _1));
+  channel->sub_input_status = create_subscription<Float32Stamped>(
+    "~/input/" + prefix + "input_status", queue_size,
+    std::bind(&GeneralTimeDelayEstimatorNode::callbackInputStatus, this, std::ref(*channel), _1));
+
+  channel->collected_data = std::make_unique<TimeDelayEstimator>(
+    this, params_, name, params_.total_data_size, use_weight_for_cross_correlation);
+
+  channel->pub_time_delay =
+    create_publisher<TimeDelay>("~/output/" + prefix + "time_delay", durable_qos);
+
+  channels_.push_back(std::move(channel));
+}
+
+std::unique_lock<std::mutex> GeneralTimeDelayEstimatorNode::lockData(const size_t channel)
+{
+  if (!parallel_estimation_) {
+    return {};
+  }
+  return std::unique_lock<std::mutex>(parallel_estimation_->dataMutex(channel));
+}
+
+void GeneralTimeDelayEstimatorNode::timerDataCollector()
 {
   if (std::min(auto_mode_duration_, engage_duration_) < 5.0 && detect_manual_engage_) {
     if (params_.reset_at_disengage) {
-      collected_data_->resetEstimator();
+      for (size_t i = 0; i < channels_.size(); i++) {
+        const auto lock = lockData(i);
+        channels_.at(i)->collected_data->resetEstimator();
+      }
+    }
+    // the grid starts again at the samples after the engagement
+    for (auto & channel : channels_) {
+      channel->cmd_samples.clear();
+      channel->status_samples.clear();
+      channel->has_grid = false;
     }
     return;
   }
-  if (input_status_ptr_ && input_cmd_ptr_) {
-    collected_data_->preprocessData(this);
+  for (size_t i = 0; i < channels_.size(); i++) {
+    auto & channel = *channels_.at(i);
+    auto & cmd = channel.cmd_samples;
+    auto & status = channel.status_samples;
+    if (!channel.input_status_ptr || !channel.input_cmd_ptr || cmd.empty() || status.empty()) {
+      continue;
+    }
+    // the grid does not go back before the oldest samples, e.g. if the buffers were full
+    const double oldest = std::max(cmd.stamps.front(), status.stamps.front());
+    if (!channel.has_grid || channel.grid_stamp < oldest) {
+      channel.grid_stamp = oldest;
+      channel.has_grid = true;
+    }
+    // the grid and the samples of both signals only move forward, so each sample is visited once
+    const double newest = std::min(cmd.stamps.back(), status.stamps.back());
+    const auto lock = lockData(i);
+    for (; channel.grid_stamp <= newest; channel.grid_stamp += params_.sampling_delta_time) {
+      auto & data = *channel.collected_data;
+      data.input_.setValue(cmd.interpolate(channel.grid_stamp), channel.grid_stamp);
+      data.response_.setValue(status.interpolate(channel.grid_stamp), channel.grid_stamp);
+      data.preprocessData(this);
+    }
   }
 }
-bool TimeDelayEstimatorNode::estimateTimeDelay()
+bool GeneralTimeDelayEstimatorNode::estimateTimeDelay()
 {
   std::chrono::system_clock::time_point start, end;
   start = std::chrono::system_clock::now();
@@ -149,12 +248,21 @@ bool TimeDelayEstimatorNode::estimateTimeDelay()
   auto & clk = *this->get_clock();
 
   // ====data delay estimation
-  if (!input_status_ptr_ || !input_cmd_ptr_) {
-    RCLCPP_INFO_STREAM_THROTTLE(
-      rclcpp::get_logger("time_delay_estimator"), clk, 5000,
-      "[time_delay_estimator] : empty input ptr");
-  } else {
-    pub_time_delay_->publish(collected_data_->estimateTimeDelay(this, "cc"));
+  std::vector<bool> ready;
+  for (const auto & channel : channels_) {
+    ready.push_back(channel->input_status_ptr && channel->input_cmd_ptr);
+    if (!ready.back()) {
+      RCLCPP_INFO_STREAM_THROTTLE(
+        rclcpp::get_logger("time_delay_estimator"), clk, 5000,
+        "[time_delay_estimator] : empty " << channel->name << " input ptr");
+    } else if (!parallel_estimation_) {
+      channel->pub_time_delay->publish(channel->collected_data->estimateTimeDelay(this, "cc"));
+    }
+  }
+
+  if (parallel_estimation_) {
+    // the results are published by the workers
+    parallel_estimation_->estimate(ready);
   }
 
   end = std::chrono::system_clock::now();
@@ -164,27 +272,30 @@ bool TimeDelayEstimatorNode::estimateTimeDelay()
   return true;
 }
 
-void TimeDelayEstimatorNode::callbackInputCmd(const Float32Stamped::ConstSharedPtr msg)
+void GeneralTimeDelayEstimatorNode::callbackInputCmd(
+  Channel & channel, const Float32Stamped::ConstSharedPtr msg)
 {
-  input_cmd_ptr_ = msg;
-  const auto & t = this->get_clock()->now().seconds();
-  double input =
-    validateRange(this, valid_input_.min, valid_input_.max, input_cmd_ptr_->data, data_name_);
-  const double input_offset = addOffset(input, input_offset_);
-  collected_data_->input_.setValue(input_offset, t);
+  channel.input_cmd_ptr = msg;
+  double input = validateRange(
+    this, channel.valid_input.min, channel.valid_input.max, channel.input_cmd_ptr->data,
+    channel.name);
+  const double input_offset = addOffset(input, channel.input_offset);
+  channel.cmd_samples.push_back(getStamp(this, msg->header), input_offset);
 }
 
-void TimeDelayEstimatorNode::callbackInputStatus(const Float32Stamped::ConstSharedPtr msg)
+void GeneralTimeDelayEstimatorNode::callbackInputStatus(
+  Channel & channel, const Float32Stamped::ConstSharedPtr msg)
 {
-  input_status_ptr_ = msg;
-  const auto & t = this->get_clock()->now().seconds();
+  channel.input_status_ptr = msg;
   double input_response = validateRange(
-    this, valid_input_.min, valid_input_.max, input_status_ptr_->data, data_name_ + " response");
-  const double input_response_offset = addOffset(input_response, input_offset_);
-  collected_data_->response_.setValue(input_response_offset, t);
+    this, channel.valid_input.min, channel.valid_input.max, channel.input_status_ptr->data,
+    channel.name + " response");
+  const double input_response_offset = addOffset(input_response, channel.input_offset);
+  channel.status_samples.push_back(getStamp(this, msg->header), input_response_offset);
 }
 
-void TimeDelayEstimatorNode::callbackControlModeReport(const ControlModeReport::ConstSharedPtr msg)
+void GeneralTimeDelayEstimatorNode::callbackControlModeReport(
+  const ControlModeReport::ConstSharedPtr msg)
 {
   auto & clk = *this->get_clock();
   control_mode_ptr_ = msg;
@@ -202,7 +313,7 @@ void TimeDelayEstimatorNode::callbackControlModeReport(const ControlModeReport::
   }
 }
 
-void TimeDelayEstimatorNode::callbackEngage(const IsEngaged::ConstSharedPtr msg)
+void GeneralTimeDelayEstimatorNode::callbackEngage(const IsEngaged::ConstSharedPtr msg)
 {
   engage_mode_ = msg->data;
   auto & clk = *this->get_clock();
@@ -219,3 +330,7 @@ void TimeDelayEstimatorNode::callbackEngage(const IsEngaged::ConstSharedPtr msg)
       "[time_delay_estimator] engage mode : disengage");
   }
 }
+
+#include <rclcpp_components/register_node_macro.hpp>
+
+RCLCPP_COMPONENTS_REGISTER_NODE(GeneralTimeDelayEstimatorNode)
@@ -0,0 +1,117 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "time_delay_estimator/parallel_estimation.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+ParallelEstimation::ParallelEstimation(
+  rclcpp::Node * node, const std::string & estimator_type, const double deadline)
+: node_(node),
+  estimator_type_(estimator_type),
+  deadline_duration_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(deadline)))
+{
+}
+
+ParallelEstimation::~ParallelEstimation()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_start_.notify_all();
+  for (auto & channel : channels_) {
+    channel->thread.join();
+  }
+}
+
+size_t ParallelEstimation::addChannel(
+  const std::string & name, TimeDelayEstimator * estimator,
+  const rclcpp::Publisher<TimeDelay>::SharedPtr & publisher)
+{
+  auto channel = std::make_unique<Channel>();
+  channel->name = name;
+  channel->estimator = estimator;
+  channel->publisher = publisher;
+  channel->thread = std::thread(&ParallelEstimation::work, this, std::ref(*channel));
+  channels_.push_back(std::move(channel));
+  return channels_.size() - 1;
+}
+
+void ParallelEstimation::estimate(const std::vector<bool> & ready)
+{
+  auto & clk = *node_->get_clock();
+  std::unique_lock<std::mutex> lock(mutex_);
+  deadline_ = std::chrono::steady_clock::now() + deadline_duration_;
+  for (size_t i = 0; i < channels_.size(); i++) {
+    auto & channel = *channels_.at(i);
+    if (!ready.at(i)) {
+      continue;
+    }
+    if (channel.busy) {
+      RCLCPP_WARN_STREAM_THROTTLE(
+        rclcpp::get_logger("time_delay_estimator"), clk, 5000,
+        "[time_delay_estimator] " << channel.name << " is skipped, the last estimation runs");
+      continue;
+    }
+    channel.busy = true;
+    channel.requested = true;
+  }
+  cv_start_.notify_all();
+
+  const auto finished = cv_done_.wait_until(lock, deadline_, [this]() {
+    return std::none_of(
+      channels_.begin(), channels_.end(), [](const auto & channel) { return channel->busy; });
+  });
+  if (!finished) {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      rclcpp::get_logger("time_delay_estimator"), clk, 5000,
+      "[time_delay_estimator] estimation missed the deadline");
+  }
+}
+
+void ParallelEstimation::work(Channel & channel)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_start_.wait(lock, [this, &channel]() { return stop_ || channel.requested; });
+    if (stop_) {
+      return;
+    }
+    channel.requested = false;
+    const auto deadline = deadline_;
+    lock.unlock();
+
+    TimeDelay time_delay;
+    {
+      std::lock_guard<std::mutex> data_lock(channel.data_mutex);
+      time_delay = channel.estimator->estimateTimeDelay(node_, estimator_type_);
+    }
+    // a late result is dropped, the next estimation has newer data
+    if (std::chrono::steady_clock::now() <= deadline) {
+      channel.publisher->publish(time_delay);
+    }
+
+    lock.lock();
+    channel.busy = false;
+    cv_done_.notify_all();
+  }
+}
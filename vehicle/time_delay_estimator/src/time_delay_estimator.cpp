@@ -19,6 +19,9 @@
 #include "time_delay_estimator/data_processor.hpp"
 #include "time_delay_estimator/parameters.hpp"
 
+#include <autoware/tool_tracing/tracing.hpp>
+
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -28,9 +31,17 @@ TimeDelayEstimator::TimeDelayEstimator(
   bool use_weight_for_cross_correlation)
 {
   params_ = params;
-  debugger_ = std::make_unique<Debugger>(node, name);
+  // the debug arrays are as long as the processed data with the margin for the delay
+  const size_t debug_array_size = static_cast<size_t>(
+    std::max(total_data_size, 0) * (1.0 + std::max(params.valid_delay_index_ratio, 0.0)));
+  debugger_ = std::make_unique<Debugger>(node, name, debug_array_size);
   this->name_ = name;
-  ignore_thresh_ = node->declare_parameter<double>(name + "/min_stddev_threshold", 0.005);
+  // the estimators of a name may be created several times on a node, e.g. once per bag
+  const std::string threshold_name = name + "/min_stddev_threshold";
+  ignore_thresh_ = node->has_parameter(threshold_name)
+                     ? node->get_parameter(threshold_name).as_double()
+                     : node->declare_parameter<double>(threshold_name, 0.005);
+  resetData();
   weights_for_data_.clear();
   for (size_t i = total_data_size; i > 0; i--) {
     if (use_weight_for_cross_correlation) {
@@ -41,19 +52,29 @@ TimeDelayEstimator::TimeDelayEstimator(
   }
 }
 
+void TimeDelayEstimator::resetData()
+{
+  // the buffers fill up to data_size + buffer samples before they are popped
+  const size_t capacity = static_cast<size_t>(params_.data_size + data_buffer_ + 1);
+  const size_t validation_capacity = static_cast<size_t>(params_.validation_size + 1);
+  input_ = Data(capacity, validation_capacity, params_.num_interpolation);
+  response_ = Data(capacity, validation_capacity, params_.num_interpolation);
+  response_dot_ = Data(capacity, validation_capacity, params_.num_interpolation);
+  response_2dot_ = Data(capacity, validation_capacity, params_.num_interpolation);
+}
+
 void TimeDelayEstimator::resetEstimator()
 {
   cc_estimator_ = Estimator();
   ls_estimator_ = Estimator();
   ls2_estimator_ = Estimator();
   loop_count_ = 0;
+  has_cross_correlation_peak_ = false;
+  cross_correlation_scan_count_ = 0;
   has_enough_input_ = false;
   has_enough_response_ = false;
   max_current_stddev_ = 0;
-  input_ = {};
-  response_ = {};
-  response_dot_ = {};
-  response_2dot_ = {};
+  resetData();
   time_delay_ = tier4_calibration_msgs::msg::TimeDelay();
 }
 
@@ -63,10 +84,9 @@ void TimeDelayEstimator::preprocessData(rclcpp::Node * node)
     is_valid_data_ = data_processor::checkIsValidData(
       input_, response_, params_, max_current_stddev_, ignore_thresh_);
     if (is_valid_data_) {
-      const int buffer = 2;
-      has_enough_input_ = data_processor::processInputData(input_, params_, buffer);
+      has_enough_input_ = data_processor::processInputData(input_, params_, data_buffer_);
       has_enough_response_ = data_processor::processResponseData(
-        node, response_, response_dot_, response_2dot_, params_, buffer);
+        node, response_, response_dot_, response_2dot_, params_, data_buffer_);
     }
   } catch (std::runtime_error & e) {  // Handle runtime errors
     std::cerr << "[time_delay_estimator] at preprocessData runtime_error: " << e.what()
@@ -112,20 +132,21 @@ void TimeDelayEstimator::processDebugData(rclcpp::Node * node)
     de.data[debugger_->LEAST_SQUARED_SECOND::LS2_DELAY] = ls2_estimator_.time_delay;
     de.data[debugger_->LEAST_SQUARED_SECOND::LS2_MAE_AT_TIME] = ls2_estimator_.mae;
     debugger_->publishDebugValue();
-    std_msgs::msg::Float32MultiArray input_data;
-    std_msgs::msg::Float32MultiArray response_data;
-    std_msgs::msg::Float32MultiArray estimated_data;
-    auto & input_dim = input_data.layout.dim;
-    input_dim.resize(1);
-    input_dim[0].size = params_.total_data_size;
-    auto & response_dim = response_data.layout.dim;
-    response_dim.resize(1);
-    response_dim[0].size = params_.total_data_size;
-    auto & estimated_dim = estimated_data.layout.dim;
-    estimated_dim.resize(1);
-    estimated_dim[0].size = params_.total_data_size;
-    int size = static_cast<int>(input_.processed.size() * (1.0 + params_.valid_delay_index_ratio));
-    if (params_.is_showing_debug_info) {
+    if (params_.is_showing_debug_info && cc_estimator_.cross_correlation.size() > 0) {
+      // the messages are reused, which keeps their data allocated
+      auto & input_data = debugger_->pub_debug_input_->clear();
+      auto & response_data = debugger_->pub_debug_response_->clear();
+      auto & estimated_data = debugger_->pub_debug_estimated_->clear();
+      auto & corr_data = debugger_->pub_debug_corr_->clear();
+      const auto set_dim = [this](std_msgs::msg::Float32MultiArray & array) {
+        array.layout.dim.resize(1);
+        array.layout.dim.front().size = params_.total_data_size;
+      };
+      set_dim(input_data);
+      set_dim(response_data);
+      set_dim(estimated_data);
+      int size =
+        static_cast<int>(input_.processed.size() * (1.0 + params_.valid_delay_index_ratio));
       // for input & response
       for (int i = 0; i < size; i += 1) {
         if (i < static_cast<int>(input_.processed.size())) {
@@ -141,23 +162,14 @@ void TimeDelayEstimator::processDebugData(rclcpp::Node * node)
         } else {
           estimated_data.data.emplace_back(0);
         }
+        // for cross correlation
+        corr_data.data.emplace_back(i == cc_estimator_.estimated_delay_index ? 1 : 0);
       }
-      // for cross correlation
-      std_msgs::msg::Float64MultiArray corr_data;
-      if (cc_estimator_.cross_correlation.size() > 0) {
-        for (int i = 0; i < size; i += 1) {
-          if (i == cc_estimator_.estimated_delay_index) {
-            corr_data.data.emplace_back(1);
-          } else {
-            corr_data.data.emplace_back(0);
-          }
-        }
-        // cross correlation
-        debugger_->pub_debug_input_->publish(input_data);
-        debugger_->pub_debug_response_->publish(response_data);
-        debugger_->pub_debug_estimated_->publish(estimated_data);
-        debugger_->pub_debug_corr_->publish(corr_data);
-      }
+      // cross correlation
+      debugger_->pub_debug_input_->publish();
+      debugger_->pub_debug_response_->publish();
+      debugger_->pub_debug_estimated_->publish();
+      debugger_->pub_debug_corr_->publish();
     }
   }
 }
@@ -195,15 +207,10 @@ void TimeDelayEstimator::setOutput(Estimator & estimator)
 tier4_calibration_msgs::msg::TimeDelay TimeDelayEstimator::estimateTimeDelay(
   rclcpp::Node * node, std::string estimator_type)
 {
+  AUTOWARE_TOOL_TRACING_STAGE("time_delay_estimator", "estimate");
+
   try {
-    const bool use_time_fitting = false;
     auto & clk = *node->get_clock();
-    // use this for real time estimation only
-    if (use_time_fitting) {
-      math_utils::fitToTheSizeOfVector(
-        input_.stamps, response_.stamps, input_.processed, response_.processed,
-        params_.total_data_size, params_.num_interpolation);
-    }
     // ----  Estimate Time Delay
     if (is_valid_data_ && has_enough_input_ && has_enough_response_) {
       if (estimator_type == "cc") {
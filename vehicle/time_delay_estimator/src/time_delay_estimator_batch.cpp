@@ -0,0 +1,408 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/math_utils.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rosbag2_cpp/reader.hpp"
+#include "rosbag2_storage/storage_filter.hpp"
+#include "time_delay_estimator/data_processor.hpp"
+#include "time_delay_estimator/parameters.hpp"
+#include "time_delay_estimator/time_delay_estimator.hpp"
+
+#include "autoware_vehicle_msgs/msg/control_mode_report.hpp"
+#include "tier4_calibration_msgs/msg/bool_stamped.hpp"
+#include "tier4_calibration_msgs/msg/float32_stamped.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using Float32Stamped = tier4_calibration_msgs::msg::Float32Stamped;
+using BoolStamped = tier4_calibration_msgs::msg::BoolStamped;
+using ControlModeReport = autoware_vehicle_msgs::msg::ControlModeReport;
+
+struct ChannelConfig
+{
+  std::string name;
+  std::string cmd_topic;
+  std::string status_topic;
+  MinMax valid;
+  double offset;
+  bool normalize;
+};
+
+// settings shared by all the bags of a run
+struct Context
+{
+  Params params;
+  std::string estimator_type;
+  bool use_weight_for_cross_correlation;
+  bool detect_manual_engage;
+  double segment_duration;
+  std::string control_mode_topic;
+  std::string is_engage_topic;
+  std::vector<ChannelConfig> channels;
+};
+
+// delays estimated from the current data within a segment
+struct SegmentStatistic
+{
+  size_t estimation_num = 0;
+  size_t valid_num = 0;
+  double delay_sum = 0;
+  double delay_squared_sum = 0;
+  double peak_sum = 0;
+};
+
+struct Channel
+{
+  const ChannelConfig * config;
+  std::unique_ptr<TimeDelayEstimator> estimator;
+  bool has_cmd = false;
+  bool has_status = false;
+  SegmentStatistic statistic;
+};
+
+double validateRange(const MinMax & valid, const double val)
+{
+  return (valid.min < std::abs(val) && std::abs(val) < valid.max) ? val : 0.0;
+}
+
+// the same conversion as the callbacks of TimeDelayEstimatorNode
+double convertValue(const ChannelConfig & config, const double val)
+{
+  double value = validateRange(config.valid, val);
+  if (config.normalize) {
+    value = math_utils::normalize(value, -1.0, 1.0);
+  }
+  return value + config.offset;
+}
+
+ChannelConfig declareChannel(
+  rclcpp::Node & node, const std::string & name, const double min_stddev_default,
+  const bool normalize)
+{
+  ChannelConfig config;
+  config.name = name;
+  config.cmd_topic = node.declare_parameter<std::string>(
+    name + "/cmd_topic", "/calibration/vehicle/" + name + "_cmd");
+  config.status_topic = node.declare_parameter<std::string>(
+    name + "/status_topic", "/calibration/vehicle/" + name + "_status");
+  config.valid.min = node.declare_parameter<double>(name + "/valid_min_" + name, 0.05);
+  config.valid.max = node.declare_parameter<double>(name + "/valid_max_" + name, 1.0);
+  config.offset = node.declare_parameter<double>(name + "/offset_value", 0.0);
+  config.normalize = normalize;
+  // declared here, since the estimators of the bags are created concurrently
+  node.declare_parameter<double>(name + "/min_stddev_threshold", min_stddev_default);
+  return config;
+}
+
+Context declareContext(rclcpp::Node & node)
+{
+  Context context;
+  auto & params = context.params;
+  params.sampling_hz = node.declare_parameter<double>("data/sampling_hz", 30.0);
+  params.estimation_hz = node.declare_parameter<double>("data/estimation_hz", 10.0);
+  params.sampling_duration = node.declare_parameter<double>("data/sampling_duration", 5.0);
+  params.validation_duration = node.declare_parameter<double>("data/validation_duration", 1.0);
+  params.valid_peak_cross_correlation_threshold =
+    node.declare_parameter<double>("data/valid_peak_cross_correlation_threshold", 0.8);
+  params.valid_delay_index_ratio =
+    node.declare_parameter<double>("data/valid_delay_index_ratio", 0.1);
+  params.cutoff_hz_input = node.declare_parameter<double>("filter/cutoff_hz_input", 0.5);
+  params.cutoff_hz_output = node.declare_parameter<double>("filter/cutoff_hz_output", 0.1);
+  // the debug values are published, but nobody watches them offline
+  params.is_showing_debug_info = false;
+  params.is_test_mode = false;
+  params.num_interpolation = node.declare_parameter<int>("data/num_interpolation", 1);
+  params.cross_correlation_search_width =
+    node.declare_parameter<int>("data/cross_correlation_search_width", 3);
+  params.cross_correlation_full_scan_period =
+    node.declare_parameter<int>("data/cross_correlation_full_scan_period", 10);
+  params.cross_correlation_decimation =
+    node.declare_parameter<int>("data/cross_correlation_decimation", 4);
+  params.reset_at_disengage = node.declare_parameter<bool>("reset_at_disengage", false);
+  params.sampling_delta_time = 1.0 / params.sampling_hz;
+  params.estimation_delta_time = 1.0 / params.estimation_hz;
+  params.data_size = static_cast<int>(params.sampling_hz * params.sampling_duration);
+  params.validation_size = static_cast<int>(params.sampling_hz * params.validation_duration);
+  params.total_data_size =
+    static_cast<int>(params.sampling_duration * params.sampling_hz * params.num_interpolation) +
+    1;
+  context.estimator_type = node.declare_parameter<std::string>("estimator_type", "cc");
+  context.use_weight_for_cross_correlation =
+    node.declare_parameter<bool>("use_weight_for_cross_correlation", false);
+  context.detect_manual_engage = node.declare_parameter<bool>("detect_manual_engage", true);
+  context.segment_duration = node.declare_parameter<double>("batch/segment_duration", 60.0);
+  context.control_mode_topic =
+    node.declare_parameter<std::string>("control_mode_topic", "/vehicle/status/control_mode");
+  context.is_engage_topic =
+    node.declare_parameter<std::string>("is_engage_topic", "/calibration/vehicle/is_engage");
+  context.channels.push_back(declareChannel(node, "accel", 0.005, false));
+  context.channels.push_back(declareChannel(node, "brake", 0.005, false));
+  context.channels.push_back(declareChannel(node, "steer", 0.0025, true));
+  return context;
+}
+
+template <typename T>
+T deserialize(const rosbag2_storage::SerializedBagMessage & message)
+{
+  static const rclcpp::Serialization<T> serialization;
+  const rclcpp::SerializedMessage serialized(*message.serialized_data);
+  T msg;
+  serialization.deserialize_message(&serialized, &msg);
+  return msg;
+}
+
+void writeSegment(
+  const std::string & bag_path, const Channel & channel, const double begin, const double end,
+  std::ostream & rows)
+{
+  const auto & s = channel.statistic;
+  const double n = static_cast<double>(std::max<size_t>(s.valid_num, 1));
+  const double mean = s.delay_sum / n;
+  const double stddev = std::sqrt(std::max(s.delay_squared_sum / n - mean * mean, 0.0));
+  rows << bag_path << "," << channel.config->name << "," << begin << "," << end << ","
+       << s.estimation_num << "," << s.valid_num << "," << mean << "," << stddev << ","
+       << s.peak_sum / n << "\n";
+}
+
+// Step through the bag at @bag_path as the data collection and the estimation timers of
+// TimeDelayEstimatorNode do, but at the bag time and as fast as possible, and write the
+// statistics of the delays of every segment to @rows
+void processBag(
+  rclcpp::Node & node, std::mutex & node_mutex, const Context & context,
+  const std::string & bag_path, std::ostream & rows)
+{
+  const auto & params = context.params;
+  std::vector<Channel> channels(context.channels.size());
+  {
+    // the estimators create their debug publishers on the shared node
+    std::lock_guard<std::mutex> lock(node_mutex);
+    for (size_t i = 0; i < channels.size(); i++) {
+      channels[i].config = &context.channels[i];
+      channels[i].estimator = std::make_unique<TimeDelayEstimator>(
+        &node, params, context.channels[i].name, params.total_data_size,
+        context.use_weight_for_cross_correlation);
+    }
+  }
+
+  rosbag2_cpp::Reader reader;
+  reader.open(bag_path);
+
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = {context.control_mode_topic, context.is_engage_topic};
+  for (const auto & config : context.channels) {
+    filter.topics.push_back(config.cmd_topic);
+    filter.topics.push_back(config.status_topic);
+  }
+  reader.set_filter(filter);
+
+  const double start_time =
+    std::chrono::duration<double>(reader.get_metadata().starting_time.time_since_epoch()).count();
+  double auto_mode_duration = 0.0;
+  double engage_duration = 0.0;
+  double last_manual_time = start_time;
+  double last_disengage_time = start_time;
+  size_t segment = 0;
+
+  const auto flush_segment = [&](const double end) {
+    const double begin = static_cast<double>(segment) * context.segment_duration;
+    for (auto & channel : channels) {
+      writeSegment(bag_path, channel, begin, end, rows);
+      channel.statistic = SegmentStatistic();
+    }
+  };
+
+  // timerDataCollector and estimateTimeDelay at @t
+  const auto step = [&](const double t) {
+    const auto step_segment = static_cast<size_t>((t - start_time) / context.segment_duration);
+    if (step_segment != segment) {
+      flush_segment(static_cast<double>(segment + 1) * context.segment_duration);
+      segment = step_segment;
+    }
+    if (std::min(auto_mode_duration, engage_duration) < 5.0 && context.detect_manual_engage) {
+      if (params.reset_at_disengage) {
+        for (auto & channel : channels) {
+          channel.estimator->resetEstimator();
+        }
+      }
+      return;
+    }
+    for (auto & channel : channels) {
+      if (channel.has_cmd && channel.has_status) {
+        channel.estimator->preprocessData(&node);
+      }
+    }
+    for (auto & channel : channels) {
+      if (!channel.has_cmd || !channel.has_status) {
+        continue;
+      }
+      const bool has_enough_data = channel.estimator->hasEnoughData();
+      const auto time_delay = channel.estimator->estimateTimeDelay(&node, context.estimator_type);
+      auto & s = channel.statistic;
+      s.estimation_num++;
+      if (has_enough_data) {
+        s.valid_num++;
+        s.delay_sum += time_delay.time_delay;
+        s.delay_squared_sum += time_delay.time_delay * time_delay.time_delay;
+        s.peak_sum += time_delay.correlation_peak;
+      }
+    }
+  };
+
+  int64_t step_num = 1;
+  double last_time = start_time;
+  while (reader.has_next() && rclcpp::ok()) {
+    const auto message = reader.read_next();
+    const double t = static_cast<double>(message->time_stamp) * 1e-9;
+    // the timers that fire before the message
+    for (double step_time = start_time + static_cast<double>(step_num) * params.sampling_delta_time;
+         step_time <= t;
+         step_time = start_time + static_cast<double>(++step_num) * params.sampling_delta_time) {
+      step(step_time);
+    }
+    last_time = std::max(last_time, t);
+
+    if (message->topic_name == context.control_mode_topic) {
+      if (deserialize<ControlModeReport>(*message).mode == ControlModeReport::AUTONOMOUS) {
+        auto_mode_duration = t - last_manual_time;
+      } else {
+        auto_mode_duration = 0;
+        last_manual_time = t;
+      }
+      continue;
+    }
+    if (message->topic_name == context.is_engage_topic) {
+      if (deserialize<BoolStamped>(*message).data) {
+        engage_duration = t - last_disengage_time;
+      } else {
+        engage_duration = 0;
+        last_disengage_time = t;
+      }
+      continue;
+    }
+    for (auto & channel : channels) {
+      const auto & config = *channel.config;
+      if (message->topic_name == config.cmd_topic) {
+        const auto msg = deserialize<Float32Stamped>(*message);
+        channel.estimator->input_.setValue(convertValue(config, msg.data), t);
+        channel.has_cmd = true;
+      } else if (message->topic_name == config.status_topic) {
+        const auto msg = deserialize<Float32Stamped>(*message);
+        channel.estimator->response_.setValue(convertValue(config, msg.data), t);
+        channel.has_status = true;
+      }
+    }
+  }
+  flush_segment(last_time - start_time);
+}
+
+bool run(rclcpp::Node & node)
+{
+  const auto bag_paths =
+    node.declare_parameter<std::vector<std::string>>("bag_paths", std::vector<std::string>{});
+  const auto output_path =
+    node.declare_parameter<std::string>("batch/output_path", "time_delay_estimation.csv");
+  const auto thread_num_param = node.declare_parameter<int>("batch/thread_num", 0);
+  const Context context = declareContext(node);
+
+  if (bag_paths.empty()) {
+    RCLCPP_ERROR(node.get_logger(), "bag_paths is empty.");
+    return false;
+  }
+  if (context.segment_duration <= 0.0) {
+    RCLCPP_ERROR(node.get_logger(), "batch/segment_duration must be positive.");
+    return false;
+  }
+
+  // 0 for the number of the cores
+  const size_t thread_num = std::min<size_t>(
+    thread_num_param > 0 ? static_cast<size_t>(thread_num_param)
+                         : std::max<size_t>(std::thread::hardware_concurrency(), 1),
+    bag_paths.size());
+
+  // the rows of each bag, written in the order of bag_paths
+  std::vector<std::ostringstream> rows(bag_paths.size());
+  std::vector<char> success(bag_paths.size(), false);
+  std::mutex node_mutex;
+  std::atomic<size_t> next_bag(0);
+
+  auto worker = [&]() {
+    for (size_t b = next_bag++; b < bag_paths.size() && rclcpp::ok(); b = next_bag++) {
+      RCLCPP_INFO(node.get_logger(), "processing %s", bag_paths[b].c_str());
+      rows[b] << std::fixed << std::setprecision(6);
+      try {
+        processBag(node, node_mutex, context, bag_paths[b], rows[b]);
+        success[b] = true;
+      } catch (const std::exception & e) {
+        RCLCPP_ERROR(node.get_logger(), "failed to process %s: %s", bag_paths[b].c_str(), e.what());
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_num; i++) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  std::ofstream ofs(output_path);
+  if (!ofs) {
+    RCLCPP_ERROR(node.get_logger(), "failed to open %s", output_path.c_str());
+    return false;
+  }
+  ofs << "bag,channel,segment_begin,segment_end,estimation_num,valid_num,time_delay_mean,"
+         "time_delay_stddev,correlation_peak_mean\n";
+  for (const auto & r : rows) {
+    ofs << r.str();
+  }
+  RCLCPP_INFO(node.get_logger(), "wrote %s", output_path.c_str());
+
+  return std::all_of(success.begin(), success.end(), [](const char s) { return s; });
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+
+  // named like the live node, so that its parameter file applies as it is
+  auto node = std::make_shared<rclcpp::Node>("time_delay_estimator");
+  const bool success = run(*node);
+
+  rclcpp::shutdown();
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -65,7 +65,13 @@ TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_
   params_.cutoff_hz_output = this->declare_parameter<double>("filter/cutoff_hz_output", 0.1);
   params_.is_showing_debug_info = this->declare_parameter<bool>("is_showing_debug_info", true);
   params_.is_test_mode = this->declare_parameter<bool>("test/is_test_mode", false);
-  params_.num_interpolation = this->declare_parameter<int>("data/num_interpolation", 3);
+  params_.num_interpolation = this->declare_parameter<int>("data/num_interpolation", 1);
+  params_.cross_correlation_search_width =
+    this->declare_parameter<int>("data/cross_correlation_search_width", 3);
+  params_.cross_correlation_full_scan_period =
+    this->declare_parameter<int>("data/cross_correlation_full_scan_period", 10);
+  params_.cross_correlation_decimation =
+    this->declare_parameter<int>("data/cross_correlation_decimation", 4);
   params_.reset_at_disengage = this->declare_parameter<bool>("reset_at_disengage", false);
   estimator_type_ = this->declare_parameter<std::string>("estimator_type", "cc");
   bool use_weight_for_cross_correlation =
@@ -131,6 +137,18 @@ TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_
   pub_time_delay_steer_ = create_publisher<TimeDelay>("~/output/steer_cmd_delay", durable_qos);
   pub_time_delay_brake_ = create_publisher<TimeDelay>("~/output/brake_cmd_delay", durable_qos);
 
+  const bool parallel_estimation = this->declare_parameter<bool>("parallel_estimation", false);
+  const double estimation_deadline =
+    this->declare_parameter<double>("estimation_deadline", params_.sampling_delta_time);
+  if (parallel_estimation) {
+    // in the order of ChannelIndex
+    parallel_estimation_ =
+      std::make_unique<ParallelEstimation>(this, estimator_type_, estimation_deadline);
+    parallel_estimation_->addChannel("accel", accel_data_.get(), pub_time_delay_accel_);
+    parallel_estimation_->addChannel("brake", brake_data_.get(), pub_time_delay_brake_);
+    parallel_estimation_->addChannel("steer", steer_data_.get(), pub_time_delay_steer_);
+  }
+
   const auto period_s = params_.sampling_delta_time;
   // data processing callback
   {
@@ -163,23 +181,44 @@ void TimeDelayEstimatorNode::timerDataCollector()
   }
   if (std::min(auto_mode_duration_, engage_duration_) < 5.0 && detect_manual_engage_) {
     if (params_.reset_at_disengage) {
-      accel_data_->resetEstimator();
-      brake_data_->resetEstimator();
-      steer_data_->resetEstimator();
+      {
+        const auto lock = lockData(ACCEL);
+        accel_data_->resetEstimator();
+      }
+      {
+        const auto lock = lockData(BRAKE);
+        brake_data_->resetEstimator();
+      }
+      {
+        const auto lock = lockData(STEER);
+        steer_data_->resetEstimator();
+      }
     }
     return;
   }
   // ====accel delay estimation
   if (accel_status_ptr_ && accel_cmd_ptr_) {
+    const auto lock = lockData(ACCEL);
     accel_data_->preprocessData(this);
   }
   if (brake_status_ptr_ && brake_cmd_ptr_) {
+    const auto lock = lockData(BRAKE);
     brake_data_->preprocessData(this);
   }
   if (steer_status_ptr_ && steer_cmd_ptr_) {
+    const auto lock = lockData(STEER);
     steer_data_->preprocessData(this);
   }
 }
+
+std::unique_lock<std::mutex> TimeDelayEstimatorNode::lockData(const ChannelIndex channel)
+{
+  if (!parallel_estimation_) {
+    return {};
+  }
+  return std::unique_lock<std::mutex>(parallel_estimation_->dataMutex(channel));
+}
+
 bool TimeDelayEstimatorNode::estimateTimeDelay()
 {
   std::chrono::system_clock::time_point start, end;
@@ -195,32 +234,41 @@ bool TimeDelayEstimatorNode::estimateTimeDelay()
   }
   auto & clk = *this->get_clock();
 
+  const bool accel_ready = accel_status_ptr_ && accel_cmd_ptr_;
+  const bool brake_ready = brake_status_ptr_ && brake_cmd_ptr_;
+  const bool steer_ready = steer_status_ptr_ && steer_cmd_ptr_;
+
   // ====accel delay estimation
-  if (!accel_status_ptr_ || !accel_cmd_ptr_) {
+  if (!accel_ready) {
     RCLCPP_INFO_STREAM_THROTTLE(
       rclcpp::get_logger("time_delay_estimator"), clk, 5000,
       "[time_delay_estimator] : empty accel ptr");
-  } else {
+  } else if (!parallel_estimation_) {
     pub_time_delay_accel_->publish(accel_data_->estimateTimeDelay(this, estimator_type_));
   }
 
   // ====brake delay estimation
-  if (!brake_status_ptr_ || !brake_cmd_ptr_) {
+  if (!brake_ready) {
     RCLCPP_INFO_STREAM_THROTTLE(
       rclcpp::get_logger("time_delay_estimator"), clk, 5000,
       "[time_delay_estimator] : empty brake ptr");
-  } else {
+  } else if (!parallel_estimation_) {
     pub_time_delay_brake_->publish(brake_data_->estimateTimeDelay(this, estimator_type_));
   }
   // ====steer delay estimation
-  if (!steer_status_ptr_ || !steer_cmd_ptr_) {
+  if (!steer_ready) {
     RCLCPP_INFO_STREAM_THROTTLE(
       rclcpp::get_logger("time_delay_estimator"), clk, 5000,
       "[time_delay_estimator] : empty steer ptr");
-  } else {
+  } else if (!parallel_estimation_) {
     pub_time_delay_steer_->publish(steer_data_->estimateTimeDelay(this, estimator_type_));
   }
 
+  if (parallel_estimation_) {
+    // the results are published by the workers
+    parallel_estimation_->estimate({accel_ready, brake_ready, steer_ready});
+  }
+
   end = std::chrono::system_clock::now();
   double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
   RCLCPP_DEBUG_STREAM_THROTTLE(
@@ -356,3 +404,7 @@ void TimeDelayEstimatorNode::callbackTestData()
   test_data_->input_.setValue(input, t);
   test_data_->response_.setValue(response, t);
 }
+
+#include <rclcpp_components/register_node_macro.hpp>
+
+RCLCPP_COMPONENTS_REGISTER_NODE(TimeDelayEstimatorNode)